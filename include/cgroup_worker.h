@@ -0,0 +1,107 @@
+/*
+ * cgroup_worker.h - Off-thread cgroup v2 writes for the focused application
+ *
+ * Responsibilities:
+ * - Give the cgroup of the focused client's process (_NET_WM_PID) a higher
+ *   cpu.weight and io.weight, and put back the weights it had once focus
+ *   moves on, so the interactive app keeps up with background builds
+ * - Do the /proc and /sys/fs/cgroup I/O on a thread of its own; the event
+ *   thread only posts the pid
+ *
+ * Model:
+ * - One request slot, latest wins: posts that arrive while the worker is
+ *   busy replace each other, so a burst of focus changes costs one write
+ *   pair. The event thread additionally waits focus_boost_delay_ms after the
+ *   last focus change before posting (see event.c)
+ * - A cgroup is only boosted when it is neither the root nor one holding
+ *   the window manager itself: raising a session-wide slice would raise the
+ *   background jobs too. Such requests count as skipped
+ * - A cgroup the user cannot write (no delegation, controller not enabled)
+ *   counts as failed and is left alone
+ *
+ * Lifecycle:
+ * - A zeroed cgroup_worker_t is valid and not running. Stopping demotes the
+ *   boosted cgroup before the thread exits
+ *
+ * Threading:
+ * - start/stop/post are main thread only; cgroup_worker_apply runs on the
+ *   worker (tests call it directly on a stopped worker)
+ */
+
+#ifndef CGROUP_WORKER_H
+#define CGROUP_WORKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define CGROUP_WEIGHT_MIN 1u
+#define CGROUP_WEIGHT_MAX 10000u
+#define CGROUP_WORKER_PATH_MAX 512u
+
+typedef struct cgroup_worker {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  bool stop;
+  bool running;
+
+  /* Request slot, guarded by lock */
+  pid_t want_pid; /* 0 = demote only */
+  bool pending;
+
+  /* Worker side; fixed while running */
+  uint32_t weight;
+  const char* proc_root;   /* "/proc", tests point elsewhere */
+  const char* cgroup_root; /* "/sys/fs/cgroup" */
+  char self_cgroup[CGROUP_WORKER_PATH_MAX];
+  char boosted[CGROUP_WORKER_PATH_MAX]; /* relative cgroup path, "" = none */
+  char saved_cpu[32];
+  char saved_io[64];
+  bool warned;
+
+  _Atomic uint64_t posted;
+  _Atomic uint64_t boosts;
+  _Atomic uint64_t demotes;
+  _Atomic uint64_t skipped;
+  _Atomic uint64_t failed;
+} cgroup_worker_t;
+
+/*
+ * Start the thread, boosting to weight (clamped to 1..10000). Returns false
+ * (and stays stopped) without cgroup v2 or when the thread cannot start.
+ */
+bool cgroup_worker_start(cgroup_worker_t* w, uint32_t weight);
+
+/* Demote the boosted cgroup, then join the thread (no-op if stopped) */
+void cgroup_worker_stop(cgroup_worker_t* w);
+
+/* Ask for pid's cgroup to be the boosted one; 0 demotes without boosting */
+void cgroup_worker_post(cgroup_worker_t* w, pid_t pid);
+
+/* Worker body for one request; w->self_cgroup must be resolved */
+void cgroup_worker_apply(cgroup_worker_t* w, pid_t pid);
+
+/* The unified-hierarchy path in a /proc/<pid>/cgroup file ("0::/a/b") */
+bool cgroup_parse_proc(const char* text, char* out, size_t cap);
+
+/* a is b or one of its ancestors ("/" is everyone's) */
+bool cgroup_path_contains(const char* a, const char* b);
+
+/* Append the report; returns bytes written, excluding the NUL */
+size_t cgroup_worker_format(const cgroup_worker_t* w, char* buf, size_t cap);
+void cgroup_worker_dump(const cgroup_worker_t* w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CGROUP_WORKER_H */
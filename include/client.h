@@ -12,11 +12,12 @@
  * - Memory is owned by a slotmap in server_t (see event.h)
  *
  * Contracts:
- * - Hot/cold memory is stable for the lifetime of the handle generation
- * - Do not store raw pointers to hot/cold across operations that may realloc
- * the slotmap
+ * - Hot/cold memory is stable for the lifetime of the handle generation:
+ * s->clients is a paged slotmap, so managing more clients never moves a
+ * slot. A pointer still dies with the client (slotmap_free reuses the slot)
  * - Strings in client_cold_t may be owned by string_arena or heap depending on
- * implementation
+ * implementation; wm_instance, wm_class, wm_client_machine and wm_command
+ * are str_intern references the client holds
  *
  * Threading:
  * - Not thread-safe
@@ -39,7 +40,9 @@ extern "C" {
 #include "ds.h"
 #include "handle.h"
 #include "hxm.h"
+#include "manage_stats.h"
 #include "render.h"
+#include "rules.h"
 
 /* Basic rectangle type used throughout */
 typedef struct rect {
@@ -48,7 +51,7 @@ typedef struct rect {
 } rect_t;
 
 /* Snap targets */
-typedef enum snap_edge { SNAP_NONE = 0, SNAP_LEFT, SNAP_RIGHT } snap_edge_t;
+typedef enum snap_edge { SNAP_NONE = 0, SNAP_LEFT, SNAP_RIGHT, SNAP_TOP, SNAP_TOP_LEFT, SNAP_TOP_RIGHT, SNAP_BOTTOM_LEFT, SNAP_BOTTOM_RIGHT } snap_edge_t;
 
 /* Stacking layers (bottom -> top) */
 typedef enum layer { LAYER_DESKTOP = 0, LAYER_BELOW, LAYER_NORMAL, LAYER_ABOVE, LAYER_DOCK, LAYER_OVERLAY, LAYER_FULLSCREEN, LAYER_COUNT } layer_t;
@@ -73,7 +76,11 @@ typedef enum client_dirty {
   DIRTY_FRAME_BUTTONS = 1u << 12,
   DIRTY_FRAME_BORDER = 1u << 13,
 
-  DIRTY_BYPASS_COMPOSITOR = 1u << 14
+  DIRTY_BYPASS_COMPOSITOR = 1u << 14,
+
+  /* Owed a synthetic ConfigureNotify, sent once by wm_flush_dirty after
+   * every client is committed */
+  DIRTY_SYNTHETIC_CONFIGURE = 1u << 15
 } client_dirty_t;
 
 /* Client lifecycle state */
@@ -127,7 +134,7 @@ typedef struct strut {
 } strut_t;
 
 /* Client flags (bitmask) */
-typedef enum client_flags { CLIENT_FLAG_NONE = 0, CLIENT_FLAG_URGENT = 1u << 0, CLIENT_FLAG_FOCUSED = 1u << 1, CLIENT_FLAG_UNDECORATED = 1u << 2 } client_flags_t;
+typedef enum client_flags { CLIENT_FLAG_NONE = 0, CLIENT_FLAG_URGENT = 1u << 0, CLIENT_FLAG_FOCUSED = 1u << 1, CLIENT_FLAG_UNDECORATED = 1u << 2, CLIENT_FLAG_OUTLINE_DRAG = 1u << 3, CLIENT_FLAG_LIVE_DRAG = 1u << 4, CLIENT_FLAG_FREEZE = 1u << 5 } client_flags_t;
 
 /* Supported WM_PROTOCOLS */
 typedef enum protocol_flags { PROTOCOL_DELETE_WINDOW = 1u << 0, PROTOCOL_TAKE_FOCUS = 1u << 1, PROTOCOL_SYNC_REQUEST = 1u << 2, PROTOCOL_PING = 1u << 3 } protocol_flags_t;
@@ -151,6 +158,25 @@ typedef enum window_type {
   WINDOW_TYPE_COUNT
 } window_type_t;
 
+/*
+ * Frame visibility as last requested by the WM. The workspace pass only
+ * issues map/unmap requests for frames whose wanted state differs; UNKNOWN
+ * (a fresh or externally set up client) always gets the request.
+ */
+typedef enum frame_vis {
+  FRAME_VIS_UNKNOWN = 0,
+  FRAME_VIS_MAPPED,
+  FRAME_VIS_HIDDEN,
+} frame_vis_t;
+
+/* Slot a client occupies in the server's desktop membership index */
+typedef enum desktop_member {
+  DESKTOP_MEMBER_NONE = 0, /* not indexed yet */
+  DESKTOP_MEMBER_UNLISTED, /* indexed, on no desktop list (no desktop, not sticky) */
+  DESKTOP_MEMBER_STICKY,
+  DESKTOP_MEMBER_FIRST, /* DESKTOP_MEMBER_FIRST + d: desktop d */
+} desktop_member_t;
+
 /*
  * Hot storage contract for client_hot_t:
  * - Keep only fields touched in hot event-loop, stacking/focus, and geometry paths.
@@ -158,11 +184,29 @@ typedef enum window_type {
  * - New hot fields require clear hot-path justification and size impact review.
  */
 #if HXM_DIAG
-#define CLIENT_HOT_CACHELINE_PAD_BYTES 16u
+#define CLIENT_HOT_CACHELINE_PAD_BYTES 4u
 #else
-#define CLIENT_HOT_CACHELINE_PAD_BYTES 24u
+#define CLIENT_HOT_CACHELINE_PAD_BYTES 4u
 #endif
 
+/*
+ * Pointer hit regions of a frame, in frame coordinates, so motion over it is
+ * a few integer compares. Built by frame_hit_table for the size and
+ * decoration recorded here; a config reload clears FRAME_HIT_VALID so theme
+ * metrics are picked up again.
+ */
+enum { FRAME_HIT_VALID = 1u << 0, FRAME_HIT_UNDECORATED = 1u << 1 };
+
+typedef struct frame_hit {
+  uint16_t w, h; /* hot->server size the table describes */
+  uint16_t bw;
+  int16_t right_edge; /* x >= right_edge is the right border */
+  int16_t bottom_edge;
+  int16_t button_x; /* close button; maximize and minimize step left */
+  int16_t button_y;
+  uint8_t flags;
+} frame_hit_t;
+
 /* client_hot_t: frequently accessed client state */
 typedef struct client_hot {
   handle_t self;
@@ -194,7 +238,8 @@ typedef struct client_hot {
   snap_edge_t snap_preview_edge;
   rect_t snap_preview_frame_rect;
 
-  int32_t stacking_index;
+  int32_t stacking_index;  /* position hint in layers[stacking_layer], may be stale */
+  uint32_t stacking_label; /* order key within the layer, ascending bottom -> top */
   int8_t stacking_layer;
 
   uint32_t dirty;
@@ -203,7 +248,7 @@ typedef struct client_hot {
   uint8_t state;         /* client_state_t */
   uint8_t initial_state; /* from WM_HINTS */
   uint8_t ignore_unmap;
-  uint8_t _pad0;
+  bool dirty_queued; /* on s->dirty_clients */
 
   uint32_t probe_required_mask; /* manage_probe_t bitset */
   uint32_t probe_received_mask; /* manage_probe_t bitset */
@@ -244,9 +289,20 @@ typedef struct client_hot {
   list_node_t transient_sibling;
   list_node_t transients_head;
 
-  list_node_t focus_node;
+  uint32_t focus_slot; /* s->focus_mru slot, 0 = not in focus history */
+
+  frame_hit_t frame_hit;
+  int last_cursor_dir; /* -1 until the frame cursor is first set */
+
+  uint8_t monitor;     /* monitors index of its screen holding the centre of server geometry */
+  uint8_t monitor_gen; /* monitor_generation that index is valid for, 0 = stale */
+  uint8_t frame_vis;   /* frame_vis_t, what the WM last did to the frame */
+  uint8_t screen;      /* s->screens index, fixed at manage */
+
+  uint16_t tile_tree; /* 1 + tiling index of its screen, 0 = not tiled */
+  bool tile_float;    /* kept out of tiling by hand */
 
-  int last_cursor_dir;
+  bool probe_deferred; /* adopted with the reduced probe, see client_complete_probe */
 
   /*
    * Keep hot stride at one 256-byte block for predictable cacheline stepping in
@@ -261,6 +317,24 @@ HXM_STATIC_ASSERT(sizeof(client_hot_t) <= CLIENT_HOT_SIZE_GUARD_BYTES,
 HXM_STATIC_ASSERT(sizeof(client_hot_t) == CLIENT_HOT_SIZE_GUARD_BYTES,
                   "client_hot_t size must remain exactly 256 bytes");
 
+/*
+ * SoA columns of s->clients, one slotmap column each, indexed by slot index.
+ * Bulk passes (workspace visibility, _NET_CLIENT_LIST) stream these instead
+ * of touching a 256-byte client_hot_t per client. Each mirrors the hot field
+ * of the same name and is written only through the client_set_* helpers in
+ * event.h. A slotmap without them (servers built by hand in tests) is read
+ * through client_hot_t instead.
+ */
+typedef enum client_col {
+  CLIENT_COL_XID,       /* xcb_window_t */
+  CLIENT_COL_STATE,     /* uint8_t, client_state_t */
+  CLIENT_COL_DESKTOP,   /* int32_t */
+  CLIENT_COL_STICKY,    /* uint8_t */
+  CLIENT_COL_FRAME_VIS, /* uint8_t, frame_vis_t */
+  CLIENT_COL_SCREEN,    /* uint8_t, s->screens index */
+  CLIENT_COL_COUNT
+} client_col_t;
+
 /* Determine a derived layer based on above/below state flags */
 static inline uint8_t client_layer_from_state(const client_hot_t* hot) {
   if (!hot)
@@ -276,7 +350,39 @@ static inline int stack_current_layer(const client_hot_t* c) {
   return (c->stacking_layer >= 0) ? (int)c->stacking_layer : (int)c->layer;
 }
 
+/*
+ * Lazy _NET_WM_ICON fetch state.
+ *
+ * The property is not read at manage time. The first time a frame or the
+ * switcher draws the client, the size headers are walked with 2-word reads
+ * and then only the pixel run of the chosen size is fetched.
+ * gen is bumped on every PropertyNotify so in-flight reads can be dropped.
+ */
+typedef enum icon_fetch_phase {
+  ICON_FETCH_IDLE = 0, /* icon_surface reflects the property (or no fetch wanted) */
+  ICON_FETCH_WANTED,   /* fetch on next draw */
+  ICON_FETCH_SCANNING, /* header read in flight at offset */
+  ICON_FETCH_PIXELS    /* pixel run read in flight at best_offset */
+} icon_fetch_phase_t;
+
+typedef struct icon_fetch {
+  uint32_t gen;
+  uint32_t offset; /* next header, in 32-bit words */
+  uint32_t best_offset;
+  uint32_t best_w;
+  uint32_t best_h;
+  uint32_t best_diff;
+  uint32_t icons_seen;
+  uint32_t total_pixels;
+  uint8_t phase;
+} icon_fetch_t;
+
 /* client_cold_t: rarely accessed client state */
+#define CLIENT_PROP_HASH_SLOTS 4
+
+/* Superseded string_arena bytes tolerated before client_compact_strings copies */
+#define CLIENT_STRING_DEAD_MAX 4096u
+
 typedef struct client_cold {
   /* Effective/composed strings used for UI */
   char* title;
@@ -285,10 +391,11 @@ typedef struct client_cold {
   char* base_title;
   char* base_icon_name;
 
-  char* wm_instance;
-  char* wm_class;
-  char* wm_client_machine;
-  char* wm_command;
+  /* Interned (str_intern.h), one reference each */
+  const char* wm_instance;
+  const char* wm_class;
+  const char* wm_client_machine;
+  const char* wm_command;
 
   xcb_window_t* colormap_windows;
   uint32_t colormap_windows_len;
@@ -296,19 +403,28 @@ typedef struct client_cold {
   xcb_visualid_t visual_id;
   xcb_visualtype_t* visual_type;
   uint8_t depth;
+  uint8_t damage_refs; /* consumers holding damage, see client_damage_subscribe */
 
   xcb_colormap_t colormap;
   xcb_colormap_t frame_colormap;
   bool frame_colormap_owned;
 
   render_context_t render_ctx;
+  xcb_pixmap_t frame_pixmap; /* decoration backing, see config.frame_backing */
+  uint16_t frame_pixmap_w;
+  uint16_t frame_pixmap_h;
   cairo_surface_t* icon_surface;
+  icon_fetch_t icon_fetch;
 
-  arena_t string_arena;
+  arena_t string_arena; /* base_title, base_icon_name; see client_compact_strings */
 
   bool has_net_wm_name;
   bool has_net_wm_icon_name;
 
+  /* Title refresh throttling, see event_process */
+  bool title_deferred;       /* a trailing refresh is queued in server.title_deferred */
+  uint32_t title_refresh_ms; /* monotonic ms (wrapping) of the last refresh let through */
+
   size_hints_t hints;
   uint32_t hints_flags;
 
@@ -317,12 +433,17 @@ typedef struct client_cold {
 
   xcb_damage_damage_t damage;
   dirty_region_t damage_region;
-  dirty_region_t frame_damage;
+  dirty_rects_t frame_damage;
 
   uint32_t protocols;
   bool sync_enabled;
+  bool ping_hung; /* has not answered _NET_WM_PING within ping_timeout_ms, see wm_ping.c */
   uint32_t sync_counter;
   uint64_t sync_value;
+  uint32_t sync_alarm;      /* XSync alarm on sync_counter, created on first interactive resize */
+  uint32_t ping_sent_ms;    /* monotonic ms (wrapping) of the unanswered ping, 0 = none */
+  uint64_t sync_wait_value; /* interactive resize waits for the counter to reach this, 0 = not waiting */
+  uint64_t sync_wait_start; /* monotonic ns */
   manage_phase_t manage_phase;
   uint8_t pending_state_count;
   pending_state_msg_t pending_state_msgs[4];
@@ -355,11 +476,26 @@ typedef struct client_cold {
 
   uint32_t pid;
 
-  /*
-   * Round cold stride to a cacheline multiple for predictable packing in slot
-   * arrays. Keep this in sync with cold field changes.
-   */
-  uint8_t cold_cacheline_pad[32];
+  uint32_t desktop_member; /* desktop_member_t slot, or DESKTOP_MEMBER_FIRST + desktop */
+
+  /* Hash of the last GetProperty reply for each cached property (see
+   * wm_prop_desc_t.cache), 0 = unknown. An identical reply is not reparsed */
+  uint32_t prop_hash[CLIENT_PROP_HASH_SLOTS];
+
+  /* MapRequest to first paint, folded into manage_stats on the first paint */
+  manage_timing_t manage_timing;
+
+  /* Switcher thumbnail, see thumbnail.h */
+  cairo_surface_t* thumb;
+  uint64_t thumb_time; /* monotonic ns of the last rescale */
+  uint16_t thumb_w, thumb_h;
+  bool thumb_redirected;
+  bool thumb_queued;
+
+  /* Seconds hidden while holding a render context, see mem_budget.h.
+   * Also rounds the cold stride to a cacheline multiple; keep the total in
+   * sync with cold field changes */
+  uint16_t render_idle_s;
 } client_cold_t;
 
 #define CLIENT_COLD_SIZE_ALIGN_BYTES 64u
@@ -370,7 +506,17 @@ static inline void client_render_payload_init(client_cold_t* cold) {
   if (!cold)
     return;
   render_init(&cold->render_ctx);
+  cold->frame_pixmap = XCB_NONE;
+  cold->frame_pixmap_w = 0;
+  cold->frame_pixmap_h = 0;
   cold->icon_surface = NULL;
+  cold->icon_fetch = (icon_fetch_t){0};
+  cold->thumb = NULL;
+  cold->thumb_time = 0;
+  cold->thumb_w = 0;
+  cold->thumb_h = 0;
+  cold->thumb_redirected = false;
+  cold->thumb_queued = false;
 }
 
 static inline void client_render_payload_destroy(client_cold_t* cold) {
@@ -381,6 +527,20 @@ static inline void client_render_payload_destroy(client_cold_t* cold) {
     cairo_surface_destroy(cold->icon_surface);
     cold->icon_surface = NULL;
   }
+  if (cold->thumb) {
+    cairo_surface_destroy(cold->thumb);
+    cold->thumb = NULL;
+  }
+}
+
+static inline void client_frame_backing_destroy(xcb_connection_t* conn, client_cold_t* cold) {
+  if (!cold)
+    return;
+  if (conn && cold->frame_pixmap != XCB_NONE)
+    xcb_free_pixmap(conn, cold->frame_pixmap);
+  cold->frame_pixmap = XCB_NONE;
+  cold->frame_pixmap_w = 0;
+  cold->frame_pixmap_h = 0;
 }
 
 static inline void client_visual_payload_init(client_cold_t* cold, xcb_visualid_t root_visual) {
@@ -410,6 +570,11 @@ static inline void client_sync_payload_init(client_cold_t* cold) {
   cold->sync_enabled = false;
   cold->sync_counter = 0;
   cold->sync_value = 0;
+  cold->sync_alarm = 0;
+  cold->sync_wait_value = 0;
+  cold->sync_wait_start = 0;
+  cold->ping_hung = false;
+  cold->ping_sent_ms = 0;
 }
 
 static inline void client_manage_staging_init(client_cold_t* cold) {
@@ -456,22 +621,66 @@ typedef struct server server_t;
 
 /* Client lifecycle */
 void client_manage_start(server_t* s, xcb_window_t win);
+/* Manage a window that is not shown yet: properties only needed once it is
+ * (names, user time, sync counter, opacity, ...) are probed by
+ * client_complete_probe */
+void client_manage_start_deferred(server_t* s, xcb_window_t win);
+/* Queue the probes a deferred manage left out; no-op for other clients */
+void client_complete_probe(server_t* s, client_hot_t* hot);
+/* Move a managing client to the screen of root (its geometry reply's root) */
+void client_note_root(server_t* s, client_hot_t* hot, xcb_window_t root);
 void client_abort_manage(server_t* s, handle_t h);
 void client_finish_manage(server_t* s, handle_t h);
+/* Called after each frame paint; the first one after a shown manage closes
+ * the client's manage_timing */
+void client_manage_painted(const client_hot_t* hot, client_cold_t* cold);
 void client_unmanage(server_t* s, handle_t h);
+
+/* Rule matching input from a client's current metadata */
+rule_subject_t client_rule_subject(const client_hot_t* hot, const client_cold_t* cold);
+/* Re-run live rules after class/instance/title (RULE_DEP_*) changed from before */
+void client_rules_changed(server_t* s, handle_t h, uint8_t changed, const rule_subject_t* before);
 void client_close(server_t* s, handle_t h);
 
+/* Lazy _NET_WM_ICON fetch (see icon_fetch_t) */
+void client_icon_request(server_t* s, handle_t h);
+void client_icon_invalidate(server_t* s, handle_t h);
+bool client_icon_read_header(server_t* s, handle_t h, uint32_t offset);
+bool client_icon_read_pixels(server_t* s, handle_t h, uint32_t offset, uint32_t words);
+
+/*
+ * Refcounted Damage subscription. The damage object exists only while at
+ * least one consumer (switcher thumbnails) holds a reference: with none, the
+ * server sends no DamageNotify and wm_flush_dirty issues no subtracts.
+ */
+void client_damage_subscribe(server_t* s, handle_t h);
+void client_damage_unsubscribe(server_t* s, handle_t h);
+
 /* Helpers */
 void client_constrain_size(const size_hints_t* hints, uint32_t flags, uint16_t* w, uint16_t* h);
 
 bool should_focus_on_map(const client_hot_t* hot);
 
 void client_setup_grabs(server_t* s, handle_t h);
+/* Button grabs for a client that is (focused) or is not the focused one */
+void client_set_button_grabs(server_t* s, handle_t h, bool focused);
 
 bool client_can_move(const client_hot_t* hot);
 bool client_can_resize(const client_hot_t* hot, const client_cold_t* cold);
 bool client_has_fixed_size(const client_cold_t* cold);
 
+/* _NET_WM_PID names a process of this host (WM_CLIENT_MACHINE unset or ours) */
+bool client_pid_local(const client_cold_t* cold);
+
+/*
+ * string_arena only grows, so every title change leaves the old copy behind.
+ * Once the superseded bytes exceed both CLIENT_STRING_DEAD_MAX and the live
+ * strings, copy base_title and base_icon_name into a fresh arena (re-pointing
+ * title when it aliases base_title) and free the old one. Pointers into the
+ * old arena die. Returns the bytes released.
+ */
+size_t client_compact_strings(client_cold_t* cold);
+
 #ifdef __cplusplus
 }
 #endif
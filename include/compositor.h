@@ -0,0 +1,122 @@
+/*
+ * compositor.h - Optional built-in compositing manager
+ *
+ * Responsibilities:
+ * - Redirect the root's children (manual Composite redirection) and paint
+ *   them into the Composite overlay window with RENDER (cairo-xcb)
+ * - Take stacking from s->layers and geometry from the root's
+ *   ConfigureNotify stream, so no second copy of the window tree has to be
+ *   kept in step with the window manager's
+ * - Repaint only what changed: window Damage, plus the old and new rects of
+ *   every map, unmap, move, resize and restack
+ * - Unredirect everything while the focused client is fullscreen over the
+ *   whole screen, so a game or video is shown without a copy
+ *
+ * Notes:
+ * - Owns _NET_WM_CM_S0; refuses to start while another compositor runs
+ * - RENDER has no vsync: paints are paced to the fastest monitor's refresh,
+ *   which removes most tearing but cannot promise its absence
+ * - Managed clients are painted through their frame, which has the root
+ *   visual, so their alpha is not blended; override-redirect windows with a
+ *   32-bit visual are
+ * - Windows the window manager does not frame (menus, tooltips, popups) are
+ *   painted above all frames, in the order they were stacked
+ * - Bounding shapes are not read: a shaped window is painted as its
+ *   rectangle, except hxm's own hollow snap preview
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <cairo/cairo.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <xcb/damage.h>
+#include <xcb/xcb.h>
+
+#include "ds.h"
+#include "hxm.h"
+
+/* Paint rate when no monitor reports its refresh */
+#define COMPOSITOR_DEFAULT_MHZ 60000u
+
+struct server;
+
+typedef struct comp_win {
+  xcb_window_t win;
+  int16_t x, y;
+  uint16_t w, h; /* outer size, border included */
+  uint16_t border;
+  xcb_visualid_t visual;
+  bool input_only;
+  bool mapped;
+  bool argb; /* 32-bit visual, blended with OVER */
+  xcb_damage_damage_t damage;
+  xcb_pixmap_t pixmap; /* NameWindowPixmap, renamed after each map and resize */
+  cairo_surface_t* surface;
+} comp_win_t;
+
+typedef struct compositor {
+  bool active;
+  bool suspended; /* a fullscreen client is shown unredirected */
+  xcb_window_t overlay;
+  uint16_t w, h;
+  xcb_pixmap_t back_pixmap;
+  cairo_surface_t* back;  /* paints land here, then damaged rects go to front */
+  cairo_surface_t* front; /* the overlay window */
+  xcb_pixmap_t root_bg;   /* _XROOTPMAP_ID, XCB_NONE paints black */
+  cairo_surface_t* bg;
+
+  hash_map_t windows; /* xcb_window_t -> comp_win_t* */
+  comp_win_t** order; /* root children as stacked, bottom to top */
+  size_t order_len;
+  size_t order_cap;
+  comp_win_t** paint; /* this paint's windows, bottom to top */
+  size_t paint_cap;
+
+  dirty_rects_t damage; /* screen coordinates */
+  uint64_t last_paint_ns;
+
+  uint64_t paints;
+  uint64_t windows_painted;
+  uint64_t windows_occluded; /* skipped under an opaque window covering the damage */
+  uint64_t damage_events;
+  uint64_t suspends;
+} compositor_t;
+
+/* Composite and Damage present and config.compositor set */
+bool compositor_enabled(const struct server* s);
+
+/* Take over the screen; false (with a warning) leaves it to the server */
+bool compositor_start(struct server* s);
+void compositor_stop(struct server* s);
+
+/* Root structure events and root property changes, at ingest */
+void compositor_observe(struct server* s, const xcb_generic_event_t* ev);
+
+/* A tick's coalesced Damage for a drawable that is not a client window */
+void compositor_note_damage(struct server* s, xcb_window_t drawable, const dirty_rects_t* region);
+
+/* RandR changed the root size */
+void compositor_resize(struct server* s, uint16_t w, uint16_t h);
+
+/* Suspend or resume for fullscreen, then repaint if due; true if X requests were issued */
+bool compositor_paint(struct server* s, uint64_t now);
+
+/* Append the report; returns bytes written, excluding the NUL */
+size_t compositor_format(const compositor_t* c, char* buf, size_t cap);
+void compositor_dump(const compositor_t* c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPOSITOR_H */
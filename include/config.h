@@ -35,6 +35,7 @@ extern "C" {
 #include <xcb/xcb_keysyms.h>
 
 #include "ds.h"
+#include "rules.h"
 #include "theme.h"
 
 /* Action types referenced by key bindings and menu items */
@@ -59,7 +60,12 @@ typedef enum action_type {
 
   ACTION_TOGGLE_STICKY,
   ACTION_MOVE,
-  ACTION_RESIZE
+  ACTION_RESIZE,
+
+  ACTION_TILE_LAYOUT,
+  ACTION_TILE_TOGGLE,
+  ACTION_TILE_GROW,
+  ACTION_TILE_SHRINK
 } action_type_t;
 
 typedef struct key_binding {
@@ -68,24 +74,34 @@ typedef struct key_binding {
 
   action_type_t action;
 
+  /* Auto-repeat runs the action at most once per this many ms, 0 = every
+   * repeat (repeats arriving in one tick still collapse into one step) */
+  uint32_t repeat_ms;
+
   /* Only used when action == ACTION_EXEC or ACTION_TERMINAL (if you model it
    * that way) */
   char* exec_cmd;
 } key_binding_t;
 
 /* Initial placement policy for newly-managed windows */
-typedef enum placement_policy { PLACEMENT_DEFAULT = 0, PLACEMENT_CENTER, PLACEMENT_MOUSE } placement_policy_t;
+typedef enum placement_policy { PLACEMENT_DEFAULT = 0, PLACEMENT_CENTER, PLACEMENT_MOUSE, PLACEMENT_SMART } placement_policy_t;
+
+/* Outline drags: off, on once a client misses its sync deadline, or always */
+typedef enum outline_mode { OUTLINE_OFF = 0, OUTLINE_AUTO, OUTLINE_ALWAYS } outline_mode_t;
 
 /* Application rule:
  * Match fields:
  * - NULL means "do not match on this field"
  * - type_match: -1 any, else client_type_t value (defined elsewhere)
  * - transient_match: -1 any, 0 normal, 1 transient
+ * - live: also re-evaluated when class, instance or title change after
+ *   manage; fires when the rule starts matching
  *
  * Apply fields:
  * - desktop: -2 don't change, -1 sticky, >=0 target desktop
  * - layer: -1 don't change, else stack_layer_t value (defined elsewhere)
  * - focus: -1 don't change, 0 no, 1 yes
+ * - outline: -1 don't change, 0 always drag live, 1 always drag an outline
  * - bypass_compositor: -1 don't change, 0 unset/allow, 1/2 set value for
  *   _NET_WM_BYPASS_COMPOSITOR
  */
@@ -96,11 +112,14 @@ typedef struct app_rule {
 
   int32_t type_match;
   int8_t transient_match;
+  bool live;
 
   int32_t desktop;
   int32_t layer;
   int8_t focus;
   int8_t bypass_compositor;
+  int8_t outline;
+  int8_t freeze; /* stop the app while all its windows are hidden, see freezer.h */
 
   placement_policy_t placement;
 } app_rule_t;
@@ -121,19 +140,71 @@ typedef struct config {
    */
   small_vec_t key_bindings;
   small_vec_t rules;
+  rule_set_t rule_set; /* compiled from rules; see rules.h */
 
   /* Policy flags */
   bool focus_raise;
   bool focus_follows_mouse;
+  uint32_t focus_hover_delay_ms; /* focus_follows_mouse waits for the pointer to rest this long, 0 = focus on enter */
+  uint32_t focus_hover_speed;    /* px/s below which a crossing focuses without waiting, 0 = always wait */
   bool fullscreen_use_workarea;
+  bool fullscreen_fast;           /* trim WM work under a focused monitor-covering fullscreen client, see wm_fullscreen.c */
+  bool compositor;                /* composite the screen ourselves, see compositor.h */
+  placement_policy_t placement;   /* used when no rule picks one */
+  bool frame_backing;             /* keep decorations in a background pixmap, exposes need no repaint */
+  bool render_thread;             /* shape title text on a worker thread, see render_worker.h */
+  bool input_thread;              /* read the X socket on a helper thread, see x_reader.h */
+  bool focus_boost;               /* raise the focused app's cgroup weights, see cgroup_worker.h */
+  uint32_t focus_boost_weight;    /* cpu.weight and io.weight while focused, 1..10000 */
+  uint32_t focus_boost_delay_ms;  /* focus must rest this long before the cgroup is switched */
+  uint32_t interactive_max_hz;    /* cap on move/resize commits per second, 0 = monitor refresh */
+  bool interactive_predict;       /* lead drags by the pointer's velocity up to the next paced commit */
+  bool xinput2_motion;            /* drive drags from an XI2 grab when the server has XInput 2 */
+  bool interactive_motion_hint;   /* grab drags with PointerMotionHint and poll the pointer once per commit */
+  outline_mode_t interactive_outline; /* draw drags as an outline and configure the client once on release */
+  uint32_t interactive_defer_ms;  /* during drags, hold other clients' updates at most this long, 0 = never */
+  uint32_t interactive_busy_poll_us; /* during grabs, spin this long for input before sleeping, 0 = never */
+  bool interactive_boost;         /* during grabs, raise the event thread to SCHED_RR (or nice -5) if permitted */
+  uint32_t keyboard_step_px;      /* arrow-key step of a keyboard move/resize before acceleration */
+  bool switcher_thumbnails;       /* window thumbnails in the Alt-Tab switcher (needs Composite) */
+  uint32_t switcher_thumbnail_hz; /* max rescales per thumbnail per second, 0 = on every damage */
+  uint32_t memory_budget_mb;      /* evict reconstructible caches above this, 0 = no budget, see mem_budget.h */
+  uint32_t render_idle_release_s; /* free render contexts of clients hidden this long, 0 = keep */
+  uint32_t prewarm_idle_ms;       /* paint frames of desktops likely shown next after this long idle, 0 = never, see prewarm.h */
+  uint32_t ping_interval_ms;      /* _NET_WM_PING mapped clients this often, 0 = never, see wm_ping.c */
+  uint32_t ping_timeout_ms;       /* a client that has not answered a ping this long is hung */
+  uint32_t manage_defer_ms;       /* hold new windows this long before framing them, 0 = frame at once */
+  uint32_t frame_pool_size;       /* unmanaged frames kept for reuse, 0 = destroy them */
 
   /* Snap-to-edge */
   bool snap_enable;
   uint32_t snap_threshold_px;
   uint32_t snap_preview_border_px;
   uint32_t snap_preview_color;
+  uint32_t snap_split_percent;      /* width of the left tile, the right one gets the rest */
+  uint32_t snap_corner_px;          /* reach of the quarter-tile zones, 0 = no corner tiles */
+  bool snap_top_maximize;           /* dragging to the top edge tiles the whole workarea */
+  uint32_t snap_edge_resistance_px; /* pull toward window, monitor and strut edges, 0 = off */
+
+  /* Tiling, see wm_tiling.c */
+  uint32_t tiling_layout;         /* tile_mode_t for every desktop until changed by key */
+  uint32_t tiling_master_percent; /* master/stack: width of the master column */
+  uint32_t tiling_gap_px;         /* between tiles and around them */
 } config_t;
 
+/*
+ * Independently applicable parts of config_t, as reported by config_diff.
+ * A reload only re-applies the sections that actually changed.
+ */
+typedef enum config_section {
+  CONFIG_SECTION_THEME = 1u << 0,    /* theme, font_name, frame_backing */
+  CONFIG_SECTION_KEYS = 1u << 1,     /* key_bindings */
+  CONFIG_SECTION_DESKTOPS = 1u << 2, /* desktop_count, desktop_names */
+  CONFIG_SECTION_RULES = 1u << 3,    /* rules */
+  CONFIG_SECTION_POLICY = 1u << 4,   /* focus, placement, pacing, render_thread, input_thread, switcher, memory budget */
+  CONFIG_SECTION_SNAP = 1u << 5,     /* snap_* */
+} config_section_t;
+
 /* Initialize config to default values (does not load from disk) */
 void config_init_defaults(config_t* config);
 
@@ -149,9 +220,16 @@ bool config_load(config_t* config, const char* path);
  */
 bool theme_load(theme_t* theme, const char* path);
 
+/* Return the config_section_t bits whose values differ between a and b */
+uint32_t config_diff(const config_t* a, const config_t* b);
+
 /* Free all heap-owned memory inside config */
 void config_destroy(config_t* config);
 
+/* Move src into dst (which must be destroyed or uninitialized); src is left
+ * empty. A plain struct copy would leave inline small_vec storage behind. */
+void config_move(config_t* dst, config_t* src);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,115 @@
+/*
+ * config_cache.h - Compiled binary cache of parsed configuration
+ *
+ * Responsibilities:
+ * - Keep the parsed result of hxm.conf + themerc (config_t) and of menu.conf
+ *   (menu specs) under $XDG_CACHE_HOME/hxm, or ~/.cache/hxm
+ * - Validate an entry against every candidate source path the text loaders
+ *   would try, so a hit reproduces exactly what parsing would produce
+ * - Memory-map hits; text is only parsed when a source changed
+ *
+ * Validation:
+ * - An entry is only valid for the binary that wrote it (its build-id): a
+ *   new build may change the defaults the cached config was merged with
+ * - Each candidate path has a stamp: mtime, size and content hash, or absent
+ * - Same mtime and size is a hit without reading the source; a new mtime with
+ *   the old size is resolved by the content hash and the stamps are refreshed
+ * - Any other difference, including a candidate appearing or disappearing, is
+ *   a miss
+ *
+ * Usage on a miss:
+ * - config_cache_stamp the sources before parsing, so an edit racing the
+ *   parse invalidates the entry written afterwards
+ * - parse as usual, then store
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef CONFIG_CACHE_H
+#define CONFIG_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "hxm.h"
+
+#define CONFIG_CACHE_MAX_SOURCES 16
+#define CONFIG_CACHE_PATH_MAX 1024
+
+typedef enum config_cache_kind {
+  CONFIG_CACHE_MAIN = 1, /* hxm.conf + themerc */
+  CONFIG_CACHE_MENU = 2, /* menu.conf */
+} config_cache_kind_t;
+
+typedef struct config_cache_stamp {
+  int64_t mtime_ns; /* -1 when the path did not exist */
+  int64_t size;
+  uint64_t hash; /* FNV-1a of the contents */
+} config_cache_stamp_t;
+
+/* Candidate paths in the order the loaders try them */
+typedef struct config_cache_sources {
+  char path[CONFIG_CACHE_MAX_SOURCES][CONFIG_CACHE_PATH_MAX];
+  config_cache_stamp_t stamp[CONFIG_CACHE_MAX_SOURCES]; /* see config_cache_stamp */
+  uint32_t count;
+} config_cache_sources_t;
+
+/* Growable payload written by a codec */
+typedef struct config_cache_buf {
+  uint8_t* data;
+  size_t len;
+  size_t cap;
+} config_cache_buf_t;
+
+/* Bounds-checked cursor over a mapped payload; ok drops on any overrun */
+typedef struct config_cache_reader {
+  const uint8_t* p;
+  const uint8_t* end;
+  bool ok;
+} config_cache_reader_t;
+
+/* A validated, mapped entry */
+typedef struct config_cache_map {
+  void* addr;
+  size_t len;
+  config_cache_reader_t payload;
+} config_cache_map_t;
+
+/* Sources */
+void config_cache_sources_init(config_cache_sources_t* src);
+bool config_cache_sources_add(config_cache_sources_t* src, const char* fmt, ...) HXM_ATTR_PRINTF(2, 3);
+void config_cache_stamp(config_cache_sources_t* src);
+
+/* Entries */
+bool config_cache_open(config_cache_map_t* map, config_cache_kind_t kind, const config_cache_sources_t* src);
+void config_cache_close(config_cache_map_t* map);
+void config_cache_store(config_cache_kind_t kind, const config_cache_sources_t* src, const config_cache_buf_t* payload);
+
+/* Codec helpers; strings are stored NUL-terminated, NULL is kept distinct */
+void config_cache_buf_free(config_cache_buf_t* buf);
+void config_cache_put(config_cache_buf_t* buf, const void* data, size_t len);
+void config_cache_put_u32(config_cache_buf_t* buf, uint32_t v);
+void config_cache_put_u64(config_cache_buf_t* buf, uint64_t v);
+void config_cache_put_str(config_cache_buf_t* buf, const char* str);
+bool config_cache_get(config_cache_reader_t* r, void* out, size_t len);
+uint32_t config_cache_get_u32(config_cache_reader_t* r);
+uint64_t config_cache_get_u64(config_cache_reader_t* r);
+/* Returns a pointer into the mapping, NULL for a stored NULL or on overrun */
+const char* config_cache_get_str(config_cache_reader_t* r);
+
+/* config_t codec: load replaces *config on a hit and leaves it alone otherwise */
+bool config_cache_load_config(config_t* config, const config_cache_sources_t* src);
+void config_cache_store_config(const config_t* config, const config_cache_sources_t* src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_CACHE_H */
@@ -0,0 +1,69 @@
+/*
+ * config_watch.h - Reload hxm.conf, themerc and menu.conf when they change
+ *
+ * Responsibilities:
+ * - inotify watches on the directories the config search path reads from.
+ *   Directories rather than files, so editors that save by rename are seen
+ *   and a user file created later takes over from the /etc fallback
+ * - Debounce: every relevant event re-arms a one-shot timerfd, and the
+ *   reload runs once the files have been quiet for CONFIG_WATCH_DEBOUNCE_MS
+ *
+ * Both descriptors are nonblocking and polled from the main epoll set.
+ * config_watch_take reports which files changed; what to re-apply is decided
+ * by the caller (see config_diff).
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef CONFIG_WATCH_H
+#define CONFIG_WATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CONFIG_WATCH_DEBOUNCE_MS 150
+
+enum config_watch_file {
+  CONFIG_WATCH_MAIN = 1u << 0,  /* hxm.conf */
+  CONFIG_WATCH_THEME = 1u << 1, /* themerc */
+  CONFIG_WATCH_MENU = 1u << 2,  /* menu.conf */
+  CONFIG_WATCH_ALL = CONFIG_WATCH_MAIN | CONFIG_WATCH_THEME | CONFIG_WATCH_MENU,
+};
+
+typedef struct config_watch {
+  int inotify_fd;
+  int timer_fd;
+  uint32_t pending; /* config_watch_file bits seen since the last take */
+  bool settled;     /* debounce elapsed with pending set */
+} config_watch_t;
+
+/* Open the inotify and timer descriptors; false (fds -1) if unavailable */
+bool config_watch_init(config_watch_t* w);
+
+/* Watch dir; missing directories are skipped silently */
+void config_watch_add_dir(config_watch_t* w, const char* dir);
+
+/* Watch every directory hxm.conf, themerc and menu.conf are searched in */
+void config_watch_add_search_path(config_watch_t* w);
+
+/* Drain inotify_fd and re-arm the debounce timer if a config file changed */
+void config_watch_handle_inotify(config_watch_t* w);
+
+/* Drain timer_fd; the pending changes are now settled */
+void config_watch_handle_timer(config_watch_t* w);
+
+/* Settled config_watch_file bits, cleared by the call; 0 while debouncing */
+uint32_t config_watch_take(config_watch_t* w);
+
+void config_watch_destroy(config_watch_t* w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_WATCH_H */
@@ -0,0 +1,107 @@
+/*
+ * control.h - Unix-domain control socket serving live JSON diagnostics
+ *
+ * The socket lives at $HXM_CONTROL_SOCKET, or $XDG_RUNTIME_DIR/hxm-<DISPLAY>.sock
+ * when that is unset; an empty HXM_CONTROL_SOCKET, or no runtime dir,
+ * disables it. Only peers with our uid are served.
+ *
+ * Protocol: the client writes one line naming a section, the server answers
+ * with one JSON object and closes the connection.
+ *
+ *   all      every section below (also an empty line)
+ *   layers   stacking layers per screen, bottom to top
+ *   focus    focused window and the focus MRU
+ *   cookies  cookie jar occupancy and per-type reply stats
+ *   ticks    tick phase latency
+ *   memory   slotmap, arenas, caches and maps
+ *   clients  per-client state and dirty bits
+ *   wakeups  event loop wakeups by cause (see wake_cause_t)
+ *   requests X requests sent by kind and per tick, ConfigureRequest and
+ *            client message coalescing
+ *
+ * `hxm --query [section]` is the matching client; socat works too.
+ *
+ * The snapshot is taken in full when the request line arrives, so it is
+ * consistent with one point of the event loop; writing it back is spread
+ * over ticks, CONTROL_WRITE_CHUNK bytes per connection per wakeup.
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define CONTROL_SOCKET_ENV "HXM_CONTROL_SOCKET"
+
+#define CONTROL_MAX_CONNS 4
+#define CONTROL_MAX_REQUEST 64
+#define CONTROL_WRITE_CHUNK (16u * 1024u)
+#define CONTROL_SNAPSHOT_MAX (1u << 20)
+
+struct server;
+
+typedef struct control_conn {
+  int fd; /* -1 = free */
+  bool writing;
+  uint32_t in_len;
+  char in[CONTROL_MAX_REQUEST];
+  char* out;
+  size_t out_len;
+  size_t out_off;
+} control_conn_t;
+
+typedef struct control {
+  int listen_fd; /* -1 = disabled */
+  int epoll_fd;
+  char* path;
+  control_conn_t conns[CONTROL_MAX_CONNS];
+} control_t;
+
+/* Mark every descriptor closed; safe to call on a zeroed control_t */
+void control_init(control_t* c);
+
+/* Resolve the socket path; false when the socket is disabled */
+bool control_socket_path(char* buf, size_t len);
+
+/* Bind and listen, adding the socket to epoll_fd. False leaves it disabled */
+bool control_open(control_t* c, int epoll_fd);
+
+/* Close every connection and the listener, and unlink the socket */
+void control_close(control_t* c);
+
+/* True if fd is the listener or one of its connections */
+bool control_owns_fd(const control_t* c, int fd);
+
+/* Service readiness (epoll events) on an owned fd */
+void control_handle(control_t* c, struct server* s, int fd, uint32_t events);
+
+/* JSON for one section (or "all"), newline terminated and malloc'd.
+ * NULL for an unknown section
+ */
+char* control_snapshot(struct server* s, const char* section, size_t* len_out);
+
+/* Client side: send section, copy the answer to out. Returns 0 on success */
+int control_query(const char* section, FILE* out);
+
+/*
+ * Client side: sample the wakeups section, sleep seconds, sample again and
+ * report the difference. Returns 0 when hxm woke for nothing but the two
+ * queries, 1 when it woke otherwise, -1 on error.
+ */
+int control_idle_check(unsigned seconds, FILE* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONTROL_H */
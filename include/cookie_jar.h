@@ -46,7 +46,9 @@ extern "C" {
 #include <assert.h>
 #include <xcb/xcb.h>
 
+#include "ds.h"
 #include "handle.h"
+#include "hxm.h"
 
 /* Cookie categories for diagnostics/dispatch */
 typedef enum cookie_type {
@@ -56,6 +58,8 @@ typedef enum cookie_type {
   COOKIE_GET_GEOMETRY,
   COOKIE_GET_PROPERTY,
   COOKIE_GET_PROPERTY_FRAME_EXTENTS,
+  COOKIE_GET_PROPERTY_ICON_HEADER,
+  COOKIE_GET_PROPERTY_ICON_PIXELS,
 
   COOKIE_QUERY_TREE,
   COOKIE_QUERY_POINTER,
@@ -66,10 +70,15 @@ typedef enum cookie_type {
 
   COOKIE_GRAB_POINTER,
   COOKIE_GRAB_KEYBOARD,
+  COOKIE_GRAB_KEY,
   COOKIE_RANDR_GET_SCREEN_RESOURCES,
-  COOKIE_RANDR_GET_CRTC_INFO
+  COOKIE_RANDR_GET_CRTC_INFO,
+
+  COOKIE_TYPE_COUNT
 } cookie_type_t;
 
+const char* cookie_type_name(cookie_type_t type);
+
 struct server;
 struct cookie_slot;
 
@@ -103,11 +112,54 @@ typedef struct cookie_slot {
 
   uint64_t timestamp_ns; /* enqueue time */
   uint64_t txn_id;       /* optional transaction/group id */
+  uint32_t group;        /* cookie group id, 0 = ungrouped */
 
   cookie_handler_fn handler;
   bool live;
+
+  /* Cookies of the same client, linked by sequence (0 ends the list).
+   * Sequences survive backshift and growth, so moves need no fixup.
+   */
+  uint32_t client_prev;
+  uint32_t client_next;
 } cookie_slot_t;
 
+/* Cookie groups
+ *
+ * A group collects the replies of a related request set (e.g. the probes of
+ * one client manage) and dispatches them together once the last member has
+ * answered or timed out:
+ *
+ *   cookie_jar_group_begin(cj, txn_id, client, on_complete);
+ *   ... cookie_jar_push(...) for each member ...
+ *   cookie_jar_group_end(cj, s);
+ *
+ * On completion every member's handler runs in sequence order in a single
+ * pass, with the same borrowed reply/err contract as ungrouped cookies, then
+ * on_complete is called once. cookie_jar_remove_client drops a client's
+ * groups together with any replies already collected, without callbacks.
+ */
+typedef void (*cookie_group_fn)(struct server* s, uint64_t txn_id, handle_t client);
+
+typedef struct cookie_member {
+  cookie_slot_t slot;
+  void* reply;
+  xcb_generic_error_t* err;
+} cookie_member_t;
+
+typedef struct cookie_group {
+  uint64_t txn_id;
+  handle_t client;
+  cookie_group_fn on_complete;
+  uint32_t pending; /* members still in the table */
+  bool sealed;      /* group_end called, no more members */
+  bool live;
+
+  cookie_member_t* members; /* collected replies, in arrival order */
+  size_t member_len;
+  size_t member_cap;
+} cookie_group_t;
+
 /* Must be power of two */
 #ifndef COOKIE_JAR_CAP
 #define COOKIE_JAR_CAP 1024u
@@ -122,14 +174,81 @@ typedef struct cookie_slot {
 #define COOKIE_JAR_TIMEOUT_NS (5ull * 1000ull * 1000ull * 1000ull)
 #endif
 
+/* Deadline index entry (min-heap on timestamp_ns)
+ * Entries are validated lazily against the slot table by sequence, so
+ * backshift moves and table growth never need to touch the heap.
+ */
+typedef struct cookie_deadline {
+  uint64_t timestamp_ns;
+  uint32_t sequence;
+} cookie_deadline_t;
+
+/* Telemetry, always collected
+ *
+ * Reply latency runs from cookie_jar_push to dispatch, so it includes both
+ * the X server round trip and any ticks the reply sat queued behind the
+ * per-drain budget; budget_limited counts the drains that left answered
+ * replies behind, which separates the two.
+ */
+#define COOKIE_JAR_PROBE_BUCKETS 8 /* probe lengths 0..6, then 7 and longer */
+
+typedef struct cookie_type_stats {
+  uint64_t pushed;
+  uint64_t completed; /* reply delivered */
+  uint64_t errors;    /* X error delivered */
+  uint64_t timed_out; /* expired after COOKIE_JAR_TIMEOUT_NS */
+  uint64_t dropped;   /* removed with their client, never dispatched */
+  latency_hist_t latency; /* completed and errors */
+} cookie_type_stats_t;
+
+typedef struct cookie_jar_stats {
+  cookie_type_stats_t type[COOKIE_TYPE_COUNT];
+  uint64_t probe_len[COOKIE_JAR_PROBE_BUCKETS]; /* per insert */
+  uint32_t probe_len_max;
+  uint32_t grows;
+  size_t live_max;
+  uint64_t drains;
+  uint64_t budget_limited;
+} cookie_jar_stats_t;
+
 typedef struct cookie_jar {
   cookie_slot_t* slots;
   size_t cap;
   size_t live_count;
   size_t scan_cursor;
+  size_t probe_max; /* no live slot sits further than this from its home */
   uint64_t earliest_cookie_ns;
   bool timeout_hint_dirty;
   bool replies_may_exist;
+
+  cookie_deadline_t* deadlines;
+  size_t deadline_len;
+  size_t deadline_cap;
+
+  /* Live sequences in ascending (wrap-aware) order, ring buffer.
+   * Entries are dropped lazily once their slot is gone.
+   */
+  uint32_t* order;
+  size_t order_head;
+  size_t order_len;
+  size_t order_cap; /* power of two */
+
+  /* Rely on X delivering replies in request order: drain polls from the
+   * lowest live sequence and stops at the first one not yet answered.
+   * When false, drain falls back to a fair scan of the whole table.
+   */
+  bool ordered;
+
+  /* client handle -> sequence of its most recent cookie, the head of the
+   * client_prev/client_next list; only clients with live cookies appear
+   */
+  hash_map_t client_cookies;
+
+  cookie_group_t* groups; /* group id = index + 1 */
+  uint32_t group_cap;
+  uint32_t open_group; /* pushes join this group while non-zero */
+
+  cookie_jar_stats_t* stats;
 } cookie_jar_t;
 
 /* Initialize/destroy */
@@ -144,18 +263,32 @@ void cookie_jar_destroy(cookie_jar_t* cj);
  */
 void cookie_jar_push(cookie_jar_t* cj, uint32_t sequence, cookie_type_t type, handle_t client, uintptr_t data, uint64_t txn_id, cookie_handler_fn handler);
 
+/* Open a cookie group; subsequent pushes join it until cookie_jar_group_end.
+ * Groups do not nest. Returns the group id.
+ */
+uint32_t cookie_jar_group_begin(cookie_jar_t* cj, uint64_t txn_id, handle_t client, cookie_group_fn on_complete);
+
+/* Seal the open group. If every member already completed (or the group is
+ * empty) on_complete runs immediately.
+ */
+void cookie_jar_group_end(cookie_jar_t* cj, struct server* s);
+
 /* Remove all pending cookies associated with a client handle.
- * Returns number of removed slots.
+ * Walks only that client's cookies. Returns number of removed slots.
  */
 size_t cookie_jar_remove_client(cookie_jar_t* cj, handle_t client);
 
+/* Live slot waiting on sequence, or NULL */
+const cookie_slot_t* cookie_jar_lookup(const cookie_jar_t* cj, uint32_t sequence);
+
 /* Drain ready replies (non-blocking, conn is required)
  * Polls up to max_replies ready replies and dispatches handlers
  * Also expires timed out cookies (handler called with reply=NULL)
  *
  * If max_replies is 0, COOKIE_JAR_MAX_REPLIES_PER_TICK is used
+ * Returns the number of slots dispatched (replies, errors and timeouts)
  */
-void cookie_jar_drain(cookie_jar_t* cj, xcb_connection_t* conn, struct server* s, size_t max_replies);
+size_t cookie_jar_drain(cookie_jar_t* cj, xcb_connection_t* conn, struct server* s, size_t max_replies);
 
 /* Expire timed-out cookies without polling X replies.
  * If max_expirations is 0, COOKIE_JAR_MAX_REPLIES_PER_TICK is used.
@@ -182,6 +315,12 @@ static inline size_t cookie_jar_capacity(const cookie_jar_t* cj) {
   return cj->cap;
 }
 
+/* Render per-type counters, reply latency and table health; types never
+ * pushed are omitted. Returns bytes written, excluding the NUL
+ */
+size_t cookie_jar_stats_format(const cookie_jar_t* cj, char* buf, size_t cap);
+void cookie_jar_stats_dump(const cookie_jar_t* cj);
+
 #ifdef __cplusplus
 }
 #endif
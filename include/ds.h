@@ -4,7 +4,9 @@
  * Primitives used throughout the WM:
  * - arena: fast, resettable allocator for per-tick temporaries
  * - small_vec: pointer vector with small inline storage
+ * - DS_VEC_DEFINE: typed vectors with inline storage (handle_vec, u32_vec)
  * - hash_map: uint64_t -> void* open-addressing hash map (key 0 reserved)
+ * - epoch_map: per-tick uint64_t -> void* map with O(1) clear
  *
  * Design goals:
  * - predictable performance
@@ -27,6 +29,10 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "handle.h"
 
 /* ---------------- Arena ---------------- */
 
@@ -44,6 +50,14 @@ typedef struct arena {
 
   /* Default block size for new allocations */
   size_t block_size;
+
+  /* Accounting (payload bytes) */
+  size_t used;        /* allocated since the last reset, after alignment */
+  size_t blocks_used; /* blocks touched since the last reset */
+  size_t reserved;    /* held across all blocks */
+  size_t blocks;      /* blocks held */
+  size_t high_water;  /* decaying peak of used, updated on reset */
+  uint64_t shrinks;   /* resets that released memory */
 } arena_t;
 
 /* Initialize arena with a block size hint (0 => sensible default) */
@@ -58,7 +72,14 @@ void* arena_alloc(arena_t* a, size_t size);
 char* arena_strndup(arena_t* a, const char* s, size_t n);
 char* arena_strdup(arena_t* a, const char* s);
 
-/* Reset arena for reuse (keeps first block for amortization) */
+/* Reset arena for reuse (keeps blocks for amortization)
+ *
+ * Decay policy: each reset folds used into high_water, which otherwise
+ * decays toward recent usage. Once reserved exceeds twice the working set
+ * (high_water plus headroom, at least block_size), trailing blocks are freed
+ * and the first block is resized to the working set. One storm tick thus
+ * costs memory only until usage has been low for a while.
+ */
 void arena_reset(arena_t* a);
 
 /* Free all memory associated with the arena */
@@ -106,19 +127,134 @@ static inline bool small_vec_empty(const small_vec_t* v) {
   return !v || v->length == 0u;
 }
 
+/* ---------------- Typed vectors ----------------
+ *
+ * DS_VEC_DEFINE(name, type, inline_cap) generates name_t plus inline
+ * init/destroy/clear/push/pop/insert/remove_at/find/remove/remove_swap.
+ * Elements are stored by value, so scans stay contiguous and need no
+ * void* round-trips. Like small_vec, the first inline_cap elements live in
+ * the struct: a vector must not be copied or moved once initialized.
+ * type must be comparable with ==.
+ */
+
+/* Out-of-line growth shared by every typed vector (aborts on OOM) */
+void ds_vec_grow(void** items, size_t* capacity, void* inline_storage, size_t length, size_t elem_size,
+                 size_t min_cap);
+
+#define DS_VEC_DEFINE(name, type, inline_cap)                                                          \
+  typedef struct name {                                                                                \
+    type* items;                                                                                       \
+    size_t length;                                                                                     \
+    size_t capacity;                                                                                   \
+    type inline_storage[inline_cap];                                                                   \
+  } name##_t;                                                                                          \
+                                                                                                       \
+  static inline void name##_init(name##_t* v) {                                                        \
+    v->items = v->inline_storage;                                                                      \
+    v->length = 0;                                                                                     \
+    v->capacity = (inline_cap);                                                                        \
+  }                                                                                                    \
+  static inline void name##_destroy(name##_t* v) {                                                     \
+    if (v->items != v->inline_storage)                                                                 \
+      free(v->items);                                                                                  \
+    name##_init(v);                                                                                    \
+  }                                                                                                    \
+  static inline void name##_clear(name##_t* v) {                                                       \
+    v->length = 0;                                                                                     \
+  }                                                                                                    \
+  static inline void name##_reserve(name##_t* v, size_t n) {                                           \
+    if (n > v->capacity)                                                                               \
+      ds_vec_grow((void**)&v->items, &v->capacity, v->inline_storage, v->length, sizeof(type), n);     \
+  }                                                                                                    \
+  static inline void name##_push(name##_t* v, type item) {                                             \
+    if (v->length == v->capacity)                                                                      \
+      name##_reserve(v, v->length + 1);                                                                \
+    v->items[v->length++] = item;                                                                      \
+  }                                                                                                    \
+  static inline bool name##_pop(name##_t* v, type* out) {                                              \
+    if (v->length == 0)                                                                                \
+      return false;                                                                                    \
+    *out = v->items[--v->length];                                                                      \
+    return true;                                                                                       \
+  }                                                                                                    \
+  /* Insert at idx (clamped to length), shifting the tail up */                                        \
+  static inline void name##_insert(name##_t* v, size_t idx, type item) {                               \
+    if (v->length == v->capacity)                                                                      \
+      name##_reserve(v, v->length + 1);                                                                \
+    if (idx > v->length)                                                                               \
+      idx = v->length;                                                                                 \
+    memmove(&v->items[idx + 1], &v->items[idx], (v->length - idx) * sizeof(type));                     \
+    v->items[idx] = item;                                                                              \
+    v->length++;                                                                                       \
+  }                                                                                                    \
+  static inline void name##_remove_at(name##_t* v, size_t idx) {                                       \
+    if (idx >= v->length)                                                                              \
+      return;                                                                                          \
+    memmove(&v->items[idx], &v->items[idx + 1], (v->length - idx - 1) * sizeof(type));                 \
+    v->length--;                                                                                       \
+  }                                                                                                    \
+  /* Index of the first match, or SIZE_MAX */                                                          \
+  static inline size_t name##_find(const name##_t* v, type item) {                                     \
+    for (size_t i = 0; i < v->length; i++) {                                                           \
+      if (v->items[i] == item)                                                                         \
+        return i;                                                                                      \
+    }                                                                                                  \
+    return SIZE_MAX;                                                                                   \
+  }                                                                                                    \
+  /* Stable remove of the first match; returns true if found */                                        \
+  static inline bool name##_remove(name##_t* v, type item) {                                           \
+    size_t idx = name##_find(v, item);                                                                 \
+    if (idx == SIZE_MAX)                                                                               \
+      return false;                                                                                    \
+    name##_remove_at(v, idx);                                                                          \
+    return true;                                                                                       \
+  }                                                                                                    \
+  /* Unordered remove of the first match; returns true if found */                                     \
+  static inline bool name##_remove_swap(name##_t* v, type item) {                                      \
+    size_t idx = name##_find(v, item);                                                                 \
+    if (idx == SIZE_MAX)                                                                               \
+      return false;                                                                                    \
+    v->items[idx] = v->items[--v->length];                                                             \
+    return true;                                                                                       \
+  }
+
+#ifndef HANDLE_VEC_INLINE_CAP
+#define HANDLE_VEC_INLINE_CAP 16
+#endif
+#ifndef U32_VEC_INLINE_CAP
+#define U32_VEC_INLINE_CAP 16
+#endif
+
+/* Client handles by value: stacking layers, manage order */
+DS_VEC_DEFINE(handle_vec, handle_t, HANDLE_VEC_INLINE_CAP)
+/* Window ids, atoms and other 32-bit protocol values */
+DS_VEC_DEFINE(u32_vec, uint32_t, U32_VEC_INLINE_CAP)
+
 /* ---------------- Hash map ----------------
  *
- * Open addressing with linear probing
- * Key type: uint64_t
- * Value type: void*
+ * Open addressing, key type: uint64_t, value type: void*
+ *
+ * Two layouts share this API, chosen per map at init time:
+ * - HASH_MAP_LINEAR (hash_map_init, also the zeroed state): linear probing
+ *   over 24-byte entries with backshift deletion
+ * - HASH_MAP_SWISS (hash_map_init_swiss): one control byte per slot probed
+ *   16 at a time (SSE2 where available), keys and values in split arrays.
+ *   Better for large, lookup-heavy maps: a miss usually touches one
+ *   16-byte control group and no keys at all
  *
  * Invariants:
  * - key=0 is reserved as an empty marker and must not be inserted
  *
  * Notes:
  * - This API does not take ownership of values
+ * - Iterate with hash_map_next; entries is only meaningful for the linear layout
  */
 
+typedef enum hash_map_layout {
+  HASH_MAP_LINEAR = 0,
+  HASH_MAP_SWISS,
+} hash_map_layout_t;
+
 typedef struct hash_map_entry {
   uint64_t key;
   void* value;
@@ -130,18 +266,28 @@ typedef struct hash_map {
   size_t capacity;
   size_t size;
   size_t max_load;
+
+  /* Swiss layout: ctrl[capacity], keys[capacity], values[capacity] in one block */
+  uint8_t* ctrl;
+  uint64_t* keys;
+  void** values;
+  size_t tombstones;
+  uint8_t layout;
 } hash_map_t;
 
 /* Initialize empty map */
 void hash_map_init(hash_map_t* map);
 
-/* Free internal storage */
+/* Initialize empty map using the Swiss-table layout */
+void hash_map_init_swiss(hash_map_t* map);
+
+/* Free internal storage (layout is kept) */
 void hash_map_destroy(hash_map_t* map);
 
 /* Remove all entries but keep allocated storage for reuse */
 void hash_map_clear(hash_map_t* map);
 
-/* Insert or replace (returns true on success)
+/* Insert or replace (returns true if key was already present)
  * If key already exists, its value is replaced
  */
 bool hash_map_insert(hash_map_t* map, uint64_t key, void* value);
@@ -159,11 +305,111 @@ static inline bool hash_map_empty(const hash_map_t* map) {
   return !map || map->size == 0u;
 }
 
+/* Iterate live entries: start with *cursor = 0, returns false when done.
+ * The map must not be modified during iteration.
+ * Walks every slot, so cost is the peak capacity, not the size: see
+ * DS_HOT_PATH_ENTER.
+ */
+bool hash_map_next(const hash_map_t* map, size_t* cursor, uint64_t* key, void** value);
+
+/*
+ * Hot-path guard (debug builds only).
+ * A map grown by one burst keeps its capacity, so a full walk on every tick
+ * pays for the burst forever. The per-tick phases are bracketed with
+ * DS_HOT_PATH_ENTER/LEAVE and hash_map_next asserts inside them; per-tick
+ * data belongs in epoch_map_t, which iterates in O(entries).
+ */
+#ifndef NDEBUG
+extern uint32_t ds_hot_path_depth;
+#define DS_HOT_PATH_ENTER() ((void)ds_hot_path_depth++)
+#define DS_HOT_PATH_LEAVE() ((void)ds_hot_path_depth--)
+#else
+#define DS_HOT_PATH_ENTER() ((void)0)
+#define DS_HOT_PATH_LEAVE() ((void)0)
+#endif
+
 /* expose capacity for diagnostics */
 static inline size_t hash_map_capacity(const hash_map_t* map) {
   return map ? map->capacity : 0u;
 }
 
+/* ---------------- Epoch map ----------------
+ *
+ * Insertion-ordered uint64_t -> void* map for data that lives for one tick.
+ *
+ * Each index slot is stamped with the epoch it was written in; slots from
+ * older epochs read as empty. Clearing bumps the epoch instead of touching
+ * storage, so a map grown by an event storm costs nothing on idle ticks.
+ *
+ * Entries are kept densely in insertion order, which is also the iteration
+ * order. Removing an entry leaves a hole that iteration skips; reinserting
+ * the same key in the same epoch reuses its original position.
+ *
+ * Invariants:
+ * - values must be non-NULL (NULL marks a removed entry)
+ * - any key, including 0, is valid
+ *
+ * Notes:
+ * - A zeroed epoch_map_t is valid and empty
+ * - This API does not take ownership of values
+ */
+
+typedef struct epoch_map_slot {
+  uint32_t epoch;
+  uint32_t idx; /* index into keys/values */
+} epoch_map_slot_t;
+
+typedef struct epoch_map {
+  epoch_map_slot_t* slots;
+  size_t capacity; /* slots, power of two */
+  size_t max_load;
+
+  /* Dense entries in insertion order, max_load long */
+  uint64_t* keys;
+  void** values;
+  size_t count; /* entries written this epoch, including removed ones */
+
+  size_t size; /* live entries */
+  uint32_t epoch;
+} epoch_map_t;
+
+void epoch_map_init(epoch_map_t* map);
+void epoch_map_destroy(epoch_map_t* map);
+
+/* Drop every entry in O(1), keeping storage for reuse */
+void epoch_map_clear(epoch_map_t* map);
+
+/* Insert or replace; returns true if key was already present */
+bool epoch_map_insert(epoch_map_t* map, uint64_t key, void* value);
+
+/* Get value for key or NULL */
+void* epoch_map_get(const epoch_map_t* map, uint64_t key);
+
+/* Remove key if present (returns true if removed) */
+bool epoch_map_remove(epoch_map_t* map, uint64_t key);
+
+static inline size_t epoch_map_size(const epoch_map_t* map) {
+  return map ? map->size : 0u;
+}
+
+/* Iterate live entries in insertion order: start with *cursor = 0.
+ * Inserting during iteration is allowed; new entries are visited too.
+ */
+bool epoch_map_next(const epoch_map_t* map, size_t* cursor, uint64_t* key, void** value);
+
+/* ---------------- Checksum ----------------
+ *
+ * CRC-32C (Castagnoli), for cheap change detection on small buffers such as
+ * property values. Uses the SSE4.2 crc32 instruction when the CPU has it,
+ * a table otherwise; both produce the same value.
+ *
+ * Chain calls by passing the previous result as crc; start from 0.
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t len);
+
+/* "sse4.2" or "table" */
+const char* crc32c_kernel(void);
+
 #ifdef __cplusplus
 }
 #endif
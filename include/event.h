@@ -5,21 +5,32 @@
  * - server_t: global WM state ("world" object)
  * - event_buckets_t: coalescing storage for tick-based event processing
  * - pending_config_t: merged ConfigureRequest representation
+ * - tick_budget_t: runtime per-tick event/reply budgets
+ * - event_ring_t: preallocated 32-byte staging slots for ingested events
  * - event loop entry points (init/run/cleanup, ingest/process, cookie draining)
  *
  * Tick model:
  * 1) Ingest   : poll X events + signals + timers, bucket/coalesce events
- * 2) Process  : apply logical updates from buckets to in-memory model
- * 3) Flush    : emit X requests once per tick, then xcb_flush
+ * 2) Input    : lifecycle, keys, buttons, client messages, focus, due
+ *               timers, motion; committed and flushed early when bulk work
+ *               is waiting
+ * 3) Bulk     : replies, expose, configure, property, damage; property
+ *               work past the tick's time budget moves to the next tick
+ * 4) Flush    : emit X requests once per tick, then xcb_flush
  *
  * Contracts:
- * - Not thread-safe, server_t is owned by the main thread
+ * - Not thread-safe, server_t is owned by the main thread; with
+ * config.input_thread the X socket is read elsewhere (x_reader.h), but
+ * events still reach server_t only through event_ingest
  * - No synchronous X replies in hot paths (use cookie_jar)
- * - Bounded work per tick (MAX_EVENTS_PER_TICK,
+ * - Bounded work per tick (tick_budget_t, seeded from MAX_EVENTS_PER_TICK and
  * COOKIE_JAR_MAX_REPLIES_PER_TICK)
  * - Memory in tick_arena is valid until the next tick (arena_reset)
  *
  * Notes:
+ * - Deferred work (hover focus, trailing title refreshes, pacing, cookie
+ * expiry) lives on s->timers; timer_fd is armed for the wheel's next wakeup
+ * right before each wait
  * - hash_map_t stores void* values; handles are stored via handle_conv.h
  * - Many small_vec_t buckets hold pointers to events allocated in tick_arena
  */
@@ -35,25 +46,144 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include <sys/epoll.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_keysyms.h>
 
 #include "client.h"
+#include "cgroup_worker.h"
 #include "config.h"
+#include "config_watch.h"
+#include "control.h"
+#include "compositor.h"
 #include "cookie_jar.h"
 #include "ds.h"
+#include "focus_mru.h"
+#include "freezer.h"
+#include "frame_pool.h"
 #include "handle.h"
 #include "handle_conv.h"
+#include "handoff.h"
 #include "hxm.h"
+#include "icon_cache.h"
+#include "launcher.h"
+#include "mem_budget.h"
 #include "menu.h"
+#include "prewarm.h"
+#include "render_worker.h"
 #include "slotmap.h"
+#include "snap.h"
+#include "spatial.h"
+#include "tiling.h"
+#include "timer_wheel.h"
+#include "title_cache.h"
+#include "transient_groups.h"
+#include "x_reader.h"
+
+/* While ingest keeps hitting its budget, flush at most this often (~125 Hz) */
+#define EVENT_BUSY_FLUSH_NS 8000000u
+
+/*
+ * Why server_wait_for_events returned, most significant first. A wakeup
+ * with several ready fds counts once, under the first cause that applies.
+ * A timer_fd expiry with nothing due on the wheel, or EINTR, is spurious.
+ */
+typedef enum wake_cause {
+  WAKE_X = 0,    /* X socket, or the input thread's notify_fd */
+  WAKE_SIGNAL,   /* signal_fd */
+  WAKE_TIMER,    /* timer_fd with a wheel timer due */
+  WAKE_OTHER,    /* control socket, launcher helper, config watch, render worker */
+  WAKE_TIMEOUT,  /* epoll_wait timeout: a held flush or deferred property work */
+  WAKE_SPURIOUS,
+  WAKE_CAUSE_COUNT
+} wake_cause_t;
+
+const char* wake_cause_name(wake_cause_t cause);
 
 /* Bounded event processing per tick */
 #ifndef MAX_EVENTS_PER_TICK
 #define MAX_EVENTS_PER_TICK 512u
 #endif
 
+/* Adaptive tick budget
+ *
+ * MAX_EVENTS_PER_TICK / COOKIE_JAR_MAX_REPLIES_PER_TICK are the starting
+ * points. After every tick the loop feeds the measured phase costs back into
+ * tick_budget_update, which shrinks the more expensive side multiplicatively
+ * when the tick overran TICK_BUDGET_TARGET_NS and grows a saturated side when
+ * there is headroom. While a move/resize is active replies are capped at
+ * TICK_BUDGET_REPLIES_INTERACTIVE so input buckets win.
+ */
+#ifndef TICK_BUDGET_TARGET_NS
+#define TICK_BUDGET_TARGET_NS (4ull * 1000ull * 1000ull)
+#endif
+#define TICK_BUDGET_EVENTS_MIN 64u
+#define TICK_BUDGET_EVENTS_MAX 4096u
+#define TICK_BUDGET_REPLIES_MIN 8u
+#define TICK_BUDGET_REPLIES_MAX 1024u
+#define TICK_BUDGET_REPLIES_INTERACTIVE 16u
+
+typedef struct tick_budget {
+  uint32_t max_events;  /* 0 = MAX_EVENTS_PER_TICK */
+  uint32_t max_replies; /* 0 = COOKIE_JAR_MAX_REPLIES_PER_TICK */
+
+  /* Work actually done this tick, reported by ingest/drain */
+  uint32_t events_used;
+  uint32_t replies_used;
+} tick_budget_t;
+
+static inline uint32_t tick_budget_events(const tick_budget_t* b) {
+  return b->max_events ? b->max_events : MAX_EVENTS_PER_TICK;
+}
+
+static inline uint32_t tick_budget_replies(const tick_budget_t* b) {
+  return b->max_replies ? b->max_replies : COOKIE_JAR_MAX_REPLIES_PER_TICK;
+}
+
+void tick_budget_init(tick_budget_t* b);
+
+/* Adjust budgets from the finished tick's sample
+ * interactive: a pointer-driven move/resize is in progress
+ */
+void tick_budget_update(tick_budget_t* b, const tick_sample_t* sample, bool interactive);
+
+/* Bulk lane property work guaranteed per tick, however late the tick runs */
+#ifndef EVENT_BULK_PROPS_MIN
+#define EVENT_BULK_PROPS_MIN 32u
+#endif
+
+/* Per-tick event staging ring
+ *
+ * X core events are fixed 32-byte wire packets. Ingestion drains whatever
+ * libxcb already has queued in a tight loop, copying each event into a
+ * preallocated slot and freeing the libxcb allocation immediately.
+ * Coalescing then runs over the staged batch and buckets point straight at
+ * the slots, so kept events need no second tick_arena copy.
+ *
+ * Slots are recycled at the start of every tick, the same lifetime as
+ * tick_arena. When the ring is missing or full, staging falls back to
+ * tick_arena.
+ */
+#define EVENT_SLOT_BYTES 32u
+#ifndef EVENT_RING_CAP
+#define EVENT_RING_CAP 1024u
+#endif
+
+typedef union event_slot {
+  uint8_t bytes[EVENT_SLOT_BYTES];
+  uint64_t align;
+} event_slot_t;
+
+typedef struct event_ring {
+  event_slot_t* slots;
+  uint32_t cap;
+  uint32_t used;
+} event_ring_t;
+
+void event_ring_init(event_ring_t* r, uint32_t cap);
+void event_ring_destroy(event_ring_t* r);
+
 /* Merged ConfigureRequest for coalescing */
 typedef struct pending_config {
   xcb_window_t window;
@@ -67,6 +197,11 @@ typedef struct pending_config {
   uint16_t mask; /* value_mask from the request */
 } pending_config_t;
 
+/* Screens managed by one process, the first ones of the display */
+#ifndef HXM_MAX_SCREENS
+#define HXM_MAX_SCREENS 8u
+#endif
+
 /* Event buckets for coalescing */
 typedef struct event_buckets {
   /* Ordered queues (ordering matters for correctness) */
@@ -74,43 +209,53 @@ typedef struct event_buckets {
   small_vec_t unmap_notifies;   /* xcb_unmap_notify_event_t* */
   small_vec_t destroy_notifies; /* xcb_destroy_notify_event_t* */
 
-  small_vec_t key_presses;     /* xcb_key_press_event_t* */
+  small_vec_t key_presses;     /* xcb_key_press_event_t*, see key_press_push */
   small_vec_t key_releases;    /* xcb_key_release_event_t* */
   small_vec_t button_events;   /* xcb_button_press_event_t* or
                                   xcb_button_release_event_t* */
-  small_vec_t client_messages; /* xcb_client_message_event_t* */
+  small_vec_t client_messages; /* xcb_client_message_event_t*, NULL once superseded */
 
-  /* Expose coalesced by window: window -> dirty_region_t* */
-  hash_map_t expose_regions;
-  /* Keys touched this tick for expose_regions (uint64_t* in tick_arena) */
-  small_vec_t expose_region_keys;
+  /* Coalescing maps are epoch maps: reset per tick is O(1) and iteration
+   * follows arrival order */
 
-  /* ConfigureRequest coalesced by window: window -> pending_config_t* */
-  hash_map_t configure_requests;
-  /* Keys touched this tick for configure_requests (uint64_t* in tick_arena) */
-  small_vec_t configure_request_keys;
+  /* Expose coalesced by window: window -> dirty_rects_t* */
+  epoch_map_t expose_regions;
+
+  /* ConfigureRequest coalesced by window: window -> pending_config_t*
+   * Managed windows only, as routed at ingest */
+  epoch_map_t configure_requests;
+
+  /* ConfigureRequests for windows we don't manage, in arrival order.
+   * Forwarded verbatim by the flush with no client lookups; a request merges
+   * into a recent entry for the same window. Storage is kept across ticks
+   * and freed in server_cleanup. */
+  pending_config_t* unmanaged_configs;
+  uint32_t unmanaged_configs_len;
+  uint32_t unmanaged_configs_cap;
 
   /* ConfigureNotify coalesced by window: window ->
    * xcb_configure_notify_event_t* */
-  hash_map_t configure_notifies;
-  /* Keys touched this tick for configure_notifies (uint64_t* in tick_arena) */
-  small_vec_t configure_notify_keys;
+  epoch_map_t configure_notifies;
+
+  /* Client messages with an absolute effect, see client_message_push:
+   * (window << 32 | hash of type and identity) -> 1 + client_messages index,
+   * and window -> 1 + index of its latest message of any type */
+  epoch_map_t client_message_keys;
+  epoch_map_t client_message_last;
+
+  /* Key presses that are auto-repeats: key_presses entry -> repeats it
+   * stands for, later repeats of the same chord folded in */
+  epoch_map_t key_repeats;
 
   /* Destroy tracker for this tick: window -> (void*)1 */
-  hash_map_t destroyed_windows;
-  /* Keys touched this tick for destroyed_windows (uint64_t* in tick_arena) */
-  small_vec_t destroyed_window_keys;
+  epoch_map_t destroyed_windows;
 
   /* PropertyNotify coalesced by (window, atom): combined key ->
    * xcb_property_notify_event_t* or small sentinel */
-  hash_map_t property_notifies;
-  /* Keys touched this tick for property_notifies (uint64_t* in tick_arena) */
-  small_vec_t property_notify_keys;
+  epoch_map_t property_notifies;
 
   /* MotionNotify latest per window: window -> xcb_motion_notify_event_t* */
-  hash_map_t motion_notifies;
-  /* Keys touched this tick for motion_notifies (uint64_t* in tick_arena) */
-  small_vec_t motion_notify_keys;
+  epoch_map_t motion_notifies;
 
   /* Enter/Leave latest (not per-window), used for pointer focus rules */
   struct {
@@ -128,19 +273,39 @@ typedef struct event_buckets {
     bool out_valid;
   } focus_notify;
 
-  /* Damage events coalesced by drawable: drawable -> dirty_region_t* */
-  hash_map_t damage_regions;
-  /* Keys touched this tick for damage_regions (uint64_t* in tick_arena) */
-  small_vec_t damage_region_keys;
+  /* Damage events coalesced by drawable: drawable -> dirty_rects_t* */
+  epoch_map_t damage_regions;
 
-  /* RandR coalescing */
+  /* RandR coalescing, sizes indexed like s->screens */
   bool randr_dirty;
-  uint16_t randr_width;
-  uint16_t randr_height;
+  uint8_t randr_screens; /* bit per screen with a size pending */
+  uint16_t randr_width[HXM_MAX_SCREENS];
+  uint16_t randr_height[HXM_MAX_SCREENS];
+
+  /* Keyboard mapping changed: regrab keys and rebuild key_dispatch */
+  bool keymap_dirty;
 
   /* Per-tick counters */
   uint64_t ingested;
   uint64_t coalesced;
+
+  /* Lifetime unmanaged ConfigureRequest volume, for tick_stats */
+  uint64_t unmanaged_forwarded; /* xcb_configure_window calls sent */
+  uint64_t unmanaged_coalesced; /* requests merged into a pending entry */
+
+  /* Lifetime client messages superseded by a later copy in the same tick */
+  uint64_t client_messages_dropped;
+
+  /* PropertyNotify the bulk lane ran out of time for, copied in arrival
+   * order and replayed ahead of the next tick's bucket. Storage is kept
+   * across ticks and freed in server_cleanup. */
+  xcb_property_notify_event_t* deferred_props;
+  uint32_t deferred_props_len;
+  uint32_t deferred_props_cap;
+
+  /* Lifetime lane volume, for tick_stats */
+  uint64_t input_flushes;  /* early flushes of the input lane */
+  uint64_t props_deferred; /* PropertyNotify pushed to a later tick */
 } event_buckets_t;
 
 /* Root dirty flags
@@ -153,36 +318,185 @@ enum {
   ROOT_DIRTY_WORKAREA = 1u << 3,
   ROOT_DIRTY_VISIBILITY = 1u << 4,
   ROOT_DIRTY_CURRENT_DESKTOP = 1u << 5,
-  ROOT_DIRTY_SHOWING_DESKTOP = 1u << 6
+  ROOT_DIRTY_SHOWING_DESKTOP = 1u << 6,
+  ROOT_DIRTY_COLORMAP = 1u << 7
 };
 
+/* Root properties hxm owns, each shadowed by the bytes it last wrote */
+typedef enum root_prop {
+  ROOT_PROP_CLIENT_LIST = 0,
+  ROOT_PROP_CLIENT_LIST_STACKING,
+  ROOT_PROP_NUMBER_OF_DESKTOPS,
+  ROOT_PROP_CURRENT_DESKTOP,
+  ROOT_PROP_VIRTUAL_ROOTS,
+  ROOT_PROP_DESKTOP_NAMES,
+  ROOT_PROP_DESKTOP_VIEWPORT,
+  ROOT_PROP_DESKTOP_GEOMETRY,
+  ROOT_PROP_WORKAREA,
+  ROOT_PROP_SHOWING_DESKTOP,
+  ROOT_PROP_COUNT
+} root_prop_t;
+
+/* Last value written to a root property, see wm_publish_root_prop */
+typedef struct published_prop {
+  uint8_t* data;
+  uint32_t len; /* bytes */
+  uint32_t cap;
+  xcb_atom_t type;
+  uint8_t format;
+  bool valid; /* false until the first write: always publish once */
+} published_prop_t;
+
 /* Interaction state (Move/Resize/Menu) */
 typedef enum interaction_mode { INTERACTION_NONE = 0, INTERACTION_MOVE, INTERACTION_RESIZE, INTERACTION_MENU } interaction_mode_t;
 
+/*
+ * Auto-repeat of the key held down. Only the last key pressed repeats, so
+ * one key is tracked. With XKB detectable auto-repeat a repeat is a press of
+ * the held key; without it, a release and press that share a timestamp.
+ */
+typedef struct key_repeat {
+  xcb_keycode_t held;            /* pressed and not yet released, 0 for none */
+  xcb_keycode_t released;        /* last key released, and when */
+  xcb_timestamp_t released_time;
+  bool detectable;               /* the server agreed to detectable auto-repeat */
+  uint64_t fired_ns;             /* tick a press of held last ran its binding */
+
+  uint64_t repeats; /* auto-repeat presses seen */
+  uint64_t folded;  /* of those, folded into an earlier repeat of the tick */
+  uint64_t capped;  /* repeat runs dropped by a binding's repeat_ms */
+} key_repeat_t;
+
+/* Modifier combinations indexed by key_dispatch: Shift, Control, Mod1, Mod3, Mod4 */
+#define KEY_DISPATCH_MOD_COMBOS 32
+#define KEY_DISPATCH_NONE 0xFFFFu
+
 typedef enum resize_dir { RESIZE_NONE = 0, RESIZE_TOP = 1u << 0, RESIZE_BOTTOM = 1u << 1, RESIZE_LEFT = 1u << 2, RESIZE_RIGHT = 1u << 3 } resize_dir_t;
 
 /* Monitor information */
 typedef struct monitor {
   rect_t geom;
   rect_t workarea;
+  uint32_t refresh_mhz; /* CRTC mode refresh rate, 0 if unknown */
+  uint32_t crtc;        /* RandR CRTC, 0 without RandR; matches monitors across snapshots */
 } monitor_t;
 
-/* Main server state */
-typedef struct server {
-  xcb_connection_t* conn;
+/* RandR mode id -> refresh, kept while CRTC info replies are outstanding */
+typedef struct randr_mode_rate {
+  uint32_t id;
+  uint32_t refresh_mhz;
+} randr_mode_rate_t;
+
+/*
+ * One X screen: its root and everything kept per root. A client belongs to
+ * the screen whose root it was a child of (client_hot_t.screen). Config,
+ * theme tiles, font, icon and title caches, the cookie jar, focus history
+ * and interaction state are shared by all screens.
+ */
+typedef struct screen {
+  int num;
   xcb_window_t root;
+  xcb_atom_t wm_selection; /* WM_Sn of num; XCB_NONE means WM_S0 */
 
   xcb_visualid_t root_visual;
   xcb_visualtype_t* root_visual_type;
   uint8_t root_depth;
 
   xcb_colormap_t default_colormap;
+  bool colormaps_static; /* no visual has a writable colormap: installing one changes nothing */
   xcb_window_t supporting_wm_check;
 
+  /* Root property dirty bits */
+  uint32_t root_dirty;
+
+  /* Published root properties, so unchanged rebuilds skip the write */
+  published_prop_t published[ROOT_PROP_COUNT];
+
+  /* Monitor configuration */
+  monitor_t* monitors;
+  uint32_t monitor_count;
+  uint8_t monitor_generation; /* bumped per monitor snapshot, never 0 once set; see client_hot_t.monitor */
+  monitor_t* randr_pending_monitors;
+  uint32_t randr_pending_capacity;
+  uint32_t randr_pending_replies;
+  randr_mode_rate_t* randr_pending_modes;
+  uint32_t randr_pending_mode_count;
+  uint64_t randr_pending_generation;
+
+  /* Workarea (computed minus struts/docks) */
+  rect_t workarea;
+  bool workarea_dirty;
+
+  /* Workareas per desktop and monitor, desktop-major; see wm_workarea_invalidate */
+  rect_t* workarea_cache;
+  uint32_t workarea_cache_desktops;
+  uint32_t workarea_cache_monitors;
+
+  /* Tile trees per desktop and monitor, desktop-major; see wm_tiling.c */
+  tile_tree_t* tiling;
+  uint32_t tiling_desktops;
+  uint32_t tiling_monitors;
+  bool tiling_on;      /* some tree lays out; off, clients are not filed */
+  bool tiling_rebuild; /* file every client, not just the queued ones */
+  bool workarea_cache_valid;
+
+  /* Committed frame rects, for hit-testing (see wm_client_at_point) */
+  spatial_index_t frame_index;
+
+  /* Stacking layers (bottom -> top) */
+  handle_vec_t layers[LAYER_COUNT];
+  u32_vec_t committed_stacking; /* frames bottom -> top as last sent to X */
+
+  handle_vec_t strut_clients; /* clients with a non-zero effective strut, manage order */
+
+  xcb_window_t committed_active_window; /* _NET_ACTIVE_WINDOW as last written */
+  bool active_window_committed;         /* committed_active_window is known */
+  handle_t* desktop_focus;              /* per-desktop MRU head: last client focused there */
+  uint32_t desktop_focus_cap;
+
+  /*
+   * Desktop membership index: desktop_members[d] holds the screen's clients
+   * on desktop d in manage order, sticky_members the sticky ones. Rebuilt
+   * for all screens at once, see server_t.desktop_members_valid.
+   */
+  handle_vec_t* desktop_members;
+  uint32_t desktop_members_count;
+  handle_vec_t sticky_members;
+  handle_vec_t visibility_moved; /* clients whose membership changed since the last visibility pass */
+  uint32_t visible_desktop;      /* desktop the last visibility pass showed */
+
+  /* Workspaces */
+  uint32_t desktop_count;
+  uint32_t current_desktop;
+  bool showing_desktop;
+  handle_vec_t show_desktop_order; /* clients show desktop hid, bottom -> top */
+} screen_t;
+
+/* Main server state */
+typedef struct server {
+  xcb_connection_t* conn;
+  screen_t screens[HXM_MAX_SCREENS];
+  uint32_t screen_count;  /* managed screens; a server built without server_init has one */
+  uint32_t active_screen; /* screen of the last pointer or key event, see server_screen */
+
   int xcb_fd;
   int epoll_fd;
   int signal_fd;
   int timer_fd;
+  timer_wheel_t timers;        /* every deferred wakeup, see timer_wheel.h */
+  uint64_t timer_armed_ns;     /* absolute deadline timer_fd is set for, 0 when disarmed */
+  uint64_t timer_rearms;       /* timerfd_settime calls, for tick_stats */
+  wheel_timer_t wake_timer;    /* server_schedule_timer: wake only, the tick does the work */
+  wheel_timer_t hover_timer;   /* hover_deadline */
+  wheel_timer_t title_timer;   /* earliest trailing title refresh */
+  wheel_timer_t cookie_timer;  /* earliest cookie expiry */
+  wheel_timer_t manage_timer;  /* earliest held manage request */
+  config_watch_t config_watch; /* hot reload of hxm.conf, themerc, menu.conf */
+  control_t control;           /* diagnostics socket, see control.h */
+  mem_budget_t mem_budget;     /* per-subsystem usage, config.memory_budget_mb */
+  prewarm_t prewarm;           /* idle decoration painting, config.prewarm_idle_ms */
+  launcher_t launcher;         /* keybinding, menu and autostart commands */
+  uint64_t tick_start_ns;      /* monotonic ns the current tick woke up */
 
   /* Extension support flags */
   bool damage_supported;
@@ -192,24 +506,42 @@ typedef struct server {
   bool randr_supported;
   uint8_t randr_event_base;
 
-  /* Root property dirty bits */
-  uint32_t root_dirty;
+  bool sync_supported; /* XSync initialized; alarms pace interactive resize */
+  uint8_t sync_event_base;
 
-  /* Monitor configuration */
-  monitor_t* monitors;
-  uint32_t monitor_count;
-  monitor_t* randr_pending_monitors;
-  uint32_t randr_pending_capacity;
-  uint32_t randr_pending_replies;
-  uint64_t randr_pending_generation;
+  bool composite_supported; /* Composite >= 0.2 (NameWindowPixmap) for switcher thumbnails */
 
-  /* Workarea (computed minus struts/docks) */
-  rect_t workarea;
-  bool workarea_dirty;
+  bool shm_supported; /* MIT-SHM on a local display; image uploads use shared memory, see render_upload_init */
+
+  bool xi2_supported;   /* XInput >= 2.0, drags can grab XI_Motion instead of core motion */
+  uint8_t xi2_opcode;   /* major opcode, matched against GenericEvent extension */
+  uint16_t xi2_pointer; /* master pointer device of our client pointer */
+
+  /* Root property writes over all screens */
+  uint64_t root_props_written;
+  uint64_t root_props_skipped; /* identical to the last write, lifetime total */
+
+  /* Monitor snapshots over all screens */
+  uint64_t monitor_snapshots_same; /* identical to the current set, dropped without work */
+  uint64_t monitor_clients_moved;  /* relocated off a moved, resized or removed monitor */
 
   /* Key symbols mapping */
   xcb_key_symbols_t* keysyms;
 
+  /*
+   * Key binding dispatch: (keycode, clean modifiers) -> key_bindings index + 1,
+   * KEY_DISPATCH_NONE for no binding, 0 for not yet resolved.
+   * Cleared and primed by wm_setup_keys.
+   */
+  uint16_t key_dispatch[256][KEY_DISPATCH_MOD_COMBOS];
+
+  /* Passive key grabs held on the root, sorted (keycode << 16 | modifiers) */
+  uint32_t* key_grabs;
+  size_t key_grab_count;
+  bool key_grabs_valid; /* false until the first wm_setup_keys */
+
+  key_repeat_t key_repeat;
+
   /* Cursor resources */
   xcb_cursor_t cursor_left_ptr;
   xcb_cursor_t cursor_move;
@@ -230,14 +562,32 @@ typedef struct server {
   handle_t interaction_handle;
   bool interaction_requires_buttons;
   bool interaction_pointer_grabbed;
+  bool interaction_xi2;            /* the interaction grab is an XI2 device grab */
+  bool interaction_motion_hint;    /* grabbed with PointerMotionHint, positions come from QueryPointer */
+  bool interaction_hint_pending;   /* a hint arrived since the last QueryPointer was sent */
+  bool interaction_query_inflight; /* a drag QueryPointer awaits its reply */
+  uint64_t interaction_query_time; /* monotonic ns of the last drag QueryPointer */
+  bool interaction_outline;        /* geometry is shown by the preview outline and committed on release */
+  bool interaction_keyboard_grabbed; /* keyboard move/resize holds the keyboard for arrow keys */
+  bool interaction_keyboard_pending; /* its GrabKeyboard reply is still outstanding */
+  rect_t interaction_origin;         /* desired geometry at start, restored by Escape */
+  int32_t interaction_key_dx;        /* arrow steps pressed since the last flush */
+  int32_t interaction_key_dy;
+  xcb_keycode_t interaction_key_last; /* auto-repeat detection for step acceleration */
+  uint32_t interaction_key_time;
+  uint32_t interaction_key_repeats;
 
   uint32_t interaction_time;       /* X server timestamp */
   uint64_t last_interaction_flush; /* monotonic ns */
+  uint64_t full_flush_ns;          /* tick of the last full wm_flush_dirty, bounds interactive_defer_ms */
+  uint64_t interaction_qos_ticks;  /* lifetime ticks committed in drag mode, for tick_stats */
 
   int16_t interaction_start_x, interaction_start_y;
   int32_t interaction_start_w, interaction_start_h;
 
   int16_t interaction_pointer_x, interaction_pointer_y;
+  int16_t interaction_motion_x, interaction_motion_y; /* previous drag sample, for prediction */
+  uint32_t interaction_motion_time;                   /* its X time, 0 = none yet */
   int16_t pointer_root_x, pointer_root_y;
   bool pointer_root_valid;
 
@@ -249,37 +599,61 @@ typedef struct server {
 
   /* Prefetched X event */
   xcb_generic_event_t* prefetched_event;
+  event_ring_t event_ring;
 
   /* Coalescing buckets */
   event_buckets_t buckets;
 
   /* Client storage */
   slotmap_t clients;          /* owns hot/cold client memory */
-  small_vec_t active_clients; /* handles in stable manage order */
+  handle_vec_t active_clients; /* handles in stable manage order */
+  handle_vec_t dirty_clients;  /* commit worklist, see server_mark_dirty */
+  handle_vec_t title_deferred; /* clients with a throttled title refresh pending */
+  handle_vec_t frame_pass;     /* decoration paints batched by wm_flush_dirty */
+  handle_vec_t thumb_queue;    /* clients whose switcher thumbnail is stale, see thumbnail.h */
+
+  /* Synthetic ConfigureNotify, lifetime totals for tick_stats */
+  uint64_t synthetic_sent;
+  uint64_t synthetic_suppressed; /* unchanged root-relative geometry, or repeated in one tick */
+
+  /* Fullscreen fast mode, see wm_fullscreen.c */
+  handle_t fs_fast;              /* focused client covering its monitor, HANDLE_INVALID when off */
+  rect_t fs_fast_monitor;        /* the monitor it covers */
+  bool fs_fast_thumb;            /* its thumbnail redirection is suspended */
+  handle_vec_t fs_fast_covered;  /* frames under it with pointer events and paints held */
+  uint64_t fs_fast_entered;
+  uint64_t fs_fast_paints_held;
 
   /* Global maps: XID -> handle */
-  hash_map_t window_to_client;         /* xcb_window_t -> handle_t via ptr */
-  hash_map_t frame_to_client;          /* frame XID -> handle_t via ptr */
+  hash_map_t xid_index;                /* client and frame XIDs -> tagged handle, see server_xid_bind */
   hash_map_t pending_unmanaged_states; /* xcb_window_t -> small_vec_t* */
+  hash_map_t prop_fetches;             /* (xid << 32 | atom) -> PropertyNotify refetch in flight, see wm_prop_fetch_settle */
 
-  /* Stacking layers (bottom -> top) */
-  small_vec_t layers[LAYER_COUNT]; /* each contains handle_t via ptr or direct
-                                      value depending on ds impl */
+  transient_groups_t transients; /* dialog groups raised and lowered as one, see stack.c */
 
   /* Focus */
   handle_t focused_client;
   xcb_window_t initial_focus;
   xcb_window_t committed_focus;
-  list_node_t focus_history; /* MRU list head */
+  handle_t committed_focus_client;      /* client last restyled as focused */
+  handle_t button_grab_client;          /* client holding the focused button grabs */
+  focus_mru_t focus_mru;                /* focus history, most recent first */
+
+  /*
+   * Every screen's desktop membership index is rebuilt lazily after
+   * wm_desktop_members_invalidate and kept current by wm_desktop_members_sync.
+   */
+  size_t desktop_members_clients; /* clients the index knows about */
+  bool desktop_members_valid;
   uint16_t last_focus_sequence;
   uint32_t last_pointer_hint_time;
+  handle_t hover_target;   /* focus-follows-mouse client waiting out focus_hover_delay_ms */
+  uint64_t hover_deadline; /* monotonic ns at which hover_target takes focus */
+  uint32_t hover_time;     /* X time of the last pointer crossing into a client */
+  int16_t hover_x;         /* root position of that crossing */
+  int16_t hover_y;
 
-  /* Workspaces */
-  uint32_t desktop_count;
-  uint32_t current_desktop;
-  bool showing_desktop;
-
-  /* Root menu */
+  /* Root menu, shared: its window is recreated on the screen it is shown on */
   menu_t menu;
   bool switcher_active;
   handle_t switcher_origin;
@@ -288,27 +662,61 @@ typedef struct server {
   bool running;
   bool restarting;
   int exit_code;
+  handoff_t handoff; /* client model from the process we were exec'd from */
+
+  /* Startup adoption, see wm_adopt_children */
+  hash_map_t adopt_desktops;   /* root child -> 1 + its _NET_WM_DESKTOP, while the scan is in flight */
+  u32_vec_t adopt_later;       /* scanned windows held back until the visible ones are adopted */
+  handle_vec_t adopt_deferred; /* adopted with the reduced probe, completed in the background */
 
   bool x_poll_immediate;
   bool x_fd_ready;
-  uint8_t force_poll_ticks;
+  uint64_t wakeups[WAKE_CAUSE_COUNT]; /* epoll_wait returns by cause, lifetime */
+  uint64_t busy_poll_hits;             /* grab waits that found input while spinning */
+  uint64_t busy_poll_misses;           /* and that spun out and slept */
+  bool boost_active;                   /* scheduling raised for the current grab */
+  bool boost_rr;                       /* as SCHED_RR rather than by nice */
+  bool boost_denied;                   /* neither was permitted; not retried until reload */
+  int boost_saved_nice;
+  uint64_t boosts;                     /* grabs boosted, lifetime */
 
   uint64_t txn_id; /* monotonic transaction id for cookie ordering */
   bool in_commit_phase;
   bool pending_flush;
+  tick_budget_t tick_budget;
 
   /* Configuration */
   config_t config;
   bool snap_enabled;
   uint32_t snap_threshold_px;
+  snap_layout_t snap_layout;
+  uint32_t snap_edge_resistance_px;
+  snap_edge_index_t snap_edges; /* built per move from visible frames, monitors and struts */
   uint32_t snap_preview_color;
   uint16_t snap_preview_border_px;
-  xcb_window_t snap_preview_win;
+  xcb_window_t snap_preview_win; /* created on the screen it was last shown on */
+  uint32_t snap_preview_screen;
   bool snap_preview_mapped;
+  bool snap_preview_shaped; /* bounding shape cut down to the border ring */
   bool is_test;
 
   /* Resources */
   cairo_surface_t* default_icon;
+  icon_cache_t icon_cache;
+  title_cache_t title_cache;
+  frame_pool_t frame_pool;       /* frames of unmanaged clients, config.frame_pool_size */
+  render_worker_t render_worker; /* running only with config.render_thread */
+  x_reader_t x_reader;           /* running only with config.input_thread */
+  cgroup_worker_t cgroup_worker; /* running only with config.focus_boost */
+  wheel_timer_t focus_boost_timer; /* focus_boost_delay_ms after the last focus commit */
+  pid_t focus_boost_pid;           /* last pid posted to cgroup_worker, 0 = none */
+  wheel_timer_t ping_timer;        /* next ping round or unanswered ping deadline, see wm_ping.c */
+  uint64_t ping_round_ns;          /* monotonic ns of the next ping round */
+  uint64_t pings_sent;
+  uint64_t pings_hung;             /* times a client was marked hung */
+  freezer_t freezer;               /* apps stopped by the freeze rule */
+  compositor_t compositor;         /* active only with config.compositor */
+  render_tiles_t frame_tiles; /* shared decoration tiles, reset on reload */
 } server_t;
 
 /* ---------- Common server helpers ---------- */
@@ -329,18 +737,209 @@ static inline client_cold_t* server_ccold(server_t* s, handle_t h) {
   return (client_cold_t*)slotmap_cold(&s->clients, h);
 }
 
-static inline handle_t server_get_client_by_window(server_t* s, xcb_window_t win) {
-  if (!s || win == XCB_NONE)
+/* ---------- Screens ---------- */
+
+static inline uint32_t server_screen_count(const server_t* s) {
+  return s->screen_count ? s->screen_count : 1u;
+}
+
+/* The screen the user is on, for work no client or root event names */
+static inline screen_t* server_screen(server_t* s) {
+  return &s->screens[s->active_screen];
+}
+
+/* The screen a client lives on; NULL hot falls back to server_screen */
+static inline screen_t* client_screen(server_t* s, const client_hot_t* hot) {
+  return hot ? &s->screens[hot->screen] : server_screen(s);
+}
+
+static inline uint32_t server_screen_index(const server_t* s, const screen_t* scr) {
+  return (uint32_t)(scr - s->screens);
+}
+
+/* Managed screen whose root is win, NULL if win is no root of ours */
+static inline screen_t* server_screen_of_root(server_t* s, xcb_window_t win) {
+  for (uint32_t i = 0; i < server_screen_count(s); i++) {
+    if (s->screens[i].root == win)
+      return &s->screens[i];
+  }
+  return NULL;
+}
+
+/* root_dirty bits pending on any screen */
+static inline uint32_t server_root_dirty(const server_t* s) {
+  uint32_t dirty = 0;
+  for (uint32_t i = 0; i < server_screen_count(s); i++)
+    dirty |= s->screens[i].root_dirty;
+  return dirty;
+}
+
+static inline bool server_workarea_dirty(const server_t* s) {
+  for (uint32_t i = 0; i < server_screen_count(s); i++) {
+    if (s->screens[i].workarea_dirty)
+      return true;
+  }
+  return false;
+}
+
+/* Pointer or key input reported on root: its screen becomes the active one */
+static inline void server_screen_enter(server_t* s, xcb_window_t root) {
+  screen_t* scr = server_screen_of_root(s, root);
+  if (scr)
+    s->active_screen = server_screen_index(s, scr);
+}
+
+/* ---------- SoA client columns (client_col_t) ---------- */
+
+typedef struct client_cols {
+  const xcb_window_t* xid;
+  const uint8_t* state;
+  const int32_t* desktop;
+  const uint8_t* sticky;
+  const uint8_t* frame_vis;
+  const uint8_t* screen;
+} client_cols_t;
+
+/* Register the columns on s->clients; server_init aborts if this fails */
+bool server_client_cols_init(server_t* s);
+
+/* Column bases for this tick, false if s->clients has none registered */
+static inline bool server_client_cols(const server_t* s, client_cols_t* out) {
+  if (slotmap_column_count(&s->clients) < CLIENT_COL_COUNT)
+    return false;
+  out->xid = (const xcb_window_t*)slotmap_column(&s->clients, CLIENT_COL_XID);
+  out->state = (const uint8_t*)slotmap_column(&s->clients, CLIENT_COL_STATE);
+  out->desktop = (const int32_t*)slotmap_column(&s->clients, CLIENT_COL_DESKTOP);
+  out->sticky = (const uint8_t*)slotmap_column(&s->clients, CLIENT_COL_STICKY);
+  out->frame_vis = (const uint8_t*)slotmap_column(&s->clients, CLIENT_COL_FRAME_VIS);
+  out->screen = (const uint8_t*)slotmap_column(&s->clients, CLIENT_COL_SCREEN);
+  return true;
+}
+
+static inline void server_client_col_put(server_t* s, const client_hot_t* hot, client_col_t col, const void* v, size_t sz) {
+  uint8_t* base = (uint8_t*)slotmap_column(&s->clients, col);
+  if (base)
+    memcpy(base + (size_t)handle_index(hot->self) * sz, v, sz);
+}
+
+/* Setters for the mirrored hot fields; hot->self must already be set */
+static inline void client_set_xid(server_t* s, client_hot_t* hot, xcb_window_t xid) {
+  hot->xid = xid;
+  server_client_col_put(s, hot, CLIENT_COL_XID, &xid, sizeof(xid));
+}
+
+static inline void client_set_state(server_t* s, client_hot_t* hot, uint8_t state) {
+  hot->state = state;
+  server_client_col_put(s, hot, CLIENT_COL_STATE, &state, sizeof(state));
+}
+
+static inline void client_set_desktop(server_t* s, client_hot_t* hot, int32_t desktop) {
+  hot->desktop = desktop;
+  server_client_col_put(s, hot, CLIENT_COL_DESKTOP, &desktop, sizeof(desktop));
+}
+
+static inline void client_set_sticky(server_t* s, client_hot_t* hot, bool sticky) {
+  uint8_t v = sticky ? 1u : 0u;
+  hot->sticky = sticky;
+  server_client_col_put(s, hot, CLIENT_COL_STICKY, &v, sizeof(v));
+}
+
+static inline void client_set_frame_vis(server_t* s, client_hot_t* hot, uint8_t vis) {
+  hot->frame_vis = vis;
+  server_client_col_put(s, hot, CLIENT_COL_FRAME_VIS, &vis, sizeof(vis));
+}
+
+static inline void client_set_screen(server_t* s, client_hot_t* hot, uint8_t screen) {
+  hot->screen = screen;
+  server_client_col_put(s, hot, CLIENT_COL_SCREEN, &screen, sizeof(screen));
+}
+
+/* Relink a client under a new transient parent (HANDLE_INVALID for none) */
+static inline void client_set_transient_for(server_t* s, client_hot_t* hot, handle_t parent) {
+  if (hot->transient_for == parent)
+    return;
+  hot->transient_for = parent;
+  transient_groups_invalidate(&s->transients);
+}
+
+/*
+ * Queue a client for the next commit phase without touching its dirty bits.
+ * wm_flush_dirty only visits queued clients, so anything that leaves work for
+ * the commit (dirty bits, desired != server, frame damage) must queue.
+ */
+static inline void server_queue_client(server_t* s, client_hot_t* hot) {
+  if (!s || !hot || hot->dirty_queued)
+    return;
+  hot->dirty_queued = true;
+  handle_vec_push(&s->dirty_clients, hot->self);
+}
+
+static inline void server_mark_dirty(server_t* s, client_hot_t* hot, uint32_t bits) {
+  if (!hot)
+    return;
+  hot->dirty |= bits;
+  server_queue_client(s, hot);
+}
+
+/*
+ * One xid_index entry per client window and per frame, so routing an event
+ * is one probe whichever of the two it names. The value packs the slot
+ * index, the low XID_GEN_BITS of the generation and the role; the handle is
+ * rebuilt from the slotmap, and an entry whose slot has moved on resolves
+ * to HANDLE_INVALID like a stale handle would.
+ */
+typedef enum xid_role { XID_NONE = 0, XID_CLIENT, XID_FRAME } xid_role_t;
+
+#define XID_GEN_BITS 24u
+#define XID_ROLE_SHIFT 56u
+
+/* Returns true if xid was already bound */
+static inline bool server_xid_bind(server_t* s, xcb_window_t xid, xid_role_t role, handle_t h) {
+  uint64_t gen = handle_generation(h) & ((1u << XID_GEN_BITS) - 1u);
+  uint64_t v = (uint64_t)handle_index(h) | (gen << HANDLE_INDEX_BITS) | ((uint64_t)role << XID_ROLE_SHIFT);
+  return hash_map_insert(&s->xid_index, (uint64_t)xid, (void*)(uintptr_t)v);
+}
+
+/* The owning client of xid, HANDLE_INVALID if none; *role says which of its windows xid is */
+static inline handle_t server_xid_lookup(server_t* s, xcb_window_t xid, xid_role_t* role) {
+  if (role)
+    *role = XID_NONE;
+  if (!s || xid == XCB_NONE)
+    return HANDLE_INVALID;
+  uint64_t v = (uint64_t)(uintptr_t)hash_map_get(&s->xid_index, (uint64_t)xid);
+  if (!v)
+    return HANDLE_INVALID;
+  handle_t h = slotmap_handle_at(&s->clients, (uint32_t)(v & HANDLE_INDEX_MASK));
+  uint64_t gen = (v >> HANDLE_INDEX_BITS) & ((1u << XID_GEN_BITS) - 1u);
+  if (h == HANDLE_INVALID || (handle_generation(h) & ((1u << XID_GEN_BITS) - 1u)) != gen)
     return HANDLE_INVALID;
-  void* ptr = hash_map_get(&s->window_to_client, (uint64_t)win);
-  return ptr_to_handle(ptr);
+  if (role)
+    *role = (xid_role_t)(v >> XID_ROLE_SHIFT);
+  return h;
+}
+
+/* Drops xid if it is bound in that role */
+static inline void server_xid_unbind(server_t* s, xcb_window_t xid, xid_role_t role) {
+  uint64_t v = (uint64_t)(uintptr_t)hash_map_get(&s->xid_index, (uint64_t)xid);
+  if (v && (xid_role_t)(v >> XID_ROLE_SHIFT) == role)
+    hash_map_remove(&s->xid_index, (uint64_t)xid);
+}
+
+static inline handle_t server_get_client_by_window(server_t* s, xcb_window_t win) {
+  xid_role_t role;
+  handle_t h = server_xid_lookup(s, win, &role);
+  return (role == XID_CLIENT) ? h : HANDLE_INVALID;
 }
 
 static inline handle_t server_get_client_by_frame(server_t* s, xcb_window_t frame) {
-  if (!s || frame == XCB_NONE)
-    return HANDLE_INVALID;
-  void* ptr = hash_map_get(&s->frame_to_client, (uint64_t)frame);
-  return ptr_to_handle(ptr);
+  xid_role_t role;
+  handle_t h = server_xid_lookup(s, frame, &role);
+  return (role == XID_FRAME) ? h : HANDLE_INVALID;
+}
+
+/* Client owning win as either its own window or its frame */
+static inline handle_t server_get_client_by_any(server_t* s, xcb_window_t win) {
+  return server_xid_lookup(s, win, NULL);
 }
 
 /* ---------- Server lifecycle ---------- */
@@ -361,12 +960,67 @@ void event_ingest(server_t* s, bool x_ready);
  */
 bool event_drain_cookies(server_t* s);
 
-/* Process buckets, apply updates, flush dirty changes */
+/* Process buckets, apply updates, flush dirty changes
+ * Both lanes back to back with no deadline
+ */
 void event_process(server_t* s);
 
-/* Schedule a timerfd-based wakeup after ms milliseconds */
+/* Input lane: lifecycle, keys, buttons, client messages, focus and motion
+ * Returns true if any input, focus or pointer event was handled
+ */
+bool event_process_input(server_t* s);
+
+/* Bulk lane: expose, configure, property, damage and RandR
+ * PropertyNotify left when monotonic time passes deadline_ns (0 = none) is
+ * deferred to the next tick, after at least EVENT_BULK_PROPS_MIN of them
+ */
+void event_process_bulk(server_t* s, uint64_t deadline_ns);
+
+/* Whether the bulk lane or reply drain has work that could delay a flush */
+bool event_bulk_pending(const server_t* s);
+
+/*
+ * Wake the loop after ms milliseconds for work the tick itself re-checks.
+ * Shares one wheel timer: the earliest pending request wins.
+ */
 void server_schedule_timer(server_t* s, int ms);
 
+/* Same, with nanosecond resolution for sub-millisecond pacing */
+void server_schedule_timer_ns(server_t* s, uint64_t ns);
+
+/*
+ * Focus was committed: once it rests focus_boost_delay_ms, hand the focused
+ * client's pid to cgroup_worker. No-op unless focus_boost is running.
+ */
+void server_focus_boost_note(server_t* s);
+
+/* Point timer_fd at the wheel's next wakeup; no syscall when unchanged */
+void server_sync_timer_fd(server_t* s);
+
+/*
+ * Block until X input, a signal, another owned fd or a timer is ready, or
+ * timeout_ms passes (-1: no limit). Returns true when X input is ready.
+ * Every return is counted in s->wakeups. During a grab with
+ * interactive_busy_poll_us set, input is first looked for by spinning that
+ * long, so the next motion does not pay for a sleep and a scheduler wakeup.
+ */
+bool server_wait_for_events(server_t* s, int timeout_ms);
+
+/*
+ * epoll timeout for the next wait given the time since the last flush: -1
+ * unless a flush is being held back while ingest is busy, so an idle loop
+ * only wakes for fds and the timer wheel
+ */
+int server_flush_wait_ms(const server_t* s, uint64_t since_flush_ns);
+
+/*
+ * While a drag, Alt-Tab or the menu holds a grab, raise the event thread to
+ * SCHED_RR (nice -5 when realtime is refused) if interactive_boost is set,
+ * and drop back once the grab ends. Called once per tick; cheap when nothing
+ * changes.
+ */
+void server_grab_boost_update(server_t* s);
+
 #ifdef __cplusplus
 }
 #endif
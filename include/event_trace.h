@@ -0,0 +1,89 @@
+/*
+ * event_trace.h - Binary recording of the X input stream for offline replay
+ *
+ * Responsibilities:
+ * - When HXM_EVENT_TRACE names a file at startup, append every event
+ *   event_ingest stages, every reply or error cookie_jar_drain hands to a
+ *   handler, and a marker at the start of each tick, with monotonic stamps
+ * - Read such a file back record by record (perf_pipeline --replay)
+ *
+ * Format (host byte order; traces are replayed on the machine class that
+ * recorded them):
+ * - 16-byte header: "HXMTRACE", u32 version, u32 reserved
+ * - Records: a 24-byte event_trace_hdr_t followed by len payload bytes
+ *     TICK   no payload
+ *     EVENT  the 32-byte wire event, XI2 already rewritten to core
+ *     REPLY  the full reply (32 + 4 * length bytes); cookie type and slot
+ *            data identify the request, since replay sequences differ
+ *     ERROR  the 32-byte error, same identification as REPLY
+ *
+ * Recording costs one branch per site while off. Writes go through a large
+ * stdio buffer; a crash loses at most the buffered tail.
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <xcb/xcb.h>
+
+#include "cookie_jar.h"
+
+#define EVENT_TRACE_ENV "HXM_EVENT_TRACE"
+#define EVENT_TRACE_VERSION 1u
+
+typedef enum event_trace_kind {
+  EVENT_TRACE_TICK = 1,
+  EVENT_TRACE_EVENT = 2,
+  EVENT_TRACE_REPLY = 3,
+  EVENT_TRACE_ERROR = 4,
+} event_trace_kind_t;
+
+typedef struct event_trace_hdr {
+  uint8_t kind;        /* event_trace_kind_t */
+  uint8_t cookie_type; /* cookie_type_t, REPLY/ERROR only */
+  uint16_t reserved;
+  uint32_t len; /* payload bytes */
+  uint64_t t_ns;
+  uint64_t data; /* cookie slot data, REPLY/ERROR only */
+} event_trace_hdr_t;
+
+extern FILE* event_trace_out;
+
+static inline bool event_trace_recording(void) { return event_trace_out != NULL; }
+
+/* Start recording to the file in HXM_EVENT_TRACE, if set; true if recording */
+bool event_trace_open_from_env(void);
+void event_trace_close(void);
+
+void event_trace_tick(uint64_t t_ns);
+void event_trace_event(const xcb_generic_event_t* ev);
+void event_trace_reply(const cookie_slot_t* slot, const void* reply, const xcb_generic_error_t* err);
+
+typedef struct event_trace_reader {
+  FILE* f;
+  uint8_t* buf; /* payload of the last record, valid until the next read */
+  uint32_t cap;
+} event_trace_reader_t;
+
+bool event_trace_reader_open(event_trace_reader_t* r, const char* path);
+void event_trace_reader_close(event_trace_reader_t* r);
+
+/* Next record; payload points into r->buf. Returns false at EOF or on a
+ * truncated or malformed record */
+bool event_trace_reader_next(event_trace_reader_t* r, event_trace_hdr_t* hdr, const uint8_t** payload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_TRACE_H */
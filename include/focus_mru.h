@@ -0,0 +1,124 @@
+/*
+ * focus_mru.h - Focus history as an index-linked MRU table
+ *
+ * Responsibilities:
+ * - Order clients most recently focused first, with O(1) move-to-front,
+ *   insert and remove through the slot each client keeps in focus_slot
+ * - Cache what focus fallback, cycling and the switcher filter on (desktop,
+ *   mapped, switchable type) next to the handle, so a filtered scan walks
+ *   one small array instead of chasing 256-byte client_hot_t records
+ *
+ * Layout:
+ * - entries[0] is the sentinel: its next is the MRU head, its prev the tail
+ * - slot 0 means "not in history", so a zeroed table and a zeroed client
+ *   are both valid empty states
+ * - Freed slots are chained through next from free_head and reused; entries
+ *   may move on growth, so hold slots, never entry pointers
+ *
+ * Cached bits are a filter, not the truth: callers still check the client
+ * they settle on (show-desktop hiding, for one, is not cached).
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef FOCUS_MRU_H
+#define FOCUS_MRU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "client.h"
+#include "handle.h"
+
+typedef enum {
+  FOCUS_MRU_MAPPED = 1u << 0,
+  FOCUS_MRU_STICKY = 1u << 1,
+  FOCUS_MRU_SWITCHABLE = 1u << 2, /* type may take focus from cycling or the switcher */
+} focus_mru_flags_t;
+
+/* desktop filter matching every entry */
+#define FOCUS_MRU_ANY_DESKTOP INT32_MIN
+
+typedef struct focus_mru_entry {
+  handle_t h;
+  uint32_t prev;
+  uint32_t next;
+  int32_t desktop;
+  uint32_t flags; /* focus_mru_flags_t */
+} focus_mru_entry_t;
+
+typedef struct focus_mru {
+  focus_mru_entry_t* entries; /* NULL until the first insert */
+  uint32_t cap;
+  uint32_t used; /* slots handed out, including the sentinel */
+  uint32_t count;
+  uint32_t free_head;
+} focus_mru_t;
+
+void focus_mru_destroy(focus_mru_t* m);
+
+/* Link h after slot `after` (0 = at the head); returns its slot, 0 on OOM */
+uint32_t focus_mru_insert_after(focus_mru_t* m, uint32_t after, handle_t h);
+
+/* Relink an existing slot after `after` (0 = at the head) */
+void focus_mru_move_after(focus_mru_t* m, uint32_t slot, uint32_t after);
+
+void focus_mru_remove(focus_mru_t* m, uint32_t slot);
+
+static inline uint32_t focus_mru_first(const focus_mru_t* m) { return m->entries ? m->entries[0].next : 0; }
+
+static inline uint32_t focus_mru_last(const focus_mru_t* m) { return m->entries ? m->entries[0].prev : 0; }
+
+static inline uint32_t focus_mru_next(const focus_mru_t* m, uint32_t slot) { return m->entries[slot].next; }
+
+static inline uint32_t focus_mru_prev(const focus_mru_t* m, uint32_t slot) { return m->entries[slot].prev; }
+
+static inline handle_t focus_mru_handle(const focus_mru_t* m, uint32_t slot) { return m->entries[slot].h; }
+
+static inline bool focus_mru_match(const focus_mru_t* m, uint32_t slot, int32_t desktop, uint32_t need) {
+  const focus_mru_entry_t* e = &m->entries[slot];
+  if ((e->flags & need) != need)
+    return false;
+  return desktop == FOCUS_MRU_ANY_DESKTOP || e->desktop == desktop || (e->flags & FOCUS_MRU_STICKY);
+}
+
+/* Filter bits for a client as it stands now */
+static inline uint32_t focus_mru_client_flags(const client_hot_t* hot) {
+  uint32_t flags = 0;
+  if (hot->state == STATE_MAPPED)
+    flags |= FOCUS_MRU_MAPPED;
+  if (hot->sticky)
+    flags |= FOCUS_MRU_STICKY;
+  switch (hot->type) {
+    case WINDOW_TYPE_DOCK:
+    case WINDOW_TYPE_NOTIFICATION:
+    case WINDOW_TYPE_DESKTOP:
+    case WINDOW_TYPE_MENU:
+    case WINDOW_TYPE_DROPDOWN_MENU:
+    case WINDOW_TYPE_POPUP_MENU:
+    case WINDOW_TYPE_TOOLTIP:
+    case WINDOW_TYPE_COMBO:
+    case WINDOW_TYPE_DND:
+      break;
+    default:
+      flags |= FOCUS_MRU_SWITCHABLE;
+      break;
+  }
+  return flags;
+}
+
+static inline void focus_mru_refresh(focus_mru_t* m, uint32_t slot, const client_hot_t* hot) {
+  m->entries[slot].desktop = hot->desktop;
+  m->entries[slot].flags = focus_mru_client_flags(hot);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOCUS_MRU_H */
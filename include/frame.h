@@ -11,6 +11,8 @@
  * - handle_t refers to a managed client/window object owned by the server
  * - frame_redraw* mark or paint decorations based on current theme/state
  * - frame_flush pushes any pending drawing to the X server (or backing surface)
+ * - With config.frame_backing, decorations are drawn into a per-frame pixmap
+ *   set as the frame's background; the X server then repaints exposes itself
  *
  * Contract:
  * - frame_init_resources must be called once during server startup
@@ -33,6 +35,15 @@ extern "C" {
 #include "hxm.h"
 
 typedef struct server server_t;
+typedef struct client_hot client_hot_t;
+typedef struct frame_hit frame_hit_t;
+
+/* Frame background before (or without) a backing pixmap */
+#define FRAME_BACKGROUND_PIXEL 0x333333u
+
+/* Events selected on a managed client's frame */
+#define FRAME_EVENT_MASK \
+  (XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW)
 
 /* Redraw flags for the decoration subparts */
 typedef enum frame_redraw_mask {
@@ -56,12 +67,23 @@ void frame_redraw(server_t* s, handle_t h, uint32_t what);
 
 /* Redraw only the dirty region (damage)
  * dirty must point to a valid region description
+ * No-op for frames with a backing pixmap, which the server repaints itself
  */
-void frame_redraw_region(server_t* s, handle_t h, const dirty_region_t* dirty);
+void frame_redraw_region(server_t* s, handle_t h, const dirty_rects_t* dirty);
 
 /* Flush any pending drawing operations for this frame */
 void frame_flush(server_t* s, handle_t h);
 
+/* Store title runs finished by the render worker and repaint the frames
+ * that were showing a stale title while waiting for them
+ */
+void frame_collect_title_runs(server_t* s);
+
+/* Pointer hit regions for hot, rebuilt first if its size or decoration
+ * changed since the last call
+ */
+const frame_hit_t* frame_hit_table(server_t* s, client_hot_t* hot);
+
 /* Hit-test for frame buttons
  * x,y are relative to the frame (not root) coordinate space
  */
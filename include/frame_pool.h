@@ -0,0 +1,107 @@
+/*
+ * frame_pool.h - Recycled frame windows with their render contexts
+ *
+ * Responsibilities:
+ * - Keep the frame window and render context of an unmanaged client, so the
+ *   next client_finish_manage reconfigures an existing window and retargets
+ *   an existing cairo surface/pango layout instead of creating both anew
+ * - Bound the pool by config.frame_pool_size and let mem_budget empty it
+ *   under memory pressure
+ *
+ * Reuse fence:
+ * - A frame enters the pool unmapped, with events from its previous life
+ *   possibly still queued (notably its own UnmapNotify, which would consume
+ *   the next owner's ignore_unmap). frame_pool_put appends a zero-length
+ *   _HXM_FRAME_POOL property to the frame; the PropertyNotify for it is the
+ *   last event the old life can produce, and only once event ingest has seen
+ *   it (frame_pool_settle) is the frame handed out again
+ *
+ * Notes:
+ * - Entries are keyed by (root, depth, visual): a frame is a child of its
+ *   screen's root and uses that root's pair, so it is only handed to a
+ *   client of the same screen
+ * - Frames never own a colormap (they use the root visual), so there is
+ *   none to recycle
+ * - A zeroed frame_pool_t is valid and empty
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "render.h"
+
+/* Hard cap on config.frame_pool_size */
+#define FRAME_POOL_MAX 32
+
+typedef struct frame_pool_entry {
+  xcb_window_t frame;
+  xcb_window_t root;
+  xcb_visualid_t visual;
+  uint8_t depth;
+  bool settled; /* reuse fence seen, safe to hand out */
+  render_context_t render;
+} frame_pool_entry_t;
+
+typedef struct frame_pool {
+  frame_pool_entry_t entries[FRAME_POOL_MAX]; /* oldest first */
+  uint32_t count;
+
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t returned;
+  uint64_t trimmed;
+
+  bool closed; /* set by frame_pool_destroy, puts are refused */
+} frame_pool_t;
+
+void frame_pool_init(frame_pool_t* pool);
+
+/* Destroy every pooled frame and render context; later puts are refused */
+void frame_pool_destroy(frame_pool_t* pool, xcb_connection_t* conn);
+
+/*
+ * Take a settled frame under root of depth/visual: *frame receives the window and
+ * *render the context (ownership passes to the caller). Returns false on a
+ * miss, leaving both untouched.
+ */
+bool frame_pool_take(frame_pool_t* pool, xcb_window_t root, uint8_t depth, xcb_visualid_t visual, xcb_window_t* frame, render_context_t* render);
+
+/*
+ * Return an unmanaged client's frame, already emptied of the client. On
+ * success the frame is unmapped, its background reset, the fence queued and
+ * *render moved into the pool (reset to render_init). Returns false when
+ * the pool already holds limit frames; the caller destroys both then.
+ */
+bool frame_pool_put(frame_pool_t* pool, xcb_connection_t* conn, uint32_t limit, xcb_window_t frame, xcb_window_t root, uint8_t depth, xcb_visualid_t visual,
+                    render_context_t* render);
+
+/* Event ingest saw PropertyNotify(window, atom); true if it was a pool fence */
+bool frame_pool_settle(frame_pool_t* pool, xcb_window_t window, xcb_atom_t atom);
+
+/* Destroy the oldest frames until at most keep remain; returns the bytes released */
+size_t frame_pool_trim(frame_pool_t* pool, xcb_connection_t* conn, uint32_t keep);
+
+/* Client-side bytes held by pooled render contexts */
+size_t frame_pool_bytes(const frame_pool_t* pool);
+
+static inline uint32_t frame_pool_size(const frame_pool_t* pool) {
+  return pool->count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAME_POOL_H */
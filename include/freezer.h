@@ -0,0 +1,90 @@
+/*
+ * freezer.h - Stop applications whose windows are all hidden
+ *
+ * Responsibilities:
+ * - Freeze the process behind a client's _NET_WM_PID when the freeze rule
+ *   action applies and none of its windows is shown, and thaw it before any
+ *   of them is mapped again
+ * - Prefer the cgroup v2 freezer (cgroup.freeze), which stops every process
+ *   of the app at once and is invisible to it. Only a systemd-style scope
+ *   that does not hold the window manager qualifies: anything larger would
+ *   freeze unrelated apps, or us
+ * - Otherwise SIGSTOP the process group (the process alone when it shares
+ *   ours); SIGCONT thaws it
+ *
+ * Notes:
+ * - Entries are keyed by pid; several windows of one app share an entry
+ * - Thawing is synchronous so that the caller can order it ahead of the
+ *   MapWindow that shows the app; a frozen client cannot repaint
+ * - freezer_destroy thaws everything: an app must never outlive the window
+ *   manager frozen
+ * - A zeroed freezer_t is valid and empty; /proc and /sys/fs/cgroup are used
+ *   unless proc_root and cgroup_root are set (tests)
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef FREEZER_H
+#define FREEZER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "cgroup_worker.h"
+
+typedef enum freeze_method {
+  FREEZE_CGROUP = 1,
+  FREEZE_SIGNAL,
+} freeze_method_t;
+
+typedef struct freeze_entry {
+  pid_t pid;
+  pid_t target; /* FREEZE_SIGNAL: kill() target, -pgid or pid */
+  uint8_t method;
+  char* cgroup; /* FREEZE_CGROUP: relative path, owned */
+} freeze_entry_t;
+
+typedef struct freezer {
+  freeze_entry_t* entries;
+  size_t count;
+  size_t cap;
+
+  const char* proc_root;
+  const char* cgroup_root;
+  bool self_known;
+  char self_cgroup[CGROUP_WORKER_PATH_MAX];
+
+  uint64_t frozen;
+  uint64_t thawed;
+  uint64_t failed;
+} freezer_t;
+
+/* Stop pid's app; true when it is frozen now (including already) */
+bool freezer_freeze(freezer_t* f, pid_t pid);
+
+/* Resume pid's app; true when it was frozen */
+bool freezer_thaw(freezer_t* f, pid_t pid);
+
+bool freezer_is_frozen(const freezer_t* f, pid_t pid);
+
+void freezer_thaw_all(freezer_t* f);
+
+/* Thaw everything and free the table */
+void freezer_destroy(freezer_t* f);
+
+/* Append the report; returns bytes written, excluding the NUL */
+size_t freezer_format(const freezer_t* f, char* buf, size_t cap);
+void freezer_dump(const freezer_t* f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FREEZER_H */
@@ -0,0 +1,115 @@
+/*
+ * handoff.h - Client model carried across an in-place restart
+ *
+ * Responsibilities:
+ * - Before re-exec, serialize what the next process would otherwise have to
+ *   rediscover per window: desktop, layer, geometry, stacking and focus
+ *   order, and the cached name/class strings
+ * - After exec, decode and validate it so adoption can skip the per-child
+ *   classification round trip and the carried property probes
+ *
+ * Transport:
+ * - A memfd inherited across execv; its number is in HXM_HANDOFF_FD.
+ *   handoff_load consumes (closes and unsets) it
+ * - The blob is versioned and tied to the root window of the first screen;
+ *   it carries the clients of every screen. Anything that does not decode
+ *   cleanly is dropped and startup falls back to full adoption
+ *
+ * Ownership:
+ * - Decoded strings live in the handoff's arena; managed clients copy them
+ * - A record is consumed when its window finishes manage, so a later window
+ *   that reuses the XID is managed from scratch
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "client.h"
+#include "ds.h"
+
+#define HANDOFF_ENV "HXM_HANDOFF_FD"
+
+enum handoff_flags {
+  HANDOFF_STICKY = 1u << 0,
+  HANDOFF_ICONIC = 1u << 1,
+  HANDOFF_NET_WM_NAME = 1u << 2,      /* title came from _NET_WM_NAME */
+  HANDOFF_NET_WM_ICON_NAME = 1u << 3, /* icon name came from _NET_WM_ICON_NAME */
+};
+
+enum handoff_str {
+  HANDOFF_STR_CLASS = 0,
+  HANDOFF_STR_INSTANCE,
+  HANDOFF_STR_TITLE,
+  HANDOFF_STR_ICON_NAME,
+  HANDOFF_STR_CLIENT_MACHINE,
+  HANDOFF_STR_COMMAND,
+  HANDOFF_STR_COUNT
+};
+
+typedef struct handoff_client {
+  xcb_window_t xid;
+  int32_t desktop;
+  rect_t geom; /* client rect in root coordinates (hot->desired) */
+  uint8_t base_layer;
+  uint8_t flags;       /* HANDOFF_* */
+  uint32_t stack_rank; /* 0 is bottom-most */
+  uint32_t focus_rank; /* 0 is most recently focused */
+  const char* str[HANDOFF_STR_COUNT]; /* NULL when the client had none */
+} handoff_client_t;
+
+typedef struct handoff {
+  bool active;
+  xcb_window_t root;
+  handoff_client_t* clients; /* ordered by stack_rank */
+  size_t count;
+  hash_map_t by_xid; /* xid -> handoff_client_t*, unconsumed only */
+  handle_t* focus_slots; /* focus_rank -> handle once managed */
+  arena_t strings;
+} handoff_t;
+
+/* Serialize clients into a malloc'd blob. Returns false on allocation failure */
+bool handoff_encode(xcb_window_t root, const handoff_client_t* clients, size_t count, uint8_t** out, size_t* out_len);
+
+/* Decode and validate a blob into h (replacing its contents) */
+bool handoff_decode(handoff_t* h, const uint8_t* buf, size_t len);
+
+void handoff_destroy(handoff_t* h);
+
+/* Snapshot s's managed clients into a memfd for the next process; -1 on failure */
+int handoff_save(server_t* s);
+
+/* The descriptor HANDOFF_ENV names, or -1; leaves the variable set */
+int handoff_env_fd(void);
+
+/* Consume HANDOFF_ENV if set; keeps the handoff only if it is for root */
+bool handoff_load(handoff_t* h, xcb_window_t root);
+
+/* The unconsumed record for xid, or NULL */
+const handoff_client_t* handoff_find(const handoff_t* h, xcb_window_t xid);
+
+/* Drop xid's record so it is not applied twice; the last one frees h */
+void handoff_consume(handoff_t* h, xcb_window_t xid);
+
+/*
+ * Focus-history slot h, restored from c, goes after: that of the nearest
+ * more recently focused client restored so far, else 0 (the head).
+ */
+uint32_t handoff_focus_anchor(server_t* s, const handoff_client_t* c, handle_t h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HANDOFF_H */
@@ -5,9 +5,10 @@
  *
  * Provides:
  * - Intrusive doubly-linked list primitives
- * - Dirty region logic (rect union, clamping)
+ * - Dirty region logic (rect union, clamping, small rect lists)
  * - Logging macros with compile-time elimination
  * - Performance counters
+ * - Tick phase latency histograms (always enabled)
  * - Simple rate limiter
  * - Global signal flags
  *
@@ -248,6 +249,148 @@ static inline void dirty_region_clamp(dirty_region_t* r, int16_t bx, int16_t by,
   r->valid = true;
 }
 
+/* ---------- Dirty rectangle lists ---------- */
+
+/*
+ * A few rects instead of one bounding box, so two small exposes at opposite
+ * ends of a frame do not repaint everything in between. Stored rects never
+ * touch: a new rect swallows every rect it overlaps or shares an edge with,
+ * and once the list is full it is merged with the rect whose bounding box
+ * wastes the least area.
+ */
+#define DIRTY_RECTS_MAX 8
+
+typedef struct dirty_rect {
+  int16_t x, y;
+  uint16_t w, h;
+} dirty_rect_t;
+
+typedef struct dirty_rects {
+  uint8_t count;
+  dirty_rect_t rects[DIRTY_RECTS_MAX];
+} dirty_rects_t;
+
+static inline void dirty_rects_reset(dirty_rects_t* r) {
+  r->count = 0;
+}
+
+static inline bool dirty_rects_empty(const dirty_rects_t* r) {
+  return r->count == 0;
+}
+
+static inline bool dirty_rect_touches(const dirty_rect_t* a, const dirty_rect_t* b) {
+  int32_t ax2 = (int32_t)a->x + (int32_t)a->w;
+  int32_t ay2 = (int32_t)a->y + (int32_t)a->h;
+  int32_t bx2 = (int32_t)b->x + (int32_t)b->w;
+  int32_t by2 = (int32_t)b->y + (int32_t)b->h;
+  bool x_overlap = a->x < bx2 && b->x < ax2;
+  bool y_overlap = a->y < by2 && b->y < ay2;
+  bool x_touch = a->x <= bx2 && b->x <= ax2;
+  bool y_touch = a->y <= by2 && b->y <= ay2;
+  // Corner contact alone does not count, its bounding box is mostly waste
+  return (x_overlap && y_touch) || (y_overlap && x_touch);
+}
+
+static inline dirty_rect_t dirty_rect_bound(const dirty_rect_t* a, const dirty_rect_t* b) {
+  int32_t x1 = a->x < b->x ? a->x : b->x;
+  int32_t y1 = a->y < b->y ? a->y : b->y;
+  int32_t ax2 = (int32_t)a->x + (int32_t)a->w;
+  int32_t ay2 = (int32_t)a->y + (int32_t)a->h;
+  int32_t bx2 = (int32_t)b->x + (int32_t)b->w;
+  int32_t by2 = (int32_t)b->y + (int32_t)b->h;
+  int32_t nw = (ax2 > bx2 ? ax2 : bx2) - x1;
+  int32_t nh = (ay2 > by2 ? ay2 : by2) - y1;
+  dirty_rect_t out;
+  out.x = (int16_t)x1;
+  out.y = (int16_t)y1;
+  out.w = (uint16_t)(nw > UINT16_MAX ? UINT16_MAX : nw);
+  out.h = (uint16_t)(nh > UINT16_MAX ? UINT16_MAX : nh);
+  return out;
+}
+
+/* Area the bounding box of a and b covers beyond a and b themselves */
+static inline int64_t dirty_rect_merge_waste(const dirty_rect_t* a, const dirty_rect_t* b) {
+  dirty_rect_t u = dirty_rect_bound(a, b);
+  int32_t ix1 = a->x > b->x ? a->x : b->x;
+  int32_t iy1 = a->y > b->y ? a->y : b->y;
+  int32_t ax2 = (int32_t)a->x + (int32_t)a->w;
+  int32_t ay2 = (int32_t)a->y + (int32_t)a->h;
+  int32_t bx2 = (int32_t)b->x + (int32_t)b->w;
+  int32_t by2 = (int32_t)b->y + (int32_t)b->h;
+  int32_t iw = (ax2 < bx2 ? ax2 : bx2) - ix1;
+  int32_t ih = (ay2 < by2 ? ay2 : by2) - iy1;
+  int64_t inter = (iw > 0 && ih > 0) ? (int64_t)iw * ih : 0;
+  return (int64_t)u.w * u.h - (int64_t)a->w * a->h - (int64_t)b->w * b->h + inter;
+}
+
+static inline void dirty_rects_add(dirty_rects_t* r, int16_t x, int16_t y, uint16_t w, uint16_t h) {
+  if (w == 0 || h == 0)
+    return;
+
+  dirty_rect_t n = {x, y, w, h};
+  for (;;) {
+    // A grown rect may reach rects it missed before, so rescan after each merge
+    for (uint8_t i = 0; i < r->count;) {
+      if (dirty_rect_touches(&n, &r->rects[i])) {
+        n = dirty_rect_bound(&n, &r->rects[i]);
+        r->rects[i] = r->rects[--r->count];
+        i = 0;
+      }
+      else {
+        i++;
+      }
+    }
+    if (r->count < DIRTY_RECTS_MAX)
+      break;
+
+    uint8_t best = 0;
+    int64_t best_waste = INT64_MAX;
+    for (uint8_t i = 0; i < r->count; i++) {
+      int64_t waste = dirty_rect_merge_waste(&n, &r->rects[i]);
+      if (waste < best_waste) {
+        best_waste = waste;
+        best = i;
+      }
+    }
+    n = dirty_rect_bound(&n, &r->rects[best]);
+    r->rects[best] = r->rects[--r->count];
+  }
+  r->rects[r->count++] = n;
+}
+
+static inline dirty_rects_t dirty_rects_make(int16_t x, int16_t y, uint16_t w, uint16_t h) {
+  dirty_rects_t r = {0};
+  dirty_rects_add(&r, x, y, w, h);
+  return r;
+}
+
+static inline void dirty_rects_union(dirty_rects_t* dst, const dirty_rects_t* src) {
+  if (!src)
+    return;
+  for (uint8_t i = 0; i < src->count; i++)
+    dirty_rects_add(dst, src->rects[i].x, src->rects[i].y, src->rects[i].w, src->rects[i].h);
+}
+
+static inline dirty_region_t dirty_rects_bounds(const dirty_rects_t* r) {
+  dirty_region_t out;
+  dirty_region_reset(&out);
+  for (uint8_t i = 0; i < r->count; i++)
+    dirty_region_union_rect(&out, r->rects[i].x, r->rects[i].y, r->rects[i].w, r->rects[i].h);
+  return out;
+}
+
+static inline void dirty_rects_clamp(dirty_rects_t* r, int16_t bx, int16_t by, uint16_t bw, uint16_t bh) {
+  // Shrinking cannot make disjoint rects touch, so no re-merge is needed
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < r->count; i++) {
+    dirty_region_t c = dirty_region_make(r->rects[i].x, r->rects[i].y, r->rects[i].w, r->rects[i].h);
+    dirty_region_clamp(&c, bx, by, bw, bh);
+    if (c.valid)
+      r->rects[kept++] = (dirty_rect_t){c.x, c.y, c.w, c.h};
+  }
+  r->count = kept;
+}
+
 /* Monotonic clock helper, implemented elsewhere */
 uint64_t monotonic_time_ns(void);
 
@@ -292,6 +435,13 @@ enum log_level {
  */
 void hxm_log(enum log_level level, const char* fmt, ...) HXM_ATTR_PRINTF(2, 3);
 
+/* With HXM_LOG_ASYNC set, lines logged by the calling thread are queued to a
+ * writer thread until stop; a full queue drops lines and counts them in
+ * hxm_log_dropped. Stop drains and joins, and also runs at exit. */
+void hxm_log_async_start(void);
+void hxm_log_async_stop(void);
+uint64_t hxm_log_dropped(void);
+
 #define HXM_LOG_ENABLED(level) ((level) >= HXM_LOG_MIN_LEVEL)
 
 #if HXM_LOG_ENABLED(HXM_LOG_LEVEL_DEBUG)
@@ -359,6 +509,12 @@ void hxm_log(enum log_level level, const char* fmt, ...) HXM_ATTR_PRINTF(2, 3);
 
 void hxm_err(const char* fmt, ...) HXM_ATTR_PRINTF(1, 2);
 
+static inline void hxm_log_async_start(void) {}
+static inline void hxm_log_async_stop(void) {}
+static inline uint64_t hxm_log_dropped(void) {
+  return 0;
+}
+
 #define LOG_ERROR(...) hxm_err(__VA_ARGS__)
 #define LOG_WARN(...) \
   do {                \
@@ -439,6 +595,290 @@ static inline void counters_tick_record(uint64_t dt_ns) {
 
 #endif
 
+/* ---------- X request accounting ----------
+ *
+ * Always-on per-kind counts of the requests that make up most of the WM's
+ * output. Each listed xcb request function is shadowed by a macro that bumps
+ * its kind's counter before calling through, so every call site in a file
+ * that includes this header is counted without being touched. Other requests
+ * (queries, cursors, render via cairo) go uncounted; byte totals come from
+ * xcb_total_written and cover everything.
+ *
+ * Main thread only: render workers draw into client-side surfaces and issue
+ * no requests. Define HXM_NO_XREQ_ACCOUNTING before including this header to
+ * see the unwrapped functions.
+ */
+
+typedef enum xreq_kind {
+  XREQ_CONFIGURE = 0, /* ConfigureWindow */
+  XREQ_PROPERTY,      /* ChangeProperty, DeleteProperty */
+  XREQ_GET_PROPERTY,  /* GetProperty */
+  XREQ_MAP,           /* MapWindow, UnmapWindow */
+  XREQ_ATTRIBUTES,    /* ChangeWindowAttributes */
+  XREQ_IMAGE,         /* PutImage */
+  XREQ_GRAB,          /* Grab/Ungrab Key, Button, Pointer, Keyboard */
+  XREQ_FOCUS,         /* SetInputFocus */
+  XREQ_SEND_EVENT,    /* SendEvent */
+  XREQ_KIND_COUNT
+} xreq_kind_t;
+
+extern uint64_t xreq_counts[XREQ_KIND_COUNT];
+
+const char* xreq_kind_name(xreq_kind_t kind);
+
+#define XREQ_COUNTED(kind, call) (xreq_counts[(kind)]++, call)
+
+#ifndef HXM_NO_XREQ_ACCOUNTING
+#define xcb_configure_window(...) XREQ_COUNTED(XREQ_CONFIGURE, xcb_configure_window(__VA_ARGS__))
+#define xcb_configure_window_checked(...) XREQ_COUNTED(XREQ_CONFIGURE, xcb_configure_window_checked(__VA_ARGS__))
+#define xcb_change_property(...) XREQ_COUNTED(XREQ_PROPERTY, xcb_change_property(__VA_ARGS__))
+#define xcb_change_property_checked(...) XREQ_COUNTED(XREQ_PROPERTY, xcb_change_property_checked(__VA_ARGS__))
+#define xcb_delete_property(...) XREQ_COUNTED(XREQ_PROPERTY, xcb_delete_property(__VA_ARGS__))
+#define xcb_delete_property_checked(...) XREQ_COUNTED(XREQ_PROPERTY, xcb_delete_property_checked(__VA_ARGS__))
+#define xcb_get_property(...) XREQ_COUNTED(XREQ_GET_PROPERTY, xcb_get_property(__VA_ARGS__))
+#define xcb_get_property_unchecked(...) XREQ_COUNTED(XREQ_GET_PROPERTY, xcb_get_property_unchecked(__VA_ARGS__))
+#define xcb_map_window(...) XREQ_COUNTED(XREQ_MAP, xcb_map_window(__VA_ARGS__))
+#define xcb_map_window_checked(...) XREQ_COUNTED(XREQ_MAP, xcb_map_window_checked(__VA_ARGS__))
+#define xcb_unmap_window(...) XREQ_COUNTED(XREQ_MAP, xcb_unmap_window(__VA_ARGS__))
+#define xcb_unmap_window_checked(...) XREQ_COUNTED(XREQ_MAP, xcb_unmap_window_checked(__VA_ARGS__))
+#define xcb_change_window_attributes(...) XREQ_COUNTED(XREQ_ATTRIBUTES, xcb_change_window_attributes(__VA_ARGS__))
+#define xcb_change_window_attributes_checked(...) XREQ_COUNTED(XREQ_ATTRIBUTES, xcb_change_window_attributes_checked(__VA_ARGS__))
+#define xcb_put_image(...) XREQ_COUNTED(XREQ_IMAGE, xcb_put_image(__VA_ARGS__))
+#define xcb_grab_key(...) XREQ_COUNTED(XREQ_GRAB, xcb_grab_key(__VA_ARGS__))
+#define xcb_grab_key_checked(...) XREQ_COUNTED(XREQ_GRAB, xcb_grab_key_checked(__VA_ARGS__))
+#define xcb_ungrab_key(...) XREQ_COUNTED(XREQ_GRAB, xcb_ungrab_key(__VA_ARGS__))
+#define xcb_grab_button(...) XREQ_COUNTED(XREQ_GRAB, xcb_grab_button(__VA_ARGS__))
+#define xcb_ungrab_button(...) XREQ_COUNTED(XREQ_GRAB, xcb_ungrab_button(__VA_ARGS__))
+#define xcb_grab_pointer(...) XREQ_COUNTED(XREQ_GRAB, xcb_grab_pointer(__VA_ARGS__))
+#define xcb_ungrab_pointer(...) XREQ_COUNTED(XREQ_GRAB, xcb_ungrab_pointer(__VA_ARGS__))
+#define xcb_grab_keyboard(...) XREQ_COUNTED(XREQ_GRAB, xcb_grab_keyboard(__VA_ARGS__))
+#define xcb_ungrab_keyboard(...) XREQ_COUNTED(XREQ_GRAB, xcb_ungrab_keyboard(__VA_ARGS__))
+#define xcb_set_input_focus(...) XREQ_COUNTED(XREQ_FOCUS, xcb_set_input_focus(__VA_ARGS__))
+#define xcb_set_input_focus_checked(...) XREQ_COUNTED(XREQ_FOCUS, xcb_set_input_focus_checked(__VA_ARGS__))
+#define xcb_send_event(...) XREQ_COUNTED(XREQ_SEND_EVENT, xcb_send_event(__VA_ARGS__))
+#define xcb_send_event_checked(...) XREQ_COUNTED(XREQ_SEND_EVENT, xcb_send_event_checked(__VA_ARGS__))
+#endif
+
+/* ---------- Tick phase latency histograms ----------
+ *
+ * Log-bucketed (HDR-style) histograms of per-phase tick durations.
+ * Unlike struct counters these are compiled into every build: recording a
+ * sample is a count-leading-zeros, a shift and an increment.
+ *
+ * Bucketing:
+ * - values below LATENCY_HIST_SUB_BUCKETS get one exact bucket each
+ * - every larger power-of-two octave is split into LATENCY_HIST_SUB_BUCKETS
+ *   linear sub-buckets, bounding relative error to 1 / LATENCY_HIST_SUB_BUCKETS
+ */
+
+#define LATENCY_HIST_SUB_BITS 3u
+#define LATENCY_HIST_SUB_BUCKETS (1u << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_BUCKETS ((64u - LATENCY_HIST_SUB_BITS + 1u) * LATENCY_HIST_SUB_BUCKETS)
+
+typedef struct latency_hist {
+  uint64_t count;
+  uint64_t sum_ns;
+  uint64_t min_ns; /* UINT64_MAX when count == 0 */
+  uint64_t max_ns;
+  uint64_t buckets[LATENCY_HIST_BUCKETS];
+} latency_hist_t;
+
+void latency_hist_reset(latency_hist_t* h);
+void latency_hist_record(latency_hist_t* h, uint64_t ns);
+
+/* Return the upper bound of the bucket holding the given quantile, clamped to
+ * max_ns. permille_x10 is in units of 0.01% (5000 = p50, 9900 = p99,
+ * 9990 = p99.9). Returns 0 for an empty histogram.
+ */
+uint64_t latency_hist_quantile(const latency_hist_t* h, uint32_t permille_x10);
+
+/* Phases of one server_run iteration, in execution order */
+typedef enum tick_phase {
+  TICK_PHASE_WAIT = 0,    /* epoll wait (idle time, not part of TOTAL) */
+  TICK_PHASE_INGEST,      /* event_ingest */
+  TICK_PHASE_DRAIN,       /* event_drain_cookies */
+  TICK_PHASE_PROCESS,     /* event_process */
+  TICK_PHASE_FLUSH_DIRTY, /* wm_flush_dirty + debounced workarea publish */
+  TICK_PHASE_XCB_FLUSH,   /* xcb_flush (only when a flush was issued) */
+  TICK_PHASE_TOTAL,       /* ingest through xcb_flush */
+  TICK_PHASE_COUNT
+} tick_phase_t;
+
+/* Steps of server_init, in execution order */
+typedef enum startup_phase {
+  STARTUP_PHASE_CONNECT = 0, /* connect, atoms, keysyms */
+  STARTUP_PHASE_X_QUERIES,   /* extension and root property replies (one round trip) */
+  STARTUP_PHASE_CONFIG,      /* config and theme parse, overlapping the version queries */
+  STARTUP_PHASE_BECOME,      /* wm_become, monitors */
+  STARTUP_PHASE_ADOPT,       /* restart handoff + wm_adopt_children (probes are async) */
+  STARTUP_PHASE_RESOURCES,   /* fds, frame resources, menu config, caches, keys */
+  STARTUP_PHASE_COUNT
+} startup_phase_t;
+
+/* Per-tick sample, filled by the event loop then folded into tick_stats */
+typedef struct tick_sample {
+  uint64_t ns[TICK_PHASE_COUNT];
+  uint32_t mask; /* bit per phase that actually ran this tick */
+
+  /* tick_arena at the end of the tick */
+  uint64_t arena_used;     /* bytes allocated this tick */
+  uint64_t arena_reserved; /* bytes held */
+  uint64_t arena_shrinks;  /* lifetime decay releases */
+  uint32_t arena_blocks;   /* blocks touched this tick */
+
+  /* Shared title cache, lifetime totals */
+  uint64_t title_hits;
+  uint64_t title_misses;
+
+  /* ConfigureRequests passed through for unmanaged windows, lifetime totals */
+  uint64_t unmanaged_forwarded;
+  uint64_t unmanaged_coalesced;
+
+  /* Client messages superseded within a tick, lifetime total */
+  uint64_t client_messages_dropped;
+
+  /* Synthetic ConfigureNotify, lifetime totals */
+  uint64_t synthetic_sent;
+  uint64_t synthetic_suppressed;
+
+  /* Root property writes, lifetime totals */
+  uint64_t root_props_written;
+  uint64_t root_props_skipped;
+
+  /* RandR monitor snapshots found unchanged, clients moved between monitors,
+   * lifetime totals */
+  uint64_t monitor_snapshots_same;
+  uint64_t monitor_clients_moved;
+
+  /* Priority lanes, lifetime totals */
+  uint64_t input_flushes;
+  uint64_t props_deferred;
+  uint64_t interaction_qos_ticks;
+
+  /* Timer wheel, lifetime totals */
+  uint64_t timers_fired;
+  uint64_t timer_rearms;
+
+  /* X output this tick: counted requests by kind, bytes written */
+  uint32_t xreq[XREQ_KIND_COUNT];
+  uint64_t x_bytes;
+} tick_sample_t;
+
+static inline void tick_sample_init(tick_sample_t* t) {
+  for (int i = 0; i < TICK_PHASE_COUNT; i++)
+    t->ns[i] = 0;
+  t->mask = 0;
+  t->arena_used = 0;
+  t->arena_reserved = 0;
+  t->arena_shrinks = 0;
+  t->arena_blocks = 0;
+  t->title_hits = 0;
+  t->title_misses = 0;
+  t->unmanaged_forwarded = 0;
+  t->unmanaged_coalesced = 0;
+  t->client_messages_dropped = 0;
+  t->synthetic_sent = 0;
+  t->synthetic_suppressed = 0;
+  t->root_props_written = 0;
+  t->root_props_skipped = 0;
+  t->monitor_snapshots_same = 0;
+  t->monitor_clients_moved = 0;
+  t->input_flushes = 0;
+  t->props_deferred = 0;
+  t->interaction_qos_ticks = 0;
+  t->timers_fired = 0;
+  t->timer_rearms = 0;
+  for (int i = 0; i < XREQ_KIND_COUNT; i++)
+    t->xreq[i] = 0;
+  t->x_bytes = 0;
+}
+
+static inline void tick_sample_add(tick_sample_t* t, tick_phase_t phase, uint64_t ns) {
+  t->ns[phase] += ns;
+  t->mask |= 1u << phase;
+}
+
+struct tick_stats {
+  latency_hist_t phase[TICK_PHASE_COUNT];
+
+  /* server_init breakdown, recorded once per process */
+  uint64_t startup_ns[STARTUP_PHASE_COUNT];
+
+  /* Phase breakdown of the slowest tick seen (by TOTAL) */
+  tick_sample_t slowest;
+
+  /* tick_arena bytes per tick (the histogram is unit-agnostic) */
+  latency_hist_t arena_used;
+  uint32_t arena_blocks_max;
+  uint64_t arena_reserved; /* latest tick */
+  uint64_t arena_reserved_max;
+  uint64_t arena_shrinks;
+
+  /* Title cache lookups, lifetime totals */
+  uint64_t title_hits;
+  uint64_t title_misses;
+
+  /* Unmanaged ConfigureRequest pass-through, lifetime totals */
+  uint64_t unmanaged_forwarded;
+  uint64_t unmanaged_coalesced;
+
+  /* Client messages superseded by a later copy, lifetime total */
+  uint64_t client_messages_dropped;
+
+  /* Synthetic ConfigureNotify sent vs. suppressed as redundant, lifetime totals */
+  uint64_t synthetic_sent;
+  uint64_t synthetic_suppressed;
+
+  /* Root property writes made vs. skipped as identical, lifetime totals */
+  uint64_t root_props_written;
+  uint64_t root_props_skipped;
+
+  /* RandR monitor snapshots found unchanged, clients moved between monitors,
+   * lifetime totals */
+  uint64_t monitor_snapshots_same;
+  uint64_t monitor_clients_moved;
+
+  /* Input lane flushed ahead of bulk work, PropertyNotify deferred, lifetime
+   * totals */
+  uint64_t input_flushes;
+  uint64_t props_deferred;
+  /* Ticks committed in drag mode, lifetime total */
+  uint64_t interaction_qos_ticks;
+
+  /* Timer callbacks fired and timerfd re-arms, lifetime totals */
+  uint64_t timers_fired;
+  uint64_t timer_rearms;
+
+  /* X output per tick (the histograms are unit-agnostic) */
+  latency_hist_t x_requests;
+  latency_hist_t x_bytes;
+  uint64_t x_bytes_total;
+  uint32_t xreq_max[XREQ_KIND_COUNT]; /* busiest tick per kind */
+
+  /* Interactive move/resize pacing, latest drag (mHz, 0 = none yet) */
+  uint32_t pacing_mhz;         /* effective, after interactive_max_hz */
+  uint32_t pacing_monitor_mhz; /* monitor refresh it came from, 0 = unknown */
+};
+
+extern struct tick_stats tick_stats;
+
+const char* tick_phase_name(tick_phase_t phase);
+
+void tick_stats_init(void);
+void tick_stats_record(const tick_sample_t* sample);
+void tick_stats_record_startup(startup_phase_t phase, uint64_t ns);
+void tick_stats_record_pacing(uint32_t effective_mhz, uint32_t monitor_mhz);
+
+/* Fill the sample's X output fields with the growth since *mark and the
+ * written-byte count, then advance the marks */
+void tick_sample_take_xreq(tick_sample_t* t, uint64_t mark[XREQ_KIND_COUNT], uint64_t* bytes_mark, uint64_t bytes_written);
+
+/* Render a human-readable summary (one line per phase, microseconds)
+ * Returns the number of bytes written, excluding the NUL terminator
+ */
+size_t tick_stats_format(char* buf, size_t cap);
+void tick_stats_dump(void);
+
 /* ---------- Rate limiter ---------- */
 
 typedef struct rl {
@@ -0,0 +1,93 @@
+/*
+ * icon_cache.h - Shared, deduplicated client icon surfaces
+ *
+ * Responsibilities:
+ * - Convert _NET_WM_ICON ARGB pixels into premultiplied cairo surfaces
+ * - Share one surface between every client carrying identical pixels
+ * - Keep pre-scaled variants so frame/menu paints are plain blits
+ * - Persist rasterized file icons (menu entries) so later starts skip
+ *   decoding: icon_cache_disk_load / icon_cache_disk_store
+ *
+ * Ownership:
+ * - icon_cache_intern returns a new cairo reference; release it with
+ *   cairo_surface_destroy like any other surface
+ * - The cache holds no reference of its own: an entry disappears when the
+ *   last client drops its surface
+ * - icon_cache_scaled returns a borrowed surface owned by the source icon
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef ICON_CACHE_H
+#define ICON_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <cairo/cairo.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ds.h"
+
+/* Pre-scaled variants kept per icon (title bar, menu, switcher, ...) */
+#define ICON_CACHE_VARIANTS 4
+
+typedef struct icon_cache {
+  hash_map_t by_hash; /* content hash -> cairo_surface_t* (weak) */
+  uint64_t hits;
+  uint64_t misses;
+} icon_cache_t;
+
+/* A zeroed icon_cache_t is valid and empty */
+void icon_cache_init(icon_cache_t* cache);
+void icon_cache_destroy(icon_cache_t* cache);
+
+/*
+ * Return a surface for w x h non-premultiplied ARGB pixels, shared with any
+ * live icon of identical content. Never returns NULL.
+ */
+cairo_surface_t* icon_cache_intern(icon_cache_t* cache, const uint32_t* argb, uint32_t w, uint32_t h);
+
+static inline size_t icon_cache_size(const icon_cache_t* cache) {
+  return hash_map_size(&cache->by_hash);
+}
+
+/*
+ * Return icon scaled to fit a size x size box, keeping aspect ratio.
+ * Variants are rendered once and live as long as the icon itself.
+ * Returns icon unchanged if it already fits exactly, NULL if it is not an
+ * image surface.
+ */
+cairo_surface_t* icon_cache_scaled(cairo_surface_t* icon, int size);
+
+/*
+ * On-disk cache of icons rasterized from image files, under
+ * $XDG_CACHE_HOME/hxm/icons. Entries are keyed by source path and display
+ * size, and are stale once the source's mtime or length changes.
+ *
+ * icon_cache_disk_load returns a new surface backed by a private mapping of
+ * the entry (unmapped when the surface dies), or NULL on a miss.
+ * icon_cache_disk_store writes an ARGB32 image surface; failures are silent.
+ */
+cairo_surface_t* icon_cache_disk_load(const char* path, int size);
+void icon_cache_disk_store(const char* path, int size, cairo_surface_t* surface);
+
+/*
+ * Premultiply n ARGB pixels for CAIRO_FORMAT_ARGB32.
+ * Dispatches to the best kernel for this CPU (AVX2/SSE2/NEON/scalar); every
+ * kernel matches icon_premultiply_scalar bit for bit.
+ */
+void icon_premultiply(uint32_t* dst, const uint32_t* src, size_t n);
+void icon_premultiply_scalar(uint32_t* dst, const uint32_t* src, size_t n);
+
+/* Name of the kernel icon_premultiply dispatches to */
+const char* icon_premultiply_kernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ICON_CACHE_H */
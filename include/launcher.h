@@ -0,0 +1,123 @@
+/*
+ * launcher.h - Start external commands without forking the window manager
+ *
+ * Responsibilities:
+ * - Run keybinding and menu commands ("sh -c cmd") and the autostart script
+ *   through posix_spawn. glibc implements it with clone(CLONE_VM|CLONE_VFORK):
+ *   the child borrows our address space until exec instead of copying the
+ *   page tables of every xcb, cairo and pango mapping, so a launch costs the
+ *   same however large the WM has grown
+ * - Give every child the same environment, built once without hxm-internal
+ *   variables, an empty signal mask (the WM blocks the signals it reads from
+ *   signal_fd) and default dispositions, in a session of its own
+ * - Reap children from the SIGCHLD branch of the signal_fd path; nothing
+ *   waits for a child on the event thread
+ * - Time each launch from the wakeup of the tick whose input asked for it
+ *   to the return of posix_spawn, which is after the child's exec
+ * - Optionally hand shell commands to a helper process forked by main before
+ *   the X connection, fonts and caches exist. The helper execs commands with
+ *   no shell syntax directly, resolving the program through a PATH cache
+ *   that inotify on the PATH directories invalidates, and only runs the rest
+ *   through sh. Its replies come back on helper_fd, polled by the event loop
+ *
+ * Lifecycle:
+ * - A zeroed launcher_t is valid; the environment and spawn attributes are
+ *   built on the first launch
+ * - launcher_helper_start runs before server_init, which keeps the helper
+ *   across its reset. HXM_LAUNCHER_HELPER=0 disables the helper; when it is
+ *   gone or its socket is full, commands are spawned locally
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <spawn.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "hxm.h"
+
+#define LAUNCHER_HELPER_ENV "HXM_LAUNCHER_HELPER"
+#define LAUNCHER_CMD_MAX 4096u
+#define LAUNCHER_ARGV_MAX 64u
+
+typedef struct launcher {
+  bool ready;
+  posix_spawnattr_t attr;
+  char** envp; /* NULL-terminated, owned */
+  size_t env_count;
+
+  uint32_t running; /* spawned and not yet reaped */
+  uint64_t spawned;
+  uint64_t failed;      /* posix_spawn errors */
+  uint64_t reaped;      /* children collected on SIGCHLD */
+  uint64_t exit_errors; /* reaped with a non-zero status or a signal */
+  latency_hist_t latency; /* trigger to exec */
+
+  pid_t helper_pid; /* 0 without a helper */
+  int helper_fd;    /* valid while helper_pid > 0 */
+  uint32_t helper_pending;
+  uint64_t helper_sent;
+  uint64_t helper_direct;    /* exec'd without sh */
+  uint64_t helper_fallbacks; /* spawned locally while the helper was up */
+} launcher_t;
+
+void launcher_destroy(launcher_t* l);
+
+/* Fork the helper; false when disabled or unavailable */
+bool launcher_helper_start(launcher_t* l);
+
+/* Read the helper's replies; stops using the helper once it is gone */
+void launcher_helper_collect(launcher_t* l);
+
+static inline bool launcher_helper_owns_fd(const launcher_t* l, int fd) {
+  return l->helper_pid > 0 && fd == l->helper_fd;
+}
+
+/*
+ * Run cmd through /bin/sh -c, or through the helper. trigger_ns is the
+ * monotonic time the input asking for it was woken up for, 0 to time from
+ * this call. Returns the child's pid, 0 when the helper took the command,
+ * or -1.
+ */
+pid_t launcher_shell(launcher_t* l, const char* cmd, uint64_t trigger_ns);
+
+/*
+ * Run the first of the blank-separated program names that is on PATH, with
+ * no arguments. The helper resolves them through its PATH cache and execs
+ * the one found; without it, this is "a || b || ..." through sh.
+ */
+pid_t launcher_first(launcher_t* l, const char* names, uint64_t trigger_ns);
+
+/* Run the program at path with no arguments; same as launcher_shell otherwise */
+pid_t launcher_exec(launcher_t* l, const char* path, uint64_t trigger_ns);
+
+/* Collect every exited child without blocking; returns how many */
+uint32_t launcher_reap(launcher_t* l);
+
+/* Append the report; returns bytes written, excluding the NUL */
+size_t launcher_format(const launcher_t* l, char* buf, size_t cap);
+void launcher_dump(const launcher_t* l);
+
+/*
+ * Split cmd in place into at most max - 1 words plus a NULL terminator when
+ * it has no shell syntax (quotes, expansions, redirections, operators,
+ * globs, comments or a leading assignment). Returns the word count, 0 when
+ * cmd needs sh.
+ */
+size_t launcher_split_command(char* cmd, char** argv, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LAUNCHER_H */
@@ -0,0 +1,108 @@
+/*
+ * manage_stats.h - Time from MapRequest to first frame paint
+ *
+ * Each client carries a manage_timing_t stamped at every manage milestone.
+ * The first frame paint closes the record and folds it into per-stage,
+ * per-window-type and per-WM_CLASS histograms, reported alongside tick
+ * stats by --dump-stats.
+ *
+ * Compiled into every build, like tick stats: a mark is one store, and
+ * aggregation runs once per managed window.
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef MANAGE_STATS_H
+#define MANAGE_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hxm.h"
+
+/* Manage milestones, in the order a window normally passes them */
+typedef enum manage_mark {
+  MANAGE_MARK_MAP_REQUEST = 0, /* wm_handle_map_request (0 for adopted windows) */
+  MANAGE_MARK_START,           /* client_manage_start issued the probes */
+  MANAGE_MARK_READY,           /* probes answered, STATE_READY */
+  MANAGE_MARK_FINISH,          /* client_finish_manage */
+  MANAGE_MARK_FRAME_MAP,       /* frame first mapped */
+  MANAGE_MARK_PAINT,           /* first render_frame */
+  MANAGE_MARK_COUNT
+} manage_mark_t;
+
+/* Stage n spans mark n to mark n + 1; the last slot is the whole manage */
+#define MANAGE_STAGE_COUNT MANAGE_MARK_COUNT
+#define MANAGE_STAGE_TOTAL (MANAGE_STAGE_COUNT - 1)
+
+#define MANAGE_STATS_TYPES 16   /* >= WINDOW_TYPE_COUNT */
+#define MANAGE_STATS_CLASSES 16 /* distinct WM_CLASS rows, then "(other)" */
+#define MANAGE_STATS_LABEL_LEN 32
+
+typedef struct manage_timing {
+  uint64_t t[MANAGE_MARK_COUNT]; /* monotonic ns, 0 = not reached */
+  uint64_t slowest_probe_ns;     /* push to reply of the slowest probe */
+  uint32_t slowest_probe_atom;   /* for COOKIE_GET_PROPERTY */
+  uint8_t slowest_probe_type;    /* cookie_type_t, COOKIE_NONE = no probe yet */
+} manage_timing_t;
+
+static inline void manage_timing_mark(manage_timing_t* m, manage_mark_t mark, uint64_t now_ns) {
+  if (m->t[mark] == 0)
+    m->t[mark] = now_ns;
+}
+
+static inline void manage_timing_probe(manage_timing_t* m, uint8_t cookie_type, uint32_t atom, uint64_t latency_ns) {
+  if (latency_ns < m->slowest_probe_ns && m->slowest_probe_type != 0)
+    return;
+  m->slowest_probe_ns = latency_ns;
+  m->slowest_probe_atom = atom;
+  m->slowest_probe_type = cookie_type;
+}
+
+typedef struct manage_class_stats {
+  char name[MANAGE_STATS_LABEL_LEN];
+  latency_hist_t total;
+  uint64_t worst_probe_ns;
+  char worst_probe[MANAGE_STATS_LABEL_LEN];
+} manage_class_stats_t;
+
+struct manage_stats {
+  latency_hist_t stage[MANAGE_STAGE_COUNT];
+  latency_hist_t by_type[MANAGE_STATS_TYPES];
+  manage_class_stats_t classes[MANAGE_STATS_CLASSES + 1]; /* last row is "(other)" */
+  uint32_t class_count;
+
+  /* Slowest manage seen, by total */
+  uint64_t slowest_stage_ns[MANAGE_STAGE_COUNT];
+  char slowest_class[MANAGE_STATS_LABEL_LEN];
+  char slowest_probe[MANAGE_STATS_LABEL_LEN];
+  uint64_t slowest_probe_ns;
+  uint8_t slowest_type;
+
+  /* Windows destroyed or withdrawn before they were framed */
+  uint64_t discarded_probing; /* probes still in flight */
+  uint64_t discarded_ready;   /* probes answered, waiting on the commit or manage_defer_ms */
+};
+
+extern struct manage_stats manage_stats;
+
+void manage_stats_init(void);
+
+/* Fold a record whose PAINT mark is set. probe names its slowest probe */
+void manage_stats_record(const manage_timing_t* m, uint8_t window_type, const char* wm_class, const char* probe);
+
+/* Count a window dropped before framing; ready is true past STATE_READY */
+static inline void manage_stats_discard(bool ready) {
+  if (ready)
+    manage_stats.discarded_ready++;
+  else
+    manage_stats.discarded_probing++;
+}
+
+/* Append the report; returns bytes written, excluding the NUL */
+size_t manage_stats_format(char* buf, size_t cap);
+void manage_stats_dump(void);
+
+#endif /* MANAGE_STATS_H */
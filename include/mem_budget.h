@@ -0,0 +1,115 @@
+/*
+ * mem_budget.h - Per-subsystem memory accounting and budget enforcement
+ *
+ * Usage is measured by walking the owners (slotmap, clients, caches, menu)
+ * rather than by hooking every allocation: the walk is O(clients) and runs
+ * at most once per MEM_BUDGET_INTERVAL_NS. Surfaces shared between holders
+ * (icons deduplicated by icon_cache, title runs still in title_cache) are
+ * split by reference count, so each byte is counted once.
+ *
+ * Server-side pixmaps held on our behalf (frame backing, thumbnails) are
+ * counted too, at 4 bytes per pixel: on a kiosk the X server shares the
+ * same RAM.
+ *
+ * With config.memory_budget_mb set, a measurement above the budget evicts
+ * reconstructible data, cheapest to rebuild first, until usage is back
+ * under MEM_BUDGET_LOW_WATER of the budget:
+ *
+ *   1. pooled title surfaces nobody is drawing, pooled frames
+ *   2. title runs of hidden clients
+ *   3. render contexts and frame backing of hidden clients
+ *   4. icons larger than MEM_BUDGET_ICON_MAX_PX of hidden clients
+ *
+ * A client is hidden when iconified, withdrawn, or on a desktop not shown.
+ * Independently of the budget, a hidden client's render context (cairo
+ * surface and context, layout, title run, backing pixmap) is released once
+ * it has been idle for config.render_idle_release_s, unless prewarm.h keeps
+ * its desktop warm.
+ *
+ * Everything evicted is rebuilt on the client's next paint.
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MEM_BUDGET_INTERVAL_NS 1000000000ull
+
+/* Eviction stops at this fraction of the budget, in percent */
+#define MEM_BUDGET_LOW_WATER 90u
+
+/* Largest icon edge the frame or switcher ever draws */
+#define MEM_BUDGET_ICON_MAX_PX 64
+
+typedef enum mem_class {
+  MEM_CLIENT_SLOTS = 0, /* slotmap hot + cold arrays */
+  MEM_CLIENT_STRINGS,   /* per-client string_arena blocks, interned names */
+  MEM_RENDER,           /* render context surfaces, frame backing pixmaps, pooled frames */
+  MEM_TITLES,           /* title runs: cached, pooled and held privately */
+  MEM_ICONS,            /* client icon surfaces */
+  MEM_MENU_ICONS,       /* menu.conf icon surfaces */
+  MEM_THUMBNAILS,       /* switcher thumbnails */
+  MEM_TICK_ARENA,
+  MEM_CLASS_COUNT
+} mem_class_t;
+
+typedef struct mem_usage {
+  size_t bytes[MEM_CLASS_COUNT];
+  size_t total;
+} mem_usage_t;
+
+typedef enum mem_evict {
+  MEM_EVICT_TITLE_POOL = 0,
+  MEM_EVICT_FRAME_POOL, /* counted per frame */
+  MEM_EVICT_TITLES,
+  MEM_EVICT_RENDER,
+  MEM_EVICT_ICONS,
+  MEM_EVICT_IDLE_RENDER, /* released by render_idle_release_s, not the budget */
+  MEM_EVICT_STRINGS,     /* superseded titles dropped by client_compact_strings */
+  MEM_EVICT_COUNT
+} mem_evict_t;
+
+typedef struct mem_budget {
+  uint64_t next_check_ns;
+  uint64_t last_check_ns;
+  mem_usage_t last;  /* latest measurement */
+  size_t peak_total; /* highest total measured */
+  uint64_t checks;
+  uint64_t over_budget; /* checks that found usage above the budget */
+  uint64_t evicted[MEM_EVICT_COUNT];
+  size_t evicted_bytes[MEM_EVICT_COUNT];
+} mem_budget_t;
+
+struct server;
+
+const char* mem_class_name(mem_class_t c);
+const char* mem_evict_name(mem_evict_t e);
+
+/* Walk every owner and fill out */
+void mem_usage_measure(struct server* s, mem_usage_t* out);
+
+/*
+ * Evict reconstructible data until usage is at most target bytes.
+ * Returns the bytes released; *x_queued (may be NULL) is set when X requests
+ * were queued.
+ */
+size_t mem_budget_enforce(struct server* s, size_t target, bool* x_queued);
+
+/*
+ * Called once per tick: when the interval has passed, releases idle render
+ * contexts, re-measures and enforces config.memory_budget_mb.
+ * Returns true when X requests were queued.
+ */
+bool mem_budget_tick(struct server* s, uint64_t now_ns);
+
+/* Append the report; returns bytes written, excluding the NUL */
+size_t mem_budget_format(const mem_budget_t* mb, size_t limit, char* buf, size_t cap);
+void mem_budget_dump(const mem_budget_t* mb, size_t limit);
+
+#endif /* MEM_BUDGET_H */
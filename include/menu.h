@@ -20,8 +20,14 @@
  * - menu_destroy must be called during server shutdown
  *
  * Conventions:
- * - menu items are stored as pointers (menu_item_t*) in small_vec_t
- * - selected_index is -1 when nothing is selected
+ * - shown rows are a flat menu_item_t array rebuilt on each show; their
+ *   strings live in item_arena and are released in bulk
+ * - parsed menu.conf entries are a flat menu_item_spec_t array in
+ *   config_arena together with their interned strings; a reload is one
+ *   arena teardown plus the decoded icons
+ * - selected_index is -1 when nothing is selected; it indexes items, not rows
+ * - rows[] maps each painted row to its item; with no type-ahead query it is
+ *   the identity, a query keeps only the matching items in their order
  *
  * Contracts:
  * - Callers should route relevant X events to menu_handle_* while menu.visible
@@ -41,6 +47,7 @@ extern "C" {
 #include <stdint.h>
 #include <xcb/xcb.h>
 
+#include "config_cache.h"
 #include "ds.h"
 #include "handle.h"
 #include "hxm.h"
@@ -50,31 +57,41 @@ extern "C" {
 typedef enum menu_action { MENU_ACTION_NONE = 0, MENU_ACTION_EXEC, MENU_ACTION_RESTART, MENU_ACTION_EXIT, MENU_ACTION_RELOAD, MENU_ACTION_RESTORE, MENU_ACTION_SEPARATOR } menu_action_t;
 
 typedef struct menu_item_spec {
-  char* label;
+  const char* label; /* interned in config_arena */
   menu_action_t action;
-  char* cmd;
-  char* icon_path;
+  const char* cmd;
+  const char* icon_path;
+  cairo_surface_t* icon_surface; /* decoded on first show, owned by the spec */
+  bool icon_loaded;
+  uint64_t match_mask; /* characters of label and cmd, built while parsing */
 } menu_item_spec_t;
 
 /* A single menu item */
 typedef struct menu_item {
-  char* label;
+  const char* label; /* in item_arena */
   menu_action_t action;
 
   /* Used by MENU_ACTION_EXEC */
-  char* cmd;
+  const char* cmd;
 
   /* Used by MENU_ACTION_RESTORE */
   handle_t client;
 
   /* Icon support */
-  char* icon_path;
-  cairo_surface_t* icon_surface; /* cached, owned by the menu item */
+  cairo_surface_t* icon_surface; /* borrowed from the config spec */
+
+  /* Type-ahead */
+  uint64_t match_mask; /* characters of label and cmd */
+  uint32_t row;        /* painted row, MENU_ROW_HIDDEN when filtered out */
 } menu_item_t;
 
+#define MENU_ROW_HIDDEN UINT32_MAX
+#define MENU_FILTER_MAX 64
+
 /* Menu instance state */
 typedef struct menu {
   xcb_window_t window;
+  uint32_t screen; /* Index into s->screens of the window's root */
 
   int16_t x, y;
   uint16_t w, h;
@@ -88,11 +105,32 @@ typedef struct menu {
 
   render_context_t render_ctx;
 
-  /* Vector of menu_item_t* */
-  small_vec_t items;
-
-  /* Parsed menu.conf entries (menu_item_spec_t*) */
-  small_vec_t config_items;
+  /* Rendered rows, created on show and released on hide */
+  cairo_surface_t* back;
+  xcb_pixmap_t back_pixmap; /* XCB_NONE for image-backed test buffers */
+  uint16_t back_w, back_h;
+  int32_t back_selected; /* selected_index the buffer was drawn with */
+
+  /* Rows currently populated */
+  menu_item_t* items;
+  uint32_t item_count;
+  uint32_t item_cap;
+  arena_t item_arena;
+
+  /* Shown rows; rows_next is scratch for the next filter pass (item_cap each) */
+  uint32_t* rows;
+  uint32_t* rows_next;
+  uint32_t row_count;
+
+  /* Type-ahead query, folded to lower case */
+  char filter[MENU_FILTER_MAX];
+  uint32_t filter_len;
+  uint64_t filter_mask;
+
+  /* Parsed menu.conf entries, array and strings both in config_arena */
+  menu_item_spec_t* config_items;
+  uint32_t config_count;
+  arena_t config_arena;
 } menu_t;
 
 typedef struct server server_t;
@@ -104,12 +142,22 @@ void menu_destroy(server_t* s);
 /* Load menu configuration from YAML (menu.conf) */
 bool menu_load_config(server_t* s, const char* path);
 
+/* Compiled menu.conf, see config_cache.h; load replaces the config on a hit */
+bool menu_load_cache(server_t* s, const config_cache_sources_t* src);
+void menu_store_cache(const server_t* s, const config_cache_sources_t* src);
+
 /* Show/hide */
 void menu_show(server_t* s, int16_t x, int16_t y);
 void menu_show_client_list(server_t* s, int16_t x, int16_t y);
 void menu_show_switcher(server_t* s, handle_t origin);
 void menu_hide(server_t* s);
 
+/* Re-render every row (e.g. after an icon arrives) and repaint the window */
+void menu_redraw(server_t* s);
+
+/* Refresh a client's row (label and match mask) after its title changed */
+void menu_client_title_changed(server_t* s, handle_t h);
+
 /* Event handlers while menu is active */
 void menu_handle_expose(server_t* s);
 void menu_handle_expose_region(server_t* s, const dirty_region_t* dirty);
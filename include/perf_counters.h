@@ -0,0 +1,74 @@
+/*
+ * perf_counters.h - Optional hardware counters around a code region
+ *
+ * Responsibilities:
+ * - Count cycles, instructions, L1D read misses, LLC read misses and branch
+ *   misses for the calling thread between perf_counters_start and
+ *   perf_counters_stop, user space only
+ * - Degrade per event: a PMU without an LLC event, a VM without a PMU or a
+ *   perf_event_paranoid that forbids access leaves that event (or all of
+ *   them) unavailable instead of failing
+ *
+ * Notes:
+ * - Events are opened individually, not as a group, so the kernel may
+ *   multiplex them; values are scaled by enabled/running time and are
+ *   estimates when running < enabled
+ * - Linux only; elsewhere every event is unavailable
+ *
+ * Threading:
+ * - Counts the opening thread only
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum perf_counter_kind {
+  PERF_COUNTER_CYCLES = 0,
+  PERF_COUNTER_INSTRUCTIONS,
+  PERF_COUNTER_L1D_MISSES,
+  PERF_COUNTER_LLC_MISSES,
+  PERF_COUNTER_BRANCH_MISSES,
+  PERF_COUNTER_KIND_COUNT
+} perf_counter_kind_t;
+
+typedef struct perf_counters {
+  int fd[PERF_COUNTER_KIND_COUNT]; /* -1 = unavailable */
+} perf_counters_t;
+
+typedef struct perf_counter_sample {
+  uint64_t value[PERF_COUNTER_KIND_COUNT];
+  bool valid[PERF_COUNTER_KIND_COUNT];
+} perf_counter_sample_t;
+
+/* Open every event that the kernel allows; true if at least one opened */
+bool perf_counters_open(perf_counters_t* pc);
+void perf_counters_close(perf_counters_t* pc);
+
+/* Reset and enable every open event */
+void perf_counters_start(perf_counters_t* pc);
+
+/* Disable and read; an event that never ran is left invalid */
+void perf_counters_stop(perf_counters_t* pc, perf_counter_sample_t* out);
+
+/* Short lowercase name, e.g. "l1d_misses" */
+const char* perf_counter_name(perf_counter_kind_t kind);
+
+/*
+ * Print " <NAME>_PER_OP <v>" for every kind, then " IPC <v>"; a value that
+ * cannot be computed prints as NA, so the field list never changes
+ */
+void perf_counters_print_per_op(FILE* out, const perf_counter_sample_t* s, uint64_t ops);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_COUNTERS_H */
@@ -0,0 +1,39 @@
+/*
+ * placement.h - Free-space search for initial window placement
+ *
+ * Pure geometry, no server state: callers gather the obstacle rects (see
+ * wm_place_window, which takes them from the frame index).
+ */
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "client.h"
+#include "ds.h"
+
+/*
+ * Find where a w x h rect inside area overlaps obstacles the least, measured
+ * in pixels of overlap summed over obstacles. Ties go to the topmost, then
+ * leftmost position. A rect larger than area is pinned to area's top/left.
+ *
+ * The minimum is exact: overlap is piecewise linear between obstacle edges,
+ * so only edge-aligned positions are evaluated, each row with one sweep over
+ * presorted slope changes. Cost is O(n^2) for n obstacles with scratch
+ * memory from the arena.
+ *
+ * Returns the overlap at the chosen position.
+ */
+uint64_t placement_min_overlap(arena_t* scratch, rect_t area, uint32_t w, uint32_t h, const rect_t* obstacles, size_t n, int32_t* out_x, int32_t* out_y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLACEMENT_H */
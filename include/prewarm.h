@@ -0,0 +1,70 @@
+/*
+ * prewarm.h - Idle-time decoration prewarming for desktops likely shown next
+ *
+ * A desktop switch maps every client of the new desktop at once, and any
+ * frame whose decorations are not ready is painted in that one tick. Once
+ * the loop has gone config.prewarm_idle_ms without an X event, frames on the
+ * desktops a switch most likely goes to, the neighbours of the current one
+ * and the PREWARM_RECENT most recently left, are painted ahead of time. Only
+ * the active screen (server_screen) is prewarmed:
+ *
+ * - with frame_backing, into the backing pixmap, so the exposes of the switch
+ *   are filled by the X server and nothing is rendered
+ * - without, through the render context, so the repaint on the switch finds
+ *   its surface set up and its title run in title_cache
+ *
+ * Work is done in slices of at most PREWARM_SLICE_CLIENTS frames and
+ * PREWARM_SLICE_NS, and pending input is checked before every frame: an
+ * event ends the slice and restarts the idle wait. Each idle period visits
+ * every candidate at most once.
+ *
+ * Memory: a pass stops before it would take usage measured by mem_budget
+ * above MEM_BUDGET_LOW_WATER of config.memory_budget_mb, so the evictor never
+ * undoes it. Clients it keeps warm are exempt from render_idle_release_s,
+ * not from the budget.
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef PREWARM_H
+#define PREWARM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Most recently left desktops kept warm besides the current one's neighbours */
+#define PREWARM_RECENT 2u
+
+/* Most frames painted per idle slice, and the time a slice may take */
+#define PREWARM_SLICE_CLIENTS 4u
+#define PREWARM_SLICE_NS 2000000ull
+
+typedef struct prewarm {
+  uint64_t idle_since_ns; /* last tick that ingested X events, 0 before the first */
+  uint32_t cursor;        /* candidates this idle period has visited */
+  bool pending;           /* this idle period's pass has not finished */
+  uint32_t shown;         /* current desktop as of the last tick */
+  uint32_t recent[PREWARM_RECENT]; /* most recently left desktops, newest first */
+  uint32_t recent_len;
+
+  uint64_t slices;
+  uint64_t painted;
+  uint64_t yields;       /* slices cut short by input */
+  uint64_t budget_stops; /* passes stopped by the memory budget */
+} prewarm_t;
+
+struct server;
+struct client_hot;
+
+/*
+ * Called once per tick, after the commit: restarts the idle wait when the
+ * tick ingested events, otherwise runs the next slice once the wait is over.
+ * Returns true when X requests were queued.
+ */
+bool prewarm_tick(struct server* s, uint64_t now_ns);
+
+/* hot is mapped on a desktop prewarming keeps warm */
+bool prewarm_keeps(const struct server* s, const struct client_hot* hot);
+
+#endif /* PREWARM_H */
@@ -21,8 +21,15 @@
  * Notes:
  * - The returned cairo_surface_t/cairo_t/PangoLayout are owned by
  * render_context_t
- * - render_frame may recreate the backing surface if target/visual/depth
- * changes
+ * - render_frame may recreate the backing surface if visual/depth changes;
+ * size and drawable changes retarget the existing surface in place
+ * - Title text goes through one process-wide PangoContext and layout for the
+ * main thread (render_text_*), with config.font_name parsed once per
+ * configure and its height taken from the font metrics; a render_context_t
+ * only carries a layout when its owner (the menu) wants a different font
+ * - render_tiles_t holds theme pieces shared by every frame (title slices,
+ * button glyphs); it is built lazily on first paint and rebuilt whenever the
+ * theme values it was rendered from change
  */
 
 #pragma once
@@ -37,6 +44,7 @@
 
 #include "hxm.h"
 #include "theme.h"
+#include "title_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,8 +54,8 @@ extern "C" {
 typedef struct render_context {
   cairo_surface_t* surface;
   cairo_t* cr;
-  PangoLayout* layout;
-  cairo_surface_t* title_surface;
+  PangoLayout* layout; /* optional, from render_text_layout_create */
+  cairo_surface_t* title_surface; /* own reference, possibly shared via title_cache */
 
   /* Cached target parameters */
   xcb_window_t target;
@@ -63,6 +71,7 @@ typedef struct render_context {
   int last_title_width;
   int last_title_height;
   uint32_t last_title_color;
+  bool title_pending; /* new run is on the render worker, title_surface is the old one */
 } render_context_t;
 
 /* Simple color struct for interfaces and theme conversions */
@@ -70,11 +79,49 @@ typedef struct rgba {
   double r, g, b, a;
 } rgba_t;
 
+/* Width of the fixed left/right caps of a title slice */
+#define RENDER_TILE_CAP 4
+#define RENDER_TILE_WIDTH (2 * RENDER_TILE_CAP + 1)
+
+/* Frame buttons are fixed squares */
+#define RENDER_BUTTON_SIZE 16
+
+/*
+ * Title background rendered once at RENDER_TILE_WIDTH: left cap, one
+ * stretchable column, right cap. Only appearances that do not vary along x
+ * (solid, vertical gradient) are sliced; others are drawn directly.
+ */
+typedef struct render_title_tile {
+  appearance_t app;
+  int height;
+  cairo_surface_t* slices;
+} render_title_tile_t;
+
+/* close/max/min glyphs side by side on a transparent strip */
+typedef struct render_button_tile {
+  uint32_t color;
+  cairo_surface_t* strip;
+} render_button_tile_t;
+
+typedef struct render_tiles {
+  render_title_tile_t title[2]; /* indexed by active */
+  render_button_tile_t buttons[2];
+  uint64_t builds; /* tiles rendered since init */
+} render_tiles_t;
+
+/* A zeroed render_tiles_t is valid and empty */
+void render_tiles_init(render_tiles_t* tiles);
+void render_tiles_destroy(render_tiles_t* tiles);
+
 /* Initialize / Free */
 void render_init(render_context_t* ctx);
 void render_free(render_context_t* ctx);
 
+/* Drop the title run reference; the next paint looks it up or reshapes it */
+void render_release_title(render_context_t* ctx);
+
 /* Ensure ctx matches the target window/visual/depth/size
+ * Only a new visual/depth rebuilds the surface and cairo_t
  * Returns false on allocation or backend failure
  */
 bool render_context_ensure(xcb_connection_t* conn, xcb_window_t win, xcb_visualtype_t* visual, render_context_t* ctx, int depth, int width, int height);
@@ -88,11 +135,15 @@ void render_context_begin(render_context_t* ctx);
 void render_clear(render_context_t* ctx);
 
 /* Main paint function
- * - conn/win/visual/depth define the X11 target
+ * - conn/win/visual/depth define the X11 target; win may be a window or a
+ *   pixmap of the same visual/depth
  * - ctx is persistent and owned by caller
  * - is_test may alter behavior (deterministic output, disable X11 flushes, etc)
  * - title/active/theme/icon define appearance
- * - dirty may be NULL to redraw entire frame
+ * - tiles may be NULL to draw every theme element directly
+ * - titles may be NULL to shape the title privately for this ctx
+ * - dirty may be NULL to redraw entire frame; otherwise painting is clipped
+ *   to its rects
  */
 void render_frame(xcb_connection_t* conn,
                   xcb_window_t win,
@@ -105,8 +156,54 @@ void render_frame(xcb_connection_t* conn,
                   int width,
                   int height,
                   theme_t* theme,
+                  render_tiles_t* tiles,
+                  title_cache_t* titles,
                   cairo_surface_t* icon,
-                  const dirty_region_t* dirty);
+                  const dirty_rects_t* dirty);
+
+/*
+ * Image uploads. Title runs and theme tiles are drawn by cairo's image
+ * backend and reach the server when first painted onto a frame. Once
+ * render_upload_init has a cairo-xcb surface to go by, render_image_create
+ * takes those images from cairo's per-connection MIT-SHM segment pool, so
+ * the upload is an ShmPutImage instead of the pixels crossing the socket.
+ * Without it (no MIT-SHM, remote display, tests) images are plain and go
+ * by PutImage. render_upload_set_reference takes ownership of ref and
+ * makes it that surface (NULL clears it). Main thread only.
+ */
+void render_upload_init(xcb_connection_t* conn, xcb_window_t root, xcb_visualtype_t* visual);
+void render_upload_set_reference(cairo_surface_t* ref);
+void render_upload_shutdown(void);
+bool render_upload_shm(void);
+cairo_surface_t* render_image_create(cairo_format_t format, int w, int h);
+
+/* Title font when none is configured */
+#define RENDER_TEXT_DEFAULT_FONT "Sans Bold 10"
+
+/*
+ * Main thread text state. render_text_configure parses font (NULL or empty
+ * for the default) and caches its metrics; it is a no-op for the current
+ * font. Lookups configure the default on first use.
+ */
+void render_text_configure(const char* font);
+void render_text_shutdown(void);
+const char* render_text_font(void);
+int render_text_height(void);
+uint64_t render_text_configures(void);
+
+/* New layout on the shared context; caller owns it */
+PangoLayout* render_text_layout_create(const char* font);
+
+/*
+ * Title text rasterization, shared with the render worker
+ * Safe off the main thread: touches only the given layout and image surface.
+ * render_title_layout_create builds a layout on the calling thread's font
+ * map; text_h is the line height from render_title_text_height, which
+ * centres the text without measuring it.
+ */
+PangoLayout* render_title_layout_create(const char* font);
+int render_title_text_height(PangoLayout* layout);
+bool render_title_rasterize(PangoLayout* layout, cairo_surface_t* surface, const char* title, int title_text_width, int title_h, int text_h, rgba_t text);
 
 /* Convenience: convert theme color (or other integer formats) to rgba_t
  * If you already store doubles, you can ignore this helper
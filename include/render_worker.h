@@ -0,0 +1,78 @@
+/*
+ * render_worker.h - Off-thread title text shaping
+ *
+ * Responsibilities:
+ * - Run pango on a helper thread so a slow font fallback (CJK, colour emoji,
+ *   very long titles) cannot stall event handling
+ * - Hand finished runs back to the main thread, which stores them in the
+ *   title cache and repaints the frames that were waiting
+ *
+ * Ownership:
+ * - A job owns a snapshot of its key (text copied) and a surface acquired
+ *   from the title cache pool; nothing the main thread touches is shared
+ * - inflight is main thread only; the queues are guarded by lock
+ *
+ * Notes:
+ * - notify_fd is an eventfd that becomes readable when runs are done; the
+ *   event loop watches it and calls frame_collect_title_runs
+ * - A zeroed render_worker_t is valid and not running
+ *
+ * Threading:
+ * - render_worker_start/stop/request/collect are main thread only
+ * - The worker only calls render_title_rasterize on image surfaces
+ */
+
+#ifndef RENDER_WORKER_H
+#define RENDER_WORKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ds.h"
+#include "title_cache.h"
+
+typedef struct render_job render_job_t;
+
+typedef struct render_worker {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  render_job_t* queue_head; /* main -> worker, FIFO */
+  render_job_t* queue_tail;
+  render_job_t* done; /* worker -> main, any order */
+  bool stop;
+
+  bool running;
+  int notify_fd;
+  hash_map_t inflight; /* title_key_hash -> render_job_t*, queued or done */
+} render_worker_t;
+
+/* Start the thread. Returns false (and stays stopped) if it cannot be created */
+bool render_worker_start(render_worker_t* w);
+
+/* Join the thread and drop every queued and unclaimed run (no-op if stopped) */
+void render_worker_stop(render_worker_t* w);
+
+/*
+ * Queue key for shaping into a surface from cache's pool. A key already in
+ * flight is not queued twice.
+ */
+void render_worker_request(render_worker_t* w, title_cache_t* cache, const title_key_t* key);
+
+/* Move finished runs into cache; returns how many arrived */
+size_t render_worker_collect(render_worker_t* w, title_cache_t* cache);
+
+static inline size_t render_worker_inflight(const render_worker_t* w) {
+  return hash_map_size(&w->inflight);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RENDER_WORKER_H */
@@ -0,0 +1,147 @@
+/*
+ * rules.h - Compiled matcher for application rules
+ *
+ * Responsibilities:
+ * - Index config.rules once per load so a newly managed window is tested
+ *   against the few rules that can match it, not every rule in the file
+ * - Report matches in config order, which is the order actions are applied
+ *
+ * Layout:
+ * - Each rule is anchored on its most selective string field: exact class,
+ *   else exact instance, else title substring. Rules with none of these go
+ *   on the always list
+ * - Class and instance anchors are sorted (hash, rule) arrays; title anchors
+ *   share one Aho-Corasick automaton, so a title is scanned once however
+ *   many title rules exist
+ * - type/transient are per-rule bitmasks checked before any string compare
+ * - Every candidate is confirmed with rule_matches, so hash collisions and
+ *   the non-anchor fields cost nothing in correctness
+ * - Class and instance patterns are interned (str_intern.h); a subject whose
+ *   strings are interned too is probed with their stored hash and confirmed
+ *   by pointer compare instead of strcmp
+ * - Live rules are also listed with the string fields they read, so a title
+ *   change only revisits live rules that look at the title
+ *
+ * Ownership:
+ * - The set keeps a snapshot of the rule pointers, not the rules; it must be
+ *   rebuilt (rule_set_sync) whenever config.rules changes
+ *
+ * Threading:
+ * - Main thread only; matching uses scratch owned by the set
+ */
+
+#ifndef RULES_H
+#define RULES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ds.h"
+
+struct app_rule;
+
+/* Subject fields a rule reads; also what changed on a live update */
+enum rule_dep {
+  RULE_DEP_CLASS = 1u << 0,
+  RULE_DEP_INSTANCE = 1u << 1,
+  RULE_DEP_TITLE = 1u << 2,
+};
+
+/* What a rule is tested against; strings may be NULL */
+typedef struct rule_subject {
+  const char* wm_class;
+  const char* wm_instance;
+  const char* title;
+  uint8_t type;
+  bool transient;
+  bool interned; /* wm_class and wm_instance come from str_intern */
+} rule_subject_t;
+
+typedef struct rule_key {
+  uint64_t hash;
+  uint32_t rule;
+} rule_key_t;
+
+typedef struct rule_filter {
+  uint32_t type_mask;     /* bit per window type, all set for "any" */
+  uint8_t transient_mask; /* bit 0 normal windows, bit 1 transients */
+  uint8_t deps;           /* RULE_DEP_* */
+} rule_filter_t;
+
+/* Title automaton node; children are a sibling list, -1 terminates */
+typedef struct rule_ac_node {
+  int32_t child;
+  int32_t sibling;
+  int32_t fail;
+  int32_t out;  /* first rule whose title pattern ends here */
+  int32_t dict; /* nearest node on the fail chain with out, -1 none */
+  uint8_t byte;
+} rule_ac_node_t;
+
+typedef struct rule_set {
+  const struct app_rule** rules;
+  size_t count;
+  bool built;
+
+  rule_key_t* by_class;
+  size_t class_count;
+  rule_key_t* by_instance;
+  size_t instance_count;
+
+  rule_ac_node_t* title_nodes;
+  size_t title_node_count;
+  int32_t* title_next; /* per rule: next rule ending at the same node */
+
+  uint32_t* always;
+  size_t always_count;
+
+  rule_filter_t* filters;
+  const char** class_ids;    /* per rule: interned class_match or NULL */
+  const char** instance_ids; /* per rule: interned instance_match or NULL */
+
+  uint32_t* live; /* live rules in config order */
+  size_t live_count;
+  uint8_t live_deps; /* union of the live rules' deps */
+
+  /* Match scratch: seen[rule] == epoch dedupes, matches holds the result */
+  uint32_t* seen;
+  uint32_t epoch;
+  uint32_t* matches;
+  size_t match_count;
+} rule_set_t;
+
+/* The linear reference test: does r match subj (every field checked) */
+bool rule_matches(const struct app_rule* r, const rule_subject_t* subj);
+
+/* A zeroed rule_set_t is valid and empty */
+void rule_set_init(rule_set_t* set);
+void rule_set_destroy(rule_set_t* set);
+
+/* Compile rules (small_vec of app_rule_t*), replacing any previous build */
+void rule_set_build(rule_set_t* set, const small_vec_t* rules);
+
+/* Rebuild only if rules no longer matches what the set was built from */
+void rule_set_sync(rule_set_t* set, const small_vec_t* rules);
+
+/*
+ * Indices into the built rules that match subj, ascending. The array stays
+ * valid until the next match, sync, build or destroy.
+ */
+size_t rule_set_match(rule_set_t* set, const rule_subject_t* subj, const uint32_t** out);
+
+/*
+ * Like rule_set_match, limited to live rules that read a field in changed.
+ * Same ordering and lifetime as rule_set_match.
+ */
+size_t rule_set_match_live(rule_set_t* set, const rule_subject_t* subj, uint8_t changed, const uint32_t** out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RULES_H */
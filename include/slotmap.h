@@ -15,7 +15,23 @@
  * - Not thread-safe
  * - Index 0 is reserved for HANDLE_INVALID
  * - Supports separate "hot" and "cold" storage per slot
+ * - A live bitmap mirrors hdr[].live so iteration costs O(live + cap/64)
  * - Optional debug features via macros below
+ *
+ * Storage layouts:
+ * - Contiguous (slotmap_init): hot and cold are one array each; growing
+ *   copies them, so every hot/cold pointer dies with slotmap_reserve
+ * - Paged (slotmap_init_paged): hot and cold live in pages of
+ *   SLOTMAP_PAGE_SLOTS slots behind a page directory; growing allocates new
+ *   pages only, so a slot's address never changes while the map lives.
+ *   Address computation costs one extra dependent load
+ *
+ * Columns:
+ * - slotmap_add_column registers an extra per-slot array of a fixed element
+ *   size, contiguous in both layouts, for passes that stream one or two
+ *   fields over many slots. Columns are zeroed on alloc and reallocated by
+ *   slotmap_reserve, so column pointers die with growth. The owner keeps
+ *   them in step with hot/cold; the slotmap only stores them
  */
 
 #ifndef SLOTMAP_H
@@ -69,6 +85,13 @@ extern "C" {
 #define SLOTMAP_ASSERT(x) ((void)0)
 #endif
 
+/* Slots per page in paged mode; capacity is rounded up to a whole page */
+#define SLOTMAP_PAGE_SHIFT 6u
+#define SLOTMAP_PAGE_SLOTS (1u << SLOTMAP_PAGE_SHIFT)
+#define SLOTMAP_PAGE_MASK (SLOTMAP_PAGE_SLOTS - 1u)
+
+#define SLOTMAP_MAX_COLUMNS 8u
+
 typedef struct slot_hdr {
   uint32_t gen;
   uint32_t next_free;
@@ -118,6 +141,17 @@ typedef struct slotmap {
   slot_hdr_t* hdr;
   void* hot;
   void* cold;
+  uint64_t* live_bits; /* bit i set iff hdr[i].live, (cap + 63) / 64 words */
+
+  /* Paged mode: cap / SLOTMAP_PAGE_SLOTS pages each, hot/cold stay NULL */
+  void** hot_pages;
+  void** cold_pages;
+  bool paged;
+
+  /* Columns: cap elements of col_sz[i] bytes each, in both layouts */
+  void* cols[SLOTMAP_MAX_COLUMNS];
+  size_t col_sz[SLOTMAP_MAX_COLUMNS];
+  uint32_t col_count;
 
   uint32_t cap;
   uint32_t free_head;
@@ -165,14 +199,83 @@ static inline void slotmap__poison(void* p, size_t n, uint8_t byte) {
 #endif
 }
 
+static inline size_t slotmap__live_words(uint32_t cap) {
+  return ((size_t)cap + 63u) / 64u;
+}
+
+static inline void slotmap__live_set(slotmap_t* sm, uint32_t idx) {
+  sm->live_bits[idx >> 6] |= (uint64_t)1 << (idx & 63u);
+}
+
+static inline void slotmap__live_clear(slotmap_t* sm, uint32_t idx) {
+  sm->live_bits[idx >> 6] &= ~((uint64_t)1 << (idx & 63u));
+}
+
+static inline void slotmap__cols_free(const slotmap_allocator_t* a, void** cols, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++)
+    a->free_fn(a->ctx, cols[i]);
+}
+
 static inline void slotmap__reset(slotmap_t* sm) {
   if (!sm)
     return;
   memset(sm, 0, sizeof(*sm));
 }
 
-/* Initialize with explicit allocator */
-static inline bool slotmap_init_ex(slotmap_t* sm, uint32_t cap, size_t hot_sz, size_t cold_sz, slotmap_allocator_t a) {
+/* Grow the page directories from old_pages to new_pages, allocating the new
+ * pages zeroed; existing pages stay where they are. Failure leaves sm
+ * unchanged
+ */
+static inline bool slotmap__pages_grow(slotmap_t* sm, uint32_t old_pages, uint32_t new_pages) {
+  slotmap_allocator_t a = sm->a;
+  void** hot_dir = NULL;
+  void** cold_dir = NULL;
+
+  if (sm->hot_sz != 0) {
+    hot_dir = (void**)a.calloc_fn(a.ctx, (size_t)new_pages, sizeof(void*));
+    if (!hot_dir)
+      return false;
+    if (old_pages)
+      memcpy(hot_dir, sm->hot_pages, (size_t)old_pages * sizeof(void*));
+  }
+  if (sm->cold_sz != 0) {
+    cold_dir = (void**)a.calloc_fn(a.ctx, (size_t)new_pages, sizeof(void*));
+    if (!cold_dir) {
+      a.free_fn(a.ctx, hot_dir);
+      return false;
+    }
+    if (old_pages)
+      memcpy(cold_dir, sm->cold_pages, (size_t)old_pages * sizeof(void*));
+  }
+
+  bool ok = true;
+  for (uint32_t p = old_pages; p < new_pages && ok; p++) {
+    if (hot_dir && !(hot_dir[p] = a.calloc_fn(a.ctx, SLOTMAP_PAGE_SLOTS, sm->hot_sz)))
+      ok = false;
+    else if (cold_dir && !(cold_dir[p] = a.calloc_fn(a.ctx, SLOTMAP_PAGE_SLOTS, sm->cold_sz)))
+      ok = false;
+  }
+
+  if (!ok) {
+    for (uint32_t p = old_pages; p < new_pages; p++) {
+      if (hot_dir && hot_dir[p])
+        a.free_fn(a.ctx, hot_dir[p]);
+      if (cold_dir && cold_dir[p])
+        a.free_fn(a.ctx, cold_dir[p]);
+    }
+    a.free_fn(a.ctx, cold_dir);
+    a.free_fn(a.ctx, hot_dir);
+    return false;
+  }
+
+  a.free_fn(a.ctx, sm->cold_pages);
+  a.free_fn(a.ctx, sm->hot_pages);
+  sm->hot_pages = hot_dir;
+  sm->cold_pages = cold_dir;
+  return true;
+}
+
+static inline bool slotmap__init(slotmap_t* sm, uint32_t cap, size_t hot_sz, size_t cold_sz, slotmap_allocator_t a, bool paged) {
   if (!sm)
     return false;
 
@@ -184,11 +287,17 @@ static inline bool slotmap_init_ex(slotmap_t* sm, uint32_t cap, size_t hot_sz, s
   /* cap must include the reserved index 0 */
   if (cap == 0)
     return false;
+  if (paged) {
+    if (cap > UINT32_MAX - SLOTMAP_PAGE_MASK)
+      return false;
+    cap = (cap + SLOTMAP_PAGE_MASK) & ~SLOTMAP_PAGE_MASK;
+  }
 
   sm->cap = cap;
   sm->hot_sz = hot_sz;
   sm->cold_sz = cold_sz;
   sm->a = a;
+  sm->paged = paged;
 
   /* Allocate header array */
   sm->hdr = (slot_hdr_t*)sm->a.calloc_fn(sm->a.ctx, (size_t)cap, sizeof(slot_hdr_t));
@@ -197,26 +306,44 @@ static inline bool slotmap_init_ex(slotmap_t* sm, uint32_t cap, size_t hot_sz, s
     return false;
   }
 
+  sm->live_bits = (uint64_t*)sm->a.calloc_fn(sm->a.ctx, slotmap__live_words(cap), sizeof(uint64_t));
+  if (!sm->live_bits) {
+    sm->a.free_fn(sm->a.ctx, sm->hdr);
+    slotmap__reset(sm);
+    return false;
+  }
+
   /* Allocate hot/cold storage if requested */
-  if (hot_sz != 0) {
+  if (paged) {
+    if (!slotmap__pages_grow(sm, 0, cap >> SLOTMAP_PAGE_SHIFT)) {
+      sm->a.free_fn(sm->a.ctx, sm->live_bits);
+      sm->a.free_fn(sm->a.ctx, sm->hdr);
+      slotmap__reset(sm);
+      return false;
+    }
+  }
+  else if (hot_sz != 0) {
     size_t bytes = 0;
     if (slotmap__mul_overflow_size((size_t)cap, hot_sz, &bytes)) {
+      sm->a.free_fn(sm->a.ctx, sm->live_bits);
       sm->a.free_fn(sm->a.ctx, sm->hdr);
       slotmap__reset(sm);
       return false;
     }
     sm->hot = sm->a.calloc_fn(sm->a.ctx, 1u, bytes);
     if (!sm->hot) {
+      sm->a.free_fn(sm->a.ctx, sm->live_bits);
       sm->a.free_fn(sm->a.ctx, sm->hdr);
       slotmap__reset(sm);
       return false;
     }
   }
 
-  if (cold_sz != 0) {
+  if (!paged && cold_sz != 0) {
     size_t bytes = 0;
     if (slotmap__mul_overflow_size((size_t)cap, cold_sz, &bytes)) {
       sm->a.free_fn(sm->a.ctx, sm->hot);
+      sm->a.free_fn(sm->a.ctx, sm->live_bits);
       sm->a.free_fn(sm->a.ctx, sm->hdr);
       slotmap__reset(sm);
       return false;
@@ -224,6 +351,7 @@ static inline bool slotmap_init_ex(slotmap_t* sm, uint32_t cap, size_t hot_sz, s
     sm->cold = sm->a.calloc_fn(sm->a.ctx, 1u, bytes);
     if (!sm->cold) {
       sm->a.free_fn(sm->a.ctx, sm->hot);
+      sm->a.free_fn(sm->a.ctx, sm->live_bits);
       sm->a.free_fn(sm->a.ctx, sm->hdr);
       slotmap__reset(sm);
       return false;
@@ -251,17 +379,42 @@ static inline bool slotmap_init_ex(slotmap_t* sm, uint32_t cap, size_t hot_sz, s
   return true;
 }
 
+/* Initialize with explicit allocator */
+static inline bool slotmap_init_ex(slotmap_t* sm, uint32_t cap, size_t hot_sz, size_t cold_sz, slotmap_allocator_t a) {
+  return slotmap__init(sm, cap, hot_sz, cold_sz, a, false);
+}
+
 /* Initialize using libc allocator */
 static inline bool slotmap_init(slotmap_t* sm, uint32_t cap, size_t hot_sz, size_t cold_sz) {
   return slotmap_init_ex(sm, cap, hot_sz, cold_sz, slotmap_allocator_default());
 }
 
+/* Paged layout, cap rounded up to a multiple of SLOTMAP_PAGE_SLOTS */
+static inline bool slotmap_init_paged_ex(slotmap_t* sm, uint32_t cap, size_t hot_sz, size_t cold_sz, slotmap_allocator_t a) {
+  return slotmap__init(sm, cap, hot_sz, cold_sz, a, true);
+}
+
+static inline bool slotmap_init_paged(slotmap_t* sm, uint32_t cap, size_t hot_sz, size_t cold_sz) {
+  return slotmap_init_paged_ex(sm, cap, hot_sz, cold_sz, slotmap_allocator_default());
+}
+
 static inline void slotmap_destroy(slotmap_t* sm) {
   if (!sm)
     return;
   if (sm->a.free_fn) {
+    uint32_t pages = sm->paged ? sm->cap >> SLOTMAP_PAGE_SHIFT : 0u;
+    for (uint32_t p = 0; p < pages; p++) {
+      if (sm->hot_pages)
+        sm->a.free_fn(sm->a.ctx, sm->hot_pages[p]);
+      if (sm->cold_pages)
+        sm->a.free_fn(sm->a.ctx, sm->cold_pages[p]);
+    }
+    slotmap__cols_free(&sm->a, sm->cols, sm->col_count);
+    sm->a.free_fn(sm->a.ctx, sm->cold_pages);
+    sm->a.free_fn(sm->a.ctx, sm->hot_pages);
     sm->a.free_fn(sm->a.ctx, sm->cold);
     sm->a.free_fn(sm->a.ctx, sm->hot);
+    sm->a.free_fn(sm->a.ctx, sm->live_bits);
     sm->a.free_fn(sm->a.ctx, sm->hdr);
   }
   slotmap__reset(sm);
@@ -281,13 +434,21 @@ static inline bool slotmap_live(const slotmap_t* sm, handle_t h) {
  * These do not validate live/gen and may be used in hot paths
  */
 static inline void* slotmap_hot_unchecked(const slotmap_t* sm, uint32_t idx) {
-  if (!sm || sm->hot_sz == 0 || !sm->hot)
+  if (!sm || sm->hot_sz == 0)
+    return NULL;
+  if (sm->paged)
+    return (uint8_t*)sm->hot_pages[idx >> SLOTMAP_PAGE_SHIFT] + (size_t)(idx & SLOTMAP_PAGE_MASK) * sm->hot_sz;
+  if (!sm->hot)
     return NULL;
   return (uint8_t*)sm->hot + (size_t)idx * sm->hot_sz;
 }
 
 static inline void* slotmap_cold_unchecked(const slotmap_t* sm, uint32_t idx) {
-  if (!sm || sm->cold_sz == 0 || !sm->cold)
+  if (!sm || sm->cold_sz == 0)
+    return NULL;
+  if (sm->paged)
+    return (uint8_t*)sm->cold_pages[idx >> SLOTMAP_PAGE_SHIFT] + (size_t)(idx & SLOTMAP_PAGE_MASK) * sm->cold_sz;
+  if (!sm->cold)
     return NULL;
   return (uint8_t*)sm->cold + (size_t)idx * sm->cold_sz;
 }
@@ -350,6 +511,40 @@ static inline handle_t slotmap_handle_at(const slotmap_t* sm, uint32_t idx) {
   return handle_make(idx, sh->gen);
 }
 
+/* Returns the first live index >= from, or 0 when there is none
+ * Scans the live bitmap a word at a time, so dead runs cost one load per 64
+ * slots
+ */
+static inline uint32_t slotmap_next_live(const slotmap_t* sm, uint32_t from) {
+  if (!sm || !sm->live_bits || from >= sm->cap)
+    return 0;
+  if (from == 0)
+    from = 1;
+
+  size_t words = slotmap__live_words(sm->cap);
+  size_t w = from >> 6;
+  uint64_t bits = sm->live_bits[w] & (~(uint64_t)0 << (from & 63u));
+  for (;;) {
+    if (bits)
+      return (uint32_t)((w << 6) + (size_t)__builtin_ctzll(bits));
+    if (++w >= words)
+      return 0;
+    bits = sm->live_bits[w];
+  }
+}
+
+/* Iterate live indices in ascending order:
+ *
+ *   uint32_t idx;
+ *   slotmap_for_each_live(&s->clients, idx) {
+ *     client_hot_t* hot = slotmap_hot_at(&s->clients, idx);
+ *     ...
+ *   }
+ *
+ * Freeing the current slot is safe; allocating or reserving is not
+ */
+#define slotmap_for_each_live(sm, idx) for ((idx) = slotmap_next_live((sm), 1u); (idx) != 0; (idx) = slotmap_next_live((sm), (idx) + 1u))
+
 /* Visits live slots in ascending index order
  * Callback must not call slotmap_alloc/slotmap_free/slotmap_reserve on the same
  * slotmap
@@ -357,21 +552,48 @@ static inline handle_t slotmap_handle_at(const slotmap_t* sm, uint32_t idx) {
 static inline void slotmap_for_each_used(slotmap_t* sm, slotmap_visit_fn fn, void* user) {
   if (!sm || !sm->hdr || !fn)
     return;
-  for (uint32_t idx = 1; idx < sm->cap; idx++) {
-    slot_hdr_t* sh = &sm->hdr[idx];
-    if (sh->live == 0)
-      continue;
-
+  uint32_t idx;
+  slotmap_for_each_live(sm, idx) {
     void* hot = slotmap_hot_unchecked(sm, idx);
     void* cold = slotmap_cold_unchecked(sm, idx);
-    handle_t h = handle_make(idx, sh->gen);
+    handle_t h = handle_make(idx, sm->hdr[idx].gen);
     fn(hot, cold, h, user);
   }
 }
 
+/* Register a column of elem_sz bytes per slot, zeroed for every slot.
+ * Returns the column id (registration order), or -1 on failure
+ */
+static inline int slotmap_add_column(slotmap_t* sm, size_t elem_sz) {
+  if (!sm || !sm->hdr || elem_sz == 0 || sm->col_count >= SLOTMAP_MAX_COLUMNS)
+    return -1;
+  size_t bytes = 0;
+  if (slotmap__mul_overflow_size((size_t)sm->cap, elem_sz, &bytes))
+    return -1;
+  void* col = sm->a.calloc_fn(sm->a.ctx, 1u, bytes);
+  if (!col)
+    return -1;
+  uint32_t id = sm->col_count++;
+  sm->cols[id] = col;
+  sm->col_sz[id] = elem_sz;
+  return (int)id;
+}
+
+static inline uint32_t slotmap_column_count(const slotmap_t* sm) {
+  return sm ? sm->col_count : 0u;
+}
+
+/* Base of column col indexed by slot index, NULL if not registered */
+static inline void* slotmap_column(const slotmap_t* sm, uint32_t col) {
+  if (!sm || col >= sm->col_count)
+    return NULL;
+  return sm->cols[col];
+}
+
 /* Reserve capacity (strong safety)
  * Allocates fresh buffers and copies existing content so failure leaves sm
- * unchanged
+ * unchanged. In paged mode only the headers and columns are copied;
+ * hot/cold get new pages and existing slots keep their addresses
  */
 static inline bool slotmap_reserve(slotmap_t* sm, uint32_t new_cap) {
   if (!sm || !sm->hdr)
@@ -380,6 +602,11 @@ static inline bool slotmap_reserve(slotmap_t* sm, uint32_t new_cap) {
     return true;
   if (new_cap == 0)
     return false;
+  if (sm->paged) {
+    if (new_cap > UINT32_MAX - SLOTMAP_PAGE_MASK)
+      return false;
+    new_cap = (new_cap + SLOTMAP_PAGE_MASK) & ~SLOTMAP_PAGE_MASK;
+  }
 
   slotmap_allocator_t a = sm->a;
   if (!a.calloc_fn || !a.malloc_fn || !a.free_fn)
@@ -393,33 +620,66 @@ static inline bool slotmap_reserve(slotmap_t* sm, uint32_t new_cap) {
   if (!new_hdr)
     return false;
 
+  uint64_t* new_bits = (uint64_t*)a.calloc_fn(a.ctx, slotmap__live_words(new_cap), sizeof(uint64_t));
+  if (!new_bits) {
+    a.free_fn(a.ctx, new_hdr);
+    return false;
+  }
+
+  void* new_cols[SLOTMAP_MAX_COLUMNS] = {0};
+  for (uint32_t c = 0; c < sm->col_count; c++) {
+    size_t bytes = 0;
+    if (slotmap__mul_overflow_size((size_t)new_cap, sm->col_sz[c], &bytes) || !(new_cols[c] = a.calloc_fn(a.ctx, 1u, bytes))) {
+      slotmap__cols_free(&a, new_cols, c);
+      a.free_fn(a.ctx, new_bits);
+      a.free_fn(a.ctx, new_hdr);
+      return false;
+    }
+  }
+
   void* new_hot = NULL;
   void* new_cold = NULL;
 
-  if (sm->hot_sz != 0) {
+  if (sm->paged) {
+    if (!slotmap__pages_grow(sm, sm->cap >> SLOTMAP_PAGE_SHIFT, new_cap >> SLOTMAP_PAGE_SHIFT)) {
+      slotmap__cols_free(&a, new_cols, sm->col_count);
+      a.free_fn(a.ctx, new_bits);
+      a.free_fn(a.ctx, new_hdr);
+      return false;
+    }
+  }
+  else if (sm->hot_sz != 0) {
     size_t bytes = 0;
     if (slotmap__mul_overflow_size((size_t)new_cap, sm->hot_sz, &bytes)) {
+      slotmap__cols_free(&a, new_cols, sm->col_count);
+      a.free_fn(a.ctx, new_bits);
       a.free_fn(a.ctx, new_hdr);
       return false;
     }
     new_hot = a.malloc_fn(a.ctx, bytes);
     if (!new_hot) {
+      slotmap__cols_free(&a, new_cols, sm->col_count);
+      a.free_fn(a.ctx, new_bits);
       a.free_fn(a.ctx, new_hdr);
       return false;
     }
     memset(new_hot, 0, bytes);
   }
 
-  if (sm->cold_sz != 0) {
+  if (!sm->paged && sm->cold_sz != 0) {
     size_t bytes = 0;
     if (slotmap__mul_overflow_size((size_t)new_cap, sm->cold_sz, &bytes)) {
+      slotmap__cols_free(&a, new_cols, sm->col_count);
       a.free_fn(a.ctx, new_hot);
+      a.free_fn(a.ctx, new_bits);
       a.free_fn(a.ctx, new_hdr);
       return false;
     }
     new_cold = a.malloc_fn(a.ctx, bytes);
     if (!new_cold) {
+      slotmap__cols_free(&a, new_cols, sm->col_count);
       a.free_fn(a.ctx, new_hot);
+      a.free_fn(a.ctx, new_bits);
       a.free_fn(a.ctx, new_hdr);
       return false;
     }
@@ -428,6 +688,7 @@ static inline bool slotmap_reserve(slotmap_t* sm, uint32_t new_cap) {
 
   /* Copy old content */
   memcpy(new_hdr, sm->hdr, (size_t)sm->cap * sizeof(slot_hdr_t));
+  memcpy(new_bits, sm->live_bits, slotmap__live_words(sm->cap) * sizeof(uint64_t));
 
   if (sm->hot_sz != 0 && sm->hot) {
     memcpy(new_hot, sm->hot, (size_t)sm->cap * sm->hot_sz);
@@ -435,6 +696,9 @@ static inline bool slotmap_reserve(slotmap_t* sm, uint32_t new_cap) {
   if (sm->cold_sz != 0 && sm->cold) {
     memcpy(new_cold, sm->cold, (size_t)sm->cap * sm->cold_sz);
   }
+  for (uint32_t c = 0; c < sm->col_count; c++) {
+    memcpy(new_cols[c], sm->cols[c], (size_t)sm->cap * sm->col_sz[c]);
+  }
 
   /* Initialize new headers and push them onto free list */
   uint32_t old_cap = sm->cap;
@@ -446,11 +710,17 @@ static inline bool slotmap_reserve(slotmap_t* sm, uint32_t new_cap) {
   }
 
   /* Swap in */
+  for (uint32_t c = 0; c < sm->col_count; c++) {
+    a.free_fn(a.ctx, sm->cols[c]);
+    sm->cols[c] = new_cols[c];
+  }
   a.free_fn(a.ctx, sm->cold);
   a.free_fn(a.ctx, sm->hot);
+  a.free_fn(a.ctx, sm->live_bits);
   a.free_fn(a.ctx, sm->hdr);
 
   sm->hdr = new_hdr;
+  sm->live_bits = new_bits;
   sm->hot = new_hot;
   sm->cold = new_cold;
   sm->cap = new_cap;
@@ -477,6 +747,7 @@ static inline handle_t slotmap_alloc(slotmap_t* sm, void** out_hot, void** out_c
 
   sh->live = 1;
   sh->next_free = 0;
+  slotmap__live_set(sm, idx);
 
 #ifdef SLOTMAP_TRACK_USED
   sm->used++;
@@ -491,6 +762,8 @@ static inline handle_t slotmap_alloc(slotmap_t* sm, void** out_hot, void** out_c
   if (cold && sm->cold_sz)
     memset(cold, 0, sm->cold_sz);
 #endif
+  for (uint32_t c = 0; c < sm->col_count; c++)
+    memset((uint8_t*)sm->cols[c] + (size_t)idx * sm->col_sz[c], 0, sm->col_sz[c]);
 
   if (out_hot)
     *out_hot = hot;
@@ -536,6 +809,7 @@ static inline void slotmap_free(slotmap_t* sm, handle_t h) {
     return;
 
   sh->live = 0;
+  slotmap__live_clear(sm, idx);
 
 #ifdef SLOTMAP_TRACK_USED
   if (sm->used)
@@ -579,6 +853,7 @@ static inline void slotmap_clear(slotmap_t* sm) {
   }
 
   sm->free_head = (sm->cap > 1) ? 1u : 0u;
+  memset(sm->live_bits, 0, slotmap__live_words(sm->cap) * sizeof(uint64_t));
 
 #ifdef SLOTMAP_TRACK_USED
   sm->used = 0;
@@ -606,10 +881,9 @@ static inline uint32_t slotmap_count(const slotmap_t* sm) {
   return sm->used;
 #else
   uint32_t c = 0;
-  for (uint32_t i = 1; i < sm->cap; i++) {
-    if (sm->hdr[i].live)
-      c++;
-  }
+  size_t words = slotmap__live_words(sm->cap);
+  for (size_t w = 0; w < words; w++)
+    c += (uint32_t)__builtin_popcountll(sm->live_bits[w]);
   return c;
 #endif
 }
@@ -629,6 +903,7 @@ static inline uint32_t slotmap_used_count(const slotmap_t* sm) {
  * - free list indices are in range
  * - free list slots are not live
  * - no obvious self-loop at head
+ * - the live bitmap agrees with hdr[].live
  *
  * This is intentionally lightweight and not a full cycle detector
  */
@@ -637,9 +912,15 @@ static inline bool slotmap_validate_basic(const slotmap_t* sm) {
     return false;
   if (sm->cap == 0)
     return false;
-  if (!sm->hdr)
+  if (!sm->hdr || !sm->live_bits)
     return false;
 
+  for (uint32_t i = 0; i < sm->cap; i++) {
+    bool bit = (sm->live_bits[i >> 6] >> (i & 63u)) & 1u;
+    if (bit != (sm->hdr[i].live != 0))
+      return false;
+  }
+
   uint32_t slow = sm->free_head;
   uint32_t fast = sm->free_head;
 
@@ -1,5 +1,21 @@
 /*
  * snap.h - Snap-to-edge helpers
+ *
+ * Responsibilities:
+ * - Map a drag pointer position to a tile of the monitor workarea: left and
+ *   right tiles split at a configurable ratio, quarter tiles in the corners,
+ *   and the whole workarea at the top edge
+ * - Pull a dragged frame onto nearby window, monitor and strut edges (edge
+ *   resistance and magnetism) through a sorted edge index built once per drag
+ *
+ * Notes:
+ * - The edge index holds lines, not clients: each one is a position on its
+ *   axis plus the span it covers on the other axis. A query binary-searches
+ *   the lines within reach, so a motion step is O(log n) in the edge count
+ * - A zeroed snap_edge_index_t is valid and empty
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
  */
 
 #ifndef SNAP_H
@@ -10,6 +26,8 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "client.h"
 
@@ -19,7 +37,43 @@ typedef struct snap_candidate {
   rect_t rect;
 } snap_candidate_t;
 
-snap_candidate_t snap_compute_candidate(int px, int py, rect_t wa, int threshold_px);
+typedef struct snap_layout {
+  int threshold_px;   /* distance from a workarea edge that arms a zone */
+  int corner_px;      /* reach of the quarter-tile zones along each edge, 0 = no corners */
+  uint32_t split_pct; /* width of the left tile in percent of the workarea */
+  bool top_maximize;  /* the top edge tiles the whole workarea */
+} snap_layout_t;
+
+snap_candidate_t snap_compute_candidate(int px, int py, rect_t wa, const snap_layout_t* layout);
+
+typedef struct snap_line {
+  int32_t pos; /* coordinate on the line's axis */
+  int32_t lo;  /* span on the other axis, inclusive */
+  int32_t hi;
+} snap_line_t;
+
+typedef struct snap_edge_index {
+  snap_line_t* x; /* vertical lines, sorted by pos once built */
+  snap_line_t* y; /* horizontal lines */
+  size_t x_len, x_cap;
+  size_t y_len, y_cap;
+} snap_edge_index_t;
+
+/* Drop all lines, keeping the storage for the next drag */
+void snap_edges_clear(snap_edge_index_t* idx);
+void snap_edges_destroy(snap_edge_index_t* idx);
+
+/* Add the four edges of r; returns false on OOM */
+bool snap_edges_add_rect(snap_edge_index_t* idx, rect_t r);
+
+/* Sort after the last add; queries need sorted lines */
+void snap_edges_sort(snap_edge_index_t* idx);
+
+/*
+ * Move r so its nearest edge on each axis lands on a line within dist_px
+ * whose span overlaps r. Returns r unchanged when nothing is in reach.
+ */
+rect_t snap_edges_attract(const snap_edge_index_t* idx, rect_t r, int dist_px);
 
 #ifdef __cplusplus
 }
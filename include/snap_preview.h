@@ -16,7 +16,11 @@ extern "C" {
 
 void snap_preview_init(server_t* s);
 void snap_preview_destroy(server_t* s);
-void snap_preview_apply(server_t* s, const rect_t* rect, bool show);
+/*
+ * Show the preview over rect on scr, or hide it. A hollow preview keeps only
+ * its border, which is how outline drags draw the window's prospective frame.
+ */
+void snap_preview_apply(server_t* s, const screen_t* scr, const rect_t* rect, bool show, bool hollow);
 
 #ifdef __cplusplus
 }
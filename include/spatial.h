@@ -0,0 +1,73 @@
+/*
+ * spatial.h - Uniform grid over client frame rectangles
+ *
+ * Responsibilities:
+ * - Answer "which clients cover this point" and "which clients intersect
+ *   this rect" without walking every managed client
+ * - Track one frame rect per handle; moving a client only touches the cells
+ *   it leaves and enters
+ *
+ * Notes:
+ * - The grid knows nothing about desktops, visibility or stacking; callers
+ *   filter candidates (see wm_client_at_point)
+ * - Cells are allocated lazily and dropped once empty, so memory follows the
+ *   area actually covered by windows
+ * - A zeroed spatial_index_t is valid and empty
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "client.h"
+#include "ds.h"
+#include "handle.h"
+
+/* Cells are (1 << SPATIAL_CELL_SHIFT) pixels square */
+#define SPATIAL_CELL_SHIFT 8
+
+typedef struct spatial_index {
+  hash_map_t cells;   /* packed cell coordinate -> spatial_cell_t* */
+  hash_map_t entries; /* handle -> rect_t* (currently indexed rect) */
+} spatial_index_t;
+
+void spatial_index_init(spatial_index_t* idx);
+void spatial_index_destroy(spatial_index_t* idx);
+
+/*
+ * Index h under rect, replacing any previous rect. An empty rect removes h.
+ * Returns false if rect is unchanged and nothing was touched.
+ */
+bool spatial_index_update(spatial_index_t* idx, handle_t h, rect_t rect);
+
+/* Drop h from the index (no-op if absent) */
+void spatial_index_remove(spatial_index_t* idx, handle_t h);
+
+/* Rect h is currently indexed under */
+bool spatial_index_get(const spatial_index_t* idx, handle_t h, rect_t* out);
+
+static inline size_t spatial_index_size(const spatial_index_t* idx) {
+  return hash_map_size(&idx->entries);
+}
+
+/* Append every handle whose rect contains (x, y); returns the number appended */
+size_t spatial_index_query_point(const spatial_index_t* idx, int32_t x, int32_t y, handle_vec_t* out);
+
+/* Append every handle whose rect intersects r, each once; returns the number appended */
+size_t spatial_index_query_rect(const spatial_index_t* idx, rect_t r, handle_vec_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPATIAL_H */
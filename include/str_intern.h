@@ -0,0 +1,66 @@
+/*
+ * str_intern.h - Process-wide refcounted string intern table
+ *
+ * Responsibilities:
+ * - Keep one copy of each distinct WM_CLASS class/instance, WM_CLIENT_MACHINE
+ *   and WM_COMMAND value however many clients carry it; a session with forty
+ *   terminals holds "XTerm", "xterm" and the hostname once each
+ * - Make interned strings comparable by pointer: two interned strings are
+ *   equal iff they are the same pointer, so rule matching confirms class and
+ *   instance without strcmp
+ *
+ * Ownership:
+ * - str_intern and str_intern_ref each take a reference, str_intern_release
+ *   drops one; the string is freed with its last reference
+ * - Only pointers returned by str_intern/str_intern_ref may be passed back
+ *   in; every function accepts NULL
+ *
+ * Notes:
+ * - The table hash (str_hash) is 64-bit FNV-1a, stored with each string, so
+ *   str_intern_hash costs a load instead of a pass over the bytes
+ * - Strings are cut at the first NUL within len
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef STR_INTERN_H
+#define STR_INTERN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* 64-bit FNV-1a over len bytes */
+uint64_t str_hash(const char* s, size_t len);
+
+/* Intern the first len bytes of s (or up to a NUL); NULL only for NULL s */
+const char* str_intern_n(const char* s, size_t len);
+
+/* Intern a NUL-terminated string */
+const char* str_intern(const char* s);
+
+/* Take another reference to an interned string; returns s */
+const char* str_intern_ref(const char* s);
+
+/* Drop a reference; the string is freed with the last one */
+void str_intern_release(const char* s);
+
+/* Hash of an interned string, equal to str_hash over its bytes */
+uint64_t str_intern_hash(const char* s);
+
+/* References held on an interned string, 0 for NULL */
+uint32_t str_intern_refs(const char* s);
+
+/* Distinct strings held and the heap bytes they take */
+size_t str_intern_count(void);
+size_t str_intern_bytes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STR_INTERN_H */
@@ -121,6 +121,19 @@ static inline double theme_color_b_f(uint32_t argb) {
   return (double)theme_color_b(argb) / 255.0;
 }
 
+static inline bool theme_appearance_equal(const appearance_t* a, const appearance_t* b) {
+  return a->flags == b->flags && a->color == b->color && a->color_to == b->color_to;
+}
+
+/* True when focused and unfocused frames paint the same, so focus changes need no repaint */
+static inline bool theme_focus_looks_same(const theme_t* t) {
+  return theme_appearance_equal(&t->window_active_title, &t->window_inactive_title) &&
+         t->window_active_label_text_color == t->window_inactive_label_text_color &&
+         t->window_active_border_color == t->window_inactive_border_color &&
+         theme_appearance_equal(&t->window_active_handle, &t->window_inactive_handle) &&
+         theme_appearance_equal(&t->window_active_grip, &t->window_inactive_grip);
+}
+
 /* Basic flag validation (keeps call sites honest)
  * Returns true if orientation bits are either 0 or exactly one of them
  */
@@ -0,0 +1,66 @@
+/*
+ * thumbnail.h - Downscaled client snapshots for the window switcher
+ *
+ * Responsibilities:
+ * - Redirect client windows (automatic Composite redirection) so their
+ *   contents stay readable while covered
+ * - Keep one surface per client, at most THUMBNAIL_MAX_W x THUMBNAIL_MAX_H,
+ *   scaled with RENDER from the window's NameWindowPixmap
+ * - Refresh lazily: Damage marks a thumbnail stale, thumbnail_flush rescales
+ *   it once per config.switcher_thumbnail_hz at most
+ *
+ * Ownership:
+ * - cold->thumb is owned by the client and released by thumbnail_release
+ * - thumbnail_get returns a borrowed surface, valid until the next flush
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <cairo/cairo.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "client.h"
+#include "event.h"
+
+#define THUMBNAIL_MAX_W 96
+#define THUMBNAIL_MAX_H 60
+
+/* True when config asks for thumbnails and the server has Composite */
+bool thumbnail_enabled(const server_t* s);
+
+/* Start tracking a newly managed client (redirects its window) */
+void thumbnail_track(server_t* s, handle_t h);
+
+/* Drop a client's thumbnail and queue entry, e.g. on unmanage */
+void thumbnail_release(server_t* s, handle_t h);
+
+/* Stop redirecting h and drop its Damage, keeping the last thumbnail;
+ * thumbnail_track resumes */
+void thumbnail_suspend(server_t* s, handle_t h);
+
+/* Note new damage on h; the rescale happens in thumbnail_flush */
+void thumbnail_mark_stale(server_t* s, handle_t h);
+
+/* Rescale queued thumbnails whose refresh interval has passed */
+bool thumbnail_flush(server_t* s, uint64_t now);
+
+/* Current thumbnail for h and its size, or NULL if none was captured yet */
+cairo_surface_t* thumbnail_get(server_t* s, handle_t h, int* out_w, int* out_h);
+
+/* Track or release every managed client after switcher_thumbnails changes */
+void thumbnail_apply_config(server_t* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THUMBNAIL_H */
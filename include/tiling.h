@@ -0,0 +1,126 @@
+/*
+ * tiling.h - Tiling layout engine
+ *
+ * Responsibilities:
+ * - Keep the tiled clients of one desktop on one monitor, in two shapes at
+ *   once: insertion order for master/stack, and a binary space partition
+ *   tree for BSP, so switching layouts needs no rebuild
+ * - Turn the tree and the area into frame rects, recomputing only what an
+ *   insert, remove, ratio change or area change touched
+ * - Report only the clients whose frame rect changed since the last layout
+ *
+ * Notes:
+ * - BSP: a new client splits the leaf it is inserted next to (or the newest
+ *   one) across that leaf's longer side at the next layout; a removed client's sibling takes over its
+ *   parent's space. Each only dirties that subtree, so laying out after a
+ *   map or unmap is O(depth + leaves under it), not O(clients)
+ * - Master/stack: the first client takes master_permille of the width, the
+ *   rest share the column to its right. Every stack rect depends on the
+ *   stack's length, so they are all recomputed, but only changes are
+ *   reported
+ * - gap_px separates tiles from each other and from the area's edges
+ * - Nodes live in one pool indexed by uint32_t; freed nodes are reused
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef TILING_H
+#define TILING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "client.h"
+#include "handle.h"
+
+#define TILE_NIL UINT32_MAX
+
+typedef enum tile_mode { TILE_FLOAT = 0, TILE_MASTER, TILE_BSP, TILE_MODE_COUNT } tile_mode_t;
+
+typedef struct tile_node {
+  uint32_t parent;
+  uint32_t child[2];
+  handle_t client;   /* leaves only; HANDLE_INVALID on inner and free nodes */
+  uint16_t ratio;    /* share of the first child, per mille */
+  bool side_by_side; /* children left|right rather than top/bottom */
+  bool oriented;     /* side_by_side is set, at the node's first layout */
+  bool dirty;        /* rect and everything under it must be recomputed */
+  bool dirty_below;  /* some descendant is dirty */
+  rect_t rect;       /* space given to the node, outer gap already applied */
+  rect_t last;       /* leaves: last reported frame rect, zero until reported */
+} tile_node_t;
+
+typedef struct tile_slot {
+  handle_t client;
+  uint32_t leaf;
+} tile_slot_t;
+
+typedef struct tile_result {
+  handle_t client;
+  rect_t rect;
+} tile_result_t;
+
+typedef struct tile_tree {
+  tile_mode_t mode;
+  rect_t area;
+  uint16_t gap_px;
+  uint16_t master_permille;
+
+  tile_node_t* nodes;
+  uint32_t nodes_len;
+  uint32_t nodes_cap;
+  uint32_t free_head; /* free list threaded through parent */
+  uint32_t root;      /* TILE_NIL when empty */
+
+  tile_slot_t* slots; /* insertion order, which is master/stack order */
+  size_t slots_len;
+  size_t slots_cap;
+
+  tile_result_t* out;
+  size_t out_cap;
+
+  bool pending; /* something is dirty */
+
+  uint64_t layouts;
+  uint64_t nodes_visited;
+  uint64_t rects_reported;
+} tile_tree_t;
+
+void tile_tree_init(tile_tree_t* t, tile_mode_t mode);
+void tile_tree_destroy(tile_tree_t* t);
+
+size_t tile_tree_count(const tile_tree_t* t);
+bool tile_tree_contains(const tile_tree_t* t, handle_t h);
+
+/* Add h next to near (HANDLE_INVALID: the newest client); false on OOM or if present */
+bool tile_tree_insert(tile_tree_t* t, handle_t h, handle_t near);
+bool tile_tree_remove(tile_tree_t* t, handle_t h);
+
+void tile_tree_set_mode(tile_tree_t* t, tile_mode_t mode);
+void tile_tree_set_area(tile_tree_t* t, rect_t area, uint16_t gap_px);
+void tile_tree_set_master(tile_tree_t* t, uint16_t permille);
+
+/* Move h's nearest split (the master split in master/stack) by delta per mille */
+bool tile_tree_resize(tile_tree_t* t, handle_t h, int delta_permille);
+
+/* Report h (HANDLE_INVALID: every client) again on the next layout, e.g. after it was moved by hand */
+void tile_tree_invalidate(tile_tree_t* t, handle_t h);
+
+/*
+ * Recompute what is dirty. Returns the clients whose frame rect changed, in
+ * storage owned by the tree and valid until the next call; *n is their count.
+ * A TILE_FLOAT tree reports nothing.
+ */
+const tile_result_t* tile_tree_layout(tile_tree_t* t, size_t* n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TILING_H */
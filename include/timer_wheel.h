@@ -0,0 +1,113 @@
+/*
+ * timer_wheel.h - Hierarchical timer wheel for deferred main-loop work
+ *
+ * Responsibilities:
+ * - Keep every deadline the event loop cares about (hover focus, trailing
+ *   title refreshes, XSync and interaction pacing, cookie expiry, held
+ *   manage requests) in one structure with O(1) add and cancel
+ * - Fire each timer's callback once its deadline has passed
+ * - Report the single instant the loop must wake at, so one timerfd serves
+ *   every timer
+ *
+ * Layout:
+ * - TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots, one tick being
+ *   TIMER_WHEEL_TICK_NS. Level 0 holds timers due within 64 ticks, level n
+ *   those due within 64^(n+1); slots of higher levels cascade down as the
+ *   wheel turns. Deadlines beyond the horizon wait in the top level and are
+ *   placed again when it cascades
+ * - Timers are embedded in their owner (no allocation) and linked through
+ *   next/pprev, so a zeroed wheel and a zeroed timer are both valid
+ *
+ * Slack:
+ * - A timer may fire up to slack_ns after its deadline. The reported wakeup
+ *   is the earliest deadline + slack, so timers due close together share one
+ *   wakeup instead of each arming their own
+ * - Timers never fire before their deadline
+ *
+ * Threading:
+ * - Not thread-safe; main thread only
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_TICK_NS 250000u /* 0.25 ms */
+#define TIMER_WHEEL_BITS 6u
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4u
+
+struct wheel_timer;
+
+/* ctx is the pointer passed to timer_wheel_run */
+typedef void (*wheel_timer_fn)(struct wheel_timer* t, void* ctx);
+
+typedef struct wheel_timer {
+  struct wheel_timer* next;
+  struct wheel_timer** pprev; /* NULL while not pending */
+  uint64_t deadline_ns;
+  uint64_t slack_ns;
+  uint64_t expires; /* tick the timer is due at */
+  wheel_timer_fn fn;
+} wheel_timer_t;
+
+typedef struct timer_wheel {
+  wheel_timer_t* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint64_t occupied[TIMER_WHEEL_LEVELS]; /* bit per non-empty slot */
+  uint64_t base;                         /* next tick to process */
+  uint32_t count;
+  bool running;        /* inside timer_wheel_run */
+  uint64_t run_target; /* last tick that run processes */
+
+  uint64_t next_ns; /* cached timer_wheel_next_ns, valid when next_valid */
+  bool next_valid;
+
+  uint64_t added;
+  uint64_t cancelled;
+  uint64_t fired;
+  uint64_t runs_fired; /* runs that fired at least one timer */
+  uint64_t cascaded;
+} timer_wheel_t;
+
+static inline void wheel_timer_init(wheel_timer_t* t, wheel_timer_fn fn) {
+  t->next = NULL;
+  t->pprev = NULL;
+  t->deadline_ns = t->slack_ns = t->expires = 0;
+  t->fn = fn;
+}
+
+static inline bool wheel_timer_pending(const wheel_timer_t* t) {
+  return t->pprev != NULL;
+}
+
+/* Arm t for deadline_ns (monotonic); a pending t is moved */
+void timer_wheel_add(timer_wheel_t* w, wheel_timer_t* t, uint64_t deadline_ns, uint64_t slack_ns);
+
+/* Disarm t; no-op when it is not pending */
+void timer_wheel_cancel(timer_wheel_t* w, wheel_timer_t* t);
+
+/*
+ * Fire every timer due at now_ns, in tick order. Callbacks may add or cancel
+ * any timer, including the one firing. Returns how many fired.
+ */
+uint32_t timer_wheel_run(timer_wheel_t* w, uint64_t now_ns, void* ctx);
+
+/* Monotonic ns the loop should wake at for the next timer, UINT64_MAX if none */
+uint64_t timer_wheel_next_ns(timer_wheel_t* w);
+
+/* Append the report; returns bytes written, excluding the NUL */
+size_t timer_wheel_format(const timer_wheel_t* w, char* buf, size_t cap);
+void timer_wheel_dump(const timer_wheel_t* w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMER_WHEEL_H */
@@ -0,0 +1,111 @@
+/*
+ * title_cache.h - Shared LRU of rendered title text runs
+ *
+ * Responsibilities:
+ * - Keep recently shaped titles as ARGB surfaces, keyed by everything that
+ *   affects the pixels (font, text, max width, height, colour), so clients
+ *   that flip between a few titles, or share one, skip pango entirely
+ * - Recycle surfaces of evicted runs through a small size-classed pool
+ *   instead of allocating a fresh image surface per title change
+ *
+ * Ownership:
+ * - The cache holds one reference per run; title_cache_lookup and
+ *   title_cache_insert return borrowed surfaces, so callers that keep one
+ *   past the next cache call take their own reference
+ * - Evicted surfaces still referenced elsewhere are released, not pooled
+ *
+ * Notes:
+ * - Pooled surfaces are at least as wide as requested (width is rounded up
+ *   to a size class) and are not cleared; callers paint every pixel
+ * - A zeroed title_cache_t is valid and empty
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef TITLE_CACHE_H
+#define TITLE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <cairo/cairo.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ds.h"
+#include "hxm.h"
+
+/* Runs kept before the least recently used one is evicted */
+#define TITLE_CACHE_CAPACITY 64
+
+/* Free surfaces kept for reuse; widths are rounded up to a multiple of this */
+#define TITLE_CACHE_POOL_SIZE 16
+#define TITLE_CACHE_WIDTH_CLASS 32
+
+typedef struct title_key {
+  const char* font;
+  const char* text;
+  int width; /* layout width the text was ellipsized to */
+  int height;
+  uint32_t color;
+} title_key_t;
+
+struct render_worker;
+
+typedef struct title_cache {
+  hash_map_t by_key; /* key hash -> title_run_t* */
+  list_node_t lru;   /* most recently used first */
+  size_t count;
+
+  cairo_surface_t* pool[TITLE_CACHE_POOL_SIZE];
+  size_t pool_len;
+
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t pool_reuses;
+
+  /* When set, render_frame shapes misses on this worker instead of inline */
+  struct render_worker* worker;
+} title_cache_t;
+
+void title_cache_init(title_cache_t* cache);
+void title_cache_destroy(title_cache_t* cache);
+
+/* Hash of every key field; never 0, equal keys hash equal */
+uint64_t title_key_hash(const title_key_t* key);
+
+/* Return the run rendered for key and mark it most recent, or NULL */
+cairo_surface_t* title_cache_lookup(title_cache_t* cache, const title_key_t* key);
+
+/*
+ * Return a surface of at least width x height to render a missed run into,
+ * reused from the pool when one of the right size class is free.
+ * Returns NULL on allocation failure.
+ */
+cairo_surface_t* title_cache_acquire(title_cache_t* cache, int width, int height);
+
+/*
+ * Store surface (from title_cache_acquire, ownership passes to the cache)
+ * as the run for key, evicting the least recently used run when full.
+ * Returns the surface, borrowed.
+ */
+cairo_surface_t* title_cache_insert(title_cache_t* cache, const title_key_t* key, cairo_surface_t* surface);
+
+/* Pixel bytes held by cached runs and pooled surfaces */
+size_t title_cache_bytes(const title_cache_t* cache);
+
+/* Free every pooled surface; returns the bytes released */
+size_t title_cache_trim_pool(title_cache_t* cache);
+
+static inline size_t title_cache_size(const title_cache_t* cache) {
+  return cache->count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TITLE_CACHE_H */
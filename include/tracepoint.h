@@ -0,0 +1,133 @@
+/*
+ * tracepoint.h - Static tracepoints for ticks, cookies, manage and focus
+ *
+ * Always compiled in, independent of HXM_DIAG. Each tracepoint feeds two
+ * consumers:
+ * - A USDT probe in provider "hxm" when built against <sys/sdt.h>
+ *   (HXM_HAVE_SDT). Probes are a single nop until a tracer attaches:
+ *     bpftrace -e 'usdt:/usr/bin/hxm:hxm:tick_phase { @[arg0] = hist(arg2); }'
+ * - An in-process flight recorder, on when HXM_TRACEPOINTS names a file at
+ *   startup. The newest TP_RING_CAP records are kept and written to that
+ *   file as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev) on
+ *   --dump-stats and at shutdown.
+ *
+ * Probes and their USDT arguments:
+ *   tick_phase      phase (tick_phase_t), start_ns, dur_ns
+ *   cookie_push     sequence, cookie_type
+ *   cookie_dispatch sequence, cookie_type, enqueue_ns (CLOCK_MONOTONIC, so
+ *                   bpftrace's nsecs - arg2 is the reply latency)
+ *   manage_start    xid
+ *   manage_finish   xid
+ *   focus_commit    xid
+ *
+ * Threading:
+ * - Main thread only
+ */
+
+#ifndef TRACEPOINT_H
+#define TRACEPOINT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(HXM_HAVE_SDT) && HXM_HAVE_SDT
+#include <sys/sdt.h>
+#define TP_SDT1(name, a) DTRACE_PROBE1(hxm, name, a)
+#define TP_SDT2(name, a, b) DTRACE_PROBE2(hxm, name, a, b)
+#define TP_SDT3(name, a, b, c) DTRACE_PROBE3(hxm, name, a, b, c)
+#else
+#define TP_SDT1(name, a) ((void)0)
+#define TP_SDT2(name, a, b) ((void)0)
+#define TP_SDT3(name, a, b, c) ((void)0)
+#endif
+
+uint64_t monotonic_time_ns(void);
+
+#define TRACEPOINTS_ENV "HXM_TRACEPOINTS"
+
+#ifndef TP_RING_CAP
+#define TP_RING_CAP (1u << 16) /* records, power of two */
+#endif
+
+typedef enum tp_id {
+  TP_ID_TICK_PHASE = 1,
+  TP_ID_COOKIE_PUSH,
+  TP_ID_COOKIE_DISPATCH,
+  TP_ID_MANAGE_START,
+  TP_ID_MANAGE_FINISH,
+  TP_ID_FOCUS_COMMIT,
+} tp_id_t;
+
+typedef struct tp_record {
+  uint64_t t_ns;   /* monotonic; start for spans */
+  uint64_t dur_ns; /* spans only */
+  uint32_t a;
+  uint32_t b;
+  uint32_t id; /* tp_id_t */
+  uint32_t reserved;
+} tp_record_t;
+
+typedef struct tp_ring {
+  tp_record_t* recs;
+  uint64_t next; /* records ever written; the newest TP_RING_CAP survive */
+  char* path;
+} tp_ring_t;
+
+extern tp_ring_t tp_ring;
+
+static inline bool tp_recording(void) { return tp_ring.recs != NULL; }
+
+/* Start the recorder if HXM_TRACEPOINTS is set; true if recording */
+bool tp_open_from_env(void);
+void tp_close(void);
+
+void tp_record(tp_id_t id, uint64_t t_ns, uint64_t dur_ns, uint32_t a, uint32_t b);
+
+/* Write the recorder contents to path as Chrome trace-event JSON */
+bool tp_dump_json(const char* path);
+
+/* Same, to the HXM_TRACEPOINTS file; no-op when not recording */
+void tp_dump(void);
+
+#define TP_TICK_PHASE(phase, start_ns, dur_ns)                                        \
+  do {                                                                                \
+    TP_SDT3(tick_phase, (uint32_t)(phase), (uint64_t)(start_ns), (uint64_t)(dur_ns)); \
+    if (tp_recording())                                                               \
+      tp_record(TP_ID_TICK_PHASE, (start_ns), (dur_ns), (uint32_t)(phase), 0);        \
+  } while (0)
+
+#define TP_COOKIE_PUSH(seq, type)                                          \
+  do {                                                                     \
+    TP_SDT2(cookie_push, (uint32_t)(seq), (uint32_t)(type));               \
+    if (tp_recording())                                                    \
+      tp_record(TP_ID_COOKIE_PUSH, monotonic_time_ns(), 0, (seq), (type)); \
+  } while (0)
+
+#define TP_COOKIE_DISPATCH(seq, type, enqueue_ns)                                                        \
+  do {                                                                                                   \
+    TP_SDT3(cookie_dispatch, (uint32_t)(seq), (uint32_t)(type), (uint64_t)(enqueue_ns));                 \
+    if (tp_recording())                                                                                  \
+      tp_record(TP_ID_COOKIE_DISPATCH, (enqueue_ns), monotonic_time_ns() - (enqueue_ns), (seq), (type)); \
+  } while (0)
+
+#define TP_INSTANT(probe, id, xid)                                 \
+  do {                                                             \
+    TP_SDT1(probe, (uint32_t)(xid));                               \
+    if (tp_recording())                                            \
+      tp_record((id), monotonic_time_ns(), 0, (uint32_t)(xid), 0); \
+  } while (0)
+
+#define TP_MANAGE_START(xid) TP_INSTANT(manage_start, TP_ID_MANAGE_START, xid)
+#define TP_MANAGE_FINISH(xid) TP_INSTANT(manage_finish, TP_ID_MANAGE_FINISH, xid)
+#define TP_FOCUS_COMMIT(xid) TP_INSTANT(focus_commit, TP_ID_FOCUS_COMMIT, xid)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACEPOINT_H */
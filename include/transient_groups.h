@@ -0,0 +1,73 @@
+/*
+ * transient_groups.h - The transient forest flattened in pre-order
+ *
+ * Responsibilities:
+ * - Lay out every client that has a transient parent or child in one array,
+ *   depth first, children in manage order. A client's transient subtree is
+ *   then the contiguous run order[pos, pos + span[pos]), head first and
+ *   every dialog after the window it belongs to, so raising or lowering a
+ *   group walks an array instead of recursing through parent links
+ *
+ * Lifecycle:
+ * - Rebuilt lazily: transient_groups_invalidate marks the layout stale
+ *   whenever a transient_for link changes (client_set_transient_for), and
+ *   the next lookup rebuilds it in O(clients)
+ * - A zeroed transient_groups_t is valid, stale and empty
+ *
+ * Notes:
+ * - Clients with neither a transient parent nor transient children are not
+ *   stored; their group is just themselves
+ * - Links that form a cycle are left out, only acyclic groups are laid out
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef TRANSIENT_GROUPS_H
+#define TRANSIENT_GROUPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ds.h"
+#include "handle.h"
+
+typedef struct transient_groups {
+  handle_t* order; /* pre-order over the transient forest */
+  uint32_t* span;  /* order[i]'s subtree is order[i, i + span[i]) */
+  uint32_t len;
+  uint32_t cap;
+  epoch_map_t pos; /* handle -> index into order + 1 */
+  bool valid;
+  uint64_t rebuilds;
+} transient_groups_t;
+
+/* Parent of h, HANDLE_INVALID for none */
+typedef handle_t (*transient_parent_fn)(void* user, handle_t h);
+
+void transient_groups_destroy(transient_groups_t* g);
+
+static inline void transient_groups_invalidate(transient_groups_t* g) {
+  g->valid = false;
+}
+
+/* Lay out clients[0, n) from parent_of; parents outside clients are ignored */
+void transient_groups_build(transient_groups_t* g, const handle_t* clients, size_t n, transient_parent_fn parent_of, void* user);
+
+/*
+ * h and its transient descendants in pre-order, h first. Returns the count
+ * and points *out into the layout, valid until the next build; returns 0
+ * when h has none (h is not stored). The layout must be valid.
+ */
+size_t transient_groups_subtree(const transient_groups_t* g, handle_t h, const handle_t** out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRANSIENT_GROUPS_H */
@@ -31,6 +31,7 @@ extern "C" {
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <xcb/sync.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_keysyms.h>
 
@@ -41,6 +42,7 @@ extern "C" {
 #include "xcb_utils.h"
 
 typedef struct server server_t;
+typedef struct screen screen_t;
 typedef struct pending_config pending_config_t;
 
 /* WM ownership lifecycle */
@@ -48,10 +50,20 @@ void wm_become(server_t* s);
 void wm_release(server_t* s);
 
 /* EWMH/desktop properties */
-void wm_publish_desktop_props(server_t* s);
+void wm_publish_desktop_props(server_t* s, screen_t* scr);
+/* Free the shadows kept by wm_publish_root_prop */
+void wm_published_props_destroy(server_t* s);
 
-/* Compute current workarea in root coordinates */
-void wm_compute_workarea(server_t* s, rect_t* out);
+/* Compute the workarea of scr's current desktop in root coordinates */
+void wm_compute_workarea(server_t* s, screen_t* scr, rect_t* out);
+
+/*
+ * Per-(desktop, monitor) workareas are cached until struts, monitors, the
+ * desktop count or a strut client's desktop change. wm_client_strut_changed
+ * re-reads the client's effective strut into the strut client list.
+ */
+void wm_workarea_invalidate(screen_t* scr);
+void wm_client_strut_changed(server_t* s, handle_t h);
 void wm_get_monitor_geometry(server_t* s, client_hot_t* hot, rect_t* out_geom);
 
 /* Client state set for _NET_WM_STATE style updates */
@@ -80,6 +92,8 @@ void wm_cycle_focus(server_t* s, bool forward);
 
 /* Adopt existing children on startup (reparent/scan) */
 void wm_adopt_children(server_t* s);
+/* Complete a few deferred adoption probes, called once per tick */
+void wm_adopt_trickle(server_t* s);
 
 /* Place a newly-managed window per placement policy and rules */
 void wm_place_window(server_t* s, handle_t h);
@@ -90,6 +104,7 @@ void wm_handle_unmap_notify(server_t* s, xcb_unmap_notify_event_t* ev);
 void wm_handle_destroy_notify(server_t* s, xcb_destroy_notify_event_t* ev);
 
 void wm_handle_key_press(server_t* s, xcb_key_press_event_t* ev);
+void wm_handle_key_run(server_t* s, xcb_key_press_event_t* ev, uint32_t count, bool repeat);
 void wm_handle_key_release(server_t* s, xcb_key_release_event_t* ev);
 void wm_handle_button_press(server_t* s, xcb_button_press_event_t* ev);
 void wm_handle_button_release(server_t* s, xcb_button_release_event_t* ev);
@@ -99,23 +114,90 @@ void wm_handle_configure_request(server_t* s, handle_t h, pending_config_t* ev);
 void wm_handle_configure_notify(server_t* s, handle_t h, xcb_configure_notify_event_t* ev);
 void wm_handle_property_notify(server_t* s, handle_t h, xcb_property_notify_event_t* ev);
 void wm_handle_colormap_notify(server_t* s, xcb_colormap_notify_event_t* ev);
+void wm_handle_sync_alarm(server_t* s, const xcb_sync_alarm_notify_event_t* ev);
 
 /* Cancel current move/resize or other grab-based interaction */
 void wm_cancel_interaction(server_t* s);
 
-/* Workspace management */
-void wm_switch_workspace(server_t* s, uint32_t new_desktop);
-void wm_switch_workspace_relative(server_t* s, int delta);
+/* Workspace management, per screen */
+void wm_switch_workspace(server_t* s, screen_t* scr, uint32_t new_desktop);
+void wm_switch_workspace_relative(server_t* s, screen_t* scr, int delta);
 
 void wm_client_move_to_workspace(server_t* s, handle_t h, uint32_t desktop, bool follow);
+
+/* Record h as the most recently focused client on desktop (per-desktop MRU head) */
+void wm_desktop_focus_note(server_t* s, uint32_t desktop, handle_t h);
+
+/*
+ * Desktop membership index. wm_desktop_members rebuilds the index if needed
+ * and returns the clients of scr on desktop (NULL if out of range);
+ * wm_desktop_members_sync moves h to the list its desktop/sticky state
+ * calls for. wm_desktop_members_ensure returns whether the index was already
+ * valid (false means it was just rebuilt from active_clients).
+ */
+void wm_desktop_members_invalidate(server_t* s);
+void wm_desktop_members_destroy(server_t* s);
+bool wm_desktop_members_ensure(server_t* s);
+handle_vec_t* wm_desktop_members(server_t* s, screen_t* scr, uint32_t desktop);
+void wm_desktop_members_sync(server_t* s, handle_t h);
+void wm_desktop_members_remove(server_t* s, handle_t h);
+/* Have the next visibility pass re-check h even if its desktop is not shown */
+void wm_desktop_members_touch(server_t* s, handle_t h);
+
+/* Hit-testing over committed frame rects of clients visible on scr's current desktop */
+handle_t wm_client_at_point(server_t* s, screen_t* scr, int root_x, int root_y);
+size_t wm_clients_in_rect(server_t* s, screen_t* scr, rect_t r, handle_vec_t* out);
 void wm_client_toggle_sticky(server_t* s, handle_t h);
 void wm_client_toggle_maximize(server_t* s, handle_t h);
 void wm_client_iconify(server_t* s, handle_t h);
 void wm_client_restore(server_t* s, handle_t h);
+/* The same for many clients in one batch; hs is bottom-to-top stacking order */
+void wm_clients_iconify_batch(server_t* s, const handle_t* hs, size_t n);
+void wm_clients_restore_batch(server_t* s, const handle_t* hs, size_t n);
+/* freeze rule: stop hot's app once no window of it is shown; call after hiding its frame */
+void wm_client_freeze_hidden(server_t* s, client_hot_t* hot);
+/* Resume hot's app if it is frozen; call before mapping its frame */
+void wm_client_thaw(server_t* s, client_hot_t* hot);
+
+/*
+ * Tiling (src/wm_tiling.c). flush re-files queued clients and turns changed
+ * tiles into desired geometry, before the per-client commits; remove must
+ * follow a client out of the slotmap; refresh puts a tiled client back after
+ * it asked to move or resize itself.
+ */
+void wm_tiling_flush(server_t* s);
+void wm_tiling_remove(server_t* s, handle_t h);
+void wm_tiling_refresh(server_t* s, handle_t h);
+void wm_tiling_reload(server_t* s);
+void wm_tiling_destroy(server_t* s);
+void wm_tiling_cycle_layout(server_t* s);
+void wm_tiling_float(server_t* s, handle_t h, bool floating);
+void wm_tiling_resize(server_t* s, handle_t h, bool grow);
+
+/*
+ * _NET_WM_PING (src/wm_ping.c). client pings h now, unless a ping is already
+ * out; reply takes the answer found on the root window; reload re-arms the
+ * periodic round after a config change.
+ */
+void wm_ping_client(server_t* s, handle_t h);
+void wm_ping_reply(server_t* s, xcb_window_t win);
+void wm_ping_reload(server_t* s);
 
 /* Focus implementation (src/focus.c) */
 void wm_set_focus(server_t* s, handle_t h);
 
+/*
+ * Focus history (s->focus_mru). insert links or moves h after slot `after`
+ * (0 = most recent); update re-reads the cached desktop/state/type bits and
+ * must follow any change to them on a client already in the history. pick
+ * returns the most recent client of scr on desktop (or sticky) with all of
+ * need.
+ */
+void wm_focus_history_insert(server_t* s, handle_t h, uint32_t after);
+void wm_focus_history_remove(server_t* s, handle_t h);
+void wm_focus_history_update(server_t* s, handle_t h);
+handle_t wm_focus_history_pick(server_t* s, const screen_t* scr, int32_t desktop, uint32_t need);
+
 /* Alt-tab switcher */
 void wm_switcher_start(server_t* s, int dir);
 void wm_switcher_step(server_t* s, int dir);
@@ -133,8 +215,8 @@ bool stack_can_anchor_to_sibling(server_t* s, handle_t h, handle_t sibling_h);
 /* Move client to its configured layer (based on state/rules) */
 void stack_move_to_layer(server_t* s, handle_t h);
 
-/* Sync stacking changes to X11 for a client */
-void stack_sync_to_xcb(server_t* s, handle_t h);
+/* Commit DIRTY_STACK changes to X11 as a minimal set of restacks */
+void stack_commit_to_xcb(server_t* s);
 
 /* Dirty flush:
  * Returns true if more work remains or if flush did work
@@ -142,9 +224,32 @@ void stack_sync_to_xcb(server_t* s, handle_t h);
  */
 bool wm_flush_dirty(server_t* s, uint64_t now);
 
+/*
+ * Early commit for the input lane: keyboard and pointer drag steps, the
+ * dragged client's geometry, frame and synthetic ConfigureNotify, and a
+ * focus change. Everything else, including stacking, waits for
+ * wm_flush_dirty. Returns true if requests were queued.
+ */
+bool wm_flush_input(server_t* s, uint64_t now);
+
+/*
+ * Drag mode: a move/resize is active and the last full wm_flush_dirty is
+ * less than config.interactive_defer_ms old. wm_flush_dirty then commits
+ * only input, the dragged client and the snap preview, and the bulk lane
+ * defers other clients' PropertyNotify; the rest lands on release or when
+ * the bound runs out.
+ */
+bool wm_interaction_qos(const server_t* s, uint64_t now);
+
+/* Milliseconds until a client held by manage_defer_ms is due, -1 if none */
+int wm_manage_defer_timeout_ms(server_t* s, uint64_t now);
+
 /* Async reply dispatch from cookie_jar */
 void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err);
 
+/* Manage probe group completion: every phase 1 reply has been applied */
+void wm_handle_manage_complete(server_t* s, uint64_t txn_id, handle_t h);
+
 /* State/metadata updates */
 void wm_client_update_state(server_t* s, handle_t h, uint32_t action, xcb_atom_t prop);
 bool wm_send_synthetic_configure(server_t* s, handle_t h);
@@ -0,0 +1,117 @@
+/*
+ * x_reader.h - Optional X input thread
+ *
+ * Responsibilities:
+ * - Own reads of the X socket on a helper thread, so an input burst is
+ *   pulled off the wire while the main thread is still rendering or
+ *   flushing the previous tick
+ * - Do the cheap, model-free part of ingestion there: classify each event
+ *   and fold adjacent runs the tick buckets would fold anyway (motion and
+ *   ConfigureNotify for one window keep the last, PropertyNotify for one
+ *   window and atom keeps the first)
+ * - Hand the survivors to the main thread in order through a single
+ *   producer, single consumer ring and wake it through notify_fd
+ *
+ * Ownership:
+ * - Ring entries are libxcb events; the consumer owns what it pops
+ * - Everything that reads or mutates server_t stays on the main thread:
+ *   XI2 rewriting, tracing, staging and coalescing into the buckets
+ *
+ * Notes:
+ * - Replies the reader pulls off the socket land in libxcb's reply queue,
+ *   so it signals notify_fd for any socket traffic, not only for events
+ * - Reply waits on the main thread can move events into libxcb's queue
+ *   without the socket looking readable to the reader; the main thread
+ *   calls x_reader_kick after each tick so they are picked up
+ * - When the ring is full the reader stops reading and libxcb buffers
+ * - Events already read when the reader stops stay poppable in order, so
+ *   switching back to main thread reads loses nothing
+ * - A zeroed x_reader_t is valid and not running
+ *
+ * Threading:
+ * - x_reader_start/stop/destroy/pop/kick/take_notify are main thread only
+ */
+
+#ifndef X_READER_H
+#define X_READER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#define X_READER_RING_CAP 4096u /* power of two */
+#define X_READER_BATCH 256u
+
+typedef enum {
+  X_READER_CLASS_MOTION = 0,
+  X_READER_CLASS_CONFIGURE,
+  X_READER_CLASS_PROPERTY,
+  X_READER_CLASS_OTHER,
+  X_READER_CLASS_COUNT
+} x_reader_class_t;
+
+typedef struct x_reader {
+  pthread_t thread;
+  xcb_connection_t* conn;
+  bool running;
+  int xcb_fd;
+  int notify_fd; /* eventfd, reader -> main: events or replies arrived */
+  int kick_fd;   /* eventfd, main -> reader: recheck libxcb's queue, or stop */
+  atomic_bool stop;
+
+  xcb_generic_event_t** ring;
+  _Atomic uint32_t head; /* next slot the reader fills */
+  _Atomic uint32_t tail; /* next slot the main thread pops */
+
+  /* Reader only while running; main thread only after stop */
+  xcb_generic_event_t* batch[X_READER_BATCH];
+  uint32_t batch_len;
+  uint32_t batch_pos; /* first entry not yet published */
+
+  _Atomic uint64_t seen[X_READER_CLASS_COUNT];
+  _Atomic uint64_t folded[X_READER_CLASS_COUNT];
+  _Atomic uint64_t wakeups;
+  _Atomic uint64_t ring_full; /* batches held back for lack of space */
+} x_reader_t;
+
+/* Start reading conn. Returns false (and stays stopped) on failure */
+bool x_reader_start(x_reader_t* r, xcb_connection_t* conn);
+
+/* Join the thread; events it already read stay poppable (no-op if stopped) */
+void x_reader_stop(x_reader_t* r);
+
+/* Stop and free every event not popped yet */
+void x_reader_destroy(x_reader_t* r);
+
+/* Next event in arrival order, NULL when none is waiting */
+xcb_generic_event_t* x_reader_pop(x_reader_t* r);
+
+/* Whether x_reader_pop would return an event */
+bool x_reader_pending(const x_reader_t* r);
+
+/* Whether the reader is running or still holds events */
+static inline bool x_reader_active(const x_reader_t* r) {
+  return r->running || x_reader_pending(r);
+}
+
+void x_reader_kick(x_reader_t* r);
+
+/* Consume a notify_fd wakeup */
+void x_reader_take_notify(x_reader_t* r);
+
+/* Append the report; returns bytes written, excluding the NUL */
+size_t x_reader_format(const x_reader_t* r, char* buf, size_t cap);
+void x_reader_dump(const x_reader_t* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* X_READER_H */
@@ -33,119 +33,133 @@ extern "C" {
 #include <xcb/xcb.h>
 #include <xcb/xkb.h>
 
+/*
+ * Every atom the WM may touch, in interning order. Expands into struct atoms
+ * and the name table; add an atom here and nowhere else.
+ */
+#define HXM_ATOMS(X)                    \
+  X(WM_PROTOCOLS)                       \
+  X(WM_DELETE_WINDOW)                   \
+  X(WM_TAKE_FOCUS)                      \
+  X(_NET_WM_PING)                       \
+  X(WM_STATE)                           \
+  X(WM_CLASS)                           \
+  X(WM_CLIENT_MACHINE)                  \
+  X(WM_COLORMAP_WINDOWS)                \
+  X(WM_COMMAND)                         \
+  X(WM_NAME)                            \
+  X(WM_ICON_NAME)                       \
+  X(WM_HINTS)                           \
+  X(WM_NORMAL_HINTS)                    \
+  X(WM_TRANSIENT_FOR)                   \
+  X(WM_CHANGE_STATE)                    \
+  X(_MOTIF_WM_HINTS)                    \
+  X(_GTK_FRAME_EXTENTS)                 \
+  X(_KDE_NET_WM_FRAME_STRUT)            \
+  X(_NET_WM_SYNC_REQUEST)               \
+  X(_NET_SUPPORTED)                     \
+  X(_NET_CLIENT_LIST)                   \
+  X(_NET_CLIENT_LIST_STACKING)          \
+  X(_NET_ACTIVE_WINDOW)                 \
+  X(_NET_WM_NAME)                       \
+  X(_NET_WM_VISIBLE_NAME)               \
+  X(_NET_WM_ICON_NAME)                  \
+  X(_NET_WM_VISIBLE_ICON_NAME)          \
+  X(_NET_WM_STATE)                      \
+  X(_NET_WM_WINDOW_TYPE)                \
+  X(_NET_WM_STRUT)                      \
+  X(_NET_WM_STRUT_PARTIAL)              \
+  X(_NET_WORKAREA)                      \
+  X(_NET_WM_PID)                        \
+  X(_NET_WM_USER_TIME)                  \
+  X(_NET_WM_USER_TIME_WINDOW)           \
+  X(_NET_WM_SYNC_REQUEST_COUNTER)       \
+  X(_NET_WM_ICON_GEOMETRY)              \
+  X(_NET_WM_STATE_FULLSCREEN)           \
+  X(_NET_WM_STATE_ABOVE)                \
+  X(_NET_WM_STATE_BELOW)                \
+  X(_NET_WM_STATE_STICKY)               \
+  X(_NET_WM_STATE_DEMANDS_ATTENTION)    \
+  X(_NET_WM_STATE_HIDDEN)               \
+  X(_NET_WM_STATE_MAXIMIZED_HORZ)       \
+  X(_NET_WM_STATE_MAXIMIZED_VERT)       \
+  X(_NET_WM_STATE_FOCUSED)              \
+  X(_NET_WM_STATE_MODAL)                \
+  X(_NET_WM_STATE_SHADED)               \
+  X(_NET_WM_STATE_SKIP_TASKBAR)         \
+  X(_NET_WM_STATE_SKIP_PAGER)           \
+  X(_NET_WM_WINDOW_TYPE_DOCK)           \
+  X(_NET_WM_WINDOW_TYPE_DIALOG)         \
+  X(_NET_WM_WINDOW_TYPE_NOTIFICATION)   \
+  X(_NET_WM_WINDOW_TYPE_NORMAL)         \
+  X(_NET_WM_WINDOW_TYPE_DESKTOP)        \
+  X(_NET_WM_WINDOW_TYPE_SPLASH)         \
+  X(_NET_WM_WINDOW_TYPE_TOOLBAR)        \
+  X(_NET_WM_WINDOW_TYPE_UTILITY)        \
+  X(_NET_WM_WINDOW_TYPE_MENU)           \
+  X(_NET_WM_WINDOW_TYPE_DROPDOWN_MENU)  \
+  X(_NET_WM_WINDOW_TYPE_POPUP_MENU)     \
+  X(_NET_WM_WINDOW_TYPE_TOOLTIP)        \
+  X(_NET_WM_WINDOW_TYPE_COMBO)          \
+  X(_NET_WM_WINDOW_TYPE_DND)            \
+  X(_NET_SUPPORTING_WM_CHECK)           \
+  X(_NET_DESKTOP_VIEWPORT)              \
+  X(_NET_NUMBER_OF_DESKTOPS)            \
+  X(_NET_CURRENT_DESKTOP)               \
+  X(_NET_VIRTUAL_ROOTS)                 \
+  X(_NET_DESKTOP_NAMES)                 \
+  X(_NET_WM_DESKTOP)                    \
+  X(_NET_WM_ICON)                       \
+  X(_NET_CLOSE_WINDOW)                  \
+  X(_NET_DESKTOP_GEOMETRY)              \
+  X(_NET_FRAME_EXTENTS)                 \
+  X(_NET_REQUEST_FRAME_EXTENTS)         \
+  X(_NET_SHOWING_DESKTOP)               \
+  X(_NET_WM_WINDOW_OPACITY)             \
+  X(_NET_WM_ALLOWED_ACTIONS)            \
+  X(_NET_WM_ACTION_MOVE)                \
+  X(_NET_WM_ACTION_RESIZE)              \
+  X(_NET_WM_ACTION_MINIMIZE)            \
+  X(_NET_WM_ACTION_SHADE)               \
+  X(_NET_WM_ACTION_STICK)               \
+  X(_NET_WM_ACTION_MAXIMIZE_HORZ)       \
+  X(_NET_WM_ACTION_MAXIMIZE_VERT)       \
+  X(_NET_WM_ACTION_FULLSCREEN)          \
+  X(_NET_WM_ACTION_CHANGE_DESKTOP)      \
+  X(_NET_WM_ACTION_CLOSE)               \
+  X(_NET_WM_ACTION_ABOVE)               \
+  X(_NET_WM_ACTION_BELOW)               \
+  X(_NET_WM_MOVERESIZE)                 \
+  X(_NET_MOVERESIZE_WINDOW)             \
+  X(_NET_RESTACK_WINDOW)                \
+  X(_NET_WM_FULLSCREEN_MONITORS)        \
+  X(_NET_WM_FULL_PLACEMENT)             \
+  X(UTF8_STRING)                        \
+  X(COMPOUND_TEXT)                      \
+  X(WM_S0)                              \
+  X(_NET_WM_CM_S0)                      \
+  X(_XROOTPMAP_ID)                      \
+  X(_NET_WM_BYPASS_COMPOSITOR)          \
+  X(_HXM_TICK_STATS)                    \
+  X(_HXM_FRAME_POOL)
+
 /* Atoms cache - all atoms the WM may touch */
 struct atoms {
-  xcb_atom_t WM_PROTOCOLS;
-  xcb_atom_t WM_DELETE_WINDOW;
-  xcb_atom_t WM_TAKE_FOCUS;
-  xcb_atom_t _NET_WM_PING;
-  xcb_atom_t WM_STATE;
-  xcb_atom_t WM_CLASS;
-  xcb_atom_t WM_CLIENT_MACHINE;
-  xcb_atom_t WM_COLORMAP_WINDOWS;
-  xcb_atom_t WM_COMMAND;
-  xcb_atom_t WM_NAME;
-  xcb_atom_t WM_ICON_NAME;
-  xcb_atom_t WM_HINTS;
-  xcb_atom_t WM_NORMAL_HINTS;
-  xcb_atom_t WM_TRANSIENT_FOR;
-  xcb_atom_t WM_CHANGE_STATE;
-  xcb_atom_t _MOTIF_WM_HINTS;
-  xcb_atom_t _GTK_FRAME_EXTENTS;
-  xcb_atom_t _KDE_NET_WM_FRAME_STRUT;
-  xcb_atom_t _NET_WM_SYNC_REQUEST;
-
-  xcb_atom_t _NET_SUPPORTED;
-  xcb_atom_t _NET_CLIENT_LIST;
-  xcb_atom_t _NET_CLIENT_LIST_STACKING;
-  xcb_atom_t _NET_ACTIVE_WINDOW;
-
-  xcb_atom_t _NET_WM_NAME;
-  xcb_atom_t _NET_WM_VISIBLE_NAME;
-  xcb_atom_t _NET_WM_ICON_NAME;
-  xcb_atom_t _NET_WM_VISIBLE_ICON_NAME;
-  xcb_atom_t _NET_WM_STATE;
-  xcb_atom_t _NET_WM_WINDOW_TYPE;
-  xcb_atom_t _NET_WM_STRUT;
-  xcb_atom_t _NET_WM_STRUT_PARTIAL;
-  xcb_atom_t _NET_WORKAREA;
-  xcb_atom_t _NET_WM_PID;
-
-  xcb_atom_t _NET_WM_USER_TIME;
-  xcb_atom_t _NET_WM_USER_TIME_WINDOW;
-  xcb_atom_t _NET_WM_SYNC_REQUEST_COUNTER;
-  xcb_atom_t _NET_WM_ICON_GEOMETRY;
-
-  xcb_atom_t _NET_WM_STATE_FULLSCREEN;
-  xcb_atom_t _NET_WM_STATE_ABOVE;
-  xcb_atom_t _NET_WM_STATE_BELOW;
-  xcb_atom_t _NET_WM_STATE_STICKY;
-  xcb_atom_t _NET_WM_STATE_DEMANDS_ATTENTION;
-  xcb_atom_t _NET_WM_STATE_HIDDEN;
-  xcb_atom_t _NET_WM_STATE_MAXIMIZED_HORZ;
-  xcb_atom_t _NET_WM_STATE_MAXIMIZED_VERT;
-  xcb_atom_t _NET_WM_STATE_FOCUSED;
-  xcb_atom_t _NET_WM_STATE_MODAL;
-  xcb_atom_t _NET_WM_STATE_SHADED;
-  xcb_atom_t _NET_WM_STATE_SKIP_TASKBAR;
-  xcb_atom_t _NET_WM_STATE_SKIP_PAGER;
-
-  xcb_atom_t _NET_WM_WINDOW_TYPE_DOCK;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_DIALOG;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_NOTIFICATION;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_NORMAL;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_DESKTOP;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_SPLASH;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_TOOLBAR;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_UTILITY;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_MENU;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_DROPDOWN_MENU;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_POPUP_MENU;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_TOOLTIP;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_COMBO;
-  xcb_atom_t _NET_WM_WINDOW_TYPE_DND;
-
-  xcb_atom_t _NET_SUPPORTING_WM_CHECK;
-  xcb_atom_t _NET_DESKTOP_VIEWPORT;
-  xcb_atom_t _NET_NUMBER_OF_DESKTOPS;
-  xcb_atom_t _NET_CURRENT_DESKTOP;
-  xcb_atom_t _NET_VIRTUAL_ROOTS;
-  xcb_atom_t _NET_DESKTOP_NAMES;
-  xcb_atom_t _NET_WM_DESKTOP;
-
-  xcb_atom_t _NET_WM_ICON;
-  xcb_atom_t _NET_CLOSE_WINDOW;
-  xcb_atom_t _NET_DESKTOP_GEOMETRY;
-  xcb_atom_t _NET_FRAME_EXTENTS;
-  xcb_atom_t _NET_REQUEST_FRAME_EXTENTS;
-  xcb_atom_t _NET_SHOWING_DESKTOP;
-  xcb_atom_t _NET_WM_WINDOW_OPACITY;
-
-  xcb_atom_t _NET_WM_ALLOWED_ACTIONS;
-  xcb_atom_t _NET_WM_ACTION_MOVE;
-  xcb_atom_t _NET_WM_ACTION_RESIZE;
-  xcb_atom_t _NET_WM_ACTION_MINIMIZE;
-  xcb_atom_t _NET_WM_ACTION_SHADE;
-  xcb_atom_t _NET_WM_ACTION_STICK;
-  xcb_atom_t _NET_WM_ACTION_MAXIMIZE_HORZ;
-  xcb_atom_t _NET_WM_ACTION_MAXIMIZE_VERT;
-  xcb_atom_t _NET_WM_ACTION_FULLSCREEN;
-  xcb_atom_t _NET_WM_ACTION_CHANGE_DESKTOP;
-  xcb_atom_t _NET_WM_ACTION_CLOSE;
-  xcb_atom_t _NET_WM_ACTION_ABOVE;
-  xcb_atom_t _NET_WM_ACTION_BELOW;
-  xcb_atom_t _NET_WM_MOVERESIZE;
-  xcb_atom_t _NET_MOVERESIZE_WINDOW;
-  xcb_atom_t _NET_RESTACK_WINDOW;
-  xcb_atom_t _NET_WM_FULLSCREEN_MONITORS;
-  xcb_atom_t _NET_WM_FULL_PLACEMENT;
-
-  xcb_atom_t UTF8_STRING;
-  xcb_atom_t COMPOUND_TEXT;
-  xcb_atom_t WM_S0;
-  xcb_atom_t _NET_WM_BYPASS_COMPOSITOR;
+#define HXM_ATOM_FIELD(name) xcb_atom_t name;
+  HXM_ATOMS(HXM_ATOM_FIELD)
+#undef HXM_ATOM_FIELD
 };
 
+#define HXM_ATOM_COUNT (sizeof(struct atoms) / sizeof(xcb_atom_t))
+
+/* Position of each atom in struct atoms, for tables indexed by atom */
+typedef enum atom_id {
+#define HXM_ATOM_ID(name) ATOM_ID_##name,
+  HXM_ATOMS(HXM_ATOM_ID)
+#undef HXM_ATOM_ID
+  ATOM_ID_COUNT
+} atom_id_t;
+
 extern struct atoms atoms;
 
 /* Return a stable human-readable name for an atom
@@ -153,13 +167,23 @@ extern struct atoms atoms;
  */
 const char* atom_name(xcb_atom_t atom);
 
+/* atom_id_t of an interned atom, -1 for atoms outside struct atoms
+ * O(1) through the perfect hash built by atoms_init; rebuilt on a miss if
+ * atoms.* were reassigned since (tests)
+ */
+int atom_id(xcb_atom_t atom);
+
 /* Connect to the X server
  * Wrapper so call sites can centralize error handling and preferred setup
+ * screen_out (optional) receives the screen DISPLAY names, 0 when it names none
  * Returns NULL on failure
  */
-xcb_connection_t* xcb_connect_cached(void);
+xcb_connection_t* xcb_connect_cached(int* screen_out);
+
+/* Screen screen_num of the connection, the first one when out of range */
+xcb_screen_t* xcb_screen_of(xcb_connection_t* conn, int screen_num);
 
-/* Intern all atoms into the global cache
+/* Intern all atoms into the global cache in one round trip
  * Must be called exactly once per connection lifecycle before using atoms.*
  */
 void atoms_init(xcb_connection_t* conn);
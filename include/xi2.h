@@ -0,0 +1,51 @@
+/*
+ * xi2.h - XInput 2 pointer grabs for interactive move and resize
+ *
+ * Responsibilities:
+ * - Grab the master pointer with an XI2 device grab selecting XI_Motion and
+ *   XI_ButtonRelease, as an alternative to the core pointer grab
+ * - Rewrite those events in place into core MotionNotify/ButtonRelease
+ *   layout before staging, so the ingest ring, motion coalescing and
+ *   wm_handle_motion_notify stay on one path
+ *
+ * XI2 positions are 16.16 fixed point; they are rounded to the nearest
+ * pixel instead of truncated as core events are. A core UngrabPointer also
+ * releases an XI2 grab held by this client, so ungrab sites need no change.
+ *
+ * Threading:
+ * - Not thread-safe, main thread only
+ */
+
+#ifndef XI2_H
+#define XI2_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "event.h"
+
+/* True when config asks for XI2 drags and the server has XInput >= 2.0 */
+bool xi2_enabled(const server_t* s);
+
+/* Start an async XI2 grab of the client pointer on root; returns the request sequence, 0 on failure */
+unsigned int xi2_grab_pointer(server_t* s, xcb_window_t root, xcb_cursor_t cursor, uint32_t time);
+
+/* Grab status from the reply to xi2_grab_pointer */
+uint8_t xi2_grab_status(const void* reply);
+
+/*
+ * Rewrite an XI_Motion or XI_ButtonRelease GenericEvent in place as the
+ * matching 32-byte core event. Returns false and leaves ev alone otherwise.
+ */
+bool xi2_event_to_core(const server_t* s, xcb_generic_event_t* ev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XI2_H */
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Compare a bench_ds run with the checked-in limits.
+
+Two limits apply to every result, each taken from the first pattern (fnmatch
+on the benchmark name, in file order) that matches:
+
+- max_ns_per_op: absolute cost per operation. Only meaningful for optimized,
+  uninstrumented builds, so it is skipped for runs that report
+  build.instrumented and with --relative-only.
+- max_growth: ns_per_op at the largest n over the cheapest n of the same
+  benchmark, dist and load. This catches an operation going from O(1) to
+  O(n) and holds under sanitizers too.
+
+A benchmark no pattern covers is an error, so new benchmarks come with limits.
+"""
+
+from __future__ import annotations
+
+import argparse
+import fnmatch
+import json
+import pathlib
+import sys
+
+DEFAULT_THRESHOLDS = pathlib.Path(__file__).with_name("bench_ds_thresholds.json")
+
+
+def limit_for(table: dict[str, float], name: str) -> float | None:
+    for pattern, limit in table.items():
+        if fnmatch.fnmatchcase(name, pattern):
+            return float(limit)
+    return None
+
+
+def group_key(result: dict) -> tuple:
+    return (result["name"], result.get("dist"), result.get("load"))
+
+
+def check(results: list[dict], thresholds: dict, absolute: bool) -> list[str]:
+    errors: list[str] = []
+    ns_limits = thresholds.get("max_ns_per_op", {})
+    growth_limits = thresholds.get("max_growth", {})
+
+    groups: dict[tuple, list[dict]] = {}
+    for result in results:
+        groups.setdefault(group_key(result), []).append(result)
+
+    for key, members in groups.items():
+        name, dist, load = key
+        label = name if dist is None else f"{name} dist={dist} load={load}"
+
+        ns_limit = limit_for(ns_limits, name)
+        growth_limit = limit_for(growth_limits, name)
+        if ns_limit is None or growth_limit is None:
+            errors.append(f"{label}: no threshold covers this benchmark")
+            continue
+
+        if absolute:
+            for r in members:
+                if r["ns_per_op"] > ns_limit:
+                    errors.append(f"{label} n={r['n']}: {r['ns_per_op']:.2f} ns/op > {ns_limit:g}")
+
+        largest = max(members, key=lambda r: r["n"])
+        cheapest = min(r["ns_per_op"] for r in members)
+        if cheapest > 0 and largest["ns_per_op"] / cheapest > growth_limit:
+            errors.append(
+                f"{label}: n={largest['n']} costs {largest['ns_per_op'] / cheapest:.1f}x the cheapest size > {growth_limit:g}x"
+            )
+    return errors
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Check bench_ds results against thresholds.")
+    parser.add_argument("results", help="bench_ds JSON output, or - for stdin")
+    parser.add_argument("--thresholds", default=str(DEFAULT_THRESHOLDS), help="thresholds JSON")
+    parser.add_argument("--relative-only", action="store_true", help="skip max_ns_per_op")
+    args = parser.parse_args()
+
+    try:
+        raw = sys.stdin.read() if args.results == "-" else pathlib.Path(args.results).read_text(encoding="utf-8")
+        run = json.loads(raw)
+        thresholds = json.loads(pathlib.Path(args.thresholds).read_text(encoding="utf-8"))
+    except (OSError, ValueError) as exc:
+        print(f"error: {exc}", file=sys.stderr)
+        return 2
+
+    results = run.get("results")
+    if run.get("schema") != 1 or thresholds.get("schema") != 1 or not isinstance(results, list) or not results:
+        print("error: unexpected bench_ds or thresholds schema", file=sys.stderr)
+        return 2
+
+    absolute = not args.relative_only and not run.get("build", {}).get("instrumented", False)
+    errors = check(results, thresholds, absolute)
+    if errors:
+        print("error: bench_ds regressions:", file=sys.stderr)
+        for line in errors:
+            print(f"  - {line}", file=sys.stderr)
+        return 1
+
+    mode = "absolute and growth" if absolute else "growth only"
+    print(f"bench_ds: {len(results)} results within thresholds ({mode})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
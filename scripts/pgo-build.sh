@@ -0,0 +1,265 @@
+#!/usr/bin/env bash
+# Profile-guided release build of hxm.
+#
+# 1. Configure OUT/pgo as a release LTO build with -Db_pgo=generate and
+#    -Dpgo_training=true, which adds perf_pipeline and load_client.
+# 2. Train: every perf_harness and perf_pipeline scenario, a replay of each
+#    --trace (recorded with HXM_EVENT_TRACE), and the instrumented hxm on a
+#    private Xvfb under the stress-test.py mixes.
+# 3. Merge the profile and rebuild OUT/pgo with -Db_pgo=use.
+# 4. Build OUT/baseline with the same options minus PGO and compare the two
+#    with scripts/pgo-compare.py.
+#
+# clang writes one .profraw per process, merged with llvm-profdata. GCC
+# writes a .gcda per object, so hxm.p/src_wm.c.gcda only counts what hxm
+# itself ran; each source's counters are summed across hxm, perf_pipeline
+# and perf_harness with gcov-tool and given to every target that compiles
+# it, so the harnesses train hxm's code and are measured with its profile.
+set -euo pipefail
+
+script_dir=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+repo_root=$(cd "$script_dir/.." && pwd)
+
+out_dir=${PGO_OUT_DIR:-$repo_root/build-pgo}
+llvm_profdata=${LLVM_PROFDATA:-llvm-profdata}
+gcov_tool=${GCOV_TOOL:-gcov-tool}
+
+traces=()
+harness_iters=20000
+pipeline_iters=500
+load_duration=5
+use_xvfb=1
+compare=1
+compare_runs=5
+
+die_usage() {
+  cat >&2 <<USAGE
+usage: $0 [--out DIR] [--trace FILE]... [--harness-iters N] [--pipeline-iters N] [--load-duration S] [--no-xvfb] [--no-compare] [--compare-runs N]
+USAGE
+  exit 2
+}
+
+while [[ $# -gt 0 ]]; do
+  case "$1" in
+    --out)
+      [[ $# -ge 2 ]] || die_usage
+      out_dir=$2
+      shift 2
+      ;;
+    --trace)
+      [[ $# -ge 2 ]] || die_usage
+      traces+=("$(cd "$(dirname "$2")" && pwd)/$(basename "$2")")
+      shift 2
+      ;;
+    --harness-iters)
+      [[ $# -ge 2 ]] || die_usage
+      harness_iters=$2
+      shift 2
+      ;;
+    --pipeline-iters)
+      [[ $# -ge 2 ]] || die_usage
+      pipeline_iters=$2
+      shift 2
+      ;;
+    --load-duration)
+      [[ $# -ge 2 ]] || die_usage
+      load_duration=$2
+      shift 2
+      ;;
+    --no-xvfb)
+      use_xvfb=0
+      shift
+      ;;
+    --no-compare)
+      compare=0
+      shift
+      ;;
+    --compare-runs)
+      [[ $# -ge 2 ]] || die_usage
+      compare_runs=$2
+      shift 2
+      ;;
+    *)
+      die_usage
+      ;;
+  esac
+done
+
+pgo_dir=$out_dir/pgo
+baseline_dir=$out_dir/baseline
+raw_dir=$out_dir/profraw
+train_log=$out_dir/train.log
+common_opts=(-Dbuildtype=release -Db_lto=true -Dpgo_training=true)
+targets=(hxm perf_harness perf_pipeline load_client)
+trained=(hxm perf_pipeline perf_harness)
+
+configure() {
+  local dir=$1
+  shift
+  if [[ -d "$dir/meson-private" ]]; then
+    meson configure "$dir" "$@"
+  else
+    meson setup "$dir" "$repo_root" "$@"
+  fi
+}
+
+compiler_id() {
+  meson introspect --compilers "$1" | python3 -c 'import json, sys; print(json.load(sys.stdin)["host"]["c"]["id"])'
+}
+
+start_xvfb() {
+  for i in $(seq 98 140); do
+    local disp=":$i"
+    Xvfb "$disp" -screen 0 1920x1080x24 +extension RANDR >/dev/null 2>&1 &
+    XVFB_PID=$!
+
+    local alive=1
+    for _ in $(seq 1 40); do
+      if ! kill -0 "$XVFB_PID" 2>/dev/null; then
+        alive=0
+        break
+      fi
+      sleep 0.05
+    done
+
+    if [[ "$alive" -eq 1 ]]; then
+      export DISPLAY="$disp"
+      return 0
+    fi
+    wait "$XVFB_PID" 2>/dev/null || true
+    unset XVFB_PID
+  done
+  return 1
+}
+
+stop_training_x() {
+  # hxm exits cleanly on SIGTERM, which is when its profile is written
+  if [[ -n "${HXM_PID:-}" ]] && kill -0 "$HXM_PID" 2>/dev/null; then
+    kill -TERM "$HXM_PID"
+    wait "$HXM_PID" || true
+  fi
+  unset HXM_PID
+  if [[ -n "${XVFB_PID:-}" ]] && kill -0 "$XVFB_PID" 2>/dev/null; then
+    kill "$XVFB_PID"
+    wait "$XVFB_PID" || true
+  fi
+  unset XVFB_PID
+  if [[ -n "${train_home:-}" ]]; then
+    rm -rf "$train_home"
+  fi
+  unset train_home
+}
+trap stop_training_x EXIT
+
+train_xvfb() {
+  if [[ "$use_xvfb" -eq 0 ]]; then
+    return 0
+  fi
+  if ! command -v Xvfb >/dev/null 2>&1 || ! start_xvfb; then
+    echo "Xvfb unavailable: training without hxm load runs" >&2
+    return 0
+  fi
+
+  train_home=$(mktemp -d)
+  mkdir -p "$train_home/.config/hxm"
+  HOME="$train_home" XDG_CONFIG_HOME="$train_home/.config" HXM_CONTROL_SOCKET="$train_home/hxm-control.sock" \
+    "$pgo_dir/hxm" >>"$train_log" 2>&1 &
+  HXM_PID=$!
+  sleep 2
+
+  local mix
+  for mix in ci-browser chat storm; do
+    echo "training: hxm under the $mix mix"
+    HOME="$train_home" HXM_CONTROL_SOCKET="$train_home/hxm-control.sock" \
+      LOAD_CLIENT="$pgo_dir/load_client" HXM_BIN="$pgo_dir/hxm" \
+      python3 "$repo_root/scripts/stress-test.py" --mix "$mix" --duration "$load_duration" >>"$train_log" 2>&1
+  done
+  stop_training_x
+}
+
+# Sum each source's .gcda across the trained targets and hand the result to
+# every one of them that has the object
+merge_gcc_profiles() {
+  if ! command -v "$gcov_tool" >/dev/null 2>&1; then
+    echo "$gcov_tool not found: each target keeps only its own profile" >&2
+    return 0
+  fi
+  local stage
+  stage=$(mktemp -d)
+  local name t
+  for name in $(cd "$pgo_dir" && for t in "${trained[@]}"; do ls "$t.p" 2>/dev/null; done | grep '\.gcda$' | sort -u); do
+    rm -rf "$stage/sum"
+    for t in "${trained[@]}"; do
+      [[ -f "$pgo_dir/$t.p/$name" ]] || continue
+      if [[ ! -d "$stage/sum" ]]; then
+        mkdir -p "$stage/sum"
+        cp "$pgo_dir/$t.p/$name" "$stage/sum/$name"
+        continue
+      fi
+      rm -rf "$stage/add" "$stage/out"
+      mkdir -p "$stage/add"
+      cp "$pgo_dir/$t.p/$name" "$stage/add/$name"
+      "$gcov_tool" merge -o "$stage/out" "$stage/sum" "$stage/add" >/dev/null
+      rm -rf "$stage/sum"
+      mv "$stage/out" "$stage/sum"
+    done
+    for t in "${trained[@]}"; do
+      if [[ -f "$pgo_dir/$t.p/${name%.gcda}.o" ]]; then
+        cp "$stage/sum/$name" "$pgo_dir/$t.p/$name"
+      fi
+    done
+  done
+  rm -rf "$stage"
+}
+
+mkdir -p "$out_dir"
+: >"$train_log"
+
+echo "== instrumented build: $pgo_dir"
+configure "$pgo_dir" "${common_opts[@]}" -Db_pgo=generate
+meson compile -C "$pgo_dir" "${targets[@]}"
+cc_id=$(compiler_id "$pgo_dir")
+
+# A profile left from an earlier run would be summed into this one
+find "$pgo_dir" -name '*.gcda' -delete
+rm -rf "$raw_dir"
+mkdir -p "$raw_dir"
+export LLVM_PROFILE_FILE="$raw_dir/%p-%m.profraw"
+
+echo "== training"
+echo "training: perf_harness"
+"$pgo_dir/perf_harness" --scenario all --iters "$harness_iters" >>"$train_log" 2>&1
+echo "training: perf_pipeline"
+"$pgo_dir/perf_pipeline" --iters "$pipeline_iters" >>"$train_log" 2>&1
+for trace in "${traces[@]}"; do
+  echo "training: replay of $trace"
+  "$pgo_dir/perf_pipeline" --replay "$trace" >>"$train_log" 2>&1
+done
+train_xvfb
+unset LLVM_PROFILE_FILE
+
+echo "== merging profiles ($cc_id)"
+if [[ "$cc_id" == "clang" ]]; then
+  "$llvm_profdata" merge -o "$pgo_dir/default.profdata" "$raw_dir"/*.profraw
+else
+  merge_gcc_profiles
+fi
+
+echo "== optimized build: $pgo_dir"
+meson configure "$pgo_dir" -Db_pgo=use
+meson compile -C "$pgo_dir" "${targets[@]}"
+
+echo "== baseline build: $baseline_dir"
+configure "$baseline_dir" "${common_opts[@]}" -Db_pgo=off
+meson compile -C "$baseline_dir" "${targets[@]}"
+
+echo "PGO build: $pgo_dir/hxm (training log: $train_log)"
+
+if [[ "$compare" -eq 1 ]]; then
+  echo "== speedup over $baseline_dir"
+  trace_args=()
+  for trace in "${traces[@]}"; do
+    trace_args+=(--trace "$trace")
+  done
+  python3 "$script_dir/pgo-compare.py" --baseline "$baseline_dir" --pgo "$pgo_dir" --runs "$compare_runs" "${trace_args[@]}"
+fi
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""Per-scenario speedup of a PGO build over its baseline.
+
+Runs perf_harness (--counters, for its NS_PER_OP) and perf_pipeline from
+both build directories, alternating baseline and PGO runs so that drift in
+the machine hits both alike, and reports the median time per op of each
+scenario. A replayed trace (--trace) is compared on its p50 tick time.
+
+One line per scenario, then the geometric mean over all of them:
+
+  SPEEDUP <name> BASELINE_NS <ns> PGO_NS <ns> RATIO <baseline/pgo>
+  SPEEDUP geomean RATIO <r>
+
+A ratio above 1 means the PGO build is faster. Both directories must hold
+the same harness sources; scripts/pgo-build.sh produces such a pair.
+"""
+
+import argparse
+import json
+import math
+import os
+import statistics
+import subprocess
+import sys
+
+
+def run(cmd):
+    try:
+        return subprocess.run(cmd, capture_output=True, text=True, check=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        print(f"failed: {' '.join(cmd)}: {e}", file=sys.stderr)
+        raise SystemExit(1)
+
+
+def fields(tokens):
+    return {tokens[i]: tokens[i + 1] for i in range(0, len(tokens) - 1, 2)}
+
+
+def parse(out):
+    """Scenario name -> ns per op from either harness's output"""
+    times = {}
+    for line in out.splitlines():
+        tok = line.split()
+        if len(tok) < 2:
+            continue
+        if tok[0] == "COUNTERS":
+            times["harness/" + tok[1]] = float(fields(tok[2:])["NS_PER_OP"])
+        elif tok[0] == "SCENARIO" and "NS_PER_OP" in tok:
+            times["pipeline/" + tok[1]] = float(fields(tok[2:])["NS_PER_OP"])
+        elif tok[0] == "REPLAY":
+            times["replay"] = float(fields(tok[1:])["P50_NS"])
+    return times
+
+
+def commands(build_dir, args):
+    """(command, name for its REPLAY line) per harness run"""
+    harness = os.path.join(build_dir, "perf_harness")
+    pipeline = os.path.join(build_dir, "perf_pipeline")
+    cmds = [([harness, "--scenario", "all", "--iters", str(args.harness_iters), "--clients", str(args.clients), "--counters"], None),
+            ([pipeline, "--iters", str(args.pipeline_iters)], None)]
+    for trace in args.trace:
+        cmds.append(([pipeline, "--replay", trace], "replay/" + os.path.basename(trace)))
+    return cmds
+
+
+def collect(build_dir, args):
+    times = {}
+    for cmd, replay_name in commands(build_dir, args):
+        for name, ns in parse(run(cmd)).items():
+            times[replay_name if name == "replay" else name] = ns
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--baseline", required=True, metavar="DIR", help="build directory without PGO")
+    parser.add_argument("--pgo", required=True, metavar="DIR", help="build directory with -Db_pgo=use")
+    parser.add_argument("--runs", type=int, default=5, help="runs per build, the median is reported (default 5)")
+    parser.add_argument("--harness-iters", type=int, default=100000, help="perf_harness --iters (default 100000)")
+    parser.add_argument("--pipeline-iters", type=int, default=2000, help="perf_pipeline --iters (default 2000)")
+    parser.add_argument("--clients", type=int, default=1024, help="perf_harness --clients (default 1024)")
+    parser.add_argument("--trace", action="append", default=[], metavar="FILE", help="HXM_EVENT_TRACE file to replay")
+    parser.add_argument("--json", metavar="FILE", help="also write the results as JSON ('-' for stdout)")
+    args = parser.parse_args()
+
+    samples = {"baseline": {}, "pgo": {}}
+    for _ in range(args.runs):
+        for label, build_dir in (("baseline", args.baseline), ("pgo", args.pgo)):
+            for name, ns in collect(build_dir, args).items():
+                samples[label].setdefault(name, []).append(ns)
+
+    results = []
+    for name in samples["baseline"]:
+        if name not in samples["pgo"]:
+            continue
+        base = statistics.median(samples["baseline"][name])
+        pgo = statistics.median(samples["pgo"][name])
+        if base <= 0 or pgo <= 0:
+            continue
+        results.append({"scenario": name, "baseline_ns": base, "pgo_ns": pgo, "ratio": base / pgo})
+    if not results:
+        print("no scenario ran in both builds", file=sys.stderr)
+        raise SystemExit(1)
+
+    for r in results:
+        print(f"SPEEDUP {r['scenario']} BASELINE_NS {r['baseline_ns']:.1f} PGO_NS {r['pgo_ns']:.1f} RATIO {r['ratio']:.3f}")
+    geomean = math.exp(sum(math.log(r["ratio"]) for r in results) / len(results))
+    print(f"SPEEDUP geomean RATIO {geomean:.3f}")
+
+    if args.json:
+        report = {"runs": args.runs, "scenarios": results, "geomean": geomean}
+        if args.json == "-":
+            json.dump(report, sys.stdout, indent=2)
+            print()
+        else:
+            with open(args.json, "w", encoding="utf-8") as f:
+                json.dump(report, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
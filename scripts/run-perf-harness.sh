@@ -12,10 +12,11 @@ iters=100000
 clients=1024
 scenario=all
 use_perf=1
+use_counters=0
 
 die_usage() {
   cat >&2 <<USAGE
-usage: $0 [--no-perf] [--iters N] [--clients N] [--scenario all|focus_cycle|stacking_ops|move_resize|flush_loops]
+usage: $0 [--no-perf | --counters] [--iters N] [--clients N] [--scenario all|focus_cycle|stacking_ops|move_resize|flush_loops|map_linear|map_swiss|flush_scan|flush_worklist|place_smart|rules_linear|rules_compiled|rules_interned|damage_idle_scan|damage_idle_epoch|slotmap_contiguous|slotmap_paged|visibility_aos|visibility_soa]
 USAGE
   exit 2
 }
@@ -26,6 +27,12 @@ while [[ $# -gt 0 ]]; do
       use_perf=0
       shift
       ;;
+    --counters)
+      # Per-scenario counters from inside the harness instead of perf stat
+      use_perf=0
+      use_counters=1
+      shift
+      ;;
     --iters)
       [[ $# -ge 2 ]] || die_usage
       iters=$2
@@ -58,6 +65,10 @@ if [[ ! -x "$harness_bin" ]]; then
   exit 1
 fi
 
+if [[ "$use_counters" -eq 1 ]]; then
+  exec "$harness_bin" --scenario "$scenario" --iters "$iters" --clients "$clients" --counters
+fi
+
 if [[ "$use_perf" -eq 0 ]]; then
   exec "$harness_bin" --scenario "$scenario" --iters "$iters" --clients "$clients"
 fi
@@ -68,7 +79,7 @@ if ! command -v "$perf_bin" >/dev/null 2>&1; then
 fi
 
 events='cycles,instructions,cache-misses,LLC-load-misses,branches,branch-misses'
-scenarios=(focus_cycle stacking_ops move_resize flush_loops)
+scenarios=(focus_cycle stacking_ops move_resize flush_loops map_linear map_swiss flush_scan flush_worklist place_smart rules_linear rules_compiled rules_interned damage_idle_scan damage_idle_epoch slotmap_contiguous slotmap_paged visibility_aos visibility_soa)
 if [[ "$scenario" != "all" ]]; then
   scenarios=("$scenario")
 fi
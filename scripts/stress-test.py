@@ -1,47 +1,241 @@
 #!/usr/bin/env python3
+"""Load generator for a running hxm.
 
+Spawns load_client processes with a workload mix, then reports what hxm did
+about it: tick phase histograms, X requests sent and cookie traffic, read
+from the control socket (`hxm --query`) before and after the run.
+
+Counters are reported as deltas over the run. Histograms are lifetime values
+of the hxm process, so restart hxm before a run for clean percentiles.
+
+Mixes are presets; any option given on the command line overrides the
+preset's value. Rates are per second per client process.
+"""
+
+import argparse
+import json
 import os
+import shutil
 import subprocess
+import sys
 import time
 
+# name -> load_client options; "clients" is the number of processes
+MIXES = {
+    "idle": {
+        "clients": 50,
+    },
+    # Test runners opening and closing browser windows: constant churn,
+    # tab titles, favicons, menus and tooltips, resize on startup
+    "ci-browser": {
+        "clients": 8,
+        "windows": 6,
+        "churn-hz": 4,
+        "title-hz": 40,
+        "icon-size": 64,
+        "icon-hz": 4,
+        "configure-hz": 30,
+        "transient-depth": 1,
+        "popup-hz": 10,
+    },
+    # Chat apps: unread counters in titles and large badge icons, urgency
+    # toggles, notification popups
+    "chat": {
+        "clients": 4,
+        "windows": 2,
+        "title-hz": 20,
+        "icon-size": 256,
+        "icon-hz": 2,
+        "state-hz": 4,
+        "popup-hz": 2,
+        "popup-ms": 3000,
+    },
+    # Pathological clients: ConfigureRequest and property storms
+    "storm": {
+        "clients": 4,
+        "windows": 16,
+        "title-hz": 500,
+        "state-hz": 50,
+        "configure-hz": 1000,
+        "transient-depth": 3,
+        "popup-hz": 50,
+        "popup-ms": 20,
+    },
+}
+
+LOAD_OPTIONS = [
+    ("windows", int, "toplevels kept alive per client"),
+    ("transient-depth", int, "transient chain under each toplevel"),
+    ("icon-size", int, "_NET_WM_ICON edge in pixels, 0 for none"),
+    ("popup-ms", int, "override-redirect popup lifetime"),
+    ("churn-hz", float, "toplevels replaced per second"),
+    ("title-hz", float, "title changes per second"),
+    ("icon-hz", float, "icon replacements per second"),
+    ("state-hz", float, "_NET_WM_STATE toggles per second"),
+    ("configure-hz", float, "ConfigureRequests per second"),
+    ("popup-hz", float, "override-redirect popups per second"),
+]
+
+SECTIONS = ["ticks", "requests", "cookies", "wakeups"]
+
+# Monotonic counters, reported as the growth over the run; everything else
+# (histograms, per-tick maxima, occupancy) is reported as sampled afterwards
+COUNTERS = {
+    "x", "bytes_total", "unmanaged_configure", "client_messages_coalesced", "props_deferred", "input_flushes",
+    "pushed", "completed", "errors", "timed_out", "dropped", "drains", "grows", "budget_limited",
+}
+GAUGES = {"timers_pending", "timer_armed_ns", "active", "policy", "denied"}
+
+
+def find_binary(env, candidates):
+    path = os.environ.get(env)
+    if path:
+        return path
+    for cand in candidates:
+        if os.path.isfile(cand) and os.access(cand, os.X_OK):
+            return cand
+    return None
+
+
+def query(hxm_bin, section):
+    try:
+        out = subprocess.run([hxm_bin, "--query", section], capture_output=True, text=True, timeout=10, check=True).stdout
+        return json.loads(out)[section]
+    except (OSError, subprocess.SubprocessError, ValueError, KeyError):
+        return None
 
-def spawn_windows(count):
-    procs = []
-    client = os.environ.get("DUMMY_CLIENT", "./tests/dummy_client")
-    cmd = [client]
-    if not os.path.exists(cmd[0]):
-        print(f"Error: {cmd[0]} not found. Compile it first.")
-        raise SystemExit(1)
 
-    for _ in range(count):
-        p = subprocess.Popen(cmd)
-        procs.append(p)
-    return procs
+def snapshot(hxm_bin):
+    if not hxm_bin:
+        return None
+    snap = {}
+    for section in SECTIONS:
+        data = query(hxm_bin, section)
+        if data is None:
+            return None
+        snap[section] = data
+    return snap
+
+
+def delta(before, after, counting=False):
+    if isinstance(after, dict):
+        if "count" in after and ("p50_us" in after or "p50" in after):
+            return after
+        prev = before if isinstance(before, dict) else {}
+        return {k: delta(prev.get(k), v, (counting or k in COUNTERS) and k not in GAUGES) for k, v in after.items()}
+    if counting and isinstance(after, int) and not isinstance(after, bool):
+        return after - (before if isinstance(before, int) else 0)
+    return after
+
+
+def print_report(report):
+    totals = report["load"]
+    print("Load: " + ", ".join(f"{k}={v}" for k, v in totals.items()))
+    hxm = report.get("hxm")
+    if not hxm:
+        print("hxm diagnostics unavailable (control socket disabled or hxm not found)")
+        return
+    print("Tick phases (lifetime, us):")
+    for phase, h in hxm["ticks"].items():
+        if h["count"]:
+            print(f"  {phase:12s} n={h['count']:<8d} p50={h['p50_us']:<9.1f} p90={h['p90_us']:<9.1f} p99={h['p99_us']:<9.1f} max={h['max_us']:.1f}")
+    req = hxm["requests"]
+    print("X requests during run: " + ", ".join(f"{k}={v}" for k, v in req["x"].items() if v))
+    per_tick = req["per_tick"]
+    print(f"  per tick p50={per_tick['p50']} p99={per_tick['p99']} max={per_tick['max']}")
+    uc = req["unmanaged_configure"]
+    print(f"  unmanaged configure forwarded={uc['forwarded']} coalesced={uc['coalesced']}, "
+          f"client messages coalesced={req['client_messages_coalesced']}, props deferred={req['props_deferred']}")
+    types = hxm["cookies"].get("types", {})
+    if types:
+        print("Cookies during run: " + ", ".join(f"{k}={v['pushed']}" for k, v in types.items() if v["pushed"]))
 
 
 def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--mix", choices=sorted(MIXES), default="idle", help="workload preset (default idle)")
+    parser.add_argument("--clients", type=int, help="load_client processes")
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds to run (default 10)")
+    parser.add_argument("--seed", type=int, default=1, help="base seed; client i uses seed+i")
+    parser.add_argument("--json", metavar="FILE", help="write the full report as JSON ('-' for stdout)")
+    parser.add_argument("--require-diagnostics", action="store_true", help="fail if the control socket cannot be read")
+    for name, kind, help_text in LOAD_OPTIONS:
+        parser.add_argument(f"--{name}", type=kind, help=help_text)
+    args = parser.parse_args()
+
     display = os.environ.get("DISPLAY")
     if not display:
         print("DISPLAY not set. Run this in Xephyr or Xvfb.")
         raise SystemExit(1)
 
-    print(f"Starting stress test on {display}")
+    client = find_binary("LOAD_CLIENT", ["./build/load_client", "./tests/load_client"])
+    if not client:
+        print("Error: load_client not found. Build it or set LOAD_CLIENT.")
+        raise SystemExit(1)
+    hxm_bin = find_binary("HXM_BIN", ["./build/hxm", "./hxm"]) or shutil.which("hxm")
 
-    count = 50
-    print(f"Spawning {count} windows...")
-    procs = spawn_windows(count)
+    mix = dict(MIXES[args.mix])
+    if args.clients is not None:
+        mix["clients"] = args.clients
+    for name, _, _ in LOAD_OPTIONS:
+        val = getattr(args, name.replace("-", "_"))
+        if val is not None:
+            mix[name] = val
+    clients = mix.pop("clients")
 
-    time.sleep(2)
+    duration_ms = int(args.duration * 1000)
+    cmd = [client, "--duration-ms", str(duration_ms)]
+    for name, val in mix.items():
+        cmd += [f"--{name}", str(val)]
 
-    print("Randomly moving/resizing...")
-    # Keep windows alive for a short period to exercise lifecycle paths.
-    for _ in range(100):
-        time.sleep(0.1)
+    print(f"Starting stress test on {display}: mix={args.mix} clients={clients} duration={args.duration}s")
+    before = snapshot(hxm_bin)
 
-    print("Killing windows...")
+    procs = [subprocess.Popen(cmd + ["--seed", str(args.seed + i)], stdout=subprocess.PIPE, text=True) for i in range(clients)]
+    totals = {}
+    failed = 0
+    deadline = time.monotonic() + args.duration + 30
     for p in procs:
-        p.terminate()
+        try:
+            out, _ = p.communicate(timeout=max(1.0, deadline - time.monotonic()))
+        except subprocess.TimeoutExpired:
+            p.kill()
+            out, _ = p.communicate()
+        if p.returncode != 0:
+            failed += 1
+            continue
+        for k, v in json.loads(out).items():
+            totals[k] = totals.get(k, 0) + v
+    totals.pop("elapsed_ms", None)
+
+    # Let hxm drain what the clients left queued before sampling
+    time.sleep(0.5)
+    after = snapshot(hxm_bin)
+
+    report = {
+        "mix": args.mix,
+        "clients": clients,
+        "duration_s": args.duration,
+        "params": mix,
+        "load": totals,
+        "failed_clients": failed,
+        "hxm": {k: delta(before[k], after[k], k == "wakeups") for k in SECTIONS} if before and after else None,
+    }
+    print_report(report)
+    if args.json:
+        if args.json == "-":
+            json.dump(report, sys.stdout, indent=2)
+            print()
+        else:
+            with open(args.json, "w", encoding="utf-8") as f:
+                json.dump(report, f, indent=2)
 
+    if failed:
+        print(f"{failed} load client(s) failed")
+        raise SystemExit(1)
+    if args.require_diagnostics and report["hxm"] is None:
+        print("hxm diagnostics unavailable")
+        raise SystemExit(1)
     print("Stress test finished.")
 
 
@@ -68,18 +68,21 @@ if [ -z "$hxm_bin" ]; then
   fi
 fi
 
-dummy_client=${DUMMY_CLIENT:-}
-if [ -z "$dummy_client" ]; then
-  if [ -x "$repo_root/build/dummy_client" ]; then
-    dummy_client="$repo_root/build/dummy_client"
-  elif [ -x "$repo_root/tests/dummy_client" ]; then
-    dummy_client="$repo_root/tests/dummy_client"
+load_client=${LOAD_CLIENT:-}
+if [ -z "$load_client" ]; then
+  if [ -x "$repo_root/build/load_client" ]; then
+    load_client="$repo_root/build/load_client"
+  elif [ -x "$repo_root/tests/load_client" ]; then
+    load_client="$repo_root/tests/load_client"
   else
-    echo "dummy_client not found; set DUMMY_CLIENT" >&2
+    echo "load_client not found; set LOAD_CLIENT" >&2
     exit 1
   fi
 fi
 
+# The stress test reads hxm's diagnostics through the control socket
+export HXM_CONTROL_SOCKET="$tmp_home/hxm-control.sock"
+
 cleanup() {
   if [ -n "${HXM_PID:-}" ] && kill -0 "$HXM_PID" 2>/dev/null; then
     kill "$HXM_PID"
@@ -106,6 +109,7 @@ HXM_PID=$!
 sleep 2
 
 echo "Running stress test..."
-DUMMY_CLIENT="$dummy_client" python3 "$repo_root/scripts/stress-test.py"
+LOAD_CLIENT="$load_client" HXM_BIN="$hxm_bin" python3 "$repo_root/scripts/stress-test.py" \
+  --mix ci-browser --clients 4 --duration 3 --require-diagnostics
 
 echo "Stress test complete."
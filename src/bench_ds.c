@@ -0,0 +1,570 @@
+/* src/bench_ds.c
+ * Microbenchmarks for the hot container primitives.
+ *
+ * perf_harness times whole WM scenarios built on these containers; this
+ * binary times the containers alone, one operation kind at a time, at
+ * 10, 100, 1000 and 10000 elements:
+ *
+ *   arena.alloc_reset            n allocations, then arena_reset
+ *   small_vec.push               n pushes from empty, growth included
+ *   small_vec.remove[_swap]      n removes, oldest first
+ *   hash_map.<layout>.<op>       insert, get_hit, get_miss, remove, per key
+ *                                distribution and target load factor
+ *   slotmap.<layout>.<op>        alloc, free, iterate
+ *   cookie_jar.<op>              push, drain (one tick budget per call),
+ *                                expire
+ *
+ * Key distributions model what the maps are keyed by: "seq" is one client's
+ * consecutive XIDs, "clients" is a few XIDs under each of many resource-id
+ * bases (high bits vary, low bits repeat), "random" is splitmix64. The map
+ * is grown to the capacity the target load needs and cleared before the
+ * measured keys go in, so the reported load is n / capacity.
+ *
+ * Each benchmark runs rounds of n operations with untimed preparation in
+ * between (refill before remove, empty before insert). After one untimed
+ * warm-up round, a sample is the sum of enough rounds to reach the target
+ * op count, less the timer overhead, and the best sample is reported. Output is one JSON document on stdout:
+ *
+ *   {"schema": 1, "build": {...}, "results": [
+ *     {"name": ..., "n": ..., [dist, load, load_actual,] "ops": ...,
+ *      "ns_per_op": ...}, ...]}
+ *
+ * scripts/ci/check_bench_ds.py compares a run with the limits checked in as
+ * scripts/ci/bench_ds_thresholds.json.
+ *
+ * The cookie jar runs against tests/xcb_stubs.c with every poll answered
+ * at once, and monotonic_time_ns is replaced by a clock that can be pushed
+ * past COOKIE_JAR_TIMEOUT_NS for expire. Expire logs a warning per cookie,
+ * so the log streams are sent to /dev/null and the JSON goes to a duplicate
+ * of the original stdout.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <xcb/xcb.h>
+
+#include "cookie_jar.h"
+#include "ds.h"
+#include "hxm.h"
+#include "slotmap.h"
+
+/* tests/xcb_stubs.c */
+extern int (*stub_poll_for_reply_hook)(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error);
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define BENCH_INSTRUMENTED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#define BENCH_INSTRUMENTED 1
+#endif
+#endif
+#ifndef BENCH_INSTRUMENTED
+#define BENCH_INSTRUMENTED 0
+#endif
+
+#define BENCH_TARGET_OPS (1u << 17)
+#define BENCH_QUICK_TARGET_OPS (1u << 12)
+#define BENCH_SAMPLES 5
+#define BENCH_QUICK_SAMPLES 2
+#define BENCH_MAX_N 10000u
+
+#define BENCH_ARENA_ALLOC 48u
+#define BENCH_SLOT_HOT 64u
+#define BENCH_SLOT_COLD 256u
+
+static const size_t bench_sizes[] = {10, 100, 1000, 10000};
+
+typedef enum bench_dist {
+  DIST_NONE = 0,
+  DIST_SEQ,
+  DIST_CLIENTS,
+  DIST_RANDOM,
+} bench_dist_t;
+
+static const char* const dist_names[] = {"", "seq", "clients", "random"};
+
+typedef struct bench {
+  size_t n;
+  bench_dist_t dist;
+  double load;
+
+  uint64_t* keys;
+  uint64_t* miss_keys;
+  uint32_t* order; /* lookup permutation */
+  handle_t* handles;
+  void** items;
+
+  arena_t arena;
+  small_vec_t vec;
+  hash_map_t map;
+  slotmap_t sm;
+  cookie_jar_t cj;
+  uint32_t next_seq;
+  size_t map_capacity;
+} bench_t;
+
+typedef struct bench_def {
+  const char* name;
+  bench_dist_t dist; /* DIST_NONE: not a keyed benchmark */
+  void (*setup)(bench_t* b);
+  void (*prep)(bench_t* b); /* untimed, before every round */
+  void (*run)(bench_t* b);  /* timed, n operations */
+  void (*teardown)(bench_t* b);
+} bench_def_t;
+
+static uint64_t bench_clock_skew_ns;
+static volatile uintptr_t bench_sink;
+static xcb_connection_t* bench_conn;
+
+/* Replaces the weak definition in core.c so expire can jump the clock */
+uint64_t monotonic_time_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec + bench_clock_skew_ns;
+}
+
+static inline uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t splitmix64(uint64_t* state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/* Key i of a distribution; salt separates the hit and miss sets */
+static uint64_t bench_key(bench_dist_t dist, size_t i, uint64_t salt) {
+  switch (dist) {
+    case DIST_SEQ:
+      return 0x400001u + salt * BENCH_MAX_N + i;
+    case DIST_CLIENTS:
+      // X hands each client a resource-id base in the high bits
+      return ((uint64_t)(i / 4 + 1 + salt * BENCH_MAX_N) << 21) | (i % 4 + 1);
+    case DIST_RANDOM: {
+      uint64_t state = (salt << 32) ^ i;
+      uint64_t k = splitmix64(&state);
+      return k ? k : 1;
+    }
+    case DIST_NONE:
+      break;
+  }
+  return i + 1;
+}
+
+/* ---------- Arena ---------- */
+
+static void arena_setup(bench_t* b) {
+  arena_init(&b->arena, 0);
+}
+
+static void arena_run(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    bench_sink ^= (uintptr_t)arena_alloc(&b->arena, BENCH_ARENA_ALLOC);
+  arena_reset(&b->arena);
+}
+
+static void arena_teardown(bench_t* b) {
+  arena_destroy(&b->arena);
+}
+
+/* ---------- Small vector ---------- */
+
+static void vec_setup(bench_t* b) {
+  small_vec_init(&b->vec);
+}
+
+static void vec_empty(bench_t* b) {
+  small_vec_destroy(&b->vec);
+}
+
+static void vec_fill(bench_t* b) {
+  small_vec_clear(&b->vec);
+  for (size_t i = 0; i < b->n; i++)
+    small_vec_push(&b->vec, b->items[i]);
+}
+
+static void vec_push_run(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    small_vec_push(&b->vec, b->items[i]);
+}
+
+static void vec_remove_run(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    small_vec_remove(&b->vec, b->items[i]);
+}
+
+static void vec_remove_swap_run(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    small_vec_remove_swap(&b->vec, b->items[i]);
+}
+
+static void vec_teardown(bench_t* b) {
+  small_vec_destroy(&b->vec);
+}
+
+/* ---------- Hash map ---------- */
+
+static void map_presize(bench_t* b) {
+  // Grow with keys outside every distribution, then drop them
+  for (uint64_t k = 1; (double)hash_map_capacity(&b->map) * b->load < (double)b->n; k++)
+    hash_map_insert(&b->map, (1ull << 63) | k, b);
+  hash_map_clear(&b->map);
+}
+
+static void map_fill(bench_t* b) {
+  hash_map_clear(&b->map);
+  for (size_t i = 0; i < b->n; i++)
+    hash_map_insert(&b->map, b->keys[i], b->items[i]);
+}
+
+static void map_linear_setup(bench_t* b) {
+  hash_map_init(&b->map);
+  map_presize(b);
+  map_fill(b);
+}
+
+static void map_swiss_setup(bench_t* b) {
+  hash_map_init_swiss(&b->map);
+  map_presize(b);
+  map_fill(b);
+}
+
+static void map_empty(bench_t* b) {
+  hash_map_clear(&b->map);
+}
+
+static void map_insert_run(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    hash_map_insert(&b->map, b->keys[i], b->items[i]);
+}
+
+static void map_get_hit_run(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    bench_sink ^= (uintptr_t)hash_map_get(&b->map, b->keys[b->order[i]]);
+}
+
+static void map_get_miss_run(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    bench_sink ^= (uintptr_t)hash_map_get(&b->map, b->miss_keys[b->order[i]]);
+}
+
+static void map_remove_run(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    bench_sink += hash_map_remove(&b->map, b->keys[b->order[i]]);
+}
+
+static void map_teardown(bench_t* b) {
+  hash_map_destroy(&b->map);
+}
+
+/* ---------- Slotmap ---------- */
+
+static void sm_alloc_all(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    b->handles[i] = slotmap_alloc_grow(&b->sm, NULL, NULL);
+}
+
+static void sm_free_all(bench_t* b) {
+  for (size_t i = 0; i < b->n; i++)
+    slotmap_free(&b->sm, b->handles[i]);
+}
+
+static void sm_contiguous_setup(bench_t* b) {
+  slotmap_init(&b->sm, 16, BENCH_SLOT_HOT, BENCH_SLOT_COLD);
+}
+
+static void sm_paged_setup(bench_t* b) {
+  slotmap_init_paged(&b->sm, 16, BENCH_SLOT_HOT, BENCH_SLOT_COLD);
+}
+
+static void sm_contiguous_filled_setup(bench_t* b) {
+  sm_contiguous_setup(b);
+  sm_alloc_all(b);
+}
+
+static void sm_paged_filled_setup(bench_t* b) {
+  sm_paged_setup(b);
+  sm_alloc_all(b);
+}
+
+static void sm_empty(bench_t* b) {
+  if (b->handles[0] != HANDLE_INVALID && slotmap_live(&b->sm, b->handles[0]))
+    sm_free_all(b);
+}
+
+static void sm_fill(bench_t* b) {
+  if (b->handles[0] == HANDLE_INVALID || !slotmap_live(&b->sm, b->handles[0]))
+    sm_alloc_all(b);
+}
+
+static void sm_iterate_run(bench_t* b) {
+  uint32_t idx;
+  slotmap_for_each_live(&b->sm, idx) {
+    bench_sink += *(const uint8_t*)slotmap_hot_at(&b->sm, idx);
+  }
+}
+
+static void sm_teardown(bench_t* b) {
+  slotmap_destroy(&b->sm);
+}
+
+/* ---------- Cookie jar ---------- */
+
+static int bench_poll_for_reply(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) {
+  (void)c;
+  (void)request;
+  *reply = NULL;
+  *error = NULL;
+  return 1;
+}
+
+static void bench_cookie_handler(struct server* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  (void)s;
+  (void)reply;
+  (void)err;
+  bench_sink += slot->sequence;
+}
+
+static void cj_setup(bench_t* b) {
+  cookie_jar_init(&b->cj);
+  b->next_seq = 1;
+}
+
+static void cj_fill(bench_t* b) {
+  // Four cookies per client, as in a manage burst
+  for (size_t i = 0; i < b->n; i++)
+    cookie_jar_push(&b->cj, b->next_seq++, COOKIE_GET_PROPERTY, handle_make((uint32_t)(i / 4 + 1), 1), 0, 0, bench_cookie_handler);
+}
+
+static void cj_drain_all(bench_t* b) {
+  while (b->cj.live_count > 0) {
+    cookie_jar_mark_replies_may_exist(&b->cj);
+    cookie_jar_drain(&b->cj, bench_conn, NULL, 0);
+  }
+}
+
+static void cj_fill_stale(bench_t* b) {
+  cj_fill(b);
+  bench_clock_skew_ns += COOKIE_JAR_TIMEOUT_NS + 1000000ull;
+}
+
+static void cj_push_run(bench_t* b) {
+  cj_fill(b);
+}
+
+static void cj_expire_run(bench_t* b) {
+  while (b->cj.live_count > 0)
+    cookie_jar_expire(&b->cj, NULL, 0);
+}
+
+static void cj_teardown(bench_t* b) {
+  cj_drain_all(b);
+  cookie_jar_destroy(&b->cj);
+}
+
+/* ---------- Runner ---------- */
+
+#define MAP_BENCHES(layout, dist)                                                                                          \
+  {"hash_map." #layout ".insert", dist, map_##layout##_setup, map_empty, map_insert_run, map_teardown},                   \
+      {"hash_map." #layout ".get_hit", dist, map_##layout##_setup, NULL, map_get_hit_run, map_teardown},                  \
+      {"hash_map." #layout ".get_miss", dist, map_##layout##_setup, NULL, map_get_miss_run, map_teardown},                \
+      {"hash_map." #layout ".remove", dist, map_##layout##_setup, map_fill, map_remove_run, map_teardown}
+
+static const bench_def_t benches[] = {
+    {"arena.alloc_reset", DIST_NONE, arena_setup, NULL, arena_run, arena_teardown},
+    {"small_vec.push", DIST_NONE, vec_setup, vec_empty, vec_push_run, vec_teardown},
+    {"small_vec.remove", DIST_NONE, vec_setup, vec_fill, vec_remove_run, vec_teardown},
+    {"small_vec.remove_swap", DIST_NONE, vec_setup, vec_fill, vec_remove_swap_run, vec_teardown},
+    MAP_BENCHES(linear, DIST_SEQ),
+    MAP_BENCHES(linear, DIST_CLIENTS),
+    MAP_BENCHES(linear, DIST_RANDOM),
+    MAP_BENCHES(swiss, DIST_SEQ),
+    MAP_BENCHES(swiss, DIST_CLIENTS),
+    MAP_BENCHES(swiss, DIST_RANDOM),
+    {"slotmap.contiguous.alloc", DIST_NONE, sm_contiguous_setup, sm_empty, sm_alloc_all, sm_teardown},
+    {"slotmap.contiguous.free", DIST_NONE, sm_contiguous_setup, sm_fill, sm_free_all, sm_teardown},
+    {"slotmap.contiguous.iterate", DIST_NONE, sm_contiguous_filled_setup, NULL, sm_iterate_run, sm_teardown},
+    {"slotmap.paged.alloc", DIST_NONE, sm_paged_setup, sm_empty, sm_alloc_all, sm_teardown},
+    {"slotmap.paged.free", DIST_NONE, sm_paged_setup, sm_fill, sm_free_all, sm_teardown},
+    {"slotmap.paged.iterate", DIST_NONE, sm_paged_filled_setup, NULL, sm_iterate_run, sm_teardown},
+    {"cookie_jar.push", DIST_NONE, cj_setup, cj_drain_all, cj_push_run, cj_teardown},
+    {"cookie_jar.drain", DIST_NONE, cj_setup, cj_fill, cj_drain_all, cj_teardown},
+    {"cookie_jar.expire", DIST_NONE, cj_setup, cj_fill_stale, cj_expire_run, cj_teardown},
+};
+
+static const double map_loads[] = {0.25, 0.5, 0.7};
+
+static uint64_t timer_overhead_ns(void) {
+  uint64_t best = UINT64_MAX;
+  for (int i = 0; i < 1000; i++) {
+    uint64_t t0 = now_ns();
+    uint64_t t1 = now_ns();
+    if (t1 - t0 < best)
+      best = t1 - t0;
+  }
+  return best;
+}
+
+static void bench_keys(bench_t* b) {
+  uint64_t state = 0x68786d00ull;
+  for (size_t i = 0; i < BENCH_MAX_N; i++) {
+    b->keys[i] = bench_key(b->dist, i, 0);
+    b->miss_keys[i] = bench_key(b->dist, i, 1);
+  }
+  // Lookups visit the keys in a fixed random order
+  for (size_t i = 0; i < b->n; i++)
+    b->order[i] = (uint32_t)i;
+  for (size_t i = b->n; i > 1; i--) {
+    size_t j = (size_t)(splitmix64(&state) % i);
+    uint32_t t = b->order[i - 1];
+    b->order[i - 1] = b->order[j];
+    b->order[j] = t;
+  }
+}
+
+static double bench_measure(const bench_def_t* def, bench_t* b, uint32_t target_ops, int samples, uint64_t overhead, uint64_t* ops_out) {
+  size_t rounds = target_ops / b->n;
+  if (rounds == 0)
+    rounds = 1;
+
+  memset(b->handles, 0, BENCH_MAX_N * sizeof(*b->handles));
+  def->setup(b);
+  b->map_capacity = def->dist != DIST_NONE ? hash_map_capacity(&b->map) : 0;
+  // One untimed round so first-touch page faults and growth are not sampled
+  if (def->prep)
+    def->prep(b);
+  def->run(b);
+
+  double best = -1.0;
+  for (int s = 0; s < samples; s++) {
+    uint64_t total = 0;
+    for (size_t r = 0; r < rounds; r++) {
+      if (def->prep)
+        def->prep(b);
+      uint64_t t0 = now_ns();
+      def->run(b);
+      uint64_t t1 = now_ns();
+      uint64_t dt = t1 - t0;
+      total += dt > overhead ? dt - overhead : 0;
+    }
+    double ns = (double)total / (double)(rounds * b->n);
+    if (best < 0.0 || ns < best)
+      best = ns;
+  }
+  def->teardown(b);
+
+  *ops_out = (uint64_t)rounds * b->n;
+  return best;
+}
+
+static void print_usage(const char* argv0) {
+  fprintf(stderr, "usage: %s [--quick] [--filter SUBSTRING]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+  bool quick = false;
+  const char* filter = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else if (strcmp(argv[i], "--filter") == 0) {
+      if (i + 1 >= argc) {
+        print_usage(argv[0]);
+        return 2;
+      }
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+      print_usage(argv[0]);
+      return 0;
+    } else {
+      print_usage(argv[0]);
+      return 2;
+    }
+  }
+
+  uint32_t target_ops = quick ? BENCH_QUICK_TARGET_OPS : BENCH_TARGET_OPS;
+  int samples = quick ? BENCH_QUICK_SAMPLES : BENCH_SAMPLES;
+
+  bench_t b;
+  memset(&b, 0, sizeof(b));
+  b.keys = calloc(BENCH_MAX_N, sizeof(*b.keys));
+  b.miss_keys = calloc(BENCH_MAX_N, sizeof(*b.miss_keys));
+  b.order = calloc(BENCH_MAX_N, sizeof(*b.order));
+  b.handles = calloc(BENCH_MAX_N, sizeof(*b.handles));
+  b.items = calloc(BENCH_MAX_N, sizeof(*b.items));
+  bench_conn = xcb_connect(NULL, NULL);
+  if (!b.keys || !b.miss_keys || !b.order || !b.handles || !b.items || !bench_conn) {
+    fprintf(stderr, "bench_ds: out of memory\n");
+    return 1;
+  }
+  for (size_t i = 0; i < BENCH_MAX_N; i++)
+    b.items[i] = &b.items[i];
+  stub_poll_for_reply_hook = bench_poll_for_reply;
+
+  int out_fd = dup(STDOUT_FILENO);
+  FILE* out = out_fd >= 0 ? fdopen(out_fd, "w") : NULL;
+  if (!out || !freopen("/dev/null", "w", stdout) || !freopen("/dev/null", "w", stderr)) {
+    perror("bench_ds");
+    return 1;
+  }
+
+  uint64_t overhead = timer_overhead_ns();
+  fprintf(out, "{\n  \"schema\": 1,\n");
+  fprintf(out, "  \"build\": {\"instrumented\": %s, \"ndebug\": %s, \"quick\": %s, \"timer_overhead_ns\": %llu},\n",
+         BENCH_INSTRUMENTED ? "true" : "false",
+#ifdef NDEBUG
+         "true",
+#else
+         "false",
+#endif
+         quick ? "true" : "false", (unsigned long long)overhead);
+  fprintf(out, "  \"results\": [");
+
+  bool first = true;
+  for (size_t d = 0; d < sizeof(benches) / sizeof(benches[0]); d++) {
+    const bench_def_t* def = &benches[d];
+    if (filter && !strstr(def->name, filter))
+      continue;
+    size_t loads = def->dist == DIST_NONE ? 1 : sizeof(map_loads) / sizeof(map_loads[0]);
+    for (size_t l = 0; l < loads; l++) {
+      for (size_t z = 0; z < sizeof(bench_sizes) / sizeof(bench_sizes[0]); z++) {
+        b.n = bench_sizes[z];
+        b.dist = def->dist;
+        b.load = map_loads[l];
+        bench_keys(&b);
+
+        uint64_t ops = 0;
+        double ns = bench_measure(def, &b, target_ops, samples, overhead, &ops);
+
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"n\": %zu, ", first ? "" : ",", def->name, b.n);
+        if (def->dist != DIST_NONE)
+          fprintf(out, "\"dist\": \"%s\", \"load\": %.2f, \"load_actual\": %.3f, ", dist_names[def->dist], b.load,
+                 (double)b.n / (double)b.map_capacity);
+        fprintf(out, "\"ops\": %llu, \"ns_per_op\": %.2f}", (unsigned long long)ops, ns);
+        fflush(out);
+        first = false;
+      }
+    }
+  }
+  fprintf(out, "\n  ]\n}\n");
+  fclose(out);
+
+  stub_poll_for_reply_hook = NULL;
+  xcb_disconnect(bench_conn);
+  free(b.items);
+  free(b.handles);
+  free(b.order);
+  free(b.miss_keys);
+  free(b.keys);
+  return 0;
+}
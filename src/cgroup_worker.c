@@ -0,0 +1,256 @@
+/* cgroup_worker.c - Off-thread cgroup v2 weight boosting
+ *
+ * cpu.weight must be writable for a boost to count; io.weight is written
+ * too when the io controller is enabled for the cgroup, and restored only
+ * if it was. Saved values are whatever the files held before the boost, so
+ * a weight the user set by hand comes back on demote.
+ */
+
+#include "cgroup_worker.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hxm.h"
+
+static bool read_small(const char* path, char* buf, size_t cap) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  ssize_t n = read(fd, buf, cap - 1u);
+  close(fd);
+  if (n < 0)
+    return false;
+  buf[n] = '\0';
+  return true;
+}
+
+static bool write_str(const char* path, const char* s) {
+  // O_TRUNC as a shell redirect does; cgroupfs ignores it
+  int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  size_t len = strlen(s);
+  bool ok = write(fd, s, len) == (ssize_t)len;
+  close(fd);
+  return ok;
+}
+
+/* Keep the first line only */
+static void first_line(char* s) {
+  char* nl = strchr(s, '\n');
+  if (nl)
+    *nl = '\0';
+}
+
+bool cgroup_parse_proc(const char* text, char* out, size_t cap) {
+  for (const char* line = text; line && *line;) {
+    const char* nl = strchr(line, '\n');
+    size_t len = nl ? (size_t)(nl - line) : strlen(line);
+    if (len > 3 && strncmp(line, "0::", 3) == 0) {
+      len -= 3;
+      if (len == 0 || len >= cap || line[3] != '/')
+        return false;
+      memcpy(out, line + 3, len);
+      out[len] = '\0';
+      return true;
+    }
+    line = nl ? nl + 1 : NULL;
+  }
+  return false;
+}
+
+bool cgroup_path_contains(const char* a, const char* b) {
+  if (strcmp(a, "/") == 0)
+    return true;
+  size_t len = strlen(a);
+  return strncmp(a, b, len) == 0 && (b[len] == '\0' || b[len] == '/');
+}
+
+static void cgroup_file(const cgroup_worker_t* w, const char* cgroup, const char* name, char* out, size_t cap) {
+  snprintf(out, cap, "%s%s/%s", w->cgroup_root, cgroup, name);
+}
+
+static void cgroup_demote(cgroup_worker_t* w) {
+  if (!w->boosted[0])
+    return;
+  char path[CGROUP_WORKER_PATH_MAX + 64];
+  cgroup_file(w, w->boosted, "cpu.weight", path, sizeof(path));
+  // The app may have exited and its scope gone with it
+  bool ok = write_str(path, w->saved_cpu) || errno == ENOENT;
+  if (w->saved_io[0]) {
+    cgroup_file(w, w->boosted, "io.weight", path, sizeof(path));
+    ok = (write_str(path, w->saved_io) || errno == ENOENT) && ok;
+  }
+  atomic_fetch_add_explicit(ok ? &w->demotes : &w->failed, 1, memory_order_relaxed);
+  w->boosted[0] = '\0';
+}
+
+static void cgroup_boost(cgroup_worker_t* w, const char* cgroup) {
+  char path[CGROUP_WORKER_PATH_MAX + 64];
+  char value[32];
+  snprintf(value, sizeof(value), "%u", w->weight);
+
+  cgroup_file(w, cgroup, "cpu.weight", path, sizeof(path));
+  if (!read_small(path, w->saved_cpu, sizeof(w->saved_cpu)) || !write_str(path, value)) {
+    if (!w->warned) {
+      LOG_INFO("focus_boost: cannot write %s: %s (cpu controller not delegated?)", path, strerror(errno));
+      w->warned = true;
+    }
+    atomic_fetch_add_explicit(&w->failed, 1, memory_order_relaxed);
+    return;
+  }
+  first_line(w->saved_cpu);
+
+  w->saved_io[0] = '\0';
+  cgroup_file(w, cgroup, "io.weight", path, sizeof(path));
+  char io_value[48];
+  snprintf(io_value, sizeof(io_value), "default %u", w->weight);
+  if (read_small(path, w->saved_io, sizeof(w->saved_io))) {
+    first_line(w->saved_io);
+    if (!write_str(path, io_value))
+      w->saved_io[0] = '\0';
+  }
+
+  snprintf(w->boosted, sizeof(w->boosted), "%s", cgroup);
+  atomic_fetch_add_explicit(&w->boosts, 1, memory_order_relaxed);
+}
+
+void cgroup_worker_apply(cgroup_worker_t* w, pid_t pid) {
+  char target[CGROUP_WORKER_PATH_MAX] = "";
+  if (pid > 0) {
+    char path[64 + CGROUP_WORKER_PATH_MAX];
+    char text[1024];
+    snprintf(path, sizeof(path), "%s/%d/cgroup", w->proc_root, (int)pid);
+    if (!read_small(path, text, sizeof(text)) || !cgroup_parse_proc(text, target, sizeof(target))) {
+      // Gone, or on a v1-only hierarchy
+      atomic_fetch_add_explicit(&w->skipped, 1, memory_order_relaxed);
+      target[0] = '\0';
+    }
+    else if (cgroup_path_contains(target, w->self_cgroup)) {
+      atomic_fetch_add_explicit(&w->skipped, 1, memory_order_relaxed);
+      target[0] = '\0';
+    }
+  }
+
+  // Another window of the app already boosted
+  if (strcmp(target, w->boosted) == 0)
+    return;
+  cgroup_demote(w);
+  if (target[0])
+    cgroup_boost(w, target);
+}
+
+static void* cgroup_worker_main(void* arg) {
+  cgroup_worker_t* w = (cgroup_worker_t*)arg;
+  pthread_mutex_lock(&w->lock);
+  for (;;) {
+    while (!w->stop && !w->pending)
+      pthread_cond_wait(&w->wake, &w->lock);
+    if (w->stop)
+      break;
+    pid_t pid = w->want_pid;
+    w->pending = false;
+    pthread_mutex_unlock(&w->lock);
+
+    cgroup_worker_apply(w, pid);
+
+    pthread_mutex_lock(&w->lock);
+  }
+  pthread_mutex_unlock(&w->lock);
+
+  cgroup_worker_apply(w, 0);
+  return NULL;
+}
+
+static bool cgroup_worker_resolve_self(cgroup_worker_t* w) {
+  char path[64];
+  char text[1024];
+  snprintf(path, sizeof(path), "%s/self/cgroup", w->proc_root);
+  if (!read_small(path, text, sizeof(text)) || !cgroup_parse_proc(text, w->self_cgroup, sizeof(w->self_cgroup)))
+    return false;
+  char controllers[CGROUP_WORKER_PATH_MAX + 32];
+  snprintf(controllers, sizeof(controllers), "%s/cgroup.controllers", w->cgroup_root);
+  return access(controllers, R_OK) == 0;
+}
+
+bool cgroup_worker_start(cgroup_worker_t* w, uint32_t weight) {
+  if (w->running)
+    return true;
+  memset(w, 0, sizeof(*w));
+  w->proc_root = "/proc";
+  w->cgroup_root = "/sys/fs/cgroup";
+  w->weight = weight < CGROUP_WEIGHT_MIN ? CGROUP_WEIGHT_MIN : weight > CGROUP_WEIGHT_MAX ? CGROUP_WEIGHT_MAX : weight;
+  if (!cgroup_worker_resolve_self(w)) {
+    LOG_WARN("focus_boost: no cgroup v2 hierarchy at %s", w->cgroup_root);
+    return false;
+  }
+
+  pthread_mutex_init(&w->lock, NULL);
+  pthread_cond_init(&w->wake, NULL);
+  int err = pthread_create(&w->thread, NULL, cgroup_worker_main, w);
+  if (err != 0) {
+    LOG_WARN("focus_boost thread failed: %s", strerror(err));
+    pthread_cond_destroy(&w->wake);
+    pthread_mutex_destroy(&w->lock);
+    return false;
+  }
+  w->running = true;
+  return true;
+}
+
+void cgroup_worker_stop(cgroup_worker_t* w) {
+  if (!w->running)
+    return;
+  pthread_mutex_lock(&w->lock);
+  w->stop = true;
+  pthread_cond_signal(&w->wake);
+  pthread_mutex_unlock(&w->lock);
+  pthread_join(w->thread, NULL);
+  pthread_cond_destroy(&w->wake);
+  pthread_mutex_destroy(&w->lock);
+  w->running = false;
+}
+
+void cgroup_worker_post(cgroup_worker_t* w, pid_t pid) {
+  if (!w->running)
+    return;
+  pthread_mutex_lock(&w->lock);
+  w->want_pid = pid;
+  w->pending = true;
+  pthread_cond_signal(&w->wake);
+  pthread_mutex_unlock(&w->lock);
+  atomic_fetch_add_explicit(&w->posted, 1, memory_order_relaxed);
+}
+
+size_t cgroup_worker_format(const cgroup_worker_t* w, char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+  buf[0] = '\0';
+  if (!w || !w->running)
+    return 0;
+
+  int n = snprintf(buf, cap,
+                   "focus_boost: weight=%u posted=%" PRIu64 " boosts=%" PRIu64 " demotes=%" PRIu64 " skipped=%" PRIu64
+                   " failed=%" PRIu64 "\n",
+                   w->weight, (uint64_t)atomic_load_explicit(&w->posted, memory_order_relaxed),
+                   (uint64_t)atomic_load_explicit(&w->boosts, memory_order_relaxed),
+                   (uint64_t)atomic_load_explicit(&w->demotes, memory_order_relaxed),
+                   (uint64_t)atomic_load_explicit(&w->skipped, memory_order_relaxed),
+                   (uint64_t)atomic_load_explicit(&w->failed, memory_order_relaxed));
+  if (n <= 0)
+    return 0;
+  return (size_t)n < cap ? (size_t)n : cap - 1u;
+}
+
+void cgroup_worker_dump(const cgroup_worker_t* w) {
+  char buf[256];
+  if (cgroup_worker_format(w, buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
+}
@@ -85,10 +85,12 @@
 #include "client.h"
 
 #include <assert.h>
+#include <signal.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <strings.h>
 #include <string.h>
+#include <unistd.h>
 #include <xcb/xcb_icccm.h>
 
 #include "event.h"
@@ -96,6 +98,9 @@
 #include "hxm.h"
 #include "hxm_diag.h"
 #include "slotmap.h"
+#include "str_intern.h"
+#include "thumbnail.h"
+#include "tracepoint.h"
 #include "wm.h"
 #include "wm_internal.h"
 #include "xcb_utils.h"
@@ -104,8 +109,6 @@
 #define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
 #endif
 
-#define NET_WM_ICON_LONG_LEN 4096u
-
 /*
  * Register one async manage probe in the cookie jar.
  *
@@ -194,6 +197,47 @@ bool should_focus_on_map(const client_hot_t* hot) {
   return false;
 }
 
+// Arena strings go with the arena, interned names drop their reference
+static void client_release_strings(client_cold_t* cold) {
+  arena_destroy(&cold->string_arena);
+  str_intern_release(cold->wm_instance);
+  str_intern_release(cold->wm_class);
+  str_intern_release(cold->wm_client_machine);
+  str_intern_release(cold->wm_command);
+  cold->wm_instance = NULL;
+  cold->wm_class = NULL;
+  cold->wm_client_machine = NULL;
+  cold->wm_command = NULL;
+}
+
+// Bytes arena_strdup takes for s, alignment included
+static size_t client_arena_str_bytes(const char* s) {
+  return s ? (strlen(s) + 1u + 7u) & ~(size_t)7u : 0;
+}
+
+size_t client_compact_strings(client_cold_t* cold) {
+  arena_t* a = &cold->string_arena;
+  size_t live = client_arena_str_bytes(cold->base_title) + client_arena_str_bytes(cold->base_icon_name);
+  size_t dead = a->used > live ? a->used - live : 0;
+  if (dead <= CLIENT_STRING_DEAD_MAX || dead <= live)
+    return 0;
+
+  arena_t fresh;
+  arena_init(&fresh, a->block_size);
+  bool title_aliased = cold->title == cold->base_title;
+  if (cold->base_title)
+    cold->base_title = arena_strdup(&fresh, cold->base_title);
+  if (cold->base_icon_name)
+    cold->base_icon_name = arena_strdup(&fresh, cold->base_icon_name);
+  if (title_aliased)
+    cold->title = cold->base_title;
+
+  size_t released = a->reserved > fresh.reserved ? a->reserved - fresh.reserved : 0;
+  arena_destroy(a);
+  *a = fresh;
+  return released;
+}
+
 static bool should_hide_for_show_desktop(const client_hot_t* hot) {
   assert(hot);
   return hot->type != WINDOW_TYPE_DOCK && hot->type != WINDOW_TYPE_DESKTOP;
@@ -208,6 +252,18 @@ bool client_has_fixed_size(const client_cold_t* cold) {
          cold->hints.min_w == cold->hints.max_w && cold->hints.min_h == cold->hints.max_h;
 }
 
+bool client_pid_local(const client_cold_t* cold) {
+  if (cold->pid == 0 || cold->pid > INT32_MAX)
+    return false;
+  if (!cold->wm_client_machine)
+    return true;
+  char host[256];
+  if (gethostname(host, sizeof(host)) < 0)
+    return false;
+  host[sizeof(host) - 1] = '\0';
+  return strcmp(host, cold->wm_client_machine) == 0;
+}
+
 static uint16_t clamp_u16_from_i64(int64_t v) {
   if (v < 0)
     return 0;
@@ -226,30 +282,151 @@ void client_abort_manage(server_t* s, handle_t h) {
   if (purged > 0) {
     LOG_DEBUG("Purged %zu pending cookies for aborted client handle %lx", purged, h);
   }
+  wm_prop_fetch_forget(s, hot->xid);
+  handoff_consume(&s->handoff, hot->xid);
 
   if (hot->xid != XCB_NONE) {
     // If we are aborting management (e.g. override_redirect or setup failure),
     // make sure the window is mapped so it appears.
     xcb_map_window(s->conn, hot->xid);
-    hash_map_remove(&s->window_to_client, hot->xid);
+    server_xid_unbind(s, hot->xid, XID_CLIENT);
   }
   if (hot->frame != XCB_NONE)
-    hash_map_remove(&s->frame_to_client, hot->frame);
+    server_xid_unbind(s, hot->frame, XID_FRAME);
 
-  arena_destroy(&cold->string_arena);
+  client_release_strings(cold);
   if (cold->colormap_windows) {
     free(cold->colormap_windows);
     cold->colormap_windows = NULL;
     cold->colormap_windows_len = 0;
   }
   client_visual_payload_destroy(s->conn, cold);
+  client_frame_backing_destroy(s->conn, cold);
   client_render_payload_destroy(cold);
 
-  small_vec_remove(&s->active_clients, handle_to_ptr(h));
+  screen_t* scr = client_screen(s, hot);
+  spatial_index_remove(&scr->frame_index, h);
+  handle_vec_remove(&s->active_clients, h);
+  wm_desktop_members_remove(s, h);
+  wm_tiling_remove(s, h);
+  if (handle_vec_remove(&scr->strut_clients, h))
+    wm_workarea_invalidate(scr);
   slotmap_free(&s->clients, h);
 
-  s->root_dirty |= ROOT_DIRTY_CLIENT_LIST;
-  s->workarea_dirty = true;
+  scr->root_dirty |= ROOT_DIRTY_CLIENT_LIST;
+  scr->workarea_dirty = true;
+}
+
+/*
+ * Properties a restart handoff carries and that are not probed again. The
+ * names are carried too, but only as the first paint: a client can retitle
+ * between the snapshot and our PropertyChange selection, so they are still
+ * fetched.
+ */
+static bool client_handoff_carries(xcb_atom_t prop) {
+  return prop == atoms.WM_CLASS || prop == atoms.WM_CLIENT_MACHINE || prop == atoms.WM_COMMAND || prop == atoms._NET_WM_DESKTOP;
+}
+
+static char* client_handoff_strdup(client_cold_t* cold, const char* str) {
+  return str ? arena_strdup(&cold->string_arena, str) : NULL;
+}
+
+static void client_restore_handoff_names(server_t* s, client_hot_t* hot, client_cold_t* cold, const handoff_client_t* carried) {
+  cold->wm_class = str_intern(carried->str[HANDOFF_STR_CLASS]);
+  cold->wm_instance = str_intern(carried->str[HANDOFF_STR_INSTANCE]);
+  cold->base_title = client_handoff_strdup(cold, carried->str[HANDOFF_STR_TITLE]);
+  cold->title = cold->base_title;
+  cold->base_icon_name = client_handoff_strdup(cold, carried->str[HANDOFF_STR_ICON_NAME]);
+  cold->wm_client_machine = str_intern(carried->str[HANDOFF_STR_CLIENT_MACHINE]);
+  cold->wm_command = str_intern(carried->str[HANDOFF_STR_COMMAND]);
+  cold->has_net_wm_name = (carried->flags & HANDOFF_NET_WM_NAME) != 0;
+  cold->has_net_wm_icon_name = (carried->flags & HANDOFF_NET_WM_ICON_NAME) != 0;
+  client_set_desktop(s, hot, carried->desktop);
+  client_set_sticky(s, hot, (carried->flags & HANDOFF_STICKY) != 0);
+}
+
+/*
+ * The previous process already placed this window: put it back where it was
+ * instead of running placement, and keep the layer and iconic state.
+ */
+static void client_apply_handoff(server_t* s, client_hot_t* hot, const handoff_client_t* carried) {
+  client_set_desktop(s, hot, carried->desktop);
+  client_set_sticky(s, hot, (carried->flags & HANDOFF_STICKY) != 0);
+  hot->base_layer = carried->base_layer;
+  if (hot->layer != LAYER_FULLSCREEN)
+    hot->layer = client_layer_from_state(hot);
+  hot->desired = carried->geom;
+  hot->initial_state = (carried->flags & HANDOFF_ICONIC) ? XCB_ICCCM_WM_STATE_ICONIC : XCB_ICCCM_WM_STATE_NORMAL;
+}
+
+/* Which of the manage-time property probes client_queue_probe_props issues */
+typedef enum probe_set {
+  PROBE_ALL = 0,
+  PROBE_EAGER,       /* what placement, rules and framing need; no names */
+  PROBE_EAGER_NAMES, /* PROBE_EAGER plus the names, for rules on title */
+  PROBE_DEFERRED,    /* everything PROBE_EAGER leaves out */
+} probe_set_t;
+
+/*
+ * Phase 1 property probes. Completion is bitmask-driven from the required
+ * critical probes, none of which is ever deferred. Deferred ones only matter
+ * once the window is shown or focused.
+ */
+static void client_queue_probe_props(server_t* s, handle_t h, xcb_window_t win, const handoff_client_t* carried, probe_set_t set) {
+  enum { EAGER = 0, DEFER = 1, NAME = 2 };
+  const struct {
+    xcb_atom_t prop;
+    xcb_atom_t type;
+    uint32_t long_len;
+    uint8_t when;
+  } props[] = {
+      {atoms.WM_CLASS, XCB_ATOM_STRING, 1024, EAGER},
+      {atoms.WM_CLIENT_MACHINE, XCB_ATOM_STRING, 1024, EAGER},
+      {atoms.WM_COMMAND, XCB_ATOM_STRING, 1024, DEFER},
+      {atoms.WM_HINTS, atoms.WM_HINTS, 32, EAGER},
+      {atoms.WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 32, EAGER},
+      {atoms.WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 1, EAGER},
+      {atoms.WM_COLORMAP_WINDOWS, XCB_ATOM_WINDOW, 64, DEFER},
+      {atoms._NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 32, EAGER},
+      {atoms.WM_PROTOCOLS, XCB_ATOM_ATOM, 32, EAGER},
+      {atoms._NET_WM_NAME, atoms.UTF8_STRING, 1024, NAME},
+      {atoms.WM_NAME, XCB_ATOM_STRING, 1024, NAME},
+      {atoms._NET_WM_ICON_NAME, atoms.UTF8_STRING, 1024, NAME},
+      {atoms.WM_ICON_NAME, XCB_ATOM_STRING, 1024, NAME},
+      {atoms._NET_WM_STATE, XCB_ATOM_ATOM, 32, EAGER},
+      {atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 1, EAGER},
+      {atoms._NET_WM_STRUT, XCB_ATOM_CARDINAL, 4, EAGER},
+      {atoms._NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 12, EAGER},
+      {atoms._NET_WM_PID, XCB_ATOM_CARDINAL, 1, EAGER},
+      {atoms._NET_WM_USER_TIME, XCB_ATOM_CARDINAL, 1, DEFER},
+      {atoms._NET_WM_USER_TIME_WINDOW, XCB_ATOM_WINDOW, 1, DEFER},
+      {atoms._NET_WM_SYNC_REQUEST_COUNTER, XCB_ATOM_CARDINAL, 1, DEFER},
+      {atoms._NET_WM_ICON_GEOMETRY, XCB_ATOM_CARDINAL, 4, DEFER},
+      {atoms._MOTIF_WM_HINTS, XCB_ATOM_ANY, 5, EAGER},
+      {atoms._GTK_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 4, EAGER},
+      {atoms._KDE_NET_WM_FRAME_STRUT, XCB_ATOM_CARDINAL, 4, DEFER},
+      {atoms._NET_WM_WINDOW_OPACITY, XCB_ATOM_CARDINAL, 1, DEFER},
+      {atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 1, DEFER},
+  };
+
+  for (size_t i = 0; i < ARRAY_LEN(props); i++) {
+    bool eager = props[i].when == EAGER || (props[i].when == NAME && set == PROBE_EAGER_NAMES);
+    if (set != PROBE_ALL && eager == (set == PROBE_DEFERRED))
+      continue;
+    if (carried && client_handoff_carries(props[i].prop))
+      continue;
+    client_queue_get_property(s, h, win, props[i].prop, props[i].type, props[i].long_len);
+  }
+}
+
+/* Whether any rule matches on title, which then needs the names at manage */
+static bool client_rules_use_title(const server_t* s) {
+  for (size_t i = 0; i < s->config.rules.length; i++) {
+    const app_rule_t* r = (const app_rule_t*)s->config.rules.items[i];
+    if (r && r->title_match)
+      return true;
+  }
+  return false;
 }
 
 /*
@@ -280,8 +457,8 @@ void client_abort_manage(server_t* s, handle_t h) {
  *   wm_handle_reply() records critical probe completion bits. Once all required
  *   bits are present, client_finish_manage() completes framing.
  */
-void client_manage_start(server_t* s, xcb_window_t win) {
-  TRACE_LOG("manage_start win=%u", win);
+static void client_manage_begin(server_t* s, xcb_window_t win, bool deferred) {
+  TRACE_LOG("manage_start win=%u deferred=%d", win, deferred);
   assert(win != XCB_NONE);
   if (server_get_client_by_window(s, win) != HANDLE_INVALID) {
     LOG_DEBUG("Already managing window %u", win);
@@ -289,11 +466,12 @@ void client_manage_start(server_t* s, xcb_window_t win) {
   }
   /* Single-owner invariant: no managed frame/window may alias this XID. */
   assert(server_get_client_by_frame(s, win) == HANDLE_INVALID);
+  TP_MANAGE_START(win);
 
   // Allocate slot for hot/cold client storage
   void* hot_ptr = NULL;
   void* cold_ptr = NULL;
-  handle_t h = slotmap_alloc(&s->clients, &hot_ptr, &cold_ptr);
+  handle_t h = slotmap_alloc_grow(&s->clients, &hot_ptr, &cold_ptr);
   assert(h != HANDLE_INVALID);
   assert(hot_ptr != NULL);
   assert(cold_ptr != NULL);
@@ -301,10 +479,11 @@ void client_manage_start(server_t* s, xcb_window_t win) {
 
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   client_cold_t* cold = (client_cold_t*)cold_ptr;
+  manage_timing_mark(&cold->manage_timing, MANAGE_MARK_START, monotonic_time_ns());
 
   hot->self = h;
-  hot->xid = win;
-  hot->state = STATE_NEW;
+  client_set_xid(s, hot, win);
+  client_set_state(s, hot, STATE_NEW);
 
   hot->initial_state = XCB_ICCCM_WM_STATE_NORMAL;
 
@@ -313,8 +492,10 @@ void client_manage_start(server_t* s, xcb_window_t win) {
 
   hot->state_above = false;
   hot->state_below = false;
-  hot->desktop = (int32_t)s->current_desktop;
-  hot->sticky = false;
+  // Provisional until the geometry reply names the root, see client_note_root
+  client_set_screen(s, hot, (uint8_t)s->active_screen);
+  client_set_desktop(s, hot, (int32_t)server_screen(s)->current_desktop);
+  client_set_sticky(s, hot, false);
   hot->skip_taskbar = false;
   hot->skip_pager = false;
   hot->net_wm_desktop_seen = false;
@@ -332,14 +513,16 @@ void client_manage_start(server_t* s, xcb_window_t win) {
   hot->last_cursor_dir = -1;
 
   client_render_payload_init(cold);
-  client_visual_payload_init(cold, s->root_visual);
+  client_visual_payload_init(cold, server_screen(s)->root_visual);
   client_sync_payload_init(cold);
   client_manage_staging_init(cold);
   client_optional_state_init(cold);
 
   cold->damage = XCB_NONE;
   dirty_region_reset(&cold->damage_region);
-  dirty_region_reset(&cold->frame_damage);
+  dirty_rects_reset(&cold->frame_damage);
+  cold->title_deferred = false;
+  cold->title_refresh_ms = 0;
 
   hot->ignore_unmap = 1;
   hot->override_redirect = false;
@@ -348,43 +531,10 @@ void client_manage_start(server_t* s, xcb_window_t win) {
   cold->user_time = 0;
   cold->user_time_window = XCB_NONE;
 
-  hot->original_border_width = 0;
+  // _NET_WM_ICON is not probed here; the first draw fetches it
+  cold->icon_fetch.phase = ICON_FETCH_WANTED;
 
-  // Phase 1 probes. Completion is bitmask-driven from required critical probes.
-  const struct {
-    xcb_atom_t prop;
-    xcb_atom_t type;
-    uint32_t long_len;
-  } props[] = {
-      {atoms.WM_CLASS, XCB_ATOM_STRING, 1024},
-      {atoms.WM_CLIENT_MACHINE, XCB_ATOM_STRING, 1024},
-      {atoms.WM_COMMAND, XCB_ATOM_STRING, 1024},
-      {atoms.WM_HINTS, atoms.WM_HINTS, 32},
-      {atoms.WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 32},
-      {atoms.WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 1},
-      {atoms.WM_COLORMAP_WINDOWS, XCB_ATOM_WINDOW, 64},
-      {atoms._NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 32},
-      {atoms.WM_PROTOCOLS, XCB_ATOM_ATOM, 32},
-      {atoms._NET_WM_NAME, atoms.UTF8_STRING, 1024},
-      {atoms.WM_NAME, XCB_ATOM_STRING, 1024},
-      {atoms._NET_WM_ICON_NAME, atoms.UTF8_STRING, 1024},
-      {atoms.WM_ICON_NAME, XCB_ATOM_STRING, 1024},
-      {atoms._NET_WM_STATE, XCB_ATOM_ATOM, 32},
-      {atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 1},
-      {atoms._NET_WM_STRUT, XCB_ATOM_CARDINAL, 4},
-      {atoms._NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 12},
-      {atoms._NET_WM_ICON, XCB_ATOM_CARDINAL, NET_WM_ICON_LONG_LEN},
-      {atoms._NET_WM_PID, XCB_ATOM_CARDINAL, 1},
-      {atoms._NET_WM_USER_TIME, XCB_ATOM_CARDINAL, 1},
-      {atoms._NET_WM_USER_TIME_WINDOW, XCB_ATOM_WINDOW, 1},
-      {atoms._NET_WM_SYNC_REQUEST_COUNTER, XCB_ATOM_CARDINAL, 1},
-      {atoms._NET_WM_ICON_GEOMETRY, XCB_ATOM_CARDINAL, 4},
-      {atoms._MOTIF_WM_HINTS, XCB_ATOM_ANY, 5},
-      {atoms._GTK_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 4},
-      {atoms._KDE_NET_WM_FRAME_STRUT, XCB_ATOM_CARDINAL, 4},
-      {atoms._NET_WM_WINDOW_OPACITY, XCB_ATOM_CARDINAL, 1},
-      {atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 1},
-  };
+  hot->original_border_width = 0;
 
   hot->probe_required_mask =
       MANAGE_PROBE_ATTR | MANAGE_PROBE_GEOMETRY | MANAGE_PROBE_WINDOW_TYPE | MANAGE_PROBE_TRANSIENT_FOR | MANAGE_PROBE_WM_HINTS;
@@ -395,21 +545,29 @@ void client_manage_start(server_t* s, xcb_window_t win) {
   cold->strut_full_active = false;
   arena_init(&cold->string_arena, 512);
 
-  list_init(&hot->focus_node);
+  // A window carried over a restart starts from its old names and class
+  const handoff_client_t* carried = handoff_find(&s->handoff, win);
+  if (carried)
+    client_restore_handoff_names(s, hot, cold, carried);
 
-  TRACE_LOG("manage_start init nodes h=%lx focus_node=%p", h, (void*)&hot->focus_node);
+  hot->focus_slot = 0;
 
   // Register mapping so we can find it
-  bool replaced = hash_map_insert(&s->window_to_client, win, handle_to_ptr(h));
+  bool replaced = server_xid_bind(s, win, XID_CLIENT, h);
   assert(!replaced);
   (void)replaced;
   assert(server_get_client_by_window(s, win) == h);
-  small_vec_push(&s->active_clients, handle_to_ptr(h));
-  TRACE_LOG("manage_start window_to_client[%u]=%lx", win, h);
+  handle_vec_push(&s->active_clients, h);
+  wm_desktop_members_sync(s, h);
+  TRACE_LOG("manage_start xid_index[%u]=%lx", win, h);
 
   uint32_t early_events = XCB_EVENT_MASK_PROPERTY_CHANGE;
   xcb_change_window_attributes(s->conn, win, XCB_CW_EVENT_MASK, &early_events);
 
+  // Every phase 1 probe joins one group; the client is promoted once all replied
+  uint64_t txn = ++s->txn_id;
+  cookie_jar_group_begin(&s->cookie_jar, txn, h, wm_handle_manage_complete);
+
   // Query window attributes (override_redirect, visual, etc)
   uint32_t c1 = xcb_get_window_attributes(s->conn, win).sequence;
   client_enqueue_manage_reply(s, h, c1, COOKIE_GET_WINDOW_ATTRIBUTES, win);
@@ -418,14 +576,183 @@ void client_manage_start(server_t* s, xcb_window_t win) {
   uint32_t c2 = xcb_get_geometry(s->conn, win).sequence;
   client_enqueue_manage_reply(s, h, c2, COOKIE_GET_GEOMETRY, win);
 
-  for (size_t i = 0; i < ARRAY_LEN(props); i++) {
-    client_queue_get_property(s, h, win, props[i].prop, props[i].type, props[i].long_len);
-  }
+  // Names decide rules matching on title, so they can only wait without any
+  hot->probe_deferred = deferred;
+  client_queue_probe_props(s, h, win, carried, deferred ? (client_rules_use_title(s) ? PROBE_EAGER_NAMES : PROBE_EAGER) : PROBE_ALL);
+
+  cookie_jar_group_end(&s->cookie_jar, s);
 
   LOG_DEBUG("Started management for window %u (handle %lx)", win, h);
   TRACE_ONLY(diag_dump_focus_history(s, "after manage_start"));
 }
 
+void client_manage_start(server_t* s, xcb_window_t win) {
+  client_manage_begin(s, win, false);
+}
+
+void client_manage_start_deferred(server_t* s, xcb_window_t win) {
+  client_manage_begin(s, win, true);
+}
+
+/*
+ * Deferred probe replies land like PropertyNotify refetches: each one goes
+ * through its wm_prop_desc_t reply hook whatever the manage phase, so a
+ * title that arrives after the frame is up just repaints it.
+ */
+void client_complete_probe(server_t* s, client_hot_t* hot) {
+  // Until the manage group lands, newer replies would make its own stale
+  if (!hot || !hot->probe_deferred || hot->state == STATE_NEW)
+    return;
+  hot->probe_deferred = false;
+  if (hot->xid == XCB_NONE || hot->state == STATE_UNMANAGING)
+    return;
+  TRACE_LOG("complete_probe h=%lx xid=%u", hot->self, hot->xid);
+  client_queue_probe_props(s, hot->self, hot->xid, NULL, PROBE_DEFERRED);
+}
+
+/*
+ * Manage starts a client on the active screen; the geometry reply names the
+ * root it really lives under. Moving it takes it out of the old screen's
+ * desktop lists first, since those are found through its screen.
+ */
+void client_note_root(server_t* s, client_hot_t* hot, xcb_window_t root) {
+  screen_t* scr = server_screen_of_root(s, root);
+  if (!scr || scr == client_screen(s, hot))
+    return;
+  TRACE_LOG("note_root h=%lx screen=%u", hot->self, (unsigned)server_screen_index(s, scr));
+  wm_desktop_members_remove(s, hot->self);
+  client_set_screen(s, hot, (uint8_t)server_screen_index(s, scr));
+  if (!hot->net_wm_desktop_seen && !hot->sticky)
+    client_set_desktop(s, hot, (int32_t)scr->current_desktop);
+  wm_desktop_members_sync(s, hot->self);
+}
+
+/*
+ * Queue one windowed read of _NET_WM_ICON.
+ *
+ * data packs:
+ *   high 32 bits: icon fetch generation
+ *   low  32 bits: word offset of the read
+ */
+static bool client_icon_queue_read(server_t* s, handle_t h, cookie_type_t type, uint32_t offset, uint32_t words) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold || hot->xid == XCB_NONE)
+    return false;
+
+  uint32_t seq = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_ICON, XCB_ATOM_CARDINAL, offset, words).sequence;
+  if (seq == 0)
+    return false;
+  cookie_jar_push(&s->cookie_jar, seq, type, h, ((uint64_t)cold->icon_fetch.gen << 32) | offset, s->txn_id, wm_handle_reply);
+  return true;
+}
+
+bool client_icon_read_header(server_t* s, handle_t h, uint32_t offset) {
+  return client_icon_queue_read(s, h, COOKIE_GET_PROPERTY_ICON_HEADER, offset, 2);
+}
+
+bool client_icon_read_pixels(server_t* s, handle_t h, uint32_t offset, uint32_t words) {
+  return client_icon_queue_read(s, h, COOKIE_GET_PROPERTY_ICON_PIXELS, offset, words);
+}
+
+/*
+ * Start the icon fetch if one is wanted. Called from draw paths, so clients
+ * that are never drawn never pay for their icon.
+ */
+void client_icon_request(server_t* s, handle_t h) {
+  client_cold_t* cold = server_ccold(s, h);
+  if (!cold || cold->icon_fetch.phase != ICON_FETCH_WANTED)
+    return;
+
+  icon_fetch_t* f = &cold->icon_fetch;
+  f->offset = 0;
+  f->best_offset = 0;
+  f->best_w = 0;
+  f->best_h = 0;
+  f->best_diff = UINT32_MAX;
+  f->icons_seen = 0;
+  f->total_pixels = 0;
+  f->phase = ICON_FETCH_SCANNING;
+
+  if (!client_icon_read_header(s, h, 0))
+    f->phase = ICON_FETCH_WANTED;
+}
+
+/*
+ * _NET_WM_ICON changed. Drop in-flight reads; refetch right away only if the
+ * icon was already in use, otherwise wait for the first draw.
+ */
+void client_icon_invalidate(server_t* s, handle_t h) {
+  client_cold_t* cold = server_ccold(s, h);
+  if (!cold)
+    return;
+
+  bool in_use = cold->icon_fetch.phase != ICON_FETCH_WANTED;
+  cold->icon_fetch.gen++;
+  cold->icon_fetch.phase = ICON_FETCH_WANTED;
+  if (in_use)
+    client_icon_request(s, h);
+}
+
+void client_damage_subscribe(server_t* s, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold || !s->damage_supported || cold->damage_refs == UINT8_MAX)
+    return;
+
+  if (cold->damage_refs++ > 0)
+    return;
+  cold->damage = xcb_generate_id(s->conn);
+  xcb_damage_create(s->conn, cold->damage, hot->xid, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+  dirty_region_reset(&cold->damage_region);
+  TRACE_LOG("damage subscribe h=%lx xid=%u damage=%u", h, hot->xid, cold->damage);
+}
+
+void client_damage_unsubscribe(server_t* s, handle_t h) {
+  client_cold_t* cold = server_ccold(s, h);
+  if (!cold || cold->damage_refs == 0)
+    return;
+
+  if (--cold->damage_refs > 0)
+    return;
+  if (cold->damage != XCB_NONE) {
+    xcb_damage_destroy(s->conn, cold->damage);
+    cold->damage = XCB_NONE;
+  }
+  dirty_region_reset(&cold->damage_region);
+}
+
+rule_subject_t client_rule_subject(const client_hot_t* hot, const client_cold_t* cold) {
+  return (rule_subject_t){
+      .wm_class = cold->wm_class,
+      .wm_instance = cold->wm_instance,
+      .title = cold->title,
+      .interned = true,
+      .type = hot->type,
+      .transient = hot->transient_for != HANDLE_INVALID,
+  };
+}
+
+static void client_rule_bypass_compositor(server_t* s, client_hot_t* hot, client_cold_t* cold, int8_t value) {
+  if (value == 0) {
+    cold->bypass_compositor_valid = false;
+    cold->bypass_compositor = 0;
+    xcb_delete_property(s->conn, hot->xid, atoms._NET_WM_BYPASS_COMPOSITOR);
+    if (hot->frame != XCB_NONE) {
+      xcb_delete_property(s->conn, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR);
+    }
+  }
+  else {
+    uint32_t val = (uint32_t)value;
+    cold->bypass_compositor_valid = true;
+    cold->bypass_compositor = val;
+    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 32, 1, &val);
+    if (hot->frame != XCB_NONE) {
+      xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 32, 1, &val);
+    }
+  }
+}
+
 static void client_apply_rules(server_t* s, handle_t h) {
   client_hot_t* hot = server_chot(s, h);
   client_cold_t* cold = server_ccold(s, h);
@@ -435,82 +762,103 @@ static void client_apply_rules(server_t* s, handle_t h) {
   bool is_panel = (hot->type == WINDOW_TYPE_DOCK || hot->type == WINDOW_TYPE_DESKTOP);
   bool keep_sticky = is_panel && hot->sticky;
 
-  for (size_t i = 0; i < s->config.rules.length; i++) {
-    app_rule_t* r = s->config.rules.items[i];
-    bool matched = true;
-
-    if (r->class_match && (!cold->wm_class || strcmp(cold->wm_class, r->class_match) != 0))
-      matched = false;
-    if (matched && r->instance_match && (!cold->wm_instance || strcmp(cold->wm_instance, r->instance_match) != 0))
-      matched = false;
-    if (matched && r->title_match && (!cold->title || !strstr(cold->title, r->title_match)))
-      matched = false;
-    if (matched && r->type_match != -1 && hot->type != (uint8_t)r->type_match)
-      matched = false;
-    if (matched && r->transient_match != -1) {
-      bool is_transient = (hot->transient_for != HANDLE_INVALID);
-      if (is_transient != (bool)r->transient_match)
-        matched = false;
-    }
-
-    if (matched) {
-      LOG_INFO("Rule matched for window %u", hot->xid);
-
-      if (r->desktop != -2) {
-        if (r->desktop == -1) {
-          hot->desktop = -1;
-          hot->sticky = true;
-          if (is_panel)
-            keep_sticky = true;
-        }
-        else {
-          hot->desktop = r->desktop;
-          if (!keep_sticky) {
-            hot->sticky = false;
-          }
-        }
+  rule_subject_t subj = client_rule_subject(hot, cold);
+  // Rules pushed after load (or a config never loaded) are compiled here
+  rule_set_sync(&s->config.rule_set, &s->config.rules);
+  const uint32_t* hits = NULL;
+  size_t hit_count = rule_set_match(&s->config.rule_set, &subj, &hits);
+
+  for (size_t i = 0; i < hit_count; i++) {
+    const app_rule_t* r = s->config.rule_set.rules[hits[i]];
+    LOG_INFO("Rule matched for window %u", hot->xid);
+
+    if (r->desktop != -2) {
+      if (r->desktop == -1) {
+        client_set_desktop(s, hot, -1);
+        client_set_sticky(s, hot, true);
+        if (is_panel)
+          keep_sticky = true;
       }
-
-      if (r->layer != -1) {
-        hot->base_layer = (uint8_t)r->layer;
-        if (hot->layer != LAYER_FULLSCREEN) {
-          hot->layer = client_layer_from_state(hot);
+      else {
+        client_set_desktop(s, hot, r->desktop);
+        if (!keep_sticky) {
+          client_set_sticky(s, hot, false);
         }
       }
+    }
 
-      if (r->focus != -1)
-        hot->focus_override = r->focus;
-      if (r->placement != PLACEMENT_DEFAULT)
-        hot->placement = (uint8_t)r->placement;
-
-      if (r->bypass_compositor != -1) {
-        if (r->bypass_compositor == 0) {
-          cold->bypass_compositor_valid = false;
-          cold->bypass_compositor = 0;
-          xcb_delete_property(s->conn, hot->xid, atoms._NET_WM_BYPASS_COMPOSITOR);
-          if (hot->frame != XCB_NONE) {
-            xcb_delete_property(s->conn, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR);
-          }
-        }
-        else {
-          uint32_t val = (uint32_t)r->bypass_compositor;
-          cold->bypass_compositor_valid = true;
-          cold->bypass_compositor = val;
-          xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 32, 1, &val);
-          if (hot->frame != XCB_NONE) {
-            xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 32, 1, &val);
-          }
-        }
+    if (r->layer != -1) {
+      hot->base_layer = (uint8_t)r->layer;
+      if (hot->layer != LAYER_FULLSCREEN) {
+        hot->layer = client_layer_from_state(hot);
       }
     }
+
+    if (r->focus != -1)
+      hot->focus_override = r->focus;
+    if (r->placement != PLACEMENT_DEFAULT)
+      hot->placement = (uint8_t)r->placement;
+
+    if (r->outline != -1) {
+      hot->flags &= (uint16_t)~(CLIENT_FLAG_OUTLINE_DRAG | CLIENT_FLAG_LIVE_DRAG);
+      hot->flags |= r->outline ? CLIENT_FLAG_OUTLINE_DRAG : CLIENT_FLAG_LIVE_DRAG;
+    }
+    if (r->freeze != -1)
+      hot->flags = r->freeze ? (uint16_t)(hot->flags | CLIENT_FLAG_FREEZE) : (uint16_t)(hot->flags & ~CLIENT_FLAG_FREEZE);
+
+    if (r->bypass_compositor != -1)
+      client_rule_bypass_compositor(s, hot, cold, r->bypass_compositor);
   }
 
   if (is_panel && hot->sticky) {
-    hot->desktop = -1;
+    client_set_desktop(s, hot, -1);
   }
 
-  if (!hot->sticky && hot->desktop >= (int32_t)s->desktop_count) {
-    hot->desktop = (int32_t)s->current_desktop;
+  const screen_t* scr = client_screen(s, hot);
+  if (!hot->sticky && hot->desktop >= (int32_t)scr->desktop_count) {
+    client_set_desktop(s, hot, (int32_t)scr->current_desktop);
+  }
+}
+
+/*
+ * Class, instance or title changed on a managed window. Live rules reading a
+ * changed field that match now but did not match before are applied, the way
+ * a user would have moved the window; placement no longer applies.
+ */
+void client_rules_changed(server_t* s, handle_t h, uint8_t changed, const rule_subject_t* before) {
+  rule_set_t* set = &s->config.rule_set;
+  if (!(set->live_deps & changed))
+    return;
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold || (hot->state != STATE_MAPPED && hot->state != STATE_UNMAPPED))
+    return;
+
+  rule_subject_t subj = client_rule_subject(hot, cold);
+  const uint32_t* hits = NULL;
+  size_t hit_count = rule_set_match_live(set, &subj, changed, &hits);
+
+  for (size_t i = 0; i < hit_count; i++) {
+    const app_rule_t* r = set->rules[hits[i]];
+    if (before && rule_matches(r, before))
+      continue;
+    LOG_INFO("Live rule matched for window %u", hot->xid);
+
+    if (r->desktop != -2)
+      wm_client_move_to_workspace(s, h, r->desktop == -1 ? 0xFFFFFFFFu : (uint32_t)r->desktop, false);
+    if (r->layer != -1 && hot->base_layer != (uint8_t)r->layer) {
+      hot->base_layer = (uint8_t)r->layer;
+      if (hot->layer != LAYER_FULLSCREEN) {
+        hot->layer = client_layer_from_state(hot);
+        stack_move_to_layer(s, h);
+      }
+    }
+    if (r->focus != -1)
+      hot->focus_override = r->focus;
+    if (r->freeze != -1)
+      hot->flags = r->freeze ? (uint16_t)(hot->flags | CLIENT_FLAG_FREEZE) : (uint16_t)(hot->flags & ~CLIENT_FLAG_FREEZE);
+    if (r->bypass_compositor != -1)
+      client_rule_bypass_compositor(s, hot, cold, r->bypass_compositor);
   }
 }
 
@@ -545,16 +893,22 @@ void client_finish_manage(server_t* s, handle_t h) {
   assert(cold);
   bool is_conky = client_is_conky(cold);
   TRACE_LOG("finish_manage h=%lx xid=%u desktop=%d sticky=%d initial_state=%u", h, hot->xid, hot->desktop, hot->sticky, hot->initial_state);
+  TP_MANAGE_FINISH(hot->xid);
+  manage_timing_mark(&cold->manage_timing, MANAGE_MARK_FINISH, monotonic_time_ns());
 
   /* Ensure canonical window ownership mapping before frame setup. */
   handle_t owner = server_get_client_by_window(s, hot->xid);
   if (owner != h) {
-    hash_map_insert(&s->window_to_client, hot->xid, handle_to_ptr(h));
+    server_xid_bind(s, hot->xid, XID_CLIENT, h);
   }
 
   client_apply_rules(s, h);
 
-  wm_place_window(s, h);
+  const handoff_client_t* carried = handoff_find(&s->handoff, hot->xid);
+  if (carried)
+    client_apply_handoff(s, hot, carried);
+  else
+    wm_place_window(s, h);
 
   // Subscribe to client events before framing/mapping
   uint32_t client_events = XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_FOCUS_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY;
@@ -576,11 +930,10 @@ void client_finish_manage(server_t* s, handle_t h) {
   }
   else {
     mask |= XCB_CW_BACK_PIXEL;
-    values[values_len++] = 0x333333;
+    values[values_len++] = FRAME_BACKGROUND_PIXEL;
   }
 
-  values[values_len++] =
-      XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW;
+  values[values_len++] = FRAME_EVENT_MASK;
   assert(values_len == 2);
 
   uint16_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
@@ -635,19 +988,33 @@ void client_finish_manage(server_t* s, handle_t h) {
   if (hot->frame != XCB_NONE) {
     handle_t frame_owner = server_get_client_by_frame(s, hot->frame);
     if (frame_owner == h)
-      hash_map_remove(&s->frame_to_client, hot->frame);
+      server_xid_unbind(s, hot->frame, XID_FRAME);
     hot->frame = XCB_NONE;
   }
-  hot->frame = xcb_generate_id(s->conn);
-  xcb_create_window(s->conn, s->root_depth, hot->frame, s->root, (int16_t)frame_x, (int16_t)frame_y, (uint16_t)frame_w, (uint16_t)frame_h, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, s->root_visual,
-                    mask, values);
+  // A pooled frame comes with a render context that only needs retargeting
+  xcb_window_t pooled = XCB_NONE;
+  render_context_t pooled_render;
+  const screen_t* scr = client_screen(s, hot);
+  if (frame_pool_take(&s->frame_pool, scr->root, (uint8_t)scr->root_depth, scr->root_visual, &pooled, &pooled_render)) {
+    render_free(&cold->render_ctx);
+    cold->render_ctx = pooled_render;
+    hot->frame = pooled;
+    uint32_t frame_values[] = {(uint32_t)frame_x, (uint32_t)frame_y, frame_w, frame_h};
+    xcb_configure_window(s->conn, hot->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, frame_values);
+    xcb_change_window_attributes(s->conn, hot->frame, mask, values);
+  }
+  else {
+    hot->frame = xcb_generate_id(s->conn);
+    xcb_create_window(s->conn, scr->root_depth, hot->frame, scr->root, (int16_t)frame_x, (int16_t)frame_y, (uint16_t)frame_w, (uint16_t)frame_h, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      scr->root_visual, mask, values);
+  }
 
   // Register frame mapping
-  bool frame_replaced = hash_map_insert(&s->frame_to_client, hot->frame, handle_to_ptr(h));
+  bool frame_replaced = server_xid_bind(s, hot->frame, XID_FRAME, h);
   assert(!frame_replaced);
   (void)frame_replaced;
   if (server_get_client_by_window(s, hot->xid) != h)
-    hash_map_insert(&s->window_to_client, hot->xid, handle_to_ptr(h));
+    server_xid_bind(s, hot->xid, XID_CLIENT, h);
 
   // Add to SaveSet for crash safety
   xcb_change_save_set(s->conn, XCB_SET_MODE_INSERT, hot->xid);
@@ -685,7 +1052,8 @@ void client_finish_manage(server_t* s, handle_t h) {
   hot->server.y = (int16_t)frame_y;
   hot->server.w = (uint16_t)client_w;
   hot->server.h = (uint16_t)client_h;
-  hot->dirty |= DIRTY_GEOM;
+  wm_client_update_monitor(s, hot);
+  server_mark_dirty(s, hot, DIRTY_GEOM);
 
   // Set _NET_FRAME_EXTENTS before mapping
   // if ((hot->flags & CLIENT_FLAG_UNDECORATED) || cold->gtk_frame_extents_set) {
@@ -730,12 +1098,17 @@ void client_finish_manage(server_t* s, handle_t h) {
   // ---------------------------------------------------------
   // Mapping and visibility
   // ---------------------------------------------------------
+  // Rules, hints and handoff may all have moved it since manage started
+  wm_desktop_members_sync(s, h);
+
   // Map only if visible on current desktop and not requested to start iconic
-  bool visible = (hot->sticky || (hot->desktop == (int32_t)s->current_desktop)) && (hot->initial_state != XCB_ICCCM_WM_STATE_ICONIC);
+  bool visible = (hot->sticky || (hot->desktop == (int32_t)scr->current_desktop)) && (hot->initial_state != XCB_ICCCM_WM_STATE_ICONIC);
 
-  TRACE_LOG("finish_manage visibility h=%lx visible=%d current_desktop=%u", h, visible, s->current_desktop);
+  TRACE_LOG("finish_manage visibility h=%lx visible=%d current_desktop=%u", h, visible, scr->current_desktop);
 
   if (visible) {
+    // Adopted as hidden, but rules or its state put it on screen after all
+    client_complete_probe(s, hot);
     if (cold->sync_enabled && cold->sync_counter != XCB_NONE) {
       uint64_t sync_value = ++cold->sync_value;
       wm_send_sync_request(s, hot, sync_value, XCB_CURRENT_TIME);
@@ -743,33 +1116,33 @@ void client_finish_manage(server_t* s, handle_t h) {
 
     xcb_map_window(s->conn, hot->xid);
     xcb_map_window(s->conn, hot->frame);
-    hot->state = STATE_MAPPED;
+    manage_timing_mark(&cold->manage_timing, MANAGE_MARK_FRAME_MAP, monotonic_time_ns());
+    client_set_state(s, hot, STATE_MAPPED);
+    client_set_frame_vis(s, hot, FRAME_VIS_MAPPED);
 
     uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_NORMAL, XCB_NONE};
     xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
   }
   else {
-    hot->state = STATE_UNMAPPED;
+    client_set_state(s, hot, STATE_UNMAPPED);
+    // Its first paint waits on the user, not on us; leave it out of the stats
+    memset(&cold->manage_timing, 0, sizeof(cold->manage_timing));
 
     uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_ICONIC, XCB_NONE};
     xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
   }
 
   bool hidden_by_show_desktop = false;
-  if (s->showing_desktop && hot->state == STATE_MAPPED && should_hide_for_show_desktop(hot)) {
+  if (scr->showing_desktop && hot->state == STATE_MAPPED && should_hide_for_show_desktop(hot)) {
     hot->show_desktop_hidden = true;
     TRACE_LOG("finish_manage hide for show_desktop h=%lx xid=%u", h, hot->xid);
     wm_client_iconify(s, h);
     hidden_by_show_desktop = true;
   }
 
-  hot->dirty |= DIRTY_STATE;
+  server_mark_dirty(s, hot, DIRTY_STATE);
 
-  if (s->damage_supported) {
-    cold->damage = xcb_generate_id(s->conn);
-    xcb_damage_create(s->conn, cold->damage, hot->xid, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
-    dirty_region_reset(&cold->damage_region);
-  }
+  thumbnail_track(s, h);
 
   // Setup passive grabs for click-to-focus and Alt-move/resize
   client_setup_grabs(s, h);
@@ -827,19 +1200,22 @@ void client_finish_manage(server_t* s, handle_t h) {
 
   // Add to focus history
   TRACE_ONLY(diag_dump_focus_history(s, "before manage insert"));
-  if (hot->focus_node.next && hot->focus_node.next != &hot->focus_node) {
-    list_remove(&hot->focus_node);
-  }
-  list_insert(&hot->focus_node, &s->focus_history, s->focus_history.next);
+  wm_focus_history_insert(s, h, carried ? handoff_focus_anchor(s, carried, h) : 0);
   TRACE_ONLY(diag_dump_focus_history(s, "after manage insert"));
+  if (carried)
+    handoff_consume(&s->handoff, hot->xid);
 
   // Publish initial desktop
   uint32_t desk_prop = (uint32_t)hot->desktop;
   xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &desk_prop);
 
-  // Mark root properties dirty
-  s->root_dirty |= ROOT_DIRTY_CLIENT_LIST;
-  s->workarea_dirty = true;
+  // Mark root properties dirty; a strut read during manage may have been
+  // cached under the client's provisional desktop
+  screen_t* own = client_screen(s, hot);
+  own->root_dirty |= ROOT_DIRTY_CLIENT_LIST;
+  own->workarea_dirty = true;
+  if (handle_vec_find(&own->strut_clients, h) != SIZE_MAX)
+    wm_workarea_invalidate(own);
 
   // Transition to MANAGE_DONE and replay queued state messages
   cold->manage_phase = MANAGE_DONE;
@@ -897,7 +1273,7 @@ void client_finish_manage(server_t* s, handle_t h) {
  */
 static void client_detach_transient_children(server_t* s, handle_t parent_h) {
   for (size_t i = 0; i < s->active_clients.length; i++) {
-    handle_t child_h = ptr_to_handle(s->active_clients.items[i]);
+    handle_t child_h = s->active_clients.items[i];
     if (child_h == parent_h)
       continue;
 
@@ -905,7 +1281,7 @@ static void client_detach_transient_children(server_t* s, handle_t parent_h) {
     assert(child);
     if (child->transient_for == parent_h) {
       TRACE_LOG("unmanage unlink child parent=%lx child=%lx", parent_h, child_h);
-      child->transient_for = HANDLE_INVALID;
+      client_set_transient_for(s, child, HANDLE_INVALID);
     }
   }
 }
@@ -918,27 +1294,7 @@ static handle_t client_pick_focus_fallback(server_t* s, handle_t preferred_paren
       return preferred_parent;
   }
 
-  list_node_t* node = s->focus_history.next;
-#ifdef HXM_DEBUG_TRACE
-  int guard = 0;
-#endif
-  while (node != &s->focus_history) {
-    client_hot_t* cand = (client_hot_t*)((char*)node - offsetof(client_hot_t, focus_node));
-#ifdef HXM_DEBUG_TRACE
-    if (guard < 64) {
-      TRACE_LOG("unmanage focus scan[%d] node=%p h=%lx xid=%u state=%d", guard, (void*)node, cand->self, cand->xid, cand->state);
-    }
-    else if (guard == 64) {
-      TRACE_WARN("unmanage focus scan exceeded 64 entries");
-    }
-    guard++;
-#endif
-    if (cand->state == STATE_MAPPED)
-      return cand->self;
-    node = node->next;
-  }
-
-  return HANDLE_INVALID;
+  return wm_focus_history_pick(s, NULL, FOCUS_MRU_ANY_DESKTOP, FOCUS_MRU_MAPPED);
 }
 
 static void client_detach_logical(server_t* s, handle_t h, client_hot_t* hot) {
@@ -946,26 +1302,80 @@ static void client_detach_logical(server_t* s, handle_t h, client_hot_t* hot) {
   stack_remove(s, h);
 
   client_detach_transient_children(s, h);
-  hot->transient_for = HANDLE_INVALID;
+  client_set_transient_for(s, hot, HANDLE_INVALID);
 
-  if (hot->focus_node.next && hot->focus_node.next != &hot->focus_node) {
-    TRACE_LOG("unmanage focus_history remove h=%lx node=%p prev=%p next=%p", h, (void*)&hot->focus_node, (void*)hot->focus_node.prev, (void*)hot->focus_node.next);
-    list_remove(&hot->focus_node);
-    list_init(&hot->focus_node);
-  }
+  wm_focus_history_remove(s, h);
 
   if (hot->xid != XCB_NONE) {
     handle_t owner = server_get_client_by_window(s, hot->xid);
     assert(owner == HANDLE_INVALID || owner == h);
     if (owner == h)
-      hash_map_remove(&s->window_to_client, hot->xid);
+      server_xid_unbind(s, hot->xid, XID_CLIENT);
   }
   if (hot->frame != XCB_NONE) {
     handle_t owner = server_get_client_by_frame(s, hot->frame);
     assert(owner == HANDLE_INVALID || owner == h);
     if (owner == h)
-      hash_map_remove(&s->frame_to_client, hot->frame);
+      server_xid_unbind(s, hot->frame, XID_FRAME);
+  }
+}
+
+/*
+ * A window destroyed or withdrawn before client_finish_manage: it was never
+ * framed, reparented, added to the save-set or given WM properties, so there
+ * is nothing to undo on the server. Drop the probes and the slot.
+ */
+static void client_discard_unframed(server_t* s, handle_t h, client_hot_t* hot, client_cold_t* cold, bool ready) {
+  TRACE_LOG("unmanage unframed h=%lx xid=%u ready=%d", h, hot->xid, ready);
+  manage_stats_discard(ready);
+
+  cookie_jar_remove_client(&s->cookie_jar, h);
+  wm_prop_fetch_forget(s, hot->xid);
+  client_detach_logical(s, h, hot);
+
+  client_release_strings(cold);
+  if (cold->colormap_windows) {
+    free(cold->colormap_windows);
+    cold->colormap_windows = NULL;
+    cold->colormap_windows_len = 0;
+  }
+  client_visual_payload_destroy(s->conn, cold);
+  client_render_payload_destroy(cold);
+
+  screen_t* scr = client_screen(s, hot);
+  spatial_index_remove(&scr->frame_index, h);
+  handle_vec_remove(&s->active_clients, h);
+  wm_desktop_members_remove(s, h);
+  wm_tiling_remove(s, h);
+  if (handle_vec_remove(&scr->strut_clients, h))
+    wm_workarea_invalidate(scr);
+  slotmap_free(&s->clients, h);
+
+  // Only rewritten if the window had made it into a published list
+  scr->root_dirty |= ROOT_DIRTY_CLIENT_LIST;
+}
+
+void client_manage_painted(const client_hot_t* hot, client_cold_t* cold) {
+  manage_timing_t* m = &cold->manage_timing;
+  if (m->t[MANAGE_MARK_FINISH] == 0 || m->t[MANAGE_MARK_PAINT] != 0)
+    return;
+  manage_timing_mark(m, MANAGE_MARK_PAINT, monotonic_time_ns());
+
+  const char* probe = NULL;
+  switch (m->slowest_probe_type) {
+    case COOKIE_GET_WINDOW_ATTRIBUTES:
+      probe = "attributes";
+      break;
+    case COOKIE_GET_GEOMETRY:
+      probe = "geometry";
+      break;
+    case COOKIE_GET_PROPERTY:
+      probe = atom_name(m->slowest_probe_atom);
+      break;
+    default:
+      break;
   }
+  manage_stats_record(m, hot->type, cold->wm_class, probe);
 }
 
 void client_unmanage(server_t* s, handle_t h) {
@@ -976,9 +1386,16 @@ void client_unmanage(server_t* s, handle_t h) {
   if (hot->state == STATE_UNMANAGING || hot->state == STATE_UNMANAGED)
     return;
 
+  screen_t* scr = client_screen(s, hot);
   bool destroyed = (hot->state == STATE_DESTROYED);
   handle_t transient_parent = hot->transient_for;
-  hot->state = STATE_UNMANAGING;
+  client_set_state(s, hot, STATE_UNMANAGING);
+  wm_client_thaw(s, hot);
+
+  if (hot->frame == XCB_NONE && cold->manage_phase == MANAGE_PHASE1) {
+    client_discard_unframed(s, h, hot, cold, cold->manage_timing.t[MANAGE_MARK_READY] != 0);
+    return;
+  }
 
   LOG_INFO("Unmanaging client %lx (window %u, destroyed=%d)", h, hot->xid, destroyed);
   TRACE_LOG("unmanage h=%lx frame=%u state=%d ignore_unmap=%u", h, hot->frame, hot->state, hot->ignore_unmap);
@@ -1043,19 +1460,32 @@ void client_unmanage(server_t* s, handle_t h) {
     }
 
     TRACE_LOG("unmanage reparent xid=%u -> root (%d,%d) source=%s", hot->xid, root_x, root_y, prefer_desired_pos ? "desired" : "server");
-    xcb_reparent_window(s->conn, hot->xid, s->root, (int16_t)root_x, (int16_t)root_y);
+    xcb_reparent_window(s->conn, hot->xid, scr->root, (int16_t)root_x, (int16_t)root_y);
   }
 
+  // The window is going away: drop the damage object whoever still holds it
   if (cold->damage != XCB_NONE) {
     xcb_damage_destroy(s->conn, cold->damage);
     cold->damage = XCB_NONE;
     dirty_region_reset(&cold->damage_region);
   }
+  cold->damage_refs = 0;
 
-  // Destroy frame
+  if (cold->sync_alarm != XCB_NONE) {
+    xcb_sync_destroy_alarm(s->conn, cold->sync_alarm);
+    cold->sync_alarm = XCB_NONE;
+  }
+
+  // Destroy frame, or keep it with its render context for the next client
   if (hot->frame != XCB_NONE) {
-    TRACE_LOG("unmanage destroy frame=%u", hot->frame);
-    xcb_destroy_window(s->conn, hot->frame);
+    if (frame_pool_put(&s->frame_pool, s->conn, s->config.frame_pool_size, hot->frame, scr->root, (uint8_t)scr->root_depth, scr->root_visual,
+                       &cold->render_ctx)) {
+      TRACE_LOG("unmanage pool frame=%u pooled=%u", hot->frame, frame_pool_size(&s->frame_pool));
+    }
+    else {
+      TRACE_LOG("unmanage destroy frame=%u", hot->frame);
+      xcb_destroy_window(s->conn, hot->frame);
+    }
   }
 
   // Cleanup properties.
@@ -1068,21 +1498,28 @@ void client_unmanage(server_t* s, handle_t h) {
   }
 
   // Free cold data
-  arena_destroy(&cold->string_arena);
+  thumbnail_release(s, h);
+  client_release_strings(cold);
   if (cold->colormap_windows) {
     free(cold->colormap_windows);
     cold->colormap_windows = NULL;
     cold->colormap_windows_len = 0;
   }
   client_visual_payload_destroy(s->conn, cold);
+  client_frame_backing_destroy(s->conn, cold);
   client_render_payload_destroy(cold);
 
   // Free slot
-  small_vec_remove(&s->active_clients, handle_to_ptr(h));
+  spatial_index_remove(&scr->frame_index, h);
+  handle_vec_remove(&s->active_clients, h);
+  wm_desktop_members_remove(s, h);
+  wm_tiling_remove(s, h);
+  if (handle_vec_remove(&scr->strut_clients, h))
+    wm_workarea_invalidate(scr);
   slotmap_free(&s->clients, h);
 
-  s->root_dirty |= ROOT_DIRTY_CLIENT_LIST;
-  s->workarea_dirty = true;
+  scr->root_dirty |= ROOT_DIRTY_CLIENT_LIST;
+  scr->workarea_dirty = true;
   TRACE_ONLY(diag_dump_focus_history(s, "after unmanage"));
 }
 
@@ -1094,6 +1531,22 @@ void client_close(server_t* s, handle_t h) {
   if (hot->state == STATE_DESTROYED || hot->state == STATE_UNMANAGED)
     return;
 
+  // A frozen app could neither answer nor die cleanly
+  wm_client_thaw(s, hot);
+
+  // A hung app would sit on WM_DELETE_WINDOW; kill it instead
+  if (cold->ping_hung) {
+    if (client_pid_local(cold)) {
+      LOG_INFO("Killing hung client %lx (pid %u)", h, cold->pid);
+      kill((pid_t)cold->pid, SIGKILL);
+    }
+    else {
+      LOG_INFO("Killing hung client %lx", h);
+    }
+    xcb_kill_client(s->conn, hot->xid);
+    return;
+  }
+
   if (cold->protocols & PROTOCOL_DELETE_WINDOW) {
     LOG_DEBUG("Sending WM_DELETE_WINDOW to client %lx", h);
 
@@ -1107,6 +1560,8 @@ void client_close(server_t* s, handle_t h) {
     ev.data.data32[1] = XCB_CURRENT_TIME;
 
     xcb_send_event(s->conn, 0, hot->xid, XCB_EVENT_MASK_NO_EVENT, (const char*)&ev);
+    // Closing it again once it is found hung takes the path above
+    wm_ping_client(s, h);
   }
   else {
     LOG_DEBUG("Killing client %lx", h);
@@ -1210,17 +1665,40 @@ void client_constrain_size(const size_hints_t* s, uint32_t flags, uint16_t* w, u
  *
  * Buttons 1/2/3 are grabbed with SYNC pointer mode so the WM can inspect the
  * press first, then either consume it (focus/move/resize workflows) or release
- * events back to the client.
+ * events back to the client. A client starts out unfocused; the focus commit
+ * switches its grabs with client_set_button_grabs.
  */
 void client_setup_grabs(server_t* s, handle_t h) {
+  client_set_button_grabs(s, h, false);
+}
+
+/*
+ * Every plain click on an unfocused client has to reach the WM, which focuses
+ * it and replays the press, so buttons 1-3 are grabbed under any modifiers.
+ * A click on the focused client only matters to the WM with Alt held (move and
+ * resize); with the any-modifier grab kept, each of its clicks would freeze
+ * the pointer until the WM got round to AllowEvents. The focused client keeps
+ * only Alt+1 and Alt+3, still SYNC so a press that starts nothing is
+ * replayed.
+ */
+void client_set_button_grabs(server_t* s, handle_t h, bool focused) {
   client_hot_t* hot = server_chot(s, h);
   assert(hot);
 
-  // Grab buttons 1, 2, 3 for click-to-focus and Alt-move/resize
-  // Use SYNC mode for the pointer so we can intercept clicks
-  uint16_t buttons[] = {1, 2, 3};
-  for (int i = 0; i < 3; i++) {
-    xcb_grab_button(s->conn, 0, hot->xid, XCB_EVENT_MASK_BUTTON_PRESS, XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE, buttons[i], XCB_MOD_MASK_ANY);
+  xcb_ungrab_button(s->conn, XCB_BUTTON_INDEX_ANY, hot->xid, XCB_MOD_MASK_ANY);
+  if (!focused) {
+    static const uint8_t buttons[] = {1, 2, 3};
+    for (size_t i = 0; i < sizeof(buttons); i++)
+      xcb_grab_button(s->conn, 0, hot->xid, XCB_EVENT_MASK_BUTTON_PRESS, XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE, buttons[i], XCB_MOD_MASK_ANY);
+    return;
+  }
+
+  static const uint8_t alt_buttons[] = {1, 3};
+  for (size_t i = 0; i < sizeof(alt_buttons); i++) {
+    for (size_t m = 0; m < WM_LOCK_MOD_COMBOS; m++) {
+      xcb_grab_button(s->conn, 0, hot->xid, XCB_EVENT_MASK_BUTTON_PRESS, XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE, alt_buttons[i],
+                      (uint16_t)(XCB_MOD_MASK_1 | wm_lock_mod_combos[m]));
+    }
   }
 }
 
@@ -32,6 +32,7 @@ int main(void) {
   PRINT_OFFSET(client_cold_t, frame_colormap);
   PRINT_OFFSET(client_cold_t, render_ctx);
   PRINT_OFFSET(client_cold_t, icon_surface);
+  PRINT_OFFSET(client_cold_t, icon_fetch);
   PRINT_OFFSET(client_cold_t, hints);
   PRINT_OFFSET(client_cold_t, hints_flags);
   PRINT_OFFSET(client_cold_t, user_time);
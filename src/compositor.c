@@ -0,0 +1,774 @@
+/* src/compositor.c
+ * Built-in compositing manager.
+ *
+ * Every child of the root is redirected manually: the server keeps each
+ * window's contents in an offscreen pixmap and shows nothing itself. A
+ * paint composites those pixmaps, bottom to top, into a back buffer and
+ * copies the damaged rects of it to the Composite overlay window, which
+ * sits above everything. Painting is RENDER through cairo-xcb, the same way
+ * switcher thumbnails are scaled, so no pixels cross the wire.
+ *
+ * The window list is fed from the root's SubstructureNotify events, which
+ * the window manager selects anyway, at ingest. Frames are painted in the
+ * first screen's layers order, as the window manager last committed it;
+ * other windows follow in the order the server stacked them. Damage on
+ * those windows arrives through the tick's coalesced damage buckets, one
+ * subtract per window per tick.
+ *
+ * A paint starts from the topmost opaque window that covers all damage, so
+ * a maximized terminal that scrolls composites one window, not the desktop
+ * under it. Paints are paced to the fastest monitor's refresh; damage that
+ * arrives in between waits for the next one.
+ *
+ * Only screen 0 is composited, matching the _NET_WM_CM_S0 selection it
+ * holds; windows on other screens are left to the server.
+ */
+
+#include "compositor.h"
+
+#include <cairo/cairo-xcb.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <xcb/composite.h>
+#include <xcb/shape.h>
+
+#include "event.h"
+#include "wm_internal.h"
+#include "xcb_utils.h"
+
+bool compositor_enabled(const server_t* s) {
+  return s && s->composite_supported && s->damage_supported && s->config.compositor;
+}
+
+static const screen_t* comp_screen(const server_t* s) {
+  return &s->screens[0];
+}
+
+static comp_win_t* comp_find(compositor_t* c, xcb_window_t win) {
+  return (comp_win_t*)hash_map_get(&c->windows, (uint64_t)win);
+}
+
+static void comp_damage_rect(compositor_t* c, int32_t x, int32_t y, int32_t w, int32_t h) {
+  // Clamped at paint time; only keep the coordinates in range here
+  if (w <= 0 || h <= 0 || x >= c->w || y >= c->h || x + w <= 0 || y + h <= 0)
+    return;
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  dirty_rects_add(&c->damage, (int16_t)x, (int16_t)y, (uint16_t)(w > UINT16_MAX ? UINT16_MAX : w), (uint16_t)(h > UINT16_MAX ? UINT16_MAX : h));
+}
+
+static void comp_damage_win(compositor_t* c, const comp_win_t* cw) {
+  if (cw->mapped)
+    comp_damage_rect(c, cw->x, cw->y, cw->w, cw->h);
+}
+
+static void comp_damage_all(compositor_t* c) {
+  dirty_rects_reset(&c->damage);
+  comp_damage_rect(c, 0, 0, c->w, c->h);
+}
+
+static uint8_t comp_visual_depth(const server_t* s, xcb_visualid_t visual) {
+  const screen_t* scr = comp_screen(s);
+  xcb_screen_t* screen = xcb_screen_of(s->conn, scr->num);
+  for (xcb_depth_iterator_t d = xcb_screen_allowed_depths_iterator(screen); d.rem; xcb_depth_next(&d)) {
+    for (xcb_visualtype_iterator_t v = xcb_depth_visuals_iterator(d.data); v.rem; xcb_visualtype_next(&v)) {
+      if (v.data->visual_id == visual)
+        return d.data->depth;
+    }
+  }
+  return 0;
+}
+
+static void comp_set_visual(server_t* s, comp_win_t* cw, xcb_visualid_t visual, uint8_t window_class) {
+  cw->visual = visual;
+  cw->input_only = window_class == XCB_WINDOW_CLASS_INPUT_ONLY;
+  cw->argb = !cw->input_only && comp_visual_depth(s, visual) == 32;
+}
+
+static void comp_release_pixmap(server_t* s, comp_win_t* cw) {
+  if (cw->surface) {
+    cairo_surface_destroy(cw->surface);
+    cw->surface = NULL;
+  }
+  if (cw->pixmap != XCB_NONE) {
+    xcb_free_pixmap(s->conn, cw->pixmap);
+    cw->pixmap = XCB_NONE;
+  }
+}
+
+static void comp_watch(server_t* s, comp_win_t* cw) {
+  if (cw->damage != XCB_NONE || cw->input_only || !cw->mapped || s->compositor.suspended)
+    return;
+  cw->damage = xcb_generate_id(s->conn);
+  xcb_damage_create(s->conn, cw->damage, cw->win, XCB_DAMAGE_REPORT_LEVEL_BOUNDING_BOX);
+}
+
+static void comp_unwatch(server_t* s, comp_win_t* cw) {
+  comp_release_pixmap(s, cw);
+  if (cw->damage != XCB_NONE) {
+    xcb_damage_destroy(s->conn, cw->damage);
+    cw->damage = XCB_NONE;
+  }
+}
+
+static ssize_t comp_order_index(const compositor_t* c, const comp_win_t* cw) {
+  for (size_t i = 0; i < c->order_len; i++) {
+    if (c->order[i] == cw)
+      return (ssize_t)i;
+  }
+  return -1;
+}
+
+static void comp_order_remove(compositor_t* c, comp_win_t* cw) {
+  ssize_t i = comp_order_index(c, cw);
+  if (i < 0)
+    return;
+  memmove(&c->order[i], &c->order[i + 1], (c->order_len - (size_t)i - 1u) * sizeof(*c->order));
+  c->order_len--;
+}
+
+/* Restack cw directly above sibling: XCB_NONE is the bottom, an unknown sibling the top */
+static void comp_order_place(compositor_t* c, comp_win_t* cw, xcb_window_t sibling) {
+  comp_order_remove(c, cw);
+  size_t at = c->order_len;
+  if (sibling == XCB_NONE) {
+    at = 0;
+  }
+  else {
+    comp_win_t* below = comp_find(c, sibling);
+    ssize_t i = below ? comp_order_index(c, below) : -1;
+    if (i >= 0)
+      at = (size_t)i + 1u;
+  }
+  memmove(&c->order[at + 1], &c->order[at], (c->order_len - at) * sizeof(*c->order));
+  c->order[at] = cw;
+  c->order_len++;
+}
+
+static comp_win_t* comp_add(server_t* s, xcb_window_t win, int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t border) {
+  const screen_t* scr = comp_screen(s);
+  compositor_t* c = &s->compositor;
+  if (win == c->overlay || win == XCB_NONE)
+    return NULL;
+  comp_win_t* cw = comp_find(c, win);
+  if (cw)
+    return cw;
+
+  if (c->order_len == c->order_cap) {
+    size_t cap = c->order_cap ? c->order_cap * 2u : 64u;
+    comp_win_t** grown = realloc(c->order, cap * sizeof(*grown));
+    if (!grown)
+      return NULL;
+    c->order = grown;
+    c->order_cap = cap;
+  }
+  cw = calloc(1, sizeof(*cw));
+  if (!cw)
+    return NULL;
+  hash_map_insert(&c->windows, (uint64_t)win, cw);
+  cw->win = win;
+  cw->x = x;
+  cw->y = y;
+  cw->border = border;
+  cw->w = (uint16_t)(w + 2u * border);
+  cw->h = (uint16_t)(h + 2u * border);
+  cw->visual = scr->root_visual;
+  // New windows are created on top of their siblings
+  c->order[c->order_len++] = cw;
+  return cw;
+}
+
+static void comp_forget(server_t* s, xcb_window_t win) {
+  compositor_t* c = &s->compositor;
+  comp_win_t* cw = comp_find(c, win);
+  if (!cw)
+    return;
+  comp_damage_win(c, cw);
+  comp_unwatch(s, cw);
+  comp_order_remove(c, cw);
+  hash_map_remove(&c->windows, (uint64_t)win);
+  free(cw);
+}
+
+static void comp_handle_attributes(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  compositor_t* c = &s->compositor;
+  comp_win_t* cw = c->active ? comp_find(c, (xcb_window_t)slot->data) : NULL;
+  if (!cw || err || !reply)
+    return;
+  xcb_get_window_attributes_reply_t* r = (xcb_get_window_attributes_reply_t*)reply;
+  comp_set_visual(s, cw, r->visual, r->_class);
+  if (cw->input_only)
+    comp_unwatch(s, cw);
+  comp_damage_win(c, cw);
+}
+
+static void comp_handle_geometry(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  compositor_t* c = &s->compositor;
+  comp_win_t* cw = c->active ? comp_find(c, (xcb_window_t)slot->data) : NULL;
+  if (!cw || err || !reply)
+    return;
+  xcb_get_geometry_reply_t* r = (xcb_get_geometry_reply_t*)reply;
+  comp_damage_win(c, cw);
+  comp_release_pixmap(s, cw);
+  cw->x = r->x;
+  cw->y = r->y;
+  cw->border = r->border_width;
+  cw->w = (uint16_t)(r->width + 2u * r->border_width);
+  cw->h = (uint16_t)(r->height + 2u * r->border_width);
+  comp_damage_win(c, cw);
+}
+
+static void comp_query_attributes(server_t* s, xcb_window_t win) {
+  xcb_get_window_attributes_cookie_t ck = xcb_get_window_attributes(s->conn, win);
+  if (ck.sequence)
+    cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_WINDOW_ATTRIBUTES, HANDLE_INVALID, (uintptr_t)win, s->txn_id, comp_handle_attributes);
+}
+
+static void comp_handle_background(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  const screen_t* scr = comp_screen(s);
+  (void)slot;
+  compositor_t* c = &s->compositor;
+  if (!c->active)
+    return;
+  xcb_pixmap_t pixmap = XCB_NONE;
+  xcb_get_property_reply_t* r = (xcb_get_property_reply_t*)reply;
+  if (!err && r && r->type == XCB_ATOM_PIXMAP && r->format == 32 && xcb_get_property_value_length(r) >= 4)
+    pixmap = *(xcb_pixmap_t*)xcb_get_property_value(r);
+
+  if (c->bg) {
+    cairo_surface_destroy(c->bg);
+    c->bg = NULL;
+  }
+  c->root_bg = pixmap;
+  // The pixmap belongs to whoever set the wallpaper; we only read it
+  if (pixmap != XCB_NONE && !s->is_test)
+    c->bg = cairo_xcb_surface_create(s->conn, pixmap, scr->root_visual_type, c->w, c->h);
+  comp_damage_all(c);
+}
+
+static void comp_fetch_background(server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, scr->root, atoms._XROOTPMAP_ID, XCB_ATOM_PIXMAP, 0, 1);
+  if (ck.sequence)
+    cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, HANDLE_INVALID, 0, s->txn_id, comp_handle_background);
+}
+
+static void comp_free_buffers(server_t* s) {
+  compositor_t* c = &s->compositor;
+  if (c->back) {
+    cairo_surface_destroy(c->back);
+    c->back = NULL;
+  }
+  if (c->front) {
+    cairo_surface_destroy(c->front);
+    c->front = NULL;
+  }
+  if (c->back_pixmap != XCB_NONE) {
+    xcb_free_pixmap(s->conn, c->back_pixmap);
+    c->back_pixmap = XCB_NONE;
+  }
+}
+
+static void comp_create_buffers(server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  compositor_t* c = &s->compositor;
+  c->back_pixmap = xcb_generate_id(s->conn);
+  xcb_create_pixmap(s->conn, scr->root_depth, c->back_pixmap, scr->root, c->w, c->h);
+  // Tests have no server to render to; the pixmap is enough to count requests
+  if (s->is_test)
+    return;
+  c->back = cairo_xcb_surface_create(s->conn, c->back_pixmap, scr->root_visual_type, c->w, c->h);
+  c->front = cairo_xcb_surface_create(s->conn, c->overlay, scr->root_visual_type, c->w, c->h);
+}
+
+/* Windows that already exist when we start, bottom to top */
+static void comp_scan(server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  xcb_query_tree_cookie_t tck = xcb_query_tree(s->conn, scr->root);
+  // SYNC_REPLY_EXEMPT: once per compositor start, at startup or on reload;
+  // windows created from here on are reported by CreateNotify
+  xcb_query_tree_reply_t* tree = xcb_query_tree_reply(s->conn, tck, NULL);
+  if (!tree)
+    return;
+  int n = xcb_query_tree_children_length(tree);
+  xcb_window_t* children = xcb_query_tree_children(tree);
+  xcb_get_window_attributes_cookie_t* ack = calloc((size_t)n + 1u, sizeof(*ack));
+  xcb_get_geometry_cookie_t* gck = calloc((size_t)n + 1u, sizeof(*gck));
+  if (!ack || !gck) {
+    free(ack);
+    free(gck);
+    free(tree);
+    return;
+  }
+  for (int i = 0; i < n; i++) {
+    ack[i] = xcb_get_window_attributes(s->conn, children[i]);
+    gck[i] = xcb_get_geometry(s->conn, children[i]);
+  }
+  // SYNC_REPLY_EXEMPT: same start, all requests already in flight
+  for (int i = 0; i < n; i++) {
+    xcb_get_window_attributes_reply_t* a = xcb_get_window_attributes_reply(s->conn, ack[i], NULL);
+    xcb_get_geometry_reply_t* g = xcb_get_geometry_reply(s->conn, gck[i], NULL);
+    if (a && g) {
+      comp_win_t* cw = comp_add(s, children[i], g->x, g->y, g->width, g->height, g->border_width);
+      if (cw) {
+        comp_set_visual(s, cw, a->visual, a->_class);
+        cw->mapped = a->map_state != XCB_MAP_STATE_UNMAPPED;
+        comp_watch(s, cw);
+      }
+    }
+    free(a);
+    free(g);
+  }
+  free(ack);
+  free(gck);
+  free(tree);
+}
+
+bool compositor_start(server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  compositor_t* c = &s->compositor;
+  if (c->active)
+    return true;
+  if (!s->composite_supported || !s->damage_supported) {
+    LOG_WARN("compositor needs Composite and Damage; leaving the screen to the server");
+    return false;
+  }
+
+  xcb_get_selection_owner_cookie_t ock = xcb_get_selection_owner(s->conn, atoms._NET_WM_CM_S0);
+  // SYNC_REPLY_EXEMPT: once per compositor start, at startup or on reload
+  xcb_get_selection_owner_reply_t* owner = xcb_get_selection_owner_reply(s->conn, ock, NULL);
+  xcb_window_t holder = owner ? owner->owner : XCB_NONE;
+  free(owner);
+  if (holder != XCB_NONE && holder != scr->supporting_wm_check) {
+    LOG_WARN("compositor: another compositing manager owns _NET_WM_CM_S0 (window 0x%x)", holder);
+    return false;
+  }
+
+  // Only one client may redirect manually; BadAccess means someone else does
+  xcb_void_cookie_t rck = xcb_composite_redirect_subwindows_checked(s->conn, scr->root, XCB_COMPOSITE_REDIRECT_MANUAL);
+  xcb_generic_error_t* err = xcb_request_check(s->conn, rck);
+  if (err) {
+    LOG_WARN("compositor: cannot redirect the root (error %u), is another compositor running?", err->error_code);
+    free(err);
+    return false;
+  }
+  xcb_set_selection_owner(s->conn, scr->supporting_wm_check, atoms._NET_WM_CM_S0, XCB_CURRENT_TIME);
+
+  xcb_composite_get_overlay_window_cookie_t wck = xcb_composite_get_overlay_window(s->conn, scr->root);
+  // SYNC_REPLY_EXEMPT: once per compositor start, at startup or on reload
+  xcb_composite_get_overlay_window_reply_t* wr = xcb_composite_get_overlay_window_reply(s->conn, wck, NULL);
+  c->overlay = wr ? wr->overlay_win : XCB_NONE;
+  free(wr);
+  if (c->overlay == XCB_NONE) {
+    LOG_WARN("compositor: no overlay window");
+    xcb_composite_unredirect_subwindows(s->conn, scr->root, XCB_COMPOSITE_REDIRECT_MANUAL);
+    xcb_set_selection_owner(s->conn, XCB_NONE, atoms._NET_WM_CM_S0, XCB_CURRENT_TIME);
+    return false;
+  }
+  // Clicks go through the overlay to the windows it shows
+  xcb_shape_rectangles(s->conn, XCB_SHAPE_SO_SET, XCB_SHAPE_SK_INPUT, XCB_CLIP_ORDERING_UNSORTED, c->overlay, 0, 0, 0, NULL);
+
+  xcb_screen_t* screen = xcb_screen_of(s->conn, scr->num);
+  c->w = screen->width_in_pixels;
+  c->h = screen->height_in_pixels;
+  c->suspended = false;
+  c->last_paint_ns = 0;
+  hash_map_init(&c->windows);
+  comp_create_buffers(s);
+  c->active = true;
+
+  // Tests feed windows through compositor_observe instead
+  if (!s->is_test)
+    comp_scan(s);
+  comp_fetch_background(s);
+  comp_damage_all(c);
+  LOG_INFO("compositor: started, %zu windows", hash_map_size(&c->windows));
+  return true;
+}
+
+void compositor_stop(server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  compositor_t* c = &s->compositor;
+  if (!c->active)
+    return;
+
+  for (size_t i = 0; i < c->order_len; i++) {
+    comp_unwatch(s, c->order[i]);
+    free(c->order[i]);
+  }
+  free(c->order);
+  free(c->paint);
+  c->order = NULL;
+  c->paint = NULL;
+  c->order_len = c->order_cap = c->paint_cap = 0;
+  hash_map_destroy(&c->windows);
+
+  if (c->bg) {
+    cairo_surface_destroy(c->bg);
+    c->bg = NULL;
+  }
+  c->root_bg = XCB_NONE;
+  comp_free_buffers(s);
+
+  if (!c->suspended)
+    xcb_composite_unredirect_subwindows(s->conn, scr->root, XCB_COMPOSITE_REDIRECT_MANUAL);
+  xcb_composite_release_overlay_window(s->conn, scr->root);
+  xcb_set_selection_owner(s->conn, XCB_NONE, atoms._NET_WM_CM_S0, XCB_CURRENT_TIME);
+  c->overlay = XCB_NONE;
+  c->suspended = false;
+  c->active = false;
+  dirty_rects_reset(&c->damage);
+  LOG_INFO("compositor: stopped");
+}
+
+void compositor_observe(server_t* s, const xcb_generic_event_t* ev) {
+  const screen_t* scr = comp_screen(s);
+  compositor_t* c = &s->compositor;
+  if (!c->active)
+    return;
+
+  switch (ev->response_type & ~0x80) {
+    case XCB_CREATE_NOTIFY: {
+      const xcb_create_notify_event_t* e = (const xcb_create_notify_event_t*)ev;
+      if (e->parent != scr->root)
+        break;
+      if (comp_add(s, e->window, e->x, e->y, e->width, e->height, e->border_width))
+        comp_query_attributes(s, e->window);
+      break;
+    }
+
+    case XCB_MAP_NOTIFY: {
+      const xcb_map_notify_event_t* e = (const xcb_map_notify_event_t*)ev;
+      comp_win_t* cw = e->event == scr->root ? comp_find(c, e->window) : NULL;
+      if (!cw)
+        break;
+      cw->mapped = true;
+      // Mapping gives the window a new pixmap
+      comp_release_pixmap(s, cw);
+      comp_watch(s, cw);
+      comp_damage_win(c, cw);
+      break;
+    }
+
+    case XCB_UNMAP_NOTIFY: {
+      const xcb_unmap_notify_event_t* e = (const xcb_unmap_notify_event_t*)ev;
+      comp_win_t* cw = e->event == scr->root ? comp_find(c, e->window) : NULL;
+      if (!cw)
+        break;
+      comp_damage_win(c, cw);
+      cw->mapped = false;
+      comp_unwatch(s, cw);
+      break;
+    }
+
+    case XCB_CONFIGURE_NOTIFY: {
+      const xcb_configure_notify_event_t* e = (const xcb_configure_notify_event_t*)ev;
+      comp_win_t* cw = e->event == scr->root ? comp_find(c, e->window) : NULL;
+      if (!cw)
+        break;
+      uint16_t w = (uint16_t)(e->width + 2u * e->border_width);
+      uint16_t h = (uint16_t)(e->height + 2u * e->border_width);
+      comp_damage_win(c, cw);
+      if (w != cw->w || h != cw->h)
+        comp_release_pixmap(s, cw);
+      cw->x = e->x;
+      cw->y = e->y;
+      cw->w = w;
+      cw->h = h;
+      cw->border = e->border_width;
+      comp_order_place(c, cw, e->above_sibling);
+      comp_damage_win(c, cw);
+      break;
+    }
+
+    case XCB_DESTROY_NOTIFY: {
+      const xcb_destroy_notify_event_t* e = (const xcb_destroy_notify_event_t*)ev;
+      if (e->event == scr->root)
+        comp_forget(s, e->window);
+      break;
+    }
+
+    case XCB_REPARENT_NOTIFY: {
+      const xcb_reparent_notify_event_t* e = (const xcb_reparent_notify_event_t*)ev;
+      if (e->event != scr->root)
+        break;
+      if (e->parent != scr->root) {
+        // Framed: from now on it is painted as part of its frame
+        comp_forget(s, e->window);
+        break;
+      }
+      // Released by the window manager; its size is not in the event
+      comp_win_t* cw = comp_add(s, e->window, e->x, e->y, 1, 1, 0);
+      if (!cw)
+        break;
+      comp_query_attributes(s, e->window);
+      xcb_get_geometry_cookie_t ck = xcb_get_geometry(s->conn, e->window);
+      if (ck.sequence)
+        cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_GEOMETRY, HANDLE_INVALID, (uintptr_t)e->window, s->txn_id, comp_handle_geometry);
+      break;
+    }
+
+    case XCB_PROPERTY_NOTIFY: {
+      const xcb_property_notify_event_t* e = (const xcb_property_notify_event_t*)ev;
+      if (e->window == scr->root && atoms._XROOTPMAP_ID != XCB_ATOM_NONE && e->atom == atoms._XROOTPMAP_ID)
+        comp_fetch_background(s);
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+void compositor_note_damage(server_t* s, xcb_window_t drawable, const dirty_rects_t* region) {
+  compositor_t* c = &s->compositor;
+  comp_win_t* cw = c->active ? comp_find(c, drawable) : NULL;
+  if (!cw || cw->damage == XCB_NONE)
+    return;
+  // Damage is relative to the window origin, inside the border
+  int32_t ox = cw->x + cw->border;
+  int32_t oy = cw->y + cw->border;
+  for (uint8_t i = 0; i < region->count; i++) {
+    const dirty_rect_t* r = &region->rects[i];
+    comp_damage_rect(c, ox + r->x, oy + r->y, r->w, r->h);
+  }
+  xcb_damage_subtract(s->conn, cw->damage, XCB_NONE, XCB_NONE);
+  c->damage_events++;
+}
+
+void compositor_resize(server_t* s, uint16_t w, uint16_t h) {
+  compositor_t* c = &s->compositor;
+  if (!c->active || w == 0 || h == 0 || (w == c->w && h == c->h))
+    return;
+  c->w = w;
+  c->h = h;
+  comp_free_buffers(s);
+  comp_create_buffers(s);
+  // The wallpaper setter usually follows with a new pixmap
+  comp_fetch_background(s);
+  comp_damage_all(c);
+}
+
+static void comp_suspend(server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  compositor_t* c = &s->compositor;
+  for (size_t i = 0; i < c->order_len; i++)
+    comp_unwatch(s, c->order[i]);
+  xcb_composite_unredirect_subwindows(s->conn, scr->root, XCB_COMPOSITE_REDIRECT_MANUAL);
+  xcb_unmap_window(s->conn, c->overlay);
+  c->suspended = true;
+  c->suspends++;
+  dirty_rects_reset(&c->damage);
+  LOG_DEBUG("compositor: suspended for fullscreen");
+}
+
+static void comp_resume(server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  compositor_t* c = &s->compositor;
+  c->suspended = false;
+  xcb_composite_redirect_subwindows(s->conn, scr->root, XCB_COMPOSITE_REDIRECT_MANUAL);
+  xcb_map_window(s->conn, c->overlay);
+  for (size_t i = 0; i < c->order_len; i++)
+    comp_watch(s, c->order[i]);
+  comp_damage_all(c);
+  LOG_DEBUG("compositor: resumed");
+}
+
+static uint64_t comp_interval_ns(const server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  uint32_t mhz = 0;
+  for (uint32_t i = 0; i < scr->monitor_count; i++) {
+    if (scr->monitors[i].refresh_mhz > mhz)
+      mhz = scr->monitors[i].refresh_mhz;
+  }
+  return 1000000000000ull / (mhz ? mhz : COMPOSITOR_DEFAULT_MHZ);
+}
+
+static bool comp_paint_push(compositor_t* c, size_t* len, comp_win_t* cw) {
+  if (*len == c->paint_cap) {
+    size_t cap = c->paint_cap ? c->paint_cap * 2u : 64u;
+    comp_win_t** grown = realloc(c->paint, cap * sizeof(*grown));
+    if (!grown)
+      return false;
+    c->paint = grown;
+    c->paint_cap = cap;
+  }
+  c->paint[(*len)++] = cw;
+  return true;
+}
+
+static size_t comp_build_paint_list(server_t* s) {
+  const screen_t* scr = comp_screen(s);
+  compositor_t* c = &s->compositor;
+  size_t len = 0;
+  for (int l = 0; l < LAYER_COUNT; l++) {
+    for (size_t i = 0; i < scr->layers[l].length; i++) {
+      client_hot_t* hot = server_chot(s, scr->layers[l].items[i]);
+      comp_win_t* cw = hot && hot->frame != XCB_NONE ? comp_find(c, hot->frame) : NULL;
+      if (cw && cw->mapped && !cw->input_only)
+        comp_paint_push(c, &len, cw);
+    }
+  }
+  for (size_t i = 0; i < c->order_len; i++) {
+    comp_win_t* cw = c->order[i];
+    if (cw->mapped && !cw->input_only && server_get_client_by_frame(s, cw->win) == HANDLE_INVALID)
+      comp_paint_push(c, &len, cw);
+  }
+  return len;
+}
+
+static bool comp_is_hollow(const server_t* s, const comp_win_t* cw) {
+  return cw->win == s->snap_preview_win && s->snap_preview_shaped;
+}
+
+static bool comp_covers(const comp_win_t* cw, const dirty_region_t* r) {
+  return cw->x <= r->x && cw->y <= r->y && (int32_t)cw->x + cw->w >= (int32_t)r->x + r->w && (int32_t)cw->y + cw->h >= (int32_t)r->y + r->h;
+}
+
+static bool comp_bind(server_t* s, comp_win_t* cw) {
+  const screen_t* scr = comp_screen(s);
+  if (cw->surface)
+    return true;
+  xcb_visualtype_t* visual = xcb_get_visualtype(s->conn, cw->visual);
+  if (!visual)
+    visual = scr->root_visual_type;
+  cw->pixmap = xcb_generate_id(s->conn);
+  xcb_composite_name_window_pixmap(s->conn, cw->win, cw->pixmap);
+  cw->surface = cairo_xcb_surface_create(s->conn, cw->pixmap, visual, cw->w, cw->h);
+  return cairo_surface_status(cw->surface) == CAIRO_STATUS_SUCCESS;
+}
+
+static void comp_clip(cairo_t* cr, const dirty_rects_t* damage) {
+  for (uint8_t i = 0; i < damage->count; i++)
+    cairo_rectangle(cr, damage->rects[i].x, damage->rects[i].y, damage->rects[i].w, damage->rects[i].h);
+  cairo_clip(cr);
+}
+
+static void comp_draw(server_t* s, size_t first, size_t len, bool background) {
+  compositor_t* c = &s->compositor;
+  cairo_t* cr = cairo_create(c->back);
+  comp_clip(cr, &c->damage);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  if (background) {
+    if (c->bg)
+      cairo_set_source_surface(cr, c->bg, 0, 0);
+    else
+      cairo_set_source_rgb(cr, 0, 0, 0);
+    cairo_paint(cr);
+  }
+
+  for (size_t i = first; i < len; i++) {
+    comp_win_t* cw = c->paint[i];
+    if (!comp_bind(s, cw))
+      continue;
+    cairo_set_operator(cr, cw->argb ? CAIRO_OPERATOR_OVER : CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(cr, cw->surface, cw->x, cw->y);
+    if (comp_is_hollow(s, cw)) {
+      // Only the ring the snap preview's bounding shape keeps
+      double b = s->snap_preview_border_px;
+      cairo_rectangle(cr, cw->x, cw->y, cw->w, b);
+      cairo_rectangle(cr, cw->x, cw->y + cw->h - b, cw->w, b);
+      cairo_rectangle(cr, cw->x, cw->y + b, b, cw->h - 2.0 * b);
+      cairo_rectangle(cr, cw->x + cw->w - b, cw->y + b, b, cw->h - 2.0 * b);
+    }
+    else {
+      cairo_rectangle(cr, cw->x, cw->y, cw->w, cw->h);
+    }
+    cairo_fill(cr);
+  }
+  cairo_destroy(cr);
+  cairo_surface_flush(c->back);
+
+  cr = cairo_create(c->front);
+  comp_clip(cr, &c->damage);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface(cr, c->back, 0, 0);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+  cairo_surface_flush(c->front);
+}
+
+bool compositor_paint(server_t* s, uint64_t now) {
+  compositor_t* c = &s->compositor;
+  if (!c->active)
+    return false;
+
+  rect_t screen = {0, 0, c->w, c->h};
+  bool unredirect = wm_fullscreen_unredirect_client(s, &screen) != HANDLE_INVALID;
+  if (unredirect != c->suspended) {
+    if (unredirect)
+      comp_suspend(s);
+    else
+      comp_resume(s);
+    return true;
+  }
+  if (c->suspended || dirty_rects_empty(&c->damage))
+    return false;
+
+  uint64_t interval = comp_interval_ns(s);
+  if (c->last_paint_ns != 0 && now - c->last_paint_ns < interval) {
+    server_schedule_timer_ns(s, interval - (now - c->last_paint_ns));
+    return false;
+  }
+
+  dirty_rects_clamp(&c->damage, 0, 0, c->w, c->h);
+  if (dirty_rects_empty(&c->damage))
+    return false;
+
+  size_t len = comp_build_paint_list(s);
+  // Nothing under an opaque window that covers all damage can show
+  dirty_region_t bounds = dirty_rects_bounds(&c->damage);
+  size_t first = 0;
+  bool background = true;
+  for (size_t i = len; i-- > 0;) {
+    comp_win_t* cw = c->paint[i];
+    if (!cw->argb && !comp_is_hollow(s, cw) && comp_covers(cw, &bounds)) {
+      first = i;
+      background = false;
+      break;
+    }
+  }
+
+  if (!s->is_test)
+    comp_draw(s, first, len, background);
+  c->paints++;
+  c->windows_painted += len - first;
+  c->windows_occluded += first;
+  c->last_paint_ns = now;
+  dirty_rects_reset(&c->damage);
+  return true;
+}
+
+size_t compositor_format(const compositor_t* c, char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+  buf[0] = '\0';
+  if (!c || !c->active)
+    return 0;
+
+  int n = snprintf(buf, cap,
+                   "compositor: windows=%zu suspended=%d paints=%" PRIu64 " painted=%" PRIu64 " occluded=%" PRIu64 " damage=%" PRIu64
+                   " suspends=%" PRIu64 "\n",
+                   hash_map_size(&c->windows), c->suspended ? 1 : 0, c->paints, c->windows_painted, c->windows_occluded, c->damage_events,
+                   c->suspends);
+  if (n <= 0)
+    return 0;
+  return (size_t)n < cap ? (size_t)n : cap - 1u;
+}
+
+void compositor_dump(const compositor_t* c) {
+  char buf[256];
+  if (compositor_format(c, buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
+}
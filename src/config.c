@@ -22,6 +22,7 @@
 
 #include "client.h"
 #include "hxm.h"
+#include "tiling.h"
 
 #ifndef ARRAY_LEN
 #define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
@@ -41,10 +42,25 @@
 #define DEFAULT_TITLE_HEIGHT 20
 #define DEFAULT_SNAP_THRESHOLD 24
 #define DEFAULT_SNAP_PREVIEW_BORDER 2
+#define DEFAULT_SNAP_SPLIT_PERCENT 50
+#define DEFAULT_KEYBOARD_STEP 10
+#define DEFAULT_INTERACTIVE_DEFER_MS 250
+#define MAX_INTERACTIVE_BUSY_POLL_US 2000
+#define DEFAULT_FOCUS_BOOST_WEIGHT 400
+#define DEFAULT_FOCUS_BOOST_DELAY_MS 200
+#define DEFAULT_SNAP_CORNER 96
+#define DEFAULT_SNAP_EDGE_RESISTANCE 12
 #define DEFAULT_DESKTOP_COUNT 4
-#define DEFAULT_FONT "fixed"
-
-static void add_keybind(config_t* config, uint32_t mods, xcb_keysym_t sym, action_type_t action, const char* cmd) {
+#define DEFAULT_SWITCHER_THUMBNAIL_HZ 2
+#define DEFAULT_RENDER_IDLE_RELEASE_S 30
+#define DEFAULT_PREWARM_IDLE_MS 250
+#define DEFAULT_PING_INTERVAL_MS 5000
+#define DEFAULT_PING_TIMEOUT_MS 3000
+#define DEFAULT_FRAME_POOL_SIZE 8
+#define DEFAULT_TILING_MASTER_PERCENT 55
+#define DEFAULT_FONT "Sans Bold 10"
+
+static key_binding_t* add_keybind(config_t* config, uint32_t mods, xcb_keysym_t sym, action_type_t action, const char* cmd) {
   key_binding_t* b = calloc(1, sizeof(*b));
   b->modifiers = mods;
   b->keysym = sym;
@@ -52,6 +68,7 @@ static void add_keybind(config_t* config, uint32_t mods, xcb_keysym_t sym, actio
   if (cmd)
     b->exec_cmd = strdup(cmd);
   small_vec_push(&config->key_bindings, b);
+  return b;
 }
 
 void config_init_defaults(config_t* config) {
@@ -86,11 +103,47 @@ void config_init_defaults(config_t* config) {
 
   config->focus_raise = true;
   config->focus_follows_mouse = false;
+  config->focus_hover_delay_ms = 0;
+  config->focus_hover_speed = 0;
   config->fullscreen_use_workarea = false;
+  config->fullscreen_fast = false;
+  config->compositor = false;
+  config->placement = PLACEMENT_DEFAULT;
+  config->frame_backing = false;
+  config->render_thread = false;
+  config->input_thread = false;
+  config->focus_boost = false;
+  config->focus_boost_weight = DEFAULT_FOCUS_BOOST_WEIGHT;
+  config->focus_boost_delay_ms = DEFAULT_FOCUS_BOOST_DELAY_MS;
+  config->interactive_max_hz = 0;
+  config->interactive_predict = false;
+  config->xinput2_motion = false;
+  config->interactive_motion_hint = false;
+  config->interactive_outline = OUTLINE_OFF;
+  config->interactive_defer_ms = DEFAULT_INTERACTIVE_DEFER_MS;
+  config->interactive_busy_poll_us = 0;
+  config->interactive_boost = false;
+  config->keyboard_step_px = DEFAULT_KEYBOARD_STEP;
+  config->switcher_thumbnails = false;
+  config->switcher_thumbnail_hz = DEFAULT_SWITCHER_THUMBNAIL_HZ;
+  config->memory_budget_mb = 0;
+  config->render_idle_release_s = DEFAULT_RENDER_IDLE_RELEASE_S;
+  config->prewarm_idle_ms = DEFAULT_PREWARM_IDLE_MS;
+  config->ping_interval_ms = DEFAULT_PING_INTERVAL_MS;
+  config->ping_timeout_ms = DEFAULT_PING_TIMEOUT_MS;
+  config->manage_defer_ms = 0;
+  config->frame_pool_size = DEFAULT_FRAME_POOL_SIZE;
   config->snap_enable = true;
   config->snap_threshold_px = DEFAULT_SNAP_THRESHOLD;
   config->snap_preview_border_px = DEFAULT_SNAP_PREVIEW_BORDER;
   config->snap_preview_color = DEFAULT_ACTIVE_BORDER;
+  config->snap_split_percent = DEFAULT_SNAP_SPLIT_PERCENT;
+  config->snap_corner_px = DEFAULT_SNAP_CORNER;
+  config->snap_top_maximize = true;
+  config->snap_edge_resistance_px = DEFAULT_SNAP_EDGE_RESISTANCE;
+  config->tiling_layout = TILE_FLOAT;
+  config->tiling_master_percent = DEFAULT_TILING_MASTER_PERCENT;
+  config->tiling_gap_px = 0;
 
   small_vec_init(&config->key_bindings);
   small_vec_init(&config->rules);
@@ -149,6 +202,100 @@ void config_destroy(config_t* config) {
     free(r);
   }
   small_vec_destroy(&config->rules);
+  rule_set_destroy(&config->rule_set);
+}
+
+static void small_vec_moved(small_vec_t* dst, const small_vec_t* src) {
+  if (src->items == src->inline_storage)
+    dst->items = dst->inline_storage;
+}
+
+void config_move(config_t* dst, config_t* src) {
+  *dst = *src;
+  small_vec_moved(&dst->key_bindings, &src->key_bindings);
+  small_vec_moved(&dst->rules, &src->rules);
+  memset(src, 0, sizeof(*src));
+  small_vec_init(&src->key_bindings);
+  small_vec_init(&src->rules);
+}
+
+static bool str_eq(const char* a, const char* b) {
+  if (!a || !b)
+    return a == b;
+  return strcmp(a, b) == 0;
+}
+
+static bool key_bindings_equal(const small_vec_t* a, const small_vec_t* b) {
+  if (a->length != b->length)
+    return false;
+  for (size_t i = 0; i < a->length; i++) {
+    const key_binding_t* x = a->items[i];
+    const key_binding_t* y = b->items[i];
+    if (x->modifiers != y->modifiers || x->keysym != y->keysym || x->action != y->action || x->repeat_ms != y->repeat_ms || !str_eq(x->exec_cmd, y->exec_cmd))
+      return false;
+  }
+  return true;
+}
+
+static bool rules_equal(const small_vec_t* a, const small_vec_t* b) {
+  if (a->length != b->length)
+    return false;
+  for (size_t i = 0; i < a->length; i++) {
+    const app_rule_t* x = a->items[i];
+    const app_rule_t* y = b->items[i];
+    if (!str_eq(x->class_match, y->class_match) || !str_eq(x->instance_match, y->instance_match) || !str_eq(x->title_match, y->title_match))
+      return false;
+    if (x->type_match != y->type_match || x->transient_match != y->transient_match || x->live != y->live)
+      return false;
+    if (x->desktop != y->desktop || x->layer != y->layer || x->focus != y->focus || x->bypass_compositor != y->bypass_compositor || x->placement != y->placement ||
+        x->outline != y->outline || x->freeze != y->freeze)
+      return false;
+  }
+  return true;
+}
+
+uint32_t config_diff(const config_t* a, const config_t* b) {
+  uint32_t changed = 0;
+
+  // theme_t is all 32-bit scalars, so a byte compare is a value compare
+  if (memcmp(&a->theme, &b->theme, sizeof(a->theme)) != 0 || !str_eq(a->font_name, b->font_name) || a->frame_backing != b->frame_backing)
+    changed |= CONFIG_SECTION_THEME;
+
+  if (!key_bindings_equal(&a->key_bindings, &b->key_bindings))
+    changed |= CONFIG_SECTION_KEYS;
+
+  bool desktops_same = a->desktop_count == b->desktop_count && a->desktop_names_count == b->desktop_names_count;
+  for (uint32_t i = 0; desktops_same && i < a->desktop_names_count; i++)
+    desktops_same = str_eq(a->desktop_names[i], b->desktop_names[i]);
+  if (!desktops_same)
+    changed |= CONFIG_SECTION_DESKTOPS;
+
+  if (!rules_equal(&a->rules, &b->rules))
+    changed |= CONFIG_SECTION_RULES;
+
+  if (a->focus_raise != b->focus_raise || a->focus_follows_mouse != b->focus_follows_mouse || a->focus_hover_delay_ms != b->focus_hover_delay_ms ||
+      a->focus_hover_speed != b->focus_hover_speed || a->fullscreen_use_workarea != b->fullscreen_use_workarea ||
+      a->fullscreen_fast != b->fullscreen_fast || a->compositor != b->compositor ||
+      a->placement != b->placement || a->render_thread != b->render_thread || a->input_thread != b->input_thread || a->focus_boost != b->focus_boost ||
+      a->focus_boost_weight != b->focus_boost_weight || a->focus_boost_delay_ms != b->focus_boost_delay_ms || a->interactive_max_hz != b->interactive_max_hz ||
+      a->interactive_predict != b->interactive_predict || a->xinput2_motion != b->xinput2_motion ||
+      a->interactive_motion_hint != b->interactive_motion_hint || a->interactive_outline != b->interactive_outline ||
+      a->interactive_defer_ms != b->interactive_defer_ms || a->interactive_busy_poll_us != b->interactive_busy_poll_us ||
+      a->interactive_boost != b->interactive_boost ||
+      a->keyboard_step_px != b->keyboard_step_px ||
+      a->switcher_thumbnails != b->switcher_thumbnails || a->switcher_thumbnail_hz != b->switcher_thumbnail_hz ||
+      a->memory_budget_mb != b->memory_budget_mb || a->render_idle_release_s != b->render_idle_release_s ||
+      a->prewarm_idle_ms != b->prewarm_idle_ms || a->ping_interval_ms != b->ping_interval_ms || a->ping_timeout_ms != b->ping_timeout_ms ||
+      a->manage_defer_ms != b->manage_defer_ms || a->frame_pool_size != b->frame_pool_size ||
+      a->tiling_layout != b->tiling_layout || a->tiling_master_percent != b->tiling_master_percent || a->tiling_gap_px != b->tiling_gap_px)
+    changed |= CONFIG_SECTION_POLICY;
+
+  if (a->snap_enable != b->snap_enable || a->snap_threshold_px != b->snap_threshold_px || a->snap_preview_border_px != b->snap_preview_border_px ||
+      a->snap_preview_color != b->snap_preview_color || a->snap_split_percent != b->snap_split_percent || a->snap_corner_px != b->snap_corner_px ||
+      a->snap_top_maximize != b->snap_top_maximize || a->snap_edge_resistance_px != b->snap_edge_resistance_px)
+    changed |= CONFIG_SECTION_SNAP;
+
+  return changed;
 }
 
 static char* trim_whitespace(char* str) {
@@ -212,8 +359,8 @@ static background_style_t parse_appearance_flags(const char* val) {
 
 static void parse_keybind(config_t* config, const char* val) {
   // Format: "Mod4+Shift+Return: exec xterm"
-  // Left side is modifiers + keysym, right side is action [and optional
-  // argument]
+  // Left side is modifiers + keysym [and an optional "repeat=<ms>" cap],
+  // right side is action [and optional argument]
   char* copy = strdup(val);
   char* colon = strchr(copy, ':');
   if (!colon) {
@@ -226,6 +373,21 @@ static void parse_keybind(config_t* config, const char* val) {
   char* keys = trim_whitespace(copy);
   char* action_str = trim_whitespace(colon + 1);
 
+  uint32_t repeat_ms = 0;
+  char* repeat = strstr(keys, "repeat=");
+  if (repeat) {
+    char* end = NULL;
+    unsigned long ms = strtoul(repeat + 7, &end, 10);
+    if (end == repeat + 7 || *trim_whitespace(end) != '\0' || ms > 60000ul) {
+      LOG_WARN("Invalid keybind repeat: %s", val);
+      free(copy);
+      return;
+    }
+    repeat_ms = (uint32_t)ms;
+    *repeat = '\0';
+    keys = trim_whitespace(keys);
+  }
+
   uint32_t mods = 0;
   xcb_keysym_t sym = XKB_KEY_NoSymbol;
 
@@ -294,13 +456,21 @@ static void parse_keybind(config_t* config, const char* val) {
     action = ACTION_MOVE;
   else if (strcasecmp(action_str, "resize") == 0)
     action = ACTION_RESIZE;
+  else if (strcasecmp(action_str, "tile_layout") == 0)
+    action = ACTION_TILE_LAYOUT;
+  else if (strcasecmp(action_str, "tile_toggle") == 0)
+    action = ACTION_TILE_TOGGLE;
+  else if (strcasecmp(action_str, "tile_grow") == 0)
+    action = ACTION_TILE_GROW;
+  else if (strcasecmp(action_str, "tile_shrink") == 0)
+    action = ACTION_TILE_SHRINK;
   else if (strcasecmp(action_str, "restart") == 0)
     action = ACTION_RESTART;
   else if (strcasecmp(action_str, "exit") == 0)
     action = ACTION_EXIT;
 
   if (action != ACTION_NONE) {
-    add_keybind(config, mods, sym, action, cmd);
+    add_keybind(config, mods, sym, action, cmd)->repeat_ms = repeat_ms;
   }
   else {
     LOG_WARN("Unknown action: %s", action_str);
@@ -331,6 +501,8 @@ static void parse_rule(config_t* config, const char* val) {
   r->layer = -1;
   r->focus = -1;
   r->bypass_compositor = -1;
+  r->outline = -1;
+  r->freeze = -1;
 
   char* p = match_part;
   while (p && *p) {
@@ -371,6 +543,9 @@ static void parse_rule(config_t* config, const char* val) {
       else if (strcasecmp(k, "transient") == 0) {
         r->transient_match = (strcasecmp(v, "yes") == 0 || strcasecmp(v, "true") == 0 || strcmp(v, "1") == 0);
       }
+      else if (strcasecmp(k, "live") == 0) {
+        r->live = (strcasecmp(v, "yes") == 0 || strcasecmp(v, "true") == 0 || strcmp(v, "1") == 0);
+      }
     }
     p = comma ? comma + 1 : NULL;
   }
@@ -417,6 +592,14 @@ static void parse_rule(config_t* config, const char* val) {
           r->placement = PLACEMENT_CENTER;
         else if (strcasecmp(v, "mouse") == 0)
           r->placement = PLACEMENT_MOUSE;
+        else if (strcasecmp(v, "smart") == 0)
+          r->placement = PLACEMENT_SMART;
+      }
+      else if (strcasecmp(k, "outline") == 0) {
+        r->outline = (strcasecmp(v, "yes") == 0 || strcasecmp(v, "true") == 0 || strcmp(v, "1") == 0);
+      }
+      else if (strcasecmp(k, "freeze") == 0) {
+        r->freeze = (strcasecmp(v, "yes") == 0 || strcasecmp(v, "true") == 0 || strcmp(v, "1") == 0);
       }
       else if (strcasecmp(k, "bypass_compositor") == 0) {
         if (strcasecmp(v, "yes") == 0 || strcasecmp(v, "true") == 0 || strcmp(v, "1") == 0) {
@@ -556,9 +739,110 @@ bool config_load(config_t* config, const char* path) {
     else if (strcmp(key, "focus_follows_mouse") == 0) {
       config->focus_follows_mouse = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
     }
+    else if (strcmp(key, "focus_hover_delay_ms") == 0) {
+      config->focus_hover_delay_ms = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "focus_hover_speed") == 0) {
+      config->focus_hover_speed = (uint32_t)atoi(val);
+    }
     else if (strcmp(key, "fullscreen_use_workarea") == 0) {
       config->fullscreen_use_workarea = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
     }
+    else if (strcmp(key, "fullscreen_fast") == 0) {
+      config->fullscreen_fast = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "compositor") == 0) {
+      config->compositor = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "placement") == 0) {
+      if (strcasecmp(val, "smart") == 0)
+        config->placement = PLACEMENT_SMART;
+      else if (strcasecmp(val, "center") == 0)
+        config->placement = PLACEMENT_CENTER;
+      else if (strcasecmp(val, "mouse") == 0)
+        config->placement = PLACEMENT_MOUSE;
+      else
+        config->placement = PLACEMENT_DEFAULT;
+    }
+    else if (strcmp(key, "interactive_outline") == 0) {
+      if (strcasecmp(val, "always") == 0 || strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0)
+        config->interactive_outline = OUTLINE_ALWAYS;
+      else if (strcasecmp(val, "auto") == 0)
+        config->interactive_outline = OUTLINE_AUTO;
+      else
+        config->interactive_outline = OUTLINE_OFF;
+    }
+    else if (strcmp(key, "interactive_defer_ms") == 0) {
+      config->interactive_defer_ms = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "interactive_busy_poll_us") == 0) {
+      config->interactive_busy_poll_us = (uint32_t)atoi(val);
+      if (config->interactive_busy_poll_us > MAX_INTERACTIVE_BUSY_POLL_US)
+        config->interactive_busy_poll_us = MAX_INTERACTIVE_BUSY_POLL_US;
+    }
+    else if (strcmp(key, "interactive_boost") == 0) {
+      config->interactive_boost = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "frame_backing") == 0) {
+      config->frame_backing = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "render_thread") == 0) {
+      config->render_thread = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "input_thread") == 0) {
+      config->input_thread = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "focus_boost") == 0) {
+      config->focus_boost = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "focus_boost_weight") == 0) {
+      config->focus_boost_weight = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "focus_boost_delay_ms") == 0) {
+      config->focus_boost_delay_ms = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "interactive_max_hz") == 0) {
+      config->interactive_max_hz = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "keyboard_step_px") == 0) {
+      config->keyboard_step_px = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "interactive_predict") == 0) {
+      config->interactive_predict = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "xinput2_motion") == 0) {
+      config->xinput2_motion = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "interactive_motion_hint") == 0) {
+      config->interactive_motion_hint = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "switcher_thumbnails") == 0) {
+      config->switcher_thumbnails = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "switcher_thumbnail_hz") == 0) {
+      config->switcher_thumbnail_hz = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "memory_budget_mb") == 0) {
+      config->memory_budget_mb = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "render_idle_release_s") == 0) {
+      config->render_idle_release_s = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "prewarm_idle_ms") == 0) {
+      config->prewarm_idle_ms = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "ping_interval_ms") == 0) {
+      config->ping_interval_ms = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "ping_timeout_ms") == 0) {
+      config->ping_timeout_ms = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "manage_defer_ms") == 0) {
+      config->manage_defer_ms = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "frame_pool_size") == 0) {
+      config->frame_pool_size = (uint32_t)atoi(val);
+    }
     else if (strcmp(key, "snap_enable") == 0) {
       config->snap_enable = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
     }
@@ -571,6 +855,34 @@ bool config_load(config_t* config, const char* path) {
     else if (strcmp(key, "snap_preview_color") == 0) {
       config->snap_preview_color = parse_color(val);
     }
+    else if (strcmp(key, "snap_split_percent") == 0) {
+      config->snap_split_percent = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "snap_corner_px") == 0) {
+      config->snap_corner_px = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "snap_top_maximize") == 0) {
+      config->snap_top_maximize = (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    }
+    else if (strcmp(key, "snap_edge_resistance_px") == 0) {
+      config->snap_edge_resistance_px = (uint32_t)atoi(val);
+    }
+    else if (strcmp(key, "tiling") == 0) {
+      if (strcasecmp(val, "master") == 0)
+        config->tiling_layout = TILE_MASTER;
+      else if (strcasecmp(val, "bsp") == 0)
+        config->tiling_layout = TILE_BSP;
+      else
+        config->tiling_layout = TILE_FLOAT;
+    }
+    else if (strcmp(key, "tiling_master_percent") == 0) {
+      config->tiling_master_percent = (uint32_t)atoi(val);
+      if (config->tiling_master_percent < 10 || config->tiling_master_percent > 90)
+        config->tiling_master_percent = DEFAULT_TILING_MASTER_PERCENT;
+    }
+    else if (strcmp(key, "tiling_gap_px") == 0) {
+      config->tiling_gap_px = (uint32_t)atoi(val);
+    }
     else if (strcmp(key, "keybind") == 0) {
       parse_keybind(config, val);
     }
@@ -596,6 +908,7 @@ bool config_load(config_t* config, const char* path) {
 
   free(line);
   fclose(f);
+  rule_set_build(&config->rule_set, &config->rules);
   LOG_INFO("Loaded config from %s", path);
   return true;
 }
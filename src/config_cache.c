@@ -0,0 +1,548 @@
+/* src/config_cache.c
+ * Compiled binary cache of parsed configuration
+ *
+ * An entry is a header, one record per candidate source path, then the
+ * payload written by a codec (config_t below, menu specs in menu.c):
+ *
+ *   header | record + path (padded to 8) ... | payload
+ *
+ * Records are the sources' stamps, checked in order before the payload is
+ * touched. Entries are replaced by write + rename, never edited in place.
+ */
+
+#include "config_cache.h"
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <link.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ds.h"
+#include "rules.h"
+#include "str_intern.h"
+
+/*
+ * "HXMCONF" + format version. Bump the version when config_t, key_binding_t
+ * or app_rule_t change layout; the codec also refuses payloads written with
+ * different struct sizes.
+ */
+#define CONFIG_CACHE_MAGIC 0x02464e4f434d5848ull
+#define CONFIG_CACHE_ABSENT (-1)
+#define CONFIG_CACHE_NULL_STR UINT32_MAX
+
+typedef struct config_cache_header {
+  uint64_t magic;
+  uint32_t kind;
+  uint32_t source_count;
+  uint64_t payload_len;
+  uint64_t build_id; /* config_cache_build_id of the writer */
+} config_cache_header_t;
+
+/* Followed by path_len bytes of path, padded to 8 */
+typedef struct config_cache_record {
+  config_cache_stamp_t stamp;
+  uint32_t path_len;
+  uint32_t reserved;
+} config_cache_record_t;
+
+static size_t config_cache_record_len(size_t path_len) {
+  return sizeof(config_cache_record_t) + ((path_len + 7u) & ~(size_t)7u);
+}
+
+static int config_cache_build_id_note(struct dl_phdr_info* info, size_t size, void* data) {
+  (void)size;
+  for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++) {
+    const ElfW(Phdr)* ph = &info->dlpi_phdr[i];
+    if (ph->p_type != PT_NOTE)
+      continue;
+    const uint8_t* p = (const uint8_t*)(info->dlpi_addr + ph->p_vaddr);
+    const uint8_t* end = p + ph->p_memsz;
+    while ((size_t)(end - p) >= sizeof(ElfW(Nhdr))) {
+      const ElfW(Nhdr)* note = (const ElfW(Nhdr)*)p;
+      size_t name_len = (note->n_namesz + 3u) & ~(size_t)3u;
+      size_t desc_len = (note->n_descsz + 3u) & ~(size_t)3u;
+      const uint8_t* name = p + sizeof(*note);
+      if ((size_t)(end - name) < name_len + desc_len)
+        break;
+      if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 && memcmp(name, "GNU", 4) == 0) {
+        *(uint64_t*)data = str_hash((const char*)(name + name_len), note->n_descsz);
+        return 1;
+      }
+      p = name + name_len + desc_len;
+    }
+  }
+  return 1;  // the executable comes first; shared objects do not matter
+}
+
+/*
+ * The running executable's GNU build-id, hashed; 0 when it has none. The
+ * cached config_t is the defaults with the user's files applied, so another
+ * build, whose defaults or codec may differ, must not reuse it. meson links
+ * with --build-id; a binary without one neither reads nor writes entries.
+ */
+static uint64_t config_cache_build_id(void) {
+  static bool looked_up = false;
+  static uint64_t id = 0;
+  if (!looked_up) {
+    dl_iterate_phdr(config_cache_build_id_note, &id);
+    looked_up = true;
+    if (id == 0)
+      LOG_DEBUG("config cache: executable has no build-id, cache disabled");
+  }
+  return id;
+}
+
+static bool config_cache_path(config_cache_kind_t kind, bool create_dir, char* buf, size_t cap) {
+  const char* xdg = getenv("XDG_CACHE_HOME");
+  const char* home = getenv("HOME");
+  char dir[PATH_MAX];
+  int n;
+  if (xdg && xdg[0] != '\0')
+    n = snprintf(dir, sizeof(dir), "%s/hxm", xdg);
+  else if (home && home[0] != '\0')
+    n = snprintf(dir, sizeof(dir), "%s/.cache/hxm", home);
+  else
+    return false;
+  if (n < 0 || (size_t)n >= sizeof(dir))
+    return false;
+
+  if (create_dir) {
+    // mkdir -p, the cache root may not exist yet
+    for (char* p = dir + 1; *p; p++) {
+      if (*p != '/')
+        continue;
+      *p = '\0';
+      (void)mkdir(dir, 0700);
+      *p = '/';
+    }
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST)
+      return false;
+  }
+
+  n = snprintf(buf, cap, "%s/%s", dir, (kind == CONFIG_CACHE_MENU) ? "menu.cache" : "config.cache");
+  return n > 0 && (size_t)n < cap;
+}
+
+/* Sources */
+
+void config_cache_sources_init(config_cache_sources_t* src) {
+  src->count = 0;
+}
+
+bool config_cache_sources_add(config_cache_sources_t* src, const char* fmt, ...) {
+  if (src->count >= CONFIG_CACHE_MAX_SOURCES)
+    return false;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(src->path[src->count], sizeof(src->path[0]), fmt, ap);
+  va_end(ap);
+  if (n < 0 || (size_t)n >= sizeof(src->path[0]))
+    return false;
+  src->stamp[src->count].mtime_ns = CONFIG_CACHE_ABSENT;
+  src->stamp[src->count].size = 0;
+  src->stamp[src->count].hash = 0;
+  src->count++;
+  return true;
+}
+
+static int64_t config_cache_mtime_ns(const struct stat* st) {
+  return (int64_t)st->st_mtim.tv_sec * 1000000000ll + (int64_t)st->st_mtim.tv_nsec;
+}
+
+static bool config_cache_hash_file(const char* path, uint64_t* out) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  uint64_t hash = 14695981039346656037ull;
+  uint8_t chunk[16384];
+  ssize_t n;
+  while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+    for (ssize_t i = 0; i < n; i++)
+      hash = (hash ^ chunk[i]) * 1099511628211ull;
+  }
+  close(fd);
+  if (n < 0)
+    return false;
+  *out = hash;
+  return true;
+}
+
+/* A path that exists but cannot be read is absent to the loaders too */
+static void config_cache_stamp_one(const char* path, config_cache_stamp_t* stamp) {
+  struct stat st;
+  stamp->mtime_ns = CONFIG_CACHE_ABSENT;
+  stamp->size = 0;
+  stamp->hash = 0;
+  if (stat(path, &st) != 0 || !config_cache_hash_file(path, &stamp->hash))
+    return;
+  stamp->mtime_ns = config_cache_mtime_ns(&st);
+  stamp->size = (int64_t)st.st_size;
+}
+
+void config_cache_stamp(config_cache_sources_t* src) {
+  for (uint32_t i = 0; i < src->count; i++)
+    config_cache_stamp_one(src->path[i], &src->stamp[i]);
+}
+
+typedef enum config_cache_check { CHECK_SAME, CHECK_REHASHED, CHECK_STALE } config_cache_check_t;
+
+/* Compare a recorded stamp with the path now; *now is the current stamp */
+static config_cache_check_t config_cache_check_stamp(const config_cache_stamp_t* rec, const char* path, config_cache_stamp_t* now) {
+  struct stat st;
+  *now = *rec;
+  if (stat(path, &st) != 0)
+    return (rec->mtime_ns == CONFIG_CACHE_ABSENT) ? CHECK_SAME : CHECK_STALE;
+  if (rec->mtime_ns == CONFIG_CACHE_ABSENT || rec->size != (int64_t)st.st_size)
+    return CHECK_STALE;
+  if (rec->mtime_ns == config_cache_mtime_ns(&st))
+    return CHECK_SAME;
+
+  // Touched, or rewritten with the same length: the contents decide
+  uint64_t hash;
+  if (!config_cache_hash_file(path, &hash) || hash != rec->hash)
+    return CHECK_STALE;
+  now->mtime_ns = config_cache_mtime_ns(&st);
+  return CHECK_REHASHED;
+}
+
+/* Entries */
+
+static void config_cache_write(config_cache_kind_t kind, const config_cache_sources_t* src, const void* payload, size_t payload_len) {
+  char cache_path[PATH_MAX];
+  char tmp[PATH_MAX + 16];
+  uint64_t build_id = config_cache_build_id();
+  if (build_id == 0 || !config_cache_path(kind, true, cache_path, sizeof(cache_path)))
+    return;
+  int n = snprintf(tmp, sizeof(tmp), "%s.%ld", cache_path, (long)getpid());
+  if (n < 0 || (size_t)n >= sizeof(tmp))
+    return;
+  FILE* f = fopen(tmp, "wb");
+  if (!f)
+    return;
+
+  static const uint8_t pad[8];
+  config_cache_header_t hdr = {
+      .magic = CONFIG_CACHE_MAGIC,
+      .kind = (uint32_t)kind,
+      .source_count = src->count,
+      .payload_len = payload_len,
+      .build_id = build_id,
+  };
+  bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+  for (uint32_t i = 0; ok && i < src->count; i++) {
+    size_t path_len = strlen(src->path[i]);
+    config_cache_record_t rec = {.stamp = src->stamp[i], .path_len = (uint32_t)path_len};
+    size_t pad_len = config_cache_record_len(path_len) - sizeof(rec) - path_len;
+    ok = fwrite(&rec, sizeof(rec), 1, f) == 1 && fwrite(src->path[i], 1, path_len, f) == path_len && fwrite(pad, 1, pad_len, f) == pad_len;
+  }
+  if (ok && payload_len > 0)
+    ok = fwrite(payload, payload_len, 1, f) == 1;
+  ok = (fclose(f) == 0) && ok;
+  if (!ok || rename(tmp, cache_path) != 0)
+    unlink(tmp);
+}
+
+void config_cache_store(config_cache_kind_t kind, const config_cache_sources_t* src, const config_cache_buf_t* payload) {
+  config_cache_write(kind, src, payload->data, payload->len);
+}
+
+bool config_cache_open(config_cache_map_t* map, config_cache_kind_t kind, const config_cache_sources_t* src) {
+  memset(map, 0, sizeof(*map));
+  char cache_path[PATH_MAX];
+  uint64_t build_id = config_cache_build_id();
+  if (build_id == 0 || !config_cache_path(kind, false, cache_path, sizeof(cache_path)))
+    return false;
+
+  int fd = open(cache_path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(config_cache_header_t)) {
+    close(fd);
+    return false;
+  }
+  size_t len = (size_t)st.st_size;
+  void* addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return false;
+
+  const uint8_t* base = (const uint8_t*)addr;
+  const config_cache_header_t* hdr = (const config_cache_header_t*)addr;
+  bool valid = hdr->magic == CONFIG_CACHE_MAGIC && hdr->build_id == build_id && hdr->kind == (uint32_t)kind && hdr->source_count == src->count;
+  bool rehashed = false;
+  config_cache_sources_t* now = valid ? malloc(sizeof(*now)) : NULL;
+  if (!now)
+    valid = false;
+  else
+    *now = *src;
+
+  size_t off = sizeof(*hdr);
+  for (uint32_t i = 0; valid && i < src->count; i++) {
+    size_t path_len = strlen(src->path[i]);
+    size_t rec_len = config_cache_record_len(path_len);
+    const config_cache_record_t* rec = (const config_cache_record_t*)(base + off);
+    if (len - off < rec_len || rec->path_len != path_len || memcmp(base + off + sizeof(*rec), src->path[i], path_len) != 0) {
+      valid = false;
+      break;
+    }
+    config_cache_check_t check = config_cache_check_stamp(&rec->stamp, src->path[i], &now->stamp[i]);
+    if (check == CHECK_STALE)
+      valid = false;
+    else if (check == CHECK_REHASHED)
+      rehashed = true;
+    off += rec_len;
+  }
+  if (valid && len - off != hdr->payload_len)
+    valid = false;
+
+  if (!valid) {
+    free(now);
+    munmap(addr, len);
+    return false;
+  }
+
+  // Same contents under a new mtime: refresh the stamps so the next start
+  // does not read the sources again
+  if (rehashed)
+    config_cache_write(kind, now, base + off, len - off);
+  free(now);
+
+  map->addr = addr;
+  map->len = len;
+  map->payload.p = base + off;
+  map->payload.end = base + len;
+  map->payload.ok = true;
+  return true;
+}
+
+void config_cache_close(config_cache_map_t* map) {
+  if (map->addr)
+    munmap(map->addr, map->len);
+  memset(map, 0, sizeof(*map));
+}
+
+/* Codec helpers */
+
+void config_cache_buf_free(config_cache_buf_t* buf) {
+  free(buf->data);
+  buf->data = NULL;
+  buf->len = 0;
+  buf->cap = 0;
+}
+
+void config_cache_put(config_cache_buf_t* buf, const void* data, size_t len) {
+  if (buf->len + len > buf->cap) {
+    size_t cap = buf->cap ? buf->cap : 1024;
+    while (cap < buf->len + len)
+      cap *= 2;
+    uint8_t* next = realloc(buf->data, cap);
+    if (!next) {
+      LOG_ERROR("oom");
+      abort();
+    }
+    buf->data = next;
+    buf->cap = cap;
+  }
+  if (len > 0)
+    memcpy(buf->data + buf->len, data, len);
+  buf->len += len;
+}
+
+void config_cache_put_u32(config_cache_buf_t* buf, uint32_t v) {
+  config_cache_put(buf, &v, sizeof(v));
+}
+
+void config_cache_put_u64(config_cache_buf_t* buf, uint64_t v) {
+  config_cache_put(buf, &v, sizeof(v));
+}
+
+void config_cache_put_str(config_cache_buf_t* buf, const char* str) {
+  if (!str) {
+    config_cache_put_u32(buf, CONFIG_CACHE_NULL_STR);
+    return;
+  }
+  size_t len = strlen(str);
+  config_cache_put_u32(buf, (uint32_t)len);
+  config_cache_put(buf, str, len + 1);
+}
+
+bool config_cache_get(config_cache_reader_t* r, void* out, size_t len) {
+  if (!r->ok || (size_t)(r->end - r->p) < len) {
+    r->ok = false;
+    memset(out, 0, len);
+    return false;
+  }
+  memcpy(out, r->p, len);
+  r->p += len;
+  return true;
+}
+
+uint32_t config_cache_get_u32(config_cache_reader_t* r) {
+  uint32_t v;
+  config_cache_get(r, &v, sizeof(v));
+  return v;
+}
+
+uint64_t config_cache_get_u64(config_cache_reader_t* r) {
+  uint64_t v;
+  config_cache_get(r, &v, sizeof(v));
+  return v;
+}
+
+const char* config_cache_get_str(config_cache_reader_t* r) {
+  uint32_t len = config_cache_get_u32(r);
+  if (!r->ok || len == CONFIG_CACHE_NULL_STR)
+    return NULL;
+  if ((size_t)(r->end - r->p) <= len || r->p[len] != '\0') {
+    r->ok = false;
+    return NULL;
+  }
+  const char* str = (const char*)r->p;
+  r->p += (size_t)len + 1;
+  return str;
+}
+
+static char* config_cache_dup_str(config_cache_reader_t* r) {
+  const char* str = config_cache_get_str(r);
+  return str ? strdup(str) : NULL;
+}
+
+/*
+ * config_t codec
+ *
+ * Scalars and the theme go as one struct image with every owned pointer
+ * cleared; strings, bindings and rules follow as lists. The compiled rule
+ * set holds pointers into the rules and is rebuilt from them.
+ */
+
+void config_cache_store_config(const config_t* config, const config_cache_sources_t* src) {
+  config_cache_buf_t buf = {0};
+  config_cache_put_u32(&buf, (uint32_t)sizeof(config_t));
+  config_cache_put_u32(&buf, (uint32_t)sizeof(key_binding_t));
+  config_cache_put_u32(&buf, (uint32_t)sizeof(app_rule_t));
+
+  config_t flat = *config;
+  flat.font_name = NULL;
+  flat.desktop_names = NULL;
+  memset(&flat.key_bindings, 0, sizeof(flat.key_bindings));
+  memset(&flat.rules, 0, sizeof(flat.rules));
+  memset(&flat.rule_set, 0, sizeof(flat.rule_set));
+  config_cache_put(&buf, &flat, sizeof(flat));
+
+  config_cache_put_str(&buf, config->font_name);
+  for (uint32_t i = 0; i < config->desktop_names_count; i++)
+    config_cache_put_str(&buf, config->desktop_names[i]);
+
+  config_cache_put_u32(&buf, (uint32_t)config->key_bindings.length);
+  for (size_t i = 0; i < config->key_bindings.length; i++) {
+    key_binding_t b = *(const key_binding_t*)config->key_bindings.items[i];
+    const char* cmd = b.exec_cmd;
+    b.exec_cmd = NULL;
+    config_cache_put(&buf, &b, sizeof(b));
+    config_cache_put_str(&buf, cmd);
+  }
+
+  config_cache_put_u32(&buf, (uint32_t)config->rules.length);
+  for (size_t i = 0; i < config->rules.length; i++) {
+    const app_rule_t* rule = config->rules.items[i];
+    app_rule_t r = *rule;
+    r.class_match = NULL;
+    r.instance_match = NULL;
+    r.title_match = NULL;
+    config_cache_put(&buf, &r, sizeof(r));
+    config_cache_put_str(&buf, rule->class_match);
+    config_cache_put_str(&buf, rule->instance_match);
+    config_cache_put_str(&buf, rule->title_match);
+  }
+
+  config_cache_store(CONFIG_CACHE_MAIN, src, &buf);
+  config_cache_buf_free(&buf);
+}
+
+/* out is always left destroyable, even when decoding fails */
+static bool config_cache_decode(config_t* out, config_cache_reader_t* r) {
+  memset(out, 0, sizeof(*out));
+  small_vec_init(&out->key_bindings);
+  small_vec_init(&out->rules);
+  if (config_cache_get_u32(r) != sizeof(config_t) || config_cache_get_u32(r) != sizeof(key_binding_t) || config_cache_get_u32(r) != sizeof(app_rule_t))
+    return false;
+
+  // The image carries stale pointer fields; reset them before anything else
+  config_cache_get(r, out, sizeof(*out));
+  uint32_t names = out->desktop_names_count;
+  out->font_name = NULL;
+  out->desktop_names = NULL;
+  out->desktop_names_count = 0;
+  small_vec_init(&out->key_bindings);
+  small_vec_init(&out->rules);
+  memset(&out->rule_set, 0, sizeof(out->rule_set));
+  if (!r->ok)
+    return false;
+
+  out->font_name = config_cache_dup_str(r);
+  if (names > 0) {
+    if (names > (size_t)(r->end - r->p) / sizeof(uint32_t))
+      return false;
+    out->desktop_names = calloc(names, sizeof(char*));
+    if (!out->desktop_names)
+      return false;
+    out->desktop_names_count = names;
+    for (uint32_t i = 0; i < names; i++)
+      out->desktop_names[i] = config_cache_dup_str(r);
+  }
+
+  uint32_t bindings = config_cache_get_u32(r);
+  for (uint32_t i = 0; r->ok && i < bindings; i++) {
+    key_binding_t* b = calloc(1, sizeof(*b));
+    if (!b)
+      return false;
+    config_cache_get(r, b, sizeof(*b));
+    b->exec_cmd = config_cache_dup_str(r);
+    small_vec_push(&out->key_bindings, b);
+  }
+
+  uint32_t rules = config_cache_get_u32(r);
+  for (uint32_t i = 0; r->ok && i < rules; i++) {
+    app_rule_t* rule = calloc(1, sizeof(*rule));
+    if (!rule)
+      return false;
+    config_cache_get(r, rule, sizeof(*rule));
+    rule->class_match = config_cache_dup_str(r);
+    rule->instance_match = config_cache_dup_str(r);
+    rule->title_match = config_cache_dup_str(r);
+    small_vec_push(&out->rules, rule);
+  }
+
+  if (!r->ok || r->p != r->end)
+    return false;
+  rule_set_build(&out->rule_set, &out->rules);
+  return true;
+}
+
+bool config_cache_load_config(config_t* config, const config_cache_sources_t* src) {
+  config_cache_map_t map;
+  if (!config_cache_open(&map, CONFIG_CACHE_MAIN, src))
+    return false;
+
+  config_t next;
+  bool ok = config_cache_decode(&next, &map.payload);
+  config_cache_close(&map);
+  if (!ok) {
+    config_destroy(&next);
+    return false;
+  }
+
+  config_destroy(config);
+  config_move(config, &next);
+  LOG_INFO("Loaded config from cache (%u sources unchanged)", src->count);
+  return true;
+}
@@ -0,0 +1,135 @@
+/* config_watch.c - inotify-driven, debounced config reload trigger */
+
+#include "config_watch.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "hxm.h"
+
+#define CONFIG_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)
+
+static uint32_t config_watch_file_for_name(const char* name) {
+  if (strcmp(name, "hxm.conf") == 0)
+    return CONFIG_WATCH_MAIN;
+  if (strcmp(name, "themerc") == 0)
+    return CONFIG_WATCH_THEME;
+  if (strcmp(name, "menu.conf") == 0)
+    return CONFIG_WATCH_MENU;
+  return 0;
+}
+
+bool config_watch_init(config_watch_t* w) {
+  memset(w, 0, sizeof(*w));
+  w->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (w->inotify_fd < 0) {
+    LOG_WARN("inotify_init1 failed, config changes need SIGHUP: %s", strerror(errno));
+    w->timer_fd = -1;
+    return false;
+  }
+  w->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (w->timer_fd < 0) {
+    LOG_WARN("timerfd_create failed, config changes need SIGHUP: %s", strerror(errno));
+    close(w->inotify_fd);
+    w->inotify_fd = -1;
+    return false;
+  }
+  return true;
+}
+
+void config_watch_add_dir(config_watch_t* w, const char* dir) {
+  if (w->inotify_fd < 0 || !dir)
+    return;
+  // Re-adding a watched directory returns the existing watch
+  if (inotify_add_watch(w->inotify_fd, dir, CONFIG_WATCH_MASK | IN_ONLYDIR) < 0 && errno != ENOENT && errno != ENOTDIR)
+    LOG_DEBUG("inotify_add_watch %s failed: %s", dir, strerror(errno));
+}
+
+void config_watch_add_search_path(config_watch_t* w) {
+  char path[1024];
+  const char* xdg_config_home = getenv("XDG_CONFIG_HOME");
+  const char* home = getenv("HOME");
+
+  if (xdg_config_home) {
+    snprintf(path, sizeof(path), "%s/hxm", xdg_config_home);
+    config_watch_add_dir(w, path);
+  }
+  if (home) {
+    snprintf(path, sizeof(path), "%s/.config/hxm", home);
+    config_watch_add_dir(w, path);
+  }
+  config_watch_add_dir(w, "/etc/hxm");
+  config_watch_add_dir(w, "data");
+  config_watch_add_dir(w, "../data");
+}
+
+void config_watch_handle_inotify(config_watch_t* w) {
+  if (w->inotify_fd < 0)
+    return;
+
+  uint32_t touched = 0;
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  for (;;) {
+    ssize_t n = read(w->inotify_fd, buf, sizeof(buf));
+    if (n <= 0)
+      break;
+    for (char* p = buf; p < buf + n;) {
+      const struct inotify_event* ev = (const struct inotify_event*)p;
+      if (ev->mask & IN_Q_OVERFLOW)
+        touched |= CONFIG_WATCH_ALL;
+      else if (ev->len > 0)
+        touched |= config_watch_file_for_name(ev->name);
+      p += sizeof(*ev) + ev->len;
+    }
+  }
+
+  if (!touched)
+    return;
+
+  // Trailing debounce: an editor's write/rename burst settles into one reload
+  w->pending |= touched;
+  w->settled = false;
+  struct itimerspec its = {0};
+  its.it_value.tv_sec = CONFIG_WATCH_DEBOUNCE_MS / 1000;
+  its.it_value.tv_nsec = (CONFIG_WATCH_DEBOUNCE_MS % 1000) * 1000000L;
+  if (timerfd_settime(w->timer_fd, 0, &its, NULL) < 0) {
+    LOG_WARN("timerfd_settime failed: %s", strerror(errno));
+    w->settled = true;
+  }
+}
+
+void config_watch_handle_timer(config_watch_t* w) {
+  if (w->timer_fd < 0)
+    return;
+  uint64_t expirations;
+  if (read(w->timer_fd, &expirations, sizeof(expirations)) != (ssize_t)sizeof(expirations))
+    return;
+  if (w->pending)
+    w->settled = true;
+}
+
+uint32_t config_watch_take(config_watch_t* w) {
+  if (!w->settled)
+    return 0;
+  uint32_t files = w->pending;
+  w->pending = 0;
+  w->settled = false;
+  return files;
+}
+
+void config_watch_destroy(config_watch_t* w) {
+  if (w->inotify_fd >= 0)
+    close(w->inotify_fd);
+  if (w->timer_fd >= 0)
+    close(w->timer_fd);
+  w->inotify_fd = -1;
+  w->timer_fd = -1;
+  w->pending = 0;
+  w->settled = false;
+}
@@ -0,0 +1,658 @@
+/* src/control.c
+ * Control socket: live JSON snapshots served from the main epoll loop
+ *
+ * Everything here observes, never mutates, WM state. Traversals of linked
+ * structures are capped like the diag.c dumps, so a corrupted focus list
+ * still produces an answer instead of hanging the loop that serves it.
+ *
+ * Connections are a fixed array of CONTROL_MAX_CONNS; a connection past that
+ * is closed on accept. Each one is read until its request line is complete,
+ * answered from a snapshot built at that moment, then written out a chunk
+ * per wakeup with the fd switched to EPOLLOUT.
+ */
+
+#include "control.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "client.h"
+#include "cookie_jar.h"
+#include "event.h"
+#include "hxm.h"
+#include "mem_budget.h"
+
+/* ---------- JSON buffer ---------- */
+
+typedef struct json_buf {
+  char* buf;
+  size_t len;
+  size_t cap;
+  bool overflow; /* hit CONTROL_SNAPSHOT_MAX or out of memory */
+} json_buf_t;
+
+static bool jb_reserve(json_buf_t* jb, size_t extra) {
+  if (jb->overflow)
+    return false;
+  size_t want = jb->len + extra + 1u;
+  if (want <= jb->cap)
+    return true;
+  if (want > CONTROL_SNAPSHOT_MAX) {
+    jb->overflow = true;
+    return false;
+  }
+  size_t cap = jb->cap ? jb->cap : 4096u;
+  while (cap < want)
+    cap *= 2;
+  if (cap > CONTROL_SNAPSHOT_MAX)
+    cap = CONTROL_SNAPSHOT_MAX;
+  char* grown = realloc(jb->buf, cap);
+  if (!grown) {
+    jb->overflow = true;
+    return false;
+  }
+  jb->buf = grown;
+  jb->cap = cap;
+  return true;
+}
+
+static void jb_printf(json_buf_t* jb, const char* fmt, ...) HXM_ATTR_PRINTF(2, 3);
+
+static void jb_printf(json_buf_t* jb, const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+  if (n <= 0 || !jb_reserve(jb, (size_t)n))
+    return;
+  va_start(ap, fmt);
+  vsnprintf(jb->buf + jb->len, jb->cap - jb->len, fmt, ap);
+  va_end(ap);
+  jb->len += (size_t)n;
+}
+
+/* Quoted, escaped string; NULL becomes null */
+static void jb_str(json_buf_t* jb, const char* s) {
+  if (!s) {
+    jb_printf(jb, "null");
+    return;
+  }
+  jb_printf(jb, "\"");
+  for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+    if (*p == '"' || *p == '\\')
+      jb_printf(jb, "\\%c", *p);
+    else if (*p < 0x20)
+      jb_printf(jb, "\\u%04x", *p);
+    else if (jb_reserve(jb, 1))
+      jb->buf[jb->len++] = (char)*p;
+  }
+  jb_printf(jb, "\"");
+}
+
+static double ns_to_us(uint64_t ns) {
+  return (double)ns / 1000.0;
+}
+
+static void jb_hist(json_buf_t* jb, const latency_hist_t* h) {
+  jb_printf(jb, "{\"count\":%" PRIu64 ",\"p50_us\":%.1f,\"p90_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}", h->count,
+            ns_to_us(latency_hist_quantile(h, 5000)), ns_to_us(latency_hist_quantile(h, 9000)), ns_to_us(latency_hist_quantile(h, 9900)),
+            ns_to_us(h->max_ns));
+}
+
+/* Unit-agnostic histogram: raw values for counts and byte sizes */
+static void jb_hist_raw(json_buf_t* jb, const latency_hist_t* h) {
+  jb_printf(jb, "{\"count\":%" PRIu64 ",\"p50\":%" PRIu64 ",\"p90\":%" PRIu64 ",\"p99\":%" PRIu64 ",\"max\":%" PRIu64 "}", h->count,
+            latency_hist_quantile(h, 5000), latency_hist_quantile(h, 9000), latency_hist_quantile(h, 9900), h->max_ns);
+}
+
+/* ---------- Sections ---------- */
+
+static const char* const control_layer_names[LAYER_COUNT] = {
+    "desktop", "below", "normal", "above", "dock", "overlay", "fullscreen",
+};
+
+static const char* const control_state_names[] = {
+    "unmanaged", "new", "ready", "mapped", "unmapped", "destroyed", "unmanaging",
+};
+
+static void section_layers(json_buf_t* jb, server_t* s) {
+  jb_printf(jb, "[");
+  for (uint32_t n = 0; n < server_screen_count(s); n++) {
+    for (int l = 0; l < LAYER_COUNT; l++) {
+      const handle_vec_t* v = &s->screens[n].layers[l];
+      jb_printf(jb, "%s{\"screen\":%u,\"name\":\"%s\",\"count\":%zu,\"clients\":[", (n || l) ? "," : "", n, control_layer_names[l],
+                v->length);
+      for (size_t i = 0; i < v->length; i++) {
+        const client_hot_t* c = server_chot(s, v->items[i]);
+        jb_printf(jb, "%s%u", i ? "," : "", c ? c->xid : 0u);
+      }
+      jb_printf(jb, "]}");
+    }
+  }
+  jb_printf(jb, "]");
+}
+
+static void section_focus(json_buf_t* jb, server_t* s) {
+  const client_hot_t* focused = server_chot(s, s->focused_client);
+  jb_printf(jb, "{\"focused\":%u,\"committed_focus\":%u,\"mru\":[", focused ? focused->xid : 0u, s->committed_focus);
+
+  const focus_mru_t* m = &s->focus_mru;
+  bool broken = false;
+  if (m->entries) {
+    uint32_t slot = m->entries[0].next;
+    uint32_t guard = 0;
+    while (slot != 0) {
+      // A loop or a dangling link ends the walk; the flag tells the reader
+      if (slot >= m->used || guard > m->count) {
+        broken = true;
+        break;
+      }
+      const focus_mru_entry_t* e = &m->entries[slot];
+      const client_hot_t* c = server_chot(s, e->h);
+      jb_printf(jb, "%s{\"xid\":%u,\"desktop\":%d}", guard ? "," : "", c ? c->xid : 0u, e->desktop);
+      slot = e->next;
+      guard++;
+    }
+  }
+  jb_printf(jb, "],\"mru_broken\":%s}", broken ? "true" : "false");
+}
+
+static void section_cookies(json_buf_t* jb, server_t* s) {
+  const cookie_jar_t* cj = &s->cookie_jar;
+  const cookie_jar_stats_t* st = cj->stats;
+  jb_printf(jb, "{\"live\":%zu,\"cap\":%zu", cj->live_count, cj->cap);
+  if (!st) {
+    jb_printf(jb, "}");
+    return;
+  }
+  jb_printf(jb, ",\"live_max\":%zu,\"grows\":%u,\"drains\":%" PRIu64 ",\"budget_limited\":%" PRIu64 ",\"probe_len\":[", st->live_max, st->grows,
+            st->drains, st->budget_limited);
+  for (int i = 0; i < COOKIE_JAR_PROBE_BUCKETS; i++)
+    jb_printf(jb, "%s%" PRIu64, i ? "," : "", st->probe_len[i]);
+  jb_printf(jb, "],\"types\":{");
+  bool first = true;
+  for (int i = 0; i < COOKIE_TYPE_COUNT; i++) {
+    const cookie_type_stats_t* t = &st->type[i];
+    if (t->pushed == 0)
+      continue;
+    jb_printf(jb, "%s\"%s\":{\"pushed\":%" PRIu64 ",\"completed\":%" PRIu64 ",\"errors\":%" PRIu64 ",\"timed_out\":%" PRIu64 ",\"dropped\":%" PRIu64
+                  ",\"latency\":",
+              first ? "" : ",", cookie_type_name((cookie_type_t)i), t->pushed, t->completed, t->errors, t->timed_out, t->dropped);
+    jb_hist(jb, &t->latency);
+    jb_printf(jb, "}");
+    first = false;
+  }
+  jb_printf(jb, "}}");
+}
+
+static void section_ticks(json_buf_t* jb, server_t* s) {
+  (void)s;
+  jb_printf(jb, "{");
+  for (int i = 0; i < TICK_PHASE_COUNT; i++) {
+    jb_printf(jb, "%s\"%s\":", i ? "," : "", tick_phase_name((tick_phase_t)i));
+    jb_hist(jb, &tick_stats.phase[i]);
+  }
+  jb_printf(jb, "}");
+}
+
+static void section_requests(json_buf_t* jb, server_t* s) {
+  jb_printf(jb, "{\"x\":{");
+  for (int i = 0; i < XREQ_KIND_COUNT; i++)
+    jb_printf(jb, "%s\"%s\":%" PRIu64, i ? "," : "", xreq_kind_name((xreq_kind_t)i), xreq_counts[i]);
+  jb_printf(jb, "},\"x_tick_max\":{");
+  for (int i = 0; i < XREQ_KIND_COUNT; i++)
+    jb_printf(jb, "%s\"%s\":%u", i ? "," : "", xreq_kind_name((xreq_kind_t)i), tick_stats.xreq_max[i]);
+  jb_printf(jb, "},\"per_tick\":");
+  jb_hist_raw(jb, &tick_stats.x_requests);
+  jb_printf(jb, ",\"bytes_per_tick\":");
+  jb_hist_raw(jb, &tick_stats.x_bytes);
+  const event_buckets_t* b = &s->buckets;
+  jb_printf(jb, ",\"bytes_total\":%" PRIu64 ",\"unmanaged_configure\":{\"forwarded\":%" PRIu64 ",\"coalesced\":%" PRIu64 "}", tick_stats.x_bytes_total,
+            b->unmanaged_forwarded, b->unmanaged_coalesced);
+  jb_printf(jb, ",\"client_messages_coalesced\":%" PRIu64 ",\"props_deferred\":%" PRIu64 ",\"input_flushes\":%" PRIu64 "}", b->client_messages_dropped,
+            b->props_deferred, b->input_flushes);
+}
+
+static void section_wakeups(json_buf_t* jb, server_t* s) {
+  jb_printf(jb, "{");
+  for (int i = 0; i < WAKE_CAUSE_COUNT; i++)
+    jb_printf(jb, "%s\"%s\":%" PRIu64, i ? "," : "", wake_cause_name((wake_cause_t)i), s->wakeups[i]);
+  jb_printf(jb, ",\"timers_pending\":%u,\"timer_armed_ns\":%" PRIu64, s->timers.count, s->timer_armed_ns);
+  jb_printf(jb, ",\"busy_poll\":{\"hits\":%" PRIu64 ",\"misses\":%" PRIu64 "}", s->busy_poll_hits, s->busy_poll_misses);
+  jb_printf(jb, ",\"boost\":{\"active\":%s,\"policy\":\"%s\",\"denied\":%s,\"grabs\":%" PRIu64 "}", s->boost_active ? "true" : "false",
+            s->boost_rr ? "rr" : "nice", s->boost_denied ? "true" : "false", s->boosts);
+  jb_printf(jb, ",\"fullscreen_fast\":{\"active\":%s,\"entered\":%" PRIu64 ",\"paints_held\":%" PRIu64 "}}", s->fs_fast != HANDLE_INVALID ? "true" : "false",
+            s->fs_fast_entered, s->fs_fast_paints_held);
+}
+
+static void section_memory(json_buf_t* jb, server_t* s) {
+  uint32_t cap = slotmap_capacity(&s->clients);
+  jb_printf(jb, "{\"clients\":{\"live\":%zu,\"cap\":%u,\"hot_bytes\":%zu,\"cold_bytes\":%zu}", s->active_clients.length, cap,
+            (size_t)cap * s->clients.hot_sz, (size_t)cap * s->clients.cold_sz);
+  jb_printf(jb, ",\"tick_arena\":{\"used\":%zu,\"reserved\":%zu,\"blocks\":%zu,\"shrinks\":%" PRIu64 "}", s->tick_arena.used,
+            s->tick_arena.reserved, s->tick_arena.blocks, (uint64_t)s->tick_arena.shrinks);
+  jb_printf(jb, ",\"title_cache\":{\"entries\":%zu,\"hits\":%" PRIu64 ",\"misses\":%" PRIu64 ",\"evictions\":%" PRIu64 "}", s->title_cache.count,
+            s->title_cache.hits, s->title_cache.misses, s->title_cache.evictions);
+  jb_printf(jb, ",\"prewarm\":{\"slices\":%" PRIu64 ",\"painted\":%" PRIu64 ",\"yields\":%" PRIu64 ",\"budget_stops\":%" PRIu64 "}", s->prewarm.slices,
+            s->prewarm.painted, s->prewarm.yields, s->prewarm.budget_stops);
+  jb_printf(jb, ",\"icon_cache\":{\"entries\":%zu,\"hits\":%" PRIu64 ",\"misses\":%" PRIu64 "}", hash_map_size(&s->icon_cache.by_hash),
+            s->icon_cache.hits, s->icon_cache.misses);
+  jb_printf(jb, ",\"cookie_jar\":{\"cap\":%zu,\"deadline_cap\":%zu,\"order_cap\":%zu,\"groups\":%u}", s->cookie_jar.cap,
+            s->cookie_jar.deadline_cap, s->cookie_jar.order_cap, s->cookie_jar.group_cap);
+  jb_printf(jb, ",\"maps\":{\"xid_index\":%zu,\"prop_fetches\":%zu}", hash_map_size(&s->xid_index), hash_map_size(&s->prop_fetches));
+
+  mem_usage_t usage;
+  mem_usage_measure(s, &usage);
+  const mem_budget_t* mb = &s->mem_budget;
+  jb_printf(jb, ",\"usage\":{\"total\":%zu,\"peak\":%zu,\"budget\":%zu", usage.total, mb->peak_total > usage.total ? mb->peak_total : usage.total,
+            (size_t)s->config.memory_budget_mb << 20);
+  for (int i = 0; i < MEM_CLASS_COUNT; i++)
+    jb_printf(jb, ",\"%s\":%zu", mem_class_name((mem_class_t)i), usage.bytes[i]);
+  jb_printf(jb, "},\"evicted\":{");
+  for (int i = 0; i < MEM_EVICT_COUNT; i++)
+    jb_printf(jb, "%s\"%s\":{\"count\":%" PRIu64 ",\"bytes\":%zu}", i ? "," : "", mem_evict_name((mem_evict_t)i), mb->evicted[i], mb->evicted_bytes[i]);
+  jb_printf(jb, "}}");
+}
+
+static void section_clients(json_buf_t* jb, server_t* s) {
+  jb_printf(jb, "[");
+  bool first = true;
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t h = s->active_clients.items[i];
+    const client_hot_t* hot = server_chot(s, h);
+    const client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold)
+      continue;
+    const char* state = hot->state < sizeof(control_state_names) / sizeof(control_state_names[0]) ? control_state_names[hot->state] : "?";
+    int layer = stack_current_layer(hot);
+    jb_printf(jb, "%s{\"xid\":%u,\"frame\":%u,\"state\":\"%s\",\"dirty\":\"0x%x\",\"desktop\":%d,\"layer\":\"%s\",\"title\":", first ? "" : ",",
+              hot->xid, hot->frame, state, hot->dirty, hot->desktop, layer >= 0 && layer < LAYER_COUNT ? control_layer_names[layer] : "?");
+    jb_str(jb, cold->title);
+    jb_printf(jb, ",\"class\":");
+    jb_str(jb, cold->wm_class);
+    jb_printf(jb, "}");
+    first = false;
+  }
+  jb_printf(jb, "]");
+}
+
+typedef void (*control_section_fn)(json_buf_t* jb, server_t* s);
+
+static const struct {
+  const char* name;
+  control_section_fn fn;
+} control_sections[] = {
+    {"layers", section_layers}, {"focus", section_focus},   {"cookies", section_cookies},
+    {"ticks", section_ticks},   {"memory", section_memory}, {"clients", section_clients},
+    {"wakeups", section_wakeups}, {"requests", section_requests},
+};
+
+#define CONTROL_SECTION_COUNT (sizeof(control_sections) / sizeof(control_sections[0]))
+
+char* control_snapshot(server_t* s, const char* section, size_t* len_out) {
+  bool all = !section || !*section || strcmp(section, "all") == 0;
+  json_buf_t jb = {0};
+
+  jb_printf(&jb, "{");
+  bool found = false;
+  for (size_t i = 0; i < CONTROL_SECTION_COUNT; i++) {
+    if (!all && strcmp(section, control_sections[i].name) != 0)
+      continue;
+    jb_printf(&jb, "%s\"%s\":", found ? "," : "", control_sections[i].name);
+    control_sections[i].fn(&jb, s);
+    found = true;
+  }
+  jb_printf(&jb, "}\n");
+
+  if (!found) {
+    free(jb.buf);
+    return NULL;
+  }
+  if (jb.overflow) {
+    free(jb.buf);
+    const char* msg = "{\"error\":\"snapshot too large\"}\n";
+    char* out = strdup(msg);
+    if (len_out)
+      *len_out = out ? strlen(out) : 0;
+    return out;
+  }
+  if (len_out)
+    *len_out = jb.len;
+  return jb.buf;
+}
+
+/* ---------- Socket ---------- */
+
+void control_init(control_t* c) {
+  memset(c, 0, sizeof(*c));
+  c->listen_fd = -1;
+  c->epoll_fd = -1;
+  for (int i = 0; i < CONTROL_MAX_CONNS; i++)
+    c->conns[i].fd = -1;
+}
+
+bool control_socket_path(char* buf, size_t len) {
+  const char* env = getenv(CONTROL_SOCKET_ENV);
+  if (env) {
+    if (!*env)
+      return false;
+    return (size_t)snprintf(buf, len, "%s", env) < len;
+  }
+
+  const char* dir = getenv("XDG_RUNTIME_DIR");
+  if (!dir || !*dir)
+    return false;
+  const char* display = getenv("DISPLAY");
+  char disp[64];
+  snprintf(disp, sizeof(disp), "%s", display && *display ? display : ":0");
+  // DISPLAY may carry a path (launchd, ssh); keep the name one component
+  for (char* p = disp; *p; p++) {
+    if (*p == '/')
+      *p = '_';
+  }
+  return (size_t)snprintf(buf, len, "%s/hxm-%s.sock", dir, disp) < len;
+}
+
+static void control_epoll_set(control_t* c, int fd, int op, uint32_t events) {
+  if (c->epoll_fd < 0)
+    return;
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.fd = fd;
+  if (epoll_ctl(c->epoll_fd, op, fd, &ev) < 0)
+    LOG_WARN("control: epoll_ctl fd=%d: %s", fd, strerror(errno));
+}
+
+bool control_open(control_t* c, int epoll_fd) {
+  char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+  if (!control_socket_path(path, sizeof(path)))
+    return false;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    LOG_WARN("control socket: %s", strerror(errno));
+    return false;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path, strlen(path) + 1u);
+
+  // We own the display now, so a leftover socket is from a previous run.
+  // Anything else at the path is left alone and bind reports it.
+  struct stat st;
+  if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(path);
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, CONTROL_MAX_CONNS) < 0) {
+    LOG_WARN("control socket %s: %s", path, strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  c->path = strdup(path);
+  c->listen_fd = fd;
+  c->epoll_fd = epoll_fd;
+  control_epoll_set(c, fd, EPOLL_CTL_ADD, EPOLLIN);
+  LOG_INFO("Control socket at %s", path);
+  return true;
+}
+
+static void control_conn_close(control_t* c, control_conn_t* conn) {
+  if (conn->fd < 0)
+    return;
+  control_epoll_set(c, conn->fd, EPOLL_CTL_DEL, 0);
+  close(conn->fd);
+  free(conn->out);
+  memset(conn, 0, sizeof(*conn));
+  conn->fd = -1;
+}
+
+void control_close(control_t* c) {
+  for (int i = 0; i < CONTROL_MAX_CONNS; i++)
+    control_conn_close(c, &c->conns[i]);
+  if (c->listen_fd >= 0) {
+    control_epoll_set(c, c->listen_fd, EPOLL_CTL_DEL, 0);
+    close(c->listen_fd);
+  }
+  if (c->path)
+    unlink(c->path);
+  free(c->path);
+  control_init(c);
+}
+
+bool control_owns_fd(const control_t* c, int fd) {
+  if (fd < 0 || c->listen_fd < 0)
+    return false;
+  if (fd == c->listen_fd)
+    return true;
+  for (int i = 0; i < CONTROL_MAX_CONNS; i++) {
+    if (c->conns[i].fd == fd)
+      return true;
+  }
+  return false;
+}
+
+static void control_accept(control_t* c) {
+  for (;;) {
+    int fd = accept4(c->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        LOG_WARN("control accept: %s", strerror(errno));
+      return;
+    }
+
+    struct ucred cred;
+    socklen_t cred_len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) < 0 || cred.uid != getuid()) {
+      close(fd);
+      continue;
+    }
+
+    control_conn_t* conn = NULL;
+    for (int i = 0; i < CONTROL_MAX_CONNS && !conn; i++) {
+      if (c->conns[i].fd < 0)
+        conn = &c->conns[i];
+    }
+    if (!conn) {
+      close(fd);
+      continue;
+    }
+    conn->fd = fd;
+    control_epoll_set(c, fd, EPOLL_CTL_ADD, EPOLLIN);
+  }
+}
+
+static void control_respond(control_t* c, server_t* s, control_conn_t* conn) {
+  char* nl = memchr(conn->in, '\n', conn->in_len);
+  size_t n = nl ? (size_t)(nl - conn->in) : conn->in_len;
+  while (n > 0 && (conn->in[n - 1] == '\r' || conn->in[n - 1] == ' '))
+    n--;
+  conn->in[n] = '\0';
+
+  conn->out = control_snapshot(s, conn->in, &conn->out_len);
+  if (!conn->out) {
+    conn->out = strdup("{\"error\":\"unknown section\"}\n");
+    conn->out_len = conn->out ? strlen(conn->out) : 0;
+  }
+  if (!conn->out) {
+    control_conn_close(c, conn);
+    return;
+  }
+  conn->out_off = 0;
+  conn->writing = true;
+  shutdown(conn->fd, SHUT_RD);
+  control_epoll_set(c, conn->fd, EPOLL_CTL_MOD, EPOLLOUT);
+}
+
+static void control_read(control_t* c, server_t* s, control_conn_t* conn) {
+  for (;;) {
+    size_t room = sizeof(conn->in) - 1u - conn->in_len;
+    if (room == 0) {
+      // Overlong request: answer whatever fits, which names no section
+      control_respond(c, s, conn);
+      return;
+    }
+    ssize_t n = read(conn->fd, conn->in + conn->in_len, room);
+    if (n > 0) {
+      conn->in_len += (uint32_t)n;
+      if (memchr(conn->in, '\n', conn->in_len)) {
+        control_respond(c, s, conn);
+        return;
+      }
+      continue;
+    }
+    if (n == 0) {
+      // Half-closed without a newline: the request is what we have
+      control_respond(c, s, conn);
+      return;
+    }
+    if (errno == EINTR)
+      continue;
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+      control_conn_close(c, conn);
+    return;
+  }
+}
+
+static void control_write(control_t* c, control_conn_t* conn) {
+  size_t left = conn->out_len - conn->out_off;
+  size_t chunk = left < CONTROL_WRITE_CHUNK ? left : CONTROL_WRITE_CHUNK;
+  ssize_t n = send(conn->fd, conn->out + conn->out_off, chunk, MSG_NOSIGNAL);
+  if (n < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      control_conn_close(c, conn);
+    return;
+  }
+  conn->out_off += (size_t)n;
+  if (conn->out_off == conn->out_len)
+    control_conn_close(c, conn);
+}
+
+void control_handle(control_t* c, server_t* s, int fd, uint32_t events) {
+  if (fd == c->listen_fd) {
+    control_accept(c);
+    return;
+  }
+
+  control_conn_t* conn = NULL;
+  for (int i = 0; i < CONTROL_MAX_CONNS && !conn; i++) {
+    if (c->conns[i].fd == fd)
+      conn = &c->conns[i];
+  }
+  if (!conn)
+    return;
+
+  if (conn->writing) {
+    if (events & (EPOLLERR | EPOLLHUP))
+      control_conn_close(c, conn);
+    else
+      control_write(c, conn);
+    return;
+  }
+  if (events & EPOLLERR) {
+    control_conn_close(c, conn);
+    return;
+  }
+  control_read(c, s, conn);
+}
+
+/* ---------- Client ---------- */
+
+int control_query(const char* section, FILE* out) {
+  char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+  if (!control_socket_path(path, sizeof(path))) {
+    fprintf(stderr, "Control socket disabled (set %s or XDG_RUNTIME_DIR)\n", CONTROL_SOCKET_ENV);
+    return -1;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path, strlen(path) + 1u);
+  if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  char req[CONTROL_MAX_REQUEST];
+  int req_len = snprintf(req, sizeof(req), "%s\n", section ? section : "all");
+  if (req_len < 0 || (size_t)req_len >= sizeof(req) || write(fd, req, (size_t)req_len) != req_len) {
+    fprintf(stderr, "control request failed\n");
+    close(fd);
+    return -1;
+  }
+
+  char buf[4096];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR)) {
+    if (n > 0)
+      fwrite(buf, 1, (size_t)n, out);
+  }
+  close(fd);
+  return n == 0 ? 0 : -1;
+}
+
+/* Query the wakeups section into counts */
+static bool control_read_wakeups(uint64_t counts[WAKE_CAUSE_COUNT]) {
+  char* text = NULL;
+  size_t len = 0;
+  FILE* mem = open_memstream(&text, &len);
+  if (!mem)
+    return false;
+  int rc = control_query("wakeups", mem);
+  fclose(mem);
+
+  bool ok = rc == 0 && text;
+  for (int i = 0; ok && i < WAKE_CAUSE_COUNT; i++) {
+    char key[32];
+    snprintf(key, sizeof(key), "\"%s\":", wake_cause_name((wake_cause_t)i));
+    const char* at = strstr(text, key);
+    if (!at) {
+      ok = false;
+      break;
+    }
+    counts[i] = strtoull(at + strlen(key), NULL, 10);
+  }
+  if (!ok)
+    fprintf(stderr, "unexpected wakeups answer\n");
+  free(text);
+  return ok;
+}
+
+int control_idle_check(unsigned seconds, FILE* out) {
+  uint64_t before[WAKE_CAUSE_COUNT], after[WAKE_CAUSE_COUNT];
+  if (!control_read_wakeups(before))
+    return -1;
+  for (unsigned left = seconds; left > 0;)
+    left = sleep(left);
+  if (!control_read_wakeups(after))
+    return -1;
+
+  // Our own queries show up as "other"; everything else should be silent
+  uint64_t loud = 0;
+  fprintf(out, "idle %us:", seconds);
+  for (int i = 0; i < WAKE_CAUSE_COUNT; i++) {
+    uint64_t d = after[i] - before[i];
+    fprintf(out, " %s=%" PRIu64, wake_cause_name((wake_cause_t)i), d);
+    if (i != WAKE_OTHER)
+      loud += d;
+  }
+  fprintf(out, "\n%s\n", loud == 0 ? "PASS: no wakeups while idle" : "FAIL: woke while idle");
+  return loud == 0 ? 0 : 1;
+}
@@ -66,6 +66,13 @@
  *
  * This preserves lookup correctness without tombstones.
  *
+ * Sequences are pushed in ascending order, so a burst of cookies forms one
+ * long run of slots that each sit at home. The jar keeps probe_max, an
+ * upper bound on how far any live slot sits from its home, and the shift
+ * stops once it is further than that from the hole: nothing beyond could
+ * move into it. Removing the oldest cookie of a burst is then O(1) instead
+ * of a walk over the whole run.
+ *
  * ---------------------------------------------------------------------
  * Fair reply polling
  * ---------------------------------------------------------------------
@@ -108,7 +115,18 @@
  * This provides an O(1) hint for the next timeout deadline.
  *
  * If the earliest entry is removed, the hint becomes dirty and is
- * recomputed lazily.
+ * recomputed lazily from a deadline min-heap:
+ *
+ *      deadlines[]  (timestamp_ns, sequence), ordered by timestamp_ns
+ *
+ * Removing a slot does not touch the heap. Instead, entries are checked
+ * against the table when they reach the top and discarded if the
+ * sequence is gone or was re-pushed with a newer timestamp. Expiry pops
+ * from the top, so both the hint refresh and cookie_jar_expire cost
+ * O(log n) per cookie instead of a full table scan.
+ *
+ * Stale entries pile up behind a long-lived cookie, so the heap is
+ * rebuilt from the table once it holds more than twice the live count.
  *
  * ---------------------------------------------------------------------
  * Re-entrancy guarantee
@@ -148,8 +166,37 @@
  * the sequence carried by a reply identifies the request it belongs to,
  * even when unrelated events interleave on the connection.
  *
- * Dispatch order here is driven by table scan position and fairness
- * limits, not by strict sequence order.
+ * The X server answers requests in sequence order and libxcb reads them
+ * in that order, so once the reply for sequence N is not yet available,
+ * nothing after N can be either. The jar keeps a ring of live sequences in
+ * ascending order next to the table:
+ *
+ *      order[]  lowest live sequence at order_head
+ *
+ * In ordered mode (the default) drain polls only the head and stops at the
+ * first sequence that is not ready, so its cost follows the number of
+ * replies received rather than the number of live cookies. Entries whose
+ * slot was removed (timeout, remove_client) are dropped when they reach
+ * the head. Pushes are almost always in ascending order, so insertion is
+ * an append with a short backward walk in the rare out-of-order case.
+ *
+ * With ordered=false drain falls back to a fair scan driven by table scan
+ * position, for callers whose reply source does not follow X ordering.
+ *
+ * ---------------------------------------------------------------------
+ * Per-client lists
+ * ---------------------------------------------------------------------
+ *
+ * Every cookie pushed for a client is linked into a doubly linked list
+ * through client_prev/client_next, headed in client_cookies:
+ *
+ *      client_cookies[client] -> newest seq -> ... -> oldest seq
+ *
+ * Links name sequences rather than table indices, so backshift deletion
+ * and growth move slots without touching the lists; following a link is
+ * one probe. cookie_jar_remove unlinks, so the lists only ever hold live
+ * cookies and cookie_jar_remove_client costs O(k) in the client's own
+ * cookies instead of a walk over the whole table.
  */
 
 #include "cookie_jar.h"
@@ -157,16 +204,21 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <xcb/xcbext.h>
 
+#include "event_trace.h"
 #include "hxm.h"
+#include "tracepoint.h"
 
 __attribute__((weak)) void* cj_calloc(size_t n, size_t size) {
   return calloc(n, size);
 }
 
+static size_t cookie_jar_probe(const cookie_jar_t* cj, uint32_t seq);
+
 // Load factor threshold: grow when live_count/cap >= 0.7
 #define COOKIE_JAR_MAX_LOAD_NUM 7
 #define COOKIE_JAR_MAX_LOAD_DEN 10
@@ -202,6 +254,223 @@ static inline size_t cookie_next(size_t i, size_t mask) {
   return (i + 1) & mask;
 }
 
+/* ---------- Telemetry ---------- */
+
+static const char* const cookie_type_names[COOKIE_TYPE_COUNT] = {
+    [COOKIE_NONE] = "none",
+    [COOKIE_GET_WINDOW_ATTRIBUTES] = "get_window_attributes",
+    [COOKIE_GET_GEOMETRY] = "get_geometry",
+    [COOKIE_GET_PROPERTY] = "get_property",
+    [COOKIE_GET_PROPERTY_FRAME_EXTENTS] = "get_property_frame_extents",
+    [COOKIE_GET_PROPERTY_ICON_HEADER] = "get_property_icon_header",
+    [COOKIE_GET_PROPERTY_ICON_PIXELS] = "get_property_icon_pixels",
+    [COOKIE_QUERY_TREE] = "query_tree",
+    [COOKIE_QUERY_POINTER] = "query_pointer",
+    [COOKIE_SYNC_QUERY_COUNTER] = "sync_query_counter",
+    [COOKIE_CHECK_MANAGE_MAP_REQUEST] = "check_manage_map_request",
+    [COOKIE_GRAB_POINTER] = "grab_pointer",
+    [COOKIE_GRAB_KEYBOARD] = "grab_keyboard",
+    [COOKIE_GRAB_KEY] = "grab_key",
+    [COOKIE_RANDR_GET_SCREEN_RESOURCES] = "randr_get_screen_resources",
+    [COOKIE_RANDR_GET_CRTC_INFO] = "randr_get_crtc_info",
+};
+
+const char* cookie_type_name(cookie_type_t type) {
+  if ((unsigned)type >= COOKIE_TYPE_COUNT || !cookie_type_names[type])
+    return "unknown";
+  return cookie_type_names[type];
+}
+
+static inline cookie_type_stats_t* cookie_stats_for(cookie_jar_t* cj, cookie_type_t type) {
+  return &cj->stats->type[(unsigned)type < COOKIE_TYPE_COUNT ? type : COOKIE_NONE];
+}
+
+static void cookie_stats_reply(cookie_jar_t* cj, const cookie_slot_t* slot, const xcb_generic_error_t* err) {
+  cookie_type_stats_t* t = cookie_stats_for(cj, slot->type);
+  if (err)
+    t->errors++;
+  else
+    t->completed++;
+  uint64_t now = monotonic_time_ns();
+  latency_hist_record(&t->latency, now >= slot->timestamp_ns ? now - slot->timestamp_ns : 0);
+}
+
+/* ---------- Deadline heap ---------- */
+
+static inline bool deadline_less(const cookie_deadline_t* a, const cookie_deadline_t* b) {
+  return a->timestamp_ns < b->timestamp_ns;
+}
+
+static void deadline_sift_up(cookie_deadline_t* h, size_t i) {
+  cookie_deadline_t e = h[i];
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (!deadline_less(&e, &h[parent]))
+      break;
+    h[i] = h[parent];
+    i = parent;
+  }
+  h[i] = e;
+}
+
+static void deadline_sift_down(cookie_deadline_t* h, size_t len, size_t i) {
+  cookie_deadline_t e = h[i];
+  for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= len)
+      break;
+    if (child + 1 < len && deadline_less(&h[child + 1], &h[child]))
+      child++;
+    if (!deadline_less(&h[child], &e))
+      break;
+    h[i] = h[child];
+    i = child;
+  }
+  h[i] = e;
+}
+
+static void deadline_reserve(cookie_jar_t* cj, size_t want) {
+  if (want <= cj->deadline_cap)
+    return;
+
+  size_t new_cap = cj->deadline_cap ? cj->deadline_cap : 16;
+  while (new_cap < want)
+    new_cap <<= 1;
+
+  cookie_deadline_t* next = cj_calloc(new_cap, sizeof(*next));
+  if (!next) {
+    LOG_ERROR("cookie_jar deadline heap allocation failed");
+    exit(1);
+  }
+  if (cj->deadline_len)
+    memcpy(next, cj->deadlines, cj->deadline_len * sizeof(*next));
+  free(cj->deadlines);
+  cj->deadlines = next;
+  cj->deadline_cap = new_cap;
+}
+
+static void deadline_rebuild(cookie_jar_t* cj) {
+  // Drop stale entries by re-deriving the heap from the live table
+  deadline_reserve(cj, cj->live_count);
+
+  size_t n = 0;
+  for (size_t i = 0; i < cj->cap; i++) {
+    if (!cj->slots[i].live)
+      continue;
+    cj->deadlines[n].timestamp_ns = cj->slots[i].timestamp_ns;
+    cj->deadlines[n].sequence = cj->slots[i].sequence;
+    n++;
+  }
+  cj->deadline_len = n;
+
+  for (size_t i = n / 2; i-- > 0;)
+    deadline_sift_down(cj->deadlines, n, i);
+}
+
+static void deadline_push(cookie_jar_t* cj, uint64_t ts, uint32_t seq) {
+  if (cj->deadline_len >= 2 * cj->live_count + 64 && cj->deadline_len == cj->deadline_cap) {
+    deadline_rebuild(cj);
+    // The caller already stored the slot, so the rebuild covers this entry
+    return;
+  }
+
+  deadline_reserve(cj, cj->deadline_len + 1);
+  size_t i = cj->deadline_len++;
+  cj->deadlines[i].timestamp_ns = ts;
+  cj->deadlines[i].sequence = seq;
+  deadline_sift_up(cj->deadlines, i);
+}
+
+static void deadline_pop(cookie_jar_t* cj) {
+  assert(cj->deadline_len > 0);
+  cj->deadline_len--;
+  if (cj->deadline_len > 0) {
+    cj->deadlines[0] = cj->deadlines[cj->deadline_len];
+    deadline_sift_down(cj->deadlines, cj->deadline_len, 0);
+  }
+}
+
+/*
+ * Return the table index of the live slot the heap top refers to, popping
+ * stale entries on the way. Returns cj->cap if no live deadline remains.
+ */
+static size_t deadline_top_slot(cookie_jar_t* cj) {
+  while (cj->deadline_len > 0) {
+    const cookie_deadline_t* top = &cj->deadlines[0];
+    size_t idx = cookie_jar_probe(cj, top->sequence);
+    if (cj->slots[idx].live && cj->slots[idx].timestamp_ns == top->timestamp_ns)
+      return idx;
+    deadline_pop(cj);
+  }
+  return cj->cap;
+}
+
+/* ---------- Sequence order ring ---------- */
+
+static inline bool seq_before(uint32_t a, uint32_t b) {
+  // Wrap-aware: a precedes b if it is less than 2^31 behind
+  return (int32_t)(a - b) < 0;
+}
+
+static void order_resize(cookie_jar_t* cj, size_t new_cap) {
+  uint32_t* next = cj_calloc(new_cap, sizeof(*next));
+  if (!next) {
+    LOG_ERROR("cookie_jar order ring allocation failed");
+    exit(1);
+  }
+
+  size_t mask = cj->order_cap - 1;
+  for (size_t i = 0; i < cj->order_len; i++)
+    next[i] = cj->order[(cj->order_head + i) & mask];
+
+  free(cj->order);
+  cj->order = next;
+  cj->order_cap = new_cap;
+  cj->order_head = 0;
+}
+
+static void order_compact(cookie_jar_t* cj) {
+  // Keep sequences that still have a live slot, preserving order
+  size_t mask = cj->order_cap - 1;
+  size_t kept = 0;
+  for (size_t i = 0; i < cj->order_len; i++) {
+    uint32_t seq = cj->order[(cj->order_head + i) & mask];
+    size_t idx = cookie_jar_probe(cj, seq);
+    if (cj->slots[idx].live)
+      cj->order[(cj->order_head + kept++) & mask] = seq;
+  }
+  cj->order_len = kept;
+}
+
+static void order_insert(cookie_jar_t* cj, uint32_t seq) {
+  if (cj->order_len == cj->order_cap) {
+    if (cj->order_len >= 2 * cj->live_count + 64)
+      order_compact(cj);
+    if (cj->order_len == cj->order_cap)
+      order_resize(cj, cj->order_cap * 2);
+  }
+
+  size_t mask = cj->order_cap - 1;
+  size_t pos = (cj->order_head + cj->order_len) & mask;
+  cj->order_len++;
+
+  // Walk back past later sequences (requests pushed out of issue order)
+  while (pos != cj->order_head) {
+    size_t prev = (pos - 1) & mask;
+    if (!seq_before(seq, cj->order[prev]))
+      break;
+    cj->order[pos] = cj->order[prev];
+    pos = prev;
+  }
+  cj->order[pos] = seq;
+}
+
+static inline void order_pop_head(cookie_jar_t* cj) {
+  assert(cj->order_len > 0);
+  cj->order_head = (cj->order_head + 1) & (cj->order_cap - 1);
+  cj->order_len--;
+}
+
 static void cookie_jar_refresh_timeout_hint(cookie_jar_t* cj) {
   /*
    * Recompute earliest_cookie_ns if the cached hint is invalid.
@@ -223,16 +492,15 @@ static void cookie_jar_refresh_timeout_hint(cookie_jar_t* cj) {
   if (!cj->timeout_hint_dirty && cj->earliest_cookie_ns != UINT64_MAX)
     return;
 
-  uint64_t earliest = UINT64_MAX;
-  for (size_t i = 0; i < cj->cap; i++) {
-    cookie_slot_t* slot = &cj->slots[i];
-    if (!slot->live)
-      continue;
-    if (slot->timestamp_ns < earliest)
-      earliest = slot->timestamp_ns;
+  size_t idx = deadline_top_slot(cj);
+  if (idx == cj->cap) {
+    // Every live slot has a heap entry; only reachable if that was violated
+    deadline_rebuild(cj);
+    idx = deadline_top_slot(cj);
   }
+  assert(idx < cj->cap);
 
-  cj->earliest_cookie_ns = earliest;
+  cj->earliest_cookie_ns = cj->slots[idx].timestamp_ns;
   cj->timeout_hint_dirty = false;
 }
 
@@ -255,6 +523,13 @@ static size_t cookie_jar_probe(const cookie_jar_t* cj, uint32_t seq) {
   return i;
 }
 
+const cookie_slot_t* cookie_jar_lookup(const cookie_jar_t* cj, uint32_t sequence) {
+  if (!cj->slots || cj->live_count == 0)
+    return NULL;
+  const cookie_slot_t* slot = &cj->slots[cookie_jar_probe(cj, sequence)];
+  return slot->live ? slot : NULL;
+}
+
 static void cookie_jar_grow(cookie_jar_t* cj, size_t new_cap) {
   /*
    * Resize the cookie table and rehash all live entries.
@@ -276,6 +551,7 @@ static void cookie_jar_grow(cookie_jar_t* cj, size_t new_cap) {
     LOG_ERROR("cookie_jar_grow failed");
     exit(1);
   }
+  cj->stats->grows++;
 
   size_t old_cap = cj->cap;
   cookie_slot_t* old_slots = cj->slots;
@@ -285,6 +561,7 @@ static void cookie_jar_grow(cookie_jar_t* cj, size_t new_cap) {
   cj->cap = new_cap;
   cj->live_count = 0;
   cj->scan_cursor = 0;
+  cj->probe_max = 0;
   cj->earliest_cookie_ns = UINT64_MAX;
   cj->timeout_hint_dirty = false;
   cj->replies_may_exist = replies_may_exist;
@@ -295,6 +572,9 @@ static void cookie_jar_grow(cookie_jar_t* cj, size_t new_cap) {
 
     cookie_slot_t slot = old_slots[i];
     size_t idx = cookie_jar_probe(cj, slot.sequence);
+    size_t dist = (idx - cookie_home(slot.sequence, new_cap - 1)) & (new_cap - 1);
+    if (dist > cj->probe_max)
+      cj->probe_max = dist;
     cj->slots[idx] = slot;
     cj->live_count++;
     if (slot.timestamp_ns < cj->earliest_cookie_ns) {
@@ -304,6 +584,48 @@ static void cookie_jar_grow(cookie_jar_t* cj, size_t new_cap) {
   free(old_slots);
 }
 
+/* ---------- Per-client lists ---------- */
+
+static void client_list_link(cookie_jar_t* cj, cookie_slot_t* slot) {
+  slot->client_prev = 0;
+  slot->client_next = 0;
+  if (slot->client == HANDLE_INVALID)
+    return;
+
+  uint32_t head = (uint32_t)(uintptr_t)hash_map_get(&cj->client_cookies, slot->client);
+  if (head != 0) {
+    cookie_slot_t* next = &cj->slots[cookie_jar_probe(cj, head)];
+    assert(next->live && next->client == slot->client);
+    next->client_prev = slot->sequence;
+    slot->client_next = head;
+  }
+  hash_map_insert(&cj->client_cookies, slot->client, (void*)(uintptr_t)slot->sequence);
+}
+
+static void client_list_unlink(cookie_jar_t* cj, cookie_slot_t* slot) {
+  if (slot->client == HANDLE_INVALID)
+    return;
+
+  if (slot->client_next != 0) {
+    cookie_slot_t* next = &cj->slots[cookie_jar_probe(cj, slot->client_next)];
+    assert(next->live && next->client == slot->client);
+    next->client_prev = slot->client_prev;
+  }
+  if (slot->client_prev != 0) {
+    cookie_slot_t* prev = &cj->slots[cookie_jar_probe(cj, slot->client_prev)];
+    assert(prev->live && prev->client == slot->client);
+    prev->client_next = slot->client_next;
+  }
+  else if (slot->client_next != 0) {
+    hash_map_insert(&cj->client_cookies, slot->client, (void*)(uintptr_t)slot->client_next);
+  }
+  else {
+    hash_map_remove(&cj->client_cookies, slot->client);
+  }
+  slot->client_prev = 0;
+  slot->client_next = 0;
+}
+
 /*
  * Remove a slot while preserving linear probing invariants.
  *
@@ -315,7 +637,9 @@ static void cookie_jar_grow(cookie_jar_t* cj, size_t new_cap) {
  * forward entries backward when their home bucket lies before
  * the removed position.
  *
- * This restores the probe chain without using tombstones.
+ * This restores the probe chain without using tombstones. The walk
+ * ends at an empty slot or once it is more than probe_max past the
+ * hole, since no entry that far out can have its home at or before it.
  */
 static void cookie_jar_remove(cookie_jar_t* cj, size_t idx) {
   COOKIE_JAR_ASSERT(cj);
@@ -326,6 +650,7 @@ static void cookie_jar_remove(cookie_jar_t* cj, size_t idx) {
   uint64_t removed_ts = cj->slots[idx].timestamp_ns;
   bool removed_was_earliest = (removed_ts == cj->earliest_cookie_ns);
 
+  client_list_unlink(cj, &cj->slots[idx]);
   cj->slots[idx].live = false;
   cj->slots[idx].handler = NULL;
   cj->live_count--;
@@ -334,7 +659,7 @@ static void cookie_jar_remove(cookie_jar_t* cj, size_t idx) {
   size_t hole = idx;
   size_t i = cookie_next(hole, mask);
 
-  while (cj->slots[i].live) {
+  while (cj->slots[i].live && ((i - hole) & mask) <= cj->probe_max) {
     size_t home = cookie_home(cj->slots[i].sequence, mask);
 
     bool should_move;
@@ -360,12 +685,157 @@ static void cookie_jar_remove(cookie_jar_t* cj, size_t idx) {
   if (cj->live_count == 0) {
     cj->earliest_cookie_ns = UINT64_MAX;
     cj->timeout_hint_dirty = false;
+    cj->probe_max = 0;
+    cj->deadline_len = 0;
+    cj->order_head = 0;
+    cj->order_len = 0;
   }
   else if (removed_was_earliest) {
     cj->timeout_hint_dirty = true;
   }
 }
 
+/* ---------- Cookie groups ---------- */
+
+static cookie_group_t* cookie_jar_group_get(cookie_jar_t* cj, uint32_t id) {
+  if (id == 0 || id > cj->group_cap)
+    return NULL;
+  cookie_group_t* g = &cj->groups[id - 1];
+  return g->live ? g : NULL;
+}
+
+static void cookie_group_release(cookie_group_t* g) {
+  // Drop collected replies without dispatching them
+  for (size_t i = 0; i < g->member_len; i++) {
+    free(g->members[i].reply);
+    free(g->members[i].err);
+  }
+  free(g->members);
+  memset(g, 0, sizeof(*g));
+}
+
+static void cookie_member_invoke(struct server* s, cookie_member_t* m) {
+  assert(m->slot.handler);
+  TP_COOKIE_DISPATCH(m->slot.sequence, m->slot.type, m->slot.timestamp_ns);
+  m->slot.handler(s, &m->slot, m->reply, m->err);
+
+  // Handler receives borrowed pointers; cleanup stays centralized here.
+  free(m->reply);
+  free(m->err);
+  m->reply = NULL;
+  m->err = NULL;
+}
+
+static void cookie_group_finish(cookie_jar_t* cj, struct server* s, uint32_t id) {
+  cookie_group_t* g = cookie_jar_group_get(cj, id);
+  assert(g && g->sealed && g->pending == 0);
+
+  // Detach first: member handlers may unmanage the client or open groups
+  cookie_group_t done = *g;
+  memset(g, 0, sizeof(*g));
+
+  // Replies arrive in sequence order, timeouts come later; restore issue order
+  for (size_t i = 1; i < done.member_len; i++) {
+    cookie_member_t m = done.members[i];
+    size_t j = i;
+    while (j > 0 && seq_before(m.slot.sequence, done.members[j - 1].slot.sequence)) {
+      done.members[j] = done.members[j - 1];
+      j--;
+    }
+    done.members[j] = m;
+  }
+
+  for (size_t i = 0; i < done.member_len; i++)
+    cookie_member_invoke(s, &done.members[i]);
+  free(done.members);
+
+  if (done.on_complete)
+    done.on_complete(s, done.txn_id, done.client);
+}
+
+static void cookie_group_collect(cookie_group_t* g, const cookie_member_t* m) {
+  if (g->member_len == g->member_cap) {
+    size_t new_cap = g->member_cap ? g->member_cap * 2 : 32;
+    cookie_member_t* next = cj_calloc(new_cap, sizeof(*next));
+    if (!next) {
+      LOG_ERROR("cookie_jar group allocation failed");
+      exit(1);
+    }
+    if (g->member_len)
+      memcpy(next, g->members, g->member_len * sizeof(*next));
+    free(g->members);
+    g->members = next;
+    g->member_cap = new_cap;
+  }
+  g->members[g->member_len++] = *m;
+}
+
+/*
+ * Deliver a completed slot: ungrouped slots invoke their handler now,
+ * grouped slots are parked until the whole group has completed.
+ * Takes ownership of m->reply / m->err.
+ */
+static void cookie_jar_dispatch(cookie_jar_t* cj, struct server* s, cookie_member_t* m) {
+  cookie_group_t* g = cookie_jar_group_get(cj, m->slot.group);
+  if (!g) {
+    cookie_member_invoke(s, m);
+    return;
+  }
+
+  cookie_group_collect(g, m);
+  assert(g->pending > 0);
+  g->pending--;
+  if (g->pending == 0 && g->sealed)
+    cookie_group_finish(cj, s, m->slot.group);
+}
+
+uint32_t cookie_jar_group_begin(cookie_jar_t* cj, uint64_t txn_id, handle_t client, cookie_group_fn on_complete) {
+  COOKIE_JAR_ASSERT(cj);
+  assert(cj->open_group == 0);
+
+  uint32_t idx = 0;
+  while (idx < cj->group_cap && cj->groups[idx].live)
+    idx++;
+
+  if (idx == cj->group_cap) {
+    uint32_t new_cap = cj->group_cap ? cj->group_cap * 2 : 16;
+    cookie_group_t* next = cj_calloc(new_cap, sizeof(*next));
+    if (!next) {
+      LOG_ERROR("cookie_jar group allocation failed");
+      exit(1);
+    }
+    if (cj->group_cap)
+      memcpy(next, cj->groups, cj->group_cap * sizeof(*next));
+    free(cj->groups);
+    cj->groups = next;
+    cj->group_cap = new_cap;
+  }
+
+  cookie_group_t* g = &cj->groups[idx];
+  memset(g, 0, sizeof(*g));
+  g->txn_id = txn_id;
+  g->client = client;
+  g->on_complete = on_complete;
+  g->live = true;
+
+  cj->open_group = idx + 1;
+  return cj->open_group;
+}
+
+void cookie_jar_group_end(cookie_jar_t* cj, struct server* s) {
+  COOKIE_JAR_ASSERT(cj);
+  uint32_t id = cj->open_group;
+  cj->open_group = 0;
+
+  cookie_group_t* g = cookie_jar_group_get(cj, id);
+  if (!g)
+    return;
+
+  g->sealed = true;
+  if (g->pending == 0)
+    cookie_group_finish(cj, s, id);
+}
+
 void cookie_jar_init(cookie_jar_t* cj) {
   assert(cj);
 
@@ -384,15 +854,54 @@ void cookie_jar_init(cookie_jar_t* cj) {
   cj->cap = cap;
   cj->live_count = 0;
   cj->scan_cursor = 0;
+  cj->probe_max = 0;
   cj->earliest_cookie_ns = UINT64_MAX;
   cj->timeout_hint_dirty = false;
   cj->replies_may_exist = false;
+
+  cj->deadlines = NULL;
+  cj->deadline_len = 0;
+  cj->deadline_cap = 0;
+  deadline_reserve(cj, cap);
+
+  cj->order = cj_calloc(cap, sizeof(*cj->order));
+  if (!cj->order) {
+    LOG_ERROR("cookie_jar_init failed");
+    exit(1);
+  }
+  cj->order_head = 0;
+  cj->order_len = 0;
+  cj->order_cap = cap;
+  cj->ordered = true;
+
+  hash_map_init(&cj->client_cookies);
+
+  cj->groups = NULL;
+  cj->group_cap = 0;
+  cj->open_group = 0;
+
+  cj->stats = cj_calloc(1, sizeof(*cj->stats));
+  if (!cj->stats) {
+    LOG_ERROR("cookie_jar_init failed");
+    exit(1);
+  }
+  for (int i = 0; i < COOKIE_TYPE_COUNT; i++)
+    latency_hist_reset(&cj->stats->type[i].latency);
 }
 
 void cookie_jar_destroy(cookie_jar_t* cj) {
   assert(cj);
 
+  for (uint32_t i = 0; i < cj->group_cap; i++) {
+    if (cj->groups[i].live)
+      cookie_group_release(&cj->groups[i]);
+  }
+  free(cj->groups);
+  hash_map_destroy(&cj->client_cookies);
   free(cj->slots);
+  free(cj->deadlines);
+  free(cj->order);
+  free(cj->stats);
   memset(cj, 0, sizeof(*cj));
 }
 
@@ -400,6 +909,7 @@ void cookie_jar_push(cookie_jar_t* cj, uint32_t sequence, cookie_type_t type, ha
   COOKIE_JAR_ASSERT(cj);
   assert(sequence != 0);
   assert(handler != NULL);
+  TP_COOKIE_PUSH(sequence, type);
 
   /*
    * Register a new pending XCB request.
@@ -426,10 +936,32 @@ void cookie_jar_push(cookie_jar_t* cj, uint32_t sequence, cookie_type_t type, ha
   size_t idx = cookie_jar_probe(cj, sequence);
   cookie_slot_t* slot = &cj->slots[idx];
   bool replacing = slot->live;
+
+  uint32_t probe_len = (uint32_t)((idx - cookie_home(sequence, cj->cap - 1)) & (cj->cap - 1));
+  cj->stats->probe_len[probe_len < COOKIE_JAR_PROBE_BUCKETS ? probe_len : COOKIE_JAR_PROBE_BUCKETS - 1]++;
+  if (probe_len > cj->stats->probe_len_max)
+    cj->stats->probe_len_max = probe_len;
+  if (probe_len > cj->probe_max)
+    cj->probe_max = probe_len;
+  cookie_stats_for(cj, type)->pushed++;
   uint64_t old_ts = slot->timestamp_ns;
+  bool relink = !replacing || slot->client != client;
+
+  if (replacing) {
+    if (relink)
+      client_list_unlink(cj, slot);
+    cookie_group_t* old_group = cookie_jar_group_get(cj, slot->group);
+    if (old_group && old_group->pending > 0)
+      old_group->pending--;
+  }
+  cookie_group_t* group = cookie_jar_group_get(cj, cj->open_group);
+  if (group)
+    group->pending++;
 
   if (!slot->live) {
     cj->live_count++;
+    if (cj->live_count > cj->stats->live_max)
+      cj->stats->live_max = cj->live_count;
   }
 
   uint64_t now = monotonic_time_ns();
@@ -439,8 +971,17 @@ void cookie_jar_push(cookie_jar_t* cj, uint32_t sequence, cookie_type_t type, ha
   slot->data = data;
   slot->timestamp_ns = now;
   slot->txn_id = txn_id;
+  slot->group = group ? cj->open_group : 0;
   slot->handler = handler;
   slot->live = true;
+  if (relink)
+    client_list_link(cj, slot);
+
+  // A replaced sequence leaves its old entry behind; the timestamp check in
+  // deadline_top_slot discards it
+  deadline_push(cj, now, sequence);
+  if (!replacing)
+    order_insert(cj, sequence);
 
   if (cj->live_count == 1) {
     cj->earliest_cookie_ns = now;
@@ -467,18 +1008,32 @@ size_t cookie_jar_remove_client(cookie_jar_t* cj, handle_t client) {
   COOKIE_JAR_ASSERT(cj);
   assert(client != HANDLE_INVALID);
 
-  if (cj->live_count == 0)
+  if (cj->live_count == 0 && cj->group_cap == 0)
     return 0;
 
   size_t removed = 0;
-  for (size_t idx = 0; idx < cj->cap && cj->live_count > 0;) {
+  uint32_t seq = (uint32_t)(uintptr_t)hash_map_get(&cj->client_cookies, client);
+  while (seq != 0) {
+    size_t idx = cookie_jar_probe(cj, seq);
     cookie_slot_t* slot = &cj->slots[idx];
-    if (slot->live && slot->client == client) {
-      cookie_jar_remove(cj, idx);
-      removed++;
-      continue;
+    assert(slot->live && slot->client == client);
+    seq = slot->client_next;
+
+    cookie_group_t* g = cookie_jar_group_get(cj, slot->group);
+    if (g && g->pending > 0)
+      g->pending--;
+    cookie_stats_for(cj, slot->type)->dropped++;
+    cookie_jar_remove(cj, idx);
+    removed++;
+  }
+
+  // Groups of this client go too, with any replies already collected
+  for (uint32_t i = 0; i < cj->group_cap; i++) {
+    if (cj->groups[i].live && cj->groups[i].client == client) {
+      if (cj->open_group == i + 1)
+        cj->open_group = 0;
+      cookie_group_release(&cj->groups[i]);
     }
-    idx++;
   }
 
   if (cj->scan_cursor >= cj->cap)
@@ -525,6 +1080,36 @@ int32_t cookie_jar_next_timeout_ms(cookie_jar_t* cj, uint64_t now_ns) {
   return (int32_t)timeout_ms;
 }
 
+/*
+ * Pop and dispatch cookies whose deadline has passed, oldest first.
+ * Stops at the first live cookie that is still within its timeout.
+ */
+static size_t cookie_jar_expire_due(cookie_jar_t* cj, struct server* s, uint64_t now, size_t max_expirations) {
+  size_t processed = 0;
+  while (processed < max_expirations && cj->live_count > 0) {
+    size_t idx = deadline_top_slot(cj);
+    if (idx == cj->cap)
+      break;
+
+    uint64_t ts = cj->slots[idx].timestamp_ns;
+    uint64_t age_ns = (now >= ts) ? (now - ts) : 0;
+    if (age_ns < COOKIE_JAR_TIMEOUT_NS)
+      break;
+
+    deadline_pop(cj);
+    cookie_slot_t local = cj->slots[idx];
+    cookie_jar_remove(cj, idx);
+
+    LOG_WARN("Cookie %u timed out, dropping", local.sequence);
+    cookie_stats_for(cj, local.type)->timed_out++;
+    cookie_member_t m = {.slot = local, .reply = NULL, .err = NULL};
+    cookie_jar_dispatch(cj, s, &m);
+
+    processed++;
+  }
+  return processed;
+}
+
 /*
  * Process completed replies and expired cookies.
  *
@@ -544,12 +1129,12 @@ int32_t cookie_jar_next_timeout_ms(cookie_jar_t* cj, uint64_t now_ns) {
  * Slots are removed before invoking handlers so callbacks
  * may safely enqueue additional cookies.
  */
-void cookie_jar_drain(cookie_jar_t* cj, xcb_connection_t* conn, struct server* s, size_t max_replies) {
+size_t cookie_jar_drain(cookie_jar_t* cj, xcb_connection_t* conn, struct server* s, size_t max_replies) {
   COOKIE_JAR_ASSERT(cj);
   assert(conn);
 
   if (cj->live_count == 0)
-    return;
+    return 0;
   if (max_replies == 0)
     max_replies = COOKIE_JAR_MAX_REPLIES_PER_TICK;
 
@@ -562,20 +1147,51 @@ void cookie_jar_drain(cookie_jar_t* cj, xcb_connection_t* conn, struct server* s
 
   bool poll_replies = cj->replies_may_exist;
   if (!poll_replies && !timeout_due)
-    return;
+    return 0;
   cj->replies_may_exist = false;
 
   size_t processed = 0;
-  size_t scanned = 0;
-  size_t idx = cj->scan_cursor;
-  size_t mask = cj->cap - 1;
   bool made_reply_progress = false;
+  bool reply_stalled = false;
+
+  if (poll_replies && cj->ordered) {
+    while (processed < max_replies && cj->live_count > 0 && cj->order_len > 0) {
+      size_t idx = cookie_jar_probe(cj, cj->order[cj->order_head]);
+      cookie_slot_t* slot = &cj->slots[idx];
+      if (!slot->live) {
+        order_pop_head(cj);
+        continue;
+      }
 
-  while (scanned < cj->cap && processed < max_replies && cj->live_count > 0) {
-    cookie_slot_t* slot = &cj->slots[idx];
+      void* reply = NULL;
+      xcb_generic_error_t* err = NULL;
+      if (!xcb_poll_for_reply(conn, slot->sequence, &reply, &err)) {
+        // Later sequences cannot have been answered yet
+        reply_stalled = true;
+        break;
+      }
+
+      order_pop_head(cj);
+      if (event_trace_recording())
+        event_trace_reply(slot, reply, err);
+      cookie_stats_reply(cj, slot, err);
+      cookie_member_t m = {.slot = *slot, .reply = reply, .err = err};
+      cookie_jar_remove(cj, idx);
+      cookie_jar_dispatch(cj, s, &m);
+
+      made_reply_progress = true;
+      processed++;
+    }
+  }
+  else if (poll_replies) {
+    size_t scanned = 0;
+    size_t idx = cj->scan_cursor;
+    size_t mask = cj->cap - 1;
 
-    if (slot->live) {
-      if (poll_replies) {
+    while (scanned < cj->cap && processed < max_replies && cj->live_count > 0) {
+      cookie_slot_t* slot = &cj->slots[idx];
+
+      if (slot->live) {
         void* reply = NULL;
         xcb_generic_error_t* err = NULL;
 
@@ -585,17 +1201,12 @@ void cookie_jar_drain(cookie_jar_t* cj, xcb_connection_t* conn, struct server* s
         if (ready) {
           // Remove before invoking handler so re-entrancy can safely push new
           // cookies
-          cookie_slot_t local = *slot;
+          if (event_trace_recording())
+            event_trace_reply(slot, reply, err);
+          cookie_stats_reply(cj, slot, err);
+          cookie_member_t m = {.slot = *slot, .reply = reply, .err = err};
           cookie_jar_remove(cj, idx);
-
-          assert(local.handler);
-          local.handler(s, &local, reply, err);
-
-          // Handler receives borrowed pointers; cleanup stays centralized here.
-          if (reply)
-            free(reply);
-          if (err)
-            free(err);
+          cookie_jar_dispatch(cj, s, &m);
 
           made_reply_progress = true;
           processed++;
@@ -603,27 +1214,27 @@ void cookie_jar_drain(cookie_jar_t* cj, xcb_connection_t* conn, struct server* s
         }
       }
 
-      uint64_t age_ns = (now >= slot->timestamp_ns) ? (now - slot->timestamp_ns) : 0;
-      if (age_ns >= COOKIE_JAR_TIMEOUT_NS) {
-        cookie_slot_t local = *slot;
-        cookie_jar_remove(cj, idx);
-
-        LOG_WARN("Cookie %u timed out, dropping", local.sequence);
-        assert(local.handler);
-        local.handler(s, &local, NULL, NULL);
-
-        processed++;
-        continue;
-      }
+      idx = cookie_next(idx, mask);
+      scanned++;
     }
 
-    idx = cookie_next(idx, mask);
-    scanned++;
+    cj->scan_cursor = idx;
   }
 
-  cj->scan_cursor = idx;
-  if (poll_replies && made_reply_progress && cj->live_count > 0)
+  if (poll_replies) {
+    cj->stats->drains++;
+    // Out of budget with the queue not yet caught up: replies wait on us
+    if (processed >= max_replies && !reply_stalled && cj->live_count > 0)
+      cj->stats->budget_limited++;
+  }
+
+  // Timeouts come off the deadline heap rather than the table scan
+  if (processed < max_replies)
+    processed += cookie_jar_expire_due(cj, s, now, max_replies - processed);
+
+  if (poll_replies && made_reply_progress && !reply_stalled && cj->live_count > 0)
     cj->replies_may_exist = true;
+  return processed;
 }
 
 void cookie_jar_expire(cookie_jar_t* cj, struct server* s, size_t max_expirations) {
@@ -641,31 +1252,56 @@ void cookie_jar_expire(cookie_jar_t* cj, struct server* s, size_t max_expiration
   if (earliest_age < COOKIE_JAR_TIMEOUT_NS)
     return;
 
-  size_t processed = 0;
-  size_t scanned = 0;
-  size_t idx = cj->scan_cursor;
-  size_t mask = cj->cap - 1;
+  cookie_jar_expire_due(cj, s, now, max_expirations);
+}
 
-  while (scanned < cj->cap && processed < max_expirations && cj->live_count > 0) {
-    cookie_slot_t* slot = &cj->slots[idx];
-    if (slot->live) {
-      uint64_t age_ns = (now >= slot->timestamp_ns) ? (now - slot->timestamp_ns) : 0;
-      if (age_ns >= COOKIE_JAR_TIMEOUT_NS) {
-        cookie_slot_t local = *slot;
-        cookie_jar_remove(cj, idx);
+size_t cookie_jar_stats_format(const cookie_jar_t* cj, char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+  buf[0] = '\0';
+  if (!cj || !cj->stats)
+    return 0;
 
-        LOG_WARN("Cookie %u timed out, dropping", local.sequence);
-        assert(local.handler);
-        local.handler(s, &local, NULL, NULL);
+  size_t off = 0;
+  const cookie_jar_stats_t* st = cj->stats;
 
-        processed++;
-        continue;
-      }
-    }
+#define CJ_APPEND(...)                                                  \
+  do {                                                                  \
+    if (off < cap) {                                                    \
+      int n_ = snprintf(buf + off, cap - off, __VA_ARGS__);             \
+      if (n_ > 0)                                                       \
+        off += ((size_t)n_ < cap - off) ? (size_t)n_ : cap - off - 1u; \
+    }                                                                   \
+  } while (0)
 
-    idx = cookie_next(idx, mask);
-    scanned++;
+  CJ_APPEND("cookie jar: live=%zu live_max=%zu cap=%zu grows=%u drains=%" PRIu64 " budget_limited=%" PRIu64 "\n", cj->live_count,
+            st->live_max, cj->cap, st->grows, st->drains, st->budget_limited);
+  CJ_APPEND("cookie probe length:");
+  for (int i = 0; i < COOKIE_JAR_PROBE_BUCKETS; i++)
+    CJ_APPEND(" %d%s=%" PRIu64, i, i == COOKIE_JAR_PROBE_BUCKETS - 1 ? "+" : "", st->probe_len[i]);
+  CJ_APPEND(" max=%u\n", st->probe_len_max);
+
+  CJ_APPEND("%-26s %9s %9s %7s %7s %7s %9s %9s %9s\n", "cookie reply (us)", "pushed", "completed", "errors", "timeout", "dropped", "p50",
+            "p99", "max");
+  for (int i = 0; i < COOKIE_TYPE_COUNT; i++) {
+    const cookie_type_stats_t* t = &st->type[i];
+    if (t->pushed == 0)
+      continue;
+    const latency_hist_t* h = &t->latency;
+    CJ_APPEND("%-26s %9" PRIu64 " %9" PRIu64 " %7" PRIu64 " %7" PRIu64 " %7" PRIu64 " %9.1f %9.1f %9.1f\n", cookie_type_name((cookie_type_t)i),
+              t->pushed, t->completed, t->errors, t->timed_out, t->dropped, (double)latency_hist_quantile(h, 5000) / 1000.0,
+              (double)latency_hist_quantile(h, 9900) / 1000.0, (double)h->max_ns / 1000.0);
   }
 
-  cj->scan_cursor = idx;
+#undef CJ_APPEND
+
+  return off;
+}
+
+void cookie_jar_stats_dump(const cookie_jar_t* cj) {
+  char buf[4096];
+  if (cookie_jar_stats_format(cj, buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
 }
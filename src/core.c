@@ -4,10 +4,13 @@
  * Implements:
  * - counters: global singleton for metrics
  *   Compiles out when HXM_DIAG is disabled
+ * - tick_stats: per-phase tick latency histograms (always compiled)
+ * - xreq_counts: per-kind X request totals behind the hxm.h wrappers
  * - monotonic_time_ns: high-resolution clock for the event loop
  *
  * Notes:
  * - tick_duration_min starts at UINT64_MAX as a sentinel for "no samples"
+ * - latency_hist min_ns uses the same sentinel
  */
 
 #include <inttypes.h>
@@ -98,6 +101,356 @@ void counters_dump(void) {
 
 #endif /* HXM_DIAG */
 
+/* ---------- X request accounting ---------- */
+
+uint64_t xreq_counts[XREQ_KIND_COUNT];
+
+static const char* const xreq_kind_names[XREQ_KIND_COUNT] = {
+    [XREQ_CONFIGURE] = "configure",
+    [XREQ_PROPERTY] = "property",
+    [XREQ_GET_PROPERTY] = "get_property",
+    [XREQ_MAP] = "map",
+    [XREQ_ATTRIBUTES] = "attributes",
+    [XREQ_IMAGE] = "image",
+    [XREQ_GRAB] = "grab",
+    [XREQ_FOCUS] = "focus",
+    [XREQ_SEND_EVENT] = "send_event",
+};
+
+const char* xreq_kind_name(xreq_kind_t kind) {
+  if ((unsigned)kind >= XREQ_KIND_COUNT)
+    return "?";
+  return xreq_kind_names[kind];
+}
+
+/* ---------- Tick phase latency histograms ---------- */
+
+struct tick_stats tick_stats;
+
+static const char* const tick_phase_names[TICK_PHASE_COUNT] = {
+    [TICK_PHASE_WAIT] = "wait",
+    [TICK_PHASE_INGEST] = "ingest",
+    [TICK_PHASE_DRAIN] = "drain",
+    [TICK_PHASE_PROCESS] = "process",
+    [TICK_PHASE_FLUSH_DIRTY] = "flush_dirty",
+    [TICK_PHASE_XCB_FLUSH] = "xcb_flush",
+    [TICK_PHASE_TOTAL] = "total",
+};
+
+static const char* const startup_phase_names[STARTUP_PHASE_COUNT] = {
+    [STARTUP_PHASE_CONNECT] = "connect",
+    [STARTUP_PHASE_X_QUERIES] = "x_queries",
+    [STARTUP_PHASE_CONFIG] = "config",
+    [STARTUP_PHASE_BECOME] = "become",
+    [STARTUP_PHASE_ADOPT] = "adopt",
+    [STARTUP_PHASE_RESOURCES] = "resources",
+};
+
+const char* tick_phase_name(tick_phase_t phase) {
+  if ((unsigned)phase >= TICK_PHASE_COUNT)
+    return "?";
+  return tick_phase_names[phase];
+}
+
+static inline uint32_t latency_hist_index(uint64_t v) {
+  if (v < LATENCY_HIST_SUB_BUCKETS)
+    return (uint32_t)v;
+
+  uint32_t msb = 63u - (uint32_t)__builtin_clzll(v);
+  uint32_t shift = msb - LATENCY_HIST_SUB_BITS;
+  uint32_t sub = (uint32_t)(v >> shift) & (LATENCY_HIST_SUB_BUCKETS - 1u);
+  return (shift + 1u) * LATENCY_HIST_SUB_BUCKETS + sub;
+}
+
+// Largest value that maps to bucket idx (inclusive)
+static inline uint64_t latency_hist_upper(uint32_t idx) {
+  if (idx < LATENCY_HIST_SUB_BUCKETS)
+    return idx;
+
+  uint32_t shift = idx / LATENCY_HIST_SUB_BUCKETS - 1u;
+  uint64_t sub = idx % LATENCY_HIST_SUB_BUCKETS;
+  uint64_t base = (LATENCY_HIST_SUB_BUCKETS + sub) << shift;
+  uint64_t width = (uint64_t)1 << shift;
+  return base + (width - 1u);
+}
+
+void latency_hist_reset(latency_hist_t* h) {
+  memset(h, 0, sizeof(*h));
+  h->min_ns = UINT64_MAX;
+}
+
+void latency_hist_record(latency_hist_t* h, uint64_t ns) {
+  h->count++;
+  h->sum_ns += ns;
+  if (ns < h->min_ns)
+    h->min_ns = ns;
+  if (ns > h->max_ns)
+    h->max_ns = ns;
+  h->buckets[latency_hist_index(ns)]++;
+}
+
+uint64_t latency_hist_quantile(const latency_hist_t* h, uint32_t permille_x10) {
+  if (h->count == 0)
+    return 0;
+  if (permille_x10 > 10000u)
+    permille_x10 = 10000u;
+
+  // Rank of the target sample (1-based, rounded up)
+  uint64_t rank = (h->count * permille_x10 + 9999u) / 10000u;
+  if (rank == 0)
+    rank = 1;
+
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= rank) {
+      uint64_t upper = latency_hist_upper(i);
+      return (upper < h->max_ns) ? upper : h->max_ns;
+    }
+  }
+
+  return h->max_ns;
+}
+
+void tick_stats_init(void) {
+  for (int i = 0; i < TICK_PHASE_COUNT; i++)
+    latency_hist_reset(&tick_stats.phase[i]);
+  tick_sample_init(&tick_stats.slowest);
+  latency_hist_reset(&tick_stats.arena_used);
+  tick_stats.arena_blocks_max = 0;
+  tick_stats.arena_reserved = 0;
+  tick_stats.arena_reserved_max = 0;
+  tick_stats.arena_shrinks = 0;
+  tick_stats.title_hits = 0;
+  tick_stats.title_misses = 0;
+  tick_stats.unmanaged_forwarded = 0;
+  tick_stats.unmanaged_coalesced = 0;
+  tick_stats.client_messages_dropped = 0;
+  tick_stats.synthetic_sent = 0;
+  tick_stats.synthetic_suppressed = 0;
+  tick_stats.root_props_written = 0;
+  tick_stats.root_props_skipped = 0;
+  tick_stats.monitor_snapshots_same = 0;
+  tick_stats.monitor_clients_moved = 0;
+  tick_stats.input_flushes = 0;
+  tick_stats.props_deferred = 0;
+  tick_stats.interaction_qos_ticks = 0;
+  tick_stats.timers_fired = 0;
+  tick_stats.timer_rearms = 0;
+  latency_hist_reset(&tick_stats.x_requests);
+  latency_hist_reset(&tick_stats.x_bytes);
+  tick_stats.x_bytes_total = 0;
+  for (int i = 0; i < XREQ_KIND_COUNT; i++)
+    tick_stats.xreq_max[i] = 0;
+  tick_stats.pacing_mhz = 0;
+  tick_stats.pacing_monitor_mhz = 0;
+  for (int i = 0; i < STARTUP_PHASE_COUNT; i++)
+    tick_stats.startup_ns[i] = 0;
+}
+
+void tick_stats_record(const tick_sample_t* sample) {
+  for (int i = 0; i < TICK_PHASE_COUNT; i++) {
+    if (sample->mask & (1u << i))
+      latency_hist_record(&tick_stats.phase[i], sample->ns[i]);
+  }
+
+  if ((sample->mask & (1u << TICK_PHASE_TOTAL)) &&
+      (!(tick_stats.slowest.mask & (1u << TICK_PHASE_TOTAL)) ||
+       sample->ns[TICK_PHASE_TOTAL] > tick_stats.slowest.ns[TICK_PHASE_TOTAL])) {
+    tick_stats.slowest = *sample;
+  }
+
+  if (sample->mask & (1u << TICK_PHASE_TOTAL)) {
+    latency_hist_record(&tick_stats.arena_used, sample->arena_used);
+    if (sample->arena_blocks > tick_stats.arena_blocks_max)
+      tick_stats.arena_blocks_max = sample->arena_blocks;
+    tick_stats.arena_reserved = sample->arena_reserved;
+    if (sample->arena_reserved > tick_stats.arena_reserved_max)
+      tick_stats.arena_reserved_max = sample->arena_reserved;
+    tick_stats.arena_shrinks = sample->arena_shrinks;
+    tick_stats.title_hits = sample->title_hits;
+    tick_stats.title_misses = sample->title_misses;
+    tick_stats.unmanaged_forwarded = sample->unmanaged_forwarded;
+    tick_stats.unmanaged_coalesced = sample->unmanaged_coalesced;
+    tick_stats.client_messages_dropped = sample->client_messages_dropped;
+    tick_stats.synthetic_sent = sample->synthetic_sent;
+    tick_stats.synthetic_suppressed = sample->synthetic_suppressed;
+    tick_stats.root_props_written = sample->root_props_written;
+    tick_stats.root_props_skipped = sample->root_props_skipped;
+    tick_stats.monitor_snapshots_same = sample->monitor_snapshots_same;
+    tick_stats.monitor_clients_moved = sample->monitor_clients_moved;
+    tick_stats.input_flushes = sample->input_flushes;
+    tick_stats.props_deferred = sample->props_deferred;
+    tick_stats.interaction_qos_ticks = sample->interaction_qos_ticks;
+    tick_stats.timers_fired = sample->timers_fired;
+    tick_stats.timer_rearms = sample->timer_rearms;
+
+    uint64_t requests = 0;
+    for (int i = 0; i < XREQ_KIND_COUNT; i++) {
+      requests += sample->xreq[i];
+      if (sample->xreq[i] > tick_stats.xreq_max[i])
+        tick_stats.xreq_max[i] = sample->xreq[i];
+    }
+    latency_hist_record(&tick_stats.x_requests, requests);
+    latency_hist_record(&tick_stats.x_bytes, sample->x_bytes);
+    tick_stats.x_bytes_total += sample->x_bytes;
+  }
+}
+
+void tick_sample_take_xreq(tick_sample_t* t, uint64_t mark[XREQ_KIND_COUNT], uint64_t* bytes_mark, uint64_t bytes_written) {
+  for (int i = 0; i < XREQ_KIND_COUNT; i++) {
+    uint64_t d = xreq_counts[i] - mark[i];
+    t->xreq[i] = (d > UINT32_MAX) ? UINT32_MAX : (uint32_t)d;
+    mark[i] = xreq_counts[i];
+  }
+  t->x_bytes = (bytes_written >= *bytes_mark) ? bytes_written - *bytes_mark : 0;
+  *bytes_mark = bytes_written;
+}
+
+void tick_stats_record_startup(startup_phase_t phase, uint64_t ns) {
+  if ((unsigned)phase < STARTUP_PHASE_COUNT)
+    tick_stats.startup_ns[phase] += ns;
+}
+
+void tick_stats_record_pacing(uint32_t effective_mhz, uint32_t monitor_mhz) {
+  tick_stats.pacing_mhz = effective_mhz;
+  tick_stats.pacing_monitor_mhz = monitor_mhz;
+}
+
+static double ns_to_us(uint64_t ns) {
+  return (double)ns / 1000.0;
+}
+
+size_t tick_stats_format(char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+
+  size_t off = 0;
+  buf[0] = '\0';
+
+#define TS_APPEND(...)                                         \
+  do {                                                         \
+    if (off < cap) {                                           \
+      int n_ = snprintf(buf + off, cap - off, __VA_ARGS__);    \
+      if (n_ > 0)                                              \
+        off += ((size_t)n_ < cap - off) ? (size_t)n_ : cap - off - 1u; \
+    }                                                          \
+  } while (0)
+
+  uint64_t startup_total = 0;
+  for (int i = 0; i < STARTUP_PHASE_COUNT; i++)
+    startup_total += tick_stats.startup_ns[i];
+  if (startup_total > 0) {
+    TS_APPEND("startup (us):");
+    for (int i = 0; i < STARTUP_PHASE_COUNT; i++)
+      TS_APPEND(" %s=%.1f", startup_phase_names[i], ns_to_us(tick_stats.startup_ns[i]));
+    TS_APPEND(" total=%.1f\n", ns_to_us(startup_total));
+  }
+
+  TS_APPEND("tick phase latency (us)\n");
+  TS_APPEND("%-12s %10s %9s %9s %9s %9s %9s %9s\n", "phase", "count", "min", "p50", "p90", "p99", "p99.9",
+            "max");
+
+  for (int i = 0; i < TICK_PHASE_COUNT; i++) {
+    const latency_hist_t* h = &tick_stats.phase[i];
+    if (h->count == 0) {
+      TS_APPEND("%-12s %10" PRIu64 "\n", tick_phase_names[i], h->count);
+      continue;
+    }
+    TS_APPEND("%-12s %10" PRIu64 " %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", tick_phase_names[i], h->count,
+              ns_to_us(h->min_ns), ns_to_us(latency_hist_quantile(h, 5000)),
+              ns_to_us(latency_hist_quantile(h, 9000)), ns_to_us(latency_hist_quantile(h, 9900)),
+              ns_to_us(latency_hist_quantile(h, 9990)), ns_to_us(h->max_ns));
+  }
+
+  const tick_sample_t* s = &tick_stats.slowest;
+  if (s->mask & (1u << TICK_PHASE_TOTAL)) {
+    TS_APPEND("slowest tick:");
+    for (int i = TICK_PHASE_INGEST; i < TICK_PHASE_COUNT; i++) {
+      if (s->mask & (1u << i))
+        TS_APPEND(" %s=%.1f", tick_phase_names[i], ns_to_us(s->ns[i]));
+    }
+    TS_APPEND("\n");
+  }
+
+  const latency_hist_t* a = &tick_stats.arena_used;
+  if (a->count > 0) {
+    TS_APPEND("tick arena (bytes): p50=%" PRIu64 " p99=%" PRIu64 " max=%" PRIu64 " blocks_max=%u reserved=%" PRIu64
+              " reserved_max=%" PRIu64 " shrinks=%" PRIu64 "\n",
+              latency_hist_quantile(a, 5000), latency_hist_quantile(a, 9900), a->max_ns, tick_stats.arena_blocks_max,
+              tick_stats.arena_reserved, tick_stats.arena_reserved_max, tick_stats.arena_shrinks);
+  }
+
+  uint64_t lookups = tick_stats.title_hits + tick_stats.title_misses;
+  if (lookups > 0) {
+    TS_APPEND("title cache: hits=%" PRIu64 " misses=%" PRIu64 " hit_rate=%.1f%%\n", tick_stats.title_hits, tick_stats.title_misses,
+              100.0 * (double)tick_stats.title_hits / (double)lookups);
+  }
+
+  if (tick_stats.unmanaged_forwarded + tick_stats.unmanaged_coalesced > 0) {
+    TS_APPEND("unmanaged configure: forwarded=%" PRIu64 " coalesced=%" PRIu64 "\n", tick_stats.unmanaged_forwarded,
+              tick_stats.unmanaged_coalesced);
+  }
+
+  if (tick_stats.client_messages_dropped > 0)
+    TS_APPEND("client messages: coalesced=%" PRIu64 "\n", tick_stats.client_messages_dropped);
+
+  if (tick_stats.synthetic_sent + tick_stats.synthetic_suppressed > 0) {
+    TS_APPEND("synthetic configure: sent=%" PRIu64 " suppressed=%" PRIu64 "\n", tick_stats.synthetic_sent,
+              tick_stats.synthetic_suppressed);
+  }
+
+  if (tick_stats.root_props_written + tick_stats.root_props_skipped > 0) {
+    TS_APPEND("root properties: written=%" PRIu64 " skipped=%" PRIu64 "\n", tick_stats.root_props_written,
+              tick_stats.root_props_skipped);
+  }
+
+  if (tick_stats.monitor_snapshots_same + tick_stats.monitor_clients_moved > 0) {
+    TS_APPEND("monitor updates: unchanged=%" PRIu64 " clients moved=%" PRIu64 "\n", tick_stats.monitor_snapshots_same,
+              tick_stats.monitor_clients_moved);
+  }
+
+  if (tick_stats.input_flushes + tick_stats.props_deferred + tick_stats.interaction_qos_ticks > 0) {
+    TS_APPEND("lanes: input_flushes=%" PRIu64 " props_deferred=%" PRIu64 " drag_ticks=%" PRIu64 "\n", tick_stats.input_flushes,
+              tick_stats.props_deferred, tick_stats.interaction_qos_ticks);
+  }
+
+  if (tick_stats.timers_fired + tick_stats.timer_rearms > 0) {
+    TS_APPEND("timers: fired=%" PRIu64 " timerfd_rearms=%" PRIu64 "\n", tick_stats.timers_fired, tick_stats.timer_rearms);
+  }
+
+  const latency_hist_t* xr = &tick_stats.x_requests;
+  if (xr->count > 0 && (xr->max_ns > 0 || tick_stats.x_bytes_total > 0)) {
+    const latency_hist_t* xb = &tick_stats.x_bytes;
+    TS_APPEND("x output per tick: requests p50=%" PRIu64 " p99=%" PRIu64 " max=%" PRIu64 " bytes p50=%" PRIu64 " p99=%" PRIu64
+              " max=%" PRIu64 "\n",
+              latency_hist_quantile(xr, 5000), latency_hist_quantile(xr, 9900), xr->max_ns, latency_hist_quantile(xb, 5000),
+              latency_hist_quantile(xb, 9900), xb->max_ns);
+    TS_APPEND("x requests (total/max per tick):");
+    for (int i = 0; i < XREQ_KIND_COUNT; i++)
+      TS_APPEND(" %s=%" PRIu64 "/%u", xreq_kind_names[i], xreq_counts[i], tick_stats.xreq_max[i]);
+    TS_APPEND(" bytes=%" PRIu64 "\n", tick_stats.x_bytes_total);
+  }
+
+  if (tick_stats.pacing_mhz > 0) {
+    if (tick_stats.pacing_monitor_mhz > 0)
+      TS_APPEND("interactive pacing: %.2f Hz (monitor %.2f Hz)\n", tick_stats.pacing_mhz / 1000.0, tick_stats.pacing_monitor_mhz / 1000.0);
+    else
+      TS_APPEND("interactive pacing: %.2f Hz (monitor rate unknown)\n", tick_stats.pacing_mhz / 1000.0);
+  }
+
+#undef TS_APPEND
+
+  return off;
+}
+
+void tick_stats_dump(void) {
+  char buf[4096];
+  tick_stats_format(buf, sizeof(buf));
+  fputs(buf, stdout);
+  fflush(stdout);
+}
+
 __attribute__((weak)) uint64_t monotonic_time_ns(void) {
   struct timespec ts;
   if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
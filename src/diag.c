@@ -32,7 +32,7 @@
 /*
  * Dump one stacking layer vector
  *
- * Layers are small_vec arrays of client handles, one array per layer
+ * Layers are handle_vec arrays of client handles, one array per layer
  * This view is useful for debugging stacking anomalies such as unexpected
  * raise/lower behavior, wrong layer assignment, or disappearing windows
  * Common layers include DESKTOP, NORMAL, ABOVE, and FULLSCREEN
@@ -45,76 +45,72 @@
 void diag_dump_layer(const server_t* s, layer_t l, const char* tag) {
   if (!s)
     return;
-  const small_vec_t* v = &s->layers[l];
+  for (uint32_t n = 0; n < server_screen_count(s); n++) {
+    const handle_vec_t* v = &s->screens[n].layers[l];
 
-  // Layer vectors should remain bounded, cap traversal to limit log flood
-  LOG_DEBUG("stack %s layer=%d count=%zu", tag, l, v->length);
+    // Layer vectors should remain bounded, cap traversal to limit log flood
+    LOG_DEBUG("stack %s screen=%u layer=%d count=%zu", tag, n, l, v->length);
 
-  for (size_t i = 0; i < v->length && i < 64; i++) {
-    handle_t h = ptr_to_handle(v->items[i]);
-    const client_hot_t* c = server_chot((server_t*)s, h);
-    if (!c)
-      continue;
-    // Print both handle and X identifiers for event-log correlation
-    LOG_DEBUG("  [%zu] h=%lx xid=%u frame=%u", i, c->self, c->xid, c->frame);
-  }
+    for (size_t i = 0; i < v->length && i < 64; i++) {
+      handle_t h = v->items[i];
+      const client_hot_t* c = server_chot((server_t*)s, h);
+      if (!c)
+        continue;
+      // Print both handle and X identifiers for event-log correlation
+      LOG_DEBUG("  [%zu] h=%lx xid=%u frame=%u", i, c->self, c->xid, c->frame);
+    }
 
-  if (v->length > 64) {
-    // Guard hit usually means suspicious vector length metadata
-    LOG_WARN("stack %s layer=%d guard hit at %d, possible loop", tag, l, 64);
+    if (v->length > 64) {
+      // Guard hit usually means suspicious vector length metadata
+      LOG_WARN("stack %s screen=%u layer=%d guard hit at %d, possible loop", tag, n, l, 64);
+    }
   }
 }
 
 /*
- * Dump the focus history intrusive list
+ * Dump the focus history table
  *
- * focus_history stores most-recently-focused clients and is used as fallback
+ * focus_mru stores most-recently-focused clients and is used as fallback
  * focus selection when the current focus disappears
  *
  * Data structure:
- * - intrusive circular doubly linked list
- * - each client embeds client_hot_t.focus_node
- * - empty list invariant is head->next == head and head->prev == head
+ * - circular doubly linked list of slot indices in one entries array
+ * - entries[0] is the sentinel, each client records its slot in focus_slot
+ * - empty table invariant is entries == NULL or entries[0].next == 0
  *
  * Corruption patterns this reveals:
- * - NULL next/prev links
- * - broken circular links
- * - loops that never return to head
+ * - links pointing past the slots handed out
+ * - clients whose focus_slot disagrees with the entry naming them
+ * - loops that never return to the sentinel
  *
  * Traversal is guarded to avoid infinite loops on corrupted link graphs
  */
 void diag_dump_focus_history(const server_t* s, const char* tag) {
   if (!s)
     return;
-  const list_node_t* head = &s->focus_history;
-
-  // focus_history is circular and must always have non-NULL head links
-  if (!head->next || !head->prev) {
-    LOG_WARN("focus_history %s: list not initialized", tag);
+  const focus_mru_t* m = &s->focus_mru;
+  if (!m->entries) {
+    LOG_DEBUG("focus_history %s: empty", tag);
     return;
   }
 
-  LOG_DEBUG("focus_history %s head=%p next=%p prev=%p", tag, (void*)head, (void*)head->next, (void*)head->prev);
-  const list_node_t* node = head->next;
+  LOG_DEBUG("focus_history %s count=%u used=%u head=%u tail=%u", tag, m->count, m->used, m->entries[0].next, m->entries[0].prev);
+  uint32_t slot = m->entries[0].next;
   int guard = 0;
-  while (node != head && guard < 128) {
-    // Stop early on partially corrupted nodes
-    if (!node->next || !node->prev) {
-      LOG_WARN("focus_history %s: null link at node=%p", tag, (void*)node);
-      break;
+  while (slot != 0 && guard < 128) {
+    if (slot >= m->used) {
+      LOG_WARN("focus_history %s: link out of range slot=%u used=%u", tag, slot, m->used);
+      return;
     }
-    /*
-     * Convert intrusive node address back to owning client_hot_t
-     * client = node - offsetof(client_hot_t, focus_node)
-     */
-    const client_hot_t* c = (const client_hot_t*)((const char*)node - offsetof(client_hot_t, focus_node));
-    // c used only for debug logging, keep variable to simplify inspection
-    (void)c;
-    LOG_DEBUG("  [%d] node=%p prev=%p next=%p h=%lx xid=%u state=%d", guard, (void*)node, (void*)node->prev, (void*)node->next, c->self, c->xid, c->state);
-    node = node->next;
+    const focus_mru_entry_t* e = &m->entries[slot];
+    const client_hot_t* c = server_chot((server_t*)s, e->h);
+    if (!c || c->focus_slot != slot)
+      LOG_WARN("focus_history %s: slot=%u h=%lx not owned by its client", tag, slot, e->h);
+    LOG_DEBUG("  [%d] slot=%u prev=%u next=%u h=%lx desktop=%d flags=%x xid=%u", guard, slot, e->prev, e->next, e->h, e->desktop, e->flags, c ? c->xid : 0);
+    slot = e->next;
     guard++;
   }
-  if (node != head) {
+  if (slot != 0) {
     // Guard protects against infinite traversal on corrupted circular links
     LOG_WARN("focus_history %s: guard hit at %d, possible loop", tag, guard);
   }
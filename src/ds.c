@@ -4,7 +4,9 @@
  * Implements core data structures:
  * - Arena: bump allocator for fast per-tick temporary memory
  * - SmallVec: inline-storage vector to avoid heap allocs for common small cases
- * - HashMap: open-addressing map with linear probing and backshift deletion
+ * - HashMap: open-addressing map, either linear probing with backshift
+ *   deletion or a Swiss-table layout with SIMD-probed control bytes
+ * - CRC-32C: hardware-accelerated where available
  *
  * Invariants:
  * - allocators fail hard (abort) on OOM
@@ -22,6 +24,17 @@
 
 #include "hxm.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CRC32C_X86 1
+#include <immintrin.h>
+#else
+#define CRC32C_X86 0
+#endif
+
 __attribute__((weak)) void* ds_malloc(size_t size) {
   return malloc(size);
 }
@@ -46,6 +59,12 @@ void arena_init(struct arena* a, size_t block_size) {
   a->current = NULL;
   a->pos = 0;
   a->block_size = block_size ? block_size : 4096;
+  a->used = 0;
+  a->blocks_used = 0;
+  a->reserved = 0;
+  a->blocks = 0;
+  a->high_water = 0;
+  a->shrinks = 0;
 }
 
 static arena_block_t* arena_add_block(struct arena* a, size_t min_size) {
@@ -64,8 +83,12 @@ static arena_block_t* arena_add_block(struct arena* a, size_t min_size) {
   block->next = NULL;
   block->size = payload;
   block->used = 0;
+  a->reserved += payload;
+  a->blocks++;
 
   if (a->current) {
+    // Splice in so blocks after current (too small for this request) are kept
+    block->next = a->current->next;
     a->current->next = block;
   }
   else {
@@ -116,6 +139,10 @@ void* arena_alloc(struct arena* a, size_t size) {
     }
   }
 
+  if (a->pos == 0)
+    a->blocks_used++;
+  a->used += size;
+
   void* ptr = (void*)(a->current->data + a->pos);
   a->pos += size;
   a->current->used = a->pos;
@@ -136,13 +163,55 @@ char* arena_strdup(struct arena* a, const char* s) {
   return arena_strndup(a, s, strlen(s));
 }
 
+static void arena_decay(struct arena* a) {
+  // Move high_water 1/16 of the way toward this cycle's usage when it is
+  // lower, so a spike is forgotten after a few dozen quiet resets
+  if (a->used >= a->high_water)
+    a->high_water = a->used;
+  else
+    a->high_water -= (a->high_water - a->used + 15u) / 16u;
+
+  size_t target = a->high_water + a->high_water / 4u;
+  if (target < a->block_size)
+    target = a->block_size;
+  target = (target + 63u) & ~(size_t)63u;
+
+  if (!a->first || a->reserved <= 2u * target)
+    return;
+
+  arena_block_t* block = a->first->next;
+  while (block) {
+    arena_block_t* next = block->next;
+    free(block);
+    block = next;
+  }
+  a->first->next = NULL;
+  a->blocks = 1;
+  a->reserved = a->first->size;
+
+  if (a->first->size != target) {
+    arena_block_t* resized = (arena_block_t*)ds_realloc(a->first, sizeof(arena_block_t) + target);
+    // Keep the old block if the allocator refuses; it is still valid
+    if (resized) {
+      resized->size = target;
+      a->first = resized;
+      a->reserved = target;
+    }
+  }
+  a->shrinks++;
+}
+
 void arena_reset(struct arena* a) {
   // Reset allocation cursor but keep memory around for reuse
   if (!a)
     return;
 
+  arena_decay(a);
+
   a->current = a->first;
   a->pos = 0;
+  a->used = 0;
+  a->blocks_used = 0;
 
   arena_block_t* b = a->first;
   while (b) {
@@ -167,6 +236,11 @@ void arena_destroy(struct arena* a) {
   a->current = NULL;
   a->pos = 0;
   a->block_size = 0;
+  a->used = 0;
+  a->blocks_used = 0;
+  a->reserved = 0;
+  a->blocks = 0;
+  a->high_water = 0;
 }
 
 /* -----------------------------
@@ -259,6 +333,36 @@ void small_vec_remove(small_vec_t* v, void* item) {
   }
 }
 
+/* -----------------------------
+ * Typed vectors
+ * ----------------------------- */
+
+void ds_vec_grow(void** items, size_t* capacity, void* inline_storage, size_t length, size_t elem_size,
+                 size_t min_cap) {
+  // Same geometric policy as small_vec, type-erased for DS_VEC_DEFINE
+  size_t new_cap = *capacity ? *capacity : 8;
+  while (new_cap < min_cap)
+    new_cap *= 2;
+
+  void* new_items;
+  if (*items == inline_storage) {
+    new_items = ds_malloc(new_cap * elem_size);
+    if (new_items)
+      memcpy(new_items, inline_storage, length * elem_size);
+  }
+  else {
+    new_items = ds_realloc(*items, new_cap * elem_size);
+  }
+
+  if (!new_items) {
+    LOG_ERROR("typed vector allocation failed");
+    abort();
+  }
+
+  *items = new_items;
+  *capacity = new_cap;
+}
+
 /* -----------------------------
  * Hash map
  * ----------------------------- */
@@ -325,22 +429,212 @@ static void hash_map_resize(hash_map_t* map, size_t new_capacity) {
   map->max_load = (new_capacity * 3) / 4;
 }
 
+/* -----------------------------
+ * Swiss-table layout
+ *
+ * ctrl[i] is EMPTY, DELETED, or the low 7 hash bits (h2) of a live slot.
+ * Slots are probed in aligned groups of 16 control bytes, visiting groups
+ * in triangular order from the home group (h1 = hash >> 7). A lookup stops
+ * at the first group that still has an EMPTY byte.
+ * ----------------------------- */
+
+#define SWISS_GROUP 16u
+#define SWISS_EMPTY ((uint8_t)0x80)
+#define SWISS_DELETED ((uint8_t)0xFE)
+
+// Bit i set when group[i] == b
+static inline uint32_t swiss_match(const uint8_t* group, uint8_t b) {
+#if defined(__SSE2__)
+  __m128i g = _mm_loadu_si128((const __m128i*)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)b)));
+#else
+  uint32_t m = 0;
+  for (uint32_t i = 0; i < SWISS_GROUP; i++)
+    m |= (uint32_t)(group[i] == b) << i;
+  return m;
+#endif
+}
+
+// Bit i set when group[i] is EMPTY or DELETED (high bit set)
+static inline uint32_t swiss_match_free(const uint8_t* group) {
+#if defined(__SSE2__)
+  return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+  uint32_t m = 0;
+  for (uint32_t i = 0; i < SWISS_GROUP; i++)
+    m |= (uint32_t)(group[i] >> 7) << i;
+  return m;
+#endif
+}
+
+static void swiss_alloc(hash_map_t* map, size_t capacity) {
+  size_t bytes = capacity * (sizeof(uint8_t) + sizeof(uint64_t) + sizeof(void*));
+  uint8_t* block = (uint8_t*)ds_calloc(1, bytes);
+  if (!block) {
+    LOG_ERROR("hash_map allocation failed");
+    abort();
+  }
+  // capacity is a multiple of 16, so keys stay 8-byte aligned
+  map->ctrl = block;
+  map->keys = (uint64_t*)(void*)(block + capacity);
+  map->values = (void**)(void*)(block + capacity + capacity * sizeof(uint64_t));
+  memset(map->ctrl, SWISS_EMPTY, capacity);
+  map->capacity = capacity;
+  map->tombstones = 0;
+  // 7/8 load: groups keep at least a few free bytes so misses end early
+  map->max_load = capacity - capacity / 8;
+}
+
+static size_t swiss_find(const hash_map_t* map, uint64_t key, uint32_t hash) {
+  size_t groups = map->capacity / SWISS_GROUP;
+  size_t g = (hash >> 7) & (groups - 1);
+  uint8_t h2 = (uint8_t)(hash & 0x7F);
+
+  for (size_t step = 1; step <= groups; step++) {
+    const uint8_t* ctrl = map->ctrl + g * SWISS_GROUP;
+    uint32_t m = swiss_match(ctrl, h2);
+    while (m) {
+      size_t idx = g * SWISS_GROUP + (size_t)__builtin_ctz(m);
+      if (map->keys[idx] == key)
+        return idx;
+      m &= m - 1;
+    }
+    if (swiss_match(ctrl, SWISS_EMPTY))
+      return SIZE_MAX;
+    g = (g + step) & (groups - 1);
+  }
+  return SIZE_MAX;
+}
+
+// First EMPTY or DELETED slot on the probe path; the key must be absent
+static size_t swiss_find_free(const hash_map_t* map, uint32_t hash) {
+  size_t groups = map->capacity / SWISS_GROUP;
+  size_t g = (hash >> 7) & (groups - 1);
+
+  for (size_t step = 1;; step++) {
+    uint32_t m = swiss_match_free(map->ctrl + g * SWISS_GROUP);
+    if (m)
+      return g * SWISS_GROUP + (size_t)__builtin_ctz(m);
+    g = (g + step) & (groups - 1);
+  }
+}
+
+static void swiss_resize(hash_map_t* map, size_t new_capacity) {
+  uint8_t* old_ctrl = map->ctrl;
+  uint64_t* old_keys = map->keys;
+  void** old_values = map->values;
+  size_t old_capacity = map->capacity;
+
+  swiss_alloc(map, round_up_pow2(new_capacity));
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old_ctrl[i] & 0x80)
+      continue;
+    uint32_t hash = hash_key(old_keys[i]);
+    size_t idx = swiss_find_free(map, hash);
+    map->ctrl[idx] = (uint8_t)(hash & 0x7F);
+    map->keys[idx] = old_keys[i];
+    map->values[idx] = old_values[i];
+  }
+  free(old_ctrl);
+}
+
+static bool swiss_insert(hash_map_t* map, uint64_t key, void* value) {
+  uint32_t hash = hash_key(key);
+  if (map->capacity) {
+    size_t idx = swiss_find(map, key, hash);
+    if (idx != SIZE_MAX) {
+      map->values[idx] = value;
+      return true;
+    }
+  }
+
+  if (map->capacity == 0 || map->size + map->tombstones >= map->max_load) {
+    // Mostly tombstones: rehash in place instead of growing
+    size_t cap = map->capacity;
+    size_t new_cap = (cap == 0) ? 16 : (map->size + 1 > cap / 2 ? cap * 2 : cap);
+    if (cap == 0)
+      swiss_alloc(map, new_cap);
+    else
+      swiss_resize(map, new_cap);
+  }
+
+  size_t idx = swiss_find_free(map, hash);
+  if (map->ctrl[idx] == SWISS_DELETED)
+    map->tombstones--;
+  map->ctrl[idx] = (uint8_t)(hash & 0x7F);
+  map->keys[idx] = key;
+  map->values[idx] = value;
+  map->size++;
+  return false;
+}
+
+static bool swiss_remove(hash_map_t* map, uint64_t key) {
+  if (map->capacity == 0)
+    return false;
+  size_t idx = swiss_find(map, key, hash_key(key));
+  if (idx == SIZE_MAX)
+    return false;
+
+  // A group with an EMPTY byte never diverted a probe, so it can stay short
+  const uint8_t* group = map->ctrl + (idx & ~(size_t)(SWISS_GROUP - 1));
+  if (swiss_match(group, SWISS_EMPTY)) {
+    map->ctrl[idx] = SWISS_EMPTY;
+  }
+  else {
+    map->ctrl[idx] = SWISS_DELETED;
+    map->tombstones++;
+  }
+  map->keys[idx] = 0;
+  map->values[idx] = NULL;
+  map->size--;
+  return true;
+}
+
+/* -----------------------------
+ * Hash map API
+ * ----------------------------- */
+
 void hash_map_init(hash_map_t* map) {
   map->capacity = 0;
   map->size = 0;
   map->max_load = 0;
   map->entries = NULL;
+  map->ctrl = NULL;
+  map->keys = NULL;
+  map->values = NULL;
+  map->tombstones = 0;
+  map->layout = HASH_MAP_LINEAR;
+}
+
+void hash_map_init_swiss(hash_map_t* map) {
+  hash_map_init(map);
+  map->layout = HASH_MAP_SWISS;
 }
 
 void hash_map_destroy(hash_map_t* map) {
   free(map->entries);
+  free(map->ctrl);
   map->entries = NULL;
+  map->ctrl = NULL;
+  map->keys = NULL;
+  map->values = NULL;
   map->capacity = 0;
   map->size = 0;
   map->max_load = 0;
+  map->tombstones = 0;
 }
 
 void hash_map_clear(hash_map_t* map) {
+  if (map && map->layout == HASH_MAP_SWISS) {
+    // One byte per slot instead of a full entry
+    if (map->ctrl && (map->size || map->tombstones)) {
+      memset(map->ctrl, SWISS_EMPTY, map->capacity);
+    }
+    map->size = 0;
+    map->tombstones = 0;
+    return;
+  }
+
   if (!map || !map->entries || map->capacity == 0) {
     if (map)
       map->size = 0;
@@ -356,6 +650,8 @@ void hash_map_clear(hash_map_t* map) {
 bool hash_map_insert(hash_map_t* map, uint64_t key, void* value) {
   // key=0 is reserved as the empty sentinel
   assert(key != 0 && "key=0 is reserved for hash_map_t");
+  if (map->layout == HASH_MAP_SWISS)
+    return swiss_insert(map, key, value);
 
   if (map->capacity == 0 || map->size >= map->max_load) {
     size_t new_cap = map->capacity ? (map->capacity * 2) : 16;
@@ -387,6 +683,10 @@ void* hash_map_get(const hash_map_t* map, uint64_t key) {
   assert(key != 0 && "key=0 is reserved for hash_map_t");
   if (!map || map->capacity == 0)
     return NULL;
+  if (map->layout == HASH_MAP_SWISS) {
+    size_t idx = swiss_find(map, key, hash_key(key));
+    return (idx == SIZE_MAX) ? NULL : map->values[idx];
+  }
 
   uint32_t hash = hash_key(key);
   size_t mask = map->capacity - 1;
@@ -405,6 +705,8 @@ bool hash_map_remove(hash_map_t* map, uint64_t key) {
   assert(key != 0 && "key=0 is reserved for hash_map_t");
   if (!map || map->capacity == 0)
     return false;
+  if (map->layout == HASH_MAP_SWISS)
+    return swiss_remove(map, key);
 
   // Backshift deletion (Knuth Algorithm R) for linear probing:
   // remove the target slot, then shift forward entries backward when their
@@ -453,3 +755,244 @@ bool hash_map_remove(hash_map_t* map, uint64_t key) {
 
   return false;
 }
+
+#ifndef NDEBUG
+uint32_t ds_hot_path_depth = 0;
+#endif
+
+bool hash_map_next(const hash_map_t* map, size_t* cursor, uint64_t* key, void** value) {
+  if (!map || map->capacity == 0)
+    return false;
+  assert((*cursor != 0 || ds_hot_path_depth == 0) && "full-capacity hash_map walk on the hot path");
+
+  while (*cursor < map->capacity) {
+    size_t i = (*cursor)++;
+    if (map->layout == HASH_MAP_SWISS) {
+      if (map->ctrl[i] & 0x80)
+        continue;
+      *key = map->keys[i];
+      *value = map->values[i];
+      return true;
+    }
+    if (map->entries[i].key == 0)
+      continue;
+    *key = map->entries[i].key;
+    *value = map->entries[i].value;
+    return true;
+  }
+  return false;
+}
+
+/* -----------------------------
+ * Epoch map
+ * ----------------------------- */
+
+// Set on epoch_map_find results that name the empty slot a key would take
+#define EPOCH_MAP_MISS ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+static size_t epoch_map_find(const epoch_map_t* map, uint64_t key) {
+  size_t mask = map->capacity - 1;
+  size_t i = hash_key(key) & mask;
+  while (map->slots[i].epoch == map->epoch) {
+    if (map->keys[map->slots[i].idx] == key)
+      return i;
+    i = probe_next(i, mask);
+  }
+  return i | EPOCH_MAP_MISS;
+}
+
+static void epoch_map_grow(epoch_map_t* map) {
+  size_t new_capacity = map->capacity ? map->capacity * 2 : 16;
+  size_t new_max_load = (new_capacity * 3) / 4;
+
+  epoch_map_slot_t* slots = (epoch_map_slot_t*)ds_calloc(new_capacity, sizeof(*slots));
+  uint64_t* keys = (uint64_t*)ds_realloc(map->keys, new_max_load * sizeof(*keys));
+  if (keys)
+    map->keys = keys;
+  void** values = (void**)ds_realloc(map->values, new_max_load * sizeof(*values));
+  if (values)
+    map->values = values;
+  if (!slots || !keys || !values) {
+    LOG_ERROR("epoch_map allocation failed");
+    abort();
+  }
+
+  // Fresh slots are epoch 0, which is never current
+  if (map->epoch == 0)
+    map->epoch = 1;
+
+  size_t mask = new_capacity - 1;
+  for (size_t n = 0; n < map->count; n++) {
+    size_t i = hash_key(map->keys[n]) & mask;
+    while (slots[i].epoch == map->epoch)
+      i = probe_next(i, mask);
+    slots[i].epoch = map->epoch;
+    slots[i].idx = (uint32_t)n;
+  }
+
+  free(map->slots);
+  map->slots = slots;
+  map->capacity = new_capacity;
+  map->max_load = new_max_load;
+}
+
+void epoch_map_init(epoch_map_t* map) {
+  memset(map, 0, sizeof(*map));
+}
+
+void epoch_map_destroy(epoch_map_t* map) {
+  if (!map)
+    return;
+  free(map->slots);
+  free(map->keys);
+  free(map->values);
+  memset(map, 0, sizeof(*map));
+}
+
+void epoch_map_clear(epoch_map_t* map) {
+  if (!map || map->count == 0)
+    return;
+
+  map->epoch++;
+  if (map->epoch == 0) {
+    // Wrapped: stale stamps could alias the new epoch, so wipe once
+    memset(map->slots, 0, map->capacity * sizeof(*map->slots));
+    map->epoch = 1;
+  }
+  map->count = 0;
+  map->size = 0;
+}
+
+bool epoch_map_insert(epoch_map_t* map, uint64_t key, void* value) {
+  assert(value != NULL && "epoch_map_t values must be non-NULL");
+  if (map->capacity == 0 || map->count >= map->max_load)
+    epoch_map_grow(map);
+
+  size_t i = epoch_map_find(map, key);
+  if (!(i & EPOCH_MAP_MISS)) {
+    uint32_t idx = map->slots[i].idx;
+    bool existed = map->values[idx] != NULL;
+    if (!existed)
+      map->size++;
+    map->values[idx] = value;
+    return existed;
+  }
+
+  i &= ~EPOCH_MAP_MISS;
+  map->keys[map->count] = key;
+  map->values[map->count] = value;
+  map->slots[i].epoch = map->epoch;
+  map->slots[i].idx = (uint32_t)map->count;
+  map->count++;
+  map->size++;
+  return false;
+}
+
+void* epoch_map_get(const epoch_map_t* map, uint64_t key) {
+  if (!map || map->count == 0)
+    return NULL;
+  size_t i = epoch_map_find(map, key);
+  if (i & EPOCH_MAP_MISS)
+    return NULL;
+  return map->values[map->slots[i].idx];
+}
+
+bool epoch_map_remove(epoch_map_t* map, uint64_t key) {
+  if (!map || map->count == 0)
+    return false;
+  size_t i = epoch_map_find(map, key);
+  if (i & EPOCH_MAP_MISS)
+    return false;
+
+  // The slot stays stamped so probe chains through it remain intact
+  uint32_t idx = map->slots[i].idx;
+  if (!map->values[idx])
+    return false;
+  map->values[idx] = NULL;
+  map->size--;
+  return true;
+}
+
+bool epoch_map_next(const epoch_map_t* map, size_t* cursor, uint64_t* key, void** value) {
+  if (!map)
+    return false;
+  while (*cursor < map->count) {
+    size_t i = (*cursor)++;
+    if (!map->values[i])
+      continue;
+    *key = map->keys[i];
+    *value = map->values[i];
+    return true;
+  }
+  return false;
+}
+
+/* -----------------------------
+ * CRC-32C
+ * ----------------------------- */
+
+static uint32_t crc32c_table[256];
+
+static void crc32c_table_init(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++)
+      c = (c >> 1) ^ (0x82f63b78u & (0u - (c & 1u)));
+    crc32c_table[i] = c;
+  }
+}
+
+static uint32_t crc32c_sw(uint32_t crc, const uint8_t* p, size_t len) {
+  while (len--)
+    crc = crc32c_table[(crc ^ *p++) & 0xffu] ^ (crc >> 8);
+  return crc;
+}
+
+#if CRC32C_X86
+__attribute__((target("sse4.2"))) static uint32_t crc32c_sse42(uint32_t crc, const uint8_t* p, size_t len) {
+#if defined(__x86_64__)
+  uint64_t c = crc;
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    c = _mm_crc32_u64(c, v);
+  }
+  crc = (uint32_t)c;
+#endif
+  for (; len >= 4; len -= 4, p += 4) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    crc = _mm_crc32_u32(crc, v);
+  }
+  while (len--)
+    crc = _mm_crc32_u8(crc, *p++);
+  return crc;
+}
+#endif
+
+static uint32_t (*crc32c_impl)(uint32_t crc, const uint8_t* p, size_t len);
+static const char* crc32c_impl_name = "table";
+
+static void crc32c_select(void) {
+#if CRC32C_X86
+  if (__builtin_cpu_supports("sse4.2")) {
+    crc32c_impl = crc32c_sse42;
+    crc32c_impl_name = "sse4.2";
+    return;
+  }
+#endif
+  crc32c_table_init();
+  crc32c_impl = crc32c_sw;
+}
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t len) {
+  if (!crc32c_impl)
+    crc32c_select();
+  return ~crc32c_impl(~crc, (const uint8_t*)data, len);
+}
+
+const char* crc32c_kernel(void) {
+  if (!crc32c_impl)
+    crc32c_select();
+  return crc32c_impl_name;
+}
@@ -7,26 +7,40 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <fontconfig/fontconfig.h>
+#include <inttypes.h>
 #include <pango/pangocairo.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/resource.h>
 #include <sys/signalfd.h>
+#include <sys/socket.h>
 #include <sys/timerfd.h>
-#include <sys/wait.h>
 #include <unistd.h>
+#include <xcb/composite.h>
 #include <xcb/damage.h>
 #include <xcb/randr.h>
+#include <xcb/shm.h>
+#include <xcb/sync.h>
 #include <xcb/xcb_keysyms.h>
+#include <xcb/xinput.h>
+#include <xcb/xkb.h>
 
+#include "config_cache.h"
+#include "event_trace.h"
 #include "frame.h"
 #include "hxm.h"
+#include "manage_stats.h"
 #include "snap_preview.h"
+#include "thumbnail.h"
+#include "tracepoint.h"
 #include "wm.h"
 #include "wm_internal.h"
 #include "xcb_utils.h"
+#include "xi2.h"
 
 /*
  * event.c
@@ -39,42 +53,49 @@
  *  - event_process: apply bucketed work in a stable order (lifecycle -> input
  * -> configure -> property)
  *  - event_drain_cookies: drain async replies (never block in hot loop)
- *  - server_run: tick loop: wait -> drain -> ingest -> process -> flush
+ *  - server_run: tick loop: wait -> ingest -> input -> drain -> bulk -> flush
  *
  * Pipeline:
  *  1. Ingest: Read raw X11 events + signals + timers. Bucket them by type.
  *             Aggressively coalesce high-frequency events (Motion,
  * ConfigureNotify) to avoid redundant processing.
- *  2. Drain:  Check for async cookie replies (GetProperty, etc) and invoke
- * callbacks.
- *  3. Process: Iterate buckets in a stable, logical order:
+ *  2. Input:  event_process_input, the priority lane:
  *              - Lifecycle (Map/Unmap/Destroy) first to ensure valid handles.
- *              - Input (Keys/Buttons) next to drive interactions.
- *              - Configure/Property updates last to reflect external state
- * changes.
- *  4. Flush:  Push accumulated dirty state (layout, focus, stacking) to X11.
+ *              - Keys, buttons, client messages, focus and motion next to
+ * drive interactions.
+ *             When replies or bulk buckets are waiting, wm_flush_input commits
+ * focus and the dragged client and flushes before they run.
+ *  3. Drain:  Check for async cookie replies (GetProperty, etc) and invoke
+ * callbacks.
+ *  4. Bulk:   event_process_bulk: expose, configure, then property updates
+ * (deferred past the tick's time budget), damage and RandR.
+ *  5. Flush:  Push accumulated dirty state (layout, focus, stacking) to X11.
  *
  * Invariants:
  *  - No blocking X round-trips in hot paths
- *  - Bounded work per tick (MAX_EVENTS_PER_TICK)
+ *  - Bounded work per tick (adaptive tick_budget, see event.h)
  *  - Use tick_arena for per-tick allocations and copies
  *  - Batch X requests and flush once per tick
  */
 
 static int make_epoll_or_die(void);
 static void epoll_add_fd_or_die(int epfd, int fd);
-static void load_config_from_home(server_t* s);
+static void server_sync_render_worker(server_t* s);
+static void server_sync_x_reader(server_t* s);
+static void server_sync_cgroup_worker(server_t* s);
+static void server_sync_compositor(server_t* s);
+static void load_config_files(config_t* config, bool use_cache);
 static void load_menu_config(server_t* s);
 static void run_autostart(server_t* s);
 static xcb_atom_t autostart_guard_atom(server_t* s);
 static bool autostart_already_ran(server_t* s, xcb_atom_t guard_atom);
 static void autostart_mark_ran(server_t* s, xcb_atom_t guard_atom);
-static void apply_reload(server_t* s);
+static void event_grab_boost_set(server_t* s, bool want);
+static void apply_reload(server_t* s, uint32_t files);
+static void event_publish_tick_stats(server_t* s);
 static void buckets_reset(event_buckets_t* b);
-static void bucket_clear_map_touched(hash_map_t* map, small_vec_t* keys);
-static void bucket_track_key(server_t* s, small_vec_t* keys, uint64_t key);
 static void event_ingest_one(server_t* s, xcb_generic_event_t* ev);
-static bool server_wait_for_events(server_t* s, int timeout_ms);
+static void event_coalesce(server_t* s, xcb_generic_event_t* ev);
 static void server_apply_snap_config(server_t* s);
 static bool x11_seq_after_or_equal_u16(uint16_t lhs, uint16_t rhs);
 static bool x11_time_after_or_equal_u32(uint32_t lhs, uint32_t rhs);
@@ -85,11 +106,37 @@ static handle_t focus_handle_from_event_window(server_t* s, xcb_window_t win);
 static void event_reduce_focus(server_t* s);
 static void event_reduce_pointer_hints(server_t* s);
 
-typedef struct bucket_iter {
-  size_t cursor;
-} bucket_iter_t;
+/* Record the phase that began at start; returns now, the next phase's start */
+static uint64_t startup_phase_end(startup_phase_t phase, uint64_t start) {
+  uint64_t now = monotonic_time_ns();
+  tick_stats_record_startup(phase, now - start);
+  return now;
+}
+
+bool server_client_cols_init(server_t* s) {
+  static const size_t col_sz[CLIENT_COL_COUNT] = {
+      [CLIENT_COL_XID] = sizeof(xcb_window_t),
+      [CLIENT_COL_STATE] = sizeof(uint8_t),
+      [CLIENT_COL_DESKTOP] = sizeof(int32_t),
+      [CLIENT_COL_STICKY] = sizeof(uint8_t),
+      [CLIENT_COL_FRAME_VIS] = sizeof(uint8_t),
+      [CLIENT_COL_SCREEN] = sizeof(uint8_t),
+  };
+  for (int c = 0; c < CLIENT_COL_COUNT; c++) {
+    if (slotmap_add_column(&s->clients, col_sz[c]) != c)
+      return false;
+  }
+  return true;
+}
 
-static bool bucket_iter_next(const hash_map_t* map, const small_vec_t* keys, bucket_iter_t* it, uint64_t* key, void** value);
+/* The X connection is a Unix socket, so the server can attach our SHM segments */
+static bool server_display_is_local(int fd) {
+  struct sockaddr_storage addr;
+  socklen_t len = sizeof(addr);
+  if (fd < 0 || getsockname(fd, (struct sockaddr*)&addr, &len) < 0)
+    return false;
+  return addr.ss_family == AF_UNIX;
+}
 
 volatile sig_atomic_t g_shutdown_pending = 0;
 volatile sig_atomic_t g_restart_pending = 0;
@@ -97,22 +144,47 @@ volatile sig_atomic_t g_reload_pending = 0;
 
 void server_init(server_t* s) {
   bool is_test = s->is_test;
+  // main forks the launcher helper before anything below exists
+  launcher_t launcher = s->launcher;
   memset(s, 0, sizeof(*s));
   s->is_test = is_test;
+  s->launcher = launcher;
   s->epoll_fd = s->signal_fd = s->timer_fd = s->xcb_fd = -1;
+  s->config_watch.inotify_fd = s->config_watch.timer_fd = -1;
+  control_init(&s->control);
+  uint64_t startup_start = monotonic_time_ns();
+  uint64_t phase_start = startup_start;
 
-  s->conn = xcb_connect_cached();
+  int display_screen = 0;
+  s->conn = xcb_connect_cached(&display_screen);
   if (!s->conn) {
     LOG_ERROR("Failed to connect to X server");
     exit(1);
   }
 
-  xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
-  s->root = screen->root;
-  s->root_visual = screen->root_visual;
-  s->root_visual_type = xcb_get_visualtype(s->conn, s->root_visual);
-  s->root_depth = screen->root_depth;
-  s->default_colormap = screen->default_colormap;
+  // Every screen of the display is managed here and owns its WM_Sn; the one
+  // DISPLAY names (:0.1 -> 1) starts out active. Config, theme, fonts and
+  // the icon and title caches are shared by all of them.
+  xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(s->conn));
+  for (; it.rem > 0 && s->screen_count < HXM_MAX_SCREENS; xcb_screen_next(&it)) {
+    screen_t* scr = &s->screens[s->screen_count];
+    const xcb_screen_t* screen = it.data;
+    scr->num = (int)s->screen_count;
+    scr->root = screen->root;
+    scr->root_visual = screen->root_visual;
+    scr->root_visual_type = xcb_get_visualtype(s->conn, scr->root_visual);
+    scr->root_depth = screen->root_depth;
+    scr->default_colormap = screen->default_colormap;
+    scr->colormaps_static = screen_colormaps_static(screen);
+    s->screen_count++;
+  }
+  if (it.rem > 0)
+    LOG_WARN("Display has more than %u screens, managing the first %u", HXM_MAX_SCREENS, HXM_MAX_SCREENS);
+  if (display_screen < 0 || (uint32_t)display_screen >= s->screen_count) {
+    LOG_WARN("Screen %d does not exist, screen 0 starts active", display_screen);
+    display_screen = 0;
+  }
+  s->active_screen = (uint32_t)display_screen;
 
   s->xcb_fd = xcb_get_file_descriptor(s->conn);
   if (s->xcb_fd < 0) {
@@ -134,15 +206,116 @@ void server_init(server_t* s) {
     exit(1);
   }
 
+  phase_start = startup_phase_end(STARTUP_PHASE_CONNECT, phase_start);
+
+  // Startup queries are pipelined: everything below is sent before the first
+  // reply is awaited, and config parsing runs while the version queries are
+  // in flight.
+  xcb_prefetch_extension_data(s->conn, &xcb_damage_id);
+  xcb_prefetch_extension_data(s->conn, &xcb_randr_id);
+  xcb_prefetch_extension_data(s->conn, &xcb_sync_id);
+  xcb_prefetch_extension_data(s->conn, &xcb_composite_id);
+  xcb_prefetch_extension_data(s->conn, &xcb_shm_id);
+  xcb_prefetch_extension_data(s->conn, &xcb_input_id);
+  xcb_prefetch_extension_data(s->conn, &xcb_xkb_id);
+  xcb_get_property_cookie_t desktop_ck[HXM_MAX_SCREENS];
+  xcb_get_property_cookie_t active_ck[HXM_MAX_SCREENS];
+  xcb_intern_atom_cookie_t wm_sn_ck[HXM_MAX_SCREENS] = {{0}};
+  for (uint32_t i = 0; i < s->screen_count; i++) {
+    xcb_window_t root = s->screens[i].root;
+    desktop_ck[i] = xcb_get_property(s->conn, 0, root, atoms._NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 0, 1);
+    active_ck[i] = xcb_get_property(s->conn, 0, root, atoms._NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 0, 1);
+    if (i > 0) {
+      char wm_sn[16];
+      int wm_sn_len = snprintf(wm_sn, sizeof(wm_sn), "WM_S%u", i);
+      wm_sn_ck[i] = xcb_intern_atom(s->conn, 0, (uint16_t)wm_sn_len, wm_sn);
+    }
+  }
+
+  // One round trip answers all extension queries
   s->damage_supported = false;
   s->damage_event_base = 0;
   s->damage_error_base = 0;
+  xcb_damage_query_version_cookie_t dc = {0};
   const xcb_query_extension_reply_t* damage_ext = xcb_get_extension_data(s->conn, &xcb_damage_id);
   if (damage_ext && damage_ext->present) {
     s->damage_supported = true;
     s->damage_event_base = damage_ext->first_event;
     s->damage_error_base = damage_ext->first_error;
-    xcb_damage_query_version_cookie_t dc = xcb_damage_query_version(s->conn, 1, 1);
+    dc = xcb_damage_query_version(s->conn, 1, 1);
+  }
+
+  s->randr_supported = false;
+  s->randr_event_base = 0;
+  xcb_randr_query_version_cookie_t rc = {0};
+  const xcb_query_extension_reply_t* randr_ext = xcb_get_extension_data(s->conn, &xcb_randr_id);
+  if (randr_ext && randr_ext->present) {
+    s->randr_supported = true;
+    s->randr_event_base = randr_ext->first_event;
+    rc = xcb_randr_query_version(s->conn, 1, 5);
+  }
+
+  s->sync_supported = false;
+  s->sync_event_base = 0;
+  xcb_sync_initialize_cookie_t sc = {0};
+  const xcb_query_extension_reply_t* sync_ext = xcb_get_extension_data(s->conn, &xcb_sync_id);
+  if (sync_ext && sync_ext->present) {
+    s->sync_supported = true;
+    s->sync_event_base = sync_ext->first_event;
+    sc = xcb_sync_initialize(s->conn, XCB_SYNC_MAJOR_VERSION, XCB_SYNC_MINOR_VERSION);
+  }
+
+  s->composite_supported = false;
+  xcb_composite_query_version_cookie_t cc = {0};
+  const xcb_query_extension_reply_t* composite_ext = xcb_get_extension_data(s->conn, &xcb_composite_id);
+  if (composite_ext && composite_ext->present) {
+    s->composite_supported = true;
+    cc = xcb_composite_query_version(s->conn, XCB_COMPOSITE_MAJOR_VERSION, XCB_COMPOSITE_MINOR_VERSION);
+  }
+
+  // A remote server may list MIT-SHM, but cannot attach our segments
+  s->shm_supported = false;
+  xcb_shm_query_version_cookie_t mc = {0};
+  const xcb_query_extension_reply_t* shm_ext = xcb_get_extension_data(s->conn, &xcb_shm_id);
+  if (shm_ext && shm_ext->present && server_display_is_local(s->xcb_fd)) {
+    s->shm_supported = true;
+    mc = xcb_shm_query_version(s->conn);
+  }
+
+  s->xi2_supported = false;
+  xcb_input_xi_query_version_cookie_t xc = {0};
+  xcb_input_xi_get_client_pointer_cookie_t xpc = {0};
+  const xcb_query_extension_reply_t* input_ext = xcb_get_extension_data(s->conn, &xcb_input_id);
+  if (input_ext && input_ext->present) {
+    s->xi2_supported = true;
+    s->xi2_opcode = input_ext->major_opcode;
+    xc = xcb_input_xi_query_version(s->conn, 2, 0);
+    xpc = xcb_input_xi_get_client_pointer(s->conn, XCB_NONE);
+  }
+
+  // Held bindings repeat as bare presses, see key_press_push
+  s->key_repeat.detectable = false;
+  xcb_xkb_use_extension_cookie_t kuc = {0};
+  xcb_xkb_per_client_flags_cookie_t kfc = {0};
+  const xcb_query_extension_reply_t* xkb_ext = xcb_get_extension_data(s->conn, &xcb_xkb_id);
+  if (xkb_ext && xkb_ext->present) {
+    kuc = xcb_xkb_use_extension(s->conn, XCB_XKB_MAJOR_VERSION, XCB_XKB_MINOR_VERSION);
+    kfc = xcb_xkb_per_client_flags(s->conn, XCB_XKB_ID_USE_CORE_KBD, XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT, XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT, 0, 0, 0);
+  }
+  xcb_flush(s->conn);
+  phase_start = startup_phase_end(STARTUP_PHASE_X_QUERIES, phase_start);
+
+  // Initialize configuration (defaults then optional load)
+  config_init_defaults(&s->config);
+  load_config_files(&s->config, !s->is_test);
+  server_apply_snap_config(s);
+
+  // Initialize workspace state from config
+  for (uint32_t i = 0; i < s->screen_count; i++)
+    s->screens[i].desktop_count = s->config.desktop_count ? s->config.desktop_count : 1;
+  phase_start = startup_phase_end(STARTUP_PHASE_CONFIG, phase_start);
+
+  if (s->damage_supported) {
     xcb_damage_query_version_reply_t* dr = xcb_damage_query_version_reply(s->conn, dc, NULL);
     if (!dr) {
       s->damage_supported = false;
@@ -155,13 +328,7 @@ void server_init(server_t* s) {
     }
   }
 
-  s->randr_supported = false;
-  s->randr_event_base = 0;
-  const xcb_query_extension_reply_t* randr_ext = xcb_get_extension_data(s->conn, &xcb_randr_id);
-  if (randr_ext && randr_ext->present) {
-    s->randr_supported = true;
-    s->randr_event_base = randr_ext->first_event;
-    xcb_randr_query_version_cookie_t rc = xcb_randr_query_version(s->conn, 1, 5);
+  if (s->randr_supported) {
     xcb_randr_query_version_reply_t* rr = xcb_randr_query_version_reply(s->conn, rc, NULL);
     if (!rr) {
       s->randr_supported = false;
@@ -172,56 +339,132 @@ void server_init(server_t* s) {
     }
   }
 
-  // Initialize configuration (defaults then optional load)
-  config_init_defaults(&s->config);
-  load_config_from_home(s);
-  server_apply_snap_config(s);
+  if (s->sync_supported) {
+    xcb_sync_initialize_reply_t* sr = xcb_sync_initialize_reply(s->conn, sc, NULL);
+    if (!sr) {
+      s->sync_supported = false;
+      s->sync_event_base = 0;
+      LOG_WARN("XSync present but initialize failed; resize will not wait for clients");
+    }
+    else {
+      free(sr);
+    }
+  }
 
-  // Initialize workspace state from config
-  s->desktop_count = s->config.desktop_count ? s->config.desktop_count : 1;
-
-  // Restore current desktop
-  s->current_desktop = 0;
-  xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, s->root, atoms._NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 0, 1);
-  xcb_get_property_reply_t* r = xcb_get_property_reply(s->conn, ck, NULL);
-  if (r) {
-    if (r->type == XCB_ATOM_CARDINAL && r->format == 32 && xcb_get_property_value_length(r) >= 4) {
-      uint32_t val = *(uint32_t*)xcb_get_property_value(r);
-      if (val < s->desktop_count) {
-        s->current_desktop = val;
-      }
+  if (s->composite_supported) {
+    // NameWindowPixmap arrived in 0.2
+    xcb_composite_query_version_reply_t* cr = xcb_composite_query_version_reply(s->conn, cc, NULL);
+    if (!cr || (cr->major_version == 0 && cr->minor_version < 2)) {
+      s->composite_supported = false;
+      LOG_WARN("Composite missing or older than 0.2; switcher thumbnails disabled");
+    }
+    free(cr);
+  }
+
+  if (s->shm_supported) {
+    xcb_shm_query_version_reply_t* mr = xcb_shm_query_version_reply(s->conn, mc, NULL);
+    if (!mr) {
+      s->shm_supported = false;
+      LOG_WARN("MIT-SHM present but version query failed; images are uploaded with PutImage");
+    }
+    free(mr);
+  }
+
+  if (s->xi2_supported) {
+    xcb_input_xi_query_version_reply_t* xr = xcb_input_xi_query_version_reply(s->conn, xc, NULL);
+    xcb_input_xi_get_client_pointer_reply_t* xpr = xcb_input_xi_get_client_pointer_reply(s->conn, xpc, NULL);
+    if (!xr || xr->major_version < 2) {
+      s->xi2_supported = false;
+      LOG_WARN("XInput 2 missing; drags use core motion");
     }
-    free(r);
+    // Device 2 is the virtual core pointer on every X server
+    s->xi2_pointer = xpr ? xpr->deviceid : 2;
+    free(xr);
+    free(xpr);
   }
 
-  // Restore active window (focus)
+  if (kuc.sequence) {
+    xcb_xkb_use_extension_reply_t* ur = xcb_xkb_use_extension_reply(s->conn, kuc, NULL);
+    xcb_xkb_per_client_flags_reply_t* fr = xcb_xkb_per_client_flags_reply(s->conn, kfc, NULL);
+    s->key_repeat.detectable = ur && ur->supported && fr && (fr->value & XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT);
+    free(ur);
+    free(fr);
+  }
+  if (!s->key_repeat.detectable)
+    LOG_INFO("XKB detectable auto-repeat unavailable; key repeats are matched by timestamp");
+
   s->initial_focus = XCB_NONE;
-  ck = xcb_get_property(s->conn, 0, s->root, atoms._NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 0, 1);
-  r = xcb_get_property_reply(s->conn, ck, NULL);
-  if (r) {
-    if (r->type == XCB_ATOM_WINDOW && r->format == 32 && xcb_get_property_value_length(r) >= 4) {
-      s->initial_focus = *(xcb_window_t*)xcb_get_property_value(r);
-      LOG_INFO("Restoring focus to window %u", s->initial_focus);
+  for (uint32_t i = 0; i < s->screen_count; i++) {
+    screen_t* scr = &s->screens[i];
+    if (i > 0) {
+      xcb_intern_atom_reply_t* ar = xcb_intern_atom_reply(s->conn, wm_sn_ck[i], NULL);
+      if (ar) {
+        scr->wm_selection = ar->atom;
+        free(ar);
+      }
+      if (scr->wm_selection == XCB_NONE) {
+        LOG_ERROR("Failed to intern WM_S%u", i);
+        exit(1);
+      }
+    }
+
+    // Restore current desktop
+    scr->current_desktop = 0;
+    xcb_get_property_reply_t* r = xcb_get_property_reply(s->conn, desktop_ck[i], NULL);
+    if (r) {
+      if (r->type == XCB_ATOM_CARDINAL && r->format == 32 && xcb_get_property_value_length(r) >= 4) {
+        uint32_t val = *(uint32_t*)xcb_get_property_value(r);
+        if (val < scr->desktop_count) {
+          scr->current_desktop = val;
+        }
+      }
+      free(r);
+    }
+
+    // Restore active window (focus); the active screen's wins
+    r = xcb_get_property_reply(s->conn, active_ck[i], NULL);
+    if (r) {
+      if (r->type == XCB_ATOM_WINDOW && r->format == 32 && xcb_get_property_value_length(r) >= 4) {
+        xcb_window_t win = *(xcb_window_t*)xcb_get_property_value(r);
+        if (win != XCB_NONE && (s->initial_focus == XCB_NONE || i == s->active_screen))
+          s->initial_focus = win;
+      }
+      free(r);
     }
-    free(r);
   }
+  if (s->initial_focus != XCB_NONE)
+    LOG_INFO("Restoring focus to window %u", s->initial_focus);
+  phase_start = startup_phase_end(STARTUP_PHASE_X_QUERIES, phase_start);
 
   // Cookie jar for async request/reply handling
   cookie_jar_init(&s->cookie_jar);
+  tick_budget_init(&s->tick_budget);
+  event_ring_init(&s->event_ring, EVENT_RING_CAP);
   // Initialize per-tick arena before any startup path publishes workarea.
   arena_init(&s->tick_arena, 64 * 1024);
 
   // Become WM (WM_S0 selection + supporting WM check + _NET_SUPPORTED baseline)
   wm_become(s);
-  xcb_install_colormap(s->conn, s->default_colormap);
-  if (s->randr_supported) {
-    xcb_randr_select_input(s->conn, s->root, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE);
+  for (uint32_t i = 0; i < s->screen_count; i++) {
+    screen_t* scr = &s->screens[i];
+    if (!scr->colormaps_static)
+      xcb_install_colormap(s->conn, scr->default_colormap);
+    if (s->randr_supported) {
+      xcb_randr_select_input(s->conn, scr->root, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE);
+    }
   }
 
   // Adopt existing windows (must happen after we are the WM)
-  wm_update_monitors(s);
+  for (uint32_t i = 0; i < s->screen_count; i++)
+    wm_update_monitors(s, &s->screens[i]);
   snap_preview_init(s);
+  phase_start = startup_phase_end(STARTUP_PHASE_BECOME, phase_start);
+
+  event_trace_open_from_env();
+  tp_open_from_env();
+  handoff_load(&s->handoff, s->screens[0].root);
   wm_adopt_children(s);
+  phase_start = startup_phase_end(STARTUP_PHASE_ADOPT, phase_start);
 
   // Create epoll instance and register X connection fd
   s->epoll_fd = make_epoll_or_die();
@@ -248,6 +491,8 @@ void server_init(server_t* s) {
     exit(1);
   }
   epoll_add_fd_or_die(s->epoll_fd, s->signal_fd);
+  if (s->launcher.helper_pid > 0)
+    epoll_add_fd_or_die(s->epoll_fd, s->launcher.helper_fd);
 
   // Setup timerfd (initially disarmed)
   s->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
@@ -257,6 +502,17 @@ void server_init(server_t* s) {
   }
   epoll_add_fd_or_die(s->epoll_fd, s->timer_fd);
 
+  // Config hot reload; without inotify only SIGHUP reloads
+  if (config_watch_init(&s->config_watch)) {
+    config_watch_add_search_path(&s->config_watch);
+    epoll_add_fd_or_die(s->epoll_fd, s->config_watch.inotify_fd);
+    epoll_add_fd_or_die(s->epoll_fd, s->config_watch.timer_fd);
+  }
+
+  // Live diagnostics for `hxm --query`; a test server must not take the real socket
+  if (!s->is_test)
+    control_open(&s->control, s->epoll_fd);
+
   // Initialize event buckets
   small_vec_init(&s->buckets.map_requests);
   small_vec_init(&s->buckets.unmap_notifies);
@@ -266,20 +522,16 @@ void server_init(server_t* s) {
   small_vec_init(&s->buckets.button_events);
   small_vec_init(&s->buckets.client_messages);
 
-  hash_map_init(&s->buckets.expose_regions);
-  small_vec_init(&s->buckets.expose_region_keys);
-  hash_map_init(&s->buckets.configure_requests);
-  small_vec_init(&s->buckets.configure_request_keys);
-  hash_map_init(&s->buckets.configure_notifies);
-  small_vec_init(&s->buckets.configure_notify_keys);
-  hash_map_init(&s->buckets.destroyed_windows);
-  small_vec_init(&s->buckets.destroyed_window_keys);
-  hash_map_init(&s->buckets.property_notifies);
-  small_vec_init(&s->buckets.property_notify_keys);
-  hash_map_init(&s->buckets.motion_notifies);
-  small_vec_init(&s->buckets.motion_notify_keys);
-  hash_map_init(&s->buckets.damage_regions);
-  small_vec_init(&s->buckets.damage_region_keys);
+  epoch_map_init(&s->buckets.expose_regions);
+  epoch_map_init(&s->buckets.configure_requests);
+  epoch_map_init(&s->buckets.client_message_keys);
+  epoch_map_init(&s->buckets.client_message_last);
+  epoch_map_init(&s->buckets.key_repeats);
+  epoch_map_init(&s->buckets.configure_notifies);
+  epoch_map_init(&s->buckets.destroyed_windows);
+  epoch_map_init(&s->buckets.property_notifies);
+  epoch_map_init(&s->buckets.motion_notifies);
+  epoch_map_init(&s->buckets.damage_regions);
 
   s->buckets.pointer_notify.enter_valid = false;
   s->buckets.pointer_notify.leave_valid = false;
@@ -288,29 +540,50 @@ void server_init(server_t* s) {
   s->buckets.ingested = 0;
   s->buckets.coalesced = 0;
 
-  // Initialize global maps
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+  // Initialize global maps (window lookups are hot and long-lived: Swiss layout)
+  hash_map_init_swiss(&s->xid_index);
   hash_map_init(&s->pending_unmanaged_states);
-
-  // Layer stacks and focus ring
-  for (int i = 0; i < LAYER_COUNT; i++) {
-    small_vec_init(&s->layers[i]);
+  hash_map_init(&s->prop_fetches);
+  hash_map_init(&s->adopt_desktops);
+  u32_vec_init(&s->adopt_later);
+  handle_vec_init(&s->adopt_deferred);
+
+  // Per-screen indexes and layer stacks; the focus ring is shared
+  for (uint32_t n = 0; n < HXM_MAX_SCREENS; n++) {
+    screen_t* scr = &s->screens[n];
+    spatial_index_init(&scr->frame_index);
+    for (int i = 0; i < LAYER_COUNT; i++) {
+      handle_vec_init(&scr->layers[i]);
+    }
+    handle_vec_init(&scr->strut_clients);
+    handle_vec_init(&scr->sticky_members);
+    handle_vec_init(&scr->visibility_moved);
+    handle_vec_init(&scr->show_desktop_order);
+    u32_vec_init(&scr->committed_stacking);
   }
-  list_init(&s->focus_history);
   s->focused_client = HANDLE_INVALID;
+  s->button_grab_client = HANDLE_INVALID;
   s->last_focus_sequence = 0;
   s->last_pointer_hint_time = 0;
 
   // Interaction state
   s->interaction_handle = HANDLE_INVALID;
 
-  // Client storage (handles + hot/cold split)
-  if (!slotmap_init(&s->clients, 8192, sizeof(client_hot_t), sizeof(client_cold_t))) {
+  // Client storage (handles + hot/cold split), paged so it grows in place
+  if (!slotmap_init_paged(&s->clients, 4 * SLOTMAP_PAGE_SLOTS, sizeof(client_hot_t), sizeof(client_cold_t))) {
     LOG_ERROR("client slotmap init failed");
     abort();
   }
-  small_vec_init(&s->active_clients);
+  if (!server_client_cols_init(s)) {
+    LOG_ERROR("client column init failed");
+    abort();
+  }
+  handle_vec_init(&s->active_clients);
+  handle_vec_init(&s->dirty_clients);
+  handle_vec_init(&s->title_deferred);
+  handle_vec_init(&s->frame_pass);
+  handle_vec_init(&s->thumb_queue);
+  handle_vec_init(&s->fs_fast_covered);
 
   // Setup decoration resources (colors/fonts/gcs/etc)
   frame_init_resources(s);
@@ -319,6 +592,18 @@ void server_init(server_t* s) {
   menu_init(s);
   load_menu_config(s);
 
+  icon_cache_init(&s->icon_cache);
+  title_cache_init(&s->title_cache);
+  if (s->shm_supported && !s->is_test)
+    render_upload_init(s->conn, server_screen(s)->root, server_screen(s)->root_visual_type);
+  frame_pool_init(&s->frame_pool);
+  server_sync_render_worker(s);
+  server_sync_x_reader(s);
+  server_sync_cgroup_worker(s);
+  server_sync_compositor(s);
+  wm_tiling_reload(s);
+  wm_ping_reload(s);
+
   // Default Icon
   if (access("assets/hxm-black.png", R_OK) == 0) {
     s->default_icon = cairo_image_surface_create_from_png("assets/hxm-black.png");
@@ -339,8 +624,9 @@ void server_init(server_t* s) {
   if (!s->is_test) {
     run_autostart(s);
   }
+  phase_start = startup_phase_end(STARTUP_PHASE_RESOURCES, phase_start);
 
-  LOG_INFO("Server initialized");
+  LOG_INFO("Server initialized in %.1f ms", (double)(phase_start - startup_start) / 1e6);
 }
 
 static void cleanup_client_visitor(void* hot, void* cold, handle_t h, void* user) {
@@ -356,33 +642,64 @@ void server_cleanup(server_t* s) {
     s->default_icon = NULL;
   }
 
+  event_grab_boost_set(s, false);
   snap_preview_destroy(s);
+  event_trace_close();
+  tp_dump();
+  tp_close();
 
   if (s->prefetched_event) {
     free(s->prefetched_event);
     s->prefetched_event = NULL;
   }
 
-  // Unmanage all clients (reparent back to root)
+  // Before unmanaging maps everything back, and whatever happens after
+  freezer_destroy(&s->freezer);
+  // Clients go back to the root visible to the server, not to an overlay
+  compositor_stop(s);
+
+  // Unmanage all clients (reparent back to root); their frames are
+  // destroyed, not pooled
+  frame_pool_destroy(&s->frame_pool, s->conn);
   slotmap_for_each_used(&s->clients, cleanup_client_visitor, s);
 
   if (s->keysyms) {
     xcb_key_symbols_free(s->keysyms);
     s->keysyms = NULL;
   }
+  free(s->key_grabs);
+  s->key_grabs = NULL;
+  s->key_grab_count = 0;
 
   frame_cleanup_resources(s);
   menu_destroy(s);
+  s->title_cache.worker = NULL;
+  render_worker_stop(&s->render_worker);
+  x_reader_destroy(&s->x_reader);
+  timer_wheel_cancel(&s->timers, &s->focus_boost_timer);
+  timer_wheel_cancel(&s->timers, &s->ping_timer);
+  cgroup_worker_stop(&s->cgroup_worker);
+  icon_cache_destroy(&s->icon_cache);
+  title_cache_destroy(&s->title_cache);
+  render_upload_shutdown();
   config_destroy(&s->config);
 
-  if (s->monitors) {
-    free(s->monitors);
-    s->monitors = NULL;
-  }
-  if (s->randr_pending_monitors) {
-    free(s->randr_pending_monitors);
-    s->randr_pending_monitors = NULL;
-  }
+  for (uint32_t n = 0; n < HXM_MAX_SCREENS; n++) {
+    screen_t* scr = &s->screens[n];
+    free(scr->monitors);
+    scr->monitors = NULL;
+    free(scr->workarea_cache);
+    scr->workarea_cache = NULL;
+    scr->workarea_cache_valid = false;
+    free(scr->desktop_focus);
+    scr->desktop_focus = NULL;
+    scr->desktop_focus_cap = 0;
+    free(scr->randr_pending_monitors);
+    scr->randr_pending_monitors = NULL;
+    free(scr->randr_pending_modes);
+    scr->randr_pending_modes = NULL;
+  }
+  focus_mru_destroy(&s->focus_mru);
 
   if (s->signal_fd >= 0) {
     close(s->signal_fd);
@@ -392,6 +709,8 @@ void server_cleanup(server_t* s) {
     close(s->timer_fd);
     s->timer_fd = -1;
   }
+  config_watch_destroy(&s->config_watch);
+  control_close(&s->control);
   if (s->epoll_fd >= 0) {
     close(s->epoll_fd);
     s->epoll_fd = -1;
@@ -403,6 +722,7 @@ void server_cleanup(server_t* s) {
   cookie_jar_destroy(&s->cookie_jar);
 
   arena_destroy(&s->tick_arena);
+  event_ring_destroy(&s->event_ring);
 
   small_vec_destroy(&s->buckets.map_requests);
   small_vec_destroy(&s->buckets.unmap_notifies);
@@ -412,48 +732,75 @@ void server_cleanup(server_t* s) {
   small_vec_destroy(&s->buckets.button_events);
   small_vec_destroy(&s->buckets.client_messages);
 
-  hash_map_destroy(&s->buckets.expose_regions);
-  small_vec_destroy(&s->buckets.expose_region_keys);
-  hash_map_destroy(&s->buckets.configure_requests);
-  small_vec_destroy(&s->buckets.configure_request_keys);
-  hash_map_destroy(&s->buckets.configure_notifies);
-  small_vec_destroy(&s->buckets.configure_notify_keys);
-  hash_map_destroy(&s->buckets.destroyed_windows);
-  small_vec_destroy(&s->buckets.destroyed_window_keys);
-  hash_map_destroy(&s->buckets.property_notifies);
-  small_vec_destroy(&s->buckets.property_notify_keys);
-  hash_map_destroy(&s->buckets.motion_notifies);
-  small_vec_destroy(&s->buckets.motion_notify_keys);
-  hash_map_destroy(&s->buckets.damage_regions);
-  small_vec_destroy(&s->buckets.damage_region_keys);
-
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  epoch_map_destroy(&s->buckets.expose_regions);
+  epoch_map_destroy(&s->buckets.configure_requests);
+  epoch_map_destroy(&s->buckets.client_message_keys);
+  epoch_map_destroy(&s->buckets.client_message_last);
+  epoch_map_destroy(&s->buckets.key_repeats);
+  free(s->buckets.unmanaged_configs);
+  s->buckets.unmanaged_configs = NULL;
+  s->buckets.unmanaged_configs_len = s->buckets.unmanaged_configs_cap = 0;
+  free(s->buckets.deferred_props);
+  s->buckets.deferred_props = NULL;
+  s->buckets.deferred_props_len = s->buckets.deferred_props_cap = 0;
+  epoch_map_destroy(&s->buckets.configure_notifies);
+  epoch_map_destroy(&s->buckets.destroyed_windows);
+  epoch_map_destroy(&s->buckets.property_notifies);
+  epoch_map_destroy(&s->buckets.motion_notifies);
+  epoch_map_destroy(&s->buckets.damage_regions);
+
+  hash_map_destroy(&s->xid_index);
+  handoff_destroy(&s->handoff);
 
   // Clean up pending states
-  for (size_t i = 0; i < s->pending_unmanaged_states.capacity; i++) {
-    hash_map_entry_t* entry = &s->pending_unmanaged_states.entries[i];
-    if (entry->key != 0) {
-      small_vec_t* v = (small_vec_t*)entry->value;
-      if (v) {
-        for (size_t j = 0; j < v->length; j++) {
-          free(v->items[j]);
-        }
-        small_vec_destroy(v);
-        free(v);
+  size_t pending_cursor = 0;
+  uint64_t pending_key = 0;
+  void* pending_value = NULL;
+  while (hash_map_next(&s->pending_unmanaged_states, &pending_cursor, &pending_key, &pending_value)) {
+    small_vec_t* v = (small_vec_t*)pending_value;
+    if (v) {
+      for (size_t j = 0; j < v->length; j++) {
+        free(v->items[j]);
       }
+      small_vec_destroy(v);
+      free(v);
     }
   }
   hash_map_destroy(&s->pending_unmanaged_states);
+  hash_map_destroy(&s->prop_fetches);
+  hash_map_destroy(&s->adopt_desktops);
+  u32_vec_destroy(&s->adopt_later);
+  handle_vec_destroy(&s->adopt_deferred);
+  snap_edges_destroy(&s->snap_edges);
 
+  wm_tiling_destroy(s);
   slotmap_destroy(&s->clients);
-  small_vec_destroy(&s->active_clients);
-
-  for (int i = 0; i < LAYER_COUNT; i++) {
-    small_vec_destroy(&s->layers[i]);
+  handle_vec_destroy(&s->active_clients);
+  handle_vec_destroy(&s->dirty_clients);
+  handle_vec_destroy(&s->title_deferred);
+  handle_vec_destroy(&s->frame_pass);
+  handle_vec_destroy(&s->thumb_queue);
+  handle_vec_destroy(&s->fs_fast_covered);
+  wm_desktop_members_destroy(s);
+  wm_published_props_destroy(s);
+  transient_groups_destroy(&s->transients);
+  launcher_destroy(&s->launcher);
+
+  for (uint32_t n = 0; n < HXM_MAX_SCREENS; n++) {
+    screen_t* scr = &s->screens[n];
+    spatial_index_destroy(&scr->frame_index);
+    handle_vec_destroy(&scr->strut_clients);
+    handle_vec_destroy(&scr->sticky_members);
+    handle_vec_destroy(&scr->visibility_moved);
+    handle_vec_destroy(&scr->show_desktop_order);
+    u32_vec_destroy(&scr->committed_stacking);
+    for (int i = 0; i < LAYER_COUNT; i++) {
+      handle_vec_destroy(&scr->layers[i]);
+    }
   }
 
   // Global library cleanup for ASan
+  render_text_shutdown();
   pango_cairo_font_map_set_default(NULL);
   FcFini();
 }
@@ -478,6 +825,67 @@ static void epoll_add_fd_or_die(int epfd, int fd) {
   }
 }
 
+/* (Re)start the title shaping thread to match config.render_thread */
+static void server_sync_render_worker(server_t* s) {
+  s->title_cache.worker = NULL;
+  render_worker_stop(&s->render_worker);
+  if (!s->config.render_thread)
+    return;
+  if (!render_worker_start(&s->render_worker)) {
+    LOG_WARN("render_thread unavailable, shaping titles inline");
+    return;
+  }
+  // Closing the eventfd on stop drops it from the epoll set again
+  epoll_add_fd_or_die(s->epoll_fd, s->render_worker.notify_fd);
+  s->title_cache.worker = &s->render_worker;
+}
+
+/* (Re)start the X input thread to match config.input_thread */
+static void server_sync_x_reader(server_t* s) {
+  if (s->config.input_thread == s->x_reader.running)
+    return;
+  if (!s->config.input_thread) {
+    // Closing its eventfd drops it from the epoll set; events it already
+    // read are ingested before main thread reads resume
+    x_reader_stop(&s->x_reader);
+    epoll_add_fd_or_die(s->epoll_fd, s->xcb_fd);
+    return;
+  }
+  if (!x_reader_start(&s->x_reader, s->conn)) {
+    LOG_WARN("input_thread unavailable, reading X on the main thread");
+    return;
+  }
+  // The reader owns socket reads; wake on its eventfd instead
+  if (epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, s->xcb_fd, NULL) < 0)
+    LOG_WARN("epoll_ctl del xcb fd failed: %s", strerror(errno));
+  epoll_add_fd_or_die(s->epoll_fd, s->x_reader.notify_fd);
+}
+
+/* (Re)start the cgroup weight thread to match config.focus_boost */
+static void server_sync_cgroup_worker(server_t* s) {
+  timer_wheel_cancel(&s->timers, &s->focus_boost_timer);
+  // Stopping puts the boosted cgroup's weights back
+  cgroup_worker_stop(&s->cgroup_worker);
+  s->focus_boost_pid = 0;
+  if (!s->config.focus_boost)
+    return;
+  if (!cgroup_worker_start(&s->cgroup_worker, s->config.focus_boost_weight)) {
+    LOG_WARN("focus_boost unavailable");
+    return;
+  }
+  server_focus_boost_note(s);
+}
+
+/* Start or stop the built-in compositor to match config.compositor */
+static void server_sync_compositor(server_t* s) {
+  if (compositor_enabled(s) == s->compositor.active)
+    return;
+  if (s->compositor.active)
+    compositor_stop(s);
+  else
+    compositor_start(s);
+}
+
 static xcb_atom_t autostart_guard_atom(server_t* s) {
   static const char* const guard_name = "_HXM_AUTOSTART_DONE";
   xcb_intern_atom_cookie_t ck = xcb_intern_atom(s->conn, 0, (uint16_t)strlen(guard_name), guard_name);
@@ -493,7 +901,7 @@ static bool autostart_already_ran(server_t* s, xcb_atom_t guard_atom) {
   if (guard_atom == XCB_ATOM_NONE)
     return false;
 
-  xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, s->root, guard_atom, XCB_ATOM_CARDINAL, 0, 1);
+  xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, s->screens[0].root, guard_atom, XCB_ATOM_CARDINAL, 0, 1);
   xcb_get_property_reply_t* reply = xcb_get_property_reply(s->conn, ck, NULL);
   if (!reply)
     return false;
@@ -513,7 +921,7 @@ static void autostart_mark_ran(server_t* s, xcb_atom_t guard_atom) {
     return;
 
   uint32_t one = 1u;
-  xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, guard_atom, XCB_ATOM_CARDINAL, 32, 1, &one);
+  xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->screens[0].root, guard_atom, XCB_ATOM_CARDINAL, 32, 1, &one);
   xcb_flush(s->conn);
 }
 
@@ -556,97 +964,253 @@ static void run_autostart(server_t* s) {
   }
 
   LOG_INFO("Executing autostart script: %s", exec_path);
-  pid_t pid = fork();
-  if (pid == 0) {
-    if (setsid() < 0) {
-      LOG_WARN("setsid failed in autostart: %s", strerror(errno));
-    }
-    execl(exec_path, exec_path, NULL);
-    LOG_ERROR("Failed to exec autostart script: %s", strerror(errno));
-    exit(1);
-  }
-  if (pid < 0) {
-    LOG_ERROR("Failed to fork for autostart: %s", strerror(errno));
+  if (launcher_exec(&s->launcher, exec_path, 0) < 0)
     return;
-  }
 
   autostart_mark_ran(s, guard_atom);
 }
 
-static void load_config_from_home(server_t* s) {
-  char path[1024];
-  bool config_loaded = false;
+/* Add the user and system locations of a config file, most specific first */
+static void config_candidates(config_cache_sources_t* src, const char* name) {
   const char* xdg_config_home = getenv("XDG_CONFIG_HOME");
   const char* home = getenv("HOME");
+  if (xdg_config_home)
+    config_cache_sources_add(src, "%s/hxm/%s", xdg_config_home, name);
+  if (home)
+    config_cache_sources_add(src, "%s/.config/hxm/%s", home, name);
+  config_cache_sources_add(src, "/etc/hxm/%s", name);
+}
 
-  if (xdg_config_home) {
-    snprintf(path, sizeof(path), "%s/hxm/hxm.conf", xdg_config_home);
-    config_loaded = config_load(&s->config, path);
-  }
-
-  if (!config_loaded && home) {
-    snprintf(path, sizeof(path), "%s/.config/hxm/hxm.conf", home);
-    config_loaded = config_load(&s->config, path);
-  }
-
-  if (!config_loaded) {
-    config_load(&s->config, "/etc/hxm/hxm.conf");
+/*
+ * Load hxm.conf then themerc from the first location that has each. The
+ * source-tree fallbacks (data/, ../data/) are only tried when readable. With
+ * use_cache, an unchanged set of candidates is served from the compiled cache.
+ */
+static void load_config_files(config_t* config, bool use_cache) {
+  config_cache_sources_t* src = malloc(sizeof(*src));
+  if (!src)
+    return;
+  config_cache_sources_init(src);
+  config_candidates(src, "hxm.conf");
+  uint32_t tree_first = src->count;
+  config_cache_sources_add(src, "data/hxm.conf");
+  config_cache_sources_add(src, "../data/hxm.conf");
+  uint32_t theme_first = src->count;
+  config_candidates(src, "themerc");
+
+  if (use_cache && config_cache_load_config(config, src)) {
+    free(src);
+    return;
   }
+  if (use_cache)
+    config_cache_stamp(src);
 
-  if (!config_loaded && access("data/hxm.conf", R_OK) == 0) {
-    config_loaded = config_load(&s->config, "data/hxm.conf");
-  }
-  if (!config_loaded && access("../data/hxm.conf", R_OK) == 0) {
-    config_loaded = config_load(&s->config, "../data/hxm.conf");
+  bool config_loaded = false;
+  for (uint32_t i = 0; i < theme_first && !config_loaded; i++) {
+    if (i >= tree_first && access(src->path[i], R_OK) != 0)
+      continue;
+    config_loaded = config_load(config, src->path[i]);
   }
 
   // Now try to load the theme
   bool theme_loaded = false;
-  if (xdg_config_home) {
-    snprintf(path, sizeof(path), "%s/hxm/themerc", xdg_config_home);
-    theme_loaded = theme_load(&s->config.theme, path);
+  for (uint32_t i = theme_first; i < src->count && !theme_loaded; i++)
+    theme_loaded = theme_load(&config->theme, src->path[i]);
+
+  if (use_cache && (config_loaded || theme_loaded))
+    config_cache_store_config(config, src);
+  free(src);
+}
+
+static void load_menu_config(server_t* s) {
+  config_cache_sources_t* src = malloc(sizeof(*src));
+  if (!src)
+    return;
+  config_cache_sources_init(src);
+  config_candidates(src, "menu.conf");
+  uint32_t tree_first = src->count;
+  config_cache_sources_add(src, "data/menu.conf");
+  config_cache_sources_add(src, "../data/menu.conf");
+
+  bool use_cache = !s->is_test;
+  if (use_cache && menu_load_cache(s, src)) {
+    free(src);
+    return;
   }
+  if (use_cache)
+    config_cache_stamp(src);
 
-  if (!theme_loaded && home) {
-    snprintf(path, sizeof(path), "%s/.config/hxm/themerc", home);
-    theme_loaded = theme_load(&s->config.theme, path);
+  bool loaded = false;
+  for (uint32_t i = 0; i < src->count && !loaded; i++) {
+    if (i >= tree_first && access(src->path[i], R_OK) != 0)
+      continue;
+    loaded = menu_load_config(s, src->path[i]);
   }
 
-  if (!theme_loaded) {
-    theme_load(&s->config.theme, "/etc/hxm/themerc");
+  if (!loaded) {
+    LOG_WARN("Menu config not found; menu will be empty");
   }
+  else if (use_cache) {
+    menu_store_cache(s, src);
+  }
+  free(src);
 }
 
-static void load_menu_config(server_t* s) {
-  char path[1024];
-  bool loaded = false;
-  const char* xdg_config_home = getenv("XDG_CONFIG_HOME");
-  const char* home = getenv("HOME");
+static void pending_config_merge(pending_config_t* pc, const xcb_configure_request_event_t* e) {
+  if (e->value_mask & XCB_CONFIG_WINDOW_X)
+    pc->x = e->x;
+  if (e->value_mask & XCB_CONFIG_WINDOW_Y)
+    pc->y = e->y;
+  if (e->value_mask & XCB_CONFIG_WINDOW_WIDTH)
+    pc->width = e->width;
+  if (e->value_mask & XCB_CONFIG_WINDOW_HEIGHT)
+    pc->height = e->height;
+  if (e->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+    pc->border_width = e->border_width;
+  if (e->value_mask & XCB_CONFIG_WINDOW_SIBLING)
+    pc->sibling = e->sibling;
+  if (e->value_mask & XCB_CONFIG_WINDOW_STACK_MODE)
+    pc->stack_mode = e->stack_mode;
+  pc->mask |= e->value_mask;
+}
 
-  if (xdg_config_home) {
-    snprintf(path, sizeof(path), "%s/hxm/menu.conf", xdg_config_home);
-    loaded = menu_load_config(s, path);
+// How far back a request looks for an entry of the same window to merge
+// into. Storms come from one window at a time, so a short window catches
+// them without turning ingest quadratic when many windows are busy.
+#define UNMANAGED_CONFIG_MERGE_SCAN 8u
+
+static bool unmanaged_config_append(event_buckets_t* b, const pending_config_t* pc) {
+  if (b->unmanaged_configs_len == b->unmanaged_configs_cap) {
+    uint32_t cap = b->unmanaged_configs_cap ? b->unmanaged_configs_cap * 2 : 16;
+    pending_config_t* grown = realloc(b->unmanaged_configs, (size_t)cap * sizeof(*grown));
+    if (!grown)
+      return false;
+    b->unmanaged_configs = grown;
+    b->unmanaged_configs_cap = cap;
+  }
+  b->unmanaged_configs[b->unmanaged_configs_len++] = *pc;
+  return true;
+}
+
+/*
+ * Client messages whose effect is absolute (a desktop, a geometry, an ADD or
+ * REMOVE of one state pair, an activation) only matter as the last of a
+ * burst. a and b are what two such messages must share besides window and
+ * type to stand for each other. Toggles and everything else keep every copy.
+ */
+static bool client_message_coalescable(const xcb_client_message_event_t* e, uint32_t* a, uint32_t* b) {
+  if (e->format != 32)
+    return false;
+  const uint32_t* d = e->data.data32;
+  *a = 0;
+  *b = 0;
+  if (e->type == atoms._NET_WM_DESKTOP || e->type == atoms._NET_CURRENT_DESKTOP)
+    return true;
+  if (e->type == atoms._NET_ACTIVE_WINDOW || e->type == atoms._NET_MOVERESIZE_WINDOW) {
+    *a = d[0];  // source; or gravity, flags and source
+    return true;
   }
+  if (e->type == atoms._NET_WM_STATE && d[0] <= 1u) {
+    *a = d[1];
+    *b = d[2];
+    return true;
+  }
+  return false;
+}
 
-  if (!loaded && home) {
-    snprintf(path, sizeof(path), "%s/.config/hxm/menu.conf", home);
-    loaded = menu_load_config(s, path);
+/*
+ * Queue a client message, dropping the earlier copy it supersedes. The copy
+ * is only dropped when no other message for the same window came after it,
+ * so a toggle, or a message of another type that could depend on it, keeps
+ * the order intact; across windows only the last copy's position counts.
+ */
+static void client_message_push(event_buckets_t* b, xcb_client_message_event_t* e) {
+  uint32_t a, c;
+  if (client_message_coalescable(e, &a, &c)) {
+    uint32_t mix = e->type * 0x9E3779B1u ^ a * 0x85EBCA77u ^ c * 0xC2B2AE3Du;
+    uint64_t key = ((uint64_t)e->window << 32) | mix;
+    uintptr_t prev = (uintptr_t)epoch_map_get(&b->client_message_keys, key);
+    uintptr_t last = (uintptr_t)epoch_map_get(&b->client_message_last, e->window);
+    xcb_client_message_event_t* old = (prev && prev == last) ? b->client_messages.items[prev - 1] : NULL;
+    uint32_t oa, oc;
+    if (old && old->type == e->type && client_message_coalescable(old, &oa, &oc) && oa == a && oc == c) {
+      b->client_messages.items[prev - 1] = NULL;
+      b->client_messages_dropped++;
+      b->coalesced++;
+      HXM_COUNTER_COALESCED_DROP(XCB_CLIENT_MESSAGE);
+    }
+    epoch_map_insert(&b->client_message_keys, key, (void*)(uintptr_t)(b->client_messages.length + 1));
   }
+  epoch_map_insert(&b->client_message_last, e->window, (void*)(uintptr_t)(b->client_messages.length + 1));
+  small_vec_push(&b->client_messages, e);
+}
 
-  if (!loaded) {
-    loaded = menu_load_config(s, "/etc/hxm/menu.conf");
+/*
+ * A held binding auto-repeats at the keyboard rate, and each repeat would
+ * run its action once: a held workspace_next switches desktops, with all
+ * the mapping that takes, for every repeat. Repeats are marked here, while
+ * presses and releases are still in order, and a repeat of the chord the
+ * previous press already repeated is folded into it, so the tick runs the
+ * action once for N steps (see wm_handle_key_run).
+ */
+static void key_press_push(server_t* s, xcb_key_press_event_t* e) {
+  key_repeat_t* kr = &s->key_repeat;
+  event_buckets_t* b = &s->buckets;
+  // Keycodes start at 8: 0 is "none"
+  bool repeat = e->detail != 0 && (e->detail == kr->held || (!kr->detectable && e->detail == kr->released && e->time == kr->released_time));
+  kr->held = e->detail;
+  if (!repeat) {
+    small_vec_push(&b->key_presses, e);
+    return;
   }
 
-  if (!loaded && access("data/menu.conf", R_OK) == 0) {
-    loaded = menu_load_config(s, "data/menu.conf");
+  kr->repeats++;
+  size_t n = b->key_presses.length;
+  xcb_key_press_event_t* last = n ? b->key_presses.items[n - 1] : NULL;
+  uintptr_t count = last ? (uintptr_t)epoch_map_get(&b->key_repeats, (uintptr_t)last) : 0;
+  if (count && last->detail == e->detail && last->state == e->state) {
+    epoch_map_insert(&b->key_repeats, (uintptr_t)last, (void*)(count + 1));
+    kr->folded++;
+    b->coalesced++;
+    return;
   }
+  epoch_map_insert(&b->key_repeats, (uintptr_t)e, (void*)(uintptr_t)1);
+  small_vec_push(&b->key_presses, e);
+}
+
+static void key_release_push(server_t* s, xcb_key_release_event_t* e) {
+  key_repeat_t* kr = &s->key_repeat;
+  if (e->detail == kr->held)
+    kr->held = 0;
+  kr->released = e->detail;
+  kr->released_time = e->time;
+  small_vec_push(&s->buckets.key_releases, e);
+}
 
-  if (!loaded && access("../data/menu.conf", R_OK) == 0) {
-    loaded = menu_load_config(s, "../data/menu.conf");
+// Returns true when the request merged into a pending entry
+static bool unmanaged_config_push(event_buckets_t* b, const xcb_configure_request_event_t* e) {
+  uint32_t n = b->unmanaged_configs_len;
+  uint32_t lo = n > UNMANAGED_CONFIG_MERGE_SCAN ? n - UNMANAGED_CONFIG_MERGE_SCAN : 0;
+  for (uint32_t i = n; i-- > lo;) {
+    pending_config_t* pc = &b->unmanaged_configs[i];
+    if (pc->window == e->window && pc->mask != 0) {
+      pending_config_merge(pc, e);
+      b->unmanaged_coalesced++;
+      return true;
+    }
   }
 
-  if (!loaded) {
-    LOG_WARN("Menu config not found; menu will be empty");
+  pending_config_t pc = {.window = e->window};
+  pending_config_merge(&pc, e);
+  if (!unmanaged_config_append(b, &pc))
+    LOG_WARN("dropping configure_request for unmanaged win=%u: out of memory", e->window);
+  return false;
+}
+
+static void unmanaged_config_drop(event_buckets_t* b, xcb_window_t win) {
+  for (uint32_t i = 0; i < b->unmanaged_configs_len; i++) {
+    if (b->unmanaged_configs[i].window == win)
+      b->unmanaged_configs[i].mask = 0;
   }
 }
 
@@ -659,21 +1223,19 @@ static void buckets_reset(event_buckets_t* b) {
   small_vec_clear(&b->button_events);
   small_vec_clear(&b->client_messages);
 
-  // Reuse hash map storage across ticks to avoid allocator churn.
-  bucket_clear_map_touched(&b->expose_regions, &b->expose_region_keys);
-  small_vec_clear(&b->expose_region_keys);
-  bucket_clear_map_touched(&b->configure_requests, &b->configure_request_keys);
-  small_vec_clear(&b->configure_request_keys);
-  bucket_clear_map_touched(&b->configure_notifies, &b->configure_notify_keys);
-  small_vec_clear(&b->configure_notify_keys);
-  bucket_clear_map_touched(&b->destroyed_windows, &b->destroyed_window_keys);
-  small_vec_clear(&b->destroyed_window_keys);
-  bucket_clear_map_touched(&b->property_notifies, &b->property_notify_keys);
-  small_vec_clear(&b->property_notify_keys);
-  bucket_clear_map_touched(&b->motion_notifies, &b->motion_notify_keys);
-  small_vec_clear(&b->motion_notify_keys);
-  bucket_clear_map_touched(&b->damage_regions, &b->damage_region_keys);
-  small_vec_clear(&b->damage_region_keys);
+  // Epoch bump: storage is kept and nothing is walked, however large a past
+  // storm made the maps.
+  epoch_map_clear(&b->expose_regions);
+  epoch_map_clear(&b->configure_requests);
+  epoch_map_clear(&b->client_message_keys);
+  epoch_map_clear(&b->client_message_last);
+  epoch_map_clear(&b->key_repeats);
+  b->unmanaged_configs_len = 0;
+  epoch_map_clear(&b->configure_notifies);
+  epoch_map_clear(&b->destroyed_windows);
+  epoch_map_clear(&b->property_notifies);
+  epoch_map_clear(&b->motion_notifies);
+  epoch_map_clear(&b->damage_regions);
 
   b->pointer_notify.enter_valid = false;
   b->pointer_notify.leave_valid = false;
@@ -681,73 +1243,14 @@ static void buckets_reset(event_buckets_t* b) {
   b->focus_notify.out_valid = false;
 
   b->randr_dirty = false;
-  b->randr_width = 0;
-  b->randr_height = 0;
+  b->randr_screens = 0;
+
+  b->keymap_dirty = false;
 
   b->ingested = 0;
   b->coalesced = 0;
 }
 
-static void bucket_clear_map_touched(hash_map_t* map, small_vec_t* keys) {
-  if (!map || map->size == 0)
-    return;
-  if (!keys || keys->length == 0) {
-    hash_map_clear(map);
-    return;
-  }
-
-  for (size_t i = 0; i < keys->length && map->size > 0; i++) {
-    const uint64_t* touched = (const uint64_t*)keys->items[i];
-    if (!touched || *touched == 0)
-      continue;
-    hash_map_remove(map, *touched);
-  }
-
-  // Fallback safety for stale/missing key tracking.
-  if (map->size > 0) {
-    hash_map_clear(map);
-  }
-}
-
-static void bucket_track_key(server_t* s, small_vec_t* keys, uint64_t key) {
-  uint64_t* key_copy = arena_alloc(&s->tick_arena, sizeof(*key_copy));
-  *key_copy = key;
-  small_vec_push(keys, key_copy);
-}
-
-static bool bucket_iter_next(const hash_map_t* map, const small_vec_t* keys, bucket_iter_t* it, uint64_t* key, void** value) {
-  if (!it || !key || !value)
-    return false;
-
-  if (keys && keys->length > 0) {
-    while (it->cursor < keys->length) {
-      const uint64_t* touched = (const uint64_t*)keys->items[it->cursor++];
-      if (!touched)
-        continue;
-      void* v = hash_map_get(map, *touched);
-      if (!v)
-        continue;
-      *key = *touched;
-      *value = v;
-      return true;
-    }
-    return false;
-  }
-
-  if (!map || !map->entries || map->capacity == 0)
-    return false;
-
-  while (it->cursor < map->capacity) {
-    const hash_map_entry_t* entry = &map->entries[it->cursor++];
-    if (entry->key == 0)
-      continue;
-    *key = entry->key;
-    *value = entry->value;
-    return true;
-  }
-  return false;
-}
-
 static void server_apply_snap_config(server_t* s) {
   if (!s)
     return;
@@ -758,6 +1261,14 @@ static void server_apply_snap_config(server_t* s) {
     threshold = 24;
   s->snap_threshold_px = threshold;
 
+  s->snap_layout = (snap_layout_t){
+      .threshold_px = (int)threshold,
+      .corner_px = (int)s->config.snap_corner_px,
+      .split_pct = s->config.snap_split_percent,
+      .top_maximize = s->config.snap_top_maximize,
+  };
+  s->snap_edge_resistance_px = s->config.snap_edge_resistance_px;
+
   uint32_t border_px = s->config.snap_preview_border_px;
   if (border_px == 0)
     border_px = 2;
@@ -807,10 +1318,7 @@ static bool focus_out_indicates_loss(uint8_t detail) {
 }
 
 static handle_t focus_handle_from_event_window(server_t* s, xcb_window_t win) {
-  handle_t h = server_get_client_by_window(s, win);
-  if (h == HANDLE_INVALID)
-    h = server_get_client_by_frame(s, win);
-  return h;
+  return server_get_client_by_any(s, win);
 }
 
 static void event_reduce_focus(server_t* s) {
@@ -823,6 +1331,7 @@ static void event_reduce_focus(server_t* s) {
     bool valid;
     handle_t target;
     uint16_t sequence;
+    xcb_window_t confirmed; /* FocusIn window the server already focused */
   } focus_decision_t;
 
   focus_decision_t in_decision = {0};
@@ -834,16 +1343,18 @@ static void event_reduce_focus(server_t* s) {
       handle_t h = focus_handle_from_event_window(s, ev->event);
       if (h != HANDLE_INVALID) {
         client_hot_t* hot = server_chot(s, h);
-        if (hot && hot->state == STATE_MAPPED && !hash_map_get(&s->buckets.destroyed_windows, hot->xid)) {
+        if (hot && hot->state == STATE_MAPPED && !epoch_map_get(&s->buckets.destroyed_windows, hot->xid)) {
           in_decision.valid = true;
           in_decision.target = h;
           in_decision.sequence = ev->sequence;
+          in_decision.confirmed = ev->event;
         }
       }
-      else if (ev->event == s->root || ev->event == XCB_NONE) {
+      else if (server_screen_of_root(s, ev->event) || ev->event == XCB_NONE) {
         in_decision.valid = true;
         in_decision.target = HANDLE_INVALID;
         in_decision.sequence = ev->sequence;
+        in_decision.confirmed = ev->event;
       }
     }
   }
@@ -854,7 +1365,7 @@ static void event_reduce_focus(server_t* s) {
         x11_seq_after_or_equal_u16(ev->sequence, s->last_focus_sequence)) {
       handle_t out_h = focus_handle_from_event_window(s, ev->event);
       bool from_focused_client = (out_h != HANDLE_INVALID && out_h == s->focused_client);
-      bool from_root = (ev->event == s->root);
+      bool from_root = server_screen_of_root(s, ev->event) != NULL;
       if (from_focused_client || from_root) {
         out_decision.valid = true;
         out_decision.target = HANDLE_INVALID;
@@ -882,12 +1393,103 @@ static void event_reduce_focus(server_t* s) {
 
   if (decision.target != HANDLE_INVALID) {
     client_hot_t* hot = server_chot(s, decision.target);
-    if (!hot || hot->state != STATE_MAPPED || hash_map_get(&s->buckets.destroyed_windows, hot->xid))
+    if (!hot || hot->state != STATE_MAPPED || epoch_map_get(&s->buckets.destroyed_windows, hot->xid))
       return;
   }
 
   s->last_focus_sequence = decision.sequence;
   wm_set_focus(s, decision.target);
+
+  // The server already has focus where the flush would put it; committing it
+  // again would only echo SetInputFocus and WM_TAKE_FOCUS back at the client.
+  // The colormap is still ours to install.
+  if (decision.confirmed != XCB_NONE && decision.confirmed != s->committed_focus) {
+    client_hot_t* hot = server_chot(s, s->focused_client);
+    bool mapped = hot && hot->state == STATE_MAPPED;
+    xcb_window_t want = mapped ? hot->xid : server_screen(s)->root;
+    if (decision.confirmed == want) {
+      wm_colormap_request(s);
+      s->committed_focus = want;
+    }
+  }
+}
+
+/*
+ * True when the pointer crossed into ev slower than focus_hover_speed, going
+ * by the distance and X time since the previous crossing. A gap longer than
+ * the hover delay says nothing about travel speed (the pointer may have
+ * rested), so it never counts as slow.
+ */
+static bool pointer_crossing_is_slow(const server_t* s, const xcb_enter_notify_event_t* ev) {
+  uint32_t speed = s->config.focus_hover_speed;
+  if (speed == 0 || s->hover_time == 0)
+    return false;
+  uint32_t dt = ev->time - s->hover_time;
+  if (dt == 0 || dt > s->config.focus_hover_delay_ms)
+    return false;
+
+  int64_t dx = (int64_t)ev->root_x - s->hover_x;
+  int64_t dy = (int64_t)ev->root_y - s->hover_y;
+  int64_t reach = (int64_t)speed * dt / 1000;
+  return dx * dx + dy * dy < reach * reach;
+}
+
+/* Cookie expiry is coarse; let it ride along with other wakeups */
+#define COOKIE_TIMER_SLACK_NS 20000000u
+
+/* Hover focus may land this much after focus_hover_delay_ms to share a wakeup */
+#define HOVER_TIMER_SLACK_NS 2000000u
+
+/* Arm t with fn; tests hand in zeroed servers, so fn is set on every arm */
+static void event_arm_timer(server_t* s, wheel_timer_t* t, wheel_timer_fn fn, uint64_t deadline_ns, uint64_t slack_ns) {
+  t->fn = fn;
+  timer_wheel_add(&s->timers, t, deadline_ns, slack_ns);
+}
+
+static void focus_boost_fired(wheel_timer_t* t, void* ctx) {
+  (void)t;
+  server_t* s = (server_t*)ctx;
+  pid_t pid = 0;
+  client_hot_t* hot = server_chot(s, s->focused_client);
+  client_cold_t* cold = hot ? server_ccold(s, s->focused_client) : NULL;
+  if (cold && client_pid_local(cold))
+    pid = (pid_t)cold->pid;
+  if (pid == s->focus_boost_pid)
+    return;
+  s->focus_boost_pid = pid;
+  cgroup_worker_post(&s->cgroup_worker, pid);
+}
+
+void server_focus_boost_note(server_t* s) {
+  if (!s->cgroup_worker.running)
+    return;
+  // Every commit pushes the deadline out: Alt-Tab cycling posts only where it stops
+  uint64_t delay = (uint64_t)s->config.focus_boost_delay_ms * 1000000u;
+  event_arm_timer(s, &s->focus_boost_timer, focus_boost_fired, monotonic_time_ns() + delay, delay / 4u);
+}
+
+/* Focus the hover target once the pointer has rested on it long enough */
+static void event_commit_hover_focus(server_t* s) {
+  if (s->hover_target == HANDLE_INVALID || monotonic_time_ns() < s->hover_deadline)
+    return;
+
+  handle_t target = s->hover_target;
+  s->hover_target = HANDLE_INVALID;
+  client_hot_t* hot = server_chot(s, target);
+  if (!hot || hot->state != STATE_MAPPED || target == s->focused_client)
+    return;
+  wm_set_focus(s, target);
+}
+
+static void event_hover_timer_fired(wheel_timer_t* t, void* ctx) {
+  (void)t;
+  event_commit_hover_focus((server_t*)ctx);
+}
+
+/* Forget the hover target; its timer would only wake the loop for nothing */
+static void event_drop_hover(server_t* s) {
+  s->hover_target = HANDLE_INVALID;
+  timer_wheel_cancel(&s->timers, &s->hover_timer);
 }
 
 static void event_reduce_pointer_hints(server_t* s) {
@@ -903,10 +1505,10 @@ static void event_reduce_pointer_hints(server_t* s) {
   }
   s->last_pointer_hint_time = newest;
 
-  if (!s->config.focus_follows_mouse)
-    return;
-  if (s->interaction_mode != INTERACTION_NONE)
+  if (!s->config.focus_follows_mouse || s->interaction_mode != INTERACTION_NONE) {
+    event_drop_hover(s);
     return;
+  }
   if (!s->buckets.pointer_notify.enter_valid)
     return;
 
@@ -916,68 +1518,236 @@ static void event_reduce_pointer_hints(server_t* s) {
   if (!pointer_mode_is_authoritative(ev->mode) || pointer_enter_detail_is_noise(ev->detail))
     return;
 
+  bool slow = pointer_crossing_is_slow(s, ev);
+  server_screen_enter(s, ev->root);
+  s->hover_time = ev->time;
+  s->hover_x = ev->root_x;
+  s->hover_y = ev->root_y;
+
+  // Whatever the pointer entered now, it is no longer resting on the old target
   handle_t target = focus_handle_from_event_window(s, ev->event);
+  if (target != s->hover_target)
+    event_drop_hover(s);
   if (target == HANDLE_INVALID || target == s->focused_client)
     return;
 
   client_hot_t* hot = server_chot(s, target);
   if (!hot || hot->state != STATE_MAPPED)
     return;
-  if (hash_map_get(&s->buckets.destroyed_windows, hot->xid))
+  if (epoch_map_get(&s->buckets.destroyed_windows, hot->xid))
     return;
 
-  wm_set_focus(s, target);
+  uint32_t delay = s->config.focus_hover_delay_ms;
+  if (delay == 0 || slow) {
+    event_drop_hover(s);
+    wm_set_focus(s, target);
+    return;
+  }
+
+  // Passing over a window only arms a deadline; event_commit_hover_focus acts
+  // on it when the hover timer fires
+  if (s->hover_target == HANDLE_INVALID) {
+    s->hover_target = target;
+    s->hover_deadline = monotonic_time_ns() + (uint64_t)delay * 1000000u;
+    event_arm_timer(s, &s->hover_timer, event_hover_timer_fired, s->hover_deadline, HOVER_TIMER_SLACK_NS);
+  }
 }
 
-void event_ingest(server_t* s, bool x_ready) {
-  buckets_reset(&s->buckets);
-  arena_reset(&s->tick_arena);
+void event_ring_init(event_ring_t* r, uint32_t cap) {
+  r->slots = NULL;
+  r->cap = 0;
+  r->used = 0;
+  if (cap == 0)
+    return;
 
-  if (x_ready) {
-    cookie_jar_mark_replies_may_exist(&s->cookie_jar);
+  r->slots = malloc((size_t)cap * sizeof(*r->slots));
+  if (!r->slots) {
+    LOG_ERROR("event_ring_init failed");
+    exit(1);
   }
+  r->cap = cap;
+}
 
-  uint64_t count = 0;
-  if (s->prefetched_event) {
-    uint64_t before = s->buckets.coalesced;
-    event_ingest_one(s, s->prefetched_event);
-    s->prefetched_event = NULL;
-    if (s->buckets.coalesced == before)
-      count++;
+void event_ring_destroy(event_ring_t* r) {
+  free(r->slots);
+  r->slots = NULL;
+  r->cap = 0;
+  r->used = 0;
+}
+
+/*
+ * Copy a libxcb event into tick-lifetime storage and release the original.
+ * Only the 32-byte wire packet is kept (libxcb's trailing full_sequence and
+ * any GenericEvent payload are dropped; neither is consumed here).
+ */
+static xcb_generic_event_t* event_stage(server_t* s, xcb_generic_event_t* ev) {
+  xi2_event_to_core(s, ev);
+  if (event_trace_recording())
+    event_trace_event(ev);
+
+  event_ring_t* r = &s->event_ring;
+  void* slot;
+  if (r->used < r->cap)
+    slot = &r->slots[r->used++];
+  else
+    slot = arena_alloc(&s->tick_arena, sizeof(event_slot_t));
+
+  memcpy(slot, ev, EVENT_SLOT_BYTES);
+  free(ev);
+  return (xcb_generic_event_t*)slot;
+}
+
+static bool event_is_motion_run(const xcb_generic_event_t* ev, const xcb_generic_event_t* next) {
+  if ((ev->response_type & ~0x80) != XCB_MOTION_NOTIFY || (next->response_type & ~0x80) != XCB_MOTION_NOTIFY)
+    return false;
+  return ((const xcb_motion_notify_event_t*)ev)->event == ((const xcb_motion_notify_event_t*)next)->event;
+}
+
+typedef xcb_generic_event_t* (*event_poll_fn)(server_t* s);
+
+static xcb_generic_event_t* event_poll_queued(server_t* s) {
+  return xcb_poll_for_queued_event(s->conn);
+}
+
+static xcb_generic_event_t* event_poll_socket(server_t* s) {
+  return xcb_poll_for_event(s->conn);
+}
+
+static xcb_generic_event_t* event_poll_reader(server_t* s) {
+  return x_reader_pop(&s->x_reader);
+}
+
+/*
+ * Drain up to `want` events from poll into the ring in one tight loop, then
+ * coalesce the staged batch. Returns the number of events that survived
+ * coalescing; *empty is set when poll ran dry.
+ */
+static uint64_t event_ingest_batch(server_t* s, event_poll_fn poll, uint64_t want, bool* empty) {
+  event_ring_t* r = &s->event_ring;
+  *empty = false;
+
+  uint32_t space = r->cap - r->used;
+  if (space == 0) {
+    // Ring exhausted this tick: stage one at a time into tick_arena
+    xcb_generic_event_t* ev = poll(s);
+    if (!ev) {
+      *empty = true;
+      return 0;
+    }
+    uint64_t before = s->buckets.coalesced;
+    event_ingest_one(s, ev);
+    return (s->buckets.coalesced == before) ? 1u : 0u;
   }
+  if (want > space)
+    want = space;
 
-  while (count < MAX_EVENTS_PER_TICK) {
-    xcb_generic_event_t* ev = xcb_poll_for_queued_event(s->conn);
-    if (!ev)
+  uint32_t first = r->used;
+  uint32_t n = 0;
+  while (n < want) {
+    xcb_generic_event_t* ev = poll(s);
+    if (!ev) {
+      *empty = true;
       break;
+    }
+    // XI2 events are longer than a slot; rewrite them while whole
+    xi2_event_to_core(s, ev);
+    if (event_trace_recording())
+      event_trace_event(ev);
+    memcpy(&r->slots[first + n], ev, EVENT_SLOT_BYTES);
+    free(ev);
+    n++;
+  }
+  r->used += n;
+
+  uint64_t kept = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    xcb_generic_event_t* ev = (xcb_generic_event_t*)&r->slots[first + i];
+
+    // Back-to-back motion for one window: the later event supersedes this
+    // one, skip it without touching the motion bucket
+    if (i + 1 < n && event_is_motion_run(ev, (xcb_generic_event_t*)&r->slots[first + i + 1])) {
+      HXM_COUNTER_EVENT_SEEN(XCB_MOTION_NOTIFY);
+      HXM_COUNTER_COALESCED_DROP(XCB_MOTION_NOTIFY);
+      s->buckets.coalesced++;
+      continue;
+    }
+
     uint64_t before = s->buckets.coalesced;
-    event_ingest_one(s, ev);
+    event_coalesce(s, ev);
     if (s->buckets.coalesced == before)
-      count++;
+      kept++;
   }
+  if (n > 0)
+    cookie_jar_mark_replies_may_exist(&s->cookie_jar);
 
-  bool can_read_socket = x_ready && (s->x_fd_ready || s->is_test || s->epoll_fd <= 0);
-  if (!can_read_socket) {
-    s->x_poll_immediate = (count >= MAX_EVENTS_PER_TICK);
-    s->buckets.ingested = count;
-    return;
+  return kept;
+}
+
+static void event_ingest_done(server_t* s, uint64_t count, uint64_t budget) {
+  s->x_poll_immediate = (count >= budget);
+  s->buckets.ingested = count;
+  s->tick_budget.events_used = (uint32_t)count;
+}
+
+void event_ingest(server_t* s, bool x_ready) {
+  buckets_reset(&s->buckets);
+  arena_reset(&s->tick_arena);
+  s->event_ring.used = 0;
+  if (event_trace_recording())
+    event_trace_tick(monotonic_time_ns());
+
+  if (x_ready) {
+    cookie_jar_mark_replies_may_exist(&s->cookie_jar);
   }
 
-  while (count < MAX_EVENTS_PER_TICK) {
-    xcb_generic_event_t* ev = xcb_poll_for_event(s->conn);
-    if (!ev)
-      break;
+  const uint64_t budget = tick_budget_events(&s->tick_budget);
+  uint64_t count = 0;
+  if (s->prefetched_event) {
     uint64_t before = s->buckets.coalesced;
-    event_ingest_one(s, ev);
+    event_ingest_one(s, s->prefetched_event);
+    s->prefetched_event = NULL;
     if (s->buckets.coalesced == before)
       count++;
   }
 
-  s->x_poll_immediate = (count >= MAX_EVENTS_PER_TICK);
-  s->buckets.ingested = count;
+  bool empty = false;
+  if (x_reader_active(&s->x_reader)) {
+    // What the input thread read precedes anything still inside libxcb
+    while (count < budget && !empty)
+      count += event_ingest_batch(s, event_poll_reader, budget - count, &empty);
+    if (s->x_reader.running || !empty) {
+      event_ingest_done(s, count, budget);
+      return;
+    }
+    empty = false;
+  }
+
+  while (count < budget && !empty)
+    count += event_ingest_batch(s, event_poll_queued, budget - count, &empty);
+
+  bool can_read_socket = x_ready && (s->x_fd_ready || s->is_test || s->epoll_fd <= 0);
+  if (!can_read_socket) {
+    event_ingest_done(s, count, budget);
+    return;
+  }
+
+  empty = false;
+  while (count < budget && !empty)
+    count += event_ingest_batch(s, event_poll_socket, budget - count, &empty);
+
+  event_ingest_done(s, count, budget);
 }
 
 static void event_ingest_one(server_t* s, xcb_generic_event_t* ev) {
+  event_coalesce(s, event_stage(s, ev));
+}
+
+/*
+ * Fold one staged event into the tick buckets.
+ * ev lives in the event ring (or tick_arena) until the next event_ingest, so
+ * buckets may keep the pointer itself instead of a copy.
+ */
+static void event_coalesce(server_t* s, xcb_generic_event_t* ev) {
   cookie_jar_mark_replies_may_exist(&s->cookie_jar);
 
   uint8_t type = ev->response_type & ~0x80;
@@ -985,95 +1755,91 @@ static void event_ingest_one(server_t* s, xcb_generic_event_t* ev) {
 
   if (s->damage_supported && type == (uint8_t)(s->damage_event_base + XCB_DAMAGE_NOTIFY)) {
     xcb_damage_notify_event_t* e = (xcb_damage_notify_event_t*)ev;
-    dirty_region_t* region = hash_map_get(&s->buckets.damage_regions, e->drawable);
+    dirty_rects_t* region = epoch_map_get(&s->buckets.damage_regions, e->drawable);
     if (region) {
-      dirty_region_union_rect(region, e->area.x, e->area.y, e->area.width, e->area.height);
+      dirty_rects_add(region, e->area.x, e->area.y, e->area.width, e->area.height);
       HXM_COUNTER_COALESCED_DROP(type);
       s->buckets.coalesced++;
       TRACE_LOG("coalesce damage drawable=%u area=%dx%d+%d+%d", e->drawable, e->area.width, e->area.height, e->area.x, e->area.y);
     }
     else {
-      dirty_region_t* copy = arena_alloc(&s->tick_arena, sizeof(*copy));
-      *copy = dirty_region_make(e->area.x, e->area.y, e->area.width, e->area.height);
-      hash_map_insert(&s->buckets.damage_regions, e->drawable, copy);
-      bucket_track_key(s, &s->buckets.damage_region_keys, (uint64_t)e->drawable);
+      dirty_rects_t* copy = arena_alloc(&s->tick_arena, sizeof(*copy));
+      *copy = dirty_rects_make(e->area.x, e->area.y, e->area.width, e->area.height);
+      epoch_map_insert(&s->buckets.damage_regions, e->drawable, copy);
     }
-    free(ev);
     return;
   }
 
   if (s->randr_supported && type == (uint8_t)(s->randr_event_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY)) {
     xcb_randr_screen_change_notify_event_t* e = (xcb_randr_screen_change_notify_event_t*)ev;
-    if (s->buckets.randr_dirty) {
+    screen_t* scr = server_screen_of_root(s, e->root);
+    if (!scr)
+      return;
+    uint32_t i = server_screen_index(s, scr);
+    if (s->buckets.randr_screens & (1u << i)) {
       HXM_COUNTER_COALESCED_DROP(type);
       s->buckets.coalesced++;
     }
     s->buckets.randr_dirty = true;
-    s->buckets.randr_width = e->width;
-    s->buckets.randr_height = e->height;
-    TRACE_LOG("coalesce randr notify width=%u height=%u", e->width, e->height);
+    s->buckets.randr_screens |= (uint8_t)(1u << i);
+    s->buckets.randr_width[i] = e->width;
+    s->buckets.randr_height[i] = e->height;
+    TRACE_LOG("coalesce randr notify screen=%u width=%u height=%u", i, e->width, e->height);
+    return;
+  }
 
-    free(ev);
+  if (s->sync_supported && type == (uint8_t)(s->sync_event_base + XCB_SYNC_ALARM_NOTIFY)) {
+    // Only opens the resize gate; the commit itself happens in the flush
+    wm_handle_sync_alarm(s, (xcb_sync_alarm_notify_event_t*)ev);
     return;
   }
 
+  // Root structure changes feed the compositor's window list before coalescing
+  compositor_observe(s, ev);
+
   switch (type) {
     case XCB_EXPOSE: {
       xcb_expose_event_t* e = (xcb_expose_event_t*)ev;
-      dirty_region_t* region = hash_map_get(&s->buckets.expose_regions, e->window);
+      dirty_rects_t* region = epoch_map_get(&s->buckets.expose_regions, e->window);
       if (region) {
-        dirty_region_union_rect(region, e->x, e->y, e->width, e->height);
+        dirty_rects_add(region, e->x, e->y, e->width, e->height);
         HXM_COUNTER_COALESCED_DROP(type);
         s->buckets.coalesced++;
       }
       else {
-        dirty_region_t* copy = arena_alloc(&s->tick_arena, sizeof(*copy));
-        *copy = dirty_region_make(e->x, e->y, e->width, e->height);
-        hash_map_insert(&s->buckets.expose_regions, e->window, copy);
-        bucket_track_key(s, &s->buckets.expose_region_keys, (uint64_t)e->window);
+        dirty_rects_t* copy = arena_alloc(&s->tick_arena, sizeof(*copy));
+        *copy = dirty_rects_make(e->x, e->y, e->width, e->height);
+        epoch_map_insert(&s->buckets.expose_regions, e->window, copy);
       }
       break;
     }
 
     case XCB_BUTTON_PRESS:
     case XCB_BUTTON_RELEASE: {
-      size_t sz = (type == XCB_BUTTON_PRESS) ? sizeof(xcb_button_press_event_t) : sizeof(xcb_button_release_event_t);
-      void* copy = arena_alloc(&s->tick_arena, sz);
-      memcpy(copy, ev, sz);
-      small_vec_push(&s->buckets.button_events, copy);
+      small_vec_push(&s->buckets.button_events, ev);
       break;
     }
 
     case XCB_CLIENT_MESSAGE: {
       xcb_client_message_event_t* e = (xcb_client_message_event_t*)ev;
       TRACE_LOG("ingest client_message win=%u type=%u format=%u", e->window, e->type, e->format);
-      void* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      memcpy(copy, e, sizeof(*e));
-      small_vec_push(&s->buckets.client_messages, copy);
+      client_message_push(&s->buckets, e);
       break;
     }
 
     case XCB_KEY_PRESS: {
-      xcb_key_press_event_t* e = (xcb_key_press_event_t*)ev;
-      void* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      memcpy(copy, e, sizeof(*e));
-      small_vec_push(&s->buckets.key_presses, copy);
+      key_press_push(s, (xcb_key_press_event_t*)ev);
       break;
     }
     case XCB_KEY_RELEASE: {
-      xcb_key_release_event_t* e = (xcb_key_release_event_t*)ev;
-      void* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      memcpy(copy, e, sizeof(*e));
-      small_vec_push(&s->buckets.key_releases, copy);
+      key_release_push(s, (xcb_key_release_event_t*)ev);
       break;
     }
 
     case XCB_MAP_REQUEST: {
       xcb_map_request_event_t* e = (xcb_map_request_event_t*)ev;
       TRACE_LOG("ingest map_request win=%u parent=%u", e->window, e->parent);
-      void* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      memcpy(copy, e, sizeof(*e));
-      small_vec_push(&s->buckets.map_requests, copy);
+      small_vec_push(&s->buckets.map_requests, e);
       break;
     }
 
@@ -1100,9 +1866,7 @@ static void event_ingest_one(server_t* s, xcb_generic_event_t* ev) {
     case XCB_UNMAP_NOTIFY: {
       xcb_unmap_notify_event_t* e = (xcb_unmap_notify_event_t*)ev;
       TRACE_LOG("ingest unmap_notify win=%u event=%u from_configure=%u", e->window, e->event, e->from_configure);
-      void* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      memcpy(copy, e, sizeof(*e));
-      small_vec_push(&s->buckets.unmap_notifies, copy);
+      small_vec_push(&s->buckets.unmap_notifies, e);
       break;
     }
 
@@ -1110,82 +1874,65 @@ static void event_ingest_one(server_t* s, xcb_generic_event_t* ev) {
       xcb_destroy_notify_event_t* e = (xcb_destroy_notify_event_t*)ev;
       TRACE_LOG("ingest destroy_notify win=%u event=%u", e->window, e->event);
 
-      bool existed = hash_map_insert(&s->buckets.destroyed_windows, e->window, (void*)1);
-      if (!existed)
-        bucket_track_key(s, &s->buckets.destroyed_window_keys, (uint64_t)e->window);
-      hash_map_remove(&s->buckets.configure_requests, e->window);
+      epoch_map_insert(&s->buckets.destroyed_windows, e->window, (void*)1);
+      epoch_map_remove(&s->buckets.configure_requests, e->window);
+      unmanaged_config_drop(&s->buckets, e->window);
 
-      void* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      memcpy(copy, e, sizeof(*e));
-      small_vec_push(&s->buckets.destroy_notifies, copy);
+      small_vec_push(&s->buckets.destroy_notifies, e);
       break;
     }
 
     case XCB_CONFIGURE_REQUEST: {
       xcb_configure_request_event_t* e = (xcb_configure_request_event_t*)ev;
 
-      pending_config_t* existing = hash_map_get(&s->buckets.configure_requests, e->window);
+      if (server_get_client_by_window(s, e->window) == HANDLE_INVALID) {
+        TRACE_LOG("ingest unmanaged configure_request win=%u mask=0x%x", e->window, e->value_mask);
+        if (unmanaged_config_push(&s->buckets, e)) {
+          HXM_COUNTER_COALESCED_DROP(type);
+          s->buckets.coalesced++;
+        }
+        break;
+      }
+
+      pending_config_t* existing = epoch_map_get(&s->buckets.configure_requests, e->window);
       if (existing) {
         TRACE_LOG("coalesce configure_request win=%u mask=0x%x", e->window, e->value_mask);
-        if (e->value_mask & XCB_CONFIG_WINDOW_X)
-          existing->x = e->x;
-        if (e->value_mask & XCB_CONFIG_WINDOW_Y)
-          existing->y = e->y;
-        if (e->value_mask & XCB_CONFIG_WINDOW_WIDTH)
-          existing->width = e->width;
-        if (e->value_mask & XCB_CONFIG_WINDOW_HEIGHT)
-          existing->height = e->height;
-        if (e->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
-          existing->border_width = e->border_width;
-        if (e->value_mask & XCB_CONFIG_WINDOW_SIBLING)
-          existing->sibling = e->sibling;
-        if (e->value_mask & XCB_CONFIG_WINDOW_STACK_MODE)
-          existing->stack_mode = e->stack_mode;
-
-        existing->mask |= e->value_mask;
+        pending_config_merge(existing, e);
         HXM_COUNTER_COALESCED_DROP(type);
         s->buckets.coalesced++;
       }
       else {
         TRACE_LOG("ingest configure_request win=%u mask=0x%x", e->window, e->value_mask);
         pending_config_t* pc = arena_alloc(&s->tick_arena, sizeof(*pc));
-        pc->window = e->window;
-        pc->x = e->x;
-        pc->y = e->y;
-        pc->width = e->width;
-        pc->height = e->height;
-        pc->border_width = e->border_width;
-        pc->sibling = e->sibling;
-        pc->stack_mode = e->stack_mode;
-        pc->mask = e->value_mask;
-        hash_map_insert(&s->buckets.configure_requests, e->window, pc);
-        bucket_track_key(s, &s->buckets.configure_request_keys, (uint64_t)e->window);
+        *pc = (pending_config_t){.window = e->window};
+        pending_config_merge(pc, e);
+        epoch_map_insert(&s->buckets.configure_requests, e->window, pc);
       }
       break;
     }
 
     case XCB_CONFIGURE_NOTIFY: {
       xcb_configure_notify_event_t* e = (xcb_configure_notify_event_t*)ev;
-      xcb_configure_notify_event_t* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      memcpy(copy, e, sizeof(*e));
 
-      bool existing = hash_map_get(&s->buckets.configure_notifies, e->window) != NULL;
+      bool existing = epoch_map_get(&s->buckets.configure_notifies, e->window) != NULL;
       if (existing) {
         HXM_COUNTER_COALESCED_DROP(type);
         s->buckets.coalesced++;
         TRACE_LOG("coalesce configure_notify win=%u", e->window);
       }
-      hash_map_insert(&s->buckets.configure_notifies, e->window, copy);
-      if (!existing)
-        bucket_track_key(s, &s->buckets.configure_notify_keys, (uint64_t)e->window);
+      epoch_map_insert(&s->buckets.configure_notifies, e->window, e);
       break;
     }
 
     case XCB_PROPERTY_NOTIFY: {
       xcb_property_notify_event_t* e = (xcb_property_notify_event_t*)ev;
 
+      // Reuse fence of a pooled frame, see frame_pool.h
+      if (frame_pool_settle(&s->frame_pool, e->window, e->atom))
+        break;
+
       uint64_t key = ((uint64_t)e->window << 32) | (uint64_t)e->atom;
-      if (hash_map_get(&s->buckets.property_notifies, key)) {
+      if (epoch_map_get(&s->buckets.property_notifies, key)) {
         HXM_COUNTER_COALESCED_DROP(type);
         s->buckets.coalesced++;
         TRACE_LOG("coalesce property_notify win=%u atom=%u (%s)", e->window, e->atom, atom_name(e->atom));
@@ -1193,26 +1940,20 @@ static void event_ingest_one(server_t* s, xcb_generic_event_t* ev) {
       }
 
       TRACE_LOG("ingest property_notify win=%u atom=%u (%s) state=%u", e->window, e->atom, atom_name(e->atom), e->state);
-      void* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      memcpy(copy, e, sizeof(*e));
-      hash_map_insert(&s->buckets.property_notifies, key, copy);
-      bucket_track_key(s, &s->buckets.property_notify_keys, key);
+      epoch_map_insert(&s->buckets.property_notifies, key, e);
       break;
     }
 
     case XCB_MOTION_NOTIFY: {
       xcb_motion_notify_event_t* e = (xcb_motion_notify_event_t*)ev;
-      xcb_motion_notify_event_t* existing = hash_map_get(&s->buckets.motion_notifies, e->event);
+      xcb_motion_notify_event_t* existing = epoch_map_get(&s->buckets.motion_notifies, e->event);
       if (existing) {
         HXM_COUNTER_COALESCED_DROP(type);
         s->buckets.coalesced++;
         *existing = *e;
         break;
       }
-      xcb_motion_notify_event_t* copy = arena_alloc(&s->tick_arena, sizeof(*e));
-      *copy = *e;
-      hash_map_insert(&s->buckets.motion_notifies, e->event, copy);
-      bucket_track_key(s, &s->buckets.motion_notify_keys, (uint64_t)e->event);
+      epoch_map_insert(&s->buckets.motion_notifies, e->event, e);
       break;
     }
 
@@ -1260,9 +2001,23 @@ static void event_ingest_one(server_t* s, xcb_generic_event_t* ev) {
       break;
     }
 
+    case XCB_MAPPING_NOTIFY: {
+      // The keysym table is refreshed now so later key events in this batch
+      // resolve against the new map; the regrab runs once per tick
+      xcb_mapping_notify_event_t* e = (xcb_mapping_notify_event_t*)ev;
+      if (!s->keysyms || !xcb_refresh_keyboard_mapping(s->keysyms, e))
+        break;
+      if (s->buckets.keymap_dirty) {
+        HXM_COUNTER_COALESCED_DROP(type);
+        s->buckets.coalesced++;
+      }
+      s->buckets.keymap_dirty = true;
+      TRACE_LOG("coalesce mapping_notify request=%u first=%u count=%u", e->request, e->first_keycode, e->count);
+      break;
+    }
+
     case XCB_NO_EXPOSURE:
     case XCB_CREATE_NOTIFY:
-    case XCB_MAPPING_NOTIFY:
       // These are noisy and we don't use them for anything right now
       break;
 
@@ -1270,8 +2025,6 @@ static void event_ingest_one(server_t* s, xcb_generic_event_t* ev) {
       HXM_COUNTER_EVENT_UNHANDLED(type);
       break;
   }
-
-  free(ev);
 }
 
 #if HXM_DIAG
@@ -1305,7 +2058,186 @@ static void log_unhandled_summary(void) {
 }
 #endif
 
-void event_process(server_t* s) {
+/*
+ * Title refresh throttling
+ *
+ * Each WM_NAME/_NET_WM_NAME change costs a GetProperty, a title re-layout
+ * and a frame repaint. Clients that retitle many times a second (progress
+ * bars, build tools) are limited to TITLE_REFRESH_HZ refreshes; changes
+ * inside the window collapse into one trailing refresh, so the last title
+ * always lands. The focused client gets a much higher budget.
+ */
+#define TITLE_REFRESH_HZ 4
+#define TITLE_REFRESH_HZ_FOCUSED 30
+#define TITLE_REFRESH_SLACK_NS 10000000u
+
+static uint32_t title_refresh_interval_ms(const client_hot_t* hot) {
+  return 1000u / ((hot->flags & CLIENT_FLAG_FOCUSED) ? TITLE_REFRESH_HZ_FOCUSED : TITLE_REFRESH_HZ);
+}
+
+static inline bool title_atom(xcb_atom_t atom) {
+  return atom == atoms.WM_NAME || atom == atoms._NET_WM_NAME;
+}
+
+static void title_refresh_fired(wheel_timer_t* t, void* ctx);
+
+// Keep title_timer at the earliest trailing refresh; replace moves it later
+static void title_refresh_arm(server_t* s, uint64_t deadline_ns, bool replace) {
+  if (!replace && wheel_timer_pending(&s->title_timer) && s->title_timer.deadline_ns <= deadline_ns)
+    return;
+  event_arm_timer(s, &s->title_timer, title_refresh_fired, deadline_ns, TITLE_REFRESH_SLACK_NS);
+}
+
+// Returns false if the refresh was deferred rather than let through
+static bool title_refresh_admit(server_t* s, handle_t h, uint32_t now_ms) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return true;
+
+  // An already queued trailing refresh will fetch this change too
+  if (cold->title_deferred)
+    return false;
+
+  if ((uint32_t)(now_ms - cold->title_refresh_ms) >= title_refresh_interval_ms(hot)) {
+    cold->title_refresh_ms = now_ms;
+    return true;
+  }
+
+  cold->title_deferred = true;
+  handle_vec_push(&s->title_deferred, h);
+
+  // Wake for the trailing refresh even if the client goes quiet
+  uint32_t left = title_refresh_interval_ms(hot) - (now_ms - cold->title_refresh_ms);
+  title_refresh_arm(s, (monotonic_time_ns() / 1000000u + left) * 1000000u, false);
+  return false;
+}
+
+// Let through trailing refreshes whose interval has passed
+static void title_refresh_release(server_t* s, uint32_t now_ms) {
+  size_t kept = 0;
+  for (size_t i = 0; i < s->title_deferred.length; i++) {
+    handle_t h = s->title_deferred.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold || !cold->title_deferred)
+      continue;
+    if ((uint32_t)(now_ms - cold->title_refresh_ms) < title_refresh_interval_ms(hot)) {
+      s->title_deferred.items[kept++] = h;
+      continue;
+    }
+    cold->title_deferred = false;
+    cold->title_refresh_ms = now_ms;
+    server_mark_dirty(s, hot, DIRTY_TITLE);
+  }
+  s->title_deferred.length = kept;
+}
+
+// Milliseconds until the next trailing refresh is due, -1 if none
+static int title_refresh_timeout_ms(server_t* s, uint32_t now_ms) {
+  int best = -1;
+  for (size_t i = 0; i < s->title_deferred.length; i++) {
+    handle_t h = s->title_deferred.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold)
+      continue;
+    uint32_t elapsed = now_ms - cold->title_refresh_ms;
+    uint32_t interval = title_refresh_interval_ms(hot);
+    int left = elapsed >= interval ? 0 : (int)(interval - elapsed);
+    if (best < 0 || left < best)
+      best = left;
+  }
+  return best;
+}
+
+static void title_refresh_fired(wheel_timer_t* t, void* ctx) {
+  (void)t;
+  server_t* s = ctx;
+  uint64_t now = monotonic_time_ns();
+  uint32_t now_ms = (uint32_t)(now / 1000000u);
+  title_refresh_release(s, now_ms);
+  int left = title_refresh_timeout_ms(s, now_ms);
+  if (left >= 0)
+    title_refresh_arm(s, (now / 1000000u + (uint64_t)left) * 1000000u, true);
+}
+
+/*
+ * Bulk lane PropertyNotify budget
+ *
+ * Property work is the part of a tick that grows with what clients do
+ * rather than with what the user does: a session restore or a busy
+ * terminal can post hundreds in one go. Past the tick's deadline the rest
+ * are copied out and replayed first next tick, after at least
+ * EVENT_BULK_PROPS_MIN have been handled so the backlog always drains.
+ */
+typedef struct property_lane {
+  uint64_t deadline_ns; /* 0 = none */
+  uint32_t handled;
+  bool late;         /* deadline passed, the rest is deferred */
+  bool qos;          /* drag mode: only the dragged client's run, see wm_interaction_qos */
+  handle_t dragged;
+} property_lane_t;
+
+static bool deferred_prop_append(event_buckets_t* b, const xcb_property_notify_event_t* ev) {
+  if (b->deferred_props_len == b->deferred_props_cap) {
+    uint32_t cap = b->deferred_props_cap ? b->deferred_props_cap * 2 : 64;
+    xcb_property_notify_event_t* grown = realloc(b->deferred_props, (size_t)cap * sizeof(*grown));
+    if (!grown)
+      return false;
+    b->deferred_props = grown;
+    b->deferred_props_cap = cap;
+  }
+  b->deferred_props[b->deferred_props_len++] = *ev;
+  return true;
+}
+
+static void event_process_property(server_t* s, property_lane_t* lane, const xcb_property_notify_event_t* ev, uint32_t now_ms) {
+  // Fix 1: Ignore _NET_WORKAREA on root to prevent feedback loop
+  if (ev->atom == atoms._NET_WORKAREA && server_screen_of_root(s, ev->window))
+    return;
+
+  if (epoch_map_get(&s->buckets.destroyed_windows, ev->window))
+    return;
+
+  handle_t h = server_get_client_by_window(s, ev->window);
+  if (h == HANDLE_INVALID)
+    return;
+
+  // The clock is read every few events once the guaranteed share is done
+  if (!lane->late && lane->deadline_ns && lane->handled >= EVENT_BULK_PROPS_MIN && (lane->handled & 7u) == 0 &&
+      monotonic_time_ns() > lane->deadline_ns)
+    lane->late = true;
+  bool hold = lane->late || (lane->qos && h != lane->dragged);
+  if (hold && deferred_prop_append(&s->buckets, ev)) {
+    s->buckets.props_deferred++;
+    return;
+  }
+  lane->handled++;
+
+  if (title_atom(ev->atom) && !title_refresh_admit(s, h, now_ms))
+    return;
+  wm_handle_property_notify(s, h, (xcb_property_notify_event_t*)ev);
+}
+
+static void event_process_deferred_props(server_t* s, property_lane_t* lane, uint32_t now_ms) {
+  event_buckets_t* b = &s->buckets;
+  uint32_t n = b->deferred_props_len;
+  for (uint32_t i = 0; i < n; i++) {
+    // By value: deferring again may move the array
+    xcb_property_notify_event_t ev = b->deferred_props[i];
+    // A newer notify for the same property is in this tick's bucket
+    uint64_t key = ((uint64_t)ev.window << 32) | (uint64_t)ev.atom;
+    if (epoch_map_get(&b->property_notifies, key))
+      continue;
+    event_process_property(s, lane, &ev, now_ms);
+  }
+  // Whatever was deferred again sits past n
+  b->deferred_props_len -= n;
+  memmove(b->deferred_props, b->deferred_props + n, (size_t)b->deferred_props_len * sizeof(*b->deferred_props));
+}
+
+bool event_process_input(server_t* s) {
 #if HXM_TRACE_LOGS
   static rl_t rl_process = {0};
   uint64_t now = monotonic_time_ns();
@@ -1313,14 +2245,18 @@ void event_process(server_t* s) {
     TRACE_LOG(
         "event_process buckets map=%zu unmap=%zu destroy=%zu client=%zu "
         "configure=%zu property=%zu",
-        s->buckets.map_requests.length, s->buckets.unmap_notifies.length, s->buckets.destroy_notifies.length, s->buckets.client_messages.length, hash_map_size(&s->buckets.configure_requests),
-        hash_map_size(&s->buckets.property_notifies));
+        s->buckets.map_requests.length, s->buckets.unmap_notifies.length, s->buckets.destroy_notifies.length, s->buckets.client_messages.length, epoch_map_size(&s->buckets.configure_requests),
+        epoch_map_size(&s->buckets.property_notifies));
   }
 #endif
+  bool input = s->buckets.key_presses.length > 0 || s->buckets.key_releases.length > 0 || s->buckets.button_events.length > 0 ||
+               s->buckets.client_messages.length > 0 || epoch_map_size(&s->buckets.motion_notifies) > 0 || s->buckets.pointer_notify.enter_valid ||
+               s->buckets.pointer_notify.leave_valid || s->buckets.focus_notify.in_valid || s->buckets.focus_notify.out_valid;
+
   // 1. lifecycle
   for (size_t i = 0; i < s->buckets.map_requests.length; i++) {
     xcb_map_request_event_t* ev = s->buckets.map_requests.items[i];
-    if (hash_map_get(&s->buckets.destroyed_windows, ev->window))
+    if (epoch_map_get(&s->buckets.destroyed_windows, ev->window))
       continue;
     TRACE_LOG("process map_request win=%u", ev->window);
     wm_handle_map_request(s, ev);
@@ -1328,7 +2264,7 @@ void event_process(server_t* s) {
 
   for (size_t i = 0; i < s->buckets.unmap_notifies.length; i++) {
     xcb_unmap_notify_event_t* ev = s->buckets.unmap_notifies.items[i];
-    if (hash_map_get(&s->buckets.destroyed_windows, ev->window))
+    if (epoch_map_get(&s->buckets.destroyed_windows, ev->window))
       continue;
     TRACE_LOG("process unmap_notify win=%u event=%u", ev->window, ev->event);
     wm_handle_unmap_notify(s, ev);
@@ -1340,14 +2276,20 @@ void event_process(server_t* s) {
     wm_handle_destroy_notify(s, ev);
   }
 
-  // 2. keys (keybindings)
+  // 2. keys (keybindings), against the current keyboard mapping
+  if (s->buckets.keymap_dirty)
+    wm_setup_keys(s);
+
   for (size_t i = 0; i < s->buckets.key_presses.length; i++) {
     xcb_key_press_event_t* ev = s->buckets.key_presses.items[i];
+    uint32_t repeats = (uint32_t)(uintptr_t)epoch_map_get(&s->buckets.key_repeats, (uintptr_t)ev);
     if (s->interaction_mode == INTERACTION_MENU) {
-      menu_handle_key_press(s, ev);
+      // Menu navigation is cheap: every repeat steps
+      for (uint32_t n = 0; n < (repeats ? repeats : 1u); n++)
+        menu_handle_key_press(s, ev);
     }
     else {
-      wm_handle_key_press(s, ev);
+      wm_handle_key_run(s, ev, repeats ? repeats : 1u, repeats > 0);
     }
   }
   for (size_t i = 0; i < s->buckets.key_releases.length; i++) {
@@ -1375,40 +2317,25 @@ void event_process(server_t* s) {
     }
   }
 
-  // 4. expose (frames + menu)
-  bucket_iter_t expose_it = {0};
-  uint64_t key = 0;
-  void* value = NULL;
-  while (bucket_iter_next(&s->buckets.expose_regions, &s->buckets.expose_region_keys, &expose_it, &key, &value)) {
-    xcb_window_t win = (xcb_window_t)key;
-    dirty_region_t* region = (dirty_region_t*)value;
-    if (!region || !region->valid)
-      continue;
-
-    if (win == s->menu.window) {
-      menu_handle_expose_region(s, region);
-      continue;
-    }
-
-    handle_t h = server_get_client_by_frame(s, win);
-    if (h != HANDLE_INVALID) {
-      frame_redraw_region(s, h, region);
-    }
-  }
-
-  // 5. client messages (EWMH/ICCCM)
+  // 4. client messages (EWMH/ICCCM)
   for (size_t i = 0; i < s->buckets.client_messages.length; i++) {
     xcb_client_message_event_t* ev = s->buckets.client_messages.items[i];
+    if (!ev)
+      continue;  // superseded by a later copy
     TRACE_LOG("process client_message win=%u type=%u", ev->window, ev->type);
     wm_handle_client_message(s, ev);
   }
 
-  // 6. focus and pointer signals
+  // 5. focus and pointer signals
   event_reduce_focus(s);
   // Enter/Leave update pointer-hint time and may drive focus when configured.
   event_reduce_pointer_hints(s);
-  bucket_iter_t motion_it = {0};
-  while (bucket_iter_next(&s->buckets.motion_notifies, &s->buckets.motion_notify_keys, &motion_it, &key, &value)) {
+  // Timers fire after the crossings above, which may have retargeted hover
+  timer_wheel_run(&s->timers, monotonic_time_ns(), s);
+  size_t motion_it = 0;
+  uint64_t key = 0;
+  void* value = NULL;
+  while (epoch_map_next(&s->buckets.motion_notifies, &motion_it, &key, &value)) {
     xcb_motion_notify_event_t* ev = (xcb_motion_notify_event_t*)value;
     if (!ev)
       continue;
@@ -1420,101 +2347,180 @@ void event_process(server_t* s) {
       wm_handle_motion_notify(s, ev);
     }
   }
+  return input;
+}
+
+void event_process_bulk(server_t* s, uint64_t deadline_ns) {
+  // 6. expose (frames + menu)
+  size_t expose_it = 0;
+  uint64_t key = 0;
+  void* value = NULL;
+  while (epoch_map_next(&s->buckets.expose_regions, &expose_it, &key, &value)) {
+    xcb_window_t win = (xcb_window_t)key;
+    dirty_rects_t* region = (dirty_rects_t*)value;
+    if (!region || dirty_rects_empty(region))
+      continue;
+
+    if (win == s->menu.window) {
+      // The menu is small and redrawn from one pixmap, its bounds will do
+      dirty_region_t bounds = dirty_rects_bounds(region);
+      menu_handle_expose_region(s, &bounds);
+      continue;
+    }
+
+    handle_t h = server_get_client_by_frame(s, win);
+    if (h != HANDLE_INVALID) {
+      frame_redraw_region(s, h, region);
+    }
+  }
 
   // 7. configure requests (coalesced)
-  bucket_iter_t cfg_req_it = {0};
-  while (bucket_iter_next(&s->buckets.configure_requests, &s->buckets.configure_request_keys, &cfg_req_it, &key, &value)) {
+  // Ingest routed by whether the window was managed then. A MapRequest this
+  // tick may have adopted a window with requests still queued as unmanaged;
+  // without one, the unmanaged array is left for the flush untouched.
+  if (s->buckets.map_requests.length > 0) {
+    for (uint32_t i = 0; i < s->buckets.unmanaged_configs_len; i++) {
+      pending_config_t* ev = &s->buckets.unmanaged_configs[i];
+      if (ev->mask == 0)
+        continue;
+      handle_t h = server_get_client_by_window(s, ev->window);
+      if (h != HANDLE_INVALID) {
+        wm_handle_configure_request(s, h, ev);
+        ev->mask = 0;
+      }
+    }
+  }
+
+  size_t cfg_req_it = 0;
+  while (epoch_map_next(&s->buckets.configure_requests, &cfg_req_it, &key, &value)) {
     pending_config_t* ev = (pending_config_t*)value;
     handle_t h = server_get_client_by_window(s, ev->window);
 
-    if (h != HANDLE_INVALID) {
+    if (h != HANDLE_INVALID)
       wm_handle_configure_request(s, h, ev);
-    }
+    else if (ev->mask != 0 && !unmanaged_config_append(&s->buckets, ev))  // unmanaged since ingest
+      LOG_WARN("dropping configure_request for unmanaged win=%u: out of memory", ev->window);
   }
 
   // 8. configure notifies (coalesced)
-  bucket_iter_t cfg_notify_it = {0};
-  while (bucket_iter_next(&s->buckets.configure_notifies, &s->buckets.configure_notify_keys, &cfg_notify_it, &key, &value)) {
+  size_t cfg_notify_it = 0;
+  while (epoch_map_next(&s->buckets.configure_notifies, &cfg_notify_it, &key, &value)) {
     xcb_configure_notify_event_t* ev = (xcb_configure_notify_event_t*)value;
-    handle_t h = server_get_client_by_window(s, ev->window);
-    if (h == HANDLE_INVALID)
-      h = server_get_client_by_frame(s, ev->window);
+    handle_t h = server_get_client_by_any(s, ev->window);
     if (h != HANDLE_INVALID) {
       wm_handle_configure_notify(s, h, ev);
     }
   }
 
-  // 9. property notifies (coalesced)
-  bucket_iter_t prop_it = {0};
-  while (bucket_iter_next(&s->buckets.property_notifies, &s->buckets.property_notify_keys, &prop_it, &key, &value)) {
-    xcb_property_notify_event_t* ev = (xcb_property_notify_event_t*)value;
-    // Fix 1: Ignore _NET_WORKAREA on root to prevent feedback loop
-    if (ev->window == s->root && ev->atom == atoms._NET_WORKAREA)
-      continue;
-
-    if (hash_map_get(&s->buckets.destroyed_windows, ev->window))
-      continue;
-
-    handle_t h = server_get_client_by_window(s, ev->window);
-    if (h != HANDLE_INVALID) {
-      wm_handle_property_notify(s, h, ev);
-    }
-  }
+  // 9. property notifies (coalesced), deferred leftovers first
+  uint32_t now_ms = (uint32_t)(monotonic_time_ns() / 1000000u);
+  property_lane_t lane = {.deadline_ns = deadline_ns, .qos = wm_interaction_qos(s, monotonic_time_ns()), .dragged = s->interaction_handle};
+  event_process_deferred_props(s, &lane, now_ms);
+  size_t prop_it = 0;
+  while (epoch_map_next(&s->buckets.property_notifies, &prop_it, &key, &value))
+    event_process_property(s, &lane, (xcb_property_notify_event_t*)value, now_ms);
 
   // 10. damage (coalesced)
-  bucket_iter_t damage_it = {0};
-  while (bucket_iter_next(&s->buckets.damage_regions, &s->buckets.damage_region_keys, &damage_it, &key, &value)) {
+  size_t damage_it = 0;
+  while (epoch_map_next(&s->buckets.damage_regions, &damage_it, &key, &value)) {
     xcb_window_t win = (xcb_window_t)key;
-    dirty_region_t* region = (dirty_region_t*)value;
-    if (!region || !region->valid)
+    dirty_rects_t* region = (dirty_rects_t*)value;
+    if (!region || dirty_rects_empty(region))
       continue;
 
     handle_t h = server_get_client_by_window(s, win);
-    if (h == HANDLE_INVALID)
+    if (h == HANDLE_INVALID) {
+      compositor_note_damage(s, win, region);
       continue;
+    }
     client_hot_t* hot = server_chot(s, h);
     client_cold_t* cold = server_ccold(s, h);
     if (!hot || !cold)
       continue;
 
-    dirty_region_union(&cold->damage_region, region);
+    dirty_region_t bounds = dirty_rects_bounds(region);
+    dirty_region_union(&cold->damage_region, &bounds);
+    thumbnail_mark_stale(s, h);
   }
 
   // 11. RandR (coalesced)
   if (s->buckets.randr_dirty) {
-    TRACE_LOG("queue randr commit width=%u height=%u", s->buckets.randr_width, s->buckets.randr_height);
+    TRACE_LOG("queue randr commit screens=0x%x", s->buckets.randr_screens);
   }
 
   // 12. maintenance
+  wm_adopt_trickle(s);
+}
+
+void event_process(server_t* s) {
+  event_process_input(s);
+  event_process_bulk(s, 0);
+}
+
+bool event_bulk_pending(const server_t* s) {
+  return cookie_jar_has_pending(&s->cookie_jar) || epoch_map_size(&s->buckets.property_notifies) > 0 || s->buckets.deferred_props_len > 0 ||
+         epoch_map_size(&s->buckets.configure_requests) > 0 || epoch_map_size(&s->buckets.damage_regions) > 0 ||
+         epoch_map_size(&s->buckets.expose_regions) > 0;
 }
 
 void server_schedule_timer(server_t* s, int ms) {
-  if (s->timer_fd <= 0)
+  server_schedule_timer_ns(s, ms > 0 ? (uint64_t)ms * 1000000u : 0);
+}
+
+void server_schedule_timer_ns(server_t* s, uint64_t ns) {
+  uint64_t deadline = monotonic_time_ns() + ns;
+  if (wheel_timer_pending(&s->wake_timer) && s->wake_timer.deadline_ns <= deadline)
     return;
+  // No callback: whoever asked re-checks its own state on the tick
+  event_arm_timer(s, &s->wake_timer, NULL, deadline, 0);
+}
+
+void server_sync_timer_fd(server_t* s) {
+  uint64_t next = timer_wheel_next_ns(&s->timers);
+  if (next == UINT64_MAX)
+    next = 0;
+  if (s->timer_fd <= 0 || next == s->timer_armed_ns)
+    return;
+
+  // Absolute, so the deadline does not drift by the time spent getting here
   struct itimerspec its;
-  its.it_interval.tv_sec = 0;
-  its.it_interval.tv_nsec = 0;  // One-shot
-  its.it_value.tv_sec = ms / 1000;
-  its.it_value.tv_nsec = (ms % 1000) * 1000000;
-  if (ms > 0 && its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) {
-    its.it_value.tv_nsec = 1;  // Minimal positive value
-  }
-  if (timerfd_settime(s->timer_fd, 0, &its, NULL) < 0) {
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_sec = (time_t)(next / 1000000000u);
+  its.it_value.tv_nsec = (long)(next % 1000000000u);
+  if (timerfd_settime(s->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
     LOG_WARN("timerfd_settime failed: %s", strerror(errno));
+    return;
   }
+  s->timer_armed_ns = next;
+  s->timer_rearms++;
+}
+
+int server_flush_wait_ms(const server_t* s, uint64_t since_flush_ns) {
+  // Nothing held back: sleep until an fd or the timer wheel has work
+  if (!s->pending_flush)
+    return -1;
+  if (since_flush_ns >= EVENT_BUSY_FLUSH_NS)
+    return 0;
+  return (int)((EVENT_BUSY_FLUSH_NS - since_flush_ns) / 1000000u) + 1;
 }
 
 bool event_drain_cookies(server_t* s) {
   if (!s)
     return false;
 
+  // The reply budget is shared across passes so follow-up cookies pushed by
+  // handlers cannot stretch a tick beyond it
+  size_t remaining = tick_budget_replies(&s->tick_budget);
+  size_t used = 0;
   bool any_progress = false;
-  for (int pass = 0; pass < 3; pass++) {
+  for (int pass = 0; pass < 3 && remaining > 0; pass++) {
     size_t before_live = s->cookie_jar.live_count;
 
-    cookie_jar_drain(&s->cookie_jar, s->conn, s, COOKIE_JAR_MAX_REPLIES_PER_TICK);
+    size_t processed = cookie_jar_drain(&s->cookie_jar, s->conn, s, remaining);
+    used += processed;
+    remaining -= processed;
 
-    bool cookies_progress = (s->cookie_jar.live_count != before_live);
+    bool cookies_progress = (processed > 0 || s->cookie_jar.live_count != before_live);
     if (cookies_progress)
       any_progress = true;
     if (!cookies_progress)
@@ -1522,103 +2528,196 @@ bool event_drain_cookies(server_t* s) {
     if (s->cookie_jar.live_count == 0)
       break;
   }
+  s->tick_budget.replies_used = (uint32_t)used;
   return any_progress;
 }
 
-static void apply_reload(server_t* s) {
-  LOG_INFO("Reloading configuration");
-
-  config_t next_config;
-  config_init_defaults(&next_config);
+void tick_budget_init(tick_budget_t* b) {
+  b->max_events = MAX_EVENTS_PER_TICK;
+  b->max_replies = COOKIE_JAR_MAX_REPLIES_PER_TICK;
+  b->events_used = 0;
+  b->replies_used = 0;
+}
 
-  char path[1024];
-  const char* xdg_config_home = getenv("XDG_CONFIG_HOME");
-  const char* home = getenv("HOME");
-  bool loaded = false;
+static uint32_t budget_shrink(uint32_t cur, uint32_t lo) {
+  uint32_t next = cur - cur / 4u;
+  return (next < lo) ? lo : next;
+}
 
-  if (xdg_config_home) {
-    snprintf(path, sizeof(path), "%s/hxm/hxm.conf", xdg_config_home);
-    loaded = config_load(&next_config, path);
-  }
+static uint32_t budget_grow(uint32_t cur, uint32_t hi) {
+  uint32_t next = cur + cur / 4u + 1u;
+  return (next > hi) ? hi : next;
+}
 
-  if (!loaded && home) {
-    snprintf(path, sizeof(path), "%s/.config/hxm/hxm.conf", home);
-    loaded = config_load(&next_config, path);
-  }
+void tick_budget_update(tick_budget_t* b, const tick_sample_t* sample, bool interactive) {
+  uint32_t events = tick_budget_events(b);
+  uint32_t replies = tick_budget_replies(b);
+
+  uint64_t total = sample->ns[TICK_PHASE_TOTAL];
+  uint64_t event_cost = sample->ns[TICK_PHASE_INGEST] + sample->ns[TICK_PHASE_PROCESS];
+  uint64_t reply_cost = sample->ns[TICK_PHASE_DRAIN];
+  bool events_saturated = b->events_used >= events;
+  bool replies_saturated = b->replies_used >= replies;
+
+  if (total > TICK_BUDGET_TARGET_NS) {
+    // Over budget: cut whichever side dominated, replies first during a drag
+    if (interactive || reply_cost >= event_cost)
+      replies = budget_shrink(replies, TICK_BUDGET_REPLIES_MIN);
+    else
+      events = budget_shrink(events, TICK_BUDGET_EVENTS_MIN);
+  }
+  else if (total < TICK_BUDGET_TARGET_NS / 2u) {
+    // Headroom: only grow budgets that were actually exhausted
+    if (events_saturated)
+      events = budget_grow(events, TICK_BUDGET_EVENTS_MAX);
+    if (replies_saturated)
+      replies = budget_grow(replies, TICK_BUDGET_REPLIES_MAX);
+  }
+
+  if (interactive && replies > TICK_BUDGET_REPLIES_INTERACTIVE)
+    replies = TICK_BUDGET_REPLIES_INTERACTIVE;
+
+  b->max_events = events;
+  b->max_replies = replies;
+  b->events_used = 0;
+  b->replies_used = 0;
+}
 
-  if (!loaded) {
-    loaded = config_load(&next_config, "/etc/hxm/hxm.conf");
+/*
+ * Re-read the files in `files` (config_watch_file bits) and re-apply only the
+ * config sections that differ from what is running: a keybinding edit only
+ * regrabs keys, a theme edit only repaints frames, a menu edit only reparses
+ * the menu.
+ */
+static void apply_reload(server_t* s, uint32_t files) {
+  uint32_t changed = 0;
+  if (files & (CONFIG_WATCH_MAIN | CONFIG_WATCH_THEME)) {
+    config_t next_config;
+    config_init_defaults(&next_config);
+    load_config_files(&next_config, !s->is_test);
+    changed = config_diff(&s->config, &next_config);
+    config_destroy(&s->config);
+    config_move(&s->config, &next_config);
+  }
+
+  bool menu_files = (files & CONFIG_WATCH_MENU) != 0;
+  LOG_INFO("Reloading configuration (files 0x%x, changed sections 0x%x)", files, changed);
+
+  if (changed & (CONFIG_SECTION_SNAP | CONFIG_SECTION_THEME)) {
+    // The preview colour falls back to the theme's active border
+    server_apply_snap_config(s);
+    snap_preview_destroy(s);
+    snap_preview_init(s);
+  }
+
+  for (uint32_t n = 0; n < server_screen_count(s) && (changed & CONFIG_SECTION_DESKTOPS); n++) {
+    screen_t* scr = &s->screens[n];
+    uint32_t desired = s->config.desktop_count ? s->config.desktop_count : scr->desktop_count;
+    if (desired == 0)
+      desired = 1;
+    if (desired != scr->desktop_count) {
+      scr->desktop_count = desired;
+      if (scr->current_desktop >= scr->desktop_count)
+        scr->current_desktop = 0;
+
+      for (size_t i = 0; i < s->active_clients.length; i++) {
+        handle_t h = s->active_clients.items[i];
+        client_hot_t* hot = server_chot(s, h);
+        if (!hot || hot->sticky || client_screen(s, hot) != scr)
+          continue;
+        if (hot->desktop >= (int32_t)scr->desktop_count) {
+          client_set_desktop(s, hot, (int32_t)scr->current_desktop);
+          uint32_t prop_val = (uint32_t)hot->desktop;
+          xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &prop_val);
+          wm_focus_history_update(s, h);
+        }
+      }
+      wm_desktop_members_invalidate(s);
+    }
+    wm_publish_desktop_props(s, scr);
   }
 
-  if (!loaded && access("data/hxm.conf", R_OK) == 0) {
-    loaded = config_load(&next_config, "data/hxm.conf");
+  for (uint32_t n = 0; n < server_screen_count(s) && (changed & (CONFIG_SECTION_DESKTOPS | CONFIG_SECTION_POLICY)); n++) {
+    wm_workarea_invalidate(&s->screens[n]);
+    s->screens[n].workarea_dirty = true;
   }
 
-  if (!loaded && access("../data/hxm.conf", R_OK) == 0) {
-    loaded = config_load(&next_config, "../data/hxm.conf");
+  if (changed & CONFIG_SECTION_THEME) {
+    frame_cleanup_resources(s);
+    frame_init_resources(s);
   }
+  if (changed & (CONFIG_SECTION_THEME | CONFIG_SECTION_POLICY))
+    server_sync_render_worker(s);
+  if (changed & CONFIG_SECTION_POLICY)
+    server_sync_x_reader(s);
+  if (changed & CONFIG_SECTION_POLICY)
+    server_sync_cgroup_worker(s);
+  if (changed & CONFIG_SECTION_POLICY)
+    server_sync_compositor(s);
+  if (changed & CONFIG_SECTION_POLICY)
+    wm_tiling_reload(s);
+  if (changed & CONFIG_SECTION_POLICY)
+    wm_ping_reload(s);
+  if (changed & CONFIG_SECTION_POLICY)
+    thumbnail_apply_config(s);
 
-  bool theme_loaded = false;
-  if (xdg_config_home) {
-    snprintf(path, sizeof(path), "%s/hxm/themerc", xdg_config_home);
-    theme_loaded = theme_load(&next_config.theme, path);
-  }
-  if (!theme_loaded && home) {
-    snprintf(path, sizeof(path), "%s/.config/hxm/themerc", home);
-    theme_loaded = theme_load(&next_config.theme, path);
+  if (changed & CONFIG_SECTION_THEME) {
+    // The menu window and fonts are built from the theme
+    menu_destroy(s);
+    menu_init(s);
+    load_menu_config(s);
   }
-  if (!theme_loaded) {
-    theme_load(&next_config.theme, "/etc/hxm/themerc");
+  else if (menu_files) {
+    load_menu_config(s);
   }
 
-  config_destroy(&s->config);
-  s->config = next_config;
-  server_apply_snap_config(s);
-
-  uint32_t desired = s->config.desktop_count ? s->config.desktop_count : s->desktop_count;
-  if (desired == 0)
-    desired = 1;
-  if (desired != s->desktop_count) {
-    s->desktop_count = desired;
-    if (s->current_desktop >= s->desktop_count)
-      s->current_desktop = 0;
+  if (changed & CONFIG_SECTION_KEYS)
+    wm_setup_keys(s);
 
+  if (changed & CONFIG_SECTION_THEME) {
     for (size_t i = 0; i < s->active_clients.length; i++) {
-      handle_t h = ptr_to_handle(s->active_clients.items[i]);
+      handle_t h = s->active_clients.items[i];
       client_hot_t* hot = server_chot(s, h);
-      if (!hot || hot->sticky)
+      if (!hot)
         continue;
-      if (hot->desktop >= (int32_t)s->desktop_count) {
-        hot->desktop = (int32_t)s->current_desktop;
-        uint32_t prop_val = (uint32_t)hot->desktop;
-        xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &prop_val);
-      }
+      hot->frame_hit.flags = 0;  // theme metrics may have changed
+      server_mark_dirty(s, hot, DIRTY_FRAME_STYLE | DIRTY_GEOM);
     }
   }
+}
 
-  wm_publish_desktop_props(s);
-  s->workarea_dirty = true;
-
-  frame_cleanup_resources(s);
-  frame_init_resources(s);
-
-  menu_destroy(s);
-  menu_init(s);
-  load_menu_config(s);
+/*
+ * Mirror the tick, manage, cookie jar, memory and launcher summaries onto the root window so
+ * they can be read without access to the WM's stdout (`xprop -root _HXM_TICK_STATS`)
+ */
+static void event_publish_tick_stats(server_t* s) {
+  if (!s->conn || atoms._HXM_TICK_STATS == XCB_ATOM_NONE)
+    return;
 
-  wm_setup_keys(s);
+  char buf[16384];
+  size_t len = tick_stats_format(buf, sizeof(buf));
+  len += manage_stats_format(buf + len, sizeof(buf) - len);
+  len += cookie_jar_stats_format(&s->cookie_jar, buf + len, sizeof(buf) - len);
+  len += mem_budget_format(&s->mem_budget, (size_t)s->config.memory_budget_mb << 20, buf + len, sizeof(buf) - len);
+  len += launcher_format(&s->launcher, buf + len, sizeof(buf) - len);
+  len += x_reader_format(&s->x_reader, buf + len, sizeof(buf) - len);
+  xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->screens[0].root, atoms._HXM_TICK_STATS, atoms.UTF8_STRING, 8, (uint32_t)len, buf);
+  s->pending_flush = true;
+}
 
-  snap_preview_destroy(s);
-  snap_preview_init(s);
+static const char* const wake_cause_names[WAKE_CAUSE_COUNT] = {"x", "signal", "timer", "other", "timeout", "spurious"};
 
-  for (size_t i = 0; i < s->active_clients.length; i++) {
-    handle_t h = ptr_to_handle(s->active_clients.items[i]);
-    client_hot_t* hot = server_chot(s, h);
-    if (hot)
-      hot->dirty |= DIRTY_FRAME_STYLE | DIRTY_GEOM;
-  }
+const char* wake_cause_name(wake_cause_t cause) {
+  return cause < WAKE_CAUSE_COUNT ? wake_cause_names[cause] : "unknown";
+}
 
-  wm_publish_desktop_props(s);
+static void event_wakeups_dump(const server_t* s) {
+  printf("wakeups:");
+  for (int i = 0; i < WAKE_CAUSE_COUNT; i++)
+    printf(" %s=%" PRIu64, wake_cause_names[i], s->wakeups[i]);
+  printf(" busy_poll_hits=%" PRIu64 " busy_poll_misses=%" PRIu64 " boosts=%" PRIu64 "%s\n", s->busy_poll_hits, s->busy_poll_misses,
+         s->boosts, s->boost_denied ? " boost_denied" : "");
+  fflush(stdout);
 }
 
 static void event_handle_signals(server_t* s) {
@@ -1648,21 +2747,101 @@ static void event_handle_signals(server_t* s) {
 #if HXM_DIAG
         counters_dump();
 #endif
+        tick_stats_dump();
+        manage_stats_dump();
+        cookie_jar_stats_dump(&s->cookie_jar);
+        mem_budget_dump(&s->mem_budget, (size_t)s->config.memory_budget_mb << 20);
+        launcher_dump(&s->launcher);
+        x_reader_dump(&s->x_reader);
+        cgroup_worker_dump(&s->cgroup_worker);
+        freezer_dump(&s->freezer);
+        compositor_dump(&s->compositor);
+        timer_wheel_dump(&s->timers);
+        event_wakeups_dump(s);
+        tp_dump();
+        event_publish_tick_stats(s);
         break;
       case SIGUSR2:
         LOG_INFO("Restart requested (signalfd)");
         g_restart_pending = 1;
         break;
       case SIGCHLD:
-        // Handle zombies if we fork processes
-        while (waitpid(-1, NULL, WNOHANG) > 0)
-          ;
+        launcher_reap(&s->launcher);
         break;
     }
   }
 }
 
-static bool server_wait_for_events(server_t* s, int timeout_ms) {
+/* A drag, Alt-Tab or the menu: the user is waiting on the next input */
+static bool event_grab_active(server_t* s) {
+  return s->interaction_mode != INTERACTION_NONE || s->switcher_active || menu_is_visible(&s->menu);
+}
+
+static void event_grab_boost_set(server_t* s, bool want) {
+  if (want == s->boost_active)
+    return;
+
+  if (!want) {
+    // Giving priority back never needs a privilege
+    if (s->boost_rr) {
+      struct sched_param sp = {.sched_priority = 0};
+      if (sched_setscheduler(0, SCHED_OTHER, &sp) < 0)
+        LOG_WARN("interactive_boost: leaving SCHED_RR failed: %s", strerror(errno));
+    }
+    else if (setpriority(PRIO_PROCESS, 0, s->boost_saved_nice) < 0) {
+      LOG_WARN("interactive_boost: restoring nice %d failed: %s", s->boost_saved_nice, strerror(errno));
+    }
+    s->boost_active = false;
+    return;
+  }
+
+  if (s->boost_denied)
+    return;
+  // Children spawned mid-drag must not inherit it
+  struct sched_param sp = {.sched_priority = 1};
+  if (sched_setscheduler(0, SCHED_RR | SCHED_RESET_ON_FORK, &sp) == 0) {
+    s->boost_rr = true;
+  }
+  else {
+    errno = 0;
+    int nice_now = getpriority(PRIO_PROCESS, 0);
+    if (errno != 0 || setpriority(PRIO_PROCESS, 0, nice_now - 5) < 0) {
+      LOG_INFO("interactive_boost: neither SCHED_RR nor a lower nice value is permitted, not boosting");
+      s->boost_denied = true;
+      return;
+    }
+    s->boost_saved_nice = nice_now;
+    s->boost_rr = false;
+  }
+  s->boost_active = true;
+  s->boosts++;
+}
+
+void server_grab_boost_update(server_t* s) {
+  event_grab_boost_set(s, s->config.interactive_boost && event_grab_active(s));
+}
+
+/*
+ * Spin on a zero-timeout epoll_wait until deadline_ns. libxcb's queue only
+ * fills from the socket, which the same poll watches (or the input thread's
+ * notify fd), so the fds alone tell when input arrived. Returns what the
+ * last epoll_wait returned: > 0 with evs filled, 0 when the spin ran out.
+ */
+static int event_busy_poll(server_t* s, struct epoll_event* evs, int max, uint64_t deadline_ns) {
+  for (;;) {
+    int n = epoll_wait(s->epoll_fd, evs, max, 0);
+    if (n != 0 || monotonic_time_ns() >= deadline_ns)
+      return n;
+  }
+}
+
+/* Keep the most significant cause of a multi-fd wakeup */
+static inline void wake_cause_note(wake_cause_t* cause, wake_cause_t c) {
+  if (c < *cause)
+    *cause = c;
+}
+
+bool server_wait_for_events(server_t* s, int timeout_ms) {
   s->x_fd_ready = false;
 
   if (s->epoll_fd < 0) {
@@ -1670,13 +2849,16 @@ static bool server_wait_for_events(server_t* s, int timeout_ms) {
     return true;
   }
 
-  if (s->prefetched_event)
+  if (s->prefetched_event || x_reader_pending(&s->x_reader))
     return true;
 
-  xcb_generic_event_t* queued = xcb_poll_for_queued_event(s->conn);
-  if (queued) {
-    s->prefetched_event = queued;
-    return true;
+  // With the input thread running, libxcb's event queue is the reader's
+  if (!s->x_reader.running) {
+    xcb_generic_event_t* queued = xcb_poll_for_queued_event(s->conn);
+    if (queued) {
+      s->prefetched_event = queued;
+      return true;
+    }
   }
 
   if (xcb_connection_has_error(s->conn)) {
@@ -1688,49 +2870,119 @@ static bool server_wait_for_events(server_t* s, int timeout_ms) {
 
   for (;;) {
     int wait_timeout = timeout_ms;
+    uint64_t now = monotonic_time_ns();
 
     // If we have pending cookies, ensure we wake up in time to expire stale
     // requests even when no X traffic or other timers arrive.
     if (cookie_jar_has_pending(&s->cookie_jar)) {
       static rl_t rl_cookie_flush = {0};
-      uint64_t now = monotonic_time_ns();
       if (rl_allow(&rl_cookie_flush, now, 1000000)) {
         xcb_flush(s->conn);
         HXM_COUNTER_X_FLUSH();
       }
 
       int32_t cookie_timeout = cookie_jar_next_timeout_ms(&s->cookie_jar, now);
-      if (cookie_timeout >= 0 && (wait_timeout < 0 || cookie_timeout < wait_timeout)) {
-        wait_timeout = cookie_timeout;
-      }
+      if (cookie_timeout >= 0)
+        event_arm_timer(s, &s->cookie_timer, NULL, now + (uint64_t)cookie_timeout * 1000000u, COOKIE_TIMER_SLACK_NS);
+    }
+    else {
+      timer_wheel_cancel(&s->timers, &s->cookie_timer);
     }
 
-    int n = epoll_wait(s->epoll_fd, evs, 8, wait_timeout);
+    // Property work the bulk lane deferred runs on the next tick, not the next
+    // event; during a drag wm_flush_dirty arms the timer for it instead
+    if (s->buckets.deferred_props_len > 0 && !wm_interaction_qos(s, now))
+      wait_timeout = 0;
+
+    // And for new windows held unframed by manage_defer_ms
+    int defer_timeout = wm_manage_defer_timeout_ms(s, now);
+    if (defer_timeout >= 0)
+      event_arm_timer(s, &s->manage_timer, NULL, now + (uint64_t)defer_timeout * 1000000u, 0);
+    else
+      timer_wheel_cancel(&s->timers, &s->manage_timer);
+
+    server_sync_timer_fd(s);
+    int n = 0;
+    uint32_t spin_us = s->config.interactive_busy_poll_us;
+    if (spin_us > 0 && wait_timeout != 0 && event_grab_active(s)) {
+      n = event_busy_poll(s, evs, 8, now + (uint64_t)spin_us * 1000u);
+      if (n > 0)
+        s->busy_poll_hits++;
+      else if (n == 0)
+        s->busy_poll_misses++;
+      if (wait_timeout > 0) {
+        int spent = (int)((monotonic_time_ns() - now) / 1000000u);
+        wait_timeout = spent < wait_timeout ? wait_timeout - spent : 0;
+      }
+    }
+    if (n == 0)
+      n = epoll_wait(s->epoll_fd, evs, 8, wait_timeout);
     if (n > 0) {
       bool x_ready = false;
+      // One wakeup, one cause: the most significant fd that was ready
+      wake_cause_t cause = WAKE_SPURIOUS;
       for (int i = 0; i < n; i++) {
+        // Control connections see ERR/HUP too and must close on them
+        if (control_owns_fd(&s->control, evs[i].data.fd)) {
+          control_handle(&s->control, s, evs[i].data.fd, evs[i].events);
+          wake_cause_note(&cause, WAKE_OTHER);
+          continue;
+        }
+        // A hangup means the helper died; collecting notices and drops it
+        if (launcher_helper_owns_fd(&s->launcher, evs[i].data.fd)) {
+          launcher_helper_collect(&s->launcher);
+          wake_cause_note(&cause, WAKE_OTHER);
+          continue;
+        }
+
         if (evs[i].events & (EPOLLERR | EPOLLHUP)) {
           if (evs[i].data.fd == s->xcb_fd) {
+            s->wakeups[WAKE_X]++;
             g_shutdown_pending = 1;
             return false;
           }
+          wake_cause_note(&cause, WAKE_OTHER);
           continue;
         }
 
         if (evs[i].data.fd == s->xcb_fd) {
           x_ready = true;
+          wake_cause_note(&cause, WAKE_X);
+        }
+        else if (s->x_reader.running && evs[i].data.fd == s->x_reader.notify_fd) {
+          x_reader_take_notify(&s->x_reader);
+          x_ready = true;
+          wake_cause_note(&cause, WAKE_X);
         }
         else if (evs[i].data.fd == s->signal_fd) {
           event_handle_signals(s);
+          wake_cause_note(&cause, WAKE_SIGNAL);
+        }
+        else if (s->render_worker.running && evs[i].data.fd == s->render_worker.notify_fd) {
+          frame_collect_title_runs(s);
+          wake_cause_note(&cause, WAKE_OTHER);
+        }
+        else if (evs[i].data.fd == s->config_watch.inotify_fd) {
+          config_watch_handle_inotify(&s->config_watch);
+          wake_cause_note(&cause, WAKE_OTHER);
+        }
+        else if (evs[i].data.fd == s->config_watch.timer_fd) {
+          config_watch_handle_timer(&s->config_watch);
+          wake_cause_note(&cause, WAKE_OTHER);
         }
         else if (evs[i].data.fd == s->timer_fd) {
           uint64_t expirations;
           if (read(s->timer_fd, &expirations, sizeof(expirations)) < 0) {
             // ignore error
           }
-          // Timer logic if needed
+          // Expired: the next sync must arm it again, even for the same deadline
+          s->timer_armed_ns = 0;
+          // A timer wakeup with nothing due on the wheel was wasted
+          if (timer_wheel_next_ns(&s->timers) <= monotonic_time_ns())
+            wake_cause_note(&cause, WAKE_TIMER);
         }
       }
+      s->wakeups[cause]++;
 
       if (x_ready) {
         s->x_fd_ready = true;
@@ -1745,9 +2997,12 @@ static bool server_wait_for_events(server_t* s, int timeout_ms) {
       // is fine
       return false;
     }
-    if (n == 0)
+    if (n == 0) {
+      s->wakeups[WAKE_TIMEOUT]++;
       return false;
+    }
     if (errno == EINTR) {
+      s->wakeups[WAKE_SPURIOUS]++;
       if (g_shutdown_pending || g_restart_pending || g_reload_pending)
         return false;
       continue;
@@ -1757,6 +3012,12 @@ static bool server_wait_for_events(server_t* s, int timeout_ms) {
   }
 }
 
+// Tick stats and the tick_phase tracepoint share one set of boundaries
+static inline void tick_phase_end(tick_sample_t* sample, tick_phase_t phase, uint64_t start_ns, uint64_t end_ns) {
+  tick_sample_add(sample, phase, end_ns - start_ns);
+  TP_TICK_PHASE(phase, start_ns, end_ns - start_ns);
+}
+
 void server_run(server_t* s) {
   LOG_INFO("Starting event loop");
 
@@ -1764,6 +3025,11 @@ void server_run(server_t* s) {
   int next_timeout = -1;
   s->pending_flush = false;
 
+  // Startup output is not charged to the first tick
+  uint64_t xreq_mark[XREQ_KIND_COUNT];
+  memcpy(xreq_mark, xreq_counts, sizeof(xreq_mark));
+  uint64_t x_bytes_mark = xcb_total_written(s->conn);
+
   for (;;) {
     if (g_shutdown_pending)
       break;
@@ -1782,8 +3048,23 @@ void server_run(server_t* s) {
 
         char* args[] = {path, NULL};
 
+        // Saved before cleanup unmanages everything
+        int handoff_fd = handoff_save(s);
+        if (handoff_fd >= 0) {
+          char fd_str[16];
+          snprintf(fd_str, sizeof(fd_str), "%d", handoff_fd);
+          setenv(HANDOFF_ENV, fd_str, 1);
+        }
+
         server_cleanup(s);
+        hxm_log_async_stop();
         execv(path, args);
+        int exec_errno = errno;
+        if (handoff_fd >= 0) {
+          unsetenv(HANDOFF_ENV);
+          close(handoff_fd);
+        }
+        errno = exec_errno;
       }
       LOG_ERROR("Failed to restart: %s", strerror(errno));
       g_restart_pending = 0;
@@ -1795,78 +3076,159 @@ void server_run(server_t* s) {
     }
 
     bool reload_applied = false;
+    uint32_t reload_files = config_watch_take(&s->config_watch);
     if (g_reload_pending) {
       g_reload_pending = 0;
-      apply_reload(s);
+      reload_files = CONFIG_WATCH_ALL;
+    }
+    if (reload_files) {
+      apply_reload(s, reload_files);
       reload_applied = true;
     }
 
+    server_grab_boost_update(s);
+
+    tick_sample_t sample;
+    tick_sample_init(&sample);
+
     bool x_ready = false;
+    bool waited = false;
+    uint64_t wait_start = 0;
     s->x_fd_ready = false;
     if (!reload_applied) {
       if (s->x_poll_immediate) {
         x_ready = true;
       }
       else {
+        wait_start = monotonic_time_ns();
+        waited = true;
         x_ready = server_wait_for_events(s, next_timeout);
       }
     }
 
     uint64_t start = monotonic_time_ns();
+    if (waited)
+      tick_phase_end(&sample, TICK_PHASE_WAIT, wait_start, start);
+    s->tick_start_ns = start;
     s->txn_id++;
 
+    uint64_t t0 = start;
+    DS_HOT_PATH_ENTER();
     event_ingest(s, x_ready);
+    uint64_t t1 = monotonic_time_ns();
+    tick_phase_end(&sample, TICK_PHASE_INGEST, t0, t1);
+
+    // Input lane first: with replies or bulk buckets waiting, its effects
+    // go out now instead of behind them
+    bool input = event_process_input(s);
+    t0 = monotonic_time_ns();
+    tick_phase_end(&sample, TICK_PHASE_PROCESS, t1, t0);
+    if (input && event_bulk_pending(s)) {
+      if (wm_flush_input(s, start)) {
+        t1 = monotonic_time_ns();
+        tick_phase_end(&sample, TICK_PHASE_FLUSH_DIRTY, t0, t1);
+        xcb_flush(s->conn);
+        t0 = monotonic_time_ns();
+        tick_phase_end(&sample, TICK_PHASE_XCB_FLUSH, t1, t0);
+        s->buckets.input_flushes++;
+        HXM_COUNTER_X_FLUSH();
+      }
+    }
+
     if (event_drain_cookies(s))
       s->pending_flush = true;
-    event_process(s);
+    t1 = monotonic_time_ns();
+    tick_phase_end(&sample, TICK_PHASE_DRAIN, t0, t1);
+
+    event_process_bulk(s, start + TICK_BUDGET_TARGET_NS);
+    t0 = t1;
+    t1 = monotonic_time_ns();
+    tick_phase_end(&sample, TICK_PHASE_PROCESS, t0, t1);
+
     if (wm_flush_dirty(s, start))
       s->pending_flush = true;
+    if (compositor_paint(s, start))
+      s->pending_flush = true;
     if (s->buckets.ingested > 0)
       s->pending_flush = true;
 
-    // Fix 3: Debounced workarea calculation
-    if (s->workarea_dirty) {
-      rect_t wa;
-      wm_compute_workarea(s, &wa);
+    // Fix 3: Debounced workarea calculation, held with the rest during drags
+    if (server_workarea_dirty(s) && !wm_interaction_qos(s, start) && !(wm_fullscreen_fast_held_root(s) & ROOT_DIRTY_WORKAREA)) {
+      for (uint32_t n = 0; n < server_screen_count(s); n++) {
+        screen_t* scr = &s->screens[n];
+        if (!scr->workarea_dirty)
+          continue;
+        rect_t wa;
+        wm_compute_workarea(s, scr, &wa);
 #if HXM_TRACE_LOGS
-      static rl_t rl_wa = {0};
-      if (rl_allow(&rl_wa, monotonic_time_ns(), 1000000000)) {
-        TRACE_LOG("publish_workarea debounced x=%d y=%d w=%u h=%u", wa.x, wa.y, wa.w, wa.h);
-      }
+        static rl_t rl_wa = {0};
+        if (rl_allow(&rl_wa, monotonic_time_ns(), 1000000000)) {
+          TRACE_LOG("publish_workarea debounced screen=%u x=%d y=%d w=%u h=%u", n, wa.x, wa.y, wa.w, wa.h);
+        }
 #endif
-      wm_publish_workarea(s, &wa);
-      s->workarea_dirty = false;
+        wm_publish_workarea(s, scr, &wa);
+        scr->workarea_dirty = false;
+      }
       s->pending_flush = true;
     }
 
+    if (mem_budget_tick(s, start))
+      s->pending_flush = true;
+    if (prewarm_tick(s, monotonic_time_ns()))
+      s->pending_flush = true;
+    DS_HOT_PATH_LEAVE();
+
     uint64_t flush_now = monotonic_time_ns();
+    tick_phase_end(&sample, TICK_PHASE_FLUSH_DIRTY, t1, flush_now);
     if (last_flush_time == 0)
       last_flush_time = flush_now;
     bool busy = s->x_poll_immediate;
-    if (s->pending_flush && (!busy || flush_now - last_flush_time >= 8000000)) {  // 8ms ~ 125Hz
+    uint64_t since_flush = (flush_now >= last_flush_time) ? (flush_now - last_flush_time) : 0;
+    if (s->pending_flush && (!busy || since_flush >= EVENT_BUSY_FLUSH_NS)) {
       xcb_flush(s->conn);
+      tick_phase_end(&sample, TICK_PHASE_XCB_FLUSH, flush_now, monotonic_time_ns());
       s->pending_flush = false;
       last_flush_time = flush_now;
+      since_flush = 0;
       HXM_COUNTER_X_FLUSH();
-      next_timeout = -1;
-    }
-    else {
-      uint64_t elapsed = (flush_now >= last_flush_time) ? (flush_now - last_flush_time) : 0;
-      if (elapsed >= 8000000) {
-        next_timeout = 0;
-      }
-      else {
-        uint64_t rem = 8000000 - elapsed;
-        next_timeout = (int)(rem / 1000000) + 1;
-      }
     }
+    next_timeout = server_flush_wait_ms(s, since_flush);
+
+    // Reply waits this tick may have queued events inside libxcb where the
+    // input thread's poll cannot see them
+    x_reader_kick(&s->x_reader);
 
 #if HXM_DIAG
     log_unhandled_summary();
 #endif
 
-#if HXM_DIAG
     uint64_t end = monotonic_time_ns();
+    tick_phase_end(&sample, TICK_PHASE_TOTAL, start, end);
+    sample.arena_used = s->tick_arena.used;
+    sample.arena_reserved = s->tick_arena.reserved;
+    sample.arena_shrinks = s->tick_arena.shrinks;
+    sample.arena_blocks = (uint32_t)s->tick_arena.blocks_used;
+    sample.title_hits = s->title_cache.hits;
+    sample.title_misses = s->title_cache.misses;
+    sample.unmanaged_forwarded = s->buckets.unmanaged_forwarded;
+    sample.unmanaged_coalesced = s->buckets.unmanaged_coalesced;
+    sample.client_messages_dropped = s->buckets.client_messages_dropped;
+    sample.synthetic_sent = s->synthetic_sent;
+    sample.synthetic_suppressed = s->synthetic_suppressed;
+    sample.root_props_written = s->root_props_written;
+    sample.root_props_skipped = s->root_props_skipped;
+    sample.monitor_snapshots_same = s->monitor_snapshots_same;
+    sample.monitor_clients_moved = s->monitor_clients_moved;
+    sample.input_flushes = s->buckets.input_flushes;
+    sample.props_deferred = s->buckets.props_deferred;
+    sample.interaction_qos_ticks = s->interaction_qos_ticks;
+    sample.timers_fired = s->timers.fired;
+    sample.timer_rearms = s->timer_rearms;
+    tick_sample_take_xreq(&sample, xreq_mark, &x_bytes_mark, xcb_total_written(s->conn));
+    tick_stats_record(&sample);
+    tick_budget_update(&s->tick_budget, &sample,
+                       s->interaction_mode == INTERACTION_MOVE || s->interaction_mode == INTERACTION_RESIZE);
+#if HXM_DIAG
     counters_tick_record(end - start);
 #endif
   }
@@ -0,0 +1,143 @@
+/* src/event_trace.c
+ * Event/reply trace recorder and reader.
+ *
+ * The recorder is a single global stream because the ingest and drain sites
+ * have no common context object cheaper to reach than a static. Each record
+ * is one fwrite of header then payload; the 1 MiB stdio buffer keeps that to
+ * a syscall every few thousand events.
+ */
+
+#include "event_trace.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hxm.h"
+
+#define EVENT_TRACE_MAGIC "HXMTRACE"
+#define EVENT_TRACE_BUF_SIZE (1u << 20)
+#define EVENT_TRACE_MAX_PAYLOAD (1u << 24)
+
+FILE* event_trace_out = NULL;
+static char* event_trace_buf;
+
+static void event_trace_write(uint8_t kind, uint8_t cookie_type, uint64_t data, const void* payload, uint32_t len) {
+  event_trace_hdr_t hdr = {
+      .kind = kind,
+      .cookie_type = cookie_type,
+      .len = len,
+      .t_ns = monotonic_time_ns(),
+      .data = data,
+  };
+  if (fwrite(&hdr, sizeof(hdr), 1, event_trace_out) != 1 || (len && fwrite(payload, len, 1, event_trace_out) != 1)) {
+    LOG_WARN("event trace write failed, recording stopped");
+    event_trace_close();
+  }
+}
+
+bool event_trace_open_from_env(void) {
+  const char* path = getenv(EVENT_TRACE_ENV);
+  if (!path || !*path || event_trace_out)
+    return event_trace_out != NULL;
+
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    LOG_WARN("event trace %s: %s", path, strerror(errno));
+    return false;
+  }
+  event_trace_buf = malloc(EVENT_TRACE_BUF_SIZE);
+  if (event_trace_buf)
+    setvbuf(f, event_trace_buf, _IOFBF, EVENT_TRACE_BUF_SIZE);
+
+  uint32_t head[2] = {EVENT_TRACE_VERSION, 0};
+  if (fwrite(EVENT_TRACE_MAGIC, 8, 1, f) != 1 || fwrite(head, sizeof(head), 1, f) != 1) {
+    LOG_WARN("event trace %s: header write failed", path);
+    fclose(f);
+    free(event_trace_buf);
+    event_trace_buf = NULL;
+    return false;
+  }
+  event_trace_out = f;
+  LOG_INFO("Recording event trace to %s", path);
+  return true;
+}
+
+void event_trace_close(void) {
+  if (event_trace_out) {
+    fclose(event_trace_out);
+    event_trace_out = NULL;
+  }
+  free(event_trace_buf);
+  event_trace_buf = NULL;
+}
+
+void event_trace_tick(uint64_t t_ns) {
+  if (!event_trace_out)
+    return;
+  event_trace_hdr_t hdr = {.kind = EVENT_TRACE_TICK, .t_ns = t_ns};
+  if (fwrite(&hdr, sizeof(hdr), 1, event_trace_out) != 1) {
+    LOG_WARN("event trace write failed, recording stopped");
+    event_trace_close();
+  }
+}
+
+void event_trace_event(const xcb_generic_event_t* ev) {
+  if (!event_trace_out || !ev)
+    return;
+  event_trace_write(EVENT_TRACE_EVENT, 0, 0, ev, 32);
+}
+
+void event_trace_reply(const cookie_slot_t* slot, const void* reply, const xcb_generic_error_t* err) {
+  if (!event_trace_out || !slot)
+    return;
+  if (err) {
+    event_trace_write(EVENT_TRACE_ERROR, slot->type, slot->data, err, 32);
+  } else if (reply) {
+    uint32_t len = 32u + 4u * ((const xcb_generic_reply_t*)reply)->length;
+    event_trace_write(EVENT_TRACE_REPLY, slot->type, slot->data, reply, len);
+  }
+}
+
+bool event_trace_reader_open(event_trace_reader_t* r, const char* path) {
+  memset(r, 0, sizeof(*r));
+  r->f = fopen(path, "rb");
+  if (!r->f)
+    return false;
+
+  char magic[8];
+  uint32_t head[2];
+  if (fread(magic, sizeof(magic), 1, r->f) != 1 || memcmp(magic, EVENT_TRACE_MAGIC, 8) != 0 || fread(head, sizeof(head), 1, r->f) != 1 ||
+      head[0] != EVENT_TRACE_VERSION) {
+    fclose(r->f);
+    r->f = NULL;
+    return false;
+  }
+  return true;
+}
+
+void event_trace_reader_close(event_trace_reader_t* r) {
+  if (r->f)
+    fclose(r->f);
+  free(r->buf);
+  memset(r, 0, sizeof(*r));
+}
+
+bool event_trace_reader_next(event_trace_reader_t* r, event_trace_hdr_t* hdr, const uint8_t** payload) {
+  if (!r->f || fread(hdr, sizeof(*hdr), 1, r->f) != 1)
+    return false;
+  if (hdr->kind < EVENT_TRACE_TICK || hdr->kind > EVENT_TRACE_ERROR || hdr->len > EVENT_TRACE_MAX_PAYLOAD)
+    return false;
+
+  if (hdr->len > r->cap) {
+    uint8_t* grown = realloc(r->buf, hdr->len);
+    if (!grown)
+      return false;
+    r->buf = grown;
+    r->cap = hdr->len;
+  }
+  if (hdr->len && fread(r->buf, hdr->len, 1, r->f) != 1)
+    return false;
+  *payload = r->buf;
+  return true;
+}
@@ -2,12 +2,13 @@
  * Window focus handling and history
  *
  * Model:
- * - MRU History: We maintain a global Most Recently Used list
- * (`s->focus_history`)
+ * - MRU History: We maintain a global Most Recently Used table
+ * (`s->focus_mru`, see focus_mru.h), linked by slot index with filter bits
+ * cached per entry
  * - Logical vs Physical: `wm_set_focus` updates the logical state
  * (`s->focused_client`) The actual X11 `SetInputFocus` request is deferred to
- * the flush phase via `s->root_dirty` This prevents focus stealing races and
- * flickering
+ * the flush phase via the screen's `root_dirty` This prevents focus stealing
+ * races and flickering
  */
 
 #include <stdlib.h>
@@ -19,42 +20,139 @@
 #include "wm.h"
 #include "xcb_utils.h"
 
-static inline bool list_node_linked(const list_node_t* n) {
-  if (!n)
-    return false;
-  if (!n->next || !n->prev)
-    return false;
-  return !(n->next == n && n->prev == n);
+/*
+ * Colormaps
+ *
+ * Focus changes, WM_COLORMAP_WINDOWS updates and ColormapNotify only ask for
+ * an install; wm_flush_colormap does it once per tick, for whichever client
+ * is focused by then. Static visuals (TrueColor, StaticColor, StaticGray)
+ * have read-only colormaps, so installing one changes no pixel: with no
+ * other visual on the screen nothing is ever asked for, and a client whose
+ * own visual is static gets nothing installed for it.
+ */
+static bool visual_class_dynamic(uint8_t c) {
+  return c == XCB_VISUAL_CLASS_GRAY_SCALE || c == XCB_VISUAL_CLASS_PSEUDO_COLOR || c == XCB_VISUAL_CLASS_DIRECT_COLOR;
 }
 
-void wm_install_client_colormap(server_t* s, client_hot_t* hot) {
-  if (!s || !hot)
-    return;
+bool screen_colormaps_static(const xcb_screen_t* screen) {
+  for (xcb_depth_iterator_t d = xcb_screen_allowed_depths_iterator(screen); d.rem; xcb_depth_next(&d)) {
+    for (xcb_visualtype_iterator_t v = xcb_depth_visuals_iterator(d.data); v.rem; xcb_visualtype_next(&v)) {
+      if (visual_class_dynamic(v.data->_class))
+        return false;
+    }
+  }
+  return true;
+}
+
+void wm_colormap_request(server_t* s) {
+  screen_t* scr = client_screen(s, server_chot(s, s->focused_client));
+  if (!scr->colormaps_static)
+    scr->root_dirty |= ROOT_DIRTY_COLORMAP;
+}
 
+static bool wm_install_client_colormap(server_t* s, client_hot_t* hot) {
   client_cold_t* cold = server_ccold(s, hot->self);
   if (!cold)
-    return;
-  bool use_list = cold && cold->colormap_windows && cold->colormap_windows_len > 0;
+    return false;
+  bool installed = false;
 
-  if (use_list) {
+  if (cold->colormap_windows && cold->colormap_windows_len > 0) {
     for (uint32_t i = 0; i < cold->colormap_windows_len; i++) {
       xcb_window_t win = cold->colormap_windows[i];
       if (win == hot->xid && cold->colormap != XCB_NONE) {
         xcb_install_colormap(s->conn, cold->colormap);
+        installed = true;
       }
       else if (win == hot->frame && cold->frame_colormap_owned && cold->frame_colormap != XCB_NONE) {
         xcb_install_colormap(s->conn, cold->frame_colormap);
+        installed = true;
       }
     }
-    return;
+    return installed;
   }
 
+  // The frame shares the client's visual, so both colormaps are static
+  if (cold->visual_type && !visual_class_dynamic(cold->visual_type->_class))
+    return false;
+
   if (cold->colormap != XCB_NONE) {
     xcb_install_colormap(s->conn, cold->colormap);
+    installed = true;
   }
   if (cold->frame_colormap_owned && cold->frame_colormap != XCB_NONE) {
     xcb_install_colormap(s->conn, cold->frame_colormap);
+    installed = true;
   }
+  return installed;
+}
+
+bool wm_flush_colormap(server_t* s) {
+  client_hot_t* hot = server_chot(s, s->focused_client);
+  bool installed = false;
+  for (uint32_t i = 0; i < server_screen_count(s); i++) {
+    screen_t* scr = &s->screens[i];
+    if (!(scr->root_dirty & ROOT_DIRTY_COLORMAP))
+      continue;
+    scr->root_dirty &= ~ROOT_DIRTY_COLORMAP;
+
+    // Each screen has its own installed list; only the focused one follows a client
+    if (hot && hot->screen == i && hot->state == STATE_MAPPED)
+      installed |= wm_install_client_colormap(s, hot);
+    else if (scr->default_colormap != XCB_NONE) {
+      xcb_install_colormap(s->conn, scr->default_colormap);
+      installed = true;
+    }
+  }
+  return installed;
+}
+
+void wm_focus_history_insert(server_t* s, handle_t h, uint32_t after) {
+  client_hot_t* c = server_chot(s, h);
+  if (!c)
+    return;
+
+  if (c->focus_slot) {
+    TRACE_LOG("focus_history move h=%lx slot=%u after=%u", h, c->focus_slot, after);
+    focus_mru_move_after(&s->focus_mru, c->focus_slot, after);
+  }
+  else {
+    c->focus_slot = focus_mru_insert_after(&s->focus_mru, after, h);
+    if (!c->focus_slot) {
+      LOG_ERROR("focus history allocation failed for client %lx", h);
+      return;
+    }
+  }
+  focus_mru_refresh(&s->focus_mru, c->focus_slot, c);
+}
+
+void wm_focus_history_remove(server_t* s, handle_t h) {
+  client_hot_t* c = server_chot(s, h);
+  if (!c || !c->focus_slot)
+    return;
+  TRACE_LOG("focus_history remove h=%lx slot=%u", h, c->focus_slot);
+  focus_mru_remove(&s->focus_mru, c->focus_slot);
+  c->focus_slot = 0;
+}
+
+void wm_focus_history_update(server_t* s, handle_t h) {
+  client_hot_t* c = server_chot(s, h);
+  if (c && c->focus_slot)
+    focus_mru_refresh(&s->focus_mru, c->focus_slot, c);
+}
+
+handle_t wm_focus_history_pick(server_t* s, const screen_t* scr, int32_t desktop, uint32_t need) {
+  focus_mru_t* m = &s->focus_mru;
+  for (uint32_t i = focus_mru_first(m); i != 0; i = focus_mru_next(m, i)) {
+    if (!focus_mru_match(m, i, desktop, need))
+      continue;
+    // Cached bits narrow the scan; the client itself has the final say
+    client_hot_t* c = server_chot(s, focus_mru_handle(m, i));
+    if (!c || (scr && &s->screens[c->screen] != scr))
+      continue;
+    if (!(need & FOCUS_MRU_MAPPED) || c->state == STATE_MAPPED)
+      return c->self;
+  }
+  return HANDLE_INVALID;
 }
 
 /*
@@ -62,8 +160,9 @@ void wm_install_client_colormap(server_t* s, client_hot_t* hot) {
  * Update the focused client.
  *
  * Actions:
- * - Update `s->focused_client`
- * - Mark the old and new clients as dirty (for frame redraws)
+ * - Update `s->focused_client` and the clients' CLIENT_FLAG_FOCUSED
+ * - Leave restyling to the flush, which repaints only the clients whose
+ * focus state differs from the last committed one
  * - Move the new client to the head of the MRU focus list
  * - Mark `ROOT_DIRTY_ACTIVE_WINDOW` to trigger the X11 focus update in the
  * flush phase
@@ -84,12 +183,13 @@ void wm_set_focus(server_t* s, handle_t h) {
   if (s->focused_client == h)
     return;
 
-  // Unfocus old
+  // Unfocus old; restyling waits for the flush, see wm_flush_focus_style
   if (s->focused_client != HANDLE_INVALID) {
     client_hot_t* old = server_chot(s, s->focused_client);
     if (old) {
       old->flags &= ~CLIENT_FLAG_FOCUSED;
-      old->dirty |= DIRTY_FRAME_STYLE | DIRTY_STATE;
+      // Its screen's _NET_ACTIVE_WINDOW goes back to None
+      client_screen(s, old)->root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
     }
   }
   wm_cancel_interaction(s);
@@ -97,16 +197,13 @@ void wm_set_focus(server_t* s, handle_t h) {
 
   if (c) {
     c->flags |= CLIENT_FLAG_FOCUSED;
-    c->dirty |= DIRTY_FRAME_STYLE | DIRTY_STATE;
 
     // Move to MRU head
-    if (list_node_linked(&c->focus_node)) {
-      TRACE_LOG("set_focus remove focus_node h=%lx node=%p prev=%p next=%p", h, (void*)&c->focus_node, (void*)c->focus_node.prev, (void*)c->focus_node.next);
-      list_remove(&c->focus_node);
-    }
     TRACE_ONLY(diag_dump_focus_history(s, "before focus insert"));
-    list_insert(&c->focus_node, &s->focus_history, s->focus_history.next);
+    wm_focus_history_insert(s, h, 0);
     TRACE_ONLY(diag_dump_focus_history(s, "after focus insert"));
+    screen_t* scr = client_screen(s, c);
+    wm_desktop_focus_note(s, scr->current_desktop, h);
 
     if (s->config.focus_raise) {
       TRACE_LOG("set_focus raise h=%lx", h);
@@ -114,11 +211,11 @@ void wm_set_focus(server_t* s, handle_t h) {
     }
 
     // Mark deferred update
-    s->root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
+    scr->root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
   }
   else {
     // Focus root or None
     TRACE_LOG("set_focus root");
-    s->root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
+    server_screen(s)->root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
   }
 }
@@ -7,6 +7,7 @@
 #include <X11/cursorfont.h>
 #include <assert.h>
 #include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -17,6 +18,10 @@
 #include "wm_internal.h"
 
 void frame_init_resources(server_t* s) {
+  // Theme tiles are rendered on first paint with the current theme
+  render_tiles_init(&s->frame_tiles);
+  render_text_configure(s->config.font_name);
+
   // Cursors
   xcb_font_t cursor_font = xcb_generate_id(s->conn);
   xcb_open_font(s->conn, cursor_font, strlen("cursor"), "cursor");
@@ -46,6 +51,8 @@ void frame_init_resources(server_t* s) {
 }
 
 void frame_cleanup_resources(server_t* s) {
+  render_tiles_destroy(&s->frame_tiles);
+
   if (!s->conn)
     return;
 
@@ -101,26 +108,49 @@ static bool frame_render_disabled(void) {
   return cached != 0;
 }
 
-static xcb_rectangle_t get_button_rect(server_t* s, client_hot_t* hot, frame_button_t btn) {
-  uint32_t frame_w_calc = (uint32_t)hot->server.w + (uint32_t)(2u * (uint32_t)s->config.theme.border_width);
-  if (frame_w_calc > MAX_FRAME_SIZE)
-    frame_w_calc = MAX_FRAME_SIZE;
-  uint16_t frame_w = (uint16_t)frame_w_calc;
-  // Buttons are laid out inside the right border
-  int32_t x_calc = (int32_t)frame_w - (int32_t)s->config.theme.border_width - BUTTON_PADDING - BUTTON_WIDTH;
-  if (x_calc < INT16_MIN)
-    x_calc = INT16_MIN;
-  if (x_calc > INT16_MAX)
-    x_calc = INT16_MAX;
-  int16_t x = (int16_t)x_calc;
-  int16_t y = (int16_t)((s->config.theme.title_height - BUTTON_HEIGHT) / 2);
-
-  if (btn == FRAME_BUTTON_MAXIMIZE)
-    x -= (BUTTON_WIDTH + BUTTON_PADDING);
-  if (btn == FRAME_BUTTON_MINIMIZE)
-    x -= 2 * (BUTTON_WIDTH + BUTTON_PADDING);
-
-  return (xcb_rectangle_t){x, y, BUTTON_WIDTH, BUTTON_HEIGHT};
+static int16_t frame_hit_clamp(int32_t v) {
+  if (v < INT16_MIN)
+    return INT16_MIN;
+  if (v > INT16_MAX)
+    return INT16_MAX;
+  return (int16_t)v;
+}
+
+static void frame_hit_build(server_t* s, client_hot_t* hot) {
+  frame_hit_t* t = &hot->frame_hit;
+  bool undecorated = (hot->flags & CLIENT_FLAG_UNDECORATED) != 0;
+  uint32_t bw = undecorated ? 0 : s->config.theme.border_width;
+  uint32_t th = undecorated ? 0 : s->config.theme.title_height;
+  if (bw > UINT16_MAX)
+    bw = UINT16_MAX;
+
+  uint32_t frame_w = (uint32_t)hot->server.w + 2u * bw;
+  uint32_t frame_h = (uint32_t)hot->server.h + th + bw;
+  if (frame_w > MAX_FRAME_SIZE)
+    frame_w = MAX_FRAME_SIZE;
+  if (frame_h > MAX_FRAME_SIZE)
+    frame_h = MAX_FRAME_SIZE;
+
+  int32_t right_edge = (int32_t)frame_w - (int32_t)bw;
+  int32_t bottom_edge = (int32_t)frame_h - (int32_t)bw;
+
+  t->w = hot->server.w;
+  t->h = hot->server.h;
+  t->bw = (uint16_t)bw;
+  t->right_edge = frame_hit_clamp(right_edge < 0 ? 0 : right_edge);
+  t->bottom_edge = frame_hit_clamp(bottom_edge < 0 ? 0 : bottom_edge);
+  // Buttons are laid out inside the right border, closest first
+  t->button_x = frame_hit_clamp((int32_t)frame_w - (int32_t)s->config.theme.border_width - BUTTON_PADDING - BUTTON_WIDTH);
+  t->button_y = (int16_t)(((int32_t)s->config.theme.title_height - BUTTON_HEIGHT) / 2);
+  t->flags = (uint8_t)(FRAME_HIT_VALID | (undecorated ? FRAME_HIT_UNDECORATED : 0));
+}
+
+const frame_hit_t* frame_hit_table(server_t* s, client_hot_t* hot) {
+  const frame_hit_t* t = &hot->frame_hit;
+  bool undecorated = (hot->flags & CLIENT_FLAG_UNDECORATED) != 0;
+  if (!(t->flags & FRAME_HIT_VALID) || t->w != hot->server.w || t->h != hot->server.h || ((t->flags & FRAME_HIT_UNDECORATED) != 0) != undecorated)
+    frame_hit_build(s, hot);
+  return t;
 }
 
 void frame_redraw(server_t* s, handle_t h, uint32_t what) {
@@ -129,30 +159,34 @@ void frame_redraw(server_t* s, handle_t h, uint32_t what) {
     return;
 
   if (what & FRAME_REDRAW_ALL) {
-    hot->dirty |= DIRTY_FRAME_ALL;
+    server_mark_dirty(s, hot, DIRTY_FRAME_ALL);
   }
   else {
     if (what & FRAME_REDRAW_TITLE)
-      hot->dirty |= DIRTY_FRAME_TITLE;
+      server_mark_dirty(s, hot, DIRTY_FRAME_TITLE);
     if (what & FRAME_REDRAW_BORDER)
-      hot->dirty |= DIRTY_FRAME_BORDER;
+      server_mark_dirty(s, hot, DIRTY_FRAME_BORDER);
     if (what & FRAME_REDRAW_BUTTONS)
-      hot->dirty |= DIRTY_FRAME_BUTTONS;
+      server_mark_dirty(s, hot, DIRTY_FRAME_BUTTONS);
   }
 }
 
-void frame_redraw_region(server_t* s, handle_t h, const dirty_region_t* dirty) {
+void frame_redraw_region(server_t* s, handle_t h, const dirty_rects_t* dirty) {
   client_hot_t* hot = server_chot(s, h);
   client_cold_t* cold = server_ccold(s, h);
   if (!hot || !cold)
     return;
 
-  if (dirty && dirty->valid) {
-    dirty_region_union(&cold->frame_damage, dirty);
+  if (dirty && !dirty_rects_empty(dirty)) {
+    // Exposed areas were already filled from the backing pixmap
+    if (cold->frame_pixmap != XCB_NONE)
+      return;
+    dirty_rects_union(&cold->frame_damage, dirty);
     // Let frame_flush use frame_damage as the clip region
+    server_queue_client(s, hot);
   }
   else {
-    hot->dirty |= DIRTY_FRAME_ALL;
+    server_mark_dirty(s, hot, DIRTY_FRAME_ALL);
   }
 }
 
@@ -176,18 +210,18 @@ void frame_flush(server_t* s, handle_t h) {
   const uint32_t frame_dirty_mask = DIRTY_FRAME_ALL | DIRTY_FRAME_TITLE | DIRTY_FRAME_BUTTONS | DIRTY_FRAME_BORDER | DIRTY_TITLE | DIRTY_FRAME_STYLE;
   uint32_t f_dirty = hot->dirty & frame_dirty_mask;
 
-  if (!f_dirty && !cold->frame_damage.valid)
+  if (!f_dirty && dirty_rects_empty(&cold->frame_damage))
     return;
 
   if (frame_render_disabled()) {
     hot->dirty &= ~frame_dirty_mask;
-    dirty_region_reset(&cold->frame_damage);
+    dirty_rects_reset(&cold->frame_damage);
     return;
   }
 
   if (hot->flags & CLIENT_FLAG_UNDECORATED) {
     hot->dirty &= ~frame_dirty_mask;
-    dirty_region_reset(&cold->frame_damage);
+    dirty_rects_reset(&cold->frame_damage);
     return;
   }
 
@@ -206,22 +240,46 @@ void frame_flush(server_t* s, handle_t h) {
   uint16_t frame_w = (uint16_t)frame_w_calc;
   uint16_t frame_h = (uint16_t)frame_h_calc;
 
-  // Frames are always created with the root visual/depth
-  xcb_visualtype_t* visual = s->root_visual_type;
+  // Frames are always created with the visual/depth of their screen's root
+  const screen_t* scr = client_screen(s, hot);
+  xcb_visualtype_t* visual = scr->root_visual_type;
   if (!visual) {
     LOG_WARN("No root visual found, skipping redraw for client %u", hot->xid);
     return;
   }
 
-  const dirty_region_t* clip_ptr = NULL;
-  dirty_region_t partial_clip = {0};
+  // Pixmaps cannot be resized, so a new size means a new, fully painted one
+  bool full_paint = false;
+  if (s->config.frame_backing) {
+    if (cold->frame_pixmap == XCB_NONE || cold->frame_pixmap_w != frame_w || cold->frame_pixmap_h != frame_h) {
+      // The window keeps the old pixmap alive as its background until replaced
+      client_frame_backing_destroy(s->conn, cold);
+      cold->frame_pixmap = xcb_generate_id(s->conn);
+      xcb_create_pixmap(s->conn, (uint8_t)scr->root_depth, cold->frame_pixmap, hot->frame, frame_w, frame_h);
+      cold->frame_pixmap_w = frame_w;
+      cold->frame_pixmap_h = frame_h;
+      full_paint = true;
+    }
+  }
+  else if (cold->frame_pixmap != XCB_NONE) {
+    // Backing was turned off by a reload
+    client_frame_backing_destroy(s->conn, cold);
+    uint32_t pixel = FRAME_BACKGROUND_PIXEL;
+    xcb_change_window_attributes(s->conn, hot->frame, XCB_CW_BACK_PIXEL, &pixel);
+    full_paint = true;
+  }
+  xcb_drawable_t target = cold->frame_pixmap != XCB_NONE ? cold->frame_pixmap : hot->frame;
+
+  const dirty_rects_t* clip_ptr = NULL;
+  dirty_rects_t partial_clip;
+  dirty_rects_reset(&partial_clip);
 
-  if (!(hot->dirty & (DIRTY_FRAME_ALL | DIRTY_FRAME_STYLE))) {
-    if (cold->frame_damage.valid) {
+  if (!full_paint && !(hot->dirty & (DIRTY_FRAME_ALL | DIRTY_FRAME_STYLE))) {
+    if (!dirty_rects_empty(&cold->frame_damage)) {
       clip_ptr = &cold->frame_damage;
     }
     else if (hot->dirty & (DIRTY_FRAME_TITLE | DIRTY_TITLE)) {
-      partial_clip = dirty_region_make(0, 0, frame_w, (uint16_t)s->config.theme.title_height);
+      partial_clip = dirty_rects_make(0, 0, frame_w, (uint16_t)s->config.theme.title_height);
       clip_ptr = &partial_clip;
     }
     else if (hot->dirty & DIRTY_FRAME_BUTTONS) {
@@ -245,29 +303,70 @@ void frame_flush(server_t* s, handle_t h) {
       if (clip_h_calc > UINT16_MAX)
         clip_h_calc = UINT16_MAX;
 
-      partial_clip = dirty_region_make(clip_x, 0, (uint16_t)clip_w_calc, (uint16_t)clip_h_calc);
+      partial_clip = dirty_rects_make(clip_x, 0, (uint16_t)clip_w_calc, (uint16_t)clip_h_calc);
       clip_ptr = &partial_clip;
     }
   }
 
-  render_frame(s->conn, hot->frame, visual, &cold->render_ctx, (int)s->root_depth, s->is_test, cold->title ? cold->title : "", active, frame_w, frame_h,
-               &s->config.theme, cold->icon_surface ? cold->icon_surface : s->default_icon, clip_ptr);
+  const char* title = cold->title ? cold->title : "";
+  char hung_title[256];
+  if (cold->ping_hung) {
+    snprintf(hung_title, sizeof(hung_title), "%s (not responding)", title);
+    title = hung_title;
+  }
+
+  client_icon_request(s, h);
+  render_frame(s->conn, target, visual, &cold->render_ctx, (int)scr->root_depth, s->is_test, title, active, frame_w, frame_h,
+               &s->config.theme, &s->frame_tiles, &s->title_cache, cold->icon_surface ? cold->icon_surface : s->default_icon, clip_ptr);
+  client_manage_painted(hot, cold);
+
+  if (cold->frame_pixmap != XCB_NONE) {
+    // Re-set the background so the server picks up the new contents, then
+    // repaint only what was drawn; width/height 0 clears to the window edge
+    xcb_change_window_attributes(s->conn, hot->frame, XCB_CW_BACK_PIXMAP, &cold->frame_pixmap);
+    if (clip_ptr && !dirty_rects_empty(clip_ptr)) {
+      for (uint8_t i = 0; i < clip_ptr->count; i++) {
+        const dirty_rect_t* r = &clip_ptr->rects[i];
+        xcb_clear_area(s->conn, 0, hot->frame, r->x, r->y, r->w, r->h);
+      }
+    }
+    else
+      xcb_clear_area(s->conn, 0, hot->frame, 0, 0, 0, 0);
+  }
 
   hot->dirty &= ~frame_dirty_mask;
-  dirty_region_reset(&cold->frame_damage);
+  dirty_rects_reset(&cold->frame_damage);
+}
+
+void frame_collect_title_runs(server_t* s) {
+  if (render_worker_collect(&s->render_worker, &s->title_cache) == 0)
+    return;
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t h = s->active_clients.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (hot && cold && cold->render_ctx.title_pending)
+      server_mark_dirty(s, hot, DIRTY_FRAME_TITLE);
+  }
 }
 
 frame_button_t frame_get_button_at(server_t* s, handle_t h, int16_t x, int16_t y) {
   client_hot_t* hot = server_chot(s, h);
-  if (!hot || (hot->flags & CLIENT_FLAG_UNDECORATED))
+  if (!hot)
+    return FRAME_BUTTON_NONE;
+
+  const frame_hit_t* t = frame_hit_table(s, hot);
+  if (t->flags & FRAME_HIT_UNDECORATED)
+    return FRAME_BUTTON_NONE;
+  if (y < t->button_y || y >= t->button_y + BUTTON_HEIGHT)
     return FRAME_BUTTON_NONE;
 
-  frame_button_t btns[] = {FRAME_BUTTON_CLOSE, FRAME_BUTTON_MAXIMIZE, FRAME_BUTTON_MINIMIZE};
+  static const frame_button_t btns[] = {FRAME_BUTTON_CLOSE, FRAME_BUTTON_MAXIMIZE, FRAME_BUTTON_MINIMIZE};
+  int32_t bx = t->button_x;
   for (int i = 0; i < 3; i++) {
-    xcb_rectangle_t br = get_button_rect(s, hot, btns[i]);
-    if (x >= br.x && x < br.x + br.width && y >= br.y && y < br.y + br.height) {
+    if (x >= bx && x < bx + BUTTON_WIDTH)
       return btns[i];
-    }
+    bx -= BUTTON_WIDTH + BUTTON_PADDING;
   }
 
   return FRAME_BUTTON_NONE;
@@ -0,0 +1,122 @@
+/* frame_pool.c - Recycled frame windows with their render contexts */
+
+#include "frame_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame.h"
+#include "xcb_utils.h"
+
+static size_t render_bytes(const render_context_t* ctx) {
+  cairo_surface_t* surface = ctx->surface;
+  if (!surface || cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE)
+    return 0;
+  return (size_t)cairo_image_surface_get_stride(surface) * (size_t)cairo_image_surface_get_height(surface);
+}
+
+static void entry_destroy(frame_pool_entry_t* e, xcb_connection_t* conn) {
+  if (conn)
+    xcb_destroy_window(conn, e->frame);
+  render_free(&e->render);
+}
+
+void frame_pool_init(frame_pool_t* pool) {
+  memset(pool, 0, sizeof(*pool));
+}
+
+void frame_pool_destroy(frame_pool_t* pool, xcb_connection_t* conn) {
+  for (uint32_t i = 0; i < pool->count; i++)
+    entry_destroy(&pool->entries[i], conn);
+  pool->count = 0;
+  pool->closed = true;
+}
+
+bool frame_pool_take(frame_pool_t* pool, xcb_window_t root, uint8_t depth, xcb_visualid_t visual, xcb_window_t* frame, render_context_t* render) {
+  // Newest first: its render context is the most likely to be warm
+  for (uint32_t i = pool->count; i-- > 0;) {
+    frame_pool_entry_t* e = &pool->entries[i];
+    if (!e->settled || e->root != root || e->depth != depth || e->visual != visual)
+      continue;
+    *frame = e->frame;
+    *render = e->render;
+    memmove(e, e + 1, (pool->count - i - 1) * sizeof(*e));
+    pool->count--;
+    pool->hits++;
+    return true;
+  }
+  pool->misses++;
+  return false;
+}
+
+bool frame_pool_put(frame_pool_t* pool, xcb_connection_t* conn, uint32_t limit, xcb_window_t frame, xcb_window_t root, uint8_t depth, xcb_visualid_t visual,
+                    render_context_t* render) {
+  if (limit > FRAME_POOL_MAX)
+    limit = FRAME_POOL_MAX;
+  if (pool->closed || frame == XCB_NONE || pool->count >= limit || atoms._HXM_FRAME_POOL == XCB_ATOM_NONE)
+    return false;
+
+  // Anything still drawing into the old backing goes out before it is freed
+  if (render->surface)
+    cairo_surface_flush(render->surface);
+  render_release_title(render);
+  if (render->last_title) {
+    free(render->last_title);
+    render->last_title = NULL;
+  }
+  render->title_pending = false;
+
+  // Only the fence's PropertyNotify is wanted until the frame is handed out
+  xcb_unmap_window(conn, frame);
+  uint32_t values[] = {FRAME_BACKGROUND_PIXEL, XCB_EVENT_MASK_PROPERTY_CHANGE};
+  xcb_change_window_attributes(conn, frame, XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK, values);
+  xcb_delete_property(conn, frame, atoms._NET_WM_WINDOW_OPACITY);
+  xcb_delete_property(conn, frame, atoms._NET_WM_BYPASS_COMPOSITOR);
+  xcb_change_property(conn, XCB_PROP_MODE_APPEND, frame, atoms._HXM_FRAME_POOL, XCB_ATOM_CARDINAL, 32, 0, NULL);
+
+  frame_pool_entry_t* e = &pool->entries[pool->count++];
+  e->frame = frame;
+  e->root = root;
+  e->visual = visual;
+  e->depth = depth;
+  e->settled = false;
+  e->render = *render;
+  render_init(render);
+  pool->returned++;
+  return true;
+}
+
+bool frame_pool_settle(frame_pool_t* pool, xcb_window_t window, xcb_atom_t atom) {
+  if (atom != atoms._HXM_FRAME_POOL || atom == XCB_ATOM_NONE)
+    return false;
+  for (uint32_t i = 0; i < pool->count; i++) {
+    if (pool->entries[i].frame == window) {
+      pool->entries[i].settled = true;
+      return true;
+    }
+  }
+  // Fence of a frame trimmed meanwhile
+  return true;
+}
+
+size_t frame_pool_trim(frame_pool_t* pool, xcb_connection_t* conn, uint32_t keep) {
+  if (pool->count <= keep)
+    return 0;
+  uint32_t drop = pool->count - keep;
+  size_t bytes = 0;
+  for (uint32_t i = 0; i < drop; i++) {
+    bytes += render_bytes(&pool->entries[i].render);
+    entry_destroy(&pool->entries[i], conn);
+  }
+  memmove(pool->entries, pool->entries + drop, keep * sizeof(pool->entries[0]));
+  pool->count = keep;
+  pool->trimmed += drop;
+  return bytes;
+}
+
+size_t frame_pool_bytes(const frame_pool_t* pool) {
+  size_t bytes = 0;
+  for (uint32_t i = 0; i < pool->count; i++)
+    bytes += render_bytes(&pool->entries[i].render);
+  return bytes;
+}
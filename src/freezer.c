@@ -0,0 +1,174 @@
+/* freezer.c - Stop applications whose windows are all hidden */
+
+#include "freezer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hxm.h"
+
+static const char* freezer_proc_root(const freezer_t* f) {
+  return f->proc_root ? f->proc_root : "/proc";
+}
+
+static const char* freezer_cgroup_root(const freezer_t* f) {
+  return f->cgroup_root ? f->cgroup_root : "/sys/fs/cgroup";
+}
+
+static bool read_cgroup_of(const freezer_t* f, const char* who, char* out, size_t cap) {
+  char path[128];
+  char text[1024];
+  snprintf(path, sizeof(path), "%s/%s/cgroup", freezer_proc_root(f), who);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  ssize_t n = read(fd, text, sizeof(text) - 1u);
+  close(fd);
+  if (n <= 0)
+    return false;
+  text[n] = '\0';
+  return cgroup_parse_proc(text, out, cap);
+}
+
+static bool write_freeze(const freezer_t* f, const char* cgroup, bool on) {
+  char path[CGROUP_WORKER_PATH_MAX + 64];
+  snprintf(path, sizeof(path), "%s%s/cgroup.freeze", freezer_cgroup_root(f), cgroup);
+  int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  bool ok = write(fd, on ? "1" : "0", 1) == 1;
+  close(fd);
+  return ok;
+}
+
+/* A scope of its own: the app and nothing else, and not us */
+static bool freezer_cgroup_usable(freezer_t* f, const char* cgroup) {
+  if (!f->self_known) {
+    if (!read_cgroup_of(f, "self", f->self_cgroup, sizeof(f->self_cgroup)))
+      snprintf(f->self_cgroup, sizeof(f->self_cgroup), "/");
+    f->self_known = true;
+  }
+  if (cgroup_path_contains(cgroup, f->self_cgroup))
+    return false;
+  size_t len = strlen(cgroup);
+  return len > 6 && strcmp(cgroup + len - 6, ".scope") == 0;
+}
+
+static freeze_entry_t* freezer_find(const freezer_t* f, pid_t pid) {
+  for (size_t i = 0; i < f->count; i++) {
+    if (f->entries[i].pid == pid)
+      return &f->entries[i];
+  }
+  return NULL;
+}
+
+bool freezer_is_frozen(const freezer_t* f, pid_t pid) {
+  return freezer_find(f, pid) != NULL;
+}
+
+bool freezer_freeze(freezer_t* f, pid_t pid) {
+  if (pid <= 1 || pid == getpid())
+    return false;
+  if (freezer_find(f, pid))
+    return true;
+  if (f->count == f->cap) {
+    size_t cap = f->cap ? f->cap * 2u : 8u;
+    freeze_entry_t* grown = realloc(f->entries, cap * sizeof(*grown));
+    if (!grown)
+      return false;
+    f->entries = grown;
+    f->cap = cap;
+  }
+
+  freeze_entry_t e = {.pid = pid};
+  char who[24];
+  char cgroup[CGROUP_WORKER_PATH_MAX];
+  snprintf(who, sizeof(who), "%d", (int)pid);
+  if (read_cgroup_of(f, who, cgroup, sizeof(cgroup)) && freezer_cgroup_usable(f, cgroup) && write_freeze(f, cgroup, true)) {
+    e.method = FREEZE_CGROUP;
+    e.cgroup = strdup(cgroup);
+    if (!e.cgroup) {
+      write_freeze(f, cgroup, false);
+      return false;
+    }
+  }
+  else {
+    // Apps we launch lead their own session; one that shares our group stops alone
+    pid_t pgid = getpgid(pid);
+    e.target = (pgid > 1 && pgid != getpgrp()) ? -pgid : pid;
+    if (kill(e.target, SIGSTOP) < 0) {
+      LOG_DEBUG("freeze pid %d failed: %s", (int)pid, strerror(errno));
+      f->failed++;
+      return false;
+    }
+    e.method = FREEZE_SIGNAL;
+  }
+
+  f->entries[f->count++] = e;
+  f->frozen++;
+  return true;
+}
+
+static void freezer_release(freezer_t* f, freeze_entry_t* e) {
+  bool ok;
+  if (e->method == FREEZE_CGROUP)
+    ok = write_freeze(f, e->cgroup, false) || errno == ENOENT;
+  else
+    ok = kill(e->target, SIGCONT) == 0 || errno == ESRCH;
+  if (!ok) {
+    LOG_WARN("thaw pid %d failed: %s", (int)e->pid, strerror(errno));
+    f->failed++;
+  }
+  free(e->cgroup);
+  f->thawed++;
+}
+
+bool freezer_thaw(freezer_t* f, pid_t pid) {
+  freeze_entry_t* e = freezer_find(f, pid);
+  if (!e)
+    return false;
+  freezer_release(f, e);
+  *e = f->entries[--f->count];
+  return true;
+}
+
+void freezer_thaw_all(freezer_t* f) {
+  for (size_t i = 0; i < f->count; i++)
+    freezer_release(f, &f->entries[i]);
+  f->count = 0;
+}
+
+void freezer_destroy(freezer_t* f) {
+  freezer_thaw_all(f);
+  free(f->entries);
+  f->entries = NULL;
+  f->cap = 0;
+}
+
+size_t freezer_format(const freezer_t* f, char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+  buf[0] = '\0';
+  if (!f || f->frozen + f->failed == 0)
+    return 0;
+
+  int n = snprintf(buf, cap, "freezer: frozen_now=%zu frozen=%" PRIu64 " thawed=%" PRIu64 " failed=%" PRIu64 "\n", f->count, f->frozen,
+                   f->thawed, f->failed);
+  if (n <= 0)
+    return 0;
+  return (size_t)n < cap ? (size_t)n : cap - 1u;
+}
+
+void freezer_dump(const freezer_t* f) {
+  char buf[256];
+  if (freezer_format(f, buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
+}
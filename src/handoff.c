@@ -0,0 +1,369 @@
+/* handoff.c - Client model carried across an in-place restart */
+
+#include "handoff.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "event.h"
+#include "hxm.h"
+
+#define HANDOFF_MAGIC 0x48584d48u /* "HXMH" */
+#define HANDOFF_VERSION 1u
+#define HANDOFF_MAX_BYTES (64u * 1024u * 1024u)
+
+/*
+ * Layout, native endian (the reader is the same build, re-exec'd):
+ *   header: magic, version, root, count                      4 x u32
+ *   record: xid, desktop, x, y, w, h, base_layer, flags,
+ *           stack_rank, focus_rank                           fixed part
+ *           HANDOFF_STR_COUNT x (u16 length, bytes)          0xFFFF = NULL
+ */
+typedef struct handoff_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t root;
+  uint32_t count;
+} handoff_header_t;
+
+typedef struct handoff_record {
+  uint32_t xid;
+  int32_t desktop;
+  int16_t x, y;
+  uint16_t w, h;
+  uint8_t base_layer;
+  uint8_t flags;
+  uint16_t reserved;
+  uint32_t stack_rank;
+  uint32_t focus_rank;
+} handoff_record_t;
+
+#define HANDOFF_STR_NULL 0xFFFFu
+
+typedef struct handoff_buf {
+  uint8_t* data;
+  size_t len;
+  size_t cap;
+} handoff_buf_t;
+
+static bool handoff_buf_put(handoff_buf_t* b, const void* p, size_t n) {
+  if (b->len + n > b->cap) {
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + n)
+      cap *= 2;
+    uint8_t* data = realloc(b->data, cap);
+    if (!data)
+      return false;
+    b->data = data;
+    b->cap = cap;
+  }
+  memcpy(b->data + b->len, p, n);
+  b->len += n;
+  return true;
+}
+
+bool handoff_encode(xcb_window_t root, const handoff_client_t* clients, size_t count, uint8_t** out, size_t* out_len) {
+  handoff_buf_t b = {0};
+  handoff_header_t hdr = {HANDOFF_MAGIC, HANDOFF_VERSION, root, (uint32_t)count};
+  bool ok = handoff_buf_put(&b, &hdr, sizeof(hdr));
+
+  for (size_t i = 0; ok && i < count; i++) {
+    const handoff_client_t* c = &clients[i];
+    handoff_record_t rec = {
+        .xid = c->xid,
+        .desktop = c->desktop,
+        .x = c->geom.x,
+        .y = c->geom.y,
+        .w = c->geom.w,
+        .h = c->geom.h,
+        .base_layer = c->base_layer,
+        .flags = c->flags,
+        .stack_rank = c->stack_rank,
+        .focus_rank = c->focus_rank,
+    };
+    ok = handoff_buf_put(&b, &rec, sizeof(rec));
+    for (int k = 0; ok && k < HANDOFF_STR_COUNT; k++) {
+      const char* str = c->str[k];
+      size_t n = str ? strlen(str) : 0;
+      // A longer string than fits is truncated; the probe would cap it too
+      if (n >= HANDOFF_STR_NULL)
+        n = HANDOFF_STR_NULL - 1;
+      uint16_t len = str ? (uint16_t)n : (uint16_t)HANDOFF_STR_NULL;
+      ok = handoff_buf_put(&b, &len, sizeof(len)) && (n == 0 || handoff_buf_put(&b, str, n));
+    }
+  }
+
+  if (!ok) {
+    free(b.data);
+    return false;
+  }
+  *out = b.data;
+  *out_len = b.len;
+  return true;
+}
+
+static int handoff_stack_cmp(const void* a, const void* b) {
+  uint32_t ra = ((const handoff_client_t*)a)->stack_rank;
+  uint32_t rb = ((const handoff_client_t*)b)->stack_rank;
+  return (ra > rb) - (ra < rb);
+}
+
+void handoff_destroy(handoff_t* h) {
+  if (h->clients)
+    arena_destroy(&h->strings);
+  free(h->clients);
+  free(h->focus_slots);
+  hash_map_destroy(&h->by_xid);
+  memset(h, 0, sizeof(*h));
+}
+
+bool handoff_decode(handoff_t* h, const uint8_t* buf, size_t len) {
+  handoff_destroy(h);
+
+  handoff_header_t hdr;
+  if (len < sizeof(hdr))
+    return false;
+  memcpy(&hdr, buf, sizeof(hdr));
+  if (hdr.magic != HANDOFF_MAGIC || hdr.version != HANDOFF_VERSION)
+    return false;
+  // Every record needs at least its fixed part and string lengths
+  size_t min_record = sizeof(handoff_record_t) + HANDOFF_STR_COUNT * sizeof(uint16_t);
+  if (hdr.count == 0 || hdr.count > (len - sizeof(hdr)) / min_record)
+    return false;
+
+  h->clients = calloc(hdr.count, sizeof(*h->clients));
+  h->focus_slots = calloc(hdr.count, sizeof(*h->focus_slots));
+  if (!h->clients || !h->focus_slots) {
+    LOG_ERROR("handoff allocation failed");
+    abort();
+  }
+  arena_init(&h->strings, 4096);
+  hash_map_init(&h->by_xid);
+
+  size_t off = sizeof(hdr);
+  for (uint32_t i = 0; i < hdr.count; i++) {
+    handoff_record_t rec;
+    if (len - off < sizeof(rec))
+      goto invalid;
+    memcpy(&rec, buf + off, sizeof(rec));
+    off += sizeof(rec);
+    if (rec.xid == XCB_NONE || rec.focus_rank >= hdr.count || rec.base_layer >= LAYER_COUNT || rec.w == 0 || rec.h == 0)
+      goto invalid;
+
+    handoff_client_t* c = &h->clients[i];
+    c->xid = rec.xid;
+    c->desktop = rec.desktop;
+    c->geom = (rect_t){rec.x, rec.y, rec.w, rec.h};
+    c->base_layer = rec.base_layer;
+    c->flags = rec.flags;
+    c->stack_rank = rec.stack_rank;
+    c->focus_rank = rec.focus_rank;
+
+    for (int k = 0; k < HANDOFF_STR_COUNT; k++) {
+      uint16_t n;
+      if (len - off < sizeof(n))
+        goto invalid;
+      memcpy(&n, buf + off, sizeof(n));
+      off += sizeof(n);
+      if (n == HANDOFF_STR_NULL)
+        continue;
+      if (len - off < n)
+        goto invalid;
+      c->str[k] = arena_strndup(&h->strings, (const char*)buf + off, n);
+      off += n;
+    }
+  }
+  if (off != len)
+    goto invalid;
+
+  // Ranks are a permutation; focus_slots doubles as the seen set here
+  for (uint32_t i = 0; i < hdr.count; i++) {
+    handoff_client_t* c = &h->clients[i];
+    if (h->focus_slots[c->focus_rank] != HANDLE_INVALID)
+      goto invalid;
+    h->focus_slots[c->focus_rank] = (handle_t)1;
+  }
+  memset(h->focus_slots, 0, hdr.count * sizeof(*h->focus_slots));
+
+  qsort(h->clients, hdr.count, sizeof(*h->clients), handoff_stack_cmp);
+  h->count = hdr.count;
+  for (size_t i = 0; i < h->count; i++) {
+    if (hash_map_get(&h->by_xid, h->clients[i].xid))
+      goto invalid;
+    hash_map_insert(&h->by_xid, h->clients[i].xid, &h->clients[i]);
+  }
+  h->root = hdr.root;
+  h->active = true;
+  return true;
+
+invalid:
+  handoff_destroy(h);
+  return false;
+}
+
+const handoff_client_t* handoff_find(const handoff_t* h, xcb_window_t xid) {
+  if (!h->active)
+    return NULL;
+  return hash_map_get(&h->by_xid, xid);
+}
+
+void handoff_consume(handoff_t* h, xcb_window_t xid) {
+  if (!h->active)
+    return;
+  hash_map_remove(&h->by_xid, xid);
+  if (hash_map_empty(&h->by_xid)) {
+    LOG_INFO("Restart handoff complete");
+    handoff_destroy(h);
+  }
+}
+
+uint32_t handoff_focus_anchor(server_t* s, const handoff_client_t* c, handle_t h) {
+  handoff_t* ho = &s->handoff;
+  ho->focus_slots[c->focus_rank] = h;
+  for (uint32_t r = c->focus_rank; r-- > 0;) {
+    client_hot_t* prev = server_chot(s, ho->focus_slots[r]);
+    if (prev && prev->focus_slot)
+      return prev->focus_slot;
+  }
+  return 0;
+}
+
+static bool handoff_client_live(const client_hot_t* hot) {
+  return hot && (hot->state == STATE_MAPPED || hot->state == STATE_UNMAPPED) && hot->frame != XCB_NONE;
+}
+
+int handoff_save(server_t* s) {
+  size_t n = 0;
+  handoff_client_t* out = calloc(s->active_clients.length ? s->active_clients.length : 1, sizeof(*out));
+  if (!out)
+    return -1;
+  hash_map_t slots; /* handle -> record */
+  hash_map_init(&slots);
+
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t h = s->active_clients.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!handoff_client_live(hot) || !cold || hot->desired.w == 0 || hot->desired.h == 0)
+      continue;
+
+    handoff_client_t* c = &out[n++];
+    hash_map_insert(&slots, h, c);
+    c->xid = hot->xid;
+    c->desktop = hot->desktop;
+    c->geom = hot->desired;
+    c->base_layer = hot->base_layer;
+    c->flags = (hot->sticky ? HANDOFF_STICKY : 0) | (hot->state == STATE_UNMAPPED ? HANDOFF_ICONIC : 0) |
+               (cold->has_net_wm_name ? HANDOFF_NET_WM_NAME : 0) | (cold->has_net_wm_icon_name ? HANDOFF_NET_WM_ICON_NAME : 0);
+    c->stack_rank = UINT32_MAX;
+    c->focus_rank = UINT32_MAX;
+    c->str[HANDOFF_STR_CLASS] = cold->wm_class;
+    c->str[HANDOFF_STR_INSTANCE] = cold->wm_instance;
+    c->str[HANDOFF_STR_TITLE] = cold->base_title;
+    c->str[HANDOFF_STR_ICON_NAME] = cold->base_icon_name;
+    c->str[HANDOFF_STR_CLIENT_MACHINE] = cold->wm_client_machine;
+    c->str[HANDOFF_STR_COMMAND] = cold->wm_command;
+  }
+
+  // Stacked clients bottom to top, then the unstacked (iconified) ones.
+  // Ranks only compare within a screen, so screens simply follow each other
+  uint32_t rank = 0;
+  for (uint32_t sn = 0; sn < server_screen_count(s); sn++) {
+    const screen_t* scr = &s->screens[sn];
+    for (int l = 0; l < LAYER_COUNT; l++) {
+      for (size_t i = 0; i < scr->layers[l].length; i++) {
+        handoff_client_t* c = hash_map_get(&slots, scr->layers[l].items[i]);
+        if (c && c->stack_rank == UINT32_MAX)
+          c->stack_rank = rank++;
+      }
+    }
+  }
+  uint32_t focus = 0;
+  for (uint32_t i = focus_mru_first(&s->focus_mru); i != 0; i = focus_mru_next(&s->focus_mru, i)) {
+    handoff_client_t* c = hash_map_get(&slots, focus_mru_handle(&s->focus_mru, i));
+    if (c && c->focus_rank == UINT32_MAX)
+      c->focus_rank = focus++;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (out[i].stack_rank == UINT32_MAX)
+      out[i].stack_rank = rank++;
+    if (out[i].focus_rank == UINT32_MAX)
+      out[i].focus_rank = focus++;
+  }
+
+  uint8_t* blob = NULL;
+  size_t len = 0;
+  bool ok = n > 0 && handoff_encode(s->screens[0].root, out, n, &blob, &len);
+  hash_map_destroy(&slots);
+  free(out);
+  if (!ok)
+    return -1;
+
+  // Not close-on-exec: the next process inherits it
+  int fd = memfd_create("hxm-handoff", 0);
+  if (fd < 0) {
+    LOG_WARN("handoff memfd failed: %s", strerror(errno));
+    free(blob);
+    return -1;
+  }
+  size_t done = 0;
+  while (done < len) {
+    ssize_t w = write(fd, blob + done, len - done);
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w <= 0) {
+      LOG_WARN("handoff write failed: %s", strerror(errno));
+      close(fd);
+      free(blob);
+      return -1;
+    }
+    done += (size_t)w;
+  }
+  free(blob);
+  LOG_INFO("Handing off %zu clients (%zu bytes)", n, len);
+  return fd;
+}
+
+int handoff_env_fd(void) {
+  const char* env = getenv(HANDOFF_ENV);
+  if (!env)
+    return -1;
+  char* end = NULL;
+  long fd = strtol(env, &end, 10);
+  if (!end || *end != '\0' || fd <= 2 || fd >= INT32_MAX)
+    return -1;
+  return (int)fd;
+}
+
+bool handoff_load(handoff_t* h, xcb_window_t root) {
+  if (!getenv(HANDOFF_ENV))
+    return false;
+  int fd = handoff_env_fd();
+  unsetenv(HANDOFF_ENV);
+  if (fd < 0)
+    return false;
+
+  bool ok = false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size <= HANDOFF_MAX_BYTES) {
+    size_t len = (size_t)st.st_size;
+    uint8_t* buf = malloc(len);
+    if (buf && pread(fd, buf, len, 0) == (ssize_t)len)
+      ok = handoff_decode(h, buf, len) && h->root == root;
+    free(buf);
+  }
+  close(fd);
+
+  if (!ok) {
+    LOG_WARN("Ignoring invalid restart handoff");
+    handoff_destroy(h);
+    return false;
+  }
+  LOG_INFO("Restart handoff: %zu clients", h->count);
+  return true;
+}
@@ -0,0 +1,482 @@
+/* icon_cache.c - Shared, deduplicated client icon surfaces */
+
+#include "icon_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// SSE2 is baseline on x86-64; AVX2 is picked at runtime. NEON is baseline on AArch64.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#define ICON_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define ICON_SIMD_X86 0
+#endif
+
+#if !ICON_SIMD_X86 && defined(__ARM_NEON)
+#define ICON_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define ICON_SIMD_NEON 0
+#endif
+
+/*
+ * Per-surface bookkeeping, attached as cairo user data so it dies with the
+ * surface. Interned icons also carry their cache key so the last
+ * cairo_surface_destroy() unlinks them from the cache.
+ */
+typedef struct icon_meta {
+  icon_cache_t* cache;
+  cairo_surface_t* self; /* weak, only compared against cache entries */
+  uint64_t key;
+  uint32_t next_evict;
+  struct {
+    int size;
+    cairo_surface_t* surface;
+  } variants[ICON_CACHE_VARIANTS];
+} icon_meta_t;
+
+static const cairo_user_data_key_t icon_meta_key;
+
+static void icon_meta_destroy(void* data) {
+  icon_meta_t* meta = (icon_meta_t*)data;
+  if (meta->cache && hash_map_get(&meta->cache->by_hash, meta->key) == meta->self)
+    hash_map_remove(&meta->cache->by_hash, meta->key);
+
+  for (size_t i = 0; i < ICON_CACHE_VARIANTS; i++) {
+    if (meta->variants[i].surface)
+      cairo_surface_destroy(meta->variants[i].surface);
+  }
+  free(meta);
+}
+
+static icon_meta_t* icon_meta_get(cairo_surface_t* surface) {
+  icon_meta_t* meta = cairo_surface_get_user_data(surface, &icon_meta_key);
+  if (meta)
+    return meta;
+
+  meta = calloc(1, sizeof(*meta));
+  if (!meta)
+    return NULL;
+  meta->self = surface;
+  if (cairo_surface_set_user_data(surface, &icon_meta_key, meta, icon_meta_destroy) != CAIRO_STATUS_SUCCESS) {
+    free(meta);
+    return NULL;
+  }
+  return meta;
+}
+
+/*
+ * Premultiply kernels.
+ *
+ * All kernels compute round(c * a / 255) as ((t + (t >> 8)) >> 8) with
+ * t = c * a + 128, which is exact for 8-bit inputs and equal to the scalar
+ * (c * a + 127) / 255. Alpha is multiplied by 255 so it passes through, and
+ * a == 0 yields 0 without a branch. Results are bit-identical across kernels.
+ */
+void icon_premultiply_scalar(uint32_t* dst, const uint32_t* src, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    uint32_t pixel = src[i];
+    uint8_t a = (uint8_t)(pixel >> 24);
+    uint8_t r = (uint8_t)(pixel >> 16);
+    uint8_t g = (uint8_t)(pixel >> 8);
+    uint8_t b = (uint8_t)pixel;
+    if (a == 0) {
+      r = 0;
+      g = 0;
+      b = 0;
+    }
+    else if (a < 255) {
+      // Cairo expects premultiplied ARGB32
+      r = (uint8_t)((r * a + 127) / 255);
+      g = (uint8_t)((g * a + 127) / 255);
+      b = (uint8_t)((b * a + 127) / 255);
+    }
+    dst[i] = ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+}
+
+#if ICON_SIMD_X86
+static inline __m128i premul_epi16_sse2(__m128i px, __m128i alpha_lane) {
+  // px: 2 pixels as 16-bit b,g,r,a lanes; broadcast each pixel's alpha
+  __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  a = _mm_or_si128(_mm_andnot_si128(alpha_lane, a), _mm_and_si128(alpha_lane, _mm_set1_epi16(255)));
+  __m128i t = _mm_add_epi16(_mm_mullo_epi16(px, a), _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void icon_premultiply_sse2(uint32_t* dst, const uint32_t* src, size_t n) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha_lane = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i lo = premul_epi16_sse2(_mm_unpacklo_epi8(v, zero), alpha_lane);
+    __m128i hi = premul_epi16_sse2(_mm_unpackhi_epi8(v, zero), alpha_lane);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+  }
+  icon_premultiply_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2"))) static inline __m256i premul_epi16_avx2(__m256i px, __m256i alpha_lane) {
+  __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  a = _mm256_blendv_epi8(a, _mm256_set1_epi16(255), alpha_lane);
+  __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(px, a), _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2"))) static void icon_premultiply_avx2(uint32_t* dst, const uint32_t* src, size_t n) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i alpha_lane = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    // unpack/pack work per 128-bit lane, so pixel order is preserved
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i lo = premul_epi16_avx2(_mm256_unpacklo_epi8(v, zero), alpha_lane);
+    __m256i hi = premul_epi16_avx2(_mm256_unpackhi_epi8(v, zero), alpha_lane);
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+  }
+  icon_premultiply_sse2(dst + i, src + i, n - i);
+}
+#endif
+
+#if ICON_SIMD_NEON
+static void icon_premultiply_neon(uint32_t* dst, const uint32_t* src, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    // Deinterleave 8 pixels into b, g, r, a planes
+    uint8x8x4_t px = vld4_u8((const uint8_t*)(src + i));
+    uint8x8_t a = px.val[3];
+    for (int c = 0; c < 3; c++) {
+      uint16x8_t x = vmull_u8(px.val[c], a);
+      px.val[c] = vraddhn_u16(x, vrshrq_n_u16(x, 8));
+    }
+    vst4_u8((uint8_t*)(dst + i), px);
+  }
+  icon_premultiply_scalar(dst + i, src + i, n - i);
+}
+#endif
+
+typedef void (*icon_premultiply_fn)(uint32_t* dst, const uint32_t* src, size_t n);
+
+static icon_premultiply_fn icon_premultiply_impl;
+static const char* icon_premultiply_impl_name;
+
+static void icon_premultiply_select(void) {
+  icon_premultiply_impl = icon_premultiply_scalar;
+  icon_premultiply_impl_name = "scalar";
+#if ICON_SIMD_X86
+  icon_premultiply_impl = icon_premultiply_sse2;
+  icon_premultiply_impl_name = "sse2";
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    icon_premultiply_impl = icon_premultiply_avx2;
+    icon_premultiply_impl_name = "avx2";
+  }
+#elif ICON_SIMD_NEON
+  icon_premultiply_impl = icon_premultiply_neon;
+  icon_premultiply_impl_name = "neon";
+#endif
+}
+
+void icon_premultiply(uint32_t* dst, const uint32_t* src, size_t n) {
+  if (!icon_premultiply_impl)
+    icon_premultiply_select();
+  icon_premultiply_impl(dst, src, n);
+}
+
+const char* icon_premultiply_kernel(void) {
+  if (!icon_premultiply_impl)
+    icon_premultiply_select();
+  return icon_premultiply_impl_name;
+}
+
+// FNV-1a over 32-bit words; hash_map_t remixes keys, 0 is reserved
+static uint64_t icon_hash(const uint32_t* argb, uint32_t w, uint32_t h) {
+  uint64_t x = 0xcbf29ce484222325ull ^ (((uint64_t)w << 32) | h);
+  size_t n = (size_t)w * h;
+  for (size_t i = 0; i < n; i++)
+    x = (x ^ argb[i]) * 0x100000001b3ull;
+  return x ? x : 1;
+}
+
+// Hashes can collide: confirm by converting in chunks and comparing
+static bool icon_matches(cairo_surface_t* surface, const uint32_t* argb, uint32_t w, uint32_t h) {
+  if (cairo_image_surface_get_width(surface) != (int)w || cairo_image_surface_get_height(surface) != (int)h)
+    return false;
+
+  const unsigned char* data = cairo_image_surface_get_data(surface);
+  int stride = cairo_image_surface_get_stride(surface);
+  if (!data)
+    return false;
+
+  uint32_t tmp[256];
+  for (uint32_t y = 0; y < h; y++) {
+    const uint32_t* row = (const uint32_t*)(data + (size_t)y * (size_t)stride);
+    const uint32_t* src = argb + (size_t)y * w;
+    for (uint32_t x = 0; x < w; x += 256) {
+      size_t n = (w - x < 256) ? (size_t)(w - x) : 256;
+      icon_premultiply(tmp, src + x, n);
+      if (memcmp(tmp, row + x, n * sizeof(uint32_t)) != 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+void icon_cache_init(icon_cache_t* cache) {
+  hash_map_init(&cache->by_hash);
+  cache->hits = 0;
+  cache->misses = 0;
+}
+
+void icon_cache_destroy(icon_cache_t* cache) {
+  // Entries are weak; surfaces still held by clients just stop being shared
+  hash_map_destroy(&cache->by_hash);
+  cache->hits = 0;
+  cache->misses = 0;
+}
+
+cairo_surface_t* icon_cache_intern(icon_cache_t* cache, const uint32_t* argb, uint32_t w, uint32_t h) {
+  uint64_t key = icon_hash(argb, w, h);
+  cairo_surface_t* hit = hash_map_get(&cache->by_hash, key);
+  if (hit && icon_matches(hit, argb, w, h)) {
+    cache->hits++;
+    return cairo_surface_reference(hit);
+  }
+  cache->misses++;
+
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)w, (int)h);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+    return surface;  // inert error surface, safe to paint and destroy
+
+  unsigned char* dest = cairo_image_surface_get_data(surface);
+  int stride = cairo_image_surface_get_stride(surface);
+  cairo_surface_flush(surface);
+  for (uint32_t y = 0; y < h; y++)
+    icon_premultiply((uint32_t*)(dest + (size_t)y * (size_t)stride), argb + (size_t)y * w, w);
+  cairo_surface_mark_dirty(surface);
+
+  // On a true collision the newcomer simply stays private
+  if (!hit) {
+    icon_meta_t* meta = icon_meta_get(surface);
+    if (meta) {
+      meta->cache = cache;
+      meta->key = key;
+      hash_map_insert(&cache->by_hash, key, surface);
+    }
+  }
+  return surface;
+}
+
+cairo_surface_t* icon_cache_scaled(cairo_surface_t* icon, int size) {
+  if (!icon || size <= 0 || cairo_surface_get_type(icon) != CAIRO_SURFACE_TYPE_IMAGE)
+    return NULL;
+
+  int w = cairo_image_surface_get_width(icon);
+  int h = cairo_image_surface_get_height(icon);
+  if (w <= 0 || h <= 0)
+    return NULL;
+  int longest = (w > h) ? w : h;
+  if (longest == size)
+    return icon;
+
+  icon_meta_t* meta = icon_meta_get(icon);
+  if (!meta)
+    return NULL;
+  for (size_t i = 0; i < ICON_CACHE_VARIANTS; i++) {
+    if (meta->variants[i].surface && meta->variants[i].size == size)
+      return meta->variants[i].surface;
+  }
+
+  double scale = (double)size / (double)longest;
+  int dw = (int)(w * scale + 0.5);
+  int dh = (int)(h * scale + 0.5);
+  if (dw < 1)
+    dw = 1;
+  if (dh < 1)
+    dh = 1;
+
+  cairo_surface_t* variant = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, dw, dh);
+  cairo_t* cr = cairo_create(variant);
+  cairo_scale(cr, scale, scale);
+  cairo_set_source_surface(cr, icon, 0, 0);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+  cairo_surface_flush(variant);
+
+  size_t slot = ICON_CACHE_VARIANTS;
+  for (size_t i = 0; i < ICON_CACHE_VARIANTS && slot == ICON_CACHE_VARIANTS; i++) {
+    if (!meta->variants[i].surface)
+      slot = i;
+  }
+  if (slot == ICON_CACHE_VARIANTS) {
+    slot = meta->next_evict++ % ICON_CACHE_VARIANTS;
+    cairo_surface_destroy(meta->variants[slot].surface);
+  }
+  meta->variants[slot].size = size;
+  meta->variants[slot].surface = variant;
+  return variant;
+}
+
+/*
+ * Disk cache entry: header, then h rows of stride bytes of premultiplied
+ * ARGB32 exactly as cairo stores them, so a hit maps straight into a surface.
+ */
+#define ICON_DISK_MAGIC 0x4e4f4349584d4858ull /* "HXMICON" + version 1 */
+
+typedef struct icon_disk_header {
+  uint64_t magic;
+  int64_t src_mtime_ns;
+  int64_t src_size;
+  int32_t size;
+  int32_t w;
+  int32_t h;
+  int32_t stride;
+  uint64_t reserved;
+} icon_disk_header_t;
+
+typedef struct icon_disk_map {
+  void* addr;
+  size_t len;
+} icon_disk_map_t;
+
+static const cairo_user_data_key_t icon_disk_map_key;
+
+static void icon_disk_map_release(void* data) {
+  icon_disk_map_t* map = (icon_disk_map_t*)data;
+  munmap(map->addr, map->len);
+  free(map);
+}
+
+static bool icon_disk_path(const char* src, int size, bool create_dir, char* buf, size_t cap) {
+  const char* xdg = getenv("XDG_CACHE_HOME");
+  const char* home = getenv("HOME");
+  char dir[PATH_MAX];
+  int n;
+  if (xdg && xdg[0] != '\0')
+    n = snprintf(dir, sizeof(dir), "%s/hxm/icons", xdg);
+  else if (home && home[0] != '\0')
+    n = snprintf(dir, sizeof(dir), "%s/.cache/hxm/icons", home);
+  else
+    return false;
+  if (n < 0 || (size_t)n >= sizeof(dir))
+    return false;
+
+  if (create_dir) {
+    // mkdir -p, the cache root may not exist yet
+    for (char* p = dir + 1; *p; p++) {
+      if (*p != '/')
+        continue;
+      *p = '\0';
+      (void)mkdir(dir, 0700);
+      *p = '/';
+    }
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST)
+      return false;
+  }
+
+  // FNV-1a of the source path
+  uint64_t hash = 14695981039346656037ull;
+  for (const char* c = src; *c; c++)
+    hash = (hash ^ (uint8_t)*c) * 1099511628211ull;
+  n = snprintf(buf, cap, "%s/%016llx-%d.argb", dir, (unsigned long long)hash, size);
+  return n > 0 && (size_t)n < cap;
+}
+
+static int64_t icon_disk_mtime_ns(const struct stat* st) {
+  return (int64_t)st->st_mtim.tv_sec * 1000000000ll + (int64_t)st->st_mtim.tv_nsec;
+}
+
+cairo_surface_t* icon_cache_disk_load(const char* path, int size) {
+  char cache_path[PATH_MAX];
+  struct stat src_st;
+  if (!path || size <= 0 || stat(path, &src_st) != 0 || !icon_disk_path(path, size, false, cache_path, sizeof(cache_path)))
+    return NULL;
+
+  int fd = open(cache_path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(icon_disk_header_t)) {
+    close(fd);
+    return NULL;
+  }
+  size_t len = (size_t)st.st_size;
+  // Private and writable: cairo treats the pixels as its own
+  void* addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return NULL;
+
+  const icon_disk_header_t* hdr = (const icon_disk_header_t*)addr;
+  bool valid = hdr->magic == ICON_DISK_MAGIC && hdr->src_mtime_ns == icon_disk_mtime_ns(&src_st) && hdr->src_size == (int64_t)src_st.st_size &&
+               hdr->size == size && hdr->w > 0 && hdr->h > 0 && hdr->w <= size && hdr->h <= size &&
+               hdr->stride == cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, hdr->w) &&
+               len == sizeof(*hdr) + (size_t)hdr->stride * (size_t)hdr->h;
+  if (!valid) {
+    munmap(addr, len);
+    return NULL;
+  }
+
+  icon_disk_map_t* map = malloc(sizeof(*map));
+  if (!map) {
+    munmap(addr, len);
+    return NULL;
+  }
+  map->addr = addr;
+  map->len = len;
+
+  unsigned char* pixels = (unsigned char*)addr + sizeof(*hdr);
+  cairo_surface_t* surface = cairo_image_surface_create_for_data(pixels, CAIRO_FORMAT_ARGB32, hdr->w, hdr->h, hdr->stride);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ||
+      cairo_surface_set_user_data(surface, &icon_disk_map_key, map, icon_disk_map_release) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    icon_disk_map_release(map);
+    return NULL;
+  }
+  return surface;
+}
+
+void icon_cache_disk_store(const char* path, int size, cairo_surface_t* surface) {
+  char cache_path[PATH_MAX];
+  char tmp[PATH_MAX + 16];
+  struct stat src_st;
+  if (!path || !surface || size <= 0 || cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE ||
+      cairo_image_surface_get_format(surface) != CAIRO_FORMAT_ARGB32 || stat(path, &src_st) != 0 ||
+      !icon_disk_path(path, size, true, cache_path, sizeof(cache_path)))
+    return;
+
+  cairo_surface_flush(surface);
+  icon_disk_header_t hdr = {
+      .magic = ICON_DISK_MAGIC,
+      .src_mtime_ns = icon_disk_mtime_ns(&src_st),
+      .src_size = (int64_t)src_st.st_size,
+      .size = size,
+      .w = cairo_image_surface_get_width(surface),
+      .h = cairo_image_surface_get_height(surface),
+      .stride = cairo_image_surface_get_stride(surface),
+  };
+  const unsigned char* pixels = cairo_image_surface_get_data(surface);
+  if (!pixels || hdr.w <= 0 || hdr.h <= 0 || hdr.w > size || hdr.h > size)
+    return;
+
+  int n = snprintf(tmp, sizeof(tmp), "%s.%ld", cache_path, (long)getpid());
+  if (n < 0 || (size_t)n >= sizeof(tmp))
+    return;
+  FILE* f = fopen(tmp, "wb");
+  if (!f)
+    return;
+  bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 && fwrite(pixels, (size_t)hdr.stride, (size_t)hdr.h, f) == (size_t)hdr.h;
+  ok = (fclose(f) == 0) && ok;
+  if (!ok || rename(tmp, cache_path) != 0)
+    unlink(tmp);
+}
@@ -0,0 +1,622 @@
+/* src/launcher.c
+ * posix_spawn based launcher with asynchronous reaping.
+ *
+ * The old launch path double-forked the whole WM and waited for the
+ * intermediate child on the event thread. A spawned child is a direct child
+ * now, collected by launcher_reap when SIGCHLD shows up on signal_fd.
+ *
+ * The helper talks SOCK_SEQPACKET: one launcher_request per command, one
+ * launcher_reply back. It ignores SIGCHLD so the kernel reaps what it starts
+ * (the spawn attributes restore the default in the child), and exits when
+ * the WM end of the socket closes, including across a restart exec.
+ */
+
+#include "launcher.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ds.h"
+#include "event_trace.h"
+#include "handoff.h"
+#include "str_intern.h"
+
+extern char** environ;
+
+/* Set by the WM for itself, never meant for the programs it starts */
+static bool launcher_private_env(const char* entry) {
+  static const char* const names[] = {HANDOFF_ENV, EVENT_TRACE_ENV};
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    size_t n = strlen(names[i]);
+    if (strncmp(entry, names[i], n) == 0 && entry[n] == '=')
+      return true;
+  }
+  return false;
+}
+
+static bool launcher_build_env(launcher_t* l) {
+  size_t n = 0;
+  for (char** e = environ; e && *e; e++)
+    n++;
+  l->envp = calloc(n + 1u, sizeof(*l->envp));
+  if (!l->envp)
+    return false;
+  l->env_count = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (launcher_private_env(environ[i]))
+      continue;
+    char* copy = strdup(environ[i]);
+    if (!copy)
+      return false;
+    l->envp[l->env_count++] = copy;
+  }
+  return true;
+}
+
+static bool launcher_build_attr(launcher_t* l) {
+  if (posix_spawnattr_init(&l->attr) != 0)
+    return false;
+
+  sigset_t none;
+  sigemptyset(&none);
+  sigset_t defaults;
+  sigemptyset(&defaults);
+  const int reset[] = {SIGCHLD, SIGHUP, SIGINT, SIGTERM, SIGUSR1, SIGUSR2, SIGPIPE};
+  for (size_t i = 0; i < sizeof(reset) / sizeof(reset[0]); i++)
+    sigaddset(&defaults, reset[i]);
+
+  short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_SETSID
+  flags |= POSIX_SPAWN_SETSID;
+#else
+  flags |= POSIX_SPAWN_SETPGROUP;
+  posix_spawnattr_setpgroup(&l->attr, 0);
+#endif
+  if (posix_spawnattr_setsigmask(&l->attr, &none) != 0 || posix_spawnattr_setsigdefault(&l->attr, &defaults) != 0 ||
+      posix_spawnattr_setflags(&l->attr, flags) != 0) {
+    posix_spawnattr_destroy(&l->attr);
+    return false;
+  }
+  return true;
+}
+
+static bool launcher_ready(launcher_t* l) {
+  if (l->ready)
+    return true;
+  if (l->latency.count == 0)
+    latency_hist_reset(&l->latency);
+  if (!launcher_build_attr(l)) {
+    LOG_ERROR("launcher: spawn attributes unavailable");
+    return false;
+  }
+  if (!launcher_build_env(l)) {
+    LOG_ERROR("launcher: out of memory building the environment");
+    posix_spawnattr_destroy(&l->attr);
+    for (size_t i = 0; l->envp && i < l->env_count; i++)
+      free(l->envp[i]);
+    free(l->envp);
+    l->envp = NULL;
+    l->env_count = 0;
+    return false;
+  }
+  l->ready = true;
+  return true;
+}
+
+static void launcher_helper_lost(launcher_t* l) {
+  LOG_WARN("launcher: helper %d is gone, spawning locally", (int)l->helper_pid);
+  close(l->helper_fd);
+  l->helper_fd = -1;
+  l->helper_pid = 0;
+  l->helper_pending = 0;
+}
+
+void launcher_destroy(launcher_t* l) {
+  if (l->helper_pid > 0) {
+    close(l->helper_fd);
+    waitpid(l->helper_pid, NULL, 0);
+  }
+  if (l->ready) {
+    posix_spawnattr_destroy(&l->attr);
+    for (size_t i = 0; i < l->env_count; i++)
+      free(l->envp[i]);
+    free(l->envp);
+  }
+  memset(l, 0, sizeof(*l));
+}
+
+static pid_t launcher_spawn(launcher_t* l, const char* path, char* const argv[], const char* what, uint64_t trigger_ns) {
+  uint64_t start = monotonic_time_ns();
+  if (!launcher_ready(l)) {
+    l->failed++;
+    return -1;
+  }
+
+  pid_t pid = -1;
+  int err = posix_spawn(&pid, path, NULL, &l->attr, argv, l->envp);
+  if (err != 0) {
+    l->failed++;
+    LOG_ERROR("launcher: cannot start %s: %s", what, strerror(err));
+    return -1;
+  }
+
+  l->spawned++;
+  l->running++;
+  uint64_t end = monotonic_time_ns();
+  uint64_t from = (trigger_ns && trigger_ns <= start) ? trigger_ns : start;
+  latency_hist_record(&l->latency, end - from);
+  return pid;
+}
+
+/* The command is a list of program names; the first one on PATH runs */
+#define LAUNCHER_REQ_FIRST (1u << 0)
+
+typedef struct launcher_request {
+  uint64_t trigger_ns;
+  uint32_t flags; /* LAUNCHER_REQ_* */
+  uint32_t pad;
+  /* command bytes follow, not NUL terminated */
+} launcher_request_t;
+
+typedef struct launcher_reply {
+  int32_t pid; /* -1 on failure */
+  int32_t err;
+  uint32_t direct;
+  uint32_t pad;
+  uint64_t trigger_ns;
+  uint64_t exec_ns; /* posix_spawn returned */
+} launcher_reply_t;
+
+static bool launcher_helper_send(launcher_t* l, const char* cmd, uint32_t flags, uint64_t trigger_ns) {
+  if (l->helper_pid <= 0)
+    return false;
+  size_t len = strlen(cmd);
+  if (len == 0 || len > LAUNCHER_CMD_MAX) {
+    l->helper_fallbacks++;
+    return false;
+  }
+
+  launcher_request_t req = {.trigger_ns = trigger_ns, .flags = flags};
+  struct iovec iov[2] = {{&req, sizeof(req)}, {(void*)(uintptr_t)cmd, len}};
+  struct msghdr msg = {.msg_iov = iov, .msg_iovlen = 2};
+  if (sendmsg(l->helper_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)
+      l->helper_fallbacks++;
+    else
+      launcher_helper_lost(l);
+    return false;
+  }
+  l->helper_sent++;
+  l->helper_pending++;
+  return true;
+}
+
+void launcher_helper_collect(launcher_t* l) {
+  while (l->helper_pid > 0) {
+    launcher_reply_t r;
+    ssize_t n = recv(l->helper_fd, &r, sizeof(r), MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n != (ssize_t)sizeof(r)) {
+      launcher_helper_lost(l);
+      return;
+    }
+
+    if (l->helper_pending > 0)
+      l->helper_pending--;
+    if (r.pid < 0) {
+      l->failed++;
+      LOG_ERROR("launcher: helper cannot start a command: %s", strerror(r.err));
+      continue;
+    }
+    l->spawned++;
+    l->helper_direct += r.direct != 0;
+    if (r.exec_ns >= r.trigger_ns)
+      latency_hist_record(&l->latency, r.exec_ns - r.trigger_ns);
+  }
+}
+
+pid_t launcher_shell(launcher_t* l, const char* cmd, uint64_t trigger_ns) {
+  if (!cmd)
+    return -1;
+  if (l->helper_pid > 0) {
+    if (launcher_helper_send(l, cmd, 0, trigger_ns ? trigger_ns : monotonic_time_ns()))
+      return 0;
+  }
+  char* const argv[] = {"sh", "-c", (char*)(uintptr_t)cmd, NULL};
+  return launcher_spawn(l, "/bin/sh", argv, cmd, trigger_ns);
+}
+
+pid_t launcher_first(launcher_t* l, const char* names, uint64_t trigger_ns) {
+  if (!names)
+    return -1;
+  if (l->helper_pid > 0) {
+    if (launcher_helper_send(l, names, LAUNCHER_REQ_FIRST, trigger_ns ? trigger_ns : monotonic_time_ns()))
+      return 0;
+  }
+
+  // Locally the PATH search is left to sh: "a || b || ..."
+  char buf[LAUNCHER_CMD_MAX + 1u];
+  char* argv[LAUNCHER_ARGV_MAX];
+  snprintf(buf, sizeof(buf), "%s", names);
+  size_t argc = launcher_split_command(buf, argv, LAUNCHER_ARGV_MAX);
+  if (argc == 0) {
+    l->failed++;
+    return -1;
+  }
+  char cmd[LAUNCHER_CMD_MAX + 4u * LAUNCHER_ARGV_MAX];
+  size_t len = 0;
+  for (size_t i = 0; i < argc && len < sizeof(cmd); i++)
+    len += (size_t)snprintf(cmd + len, sizeof(cmd) - len, "%s%s", i ? " || " : "", argv[i]);
+  char* const sh_argv[] = {"sh", "-c", cmd, NULL};
+  return launcher_spawn(l, "/bin/sh", sh_argv, names, trigger_ns);
+}
+
+pid_t launcher_exec(launcher_t* l, const char* path, uint64_t trigger_ns) {
+  if (!path)
+    return -1;
+  char* const argv[] = {(char*)(uintptr_t)path, NULL};
+  return launcher_spawn(l, path, argv, path, trigger_ns);
+}
+
+uint32_t launcher_reap(launcher_t* l) {
+  uint32_t n = 0;
+  int status = 0;
+  pid_t pid;
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    if (l->helper_pid > 0 && pid == l->helper_pid) {
+      launcher_helper_lost(l);
+      continue;
+    }
+    n++;
+    l->reaped++;
+    if (l->running > 0)
+      l->running--;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      l->exit_errors++;
+      if (WIFEXITED(status))
+        LOG_DEBUG("launcher: child %d exited with %d", (int)pid, WEXITSTATUS(status));
+      else if (WIFSIGNALED(status))
+        LOG_DEBUG("launcher: child %d killed by signal %d", (int)pid, WTERMSIG(status));
+    }
+  }
+  return n;
+}
+
+size_t launcher_split_command(char* cmd, char** argv, size_t max) {
+  if (!cmd || !argv || max < 2u)
+    return 0;
+  // Anything sh would interpret beyond splitting words on blanks
+  if (strpbrk(cmd, "|&;<>()$`\\\"'*?[]{}#~\n"))
+    return 0;
+
+  size_t argc = 0;
+  char* p = cmd;
+  for (;;) {
+    while (*p == ' ' || *p == '\t')
+      *p++ = '\0';
+    if (!*p)
+      break;
+    if (argc + 1u >= max)
+      return 0;
+    argv[argc++] = p;
+    while (*p && *p != ' ' && *p != '\t')
+      p++;
+  }
+  argv[argc] = NULL;
+  if (argc == 0 || strchr(argv[0], '='))
+    return 0;
+  return argc;
+}
+
+/*
+ * PATH lookups, helper side. A result is cached only when every directory it
+ * depends on is watched: a hit in dir i needs dirs [0, i], a miss needs all.
+ */
+typedef struct launcher_path_entry {
+  char* name;
+  char* path; /* NULL: not on PATH */
+} launcher_path_entry_t;
+
+typedef struct launcher_path_cache {
+  hash_map_t map; /* str_hash(name) -> entry */
+  char** dirs;
+  size_t dir_count;
+  size_t watched; /* leading dirs with a watch */
+  int inotify_fd;
+} launcher_path_cache_t;
+
+#define LAUNCHER_PATH_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+
+static void launcher_path_clear(launcher_path_cache_t* pc) {
+  size_t cursor = 0;
+  uint64_t key;
+  void* value;
+  while (hash_map_next(&pc->map, &cursor, &key, &value)) {
+    launcher_path_entry_t* e = value;
+    free(e->name);
+    free(e->path);
+    free(e);
+  }
+  hash_map_clear(&pc->map);
+}
+
+static void launcher_path_init(launcher_path_cache_t* pc) {
+  memset(pc, 0, sizeof(*pc));
+  hash_map_init(&pc->map);
+  pc->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  const char* path = getenv("PATH");
+  char* copy = strdup(path ? path : "/usr/local/bin:/usr/bin:/bin");
+  if (!copy)
+    return;
+  size_t n = 1;
+  for (const char* c = copy; *c; c++)
+    n += *c == ':';
+  pc->dirs = calloc(n, sizeof(*pc->dirs));
+  if (!pc->dirs) {
+    free(copy);
+    return;
+  }
+
+  bool watching = pc->inotify_fd >= 0;
+  char* save = NULL;
+  for (char* dir = strtok_r(copy, ":", &save); dir; dir = strtok_r(NULL, ":", &save)) {
+    char* d = strdup(dir);
+    if (!d)
+      break;
+    pc->dirs[pc->dir_count++] = d;
+    // Relative entries follow the cwd, which no watch can track
+    watching = watching && d[0] == '/' && inotify_add_watch(pc->inotify_fd, d, LAUNCHER_PATH_EVENTS) >= 0;
+    if (watching)
+      pc->watched++;
+  }
+  free(copy);
+}
+
+static void launcher_path_destroy(launcher_path_cache_t* pc) {
+  launcher_path_clear(pc);
+  hash_map_destroy(&pc->map);
+  for (size_t i = 0; i < pc->dir_count; i++)
+    free(pc->dirs[i]);
+  free(pc->dirs);
+  if (pc->inotify_fd >= 0)
+    close(pc->inotify_fd);
+}
+
+static void launcher_path_handle_inotify(launcher_path_cache_t* pc) {
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  bool lost = false;
+  ssize_t n;
+  while ((n = read(pc->inotify_fd, buf, sizeof(buf))) > 0) {
+    for (char* p = buf; p < buf + n;) {
+      const struct inotify_event* ev = (const struct inotify_event*)p;
+      lost = lost || (ev->mask & (IN_IGNORED | IN_Q_OVERFLOW));
+      p += sizeof(*ev) + ev->len;
+    }
+  }
+  // A directory that went away is no longer watched; stop trusting the cache
+  if (lost)
+    pc->watched = 0;
+  launcher_path_clear(pc);
+}
+
+/* Resolve name into out; false when it is not an executable on PATH */
+static bool launcher_path_lookup(launcher_path_cache_t* pc, const char* name, char* out, size_t cap) {
+  size_t len = strlen(name);
+  uint64_t key = str_hash(name, len) | 1u; // 0 is the map's empty key
+  launcher_path_entry_t* e = hash_map_get(&pc->map, key);
+  if (e && strcmp(e->name, name) == 0) {
+    if (!e->path)
+      return false;
+    snprintf(out, cap, "%s", e->path);
+    return true;
+  }
+
+  size_t found = pc->dir_count;
+  for (size_t i = 0; i < pc->dir_count; i++) {
+    int w = snprintf(out, cap, "%s/%s", pc->dirs[i], name);
+    if (w <= 0 || (size_t)w >= cap)
+      continue;
+    struct stat st;
+    if (stat(out, &st) == 0 && S_ISREG(st.st_mode) && access(out, X_OK) == 0) {
+      found = i;
+      break;
+    }
+  }
+
+  bool cacheable = found < pc->dir_count ? found < pc->watched : pc->watched == pc->dir_count;
+  if (cacheable && !e) {
+    e = calloc(1, sizeof(*e));
+    if (e) {
+      e->name = strdup(name);
+      e->path = found < pc->dir_count ? strdup(out) : NULL;
+      if (!e->name || (found < pc->dir_count && !e->path)) {
+        free(e->name);
+        free(e->path);
+        free(e);
+      }
+      else {
+        hash_map_insert(&pc->map, key, e);
+      }
+    }
+  }
+  return found < pc->dir_count;
+}
+
+static void launcher_helper_run(launcher_t* l, launcher_path_cache_t* pc, char* cmd, uint32_t flags, launcher_reply_t* r) {
+  char* argv[LAUNCHER_ARGV_MAX];
+  char resolved[PATH_MAX];
+  char* shell = strdup(cmd);
+  if (!shell) {
+    r->pid = -1;
+    r->err = ENOMEM;
+    return;
+  }
+
+  // Builtins and missing programs fail the lookup and go to sh like the rest
+  const char* path = NULL;
+  size_t argc = launcher_split_command(cmd, argv, LAUNCHER_ARGV_MAX);
+  if (flags & LAUNCHER_REQ_FIRST) {
+    // Alternatives, not arguments: the first one found runs on its own
+    size_t i = 0;
+    for (; i < argc && !path; i++) {
+      if (strchr(argv[i], '/'))
+        path = access(argv[i], X_OK) == 0 ? argv[i] : NULL;
+      else if (launcher_path_lookup(pc, argv[i], resolved, sizeof(resolved)))
+        path = resolved;
+    }
+    if (!path) {
+      free(shell);
+      r->exec_ns = monotonic_time_ns();
+      r->pid = -1;
+      r->err = ENOENT;
+      return;
+    }
+    argv[0] = argv[i - 1];
+    argv[1] = NULL;
+  }
+  else if (argc > 0) {
+    if (strchr(argv[0], '/'))
+      path = argv[0];
+    else if (launcher_path_lookup(pc, argv[0], resolved, sizeof(resolved)))
+      path = resolved;
+  }
+
+  pid_t pid = -1;
+  int err;
+  if (path) {
+    err = posix_spawn(&pid, path, NULL, &l->attr, argv, l->envp);
+    r->direct = err == 0;
+  }
+  else {
+    char* const sh_argv[] = {"sh", "-c", shell, NULL};
+    err = posix_spawn(&pid, "/bin/sh", NULL, &l->attr, sh_argv, l->envp);
+  }
+  free(shell);
+  r->exec_ns = monotonic_time_ns();
+  r->pid = err == 0 ? (int32_t)pid : -1;
+  r->err = err;
+}
+
+static void launcher_helper_main(int fd) {
+  prctl(PR_SET_NAME, "hxm-launcher", 0, 0, 0);
+  signal(SIGCHLD, SIG_IGN);
+
+  // Forked before handoff_load: the restart memfd is the WM's alone, and
+  // holding it would keep the blob alive for the helper's lifetime
+  int handoff_fd = handoff_env_fd();
+  if (handoff_fd >= 0)
+    close(handoff_fd);
+
+  launcher_t l = {0};
+  if (!launcher_ready(&l))
+    _exit(1);
+  launcher_path_cache_t pc;
+  launcher_path_init(&pc);
+
+  char buf[sizeof(launcher_request_t) + LAUNCHER_CMD_MAX + 1u];
+  for (;;) {
+    struct pollfd pfd[2] = {{.fd = fd, .events = POLLIN}, {.fd = pc.inotify_fd, .events = POLLIN}};
+    if (poll(pfd, pc.inotify_fd >= 0 ? 2 : 1, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    if (pc.inotify_fd >= 0 && (pfd[1].revents & POLLIN))
+      launcher_path_handle_inotify(&pc);
+    if (!pfd[0].revents)
+      continue;
+
+    ssize_t n = recv(fd, buf, sizeof(buf) - 1u, 0);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < (ssize_t)sizeof(launcher_request_t))
+      break;
+    buf[n] = '\0';
+
+    launcher_request_t req;
+    memcpy(&req, buf, sizeof(req));
+    launcher_reply_t r = {.trigger_ns = req.trigger_ns};
+    launcher_helper_run(&l, &pc, buf + sizeof(req), req.flags, &r);
+    if (send(fd, &r, sizeof(r), MSG_NOSIGNAL) < 0 && errno == EPIPE)
+      break;
+  }
+
+  launcher_path_destroy(&pc);
+  launcher_destroy(&l);
+  _exit(0);
+}
+
+bool launcher_helper_start(launcher_t* l) {
+  const char* env = getenv(LAUNCHER_HELPER_ENV);
+  if (env && strcmp(env, "0") == 0)
+    return false;
+
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0) {
+    LOG_WARN("launcher: no helper socket: %s", strerror(errno));
+    return false;
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    LOG_WARN("launcher: cannot fork the helper: %s", strerror(errno));
+    close(sv[0]);
+    close(sv[1]);
+    return false;
+  }
+  if (pid == 0) {
+    close(sv[0]);
+    launcher_helper_main(sv[1]);
+  }
+
+  close(sv[1]);
+  latency_hist_reset(&l->latency);
+  l->helper_pid = pid;
+  l->helper_fd = sv[0];
+  l->helper_pending = 0;
+  return true;
+}
+
+size_t launcher_format(const launcher_t* l, char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+  buf[0] = '\0';
+  if (!l || (l->spawned == 0 && l->failed == 0))
+    return 0;
+
+  const latency_hist_t* h = &l->latency;
+  int n = snprintf(buf, cap,
+                   "launcher: spawned=%" PRIu64 " failed=%" PRIu64 " running=%u reaped=%" PRIu64 " exit_errors=%" PRIu64
+                   " helper=%s sent=%" PRIu64 " direct=%" PRIu64 " fallbacks=%" PRIu64
+                   " trigger_to_exec_us p50=%.1f p99=%.1f max=%.1f\n",
+                   l->spawned, l->failed, l->running, l->reaped, l->exit_errors, l->helper_pid > 0 ? "up" : "down",
+                   l->helper_sent, l->helper_direct, l->helper_fallbacks, (double)latency_hist_quantile(h, 5000) / 1000.0,
+                   (double)latency_hist_quantile(h, 9900) / 1000.0, (double)h->max_ns / 1000.0);
+  if (n <= 0)
+    return 0;
+  return (size_t)n < cap ? (size_t)n : cap - 1u;
+}
+
+void launcher_dump(const launcher_t* l) {
+  char buf[512];
+  if (launcher_format(l, buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
+}
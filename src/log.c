@@ -1,5 +1,11 @@
 /* src/log.c
  * Logging subsystem.
+ *
+ * Lines are written synchronously unless HXM_LOG_ASYNC is set, in which case
+ * hxm_log_async_start hands the blocking part to a writer thread: the
+ * starting thread formats each message into a preallocated single-producer
+ * ring and returns; the writer formats the timestamp and does the write.
+ * Other threads keep writing synchronously so the ring stays SPSC.
  */
 
 #include <stdarg.h>
@@ -9,9 +15,12 @@
 
 #if HXM_DIAG
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -63,14 +72,17 @@ static void log_init_once(void) {
   setvbuf(stdout, NULL, _IOLBF, 0);
 }
 
-static void format_timestamp(char* out, size_t out_sz, long* ms_out) {
-  struct timespec ts;
-  clockid_t clk = use_monotonic ? CLOCK_MONOTONIC : CLOCK_REALTIME;
-  if (clock_gettime(clk, &ts) != 0) {
+static bool log_clock(struct timespec* ts) {
+  return clock_gettime(use_monotonic ? CLOCK_MONOTONIC : CLOCK_REALTIME, ts) == 0;
+}
+
+static void format_timestamp(const struct timespec* tsp, char* out, size_t out_sz, long* ms_out) {
+  if (!tsp) {
     snprintf(out, out_sz, "??:??:??");
     *ms_out = 0;
     return;
   }
+  struct timespec ts = *tsp;
 
   *ms_out = ts.tv_nsec / 1000000;
 
@@ -90,6 +102,210 @@ static void format_timestamp(char* out, size_t out_sz, long* ms_out) {
   strftime(out, out_sz, "%H:%M:%S", &tm);
 }
 
+static void log_emit(enum log_level level, const struct timespec* ts, const char* msg, size_t len) {
+  char tsbuf[32];
+  long ms = 0;
+  format_timestamp(ts, tsbuf, sizeof(tsbuf), &ms);
+
+  FILE* out = (level >= LOG_WARN) ? stderr : stdout;
+  fprintf(out, "[%s.%03ld %s] %.*s\n", tsbuf, ms, safe_level_str(level), (int)len, msg);
+  if (level >= LOG_WARN)
+    fflush(out);
+}
+
+/* ---------- Async ring ----------
+ *
+ * Byte ring of variable-length records, each 8-byte aligned: a header and
+ * the formatted message. head and tail are free-running byte positions;
+ * only the producer stores head and only the writer stores tail. A record
+ * that would straddle the end is preceded by a LOG_RING_WRAP marker.
+ */
+
+#define LOG_RING_SIZE (256u * 1024u) /* power of two */
+#define LOG_RING_MAX_MSG 4096u
+#define LOG_RING_WRAP UINT32_MAX
+#define LOG_RING_IDLE_NS (100ull * 1000ull * 1000ull)
+
+typedef struct log_record {
+  uint32_t len; /* message bytes, or LOG_RING_WRAP */
+  uint8_t level;
+  uint8_t has_ts;
+  uint16_t reserved;
+  struct timespec ts;
+} log_record_t;
+
+static struct {
+  char* buf;
+  _Atomic uint64_t head;
+  _Atomic uint64_t tail;
+  _Atomic uint64_t dropped;
+  _Atomic bool writer_idle;
+  _Atomic bool stopping;
+  pthread_t producer;
+  pthread_t writer;
+  pthread_mutex_t lock; /* only guards the idle wait */
+  pthread_cond_t wake;
+  uint64_t dropped_reported; /* writer only */
+  _Atomic bool running;
+} log_ring;
+
+static inline size_t log_record_span(uint32_t len) {
+  return (sizeof(log_record_t) + len + 7u) & ~(size_t)7u;
+}
+
+static bool log_ring_push(enum log_level level, const struct timespec* ts, const char* msg, uint32_t len) {
+  uint64_t head = atomic_load_explicit(&log_ring.head, memory_order_relaxed);
+  uint64_t tail = atomic_load_explicit(&log_ring.tail, memory_order_acquire);
+  size_t need = log_record_span(len);
+  size_t off = (size_t)(head & (LOG_RING_SIZE - 1u));
+  size_t to_end = LOG_RING_SIZE - off;
+  size_t pad = (need > to_end) ? to_end : 0;
+
+  if (head + pad + need - tail > LOG_RING_SIZE) {
+    atomic_fetch_add_explicit(&log_ring.dropped, 1, memory_order_relaxed);
+    return false;
+  }
+
+  if (pad) {
+    uint32_t wrap = LOG_RING_WRAP;
+    memcpy(log_ring.buf + off, &wrap, sizeof(wrap));
+    off = 0;
+  }
+  log_record_t rec = {.len = len, .level = (uint8_t)level, .has_ts = ts != NULL};
+  if (ts)
+    rec.ts = *ts;
+  memcpy(log_ring.buf + off, &rec, sizeof(rec));
+  memcpy(log_ring.buf + off + sizeof(rec), msg, len);
+  atomic_store_explicit(&log_ring.head, head + pad + need, memory_order_release);
+
+  if (atomic_load(&log_ring.writer_idle))
+    pthread_cond_signal(&log_ring.wake);
+  return true;
+}
+
+/* Writes out everything published so far; returns false if there was nothing */
+static bool log_ring_drain(void) {
+  uint64_t tail = atomic_load_explicit(&log_ring.tail, memory_order_relaxed);
+  uint64_t head = atomic_load_explicit(&log_ring.head, memory_order_acquire);
+  if (tail == head)
+    return false;
+
+  bool flush_out = false;
+  while (tail != head) {
+    size_t off = (size_t)(tail & (LOG_RING_SIZE - 1u));
+    log_record_t rec;
+    memcpy(&rec.len, log_ring.buf + off, sizeof(rec.len));
+    if (rec.len == LOG_RING_WRAP) {
+      tail += LOG_RING_SIZE - off;
+      continue;
+    }
+    memcpy(&rec, log_ring.buf + off, sizeof(rec));
+    log_emit((enum log_level)rec.level, rec.has_ts ? &rec.ts : NULL, log_ring.buf + off + sizeof(rec), rec.len);
+    flush_out |= rec.level < LOG_WARN;
+    tail += log_record_span(rec.len);
+  }
+  atomic_store_explicit(&log_ring.tail, tail, memory_order_release);
+  if (flush_out)
+    fflush(stdout);
+
+  uint64_t dropped = atomic_load_explicit(&log_ring.dropped, memory_order_relaxed);
+  if (dropped != log_ring.dropped_reported) {
+    struct timespec ts;
+    char msg[64];
+    int n = snprintf(msg, sizeof(msg), "log ring full, dropped %llu lines", (unsigned long long)(dropped - log_ring.dropped_reported));
+    log_emit(LOG_WARN, log_clock(&ts) ? &ts : NULL, msg, (size_t)n);
+    log_ring.dropped_reported = dropped;
+  }
+  return true;
+}
+
+static void* log_writer_main(void* arg) {
+  (void)arg;
+  for (;;) {
+    if (log_ring_drain())
+      continue;
+    if (atomic_load(&log_ring.stopping))
+      break;
+
+    // A push that misses the signal is picked up after LOG_RING_IDLE_NS
+    pthread_mutex_lock(&log_ring.lock);
+    atomic_store(&log_ring.writer_idle, true);
+    if (atomic_load(&log_ring.head) == atomic_load(&log_ring.tail) && !atomic_load(&log_ring.stopping)) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_MONOTONIC, &deadline);
+      deadline.tv_nsec += (long)LOG_RING_IDLE_NS;
+      if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+      }
+      pthread_cond_timedwait(&log_ring.wake, &log_ring.lock, &deadline);
+    }
+    atomic_store(&log_ring.writer_idle, false);
+    pthread_mutex_unlock(&log_ring.lock);
+  }
+  return NULL;
+}
+
+void hxm_log_async_start(void) {
+  log_init_once();
+  if (atomic_load(&log_ring.running) || !env_truthy(getenv("HXM_LOG_ASYNC")))
+    return;
+
+  log_ring.buf = malloc(LOG_RING_SIZE);
+  if (!log_ring.buf)
+    return;
+  atomic_store(&log_ring.head, 0);
+  atomic_store(&log_ring.tail, 0);
+  atomic_store(&log_ring.dropped, 0);
+  log_ring.dropped_reported = 0;
+  atomic_store(&log_ring.stopping, false);
+  atomic_store(&log_ring.writer_idle, false);
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&log_ring.wake, &attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&log_ring.lock, NULL);
+
+  int err = pthread_create(&log_ring.writer, NULL, log_writer_main, NULL);
+  if (err != 0) {
+    pthread_cond_destroy(&log_ring.wake);
+    pthread_mutex_destroy(&log_ring.lock);
+    free(log_ring.buf);
+    log_ring.buf = NULL;
+    hxm_log(LOG_WARN, "async log writer failed to start: %s", strerror(err));
+    return;
+  }
+  log_ring.producer = pthread_self();
+  atomic_store(&log_ring.running, true);
+
+  static bool atexit_registered;
+  if (!atexit_registered)
+    atexit_registered = atexit(hxm_log_async_stop) == 0;
+}
+
+void hxm_log_async_stop(void) {
+  if (!atomic_load(&log_ring.running))
+    return;
+  // Later lines from this thread go straight out, after what was queued
+  atomic_store(&log_ring.running, false);
+  atomic_store(&log_ring.stopping, true);
+  pthread_mutex_lock(&log_ring.lock);
+  pthread_cond_signal(&log_ring.wake);
+  pthread_mutex_unlock(&log_ring.lock);
+  pthread_join(log_ring.writer, NULL);
+
+  pthread_cond_destroy(&log_ring.wake);
+  pthread_mutex_destroy(&log_ring.lock);
+  free(log_ring.buf);
+  log_ring.buf = NULL;
+}
+
+uint64_t hxm_log_dropped(void) {
+  return atomic_load_explicit(&log_ring.dropped, memory_order_relaxed);
+}
+
 void hxm_log(enum log_level level, const char* fmt, ...) {
   if (!HXM_LOG_ENABLED(level))
     return;
@@ -98,9 +314,26 @@ void hxm_log(enum log_level level, const char* fmt, ...) {
   if (!fmt)
     fmt = "(null fmt)";
 
+  struct timespec ts;
+  bool have_ts = log_clock(&ts);
+
+  if (atomic_load_explicit(&log_ring.running, memory_order_acquire) && pthread_equal(log_ring.producer, pthread_self())) {
+    char msg[LOG_RING_MAX_MSG];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    if (n < 0)
+      n = 0;
+    if ((size_t)n >= sizeof(msg))
+      n = (int)sizeof(msg) - 1;
+    log_ring_push(level, have_ts ? &ts : NULL, msg, (uint32_t)n);
+    return;
+  }
+
   char tsbuf[32];
   long ms = 0;
-  format_timestamp(tsbuf, sizeof(tsbuf), &ms);
+  format_timestamp(have_ts ? &ts : NULL, tsbuf, sizeof(tsbuf), &ms);
 
   FILE* out = (level >= LOG_WARN) ? stderr : stdout;
   fprintf(out, "[%s.%03ld %s] ", tsbuf, ms, safe_level_str(level));
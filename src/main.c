@@ -14,8 +14,10 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "control.h"
 #include "event.h"
 #include "hxm.h"
+#include "manage_stats.h"
 #include "xcb_utils.h"
 
 static server_t server;
@@ -28,9 +30,13 @@ static void print_help(const char* prog) {
   printf(
       "  --reconfigure   Reload the configuration of the running hxm "
       "instance\n");
-#if HXM_DIAG
-  printf("  --dump-stats    Print performance counters and exit\n");
-#endif
+  printf("  --dump-stats    Ask the running instance to dump tick stats and exit\n");
+  printf("  --query [sect]  Print live JSON diagnostics (layers, focus, cookies,\n");
+  printf("                  ticks, memory, clients, wakeups, requests; default all)\n");
+  printf("                  and exit\n");
+  printf("  --idle-check [secs]\n");
+  printf("                  Fail if the running instance wakes up while the desktop\n");
+  printf("                  is left alone for secs seconds (default 10)\n");
   printf("  --help          Print this help and exit\n");
 }
 
@@ -59,7 +65,8 @@ static bool get_window32(xcb_connection_t* conn, xcb_window_t win, xcb_atom_t pr
 }
 
 static int send_signal_to_wm(int sig) {
-  xcb_connection_t* conn = xcb_connect(NULL, NULL);
+  int screen_num = 0;
+  xcb_connection_t* conn = xcb_connect(NULL, &screen_num);
   if (!conn || xcb_connection_has_error(conn)) {
     fprintf(stderr, "Failed to connect to X server\n");
     if (conn)
@@ -69,7 +76,7 @@ static int send_signal_to_wm(int sig) {
 
   atoms_init(conn);
 
-  xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(conn)).data;
+  xcb_screen_t* screen = xcb_screen_of(conn, screen_num);
   xcb_window_t root = screen ? screen->root : XCB_NONE;
 
   // Prefer EWMH supporting WM check window published on root
@@ -78,9 +85,17 @@ static int send_signal_to_wm(int sig) {
     (void)get_window32(conn, root, atoms._NET_SUPPORTING_WM_CHECK, &wm_win);
   }
 
-  // Fallback to WM_S0 selection owner
-  if (wm_win == XCB_NONE) {
-    xcb_get_selection_owner_reply_t* owner = xcb_get_selection_owner_reply(conn, xcb_get_selection_owner(conn, atoms.WM_S0), NULL);
+  // Fallback to the WM_Sn selection owner of this screen
+  xcb_atom_t selection = atoms.WM_S0;
+  if (wm_win == XCB_NONE && screen_num > 0) {
+    char name[16];
+    int len = snprintf(name, sizeof(name), "WM_S%d", screen_num);
+    xcb_intern_atom_reply_t* ar = xcb_intern_atom_reply(conn, xcb_intern_atom(conn, 1, (uint16_t)len, name), NULL);
+    selection = ar ? ar->atom : XCB_NONE;
+    free(ar);
+  }
+  if (wm_win == XCB_NONE && selection != XCB_NONE) {
+    xcb_get_selection_owner_reply_t* owner = xcb_get_selection_owner_reply(conn, xcb_get_selection_owner(conn, selection), NULL);
     if (owner) {
       wm_win = owner->owner;
       free(owner);
@@ -115,16 +130,23 @@ int main(int argc, char** argv) {
 #if HXM_DIAG
   counters_init();
 #endif
+  tick_stats_init();
+  manage_stats_init();
 
   for (int i = 1; i < argc; i++) {
-#if HXM_DIAG
     if (strcmp(argv[i], "--dump-stats") == 0) {
       // Ask the running instance to dump stats
       return send_signal_to_wm(SIGUSR1) == 0 ? 0 : 1;
     }
-    else
-#endif
-        if (strcmp(argv[i], "--help") == 0) {
+    else if (strcmp(argv[i], "--query") == 0) {
+      const char* section = (i + 1 < argc) ? argv[i + 1] : "all";
+      return control_query(section, stdout) == 0 ? 0 : 1;
+    }
+    else if (strcmp(argv[i], "--idle-check") == 0) {
+      int seconds = (i + 1 < argc) ? atoi(argv[i + 1]) : 10;
+      return control_idle_check(seconds > 0 ? (unsigned)seconds : 10u, stdout) == 0 ? 0 : 1;
+    }
+    else if (strcmp(argv[i], "--help") == 0) {
       print_help(argv[0]);
       return 0;
     }
@@ -144,6 +166,10 @@ int main(int argc, char** argv) {
     }
   }
 
+  // Fork the launcher helper while the process is still small and single threaded
+  launcher_helper_start(&server.launcher);
+
+  hxm_log_async_start();
   LOG_INFO("hxm starting");
 
   server_init(&server);
@@ -0,0 +1,189 @@
+/* src/manage_stats.c
+ * Manage latency histograms, from MapRequest to first frame paint
+ *
+ * Records are folded once per window, so the per-class table is a short
+ * linear scan; classes beyond MANAGE_STATS_CLASSES share the "(other)" row
+ * rather than evicting a class already being tracked.
+ */
+
+#include "manage_stats.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "client.h"
+
+HXM_STATIC_ASSERT(WINDOW_TYPE_COUNT <= MANAGE_STATS_TYPES, "MANAGE_STATS_TYPES too small");
+
+struct manage_stats manage_stats;
+
+static const char* const manage_stage_names[MANAGE_STAGE_COUNT] = {
+    "classify", /* MapRequest -> manage start */
+    "probes",   /* manage start -> STATE_READY */
+    "queue",    /* STATE_READY -> finish_manage */
+    "frame",    /* finish_manage -> frame mapped */
+    "paint",    /* frame mapped -> first paint */
+    "total",
+};
+
+static const char* const manage_type_names[WINDOW_TYPE_COUNT] = {
+    "normal", "dialog", "dock",          "notification", "desktop", "splash", "toolbar",
+    "utility", "menu",  "dropdown_menu", "popup_menu",   "tooltip", "combo",  "dnd",
+};
+
+static void label_copy(char dst[MANAGE_STATS_LABEL_LEN], const char* src) {
+  snprintf(dst, MANAGE_STATS_LABEL_LEN, "%s", src ? src : "");
+}
+
+void manage_stats_init(void) {
+  memset(&manage_stats, 0, sizeof(manage_stats));
+  for (int i = 0; i < MANAGE_STAGE_COUNT; i++)
+    latency_hist_reset(&manage_stats.stage[i]);
+  for (int i = 0; i < MANAGE_STATS_TYPES; i++)
+    latency_hist_reset(&manage_stats.by_type[i]);
+  for (int i = 0; i <= MANAGE_STATS_CLASSES; i++)
+    latency_hist_reset(&manage_stats.classes[i].total);
+  label_copy(manage_stats.classes[MANAGE_STATS_CLASSES].name, "(other)");
+}
+
+static manage_class_stats_t* manage_class_row(const char* wm_class) {
+  if (!wm_class || !*wm_class)
+    wm_class = "(none)";
+
+  for (uint32_t i = 0; i < manage_stats.class_count; i++) {
+    if (strncmp(manage_stats.classes[i].name, wm_class, MANAGE_STATS_LABEL_LEN - 1u) == 0)
+      return &manage_stats.classes[i];
+  }
+  if (manage_stats.class_count == MANAGE_STATS_CLASSES)
+    return &manage_stats.classes[MANAGE_STATS_CLASSES];
+
+  manage_class_stats_t* row = &manage_stats.classes[manage_stats.class_count++];
+  label_copy(row->name, wm_class);
+  return row;
+}
+
+void manage_stats_record(const manage_timing_t* m, uint8_t window_type, const char* wm_class, const char* probe) {
+  uint64_t paint = m->t[MANAGE_MARK_PAINT];
+  if (paint == 0)
+    return;
+
+  uint64_t stage_ns[MANAGE_STAGE_COUNT] = {0};
+  uint64_t first = 0;
+  for (int i = 0; i < MANAGE_MARK_COUNT; i++) {
+    if (m->t[i] != 0 && first == 0)
+      first = m->t[i];
+    if (i == MANAGE_STAGE_TOTAL)
+      continue;
+    // A missing or out-of-order mark drops only the stages touching it
+    if (m->t[i] == 0 || m->t[i + 1] == 0 || m->t[i + 1] < m->t[i])
+      continue;
+    stage_ns[i] = m->t[i + 1] - m->t[i];
+    latency_hist_record(&manage_stats.stage[i], stage_ns[i]);
+  }
+  uint64_t total = paint - first;
+  stage_ns[MANAGE_STAGE_TOTAL] = total;
+  latency_hist_record(&manage_stats.stage[MANAGE_STAGE_TOTAL], total);
+
+  if (window_type < MANAGE_STATS_TYPES)
+    latency_hist_record(&manage_stats.by_type[window_type], total);
+
+  manage_class_stats_t* row = manage_class_row(wm_class);
+  latency_hist_record(&row->total, total);
+  if (probe && m->slowest_probe_ns >= row->worst_probe_ns) {
+    row->worst_probe_ns = m->slowest_probe_ns;
+    label_copy(row->worst_probe, probe);
+  }
+
+  if (total >= manage_stats.slowest_stage_ns[MANAGE_STAGE_TOTAL]) {
+    memcpy(manage_stats.slowest_stage_ns, stage_ns, sizeof(stage_ns));
+    label_copy(manage_stats.slowest_class, row == &manage_stats.classes[MANAGE_STATS_CLASSES] ? wm_class : row->name);
+    label_copy(manage_stats.slowest_probe, probe);
+    manage_stats.slowest_probe_ns = m->slowest_probe_ns;
+    manage_stats.slowest_type = window_type;
+  }
+}
+
+static double ns_to_us(uint64_t ns) {
+  return (double)ns / 1000.0;
+}
+
+static const char* manage_type_name(uint8_t type) {
+  return type < WINDOW_TYPE_COUNT ? manage_type_names[type] : "?";
+}
+
+size_t manage_stats_format(char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+
+  size_t off = 0;
+  buf[0] = '\0';
+
+#define MS_APPEND(...)                                                  \
+  do {                                                                  \
+    if (off < cap) {                                                    \
+      int n_ = snprintf(buf + off, cap - off, __VA_ARGS__);             \
+      if (n_ > 0)                                                       \
+        off += ((size_t)n_ < cap - off) ? (size_t)n_ : cap - off - 1u; \
+    }                                                                   \
+  } while (0)
+
+  if (manage_stats.discarded_probing || manage_stats.discarded_ready)
+    MS_APPEND("manage discarded before framing: probing=%" PRIu64 " ready=%" PRIu64 "\n", manage_stats.discarded_probing,
+              manage_stats.discarded_ready);
+
+  if (manage_stats.stage[MANAGE_STAGE_TOTAL].count == 0)
+    return off;
+
+  MS_APPEND("manage latency (us)\n");
+  MS_APPEND("%-12s %10s %9s %9s %9s %9s\n", "stage", "count", "p50", "p90", "p99", "max");
+  for (int i = 0; i < MANAGE_STAGE_COUNT; i++) {
+    const latency_hist_t* h = &manage_stats.stage[i];
+    if (h->count == 0)
+      continue;
+    MS_APPEND("%-12s %10" PRIu64 " %9.1f %9.1f %9.1f %9.1f\n", manage_stage_names[i], h->count,
+              ns_to_us(latency_hist_quantile(h, 5000)), ns_to_us(latency_hist_quantile(h, 9000)),
+              ns_to_us(latency_hist_quantile(h, 9900)), ns_to_us(h->max_ns));
+  }
+
+  MS_APPEND("manage total by type (us):");
+  for (int i = 0; i < WINDOW_TYPE_COUNT; i++) {
+    const latency_hist_t* h = &manage_stats.by_type[i];
+    if (h->count > 0)
+      MS_APPEND(" %s=%" PRIu64 "/%.1f/%.1f", manage_type_names[i], h->count, ns_to_us(latency_hist_quantile(h, 5000)),
+                ns_to_us(h->max_ns));
+  }
+  MS_APPEND(" (count/p50/max)\n");
+
+  MS_APPEND("manage total by class (us)\n");
+  for (int i = 0; i <= MANAGE_STATS_CLASSES; i++) {
+    const manage_class_stats_t* row = &manage_stats.classes[i];
+    if (row->total.count == 0)
+      continue;
+    MS_APPEND("  %-24s n=%" PRIu64 " p50=%.1f p99=%.1f max=%.1f", row->name, row->total.count,
+              ns_to_us(latency_hist_quantile(&row->total, 5000)), ns_to_us(latency_hist_quantile(&row->total, 9900)),
+              ns_to_us(row->total.max_ns));
+    if (row->worst_probe[0])
+      MS_APPEND(" worst_probe=%s/%.1f", row->worst_probe, ns_to_us(row->worst_probe_ns));
+    MS_APPEND("\n");
+  }
+
+  MS_APPEND("slowest manage: class=%s type=%s", manage_stats.slowest_class, manage_type_name(manage_stats.slowest_type));
+  for (int i = 0; i < MANAGE_STAGE_COUNT; i++)
+    MS_APPEND(" %s=%.1f", manage_stage_names[i], ns_to_us(manage_stats.slowest_stage_ns[i]));
+  if (manage_stats.slowest_probe[0])
+    MS_APPEND(" probe=%s/%.1f", manage_stats.slowest_probe, ns_to_us(manage_stats.slowest_probe_ns));
+  MS_APPEND("\n");
+
+#undef MS_APPEND
+
+  return off;
+}
+
+void manage_stats_dump(void) {
+  char buf[4096];
+  if (manage_stats_format(buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
+}
@@ -0,0 +1,342 @@
+/* src/mem_budget.c
+ * Per-subsystem memory accounting and the budget-enforcing evictor
+ *
+ * Eviction only touches state the paint path already knows how to rebuild:
+ * a released title run is looked up or reshaped by render_frame, a freed
+ * render context is recreated by render_context_ensure, and an icon reset to
+ * ICON_FETCH_WANTED is refetched by client_icon_request on the next draw.
+ * Clients mid-fetch or with a title run on the render worker are skipped.
+ */
+
+#include "mem_budget.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "client.h"
+#include "event.h"
+#include "frame.h"
+#include "hxm.h"
+#include "prewarm.h"
+#include "render.h"
+#include "str_intern.h"
+
+static const char* const mem_class_names[MEM_CLASS_COUNT] = {
+    "client_slots", "client_strings", "render", "titles", "icons", "menu_icons", "thumbnails", "tick_arena",
+};
+
+static const char* const mem_evict_names[MEM_EVICT_COUNT] = {
+    "title_pool",
+    "frame_pool",
+    "titles",
+    "render",
+    "icons",
+    "idle_render",
+    "strings",
+};
+
+const char* mem_class_name(mem_class_t c) {
+  return (unsigned)c < MEM_CLASS_COUNT ? mem_class_names[c] : "?";
+}
+
+const char* mem_evict_name(mem_evict_t e) {
+  return (unsigned)e < MEM_EVICT_COUNT ? mem_evict_names[e] : "?";
+}
+
+static size_t image_bytes(cairo_surface_t* surface) {
+  if (!surface || cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE)
+    return 0;
+  return (size_t)cairo_image_surface_get_stride(surface) * (size_t)cairo_image_surface_get_height(surface);
+}
+
+// A holder's share of a surface others may reference too
+static size_t image_share(cairo_surface_t* surface) {
+  size_t bytes = image_bytes(surface);
+  unsigned refs = bytes ? cairo_surface_get_reference_count(surface) : 0;
+  return refs > 1 ? bytes / refs : bytes;
+}
+
+static size_t pixmap_bytes(uint32_t w, uint32_t h) {
+  return (size_t)w * (size_t)h * 4u;
+}
+
+static bool client_on_other_desktop(const server_t* s, const client_hot_t* hot) {
+  return !hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != s->screens[hot->screen].current_desktop;
+}
+
+static bool client_is_settled(const client_hot_t* hot) {
+  return hot->frame != XCB_NONE && (hot->state == STATE_MAPPED || hot->state == STATE_UNMAPPED);
+}
+
+// Iconified, withdrawn, or framed on a desktop that is not shown
+static bool client_is_hidden(const server_t* s, const client_hot_t* hot) {
+  return hot->state == STATE_UNMAPPED || client_on_other_desktop(s, hot);
+}
+
+static bool client_holds_render(const client_cold_t* cold) {
+  const render_context_t* ctx = &cold->render_ctx;
+  return ctx->surface || ctx->cr || ctx->layout || ctx->title_surface || cold->frame_pixmap != XCB_NONE;
+}
+
+/*
+ * Tear down the render context and frame backing of a hidden client.
+ * Returns the bytes released; *queued is set when X requests went out.
+ */
+static size_t client_release_render(server_t* s, const client_hot_t* hot, client_cold_t* cold, bool* queued) {
+  render_context_t* ctx = &cold->render_ctx;
+  size_t bytes = image_bytes(ctx->surface) + image_share(ctx->title_surface);
+  render_free(ctx);
+  render_init(ctx);
+  if (cold->frame_pixmap != XCB_NONE) {
+    // The window background keeps the pixmap alive until it is replaced;
+    // the expose on the next map repaints into a fresh one
+    bytes += pixmap_bytes(cold->frame_pixmap_w, cold->frame_pixmap_h);
+    client_frame_backing_destroy(s->conn, cold);
+    uint32_t pixel = FRAME_BACKGROUND_PIXEL;
+    xcb_change_window_attributes(s->conn, hot->frame, XCB_CW_BACK_PIXEL, &pixel);
+    *queued = true;
+  }
+  cold->render_idle_s = 0;
+  return bytes;
+}
+
+void mem_usage_measure(server_t* s, mem_usage_t* out) {
+  memset(out, 0, sizeof(*out));
+
+  const slotmap_t* sm = &s->clients;
+  size_t cap = slotmap_capacity(sm);
+  out->bytes[MEM_CLIENT_SLOTS] = cap * (sm->hot_sz + sm->cold_sz + sizeof(slot_hdr_t)) + (cap + 63u) / 64u * sizeof(uint64_t);
+
+  uint32_t idx;
+  slotmap_for_each_live(sm, idx) {
+    client_cold_t* cold = slotmap_cold_at(sm, idx);
+    out->bytes[MEM_CLIENT_STRINGS] += cold->string_arena.reserved;
+    out->bytes[MEM_RENDER] += image_bytes(cold->render_ctx.surface) + pixmap_bytes(cold->frame_pixmap_w, cold->frame_pixmap_h);
+    out->bytes[MEM_TITLES] += image_share(cold->render_ctx.title_surface);
+    out->bytes[MEM_ICONS] += image_share(cold->icon_surface);
+    if (cold->thumb)
+      out->bytes[MEM_THUMBNAILS] += pixmap_bytes(cold->thumb_w, cold->thumb_h);
+  }
+
+  out->bytes[MEM_RENDER] += pixmap_bytes(s->menu.back_w, s->menu.back_h) + frame_pool_bytes(&s->frame_pool);
+  out->bytes[MEM_CLIENT_STRINGS] += str_intern_bytes();
+  out->bytes[MEM_TITLES] += title_cache_bytes(&s->title_cache);
+  out->bytes[MEM_ICONS] += image_share(s->default_icon);
+  for (uint32_t i = 0; i < s->menu.config_count; i++)
+    out->bytes[MEM_MENU_ICONS] += image_bytes(s->menu.config_items[i].icon_surface);
+  out->bytes[MEM_TICK_ARENA] = s->tick_arena.reserved;
+
+  for (int i = 0; i < MEM_CLASS_COUNT; i++)
+    out->total += out->bytes[i];
+}
+
+static void mem_evicted(server_t* s, mem_evict_t kind, size_t bytes, size_t* total) {
+  s->mem_budget.evicted[kind]++;
+  s->mem_budget.evicted_bytes[kind] += bytes;
+  *total = *total > bytes ? *total - bytes : 0;
+}
+
+// Titles of hidden clients; only runs nobody else holds actually free memory
+static void evict_titles(server_t* s, size_t target, size_t* total) {
+  uint32_t idx;
+  slotmap_for_each_live(&s->clients, idx) {
+    if (*total <= target)
+      return;
+    const client_hot_t* hot = slotmap_hot_at(&s->clients, idx);
+    client_cold_t* cold = slotmap_cold_at(&s->clients, idx);
+    render_context_t* ctx = &cold->render_ctx;
+    if (!client_is_hidden(s, hot) || !ctx->title_surface || ctx->title_pending)
+      continue;
+    if (cairo_surface_get_reference_count(ctx->title_surface) != 1)
+      continue;
+    size_t bytes = image_bytes(ctx->title_surface);
+    render_release_title(ctx);
+    mem_evicted(s, MEM_EVICT_TITLES, bytes, total);
+  }
+}
+
+static bool evict_render(server_t* s, size_t target, size_t* total) {
+  bool queued = false;
+  uint32_t idx;
+  slotmap_for_each_live(&s->clients, idx) {
+    if (*total <= target)
+      break;
+    const client_hot_t* hot = slotmap_hot_at(&s->clients, idx);
+    client_cold_t* cold = slotmap_cold_at(&s->clients, idx);
+    if (!client_is_settled(hot) || !client_is_hidden(s, hot) || cold->render_ctx.title_pending || !client_holds_render(cold))
+      continue;
+    mem_evicted(s, MEM_EVICT_RENDER, client_release_render(s, hot, cold, &queued), total);
+  }
+  return queued;
+}
+
+static void evict_icons(server_t* s, size_t target, size_t* total) {
+  uint32_t idx;
+  slotmap_for_each_live(&s->clients, idx) {
+    if (*total <= target)
+      return;
+    const client_hot_t* hot = slotmap_hot_at(&s->clients, idx);
+    client_cold_t* cold = slotmap_cold_at(&s->clients, idx);
+    cairo_surface_t* icon = cold->icon_surface;
+    if (!client_is_hidden(s, hot) || !icon || cold->icon_fetch.phase != ICON_FETCH_IDLE)
+      continue;
+    if (cairo_surface_get_type(icon) != CAIRO_SURFACE_TYPE_IMAGE)
+      continue;
+    if (cairo_image_surface_get_width(icon) <= MEM_BUDGET_ICON_MAX_PX && cairo_image_surface_get_height(icon) <= MEM_BUDGET_ICON_MAX_PX)
+      continue;
+
+    size_t bytes = image_share(icon);
+    cairo_surface_destroy(icon);
+    cold->icon_surface = NULL;
+    cold->icon_fetch.gen++;
+    cold->icon_fetch.phase = ICON_FETCH_WANTED;
+    mem_evicted(s, MEM_EVICT_ICONS, bytes, total);
+  }
+}
+
+/*
+ * Count how long each hidden client has held its render context and release
+ * those past config.render_idle_release_s. Visible clients restart at 0.
+ */
+static bool release_idle_render(server_t* s, uint64_t elapsed_ns) {
+  uint32_t after_s = s->config.render_idle_release_s < UINT16_MAX ? s->config.render_idle_release_s : UINT16_MAX;
+  uint64_t elapsed_s = elapsed_ns / 1000000000ull;
+  bool queued = false;
+  uint32_t idx;
+  slotmap_for_each_live(&s->clients, idx) {
+    const client_hot_t* hot = slotmap_hot_at(&s->clients, idx);
+    client_cold_t* cold = slotmap_cold_at(&s->clients, idx);
+    if (!client_is_settled(hot) || !client_is_hidden(s, hot) || !client_holds_render(cold) || prewarm_keeps(s, hot)) {
+      cold->render_idle_s = 0;
+      continue;
+    }
+    uint64_t idle = cold->render_idle_s + elapsed_s;
+    cold->render_idle_s = idle < UINT16_MAX ? (uint16_t)idle : UINT16_MAX;
+    if (after_s == 0 || cold->render_idle_s < after_s || cold->render_ctx.title_pending)
+      continue;
+
+    size_t bytes = client_release_render(s, hot, cold, &queued);
+    s->mem_budget.evicted[MEM_EVICT_IDLE_RENDER]++;
+    s->mem_budget.evicted_bytes[MEM_EVICT_IDLE_RENDER] += bytes;
+  }
+  return queued;
+}
+
+// Every pooled frame goes; a frame is cheap next to the render context it holds
+static bool evict_frame_pool(server_t* s, size_t* total) {
+  uint32_t frames = frame_pool_size(&s->frame_pool);
+  if (frames == 0)
+    return false;
+  size_t bytes = frame_pool_trim(&s->frame_pool, s->conn, 0);
+  s->mem_budget.evicted[MEM_EVICT_FRAME_POOL] += frames;
+  s->mem_budget.evicted_bytes[MEM_EVICT_FRAME_POOL] += bytes;
+  *total = *total > bytes ? *total - bytes : 0;
+  return true;
+}
+
+size_t mem_budget_enforce(server_t* s, size_t target, bool* x_queued) {
+  mem_usage_t usage;
+  mem_usage_measure(s, &usage);
+  size_t total = usage.total;
+  if (total <= target)
+    return 0;
+
+  size_t before = total;
+  size_t pooled = title_cache_trim_pool(&s->title_cache);
+  if (pooled)
+    mem_evicted(s, MEM_EVICT_TITLE_POOL, pooled, &total);
+  if (total > target && evict_frame_pool(s, &total) && x_queued)
+    *x_queued = true;
+  if (total > target)
+    evict_titles(s, target, &total);
+  if (total > target && evict_render(s, target, &total) && x_queued)
+    *x_queued = true;
+  if (total > target)
+    evict_icons(s, target, &total);
+
+  if (total > target)
+    LOG_DEBUG("memory budget: %zu bytes still above target %zu after eviction", total, target);
+  return before - total;
+}
+
+bool mem_budget_tick(server_t* s, uint64_t now_ns) {
+  mem_budget_t* mb = &s->mem_budget;
+  if (now_ns < mb->next_check_ns)
+    return false;
+  mb->next_check_ns = now_ns + MEM_BUDGET_INTERVAL_NS;
+
+  // The loop sleeps while idle, so a check may come long after the last one
+  uint64_t elapsed_ns = mb->last_check_ns ? now_ns - mb->last_check_ns : 0;
+  mb->last_check_ns = now_ns;
+  bool queued = release_idle_render(s, elapsed_ns);
+
+  // A reload may have lowered frame_pool_size
+  if (frame_pool_size(&s->frame_pool) > s->config.frame_pool_size) {
+    frame_pool_trim(&s->frame_pool, s->conn, s->config.frame_pool_size);
+    queued = true;
+  }
+
+  mem_usage_measure(s, &mb->last);
+  mb->checks++;
+  if (mb->last.total > mb->peak_total)
+    mb->peak_total = mb->last.total;
+
+  size_t limit = (size_t)s->config.memory_budget_mb << 20;
+  if (limit == 0 || mb->last.total <= limit)
+    return queued;
+
+  mb->over_budget++;
+  mem_budget_enforce(s, limit / 100u * MEM_BUDGET_LOW_WATER, &queued);
+  return queued;
+}
+
+size_t mem_budget_format(const mem_budget_t* mb, size_t limit, char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+
+  size_t off = 0;
+  buf[0] = '\0';
+
+#define MB_APPEND(...)                                                  \
+  do {                                                                  \
+    if (off < cap) {                                                    \
+      int n_ = snprintf(buf + off, cap - off, __VA_ARGS__);             \
+      if (n_ > 0)                                                       \
+        off += ((size_t)n_ < cap - off) ? (size_t)n_ : cap - off - 1u; \
+    }                                                                   \
+  } while (0)
+
+  if (mb->checks == 0)
+    return 0;
+
+  MB_APPEND("memory (KiB): total=%zu peak=%zu", mb->last.total / 1024u, mb->peak_total / 1024u);
+  if (limit)
+    MB_APPEND(" budget=%zu over=%" PRIu64, limit / 1024u, mb->over_budget);
+  MB_APPEND("\n ");
+  for (int i = 0; i < MEM_CLASS_COUNT; i++)
+    MB_APPEND(" %s=%zu", mem_class_names[i], mb->last.bytes[i] / 1024u);
+  MB_APPEND("\n");
+
+  bool any = false;
+  for (int i = 0; i < MEM_EVICT_COUNT; i++)
+    any = any || mb->evicted[i] > 0;
+  if (any) {
+    MB_APPEND("memory evicted:");
+    for (int i = 0; i < MEM_EVICT_COUNT; i++)
+      MB_APPEND(" %s=%" PRIu64 "/%zuKiB", mem_evict_names[i], mb->evicted[i], mb->evicted_bytes[i] / 1024u);
+    MB_APPEND("\n");
+  }
+
+#undef MB_APPEND
+
+  return off;
+}
+
+void mem_budget_dump(const mem_budget_t* mb, size_t limit) {
+  char buf[1024];
+  if (mem_budget_format(mb, limit, buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
+}
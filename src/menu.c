@@ -20,7 +20,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <unistd.h>
 #include <xcb/xcb_icccm.h>
 #include <yaml.h>
@@ -28,44 +27,30 @@
 #include "client.h"
 #include "event.h"
 #include "hxm.h"
+#include "icon_cache.h"
+#include "thumbnail.h"
 #include "wm.h"
 #include "xcb_utils.h"
 
 #define MENU_PADDING 4
 #define MENU_ITEM_HEIGHT 24
 #define MENU_WIDTH 240
+#define MENU_ICON_SIZE (MENU_ITEM_HEIGHT - 6)
+#define MENU_THUMB_ROW_HEIGHT (THUMBNAIL_MAX_H + 2 * MENU_PADDING)
 
-static void* xmalloc(size_t n) {
-  void* p = malloc(n);
-  if (!p) {
+static void* xrealloc(void* p, size_t n) {
+  void* q = realloc(p, n);
+  if (!q) {
     LOG_ERROR("oom");
     abort();
   }
-  return p;
-}
-
-static void* xcalloc(size_t n, size_t sz) {
-  void* p = calloc(n, sz);
-  if (!p) {
-    LOG_ERROR("oom");
-    abort();
-  }
-  return p;
-}
-
-static char* xstrdup(const char* s) {
-  if (!s)
-    return NULL;
-  char* p = strdup(s);
-  if (!p) {
-    LOG_ERROR("oom");
-    abort();
-  }
-  return p;
+  return q;
 }
 
 static int menu_find_next_selectable(server_t* s, int start, int dir);
 static int menu_find_first_selectable(server_t* s);
+static void menu_back_release(server_t* s);
+static void menu_set_selected(server_t* s, int32_t index);
 
 typedef enum menu_grab_context {
   MENU_GRAB_CONTEXT_ROOT = 1,
@@ -148,23 +133,9 @@ static void menu_enqueue_grab_cookie(server_t* s, uint32_t sequence, cookie_type
 static bool switcher_is_candidate(const server_t* s, const client_hot_t* hot) {
   if (!s || !hot)
     return false;
-  if (s->showing_desktop && hot->show_desktop_hidden)
+  if (s->screens[hot->screen].showing_desktop && hot->show_desktop_hidden)
     return false;
-
-  switch (hot->type) {
-    case WINDOW_TYPE_DOCK:
-    case WINDOW_TYPE_NOTIFICATION:
-    case WINDOW_TYPE_DESKTOP:
-    case WINDOW_TYPE_MENU:
-    case WINDOW_TYPE_DROPDOWN_MENU:
-    case WINDOW_TYPE_POPUP_MENU:
-    case WINDOW_TYPE_TOOLTIP:
-    case WINDOW_TYPE_COMBO:
-    case WINDOW_TYPE_DND:
-      return false;
-    default:
-      return true;
-  }
+  return (focus_mru_client_flags(hot) & FOCUS_MRU_SWITCHABLE) != 0;
 }
 
 static void menu_format_client_label(const server_t* s, const client_hot_t* hot, const client_cold_t* cold, char* out, size_t out_len) {
@@ -174,7 +145,7 @@ static void menu_format_client_label(const server_t* s, const client_hot_t* hot,
 
   tag[0] = '\0';
 
-  if (hot && !hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != s->current_desktop) {
+  if (hot && !hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != s->screens[hot->screen].current_desktop) {
     pos += (size_t)snprintf(tag + pos, sizeof(tag) - pos, "ws %d", hot->desktop);
   }
   if (hot && hot->state == STATE_UNMAPPED) {
@@ -193,96 +164,178 @@ static void menu_format_client_label(const server_t* s, const client_hot_t* hot,
   }
 }
 
-static void menu_clear_items(server_t* s) {
-  for (size_t i = 0; i < s->menu.items.length; i++) {
-    menu_item_t* item = s->menu.items.items[i];
-    if (item->label)
-      free(item->label);
-    if (item->cmd)
-      free(item->cmd);
-    if (item->icon_path)
-      free(item->icon_path);
-    if (item->icon_surface)
-      cairo_surface_destroy(item->icon_surface);
-    free(item);
+static void menu_format_list_label(const client_hot_t* hot, const client_cold_t* cold, char* out, size_t out_len) {
+  const char* title = (cold && cold->title) ? cold->title : "Unnamed";
+  if (hot && hot->state == STATE_UNMAPPED)
+    snprintf(out, out_len, "[%s]", title);
+  else
+    snprintf(out, out_len, "%s", title);
+}
+
+/*
+ * Type-ahead index
+ *
+ * Every item carries a 64-bit mask of the characters in its label and
+ * command, folded to lower case and bucketed by (c - 0x20) & 63. A query can
+ * only be a subsequence of a string whose mask covers the query's mask, so
+ * one AND rejects most rows before the subsequence walk. Config masks are
+ * built while menu.conf is parsed and client rows are refreshed when a title
+ * changes, so a keystroke never rescans strings it can rule out.
+ */
+
+static inline uint8_t menu_fold(uint8_t c) {
+  return (c >= 'A' && c <= 'Z') ? (uint8_t)(c + ('a' - 'A')) : c;
+}
+
+static inline uint64_t menu_match_bit(uint8_t c) {
+  return 1ull << ((uint8_t)(menu_fold(c) - 0x20u) & 63u);
+}
+
+static uint64_t menu_match_mask(const char* str) {
+  uint64_t mask = 0;
+  for (const uint8_t* p = (const uint8_t*)str; p && *p; p++)
+    mask |= menu_match_bit(*p);
+  return mask;
+}
+
+/* needle is already folded */
+static bool menu_subsequence(const char* hay, const char* needle, uint32_t len) {
+  if (!hay)
+    return false;
+  uint32_t n = 0;
+  for (const uint8_t* p = (const uint8_t*)hay; *p && n < len; p++) {
+    if (menu_fold(*p) == (uint8_t)needle[n])
+      n++;
   }
-  small_vec_clear(&s->menu.items);
+  return n == len;
+}
+
+static bool menu_item_matches(const menu_t* m, const menu_item_t* item) {
+  if (m->filter_len == 0)
+    return true;
+  if (item->action == MENU_ACTION_SEPARATOR || item->action == MENU_ACTION_NONE)
+    return false;
+  if ((item->match_mask & m->filter_mask) != m->filter_mask)
+    return false;
+  return menu_subsequence(item->label, m->filter, m->filter_len) || menu_subsequence(item->cmd, m->filter, m->filter_len);
+}
+
+static void menu_clear_items(server_t* s) {
+  s->menu.item_count = 0;
+  s->menu.row_count = 0;
+  s->menu.item_height = MENU_ITEM_HEIGHT;
+  s->menu.filter_len = 0;
+  s->menu.filter[0] = '\0';
+  s->menu.filter_mask = 0;
+  arena_reset(&s->menu.item_arena);
 }
 
 static void menu_clear_config(menu_t* m) {
-  if (!m)
-    return;
-  for (size_t i = 0; i < m->config_items.length; i++) {
-    menu_item_spec_t* spec = m->config_items.items[i];
-    if (!spec)
-      continue;
-    free(spec->label);
-    free(spec->cmd);
-    free(spec->icon_path);
-    free(spec);
+  for (uint32_t i = 0; i < m->config_count; i++) {
+    if (m->config_items[i].icon_surface)
+      cairo_surface_destroy(m->config_items[i].icon_surface);
   }
-  small_vec_clear(&m->config_items);
+  arena_destroy(&m->config_arena);
+  m->config_items = NULL;
+  m->config_count = 0;
 }
 
-static cairo_surface_t* menu_load_icon(const char* path) {
-  if (!path || path[0] == '\0')
-    return NULL;
-
-  const char* dot = strrchr(path, '.');
-  bool is_svg = (dot && strcasecmp(dot, ".svg") == 0);
+/* Fit w x h into a size x size box, keeping aspect */
+static void menu_icon_fit(int w, int h, int size, int* out_w, int* out_h) {
+  if (w < 1)
+    w = 1;
+  if (h < 1)
+    h = 1;
+  int longest = (w > h) ? w : h;
+  *out_w = (int)((double)w * size / longest + 0.5);
+  *out_h = (int)((double)h * size / longest + 0.5);
+  if (*out_w < 1)
+    *out_w = 1;
+  if (*out_h < 1)
+    *out_h = 1;
+}
 
-  if (is_svg) {
-    GError* error = NULL;
-    RsvgHandle* handle = rsvg_handle_new_from_file(path, &error);
-    if (!handle) {
-      if (error) {
-        if (!g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
-          LOG_WARN("Failed to load SVG icon %s: %s", path, error->message);
-        }
-        g_error_free(error);
+static cairo_surface_t* menu_render_svg(const char* path, int size) {
+  GError* error = NULL;
+  RsvgHandle* handle = rsvg_handle_new_from_file(path, &error);
+  if (!handle) {
+    if (error) {
+      if (!g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+        LOG_WARN("Failed to load SVG icon %s: %s", path, error->message);
       }
-      return NULL;
+      g_error_free(error);
     }
+    return NULL;
+  }
 
-    gdouble width = 0, height = 0;
-    if (!rsvg_handle_get_intrinsic_size_in_pixels(handle, &width, &height)) {
-      width = 16;
-      height = 16;
-    }
-    int w = (int)width;
-    int h = (int)height;
-    if (w <= 0)
-      w = 16;
-    if (h <= 0)
-      h = 16;
-
-    RsvgRectangle viewport = {0.0, 0.0, (double)w, (double)h};
-    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
-    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
-      g_object_unref(handle);
-      cairo_surface_destroy(surface);
-      return NULL;
-    }
+  gdouble width = 0, height = 0;
+  if (!rsvg_handle_get_intrinsic_size_in_pixels(handle, &width, &height) || width <= 0 || height <= 0) {
+    width = size;
+    height = size;
+  }
+  int w, h;
+  menu_icon_fit((int)(width + 0.5), (int)(height + 0.5), size, &w, &h);
 
-    cairo_t* cr = cairo_create(surface);
-    gboolean ok = rsvg_handle_render_document(handle, cr, &viewport, &error);
-    if (!ok || error) {
-      LOG_WARN("Failed to render SVG icon %s: %s", path, error ? error->message : "unknown error");
-      if (error)
-        g_error_free(error);
-    }
-    cairo_destroy(cr);
+  // Rendered straight at display size: no intrinsic-size raster to rescale
+  RsvgRectangle viewport = {0.0, 0.0, (double)w, (double)h};
+  cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
     g_object_unref(handle);
-    return surface;
+    cairo_surface_destroy(surface);
+    return NULL;
   }
-  else {
-    cairo_surface_t* surface = cairo_image_surface_create_from_png(path);
-    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
-      cairo_surface_destroy(surface);
-      return NULL;
-    }
+
+  cairo_t* cr = cairo_create(surface);
+  gboolean ok = rsvg_handle_render_document(handle, cr, &viewport, &error);
+  if (!ok || error) {
+    LOG_WARN("Failed to render SVG icon %s: %s", path, error ? error->message : "unknown error");
+    if (error)
+      g_error_free(error);
+  }
+  cairo_destroy(cr);
+  g_object_unref(handle);
+  cairo_surface_flush(surface);
+  return surface;
+}
+
+static cairo_surface_t* menu_render_png(const char* path, int size) {
+  cairo_surface_t* surface = cairo_image_surface_create_from_png(path);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+
+  cairo_surface_t* scaled = icon_cache_scaled(surface, size);
+  if (scaled == surface)
     return surface;
+  // The variant is owned by the full-size decode; keep only the variant
+  if (scaled)
+    cairo_surface_reference(scaled);
+  cairo_surface_destroy(surface);
+  return scaled;
+}
+
+/*
+ * Load a menu icon rasterized to fit size x size. The disk cache is checked
+ * first so an unchanged icon is never decoded twice across starts.
+ */
+static cairo_surface_t* menu_load_icon(const char* path, int size, bool disk_cache) {
+  if (!path || path[0] == '\0')
+    return NULL;
+
+  if (disk_cache) {
+    cairo_surface_t* cached = icon_cache_disk_load(path, size);
+    if (cached)
+      return cached;
   }
+
+  const char* dot = strrchr(path, '.');
+  bool is_svg = (dot && strcasecmp(dot, ".svg") == 0);
+  cairo_surface_t* surface = is_svg ? menu_render_svg(path, size) : menu_render_png(path, size);
+
+  if (surface && disk_cache)
+    icon_cache_disk_store(path, size, surface);
+  return surface;
 }
 
 static bool parse_bool_scalar(const char* val) {
@@ -312,6 +365,162 @@ static menu_action_t parse_action_scalar(const char* val) {
   return MENU_ACTION_NONE;
 }
 
+/*
+ * menu.conf is parsed from the event stream, not a loaded document: items
+ * go straight into a scratch array and their strings into the new config
+ * arena, interned so repeated labels/commands/icons are stored once.
+ */
+typedef struct menu_parse {
+  yaml_parser_t parser;
+  arena_t arena;
+  hash_map_t strings; /* FNV-1a -> interned string */
+  menu_item_spec_t* specs;
+  uint32_t count;
+  uint32_t cap;
+} menu_parse_t;
+
+static const char* menu_parse_intern(menu_parse_t* p, const char* str, size_t len) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < len; i++)
+    hash = (hash ^ (uint8_t)str[i]) * 1099511628211ull;
+
+  const char* known = hash_map_get(&p->strings, hash);
+  if (known && strncmp(known, str, len) == 0 && known[len] == '\0')
+    return known;
+  char* copy = arena_strndup(&p->arena, str, len);
+  if (!known)
+    hash_map_insert(&p->strings, hash, copy);
+  return copy;
+}
+
+static bool menu_parse_next(menu_parse_t* p, yaml_event_t* ev) {
+  if (yaml_parser_parse(&p->parser, ev))
+    return true;
+  LOG_WARN("YAML parse error in menu.conf: %s", p->parser.problem ? p->parser.problem : "unknown");
+  return false;
+}
+
+/* Consume the rest of the node that ev starts; ev is deleted */
+static bool menu_parse_skip(menu_parse_t* p, yaml_event_t* ev) {
+  int depth = (ev->type == YAML_SEQUENCE_START_EVENT || ev->type == YAML_MAPPING_START_EVENT) ? 1 : 0;
+  yaml_event_delete(ev);
+  while (depth > 0) {
+    yaml_event_t inner;
+    if (!menu_parse_next(p, &inner))
+      return false;
+    if (inner.type == YAML_SEQUENCE_START_EVENT || inner.type == YAML_MAPPING_START_EVENT)
+      depth++;
+    else if (inner.type == YAML_SEQUENCE_END_EVENT || inner.type == YAML_MAPPING_END_EVENT)
+      depth--;
+    yaml_event_delete(&inner);
+  }
+  return true;
+}
+
+/* Parse one item mapping (its MAPPING_START already consumed) */
+static bool menu_parse_item(menu_parse_t* p) {
+  menu_item_spec_t spec = {0};
+  bool separator_flag = false;
+
+  for (;;) {
+    yaml_event_t key;
+    if (!menu_parse_next(p, &key))
+      return false;
+    if (key.type == YAML_MAPPING_END_EVENT) {
+      yaml_event_delete(&key);
+      break;
+    }
+
+    char name[16] = "";
+    if (key.type == YAML_SCALAR_EVENT && key.data.scalar.length < sizeof(name))
+      memcpy(name, key.data.scalar.value, key.data.scalar.length + 1);
+    bool key_ok = key.type == YAML_SCALAR_EVENT;
+    if (!menu_parse_skip(p, &key))
+      return false;
+
+    yaml_event_t val;
+    if (!menu_parse_next(p, &val))
+      return false;
+    if (!key_ok || val.type != YAML_SCALAR_EVENT) {
+      if (!menu_parse_skip(p, &val))
+        return false;
+      continue;
+    }
+
+    const char* v = (const char*)val.data.scalar.value;
+    size_t vlen = val.data.scalar.length;
+    if (strcasecmp(name, "separator") == 0)
+      separator_flag = parse_bool_scalar(v);
+    else if (strcasecmp(name, "label") == 0)
+      spec.label = menu_parse_intern(p, v, vlen);
+    else if (strcasecmp(name, "action") == 0)
+      spec.action = parse_action_scalar(v);
+    else if (strcasecmp(name, "cmd") == 0)
+      spec.cmd = menu_parse_intern(p, v, vlen);
+    else if (strcasecmp(name, "icon") == 0)
+      spec.icon_path = menu_parse_intern(p, v, vlen);
+    yaml_event_delete(&val);
+  }
+
+  if (separator_flag) {
+    spec.action = MENU_ACTION_SEPARATOR;
+  }
+  else if (spec.action == MENU_ACTION_NONE && spec.cmd) {
+    spec.action = MENU_ACTION_EXEC;
+  }
+
+  if (spec.action != MENU_ACTION_SEPARATOR && !spec.label) {
+    LOG_WARN("Menu item missing label; skipping");
+    return true;
+  }
+  spec.match_mask = menu_match_mask(spec.label) | menu_match_mask(spec.cmd);
+
+  if (p->count == p->cap) {
+    p->cap = p->cap ? p->cap * 2 : 64;
+    p->specs = xrealloc(p->specs, p->cap * sizeof(*p->specs));
+  }
+  p->specs[p->count++] = spec;
+  return true;
+}
+
+/* Parse the root sequence; false on a syntax error or a non-sequence root */
+static bool menu_parse_stream(menu_parse_t* p, const char* path) {
+  yaml_event_t ev;
+  // STREAM_START, DOCUMENT_START
+  for (int i = 0; i < 2; i++) {
+    if (!menu_parse_next(p, &ev))
+      return false;
+    yaml_event_delete(&ev);
+  }
+
+  if (!menu_parse_next(p, &ev))
+    return false;
+  if (ev.type != YAML_SEQUENCE_START_EVENT) {
+    LOG_WARN("menu.conf must be a YAML sequence of menu items: %s", path);
+    yaml_event_delete(&ev);
+    return false;
+  }
+  yaml_event_delete(&ev);
+
+  for (;;) {
+    if (!menu_parse_next(p, &ev))
+      return false;
+    if (ev.type == YAML_SEQUENCE_END_EVENT) {
+      yaml_event_delete(&ev);
+      return true;
+    }
+    if (ev.type != YAML_MAPPING_START_EVENT) {
+      LOG_WARN("menu.conf item is not a mapping; skipping");
+      if (!menu_parse_skip(p, &ev))
+        return false;
+      continue;
+    }
+    yaml_event_delete(&ev);
+    if (!menu_parse_item(p))
+      return false;
+  }
+}
+
 bool menu_load_config(server_t* s, const char* path) {
   if (!s || !path)
     return false;
@@ -320,124 +529,172 @@ bool menu_load_config(server_t* s, const char* path) {
   if (!f)
     return false;
 
-  yaml_parser_t parser;
-  yaml_document_t doc;
-
-  if (!yaml_parser_initialize(&parser)) {
+  menu_parse_t p;
+  memset(&p, 0, sizeof(p));
+  if (!yaml_parser_initialize(&p.parser)) {
     fclose(f);
     return false;
   }
+  yaml_parser_set_input_file(&p.parser, f);
+  arena_init(&p.arena, 16 * 1024);
+  hash_map_init(&p.strings);
 
-  yaml_parser_set_input_file(&parser, f);
+  bool parsed = menu_parse_stream(&p, path);
+  yaml_parser_delete(&p.parser);
+  hash_map_destroy(&p.strings);
+  fclose(f);
 
-  if (!yaml_parser_load(&parser, &doc)) {
+  if (!parsed) {
     LOG_WARN("Failed to parse YAML in %s", path);
-    yaml_parser_delete(&parser);
-    fclose(f);
-    return false;
-  }
-
-  yaml_node_t* root = yaml_document_get_root_node(&doc);
-  if (!root || root->type != YAML_SEQUENCE_NODE) {
-    LOG_WARN("menu.conf must be a YAML sequence of menu items: %s", path);
-    yaml_document_delete(&doc);
-    yaml_parser_delete(&parser);
-    fclose(f);
+    arena_destroy(&p.arena);
+    free(p.specs);
     return false;
   }
 
+  // Shown items borrow icons from the specs about to be freed
+  if (s->menu.visible)
+    menu_hide(s);
+  menu_clear_items(s);
   menu_clear_config(&s->menu);
 
-  size_t loaded = 0;
-  for (yaml_node_item_t* item = root->data.sequence.items.start; item < root->data.sequence.items.top; item++) {
-    yaml_node_t* node = yaml_document_get_node(&doc, *item);
-    if (!node || node->type != YAML_MAPPING_NODE) {
-      LOG_WARN("menu.conf item is not a mapping; skipping");
-      continue;
-    }
+  s->menu.config_arena = p.arena;
+  s->menu.config_count = p.count;
+  if (p.count > 0) {
+    s->menu.config_items = arena_alloc(&s->menu.config_arena, p.count * sizeof(menu_item_spec_t));
+    memcpy(s->menu.config_items, p.specs, p.count * sizeof(menu_item_spec_t));
+  }
+  free(p.specs);
 
-    menu_item_spec_t* spec = xcalloc(1, sizeof(menu_item_spec_t));
-    bool separator_flag = false;
-
-    for (yaml_node_pair_t* pair = node->data.mapping.pairs.start; pair < node->data.mapping.pairs.top; pair++) {
-      yaml_node_t* key_node = yaml_document_get_node(&doc, pair->key);
-      yaml_node_t* val_node = yaml_document_get_node(&doc, pair->value);
-      if (!key_node || key_node->type != YAML_SCALAR_NODE)
-        continue;
-
-      const char* key = (const char*)key_node->data.scalar.value;
-      if (!key)
-        continue;
-
-      if (strcasecmp(key, "separator") == 0) {
-        if (val_node && val_node->type == YAML_SCALAR_NODE) {
-          const char* val = (const char*)val_node->data.scalar.value;
-          separator_flag = parse_bool_scalar(val);
-        }
-        continue;
-      }
+  if (p.count == 0) {
+    LOG_WARN("Loaded menu.conf from %s but found no items", path);
+    return false;
+  }
 
-      if (!val_node || val_node->type != YAML_SCALAR_NODE)
-        continue;
-      const char* val = (const char*)val_node->data.scalar.value;
-      if (!val)
-        continue;
-
-      if (strcasecmp(key, "label") == 0)
-        spec->label = xstrdup(val);
-      else if (strcasecmp(key, "action") == 0)
-        spec->action = parse_action_scalar(val);
-      else if (strcasecmp(key, "cmd") == 0)
-        spec->cmd = xstrdup(val);
-      else if (strcasecmp(key, "icon") == 0)
-        spec->icon_path = xstrdup(val);
-    }
+  LOG_INFO("Loaded menu config from %s (%u items)", path, p.count);
+  return true;
+}
 
-    if (separator_flag) {
-      spec->action = MENU_ACTION_SEPARATOR;
-    }
-    else if (spec->action == MENU_ACTION_NONE && spec->cmd) {
-      spec->action = MENU_ACTION_EXEC;
-    }
+/*
+ * Compiled menu.conf: the specs as a list of action, match mask and strings.
+ * Icons are not cached here, they have their own disk cache.
+ */
+void menu_store_cache(const server_t* s, const config_cache_sources_t* src) {
+  config_cache_buf_t buf = {0};
+  config_cache_put_u32(&buf, s->menu.config_count);
+  for (uint32_t i = 0; i < s->menu.config_count; i++) {
+    const menu_item_spec_t* spec = &s->menu.config_items[i];
+    config_cache_put_u32(&buf, (uint32_t)spec->action);
+    config_cache_put_u64(&buf, spec->match_mask);
+    config_cache_put_str(&buf, spec->label);
+    config_cache_put_str(&buf, spec->cmd);
+    config_cache_put_str(&buf, spec->icon_path);
+  }
+  config_cache_store(CONFIG_CACHE_MENU, src, &buf);
+  config_cache_buf_free(&buf);
+}
 
-    if (spec->action != MENU_ACTION_SEPARATOR && !spec->label) {
-      LOG_WARN("Menu item missing label; skipping");
-      free(spec->label);
-      free(spec->cmd);
-      free(spec->icon_path);
-      free(spec);
-      continue;
-    }
+static const char* menu_cache_str(arena_t* arena, config_cache_reader_t* r) {
+  const char* str = config_cache_get_str(r);
+  return str ? arena_strdup(arena, str) : NULL;
+}
 
-    small_vec_push(&s->menu.config_items, spec);
-    loaded++;
-  }
+bool menu_load_cache(server_t* s, const config_cache_sources_t* src) {
+  config_cache_map_t map;
+  if (!config_cache_open(&map, CONFIG_CACHE_MENU, src))
+    return false;
 
-  yaml_document_delete(&doc);
-  yaml_parser_delete(&parser);
-  fclose(f);
+  config_cache_reader_t* r = &map.payload;
+  uint32_t count = config_cache_get_u32(r);
+  // Every spec takes at least 24 bytes, which bounds a corrupt count
+  if (count == 0 || count > (size_t)(r->end - r->p) / 24) {
+    config_cache_close(&map);
+    return false;
+  }
 
-  if (loaded == 0) {
-    LOG_WARN("Loaded menu.conf from %s but found no items", path);
+  arena_t arena;
+  arena_init(&arena, 16 * 1024);
+  menu_item_spec_t* specs = arena_alloc(&arena, count * sizeof(menu_item_spec_t));
+  memset(specs, 0, count * sizeof(menu_item_spec_t));
+  for (uint32_t i = 0; r->ok && i < count; i++) {
+    specs[i].action = (menu_action_t)config_cache_get_u32(r);
+    specs[i].match_mask = config_cache_get_u64(r);
+    specs[i].label = menu_cache_str(&arena, r);
+    specs[i].cmd = menu_cache_str(&arena, r);
+    specs[i].icon_path = menu_cache_str(&arena, r);
+    if (specs[i].action > MENU_ACTION_SEPARATOR)
+      r->ok = false;
+  }
+  bool ok = r->ok && r->p == r->end;
+  config_cache_close(&map);
+  if (!ok) {
+    arena_destroy(&arena);
     return false;
   }
 
-  LOG_INFO("Loaded menu config from %s (%zu items)", path, loaded);
+  // Same hand-over as menu_load_config
+  if (s->menu.visible)
+    menu_hide(s);
+  menu_clear_items(s);
+  menu_clear_config(&s->menu);
+  s->menu.config_arena = arena;
+  s->menu.config_items = specs;
+  s->menu.config_count = count;
+  LOG_INFO("Loaded menu config from cache (%u items)", count);
   return true;
 }
 
-static void menu_add_item(server_t* s, const char* label, menu_action_t action, const char* cmd, handle_t client, const char* icon_path) {
-  menu_item_t* item = xmalloc(sizeof(menu_item_t));
-  item->label = label ? xstrdup(label) : NULL;
+static void menu_add_item(server_t* s, const char* label, menu_action_t action, const char* cmd, handle_t client, cairo_surface_t* icon, uint64_t match_mask) {
+  menu_t* m = &s->menu;
+  if (m->item_count == m->item_cap) {
+    m->item_cap = m->item_cap ? m->item_cap * 2 : 32;
+    m->items = xrealloc(m->items, m->item_cap * sizeof(*m->items));
+    m->rows = xrealloc(m->rows, m->item_cap * sizeof(*m->rows));
+    m->rows_next = xrealloc(m->rows_next, m->item_cap * sizeof(*m->rows_next));
+  }
+
+  // Items are only added with the query empty, so every one is shown
+  uint32_t index = m->item_count++;
+  menu_item_t* item = &m->items[index];
+  item->label = label ? arena_strdup(&m->item_arena, label) : NULL;
   item->action = action;
-  item->cmd = cmd ? xstrdup(cmd) : NULL;
+  item->cmd = cmd ? arena_strdup(&m->item_arena, cmd) : NULL;
   item->client = client;
-  item->icon_path = icon_path ? xstrdup(icon_path) : NULL;
-  item->icon_surface = menu_load_icon(icon_path);
-  small_vec_push(&s->menu.items, item);
+  item->icon_surface = icon;
+  item->match_mask = match_mask;
+  item->row = m->row_count;
+  m->rows[m->row_count++] = index;
 
   // Resize menu height
-  s->menu.h = s->menu.items.length * MENU_ITEM_HEIGHT + 2 * MENU_PADDING;
+  s->menu.h = m->item_count * m->item_height + 2 * MENU_PADDING;
+}
+
+static const screen_t* menu_screen(const server_t* s) {
+  return &s->screens[s->menu.screen];
+}
+
+static void menu_create_window(server_t* s) {
+  // Create window (Override Redirect)
+  s->menu.window = xcb_generate_id(s->conn);
+  uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK;
+  uint32_t values[] = {s->config.theme.menu_items.color, 1,
+                       XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE};
+
+  xcb_create_window(s->conn, XCB_COPY_FROM_PARENT, s->menu.window, menu_screen(s)->root, 0, 0, s->menu.w, s->menu.h, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, mask,
+                    values);
+}
+
+static void menu_back_release(server_t* s);
+
+/* A window cannot be reparented across screens, so the menu is recreated
+ * on the active screen's root before it is shown there
+ */
+static void menu_follow_screen(server_t* s) {
+  if (s->menu.screen == s->active_screen || s->menu.window == XCB_NONE)
+    return;
+  xcb_destroy_window(s->conn, s->menu.window);
+  menu_back_release(s);
+  s->menu.screen = s->active_screen;
+  menu_create_window(s);
 }
 
 void menu_init(server_t* s) {
@@ -448,17 +705,28 @@ void menu_init(server_t* s) {
   s->menu.item_height = MENU_ITEM_HEIGHT;
   s->menu.w = MENU_WIDTH;
   s->menu.h = 2 * MENU_PADDING;
-  small_vec_init(&s->menu.items);
-  small_vec_init(&s->menu.config_items);
+  s->menu.back = NULL;
+  s->menu.back_pixmap = XCB_NONE;
+  s->menu.back_w = 0;
+  s->menu.back_h = 0;
+  s->menu.back_selected = -1;
+  s->menu.items = NULL;
+  s->menu.item_count = 0;
+  s->menu.item_cap = 0;
+  s->menu.rows = NULL;
+  s->menu.rows_next = NULL;
+  s->menu.row_count = 0;
+  s->menu.filter_len = 0;
+  s->menu.filter[0] = '\0';
+  s->menu.filter_mask = 0;
+  arena_init(&s->menu.item_arena, 4096);
+  s->menu.config_items = NULL;
+  s->menu.config_count = 0;
+  arena_init(&s->menu.config_arena, 16 * 1024);
   render_init(&s->menu.render_ctx);
 
-  // Create window (Override Redirect)
-  s->menu.window = xcb_generate_id(s->conn);
-  uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK;
-  uint32_t values[] = {s->config.theme.menu_items.color, 1,
-                       XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE};
-
-  xcb_create_window(s->conn, XCB_COPY_FROM_PARENT, s->menu.window, s->root, 0, 0, s->menu.w, s->menu.h, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, mask, values);
+  s->menu.screen = s->active_screen;
+  menu_create_window(s);
 }
 
 void menu_destroy(server_t* s) {
@@ -466,30 +734,38 @@ void menu_destroy(server_t* s) {
     xcb_destroy_window(s->conn, s->menu.window);
     s->menu.window = XCB_NONE;
   }
+  menu_back_release(s);
   render_free(&s->menu.render_ctx);
 
   menu_clear_items(s);
   menu_clear_config(&s->menu);
-  if (s->menu.items.items)
-    small_vec_destroy(&s->menu.items);
-  if (s->menu.config_items.items)
-    small_vec_destroy(&s->menu.config_items);
+  arena_destroy(&s->menu.item_arena);
+  free(s->menu.items);
+  free(s->menu.rows);
+  free(s->menu.rows_next);
+  s->menu.items = NULL;
+  s->menu.rows = NULL;
+  s->menu.rows_next = NULL;
+  s->menu.item_cap = 0;
 }
 
 static void menu_populate_root(server_t* s) {
   menu_clear_items(s);
 
-  if (s->menu.config_items.length == 0) {
-    menu_add_item(s, "(Menu not configured)", MENU_ACTION_NONE, NULL, HANDLE_INVALID, NULL);
+  if (s->menu.config_count == 0) {
+    menu_add_item(s, "(Menu not configured)", MENU_ACTION_NONE, NULL, HANDLE_INVALID, NULL, 0);
     return;
   }
 
-  for (size_t i = 0; i < s->menu.config_items.length; i++) {
-    menu_item_spec_t* spec = s->menu.config_items.items[i];
-    if (!spec)
-      continue;
+  for (uint32_t i = 0; i < s->menu.config_count; i++) {
+    menu_item_spec_t* spec = &s->menu.config_items[i];
+    // Icons are decoded on first show rather than while startup parses the config
+    if (!spec->icon_loaded) {
+      spec->icon_surface = menu_load_icon(spec->icon_path, MENU_ICON_SIZE, !s->is_test);
+      spec->icon_loaded = true;
+    }
     const char* label = (spec->action == MENU_ACTION_SEPARATOR) ? NULL : spec->label;
-    menu_add_item(s, label, spec->action, spec->cmd, HANDLE_INVALID, spec->icon_path);
+    menu_add_item(s, label, spec->action, spec->cmd, HANDLE_INVALID, spec->icon_surface, spec->match_mask);
   }
 }
 
@@ -511,12 +787,13 @@ void menu_show(server_t* s, int16_t x, int16_t y) {
   assert(s->interaction_mode == INTERACTION_NONE);
   s->menu.is_client_list = false;
   s->menu.is_switcher = false;
+  menu_follow_screen(s);
   menu_populate_root(s);
 
   uint32_t values_h[] = {s->menu.h};
   xcb_configure_window(s->conn, s->menu.window, XCB_CONFIG_WINDOW_HEIGHT, values_h);
 
-  xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+  xcb_screen_t* screen = xcb_screen_of(s->conn, menu_screen(s)->num);
   if (x + s->menu.w > screen->width_in_pixels)
     x = screen->width_in_pixels - s->menu.w;
   if (y + s->menu.h > screen->height_in_pixels)
@@ -540,13 +817,13 @@ void menu_show(server_t* s, int16_t x, int16_t y) {
   const uint32_t stack_values[] = {XCB_STACK_MODE_ABOVE};
   xcb_configure_window(s->conn, s->menu.window, XCB_CONFIG_WINDOW_STACK_MODE, stack_values);
 
-  xcb_grab_pointer_cookie_t pc = xcb_grab_pointer(s->conn, 0, s->root, XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION, XCB_GRAB_MODE_ASYNC,
+  xcb_grab_pointer_cookie_t pc = xcb_grab_pointer(s->conn, 0, menu_screen(s)->root, XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION, XCB_GRAB_MODE_ASYNC,
                                                   XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE, XCB_CURRENT_TIME);
-  xcb_grab_keyboard_cookie_t kc = xcb_grab_keyboard(s->conn, 0, s->root, XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+  xcb_grab_keyboard_cookie_t kc = xcb_grab_keyboard(s->conn, 0, menu_screen(s)->root, XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
   menu_enqueue_grab_cookie(s, pc.sequence, COOKIE_GRAB_POINTER, MENU_GRAB_CONTEXT_ROOT);
   menu_enqueue_grab_cookie(s, kc.sequence, COOKIE_GRAB_KEYBOARD, MENU_GRAB_CONTEXT_ROOT);
 
-  menu_handle_expose(s);
+  menu_redraw(s);
 }
 
 void menu_show_client_list(server_t* s, int16_t x, int16_t y) {
@@ -558,35 +835,30 @@ void menu_show_client_list(server_t* s, int16_t x, int16_t y) {
   assert(s->interaction_mode == INTERACTION_NONE);
   s->menu.is_client_list = true;
   s->menu.is_switcher = false;
+  menu_follow_screen(s);
   menu_clear_items(s);
 
-  for (uint32_t i = 1; i < s->clients.cap; i++) {
-    if (!s->clients.hdr[i].live)
-      continue;
-    handle_t h = handle_make(i, s->clients.hdr[i].gen);
+  uint32_t i;
+  slotmap_for_each_live(&s->clients, i) {
+    handle_t h = slotmap_handle_at(&s->clients, i);
     client_cold_t* cold = server_ccold(s, h);
     client_hot_t* hot = server_chot(s, h);
     if (!cold || !hot)
       continue;
 
     char label[256];
-    if (hot->state == STATE_UNMAPPED) {
-      snprintf(label, sizeof(label), "[%s]", cold->title ? cold->title : "Unnamed");
-    }
-    else {
-      snprintf(label, sizeof(label), "%s", cold->title ? cold->title : "Unnamed");
-    }
-    menu_add_item(s, label, MENU_ACTION_RESTORE, NULL, h, NULL);
+    menu_format_list_label(hot, cold, label, sizeof(label));
+    menu_add_item(s, label, MENU_ACTION_RESTORE, NULL, h, NULL, menu_match_mask(label));
   }
 
-  if (s->menu.items.length == 0) {
-    menu_add_item(s, "(No windows)", MENU_ACTION_NONE, NULL, HANDLE_INVALID, NULL);
+  if (s->menu.item_count == 0) {
+    menu_add_item(s, "(No windows)", MENU_ACTION_NONE, NULL, HANDLE_INVALID, NULL, 0);
   }
 
   uint32_t values_h[] = {s->menu.h};
   xcb_configure_window(s->conn, s->menu.window, XCB_CONFIG_WINDOW_HEIGHT, values_h);
 
-  xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+  xcb_screen_t* screen = xcb_screen_of(s->conn, menu_screen(s)->num);
   if (x + s->menu.w > screen->width_in_pixels)
     x = screen->width_in_pixels - s->menu.w;
   if (y + s->menu.h > screen->height_in_pixels)
@@ -610,13 +882,13 @@ void menu_show_client_list(server_t* s, int16_t x, int16_t y) {
   const uint32_t stack_values[] = {XCB_STACK_MODE_ABOVE};
   xcb_configure_window(s->conn, s->menu.window, XCB_CONFIG_WINDOW_STACK_MODE, stack_values);
 
-  xcb_grab_pointer_cookie_t pc = xcb_grab_pointer(s->conn, 0, s->root, XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION, XCB_GRAB_MODE_ASYNC,
+  xcb_grab_pointer_cookie_t pc = xcb_grab_pointer(s->conn, 0, menu_screen(s)->root, XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION, XCB_GRAB_MODE_ASYNC,
                                                   XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE, XCB_CURRENT_TIME);
-  xcb_grab_keyboard_cookie_t kc = xcb_grab_keyboard(s->conn, 0, s->root, XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+  xcb_grab_keyboard_cookie_t kc = xcb_grab_keyboard(s->conn, 0, menu_screen(s)->root, XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
   menu_enqueue_grab_cookie(s, pc.sequence, COOKIE_GRAB_POINTER, MENU_GRAB_CONTEXT_CLIENT_LIST);
   menu_enqueue_grab_cookie(s, kc.sequence, COOKIE_GRAB_KEYBOARD, MENU_GRAB_CONTEXT_CLIENT_LIST);
 
-  menu_handle_expose(s);
+  menu_redraw(s);
 }
 
 void menu_hide(server_t* s) {
@@ -628,6 +900,7 @@ void menu_hide(server_t* s) {
     s->interaction_mode = INTERACTION_NONE;
   }
   xcb_unmap_window(s->conn, s->menu.window);
+  menu_back_release(s);
   xcb_ungrab_pointer(s->conn, XCB_CURRENT_TIME);
   xcb_ungrab_keyboard(s->conn, XCB_CURRENT_TIME);
 }
@@ -636,148 +909,361 @@ static rgba_t u32_to_rgba(uint32_t c) {
   return (rgba_t){((c >> 16) & 0xFF) / 255.0, ((c >> 8) & 0xFF) / 255.0, (c & 0xFF) / 255.0, 1.0};
 }
 
-void menu_handle_expose(server_t* s) {
-  menu_handle_expose_region(s, NULL);
+/*
+ * Back buffer
+ *
+ * Rows are rendered once into a buffer owned by the menu while it is shown.
+ * Exposes copy from it and a selection change repaints only the two rows
+ * involved, so sweeping the pointer over a long menu does no pango work for
+ * the rows it is not touching.
+ */
+
+static void menu_back_release(server_t* s) {
+  if (s->menu.back) {
+    cairo_surface_destroy(s->menu.back);
+    s->menu.back = NULL;
+  }
+  if (s->menu.back_pixmap != XCB_NONE) {
+    xcb_free_pixmap(s->conn, s->menu.back_pixmap);
+    s->menu.back_pixmap = XCB_NONE;
+  }
 }
 
-void menu_handle_expose_region(server_t* s, const dirty_region_t* dirty) {
+static bool menu_back_ensure(server_t* s) {
+  if (s->menu.back && s->menu.back_w == s->menu.w && s->menu.back_h == s->menu.h)
+    return true;
+  menu_back_release(s);
   if (s->menu.w == 0 || s->menu.h == 0)
+    return false;
+
+  if (s->is_test) {
+    s->menu.back = cairo_image_surface_create((menu_screen(s)->root_depth == 32) ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24, s->menu.w, s->menu.h);
+  }
+  else {
+    s->menu.back_pixmap = xcb_generate_id(s->conn);
+    xcb_create_pixmap(s->conn, menu_screen(s)->root_depth, s->menu.back_pixmap, s->menu.window, s->menu.w, s->menu.h);
+    s->menu.back = cairo_xcb_surface_create(s->conn, s->menu.back_pixmap, menu_screen(s)->root_visual_type, s->menu.w, s->menu.h);
+  }
+  s->menu.back_w = s->menu.w;
+  s->menu.back_h = s->menu.h;
+  return true;
+}
+
+static cairo_t* menu_back_begin(server_t* s) {
+  cairo_t* cr = cairo_create(s->menu.back);
+  if (!s->menu.render_ctx.layout)
+    s->menu.render_ctx.layout = render_text_layout_create("Sans 10");
+  pango_cairo_update_layout(cr, s->menu.render_ctx.layout);
+  return cr;
+}
+
+/* Paint row r; rows past the last shown item are left empty */
+static void menu_paint_row(server_t* s, cairo_t* cr, size_t r) {
+  menu_item_t* item = (r < s->menu.row_count) ? &s->menu.items[s->menu.rows[r]] : NULL;
+  int32_t row_h = s->menu.item_height;
+  int16_t item_y = MENU_PADDING + r * row_h;
+  bool selected = item && ((int32_t)s->menu.rows[r] == s->menu.selected_index);
+
+  rgba_t fg = u32_to_rgba(s->config.theme.menu_items_text_color);
+  rgba_t row_bg = u32_to_rgba(selected ? s->config.theme.menu_items_active.color : s->config.theme.menu_items.color);
+
+  cairo_save(cr);
+  cairo_rectangle(cr, 0, item_y, s->menu.w, row_h);
+  cairo_clip(cr);
+  cairo_set_source_rgba(cr, row_bg.r, row_bg.g, row_bg.b, row_bg.a);
+  cairo_paint(cr);
+
+  if (!item) {
+    cairo_restore(cr);
+    return;
+  }
+
+  if (item->action == MENU_ACTION_SEPARATOR) {
+    cairo_set_source_rgba(cr, fg.r, fg.g, fg.b, 0.3);
+    cairo_set_line_width(cr, 1.0);
+    cairo_move_to(cr, MENU_PADDING, item_y + row_h / 2.0);
+    cairo_line_to(cr, s->menu.w - MENU_PADDING, item_y + row_h / 2.0);
+    cairo_stroke(cr);
+    cairo_restore(cr);
     return;
+  }
 
-  cairo_surface_t* target_surface = NULL;
-  xcb_pixmap_t pixmap = XCB_NONE;
+  int text_x_offset = MENU_PADDING * 2;
 
-  if (s->is_test) {
-    target_surface = cairo_image_surface_create((s->root_depth == 32) ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24, s->menu.w, s->menu.h);
+  cairo_surface_t* icon = NULL;
+  if (s->menu.is_client_list && item->client != HANDLE_INVALID) {
+    client_icon_request(s, item->client);
+    client_cold_t* cold = server_ccold(s, item->client);
+    if (cold)
+      icon = cold->icon_surface;
   }
   else {
-    pixmap = xcb_generate_id(s->conn);
-    xcb_create_pixmap(s->conn, s->root_depth, pixmap, s->menu.window, s->menu.w, s->menu.h);
-    target_surface = cairo_xcb_surface_create(s->conn, pixmap, s->root_visual_type, s->menu.w, s->menu.h);
+    icon = item->icon_surface;
   }
 
-  cairo_t* cr = cairo_create(target_surface);
-  if (dirty && dirty->valid) {
-    dirty_region_t clip = *dirty;
-    dirty_region_clamp(&clip, 0, 0, s->menu.w, s->menu.h);
-    if (!clip.valid) {
-      cairo_destroy(cr);
-      if (s->is_test) {
-        cairo_surface_destroy(target_surface);
-      }
-      else {
-        cairo_surface_destroy(target_surface);
-        xcb_free_pixmap(s->conn, pixmap);
+  // Thumbnail rows: the cached snapshot is composited as is, the icon stands
+  // in until one has been captured
+  if (row_h == MENU_THUMB_ROW_HEIGHT && item->client != HANDLE_INVALID) {
+    int thumb_w = 0;
+    int thumb_h = 0;
+    cairo_surface_t* thumb = thumbnail_get(s, item->client, &thumb_w, &thumb_h);
+    int box_x = text_x_offset;
+    int box_y = item_y + MENU_PADDING;
+    if (thumb) {
+      cairo_set_source_surface(cr, thumb, box_x + (THUMBNAIL_MAX_W - thumb_w) / 2, box_y + (THUMBNAIL_MAX_H - thumb_h) / 2);
+      cairo_paint(cr);
+    }
+    else if (icon) {
+      cairo_surface_t* scaled = icon_cache_scaled(icon, MENU_ICON_SIZE);
+      if (scaled) {
+        int icon_w = cairo_image_surface_get_width(scaled);
+        int icon_h = cairo_image_surface_get_height(scaled);
+        cairo_set_source_surface(cr, scaled, box_x + (THUMBNAIL_MAX_W - icon_w) / 2, box_y + (THUMBNAIL_MAX_H - icon_h) / 2);
+        cairo_paint(cr);
       }
-      return;
     }
-    cairo_rectangle(cr, clip.x, clip.y, clip.w, clip.h);
-    cairo_clip(cr);
+    icon = NULL;
+    text_x_offset += THUMBNAIL_MAX_W + 6;
   }
 
+  // Shared pre-scaled variant, painted 1:1
+  cairo_surface_t* scaled = icon ? icon_cache_scaled(icon, MENU_ICON_SIZE) : NULL;
+  if (scaled) {
+    int icon_w = cairo_image_surface_get_width(scaled);
+    int icon_h = cairo_image_surface_get_height(scaled);
+    int icon_y = item_y + (row_h - icon_h) / 2;
+    cairo_set_source_surface(cr, scaled, (double)text_x_offset, (double)icon_y);
+    cairo_paint(cr);
+    text_x_offset += icon_w + 6;
+  }
+
+  rgba_t text_color = selected ? u32_to_rgba(s->config.theme.menu_items_active_text_color) : fg;
+  cairo_set_source_rgba(cr, text_color.r, text_color.g, text_color.b, text_color.a);
+  pango_layout_set_text(s->menu.render_ctx.layout, item->label ? item->label : "", -1);
+  pango_layout_set_width(s->menu.render_ctx.layout, (s->menu.w - text_x_offset - MENU_PADDING) * PANGO_SCALE);
+  pango_layout_set_ellipsize(s->menu.render_ctx.layout, PANGO_ELLIPSIZE_END);
+  int text_h;
+  pango_layout_get_pixel_size(s->menu.render_ctx.layout, NULL, &text_h);
+  double text_y = item_y + (row_h - text_h) / 2.0;
+  cairo_move_to(cr, text_x_offset, text_y);
+  pango_cairo_show_layout(cr, s->menu.render_ctx.layout);
+  cairo_restore(cr);
+}
+
+/* Copy a band of the back buffer to the window */
+static void menu_present(server_t* s, int16_t x, int16_t y, uint16_t w, uint16_t h) {
+  if (w == 0 || h == 0)
+    return;
+  cairo_surface_flush(s->menu.back);
+
+  xcb_gcontext_t gc = xcb_generate_id(s->conn);
+  uint32_t mask = XCB_GC_GRAPHICS_EXPOSURES;
+  uint32_t values[] = {0};
+  xcb_create_gc(s->conn, gc, s->menu.window, mask, values);
+  if (s->is_test) {
+    // Z-pixmap rows are sent whole, so the band spans the full width
+    int stride = cairo_image_surface_get_stride(s->menu.back);
+    const uint8_t* data = cairo_image_surface_get_data(s->menu.back) + (size_t)y * (size_t)stride;
+    xcb_put_image(s->conn, XCB_IMAGE_FORMAT_Z_PIXMAP, s->menu.window, gc, (uint16_t)s->menu.w, h, 0, y, 0, (uint8_t)menu_screen(s)->root_depth, (uint32_t)(stride * h), data);
+  }
+  else {
+    xcb_copy_area(s->conn, s->menu.back_pixmap, s->menu.window, gc, x, y, x, y, w, h);
+  }
+  xcb_free_gc(s->conn, gc);
+}
+
+static void menu_present_rows(server_t* s, int32_t first, int32_t last) {
+  menu_present(s, 0, (int16_t)(MENU_PADDING + first * s->menu.item_height), s->menu.w, (uint16_t)((last - first + 1) * s->menu.item_height));
+}
+
+static void menu_present_row(server_t* s, int32_t r) {
+  menu_present_rows(s, r, r);
+}
+
+/* Painted row of an item index, -1 when there is none */
+static int32_t menu_row_of(const server_t* s, int32_t index) {
+  if (index < 0 || index >= (int32_t)s->menu.item_count || s->menu.items[index].row == MENU_ROW_HIDDEN)
+    return -1;
+  return (int32_t)s->menu.items[index].row;
+}
+
+void menu_redraw(server_t* s) {
+  if (!menu_back_ensure(s))
+    return;
+
+  cairo_t* cr = menu_back_begin(s);
   rgba_t bg = u32_to_rgba(s->config.theme.menu_items.color);
   cairo_set_source_rgba(cr, bg.r, bg.g, bg.b, bg.a);
   cairo_paint(cr);
+  for (uint32_t r = 0; r < s->menu.row_count; r++)
+    menu_paint_row(s, cr, r);
+  cairo_destroy(cr);
+
+  s->menu.back_selected = s->menu.selected_index;
+  menu_present(s, 0, 0, s->menu.w, s->menu.h);
+}
+
+/* Move the highlight, repainting only the rows it leaves and enters */
+static void menu_set_selected(server_t* s, int32_t index) {
+  if (index == s->menu.selected_index)
+    return;
+  s->menu.selected_index = index;
+  if (!s->menu.back || s->menu.back_w != s->menu.w || s->menu.back_h != s->menu.h) {
+    menu_redraw(s);
+    return;
+  }
+
+  int32_t rows[2] = {menu_row_of(s, s->menu.back_selected), menu_row_of(s, index)};
+  cairo_t* cr = menu_back_begin(s);
+  for (int r = 0; r < 2; r++) {
+    if (rows[r] >= 0)
+      menu_paint_row(s, cr, (size_t)rows[r]);
+  }
+  cairo_destroy(cr);
+  s->menu.back_selected = index;
+
+  for (int r = 0; r < 2; r++) {
+    if (rows[r] >= 0)
+      menu_present_row(s, rows[r]);
+  }
+}
 
-  if (!s->menu.render_ctx.layout) {
-    s->menu.render_ctx.layout = pango_cairo_create_layout(cr);
-    PangoFontDescription* desc = pango_font_description_from_string("Sans 10");
-    pango_layout_set_font_description(s->menu.render_ctx.layout, desc);
-    pango_font_description_free(desc);
+/*
+ * Recompute the shown rows for the current query. narrowing means the query
+ * only grew, so only the rows already shown need testing. The window keeps
+ * its height while filtering; rows whose item or highlight changed are
+ * repainted and presented as one band. touched forces an item's row to
+ * repaint, e.g. after its label changed.
+ */
+static void menu_filter_apply(server_t* s, bool narrowing, int32_t touched) {
+  menu_t* m = &s->menu;
+  uint32_t count = 0;
+  if (narrowing) {
+    for (uint32_t r = 0; r < m->row_count; r++) {
+      if (menu_item_matches(m, &m->items[m->rows[r]]))
+        m->rows_next[count++] = m->rows[r];
+    }
   }
   else {
-    pango_cairo_update_layout(cr, s->menu.render_ctx.layout);
+    for (uint32_t i = 0; i < m->item_count; i++) {
+      if (menu_item_matches(m, &m->items[i]))
+        m->rows_next[count++] = i;
+    }
   }
 
-  rgba_t fg = u32_to_rgba(s->config.theme.menu_items_text_color);
-  rgba_t sel_bg = u32_to_rgba(s->config.theme.menu_items_active.color);
-  rgba_t sel_fg = u32_to_rgba(s->config.theme.menu_items_active_text_color);
-
-  for (size_t i = 0; i < s->menu.items.length; i++) {
-    menu_item_t* item = s->menu.items.items[i];
-    int16_t item_y = MENU_PADDING + i * MENU_ITEM_HEIGHT;
-
-    if (item->action == MENU_ACTION_SEPARATOR) {
-      cairo_set_source_rgba(cr, fg.r, fg.g, fg.b, 0.3);
-      cairo_set_line_width(cr, 1.0);
-      cairo_move_to(cr, MENU_PADDING, item_y + MENU_ITEM_HEIGHT / 2.0);
-      cairo_line_to(cr, s->menu.w - MENU_PADDING, item_y + MENU_ITEM_HEIGHT / 2.0);
-      cairo_stroke(cr);
+  int32_t old_selected_row = menu_row_of(s, m->back_selected);
+  uint32_t old_count = m->row_count;
+  for (uint32_t r = 0; r < old_count; r++)
+    m->items[m->rows[r]].row = MENU_ROW_HIDDEN;
+  for (uint32_t r = 0; r < count; r++)
+    m->items[m->rows_next[r]].row = r;
+  uint32_t* old_rows = m->rows;
+  m->rows = m->rows_next;
+  m->rows_next = old_rows;
+  m->row_count = count;
+
+  // While a query is typed the best (first) match is highlighted
+  if (m->filter_len > 0)
+    m->selected_index = menu_find_first_selectable(s);
+  else if (menu_row_of(s, m->selected_index) < 0)
+    m->selected_index = -1;
+
+  if (!m->back || m->back_w != m->w || m->back_h != m->h) {
+    menu_redraw(s);
+    return;
+  }
+
+  int32_t selected_row = menu_row_of(s, m->selected_index);
+  int32_t touched_row = menu_row_of(s, touched);
+  uint32_t span = (count > old_count) ? count : old_count;
+  int32_t first = -1;
+  int32_t last = -1;
+  cairo_t* cr = NULL;
+  for (uint32_t r = 0; r < span; r++) {
+    bool changed = r >= count || r >= old_count || m->rows[r] != old_rows[r];
+    if (!changed && (int32_t)r != old_selected_row && (int32_t)r != selected_row && (int32_t)r != touched_row)
       continue;
-    }
+    if (!cr)
+      cr = menu_back_begin(s);
+    menu_paint_row(s, cr, r);
+    if (first < 0)
+      first = (int32_t)r;
+    last = (int32_t)r;
+  }
+  if (cr)
+    cairo_destroy(cr);
+  m->back_selected = m->selected_index;
+  if (first >= 0)
+    menu_present_rows(s, first, last);
+}
 
-    bool selected = ((int)i == s->menu.selected_index);
+static void menu_filter_push(server_t* s, char c) {
+  menu_t* m = &s->menu;
+  if (m->filter_len + 1 >= MENU_FILTER_MAX)
+    return;
+  m->filter[m->filter_len++] = (char)menu_fold((uint8_t)c);
+  m->filter[m->filter_len] = '\0';
+  m->filter_mask |= menu_match_bit((uint8_t)c);
+  menu_filter_apply(s, true, -1);
+}
 
-    if (selected) {
-      cairo_set_source_rgba(cr, sel_bg.r, sel_bg.g, sel_bg.b, sel_bg.a);
-      cairo_rectangle(cr, 0, item_y, s->menu.w, MENU_ITEM_HEIGHT);
-      cairo_fill(cr);
-    }
+static void menu_filter_pop(server_t* s, bool all) {
+  menu_t* m = &s->menu;
+  if (m->filter_len == 0)
+    return;
+  m->filter_len = all ? 0 : m->filter_len - 1;
+  m->filter[m->filter_len] = '\0';
+  m->filter_mask = menu_match_mask(m->filter);
+  menu_filter_apply(s, false, -1);
+}
 
-    int text_x_offset = MENU_PADDING * 2;
+void menu_client_title_changed(server_t* s, handle_t h) {
+  menu_t* m = &s->menu;
+  if (!m->visible || !m->is_client_list)
+    return;
 
-    cairo_surface_t* icon = NULL;
-    if (s->menu.is_client_list && item->client != HANDLE_INVALID) {
-      client_cold_t* cold = server_ccold(s, item->client);
-      if (cold)
-        icon = cold->icon_surface;
-    }
-    else {
-      icon = item->icon_surface;
-    }
+  for (uint32_t i = 0; i < m->item_count; i++) {
+    menu_item_t* item = &m->items[i];
+    if (item->client != h)
+      continue;
 
-    if (icon) {
-      int icon_w = cairo_image_surface_get_width(icon);
-      int icon_h = cairo_image_surface_get_height(icon);
-      double target_size = MENU_ITEM_HEIGHT - 6;
-      double scale = target_size / ((icon_w > icon_h) ? icon_w : icon_h);
-      double draw_w = icon_w * scale;
-      double draw_h = icon_h * scale;
-      double icon_y = item_y + (MENU_ITEM_HEIGHT - draw_h) / 2.0;
-      cairo_save(cr);
-      cairo_translate(cr, text_x_offset, icon_y);
-      cairo_scale(cr, scale, scale);
-      cairo_set_source_surface(cr, icon, 0, 0);
-      cairo_paint(cr);
-      cairo_restore(cr);
-      text_x_offset += (int)draw_w + 6;
-    }
+    char label[256];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (m->is_switcher)
+      menu_format_client_label(s, hot, cold, label, sizeof(label));
+    else
+      menu_format_list_label(hot, cold, label, sizeof(label));
+    if (item->label && strcmp(item->label, label) == 0)
+      return;
 
-    rgba_t text_color = selected ? sel_fg : fg;
-    cairo_set_source_rgba(cr, text_color.r, text_color.g, text_color.b, text_color.a);
-    pango_layout_set_text(s->menu.render_ctx.layout, item->label ? item->label : "", -1);
-    pango_layout_set_width(s->menu.render_ctx.layout, (s->menu.w - text_x_offset - MENU_PADDING) * PANGO_SCALE);
-    pango_layout_set_ellipsize(s->menu.render_ctx.layout, PANGO_ELLIPSIZE_END);
-    int text_h;
-    pango_layout_get_pixel_size(s->menu.render_ctx.layout, NULL, &text_h);
-    double text_y = item_y + (MENU_ITEM_HEIGHT - text_h) / 2.0;
-    cairo_move_to(cr, text_x_offset, text_y);
-    pango_cairo_show_layout(cr, s->menu.render_ctx.layout);
+    item->label = arena_strdup(&m->item_arena, label);
+    item->match_mask = menu_match_mask(label);
+    menu_filter_apply(s, false, (int32_t)i);
+    return;
   }
+}
 
-  cairo_destroy(cr);
+void menu_handle_expose(server_t* s) {
+  menu_handle_expose_region(s, NULL);
+}
 
-  if (s->is_test) {
-    cairo_surface_flush(target_surface);
-    xcb_gcontext_t gc = xcb_generate_id(s->conn);
-    uint32_t mask = XCB_GC_GRAPHICS_EXPOSURES;
-    uint32_t values[] = {0};
-    xcb_create_gc(s->conn, gc, s->menu.window, mask, values);
-    xcb_put_image(s->conn, XCB_IMAGE_FORMAT_Z_PIXMAP, s->menu.window, gc, (uint16_t)s->menu.w, (uint16_t)s->menu.h, 0, 0, 0, (uint8_t)s->root_depth,
-                  (uint32_t)(cairo_image_surface_get_stride(target_surface) * s->menu.h), cairo_image_surface_get_data(target_surface));
-    xcb_free_gc(s->conn, gc);
-    cairo_surface_destroy(target_surface);
+void menu_handle_expose_region(server_t* s, const dirty_region_t* dirty) {
+  if (s->menu.w == 0 || s->menu.h == 0)
+    return;
+  if (!s->menu.back || s->menu.back_w != s->menu.w || s->menu.back_h != s->menu.h) {
+    menu_redraw(s);
+    return;
   }
-  else {
-    cairo_surface_destroy(target_surface);
-    xcb_gcontext_t gc = xcb_generate_id(s->conn);
-    uint32_t mask = XCB_GC_GRAPHICS_EXPOSURES;
-    uint32_t values[] = {0};
-    xcb_create_gc(s->conn, gc, s->menu.window, mask, values);
-    xcb_copy_area(s->conn, pixmap, s->menu.window, gc, 0, 0, 0, 0, s->menu.w, s->menu.h);
-    xcb_free_gc(s->conn, gc);
-    xcb_free_pixmap(s->conn, pixmap);
+
+  dirty_region_t clip = dirty_region_make(0, 0, s->menu.w, s->menu.h);
+  if (dirty && dirty->valid) {
+    clip = *dirty;
+    dirty_region_clamp(&clip, 0, 0, s->menu.w, s->menu.h);
+    if (!clip.valid)
+      return;
   }
+  menu_present(s, clip.x, clip.y, clip.w, clip.h);
 }
 
 void menu_show_switcher(server_t* s, handle_t origin) {
@@ -788,28 +1274,34 @@ void menu_show_switcher(server_t* s, handle_t origin) {
   assert(s->interaction_mode == INTERACTION_NONE);
   s->menu.is_client_list = true;
   s->menu.is_switcher = true;
+  menu_follow_screen(s);
   menu_clear_items(s);
+  if (thumbnail_enabled(s))
+    s->menu.item_height = MENU_THUMB_ROW_HEIGHT;
 
   int origin_index = -1;
   int idx = 0;
 
-  for (list_node_t* node = s->focus_history.next; node != &s->focus_history; node = node->next) {
-    client_hot_t* hot = (client_hot_t*)((char*)node - offsetof(client_hot_t, focus_node));
+  focus_mru_t* mru = &s->focus_mru;
+  for (uint32_t i = focus_mru_first(mru); i != 0; i = focus_mru_next(mru, i)) {
+    if (!focus_mru_match(mru, i, FOCUS_MRU_ANY_DESKTOP, FOCUS_MRU_SWITCHABLE))
+      continue;
+    client_hot_t* hot = server_chot(s, focus_mru_handle(mru, i));
     if (!switcher_is_candidate(s, hot))
       continue;
 
     client_cold_t* cold = server_ccold(s, hot->self);
     char label[256];
     menu_format_client_label(s, hot, cold, label, sizeof(label));
-    menu_add_item(s, label, MENU_ACTION_RESTORE, NULL, hot->self, NULL);
+    menu_add_item(s, label, MENU_ACTION_RESTORE, NULL, hot->self, NULL, menu_match_mask(label));
 
     if (hot->self == origin)
       origin_index = idx;
     idx++;
   }
 
-  if (s->menu.items.length == 0) {
-    menu_add_item(s, "(No windows)", MENU_ACTION_NONE, NULL, HANDLE_INVALID, NULL);
+  if (s->menu.item_count == 0) {
+    menu_add_item(s, "(No windows)", MENU_ACTION_NONE, NULL, HANDLE_INVALID, NULL, 0);
   }
 
   uint32_t values_h[] = {s->menu.h};
@@ -820,11 +1312,11 @@ void menu_show_switcher(server_t* s, handle_t origin) {
   if (origin_hot) {
     wm_get_monitor_geometry(s, origin_hot, &geom);
   }
-  else if (s->monitor_count > 0) {
-    geom = s->monitors[0].geom;
+  else if (menu_screen(s)->monitor_count > 0) {
+    geom = menu_screen(s)->monitors[0].geom;
   }
   else {
-    xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+    xcb_screen_t* screen = xcb_screen_of(s->conn, menu_screen(s)->num);
     geom.x = 0;
     geom.y = 0;
     geom.w = (uint16_t)screen->width_in_pixels;
@@ -857,13 +1349,13 @@ void menu_show_switcher(server_t* s, handle_t origin) {
   const uint32_t stack_values[] = {XCB_STACK_MODE_ABOVE};
   xcb_configure_window(s->conn, s->menu.window, XCB_CONFIG_WINDOW_STACK_MODE, stack_values);
 
-  xcb_grab_pointer_cookie_t pc = xcb_grab_pointer(s->conn, 0, s->root, XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION, XCB_GRAB_MODE_ASYNC,
+  xcb_grab_pointer_cookie_t pc = xcb_grab_pointer(s->conn, 0, menu_screen(s)->root, XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION, XCB_GRAB_MODE_ASYNC,
                                                   XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE, XCB_CURRENT_TIME);
-  xcb_grab_keyboard_cookie_t kc = xcb_grab_keyboard(s->conn, 0, s->root, XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+  xcb_grab_keyboard_cookie_t kc = xcb_grab_keyboard(s->conn, 0, menu_screen(s)->root, XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
   menu_enqueue_grab_cookie(s, pc.sequence, COOKIE_GRAB_POINTER, MENU_GRAB_CONTEXT_SWITCHER);
   menu_enqueue_grab_cookie(s, kc.sequence, COOKIE_GRAB_KEYBOARD, MENU_GRAB_CONTEXT_SWITCHER);
 
-  menu_handle_expose(s);
+  menu_redraw(s);
 }
 
 bool menu_switcher_step(server_t* s, int dir) {
@@ -874,8 +1366,7 @@ bool menu_switcher_step(server_t* s, int dir) {
   if (dir == 0) {
     int first = menu_find_first_selectable(s);
     if (first != s->menu.selected_index && first >= 0) {
-      s->menu.selected_index = first;
-      menu_handle_expose(s);
+      menu_set_selected(s, first);
       return true;
     }
     return false;
@@ -885,18 +1376,17 @@ bool menu_switcher_step(server_t* s, int dir) {
     start = menu_find_first_selectable(s);
   int next = menu_find_next_selectable(s, start, dir);
   if (next != s->menu.selected_index && next >= 0) {
-    s->menu.selected_index = next;
-    menu_handle_expose(s);
+    menu_set_selected(s, next);
     return true;
   }
   return false;
 }
 
 handle_t menu_switcher_selected_client(const server_t* s) {
-  if (!s || !s->menu.visible || s->menu.selected_index < 0 || s->menu.selected_index >= (int32_t)s->menu.items.length)
+  if (!s || !s->menu.visible || s->menu.selected_index < 0 || s->menu.selected_index >= (int32_t)s->menu.item_count)
     return HANDLE_INVALID;
 
-  menu_item_t* item = s->menu.items.items[s->menu.selected_index];
+  menu_item_t* item = &s->menu.items[s->menu.selected_index];
   if (!item || item->action != MENU_ACTION_RESTORE)
     return HANDLE_INVALID;
   return item->client;
@@ -907,26 +1397,20 @@ void menu_handle_pointer_motion(server_t* s, int16_t x, int16_t y) {
   int32_t local_y = (int32_t)y - (int32_t)s->menu.y;
 
   if (local_x < 0 || local_x >= (int32_t)s->menu.w || local_y < 0 || local_y >= (int32_t)s->menu.h) {
-    if (s->menu.selected_index != -1) {
-      s->menu.selected_index = -1;
-      menu_handle_expose(s);
-    }
+    menu_set_selected(s, -1);
     return;
   }
 
-  int32_t index = (local_y - MENU_PADDING) / MENU_ITEM_HEIGHT;
-  if (index < 0 || index >= (int32_t)s->menu.items.length) {
-    index = -1;
-  }
-  else {
-    menu_item_t* item = s->menu.items.items[index];
-    if (item->action == MENU_ACTION_SEPARATOR)
+  int32_t row = (local_y - MENU_PADDING) / s->menu.item_height;
+  int32_t index = -1;
+  if (row >= 0 && row < (int32_t)s->menu.row_count) {
+    index = (int32_t)s->menu.rows[row];
+    if (s->menu.items[index].action == MENU_ACTION_SEPARATOR)
       index = -1;
   }
 
   if (index != s->menu.selected_index) {
-    s->menu.selected_index = index;
-    menu_handle_expose(s);
+    menu_set_selected(s, index);
   }
 }
 
@@ -934,27 +1418,6 @@ extern volatile sig_atomic_t g_shutdown_pending;
 extern volatile sig_atomic_t g_restart_pending;
 extern volatile sig_atomic_t g_reload_pending;
 
-static void spawn(const char* cmd) {
-  pid_t p = fork();
-  if (p < 0)
-    return;
-
-  if (p == 0) {
-    pid_t p2 = fork();
-    if (p2 < 0)
-      _exit(1);
-    if (p2 == 0) {
-      setsid();
-      execl("/bin/sh", "sh", "-c", cmd, (char*)NULL);
-      _exit(1);
-    }
-    _exit(0);
-  }
-
-  int status = 0;
-  (void)waitpid(p, &status, 0);
-}
-
 void menu_handle_button_press(server_t* s, xcb_button_press_event_t* ev) {
   int32_t local_x = (int32_t)ev->root_x - (int32_t)s->menu.x;
   int32_t local_y = (int32_t)ev->root_y - (int32_t)s->menu.y;
@@ -979,9 +1442,10 @@ void menu_handle_button_release(server_t* s, xcb_button_release_event_t* ev) {
       return;
     }
 
-    int32_t index = (local_y - MENU_PADDING) / MENU_ITEM_HEIGHT;
-    if (index >= 0 && index < (int32_t)s->menu.items.length) {
-      menu_item_t* item = s->menu.items.items[index];
+    int32_t row = (local_y - MENU_PADDING) / s->menu.item_height;
+    if (row >= 0 && row < (int32_t)s->menu.row_count) {
+      int32_t index = (int32_t)s->menu.rows[row];
+      menu_item_t* item = &s->menu.items[index];
       if (item->action != MENU_ACTION_SEPARATOR) {
         s->menu.selected_index = index;
         menu_activate_selected(s);
@@ -995,40 +1459,37 @@ void menu_handle_button_release(server_t* s, xcb_button_release_event_t* ev) {
   }
 }
 
+/* Walks shown rows from the item start; returns an item index */
 static int menu_find_next_selectable(server_t* s, int start, int dir) {
-  if (s->menu.items.length == 0)
+  if (s->menu.row_count == 0)
     return -1;
 
-  int i = start;
-  for (size_t step = 0; step < s->menu.items.length; step++) {
-    i += dir;
-    if (i < 0)
-      i = (int)s->menu.items.length - 1;
-    if (i >= (int)s->menu.items.length)
-      i = 0;
+  int r = menu_row_of(s, start);
+  for (size_t step = 0; step < s->menu.row_count; step++) {
+    r += dir;
+    if (r < 0)
+      r = (int)s->menu.row_count - 1;
+    if (r >= (int)s->menu.row_count)
+      r = 0;
 
-    menu_item_t* item = s->menu.items.items[i];
-    if (!item)
-      continue;
+    menu_item_t* item = &s->menu.items[s->menu.rows[r]];
     if (item->action == MENU_ACTION_SEPARATOR)
       continue;
     if (item->action == MENU_ACTION_NONE)
       continue;
-    return i;
+    return (int)s->menu.rows[r];
   }
   return -1;
 }
 
 static int menu_find_first_selectable(server_t* s) {
-  for (size_t i = 0; i < s->menu.items.length; i++) {
-    menu_item_t* item = s->menu.items.items[i];
-    if (!item)
-      continue;
+  for (uint32_t r = 0; r < s->menu.row_count; r++) {
+    menu_item_t* item = &s->menu.items[s->menu.rows[r]];
     if (item->action == MENU_ACTION_SEPARATOR)
       continue;
     if (item->action == MENU_ACTION_NONE)
       continue;
-    return (int)i;
+    return (int)s->menu.rows[r];
   }
   return -1;
 }
@@ -1053,12 +1514,10 @@ static void menu_do_restore(server_t* s, handle_t client) {
 static void menu_activate_selected(server_t* s) {
   if (!s->menu.visible)
     return;
-  if (s->menu.selected_index < 0 || s->menu.selected_index >= (int)s->menu.items.length)
+  if (s->menu.selected_index < 0 || s->menu.selected_index >= (int)s->menu.item_count)
     return;
 
-  menu_item_t* item = s->menu.items.items[s->menu.selected_index];
-  if (!item)
-    return;
+  menu_item_t* item = &s->menu.items[s->menu.selected_index];
   if (item->action == MENU_ACTION_SEPARATOR)
     return;
 
@@ -1069,7 +1528,7 @@ static void menu_activate_selected(server_t* s) {
   switch (item->action) {
     case MENU_ACTION_EXEC:
       if (item->cmd)
-        spawn(item->cmd);
+        launcher_shell(&s->launcher, item->cmd, s->tick_start_ns);
       break;
     case MENU_ACTION_EXIT:
       g_shutdown_pending = 1;
@@ -1122,7 +1581,15 @@ void menu_handle_key_press(server_t* s, xcb_key_press_event_t* ev) {
 
   switch (sym) {
     case XK_Escape:
-      menu_hide(s);
+      // The first Escape drops a typed query, the next one closes the menu
+      if (s->menu.filter_len > 0)
+        menu_filter_pop(s, true);
+      else
+        menu_hide(s);
+      return;
+
+    case XK_BackSpace:
+      menu_filter_pop(s, false);
       return;
 
     case XK_Up: {
@@ -1131,8 +1598,7 @@ void menu_handle_key_press(server_t* s, xcb_key_press_event_t* ev) {
         start = menu_find_first_selectable(s);
       int next = menu_find_next_selectable(s, start, -1);
       if (next != s->menu.selected_index) {
-        s->menu.selected_index = next;
-        menu_handle_expose(s);
+        menu_set_selected(s, next);
       }
       return;
     }
@@ -1143,8 +1609,7 @@ void menu_handle_key_press(server_t* s, xcb_key_press_event_t* ev) {
         start = menu_find_first_selectable(s);
       int next = menu_find_next_selectable(s, start, +1);
       if (next != s->menu.selected_index) {
-        s->menu.selected_index = next;
-        menu_handle_expose(s);
+        menu_set_selected(s, next);
       }
       return;
     }
@@ -1152,8 +1617,7 @@ void menu_handle_key_press(server_t* s, xcb_key_press_event_t* ev) {
     case XK_Home: {
       int first = menu_find_first_selectable(s);
       if (first != s->menu.selected_index) {
-        s->menu.selected_index = first;
-        menu_handle_expose(s);
+        menu_set_selected(s, first);
       }
       return;
     }
@@ -1170,4 +1634,13 @@ void menu_handle_key_press(server_t* s, xcb_key_press_event_t* ev) {
     default:
       break;
   }
+
+  // Printable characters extend the query; the switcher runs under a held
+  // modifier and does not filter
+  if (s->menu.is_switcher || (ev->state & (XCB_MOD_MASK_CONTROL | XCB_MOD_MASK_1 | XCB_MOD_MASK_4)))
+    return;
+  if (ev->state & XCB_MOD_MASK_SHIFT)
+    sym = xcb_key_symbols_get_keysym(s->keysyms, ev->detail, 1);
+  if (sym > XK_space && sym <= XK_asciitilde)
+    menu_filter_push(s, (char)sym);
 }
@@ -0,0 +1,152 @@
+/* src/perf_counters.c
+ * Optional hardware counters around a code region (perf_event_open)
+ */
+
+#include "perf_counters.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* const perf_counter_names[PERF_COUNTER_KIND_COUNT] = {
+    [PERF_COUNTER_CYCLES] = "cycles",
+    [PERF_COUNTER_INSTRUCTIONS] = "instructions",
+    [PERF_COUNTER_L1D_MISSES] = "l1d_misses",
+    [PERF_COUNTER_LLC_MISSES] = "llc_misses",
+    [PERF_COUNTER_BRANCH_MISSES] = "branch_misses",
+};
+
+const char* perf_counter_name(perf_counter_kind_t kind) {
+  if ((unsigned)kind >= PERF_COUNTER_KIND_COUNT)
+    return "?";
+  return perf_counter_names[kind];
+}
+
+#ifdef __linux__
+
+static void perf_counter_attr(perf_counter_kind_t kind, struct perf_event_attr* attr) {
+  memset(attr, 0, sizeof(*attr));
+  attr->size = sizeof(*attr);
+  attr->disabled = 1;
+  attr->exclude_kernel = 1;
+  attr->exclude_hv = 1;
+  attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  const uint64_t read_miss = (uint64_t)PERF_COUNT_HW_CACHE_OP_READ << 8 | (uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+  switch (kind) {
+    case PERF_COUNTER_CYCLES:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PERF_COUNTER_INSTRUCTIONS:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PERF_COUNTER_L1D_MISSES:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+      break;
+    case PERF_COUNTER_LLC_MISSES:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_LL | read_miss;
+      break;
+    case PERF_COUNTER_BRANCH_MISSES:
+    default:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+  }
+}
+
+bool perf_counters_open(perf_counters_t* pc) {
+  bool any = false;
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++) {
+    struct perf_event_attr attr;
+    perf_counter_attr((perf_counter_kind_t)i, &attr);
+    long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    pc->fd[i] = fd >= 0 ? (int)fd : -1;
+    any |= fd >= 0;
+  }
+  return any;
+}
+
+void perf_counters_close(perf_counters_t* pc) {
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++) {
+    if (pc->fd[i] >= 0)
+      close(pc->fd[i]);
+    pc->fd[i] = -1;
+  }
+}
+
+void perf_counters_start(perf_counters_t* pc) {
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++) {
+    if (pc->fd[i] < 0)
+      continue;
+    ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+void perf_counters_stop(perf_counters_t* pc, perf_counter_sample_t* out) {
+  memset(out, 0, sizeof(*out));
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++) {
+    if (pc->fd[i] >= 0)
+      ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+  }
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++) {
+    uint64_t buf[3]; /* value, time_enabled, time_running */
+    if (pc->fd[i] < 0 || read(pc->fd[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf) || buf[2] == 0)
+      continue;
+    // Multiplexed: extrapolate from the share of time the event was on the PMU
+    out->value[i] = buf[2] < buf[1] ? (uint64_t)((double)buf[0] * (double)buf[1] / (double)buf[2]) : buf[0];
+    out->valid[i] = true;
+  }
+}
+
+#else
+
+bool perf_counters_open(perf_counters_t* pc) {
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++)
+    pc->fd[i] = -1;
+  return false;
+}
+
+void perf_counters_close(perf_counters_t* pc) {
+  (void)pc;
+}
+
+void perf_counters_start(perf_counters_t* pc) {
+  (void)pc;
+}
+
+void perf_counters_stop(perf_counters_t* pc, perf_counter_sample_t* out) {
+  (void)pc;
+  memset(out, 0, sizeof(*out));
+}
+
+#endif
+
+void perf_counters_print_per_op(FILE* out, const perf_counter_sample_t* s, uint64_t ops) {
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++) {
+    char upper[32];
+    const char* name = perf_counter_names[i];
+    size_t n = 0;
+    for (; name[n] && n + 1 < sizeof(upper); n++)
+      upper[n] = (char)toupper((unsigned char)name[n]);
+    upper[n] = '\0';
+    if (s->valid[i] && ops > 0)
+      fprintf(out, " %s_PER_OP %.4f", upper, (double)s->value[i] / (double)ops);
+    else
+      fprintf(out, " %s_PER_OP NA", upper);
+  }
+  if (s->valid[PERF_COUNTER_CYCLES] && s->valid[PERF_COUNTER_INSTRUCTIONS] && s->value[PERF_COUNTER_CYCLES] > 0)
+    fprintf(out, " IPC %.3f", (double)s->value[PERF_COUNTER_INSTRUCTIONS] / (double)s->value[PERF_COUNTER_CYCLES]);
+  else
+    fprintf(out, " IPC NA");
+}
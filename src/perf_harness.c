@@ -3,8 +3,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "client.h"
+#include "config.h"
+#include "ds.h"
+#include "focus_mru.h"
+#include "perf_counters.h"
+#include "placement.h"
+#include "rules.h"
+#include "slotmap.h"
+#include "str_intern.h"
 
 typedef enum scenario_kind {
   SCENARIO_ALL = 0,
@@ -12,6 +21,20 @@ typedef enum scenario_kind {
   SCENARIO_STACKING_OPS,
   SCENARIO_MOVE_RESIZE,
   SCENARIO_FLUSH_LOOPS,
+  SCENARIO_MAP_LINEAR,
+  SCENARIO_MAP_SWISS,
+  SCENARIO_FLUSH_SCAN,
+  SCENARIO_FLUSH_WORKLIST,
+  SCENARIO_PLACE_SMART,
+  SCENARIO_RULES_LINEAR,
+  SCENARIO_RULES_COMPILED,
+  SCENARIO_RULES_INTERNED,
+  SCENARIO_DAMAGE_IDLE_SCAN,
+  SCENARIO_DAMAGE_IDLE_EPOCH,
+  SCENARIO_SLOTMAP_CONTIGUOUS,
+  SCENARIO_SLOTMAP_PAGED,
+  SCENARIO_VISIBILITY_AOS,
+  SCENARIO_VISIBILITY_SOA,
 } scenario_kind_t;
 
 typedef struct flush_state {
@@ -19,6 +42,16 @@ typedef struct flush_state {
   dirty_region_t frame_damage;
 } flush_state_t;
 
+// --counters: hardware counters around each scenario, see perf_counters.h
+static bool counters_enabled;
+static perf_counters_t counters;
+
+static uint64_t harness_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
 static uint64_t parse_u64(const char* s, const char* name) {
   char* end = NULL;
   unsigned long long v = strtoull(s, &end, 10);
@@ -40,6 +73,34 @@ static scenario_kind_t parse_scenario(const char* s) {
     return SCENARIO_MOVE_RESIZE;
   if (strcmp(s, "flush_loops") == 0)
     return SCENARIO_FLUSH_LOOPS;
+  if (strcmp(s, "map_linear") == 0)
+    return SCENARIO_MAP_LINEAR;
+  if (strcmp(s, "map_swiss") == 0)
+    return SCENARIO_MAP_SWISS;
+  if (strcmp(s, "flush_scan") == 0)
+    return SCENARIO_FLUSH_SCAN;
+  if (strcmp(s, "flush_worklist") == 0)
+    return SCENARIO_FLUSH_WORKLIST;
+  if (strcmp(s, "place_smart") == 0)
+    return SCENARIO_PLACE_SMART;
+  if (strcmp(s, "rules_linear") == 0)
+    return SCENARIO_RULES_LINEAR;
+  if (strcmp(s, "rules_compiled") == 0)
+    return SCENARIO_RULES_COMPILED;
+  if (strcmp(s, "rules_interned") == 0)
+    return SCENARIO_RULES_INTERNED;
+  if (strcmp(s, "damage_idle_scan") == 0)
+    return SCENARIO_DAMAGE_IDLE_SCAN;
+  if (strcmp(s, "damage_idle_epoch") == 0)
+    return SCENARIO_DAMAGE_IDLE_EPOCH;
+  if (strcmp(s, "slotmap_contiguous") == 0)
+    return SCENARIO_SLOTMAP_CONTIGUOUS;
+  if (strcmp(s, "slotmap_paged") == 0)
+    return SCENARIO_SLOTMAP_PAGED;
+  if (strcmp(s, "visibility_aos") == 0)
+    return SCENARIO_VISIBILITY_AOS;
+  if (strcmp(s, "visibility_soa") == 0)
+    return SCENARIO_VISIBILITY_SOA;
 
   fprintf(stderr, "unknown scenario: %s\n", s);
   exit(2);
@@ -47,8 +108,9 @@ static scenario_kind_t parse_scenario(const char* s) {
 
 static void print_usage(const char* argv0) {
   fprintf(stderr,
-          "usage: %s [--scenario all|focus_cycle|stacking_ops|move_resize|flush_loops] "
-          "[--iters N] [--clients N]\n",
+          "usage: %s [--scenario all|focus_cycle|stacking_ops|move_resize|flush_loops|map_linear|map_swiss|flush_scan|flush_worklist|place_smart|rules_linear|rules_compiled|rules_interned|"
+          "damage_idle_scan|damage_idle_epoch|slotmap_contiguous|slotmap_paged|visibility_aos|visibility_soa] "
+          "[--iters N] [--clients N] [--counters]\n",
           argv0);
 }
 
@@ -73,32 +135,40 @@ static void init_clients(client_hot_t* clients, size_t n) {
     c->layer = (uint8_t)LAYER_NORMAL;
     c->base_layer = (uint8_t)LAYER_NORMAL;
 
-    list_init(&c->focus_node);
     list_init(&c->transient_sibling);
     list_init(&c->transients_head);
   }
 }
 
 static uint64_t run_focus_cycle(client_hot_t* clients, size_t n, uint64_t iters) {
-  LIST_HEAD(focus_head);
+  focus_mru_t mru = {0};
 
-  for (size_t i = 0; i < n; ++i)
-    list_push_back(&focus_head, &clients[i].focus_node);
+  // Handles are client indices here, not slotmap handles
+  for (size_t i = 0; i < n; ++i) {
+    clients[i].focus_slot = focus_mru_insert_after(&mru, focus_mru_last(&mru), (handle_t)i);
+    focus_mru_refresh(&mru, clients[i].focus_slot, &clients[i]);
+  }
 
   uint64_t ops = 0;
-  list_node_t* node = focus_head.next;
-
-  for (uint64_t i = 0; i < iters; ++i) {
-    if (node == &focus_head)
-      node = node->next;
-
-    client_hot_t* c = list_entry(node, client_hot_t, focus_node);
-    c->dirty ^= DIRTY_FOCUS;
+  uint32_t slot = focus_mru_first(&mru);
+
+  for (uint64_t i = 0; i < iters && mru.count; ++i) {
+    if (slot == 0)
+      slot = focus_mru_first(&mru);
+
+    uint32_t next = focus_mru_next(&mru, slot);
+    if (focus_mru_match(&mru, slot, 0, FOCUS_MRU_SWITCHABLE)) {
+      client_hot_t* c = &clients[focus_mru_handle(&mru, slot)];
+      c->dirty ^= DIRTY_FOCUS;
+      // Focusing moves the client to the head, as wm_set_focus does
+      focus_mru_move_after(&mru, slot, 0);
+    }
     ops++;
 
-    node = node->next;
+    slot = next;
   }
 
+  focus_mru_destroy(&mru);
   return ops;
 }
 
@@ -207,12 +277,375 @@ static uint64_t run_flush_loops(client_hot_t* clients, flush_state_t* states, si
   return ops;
 }
 
+// Window-id lookups as the event path does them: mostly hits, some misses
+// (unmanaged/override-redirect windows), and steady map/unmap churn
+static uint64_t run_map_lookups(bool swiss, size_t n, uint64_t iters) {
+  hash_map_t map;
+  if (swiss)
+    hash_map_init_swiss(&map);
+  else
+    hash_map_init(&map);
+
+  const uint64_t base = 0x00400000u;
+  for (size_t i = 0; i < n; ++i)
+    hash_map_insert(&map, base + (uint64_t)i * 5u, (void*)(uintptr_t)(i + 1));
+
+  uint64_t ops = 0;
+  uint64_t found = 0;
+  for (uint64_t i = 0; i < iters; ++i) {
+    uint64_t idx = (i * 2654435761u) % (uint64_t)n;
+    uint64_t key = base + idx * 5u;
+
+    if (hash_map_get(&map, key))
+      found++;
+    if (hash_map_get(&map, key + 1u))
+      found++;
+    ops += 2;
+
+    if ((i & 7u) == 0) {
+      hash_map_remove(&map, key);
+      hash_map_insert(&map, key, (void*)(uintptr_t)(idx + 1));
+      ops += 2;
+    }
+  }
+
+  hash_map_destroy(&map);
+  if (found == 0 && iters > 0)
+    fprintf(stderr, "map scenario found no keys\n");
+  return ops;
+}
+
+// One commit phase per tick with two clients touched, the common steady
+// state: scanning every client for dirty bits vs. walking only the queued ones.
+// Both commit the same clients, so OPS match and only the cost differs.
+static uint64_t run_flush_commit(client_hot_t* clients, size_t n, uint64_t iters, bool worklist) {
+  handle_vec_t queue;
+  handle_vec_init(&queue);
+
+  uint64_t ops = 0;
+  for (uint64_t i = 0; i < iters; ++i) {
+    for (uint64_t k = 0; k < 2; ++k) {
+      client_hot_t* c = &clients[((i * 2u + k) * 2654435761u) % (uint64_t)n];
+      c->dirty |= DIRTY_GEOM;
+      if (!c->dirty_queued) {
+        c->dirty_queued = true;
+        handle_vec_push(&queue, c->self);
+      }
+    }
+
+    if (worklist) {
+      for (size_t j = 0; j < queue.length; ++j) {
+        client_hot_t* c = &clients[handle_index(queue.items[j]) - 1u];
+        if (c->dirty != DIRTY_NONE) {
+          c->dirty = DIRTY_NONE;
+          ops++;
+        }
+        c->dirty_queued = false;
+      }
+    } else {
+      for (size_t j = 0; j < n; ++j) {
+        client_hot_t* c = &clients[j];
+        if (c->dirty != DIRTY_NONE) {
+          c->dirty = DIRTY_NONE;
+          ops++;
+        }
+        c->dirty_queued = false;
+      }
+    }
+    handle_vec_clear(&queue);
+  }
+
+  handle_vec_destroy(&queue);
+  return ops;
+}
+
+// Smart placement of an 800x600 window on a 1920x1080 workarea crowded by
+// up to 200 frames, as during a session restore. A placement is far heavier
+// than the other ops, so one runs per 100 iterations.
+static uint64_t run_place_smart(size_t n, uint64_t iters) {
+  if (n > 200)
+    n = 200;
+  rect_t* obstacles = calloc(n, sizeof(*obstacles));
+  if (!obstacles) {
+    fprintf(stderr, "failed to allocate %zu obstacles\n", n);
+    exit(1);
+  }
+  uint32_t seed = 0x9e3779b9u;
+  for (size_t i = 0; i < n; ++i) {
+    seed = seed * 1664525u + 1013904223u;
+    obstacles[i].x = (int16_t)((seed >> 8) % 1600u);
+    seed = seed * 1664525u + 1013904223u;
+    obstacles[i].y = (int16_t)((seed >> 8) % 800u);
+    obstacles[i].w = (uint16_t)(200u + (seed >> 20) % 600u);
+    obstacles[i].h = (uint16_t)(150u + (seed >> 12) % 400u);
+  }
+
+  arena_t scratch;
+  arena_init(&scratch, 64 * 1024);
+  rect_t area = {.x = 0, .y = 0, .w = 1920, .h = 1080};
+  uint64_t ops = 0;
+  uint64_t placements = iters / 100u + 1u;
+  for (uint64_t i = 0; i < placements; ++i) {
+    int32_t x = 0, y = 0;
+    placement_min_overlap(&scratch, area, 800, 600, obstacles, n, &x, &y);
+    // Drop a frame where the last window went so the next search differs
+    rect_t* o = &obstacles[i % n];
+    o->x = (int16_t)x;
+    o->y = (int16_t)y;
+    arena_reset(&scratch);
+    ops++;
+  }
+
+  arena_destroy(&scratch);
+  free(obstacles);
+  return ops;
+}
+
+// A 1000-rule config, mostly class rules with some instance, title and
+// type-only ones, matched against a stream of new windows as on login.
+// All variants find the same rules, so OPS match and only the cost differs.
+// The interned one holds class and instance the way clients do.
+static uint64_t run_rule_match(uint64_t iters, bool compiled, bool interned) {
+  enum { RULES = 1000, NAMES = 1500 };
+  char names[NAMES][24];
+  const char* ids[NAMES];
+  for (size_t i = 0; i < NAMES; ++i) {
+    snprintf(names[i], sizeof(names[i]), "App%zu", i * 7919u % 10007u);
+    ids[i] = interned ? str_intern(names[i]) : names[i];
+  }
+
+  small_vec_t rules;
+  small_vec_init(&rules);
+  for (size_t i = 0; i < RULES; ++i) {
+    app_rule_t* r = calloc(1, sizeof(*r));
+    if (!r) {
+      fprintf(stderr, "failed to allocate rule\n");
+      exit(1);
+    }
+    r->type_match = -1;
+    r->transient_match = -1;
+    if (i % 10 < 7)
+      r->class_match = strdup(names[i]);
+    else if (i % 10 < 8)
+      r->instance_match = strdup(names[i]);
+    else if (i % 10 < 9)
+      r->title_match = strdup(names[i]);
+    else
+      r->type_match = (int32_t)((i / 10) % WINDOW_TYPE_COUNT);
+    small_vec_push(&rules, r);
+  }
+
+  rule_set_t set;
+  rule_set_init(&set);
+  if (compiled)
+    rule_set_build(&set, &rules);
+
+  char title[64];
+  uint64_t ops = 0;
+  for (uint64_t i = 0; i < iters; ++i) {
+    const char* name = ids[(i * 2654435761u) % NAMES];
+    snprintf(title, sizeof(title), "%s - document %llu", name, (unsigned long long)(i % 97u));
+    rule_subject_t subj = {name, name, title, (uint8_t)(i % WINDOW_TYPE_COUNT), (i & 3u) == 0, interned};
+
+    if (compiled) {
+      const uint32_t* hits = NULL;
+      ops += rule_set_match(&set, &subj, &hits);
+    } else {
+      for (size_t j = 0; j < rules.length; ++j) {
+        if (rule_matches(rules.items[j], &subj))
+          ops++;
+      }
+    }
+  }
+
+  rule_set_destroy(&set);
+  for (size_t i = 0; interned && i < NAMES; ++i)
+    str_intern_release(ids[i]);
+  for (size_t i = 0; i < rules.length; ++i) {
+    app_rule_t* r = rules.items[i];
+    free(r->class_match);
+    free(r->instance_match);
+    free(r->title_match);
+    free(r);
+  }
+  small_vec_destroy(&rules);
+  return ops;
+}
+
+// Idle ticks after a damage burst: one burst of 4096 damaged drawables grows
+// the per-tick bucket, then each tick drains it with a blinking cursor as the
+// only damage. A hash_map walk pays for the burst's capacity on every tick;
+// an epoch_map walk only visits this tick's entries. Both drain the same
+// entries, so OPS match and only the cost differs.
+#define DAMAGE_BURST 4096u
+
+static uint64_t run_damage_idle(uint64_t iters, bool epoch) {
+  static dirty_rects_t rect;
+  const uint64_t base = 0x00400000u;
+  hash_map_t map;
+  epoch_map_t emap;
+  hash_map_init(&map);
+  epoch_map_init(&emap);
+
+  for (uint64_t i = 0; i < DAMAGE_BURST; ++i) {
+    if (epoch)
+      epoch_map_insert(&emap, base + i, &rect);
+    else
+      hash_map_insert(&map, base + i, &rect);
+  }
+
+  uint64_t ops = 0;
+  uint64_t key = 0;
+  void* value = NULL;
+  for (uint64_t i = 0; i < iters; ++i) {
+    if (epoch)
+      epoch_map_clear(&emap);
+    else
+      hash_map_clear(&map);
+    if ((i & 15u) == 0) {
+      if (epoch)
+        epoch_map_insert(&emap, base, &rect);
+      else
+        hash_map_insert(&map, base, &rect);
+    }
+
+    size_t cursor = 0;
+    if (epoch) {
+      while (epoch_map_next(&emap, &cursor, &key, &value))
+        ops++;
+    } else {
+      while (hash_map_next(&map, &cursor, &key, &value))
+        ops++;
+    }
+  }
+
+  hash_map_destroy(&map);
+  epoch_map_destroy(&emap);
+  return ops;
+}
+
+// Client storage growing from empty to n clients through alloc_grow, then
+// the bulk passes' access pattern: every live hot record read per pass. The
+// contiguous layout copies all hot and cold data on each doubling; the paged
+// one only adds pages, at one extra load per slot address.
+#define SLOTMAP_SCAN_PASSES 16u
+
+static uint64_t run_slotmap(size_t n, uint64_t iters, bool paged) {
+  uint64_t rounds = iters / n + 1u;
+  uint64_t ops = 0;
+  for (uint64_t r = 0; r < rounds; ++r) {
+    slotmap_t sm;
+    bool ok = paged ? slotmap_init_paged(&sm, 2, sizeof(client_hot_t), sizeof(client_cold_t))
+                    : slotmap_init(&sm, 2, sizeof(client_hot_t), sizeof(client_cold_t));
+    if (!ok) {
+      fprintf(stderr, "slotmap init failed\n");
+      exit(1);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      void* hot = NULL;
+      if (slotmap_alloc_grow(&sm, &hot, NULL) == HANDLE_INVALID) {
+        fprintf(stderr, "slotmap growth failed\n");
+        exit(1);
+      }
+      ((client_hot_t*)hot)->desktop = (int32_t)(i & 3u);
+    }
+
+    for (uint32_t pass = 0; pass < SLOTMAP_SCAN_PASSES; ++pass) {
+      uint32_t idx;
+      slotmap_for_each_live(&sm, idx) {
+        const client_hot_t* hot = slotmap_hot_at(&sm, idx);
+        if (hot->desktop == (int32_t)(pass & 3u))
+          ops++;
+      }
+    }
+    slotmap_destroy(&sm);
+  }
+  return ops;
+}
+
+// The workspace visibility decision over every client: state, sticky,
+// desktop and frame_vis read either from client_hot_t (four cache lines
+// apart per client) or from the client columns (a few bytes per client).
+// Handles are visited in manage order, as the pass does.
+static uint64_t run_visibility(size_t n, uint64_t iters, bool soa) {
+  slotmap_t sm;
+  if (!slotmap_init_paged(&sm, (uint32_t)n + 1u, sizeof(client_hot_t), sizeof(client_cold_t)) ||
+      slotmap_add_column(&sm, sizeof(uint8_t)) != 0 || slotmap_add_column(&sm, sizeof(uint8_t)) != 1 ||
+      slotmap_add_column(&sm, sizeof(int32_t)) != 2 || slotmap_add_column(&sm, sizeof(uint8_t)) != 3) {
+    fprintf(stderr, "slotmap init failed\n");
+    exit(1);
+  }
+  uint8_t* col_state = slotmap_column(&sm, 0);
+  uint8_t* col_sticky = slotmap_column(&sm, 1);
+  int32_t* col_desktop = slotmap_column(&sm, 2);
+  uint8_t* col_vis = slotmap_column(&sm, 3);
+
+  handle_t* handles = calloc(n, sizeof(*handles));
+  if (!handles) {
+    fprintf(stderr, "allocation failed\n");
+    exit(1);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    void* hot_ptr = NULL;
+    handles[i] = slotmap_alloc(&sm, &hot_ptr, NULL);
+    client_hot_t* hot = hot_ptr;
+    uint32_t idx = handle_index(handles[i]);
+    hot->state = col_state[idx] = (i % 7u) ? STATE_MAPPED : STATE_UNMAPPED;
+    hot->desktop = col_desktop[idx] = (int32_t)(i & 3u);
+    hot->sticky = (i % 11u) == 0;
+    col_sticky[idx] = hot->sticky;
+    hot->frame_vis = col_vis[idx] = (i & 3u) ? FRAME_VIS_HIDDEN : FRAME_VIS_MAPPED;
+  }
+
+  uint64_t ops = 0;
+  uint64_t passes = iters / n + 1u;
+  for (uint64_t pass = 0; pass < passes; ++pass) {
+    int32_t current = (int32_t)(pass & 3u);
+    for (size_t i = 0; i < n; ++i) {
+      handle_t h = handles[i];
+      if (!slotmap_live(&sm, h))
+        continue;
+      uint8_t state, sticky, vis;
+      int32_t desktop;
+      if (soa) {
+        uint32_t idx = handle_index(h);
+        state = col_state[idx];
+        sticky = col_sticky[idx];
+        desktop = col_desktop[idx];
+        vis = col_vis[idx];
+      } else {
+        const client_hot_t* hot = slotmap_hot(&sm, h);
+        state = hot->state;
+        sticky = hot->sticky;
+        desktop = hot->desktop;
+        vis = hot->frame_vis;
+      }
+      if (state != STATE_MAPPED)
+        continue;
+      bool visible = sticky || desktop == current;
+      if (visible ? vis != FRAME_VIS_MAPPED : vis != FRAME_VIS_HIDDEN)
+        ops++;
+    }
+  }
+
+  free(handles);
+  slotmap_destroy(&sm);
+  return ops;
+}
+
 static void run_one_scenario(const char* name, scenario_kind_t kind, client_hot_t* clients, flush_state_t* states, size_t n, uint64_t iters) {
   init_clients(clients, n);
   if (states) {
     memset(states, 0, n * sizeof(*states));
   }
 
+  // Scenario setup is counted too; it is small next to the default iters
+  uint64_t start_ns = 0;
+  if (counters_enabled) {
+    start_ns = harness_now_ns();
+    perf_counters_start(&counters);
+  }
+
   uint64_t ops = 0;
   switch (kind) {
     case SCENARIO_FOCUS_CYCLE:
@@ -227,6 +660,48 @@ static void run_one_scenario(const char* name, scenario_kind_t kind, client_hot_
     case SCENARIO_FLUSH_LOOPS:
       ops = run_flush_loops(clients, states, n, iters);
       break;
+    case SCENARIO_MAP_LINEAR:
+      ops = run_map_lookups(false, n, iters);
+      break;
+    case SCENARIO_MAP_SWISS:
+      ops = run_map_lookups(true, n, iters);
+      break;
+    case SCENARIO_FLUSH_SCAN:
+      ops = run_flush_commit(clients, n, iters, false);
+      break;
+    case SCENARIO_FLUSH_WORKLIST:
+      ops = run_flush_commit(clients, n, iters, true);
+      break;
+    case SCENARIO_PLACE_SMART:
+      ops = run_place_smart(n, iters);
+      break;
+    case SCENARIO_RULES_LINEAR:
+      ops = run_rule_match(iters, false, false);
+      break;
+    case SCENARIO_RULES_COMPILED:
+      ops = run_rule_match(iters, true, false);
+      break;
+    case SCENARIO_RULES_INTERNED:
+      ops = run_rule_match(iters, true, true);
+      break;
+    case SCENARIO_DAMAGE_IDLE_SCAN:
+      ops = run_damage_idle(iters, false);
+      break;
+    case SCENARIO_DAMAGE_IDLE_EPOCH:
+      ops = run_damage_idle(iters, true);
+      break;
+    case SCENARIO_SLOTMAP_CONTIGUOUS:
+      ops = run_slotmap(n, iters, false);
+      break;
+    case SCENARIO_SLOTMAP_PAGED:
+      ops = run_slotmap(n, iters, true);
+      break;
+    case SCENARIO_VISIBILITY_AOS:
+      ops = run_visibility(n, iters, false);
+      break;
+    case SCENARIO_VISIBILITY_SOA:
+      ops = run_visibility(n, iters, true);
+      break;
     case SCENARIO_ALL:
     default:
       fprintf(stderr, "invalid non-concrete scenario kind\n");
@@ -234,6 +709,15 @@ static void run_one_scenario(const char* name, scenario_kind_t kind, client_hot_
   }
 
   printf("SCENARIO %s OPS %llu\n", name, (unsigned long long)ops);
+
+  if (counters_enabled) {
+    perf_counter_sample_t sample;
+    perf_counters_stop(&counters, &sample);
+    uint64_t elapsed_ns = harness_now_ns() - start_ns;
+    printf("COUNTERS %s NS_PER_OP %.2f", name, ops ? (double)elapsed_ns / (double)ops : 0.0);
+    perf_counters_print_per_op(stdout, &sample, ops);
+    printf("\n");
+  }
 }
 
 int main(int argc, char** argv) {
@@ -265,6 +749,8 @@ int main(int argc, char** argv) {
         return 2;
       }
       clients_n = (size_t)parsed;
+    } else if (strcmp(argv[i], "--counters") == 0) {
+      counters_enabled = true;
     } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
       print_usage(argv[0]);
       return 0;
@@ -286,21 +772,68 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  if (counters_enabled && !perf_counters_open(&counters))
+    fprintf(stderr, "perf_event_open unavailable (no PMU, or kernel.perf_event_paranoid too strict); counters print as NA\n");
+
   if (scenario == SCENARIO_ALL) {
     run_one_scenario("focus_cycle", SCENARIO_FOCUS_CYCLE, clients, states, clients_n, iters);
     run_one_scenario("stacking_ops", SCENARIO_STACKING_OPS, clients, states, clients_n, iters);
     run_one_scenario("move_resize", SCENARIO_MOVE_RESIZE, clients, states, clients_n, iters);
     run_one_scenario("flush_loops", SCENARIO_FLUSH_LOOPS, clients, states, clients_n, iters);
+    run_one_scenario("map_linear", SCENARIO_MAP_LINEAR, clients, states, clients_n, iters);
+    run_one_scenario("map_swiss", SCENARIO_MAP_SWISS, clients, states, clients_n, iters);
+    run_one_scenario("flush_scan", SCENARIO_FLUSH_SCAN, clients, states, clients_n, iters);
+    run_one_scenario("flush_worklist", SCENARIO_FLUSH_WORKLIST, clients, states, clients_n, iters);
+    run_one_scenario("place_smart", SCENARIO_PLACE_SMART, clients, states, clients_n, iters);
+    run_one_scenario("rules_linear", SCENARIO_RULES_LINEAR, clients, states, clients_n, iters);
+    run_one_scenario("rules_compiled", SCENARIO_RULES_COMPILED, clients, states, clients_n, iters);
+    run_one_scenario("rules_interned", SCENARIO_RULES_INTERNED, clients, states, clients_n, iters);
+    run_one_scenario("damage_idle_scan", SCENARIO_DAMAGE_IDLE_SCAN, clients, states, clients_n, iters);
+    run_one_scenario("damage_idle_epoch", SCENARIO_DAMAGE_IDLE_EPOCH, clients, states, clients_n, iters);
+    run_one_scenario("slotmap_contiguous", SCENARIO_SLOTMAP_CONTIGUOUS, clients, states, clients_n, iters);
+    run_one_scenario("slotmap_paged", SCENARIO_SLOTMAP_PAGED, clients, states, clients_n, iters);
+    run_one_scenario("visibility_aos", SCENARIO_VISIBILITY_AOS, clients, states, clients_n, iters);
+    run_one_scenario("visibility_soa", SCENARIO_VISIBILITY_SOA, clients, states, clients_n, iters);
   } else if (scenario == SCENARIO_FOCUS_CYCLE) {
     run_one_scenario("focus_cycle", scenario, clients, states, clients_n, iters);
   } else if (scenario == SCENARIO_STACKING_OPS) {
     run_one_scenario("stacking_ops", scenario, clients, states, clients_n, iters);
   } else if (scenario == SCENARIO_MOVE_RESIZE) {
     run_one_scenario("move_resize", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_MAP_LINEAR) {
+    run_one_scenario("map_linear", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_MAP_SWISS) {
+    run_one_scenario("map_swiss", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_FLUSH_SCAN) {
+    run_one_scenario("flush_scan", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_FLUSH_WORKLIST) {
+    run_one_scenario("flush_worklist", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_PLACE_SMART) {
+    run_one_scenario("place_smart", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_RULES_LINEAR) {
+    run_one_scenario("rules_linear", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_RULES_COMPILED) {
+    run_one_scenario("rules_compiled", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_RULES_INTERNED) {
+    run_one_scenario("rules_interned", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_DAMAGE_IDLE_SCAN) {
+    run_one_scenario("damage_idle_scan", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_DAMAGE_IDLE_EPOCH) {
+    run_one_scenario("damage_idle_epoch", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_SLOTMAP_CONTIGUOUS) {
+    run_one_scenario("slotmap_contiguous", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_SLOTMAP_PAGED) {
+    run_one_scenario("slotmap_paged", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_VISIBILITY_AOS) {
+    run_one_scenario("visibility_aos", scenario, clients, states, clients_n, iters);
+  } else if (scenario == SCENARIO_VISIBILITY_SOA) {
+    run_one_scenario("visibility_soa", scenario, clients, states, clients_n, iters);
   } else {
     run_one_scenario("flush_loops", scenario, clients, states, clients_n, iters);
   }
 
+  if (counters_enabled)
+    perf_counters_close(&counters);
   free(states);
   free(clients);
   return 0;
@@ -0,0 +1,791 @@
+/* src/perf_pipeline.c
+ * End-to-end scenarios over the real tick pipeline.
+ *
+ * perf_harness times data structures in isolation. This harness links the
+ * window manager itself against tests/xcb_stubs.c and feeds synthetic events
+ * through event_ingest, cookie_jar_drain, event_process and wm_flush_dirty,
+ * the same sequence server_run performs per tick. Every reply the jar waits
+ * for is answered at once with a zeroed reply (absent property, empty tree),
+ * so managing a window walks the real reply handlers.
+ *
+ * Each scenario prints one line:
+ *
+ *   SCENARIO <name> OPS <n> NS_PER_OP <ns> REQS_PER_OP <requests>
+ *
+ * where requests counts X requests issued through the stubs, so a change
+ * that saves round trips shows up even when wall time is noise.
+ *
+ * drag_input_sleep and drag_input_busy_poll time input to configure during
+ * a drag instead: a writer thread stands in for the X server, sending one
+ * byte on a pipe in place of the X socket at a jittered ~1 kHz, and each op
+ * is the time from that write through server_wait_for_events and the tick
+ * that moves the window. They differ only in interactive_busy_poll_us, so
+ * the pair shows what spinning saves in scheduler wakeups. Ops are capped
+ * at PIPELINE_INPUT_MAX_OPS to keep the run short.
+ *
+ * click_through times a click from the press to the client seeing it. The
+ * stubs keep the passive button grabs the WM has in place; a press that
+ * activates a synchronous one freezes the pointer, so it costs the tick
+ * that ingests it and answers with AllowEvents, while any other press goes
+ * straight to the client and costs nothing here. One click in
+ * PIPELINE_CLICK_REFOCUS lands on another client and moves focus, the rest
+ * go to the focused one.
+ *
+ * --replay FILE runs a trace recorded with HXM_EVENT_TRACE instead: each
+ * recorded tick's events are queued and one tick runs with the recorded
+ * timestamp as the virtual clock. A request is answered with the next
+ * recorded reply of the same cookie type and slot data, or a zeroed reply
+ * when none is left (slot data holding a pointer never matches). Windows
+ * adopted when recording started are unknown to the replay, so their events
+ * take the unmanaged paths. Prints one line:
+ *
+ *   REPLAY TICKS <n> EVENTS <n> P50_NS .. MAX_NS <ns> REQS_PER_TICK <requests>
+ *     REPLIES_MATCHED <n> REPLIES_ZEROED <n>
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+#include <xcb/xcb.h>
+
+#include "client.h"
+#include "cookie_jar.h"
+#include "event.h"
+#include "event_trace.h"
+#include "hxm.h"
+#include "wm.h"
+#include "wm_internal.h"
+#include "xcb_utils.h"
+
+/* tests/xcb_stubs.c */
+extern void xcb_stubs_reset(void);
+extern bool xcb_stubs_enqueue_queued_event(xcb_generic_event_t* ev);
+extern uint64_t stub_request_count;
+extern bool xcb_stubs_button_grab_freezes(xcb_window_t window, uint8_t button, uint16_t state);
+extern int (*stub_poll_for_reply_hook)(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error);
+
+/* Events queued per tick; the stub queue holds 2048 */
+#define PIPELINE_BATCH 256u
+/* Ticks allowed for freshly mapped windows to finish managing */
+#define PIPELINE_SETTLE_TICKS 16
+#define PIPELINE_WINDOW_BASE 0x400000u
+#define PIPELINE_PER_DESKTOP 50u
+/* Simulated pointer rate for the resize scenario: 1 kHz */
+#define PIPELINE_MOTION_NS 1000000ull
+/* drag_input: writes are 250..1250 us apart, at most this many per run */
+#define PIPELINE_INPUT_MIN_GAP_US 250u
+#define PIPELINE_INPUT_JITTER_US 1000u
+#define PIPELINE_INPUT_MAX_OPS 2000u
+#define PIPELINE_INPUT_BUSY_POLL_US 1000u
+/* click_through: every this many clicks, one goes to an unfocused client */
+#define PIPELINE_CLICK_REFOCUS 8u
+
+typedef enum scenario_kind {
+  SCENARIO_ALL = 0,
+  SCENARIO_MANAGE,
+  SCENARIO_PROPERTY_STORM,
+  SCENARIO_WORKSPACE_SWITCH,
+  SCENARIO_INTERACTIVE_RESIZE,
+  SCENARIO_ALT_TAB,
+  SCENARIO_DRAG_INPUT_SLEEP,
+  SCENARIO_DRAG_INPUT_BUSY_POLL,
+  SCENARIO_CLICK_THROUGH,
+} scenario_kind_t;
+
+typedef struct pipeline {
+  server_t s;
+  uint64_t now; /* virtual clock handed to wm_flush_dirty */
+  xcb_window_t next_window;
+} pipeline_t;
+
+typedef struct scenario_result {
+  uint64_t ops;
+  uint64_t ns;
+  uint64_t requests;
+} scenario_result_t;
+
+static uint64_t parse_u64(const char* s, const char* name) {
+  char* end = NULL;
+  unsigned long long v = strtoull(s, &end, 10);
+  if (!s || *s == '\0' || !end || *end != '\0') {
+    fprintf(stderr, "invalid %s: %s\n", name, s ? s : "(null)");
+    exit(2);
+  }
+  return (uint64_t)v;
+}
+
+static scenario_kind_t parse_scenario(const char* s) {
+  if (strcmp(s, "all") == 0)
+    return SCENARIO_ALL;
+  if (strcmp(s, "manage") == 0)
+    return SCENARIO_MANAGE;
+  if (strcmp(s, "property_storm") == 0)
+    return SCENARIO_PROPERTY_STORM;
+  if (strcmp(s, "workspace_switch") == 0)
+    return SCENARIO_WORKSPACE_SWITCH;
+  if (strcmp(s, "interactive_resize") == 0)
+    return SCENARIO_INTERACTIVE_RESIZE;
+  if (strcmp(s, "alt_tab") == 0)
+    return SCENARIO_ALT_TAB;
+  if (strcmp(s, "drag_input_sleep") == 0)
+    return SCENARIO_DRAG_INPUT_SLEEP;
+  if (strcmp(s, "drag_input_busy_poll") == 0)
+    return SCENARIO_DRAG_INPUT_BUSY_POLL;
+  if (strcmp(s, "click_through") == 0)
+    return SCENARIO_CLICK_THROUGH;
+
+  fprintf(stderr, "unknown scenario: %s\n", s);
+  exit(2);
+}
+
+static void print_usage(const char* argv0) {
+  fprintf(stderr, "usage: %s [--scenario all|manage|property_storm|workspace_switch|interactive_resize|alt_tab|drag_input_sleep|drag_input_busy_poll|click_through] [--iters N] [--clients N] [--replay FILE]\n", argv0);
+}
+
+/* Answer every outstanding request with a zeroed reply large enough for any
+ * fixed reply struct; the jar frees it after the handler ran */
+static int pipeline_poll_for_reply(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) {
+  (void)c;
+  (void)request;
+  if (error)
+    *error = NULL;
+  if (reply) {
+    xcb_generic_reply_t* r = calloc(1, 256);
+    if (!r)
+      return 0;
+    r->response_type = 1;
+    *reply = r;
+  }
+  return 1;
+}
+
+static void pipeline_init(pipeline_t* p) {
+  memset(p, 0, sizeof(*p));
+  xcb_stubs_reset();
+  stub_poll_for_reply_hook = pipeline_poll_for_reply;
+
+  p->s.is_test = true;
+  server_init(&p->s);
+  p->now = monotonic_time_ns();
+  p->next_window = PIPELINE_WINDOW_BASE;
+}
+
+static void pipeline_destroy(pipeline_t* p) {
+  server_cleanup(&p->s);
+  stub_poll_for_reply_hook = NULL;
+  xcb_stubs_reset();
+}
+
+/* One pass of server_run's tick body, without the wait */
+static void pipeline_tick(pipeline_t* p) {
+  server_t* s = &p->s;
+  s->txn_id++;
+  event_ingest(s, true);
+  cookie_jar_mark_replies_may_exist(&s->cookie_jar);
+  cookie_jar_drain(&s->cookie_jar, s->conn, s, SIZE_MAX);
+  event_process(s);
+  wm_flush_dirty(s, p->now);
+}
+
+static void pipeline_queue(const void* ev, size_t len) {
+  xcb_generic_event_t* copy = calloc(1, sizeof(xcb_generic_event_t));
+  if (!copy) {
+    fprintf(stderr, "out of memory queueing event\n");
+    exit(1);
+  }
+  memcpy(copy, ev, len);
+  if (!xcb_stubs_enqueue_queued_event(copy)) {
+    fprintf(stderr, "stub event queue full\n");
+    exit(1);
+  }
+}
+
+static size_t pipeline_pending_manage(server_t* s) {
+  size_t pending = 0;
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    client_hot_t* hot = server_chot(s, s->active_clients.items[i]);
+    if (hot && (hot->state == STATE_NEW || hot->state == STATE_READY))
+      pending++;
+  }
+  return pending;
+}
+
+/* MapRequest n new windows through the pipeline and tick until managed */
+static void pipeline_map_windows(pipeline_t* p, size_t n) {
+  server_t* s = &p->s;
+  size_t queued = 0;
+  while (queued < n) {
+    for (uint32_t b = 0; b < PIPELINE_BATCH && queued < n; b++, queued++) {
+      xcb_map_request_event_t ev = {
+          .response_type = XCB_MAP_REQUEST,
+          .parent = s->screens[0].root,
+          .window = p->next_window++,
+      };
+      pipeline_queue(&ev, sizeof(ev));
+    }
+    pipeline_tick(p);
+    pipeline_tick(p);
+  }
+
+  for (int i = 0; i < PIPELINE_SETTLE_TICKS && pipeline_pending_manage(s) > 0; i++)
+    pipeline_tick(p);
+}
+
+static scenario_result_t run_manage(pipeline_t* p, size_t n) {
+  uint64_t req0 = stub_request_count;
+  uint64_t t0 = monotonic_time_ns();
+  pipeline_map_windows(p, n);
+  uint64_t t1 = monotonic_time_ns();
+  return (scenario_result_t){.ops = p->s.active_clients.length, .ns = t1 - t0, .requests = stub_request_count - req0};
+}
+
+static scenario_result_t run_property_storm(pipeline_t* p, size_t n, uint64_t iters) {
+  server_t* s = &p->s;
+  pipeline_map_windows(p, n);
+  size_t clients = s->active_clients.length;
+  if (clients == 0)
+    return (scenario_result_t){0};
+
+  const xcb_atom_t props[] = {atoms._NET_WM_NAME, XCB_ATOM_WM_NAME, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_NORMAL_HINTS};
+  uint64_t req0 = stub_request_count;
+  uint64_t t0 = monotonic_time_ns();
+  uint64_t sent = 0;
+  while (sent < iters) {
+    for (uint32_t b = 0; b < PIPELINE_BATCH && sent < iters; b++, sent++) {
+      client_hot_t* hot = server_chot(s, s->active_clients.items[sent % clients]);
+      xcb_property_notify_event_t ev = {
+          .response_type = XCB_PROPERTY_NOTIFY,
+          .window = hot->xid,
+          .atom = props[(sent / clients) % (sizeof(props) / sizeof(props[0]))],
+          .state = XCB_PROPERTY_NEW_VALUE,
+      };
+      pipeline_queue(&ev, sizeof(ev));
+    }
+    pipeline_tick(p);
+    // Let the refetches issued this tick land, as the next wakeup would
+    pipeline_tick(p);
+  }
+  uint64_t t1 = monotonic_time_ns();
+  return (scenario_result_t){.ops = sent, .ns = t1 - t0, .requests = stub_request_count - req0};
+}
+
+static scenario_result_t run_workspace_switch(pipeline_t* p, uint64_t iters) {
+  server_t* s = &p->s;
+  screen_t* scr = &s->screens[0];
+  uint32_t desktops = scr->desktop_count < 2 ? 2 : scr->desktop_count;
+  scr->desktop_count = desktops;
+  pipeline_map_windows(p, (size_t)PIPELINE_PER_DESKTOP * desktops);
+  for (size_t i = 0; i < s->active_clients.length; i++)
+    wm_client_move_to_workspace(s, s->active_clients.items[i], (uint32_t)(i % desktops), false);
+  pipeline_tick(p);
+
+  uint64_t req0 = stub_request_count;
+  uint64_t t0 = monotonic_time_ns();
+  for (uint64_t i = 0; i < iters; i++) {
+    wm_switch_workspace(s, scr, (scr->current_desktop + 1) % desktops);
+    pipeline_tick(p);
+  }
+  uint64_t t1 = monotonic_time_ns();
+  return (scenario_result_t){.ops = iters, .ns = t1 - t0, .requests = stub_request_count - req0};
+}
+
+static scenario_result_t run_interactive_resize(pipeline_t* p, size_t n, uint64_t iters) {
+  server_t* s = &p->s;
+  pipeline_map_windows(p, n);
+  if (s->active_clients.length == 0)
+    return (scenario_result_t){0};
+
+  handle_t h = s->active_clients.items[s->active_clients.length - 1];
+  client_hot_t* hot = server_chot(s, h);
+  int16_t x0 = (int16_t)(hot->server.x + hot->server.w);
+  int16_t y0 = (int16_t)(hot->server.y + hot->server.h);
+  wm_start_interaction(s, h, hot, false, RESIZE_BOTTOM | RESIZE_RIGHT, x0, y0, XCB_CURRENT_TIME, false);
+
+  uint64_t req0 = stub_request_count;
+  uint64_t t0 = monotonic_time_ns();
+  for (uint64_t i = 0; i < iters; i++) {
+    // Sweep out and back so the size stays within the workarea
+    int16_t d = (int16_t)(i % 400 < 200 ? i % 200 : 200 - i % 200);
+    xcb_motion_notify_event_t ev = {
+        .response_type = XCB_MOTION_NOTIFY,
+        .root = s->screens[0].root,
+        .event = hot->frame,
+        .root_x = (int16_t)(x0 + d),
+        .root_y = (int16_t)(y0 + d / 2),
+        .state = XCB_KEY_BUT_MASK_BUTTON_1,
+        .same_screen = 1,
+    };
+    pipeline_queue(&ev, sizeof(ev));
+    p->now += PIPELINE_MOTION_NS;
+    pipeline_tick(p);
+  }
+  uint64_t t1 = monotonic_time_ns();
+
+  if (s->interaction_mode != INTERACTION_NONE)
+    wm_cancel_interaction(s);
+  return (scenario_result_t){.ops = iters, .ns = t1 - t0, .requests = stub_request_count - req0};
+}
+
+static scenario_result_t run_alt_tab(pipeline_t* p, size_t n, uint64_t iters) {
+  server_t* s = &p->s;
+  pipeline_map_windows(p, n);
+
+  uint64_t req0 = stub_request_count;
+  uint64_t t0 = monotonic_time_ns();
+  for (uint64_t i = 0; i < iters; i++) {
+    wm_cycle_focus(s, true);
+    pipeline_tick(p);
+  }
+  uint64_t t1 = monotonic_time_ns();
+  return (scenario_result_t){.ops = iters, .ns = t1 - t0, .requests = stub_request_count - req0};
+}
+
+static scenario_result_t run_click_through(pipeline_t* p, size_t n, uint64_t iters) {
+  server_t* s = &p->s;
+  pipeline_map_windows(p, n < 2 ? 2 : n);
+  size_t clients = s->active_clients.length;
+  if (clients < 2)
+    return (scenario_result_t){0};
+  pipeline_tick(p);
+
+  uint64_t req0 = stub_request_count;
+  uint64_t total_ns = 0;
+  for (uint64_t i = 0; i < iters; i++) {
+    handle_t h = s->focused_client;
+    if (i % PIPELINE_CLICK_REFOCUS == PIPELINE_CLICK_REFOCUS - 1u || !server_chot(s, h))
+      h = s->active_clients.items[(i / PIPELINE_CLICK_REFOCUS) % clients];
+    client_hot_t* hot = server_chot(s, h);
+    if (!xcb_stubs_button_grab_freezes(hot->xid, 1, 0))
+      continue;
+
+    xcb_button_press_event_t ev = {
+        .response_type = XCB_BUTTON_PRESS,
+        .detail = 1,
+        .time = (xcb_timestamp_t)(i + 1u),
+        .root = s->screens[0].root,
+        .event = hot->xid,
+        .event_x = 10,
+        .event_y = 10,
+        .same_screen = 1,
+    };
+    uint64_t t0 = monotonic_time_ns();
+    pipeline_queue(&ev, sizeof(ev));
+    pipeline_tick(p);
+    total_ns += monotonic_time_ns() - t0;
+  }
+  return (scenario_result_t){.ops = iters, .ns = total_ns, .requests = stub_request_count - req0};
+}
+
+typedef struct input_feed {
+  int x_fd[2];   /* stands in for the X socket */
+  int ack_fd[2]; /* main thread: the tick for the last write is done */
+  uint64_t ops;
+  _Atomic uint64_t sent_ns;
+} input_feed_t;
+
+static void* input_feed_main(void* arg) {
+  input_feed_t* f = arg;
+  uint32_t seed = 0x9e3779b9u;
+  for (uint64_t i = 0; i < f->ops; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    uint32_t gap_us = PIPELINE_INPUT_MIN_GAP_US + (seed >> 8) % PIPELINE_INPUT_JITTER_US;
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = (long)gap_us * 1000L};
+    nanosleep(&ts, NULL);
+
+    atomic_store(&f->sent_ns, monotonic_time_ns());
+    char c = 'm';
+    char ack;
+    if (write(f->x_fd[1], &c, 1) != 1 || read(f->ack_fd[0], &ack, 1) != 1)
+      break;
+  }
+  return NULL;
+}
+
+static scenario_result_t run_drag_input(pipeline_t* p, size_t n, uint64_t iters, uint32_t busy_poll_us) {
+  server_t* s = &p->s;
+  pipeline_map_windows(p, n);
+  if (s->active_clients.length == 0 || s->epoll_fd < 0)
+    return (scenario_result_t){0};
+
+  input_feed_t feed = {.ops = iters < PIPELINE_INPUT_MAX_OPS ? iters : PIPELINE_INPUT_MAX_OPS};
+  if (pipe(feed.x_fd) < 0 || pipe(feed.ack_fd) < 0) {
+    fprintf(stderr, "pipe failed\n");
+    exit(1);
+  }
+  int stub_fd = s->xcb_fd;
+  struct epoll_event ev_in = {.events = EPOLLIN, .data.fd = feed.x_fd[0]};
+  epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, stub_fd, NULL);
+  if (epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, feed.x_fd[0], &ev_in) < 0) {
+    fprintf(stderr, "epoll_ctl failed\n");
+    exit(1);
+  }
+  s->xcb_fd = feed.x_fd[0];
+  s->config.interactive_busy_poll_us = busy_poll_us;
+
+  handle_t h = s->active_clients.items[s->active_clients.length - 1];
+  client_hot_t* hot = server_chot(s, h);
+  int16_t x0 = (int16_t)(hot->server.x + 10);
+  int16_t y0 = (int16_t)(hot->server.y + 10);
+  wm_start_interaction(s, h, hot, true, 0, x0, y0, XCB_CURRENT_TIME, false);
+
+  pthread_t writer;
+  if (pthread_create(&writer, NULL, input_feed_main, &feed) != 0) {
+    fprintf(stderr, "pthread_create failed\n");
+    exit(1);
+  }
+
+  uint64_t req0 = stub_request_count;
+  uint64_t total_ns = 0;
+  for (uint64_t i = 0; i < feed.ops; i++) {
+    while (!server_wait_for_events(s, 1000)) {
+    }
+    char c;
+    if (read(feed.x_fd[0], &c, 1) != 1)
+      break;
+    int16_t d = (int16_t)(i % 200);
+    xcb_motion_notify_event_t ev = {
+        .response_type = XCB_MOTION_NOTIFY,
+        .root = s->screens[0].root,
+        .event = hot->frame,
+        .root_x = (int16_t)(x0 + d),
+        .root_y = (int16_t)(y0 + d / 2),
+        .state = XCB_KEY_BUT_MASK_BUTTON_1,
+        .same_screen = 1,
+    };
+    pipeline_queue(&ev, sizeof(ev));
+    p->now = monotonic_time_ns();
+    pipeline_tick(p);
+    total_ns += monotonic_time_ns() - atomic_load(&feed.sent_ns);
+    if (write(feed.ack_fd[1], &c, 1) != 1)
+      break;
+  }
+  pthread_join(writer, NULL);
+
+  if (s->interaction_mode != INTERACTION_NONE)
+    wm_cancel_interaction(s);
+  epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, feed.x_fd[0], NULL);
+  s->xcb_fd = stub_fd;
+  close(feed.x_fd[0]);
+  close(feed.x_fd[1]);
+  close(feed.ack_fd[0]);
+  close(feed.ack_fd[1]);
+  return (scenario_result_t){.ops = feed.ops, .ns = total_ns, .requests = stub_request_count - req0};
+}
+
+static void run_one_scenario(const char* name, scenario_kind_t kind, size_t n, uint64_t iters) {
+  pipeline_t* p = calloc(1, sizeof(*p));
+  if (!p) {
+    fprintf(stderr, "failed to allocate pipeline\n");
+    exit(1);
+  }
+  pipeline_init(p);
+
+  scenario_result_t r = {0};
+  switch (kind) {
+    case SCENARIO_MANAGE:
+      r = run_manage(p, n);
+      break;
+    case SCENARIO_PROPERTY_STORM:
+      r = run_property_storm(p, n, iters);
+      break;
+    case SCENARIO_WORKSPACE_SWITCH:
+      r = run_workspace_switch(p, iters);
+      break;
+    case SCENARIO_INTERACTIVE_RESIZE:
+      r = run_interactive_resize(p, n, iters);
+      break;
+    case SCENARIO_ALT_TAB:
+      r = run_alt_tab(p, n, iters);
+      break;
+    case SCENARIO_DRAG_INPUT_SLEEP:
+      r = run_drag_input(p, n, iters, 0);
+      break;
+    case SCENARIO_DRAG_INPUT_BUSY_POLL:
+      r = run_drag_input(p, n, iters, PIPELINE_INPUT_BUSY_POLL_US);
+      break;
+    case SCENARIO_CLICK_THROUGH:
+      r = run_click_through(p, n, iters);
+      break;
+    case SCENARIO_ALL:
+    default:
+      fprintf(stderr, "invalid non-concrete scenario kind\n");
+      exit(2);
+  }
+
+  pipeline_destroy(p);
+  free(p);
+
+  double ops = r.ops ? (double)r.ops : 1.0;
+  printf("SCENARIO %s OPS %llu NS_PER_OP %.1f REQS_PER_OP %.2f\n", name, (unsigned long long)r.ops, (double)r.ns / ops, (double)r.requests / ops);
+}
+
+typedef struct replay_tick {
+  uint64_t t_ns;
+  uint32_t first_event;
+  uint32_t event_count;
+} replay_tick_t;
+
+typedef struct replay_reply {
+  uint64_t key;
+  uint8_t* bytes;
+  uint32_t len;
+  bool is_error;
+  uint32_t next; /* index + 1 of the next reply with the same key, 0 = none */
+} replay_reply_t;
+
+typedef struct replay {
+  uint8_t (*events)[32];
+  uint32_t event_len, event_cap;
+  replay_tick_t* ticks;
+  uint32_t tick_len, tick_cap;
+  replay_reply_t* replies;
+  uint32_t reply_len, reply_cap;
+  hash_map_t heads; /* reply key -> index + 1 of the first unconsumed reply */
+
+  pipeline_t* p;
+  uint64_t matched;
+  uint64_t zeroed;
+} replay_t;
+
+/* The reply hook takes no context argument */
+static replay_t* replay_active;
+
+static uint64_t replay_key(uint8_t cookie_type, uint64_t data) {
+  return ((uint64_t)cookie_type << 56) ^ data ^ (1ull << 63);
+}
+
+static void* replay_grow(void* items, uint32_t* cap, size_t size) {
+  uint32_t grown_cap = *cap ? *cap * 2 : 256;
+  void* grown = realloc(items, (size_t)grown_cap * size);
+  if (!grown) {
+    fprintf(stderr, "out of memory loading trace\n");
+    exit(1);
+  }
+  *cap = grown_cap;
+  return grown;
+}
+
+static bool replay_load(replay_t* rp, const char* path) {
+  event_trace_reader_t r;
+  if (!event_trace_reader_open(&r, path))
+    return false;
+
+  event_trace_hdr_t hdr;
+  const uint8_t* payload = NULL;
+  while (event_trace_reader_next(&r, &hdr, &payload)) {
+    if (hdr.kind == EVENT_TRACE_TICK) {
+      if (rp->tick_len == rp->tick_cap)
+        rp->ticks = replay_grow(rp->ticks, &rp->tick_cap, sizeof(*rp->ticks));
+      rp->ticks[rp->tick_len++] = (replay_tick_t){.t_ns = hdr.t_ns, .first_event = rp->event_len};
+    } else if (hdr.kind == EVENT_TRACE_EVENT) {
+      if (hdr.len != 32 || rp->tick_len == 0)
+        continue;
+      if (rp->event_len == rp->event_cap)
+        rp->events = replay_grow(rp->events, &rp->event_cap, sizeof(*rp->events));
+      memcpy(rp->events[rp->event_len++], payload, 32);
+      rp->ticks[rp->tick_len - 1].event_count++;
+    } else if (hdr.len >= 32) {
+      if (rp->reply_len == rp->reply_cap)
+        rp->replies = replay_grow(rp->replies, &rp->reply_cap, sizeof(*rp->replies));
+      uint8_t* bytes = malloc(hdr.len);
+      if (!bytes) {
+        fprintf(stderr, "out of memory loading trace\n");
+        exit(1);
+      }
+      memcpy(bytes, payload, hdr.len);
+      rp->replies[rp->reply_len++] = (replay_reply_t){
+          .key = replay_key(hdr.cookie_type, hdr.data),
+          .bytes = bytes,
+          .len = hdr.len,
+          .is_error = (hdr.kind == EVENT_TRACE_ERROR),
+      };
+    }
+  }
+  event_trace_reader_close(&r);
+
+  // Chain replies per key in recorded order
+  hash_map_init(&rp->heads);
+  for (uint32_t i = rp->reply_len; i-- > 0;) {
+    rp->replies[i].next = (uint32_t)(uintptr_t)hash_map_get(&rp->heads, rp->replies[i].key);
+    hash_map_insert(&rp->heads, rp->replies[i].key, (void*)(uintptr_t)(i + 1));
+  }
+  return true;
+}
+
+static void replay_free(replay_t* rp) {
+  for (uint32_t i = 0; i < rp->reply_len; i++)
+    free(rp->replies[i].bytes);
+  free(rp->replies);
+  free(rp->ticks);
+  free(rp->events);
+  hash_map_destroy(&rp->heads);
+}
+
+/* Hand out the next recorded reply for the request's cookie, else fall back
+ * to pipeline_poll_for_reply */
+static int replay_poll_for_reply(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) {
+  replay_t* rp = replay_active;
+  const cookie_slot_t* slot = cookie_jar_lookup(&rp->p->s.cookie_jar, (uint32_t)request);
+  uint64_t key = slot ? replay_key((uint8_t)slot->type, slot->data) : 0;
+  uint32_t idx = slot ? (uint32_t)(uintptr_t)hash_map_get(&rp->heads, key) : 0;
+  if (!idx) {
+    rp->zeroed++;
+    return pipeline_poll_for_reply(c, request, reply, error);
+  }
+
+  replay_reply_t* rec = &rp->replies[idx - 1];
+  if (rec->next)
+    hash_map_insert(&rp->heads, key, (void*)(uintptr_t)rec->next);
+  else
+    hash_map_remove(&rp->heads, key);
+
+  // The jar frees what it is handed; the recorded copy stays for reuse
+  void* copy = malloc(rec->len);
+  if (!copy)
+    return 0;
+  memcpy(copy, rec->bytes, rec->len);
+  ((xcb_generic_reply_t*)copy)->sequence = (uint16_t)request;
+  if (reply)
+    *reply = rec->is_error ? NULL : copy;
+  if (error)
+    *error = rec->is_error ? copy : NULL;
+  if ((rec->is_error && !error) || (!rec->is_error && !reply))
+    free(copy);
+  rp->matched++;
+  return 1;
+}
+
+static int run_replay(const char* path) {
+  // The pipeline's server_init must not record over its own input
+  unsetenv(EVENT_TRACE_ENV);
+
+  replay_t rp = {0};
+  if (!replay_load(&rp, path)) {
+    fprintf(stderr, "cannot read trace: %s\n", path);
+    return 1;
+  }
+
+  pipeline_t* p = calloc(1, sizeof(*p));
+  latency_hist_t* hist = calloc(1, sizeof(*hist));
+  if (!p || !hist) {
+    fprintf(stderr, "failed to allocate pipeline\n");
+    exit(1);
+  }
+  pipeline_init(p);
+  latency_hist_reset(hist);
+  rp.p = p;
+  replay_active = &rp;
+  stub_poll_for_reply_hook = replay_poll_for_reply;
+
+  uint64_t req0 = stub_request_count;
+  for (uint32_t t = 0; t < rp.tick_len; t++) {
+    const replay_tick_t* tick = &rp.ticks[t];
+    // Ticks past the stub queue's depth spill into the next tick
+    for (uint32_t i = 0; i < tick->event_count; i++) {
+      xcb_generic_event_t* copy = calloc(1, sizeof(xcb_generic_event_t));
+      if (!copy)
+        exit(1);
+      memcpy(copy, rp.events[tick->first_event + i], 32);
+      if (!xcb_stubs_enqueue_queued_event(copy)) {
+        free(copy);
+        break;
+      }
+    }
+    p->now = tick->t_ns;
+
+    uint64_t t0 = monotonic_time_ns();
+    pipeline_tick(p);
+    latency_hist_record(hist, monotonic_time_ns() - t0);
+  }
+  uint64_t requests = stub_request_count - req0;
+
+  replay_active = NULL;
+  pipeline_destroy(p);
+  free(p);
+
+  double ticks = rp.tick_len ? (double)rp.tick_len : 1.0;
+  printf("REPLAY TICKS %u EVENTS %u P50_NS %llu P90_NS %llu P99_NS %llu MAX_NS %llu REQS_PER_TICK %.2f REPLIES_MATCHED %llu REPLIES_ZEROED %llu\n", rp.tick_len, rp.event_len,
+         (unsigned long long)latency_hist_quantile(hist, 5000), (unsigned long long)latency_hist_quantile(hist, 9000),
+         (unsigned long long)latency_hist_quantile(hist, 9900), (unsigned long long)hist->max_ns, (double)requests / ticks,
+         (unsigned long long)rp.matched, (unsigned long long)rp.zeroed);
+
+  free(hist);
+  replay_free(&rp);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  scenario_kind_t scenario = SCENARIO_ALL;
+  uint64_t iters = 10000;
+  size_t clients_n = 1000;
+  const char* replay_path = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--scenario") == 0) {
+      if (i + 1 >= argc) {
+        print_usage(argv[0]);
+        return 2;
+      }
+      scenario = parse_scenario(argv[++i]);
+    } else if (strcmp(argv[i], "--iters") == 0) {
+      if (i + 1 >= argc) {
+        print_usage(argv[0]);
+        return 2;
+      }
+      iters = parse_u64(argv[++i], "iters");
+    } else if (strcmp(argv[i], "--clients") == 0) {
+      if (i + 1 >= argc) {
+        print_usage(argv[0]);
+        return 2;
+      }
+      uint64_t parsed = parse_u64(argv[++i], "clients");
+      if (parsed == 0) {
+        fprintf(stderr, "clients must be > 0\n");
+        return 2;
+      }
+      clients_n = (size_t)parsed;
+    } else if (strcmp(argv[i], "--replay") == 0) {
+      if (i + 1 >= argc) {
+        print_usage(argv[0]);
+        return 2;
+      }
+      replay_path = argv[++i];
+    } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+      print_usage(argv[0]);
+      return 0;
+    } else {
+      print_usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (replay_path)
+    return run_replay(replay_path);
+
+  static const struct {
+    const char* name;
+    scenario_kind_t kind;
+  } scenarios[] = {
+      {"manage", SCENARIO_MANAGE},
+      {"property_storm", SCENARIO_PROPERTY_STORM},
+      {"workspace_switch", SCENARIO_WORKSPACE_SWITCH},
+      {"interactive_resize", SCENARIO_INTERACTIVE_RESIZE},
+      {"alt_tab", SCENARIO_ALT_TAB},
+      {"drag_input_sleep", SCENARIO_DRAG_INPUT_SLEEP},
+      {"drag_input_busy_poll", SCENARIO_DRAG_INPUT_BUSY_POLL},
+      {"click_through", SCENARIO_CLICK_THROUGH},
+  };
+
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    if (scenario == SCENARIO_ALL || scenario == scenarios[i].kind)
+      run_one_scenario(scenarios[i].name, scenarios[i].kind, clients_n, iters);
+  }
+  return 0;
+}
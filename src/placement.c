@@ -0,0 +1,165 @@
+/* placement.c - Free-space search for initial window placement */
+
+#include "placement.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hxm.h"
+
+/*
+ * For an obstacle spanning [a, b) on one axis, the overlap with [x, x + len)
+ * is a trapezoid in x: rising from a - len, flat between min(a, b - len) and
+ * max(a, b - len), falling to zero at b. Each corner is a slope change.
+ */
+typedef struct placement_event {
+  int32_t pos;
+  int32_t dslope; /* +1 or -1, scaled by the obstacle's overlap on the other axis */
+  uint32_t obstacle;
+} placement_event_t;
+
+static int placement_i32_cmp(const void* a, const void* b) {
+  int32_t va = *(const int32_t*)a;
+  int32_t vb = *(const int32_t*)b;
+  return (va > vb) - (va < vb);
+}
+
+static int placement_event_cmp(const void* a, const void* b) {
+  int32_t va = ((const placement_event_t*)a)->pos;
+  int32_t vb = ((const placement_event_t*)b)->pos;
+  return (va > vb) - (va < vb);
+}
+
+static inline int32_t placement_span_overlap(int32_t x, int32_t len, int32_t a, int32_t b) {
+  int32_t lo = x > a ? x : a;
+  int32_t hi = (x + len) < b ? (x + len) : b;
+  return hi > lo ? hi - lo : 0;
+}
+
+static void* placement_alloc(arena_t* scratch, size_t size) {
+  void* p = arena_alloc(scratch, size ? size : 1u);
+  if (!p) {
+    LOG_ERROR("placement scratch allocation failed");
+    abort();
+  }
+  return p;
+}
+
+/* Sorted, deduplicated positions in [lo, hi] where the overlap can bend */
+static size_t placement_candidates(int32_t* out, int32_t lo, int32_t hi, int32_t len, const int32_t* a, const int32_t* b, size_t n) {
+  size_t m = 0;
+  out[m++] = lo;
+  if (hi != lo)
+    out[m++] = hi;
+  for (size_t i = 0; i < n; i++) {
+    int32_t pts[4] = {a[i] - len, a[i], b[i] - len, b[i]};
+    for (int k = 0; k < 4; k++) {
+      if (pts[k] > lo && pts[k] < hi)
+        out[m++] = pts[k];
+    }
+  }
+  qsort(out, m, sizeof(*out), placement_i32_cmp);
+  size_t u = 0;
+  for (size_t i = 0; i < m; i++) {
+    if (u == 0 || out[u - 1] != out[i])
+      out[u++] = out[i];
+  }
+  return u;
+}
+
+uint64_t placement_min_overlap(arena_t* scratch, rect_t area, uint32_t w, uint32_t h, const rect_t* obstacles, size_t n, int32_t* out_x, int32_t* out_y) {
+  int32_t x_lo = area.x;
+  int32_t y_lo = area.y;
+  int32_t x_hi = (w < area.w) ? (int32_t)area.x + (int32_t)area.w - (int32_t)w : x_lo;
+  int32_t y_hi = (h < area.h) ? (int32_t)area.y + (int32_t)area.h - (int32_t)h : y_lo;
+  int32_t len_x = (int32_t)w;
+  int32_t len_y = (int32_t)h;
+
+  *out_x = x_lo;
+  *out_y = y_lo;
+
+  // Only obstacles that can touch some candidate position matter
+  int32_t* ax = placement_alloc(scratch, (n ? n : 1u) * 4u * sizeof(int32_t));
+  int32_t* bx = ax + n;
+  int32_t* ay = bx + n;
+  int32_t* by = ay + n;
+  size_t m = 0;
+  for (size_t i = 0; i < n; i++) {
+    const rect_t* r = &obstacles[i];
+    if (r->w == 0 || r->h == 0)
+      continue;
+    int32_t rx0 = r->x, ry0 = r->y;
+    int32_t rx1 = rx0 + (int32_t)r->w, ry1 = ry0 + (int32_t)r->h;
+    if (rx1 <= x_lo || rx0 >= x_hi + len_x || ry1 <= y_lo || ry0 >= y_hi + len_y)
+      continue;
+    ax[m] = rx0;
+    bx[m] = rx1;
+    ay[m] = ry0;
+    by[m] = ry1;
+    m++;
+  }
+  if (m == 0 || len_x == 0 || len_y == 0)
+    return 0;
+
+  int32_t* xs = placement_alloc(scratch, (4u * m + 2u) * sizeof(int32_t));
+  int32_t* ys = placement_alloc(scratch, (4u * m + 2u) * sizeof(int32_t));
+  size_t nx = placement_candidates(xs, x_lo, x_hi, len_x, ax, bx, m);
+  size_t ny = placement_candidates(ys, y_lo, y_hi, len_y, ay, by, m);
+
+  placement_event_t* ev = placement_alloc(scratch, 4u * m * sizeof(*ev));
+  for (size_t i = 0; i < m; i++) {
+    int32_t rise_end = ax[i] < bx[i] - len_x ? ax[i] : bx[i] - len_x;
+    int32_t fall_start = ax[i] < bx[i] - len_x ? bx[i] - len_x : ax[i];
+    ev[4 * i + 0] = (placement_event_t){ax[i] - len_x, +1, (uint32_t)i};
+    ev[4 * i + 1] = (placement_event_t){rise_end, -1, (uint32_t)i};
+    ev[4 * i + 2] = (placement_event_t){fall_start, -1, (uint32_t)i};
+    ev[4 * i + 3] = (placement_event_t){bx[i], +1, (uint32_t)i};
+  }
+  qsort(ev, 4u * m, sizeof(*ev), placement_event_cmp);
+
+  int64_t* wy = placement_alloc(scratch, m * sizeof(*wy));
+  uint64_t best = UINT64_MAX;
+  for (size_t yi = 0; yi < ny; yi++) {
+    int32_t y = ys[yi];
+    bool any = false;
+    for (size_t i = 0; i < m; i++) {
+      wy[i] = placement_span_overlap(y, len_y, ay[i], by[i]);
+      any = any || wy[i] != 0;
+    }
+    if (!any) {
+      // Nothing in this band: the leftmost slot is free
+      best = 0;
+      *out_x = x_lo;
+      *out_y = y;
+      break;
+    }
+
+    // Sweep x: f is piecewise linear, advance it between breakpoints
+    int64_t f = 0;
+    int64_t slope = 0;
+    int32_t pos = ev[0].pos < xs[0] ? ev[0].pos : xs[0];
+    size_t ei = 0;
+    for (size_t xi = 0; xi < nx; xi++) {
+      int32_t x = xs[xi];
+      while (ei < 4u * m && ev[ei].pos <= x) {
+        f += slope * (int64_t)(ev[ei].pos - pos);
+        pos = ev[ei].pos;
+        slope += (int64_t)ev[ei].dslope * wy[ev[ei].obstacle];
+        ei++;
+      }
+      f += slope * (int64_t)(x - pos);
+      pos = x;
+      if ((uint64_t)f < best) {
+        best = (uint64_t)f;
+        *out_x = x;
+        *out_y = y;
+        if (best == 0)
+          break;
+      }
+    }
+    if (best == 0)
+      break;
+  }
+  return best;
+}
@@ -0,0 +1,220 @@
+/* src/prewarm.c
+ * Idle-time decoration prewarming for desktops likely shown next
+ *
+ * Painting goes through frame_flush like any other repaint, so a prewarmed
+ * frame is indistinguishable from one that was painted while shown: the
+ * backing pixmap or render context it leaves behind is what the next paint
+ * or expose would have built.
+ */
+
+#include "prewarm.h"
+
+#include "client.h"
+#include "event.h"
+#include "frame.h"
+#include "hxm.h"
+#include "mem_budget.h"
+#include "wm.h"
+#include "x_reader.h"
+
+#define PREWARM_DESKTOPS_MAX (2u + PREWARM_RECENT)
+
+static bool prewarm_add_desktop(uint32_t* out, uint32_t* n, uint32_t d, uint32_t current, uint32_t count) {
+  if (d == current || d >= count)
+    return false;
+  for (uint32_t i = 0; i < *n; i++) {
+    if (out[i] == d)
+      return false;
+  }
+  out[(*n)++] = d;
+  return true;
+}
+
+// Neighbours first, wrapping like wm_switch_workspace_relative, then recents
+static uint32_t prewarm_desktops(const server_t* s, uint32_t out[PREWARM_DESKTOPS_MAX]) {
+  const screen_t* scr = &s->screens[s->active_screen];
+  uint32_t count = scr->desktop_count;
+  uint32_t cur = scr->current_desktop;
+  uint32_t n = 0;
+  if (count < 2 || cur >= count)
+    return 0;
+  prewarm_add_desktop(out, &n, (cur + 1u) % count, cur, count);
+  prewarm_add_desktop(out, &n, (cur + count - 1u) % count, cur, count);
+  for (uint32_t i = 0; i < s->prewarm.recent_len; i++)
+    prewarm_add_desktop(out, &n, s->prewarm.recent[i], cur, count);
+  return n;
+}
+
+// True when the current desktop changed, which changes the candidates
+static bool prewarm_note_desktop(prewarm_t* pw, uint32_t current) {
+  if (current == pw->shown)
+    return false;
+  uint32_t left = pw->shown;
+  pw->shown = current;
+
+  uint32_t kept = 0;
+  uint32_t recent[PREWARM_RECENT];
+  recent[kept++] = left;
+  for (uint32_t i = 0; i < pw->recent_len && kept < PREWARM_RECENT; i++) {
+    if (pw->recent[i] != left && pw->recent[i] != current)
+      recent[kept++] = pw->recent[i];
+  }
+  for (uint32_t i = 0; i < kept; i++)
+    pw->recent[i] = recent[i];
+  pw->recent_len = kept;
+  return true;
+}
+
+static bool prewarm_on(const server_t* s) {
+  return s->config.prewarm_idle_ms > 0;
+}
+
+bool prewarm_keeps(const server_t* s, const client_hot_t* hot) {
+  if (!prewarm_on(s) || hot->state != STATE_MAPPED || hot->sticky || hot->desktop < 0 || hot->screen != s->active_screen)
+    return false;
+  uint32_t desktops[PREWARM_DESKTOPS_MAX];
+  uint32_t n = prewarm_desktops(s, desktops);
+  for (uint32_t i = 0; i < n; i++) {
+    if (desktops[i] == (uint32_t)hot->desktop)
+      return true;
+  }
+  return false;
+}
+
+// A frame the next switch to its desktop would otherwise have to render
+static bool prewarm_wanted(const server_t* s, const client_hot_t* hot, const client_cold_t* cold) {
+  if (hot->frame == XCB_NONE || hot->state != STATE_MAPPED || hot->sticky || hot->override_redirect || (hot->flags & CLIENT_FLAG_UNDECORATED))
+    return false;
+  const render_context_t* ctx = &cold->render_ctx;
+  if (ctx->title_pending)
+    return false;
+  // Dirty frames are painted by the commit whether shown or not, so a
+  // backing pixmap that exists is current
+  if (s->config.frame_backing)
+    return cold->frame_pixmap == XCB_NONE;
+  return !ctx->surface || (!ctx->title_surface && cold->title && cold->title[0] != '\0');
+}
+
+// Bytes a paint adds to what mem_budget counts
+static size_t prewarm_cost(const server_t* s, const client_hot_t* hot) {
+  if (!s->config.frame_backing)
+    return 0;
+  size_t w = (size_t)hot->server.w + 2u * s->config.theme.border_width;
+  size_t h = (size_t)hot->server.h + s->config.theme.title_height + s->config.theme.border_width;
+  return w * h * 4u;
+}
+
+/*
+ * Input the next tick would ingest. Without the reader thread this reads the
+ * socket; an event found is handed to that tick like server_wait_for_events
+ * does.
+ */
+static bool prewarm_input_pending(server_t* s) {
+  if (s->prefetched_event || x_reader_pending(&s->x_reader))
+    return true;
+  if (s->x_reader.running)
+    return false;
+  xcb_generic_event_t* ev = xcb_poll_for_event(s->conn);
+  if (!ev)
+    return false;
+  s->prefetched_event = ev;
+  return true;
+}
+
+static void prewarm_paint(server_t* s, handle_t h, client_hot_t* hot) {
+  // frame_flush clears what it paints, so the client needs no queueing
+  hot->dirty |= DIRTY_FRAME_ALL;
+  bool in_commit = s->in_commit_phase;
+  s->in_commit_phase = true;
+  frame_flush(s, h);
+  s->in_commit_phase = in_commit;
+}
+
+static bool prewarm_slice(server_t* s) {
+  prewarm_t* pw = &s->prewarm;
+  screen_t* scr = server_screen(s);
+  if (!scr->root_visual_type) {
+    pw->pending = false;
+    return false;
+  }
+  pw->slices++;
+  uint64_t start = monotonic_time_ns();
+
+  size_t limit = (size_t)s->config.memory_budget_mb << 20;
+  size_t room = limit ? limit / 100u * MEM_BUDGET_LOW_WATER : SIZE_MAX;
+  size_t used = s->mem_budget.last.total;
+
+  uint32_t desktops[PREWARM_DESKTOPS_MAX];
+  uint32_t nd = prewarm_desktops(s, desktops);
+  uint32_t index = 0;
+  uint32_t painted = 0;
+  bool queued = false;
+  for (uint32_t d = 0; d < nd; d++) {
+    handle_vec_t* members = wm_desktop_members(s, scr, desktops[d]);
+    size_t len = members ? members->length : 0;
+    if (index + len <= pw->cursor) {
+      index += (uint32_t)len;
+      continue;
+    }
+    for (size_t i = pw->cursor > index ? pw->cursor - index : 0; i < len; i++) {
+      if (painted == PREWARM_SLICE_CLIENTS || monotonic_time_ns() - start >= PREWARM_SLICE_NS) {
+        // The rest goes in the next slice, after the loop has looked for input
+        server_schedule_timer_ns(s, 0);
+        return queued;
+      }
+      if (prewarm_input_pending(s)) {
+        // The tick that ingests it restarts the idle wait
+        pw->yields++;
+        return queued;
+      }
+      pw->cursor = index + (uint32_t)i + 1u;
+
+      handle_t h = members->items[i];
+      client_hot_t* hot = server_chot(s, h);
+      client_cold_t* cold = server_ccold(s, h);
+      if (!hot || !cold || !prewarm_wanted(s, hot, cold))
+        continue;
+      size_t cost = prewarm_cost(s, hot);
+      if (used + cost > room) {
+        pw->budget_stops++;
+        pw->pending = false;
+        return queued;
+      }
+      used += cost;
+      prewarm_paint(s, h, hot);
+      painted++;
+      pw->painted++;
+      queued = true;
+    }
+    index += (uint32_t)len;
+  }
+  pw->pending = false;
+  return queued;
+}
+
+bool prewarm_tick(server_t* s, uint64_t now_ns) {
+  prewarm_t* pw = &s->prewarm;
+  bool switched = prewarm_note_desktop(pw, server_screen(s)->current_desktop);
+  if (!prewarm_on(s)) {
+    pw->pending = false;
+    return false;
+  }
+
+  uint64_t idle_ns = (uint64_t)s->config.prewarm_idle_ms * 1000000u;
+  if (s->buckets.ingested > 0 || switched || pw->idle_since_ns == 0) {
+    pw->idle_since_ns = now_ns;
+    pw->cursor = 0;
+    pw->pending = true;
+    server_schedule_timer_ns(s, idle_ns);
+    return false;
+  }
+  if (!pw->pending)
+    return false;
+
+  uint64_t idle = now_ns - pw->idle_since_ns;
+  if (idle < idle_ns) {
+    server_schedule_timer_ns(s, idle_ns - idle);
+    return false;
+  }
+  return prewarm_slice(s);
+}
@@ -13,8 +13,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "icon_cache.h"
+#include "render_worker.h"
+
 // Rendering is expected to run on the WM thread
-// XCB/cairo_xcb are not safely usable from multiple threads on one connection
+// XCB/cairo_xcb are not safely usable from multiple threads on one connection;
+// only render_title_* below may run elsewhere (see render_worker.c)
 
 // Helper to convert hex uint32 to RGBA
 static rgba_t u32_to_rgba(uint32_t c) {
@@ -150,15 +154,26 @@ static void render_reset_surface(render_context_t* ctx) {
   ctx->height = 0;
 }
 
+/*
+ * Size changes keep the surface and cairo_t: a window-backed xcb surface
+ * only needs to learn the new drawable size. Interactive resizes repaint on
+ * every flush, so rebuilding here would put cairo setup on the motion path.
+ * A new drawable of the same visual/depth (a frame's backing pixmap is
+ * replaced on every resize) is swapped in the same way. Only a new visual or
+ * depth (or the image surfaces used by tests, which cannot change size)
+ * rebuild the context.
+ */
 static bool render_prepare_surface(xcb_connection_t* conn, xcb_window_t win, xcb_visualtype_t* visual, render_context_t* ctx, int depth, int w, int h, bool is_test) {
   bool recreate = false;
 
   if (!ctx->surface || !ctx->cr)
     recreate = true;
 
-  if (ctx->surface_is_test != is_test || ctx->target != win || ctx->width != w || ctx->height != h || ctx->depth != depth) {
+  if (ctx->surface_is_test != is_test || ctx->depth != depth) {
     recreate = true;
   }
+  if (is_test && ctx->target != win)
+    recreate = true;
 
   if (!is_test) {
     if (!visual)
@@ -167,9 +182,23 @@ static bool render_prepare_surface(xcb_connection_t* conn, xcb_window_t win, xcb
       recreate = true;
   }
 
-  if (!recreate)
+  if (!recreate && ctx->target == win && ctx->width == w && ctx->height == h)
     return true;
 
+  if (!recreate && !is_test) {
+    cairo_surface_flush(ctx->surface);
+    if (ctx->target != win)
+      cairo_xcb_surface_set_drawable(ctx->surface, win, w, h);
+    else
+      cairo_xcb_surface_set_size(ctx->surface, w, h);
+    if (cairo_surface_ok(ctx->surface)) {
+      ctx->target = win;
+      ctx->width = w;
+      ctx->height = h;
+      return true;
+    }
+  }
+
   render_reset_surface(ctx);
 
   cairo_surface_t* surface = NULL;
@@ -204,6 +233,12 @@ static bool render_prepare_surface(xcb_connection_t* conn, xcb_window_t win, xcb
   return true;
 }
 
+bool render_context_ensure(xcb_connection_t* conn, xcb_window_t win, xcb_visualtype_t* visual, render_context_t* ctx, int depth, int width, int height) {
+  if (!ctx || width <= 0 || height <= 0)
+    return false;
+  return render_prepare_surface(conn, win, visual, ctx, depth, width, height, false);
+}
+
 static void render_invalidate_title_cache(render_context_t* ctx) {
   if (ctx->title_surface) {
     cairo_surface_destroy(ctx->title_surface);
@@ -214,6 +249,10 @@ static void render_invalidate_title_cache(render_context_t* ctx) {
   ctx->last_title_color = 0xFFFFFFFFu;
 }
 
+void render_release_title(render_context_t* ctx) {
+  render_invalidate_title_cache(ctx);
+}
+
 void render_init(render_context_t* ctx) {
   ctx->surface = NULL;
   ctx->cr = NULL;
@@ -229,6 +268,7 @@ void render_init(render_context_t* ctx) {
   ctx->last_title_width = -1;
   ctx->last_title_height = -1;
   ctx->last_title_color = 0xFFFFFFFFu;
+  ctx->title_pending = false;
 }
 
 void render_free(render_context_t* ctx) {
@@ -244,105 +284,246 @@ void render_free(render_context_t* ctx) {
   render_invalidate_title_cache(ctx);
 }
 
-static void ensure_layout(render_context_t* ctx) {
-  if (ctx->layout)
+/*
+ * Main thread text state. Every frame shares one title layout, retargeted by
+ * pango_cairo_update_layout per rasterization; the text height comes from
+ * the font metrics instead of measuring each shaped title.
+ */
+typedef struct render_text {
+  PangoFontMap* font_map;
+  PangoContext* context;
+  PangoLayout* title_layout;
+  char* font; /* description the layout was configured from */
+  int text_height;
+  uint64_t configures;
+} render_text_t;
+
+static render_text_t g_text;
+
+/* 1x1 cairo-xcb surface on the root that upload images are made similar to */
+static cairo_surface_t* g_upload_ref;
+
+void render_upload_init(xcb_connection_t* conn, xcb_window_t root, xcb_visualtype_t* visual) {
+  render_upload_shutdown();
+  if (!conn || !visual)
     return;
+  render_upload_set_reference(cairo_xcb_surface_create(conn, root, visual, 1, 1));
+}
 
-  // We need a dummy surface to create a layout if one doesn't exist
-  cairo_surface_t* dummy = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
-  cairo_t* cr = cairo_create(dummy);
-  ctx->layout = pango_cairo_create_layout(cr);
-  cairo_destroy(cr);
-  cairo_surface_destroy(dummy);
+void render_upload_set_reference(cairo_surface_t* ref) {
+  render_upload_shutdown();
+  if (!cairo_surface_ok(ref)) {
+    if (ref)
+      cairo_surface_destroy(ref);
+    return;
+  }
+  g_upload_ref = ref;
+}
 
-  PangoFontDescription* desc = pango_font_description_from_string("Sans Bold 10");
-  pango_layout_set_font_description(ctx->layout, desc);
+void render_upload_shutdown(void) {
+  // Images already handed out keep their own device reference
+  if (g_upload_ref)
+    cairo_surface_destroy(g_upload_ref);
+  g_upload_ref = NULL;
+}
+
+bool render_upload_shm(void) {
+  return g_upload_ref != NULL;
+}
+
+cairo_surface_t* render_image_create(cairo_format_t format, int w, int h) {
+  if (g_upload_ref) {
+    // cairo keeps small images out of the pool and falls back when it is full
+    cairo_surface_t* surface = cairo_surface_create_similar_image(g_upload_ref, format, w, h);
+    if (cairo_surface_ok(surface) && cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE)
+      return surface;
+    if (surface)
+      cairo_surface_destroy(surface);
+  }
+  return cairo_image_surface_create(format, w, h);
+}
+
+static PangoContext* render_context_for_thread(PangoFontMap** map_out) {
+  // The cairo font map is per thread, so the worker gets its own
+  PangoFontMap* map = pango_cairo_font_map_get_default();
+  if (map_out)
+    *map_out = g_object_ref(map);
+  return pango_font_map_create_context(map);
+}
+
+static PangoLayout* render_layout_for_font(PangoContext* context, const char* font) {
+  PangoLayout* layout = pango_layout_new(context);
+  PangoFontDescription* desc = pango_font_description_from_string(font);
+  pango_layout_set_font_description(layout, desc);
   pango_font_description_free(desc);
+  return layout;
+}
+
+int render_title_text_height(PangoLayout* layout) {
+  const PangoFontDescription* desc = pango_layout_get_font_description(layout);
+  PangoFontMetrics* m = pango_context_get_metrics(pango_layout_get_context(layout), desc, NULL);
+  int h = pango_font_metrics_get_ascent(m) + pango_font_metrics_get_descent(m);
+  pango_font_metrics_unref(m);
+  return PANGO_PIXELS_CEIL(h);
+}
+
+void render_text_configure(const char* font) {
+  if (!font || !font[0])
+    font = RENDER_TEXT_DEFAULT_FONT;
+  if (g_text.font && strcmp(g_text.font, font) == 0)
+    return;
+
+  char* copy = strdup(font);
+  if (!copy) {
+    LOG_ERROR("render text font allocation failed");
+    return;
+  }
+  if (!g_text.context)
+    g_text.context = render_context_for_thread(&g_text.font_map);
+  if (g_text.title_layout)
+    g_object_unref(g_text.title_layout);
+  free(g_text.font);
+  g_text.font = copy;
+  g_text.title_layout = render_layout_for_font(g_text.context, copy);
+  g_text.text_height = render_title_text_height(g_text.title_layout);
+  g_text.configures++;
+}
+
+void render_text_shutdown(void) {
+  if (g_text.title_layout)
+    g_object_unref(g_text.title_layout);
+  if (g_text.context)
+    g_object_unref(g_text.context);
+  if (g_text.font_map)
+    g_object_unref(g_text.font_map);
+  free(g_text.font);
+  memset(&g_text, 0, sizeof(g_text));
+}
+
+static void render_text_ensure(void) {
+  if (!g_text.title_layout)
+    render_text_configure(NULL);
+}
+
+const char* render_text_font(void) {
+  render_text_ensure();
+  return g_text.font;
+}
+
+int render_text_height(void) {
+  render_text_ensure();
+  return g_text.text_height;
+}
+
+uint64_t render_text_configures(void) {
+  return g_text.configures;
+}
+
+PangoLayout* render_text_layout_create(const char* font) {
+  render_text_ensure();
+  return render_layout_for_font(g_text.context, font);
+}
+
+PangoLayout* render_title_layout_create(const char* font) {
+  PangoContext* context = render_context_for_thread(NULL);
+  PangoLayout* layout = render_layout_for_font(context, font);
+  g_object_unref(context);  // the layout holds its own reference
+  return layout;
 }
 
-static bool render_update_title_cache(render_context_t* ctx, const char* title, int title_text_width, int title_h, rgba_t text, uint32_t text_color_u32) {
+// Shape title into surface; the surface may be wider than title_text_width
+bool render_title_rasterize(PangoLayout* layout, cairo_surface_t* surface, const char* title, int title_text_width, int title_h, int text_h, rgba_t text) {
+  cairo_t* title_cr = cairo_create(surface);
+  if (!cairo_ctx_ok(title_cr)) {
+    cairo_destroy(title_cr);
+    return false;
+  }
+
+  pango_layout_set_text(layout, title, -1);
+  pango_layout_set_width(layout, title_text_width * PANGO_SCALE);
+  pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+
+  cairo_set_operator(title_cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_rgba(title_cr, 0.0, 0.0, 0.0, 0.0);
+  cairo_paint(title_cr);
+  cairo_set_operator(title_cr, CAIRO_OPERATOR_OVER);
+  cairo_set_source_rgba(title_cr, text.r, text.g, text.b, text.a);
+
+  double text_y = (title_h - text_h) / 2.0;
+  cairo_move_to(title_cr, 0.0, text_y);
+  pango_cairo_update_layout(title_cr, layout);
+  pango_cairo_show_layout(title_cr, layout);
+
+  cairo_destroy(title_cr);
+  cairo_surface_flush(surface);
+  return true;
+}
+
+/*
+ * Point ctx->title_surface at the rendered title. Runs come from the shared
+ * cache when one is given (ctx then holds a reference), so pango only runs
+ * for a title/width/colour combination no client has shown recently.
+ */
+static bool render_update_title_cache(render_context_t* ctx, title_cache_t* titles, const char* title, int title_text_width, int title_h, rgba_t text, uint32_t text_color_u32) {
   if (!ctx)
     return false;
 
   if (!title)
     title = "";
 
-  ensure_layout(ctx);
-
   bool title_changed = (!ctx->last_title || strcmp(ctx->last_title, title) != 0);
   if (title_changed) {
-    pango_layout_set_text(ctx->layout, title, -1);
     if (ctx->last_title)
       free(ctx->last_title);
     ctx->last_title = strdup(title);
   }
 
-  if (title[0] == '\0' || title_text_width <= 0 || title_h <= 0) {
-    render_invalidate_title_cache(ctx);
+  bool unchanged = !title_changed && ctx->last_title_width == title_text_width && ctx->last_title_height == title_h && ctx->last_title_color == text_color_u32;
+  if (unchanged && ctx->title_surface && !ctx->title_pending)
+    return true;
+
+  bool drawable = title[0] != '\0' && title_text_width > 0 && title_h > 0;
+  title_key_t key = {render_text_font(), title, title_text_width, title_h, text_color_u32};
+  cairo_surface_t* run = (drawable && titles) ? title_cache_lookup(titles, &key) : NULL;
+  if (drawable && !run && titles && titles->worker) {
+    // Keep showing the previous run until the worker delivers this one
+    render_worker_request(titles->worker, titles, &key);
+    ctx->title_pending = true;
     ctx->last_title_width = title_text_width;
     ctx->last_title_height = title_h;
     ctx->last_title_color = text_color_u32;
-    return false;
+    return ctx->title_surface != NULL;
   }
 
-  bool width_changed = (ctx->last_title_width != title_text_width);
-  if (width_changed) {
-    pango_layout_set_width(ctx->layout, title_text_width * PANGO_SCALE);
-    pango_layout_set_ellipsize(ctx->layout, PANGO_ELLIPSIZE_END);
-  }
-
-  bool height_changed = (ctx->last_title_height != title_h);
-  bool color_changed = (ctx->last_title_color != text_color_u32);
-  bool cache_miss = (ctx->title_surface == NULL);
+  render_invalidate_title_cache(ctx);
+  ctx->title_pending = false;
+  ctx->last_title_width = title_text_width;
+  ctx->last_title_height = title_h;
+  ctx->last_title_color = text_color_u32;
 
-  if (cache_miss || title_changed || width_changed || height_changed || color_changed) {
-    if (ctx->title_surface) {
-      cairo_surface_destroy(ctx->title_surface);
-      ctx->title_surface = NULL;
-    }
+  if (!drawable)
+    return false;
 
-    cairo_surface_t* title_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, title_text_width, title_h);
-    if (!cairo_surface_ok(title_surface)) {
-      if (title_surface)
-        cairo_surface_destroy(title_surface);
-      ctx->last_title_width = title_text_width;
-      ctx->last_title_height = title_h;
-      ctx->last_title_color = text_color_u32;
+  if (!run) {
+    cairo_surface_t* surface = titles ? title_cache_acquire(titles, title_text_width, title_h) : render_image_create(CAIRO_FORMAT_ARGB32, title_text_width, title_h);
+    if (!cairo_surface_ok(surface)) {
+      if (surface)
+        cairo_surface_destroy(surface);
       return false;
     }
-
-    cairo_t* title_cr = cairo_create(title_surface);
-    if (!cairo_ctx_ok(title_cr)) {
-      cairo_destroy(title_cr);
-      cairo_surface_destroy(title_surface);
-      ctx->last_title_width = title_text_width;
-      ctx->last_title_height = title_h;
-      ctx->last_title_color = text_color_u32;
+    if (!render_title_rasterize(g_text.title_layout, surface, title, title_text_width, title_h, g_text.text_height, text)) {
+      cairo_surface_destroy(surface);
       return false;
     }
-
-    cairo_set_operator(title_cr, CAIRO_OPERATOR_SOURCE);
-    cairo_set_source_rgba(title_cr, 0.0, 0.0, 0.0, 0.0);
-    cairo_paint(title_cr);
-    cairo_set_operator(title_cr, CAIRO_OPERATOR_OVER);
-    cairo_set_source_rgba(title_cr, text.r, text.g, text.b, text.a);
-
-    int text_h = 0;
-    pango_layout_get_pixel_size(ctx->layout, NULL, &text_h);
-    double text_y = (title_h - text_h) / 2.0;
-    cairo_move_to(title_cr, 0.0, text_y);
-    pango_cairo_update_layout(title_cr, ctx->layout);
-    pango_cairo_show_layout(title_cr, ctx->layout);
-
-    cairo_destroy(title_cr);
-    cairo_surface_flush(title_surface);
-    ctx->title_surface = title_surface;
+    if (!titles) {
+      ctx->title_surface = surface;
+      return true;
+    }
+    run = title_cache_insert(titles, &key, surface);
   }
 
-  ctx->last_title_width = title_text_width;
-  ctx->last_title_height = title_h;
-  ctx->last_title_color = text_color_u32;
-  return ctx->title_surface != NULL;
+  ctx->title_surface = cairo_surface_reference(run);
+  return true;
 }
 
 static void draw_button(cairo_t* cr, int x, int y, int w, int h, const char* type, rgba_t color) {
@@ -376,6 +557,135 @@ static void draw_button(cairo_t* cr, int x, int y, int w, int h, const char* typ
   }
 }
 
+void render_tiles_init(render_tiles_t* tiles) {
+  memset(tiles, 0, sizeof(*tiles));
+}
+
+void render_tiles_destroy(render_tiles_t* tiles) {
+  for (size_t i = 0; i < 2; i++) {
+    if (tiles->title[i].slices)
+      cairo_surface_destroy(tiles->title[i].slices);
+    if (tiles->buttons[i].strip)
+      cairo_surface_destroy(tiles->buttons[i].strip);
+  }
+  memset(tiles, 0, sizeof(*tiles));
+}
+
+static cairo_surface_t* render_tile_create(int w, int h, cairo_t** out_cr) {
+  cairo_surface_t* surface = render_image_create(CAIRO_FORMAT_ARGB32, w, h);
+  if (!cairo_surface_ok(surface)) {
+    if (surface)
+      cairo_surface_destroy(surface);
+    return NULL;
+  }
+  cairo_t* cr = cairo_create(surface);
+  if (!cairo_ctx_ok(cr)) {
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+  *out_cr = cr;
+  return surface;
+}
+
+static inline bool appearance_equal(const appearance_t* a, const appearance_t* b) {
+  return a->flags == b->flags && a->color == b->color && a->color_to == b->color_to;
+}
+
+// Horizontal and diagonal gradients change along x and cannot be stretched
+static inline bool appearance_x_invariant(const appearance_t* app) {
+  if (!(app->flags & BG_GRADIENT))
+    return true;
+  return !(app->flags & (BG_HORIZONTAL | BG_DIAGONAL | BG_CROSSDIAGONAL));
+}
+
+static cairo_surface_t* render_tiles_title(render_tiles_t* tiles, bool active, appearance_t* app, int h) {
+  if (!appearance_x_invariant(app) || h <= 0)
+    return NULL;
+
+  render_title_tile_t* t = &tiles->title[active ? 1 : 0];
+  if (t->slices && t->height == h && appearance_equal(&t->app, app))
+    return t->slices;
+
+  if (t->slices) {
+    cairo_surface_destroy(t->slices);
+    t->slices = NULL;
+  }
+
+  cairo_t* cr = NULL;
+  cairo_surface_t* slices = render_tile_create(RENDER_TILE_WIDTH, h, &cr);
+  if (!slices)
+    return NULL;
+  // Bevel edges fall within the caps, so the centre column is the whole interior
+  draw_appearance(cr, RENDER_TILE_WIDTH, h, app);
+  cairo_destroy(cr);
+  cairo_surface_flush(slices);
+
+  t->app = *app;
+  t->height = h;
+  t->slices = slices;
+  tiles->builds++;
+  return slices;
+}
+
+static cairo_surface_t* render_tiles_buttons(render_tiles_t* tiles, bool active, uint32_t color) {
+  render_button_tile_t* b = &tiles->buttons[active ? 1 : 0];
+  if (b->strip && b->color == color)
+    return b->strip;
+
+  if (b->strip) {
+    cairo_surface_destroy(b->strip);
+    b->strip = NULL;
+  }
+
+  cairo_t* cr = NULL;
+  cairo_surface_t* strip = render_tile_create(3 * RENDER_BUTTON_SIZE, RENDER_BUTTON_SIZE, &cr);
+  if (!strip)
+    return NULL;
+  rgba_t c = u32_to_rgba(color);
+  draw_button(cr, 0 * RENDER_BUTTON_SIZE, 0, RENDER_BUTTON_SIZE, RENDER_BUTTON_SIZE, "close", c);
+  draw_button(cr, 1 * RENDER_BUTTON_SIZE, 0, RENDER_BUTTON_SIZE, RENDER_BUTTON_SIZE, "max", c);
+  draw_button(cr, 2 * RENDER_BUTTON_SIZE, 0, RENDER_BUTTON_SIZE, RENDER_BUTTON_SIZE, "min", c);
+  cairo_destroy(cr);
+  cairo_surface_flush(strip);
+
+  b->color = color;
+  b->strip = strip;
+  tiles->builds++;
+  return strip;
+}
+
+// Copy the caps as-is and stretch the centre column across the rest
+static void blit_title_slices(cairo_t* cr, cairo_surface_t* slices, int w, int h) {
+  cairo_set_source_surface(cr, slices, 0.0, 0.0);
+  cairo_rectangle(cr, 0, 0, RENDER_TILE_CAP, h);
+  cairo_fill(cr);
+
+  cairo_set_source_surface(cr, slices, (double)(w - RENDER_TILE_WIDTH), 0.0);
+  cairo_rectangle(cr, (double)(w - RENDER_TILE_CAP), 0, RENDER_TILE_CAP, h);
+  cairo_fill(cr);
+
+  cairo_save(cr);
+  cairo_translate(cr, RENDER_TILE_CAP, 0);
+  cairo_scale(cr, (double)(w - 2 * RENDER_TILE_CAP), 1.0);
+  cairo_set_source_surface(cr, slices, -(double)RENDER_TILE_CAP, 0.0);
+  cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+  cairo_rectangle(cr, 0, 0, 1, h);
+  cairo_fill(cr);
+  cairo_restore(cr);
+}
+
+// glyph is the button's slot in the strip built by render_tiles_buttons
+static void blit_button(cairo_t* cr, cairo_surface_t* strip, int glyph, int x, int y, const char* type, rgba_t color) {
+  if (!strip) {
+    draw_button(cr, x, y, RENDER_BUTTON_SIZE, RENDER_BUTTON_SIZE, type, color);
+    return;
+  }
+  cairo_set_source_surface(cr, strip, (double)(x - glyph * RENDER_BUTTON_SIZE), (double)y);
+  cairo_rectangle(cr, x, y, RENDER_BUTTON_SIZE, RENDER_BUTTON_SIZE);
+  cairo_fill(cr);
+}
+
 /*
  * render_frame:
  * Paint the window frame.
@@ -383,11 +693,11 @@ static void draw_button(cairo_t* cr, int x, int y, int w, int h, const char* typ
  * Pipeline:
  * 1. Reuse or (re)create a persistent Cairo surface/context.
  * 2. Apply clip region (if partial redraw).
- * 3. Draw background, title, buttons.
+ * 3. Draw background, title, buttons (blitting cached tiles when given).
  * 4. Flush Cairo surface.
  * 5. In tests, upload image data via xcb_put_image for assertions.
  *
- * Note: PangoLayout is reused from `ctx` to save font lookup time.
+ * Note: titles are shaped with the shared main thread layout (render_text_*).
  */
 void render_frame(xcb_connection_t* conn,
                   xcb_window_t win,
@@ -400,8 +710,10 @@ void render_frame(xcb_connection_t* conn,
                   int w,
                   int h,
                   theme_t* theme,
+                  render_tiles_t* tiles,
+                  title_cache_t* titles,
                   cairo_surface_t* icon,
-                  const dirty_region_t* dirty) {
+                  const dirty_rects_t* dirty) {
   if (w <= 0 || h <= 0)
     return;
   if (!ctx)
@@ -418,20 +730,21 @@ void render_frame(xcb_connection_t* conn,
   cairo_reset_clip(cr);
 
   bool use_clip = false;
-  dirty_region_t clip = {0};
-  if (dirty && dirty->valid) {
+  dirty_rects_t clip;
+  dirty_rects_reset(&clip);
+  if (dirty && !dirty_rects_empty(dirty)) {
     clip = *dirty;
-    // Validate clip before clamp to avoid pixman asserts if coords are bogus
-    if (clip.w > 0 && clip.h > 0) {
-      dirty_region_clamp(&clip, 0, 0, (uint16_t)w, (uint16_t)h);
-      if (!clip.valid) {
-        cairo_restore(cr);
-        return;
-      }
-      cairo_rectangle(cr, (double)clip.x, (double)clip.y, (double)clip.w, (double)clip.h);
-      cairo_clip(cr);
-      use_clip = true;
+    // Clamp before clipping to avoid pixman asserts if coords are bogus
+    dirty_rects_clamp(&clip, 0, 0, (uint16_t)w, (uint16_t)h);
+    if (dirty_rects_empty(&clip)) {
+      cairo_restore(cr);
+      return;
     }
+    // One clip path of disjoint rects, so separate exposes stay separate
+    for (uint8_t i = 0; i < clip.count; i++)
+      cairo_rectangle(cr, (double)clip.rects[i].x, (double)clip.rects[i].y, (double)clip.rects[i].w, (double)clip.rects[i].h);
+    cairo_clip(cr);
+    use_clip = true;
   }
 
   // Map State
@@ -446,9 +759,11 @@ void render_frame(xcb_connection_t* conn,
   int border_w = (int)theme->border_width;
   bool clip_hits_title = true;
   if (use_clip) {
-    int32_t cy0 = (int32_t)clip.y;
-    int32_t cy1 = cy0 + (int32_t)clip.h;
-    clip_hits_title = (cy0 < title_h && cy1 > 0);
+    clip_hits_title = false;
+    for (uint8_t i = 0; i < clip.count; i++) {
+      if (clip.rects[i].y < title_h)
+        clip_hits_title = true;
+    }
   }
 
   // 1. Draw Background (Solid for the whole frame, title_bg for titlebar)
@@ -460,7 +775,11 @@ void render_frame(xcb_connection_t* conn,
     cairo_save(cr);
     cairo_rectangle(cr, 0, 0, w, title_h);
     cairo_clip(cr);
-    draw_appearance(cr, w, title_h, title_bg);
+    cairo_surface_t* slices = (tiles && w >= RENDER_TILE_WIDTH) ? render_tiles_title(tiles, active, title_bg, title_h) : NULL;
+    if (slices)
+      blit_title_slices(cr, slices, w, title_h);
+    else
+      draw_appearance(cr, w, title_h, title_bg);
     cairo_restore(cr);
   }
 
@@ -468,29 +787,25 @@ void render_frame(xcb_connection_t* conn,
 
   // 2. Draw Icon
   if (clip_hits_title && icon) {
+    int target_size = title_h - 4;
+    if (target_size > 16)
+      target_size = 16;
+    if (target_size < 8)
+      target_size = 8;
+
+    // Pre-scaled once per icon and size, so this is a plain blit
+    cairo_surface_t* scaled = icon_cache_scaled(icon, target_size);
     int icon_w, icon_h;
-    if (get_image_wh(icon, &icon_w, &icon_h)) {
-      double target_size = title_h - 4;
-      if (target_size > 16)
-        target_size = 16;
-      if (target_size < 8)
-        target_size = 8;
-      double scale = target_size / ((icon_w > icon_h) ? icon_w : icon_h);
-      double draw_w = icon_w * scale;
-      double draw_h = icon_h * scale;
-      double icon_y = (title_h - draw_h) / 2.0;
-      cairo_save(cr);
-      cairo_translate(cr, title_x_offset, icon_y);
-      cairo_scale(cr, scale, scale);
-      cairo_set_source_surface(cr, icon, 0, 0);
+    if (get_image_wh(scaled, &icon_w, &icon_h)) {
+      int icon_y = (title_h - icon_h) / 2;
+      cairo_set_source_surface(cr, scaled, (double)title_x_offset, (double)icon_y);
       cairo_paint(cr);
-      cairo_restore(cr);
-      title_x_offset += (int)draw_w + 6;
+      title_x_offset += icon_w + 6;
     }
   }
 
   // Button dimensions (used for title text clipping)
-  int btn_size = 16;
+  int btn_size = RENDER_BUTTON_SIZE;
   int btn_pad = 4;
   int total_button_width = 3 * btn_size + 4 * btn_pad;
   int leftmost_button_x = w - border_w - total_button_width;
@@ -506,9 +821,11 @@ void render_frame(xcb_connection_t* conn,
 
   // 3. Draw Title Text
   if (clip_hits_title && title && title[0] != '\0') {
-    if (render_update_title_cache(ctx, title, title_text_width, title_h, text, text_color_u32)) {
+    if (render_update_title_cache(ctx, titles, title, title_text_width, title_h, text, text_color_u32)) {
+      // A stale run shown while its successor is shaped may be wider
       cairo_set_source_surface(cr, ctx->title_surface, (double)title_x_offset, 0.0);
-      cairo_paint(cr);
+      cairo_rectangle(cr, (double)title_x_offset, 0.0, (double)title_text_width, (double)title_h);
+      cairo_fill(cr);
     }
   }
 
@@ -542,11 +859,12 @@ void render_frame(xcb_connection_t* conn,
       btn_x += border_w - leftmost_x;
       leftmost_x = border_w;
     }
-    draw_button(cr, btn_x, btn_y, btn_size, btn_size, "close", text);
+    cairo_surface_t* strip = tiles ? render_tiles_buttons(tiles, active, text_color_u32) : NULL;
+    blit_button(cr, strip, 0, btn_x, btn_y, "close", text);
     btn_x -= (btn_size + btn_pad);
-    draw_button(cr, btn_x, btn_y, btn_size, btn_size, "max", text);
+    blit_button(cr, strip, 1, btn_x, btn_y, "max", text);
     btn_x -= (btn_size + btn_pad);
-    draw_button(cr, btn_x, btn_y, btn_size, btn_size, "min", text);
+    blit_button(cr, strip, 2, btn_x, btn_y, "min", text);
   }
 
   // 6. Present
@@ -0,0 +1,208 @@
+/* render_worker.c - Off-thread title text shaping */
+
+#include "render_worker.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "hxm.h"
+#include "render.h"
+
+struct render_job {
+  render_job_t* next;
+  uint64_t hash;
+  title_key_t key; /* font and text point into buf */
+  char* buf;
+  cairo_surface_t* surface;
+  bool ok;
+};
+
+static rgba_t render_job_color(uint32_t c) {
+  return (rgba_t){((c >> 16) & 0xFF) / 255.0, ((c >> 8) & 0xFF) / 255.0, (c & 0xFF) / 255.0, 1.0};
+}
+
+static void render_job_free(render_job_t* job) {
+  if (job->surface)
+    cairo_surface_destroy(job->surface);
+  free(job->buf);
+  free(job);
+}
+
+static void render_job_free_list(render_job_t* job) {
+  while (job) {
+    render_job_t* next = job->next;
+    render_job_free(job);
+    job = next;
+  }
+}
+
+static void* render_worker_main(void* arg) {
+  render_worker_t* w = (render_worker_t*)arg;
+  // Pango layouts are not shareable across threads; this one is ours
+  PangoLayout* layout = NULL;
+  char* layout_font = NULL;
+  int text_h = 0;
+
+  pthread_mutex_lock(&w->lock);
+  for (;;) {
+    while (!w->stop && !w->queue_head)
+      pthread_cond_wait(&w->wake, &w->lock);
+    if (w->stop)
+      break;
+
+    render_job_t* job = w->queue_head;
+    w->queue_head = job->next;
+    if (!w->queue_head)
+      w->queue_tail = NULL;
+    pthread_mutex_unlock(&w->lock);
+
+    if (!layout || strcmp(layout_font, job->key.font) != 0) {
+      if (layout)
+        g_object_unref(layout);
+      free(layout_font);
+      layout = render_title_layout_create(job->key.font);
+      layout_font = strdup(job->key.font);
+      if (!layout_font) {
+        LOG_ERROR("render worker font allocation failed");
+        abort();
+      }
+      text_h = render_title_text_height(layout);
+    }
+    job->ok = render_title_rasterize(layout, job->surface, job->key.text, job->key.width, job->key.height, text_h, render_job_color(job->key.color));
+
+    pthread_mutex_lock(&w->lock);
+    bool was_empty = w->done == NULL;
+    job->next = w->done;
+    w->done = job;
+    if (was_empty) {
+      uint64_t one = 1;
+      if (write(w->notify_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        LOG_WARN("render worker notify failed: %s", strerror(errno));
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+
+  if (layout)
+    g_object_unref(layout);
+  free(layout_font);
+  return NULL;
+}
+
+bool render_worker_start(render_worker_t* w) {
+  memset(w, 0, sizeof(*w));
+  w->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (w->notify_fd < 0) {
+    LOG_WARN("render worker eventfd failed: %s", strerror(errno));
+    w->notify_fd = -1;
+    return false;
+  }
+  pthread_mutex_init(&w->lock, NULL);
+  pthread_cond_init(&w->wake, NULL);
+  hash_map_init(&w->inflight);
+
+  int err = pthread_create(&w->thread, NULL, render_worker_main, w);
+  if (err != 0) {
+    LOG_WARN("render worker thread failed: %s", strerror(err));
+    hash_map_destroy(&w->inflight);
+    pthread_cond_destroy(&w->wake);
+    pthread_mutex_destroy(&w->lock);
+    close(w->notify_fd);
+    w->notify_fd = -1;
+    return false;
+  }
+  w->running = true;
+  return true;
+}
+
+void render_worker_stop(render_worker_t* w) {
+  if (!w->running)
+    return;
+
+  pthread_mutex_lock(&w->lock);
+  w->stop = true;
+  pthread_cond_signal(&w->wake);
+  pthread_mutex_unlock(&w->lock);
+  pthread_join(w->thread, NULL);
+
+  render_job_free_list(w->queue_head);
+  render_job_free_list(w->done);
+  hash_map_destroy(&w->inflight);
+  pthread_cond_destroy(&w->wake);
+  pthread_mutex_destroy(&w->lock);
+  close(w->notify_fd);
+  memset(w, 0, sizeof(*w));
+  w->notify_fd = -1;
+}
+
+void render_worker_request(render_worker_t* w, title_cache_t* cache, const title_key_t* key) {
+  if (!w->running)
+    return;
+  uint64_t hash = title_key_hash(key);
+  if (hash_map_get(&w->inflight, hash))
+    return;
+
+  cairo_surface_t* surface = title_cache_acquire(cache, key->width, key->height);
+  if (!surface)
+    return;
+
+  // Snapshot the key: the caller's title string may change before we run
+  const char* font = key->font ? key->font : "";
+  const char* text = key->text ? key->text : "";
+  size_t font_len = strlen(font);
+  size_t text_len = strlen(text);
+  render_job_t* job = calloc(1, sizeof(*job));
+  char* buf = malloc(font_len + text_len + 2);
+  if (!job || !buf) {
+    LOG_ERROR("render worker job allocation failed");
+    abort();
+  }
+  memcpy(buf, font, font_len + 1);
+  memcpy(buf + font_len + 1, text, text_len + 1);
+  job->hash = hash;
+  job->key = *key;
+  job->key.font = buf;
+  job->key.text = buf + font_len + 1;
+  job->buf = buf;
+  job->surface = surface;
+  hash_map_insert(&w->inflight, hash, job);
+
+  pthread_mutex_lock(&w->lock);
+  if (w->queue_tail)
+    w->queue_tail->next = job;
+  else
+    w->queue_head = job;
+  w->queue_tail = job;
+  pthread_cond_signal(&w->wake);
+  pthread_mutex_unlock(&w->lock);
+}
+
+size_t render_worker_collect(render_worker_t* w, title_cache_t* cache) {
+  if (!w->running)
+    return 0;
+
+  pthread_mutex_lock(&w->lock);
+  render_job_t* done = w->done;
+  w->done = NULL;
+  uint64_t count;
+  if (read(w->notify_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    LOG_WARN("render worker notify read failed: %s", strerror(errno));
+  pthread_mutex_unlock(&w->lock);
+
+  size_t n = 0;
+  while (done) {
+    render_job_t* job = done;
+    done = job->next;
+    hash_map_remove(&w->inflight, job->hash);
+    if (job->ok) {
+      title_cache_insert(cache, &job->key, job->surface);
+      job->surface = NULL;
+    }
+    render_job_free(job);
+    n++;
+  }
+  return n;
+}
@@ -0,0 +1,320 @@
+/* rules.c - Compiled matcher for application rules */
+
+#include "rules.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "hxm.h"
+#include "str_intern.h"
+
+static void* rules_alloc(size_t n, size_t size) {
+  if (n == 0)
+    return NULL;
+  void* p = calloc(n, size);
+  if (!p) {
+    LOG_ERROR("rule set allocation failed");
+    abort();
+  }
+  return p;
+}
+
+// The intern table's hash, so interned subjects skip hashing altogether
+static uint64_t rules_hash(const char* s) {
+  return str_hash(s, strlen(s));
+}
+
+// Types past the mask width share the top bit; rule_matches tells them apart
+static uint32_t rules_type_bit(uint8_t type) {
+  return 1u << (type < 31 ? type : 31);
+}
+
+static int rule_key_cmp(const void* a, const void* b) {
+  const rule_key_t* ka = a;
+  const rule_key_t* kb = b;
+  if (ka->hash != kb->hash)
+    return ka->hash < kb->hash ? -1 : 1;
+  return (ka->rule > kb->rule) - (ka->rule < kb->rule);
+}
+
+static int rule_index_cmp(const void* a, const void* b) {
+  uint32_t va = *(const uint32_t*)a;
+  uint32_t vb = *(const uint32_t*)b;
+  return (va > vb) - (va < vb);
+}
+
+// Everything but class and instance
+static bool rule_matches_rest(const app_rule_t* r, const rule_subject_t* subj) {
+  if (r->title_match && (!subj->title || !strstr(subj->title, r->title_match)))
+    return false;
+  if (r->type_match != -1 && subj->type != (uint8_t)r->type_match)
+    return false;
+  if (r->transient_match != -1 && subj->transient != (bool)r->transient_match)
+    return false;
+  return true;
+}
+
+bool rule_matches(const app_rule_t* r, const rule_subject_t* subj) {
+  if (r->class_match && (!subj->wm_class || strcmp(subj->wm_class, r->class_match) != 0))
+    return false;
+  if (r->instance_match && (!subj->wm_instance || strcmp(subj->wm_instance, r->instance_match) != 0))
+    return false;
+  return rule_matches_rest(r, subj);
+}
+
+// rule_matches for a built rule, by pointer when subj is interned
+static bool rule_set_confirm(const rule_set_t* set, uint32_t rule, const rule_subject_t* subj) {
+  if (!subj->interned)
+    return rule_matches(set->rules[rule], subj);
+  if (set->class_ids[rule] && set->class_ids[rule] != subj->wm_class)
+    return false;
+  if (set->instance_ids[rule] && set->instance_ids[rule] != subj->wm_instance)
+    return false;
+  return rule_matches_rest(set->rules[rule], subj);
+}
+
+void rule_set_init(rule_set_t* set) {
+  memset(set, 0, sizeof(*set));
+}
+
+void rule_set_destroy(rule_set_t* set) {
+  for (size_t i = 0; set->class_ids && i < set->count; i++) {
+    str_intern_release(set->class_ids[i]);
+    str_intern_release(set->instance_ids[i]);
+  }
+  free(set->class_ids);
+  free(set->instance_ids);
+  free(set->rules);
+  free(set->by_class);
+  free(set->by_instance);
+  free(set->title_nodes);
+  free(set->title_next);
+  free(set->always);
+  free(set->filters);
+  free(set->live);
+  free(set->seen);
+  free(set->matches);
+  memset(set, 0, sizeof(*set));
+}
+
+static int32_t ac_child(const rule_set_t* set, int32_t node, uint8_t byte) {
+  for (int32_t c = set->title_nodes[node].child; c >= 0; c = set->title_nodes[c].sibling) {
+    if (set->title_nodes[c].byte == byte)
+      return c;
+  }
+  return -1;
+}
+
+static int32_t ac_insert(rule_set_t* set, size_t* cap, const char* pattern) {
+  int32_t node = 0;
+  for (const char* p = pattern; *p; p++) {
+    uint8_t byte = (uint8_t)*p;
+    int32_t next = ac_child(set, node, byte);
+    if (next < 0) {
+      if (set->title_node_count == *cap) {
+        *cap *= 2;
+        set->title_nodes = realloc(set->title_nodes, *cap * sizeof(*set->title_nodes));
+        if (!set->title_nodes) {
+          LOG_ERROR("rule set allocation failed");
+          abort();
+        }
+      }
+      next = (int32_t)set->title_node_count++;
+      set->title_nodes[next] = (rule_ac_node_t){
+          .child = -1, .sibling = set->title_nodes[node].child, .fail = 0, .out = -1, .dict = -1, .byte = byte};
+      set->title_nodes[node].child = next;
+    }
+    node = next;
+  }
+  return node;
+}
+
+// Breadth-first so every fail target is finished before its dependents
+static void ac_link(rule_set_t* set) {
+  int32_t* queue = rules_alloc(set->title_node_count, sizeof(*queue));
+  size_t head = 0, tail = 0;
+  for (int32_t c = set->title_nodes[0].child; c >= 0; c = set->title_nodes[c].sibling)
+    queue[tail++] = c;
+
+  while (head < tail) {
+    int32_t u = queue[head++];
+    for (int32_t v = set->title_nodes[u].child; v >= 0; v = set->title_nodes[v].sibling) {
+      uint8_t byte = set->title_nodes[v].byte;
+      int32_t f = set->title_nodes[u].fail;
+      int32_t to;
+      while ((to = ac_child(set, f, byte)) < 0 && f != 0)
+        f = set->title_nodes[f].fail;
+      int32_t fail = to >= 0 ? to : 0;
+      set->title_nodes[v].fail = fail;
+      set->title_nodes[v].dict = set->title_nodes[fail].out >= 0 ? fail : set->title_nodes[fail].dict;
+      queue[tail++] = v;
+    }
+  }
+  free(queue);
+}
+
+void rule_set_build(rule_set_t* set, const small_vec_t* rules) {
+  rule_set_destroy(set);
+  size_t n = rules ? rules->length : 0;
+  set->built = true;
+  if (n == 0)
+    return;
+
+  set->count = n;
+  set->rules = rules_alloc(n, sizeof(*set->rules));
+  memcpy(set->rules, rules->items, n * sizeof(*set->rules));
+  set->filters = rules_alloc(n, sizeof(*set->filters));
+  set->class_ids = rules_alloc(n, sizeof(*set->class_ids));
+  set->instance_ids = rules_alloc(n, sizeof(*set->instance_ids));
+  set->title_next = rules_alloc(n, sizeof(*set->title_next));
+  set->seen = rules_alloc(n, sizeof(*set->seen));
+  set->matches = rules_alloc(n, sizeof(*set->matches));
+  set->by_class = rules_alloc(n, sizeof(*set->by_class));
+  set->by_instance = rules_alloc(n, sizeof(*set->by_instance));
+  set->always = rules_alloc(n, sizeof(*set->always));
+  set->live = rules_alloc(n, sizeof(*set->live));
+
+  size_t node_cap = 64;
+  set->title_nodes = rules_alloc(node_cap, sizeof(*set->title_nodes));
+  set->title_nodes[0] = (rule_ac_node_t){.child = -1, .sibling = -1, .fail = 0, .out = -1, .dict = -1};
+  set->title_node_count = 1;
+
+  for (size_t i = 0; i < n; i++) {
+    const app_rule_t* r = set->rules[i];
+    uint32_t idx = (uint32_t)i;
+    rule_filter_t* f = &set->filters[i];
+
+    if (r->type_match == -1)
+      f->type_mask = UINT32_MAX;
+    else
+      f->type_mask = rules_type_bit((uint8_t)r->type_match);
+    f->transient_mask = r->transient_match == -1 ? 3u : (r->transient_match ? 2u : 1u);
+    f->deps = (r->class_match ? RULE_DEP_CLASS : 0) | (r->instance_match ? RULE_DEP_INSTANCE : 0) | (r->title_match ? RULE_DEP_TITLE : 0);
+    if (r->live && f->deps) {
+      set->live[set->live_count++] = idx;
+      set->live_deps |= f->deps;
+    }
+    set->title_next[i] = -1;
+    set->class_ids[i] = str_intern(r->class_match);
+    set->instance_ids[i] = str_intern(r->instance_match);
+
+    if (r->class_match) {
+      set->by_class[set->class_count++] = (rule_key_t){rules_hash(r->class_match), idx};
+    }
+    else if (r->instance_match) {
+      set->by_instance[set->instance_count++] = (rule_key_t){rules_hash(r->instance_match), idx};
+    }
+    else if (r->title_match && r->title_match[0]) {
+      int32_t node = ac_insert(set, &node_cap, r->title_match);
+      set->title_next[i] = set->title_nodes[node].out;
+      set->title_nodes[node].out = (int32_t)idx;
+    }
+    else {
+      set->always[set->always_count++] = idx;
+    }
+  }
+
+  qsort(set->by_class, set->class_count, sizeof(*set->by_class), rule_key_cmp);
+  qsort(set->by_instance, set->instance_count, sizeof(*set->by_instance), rule_key_cmp);
+  ac_link(set);
+}
+
+void rule_set_sync(rule_set_t* set, const small_vec_t* rules) {
+  size_t n = rules ? rules->length : 0;
+  if (set->built && set->count == n && (n == 0 || memcmp(set->rules, rules->items, n * sizeof(*set->rules)) == 0))
+    return;
+  rule_set_build(set, rules);
+}
+
+static void rule_set_consider(rule_set_t* set, uint32_t rule, const rule_subject_t* subj, uint32_t type_bit, uint8_t transient_bit) {
+  if (set->seen[rule] == set->epoch)
+    return;
+  set->seen[rule] = set->epoch;
+
+  const rule_filter_t* f = &set->filters[rule];
+  if (!(f->type_mask & type_bit) || !(f->transient_mask & transient_bit))
+    return;
+  if (!rule_set_confirm(set, rule, subj))
+    return;
+  set->matches[set->match_count++] = rule;
+}
+
+static void rule_set_probe(rule_set_t* set, const rule_key_t* keys, size_t count, const char* value, const rule_subject_t* subj,
+                           uint32_t type_bit, uint8_t transient_bit) {
+  if (!value || count == 0)
+    return;
+  uint64_t hash = subj->interned ? str_intern_hash(value) : rules_hash(value);
+
+  size_t lo = 0, hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (keys[mid].hash < hash)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for (; lo < count && keys[lo].hash == hash; lo++)
+    rule_set_consider(set, keys[lo].rule, subj, type_bit, transient_bit);
+}
+
+size_t rule_set_match(rule_set_t* set, const rule_subject_t* subj, const uint32_t** out) {
+  set->match_count = 0;
+  *out = set->matches;
+  if (set->count == 0)
+    return 0;
+
+  if (++set->epoch == 0) {
+    memset(set->seen, 0, set->count * sizeof(*set->seen));
+    set->epoch = 1;
+  }
+
+  uint32_t type_bit = rules_type_bit(subj->type);
+  uint8_t transient_bit = subj->transient ? 2u : 1u;
+
+  rule_set_probe(set, set->by_class, set->class_count, subj->wm_class, subj, type_bit, transient_bit);
+  rule_set_probe(set, set->by_instance, set->instance_count, subj->wm_instance, subj, type_bit, transient_bit);
+
+  if (subj->title && set->title_node_count > 1) {
+    int32_t node = 0;
+    for (const char* p = subj->title; *p; p++) {
+      uint8_t byte = (uint8_t)*p;
+      int32_t next;
+      while ((next = ac_child(set, node, byte)) < 0 && node != 0)
+        node = set->title_nodes[node].fail;
+      node = next >= 0 ? next : 0;
+
+      int32_t hit = set->title_nodes[node].out >= 0 ? node : set->title_nodes[node].dict;
+      for (; hit >= 0; hit = set->title_nodes[hit].dict) {
+        for (int32_t r = set->title_nodes[hit].out; r >= 0; r = set->title_next[r])
+          rule_set_consider(set, (uint32_t)r, subj, type_bit, transient_bit);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < set->always_count; i++)
+    rule_set_consider(set, set->always[i], subj, type_bit, transient_bit);
+
+  if (set->match_count > 1)
+    qsort(set->matches, set->match_count, sizeof(*set->matches), rule_index_cmp);
+  return set->match_count;
+}
+
+size_t rule_set_match_live(rule_set_t* set, const rule_subject_t* subj, uint8_t changed, const uint32_t** out) {
+  set->match_count = 0;
+  *out = set->matches;
+  if (!(set->live_deps & changed))
+    return 0;
+
+  uint32_t type_bit = rules_type_bit(subj->type);
+  uint8_t transient_bit = subj->transient ? 2u : 1u;
+  for (size_t i = 0; i < set->live_count; i++) {
+    uint32_t rule = set->live[i];
+    const rule_filter_t* f = &set->filters[rule];
+    if (!(f->deps & changed) || !(f->type_mask & type_bit) || !(f->transient_mask & transient_bit))
+      continue;
+    if (rule_set_confirm(set, rule, subj))
+      set->matches[set->match_count++] = rule;
+  }
+  return set->match_count;
+}
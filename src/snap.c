@@ -3,55 +3,184 @@
 #include "snap.h"
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-snap_candidate_t snap_compute_candidate(int px, int py, rect_t wa, int threshold_px) {
-  (void)py;  // Currently unused
+static int clamp_edge(int64_t v) {
+  return (v > INT32_MAX) ? INT32_MAX : (v < INT32_MIN ? INT32_MIN : (int)v);
+}
 
+static snap_candidate_t snap_tile(snap_edge_t edge, int x, int y, int w, int h) {
+  snap_candidate_t out;
+  out.active = true;
+  out.edge = edge;
+  out.rect.x = (int16_t)x;
+  out.rect.y = (int16_t)y;
+  out.rect.w = (uint16_t)w;
+  out.rect.h = (uint16_t)h;
+  return out;
+}
+
+snap_candidate_t snap_compute_candidate(int px, int py, rect_t wa, const snap_layout_t* layout) {
   snap_candidate_t out = {0};
   out.active = false;
   out.edge = SNAP_NONE;
   out.rect = wa;
 
-  if (wa.w < 2 || threshold_px <= 0)
+  if (!layout || wa.w < 2 || wa.h < 2 || layout->threshold_px <= 0)
     return out;
 
-  int thr = threshold_px;
-  if (thr < 0)
-    thr = 0;
-
-  int half = (int)(wa.w / 2);
-  if (half < 1)
+  uint32_t pct = layout->split_pct;
+  if (pct < 10 || pct > 90)
+    pct = 50;
+  int left_w = (int)((uint32_t)wa.w * pct / 100u);
+  int right_w = (int)wa.w - left_w;  // right gets the remainder
+  int half_h = (int)(wa.h / 2);
+  int bottom_h = (int)wa.h - half_h;
+  if (left_w < 1 || right_w < 1 || half_h < 1)
     return out;
 
-  // clamp threshold so left/right zones can't overlap
-  if (thr > half)
-    thr = half;
+  // clamp threshold so opposite zones can't overlap
+  int thr = layout->threshold_px;
+  if (thr > left_w)
+    thr = left_w;
+  if (thr > right_w)
+    thr = right_w;
+  if (thr > half_h)
+    thr = half_h;
 
+  int corner = layout->corner_px;
+  if (corner < 0)
+    corner = 0;
+  if (corner > half_h)
+    corner = half_h;
+
+  // compute far edges safely in 64-bit then clamp back
   int left_edge = (int)wa.x;
+  int top_edge = (int)wa.y;
+  int right_edge = clamp_edge((int64_t)wa.x + (int64_t)wa.w);
+  int bottom_edge = clamp_edge((int64_t)wa.y + (int64_t)wa.h);
 
-  // compute right edge safely in 64-bit then clamp back
-  int64_t right64 = (int64_t)wa.x + (int64_t)wa.w;
-  int right_edge = (right64 > INT32_MAX) ? INT32_MAX : (right64 < INT32_MIN ? INT32_MIN : (int)right64);
-
-  if (px <= left_edge + thr) {
-    out.active = true;
-    out.edge = SNAP_LEFT;
-    out.rect.x = wa.x;
-    out.rect.y = wa.y;
-    out.rect.w = (uint16_t)half;
-    out.rect.h = wa.h;
-    return out;
+  bool at_left = px <= left_edge + thr;
+  bool at_right = !at_left && px >= right_edge - thr;
+
+  if (at_left || at_right) {
+    int x = at_left ? wa.x : wa.x + left_w;
+    int w = at_left ? left_w : right_w;
+    if (corner > 0 && py <= top_edge + corner)
+      return snap_tile(at_left ? SNAP_TOP_LEFT : SNAP_TOP_RIGHT, x, wa.y, w, half_h);
+    if (corner > 0 && py >= bottom_edge - corner)
+      return snap_tile(at_left ? SNAP_BOTTOM_LEFT : SNAP_BOTTOM_RIGHT, x, wa.y + half_h, w, bottom_h);
+    return snap_tile(at_left ? SNAP_LEFT : SNAP_RIGHT, x, wa.y, w, wa.h);
   }
 
-  if (px >= right_edge - thr) {
-    out.active = true;
-    out.edge = SNAP_RIGHT;
-    out.rect.x = (int16_t)(wa.x + half);
-    out.rect.y = wa.y;
-    out.rect.w = (uint16_t)((int)wa.w - half);  // right gets the remainder when odd
-    out.rect.h = wa.h;
-    return out;
+  if (py <= top_edge + thr) {
+    // Corners reach along the top edge as well as down the sides
+    if (corner > 0 && px <= left_edge + corner)
+      return snap_tile(SNAP_TOP_LEFT, wa.x, wa.y, left_w, half_h);
+    if (corner > 0 && px >= right_edge - corner)
+      return snap_tile(SNAP_TOP_RIGHT, wa.x + left_w, wa.y, right_w, half_h);
+    if (layout->top_maximize)
+      return snap_tile(SNAP_TOP, wa.x, wa.y, wa.w, wa.h);
   }
 
   return out;
 }
+
+void snap_edges_clear(snap_edge_index_t* idx) {
+  idx->x_len = 0;
+  idx->y_len = 0;
+}
+
+void snap_edges_destroy(snap_edge_index_t* idx) {
+  free(idx->x);
+  free(idx->y);
+  memset(idx, 0, sizeof(*idx));
+}
+
+static bool snap_lines_push(snap_line_t** lines, size_t* len, size_t* cap, int32_t a, int32_t b, int32_t lo, int32_t hi) {
+  if (*len + 2 > *cap) {
+    size_t n = *cap ? *cap * 2 : 64;
+    snap_line_t* grown = realloc(*lines, n * sizeof(*grown));
+    if (!grown)
+      return false;
+    *lines = grown;
+    *cap = n;
+  }
+  (*lines)[(*len)++] = (snap_line_t){a, lo, hi};
+  (*lines)[(*len)++] = (snap_line_t){b, lo, hi};
+  return true;
+}
+
+bool snap_edges_add_rect(snap_edge_index_t* idx, rect_t r) {
+  if (r.w == 0 || r.h == 0)
+    return true;
+  int32_t x2 = (int32_t)r.x + r.w;
+  int32_t y2 = (int32_t)r.y + r.h;
+  return snap_lines_push(&idx->x, &idx->x_len, &idx->x_cap, r.x, x2, r.y, y2) && snap_lines_push(&idx->y, &idx->y_len, &idx->y_cap, r.y, y2, r.x, x2);
+}
+
+static int snap_line_cmp(const void* a, const void* b) {
+  int32_t pa = ((const snap_line_t*)a)->pos;
+  int32_t pb = ((const snap_line_t*)b)->pos;
+  return (pa > pb) - (pa < pb);
+}
+
+void snap_edges_sort(snap_edge_index_t* idx) {
+  if (idx->x_len > 1)
+    qsort(idx->x, idx->x_len, sizeof(*idx->x), snap_line_cmp);
+  if (idx->y_len > 1)
+    qsort(idx->y, idx->y_len, sizeof(*idx->y), snap_line_cmp);
+}
+
+/* First line with pos >= v */
+static size_t snap_lines_lower_bound(const snap_line_t* lines, size_t len, int32_t v) {
+  size_t lo = 0;
+  size_t hi = len;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (lines[mid].pos < v)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Closest line to either edge of [a, b] among those whose span meets [lo, hi] */
+static bool snap_lines_nearest(const snap_line_t* lines, size_t len, int32_t a, int32_t b, int32_t lo, int32_t hi, int dist, int32_t* out_delta) {
+  bool found = false;
+  int32_t best = 0;
+  int32_t edges[2] = {a, b};
+  for (int e = 0; e < 2; e++) {
+    for (size_t i = snap_lines_lower_bound(lines, len, edges[e] - dist); i < len && lines[i].pos <= edges[e] + dist; i++) {
+      if (lines[i].hi < lo || lines[i].lo > hi)
+        continue;
+      int32_t delta = lines[i].pos - edges[e];
+      if (!found || abs(delta) < abs(best)) {
+        best = delta;
+        found = true;
+      }
+    }
+  }
+  *out_delta = best;
+  return found;
+}
+
+rect_t snap_edges_attract(const snap_edge_index_t* idx, rect_t r, int dist_px) {
+  if (!idx || dist_px <= 0)
+    return r;
+
+  int32_t x1 = r.x;
+  int32_t y1 = r.y;
+  int32_t x2 = x1 + r.w;
+  int32_t y2 = y1 + r.h;
+  int32_t delta;
+
+  rect_t out = r;
+  if (snap_lines_nearest(idx->x, idx->x_len, x1, x2, y1, y2, dist_px, &delta))
+    out.x = (int16_t)(x1 + delta);
+  if (snap_lines_nearest(idx->y, idx->y_len, y1, y2, x1, x2, dist_px, &delta))
+    out.y = (int16_t)(y1 + delta);
+  return out;
+}
@@ -17,30 +17,64 @@ static void snap_preview_make_clickthrough(server_t* s) {
   xcb_shape_rectangles(s->conn, XCB_SHAPE_SO_SET, XCB_SHAPE_SK_INPUT, XCB_CLIP_ORDERING_UNSORTED, s->snap_preview_win, 0, 0, 0, NULL);
 }
 
-void snap_preview_init(server_t* s) {
-  if (!s || !s->conn)
+// bounding shape of just the border ring, so the interior shows what is below
+static void snap_preview_shape(server_t* s, uint32_t w, uint32_t h, bool hollow) {
+  if (!hollow && !s->snap_preview_shaped)
     return;
-  if (s->snap_preview_win != XCB_WINDOW_NONE)
+  const xcb_query_extension_reply_t* ext = xcb_get_extension_data(s->conn, &xcb_shape_id);
+  if (!ext || !ext->present)
     return;
 
+  if (!hollow) {
+    xcb_shape_mask(s->conn, XCB_SHAPE_SO_SET, XCB_SHAPE_SK_BOUNDING, s->snap_preview_win, 0, 0, XCB_PIXMAP_NONE);
+    s->snap_preview_shaped = false;
+    return;
+  }
+
+  int16_t b = (int16_t)s->snap_preview_border_px;
+  uint16_t ring_w = (uint16_t)(w + 2u * (uint32_t)b);
+  xcb_rectangle_t ring[4] = {
+      {(int16_t)-b, (int16_t)-b, ring_w, (uint16_t)b},
+      {(int16_t)-b, (int16_t)h, ring_w, (uint16_t)b},
+      {(int16_t)-b, 0, (uint16_t)b, (uint16_t)h},
+      {(int16_t)w, 0, (uint16_t)b, (uint16_t)h},
+  };
+  xcb_shape_rectangles(s->conn, XCB_SHAPE_SO_SET, XCB_SHAPE_SK_BOUNDING, XCB_CLIP_ORDERING_UNSORTED, s->snap_preview_win, 0, 0, 4, ring);
+  s->snap_preview_shaped = true;
+}
+
+// A window lives on one screen; the preview is created on the screen of the
+// drag that shows it
+static void snap_preview_create(server_t* s, uint32_t screen) {
+  const screen_t* scr = &s->screens[screen];
   s->snap_preview_win = xcb_generate_id(s->conn);
+  s->snap_preview_screen = screen;
 
   uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_BORDER_PIXEL | XCB_CW_OVERRIDE_REDIRECT;
   uint32_t values[3];
   values[0] = 0; /* background pixel */
 
   uint32_t border = s->snap_preview_color;
-  if (s->root_depth != 32)
+  if (scr->root_depth != 32)
     border &= 0x00FFFFFFu;
   values[1] = border; /* border pixel */
 
   values[2] = 1; /* override_redirect */
 
-  xcb_create_window(s->conn, s->root_depth, s->snap_preview_win, s->root, 0, 0, 1, 1, s->snap_preview_border_px, XCB_WINDOW_CLASS_INPUT_OUTPUT, s->root_visual, mask, values);
+  xcb_create_window(s->conn, scr->root_depth, s->snap_preview_win, scr->root, 0, 0, 1, 1, s->snap_preview_border_px, XCB_WINDOW_CLASS_INPUT_OUTPUT, scr->root_visual, mask, values);
 
   snap_preview_make_clickthrough(s);
 
   s->snap_preview_mapped = false;
+  s->snap_preview_shaped = false;
+}
+
+void snap_preview_init(server_t* s) {
+  if (!s || !s->conn)
+    return;
+  if (s->snap_preview_win != XCB_WINDOW_NONE)
+    return;
+  snap_preview_create(s, s->active_screen);
 }
 
 void snap_preview_destroy(server_t* s) {
@@ -53,9 +87,13 @@ void snap_preview_destroy(server_t* s) {
   }
 }
 
-void snap_preview_apply(server_t* s, const rect_t* rect, bool show) {
+void snap_preview_apply(server_t* s, const screen_t* scr, const rect_t* rect, bool show, bool hollow) {
   if (!s || s->snap_preview_win == XCB_WINDOW_NONE)
     return;
+  if (show && rect && scr && server_screen_index(s, scr) != s->snap_preview_screen) {
+    snap_preview_destroy(s);
+    snap_preview_create(s, server_screen_index(s, scr));
+  }
 
   if (!show || !rect) {
     if (s->snap_preview_mapped) {
@@ -88,10 +126,11 @@ void snap_preview_apply(server_t* s, const rect_t* rect, bool show) {
   values[i++] = XCB_STACK_MODE_ABOVE;
 
   xcb_configure_window(s->conn, s->snap_preview_win, mask, values);
+  snap_preview_shape(s, w, h, hollow);
 
   // keep border color in sync if config can change while running
   uint32_t border = s->snap_preview_color;
-  if (s->root_depth != 32)
+  if (s->screens[s->snap_preview_screen].root_depth != 32)
     border &= 0x00FFFFFFu;
   xcb_change_window_attributes(s->conn, s->snap_preview_win, XCB_CW_BORDER_PIXEL, &border);
 
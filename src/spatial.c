@@ -0,0 +1,234 @@
+/* spatial.c - Uniform grid over client frame rectangles */
+
+#include "spatial.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hxm.h"
+
+typedef struct spatial_item {
+  handle_t h;
+  rect_t rect;
+} spatial_item_t;
+
+typedef struct spatial_cell {
+  spatial_item_t* items;
+  uint32_t length;
+  uint32_t capacity;
+} spatial_cell_t;
+
+/* Inclusive cell span covered by a rect */
+typedef struct spatial_span {
+  int32_t x0, y0, x1, y1;
+} spatial_span_t;
+
+static inline int32_t spatial_cell_coord(int32_t v) {
+  // Floor division keeps negative coordinates in their own cells
+  return (int32_t)((v - (v < 0 ? (1 << SPATIAL_CELL_SHIFT) - 1 : 0)) / (1 << SPATIAL_CELL_SHIFT));
+}
+
+static inline uint64_t spatial_cell_key(int32_t cx, int32_t cy) {
+  // Top bit set so the key is never the reserved 0
+  return (1ull << 63) | ((uint64_t)((uint32_t)cx & 0x7FFFFFFFu) << 32) | (uint64_t)(uint32_t)cy;
+}
+
+static inline bool spatial_rect_empty(rect_t r) {
+  return r.w == 0 || r.h == 0;
+}
+
+static inline bool spatial_rect_equal(rect_t a, rect_t b) {
+  return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+static inline spatial_span_t spatial_span_of(rect_t r) {
+  spatial_span_t sp;
+  sp.x0 = spatial_cell_coord(r.x);
+  sp.y0 = spatial_cell_coord(r.y);
+  sp.x1 = spatial_cell_coord((int32_t)r.x + (int32_t)r.w - 1);
+  sp.y1 = spatial_cell_coord((int32_t)r.y + (int32_t)r.h - 1);
+  return sp;
+}
+
+static inline bool spatial_rect_contains(rect_t r, int32_t x, int32_t y) {
+  return x >= r.x && y >= r.y && x < (int32_t)r.x + (int32_t)r.w && y < (int32_t)r.y + (int32_t)r.h;
+}
+
+static inline bool spatial_rect_intersects(rect_t a, rect_t b) {
+  return (int32_t)a.x < (int32_t)b.x + (int32_t)b.w && (int32_t)b.x < (int32_t)a.x + (int32_t)a.w && (int32_t)a.y < (int32_t)b.y + (int32_t)b.h &&
+         (int32_t)b.y < (int32_t)a.y + (int32_t)a.h;
+}
+
+void spatial_index_init(spatial_index_t* idx) {
+  hash_map_init(&idx->cells);
+  hash_map_init(&idx->entries);
+}
+
+void spatial_index_destroy(spatial_index_t* idx) {
+  size_t cursor = 0;
+  uint64_t key;
+  void* value;
+  while (hash_map_next(&idx->cells, &cursor, &key, &value)) {
+    spatial_cell_t* cell = (spatial_cell_t*)value;
+    free(cell->items);
+    free(cell);
+  }
+  cursor = 0;
+  while (hash_map_next(&idx->entries, &cursor, &key, &value))
+    free(value);
+  hash_map_destroy(&idx->cells);
+  hash_map_destroy(&idx->entries);
+}
+
+static void spatial_cell_push(spatial_cell_t* cell, spatial_item_t item) {
+  if (cell->length == cell->capacity) {
+    uint32_t cap = cell->capacity ? cell->capacity * 2u : 4u;
+    spatial_item_t* items = (spatial_item_t*)realloc(cell->items, (size_t)cap * sizeof(*items));
+    if (!items) {
+      LOG_ERROR("spatial cell allocation failed");
+      abort();
+    }
+    cell->items = items;
+    cell->capacity = cap;
+  }
+  cell->items[cell->length++] = item;
+}
+
+static void spatial_cells_insert(spatial_index_t* idx, handle_t h, rect_t rect) {
+  spatial_span_t sp = spatial_span_of(rect);
+  for (int32_t cy = sp.y0; cy <= sp.y1; cy++) {
+    for (int32_t cx = sp.x0; cx <= sp.x1; cx++) {
+      uint64_t key = spatial_cell_key(cx, cy);
+      spatial_cell_t* cell = (spatial_cell_t*)hash_map_get(&idx->cells, key);
+      if (!cell) {
+        cell = (spatial_cell_t*)calloc(1, sizeof(*cell));
+        if (!cell) {
+          LOG_ERROR("spatial cell allocation failed");
+          abort();
+        }
+        hash_map_insert(&idx->cells, key, cell);
+      }
+      spatial_cell_push(cell, (spatial_item_t){h, rect});
+    }
+  }
+}
+
+static void spatial_cells_remove(spatial_index_t* idx, handle_t h, rect_t rect) {
+  spatial_span_t sp = spatial_span_of(rect);
+  for (int32_t cy = sp.y0; cy <= sp.y1; cy++) {
+    for (int32_t cx = sp.x0; cx <= sp.x1; cx++) {
+      uint64_t key = spatial_cell_key(cx, cy);
+      spatial_cell_t* cell = (spatial_cell_t*)hash_map_get(&idx->cells, key);
+      if (!cell)
+        continue;
+      for (uint32_t i = 0; i < cell->length; i++) {
+        if (cell->items[i].h == h) {
+          cell->items[i] = cell->items[--cell->length];
+          break;
+        }
+      }
+      if (cell->length == 0) {
+        hash_map_remove(&idx->cells, key);
+        free(cell->items);
+        free(cell);
+      }
+    }
+  }
+}
+
+bool spatial_index_update(spatial_index_t* idx, handle_t h, rect_t rect) {
+  if (!idx || h == HANDLE_INVALID)
+    return false;
+
+  rect_t* cur = (rect_t*)hash_map_get(&idx->entries, (uint64_t)h);
+  if (spatial_rect_empty(rect)) {
+    if (!cur)
+      return false;
+    spatial_index_remove(idx, h);
+    return true;
+  }
+  if (cur && spatial_rect_equal(*cur, rect))
+    return false;
+
+  if (cur) {
+    spatial_cells_remove(idx, h, *cur);
+  }
+  else {
+    cur = (rect_t*)malloc(sizeof(*cur));
+    if (!cur) {
+      LOG_ERROR("spatial entry allocation failed");
+      abort();
+    }
+    hash_map_insert(&idx->entries, (uint64_t)h, cur);
+  }
+  *cur = rect;
+  spatial_cells_insert(idx, h, rect);
+  return true;
+}
+
+void spatial_index_remove(spatial_index_t* idx, handle_t h) {
+  if (!idx || h == HANDLE_INVALID)
+    return;
+  rect_t* cur = (rect_t*)hash_map_get(&idx->entries, (uint64_t)h);
+  if (!cur)
+    return;
+  spatial_cells_remove(idx, h, *cur);
+  hash_map_remove(&idx->entries, (uint64_t)h);
+  free(cur);
+}
+
+bool spatial_index_get(const spatial_index_t* idx, handle_t h, rect_t* out) {
+  if (!idx || h == HANDLE_INVALID)
+    return false;
+  const rect_t* cur = (const rect_t*)hash_map_get(&idx->entries, (uint64_t)h);
+  if (!cur)
+    return false;
+  if (out)
+    *out = *cur;
+  return true;
+}
+
+size_t spatial_index_query_point(const spatial_index_t* idx, int32_t x, int32_t y, handle_vec_t* out) {
+  if (!idx || !out)
+    return 0;
+  const spatial_cell_t* cell = (const spatial_cell_t*)hash_map_get(&idx->cells, spatial_cell_key(spatial_cell_coord(x), spatial_cell_coord(y)));
+  if (!cell)
+    return 0;
+
+  size_t found = 0;
+  for (uint32_t i = 0; i < cell->length; i++) {
+    const spatial_item_t* it = &cell->items[i];
+    if (spatial_rect_contains(it->rect, x, y)) {
+      handle_vec_push(out, it->h);
+      found++;
+    }
+  }
+  return found;
+}
+
+size_t spatial_index_query_rect(const spatial_index_t* idx, rect_t r, handle_vec_t* out) {
+  if (!idx || !out || spatial_rect_empty(r))
+    return 0;
+
+  spatial_span_t q = spatial_span_of(r);
+  size_t found = 0;
+  for (int32_t cy = q.y0; cy <= q.y1; cy++) {
+    for (int32_t cx = q.x0; cx <= q.x1; cx++) {
+      const spatial_cell_t* cell = (const spatial_cell_t*)hash_map_get(&idx->cells, spatial_cell_key(cx, cy));
+      if (!cell)
+        continue;
+      for (uint32_t i = 0; i < cell->length; i++) {
+        const spatial_item_t* it = &cell->items[i];
+        if (!spatial_rect_intersects(it->rect, r))
+          continue;
+        // Report each rect only from the first cell shared by both spans
+        spatial_span_t e = spatial_span_of(it->rect);
+        if (cx != (e.x0 > q.x0 ? e.x0 : q.x0) || cy != (e.y0 > q.y0 ? e.y0 : q.y0))
+          continue;
+        handle_vec_push(out, it->h);
+        found++;
+      }
+    }
+  }
+  return found;
+}
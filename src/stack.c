@@ -4,12 +4,21 @@
  * Model:
  *  - Layered Stacking: Windows are grouped into semantic layers (Desktop,
  * Below, Normal, Above, Fullscreen, etc).
- *  - Internal Authority: The `s->layers` vectors are the single source of truth
- * for stacking order.
+ *  - Internal Authority: The `layers` vectors of each screen are the single
+ * source of truth for stacking order. A client is stacked among the clients
+ * of its own screen only.
  *  - Deferred Synchronization: Changes to the internal list mark clients as
  * `DIRTY_STACK`. The actual X11 `ConfigureWindow` requests are issued in
- * `stack_sync_to_xcb` during the flush phase, preventing "fighting" with the X
- * server and reducing round-trips.
+ * `stack_commit_to_xcb` during the flush phase, as a minimal diff against the
+ * order last committed to the X server.
+ *  - Order Labels: Each layer vector is sorted by `stacking_label`, a sparse
+ * 32-bit key. Inserting takes a label between the neighbours' labels, so no
+ * other client is rewritten; only when a gap runs out is the layer relabeled.
+ * `stacking_index` is a position hint that goes stale when neighbours move and
+ * is repaired lazily by a binary search on labels.
+ *  - Transient Groups: raising or lowering a client carries its transients
+ * along. The group comes from `s->transients` (pre-order, see
+ * transient_groups.h) and moves as one contiguous run of its layer.
  */
 #include <assert.h>
 #include <stddef.h>
@@ -25,45 +34,124 @@
 /* Forward */
 static void stack_restack(server_t* s, handle_t h);
 
-static inline small_vec_t* layer_vec(server_t* s, int layer) {
+static inline handle_vec_t* layer_vec(server_t* s, const client_hot_t* c, int layer) {
   if (!s || layer < 0 || layer >= LAYER_COUNT)
     return NULL;
-  return &s->layers[layer];
+  return &client_screen(s, c)->layers[layer];
 }
 
-static inline void mark_stacking_dirty(server_t* s) {
-  s->root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
+static inline void mark_stacking_dirty(server_t* s, const client_hot_t* c) {
+  client_screen(s, c)->root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
 }
 
-static inline bool stack_index_valid(const small_vec_t* v, handle_t h, int32_t idx) {
+static inline bool stack_index_valid(const handle_vec_t* v, handle_t h, int32_t idx) {
   if (!v || idx < 0 || (size_t)idx >= v->length)
     return false;
-  return ptr_to_handle(v->items[idx]) == h;
+  return v->items[idx] == h;
 }
 
-static int32_t stack_find_index(const small_vec_t* v, handle_t h) {
+static int32_t stack_find_index(const handle_vec_t* v, handle_t h) {
   if (!v)
     return -1;
   for (size_t i = 0; i < v->length; i++) {
-    if (ptr_to_handle(v->items[i]) == h)
+    if (v->items[i] == h)
       return (int32_t)i;
   }
   return -1;
 }
 
-static int32_t stack_resolve_index(const small_vec_t* v, handle_t h, int32_t hint) {
-  if (!v)
+/* Spacing for fresh labels; relabeling keeps at least a third of the label
+ * space free on each side so top/bottom inserts stay O(1) for many ops */
+#define STACK_LABEL_GAP (1u << 16)
+
+static inline uint32_t stack_label_at(server_t* s, const handle_vec_t* v, size_t i) {
+  client_hot_t* c = server_chot(s, v->items[i]);
+  return c ? c->stacking_label : 0;
+}
+
+/* Position of c in v: the hint if still valid, else a label search */
+static int32_t stack_resolve_index(server_t* s, const handle_vec_t* v, client_hot_t* c) {
+  if (!v || !c)
     return -1;
-  if (stack_index_valid(v, h, hint))
-    return hint;
-  return stack_find_index(v, h);
+  if (stack_index_valid(v, c->self, c->stacking_index))
+    return c->stacking_index;
+
+  size_t lo = 0;
+  size_t hi = v->length;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (stack_label_at(s, v, mid) < c->stacking_label)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo < v->length && v->items[lo] == c->self) {
+    c->stacking_index = (int32_t)lo;
+    return (int32_t)lo;
+  }
+
+  // Labels out of sync (should not happen); fall back to a scan
+  int32_t idx = stack_find_index(v, c->self);
+  if (idx >= 0)
+    c->stacking_index = idx;
+  return idx;
+}
+
+/* Evenly respace every label in the layer, centred in the label space */
+static void stack_relabel(server_t* s, handle_vec_t* v) {
+  uint64_t n = v->length;
+  uint64_t step = STACK_LABEL_GAP;
+  if (n * step * 3u > UINT32_MAX)
+    step = n ? (UINT32_MAX / (3u * n)) : 1u;
+  if (step == 0)
+    step = 1;
+  uint64_t label = (1ull << 31) - (n * step) / 2u;
+
+  for (size_t i = 0; i < v->length; i++) {
+    client_hot_t* c = server_chot(s, v->items[i]);
+    if (c) {
+      c->stacking_label = (uint32_t)label;
+      c->stacking_index = (int32_t)i;
+    }
+    label += step;
+  }
+}
+
+/* Pick a label for a client about to sit at position idx, or return false if
+ * the neighbours leave no room */
+static bool stack_label_between(server_t* s, const handle_vec_t* v, size_t idx, uint32_t* out) {
+  if (v->length == 0) {
+    *out = 1u << 31;
+    return true;
+  }
+  if (idx >= v->length) {
+    uint32_t below = stack_label_at(s, v, v->length - 1);
+    if (UINT32_MAX - below < 2)
+      return false;
+    *out = (UINT32_MAX - below > STACK_LABEL_GAP) ? below + STACK_LABEL_GAP : below + (UINT32_MAX - below) / 2u;
+    return true;
+  }
+  if (idx == 0) {
+    uint32_t above = stack_label_at(s, v, 0);
+    if (above < 2)
+      return false;
+    *out = (above > STACK_LABEL_GAP) ? above - STACK_LABEL_GAP : above / 2u;
+    return true;
+  }
+  uint32_t below = stack_label_at(s, v, idx - 1);
+  uint32_t above = stack_label_at(s, v, idx);
+  if (above <= below || above - below < 2)
+    return false;
+  *out = below + (above - below) / 2u;
+  return true;
 }
 
-static bool stack_locate_any_layer(server_t* s, handle_t h, int* layer_out, int32_t* idx_out) {
+static bool stack_locate_any_layer(server_t* s, const client_hot_t* c, int* layer_out, int32_t* idx_out) {
   if (!s)
     return false;
+  handle_t h = c->self;
   for (int l = 0; l < LAYER_COUNT; l++) {
-    small_vec_t* v = layer_vec(s, l);
+    handle_vec_t* v = layer_vec(s, c, l);
     if (!v || v->length == 0)
       continue;
     int32_t idx = stack_find_index(v, h);
@@ -88,58 +176,42 @@ bool stack_can_anchor_to_sibling(server_t* s, handle_t h, handle_t sibling_h) {
     return false;
 
   int layer = stack_current_layer(c);
-  if (layer != stack_current_layer(sib))
+  if (layer != stack_current_layer(sib) || c->screen != sib->screen)
     return false;
 
-  small_vec_t* v = layer_vec(s, layer);
+  handle_vec_t* v = layer_vec(s, c, layer);
   if (!v || v->length == 0)
     return false;
 
-  int32_t idx = stack_resolve_index(v, h, c->stacking_index);
-  if (idx < 0)
+  if (stack_resolve_index(s, v, c) < 0)
     return false;
-  c->stacking_index = idx;
-
-  int32_t sib_idx = stack_resolve_index(v, sibling_h, sib->stacking_index);
-  if (sib_idx < 0)
+  if (stack_resolve_index(s, v, sib) < 0)
     return false;
-  sib->stacking_index = sib_idx;
   return true;
 }
 
-static void stack_update_indices(server_t* s, const small_vec_t* v, size_t start) {
-  for (size_t i = start; i < v->length; i++) {
-    handle_t h = ptr_to_handle(v->items[i]);
-    client_hot_t* hot = server_chot(s, h);
-    if (hot)
-      hot->stacking_index = (int32_t)i;
-  }
-}
-
-static void stack_vec_insert(server_t* s, small_vec_t* v, size_t idx, handle_t h) {
+/* Insert c at idx; only c's label and hint are written (amortized O(1)) */
+static void stack_vec_insert(server_t* s, handle_vec_t* v, size_t idx, client_hot_t* c) {
   if (!v)
     return;
   if (idx > v->length)
     idx = v->length;
-  small_vec_push(v, NULL);
-  if (idx + 1 < v->length) {
-    memmove(&v->items[idx + 1], &v->items[idx], (v->length - 1 - idx) * sizeof(void*));
+  uint32_t label;
+  if (!stack_label_between(s, v, idx, &label)) {
+    stack_relabel(s, v);
+    bool ok = stack_label_between(s, v, idx, &label);
+    assert(ok);
+    (void)ok;
   }
-  v->items[idx] = handle_to_ptr(h);
-  stack_update_indices(s, v, idx);
+  handle_vec_insert(v, idx, c->self);
+  c->stacking_label = label;
+  c->stacking_index = (int32_t)idx;
 }
 
-static bool stack_vec_remove(server_t* s, small_vec_t* v, size_t idx) {
+static bool stack_vec_remove(handle_vec_t* v, size_t idx) {
   if (!v || idx >= v->length)
     return false;
-  if (idx + 1 < v->length) {
-    memmove(&v->items[idx], &v->items[idx + 1], (v->length - idx - 1) * sizeof(void*));
-  }
-  v->length--;
-  v->items[v->length] = NULL;
-  if (idx < v->length) {
-    stack_update_indices(s, v, idx);
-  }
+  handle_vec_remove_at(v, idx);
   return true;
 }
 
@@ -155,19 +227,19 @@ void stack_remove(server_t* s, handle_t h) {
     return;
 
   int layer = c->stacking_layer;
-  small_vec_t* v = layer_vec(s, layer);
-  int32_t idx = stack_resolve_index(v, h, c->stacking_index);
+  handle_vec_t* v = layer_vec(s, c, layer);
+  int32_t idx = stack_resolve_index(s, v, c);
 
   if (idx < 0) {
     int real_layer = -1;
     int32_t real_idx = -1;
-    if (!stack_locate_any_layer(s, h, &real_layer, &real_idx)) {
+    if (!stack_locate_any_layer(s, c, &real_layer, &real_idx)) {
       c->stacking_index = -1;
       c->stacking_layer = -1;
       return;
     }
     layer = real_layer;
-    v = layer_vec(s, layer);
+    v = layer_vec(s, c, layer);
     idx = real_idx;
     if (!v || idx < 0) {
       c->stacking_index = -1;
@@ -179,11 +251,11 @@ void stack_remove(server_t* s, handle_t h) {
   TRACE_LOG("stack_remove h=%lx layer=%d index=%d", h, layer, idx);
   TRACE_ONLY(diag_dump_layer(s, layer, "before remove"));
 
-  stack_vec_remove(s, v, (size_t)idx);
+  stack_vec_remove(v, (size_t)idx);
   c->stacking_index = -1;
   c->stacking_layer = -1;
 
-  mark_stacking_dirty(s);
+  mark_stacking_dirty(s, c);
   TRACE_ONLY(diag_dump_layer(s, layer, "after remove"));
 }
 
@@ -196,49 +268,138 @@ static xcb_window_t stack_window_xid(const client_hot_t* c) {
 }
 
 static void stack_insert_top(server_t* s, client_hot_t* c, int layer) {
-  small_vec_t* v = layer_vec(s, layer);
+  handle_vec_t* v = layer_vec(s, c, layer);
   if (!v)
     return;
-  stack_vec_insert(s, v, v->length, c->self);
+  stack_vec_insert(s, v, v->length, c);
   c->stacking_layer = (int8_t)layer;
-  c->stacking_index = (int32_t)(v->length - 1);
-  mark_stacking_dirty(s);
+  mark_stacking_dirty(s, c);
 }
 
 static void stack_insert_bottom(server_t* s, client_hot_t* c, int layer) {
-  small_vec_t* v = layer_vec(s, layer);
+  handle_vec_t* v = layer_vec(s, c, layer);
   if (!v)
     return;
-  stack_vec_insert(s, v, 0, c->self);
+  stack_vec_insert(s, v, 0, c);
   c->stacking_layer = (int8_t)layer;
-  c->stacking_index = 0;
-  mark_stacking_dirty(s);
+  mark_stacking_dirty(s, c);
 }
 
-static void stack_raise_transient_children(server_t* s, handle_t parent_h) {
-  for (size_t i = 0; i < s->active_clients.length; i++) {
-    handle_t child_h = ptr_to_handle(s->active_clients.items[i]);
-    if (child_h == parent_h)
-      continue;
+/* Marks a group member being spliced out of its layer; real hints are >= -1 */
+#define STACK_SPLICE_MARK (-2)
+
+static handle_t stack_transient_parent(void* user, handle_t h) {
+  client_hot_t* c = server_chot((server_t*)user, h);
+  return c ? c->transient_for : HANDLE_INVALID;
+}
 
-    client_hot_t* child = server_chot(s, child_h);
-    assert(child);
-    if (child->transient_for == parent_h)
-      stack_raise(s, child_h);
+/* h and its transient descendants, h first; rebuilds the layout if stale */
+static size_t stack_transient_group(server_t* s, handle_t h, const handle_t** out) {
+  if (!s->transients.valid)
+    transient_groups_build(&s->transients, s->active_clients.items, s->active_clients.length, stack_transient_parent, s);
+  return transient_groups_subtree(&s->transients, h, out);
+}
+
+/*
+ * Label the run v[from, from + n) between its neighbours, spaced like fresh
+ * inserts; relabels the layer when the gap is too narrow.
+ */
+static void stack_label_run(server_t* s, handle_vec_t* v, size_t from, size_t n) {
+  uint64_t below = from > 0 ? stack_label_at(s, v, from - 1) : 0;
+  uint64_t above = from + n < v->length ? stack_label_at(s, v, from + n) : (uint64_t)UINT32_MAX + 1u;
+  uint64_t room = above > below ? (above - below) / (n + 1u) : 0;
+  if (room == 0) {
+    stack_relabel(s, v);
+    return;
+  }
+  uint64_t step = room < STACK_LABEL_GAP ? room : STACK_LABEL_GAP;
+
+  // Hug the side that already has a neighbour; an empty layer starts centred
+  uint64_t label;
+  if (from > 0)
+    label = below + step;
+  else if (from + n < v->length)
+    label = above - step * n;
+  else
+    label = (1ull << 31) - (n * step) / 2u;
+
+  for (size_t i = from; i < from + n; i++, label += step) {
+    client_hot_t* c = server_chot(s, v->items[i]);
+    if (c) {
+      c->stacking_label = (uint32_t)label;
+      c->stacking_index = (int32_t)i;
+    }
   }
 }
 
-static void stack_lower_transient_children(server_t* s, handle_t parent_h) {
-  for (size_t i = 0; i < s->active_clients.length; i++) {
-    handle_t child_h = ptr_to_handle(s->active_clients.items[i]);
-    if (child_h == parent_h)
+/*
+ * Move a transient group (head first, pre-order) to the top or bottom of the
+ * head's layer, keeping its order: head lowest, each dialog above the window
+ * it belongs to. Members sitting in the layer come out in one compaction pass
+ * and go back as one contiguous run. Members whose own layer differs (an
+ * always-on-top dialog) move within their layer, one at a time.
+ */
+static void stack_splice_group(server_t* s, const handle_t* group, size_t n, bool top) {
+  client_hot_t* head = server_chot(s, group[0]);
+  int layer = stack_current_layer(head);
+  handle_vec_t* v = layer_vec(s, head, layer);
+  if (!v)
+    return;
+
+  size_t run = 0;
+  for (size_t i = 0; i < n; i++) {
+    client_hot_t* c = server_chot(s, group[i]);
+    if (!c || stack_current_layer(c) != layer || c->screen != head->screen)
       continue;
+    if (c->stacking_layer == layer && stack_resolve_index(s, v, c) >= 0)
+      c->stacking_index = STACK_SPLICE_MARK;
+    else
+      stack_remove(s, group[i]);
+    run++;
+  }
 
-    client_hot_t* child = server_chot(s, child_h);
-    assert(child);
-    if (child->transient_for == parent_h)
-      stack_lower(s, child_h);
+  size_t kept = 0;
+  for (size_t i = 0; i < v->length; i++) {
+    client_hot_t* c = server_chot(s, v->items[i]);
+    if (c && c->stacking_index == STACK_SPLICE_MARK)
+      continue;
+    v->items[kept++] = v->items[i];
+  }
+  v->length = kept;
+
+  handle_vec_reserve(v, kept + run);
+  size_t from = top ? kept : 0;
+  if (!top)
+    memmove(&v->items[run], &v->items[0], kept * sizeof(v->items[0]));
+  v->length = kept + run;
+  size_t at = from;
+  for (size_t i = 0; i < n; i++) {
+    client_hot_t* c = server_chot(s, group[i]);
+    if (!c || stack_current_layer(c) != layer || c->screen != head->screen)
+      continue;
+    v->items[at++] = group[i];
+    c->stacking_layer = (int8_t)layer;
+  }
+  stack_label_run(s, v, from, run);
+  TRACE_ONLY(diag_dump_layer(s, layer, top ? "after group raise" : "after group lower"));
+
+  for (size_t k = 0; k < n; k++) {
+    // Bottom inserts stack up in reverse, so walk the group backwards
+    size_t i = top ? k : n - 1u - k;
+    client_hot_t* c = server_chot(s, group[i]);
+    if (!c)
+      continue;
+    int own = stack_current_layer(c);
+    if (own != layer || c->screen != head->screen) {
+      stack_remove(s, group[i]);
+      if (top)
+        stack_insert_top(s, c, own);
+      else
+        stack_insert_bottom(s, c, own);
+    }
+    stack_restack(s, group[i]);
   }
+  mark_stacking_dirty(s, head);
 }
 
 void stack_raise(server_t* s, handle_t h) {
@@ -252,14 +413,19 @@ void stack_raise(server_t* s, handle_t h) {
   int layer = stack_current_layer(c);
   TRACE_LOG("stack_raise h=%lx layer=%d", h, layer);
 
+  /* Transients go on top of their parent, in one splice */
+  const handle_t* group = NULL;
+  size_t n = stack_transient_group(s, h, &group);
+  if (n > 1) {
+    stack_splice_group(s, group, n, true);
+    return;
+  }
+
   stack_remove(s, h);
   stack_insert_top(s, c, layer);
   TRACE_ONLY(diag_dump_layer(s, layer, "after raise"));
 
   stack_restack(s, h);
-
-  /* Raise transients on top of parent. */
-  stack_raise_transient_children(s, h);
 }
 
 void stack_move_to_layer(server_t* s, handle_t h) {
@@ -288,9 +454,13 @@ void stack_lower(server_t* s, handle_t h) {
   int layer = stack_current_layer(c);
   TRACE_LOG("stack_lower h=%lx layer=%d", h, layer);
 
-  /* Lower transients first so they remain above the parent after the parent is
-   * lowered. */
-  stack_lower_transient_children(s, h);
+  /* Transients stay above the parent: the whole group goes to the bottom */
+  const handle_t* group = NULL;
+  size_t n = stack_transient_group(s, h, &group);
+  if (n > 1) {
+    stack_splice_group(s, group, n, false);
+    return;
+  }
 
   stack_remove(s, h);
   stack_insert_bottom(s, c, layer);
@@ -315,29 +485,26 @@ void stack_place_above(server_t* s, handle_t h, handle_t sibling_h) {
   TRACE_LOG("stack_place_above h=%lx sib=%lx layer=%d", h, sibling_h, layer);
 
   /* Different lists means no meaningful "immediately above" */
-  if (layer != sib_layer) {
+  if (layer != sib_layer || c->screen != sib->screen) {
     stack_raise(s, h);
     return;
   }
 
   stack_remove(s, h);
 
-  small_vec_t* v = layer_vec(s, layer);
+  handle_vec_t* v = layer_vec(s, c, layer);
   if (!v)
     return;
 
-  int32_t sib_idx = stack_resolve_index(v, sibling_h, sib->stacking_index);
+  int32_t sib_idx = stack_resolve_index(s, v, sib);
   if (sib_idx < 0) {
     stack_raise(s, h);
     return;
   }
-  sib->stacking_index = sib_idx;
 
-  size_t new_idx = (size_t)sib_idx + 1;
-  stack_vec_insert(s, v, new_idx, h);
+  stack_vec_insert(s, v, (size_t)sib_idx + 1, c);
   c->stacking_layer = (int8_t)layer;
-  c->stacking_index = (int32_t)new_idx;
-  mark_stacking_dirty(s);
+  mark_stacking_dirty(s, c);
   TRACE_ONLY(diag_dump_layer(s, layer, "after place_above"));
 
   stack_restack(s, h);
@@ -358,160 +525,194 @@ void stack_place_below(server_t* s, handle_t h, handle_t sibling_h) {
   int sib_layer = stack_current_layer(sib);
   TRACE_LOG("stack_place_below h=%lx sib=%lx layer=%d", h, sibling_h, layer);
 
-  if (layer != sib_layer) {
+  if (layer != sib_layer || c->screen != sib->screen) {
     stack_lower(s, h);
     return;
   }
 
   stack_remove(s, h);
 
-  small_vec_t* v = layer_vec(s, layer);
+  handle_vec_t* v = layer_vec(s, c, layer);
   if (!v)
     return;
 
-  int32_t sib_idx = stack_resolve_index(v, sibling_h, sib->stacking_index);
+  int32_t sib_idx = stack_resolve_index(s, v, sib);
   if (sib_idx < 0) {
     stack_lower(s, h);
     return;
   }
-  sib->stacking_index = sib_idx;
 
-  size_t new_idx = (size_t)sib_idx;
-  stack_vec_insert(s, v, new_idx, h);
+  stack_vec_insert(s, v, (size_t)sib_idx, c);
   c->stacking_layer = (int8_t)layer;
-  c->stacking_index = (int32_t)new_idx;
-  mark_stacking_dirty(s);
+  mark_stacking_dirty(s, c);
   TRACE_ONLY(diag_dump_layer(s, layer, "after place_below"));
 
   stack_restack(s, h);
 }
 
-static xcb_window_t find_window_below(server_t* s, client_hot_t* c) {
-  /* Same layer: previous node is immediately below */
-  int layer = stack_current_layer(c);
-  small_vec_t* v = layer_vec(s, layer);
-  if (v) {
-    int32_t idx = stack_resolve_index(v, c->self, c->stacking_index);
-    if (idx > 0) {
-      c->stacking_index = idx;
-      handle_t below_h = ptr_to_handle(v->items[idx - 1]);
-      client_hot_t* below = server_chot(s, below_h);
-      xcb_window_t win = stack_window_xid(below);
-      if (win != XCB_NONE)
-        return win;
-    }
-  }
+/* Clients that take part in X stacking: managed, not being torn down */
+static bool stack_committable(const client_hot_t* c) {
+  if (!c || stack_window_xid(c) == XCB_NONE)
+    return false;
+  return c->state != STATE_NEW && c->state != STATE_UNMANAGING && c->state != STATE_DESTROYED;
+}
 
-  /* Lower layers: topmost of the nearest non-empty lower layer */
-  for (int l = layer - 1; l >= 0; l--) {
-    small_vec_t* lv = layer_vec(s, l);
-    if (lv && lv->length > 0) {
-      handle_t below_h = ptr_to_handle(lv->items[lv->length - 1]);
-      client_hot_t* below = server_chot(s, below_h);
-      xcb_window_t win = stack_window_xid(below);
-      if (win != XCB_NONE)
-        return win;
-    }
-  }
+typedef struct stack_committed_pos {
+  xcb_window_t frame;
+  uint32_t pos;
+} stack_committed_pos_t;
 
-  return XCB_NONE;
+static int stack_committed_pos_cmp(const void* a, const void* b) {
+  xcb_window_t fa = ((const stack_committed_pos_t*)a)->frame;
+  xcb_window_t fb = ((const stack_committed_pos_t*)b)->frame;
+  return (fa > fb) - (fa < fb);
 }
 
-static xcb_window_t find_window_above(server_t* s, client_hot_t* c) {
-  /* Same layer: next node is immediately above */
-  int layer = stack_current_layer(c);
-  small_vec_t* v = layer_vec(s, layer);
-  if (v) {
-    int32_t idx = stack_resolve_index(v, c->self, c->stacking_index);
-    if (idx >= 0 && (size_t)(idx + 1) < v->length) {
-      c->stacking_index = idx;
-      handle_t above_h = ptr_to_handle(v->items[idx + 1]);
-      client_hot_t* above = server_chot(s, above_h);
-      xcb_window_t win = stack_window_xid(above);
-      if (win != XCB_NONE)
-        return win;
-    }
+/* Fenwick prefix-max over committed positions, carrying the chain tail */
+typedef struct stack_lis_cell {
+  uint64_t weight;
+  uint32_t tail; /* index into the wanted order, UINT32_MAX if empty */
+} stack_lis_cell_t;
+
+static stack_lis_cell_t stack_lis_query(const stack_lis_cell_t* tree, uint32_t pos) {
+  stack_lis_cell_t best = {0, UINT32_MAX};
+  for (uint32_t i = pos; i > 0; i -= i & (0u - i)) {
+    if (tree[i].weight > best.weight)
+      best = tree[i];
   }
+  return best;
+}
 
-  /* Higher layers: bottommost of the nearest non-empty higher layer */
-  for (int l = layer + 1; l < LAYER_COUNT; l++) {
-    small_vec_t* lv = layer_vec(s, l);
-    if (lv && lv->length > 0) {
-      handle_t above_h = ptr_to_handle(lv->items[0]);
-      client_hot_t* above = server_chot(s, above_h);
-      xcb_window_t win = stack_window_xid(above);
-      if (win != XCB_NONE)
-        return win;
-    }
+static void stack_lis_update(stack_lis_cell_t* tree, uint32_t size, uint32_t pos, stack_lis_cell_t cell) {
+  for (uint32_t i = pos; i <= size; i += i & (0u - i)) {
+    if (cell.weight > tree[i].weight)
+      tree[i] = cell;
   }
-
-  return XCB_NONE;
 }
 
 /*
- * stack_sync_to_xcb:
+ * stack_commit_to_xcb:
  *
- * Translates the internal stacking list position into a concrete XCB
- * ConfigureWindow request.
+ * Emits the fewest ConfigureWindow requests that turn the order last sent to
+ * the X server into the current model order (all layers, bottom to top).
  *
  * Strategy:
- *  - We prefer to stack "Above" the window immediately below us.
- *  - If we are at the bottom of a layer, we check lower layers for an anchor.
- *  - Using "Above sibling" is generally more stable than "Below sibling" for
- *    iterative insertions (building a stack from bottom up).
- *  - This function is only called during the flush phase, ensuring we batch
- *    restacks and avoid fighting the X server during complex operations.
+ *  - Windows forming the longest subsequence already in committed order stay
+ *    put; every other window is restacked. Among equally long subsequences,
+ *    windows not marked DIRTY_STACK are preferred as anchors, so a lone raise
+ *    moves the raised window rather than everything it passed.
+ *  - Moved windows are placed bottom to top, each "Above" the window just below
+ *    it in the model (or "Below" the next one when it is the bottom), so every
+ *    anchor is already in its final place.
+ *  - A batch of raises inside one tick, e.g. a transient group, collapses into
+ *    at most one request per window that actually changed relative position.
+ *  - Each screen's order is diffed against what was committed on that screen.
  */
-void stack_sync_to_xcb(server_t* s, handle_t h) {
-  if (!s)
-    return;
-  assert(s->in_commit_phase);
+static void stack_commit_screen(server_t* s, screen_t* scr) {
+  size_t cap = 0;
+  for (int l = 0; l < LAYER_COUNT; l++)
+    cap += scr->layers[l].length;
+
+  xcb_window_t* want = cap ? (xcb_window_t*)arena_alloc(&s->tick_arena, cap * sizeof(*want)) : NULL;
+  uint8_t* stable = cap ? (uint8_t*)arena_alloc(&s->tick_arena, cap) : NULL;
+  uint32_t n = 0;
+  for (int l = 0; l < LAYER_COUNT; l++) {
+    const handle_vec_t* v = &scr->layers[l];
+    for (size_t i = 0; i < v->length; i++) {
+      client_hot_t* c = server_chot(s, v->items[i]);
+      if (!stack_committable(c))
+        continue;
+      want[n] = stack_window_xid(c);
+      stable[n] = (c->dirty & DIRTY_STACK) ? 0 : 1;
+      c->dirty &= ~DIRTY_STACK;
+      n++;
+    }
+  }
 
-  client_hot_t* c = server_chot(s, h);
-  if (!c)
-    return;
+  /* Committed position of each wanted window (1-based, 0 = never committed) */
+  u32_vec_t* committed = &scr->committed_stacking;
+  uint32_t cn = (uint32_t)committed->length;
+  uint32_t* cpos = n ? (uint32_t*)arena_alloc(&s->tick_arena, (size_t)n * sizeof(*cpos)) : NULL;
+  stack_committed_pos_t* index = cn ? (stack_committed_pos_t*)arena_alloc(&s->tick_arena, (size_t)cn * sizeof(*index)) : NULL;
+  for (uint32_t i = 0; i < cn; i++)
+    index[i] = (stack_committed_pos_t){committed->items[i], i + 1u};
+  if (cn)
+    qsort(index, cn, sizeof(*index), stack_committed_pos_cmp);
+  for (uint32_t i = 0; i < n; i++) {
+    stack_committed_pos_t key = {want[i], 0};
+    const stack_committed_pos_t* hit = cn ? bsearch(&key, index, cn, sizeof(*index), stack_committed_pos_cmp) : NULL;
+    cpos[i] = hit ? hit->pos : 0;
+  }
 
-  /* Prefer expressing "above the window below me"
-   * This keeps stable ordering when inserting into the middle
-   */
-  xcb_window_t sibling = find_window_below(s, c);
+  /* Heaviest increasing run of committed positions: length first, then the
+   * number of stable windows in it */
+  uint8_t* keep = n ? (uint8_t*)arena_alloc(&s->tick_arena, n) : NULL;
+  if (n) {
+    memset(keep, 0, n);
+    if (cn) {
+      stack_lis_cell_t* tree = (stack_lis_cell_t*)arena_alloc(&s->tick_arena, ((size_t)cn + 1u) * sizeof(*tree));
+      uint32_t* prev = (uint32_t*)arena_alloc(&s->tick_arena, (size_t)n * sizeof(*prev));
+      for (uint32_t i = 0; i <= cn; i++)
+        tree[i] = (stack_lis_cell_t){0, UINT32_MAX};
+
+      stack_lis_cell_t best = {0, UINT32_MAX};
+      for (uint32_t i = 0; i < n; i++) {
+        prev[i] = UINT32_MAX;
+        if (cpos[i] == 0)
+          continue;
+        stack_lis_cell_t below = stack_lis_query(tree, cpos[i] - 1u);
+        stack_lis_cell_t cell = {below.weight + (uint64_t)(n + 1u) + stable[i], i};
+        prev[i] = below.tail;
+        stack_lis_update(tree, cn, cpos[i], cell);
+        if (cell.weight > best.weight)
+          best = cell;
+      }
+      for (uint32_t i = best.tail; i != UINT32_MAX; i = prev[i])
+        keep[i] = 1;
+    }
+  }
 
-  uint16_t mask = 0;
-  uint32_t values[2] = {0, 0};
+  for (uint32_t i = 0; i < n; i++) {
+    if (keep[i])
+      continue;
 
-  if (sibling != XCB_NONE) {
-    mask = XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE;
-    values[0] = sibling;
-    values[1] = XCB_STACK_MODE_ABOVE;
-  }
-  else {
-    /* If there's no below sibling, try anchoring relative to an above sibling
-     */
-    sibling = find_window_above(s, c);
-    if (sibling != XCB_NONE) {
-      mask = XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE;
-      values[0] = sibling;
-      values[1] = XCB_STACK_MODE_BELOW;
+    uint16_t mask = XCB_CONFIG_WINDOW_STACK_MODE;
+    uint32_t values[2] = {XCB_STACK_MODE_ABOVE, 0};
+    if (i > 0) {
+      mask |= XCB_CONFIG_WINDOW_SIBLING;
+      values[0] = want[i - 1];
+      values[1] = XCB_STACK_MODE_ABOVE;
     }
-    else {
-      /* Only window we know about */
-      mask = XCB_CONFIG_WINDOW_STACK_MODE;
-      values[0] = XCB_STACK_MODE_ABOVE;
+    else if (n > 1) {
+      mask |= XCB_CONFIG_WINDOW_SIBLING;
+      values[0] = want[1];
+      values[1] = XCB_STACK_MODE_BELOW;
     }
+
+    TRACE_LOG("stack_commit frame=%u sibling=%u mode=%u", want[i], (mask & XCB_CONFIG_WINDOW_SIBLING) ? values[0] : XCB_NONE,
+              (mask & XCB_CONFIG_WINDOW_SIBLING) ? values[1] : values[0]);
+    xcb_configure_window(s->conn, want[i], mask, values);
+    HXM_COUNTER_RESTACK();
   }
 
-  TRACE_ONLY({
-    uint32_t mode = (mask & XCB_CONFIG_WINDOW_SIBLING) ? values[1] : values[0];
-    (void)mode;
-    TRACE_LOG("stack_sync_to_xcb h=%lx frame=%u sibling=%u mode=%u", h, c->frame, sibling, mode);
-  });
+  u32_vec_clear(committed);
+  u32_vec_reserve(committed, n);
+  if (n)
+    memcpy(committed->items, want, (size_t)n * sizeof(*want));
+  committed->length = n;
+}
+
+void stack_commit_to_xcb(server_t* s) {
+  if (!s)
+    return;
+  assert(s->in_commit_phase);
 
-  xcb_configure_window(s->conn, c->frame, mask, values);
-  HXM_COUNTER_RESTACK();
+  for (uint32_t i = 0; i < server_screen_count(s); i++)
+    stack_commit_screen(s, &s->screens[i]);
 }
 
 static void stack_restack(server_t* s, handle_t h) {
   client_hot_t* c = server_chot(s, h);
   if (c)
-    c->dirty |= DIRTY_STACK;
+    server_mark_dirty(s, c, DIRTY_STACK);
 }
@@ -0,0 +1,134 @@
+/* str_intern.c - Process-wide refcounted string intern table */
+
+#include "str_intern.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ds.h"
+#include "hxm.h"
+
+typedef struct str_entry {
+  struct str_entry* next; /* same table key */
+  uint64_t hash;
+  uint32_t refs;
+  uint32_t len;
+  char str[];
+} str_entry_t;
+
+static struct {
+  hash_map_t by_hash; /* hash (0 mapped to 1) -> str_entry_t* chain */
+  size_t count;
+  size_t bytes;
+} table;
+
+static str_entry_t* entry_of(const char* s) {
+  return (str_entry_t*)(void*)((char*)(uintptr_t)s - offsetof(str_entry_t, str));
+}
+
+static uint64_t table_key(uint64_t hash) {
+  return hash ? hash : 1u;
+}
+
+uint64_t str_hash(const char* s, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint8_t)s[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+const char* str_intern_n(const char* s, size_t len) {
+  if (!s)
+    return NULL;
+  const char* nul = memchr(s, '\0', len);
+  if (nul)
+    len = (size_t)(nul - s);
+  if (len > UINT32_MAX)
+    len = UINT32_MAX;
+
+  uint64_t hash = str_hash(s, len);
+  uint64_t key = table_key(hash);
+  str_entry_t* head = hash_map_get(&table.by_hash, key);
+  for (str_entry_t* e = head; e; e = e->next) {
+    if (e->hash == hash && e->len == len && memcmp(e->str, s, len) == 0) {
+      e->refs++;
+      return e->str;
+    }
+  }
+
+  size_t size = sizeof(str_entry_t) + len + 1u;
+  str_entry_t* e = malloc(size);
+  if (!e) {
+    LOG_ERROR("string intern allocation failed");
+    abort();
+  }
+  e->next = head;
+  e->hash = hash;
+  e->refs = 1;
+  e->len = (uint32_t)len;
+  memcpy(e->str, s, len);
+  e->str[len] = '\0';
+  hash_map_insert(&table.by_hash, key, e);
+  table.count++;
+  table.bytes += size;
+  return e->str;
+}
+
+const char* str_intern(const char* s) {
+  return s ? str_intern_n(s, strlen(s)) : NULL;
+}
+
+const char* str_intern_ref(const char* s) {
+  if (s)
+    entry_of(s)->refs++;
+  return s;
+}
+
+void str_intern_release(const char* s) {
+  if (!s)
+    return;
+  str_entry_t* e = entry_of(s);
+  if (--e->refs > 0)
+    return;
+
+  uint64_t key = table_key(e->hash);
+  str_entry_t* head = hash_map_get(&table.by_hash, key);
+  if (head == e) {
+    if (e->next)
+      hash_map_insert(&table.by_hash, key, e->next);
+    else
+      hash_map_remove(&table.by_hash, key);
+  }
+  else {
+    str_entry_t* prev = head;
+    while (prev && prev->next != e)
+      prev = prev->next;
+    if (prev)
+      prev->next = e->next;
+  }
+  table.count--;
+  table.bytes -= sizeof(str_entry_t) + e->len + 1u;
+  free(e);
+
+  // An empty table gives its storage back
+  if (table.count == 0)
+    hash_map_destroy(&table.by_hash);
+}
+
+uint64_t str_intern_hash(const char* s) {
+  return s ? entry_of(s)->hash : str_hash("", 0);
+}
+
+uint32_t str_intern_refs(const char* s) {
+  return s ? entry_of(s)->refs : 0u;
+}
+
+size_t str_intern_count(void) {
+  return table.count;
+}
+
+size_t str_intern_bytes(void) {
+  return table.bytes + hash_map_capacity(&table.by_hash) * sizeof(hash_map_entry_t);
+}
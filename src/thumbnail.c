@@ -0,0 +1,214 @@
+/* src/thumbnail.c
+ * Switcher thumbnails.
+ *
+ * Client windows are redirected with automatic Composite redirection: the
+ * server still paints them as usual, but their contents also live in an
+ * offscreen pixmap we can name and read back while they are covered. A
+ * thumbnail is that pixmap scaled down with RENDER (cairo-xcb) into a small
+ * server-side surface, so showing the switcher is a handful of composites
+ * and no client pixels cross the wire.
+ *
+ * Refresh is driven by Damage: tracking a client subscribes it
+ * (client_damage_subscribe), so with thumbnails off no damage objects exist.
+ * Damaged clients are queued, and thumbnail_flush rescales each at most
+ * switcher_thumbnail_hz times a second. A video or game that damages every
+ * frame costs one rescale per interval, not one per frame. Unmapped clients lose their offscreen
+ * storage, so they keep the last thumbnail taken while they were visible.
+ */
+
+#include "thumbnail.h"
+
+#include <cairo/cairo-xcb.h>
+#include <stdlib.h>
+#include <xcb/composite.h>
+#include <xcb/xcb.h>
+
+#include "hxm.h"
+
+/* Rescales per flush, so a burst of damage is spread over several ticks */
+#define THUMBNAIL_FLUSH_BUDGET 4
+
+bool thumbnail_enabled(const server_t* s) {
+  return s && s->composite_supported && s->config.switcher_thumbnails;
+}
+
+void thumbnail_track(server_t* s, handle_t h) {
+  if (!thumbnail_enabled(s))
+    return;
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold || cold->thumb_redirected)
+    return;
+  // A fast fullscreen client is left unredirected until it leaves
+  if (h == s->fs_fast)
+    return;
+
+  xcb_composite_redirect_window(s->conn, hot->xid, XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+  cold->thumb_redirected = true;
+  client_damage_subscribe(s, h);
+  thumbnail_mark_stale(s, h);
+}
+
+void thumbnail_release(server_t* s, handle_t h) {
+  client_cold_t* cold = server_ccold(s, h);
+  if (!cold)
+    return;
+
+  if (cold->thumb) {
+    cairo_surface_destroy(cold->thumb);
+    cold->thumb = NULL;
+  }
+  cold->thumb_w = 0;
+  cold->thumb_h = 0;
+  cold->thumb_time = 0;
+  thumbnail_suspend(s, h);
+}
+
+void thumbnail_suspend(server_t* s, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return;
+
+  if (cold->thumb_queued) {
+    handle_vec_remove_swap(&s->thumb_queue, h);
+    cold->thumb_queued = false;
+  }
+  if (cold->thumb_redirected) {
+    xcb_composite_unredirect_window(s->conn, hot->xid, XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+    cold->thumb_redirected = false;
+    client_damage_unsubscribe(s, h);
+  }
+}
+
+void thumbnail_mark_stale(server_t* s, handle_t h) {
+  client_cold_t* cold = server_ccold(s, h);
+  if (!cold || !cold->thumb_redirected || cold->thumb_queued)
+    return;
+  handle_vec_push(&s->thumb_queue, h);
+  cold->thumb_queued = true;
+}
+
+/* Scale the client's current contents into cold->thumb */
+static void thumbnail_capture(server_t* s, client_hot_t* hot, client_cold_t* cold) {
+  int w = hot->server.w;
+  int h = hot->server.h;
+  if (w <= 0 || h <= 0)
+    return;
+
+  double scale = (double)THUMBNAIL_MAX_W / (double)w;
+  if ((double)THUMBNAIL_MAX_H / (double)h < scale)
+    scale = (double)THUMBNAIL_MAX_H / (double)h;
+  if (scale > 1.0)
+    scale = 1.0;
+  int tw = (int)((double)w * scale + 0.5);
+  int th = (int)((double)h * scale + 0.5);
+  if (tw < 1)
+    tw = 1;
+  if (th < 1)
+    th = 1;
+
+  if (cold->thumb && (cold->thumb_w != tw || cold->thumb_h != th)) {
+    cairo_surface_destroy(cold->thumb);
+    cold->thumb = NULL;
+  }
+
+  // Tests have no server to read from; an image surface of the right size stands in
+  if (s->is_test) {
+    if (!cold->thumb)
+      cold->thumb = cairo_image_surface_create(CAIRO_FORMAT_RGB24, tw, th);
+  }
+  else {
+    xcb_visualtype_t* visual = cold->visual_type ? cold->visual_type : client_screen(s, hot)->root_visual_type;
+    xcb_pixmap_t pixmap = xcb_generate_id(s->conn);
+    xcb_composite_name_window_pixmap(s->conn, hot->xid, pixmap);
+    cairo_surface_t* src = cairo_xcb_surface_create(s->conn, pixmap, visual, w, h);
+
+    if (!cold->thumb)
+      cold->thumb = cairo_surface_create_similar(src, CAIRO_CONTENT_COLOR, tw, th);
+
+    cairo_t* cr = cairo_create(cold->thumb);
+    cairo_scale(cr, scale, scale);
+    cairo_set_source_surface(cr, src, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    cairo_surface_flush(cold->thumb);
+
+    cairo_surface_destroy(src);
+    xcb_free_pixmap(s->conn, pixmap);
+  }
+
+  cold->thumb_w = (uint16_t)tw;
+  cold->thumb_h = (uint16_t)th;
+}
+
+bool thumbnail_flush(server_t* s, uint64_t now) {
+  if (s->thumb_queue.length == 0)
+    return false;
+  if (!thumbnail_enabled(s)) {
+    for (size_t i = 0; i < s->thumb_queue.length; i++) {
+      client_cold_t* cold = server_ccold(s, s->thumb_queue.items[i]);
+      if (cold)
+        cold->thumb_queued = false;
+    }
+    s->thumb_queue.length = 0;
+    return false;
+  }
+
+  uint32_t hz = s->config.switcher_thumbnail_hz;
+  uint64_t interval = hz ? 1000000000ull / hz : 0;
+  uint32_t budget = THUMBNAIL_FLUSH_BUDGET;
+  bool flushed = false;
+
+  size_t kept = 0;
+  for (size_t i = 0; i < s->thumb_queue.length; i++) {
+    handle_t h = s->thumb_queue.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold)
+      continue;
+
+    // Only a viewable window has contents to read; keep it queued until then
+    bool viewable = hot->state == STATE_MAPPED && hot->frame_vis == FRAME_VIS_MAPPED;
+    bool due = cold->thumb_time == 0 || now - cold->thumb_time >= interval;
+    if (!viewable || !due || budget == 0) {
+      s->thumb_queue.items[kept++] = h;
+      continue;
+    }
+
+    thumbnail_capture(s, hot, cold);
+    cold->thumb_time = now;
+    cold->thumb_queued = false;
+    budget--;
+    flushed = true;
+  }
+  s->thumb_queue.length = kept;
+  return flushed;
+}
+
+cairo_surface_t* thumbnail_get(server_t* s, handle_t h, int* out_w, int* out_h) {
+  client_cold_t* cold = server_ccold(s, h);
+  if (!cold || !cold->thumb)
+    return NULL;
+  if (out_w)
+    *out_w = cold->thumb_w;
+  if (out_h)
+    *out_h = cold->thumb_h;
+  return cold->thumb;
+}
+
+void thumbnail_apply_config(server_t* s) {
+  bool enabled = thumbnail_enabled(s);
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t h = s->active_clients.items[i];
+    client_cold_t* cold = server_ccold(s, h);
+    if (!cold || cold->manage_phase != MANAGE_DONE)
+      continue;
+    if (enabled)
+      thumbnail_track(s, h);
+    else
+      thumbnail_release(s, h);
+  }
+}
@@ -0,0 +1,397 @@
+/* tiling.c - Tiling layout engine */
+
+#include "tiling.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE_RATIO_MIN 100
+#define TILE_RATIO_MAX 900
+#define TILE_RATIO_HALF 500
+
+static uint16_t tile_clamp_ratio(int v) {
+  if (v < TILE_RATIO_MIN)
+    return TILE_RATIO_MIN;
+  if (v > TILE_RATIO_MAX)
+    return TILE_RATIO_MAX;
+  return (uint16_t)v;
+}
+
+void tile_tree_init(tile_tree_t* t, tile_mode_t mode) {
+  memset(t, 0, sizeof(*t));
+  t->mode = mode;
+  t->master_permille = TILE_RATIO_HALF;
+  t->free_head = TILE_NIL;
+  t->root = TILE_NIL;
+}
+
+void tile_tree_destroy(tile_tree_t* t) {
+  free(t->nodes);
+  free(t->slots);
+  free(t->out);
+  tile_tree_init(t, TILE_FLOAT);
+}
+
+size_t tile_tree_count(const tile_tree_t* t) {
+  return t->slots_len;
+}
+
+static size_t tile_slot_find(const tile_tree_t* t, handle_t h) {
+  for (size_t i = 0; i < t->slots_len; i++) {
+    if (t->slots[i].client == h)
+      return i;
+  }
+  return SIZE_MAX;
+}
+
+bool tile_tree_contains(const tile_tree_t* t, handle_t h) {
+  return h != HANDLE_INVALID && tile_slot_find(t, h) != SIZE_MAX;
+}
+
+static uint32_t tile_node_alloc(tile_tree_t* t) {
+  uint32_t i;
+  if (t->free_head != TILE_NIL) {
+    i = t->free_head;
+    t->free_head = t->nodes[i].parent;
+  }
+  else {
+    if (t->nodes_len == t->nodes_cap) {
+      uint32_t cap = t->nodes_cap ? t->nodes_cap * 2u : 16u;
+      tile_node_t* nodes = realloc(t->nodes, (size_t)cap * sizeof(*nodes));
+      if (!nodes)
+        return TILE_NIL;
+      t->nodes = nodes;
+      t->nodes_cap = cap;
+    }
+    i = t->nodes_len++;
+  }
+
+  tile_node_t* n = &t->nodes[i];
+  memset(n, 0, sizeof(*n));
+  n->parent = TILE_NIL;
+  n->child[0] = n->child[1] = TILE_NIL;
+  n->ratio = TILE_RATIO_HALF;
+  return i;
+}
+
+static void tile_node_free(tile_tree_t* t, uint32_t i) {
+  t->nodes[i].client = HANDLE_INVALID;
+  t->nodes[i].parent = t->free_head;
+  t->free_head = i;
+}
+
+/* Dirty i's subtree, and flag the path down to it for the next layout */
+static void tile_mark(tile_tree_t* t, uint32_t i) {
+  t->pending = true;
+  t->nodes[i].dirty = true;
+  for (uint32_t p = t->nodes[i].parent; p != TILE_NIL && !t->nodes[p].dirty_below; p = t->nodes[p].parent)
+    t->nodes[p].dirty_below = true;
+}
+
+static void tile_mark_all(tile_tree_t* t) {
+  t->pending = true;
+  if (t->root != TILE_NIL)
+    t->nodes[t->root].dirty = true;
+}
+
+/* In g (or at the root), put n where old was */
+static void tile_replace_child(tile_tree_t* t, uint32_t g, uint32_t old, uint32_t n) {
+  t->nodes[n].parent = g;
+  if (g == TILE_NIL) {
+    t->root = n;
+    return;
+  }
+  if (t->nodes[g].child[0] == old)
+    t->nodes[g].child[0] = n;
+  else
+    t->nodes[g].child[1] = n;
+}
+
+bool tile_tree_insert(tile_tree_t* t, handle_t h, handle_t near) {
+  if (h == HANDLE_INVALID || tile_slot_find(t, h) != SIZE_MAX)
+    return false;
+
+  if (t->slots_len == t->slots_cap) {
+    size_t cap = t->slots_cap ? t->slots_cap * 2u : 8u;
+    tile_slot_t* slots = realloc(t->slots, cap * sizeof(*slots));
+    if (!slots)
+      return false;
+    t->slots = slots;
+    t->slots_cap = cap;
+  }
+
+  uint32_t target = TILE_NIL;
+  if (t->slots_len > 0) {
+    size_t at = (near != HANDLE_INVALID) ? tile_slot_find(t, near) : SIZE_MAX;
+    target = t->slots[(at != SIZE_MAX) ? at : t->slots_len - 1].leaf;
+  }
+
+  uint32_t leaf = tile_node_alloc(t);
+  if (leaf == TILE_NIL)
+    return false;
+  t->nodes[leaf].client = h;
+
+  if (target == TILE_NIL) {
+    t->root = leaf;
+    tile_mark(t, leaf);
+  }
+  else {
+    uint32_t split = tile_node_alloc(t);
+    if (split == TILE_NIL) {
+      tile_node_free(t, leaf);
+      return false;
+    }
+    tile_node_t* p = &t->nodes[split];
+    tile_node_t* old = &t->nodes[target];
+    p->rect = old->rect;
+    p->child[0] = target;
+    p->child[1] = leaf;
+    tile_replace_child(t, old->parent, target, split);
+    old->parent = split;
+    t->nodes[leaf].parent = split;
+    tile_mark(t, split);
+  }
+
+  t->slots[t->slots_len++] = (tile_slot_t){.client = h, .leaf = leaf};
+  return true;
+}
+
+bool tile_tree_remove(tile_tree_t* t, handle_t h) {
+  size_t at = (h != HANDLE_INVALID) ? tile_slot_find(t, h) : SIZE_MAX;
+  if (at == SIZE_MAX)
+    return false;
+
+  uint32_t leaf = t->slots[at].leaf;
+  uint32_t p = t->nodes[leaf].parent;
+  if (p == TILE_NIL) {
+    t->root = TILE_NIL;
+  }
+  else {
+    uint32_t sibling = (t->nodes[p].child[0] == leaf) ? t->nodes[p].child[1] : t->nodes[p].child[0];
+    tile_replace_child(t, t->nodes[p].parent, p, sibling);
+    t->nodes[sibling].rect = t->nodes[p].rect;
+    tile_node_free(t, p);
+    tile_mark(t, sibling);
+  }
+  tile_node_free(t, leaf);
+
+  memmove(&t->slots[at], &t->slots[at + 1], (t->slots_len - at - 1) * sizeof(*t->slots));
+  t->slots_len--;
+  t->pending = true;
+  return true;
+}
+
+void tile_tree_set_mode(tile_tree_t* t, tile_mode_t mode) {
+  if (t->mode == mode)
+    return;
+  t->mode = mode;
+  // Stored rects belong to the old shape; lay everything out again
+  tile_mark_all(t);
+}
+
+void tile_tree_set_area(tile_tree_t* t, rect_t area, uint16_t gap_px) {
+  if (memcmp(&t->area, &area, sizeof(area)) == 0 && t->gap_px == gap_px)
+    return;
+  t->area = area;
+  t->gap_px = gap_px;
+  tile_mark_all(t);
+}
+
+void tile_tree_set_master(tile_tree_t* t, uint16_t permille) {
+  permille = tile_clamp_ratio(permille);
+  if (t->master_permille == permille)
+    return;
+  t->master_permille = permille;
+  t->pending = true;
+}
+
+bool tile_tree_resize(tile_tree_t* t, handle_t h, int delta_permille) {
+  size_t at = (h != HANDLE_INVALID) ? tile_slot_find(t, h) : SIZE_MAX;
+  if (at == SIZE_MAX)
+    return false;
+
+  if (t->mode == TILE_MASTER) {
+    // Growing a stack client grows the stack
+    int d = (at == 0) ? delta_permille : -delta_permille;
+    uint16_t before = t->master_permille;
+    tile_tree_set_master(t, tile_clamp_ratio((int)t->master_permille + d));
+    return t->master_permille != before;
+  }
+
+  uint32_t leaf = t->slots[at].leaf;
+  uint32_t p = t->nodes[leaf].parent;
+  if (p == TILE_NIL)
+    return false;
+  tile_node_t* n = &t->nodes[p];
+  int d = (n->child[0] == leaf) ? delta_permille : -delta_permille;
+  uint16_t ratio = tile_clamp_ratio((int)n->ratio + d);
+  if (ratio == n->ratio)
+    return false;
+  n->ratio = ratio;
+  tile_mark(t, p);
+  return true;
+}
+
+void tile_tree_invalidate(tile_tree_t* t, handle_t h) {
+  if (h == HANDLE_INVALID) {
+    for (size_t i = 0; i < t->slots_len; i++)
+      memset(&t->nodes[t->slots[i].leaf].last, 0, sizeof(rect_t));
+    tile_mark_all(t);
+    return;
+  }
+  size_t at = tile_slot_find(t, h);
+  if (at == SIZE_MAX)
+    return;
+  uint32_t leaf = t->slots[at].leaf;
+  memset(&t->nodes[leaf].last, 0, sizeof(rect_t));
+  tile_mark(t, leaf);
+}
+
+static rect_t tile_make_rect(int32_t x, int32_t y, int32_t w, int32_t h) {
+  rect_t r;
+  r.x = (int16_t)x;
+  r.y = (int16_t)y;
+  r.w = (uint16_t)((w > 1) ? w : 1);
+  r.h = (uint16_t)((h > 1) ? h : 1);
+  return r;
+}
+
+/* The area less the outer gap: the root's rect */
+static rect_t tile_inner_area(const tile_tree_t* t) {
+  int32_t g = t->gap_px;
+  return tile_make_rect(t->area.x + g, t->area.y + g, (int32_t)t->area.w - 2 * g, (int32_t)t->area.h - 2 * g);
+}
+
+/* Split r along one axis at ratio, leaving the gap between the halves */
+static void tile_split(const tile_tree_t* t, rect_t r, bool side_by_side, uint16_t ratio, rect_t out[2]) {
+  int32_t len = side_by_side ? r.w : r.h;
+  int32_t gap = t->gap_px;
+  if (len - gap < 2)
+    gap = 0;
+  int32_t first = (int32_t)((int64_t)(len - gap) * ratio / 1000);
+  int32_t second = len - gap - first;
+  if (side_by_side) {
+    out[0] = tile_make_rect(r.x, r.y, first, r.h);
+    out[1] = tile_make_rect(r.x + first + gap, r.y, second, r.h);
+  }
+  else {
+    out[0] = tile_make_rect(r.x, r.y, r.w, first);
+    out[1] = tile_make_rect(r.x, r.y + first + gap, r.w, second);
+  }
+}
+
+static bool tile_out_reserve(tile_tree_t* t) {
+  if (t->out_cap >= t->slots_len)
+    return true;
+  size_t cap = t->out_cap ? t->out_cap : 8u;
+  while (cap < t->slots_len)
+    cap *= 2u;
+  tile_result_t* out = realloc(t->out, cap * sizeof(*out));
+  if (!out)
+    return false;
+  t->out = out;
+  t->out_cap = cap;
+  return true;
+}
+
+static void tile_report(tile_tree_t* t, uint32_t leaf, rect_t r, size_t* n) {
+  tile_node_t* node = &t->nodes[leaf];
+  if (memcmp(&node->last, &r, sizeof(r)) == 0)
+    return;
+  node->last = r;
+  t->out[(*n)++] = (tile_result_t){.client = node->client, .rect = r};
+}
+
+/* Give i the rect r and recompute everything under it */
+static void tile_layout_subtree(tile_tree_t* t, uint32_t i, rect_t r, size_t* n) {
+  tile_node_t* node = &t->nodes[i];
+  t->nodes_visited++;
+  node->rect = r;
+  node->dirty = false;
+  node->dirty_below = false;
+  if (node->client != HANDLE_INVALID) {
+    tile_report(t, i, r, n);
+    return;
+  }
+  // Split across the longer side, decided once so later resizes keep the shape
+  if (!node->oriented) {
+    node->side_by_side = r.w >= r.h;
+    node->oriented = true;
+  }
+  rect_t halves[2];
+  tile_split(t, r, node->side_by_side, node->ratio, halves);
+  uint32_t c0 = node->child[0];
+  uint32_t c1 = node->child[1];
+  tile_layout_subtree(t, c0, halves[0], n);
+  tile_layout_subtree(t, c1, halves[1], n);
+}
+
+/* Walk only the flagged path down to dirty subtrees */
+static void tile_layout_dirty(tile_tree_t* t, uint32_t i, size_t* n) {
+  tile_node_t* node = &t->nodes[i];
+  if (node->dirty) {
+    tile_layout_subtree(t, i, node->rect, n);
+    return;
+  }
+  if (!node->dirty_below)
+    return;
+  t->nodes_visited++;
+  node->dirty_below = false;
+  uint32_t c0 = node->child[0];
+  uint32_t c1 = node->child[1];
+  if (c0 != TILE_NIL)
+    tile_layout_dirty(t, c0, n);
+  if (c1 != TILE_NIL)
+    tile_layout_dirty(t, c1, n);
+}
+
+static void tile_layout_master(tile_tree_t* t, size_t* n) {
+  rect_t area = tile_inner_area(t);
+  size_t count = t->slots_len;
+  t->nodes_visited += count;
+  if (count == 1) {
+    tile_report(t, t->slots[0].leaf, area, n);
+    return;
+  }
+
+  rect_t cols[2];
+  tile_split(t, area, true, t->master_permille, cols);
+  tile_report(t, t->slots[0].leaf, cols[0], n);
+
+  // The stack shares its column; the last client takes the remainder
+  int32_t gap = t->gap_px;
+  int32_t stack = (int32_t)count - 1;
+  int32_t avail = (int32_t)cols[1].h - gap * (stack - 1);
+  if (avail < stack) {
+    avail = cols[1].h;
+    gap = 0;
+  }
+  int32_t y = cols[1].y;
+  for (int32_t i = 0; i < stack; i++) {
+    int32_t h = (i == stack - 1) ? (int32_t)cols[1].y + cols[1].h - y : avail / stack;
+    tile_report(t, t->slots[i + 1].leaf, tile_make_rect(cols[1].x, y, cols[1].w, h), n);
+    y += h + gap;
+  }
+}
+
+const tile_result_t* tile_tree_layout(tile_tree_t* t, size_t* n) {
+  *n = 0;
+  if (t->mode == TILE_FLOAT || !t->pending || t->slots_len == 0 || t->area.w == 0 || t->area.h == 0)
+    return t->out;
+  if (!tile_out_reserve(t))
+    return t->out;
+
+  t->layouts++;
+  if (t->mode == TILE_MASTER) {
+    tile_layout_master(t, n);
+  }
+  else if (t->nodes[t->root].dirty) {
+    tile_layout_subtree(t, t->root, tile_inner_area(t), n);
+  }
+  else {
+    tile_layout_dirty(t, t->root, n);
+  }
+  t->pending = false;
+  t->rects_reported += *n;
+  return t->out;
+}
@@ -0,0 +1,227 @@
+/* timer_wheel.c - Hierarchical timer wheel
+ *
+ * Classic cascading wheel: level n slot i holds timers whose tick, shifted
+ * right by 6n bits, is i. When the low 6n bits of base turn over to zero,
+ * the level n slot for base is emptied into the levels below. Runs over an
+ * empty level 0 jump straight to the next cascade point, so catching up
+ * after a long idle costs a few iterations per 64^2 ticks.
+ *
+ * Occupancy bits are set on insert and cleared when a slot is emptied or
+ * found empty; a clear bit always means an empty slot, a set bit may be
+ * stale after a cancel.
+ */
+
+#include "timer_wheel.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#define TIMER_WHEEL_MASK ((uint64_t)TIMER_WHEEL_SLOTS - 1u)
+#define TIMER_WHEEL_HORIZON (1ull << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+static void wheel_unlink(wheel_timer_t* t) {
+  *t->pprev = t->next;
+  if (t->next)
+    t->next->pprev = t->pprev;
+  t->next = NULL;
+  t->pprev = NULL;
+}
+
+static void wheel_push(wheel_timer_t** head, wheel_timer_t* t) {
+  t->next = *head;
+  if (*head)
+    (*head)->pprev = &t->next;
+  *head = t;
+  t->pprev = head;
+}
+
+/* Detach a whole slot into *list, which then acts as its head */
+static void wheel_take(timer_wheel_t* w, uint32_t level, uint32_t slot, wheel_timer_t** list) {
+  *list = w->slots[level][slot];
+  w->slots[level][slot] = NULL;
+  w->occupied[level] &= ~(1ull << slot);
+  if (*list)
+    (*list)->pprev = list;
+}
+
+static void wheel_place(timer_wheel_t* w, wheel_timer_t* t) {
+  uint32_t level = 0;
+  uint64_t slot_tick = w->base;  // already due: runs with the next tick
+  if (t->expires >= w->base) {
+    uint64_t delta = t->expires - w->base;
+    slot_tick = t->expires;
+    if (delta >= TIMER_WHEEL_HORIZON) {
+      // Parked in the top level; placed again when it cascades
+      delta = TIMER_WHEEL_HORIZON - 1u;
+      slot_tick = w->base + delta;
+    }
+    while (level + 1u < TIMER_WHEEL_LEVELS && delta >= (1ull << (TIMER_WHEEL_BITS * (level + 1u))))
+      level++;
+  }
+  uint32_t slot = (uint32_t)((slot_tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+  wheel_push(&w->slots[level][slot], t);
+  w->occupied[level] |= 1ull << slot;
+}
+
+/* When the wheel would report waking for t */
+static uint64_t wheel_timer_wake_ns(const timer_wheel_t* w, const wheel_timer_t* t) {
+  uint64_t tick = t->expires > w->base ? t->expires : w->base;
+  uint64_t at = t->deadline_ns + t->slack_ns;
+  if (at < t->deadline_ns)
+    at = UINT64_MAX;
+  uint64_t tick_ns = tick * TIMER_WHEEL_TICK_NS;
+  return tick_ns > at ? tick_ns : at;
+}
+
+void timer_wheel_add(timer_wheel_t* w, wheel_timer_t* t, uint64_t deadline_ns, uint64_t slack_ns) {
+  bool moved = wheel_timer_pending(t);
+  if (moved) {
+    wheel_unlink(t);
+    w->count--;
+  }
+
+  t->deadline_ns = deadline_ns;
+  t->slack_ns = slack_ns;
+  t->expires = deadline_ns / TIMER_WHEEL_TICK_NS + (deadline_ns % TIMER_WHEEL_TICK_NS != 0);
+  // Re-arming for "now" from a callback fires on the next run, not this one
+  uint64_t first = w->running ? w->run_target + 1u : w->base;
+  if (t->expires < first)
+    t->expires = first;
+  wheel_place(w, t);
+  w->count++;
+  w->added++;
+
+  if (moved) {
+    w->next_valid = false;
+  }
+  else if (w->next_valid) {
+    uint64_t at = wheel_timer_wake_ns(w, t);
+    if (at < w->next_ns)
+      w->next_ns = at;
+  }
+}
+
+void timer_wheel_cancel(timer_wheel_t* w, wheel_timer_t* t) {
+  if (!wheel_timer_pending(t))
+    return;
+  wheel_unlink(t);
+  w->count--;
+  w->cancelled++;
+  w->next_valid = false;
+}
+
+static void wheel_cascade(timer_wheel_t* w, uint32_t level, uint32_t slot) {
+  wheel_timer_t* list;
+  wheel_take(w, level, slot, &list);
+  wheel_timer_t* t;
+  while ((t = list) != NULL) {
+    wheel_unlink(t);
+    wheel_place(w, t);
+    w->cascaded++;
+  }
+}
+
+uint32_t timer_wheel_run(timer_wheel_t* w, uint64_t now_ns, void* ctx) {
+  uint64_t target = now_ns / TIMER_WHEEL_TICK_NS;
+  uint32_t fired = 0;
+  w->running = true;
+  w->run_target = target;
+
+  while (w->base <= target) {
+    if (w->count == 0) {
+      w->base = target + 1u;
+      break;
+    }
+
+    uint32_t idx = (uint32_t)(w->base & TIMER_WHEEL_MASK);
+    if (idx == 0) {
+      for (uint32_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        uint32_t slot = (uint32_t)((w->base >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+        if (w->occupied[level] & (1ull << slot))
+          wheel_cascade(w, level, slot);
+        if (slot != 0)
+          break;
+      }
+    }
+
+    if (w->occupied[0] == 0) {
+      // Nothing can fire before the next cascade point
+      uint64_t next = (w->base | TIMER_WHEEL_MASK) + 1u;
+      if (idx == 0 && w->occupied[1] == 0)
+        next = (w->base | ((1ull << (2u * TIMER_WHEEL_BITS)) - 1u)) + 1u;
+      w->base = next <= target ? next : target + 1u;
+      continue;
+    }
+
+    wheel_timer_t* list;
+    wheel_take(w, 0, idx, &list);
+    w->base++;
+    wheel_timer_t* t;
+    while ((t = list) != NULL) {
+      // Callbacks may cancel timers still on the detached list
+      wheel_unlink(t);
+      w->count--;
+      w->fired++;
+      fired++;
+      if (t->fn)
+        t->fn(t, ctx);
+    }
+  }
+
+  w->running = false;
+  if (fired > 0)
+    w->runs_fired++;
+  w->next_valid = false;
+  return fired;
+}
+
+uint64_t timer_wheel_next_ns(timer_wheel_t* w) {
+  if (w->next_valid)
+    return w->next_ns;
+
+  uint64_t best = UINT64_MAX;
+  if (w->count > 0) {
+    for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+      uint64_t bits = w->occupied[level];
+      while (bits) {
+        uint32_t slot = (uint32_t)__builtin_ctzll(bits);
+        bits &= bits - 1u;
+        const wheel_timer_t* t = w->slots[level][slot];
+        if (!t)
+          w->occupied[level] &= ~(1ull << slot);
+        for (; t; t = t->next) {
+          uint64_t at = wheel_timer_wake_ns(w, t);
+          if (at < best)
+            best = at;
+        }
+      }
+    }
+  }
+  w->next_ns = best;
+  w->next_valid = true;
+  return best;
+}
+
+size_t timer_wheel_format(const timer_wheel_t* w, char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+  buf[0] = '\0';
+  if (!w)
+    return 0;
+
+  int n = snprintf(buf, cap,
+                   "timers: pending=%u added=%" PRIu64 " cancelled=%" PRIu64 " fired=%" PRIu64 " runs_fired=%" PRIu64
+                   " cascaded=%" PRIu64 "\n",
+                   w->count, w->added, w->cancelled, w->fired, w->runs_fired, w->cascaded);
+  if (n <= 0)
+    return 0;
+  return (size_t)n < cap ? (size_t)n : cap - 1u;
+}
+
+void timer_wheel_dump(const timer_wheel_t* w) {
+  char buf[256];
+  if (timer_wheel_format(w, buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
+}
@@ -0,0 +1,192 @@
+/* title_cache.c - Shared LRU of rendered title text runs */
+
+#include "title_cache.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "render.h"
+
+typedef struct title_run {
+  list_node_t lru;
+  uint64_t hash;
+  int width;
+  int height;
+  uint32_t color;
+  cairo_surface_t* surface;
+  char* text; /* font and text back to back, each NUL terminated */
+} title_run_t;
+
+// FNV-1a over the key fields; hash_map_t remixes keys, 0 is reserved
+static uint64_t title_hash_bytes(uint64_t x, const char* p) {
+  for (; *p; p++)
+    x = (x ^ (uint8_t)*p) * 0x100000001b3ull;
+  return (x ^ 0xffu) * 0x100000001b3ull;
+}
+
+uint64_t title_key_hash(const title_key_t* key) {
+  uint64_t x = 0xcbf29ce484222325ull ^ (((uint64_t)(uint32_t)key->width << 32) | (uint32_t)key->height);
+  x = (x ^ key->color) * 0x100000001b3ull;
+  x = title_hash_bytes(x, key->font ? key->font : "");
+  x = title_hash_bytes(x, key->text ? key->text : "");
+  return x ? x : 1;
+}
+
+static const char* title_run_font(const title_run_t* run) {
+  return run->text;
+}
+
+static const char* title_run_text(const title_run_t* run) {
+  return run->text + strlen(run->text) + 1;
+}
+
+// Hashes can collide: confirm against the stored key
+static bool title_run_matches(const title_run_t* run, const title_key_t* key) {
+  return run->width == key->width && run->height == key->height && run->color == key->color && strcmp(title_run_font(run), key->font ? key->font : "") == 0 &&
+         strcmp(title_run_text(run), key->text ? key->text : "") == 0;
+}
+
+static inline int title_width_class(int width) {
+  return (width + TITLE_CACHE_WIDTH_CLASS - 1) / TITLE_CACHE_WIDTH_CLASS * TITLE_CACHE_WIDTH_CLASS;
+}
+
+static void title_cache_lazy_init(title_cache_t* cache) {
+  if (!cache->lru.next)
+    list_init(&cache->lru);
+}
+
+void title_cache_init(title_cache_t* cache) {
+  memset(cache, 0, sizeof(*cache));
+  hash_map_init(&cache->by_key);
+  list_init(&cache->lru);
+}
+
+// Give the cache's reference back, keeping the surface if nobody else uses it
+static void title_cache_release(title_cache_t* cache, cairo_surface_t* surface) {
+  if (cache->pool_len < TITLE_CACHE_POOL_SIZE && cairo_surface_get_reference_count(surface) == 1) {
+    cache->pool[cache->pool_len++] = surface;
+    return;
+  }
+  cairo_surface_destroy(surface);
+}
+
+static void title_run_drop(title_cache_t* cache, title_run_t* run, bool recycle) {
+  list_remove(&run->lru);
+  if (hash_map_get(&cache->by_key, run->hash) == run)
+    hash_map_remove(&cache->by_key, run->hash);
+  if (recycle)
+    title_cache_release(cache, run->surface);
+  else
+    cairo_surface_destroy(run->surface);
+  free(run->text);
+  free(run);
+  cache->count--;
+}
+
+void title_cache_destroy(title_cache_t* cache) {
+  title_cache_lazy_init(cache);
+  while (!list_empty(&cache->lru))
+    title_run_drop(cache, list_entry(cache->lru.next, title_run_t, lru), false);
+  for (size_t i = 0; i < cache->pool_len; i++)
+    cairo_surface_destroy(cache->pool[i]);
+  hash_map_destroy(&cache->by_key);
+  memset(cache, 0, sizeof(*cache));
+}
+
+cairo_surface_t* title_cache_lookup(title_cache_t* cache, const title_key_t* key) {
+  title_cache_lazy_init(cache);
+  title_run_t* run = hash_map_get(&cache->by_key, title_key_hash(key));
+  if (!run || !title_run_matches(run, key)) {
+    cache->misses++;
+    return NULL;
+  }
+  cache->hits++;
+  list_remove(&run->lru);
+  list_push_front(&cache->lru, &run->lru);
+  return run->surface;
+}
+
+cairo_surface_t* title_cache_acquire(title_cache_t* cache, int width, int height) {
+  if (width <= 0 || height <= 0)
+    return NULL;
+  int cls = title_width_class(width);
+  for (size_t i = 0; i < cache->pool_len; i++) {
+    cairo_surface_t* s = cache->pool[i];
+    if (cairo_image_surface_get_width(s) == cls && cairo_image_surface_get_height(s) == height) {
+      cache->pool[i] = cache->pool[--cache->pool_len];
+      cache->pool_reuses++;
+      return s;
+    }
+  }
+
+  cairo_surface_t* s = render_image_create(CAIRO_FORMAT_ARGB32, cls, height);
+  if (cairo_surface_status(s) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(s);
+    return NULL;
+  }
+  return s;
+}
+
+cairo_surface_t* title_cache_insert(title_cache_t* cache, const title_key_t* key, cairo_surface_t* surface) {
+  title_cache_lazy_init(cache);
+  uint64_t hash = title_key_hash(key);
+
+  // A colliding run loses its slot; it would never be found again anyway
+  title_run_t* old = hash_map_get(&cache->by_key, hash);
+  if (old)
+    title_run_drop(cache, old, true);
+  while (cache->count >= TITLE_CACHE_CAPACITY) {
+    title_run_drop(cache, list_entry(cache->lru.prev, title_run_t, lru), true);
+    cache->evictions++;
+  }
+
+  const char* font = key->font ? key->font : "";
+  const char* text = key->text ? key->text : "";
+  size_t font_len = strlen(font);
+  size_t text_len = strlen(text);
+  title_run_t* run = malloc(sizeof(*run));
+  char* buf = malloc(font_len + text_len + 2);
+  if (!run || !buf) {
+    LOG_ERROR("title cache allocation failed");
+    abort();
+  }
+  memcpy(buf, font, font_len + 1);
+  memcpy(buf + font_len + 1, text, text_len + 1);
+
+  run->hash = hash;
+  run->width = key->width;
+  run->height = key->height;
+  run->color = key->color;
+  run->surface = surface;
+  run->text = buf;
+  list_push_front(&cache->lru, &run->lru);
+  hash_map_insert(&cache->by_key, hash, run);
+  cache->count++;
+  return surface;
+}
+
+static size_t title_surface_bytes(cairo_surface_t* s) {
+  return (size_t)cairo_image_surface_get_stride(s) * (size_t)cairo_image_surface_get_height(s);
+}
+
+size_t title_cache_bytes(const title_cache_t* cache) {
+  size_t bytes = 0;
+  if (cache->lru.next) {
+    for (const list_node_t* n = cache->lru.next; n != &cache->lru; n = n->next)
+      bytes += title_surface_bytes(list_entry(n, title_run_t, lru)->surface);
+  }
+  for (size_t i = 0; i < cache->pool_len; i++)
+    bytes += title_surface_bytes(cache->pool[i]);
+  return bytes;
+}
+
+size_t title_cache_trim_pool(title_cache_t* cache) {
+  size_t bytes = 0;
+  for (size_t i = 0; i < cache->pool_len; i++) {
+    bytes += title_surface_bytes(cache->pool[i]);
+    cairo_surface_destroy(cache->pool[i]);
+  }
+  cache->pool_len = 0;
+  return bytes;
+}
@@ -0,0 +1,134 @@
+/* src/tracepoint.c
+ * In-process tracepoint recorder and Chrome trace-event JSON dumper.
+ *
+ * The recorder is a fixed array written round-robin, so recording costs a
+ * store of 32 bytes and never allocates after startup; a long session
+ * keeps its most recent TP_RING_CAP records, which is what a lag report
+ * needs. Timestamps stay in monotonic ns until the dump converts them to
+ * the microseconds the trace-event format expects.
+ *
+ * JSON layout: tick phases are complete events on thread 1, cookies are
+ * async spans from push to dispatch on thread 2, manage spans and focus
+ * commits are on thread 3.
+ */
+
+#include "tracepoint.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hxm.h"
+
+tp_ring_t tp_ring;
+
+bool tp_open_from_env(void) {
+  const char* path = getenv(TRACEPOINTS_ENV);
+  if (!path || !*path || tp_ring.recs)
+    return tp_ring.recs != NULL;
+
+  tp_ring.path = strdup(path);
+  tp_ring.recs = calloc(TP_RING_CAP, sizeof(*tp_ring.recs));
+  if (!tp_ring.path || !tp_ring.recs) {
+    LOG_WARN("tracepoint recorder allocation failed");
+    tp_close();
+    return false;
+  }
+  tp_ring.next = 0;
+  LOG_INFO("Recording tracepoints, dumped to %s", path);
+  return true;
+}
+
+void tp_close(void) {
+  free(tp_ring.recs);
+  free(tp_ring.path);
+  memset(&tp_ring, 0, sizeof(tp_ring));
+}
+
+void tp_record(tp_id_t id, uint64_t t_ns, uint64_t dur_ns, uint32_t a, uint32_t b) {
+  tp_record_t* r = &tp_ring.recs[tp_ring.next++ & (TP_RING_CAP - 1u)];
+  r->t_ns = t_ns;
+  r->dur_ns = dur_ns;
+  r->a = a;
+  r->b = b;
+  r->id = (uint32_t)id;
+  r->reserved = 0;
+}
+
+// Every event follows the thread_name metadata, so each one opens with a comma
+static void tp_json_event(FILE* f, const char* fmt, ...) HXM_ATTR_PRINTF(2, 3);
+
+static void tp_json_event(FILE* f, const char* fmt, ...) {
+  fputs(",\n", f);
+  va_list ap;
+  va_start(ap, fmt);
+  vfprintf(f, fmt, ap);
+  va_end(ap);
+}
+
+static void tp_json_record(FILE* f, const tp_record_t* r) {
+  double ts = (double)r->t_ns / 1000.0;
+  double dur = (double)r->dur_ns / 1000.0;
+
+  switch ((tp_id_t)r->id) {
+    case TP_ID_TICK_PHASE:
+      tp_json_event(f, "{\"name\":\"%s\",\"cat\":\"tick\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                    r->a < TICK_PHASE_COUNT ? tick_phase_name((tick_phase_t)r->a) : "phase", ts, dur);
+      break;
+    case TP_ID_COOKIE_PUSH:
+      tp_json_event(f, "{\"name\":\"push\",\"cat\":\"cookie\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":2,\"args\":{\"seq\":%u,\"type\":%u}}",
+                    ts, r->a, r->b);
+      break;
+    case TP_ID_COOKIE_DISPATCH:
+      tp_json_event(f, "{\"name\":\"cookie\",\"cat\":\"cookie\",\"ph\":\"b\",\"id\":%u,\"ts\":%.3f,\"pid\":1,\"tid\":2,\"args\":{\"type\":%u}}",
+                    r->a, ts, r->b);
+      tp_json_event(f, "{\"name\":\"cookie\",\"cat\":\"cookie\",\"ph\":\"e\",\"id\":%u,\"ts\":%.3f,\"pid\":1,\"tid\":2}", r->a, ts + dur);
+      break;
+    case TP_ID_MANAGE_START:
+    case TP_ID_MANAGE_FINISH:
+      tp_json_event(f, "{\"name\":\"manage\",\"cat\":\"client\",\"ph\":\"%s\",\"id\":%u,\"ts\":%.3f,\"pid\":1,\"tid\":3}",
+                    r->id == TP_ID_MANAGE_START ? "b" : "e", r->a, ts);
+      break;
+    case TP_ID_FOCUS_COMMIT:
+      tp_json_event(f, "{\"name\":\"focus\",\"cat\":\"client\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":3,\"args\":{\"xid\":%u}}", ts,
+                    r->a);
+      break;
+  }
+}
+
+bool tp_dump_json(const char* path) {
+  if (!tp_ring.recs || !path)
+    return false;
+  FILE* f = fopen(path, "w");
+  if (!f) {
+    LOG_WARN("tracepoint dump %s: %s", path, strerror(errno));
+    return false;
+  }
+
+  fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"tick\"}},\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"cookies\"}},\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"clients\"}}",
+        f);
+
+  uint64_t count = tp_ring.next < TP_RING_CAP ? tp_ring.next : TP_RING_CAP;
+  for (uint64_t i = tp_ring.next - count; i != tp_ring.next; i++)
+    tp_json_record(f, &tp_ring.recs[i & (TP_RING_CAP - 1u)]);
+  fputs("\n]}\n", f);
+
+  bool ok = !ferror(f);
+  if (fclose(f) != 0)
+    ok = false;
+  if (ok)
+    LOG_INFO("Dumped %llu tracepoints to %s", (unsigned long long)count, path);
+  else
+    LOG_WARN("tracepoint dump %s: write failed", path);
+  return ok;
+}
+
+void tp_dump(void) {
+  if (tp_ring.recs)
+    tp_dump_json(tp_ring.path);
+}
@@ -0,0 +1,139 @@
+/* src/transient_groups.c
+ * Pre-order layout of the transient forest.
+ *
+ * A build maps clients to their index, counts children into a CSR table
+ * (children stay in client order), then walks each root depth first with an
+ * explicit stack. Spans are summed bottom up in one reverse pass, since in
+ * pre-order every node comes after its parent.
+ */
+
+#include "transient_groups.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hxm.h"
+
+#define TG_NONE UINT32_MAX
+
+static void* tg_calloc(size_t n, size_t size) {
+  void* p = calloc(n ? n : 1u, size);
+  if (!p) {
+    LOG_ERROR("transient group allocation failed");
+    abort();
+  }
+  return p;
+}
+
+static void tg_reserve(transient_groups_t* g, uint32_t need) {
+  if (need <= g->cap)
+    return;
+  uint32_t cap = g->cap ? g->cap : 16u;
+  while (cap < need)
+    cap *= 2u;
+  handle_t* order = realloc(g->order, (size_t)cap * sizeof(*order));
+  uint32_t* span = order ? realloc(g->span, (size_t)cap * sizeof(*span)) : NULL;
+  if (!order || !span) {
+    LOG_ERROR("transient group allocation failed");
+    abort();
+  }
+  g->order = order;
+  g->span = span;
+  g->cap = cap;
+}
+
+void transient_groups_destroy(transient_groups_t* g) {
+  free(g->order);
+  free(g->span);
+  epoch_map_destroy(&g->pos);
+  memset(g, 0, sizeof(*g));
+}
+
+void transient_groups_build(transient_groups_t* g, const handle_t* clients, size_t n, transient_parent_fn parent_of, void* user) {
+  epoch_map_clear(&g->pos);
+  g->len = 0;
+  g->valid = true;
+  g->rebuilds++;
+  if (n == 0)
+    return;
+
+  for (size_t i = 0; i < n; i++)
+    epoch_map_insert(&g->pos, clients[i], (void*)(uintptr_t)(i + 1u));
+
+  uint32_t* parent = tg_calloc(n, sizeof(*parent));
+  uint32_t* first = tg_calloc(n + 1u, sizeof(*first));
+  uint8_t* linked = tg_calloc(n, sizeof(*linked));
+  uint32_t linked_count = 0;
+  for (size_t i = 0; i < n; i++) {
+    parent[i] = TG_NONE;
+    handle_t p = parent_of(user, clients[i]);
+    if (p == HANDLE_INVALID || p == clients[i])
+      continue;
+    uintptr_t pi = (uintptr_t)epoch_map_get(&g->pos, p);
+    if (!pi)
+      continue;
+    parent[i] = (uint32_t)(pi - 1u);
+    first[parent[i] + 1u]++;
+    linked_count += !linked[i] + !linked[parent[i]];
+    linked[i] = 1;
+    linked[parent[i]] = 1;
+  }
+
+  // CSR children, in client order
+  for (size_t i = 0; i < n; i++)
+    first[i + 1u] += first[i];
+  uint32_t* kids = tg_calloc(first[n], sizeof(*kids));
+  uint32_t* fill = tg_calloc(n, sizeof(*fill));
+  for (size_t i = 0; i < n; i++) {
+    if (parent[i] != TG_NONE)
+      kids[first[parent[i]] + fill[parent[i]]++] = (uint32_t)i;
+  }
+
+  tg_reserve(g, linked_count);
+  uint32_t* node_at = tg_calloc(linked_count, sizeof(*node_at));
+  uint32_t* pos_of = fill; // reused: every fill slot has been consumed
+  uint32_t* stack = tg_calloc(linked_count, sizeof(*stack));
+  for (size_t root = 0; root < n; root++) {
+    if (!linked[root] || parent[root] != TG_NONE)
+      continue;
+    uint32_t top = 0;
+    stack[top++] = (uint32_t)root;
+    while (top > 0) {
+      uint32_t x = stack[--top];
+      pos_of[x] = g->len;
+      node_at[g->len] = x;
+      g->order[g->len] = clients[x];
+      g->span[g->len] = 1;
+      g->len++;
+      for (uint32_t k = first[x + 1u]; k > first[x]; k--)
+        stack[top++] = kids[k - 1u];
+    }
+  }
+
+  // Children follow their parent, so one reverse pass totals every subtree
+  for (uint32_t k = g->len; k-- > 0;) {
+    uint32_t p = parent[node_at[k]];
+    if (p != TG_NONE)
+      g->span[pos_of[p]] += g->span[k];
+  }
+
+  epoch_map_clear(&g->pos);
+  for (uint32_t k = 0; k < g->len; k++)
+    epoch_map_insert(&g->pos, g->order[k], (void*)(uintptr_t)(k + 1u));
+
+  free(stack);
+  free(node_at);
+  free(fill);
+  free(kids);
+  free(linked);
+  free(first);
+  free(parent);
+}
+
+size_t transient_groups_subtree(const transient_groups_t* g, handle_t h, const handle_t** out) {
+  uintptr_t pos = (uintptr_t)epoch_map_get(&g->pos, h);
+  if (!pos)
+    return 0;
+  *out = &g->order[pos - 1u];
+  return g->span[pos - 1u];
+}
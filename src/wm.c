@@ -32,8 +32,10 @@
 #include "event.h"
 #include "frame.h"
 #include "hxm.h"
+#include "placement.h"
 #include "snap.h"
 #include "wm_internal.h"
+#include "xi2.h"
 
 // Small helpers
 
@@ -52,8 +54,7 @@ enum {
   NET_WM_MOVERESIZE_CANCEL = 11,
 };
 
-static void wm_apply_monitor_snapshot(server_t* s, monitor_t* next_monitors, uint32_t active_count);
-static void wm_record_pointer_root(server_t* s, int16_t root_x, int16_t root_y);
+static void wm_record_pointer_root(server_t* s, xcb_window_t root, int16_t root_x, int16_t root_y);
 static void wm_handle_randr_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err);
 static void wm_handle_grab_pointer_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err);
 
@@ -72,10 +73,14 @@ static void add_ignore_unmaps(client_hot_t* hot, uint8_t n) {
   hot->ignore_unmap = (sum > UINT8_MAX) ? UINT8_MAX : (uint8_t)sum;
 }
 
-static bool check_wm_s0_available(server_t* s) {
-  xcb_get_selection_owner_cookie_t cookie = xcb_get_selection_owner(s->conn, atoms.WM_S0);
+static xcb_atom_t wm_selection(const screen_t* scr) {
+  return scr->wm_selection != XCB_NONE ? scr->wm_selection : atoms.WM_S0;
+}
+
+static bool check_wm_s0_available(server_t* s, const screen_t* scr) {
+  xcb_get_selection_owner_cookie_t cookie = xcb_get_selection_owner(s->conn, wm_selection(scr));
   // SYNC_REPLY_EXEMPT: startup WM_S0 probe only; bound<=12 blocking replies
-  // per wm_become attempt (not in hot event loop).
+  // per screen per wm_become attempt (not in hot event loop).
   xcb_get_selection_owner_reply_t* reply = xcb_get_selection_owner_reply(s->conn, cookie, NULL);
   if (!reply)
     return false;
@@ -91,7 +96,9 @@ static void set_root_cursor(server_t* s, uint16_t cursor_font_id) {
   xcb_create_glyph_cursor(s->conn, cursor, font, font, cursor_font_id, cursor_font_id + 1, 0, 0, 0, 0xffff, 0xffff, 0xffff);
   uint32_t mask = XCB_CW_CURSOR;
   uint32_t values[] = {cursor};
-  xcb_change_window_attributes(s->conn, s->root, mask, values);
+  // A cursor is not tied to a screen; one serves every root
+  for (uint32_t i = 0; i < server_screen_count(s); i++)
+    xcb_change_window_attributes(s->conn, s->screens[i].root, mask, values);
   xcb_free_cursor(s->conn, cursor);
   xcb_close_font(s->conn, font);
 }
@@ -110,11 +117,12 @@ static bool wm_show_desktop_hides_client(const client_hot_t* hot) {
 static bool wm_maybe_exit_showing_desktop_for_client(server_t* s, const client_hot_t* hot) {
   if (!s || !hot)
     return false;
-  if (!s->showing_desktop)
+  screen_t* scr = client_screen(s, hot);
+  if (!scr->showing_desktop)
     return false;
   if (!wm_show_desktop_hides_client(hot))
     return false;
-  wm_set_showing_desktop(s, false);
+  wm_set_showing_desktop(s, scr, false);
   return true;
 }
 
@@ -135,7 +143,7 @@ static bool wm_net_active_request_allowed(server_t* s, handle_t target, const cl
   }
 
   bool request_from_user = (source == 2);
-  bool off_desktop = !hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != s->current_desktop;
+  bool off_desktop = !hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != client_screen(s, hot)->current_desktop;
   if (off_desktop && !request_from_user) {
     LOG_INFO("Ignoring _NET_ACTIVE_WINDOW non-user cross-desktop request source=%u", source);
     return false;
@@ -183,33 +191,10 @@ static bool wm_is_above_in_layer(const server_t* s, const client_hot_t* a, const
   if (layer_a != layer_b || layer_a < 0 || layer_a >= LAYER_COUNT)
     return false;
 
-  const small_vec_t* v = &s->layers[layer_a];
-  int32_t idx_a = a->stacking_index;
-  int32_t idx_b = b->stacking_index;
-
-  bool a_valid = (idx_a >= 0 && (size_t)idx_a < v->length && ptr_to_handle(v->items[idx_a]) == a->self);
-  bool b_valid = (idx_b >= 0 && (size_t)idx_b < v->length && ptr_to_handle(v->items[idx_b]) == b->self);
-  if (a_valid && b_valid)
-    return idx_a > idx_b;
-
-  idx_a = -1;
-  idx_b = -1;
-  for (size_t i = 0; i < v->length; i++) {
-    handle_t h = ptr_to_handle(v->items[i]);
-    if (h == a->self)
-      idx_a = (int32_t)i;
-    if (h == b->self)
-      idx_b = (int32_t)i;
-    if (idx_a >= 0 && idx_b >= 0)
-      break;
-  }
-
-  if (idx_a >= 0)
-    ((client_hot_t*)a)->stacking_index = idx_a;
-  if (idx_b >= 0)
-    ((client_hot_t*)b)->stacking_index = idx_b;
-
-  return (idx_a >= 0 && idx_b >= 0 && idx_a > idx_b);
+  // Labels order a layer, so no position lookup is needed
+  if (a->stacking_layer != layer_a || b->stacking_layer != layer_b)
+    return false;
+  return a->stacking_label > b->stacking_label;
 }
 
 static bool wm_restack_desktop_compatible(const client_hot_t* hot, const client_hot_t* sibling) {
@@ -237,7 +222,7 @@ static bool wm_restack_sibling_eligible(server_t* s, handle_t h, const client_ho
 }
 
 static void wm_stash_unmanaged_state_message(server_t* s, xcb_window_t win, uint32_t action, xcb_atom_t p1, xcb_atom_t p2) {
-  if (!s || win == XCB_NONE || win == s->root)
+  if (!s || win == XCB_NONE || server_screen_of_root(s, win))
     return;
   if (action > 2)
     return;
@@ -275,34 +260,55 @@ void wm_set_frame_extents_for_window(server_t* s, xcb_window_t win, bool undecor
   xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, win, atoms._NET_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 32, 4, extents);
 }
 
-static void wm_record_pointer_root(server_t* s, int16_t root_x, int16_t root_y) {
+static void wm_record_pointer_root(server_t* s, xcb_window_t root, int16_t root_x, int16_t root_y) {
   if (!s)
     return;
+  server_screen_enter(s, root);
   s->pointer_root_x = root_x;
   s->pointer_root_y = root_y;
   s->pointer_root_valid = true;
 }
 
-static void wm_clear_pending_randr(server_t* s) {
-  if (!s)
-    return;
-  if (s->randr_pending_monitors) {
-    free(s->randr_pending_monitors);
-    s->randr_pending_monitors = NULL;
+static void wm_clear_pending_randr(screen_t* scr) {
+  if (scr->randr_pending_monitors) {
+    free(scr->randr_pending_monitors);
+    scr->randr_pending_monitors = NULL;
+  }
+  scr->randr_pending_capacity = 0;
+  scr->randr_pending_replies = 0;
+  free(scr->randr_pending_modes);
+  scr->randr_pending_modes = NULL;
+  scr->randr_pending_mode_count = 0;
+}
+
+uint32_t wm_randr_mode_refresh_mhz(const xcb_randr_mode_info_t* mode) {
+  uint64_t vtotal = mode->vtotal;
+  if (mode->mode_flags & XCB_RANDR_MODE_FLAG_DOUBLE_SCAN)
+    vtotal *= 2u;
+  if (mode->mode_flags & XCB_RANDR_MODE_FLAG_INTERLACE)
+    vtotal /= 2u;
+  if (mode->htotal == 0 || vtotal == 0)
+    return 0;
+  return (uint32_t)((uint64_t)mode->dot_clock * 1000u / ((uint64_t)mode->htotal * vtotal));
+}
+
+static uint32_t wm_pending_mode_refresh(const screen_t* scr, xcb_randr_mode_t id) {
+  for (uint32_t i = 0; i < scr->randr_pending_mode_count; i++) {
+    if (scr->randr_pending_modes[i].id == id)
+      return scr->randr_pending_modes[i].refresh_mhz;
   }
-  s->randr_pending_capacity = 0;
-  s->randr_pending_replies = 0;
+  return 0;
 }
 
-static void wm_finalize_pending_randr(server_t* s, uint64_t generation) {
-  if (!s || generation != s->randr_pending_generation)
+static void wm_finalize_pending_randr(server_t* s, screen_t* scr, uint64_t generation) {
+  if (generation != scr->randr_pending_generation)
     return;
 
-  monitor_t* next_monitors = s->randr_pending_monitors;
+  monitor_t* next_monitors = scr->randr_pending_monitors;
   uint32_t active_count = 0;
 
-  if (next_monitors && s->randr_pending_capacity > 0) {
-    for (uint32_t i = 0; i < s->randr_pending_capacity; i++) {
+  if (next_monitors && scr->randr_pending_capacity > 0) {
+    for (uint32_t i = 0; i < scr->randr_pending_capacity; i++) {
       monitor_t* m = &next_monitors[i];
       if (m->geom.w == 0 || m->geom.h == 0)
         continue;
@@ -312,21 +318,32 @@ static void wm_finalize_pending_randr(server_t* s, uint64_t generation) {
     }
   }
 
-  s->randr_pending_monitors = NULL;
-  s->randr_pending_capacity = 0;
-  s->randr_pending_replies = 0;
+  scr->randr_pending_monitors = NULL;
+  scr->randr_pending_capacity = 0;
+  scr->randr_pending_replies = 0;
+  free(scr->randr_pending_modes);
+  scr->randr_pending_modes = NULL;
+  scr->randr_pending_mode_count = 0;
 
-  wm_apply_monitor_snapshot(s, next_monitors, active_count);
+  wm_apply_monitor_snapshot(s, scr, next_monitors, active_count);
 }
 
+/*
+ * RandR replies carry their screen's index in the high 32 bits of data, the
+ * CRTC index in the low ones; each screen runs its own generation.
+ */
 static void wm_handle_randr_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
   if (!s || !slot)
     return;
-  if (slot->txn_id != s->randr_pending_generation)
+  uint32_t screen = (uint32_t)(slot->data >> 32);
+  if (screen >= server_screen_count(s))
+    return;
+  screen_t* scr = &s->screens[screen];
+  if (slot->txn_id != scr->randr_pending_generation)
     return;
 
   if (slot->type == COOKIE_RANDR_GET_SCREEN_RESOURCES) {
-    wm_clear_pending_randr(s);
+    wm_clear_pending_randr(scr);
 
     if (err || !reply) {
       LOG_WARN("RandR resources reply failed");
@@ -336,55 +353,72 @@ static void wm_handle_randr_reply(server_t* s, const cookie_slot_t* slot, void*
     xcb_randr_get_screen_resources_current_reply_t* res = (xcb_randr_get_screen_resources_current_reply_t*)reply;
     int num_crtcs = xcb_randr_get_screen_resources_current_crtcs_length(res);
     if (num_crtcs <= 0) {
-      wm_apply_monitor_snapshot(s, NULL, 0);
+      wm_apply_monitor_snapshot(s, scr, NULL, 0);
       return;
     }
 
-    s->randr_pending_monitors = calloc((size_t)num_crtcs, sizeof(monitor_t));
-    if (!s->randr_pending_monitors) {
+    scr->randr_pending_monitors = calloc((size_t)num_crtcs, sizeof(monitor_t));
+    if (!scr->randr_pending_monitors) {
       LOG_ERROR("Failed to allocate pending monitor snapshot");
       return;
     }
 
-    s->randr_pending_capacity = (uint32_t)num_crtcs;
-    s->randr_pending_replies = (uint32_t)num_crtcs;
+    scr->randr_pending_capacity = (uint32_t)num_crtcs;
+    scr->randr_pending_replies = (uint32_t)num_crtcs;
+
+    // CRTC info only names its mode; keep the rates until those replies land
+    int num_modes = xcb_randr_get_screen_resources_current_modes_length(res);
+    if (num_modes > 0) {
+      scr->randr_pending_modes = calloc((size_t)num_modes, sizeof(randr_mode_rate_t));
+      if (scr->randr_pending_modes) {
+        xcb_randr_mode_info_t* modes = xcb_randr_get_screen_resources_current_modes(res);
+        for (int i = 0; i < num_modes; i++) {
+          scr->randr_pending_modes[i].id = modes[i].id;
+          scr->randr_pending_modes[i].refresh_mhz = wm_randr_mode_refresh_mhz(&modes[i]);
+        }
+        scr->randr_pending_mode_count = (uint32_t)num_modes;
+      }
+    }
 
     xcb_randr_crtc_t* crtcs = xcb_randr_get_screen_resources_current_crtcs(res);
     for (int i = 0; i < num_crtcs; i++) {
+      scr->randr_pending_monitors[i].crtc = crtcs[i];
       xcb_randr_get_crtc_info_cookie_t ck = xcb_randr_get_crtc_info(s->conn, crtcs[i], res->config_timestamp);
       if (ck.sequence == 0) {
-        s->randr_pending_replies--;
+        scr->randr_pending_replies--;
         continue;
       }
-      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_RANDR_GET_CRTC_INFO, HANDLE_INVALID, (uintptr_t)i, slot->txn_id, wm_handle_randr_reply);
+      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_RANDR_GET_CRTC_INFO, HANDLE_INVALID, ((uint64_t)screen << 32) | (uint32_t)i, slot->txn_id,
+                      wm_handle_randr_reply);
     }
 
-    if (s->randr_pending_replies == 0) {
-      wm_finalize_pending_randr(s, slot->txn_id);
+    if (scr->randr_pending_replies == 0) {
+      wm_finalize_pending_randr(s, scr, slot->txn_id);
     }
     return;
   }
 
   if (slot->type == COOKIE_RANDR_GET_CRTC_INFO) {
-    if (s->randr_pending_replies == 0)
+    if (scr->randr_pending_replies == 0)
       return;
 
-    uint32_t idx = (uint32_t)slot->data;
-    if (!err && reply && s->randr_pending_monitors && idx < s->randr_pending_capacity) {
+    uint32_t idx = (uint32_t)(slot->data & 0xFFFFFFFFu);
+    if (!err && reply && scr->randr_pending_monitors && idx < scr->randr_pending_capacity) {
       xcb_randr_get_crtc_info_reply_t* crtc = (xcb_randr_get_crtc_info_reply_t*)reply;
       if (crtc->mode != XCB_NONE) {
-        monitor_t* m = &s->randr_pending_monitors[idx];
+        monitor_t* m = &scr->randr_pending_monitors[idx];
         m->geom.x = crtc->x;
         m->geom.y = crtc->y;
         m->geom.w = crtc->width;
         m->geom.h = crtc->height;
         m->workarea = m->geom;
+        m->refresh_mhz = wm_pending_mode_refresh(scr, crtc->mode);
       }
     }
 
-    s->randr_pending_replies--;
-    if (s->randr_pending_replies == 0) {
-      wm_finalize_pending_randr(s, slot->txn_id);
+    scr->randr_pending_replies--;
+    if (scr->randr_pending_replies == 0) {
+      wm_finalize_pending_randr(s, scr, slot->txn_id);
     }
   }
 }
@@ -405,18 +439,43 @@ static void wm_handle_grab_pointer_reply(server_t* s, const cookie_slot_t* slot,
     return;
   }
 
-  xcb_grab_pointer_reply_t* r = (xcb_grab_pointer_reply_t*)reply;
-  if (r->status != XCB_GRAB_STATUS_SUCCESS) {
-    LOG_ERROR("grab_pointer failed status=%u on root=%u", r->status, s->root);
+  uint8_t status = s->interaction_xi2 ? xi2_grab_status(reply) : ((xcb_grab_pointer_reply_t*)reply)->status;
+  if (status != XCB_GRAB_STATUS_SUCCESS) {
+    LOG_ERROR("grab_pointer failed status=%u on root=%u", status, server_screen(s)->root);
     wm_cancel_interaction(s);
     return;
   }
 
   s->interaction_pointer_grabbed = true;
-  LOG_INFO("grab_pointer success status=%u on root=%u", r->status, s->root);
+  LOG_INFO("grab_pointer success status=%u on root=%u", status, server_screen(s)->root);
 }
 
-void wm_update_monitors(server_t* s) {
+static void wm_handle_grab_keyboard_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  if (!s || !slot)
+    return;
+  if (slot->type != COOKIE_GRAB_KEYBOARD)
+    return;
+
+  // An interaction that ended first already released the keyboard
+  xcb_window_t frame = (xcb_window_t)slot->data;
+  if (!s->interaction_keyboard_pending || s->interaction_window != frame)
+    return;
+  s->interaction_keyboard_pending = false;
+
+  // Without the keyboard the pointer can still finish the interaction
+  if (err || !reply) {
+    LOG_WARN("grab_keyboard async reply failed");
+    return;
+  }
+  uint8_t status = ((xcb_grab_keyboard_reply_t*)reply)->status;
+  if (status != XCB_GRAB_STATUS_SUCCESS) {
+    LOG_WARN("grab_keyboard failed status=%u on root=%u", status, server_screen(s)->root);
+    return;
+  }
+  s->interaction_keyboard_grabbed = true;
+}
+
+void wm_update_monitors(server_t* s, screen_t* scr) {
   if (!s || !s->conn)
     return;
 
@@ -424,61 +483,161 @@ void wm_update_monitors(server_t* s) {
     monitor_t* next_monitors = calloc(1, sizeof(monitor_t));
     if (!next_monitors)
       return;
-    xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+    xcb_screen_t* screen = xcb_screen_of(s->conn, scr->num);
     next_monitors[0].geom.x = 0;
     next_monitors[0].geom.y = 0;
     next_monitors[0].geom.w = (uint16_t)screen->width_in_pixels;
     next_monitors[0].geom.h = (uint16_t)screen->height_in_pixels;
     next_monitors[0].workarea = next_monitors[0].geom;
-    wm_apply_monitor_snapshot(s, next_monitors, 1);
+    wm_apply_monitor_snapshot(s, scr, next_monitors, 1);
     return;
   }
 
   if (!s->cookie_jar.slots)
     return;
 
-  s->randr_pending_generation++;
-  wm_clear_pending_randr(s);
+  scr->randr_pending_generation++;
+  wm_clear_pending_randr(scr);
 
-  xcb_randr_get_screen_resources_current_cookie_t ck = xcb_randr_get_screen_resources_current(s->conn, s->root);
+  xcb_randr_get_screen_resources_current_cookie_t ck = xcb_randr_get_screen_resources_current(s->conn, scr->root);
   if (ck.sequence == 0) {
     LOG_WARN("RandR resources request returned zero sequence; skipping async update");
     return;
   }
 
-  cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_RANDR_GET_SCREEN_RESOURCES, HANDLE_INVALID, 0, s->randr_pending_generation, wm_handle_randr_reply);
+  cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_RANDR_GET_SCREEN_RESOURCES, HANDLE_INVALID, (uint64_t)server_screen_index(s, scr) << 32,
+                  scr->randr_pending_generation, wm_handle_randr_reply);
 }
 
 void wm_get_monitor_geometry(server_t* s, client_hot_t* hot, rect_t* out_geom) {
+  const screen_t* scr = client_screen(s, hot);
   // Default to first monitor or whole screen
-  if (s->monitor_count > 0) {
-    *out_geom = s->monitors[0].geom;
+  if (scr->monitor_count > 0) {
+    *out_geom = scr->monitors[0].geom;
   }
   else {
-    xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+    xcb_screen_t* screen = xcb_screen_of(s->conn, scr->num);
     out_geom->x = 0;
     out_geom->y = 0;
     out_geom->w = (uint16_t)screen->width_in_pixels;
     out_geom->h = (uint16_t)screen->height_in_pixels;
   }
 
-  if (s->monitor_count <= 1)
+  if (scr->monitor_count <= 1)
     return;
 
-  // Use center of the window to determine which monitor it is on
-  int center_x = hot->server.x + hot->server.w / 2;
-  int center_y = hot->server.y + hot->server.h / 2;
+  // Monitor holding the centre of the committed geometry
+  *out_geom = scr->monitors[wm_client_monitor(s, hot)].geom;
+}
 
-  for (uint32_t i = 0; i < s->monitor_count; i++) {
-    monitor_t* m = &s->monitors[i];
-    if (center_x >= m->geom.x && center_x < m->geom.x + (int)m->geom.w && center_y >= m->geom.y && center_y < m->geom.y + (int)m->geom.h) {
-      *out_geom = m->geom;
-      break;
+static bool wm_monitor_same(const monitor_t* a, const monitor_t* b) {
+  return a->crtc == b->crtc && a->refresh_mhz == b->refresh_mhz && a->geom.x == b->geom.x && a->geom.y == b->geom.y && a->geom.w == b->geom.w &&
+         a->geom.h == b->geom.h;
+}
+
+/*
+ * Where the clients of old monitor o go in the next snapshot: the monitor
+ * with the same CRTC, else one covering the same area, else the first. Sets
+ * *moved when their geometry has to follow.
+ */
+static uint32_t wm_monitor_successor(const monitor_t* o, const monitor_t* next, uint32_t count, bool* moved) {
+  for (uint32_t i = 0; i < count; i++) {
+    if (next[i].crtc == o->crtc) {
+      *moved = next[i].geom.x != o->geom.x || next[i].geom.y != o->geom.y || next[i].geom.w != o->geom.w || next[i].geom.h != o->geom.h;
+      return i;
     }
   }
+  for (uint32_t i = 0; i < count; i++) {
+    if (next[i].geom.x == o->geom.x && next[i].geom.y == o->geom.y && next[i].geom.w == o->geom.w && next[i].geom.h == o->geom.h) {
+      *moved = false;
+      return i;
+    }
+  }
+  *moved = true;
+  return 0;
+}
+
+/*
+ * r at the same place relative to monitor `to` as it had on `from`. Offsets
+ * scale with the monitor size; when the size changes, r is also shrunk and
+ * pushed to fit.
+ */
+static rect_t wm_rect_relocate(rect_t r, rect_t from, rect_t to) {
+  int64_t dx = (int64_t)r.x - from.x;
+  int64_t dy = (int64_t)r.y - from.y;
+  if (from.w == to.w && from.h == to.h) {
+    r.x = (int16_t)(to.x + dx);
+    r.y = (int16_t)(to.y + dy);
+    return r;
+  }
+  if (from.w)
+    dx = dx * to.w / from.w;
+  if (from.h)
+    dy = dy * to.h / from.h;
+  if (r.w > to.w)
+    r.w = to.w;
+  if (r.h > to.h)
+    r.h = to.h;
+  int64_t x = to.x + dx;
+  int64_t y = to.y + dy;
+  if (x + r.w > (int64_t)to.x + to.w)
+    x = (int64_t)to.x + to.w - r.w;
+  if (y + r.h > (int64_t)to.y + to.h)
+    y = (int64_t)to.y + to.h - r.h;
+  r.x = (int16_t)(x < to.x ? to.x : x);
+  r.y = (int16_t)(y < to.y ? to.y : y);
+  return r;
+}
+
+/*
+ * Clients of monitors that moved, changed size or went away keep their place
+ * relative to the monitor that takes them. Everyone else is left alone: their
+ * geometry does not depend on the monitors that changed. Docks and desktop
+ * windows place themselves.
+ */
+static void wm_relocate_clients(server_t* s, const screen_t* scr, const monitor_t* old, uint32_t old_count) {
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    client_hot_t* hot = server_chot(s, s->active_clients.items[i]);
+    if (!hot || hot->state == STATE_UNMANAGING || hot->state == STATE_DESTROYED)
+      continue;
+    if (client_screen(s, hot) != scr)
+      continue;
+    if (hot->type == WINDOW_TYPE_DOCK || hot->type == WINDOW_TYPE_DESKTOP)
+      continue;
+
+    int cx = hot->server.x + (int32_t)hot->server.w / 2;
+    int cy = hot->server.y + (int32_t)hot->server.h / 2;
+    uint32_t o = 0;
+    while (o < old_count && !(cx >= old[o].geom.x && cx < old[o].geom.x + (int)old[o].geom.w && cy >= old[o].geom.y && cy < old[o].geom.y + (int)old[o].geom.h))
+      o++;
+    if (o == old_count)
+      continue;
+
+    bool moved = false;
+    uint32_t n = wm_monitor_successor(&old[o], scr->monitors, scr->monitor_count, &moved);
+    if (!moved)
+      continue;
+
+    rect_t from = old[o].geom;
+    rect_t to = scr->monitors[n].geom;
+    hot->desired = wm_rect_relocate(hot->desired, from, to);
+    if (hot->saved_maximize_valid)
+      hot->saved_maximize_geom = wm_rect_relocate(hot->saved_maximize_geom, from, to);
+    if (hot->layer == LAYER_FULLSCREEN)
+      hot->saved_geom = wm_rect_relocate(hot->saved_geom, from, to);
+    // The committed geometry still points at the old place until the flush
+    if (n <= UINT8_MAX) {
+      hot->monitor = (uint8_t)n;
+      hot->monitor_gen = scr->monitor_generation;
+    }
+    if (hot->layer == LAYER_FULLSCREEN && !s->config.fullscreen_use_workarea)
+      hot->desired = to;
+    server_mark_dirty(s, hot, DIRTY_GEOM);
+    s->monitor_clients_moved++;
+  }
 }
 
-static void wm_apply_monitor_snapshot(server_t* s, monitor_t* next_monitors, uint32_t active_count) {
+void wm_apply_monitor_snapshot(server_t* s, screen_t* scr, monitor_t* next_monitors, uint32_t active_count) {
   if (!s)
     return;
 
@@ -487,30 +646,51 @@ static void wm_apply_monitor_snapshot(server_t* s, monitor_t* next_monitors, uin
     next_monitors = NULL;
   }
 
-  if (s->monitors)
-    free(s->monitors);
-
-  s->monitors = next_monitors;
-  s->monitor_count = active_count;
-  LOG_INFO("Monitor update: %u monitors detected", s->monitor_count);
+  // Some drivers repeat the same configuration on every hotplug poll
+  bool same = active_count == scr->monitor_count;
+  for (uint32_t i = 0; same && i < active_count; i++)
+    same = wm_monitor_same(&next_monitors[i], &scr->monitors[i]);
+  if (same) {
+    free(next_monitors);
+    s->monitor_snapshots_same++;
+    LOG_DEBUG("Monitor update: configuration unchanged");
+    return;
+  }
 
-  s->workarea_dirty = true;
-  s->root_dirty |= ROOT_DIRTY_WORKAREA;
+  monitor_t* old = scr->monitors;
+  uint32_t old_count = scr->monitor_count;
+  scr->monitors = next_monitors;
+  scr->monitor_count = active_count;
 
-  if (!s->config.fullscreen_use_workarea) {
+  // Cached client monitor indices refer to the old snapshot. On wrap the
+  // tags are cleared so an ancient one cannot match again.
+  scr->monitor_generation++;
+  if (scr->monitor_generation == 0) {
+    scr->monitor_generation = 1;
     for (size_t i = 0; i < s->active_clients.length; i++) {
-      handle_t h = ptr_to_handle(s->active_clients.items[i]);
-      client_hot_t* hot = server_chot(s, h);
-      if (!hot || hot->layer != LAYER_FULLSCREEN)
-        continue;
-      wm_get_monitor_geometry(s, hot, &hot->desired);
-      hot->dirty |= DIRTY_GEOM;
+      client_hot_t* hot = server_chot(s, s->active_clients.items[i]);
+      if (hot)
+        hot->monitor_gen = 0;
     }
   }
+  LOG_INFO("Monitor update: %u monitors detected", scr->monitor_count);
+  for (uint32_t i = 0; i < scr->monitor_count; i++)
+    LOG_DEBUG("Monitor %u: %ux%u+%d+%d refresh=%.3f Hz", i, scr->monitors[i].geom.w, scr->monitors[i].geom.h, scr->monitors[i].geom.x, scr->monitors[i].geom.y,
+              scr->monitors[i].refresh_mhz / 1000.0);
+
+  if (active_count > 0)
+    wm_relocate_clients(s, scr, old, old_count);
+  free(old);
+
+  // Maximized and fullscreen clients follow their workarea from here, once
+  // the relocated ones are tagged with their new monitor
+  wm_workarea_invalidate(scr);
+  scr->workarea_dirty = true;
+  scr->root_dirty |= ROOT_DIRTY_WORKAREA;
 }
 
 static void wm_client_apply_maximize(server_t* s, client_hot_t* hot) {
-  rect_t wa = s->workarea;
+  rect_t wa = client_screen(s, hot)->workarea;
   wm_get_client_workarea(s, hot, &wa);
 
   uint16_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
@@ -572,32 +752,44 @@ void wm_client_set_maximize(server_t* s, client_hot_t* hot, bool max_horz, bool
     wm_client_apply_maximize(s, hot);
   }
 
-  hot->dirty |= DIRTY_GEOM | DIRTY_STATE;
+  server_mark_dirty(s, hot, DIRTY_GEOM | DIRTY_STATE);
+}
+
+bool wm_client_refit_maximize(server_t* s, client_hot_t* hot) {
+  rect_t before = hot->desired;
+  wm_client_apply_maximize(s, hot);
+  if (hot->desired.x == before.x && hot->desired.y == before.y && hot->desired.w == before.w && hot->desired.h == before.h)
+    return false;
+  server_mark_dirty(s, hot, DIRTY_GEOM);
+  return true;
 }
 
 /*
  * wm_become:
- * Try to become the Window Manager for the screen.
+ * Try to become the Window Manager for every managed screen. Each screen is
+ * taken on its own; one whose WM_Sn another WM holds keeps
+ * supporting_wm_check at XCB_WINDOW_NONE.
  *
+ * Per screen:
  * 1. Acquire WM_S0 selection: This is the cooperative lock used by EWMH/ICCCM
  *    to ensure only one WM is running.
  * 2. Select SubstructureRedirect: This is the X protocol mechanism that
  * intercepts window map/configure requests, allowing us to control placement.
  *    If this fails (BadAccess), another WM is already running.
  */
-void wm_become(server_t* s) {
+static void wm_become_screen(server_t* s, screen_t* scr) {
   xcb_connection_t* conn = s->conn;
-  xcb_window_t root = s->root;
+  xcb_window_t root = scr->root;
 
   // Retry loop for WM_S0 acquisition (handle race during restart)
   for (int i = 0; i < 10; i++) {
-    if (check_wm_s0_available(s))
+    if (check_wm_s0_available(s, scr))
       break;
     struct timespec ts = {0, 100000000};  // 100ms
     nanosleep(&ts, NULL);
   }
 
-  if (!check_wm_s0_available(s)) {
+  if (!check_wm_s0_available(s, scr)) {
     LOG_ERROR("Refusing to become WM: WM_S0 is already owned");
     return;
   }
@@ -614,9 +806,6 @@ void wm_become(server_t* s) {
     return;
   }
 
-  // Set cursor (left_ptr)
-  set_root_cursor(s, XC_left_ptr);
-
   // Set _NET_SUPPORTED with basic atoms
   xcb_atom_t supported_atoms[] = {
       atoms._NET_SUPPORTED,
@@ -701,22 +890,22 @@ void wm_become(server_t* s) {
   xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_SUPPORTED, XCB_ATOM_ATOM, 32, (uint32_t)(sizeof(supported_atoms) / sizeof(supported_atoms[0])), supported_atoms);
 
   // Create supporting WM check window
-  s->supporting_wm_check = xcb_generate_id(conn);
+  scr->supporting_wm_check = xcb_generate_id(conn);
   uint32_t mask = XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK;
   uint32_t values[] = {1, XCB_EVENT_MASK_PROPERTY_CHANGE};
 
-  xcb_create_window(conn, XCB_COPY_FROM_PARENT, s->supporting_wm_check, root, 0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, mask, values);
+  xcb_create_window(conn, XCB_COPY_FROM_PARENT, scr->supporting_wm_check, root, 0, 0, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, mask, values);
 
   // Acquire WM_S0 selection (EWMH)
-  xcb_set_selection_owner(conn, s->supporting_wm_check, atoms.WM_S0, XCB_CURRENT_TIME);
+  xcb_set_selection_owner(conn, scr->supporting_wm_check, wm_selection(scr), XCB_CURRENT_TIME);
 
   // Verify ownership (defensive)
   {
-    xcb_get_selection_owner_cookie_t ck = xcb_get_selection_owner(conn, atoms.WM_S0);
+    xcb_get_selection_owner_cookie_t ck = xcb_get_selection_owner(conn, wm_selection(scr));
     // SYNC_REPLY_EXEMPT: startup WM_S0 verification only; bound<=12 blocking
-    // replies per wm_become attempt (not in hot event loop).
+    // replies per screen per wm_become attempt (not in hot event loop).
     xcb_get_selection_owner_reply_t* rep = xcb_get_selection_owner_reply(conn, ck, NULL);
-    if (!rep || rep->owner != s->supporting_wm_check) {
+    if (!rep || rep->owner != scr->supporting_wm_check) {
       LOG_ERROR("Failed to acquire WM_S0 selection");
       free(rep);
       return;
@@ -725,129 +914,301 @@ void wm_become(server_t* s) {
   }
 
   // Set _NET_SUPPORTING_WM_CHECK on root and on the window
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, 32, 1, &s->supporting_wm_check);
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, s->supporting_wm_check, atoms._NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, 32, 1, &s->supporting_wm_check);
+  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, 32, 1, &scr->supporting_wm_check);
+  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, scr->supporting_wm_check, atoms._NET_SUPPORTING_WM_CHECK, XCB_ATOM_WINDOW, 32, 1, &scr->supporting_wm_check);
 
   // Set _NET_WM_NAME on supporting window (and optionally root)
   const char* wm_name = "hxm";
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, s->supporting_wm_check, atoms._NET_WM_NAME, atoms.UTF8_STRING, 8, (uint32_t)strlen(wm_name), wm_name);
+  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, scr->supporting_wm_check, atoms._NET_WM_NAME, atoms.UTF8_STRING, 8, (uint32_t)strlen(wm_name), wm_name);
   xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_WM_NAME, atoms.UTF8_STRING, 8, (uint32_t)strlen(wm_name), wm_name);
 
   // Set _NET_WM_PID
   uint32_t pid = (uint32_t)getpid();
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, s->supporting_wm_check, atoms._NET_WM_PID, XCB_ATOM_CARDINAL, 32, 1, &pid);
+  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, scr->supporting_wm_check, atoms._NET_WM_PID, XCB_ATOM_CARDINAL, 32, 1, &pid);
   // Also set on root for completeness (some pagers check root)
   xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_WM_PID, XCB_ATOM_CARDINAL, 32, 1, &pid);
 
   // Map the window so it is "viewable" as required by some tools
-  xcb_map_window(conn, s->supporting_wm_check);
+  xcb_map_window(conn, scr->supporting_wm_check);
 
   // _NET_DESKTOP_GEOMETRY
-  xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(conn)).data;
+  xcb_screen_t* screen = xcb_screen_of(conn, scr->num);
   uint32_t geometry[] = {screen->width_in_pixels, screen->height_in_pixels};
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_DESKTOP_GEOMETRY, XCB_ATOM_CARDINAL, 32, 2, geometry);
+  wm_publish_root_prop(s, scr, ROOT_PROP_DESKTOP_GEOMETRY, atoms._NET_DESKTOP_GEOMETRY, XCB_ATOM_CARDINAL, 32, 2, geometry);
 
   // Initialize workarea to full screen (no struts yet)
-  s->workarea.x = 0;
-  s->workarea.y = 0;
-  s->workarea.w = (uint16_t)screen->width_in_pixels;
-  s->workarea.h = (uint16_t)screen->height_in_pixels;
+  scr->workarea.x = 0;
+  scr->workarea.y = 0;
+  scr->workarea.w = (uint16_t)screen->width_in_pixels;
+  scr->workarea.h = (uint16_t)screen->height_in_pixels;
 
-  // Publish an initial _NET_WORKAREA unconditionally so clients can read it
-  // even when the first computed workarea equals the initialized value.
+  // Publish an initial _NET_WORKAREA so clients can read it; the computed
+  // one below is written only if it differs
   {
-    uint32_t n = s->desktop_count ? s->desktop_count : 1;
+    uint32_t n = scr->desktop_count ? scr->desktop_count : 1;
     uint32_t* wa_vals = calloc((size_t)n * 4, sizeof(uint32_t));
     if (wa_vals) {
       for (uint32_t i = 0; i < n; i++) {
-        wa_vals[i * 4 + 0] = (uint32_t)s->workarea.x;
-        wa_vals[i * 4 + 1] = (uint32_t)s->workarea.y;
-        wa_vals[i * 4 + 2] = (uint32_t)s->workarea.w;
-        wa_vals[i * 4 + 3] = (uint32_t)s->workarea.h;
+        wa_vals[i * 4 + 0] = (uint32_t)scr->workarea.x;
+        wa_vals[i * 4 + 1] = (uint32_t)scr->workarea.y;
+        wa_vals[i * 4 + 2] = (uint32_t)scr->workarea.w;
+        wa_vals[i * 4 + 3] = (uint32_t)scr->workarea.h;
       }
-      xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_WORKAREA, XCB_ATOM_CARDINAL, 32, n * 4, wa_vals);
+      wm_publish_root_prop(s, scr, ROOT_PROP_WORKAREA, atoms._NET_WORKAREA, XCB_ATOM_CARDINAL, 32, n * 4, wa_vals);
       free(wa_vals);
     }
   }
 
-  wm_publish_desktop_props(s);
+  wm_publish_desktop_props(s, scr);
 
   rect_t wa;
-  wm_compute_workarea(s, &wa);
-  wm_publish_workarea(s, &wa);
+  wm_compute_workarea(s, scr, &wa);
+  wm_publish_workarea(s, scr, &wa);
 
   // Initialize root lists and focus to sane empty values
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_CLIENT_LIST, XCB_ATOM_WINDOW, 32, 0, NULL);
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, 32, 0, NULL);
+  wm_publish_root_prop(s, scr, ROOT_PROP_CLIENT_LIST, atoms._NET_CLIENT_LIST, XCB_ATOM_WINDOW, 32, 0, NULL);
+  wm_publish_root_prop(s, scr, ROOT_PROP_CLIENT_LIST_STACKING, atoms._NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, 32, 0, NULL);
   xcb_delete_property(conn, root, atoms._NET_ACTIVE_WINDOW);
   {
     uint32_t val = 0;
-    xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_SHOWING_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &val);
+    wm_publish_root_prop(s, scr, ROOT_PROP_SHOWING_DESKTOP, atoms._NET_SHOWING_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &val);
   }
 
   xcb_flush(conn);
-  LOG_INFO("Became WM on root %u, supporting %u", root, s->supporting_wm_check);
+  LOG_INFO("Became WM on root %u, supporting %u", root, scr->supporting_wm_check);
 }
 
-void wm_release(server_t* s) {
-  if (!s || !s->conn)
-    return;
-  if (s->supporting_wm_check == XCB_WINDOW_NONE)
+void wm_become(server_t* s) {
+  bool any = false;
+  for (uint32_t i = 0; i < server_screen_count(s); i++) {
+    wm_become_screen(s, &s->screens[i]);
+    any |= s->screens[i].supporting_wm_check != XCB_WINDOW_NONE;
+  }
+  // Set cursor (left_ptr)
+  if (any)
+    set_root_cursor(s, XC_left_ptr);
+}
+
+static void wm_release_screen(server_t* s, screen_t* scr) {
+  if (scr->supporting_wm_check == XCB_WINDOW_NONE)
     return;
 
   xcb_connection_t* conn = s->conn;
-  xcb_window_t root = s->root;
-  xcb_window_t support = s->supporting_wm_check;
+  xcb_window_t root = scr->root;
+  xcb_window_t support = scr->supporting_wm_check;
 
   xcb_delete_property(conn, root, atoms._NET_SUPPORTING_WM_CHECK);
   xcb_delete_property(conn, support, atoms._NET_SUPPORTING_WM_CHECK);
   xcb_delete_property(conn, support, atoms._NET_WM_NAME);
 
-  xcb_set_selection_owner(conn, XCB_NONE, atoms.WM_S0, XCB_CURRENT_TIME);
+  xcb_set_selection_owner(conn, XCB_NONE, wm_selection(scr), XCB_CURRENT_TIME);
   xcb_destroy_window(conn, support);
-  xcb_flush(conn);
+  scr->supporting_wm_check = XCB_WINDOW_NONE;
+}
+
+void wm_release(server_t* s) {
+  if (!s || !s->conn)
+    return;
+  for (uint32_t i = 0; i < server_screen_count(s); i++)
+    wm_release_screen(s, &s->screens[i]);
+  xcb_flush(s->conn);
+}
+
+/* Deferred adoption probes completed per tick once the scan is done */
+#define ADOPT_TRICKLE_PER_TICK 4
+/* ... and only while the cookie jar has no more than this in flight */
+#define ADOPT_TRICKLE_MAX_LIVE 64
+
+static void wm_adopt_deferred(server_t* s, xcb_window_t win) {
+  client_manage_start_deferred(s, win);
+  handle_t h = server_get_client_by_window(s, win);
+  if (h != HANDLE_INVALID)
+    handle_vec_push(&s->adopt_deferred, h);
+}
 
-  s->supporting_wm_check = XCB_WINDOW_NONE;
+/* Shown on scr's current desktop if it was on it or sticky; unknown counts as shown */
+static bool wm_adopt_on_current(const screen_t* scr, uint32_t desktop) {
+  return desktop == 0xFFFFFFFFu || desktop == scr->current_desktop;
+}
+
+static void wm_adopt_desktop_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  (void)err;
+  xcb_get_property_reply_t* r = (xcb_get_property_reply_t*)reply;
+  if (!r || r->format != 32 || xcb_get_property_value_length(r) < (int)sizeof(uint32_t))
+    return;
+  uint32_t desktop = *(uint32_t*)xcb_get_property_value(r);
+  hash_map_insert(&s->adopt_desktops, slot->data >> 32, (void*)((uintptr_t)desktop + 1u));
 }
 
 /*
- * wm_adopt_children:
- * Scan for existing windows to manage (e.g., when restarting the WM).
- *
- * Strategy: Async Pipelining
- * We query the tree once, then iterate children and issue async
- * GetWindowAttributes requests for each. We do NOT block on replies here. The
- * replies will be handled by the cookie jar in the main loop, triggering
- * `client_manage_start`.
+ * Scan replies run in request order, so a window's desktop is known by the
+ * time its attributes are. A viewable window on the current desktop is
+ * adopted right away; one on another desktop waits for wm_adopt_complete.
  */
-void wm_adopt_children(server_t* s) {
-  LOG_INFO("Adopting existing windows...");
-  xcb_query_tree_cookie_t cookie = xcb_query_tree(s->conn, s->root);
-  // SYNC_REPLY_EXEMPT: startup adoption snapshot only; bound<=1 blocking reply
-  // per wm_adopt_children invocation.
-  xcb_query_tree_reply_t* reply = xcb_query_tree_reply(s->conn, cookie, NULL);
-  if (!reply)
+static void wm_adopt_attributes_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  xcb_window_t win = (xcb_window_t)(slot->data & 0xFFFFFFFFu);
+  const screen_t* scr = &s->screens[slot->data >> 32];
+  uintptr_t desktop = (uintptr_t)hash_map_get(&s->adopt_desktops, win);
+  hash_map_remove(&s->adopt_desktops, win);
+
+  xcb_get_window_attributes_reply_t* r = err ? NULL : (xcb_get_window_attributes_reply_t*)reply;
+  if (!r)
+    return;
+  LOG_DEBUG("Classify win=%u override=%d class=%d map_state=%d", win, r->override_redirect, r->_class, r->map_state);
+  if (r->_class == XCB_WINDOW_CLASS_INPUT_ONLY || r->override_redirect || r->map_state == XCB_MAP_STATE_UNMAPPED)
+    return;
+  if (server_get_client_by_window(s, win) != HANDLE_INVALID)
     return;
 
+  if (!desktop || wm_adopt_on_current(scr, (uint32_t)(desktop - 1u))) {
+    LOG_INFO("Adopting window %u (map_state %d)", win, r->map_state);
+    client_manage_start(s, win);
+  }
+  else {
+    u32_vec_push(&s->adopt_later, win);
+  }
+}
+
+static void wm_adopt_complete(server_t* s, uint64_t txn_id, handle_t client) {
+  (void)txn_id;
+  (void)client;
+  for (size_t i = 0; i < s->adopt_later.length; i++) {
+    xcb_window_t win = s->adopt_later.items[i];
+    if (server_get_client_by_window(s, win) != HANDLE_INVALID)
+      continue;
+    LOG_INFO("Adopting window %u from another desktop", win);
+    wm_adopt_deferred(s, win);
+  }
+  // Only needed for the scan; give the memory back
+  u32_vec_destroy(&s->adopt_later);
+  hash_map_destroy(&s->adopt_desktops);
+  hash_map_init(&s->adopt_desktops);
+  LOG_INFO("Adoption scan done, %zu clients with deferred probes", s->adopt_deferred.length);
+}
+
+void wm_adopt_trickle(server_t* s) {
+  if (s->adopt_deferred.length == 0 || s->interaction_mode != INTERACTION_NONE || s->cookie_jar.live_count > ADOPT_TRICKLE_MAX_LIVE)
+    return;
+  for (int n = 0; n < ADOPT_TRICKLE_PER_TICK && s->adopt_deferred.length > 0; n++) {
+    client_hot_t* hot = server_chot(s, s->adopt_deferred.items[s->adopt_deferred.length - 1]);
+    if (hot && hot->state == STATE_NEW)
+      return;  // still being managed, newest first
+    s->adopt_deferred.length--;
+    // Stale handles and clients already shown are skipped by client_complete_probe
+    client_complete_probe(s, hot);
+  }
+  if (s->adopt_deferred.length == 0)
+    handle_vec_destroy(&s->adopt_deferred);
+}
+
+/* Queue the desktop and attributes probes for the children of screen n */
+static void wm_adopt_scan(server_t* s, uint32_t n, xcb_query_tree_reply_t* reply, uint64_t txn) {
   xcb_window_t* children = xcb_query_tree_children(reply);
   int len = xcb_query_tree_children_length(reply);
-
   for (int i = 0; i < len; i++) {
     xcb_window_t win = children[i];
-    if (win == s->supporting_wm_check)
+    if (win == s->screens[n].supporting_wm_check || server_get_client_by_window(s, win) != HANDLE_INVALID)
       continue;
 
-    // Defer decision: use async attributes check via cookie jar and adopt in
-    // reply handler
+    // Defer decision: use async desktop and attributes checks via the cookie
+    // jar and adopt in the reply handlers
+    xcb_get_property_cookie_t dk = xcb_get_property(s->conn, 0, win, atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 0, 1);
     xcb_get_window_attributes_cookie_t ck = xcb_get_window_attributes(s->conn, win);
-    if (ck.sequence == 0) {
-      LOG_ERROR("Adopt attributes request returned zero sequence for window %u; skipping", win);
+    if (dk.sequence == 0 || ck.sequence == 0) {
+      LOG_ERROR("Adopt scan request returned zero sequence for window %u; skipping", win);
       continue;
     }
-    cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_WINDOW_ATTRIBUTES, HANDLE_INVALID, (uint64_t)win, s->txn_id, wm_handle_reply);
+    cookie_jar_push(&s->cookie_jar, dk.sequence, COOKIE_GET_PROPERTY, HANDLE_INVALID, ((uint64_t)win << 32) | atoms._NET_WM_DESKTOP, txn,
+                    wm_adopt_desktop_reply);
+    cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_WINDOW_ATTRIBUTES, HANDLE_INVALID, ((uint64_t)n << 32) | win, txn,
+                    wm_adopt_attributes_reply);
   }
+}
 
-  free(reply);
+/*
+ * wm_adopt_children:
+ * Scan for existing windows to manage (e.g., when restarting the WM).
+ *
+ * Strategy: Async Pipelining, visible windows first
+ * We query the tree once, then issue async _NET_WM_DESKTOP and
+ * GetWindowAttributes requests for every child as one cookie group. We do
+ * NOT block on replies here. Windows viewable on the current desktop (or
+ * sticky, or with no desktop) get the full manage probe as their replies are
+ * handled; the rest are adopted once the whole scan answered, with a reduced
+ * probe (see client_manage_start_deferred). Their remaining probes are sent
+ * before they are first shown, or trickled out a few per tick.
+ *
+ * A restart handoff already says where every window was, so those are
+ * ordered the same way without asking.
+ *
+ * Every managed root is scanned; a window is judged against the current
+ * desktop of the screen it was found on.
+ */
+void wm_adopt_children(server_t* s) {
+  LOG_INFO("Adopting existing windows...");
+  uint32_t count = server_screen_count(s);
+  xcb_query_tree_cookie_t cookies[HXM_MAX_SCREENS];
+  xcb_query_tree_reply_t* replies[HXM_MAX_SCREENS];
+  for (uint32_t n = 0; n < count; n++)
+    cookies[n] = xcb_query_tree(s->conn, s->screens[n].root);
+  for (uint32_t n = 0; n < count; n++) {
+    // SYNC_REPLY_EXEMPT: startup adoption snapshot only; bound<=1 blocking
+    // reply per screen per wm_adopt_children invocation.
+    replies[n] = xcb_query_tree_reply(s->conn, cookies[n], NULL);
+  }
+
+  // Windows handed over by the previous process were already classified:
+  // manage those still present right away, shown ones first, each pass
+  // bottom to top.
+  if (s->handoff.active) {
+    hash_map_t present;  // xid -> 1 + index of the screen it is on
+    hash_map_init(&present);
+    for (uint32_t n = 0; n < count; n++) {
+      if (!replies[n])
+        continue;
+      xcb_window_t* children = xcb_query_tree_children(replies[n]);
+      int len = xcb_query_tree_children_length(replies[n]);
+      for (int i = 0; i < len; i++) {
+        if (children[i] != XCB_NONE)
+          hash_map_insert(&present, children[i], (void*)(uintptr_t)(n + 1u));
+      }
+    }
+    for (int pass = 0; pass < 2; pass++) {
+      for (size_t i = 0; i < s->handoff.count; i++) {
+        const handoff_client_t* c = &s->handoff.clients[i];
+        uintptr_t screen = (uintptr_t)hash_map_get(&present, c->xid);
+        if (!screen || !handoff_find(&s->handoff, c->xid))
+          continue;
+        bool shown = !(c->flags & HANDOFF_ICONIC) && ((c->flags & HANDOFF_STICKY) || wm_adopt_on_current(&s->screens[screen - 1u], (uint32_t)c->desktop));
+        if (shown != (pass == 0))
+          continue;
+        LOG_INFO("Adopting window %u from restart handoff", c->xid);
+        if (shown)
+          client_manage_start(s, c->xid);
+        else
+          wm_adopt_deferred(s, c->xid);
+      }
+    }
+    // Windows that went away during the restart will never finish manage;
+    // dropping their records lets the last adoption release the handoff
+    for (size_t i = 0; s->handoff.active && i < s->handoff.count; i++) {
+      xcb_window_t xid = s->handoff.clients[i].xid;
+      if (!hash_map_get(&present, xid))
+        handoff_consume(&s->handoff, xid);
+    }
+    hash_map_destroy(&present);
+  }
+
+  uint64_t txn = ++s->txn_id;
+  cookie_jar_group_begin(&s->cookie_jar, txn, HANDLE_INVALID, wm_adopt_complete);
+  for (uint32_t n = 0; n < count; n++) {
+    if (replies[n])
+      wm_adopt_scan(s, n, replies[n], txn);
+  }
+  cookie_jar_group_end(&s->cookie_jar, s);
+
+  for (uint32_t n = 0; n < count; n++)
+    free(replies[n]);
 }
 
 void wm_handle_map_request(server_t* s, xcb_map_request_event_t* ev) {
@@ -879,10 +1240,7 @@ void wm_handle_map_request(server_t* s, xcb_map_request_event_t* ev) {
 
 void wm_handle_unmap_notify(server_t* s, xcb_unmap_notify_event_t* ev) {
   TRACE_LOG("unmap_notify win=%u event=%u from_configure=%u", ev->window, ev->event, ev->from_configure);
-  handle_t h = server_get_client_by_window(s, ev->window);
-  if (h == HANDLE_INVALID) {
-    h = server_get_client_by_frame(s, ev->window);
-  }
+  handle_t h = server_get_client_by_any(s, ev->window);
   if (h == HANDLE_INVALID)
     return;
 
@@ -903,7 +1261,7 @@ void wm_handle_unmap_notify(server_t* s, xcb_unmap_notify_event_t* ev) {
 
   // Process if reported on the window itself, its frame parent, or the root
   // Applications withdrawing will trigger this
-  if (ev->event != hot->xid && ev->event != hot->frame && ev->event != s->root)
+  if (ev->event != hot->xid && ev->event != hot->frame && ev->event != client_screen(s, hot)->root)
     return;
 
   TRACE_LOG("unmap_notify unmanage h=%lx xid=%u frame=%u", h, hot->xid, hot->frame);
@@ -923,11 +1281,7 @@ void wm_handle_destroy_notify(server_t* s, xcb_destroy_notify_event_t* ev) {
     hash_map_remove(&s->pending_unmanaged_states, ev->window);
   }
 
-  handle_t h = server_get_client_by_window(s, ev->window);
-  if (h == HANDLE_INVALID) {
-    h = server_get_client_by_frame(s, ev->window);
-  }
-
+  handle_t h = server_get_client_by_any(s, ev->window);
   if (h == HANDLE_INVALID)
     return;
 
@@ -944,7 +1298,7 @@ void wm_handle_destroy_notify(server_t* s, xcb_destroy_notify_event_t* ev) {
         return;
       }
     }
-    hot->state = STATE_DESTROYED;
+    client_set_state(s, hot, STATE_DESTROYED);
   }
   client_unmanage(s, h);
 }
@@ -1035,7 +1389,9 @@ void wm_handle_configure_request(server_t* s, handle_t h, pending_config_t* ev)
   if (!is_panel) {
     client_constrain_size(&cold->hints, cold->hints_flags, &hot->desired.w, &hot->desired.h);
   }
-  hot->dirty |= DIRTY_GEOM;
+  server_mark_dirty(s, hot, DIRTY_GEOM);
+  // A tiled client keeps its tile; it is put back before this is committed
+  wm_tiling_refresh(s, h);
 
   LOG_DEBUG("Client %lx desired geom updated: %d,%d %dx%d (mask %x)", h, hot->desired.x, hot->desired.y, hot->desired.w, hot->desired.h, ev->mask);
 }
@@ -1069,6 +1425,10 @@ void wm_handle_configure_notify(server_t* s, handle_t h, xcb_configure_notify_ev
     hot->server.y = ev->y;
     hot->server.w = client_w;
     hot->server.h = client_h;
+    wm_client_update_monitor(s, hot);
+    spatial_index_update(&client_screen(s, hot)->frame_index, h, (rect_t){ev->x, ev->y, ev->width, ev->height});
+    // The committed geometry may now disagree with desired
+    server_queue_client(s, hot);
     LOG_DEBUG("Client %lx frame geom updated: %d,%d %ux%u", h, ev->x, ev->y, (unsigned)client_w, (unsigned)client_h);
   }
   else if (ev->window == hot->xid) {
@@ -1087,7 +1447,7 @@ void wm_handle_configure_notify(server_t* s, handle_t h, xcb_configure_notify_ev
         client_constrain_size(&cold->hints, cold->hints_flags, &target_w, &target_h);
 
       if (ev->width != target_w || ev->height != target_h) {
-        hot->dirty |= DIRTY_GEOM;
+        server_mark_dirty(s, hot, DIRTY_GEOM);
       }
     }
 
@@ -1095,82 +1455,85 @@ void wm_handle_configure_notify(server_t* s, handle_t h, xcb_configure_notify_ev
   }
 }
 
-void wm_handle_property_notify(server_t* s, handle_t h, xcb_property_notify_event_t* ev) {
-  if (ev->atom == atoms._NET_WM_ALLOWED_ACTIONS || ev->atom == atoms._NET_FRAME_EXTENTS || ev->atom == atoms.WM_STATE || ev->atom == atoms._NET_WM_VISIBLE_NAME ||
-      ev->atom == atoms._NET_WM_VISIBLE_ICON_NAME) {
+/* prop_fetches values: sequence << 1, low bit set once a newer notify arrived */
+#define PROP_FETCH_STALE ((uintptr_t)1)
+
+static void prop_fetch_issue(server_t* s, handle_t h, uint64_t key, const wm_prop_desc_t* desc) {
+  xcb_window_t xid = (xcb_window_t)(key >> 32);
+  xcb_atom_t prop = (xcb_atom_t)(key & 0xFFFFFFFFu);
+  xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, xid, prop, desc->fetch_type, 0, desc->fetch_len);
+  if (ck.sequence == 0) {
+    hash_map_remove(&s->prop_fetches, key);
+    return;
+  }
+  cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, key, s->txn_id, wm_handle_reply);
+  hash_map_insert(&s->prop_fetches, key, (void*)((uintptr_t)ck.sequence << 1));
+}
+
+/* Entry for key if its cookie is still in the jar, else 0 (and the entry is dropped) */
+static uintptr_t prop_fetch_live(server_t* s, uint64_t key) {
+  uintptr_t v = (uintptr_t)hash_map_get(&s->prop_fetches, key);
+  if (!v)
+    return 0;
+  const cookie_slot_t* slot = cookie_jar_lookup(&s->cookie_jar, (uint32_t)(v >> 1));
+  if (slot && slot->type == COOKIE_GET_PROPERTY && slot->data == key)
+    return v;
+  hash_map_remove(&s->prop_fetches, key);
+  return 0;
+}
+
+void wm_prop_fetch_settle(server_t* s, const cookie_slot_t* slot, bool answered) {
+  uintptr_t v = (uintptr_t)hash_map_get(&s->prop_fetches, slot->data);
+  if (!v || (uint32_t)(v >> 1) != slot->sequence)
+    return;  // manage-time fetch, or one a later notify already replaced
+
+  const wm_prop_desc_t* desc = wm_prop_desc((xcb_atom_t)(slot->data & 0xFFFFFFFFu));
+  if (answered && (v & PROP_FETCH_STALE) && desc && desc->fetch_len && server_chot(s, slot->client))
+    prop_fetch_issue(s, slot->client, slot->data, desc);
+  else
+    hash_map_remove(&s->prop_fetches, slot->data);
+}
+
+void wm_prop_fetch_forget(server_t* s, xcb_window_t xid) {
+  if (hash_map_empty(&s->prop_fetches) || xid == XCB_NONE)
     return;
+  const xcb_atom_t* ids = (const xcb_atom_t*)&atoms;
+  for (int i = 0; i < ATOM_ID_COUNT; i++) {
+    if (ids[i] != XCB_NONE)
+      hash_map_remove(&s->prop_fetches, ((uint64_t)xid << 32) | ids[i]);
   }
+}
+
+void wm_handle_property_notify(server_t* s, handle_t h, xcb_property_notify_event_t* ev) {
+  const wm_prop_desc_t* desc = wm_prop_desc(ev->atom);
+  if (!desc || (!desc->dirty && !desc->fetch_len && !desc->notify))
+    return;
   client_hot_t* hot = server_chot(s, h);
   client_cold_t* cold = server_ccold(s, h);
   if (!hot || !cold)
     return;
 
   TRACE_LOG("property_notify h=%lx xid=%u atom=%u (%s) state=%u", h, hot->xid, ev->atom, atom_name(ev->atom), ev->state);
-  if (ev->atom == atoms.WM_NAME || ev->atom == atoms._NET_WM_NAME) {
-    hot->dirty |= DIRTY_TITLE;
-  }
-  else if (ev->atom == atoms.WM_HINTS) {
-    hot->dirty |= DIRTY_HINTS;
-  }
-  else if (ev->atom == atoms.WM_NORMAL_HINTS) {
-    hot->dirty |= DIRTY_HINTS;
-  }
-  else if (ev->atom == atoms.WM_COLORMAP_WINDOWS) {
-    hot->dirty |= DIRTY_HINTS;
-  }
-  else if (ev->atom == atoms.WM_PROTOCOLS) {
-    xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_PROTOCOLS, XCB_ATOM_ATOM, 0, 32);
-    if (ck.sequence != 0)
-      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, ((uint64_t)hot->xid << 32) | atoms.WM_PROTOCOLS, s->txn_id, wm_handle_reply);
-  }
-  else if (ev->atom == atoms._NET_WM_ICON) {
-    xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_ICON, XCB_ATOM_CARDINAL, 0, 4096);
-    if (ck.sequence != 0)
-      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, ((uint64_t)hot->xid << 32) | atoms._NET_WM_ICON, s->txn_id, wm_handle_reply);
-  }
-  else if (ev->atom == atoms._NET_WM_STATE) {
-    xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_STATE, XCB_ATOM_ATOM, 0, 32);
-    if (ck.sequence != 0)
-      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, ((uint64_t)hot->xid << 32) | atoms._NET_WM_STATE, s->txn_id, wm_handle_reply);
-  }
-  else if (ev->atom == atoms._NET_WM_WINDOW_TYPE) {
-    xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 0, 32);
-    if (ck.sequence != 0)
-      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, ((uint64_t)hot->xid << 32) | atoms._NET_WM_WINDOW_TYPE, s->txn_id, wm_handle_reply);
-  }
-  else if (ev->atom == atoms._NET_WM_DESKTOP) {
-    xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 0, 1);
-    if (ck.sequence != 0)
-      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, ((uint64_t)hot->xid << 32) | atoms._NET_WM_DESKTOP, s->txn_id, wm_handle_reply);
-  }
-  else if (ev->atom == atoms._NET_WM_SYNC_REQUEST_COUNTER) {
-    xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_SYNC_REQUEST_COUNTER, XCB_ATOM_CARDINAL, 0, 1);
-    if (ck.sequence != 0)
-      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, ((uint64_t)hot->xid << 32) | atoms._NET_WM_SYNC_REQUEST_COUNTER, s->txn_id, wm_handle_reply);
-  }
-  else if (ev->atom == atoms._NET_WM_STRUT || ev->atom == atoms._NET_WM_STRUT_PARTIAL) {
-    hot->dirty |= DIRTY_STRUT;
-    // Waterfall: Always request PARTIAL first. If it fails/empty, we fallback
-    // to STRUT in reply handler
-    xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 0, 12);
-    if (ck.sequence != 0)
-      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, ((uint64_t)hot->xid << 32) | (uint32_t)atoms._NET_WM_STRUT_PARTIAL, s->txn_id, wm_handle_reply);
-  }
-  else if (ev->atom == atoms._NET_WM_WINDOW_OPACITY) {
-    hot->dirty |= DIRTY_OPACITY;
-  }
-  else if (ev->atom == atoms._MOTIF_WM_HINTS) {
-    hot->dirty |= DIRTY_HINTS;
-  }
-  else if (ev->atom == atoms._GTK_FRAME_EXTENTS) {
-    hot->dirty |= DIRTY_HINTS;
-  }
-  else if (ev->atom == atoms._KDE_NET_WM_FRAME_STRUT) {
-    hot->dirty |= DIRTY_HINTS;
-  }
-  else if (ev->atom == atoms._NET_WM_BYPASS_COMPOSITOR) {
-    hot->dirty |= DIRTY_BYPASS_COMPOSITOR;
+  if (desc->dirty)
+    server_mark_dirty(s, hot, desc->dirty);
+
+  if (desc->fetch_len) {
+    // Strut changes always start from PARTIAL; the reply falls back to STRUT
+    xcb_atom_t prop = desc->fetch_as ? ((const xcb_atom_t*)&atoms)[desc->fetch_as - 1] : ev->atom;
+    uint64_t key = ((uint64_t)hot->xid << 32) | (uint32_t)prop;
+    uintptr_t inflight = prop_fetch_live(s, key);
+    if (inflight) {
+      // The reply already on its way predates this change; refetch once it lands
+      if (!(inflight & PROP_FETCH_STALE))
+        hash_map_insert(&s->prop_fetches, key, (void*)(inflight | PROP_FETCH_STALE));
+    }
+    else {
+      prop_fetch_issue(s, h, key, desc);
+    }
   }
+
+  if (desc->notify)
+    desc->notify(s, h, hot);
 }
 
 static bool colormap_list_contains(const client_cold_t* cold, xcb_window_t win) {
@@ -1203,7 +1566,7 @@ void wm_handle_colormap_notify(server_t* s, xcb_colormap_notify_event_t* ev) {
   }
 
   if (match) {
-    wm_install_client_colormap(s, hot);
+    wm_colormap_request(s);
   }
 }
 
@@ -1254,14 +1617,14 @@ void wm_client_apply_state_set(server_t* s, handle_t h, const client_state_set_t
 
   if (hot->skip_taskbar != set->skip_taskbar) {
     hot->skip_taskbar = set->skip_taskbar;
-    hot->dirty |= DIRTY_STATE;
-    s->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
+    server_mark_dirty(s, hot, DIRTY_STATE);
+    client_screen(s, hot)->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
   }
 
   if (hot->skip_pager != set->skip_pager) {
     hot->skip_pager = set->skip_pager;
-    hot->dirty |= DIRTY_STATE;
-    s->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
+    server_mark_dirty(s, hot, DIRTY_STATE);
+    client_screen(s, hot)->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
   }
 }
 
@@ -1270,40 +1633,27 @@ void wm_client_apply_state_set(server_t* s, handle_t h, const client_state_set_t
 // Helpers
 
 static int wm_get_resize_dir(server_t* s, client_hot_t* hot, int16_t x, int16_t y) {
-  uint16_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
-  uint16_t th = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.title_height;
-  uint16_t bottom_h = bw;
-
-  uint32_t frame_w_calc = (uint32_t)hot->server.w + (uint32_t)(2u * bw);
-  uint32_t frame_h_calc = (uint32_t)hot->server.h + (uint32_t)th + (uint32_t)bottom_h;
-  if (frame_w_calc > MAX_FRAME_SIZE)
-    frame_w_calc = MAX_FRAME_SIZE;
-  if (frame_h_calc > MAX_FRAME_SIZE)
-    frame_h_calc = MAX_FRAME_SIZE;
-
-  uint16_t frame_w = (uint16_t)frame_w_calc;
-  uint16_t frame_h = (uint16_t)frame_h_calc;
-  int32_t right_edge = (int32_t)frame_w - (int32_t)bw;
-  int32_t bottom_edge = (int32_t)frame_h - (int32_t)bw;
-  if (right_edge < 0)
-    right_edge = 0;
-  if (bottom_edge < 0)
-    bottom_edge = 0;
+  const frame_hit_t* t = frame_hit_table(s, hot);
 
   int dir = RESIZE_NONE;
-  if (x < bw)
+  if (x < (int32_t)t->bw)
     dir |= RESIZE_LEFT;
-  if ((int32_t)x >= right_edge)
+  if (x >= t->right_edge)
     dir |= RESIZE_RIGHT;
-  if (y < bw)
+  if (y < (int32_t)t->bw)
     dir |= RESIZE_TOP;  // Top border (part of titlebar area technically)
-  if ((int32_t)y >= bottom_edge)
+  if (y >= t->bottom_edge)
     dir |= RESIZE_BOTTOM;
 
   return dir;
 }
 
-static void wm_update_cursor(server_t* s, xcb_window_t win, int dir) {
+// Set the frame cursor for dir, skipping the request if the frame already has it
+static void wm_update_cursor(server_t* s, client_hot_t* hot, int dir) {
+  if (hot->last_cursor_dir == dir)
+    return;
+  hot->last_cursor_dir = dir;
+
   xcb_cursor_t c = s->cursor_left_ptr;
   if (dir == RESIZE_TOP)
     c = s->cursor_resize_top;
@@ -1322,7 +1672,7 @@ static void wm_update_cursor(server_t* s, xcb_window_t win, int dir) {
   else if (dir == (RESIZE_BOTTOM | RESIZE_RIGHT))
     c = s->cursor_resize_bottom_right;
 
-  xcb_change_window_attributes(s->conn, win, XCB_CW_CURSOR, &c);
+  xcb_change_window_attributes(s->conn, hot->frame, XCB_CW_CURSOR, &c);
 }
 
 void wm_cancel_interaction(server_t* s) {
@@ -1341,21 +1691,62 @@ void wm_cancel_interaction(server_t* s) {
   s->interaction_resize_dir = RESIZE_NONE;
   s->interaction_time = 0;
   s->interaction_pointer_grabbed = false;
+  s->interaction_outline = false;
+  s->interaction_key_dx = 0;
+  s->interaction_key_dy = 0;
   xcb_ungrab_pointer(s->conn, XCB_CURRENT_TIME);
+  if (s->interaction_keyboard_grabbed || s->interaction_keyboard_pending) {
+    xcb_ungrab_keyboard(s->conn, XCB_CURRENT_TIME);
+    s->interaction_keyboard_grabbed = false;
+    s->interaction_keyboard_pending = false;
+  }
   if (frame != XCB_NONE) {
     client_hot_t* hot = server_chot(s, h);
     if (!hot) {
       handle_t fh = server_get_client_by_frame(s, frame);
       hot = server_chot(s, fh);
     }
-    if (hot) {
-      wm_update_cursor(s, hot->frame, RESIZE_NONE);
-      hot->last_cursor_dir = RESIZE_NONE;
-    }
+    if (hot)
+      wm_update_cursor(s, hot, RESIZE_NONE);
   }
   LOG_INFO("Ended interaction");
 }
 
+/*
+ * Collect the edges a move can stick to: visible frames on this desktop,
+ * monitor bounds and each monitor's workarea (which carries the struts).
+ * Built once per drag so motion steps only binary-search sorted lines.
+ */
+static void wm_snap_edges_build(server_t* s, handle_t moving) {
+  snap_edge_index_t* idx = &s->snap_edges;
+  snap_edges_clear(idx);
+  screen_t* scr = client_screen(s, server_chot(s, moving));
+
+  for (uint32_t i = 0; i < scr->monitor_count; i++) {
+    rect_t wa;
+    snap_edges_add_rect(idx, scr->monitors[i].geom);
+    if (wm_monitor_workarea(s, scr, scr->current_desktop, i, &wa))
+      snap_edges_add_rect(idx, wa);
+  }
+  if (scr->monitor_count == 0)
+    snap_edges_add_rect(idx, scr->workarea);
+
+  handle_vec_t hits;
+  handle_vec_init(&hits);
+  wm_clients_in_rect(s, scr, (rect_t){INT16_MIN, INT16_MIN, UINT16_MAX, UINT16_MAX}, &hits);
+  for (size_t i = 0; i < hits.length; i++) {
+    client_hot_t* other = server_chot(s, hits.items[i]);
+    rect_t r;
+    if (hits.items[i] == moving || !other || other->type == WINDOW_TYPE_DESKTOP)
+      continue;
+    if (spatial_index_get(&scr->frame_index, hits.items[i], &r))
+      snap_edges_add_rect(idx, r);
+  }
+  handle_vec_destroy(&hits);
+
+  snap_edges_sort(idx);
+}
+
 void wm_start_interaction(server_t* s, handle_t h, client_hot_t* hot, bool start_move, int resize_dir, int16_t root_x, int16_t root_y, uint32_t time, bool is_keyboard) {
   (void)h;
   assert(s->interaction_mode == INTERACTION_NONE);
@@ -1367,6 +1758,14 @@ void wm_start_interaction(server_t* s, handle_t h, client_hot_t* hot, bool start
   s->interaction_requires_buttons = !is_keyboard;
   s->interaction_pointer_grabbed = false;
 
+  client_cold_t* cold = server_ccold(s, h);
+  if (cold)
+    cold->sync_wait_value = 0;
+  wm_ping_client(s, h);
+
+  // A window placed by hand stops being tiled
+  wm_tiling_float(s, h, true);
+
   s->interaction_start_x = start_move ? hot->desired.x : hot->server.x;
   s->interaction_start_y = start_move ? hot->desired.y : hot->server.y;
   s->interaction_start_w = start_move ? hot->desired.w : hot->server.w;
@@ -1374,8 +1773,41 @@ void wm_start_interaction(server_t* s, handle_t h, client_hot_t* hot, bool start
 
   s->interaction_pointer_x = root_x;
   s->interaction_pointer_y = root_y;
+  s->interaction_motion_time = 0;
+  s->interaction_hint_pending = false;
+  s->interaction_query_inflight = false;
+  s->interaction_query_time = 0;
   s->last_interaction_flush = 0;
 
+  s->interaction_origin = hot->desired;
+  s->interaction_key_dx = 0;
+  s->interaction_key_dy = 0;
+  s->interaction_key_last = 0;
+  s->interaction_key_repeats = 0;
+  s->interaction_keyboard_grabbed = false;
+  s->interaction_keyboard_pending = false;
+  xcb_window_t root = client_screen(s, hot)->root;
+  if (is_keyboard) {
+    xcb_grab_keyboard_cookie_t kc = xcb_grab_keyboard(s->conn, 0, root, time ? time : XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+    if (kc.sequence != 0) {
+      cookie_jar_push(&s->cookie_jar, kc.sequence, COOKIE_GRAB_KEYBOARD, HANDLE_INVALID, (uintptr_t)hot->frame, s->txn_id, wm_handle_grab_keyboard_reply);
+      s->interaction_keyboard_pending = true;
+    }
+  }
+
+  s->interaction_outline = false;
+  if (hot->flags & CLIENT_FLAG_OUTLINE_DRAG)
+    s->interaction_outline = true;
+  else if (!(hot->flags & CLIENT_FLAG_LIVE_DRAG))
+    s->interaction_outline = (s->config.interactive_outline == OUTLINE_ALWAYS);
+  // A hung client would not redraw any of the sizes a live resize sends it
+  if (!start_move && cold && cold->ping_hung)
+    s->interaction_outline = true;
+
+  snap_edges_clear(&s->snap_edges);
+  if (start_move && s->snap_enabled && s->snap_edge_resistance_px > 0)
+    wm_snap_edges_build(s, h);
+
   xcb_cursor_t cursor = XCB_NONE;
   if (start_move) {
     cursor = s->cursor_move;
@@ -1397,16 +1829,29 @@ void wm_start_interaction(server_t* s, handle_t h, client_hot_t* hot, bool start
   else if (resize_dir == (RESIZE_BOTTOM | RESIZE_RIGHT))
     cursor = s->cursor_resize_bottom_right;
 
-  xcb_grab_pointer_cookie_t cookie = xcb_grab_pointer(s->conn, 0, s->root, XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_BUTTON_MOTION | XCB_EVENT_MASK_POINTER_MOTION, XCB_GRAB_MODE_ASYNC,
-                                                      XCB_GRAB_MODE_ASYNC, XCB_NONE, cursor, time ? time : XCB_CURRENT_TIME);
+  // The XI2 grab reports the same events rewritten to core layout at ingest;
+  // the core UngrabPointer used to end interactions releases either grab
+  unsigned int sequence;
+  s->interaction_xi2 = xi2_enabled(s);
+  s->interaction_motion_hint = !s->interaction_xi2 && s->config.interactive_motion_hint;
+  if (s->interaction_xi2) {
+    sequence = xi2_grab_pointer(s, root, cursor, time);
+  }
+  else {
+    uint16_t mask = XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_BUTTON_MOTION | XCB_EVENT_MASK_POINTER_MOTION;
+    if (s->interaction_motion_hint)
+      mask |= XCB_EVENT_MASK_POINTER_MOTION_HINT;
+    xcb_grab_pointer_cookie_t cookie = xcb_grab_pointer(s->conn, 0, root, mask, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, XCB_NONE, cursor, time ? time : XCB_CURRENT_TIME);
+    sequence = cookie.sequence;
+  }
 
-  if (cookie.sequence == 0) {
+  if (sequence == 0) {
     LOG_ERROR("grab_pointer request returned zero sequence; aborting interaction start");
     wm_cancel_interaction(s);
     return;
   }
 
-  cookie_jar_push(&s->cookie_jar, cookie.sequence, COOKIE_GRAB_POINTER, HANDLE_INVALID, (uintptr_t)hot->frame, s->txn_id, wm_handle_grab_pointer_reply);
+  cookie_jar_push(&s->cookie_jar, sequence, COOKIE_GRAB_POINTER, HANDLE_INVALID, (uintptr_t)hot->frame, s->txn_id, wm_handle_grab_pointer_reply);
 
   LOG_INFO("Started interactive %s for client %lx (dir=%d)", start_move ? "MOVE" : "RESIZE", h, resize_dir);
 }
@@ -1414,7 +1859,7 @@ void wm_start_interaction(server_t* s, handle_t h, client_hot_t* hot, bool start
 // Mouse interaction
 
 void wm_handle_button_press(server_t* s, xcb_button_press_event_t* ev) {
-  wm_record_pointer_root(s, ev->root_x, ev->root_y);
+  wm_record_pointer_root(s, ev->root, ev->root_x, ev->root_y);
 
   if (s->interaction_mode == INTERACTION_MENU) {
     menu_handle_button_press(s, ev);
@@ -1422,7 +1867,8 @@ void wm_handle_button_press(server_t* s, xcb_button_press_event_t* ev) {
   }
 
   // Root menu and workspace scroll on empty root clicks
-  if (ev->event == s->root && ev->child == XCB_NONE) {
+  screen_t* root_scr = server_screen_of_root(s, ev->event);
+  if (root_scr && ev->child == XCB_NONE) {
     if (ev->detail == 2) {
       menu_show_client_list(s, ev->root_x, ev->root_y);
       return;
@@ -1432,24 +1878,19 @@ void wm_handle_button_press(server_t* s, xcb_button_press_event_t* ev) {
       return;
     }
     if (ev->detail == 4) {
-      wm_switch_workspace_relative(s, -1);
+      wm_switch_workspace_relative(s, root_scr, -1);
       return;
     }
     if (ev->detail == 5) {
-      wm_switch_workspace_relative(s, 1);
+      wm_switch_workspace_relative(s, root_scr, 1);
       return;
     }
   }
 
   // Identify target client
-  bool is_frame = false;
-  handle_t h = server_get_client_by_frame(s, ev->event);
-  if (h != HANDLE_INVALID) {
-    is_frame = true;
-  }
-  else {
-    h = server_get_client_by_window(s, ev->event);
-  }
+  xid_role_t role;
+  handle_t h = server_xid_lookup(s, ev->event, &role);
+  bool is_frame = (role == XID_FRAME);
   if (h == HANDLE_INVALID)
     return;
 
@@ -1522,7 +1963,7 @@ void wm_handle_button_press(server_t* s, xcb_button_press_event_t* ev) {
     hot->snap_edge = SNAP_NONE;
     hot->snap_preview_active = false;
     hot->snap_preview_edge = SNAP_NONE;
-    hot->dirty |= DIRTY_GEOM;
+    server_mark_dirty(s, hot, DIRTY_GEOM);
   }
 
   if (!start_move && !start_resize) {
@@ -1536,7 +1977,7 @@ void wm_handle_button_press(server_t* s, xcb_button_press_event_t* ev) {
 }
 
 void wm_handle_button_release(server_t* s, xcb_button_release_event_t* ev) {
-  wm_record_pointer_root(s, ev->root_x, ev->root_y);
+  wm_record_pointer_root(s, ev->root, ev->root_x, ev->root_y);
 
   if (s->interaction_mode == INTERACTION_MENU) {
     menu_handle_button_release(s, ev);
@@ -1547,6 +1988,12 @@ void wm_handle_button_release(server_t* s, xcb_button_release_event_t* ev) {
     LOG_INFO("ButtonRelease in interaction");
   }
 
+  // A predicted drag may lead the pointer; settle where the button came up
+  if (s->config.interactive_predict && (s->interaction_mode == INTERACTION_MOVE || s->interaction_mode == INTERACTION_RESIZE)) {
+    s->interaction_motion_time = 0;
+    wm_handle_motion_notify(s, (xcb_motion_notify_event_t*)ev);
+  }
+
   bool had_interaction = (s->interaction_mode != INTERACTION_NONE);
   handle_t interaction_h = s->interaction_handle;
 
@@ -1560,7 +2007,7 @@ void wm_handle_button_release(server_t* s, xcb_button_release_event_t* ev) {
         hot->desired = hot->snap_preview_frame_rect;
         hot->snap_active = true;
         hot->snap_edge = hot->snap_preview_edge;
-        hot->dirty |= DIRTY_GEOM;
+        server_mark_dirty(s, hot, DIRTY_GEOM);
       }
       hot->snap_preview_active = false;
       hot->snap_preview_edge = SNAP_NONE;
@@ -1577,8 +2024,238 @@ void wm_handle_button_release(server_t* s, xcb_button_release_event_t* ev) {
     return;
 }
 
+/*
+ * Where the drag pointer will be when the paced flush commits, extrapolated
+ * from this sample and the previous one. Motion arriving mid-interval is held
+ * until the interval ends; leading by the time left keeps the window under
+ * the pointer instead of an interval behind it. Gaps longer than
+ * INTERACTION_PREDICT_MAX_GAP_MS mean the pointer paused, so no lead.
+ */
+#define INTERACTION_PREDICT_MAX_GAP_MS 50u
+
+static void wm_predict_interaction_pointer(server_t* s, const client_hot_t* hot, const xcb_motion_notify_event_t* ev, int* out_x, int* out_y) {
+  int x = ev->root_x;
+  int y = ev->root_y;
+  int prev_x = s->interaction_motion_x;
+  int prev_y = s->interaction_motion_y;
+  uint32_t dt_ms = ev->time - s->interaction_motion_time;
+  bool have_prev = s->interaction_motion_time != 0;
+
+  s->interaction_motion_x = ev->root_x;
+  s->interaction_motion_y = ev->root_y;
+  s->interaction_motion_time = ev->time;
+  *out_x = x;
+  *out_y = y;
+
+  if (!s->config.interactive_predict || !have_prev || dt_ms == 0 || dt_ms > INTERACTION_PREDICT_MAX_GAP_MS || s->last_interaction_flush == 0)
+    return;
+
+  uint64_t now = monotonic_time_ns();
+  uint64_t due = s->last_interaction_flush + wm_interaction_interval_ns(s, hot);
+  if (due <= now)
+    return;
+
+  int64_t lead_ns = (int64_t)(due - now);
+  int64_t dt_ns = (int64_t)dt_ms * 1000000;
+  *out_x = x + (int)((int64_t)(x - prev_x) * lead_ns / dt_ns);
+  *out_y = y + (int)((int64_t)(y - prev_y) * lead_ns / dt_ns);
+}
+
+/* QueryPointer result for a motion-hint drag, fed through the motion path */
+static void wm_handle_drag_pointer_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  if (!s || !slot)
+    return;
+  s->interaction_query_inflight = false;
+
+  xcb_window_t frame = (xcb_window_t)slot->data;
+  if (err || !reply || s->interaction_window != frame)
+    return;
+  if (s->interaction_mode != INTERACTION_MOVE && s->interaction_mode != INTERACTION_RESIZE)
+    return;
+
+  const xcb_query_pointer_reply_t* r = (const xcb_query_pointer_reply_t*)reply;
+  if (!r->same_screen)
+    return;
+
+  // The reply has no timestamp, so the sample does not feed prediction
+  xcb_motion_notify_event_t ev = {
+      .response_type = XCB_MOTION_NOTIFY,
+      .detail = XCB_MOTION_NORMAL,
+      .root = r->root,
+      .event = r->root,
+      .child = r->child,
+      .root_x = r->root_x,
+      .root_y = r->root_y,
+      .event_x = r->root_x,
+      .event_y = r->root_y,
+      .state = r->mask,
+      .same_screen = 1,
+  };
+  wm_handle_motion_notify(s, &ev);
+}
+
+/*
+ * A motion-hint grab reports one MotionNotify per burst; the position after
+ * that comes from QueryPointer, which also re-arms the hint. One query is in
+ * flight at a time and at most one is sent per paced commit interval, so a
+ * long drag costs a round trip per commit instead of an event per pointer
+ * report. Returns true if a request was sent.
+ */
+bool wm_interaction_poll_pointer(server_t* s, uint64_t now) {
+  if (!s->interaction_motion_hint || !s->interaction_hint_pending || s->interaction_query_inflight)
+    return false;
+  if (s->interaction_mode != INTERACTION_MOVE && s->interaction_mode != INTERACTION_RESIZE)
+    return false;
+  client_hot_t* hot = server_chot(s, s->interaction_handle);
+  if (!hot)
+    return false;
+
+  uint64_t interval = wm_interaction_interval_ns(s, hot);
+  if (s->interaction_query_time != 0 && now - s->interaction_query_time < interval) {
+    server_schedule_timer_ns(s, interval - (now - s->interaction_query_time));
+    return false;
+  }
+
+  xcb_query_pointer_cookie_t ck = xcb_query_pointer(s->conn, client_screen(s, hot)->root);
+  if (ck.sequence == 0)
+    return false;
+  cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_QUERY_POINTER, HANDLE_INVALID, (uintptr_t)s->interaction_window, s->txn_id, wm_handle_drag_pointer_reply);
+  s->interaction_hint_pending = false;
+  s->interaction_query_inflight = true;
+  s->interaction_query_time = now;
+  return true;
+}
+
+/*
+ * Arrow keys during a keyboard move/resize only add up a step here;
+ * wm_interaction_apply_keys turns everything pressed since the last flush
+ * into one geometry change, so a held key costs one configure per paced
+ * commit rather than one per repeat. Auto-repeats of the same key double
+ * the step every KEY_ACCEL_REPEATS presses, up to 1 << KEY_ACCEL_MAX_SHIFT.
+ */
+#define KEY_REPEAT_MAX_GAP_MS 100u
+#define KEY_ACCEL_REPEATS 4u
+#define KEY_ACCEL_MAX_SHIFT 3u
+
+bool wm_interaction_handle_key(server_t* s, const xcb_key_press_event_t* ev) {
+  if (s->interaction_mode != INTERACTION_MOVE && s->interaction_mode != INTERACTION_RESIZE)
+    return false;
+  if (!s->interaction_keyboard_grabbed)
+    return false;
+  client_hot_t* hot = server_chot(s, s->interaction_handle);
+  client_cold_t* cold = server_ccold(s, s->interaction_handle);
+  if (!hot || !cold)
+    return false;
+
+  xcb_keysym_t sym = xcb_key_symbols_get_keysym(s->keysyms, ev->detail, 0);
+  if (sym == XK_Escape) {
+    hot->desired = s->interaction_origin;
+    server_mark_dirty(s, hot, DIRTY_GEOM);
+    wm_cancel_interaction(s);
+    return true;
+  }
+  if (sym == XK_Return || sym == XK_KP_Enter) {
+    wm_interaction_apply_keys(s);
+    wm_cancel_interaction(s);
+    return true;
+  }
+
+  int dir_x = 0;
+  int dir_y = 0;
+  switch (sym) {
+    case XK_Left:
+      dir_x = -1;
+      break;
+    case XK_Right:
+      dir_x = 1;
+      break;
+    case XK_Up:
+      dir_y = -1;
+      break;
+    case XK_Down:
+      dir_y = 1;
+      break;
+    default:
+      return true;  // swallowed: bindings stay quiet while the keyboard is ours
+  }
+
+  bool repeat = ev->detail == s->interaction_key_last && (uint32_t)(ev->time - s->interaction_key_time) <= KEY_REPEAT_MAX_GAP_MS;
+  s->interaction_key_repeats = repeat ? s->interaction_key_repeats + 1 : 0;
+  s->interaction_key_last = ev->detail;
+  s->interaction_key_time = ev->time;
+
+  uint32_t accel = s->interaction_key_repeats / KEY_ACCEL_REPEATS;
+  if (accel > KEY_ACCEL_MAX_SHIFT)
+    accel = KEY_ACCEL_MAX_SHIFT;
+
+  bool fine = (ev->state & XCB_MOD_MASK_SHIFT) != 0;
+  int32_t step_x = fine ? 1 : (int32_t)(s->config.keyboard_step_px ? s->config.keyboard_step_px : 1);
+  int32_t step_y = step_x;
+
+  // Resizes step whole increments, so a terminal grows by cells
+  if (s->interaction_mode == INTERACTION_RESIZE && (cold->hints_flags & XCB_ICCCM_SIZE_HINT_P_RESIZE_INC)) {
+    if (cold->hints.inc_w > 1)
+      step_x = cold->hints.inc_w;
+    if (cold->hints.inc_h > 1)
+      step_y = cold->hints.inc_h;
+  }
+
+  s->interaction_key_dx += dir_x * (step_x << accel);
+  s->interaction_key_dy += dir_y * (step_y << accel);
+  return true;
+}
+
+void wm_interaction_apply_keys(server_t* s) {
+  int32_t dx = s->interaction_key_dx;
+  int32_t dy = s->interaction_key_dy;
+  if (dx == 0 && dy == 0)
+    return;
+  s->interaction_key_dx = 0;
+  s->interaction_key_dy = 0;
+
+  if (s->interaction_mode != INTERACTION_MOVE && s->interaction_mode != INTERACTION_RESIZE)
+    return;
+  client_hot_t* hot = server_chot(s, s->interaction_handle);
+  client_cold_t* cold = server_ccold(s, s->interaction_handle);
+  if (!hot || !cold)
+    return;
+
+  // Shift the drag's anchor too, so pointer motion continues from here
+  if (s->interaction_mode == INTERACTION_MOVE) {
+    hot->desired.x = (int16_t)(hot->desired.x + dx);
+    hot->desired.y = (int16_t)(hot->desired.y + dy);
+    s->interaction_start_x = (int16_t)(s->interaction_start_x + dx);
+    s->interaction_start_y = (int16_t)(s->interaction_start_y + dy);
+    server_mark_dirty(s, hot, DIRTY_GEOM);
+    return;
+  }
+
+  uint16_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
+  uint16_t th = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.title_height;
+  uint16_t max_client_w = MAX_FRAME_SIZE;
+  uint16_t max_client_h = MAX_FRAME_SIZE;
+  wm_compute_max_client_size(bw, th, cold->gtk_frame_extents_set, &max_client_w, &max_client_h);
+
+  int32_t new_w = (int32_t)hot->desired.w + dx;
+  int32_t new_h = (int32_t)hot->desired.h + dy;
+  int32_t min_w = (max_client_w < MIN_FRAME_SIZE) ? max_client_w : MIN_FRAME_SIZE;
+  int32_t min_h = (max_client_h < MIN_FRAME_SIZE) ? max_client_h : MIN_FRAME_SIZE;
+  new_w = new_w < min_w ? min_w : (new_w > max_client_w ? max_client_w : new_w);
+  new_h = new_h < min_h ? min_h : (new_h > max_client_h ? max_client_h : new_h);
+
+  uint16_t w = (uint16_t)new_w;
+  uint16_t h = (uint16_t)new_h;
+  client_constrain_size(&cold->hints, cold->hints_flags, &w, &h);
+
+  s->interaction_start_w += (int32_t)w - (int32_t)hot->desired.w;
+  s->interaction_start_h += (int32_t)h - (int32_t)hot->desired.h;
+  hot->desired.w = w;
+  hot->desired.h = h;
+  server_mark_dirty(s, hot, DIRTY_GEOM);
+}
+
 void wm_handle_motion_notify(server_t* s, xcb_motion_notify_event_t* ev) {
-  wm_record_pointer_root(s, ev->root_x, ev->root_y);
+  wm_record_pointer_root(s, ev->root, ev->root_x, ev->root_y);
 
   if (s->interaction_mode == INTERACTION_MENU) {
     menu_handle_pointer_motion(s, ev->root_x, ev->root_y);
@@ -1592,25 +2269,7 @@ void wm_handle_motion_notify(server_t* s, xcb_motion_notify_event_t* ev) {
       client_hot_t* hot = server_chot(s, h);
       if (hot) {
         int dir = wm_get_resize_dir(s, hot, ev->event_x, ev->event_y);
-        // Optimization: only update if changed
-        // Initialize last_cursor_dir to -1 or something in client alloc?
-        // client_manage_start zeroes the struct (via calloc in slotmap or
-        // explicit init?) slotmap_alloc does NOT zero. client_manage_start
-        // does: hot->state = STATE_NEW; ... I need to init last_cursor_dir in
-        // client_manage_start or handle it here. Let's assume initialized to 0
-        // (RESIZE_NONE) is fine, but we might miss first update if it starts at
-        // 0. Better to use a separate logic or just force it once? Actually,
-        // RESIZE_NONE is 0. If we start at 0, and we are at 0, we do nothing
-        // But we want to set it to LeftPtr initially. Let's rely on frame
-        // creation setting cursor to None (inherit) or LeftPtr? Frame created
-        // with mask, but no cursor attribute set? X default is "None"
-        // (inherit). So initial 0 (RESIZE_NONE) -> updates to LeftPtr. If
-        // hot->last_cursor_dir matches, we skip. We need to ensure we
-        // initialize it to something invalid, e.g. -1
-        if (hot->last_cursor_dir != dir) {
-          wm_update_cursor(s, hot->frame, dir);
-          hot->last_cursor_dir = dir;
-        }
+        wm_update_cursor(s, hot, dir);
       }
     }
     return;
@@ -1641,24 +2300,36 @@ void wm_handle_motion_notify(server_t* s, xcb_motion_notify_event_t* ev) {
     return;
   }
 
-  int dx = ev->root_x - s->interaction_pointer_x;
-  int dy = ev->root_y - s->interaction_pointer_y;
+  if (s->interaction_motion_hint && ev->detail == XCB_MOTION_HINT)
+    s->interaction_hint_pending = true;
+
+  int pointer_x, pointer_y;
+  wm_predict_interaction_pointer(s, hot, ev, &pointer_x, &pointer_y);
+  int dx = pointer_x - s->interaction_pointer_x;
+  int dy = pointer_y - s->interaction_pointer_y;
 
   if (s->interaction_mode == INTERACTION_MOVE) {
     hot->desired.x = (int16_t)(s->interaction_start_x + dx);
     hot->desired.y = (int16_t)(s->interaction_start_y + dy);
-    hot->dirty |= DIRTY_GEOM;
+
+    screen_t* scr = client_screen(s, hot);
+    rect_t frame;
+    if (s->snap_edges.x_len && spatial_index_get(&scr->frame_index, h, &frame)) {
+      frame = snap_edges_attract(&s->snap_edges, (rect_t){hot->desired.x, hot->desired.y, frame.w, frame.h}, (int)s->snap_edge_resistance_px);
+      hot->desired.x = frame.x;
+      hot->desired.y = frame.y;
+    }
+    server_mark_dirty(s, hot, DIRTY_GEOM);
 
     hot->snap_preview_active = false;
     hot->snap_preview_edge = SNAP_NONE;
 
     if (s->snap_enabled && client_can_move(hot) && !hot->override_redirect && hot->layer != LAYER_FULLSCREEN && hot->type != WINDOW_TYPE_DOCK) {
-      rect_t wa = s->workarea;
-      int mid = wm_monitor_at_point(s, ev->root_x, ev->root_y);
-      if (mid >= 0 && (uint32_t)mid < s->monitor_count) {
-        wa = s->monitors[mid].workarea;
-      }
-      snap_candidate_t cand = snap_compute_candidate(ev->root_x, ev->root_y, wa, (int)s->snap_threshold_px);
+      rect_t wa = scr->workarea;
+      int mid = wm_monitor_at_point(scr, ev->root_x, ev->root_y);
+      if (mid >= 0)
+        wm_monitor_workarea(s, scr, scr->current_desktop, (uint32_t)mid, &wa);
+      snap_candidate_t cand = snap_compute_candidate(ev->root_x, ev->root_y, wa, &s->snap_layout);
       if (cand.active) {
         hot->snap_preview_active = true;
         hot->snap_preview_edge = cand.edge;
@@ -1762,7 +2433,7 @@ void wm_handle_motion_notify(server_t* s, xcb_motion_notify_event_t* ev) {
   hot->desired.w = w;
   hot->desired.h = h_val;
 
-  hot->dirty |= DIRTY_GEOM;
+  server_mark_dirty(s, hot, DIRTY_GEOM);
 }
 
 // EWMH client messages / state
@@ -1864,7 +2535,7 @@ void wm_client_update_state(server_t* s, handle_t h, uint32_t action, xcb_atom_t
         wm_get_monitor_geometry(s, hot, &hot->desired);
       }
 
-      hot->dirty |= DIRTY_GEOM | DIRTY_STATE | DIRTY_STACK;
+      server_mark_dirty(s, hot, DIRTY_GEOM | DIRTY_STATE | DIRTY_STACK);
     }
     else if (!add && hot->layer == LAYER_FULLSCREEN) {
       hot->layer = client_layer_from_state(hot);
@@ -1873,7 +2544,7 @@ void wm_client_update_state(server_t* s, handle_t h, uint32_t action, xcb_atom_t
       hot->maximized_horz = hot->saved_maximized_horz;
       hot->maximized_vert = hot->saved_maximized_vert;
       xcb_delete_property(s->conn, hot->xid, atoms._NET_WM_FULLSCREEN_MONITORS);
-      hot->dirty |= DIRTY_GEOM | DIRTY_STATE | DIRTY_STACK;
+      server_mark_dirty(s, hot, DIRTY_GEOM | DIRTY_STATE | DIRTY_STACK);
     }
     return;
   }
@@ -1890,10 +2561,10 @@ void wm_client_update_state(server_t* s, handle_t h, uint32_t action, xcb_atom_t
       uint8_t desired = client_layer_from_state(hot);
       if (hot->layer != desired) {
         hot->layer = desired;
-        hot->dirty |= DIRTY_STACK;
+        server_mark_dirty(s, hot, DIRTY_STACK);
       }
     }
-    hot->dirty |= DIRTY_STATE;
+    server_mark_dirty(s, hot, DIRTY_STATE);
     return;
   }
 
@@ -1909,10 +2580,10 @@ void wm_client_update_state(server_t* s, handle_t h, uint32_t action, xcb_atom_t
       uint8_t desired = client_layer_from_state(hot);
       if (hot->layer != desired) {
         hot->layer = desired;
-        hot->dirty |= DIRTY_STACK;
+        server_mark_dirty(s, hot, DIRTY_STACK);
       }
     }
-    hot->dirty |= DIRTY_STATE;
+    server_mark_dirty(s, hot, DIRTY_STATE);
     return;
   }
 
@@ -1925,8 +2596,8 @@ void wm_client_update_state(server_t* s, handle_t h, uint32_t action, xcb_atom_t
   if (prop == atoms._NET_WM_STATE_SKIP_TASKBAR) {
     if (hot->skip_taskbar != add) {
       hot->skip_taskbar = add;
-      hot->dirty |= DIRTY_STATE;
-      s->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
+      server_mark_dirty(s, hot, DIRTY_STATE);
+      client_screen(s, hot)->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
     }
     return;
   }
@@ -1934,8 +2605,8 @@ void wm_client_update_state(server_t* s, handle_t h, uint32_t action, xcb_atom_t
   if (prop == atoms._NET_WM_STATE_SKIP_PAGER) {
     if (hot->skip_pager != add) {
       hot->skip_pager = add;
-      hot->dirty |= DIRTY_STATE;
-      s->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
+      server_mark_dirty(s, hot, DIRTY_STATE);
+      client_screen(s, hot)->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
     }
     return;
   }
@@ -1945,7 +2616,9 @@ void wm_client_update_state(server_t* s, handle_t h, uint32_t action, xcb_atom_t
       hot->flags |= CLIENT_FLAG_URGENT;
     else
       hot->flags &= ~CLIENT_FLAG_URGENT;
-    hot->dirty |= DIRTY_STATE | DIRTY_FRAME_STYLE;
+    // WM_HINTS urgency is reconciled against this flag on the next reply
+    wm_prop_cache_forget(cold, WM_PROP_CACHE_WM_HINTS);
+    server_mark_dirty(s, hot, DIRTY_STATE | DIRTY_FRAME_STYLE);
     return;
   }
 
@@ -1968,8 +2641,13 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
     TRACE_LOG("client_message type=%u window=%u format=%u data=[%u,%u,%u,%u,%u]", ev->type, ev->window, ev->format, ev->data.data32[0], ev->data.data32[1], ev->data.data32[2], ev->data.data32[3],
               ev->data.data32[4]);
   });
-  if (ev->type == atoms.WM_PROTOCOLS && ev->window == s->root && ev->format == 32 && ev->data.data32[0] == atoms._NET_WM_PING) {
+  // Root messages act on the screen of that root; pagers that do not say
+  // which one get the active screen
+  screen_t* root_scr = server_screen_of_root(s, ev->window);
+  screen_t* scr = root_scr ? root_scr : server_screen(s);
+  if (ev->type == atoms.WM_PROTOCOLS && root_scr && ev->format == 32 && ev->data.data32[0] == atoms._NET_WM_PING) {
     LOG_DEBUG("Received _NET_WM_PING reply for window %u", ev->data.data32[2]);
+    wm_ping_reply(s, ev->data.data32[2]);
     return;
   }
 
@@ -1991,40 +2669,40 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
   if (ev->type == atoms._NET_CURRENT_DESKTOP) {
     uint32_t desktop = ev->data.data32[0];
     TRACE_LOG("_NET_CURRENT_DESKTOP request=%u", desktop);
-    if (desktop >= s->desktop_count) {
+    if (desktop >= scr->desktop_count) {
       LOG_INFO("Client requested switch to desktop %u (out of range)", desktop);
       return;
     }
     LOG_INFO("Client requested switch to desktop %u", desktop);
-    wm_switch_workspace(s, desktop);
+    wm_switch_workspace(s, scr, desktop);
     return;
   }
 
   if (ev->type == atoms._NET_SHOWING_DESKTOP) {
-    if (ev->window != s->root || ev->format != 32)
+    if (!root_scr || ev->format != 32)
       return;
     TRACE_LOG("_NET_SHOWING_DESKTOP request=%u", ev->data.data32[0]);
-    wm_set_showing_desktop(s, ev->data.data32[0] != 0);
+    wm_set_showing_desktop(s, scr, ev->data.data32[0] != 0);
     return;
   }
 
   if (ev->type == atoms._NET_DESKTOP_GEOMETRY) {
-    if (ev->window != s->root || ev->format != 32)
+    if (!root_scr || ev->format != 32)
       return;
     TRACE_LOG("_NET_DESKTOP_GEOMETRY request=%u,%u", ev->data.data32[0], ev->data.data32[1]);
-    xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+    xcb_screen_t* screen = xcb_screen_of(s->conn, scr->num);
     uint32_t geometry[] = {screen->width_in_pixels, screen->height_in_pixels};
-    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_DESKTOP_GEOMETRY, XCB_ATOM_CARDINAL, 32, 2, geometry);
+    wm_publish_root_prop(s, scr, ROOT_PROP_DESKTOP_GEOMETRY, atoms._NET_DESKTOP_GEOMETRY, XCB_ATOM_CARDINAL, 32, 2, geometry);
     return;
   }
 
   if (ev->type == atoms._NET_DESKTOP_VIEWPORT) {
-    if (ev->window != s->root || ev->format != 32)
+    if (!root_scr || ev->format != 32)
       return;
     TRACE_LOG("_NET_DESKTOP_VIEWPORT request=%u,%u", ev->data.data32[0], ev->data.data32[1]);
-    uint32_t* viewport = calloc(s->desktop_count * 2, sizeof(uint32_t));
+    uint32_t* viewport = calloc(scr->desktop_count * 2, sizeof(uint32_t));
     if (viewport) {
-      xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_DESKTOP_VIEWPORT, XCB_ATOM_CARDINAL, 32, s->desktop_count * 2, viewport);
+      wm_publish_root_prop(s, scr, ROOT_PROP_DESKTOP_VIEWPORT, atoms._NET_DESKTOP_VIEWPORT, XCB_ATOM_CARDINAL, 32, scr->desktop_count * 2, viewport);
       free(viewport);
     }
     return;
@@ -2035,26 +2713,29 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
     TRACE_LOG("_NET_NUMBER_OF_DESKTOPS request=%u", requested);
     if (requested == 0)
       requested = 1;
-    if (requested != s->desktop_count) {
+    if (requested != scr->desktop_count) {
       LOG_INFO("Client requested %u desktops", requested);
-      s->desktop_count = requested;
-      if (s->current_desktop >= s->desktop_count)
-        s->current_desktop = 0;
+      scr->desktop_count = requested;
+      if (scr->current_desktop >= scr->desktop_count)
+        scr->current_desktop = 0;
 
       for (size_t i = 0; i < s->active_clients.length; i++) {
-        handle_t h = ptr_to_handle(s->active_clients.items[i]);
+        handle_t h = s->active_clients.items[i];
         client_hot_t* hot = server_chot(s, h);
-        if (!hot || hot->sticky)
+        if (!hot || hot->sticky || client_screen(s, hot) != scr)
           continue;
-        if (hot->desktop >= (int32_t)s->desktop_count) {
-          hot->desktop = (int32_t)s->current_desktop;
+        if (hot->desktop >= (int32_t)scr->desktop_count) {
+          client_set_desktop(s, hot, (int32_t)scr->current_desktop);
           uint32_t prop_val = (uint32_t)hot->desktop;
           xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &prop_val);
+          wm_focus_history_update(s, h);
         }
       }
+      wm_desktop_members_invalidate(s);
     }
-    wm_publish_desktop_props(s);
-    s->workarea_dirty = true;
+    wm_publish_desktop_props(s, scr);
+    wm_workarea_invalidate(scr);
+    scr->workarea_dirty = true;
     return;
   }
 
@@ -2063,7 +2744,7 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
     if (h != HANDLE_INVALID) {
       uint32_t desktop = ev->data.data32[0];
       TRACE_LOG("_NET_WM_DESKTOP h=%lx desktop=%u", h, desktop);
-      if (desktop != 0xFFFFFFFFu && desktop >= s->desktop_count) {
+      if (desktop != 0xFFFFFFFFu && desktop >= client_screen(s, server_chot(s, h))->desktop_count) {
         LOG_INFO("Client requested move to desktop %u (out of range)", desktop);
         return;
       }
@@ -2096,8 +2777,9 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
 
       wm_maybe_exit_showing_desktop_for_client(s, hot);
 
-      if (!hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != s->current_desktop) {
-        wm_switch_workspace(s, (uint32_t)hot->desktop);
+      screen_t* own = client_screen(s, hot);
+      if (!hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != own->current_desktop) {
+        wm_switch_workspace(s, own, (uint32_t)hot->desktop);
       }
       bool was_unmapped = (hot->state == STATE_UNMAPPED);
       if (was_unmapped) {
@@ -2194,7 +2876,7 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
 
   if (ev->type == atoms._NET_REQUEST_FRAME_EXTENTS) {
     xcb_window_t target = ev->window;
-    if (target == s->root)
+    if (root_scr)
       return;
 
     bool undecorated = false;
@@ -2455,7 +3137,7 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
     int16_t root_y = (int16_t)ev->data.data32[1];
     bool is_keyboard = (direction == NET_WM_MOVERESIZE_SIZE_KEYBOARD || direction == NET_WM_MOVERESIZE_MOVE_KEYBOARD);
     if (root_x != -1 && root_y != -1) {
-      wm_record_pointer_root(s, root_x, root_y);
+      wm_record_pointer_root(s, client_screen(s, hot)->root, root_x, root_y);
     }
     use_pointer_query |= (root_x == -1 || root_y == -1);
 
@@ -2463,7 +3145,7 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
 
     if (use_pointer_query) {
       uintptr_t data = (start_move ? 0x100 : 0) | (is_keyboard ? 0x200 : 0) | (uintptr_t)resize_dir;
-      xcb_query_pointer_cookie_t ck = xcb_query_pointer(s->conn, s->root);
+      xcb_query_pointer_cookie_t ck = xcb_query_pointer(s->conn, client_screen(s, hot)->root);
       if (ck.sequence == 0) {
         LOG_ERROR("_NET_WM_MOVERESIZE query_pointer returned zero sequence; aborting interaction start");
         return;
@@ -2478,7 +3160,7 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
 
   if (ev->type == atoms._NET_CLOSE_WINDOW) {
     xcb_window_t target = ev->window;
-    if (target == s->root && ev->format == 32) {
+    if (root_scr && ev->format == 32) {
       target = (xcb_window_t)ev->data.data32[0];
     }
     handle_t h = server_get_client_by_window(s, target);
@@ -2493,6 +3175,55 @@ void wm_handle_client_message(server_t* s, xcb_client_message_event_t* ev) {
 
 // Placement / workspaces
 
+/*
+ * Smart placement: put the frame where it overlaps other visible frames on
+ * its monitor's workarea the least, favouring top-left on ties.
+ */
+static void wm_place_smart(server_t* s, handle_t h, client_hot_t* hot, client_cold_t* cold) {
+  screen_t* scr = client_screen(s, hot);
+  rect_t wa = scr->workarea;
+  wm_get_client_workarea(s, hot, &wa);
+
+  uint32_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
+  uint32_t th = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.title_height;
+  uint32_t frame_w = hot->desired.w;
+  uint32_t frame_h = hot->desired.h;
+  int32_t offset_x = 0;
+  int32_t offset_y = 0;
+  if (cold->gtk_frame_extents_set) {
+    offset_x = (int32_t)cold->gtk_extents.left;
+    offset_y = (int32_t)cold->gtk_extents.top;
+  }
+  else {
+    frame_w += 2u * bw;
+    frame_h += th + bw;
+  }
+
+  handle_vec_t hits;
+  handle_vec_init(&hits);
+  wm_clients_in_rect(s, scr, wa, &hits);
+
+  rect_t* obstacles = hits.length ? (rect_t*)arena_alloc(&s->tick_arena, hits.length * sizeof(*obstacles)) : NULL;
+  size_t n = 0;
+  for (size_t i = 0; i < hits.length; i++) {
+    client_hot_t* other = server_chot(s, hits.items[i]);
+    if (hits.items[i] == h || !other || other->type == WINDOW_TYPE_DESKTOP || other->type == WINDOW_TYPE_DOCK)
+      continue;
+    if (spatial_index_get(&scr->frame_index, hits.items[i], &obstacles[n]))
+      n++;
+  }
+  handle_vec_destroy(&hits);
+
+  int32_t x = wa.x;
+  int32_t y = wa.y;
+  uint64_t overlap = placement_min_overlap(&s->tick_arena, wa, frame_w, frame_h, obstacles, n, &x, &y);
+  TRACE_LOG("place_smart h=%lx frame=%ux%u at %d,%d overlap=%llu (%zu obstacles)", h, frame_w, frame_h, x, y, (unsigned long long)overlap, n);
+  (void)overlap;
+
+  hot->desired.x = (int16_t)(x + offset_x);
+  hot->desired.y = (int16_t)(y + offset_y);
+}
+
 void wm_place_window(server_t* s, handle_t h) {
   client_hot_t* hot = server_chot(s, h);
   client_cold_t* cold = server_ccold(s, h);
@@ -2503,11 +3234,12 @@ void wm_place_window(server_t* s, handle_t h) {
       hot->type == WINDOW_TYPE_POPUP_MENU || hot->type == WINDOW_TYPE_TOOLTIP || hot->type == WINDOW_TYPE_COMBO || hot->type == WINDOW_TYPE_DND) {
     return;
   }
+  const screen_t* scr = client_screen(s, hot);
 
   // 1. Check rules/types for explicit placement
   if (hot->placement == PLACEMENT_CENTER) {
-    hot->desired.x = (int16_t)(s->workarea.x + (s->workarea.w - hot->desired.w) / 2);
-    hot->desired.y = (int16_t)(s->workarea.y + (s->workarea.h - hot->desired.h) / 2);
+    hot->desired.x = (int16_t)(scr->workarea.x + (scr->workarea.w - hot->desired.w) / 2);
+    hot->desired.y = (int16_t)(scr->workarea.y + (scr->workarea.h - hot->desired.h) / 2);
     return;
   }
   else if (hot->placement == PLACEMENT_MOUSE) {
@@ -2516,6 +3248,10 @@ void wm_place_window(server_t* s, handle_t h) {
       hot->desired.y = (int16_t)(s->pointer_root_y - hot->desired.h / 2);
     }
   }
+  else if (hot->placement == PLACEMENT_SMART) {
+    wm_place_smart(s, h, hot, cold);
+    return;
+  }
   else if (hot->transient_for != HANDLE_INVALID) {
     // Transients: center over parent
     client_hot_t* parent = server_chot(s, hot->transient_for);
@@ -2531,23 +3267,40 @@ void wm_place_window(server_t* s, handle_t h) {
     return;
   }
 
+  // Global default policy, only when no rule chose one
+  if (hot->placement == PLACEMENT_DEFAULT) {
+    if (s->config.placement == PLACEMENT_SMART) {
+      wm_place_smart(s, h, hot, cold);
+      return;
+    }
+    if (s->config.placement == PLACEMENT_CENTER) {
+      hot->desired.x = (int16_t)(scr->workarea.x + (scr->workarea.w - hot->desired.w) / 2);
+      hot->desired.y = (int16_t)(scr->workarea.y + (scr->workarea.h - hot->desired.h) / 2);
+      return;
+    }
+    if (s->config.placement == PLACEMENT_MOUSE && s->pointer_root_valid) {
+      hot->desired.x = (int16_t)(s->pointer_root_x - hot->desired.w / 2);
+      hot->desired.y = (int16_t)(s->pointer_root_y - hot->desired.h / 2);
+    }
+  }
+
   // Clamp to workarea
-  if (hot->desired.x < s->workarea.x)
-    hot->desired.x = s->workarea.x;
-  if (hot->desired.y < s->workarea.y)
-    hot->desired.y = s->workarea.y;
+  if (hot->desired.x < scr->workarea.x)
+    hot->desired.x = scr->workarea.x;
+  if (hot->desired.y < scr->workarea.y)
+    hot->desired.y = scr->workarea.y;
 
-  if ((int32_t)hot->desired.x + (int32_t)hot->desired.w > (int32_t)s->workarea.x + (int32_t)s->workarea.w) {
-    hot->desired.x = (int16_t)(s->workarea.x + s->workarea.w - hot->desired.w);
+  if ((int32_t)hot->desired.x + (int32_t)hot->desired.w > (int32_t)scr->workarea.x + (int32_t)scr->workarea.w) {
+    hot->desired.x = (int16_t)(scr->workarea.x + scr->workarea.w - hot->desired.w);
   }
-  if ((int32_t)hot->desired.y + (int32_t)hot->desired.h > (int32_t)s->workarea.y + (int32_t)s->workarea.h) {
-    hot->desired.y = (int16_t)(s->workarea.y + s->workarea.h - hot->desired.h);
+  if ((int32_t)hot->desired.y + (int32_t)hot->desired.h > (int32_t)scr->workarea.y + (int32_t)scr->workarea.h) {
+    hot->desired.y = (int16_t)(scr->workarea.y + scr->workarea.h - hot->desired.h);
   }
 
-  if (hot->desired.x < s->workarea.x)
-    hot->desired.x = s->workarea.x;
-  if (hot->desired.y < s->workarea.y)
-    hot->desired.y = s->workarea.y;
+  if (hot->desired.x < scr->workarea.x)
+    hot->desired.x = scr->workarea.x;
+  if (hot->desired.y < scr->workarea.y)
+    hot->desired.y = scr->workarea.y;
 }
 
 void wm_client_refresh_title(server_t* s, handle_t h) {
@@ -2556,6 +3309,7 @@ void wm_client_refresh_title(server_t* s, handle_t h) {
   if (!hot || !cold)
     return;
 
+  rule_subject_t before = client_rule_subject(hot, cold);
   cold->title = cold->base_title;
 
   if (cold->has_net_wm_name && cold->title && cold->title[0] != '\0') {
@@ -2572,7 +3326,18 @@ void wm_client_refresh_title(server_t* s, handle_t h) {
     xcb_delete_property(s->conn, hot->xid, atoms._NET_WM_VISIBLE_ICON_NAME);
   }
 
-  hot->dirty |= DIRTY_TITLE | DIRTY_FRAME_STYLE;
+  server_mark_dirty(s, hot, DIRTY_TITLE | DIRTY_FRAME_STYLE);
+  if (cold->title != before.title) {
+    client_rules_changed(s, h, RULE_DEP_TITLE, &before);
+    menu_client_title_changed(s, h);
+  }
+
+  // Only now: before.title may point at the copy being superseded
+  size_t released = client_compact_strings(cold);
+  if (released) {
+    s->mem_budget.evicted[MEM_EVICT_STRINGS]++;
+    s->mem_budget.evicted_bytes[MEM_EVICT_STRINGS] += released;
+  }
 }
 
 void wm_client_toggle_maximize(server_t* s, handle_t h) {
@@ -2585,6 +3350,33 @@ void wm_client_toggle_maximize(server_t* s, handle_t h) {
   LOG_INFO("Client %u maximized toggle: %d", hot->xid, want);
 }
 
+void wm_client_freeze_hidden(server_t* s, client_hot_t* hot) {
+  if (!(hot->flags & CLIENT_FLAG_FREEZE))
+    return;
+  client_cold_t* cold = server_ccold(s, hot->self);
+  if (!cold || !client_pid_local(cold))
+    return;
+
+  // Not while another window of the app is still shown
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t h = s->active_clients.items[i];
+    client_hot_t* other = server_chot(s, h);
+    client_cold_t* other_cold = server_ccold(s, h);
+    if (other && other != hot && other->frame_vis == FRAME_VIS_MAPPED && other_cold && other_cold->pid == cold->pid)
+      return;
+  }
+  if (freezer_freeze(&s->freezer, (pid_t)cold->pid))
+    TRACE_LOG("freeze h=%lx pid=%u", hot->self, cold->pid);
+}
+
+void wm_client_thaw(server_t* s, client_hot_t* hot) {
+  if (s->freezer.count == 0)
+    return;
+  client_cold_t* cold = server_ccold(s, hot->self);
+  if (cold && cold->pid > 0 && cold->pid <= INT32_MAX && freezer_thaw(&s->freezer, (pid_t)cold->pid))
+    TRACE_LOG("thaw h=%lx pid=%u", hot->self, cold->pid);
+}
+
 void wm_client_iconify(server_t* s, handle_t h) {
   client_hot_t* hot = server_chot(s, h);
   if (!hot || hot->state != STATE_MAPPED)
@@ -2593,28 +3385,23 @@ void wm_client_iconify(server_t* s, handle_t h) {
   LOG_INFO("Iconifying client %u", hot->xid);
   TRACE_LOG("iconify h=%lx xid=%u frame=%u layer=%d", h, hot->xid, hot->frame, hot->layer);
 
-  hot->state = STATE_UNMAPPED;
+  client_set_state(s, hot, STATE_UNMAPPED);
   add_ignore_unmaps(hot, 2);
   xcb_unmap_window(s->conn, hot->frame);
+  client_set_frame_vis(s, hot, FRAME_VIS_HIDDEN);
+  wm_client_freeze_hidden(s, hot);
   stack_remove(s, h);
+  wm_focus_history_update(s, h);
 
   if (s->focused_client == h) {
-    handle_t next_h = HANDLE_INVALID;
-    for (list_node_t* node = s->focus_history.next; node != &s->focus_history; node = node->next) {
-      client_hot_t* cand = (client_hot_t*)((char*)node - offsetof(client_hot_t, focus_node));
-      if (cand->state == STATE_MAPPED) {
-        next_h = cand->self;
-        break;
-      }
-    }
-    wm_set_focus(s, next_h);
+    wm_set_focus(s, wm_focus_history_pick(s, NULL, FOCUS_MRU_ANY_DESKTOP, FOCUS_MRU_MAPPED));
   }
 
   // Set WM_STATE to IconicState
   uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_ICONIC, XCB_NONE};
   xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
 
-  hot->dirty |= DIRTY_STATE;
+  server_mark_dirty(s, hot, DIRTY_STATE);
 }
 
 void wm_client_restore(server_t* s, handle_t h) {
@@ -2641,13 +3428,96 @@ void wm_client_restore(server_t* s, handle_t h) {
   LOG_INFO("Restoring client %u", hot->xid);
   TRACE_LOG("restore h=%lx xid=%u frame=%u layer=%d", h, hot->xid, hot->frame, hot->layer);
 
-  hot->state = STATE_MAPPED;
+  client_set_state(s, hot, STATE_MAPPED);
+  wm_client_thaw(s, hot);
+  client_complete_probe(s, hot);
   xcb_map_window(s->conn, hot->xid);
   xcb_map_window(s->conn, hot->frame);
+  client_set_frame_vis(s, hot, FRAME_VIS_MAPPED);
+  wm_desktop_members_touch(s, h);
+  wm_focus_history_update(s, h);
 
   uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_NORMAL, XCB_NONE};
   xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
 
-  hot->dirty |= DIRTY_STATE;
+  server_mark_dirty(s, hot, DIRTY_STATE);
   stack_raise(s, h);
 }
+
+/*
+ * Iconify a set of clients at once, e.g. for show desktop. hs is in stacking
+ * order, bottom first. The model changes for all of them before any request
+ * goes out; then the frames are unmapped bottom-up. That way each unmap only
+ * uncovers the root or a window that is going too, and no client is asked
+ * to repaint along the way. Focus moves once at the end, not once per
+ * focused client.
+ */
+void wm_clients_iconify_batch(server_t* s, const handle_t* hs, size_t n) {
+  bool lost_focus = false;
+  for (size_t i = 0; i < n; i++) {
+    client_hot_t* hot = server_chot(s, hs[i]);
+    if (!hot || hot->state != STATE_MAPPED)
+      continue;
+    TRACE_LOG("iconify batch h=%lx xid=%u frame=%u", hs[i], hot->xid, hot->frame);
+    client_set_state(s, hot, STATE_UNMAPPED);
+    stack_remove(s, hs[i]);
+    wm_focus_history_update(s, hs[i]);
+    server_mark_dirty(s, hot, DIRTY_STATE);
+    lost_focus |= (s->focused_client == hs[i]);
+  }
+
+  // Frames the visibility pass already hid need no second unmap
+  uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_ICONIC, XCB_NONE};
+  for (size_t i = 0; i < n; i++) {
+    client_hot_t* hot = server_chot(s, hs[i]);
+    if (!hot || hot->state != STATE_UNMAPPED || hot->frame_vis == FRAME_VIS_HIDDEN)
+      continue;
+    add_ignore_unmaps(hot, 2);
+    xcb_unmap_window(s->conn, hot->frame);
+    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
+    client_set_frame_vis(s, hot, FRAME_VIS_HIDDEN);
+  }
+  for (size_t i = 0; i < n; i++) {
+    client_hot_t* hot = server_chot(s, hs[i]);
+    if (hot && hot->state == STATE_UNMAPPED)
+      wm_client_freeze_hidden(s, hot);
+  }
+
+  if (lost_focus)
+    wm_set_focus(s, wm_focus_history_pick(s, NULL, FOCUS_MRU_ANY_DESKTOP, FOCUS_MRU_MAPPED));
+}
+
+/*
+ * Undo wm_clients_iconify_batch for hs, bottom first. Stacking is rebuilt in
+ * that order, and the frames shown now are mapped top-down: the top window
+ * covers its area first, so the ones below only paint what stays visible.
+ * Clients on desktops not shown are left to the visibility pass.
+ */
+void wm_clients_restore_batch(server_t* s, const handle_t* hs, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    client_hot_t* hot = server_chot(s, hs[i]);
+    if (!hot || hot->state != STATE_UNMAPPED)
+      continue;
+    TRACE_LOG("restore batch h=%lx xid=%u frame=%u", hs[i], hot->xid, hot->frame);
+    client_set_state(s, hot, STATE_MAPPED);
+    wm_desktop_members_touch(s, hs[i]);
+    wm_focus_history_update(s, hs[i]);
+    server_mark_dirty(s, hot, DIRTY_STATE);
+    stack_raise(s, hs[i]);
+  }
+
+  // Only the frame was unmapped on the way down, the client window is still mapped
+  uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_NORMAL, XCB_NONE};
+  for (size_t i = n; i-- > 0;) {
+    client_hot_t* hot = server_chot(s, hs[i]);
+    if (!hot || hot->state != STATE_MAPPED || hot->frame_vis == FRAME_VIS_MAPPED)
+      continue;
+    if (!hot->sticky && hot->desktop != (int32_t)client_screen(s, hot)->current_desktop)
+      continue;
+    wm_client_thaw(s, hot);
+    client_complete_probe(s, hot);
+    xcb_map_window(s->conn, hot->frame);
+    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
+    client_set_frame_vis(s, hot, FRAME_VIS_MAPPED);
+  }
+}
@@ -29,70 +29,115 @@ static bool wm_should_hide_for_show_desktop(const client_hot_t* hot) {
   return hot->type != WINDOW_TYPE_DOCK && hot->type != WINDOW_TYPE_DESKTOP;
 }
 
-static bool wm_client_should_be_visible_now(const server_t* s, const client_hot_t* hot) {
+static bool wm_client_should_be_visible_now(server_t* s, const client_hot_t* hot) {
   if (!s || !hot)
     return false;
-  return hot->sticky || (hot->desktop == (int32_t)s->current_desktop);
+  return hot->sticky || (hot->desktop == (int32_t)client_screen(s, hot)->current_desktop);
 }
 
-void wm_set_showing_desktop(server_t* s, bool show) {
-  if (!s)
+typedef struct show_desktop_entry {
+  handle_t h;
+  int8_t layer;
+  uint32_t label;
+} show_desktop_entry_t;
+
+static int show_desktop_entry_cmp(const void* a, const void* b) {
+  const show_desktop_entry_t* x = (const show_desktop_entry_t*)a;
+  const show_desktop_entry_t* y = (const show_desktop_entry_t*)b;
+  if (x->layer != y->layer)
+    return (x->layer < y->layer) ? -1 : 1;
+  return (x->label < y->label) ? -1 : (x->label > y->label);
+}
+
+static handle_t wm_desktop_focus_target(server_t* s, screen_t* scr, uint32_t desktop);
+
+/*
+ * Show desktop hides and restores its whole set in one batch each (see
+ * wm_clients_iconify_batch). The set is what is shown right now on scr,
+ * bottom first, and show_desktop_order keeps that order so leaving puts the
+ * stack back the way it was. Clients hidden by a manage in between come last.
+ */
+void wm_set_showing_desktop(server_t* s, screen_t* scr, bool show) {
+  if (!s || !scr)
     return;
-  if (s->showing_desktop == show)
+  if (scr->showing_desktop == show)
     return;
-  s->showing_desktop = show;
+  scr->showing_desktop = show;
   TRACE_LOG("showing_desktop set=%d", show);
 
-  s->root_dirty |= ROOT_DIRTY_SHOWING_DESKTOP;
+  scr->root_dirty |= ROOT_DIRTY_SHOWING_DESKTOP;
 
+  size_t n = s->active_clients.length;
   if (show) {
-    for (size_t i = 0; i < s->active_clients.length; i++) {
-      handle_t h = ptr_to_handle(s->active_clients.items[i]);
+    show_desktop_entry_t* set = n ? (show_desktop_entry_t*)arena_alloc(&s->tick_arena, n * sizeof(*set)) : NULL;
+    size_t count = 0;
+    for (size_t i = 0; set && i < n; i++) {
+      handle_t h = s->active_clients.items[i];
       client_hot_t* hot = server_chot(s, h);
-      if (!hot || hot->state != STATE_MAPPED)
+      if (!hot || hot->state != STATE_MAPPED || client_screen(s, hot) != scr)
         continue;
-      if (!wm_should_hide_for_show_desktop(hot))
+      if (!wm_should_hide_for_show_desktop(hot) || !wm_client_should_be_visible_now(s, hot))
         continue;
       hot->show_desktop_hidden = true;
-      TRACE_LOG("showing_desktop hide h=%lx xid=%u", h, hot->xid);
-      wm_client_iconify(s, h);
+      set[count++] = (show_desktop_entry_t){.h = h, .layer = hot->stacking_layer, .label = hot->stacking_label};
     }
-    wm_set_focus(s, HANDLE_INVALID);
+    qsort(set, count, sizeof(*set), show_desktop_entry_cmp);
+
+    handle_vec_clear(&scr->show_desktop_order);
+    for (size_t i = 0; i < count; i++)
+      handle_vec_push(&scr->show_desktop_order, set[i].h);
+    TRACE_LOG("showing_desktop hide count=%zu", count);
+    wm_clients_iconify_batch(s, scr->show_desktop_order.items, scr->show_desktop_order.length);
+    client_hot_t* focused = server_chot(s, s->focused_client);
+    if (!focused || client_screen(s, focused) == scr)
+      wm_set_focus(s, HANDLE_INVALID);
   }
   else {
-    for (size_t i = 0; i < s->active_clients.length; i++) {
-      handle_t h = ptr_to_handle(s->active_clients.items[i]);
-      client_hot_t* hot = server_chot(s, h);
+    handle_vec_t* order = &scr->show_desktop_order;
+    size_t kept = 0;
+    for (size_t i = 0; i < order->length; i++) {
+      client_hot_t* hot = server_chot(s, order->items[i]);
       if (hot && hot->show_desktop_hidden) {
         hot->show_desktop_hidden = false;
-        if (hot->state == STATE_UNMAPPED && wm_client_should_be_visible_now(s, hot)) {
-          LOG_DEBUG("wm_desktop: Restoring client %lx from unmapped state", h);
-          wm_client_restore(s, h);
-        }
+        order->items[kept++] = order->items[i];
+      }
+    }
+    order->length = kept;
+    for (size_t i = 0; i < n; i++) {
+      client_hot_t* hot = server_chot(s, s->active_clients.items[i]);
+      if (hot && hot->show_desktop_hidden && client_screen(s, hot) == scr) {
+        hot->show_desktop_hidden = false;
+        handle_vec_push(order, hot->self);
       }
     }
-    s->root_dirty |= ROOT_DIRTY_VISIBILITY | ROOT_DIRTY_ACTIVE_WINDOW;
+    TRACE_LOG("showing_desktop restore count=%zu", order->length);
+    wm_clients_restore_batch(s, order->items, order->length);
+    handle_vec_destroy(order);
+
+    if (s->focused_client == HANDLE_INVALID)
+      wm_set_focus(s, wm_desktop_focus_target(s, scr, scr->current_desktop));
+    scr->root_dirty |= ROOT_DIRTY_VISIBILITY | ROOT_DIRTY_ACTIVE_WINDOW;
   }
 }
 
-void wm_publish_desktop_props(server_t* s) {
+void wm_publish_desktop_props(server_t* s, screen_t* scr) {
   xcb_connection_t* conn = s->conn;
-  xcb_window_t root = s->root;
+  xcb_window_t root = scr->root;
 
-  if (s->desktop_count == 0)
-    s->desktop_count = 1;
-  if (s->current_desktop >= s->desktop_count)
-    s->current_desktop = 0;
+  if (scr->desktop_count == 0)
+    scr->desktop_count = 1;
+  if (scr->current_desktop >= scr->desktop_count)
+    scr->current_desktop = 0;
 
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_NUMBER_OF_DESKTOPS, XCB_ATOM_CARDINAL, 32, 1, &s->desktop_count);
-  xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &s->current_desktop);
+  wm_publish_root_prop(s, scr, ROOT_PROP_NUMBER_OF_DESKTOPS, atoms._NET_NUMBER_OF_DESKTOPS, XCB_ATOM_CARDINAL, 32, 1, &scr->desktop_count);
+  wm_publish_root_prop(s, scr, ROOT_PROP_CURRENT_DESKTOP, atoms._NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &scr->current_desktop);
 
-  xcb_window_t* vroots = calloc(s->desktop_count, sizeof(*vroots));
+  xcb_window_t* vroots = calloc(scr->desktop_count, sizeof(*vroots));
   if (vroots) {
-    for (uint32_t i = 0; i < s->desktop_count; i++) {
+    for (uint32_t i = 0; i < scr->desktop_count; i++) {
       vroots[i] = root;
     }
-    xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_VIRTUAL_ROOTS, XCB_ATOM_WINDOW, 32, s->desktop_count, vroots);
+    wm_publish_root_prop(s, scr, ROOT_PROP_VIRTUAL_ROOTS, atoms._NET_VIRTUAL_ROOTS, XCB_ATOM_WINDOW, 32, scr->desktop_count, vroots);
     free(vroots);
   }
 
@@ -111,7 +156,7 @@ void wm_publish_desktop_props(server_t* s) {
   }
 
   if (publish_names) {
-    uint32_t name_count = s->desktop_count;
+    uint32_t name_count = scr->desktop_count;
     size_t name_bytes = 0;
     for (uint32_t i = 0; i < name_count; i++) {
       const char* name = NULL;
@@ -153,14 +198,14 @@ void wm_publish_desktop_props(server_t* s) {
         memcpy(buf + offset, name, len);
         offset += len;
       }
-      xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_DESKTOP_NAMES, atoms.UTF8_STRING, 8, (uint32_t)name_bytes, buf);
+      wm_publish_root_prop(s, scr, ROOT_PROP_DESKTOP_NAMES, atoms._NET_DESKTOP_NAMES, atoms.UTF8_STRING, 8, (uint32_t)name_bytes, buf);
       free(buf);
     }
   }
 
-  uint32_t* viewport = calloc(s->desktop_count * 2, sizeof(uint32_t));
+  uint32_t* viewport = calloc(scr->desktop_count * 2, sizeof(uint32_t));
   if (viewport) {
-    xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms._NET_DESKTOP_VIEWPORT, XCB_ATOM_CARDINAL, 32, s->desktop_count * 2, viewport);
+    wm_publish_root_prop(s, scr, ROOT_PROP_DESKTOP_VIEWPORT, atoms._NET_DESKTOP_VIEWPORT, XCB_ATOM_CARDINAL, 32, scr->desktop_count * 2, viewport);
     free(viewport);
   }
 }
@@ -225,18 +270,18 @@ static void wa_shrink_bottom(rect_t* wa, int32_t new_bottom) {
   wa->h = (uint16_t)(new_bottom - y);
 }
 
-static uint32_t wm_effective_desktop_count(const server_t* s) {
-  if (!s || s->desktop_count == 0)
+static uint32_t wm_effective_desktop_count(const screen_t* scr) {
+  if (!scr || scr->desktop_count == 0)
     return 1;
-  return s->desktop_count;
+  return scr->desktop_count;
 }
 
-static uint32_t wm_desktop_index_for_client(const server_t* s, const client_hot_t* hot) {
-  uint32_t desktop_count = wm_effective_desktop_count(s);
+static uint32_t wm_desktop_index_for_client(const screen_t* scr, const client_hot_t* hot) {
+  uint32_t desktop_count = wm_effective_desktop_count(scr);
   if (!hot || hot->sticky || hot->desktop < 0)
-    return s ? s->current_desktop % desktop_count : 0;
+    return scr ? scr->current_desktop % desktop_count : 0;
   if ((uint32_t)hot->desktop >= desktop_count)
-    return s ? s->current_desktop % desktop_count : 0;
+    return scr ? scr->current_desktop % desktop_count : 0;
   return (uint32_t)hot->desktop;
 }
 
@@ -248,11 +293,11 @@ static bool wm_strut_applies_to_desktop(const client_hot_t* hot, uint32_t deskto
   return (uint32_t)hot->desktop == desktop;
 }
 
-static uint32_t wm_monitor_set(server_t* s, monitor_t* default_mon, monitor_t** out_mons, int32_t* out_screen_w, int32_t* out_screen_h) {
-  if (!s || !default_mon || !out_mons)
+static uint32_t wm_monitor_set(server_t* s, screen_t* scr, monitor_t* default_mon, monitor_t** out_mons, int32_t* out_screen_w, int32_t* out_screen_h) {
+  if (!s || !scr || !default_mon || !out_mons)
     return 0;
 
-  xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+  xcb_screen_t* screen = xcb_screen_of(s->conn, scr->num);
   int32_t screen_w = (int32_t)screen->width_in_pixels;
   int32_t screen_h = (int32_t)screen->height_in_pixels;
   if (out_screen_w)
@@ -260,9 +305,9 @@ static uint32_t wm_monitor_set(server_t* s, monitor_t* default_mon, monitor_t**
   if (out_screen_h)
     *out_screen_h = screen_h;
 
-  if (s->monitor_count > 0 && s->monitors) {
-    *out_mons = s->monitors;
-    return s->monitor_count;
+  if (scr->monitor_count > 0 && scr->monitors) {
+    *out_mons = scr->monitors;
+    return scr->monitor_count;
   }
 
   default_mon->geom.x = 0;
@@ -282,19 +327,22 @@ static void wm_reset_monitor_workareas(monitor_t* mons, uint32_t m_count) {
   }
 }
 
-static void wm_apply_struts_for_desktop(server_t* s, uint32_t desktop, monitor_t* mons, uint32_t m_count, int32_t screen_w, int32_t screen_h) {
+static bool wm_client_has_strut(const client_cold_t* cold) {
+  return cold->strut_partial_active || cold->strut_full_active || cold->strut.left > 0 || cold->strut.right > 0 || cold->strut.top > 0 || cold->strut.bottom > 0;
+}
+
+static void wm_apply_struts_for_desktop(server_t* s, screen_t* scr, uint32_t desktop, monitor_t* mons, uint32_t m_count, int32_t screen_w, int32_t screen_h) {
   if (!s || !mons || m_count == 0)
     return;
 
-  for (size_t i = 0; i < s->active_clients.length; i++) {
-    handle_t h = ptr_to_handle(s->active_clients.items[i]);
+  for (size_t i = 0; i < scr->strut_clients.length; i++) {
+    handle_t h = scr->strut_clients.items[i];
     client_hot_t* c = server_chot(s, h);
     client_cold_t* cold = server_ccold(s, h);
     if (!c || !cold)
       continue;
 
-    bool has_strut = cold->strut_partial_active || cold->strut_full_active || cold->strut.left > 0 || cold->strut.right > 0 || cold->strut.top > 0 || cold->strut.bottom > 0;
-    if (!has_strut)
+    if (!wm_client_has_strut(cold))
       continue;
     if (!wm_strut_applies_to_desktop(c, desktop))
       continue;
@@ -354,127 +402,191 @@ static void wm_apply_struts_for_desktop(server_t* s, uint32_t desktop, monitor_t
   }
 }
 
-void wm_compute_workareas(server_t* s, rect_t* out_workareas, uint32_t count) {
-  if (!s || !out_workareas || count == 0)
+void wm_workarea_invalidate(screen_t* scr) {
+  if (scr)
+    scr->workarea_cache_valid = false;
+}
+
+void wm_client_strut_changed(server_t* s, handle_t h) {
+  client_cold_t* cold = server_ccold(s, h);
+  if (!cold)
     return;
 
+  screen_t* scr = client_screen(s, server_chot(s, h));
+  if (wm_client_has_strut(cold)) {
+    if (handle_vec_find(&scr->strut_clients, h) == SIZE_MAX)
+      handle_vec_push(&scr->strut_clients, h);
+  }
+  else {
+    handle_vec_remove(&scr->strut_clients, h);
+  }
+  wm_workarea_invalidate(scr);
+}
+
+/*
+ * Rebuild the per-(desktop, monitor) workareas if they were invalidated or
+ * the desktop/monitor count moved. Only strut clients are visited, so a
+ * rebuild is O(desktops * struts * monitors) and a workspace switch is free.
+ * Returns the desktop-major table, or NULL if it could not be allocated.
+ */
+static const rect_t* wm_workarea_cache(server_t* s, screen_t* scr, uint32_t* out_m_count) {
   monitor_t default_mon;
   monitor_t* base_mons = NULL;
   int32_t screen_w = 0;
   int32_t screen_h = 0;
-  uint32_t m_count = wm_monitor_set(s, &default_mon, &base_mons, &screen_w, &screen_h);
+  uint32_t m_count = wm_monitor_set(s, scr, &default_mon, &base_mons, &screen_w, &screen_h);
+  uint32_t desktop_count = wm_effective_desktop_count(scr);
+  *out_m_count = m_count;
   if (m_count == 0)
-    return;
+    return NULL;
+
+  if (scr->workarea_cache_valid && scr->workarea_cache && scr->workarea_cache_desktops == desktop_count && scr->workarea_cache_monitors == m_count)
+    return scr->workarea_cache;
+
+  size_t cells = (size_t)desktop_count * m_count;
+  if (scr->workarea_cache_desktops * scr->workarea_cache_monitors != cells || !scr->workarea_cache) {
+    rect_t* cache = realloc(scr->workarea_cache, cells * sizeof(*cache));
+    if (!cache)
+      return NULL;
+    scr->workarea_cache = cache;
+  }
 
   monitor_t* scratch = calloc(m_count, sizeof(*scratch));
   if (!scratch) {
-    rect_t fallback = base_mons[0].geom;
+    scr->workarea_cache_valid = false;
+    return NULL;
+  }
+
+  for (uint32_t d = 0; d < desktop_count; d++) {
+    memcpy(scratch, base_mons, m_count * sizeof(*scratch));
+    wm_reset_monitor_workareas(scratch, m_count);
+    wm_apply_struts_for_desktop(s, scr, d, scratch, m_count, screen_w, screen_h);
+    for (uint32_t m = 0; m < m_count; m++)
+      scr->workarea_cache[(size_t)d * m_count + m] = scratch[m].workarea;
+  }
+  free(scratch);
+
+  scr->workarea_cache_desktops = desktop_count;
+  scr->workarea_cache_monitors = m_count;
+  scr->workarea_cache_valid = true;
+  return scr->workarea_cache;
+}
+
+void wm_compute_workareas(server_t* s, screen_t* scr, rect_t* out_workareas, uint32_t count) {
+  if (!s || !scr || !out_workareas || count == 0)
+    return;
+
+  uint32_t m_count = 0;
+  const rect_t* cache = wm_workarea_cache(s, scr, &m_count);
+  if (!cache) {
+    if (m_count == 0)
+      return;
+    rect_t fallback = scr->workarea;
+    if (scr->monitor_count > 0 && scr->monitors)
+      fallback = scr->monitors[0].geom;
     for (uint32_t d = 0; d < count; d++) {
       out_workareas[d] = fallback;
     }
     return;
   }
 
-  uint32_t desktop_count = wm_effective_desktop_count(s);
+  uint32_t desktop_count = scr->workarea_cache_desktops;
   if (desktop_count > count)
     desktop_count = count;
 
   for (uint32_t d = 0; d < desktop_count; d++) {
-    memcpy(scratch, base_mons, m_count * sizeof(*scratch));
-    wm_reset_monitor_workareas(scratch, m_count);
-    wm_apply_struts_for_desktop(s, d, scratch, m_count, screen_w, screen_h);
-    out_workareas[d] = scratch[0].workarea;
+    out_workareas[d] = cache[(size_t)d * m_count];
   }
 
   for (uint32_t d = desktop_count; d < count; d++) {
     out_workareas[d] = out_workareas[desktop_count - 1];
   }
-
-  free(scratch);
 }
 
 /*
  * wm_compute_workarea:
- * Calculate the current desktop usable geometry (minus panels/docks).
+ * Calculate the usable geometry of scr's current desktop (minus panels/docks).
  *
  * Logic:
  * 1. Start with full monitor geometry.
  * 2. Apply only struts that scope to the current desktop (or sticky clients).
  * 3. If a strut edge intersects a monitor edge, shrink the workarea.
- * 4. This is an O(N*M) operation, but N (struts) and M (monitors) are usually
- * small.
+ * 4. The result comes from the workarea cache, so this is O(M) unless a strut,
+ * monitor or desktop count change invalidated it.
+ *
+ * The per-monitor workareas of the current desktop are also stored in
+ * scr->monitors for callers that read them directly.
  */
-void wm_compute_workarea(server_t* s, rect_t* out) {
-  if (!s || !out)
+void wm_compute_workarea(server_t* s, screen_t* scr, rect_t* out) {
+  if (!s || !scr || !out)
     return;
 
-  monitor_t default_mon;
-  monitor_t* mons = NULL;
-  int32_t screen_w = 0;
-  int32_t screen_h = 0;
-  uint32_t m_count = wm_monitor_set(s, &default_mon, &mons, &screen_w, &screen_h);
-  if (m_count == 0)
+  uint32_t m_count = 0;
+  const rect_t* cache = wm_workarea_cache(s, scr, &m_count);
+  if (!cache)
     return;
 
-  uint32_t desktop = s->current_desktop;
-  uint32_t desktop_count = wm_effective_desktop_count(s);
-  if (desktop >= desktop_count)
+  uint32_t desktop = scr->current_desktop;
+  if (desktop >= scr->workarea_cache_desktops)
     desktop = 0;
 
-  wm_reset_monitor_workareas(mons, m_count);
-  wm_apply_struts_for_desktop(s, desktop, mons, m_count, screen_w, screen_h);
-  *out = mons[0].workarea;
+  const rect_t* row = &cache[(size_t)desktop * m_count];
+  if (scr->monitor_count == m_count && scr->monitors) {
+    for (uint32_t m = 0; m < m_count; m++)
+      scr->monitors[m].workarea = row[m];
+  }
+  *out = row[0];
 }
 
 void wm_get_client_workarea(server_t* s, const client_hot_t* hot, rect_t* out_workarea) {
   if (!s || !out_workarea)
     return;
 
-  monitor_t default_mon;
-  monitor_t* base_mons = NULL;
-  int32_t screen_w = 0;
-  int32_t screen_h = 0;
-  uint32_t m_count = wm_monitor_set(s, &default_mon, &base_mons, &screen_w, &screen_h);
-  if (m_count == 0) {
-    *out_workarea = s->workarea;
+  screen_t* scr = client_screen(s, hot);
+  uint32_t m_count = 0;
+  const rect_t* cache = wm_workarea_cache(s, scr, &m_count);
+  if (!cache) {
+    *out_workarea = scr->workarea;
     return;
   }
 
-  uint32_t desktop = wm_desktop_index_for_client(s, hot);
+  uint32_t desktop = wm_desktop_index_for_client(scr, hot);
+  if (desktop >= scr->workarea_cache_desktops)
+    desktop = 0;
   uint32_t monitor_idx = 0;
   if (hot && m_count > 1) {
-    int center_x = hot->server.x + (int32_t)hot->server.w / 2;
-    int center_y = hot->server.y + (int32_t)hot->server.h / 2;
-    int idx = wm_monitor_at_point(s, center_x, center_y);
-    if (idx >= 0 && (uint32_t)idx < m_count)
-      monitor_idx = (uint32_t)idx;
+    monitor_idx = wm_client_monitor(s, (client_hot_t*)hot);
+    if (monitor_idx >= m_count)
+      monitor_idx = 0;
   }
 
-  monitor_t* scratch = calloc(m_count, sizeof(*scratch));
-  if (!scratch) {
-    if (monitor_idx < m_count)
-      *out_workarea = base_mons[monitor_idx].workarea;
-    else
-      *out_workarea = base_mons[0].workarea;
-    return;
-  }
+  *out_workarea = cache[(size_t)desktop * m_count + monitor_idx];
+}
 
-  memcpy(scratch, base_mons, m_count * sizeof(*scratch));
-  wm_reset_monitor_workareas(scratch, m_count);
-  wm_apply_struts_for_desktop(s, desktop, scratch, m_count, screen_w, screen_h);
-  *out_workarea = scratch[monitor_idx < m_count ? monitor_idx : 0].workarea;
-  free(scratch);
+bool wm_monitor_workarea(server_t* s, screen_t* scr, uint32_t desktop, uint32_t monitor, rect_t* out) {
+  if (!s || !scr || !out)
+    return false;
+
+  uint32_t m_count = 0;
+  const rect_t* cache = wm_workarea_cache(s, scr, &m_count);
+  if (!cache || monitor >= m_count)
+    return false;
+  if (desktop >= scr->workarea_cache_desktops)
+    desktop = 0;
+
+  *out = cache[(size_t)desktop * m_count + monitor];
+  return true;
 }
 
-int wm_monitor_at_point(const server_t* s, int root_x, int root_y) {
-  if (!s || s->monitor_count == 0)
+int wm_monitor_at_point(const screen_t* scr, int root_x, int root_y) {
+  if (!scr || scr->monitor_count == 0)
     return -1;
 
   int best_idx = 0;
   int best_dist_sq = INT32_MAX;
 
-  for (uint32_t i = 0; i < s->monitor_count; i++) {
-    const monitor_t* mon = &s->monitors[i];
+  for (uint32_t i = 0; i < scr->monitor_count; i++) {
+    const monitor_t* mon = &scr->monitors[i];
     int mx1 = mon->geom.x;
     int my1 = mon->geom.y;
     int mx2 = mon->geom.x + (int)mon->geom.w;
@@ -498,52 +610,341 @@ int wm_monitor_at_point(const server_t* s, int root_x, int root_y) {
   return best_idx;
 }
 
-void wm_switch_workspace(server_t* s, uint32_t new_desktop) {
-  if (s->desktop_count == 0)
-    s->desktop_count = 1;
-  if (new_desktop >= s->desktop_count)
+/*
+ * Monitor of a client's committed geometry. The index is refreshed whenever
+ * server geometry is committed and tagged with its screen's monitor
+ * generation, so maximize/fullscreen/workarea lookups do not rescan monitors.
+ */
+void wm_client_update_monitor(server_t* s, client_hot_t* hot) {
+  if (!s || !hot)
     return;
-  if (new_desktop == s->current_desktop)
+
+  screen_t* scr = client_screen(s, hot);
+  hot->monitor = 0;
+  hot->monitor_gen = 0;
+  if (scr->monitor_count == 0 || !scr->monitors)
     return;
 
-  LOG_INFO("Switching workspace %u -> %u", s->current_desktop, new_desktop);
+  int center_x = hot->server.x + (int32_t)hot->server.w / 2;
+  int center_y = hot->server.y + (int32_t)hot->server.h / 2;
+  int idx = wm_monitor_at_point(scr, center_x, center_y);
+  if (idx < 0 || idx > UINT8_MAX)
+    return;
+  hot->monitor = (uint8_t)idx;
+  hot->monitor_gen = scr->monitor_generation;
+}
+
+uint32_t wm_client_monitor(server_t* s, client_hot_t* hot) {
+  if (!s || !hot)
+    return 0;
+  screen_t* scr = client_screen(s, hot);
+  if (scr->monitor_count <= 1 || !scr->monitors)
+    return 0;
+
+  if (hot->monitor_gen == 0 || hot->monitor_gen != scr->monitor_generation || hot->monitor >= scr->monitor_count) {
+    wm_client_update_monitor(s, hot);
+    if (hot->monitor >= scr->monitor_count)
+      return 0;
+  }
+  return hot->monitor;
+}
 
-  s->current_desktop = new_desktop;
+static bool wm_client_hit_testable(server_t* s, const client_hot_t* hot) {
+  return hot && hot->state == STATE_MAPPED && !hot->show_desktop_hidden && wm_client_should_be_visible_now(s, hot);
+}
 
-  s->root_dirty |= ROOT_DIRTY_VISIBILITY | ROOT_DIRTY_CURRENT_DESKTOP | ROOT_DIRTY_WORKAREA;
-  s->workarea_dirty = true;
+static bool wm_client_stacked_above(const client_hot_t* a, const client_hot_t* b) {
+  int la = stack_current_layer(a);
+  int lb = stack_current_layer(b);
+  if (la != lb)
+    return la > lb;
+  return a->stacking_label > b->stacking_label;
+}
+
+/*
+ * Topmost visible client on scr whose frame covers the point, or
+ * HANDLE_INVALID. Candidates come from the frame index, so the cost follows
+ * the number of windows overlapping one grid cell rather than the number of
+ * clients.
+ */
+handle_t wm_client_at_point(server_t* s, screen_t* scr, int root_x, int root_y) {
+  if (!s || !scr)
+    return HANDLE_INVALID;
+
+  handle_vec_t hits;
+  handle_vec_init(&hits);
+  spatial_index_query_point(&scr->frame_index, root_x, root_y, &hits);
+
+  handle_t best = HANDLE_INVALID;
+  client_hot_t* best_hot = NULL;
+  for (size_t i = 0; i < hits.length; i++) {
+    client_hot_t* hot = server_chot(s, hits.items[i]);
+    if (!wm_client_hit_testable(s, hot))
+      continue;
+    if (!best_hot || wm_client_stacked_above(hot, best_hot)) {
+      best = hits.items[i];
+      best_hot = hot;
+    }
+  }
+  handle_vec_destroy(&hits);
+  return best;
+}
+
+/* Append visible clients on scr whose frames intersect r, in no particular order */
+size_t wm_clients_in_rect(server_t* s, screen_t* scr, rect_t r, handle_vec_t* out) {
+  if (!s || !scr || !out)
+    return 0;
+
+  size_t start = out->length;
+  spatial_index_query_rect(&scr->frame_index, r, out);
+
+  size_t kept = start;
+  for (size_t i = start; i < out->length; i++) {
+    if (wm_client_hit_testable(s, server_chot(s, out->items[i])))
+      out->items[kept++] = out->items[i];
+  }
+  out->length = kept;
+  return kept - start;
+}
+
+void wm_desktop_focus_note(server_t* s, uint32_t desktop, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  if (!hot)
+    return;
+
+  screen_t* scr = client_screen(s, hot);
+  if (desktop >= scr->desktop_focus_cap) {
+    uint32_t cap = scr->desktop_focus_cap ? scr->desktop_focus_cap : 8;
+    while (cap <= desktop)
+      cap *= 2;
+    handle_t* heads = realloc(scr->desktop_focus, cap * sizeof(*heads));
+    if (!heads)
+      return;
+    for (uint32_t i = scr->desktop_focus_cap; i < cap; i++)
+      heads[i] = HANDLE_INVALID;
+    scr->desktop_focus = heads;
+    scr->desktop_focus_cap = cap;
+  }
+  scr->desktop_focus[desktop] = h;
+}
+
+/*
+ * Desktop membership index. Each client sits in at most one list: sticky
+ * clients in sticky_members, the rest in desktop_members[desktop]. The slot
+ * it occupies is remembered in cold->desktop_member so a move touches only
+ * the two lists involved. desktop_members_clients counts indexed clients;
+ * if it disagrees with active_clients something was added behind the
+ * index's back and the next use rebuilds it.
+ */
+static uint32_t wm_desktop_member_slot(const screen_t* scr, const client_hot_t* hot) {
+  if (hot->sticky)
+    return DESKTOP_MEMBER_STICKY;
+  if (hot->desktop < 0 || (uint32_t)hot->desktop >= scr->desktop_members_count)
+    return DESKTOP_MEMBER_UNLISTED;
+  return (uint32_t)hot->desktop + DESKTOP_MEMBER_FIRST;
+}
+
+static handle_vec_t* wm_desktop_member_list(screen_t* scr, uint32_t slot) {
+  if (slot == DESKTOP_MEMBER_STICKY)
+    return &scr->sticky_members;
+  if (slot >= DESKTOP_MEMBER_FIRST && slot - DESKTOP_MEMBER_FIRST < scr->desktop_members_count)
+    return &scr->desktop_members[slot - DESKTOP_MEMBER_FIRST];
+  return NULL;
+}
+
+void wm_desktop_members_invalidate(server_t* s) {
+  if (s)
+    s->desktop_members_valid = false;
+}
+
+static void wm_desktop_members_free(screen_t* scr) {
+  for (uint32_t i = 0; i < scr->desktop_members_count; i++)
+    handle_vec_destroy(&scr->desktop_members[i]);
+  free(scr->desktop_members);
+  scr->desktop_members = NULL;
+  scr->desktop_members_count = 0;
+}
+
+void wm_desktop_members_destroy(server_t* s) {
+  for (uint32_t i = 0; i < HXM_MAX_SCREENS; i++)
+    wm_desktop_members_free(&s->screens[i]);
+  s->desktop_members_valid = false;
+}
+
+bool wm_desktop_members_ensure(server_t* s) {
+  if (s->desktop_members_valid && s->desktop_members_clients == s->active_clients.length)
+    return true;
+  s->desktop_members_valid = false;
+
+  uint32_t counts[HXM_MAX_SCREENS];
+  for (uint32_t i = 0; i < server_screen_count(s); i++)
+    counts[i] = s->screens[i].desktop_count ? s->screens[i].desktop_count : 1;
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    client_hot_t* hot = server_chot(s, s->active_clients.items[i]);
+    if (hot && !hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop >= counts[hot->screen])
+      counts[hot->screen] = (uint32_t)hot->desktop + 1;
+  }
+
+  for (uint32_t n = 0; n < server_screen_count(s); n++) {
+    screen_t* scr = &s->screens[n];
+    // Vectors keep inline storage and cannot be moved, so grow by replacement
+    if (counts[n] > scr->desktop_members_count) {
+      handle_vec_t* lists = malloc(counts[n] * sizeof(*lists));
+      if (!lists)
+        return false;
+      for (uint32_t i = 0; i < counts[n]; i++)
+        handle_vec_init(&lists[i]);
+      wm_desktop_members_free(scr);
+      scr->desktop_members = lists;
+      scr->desktop_members_count = counts[n];
+    }
+    for (uint32_t i = 0; i < scr->desktop_members_count; i++)
+      scr->desktop_members[i].length = 0;
+    scr->sticky_members.length = 0;
+    scr->visibility_moved.length = 0;
+  }
+  s->desktop_members_clients = 0;
+
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t h = s->active_clients.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold)
+      continue;
+    screen_t* scr = client_screen(s, hot);
+    cold->desktop_member = wm_desktop_member_slot(scr, hot);
+    s->desktop_members_clients++;
+    handle_vec_t* list = wm_desktop_member_list(scr, cold->desktop_member);
+    if (list)
+      handle_vec_push(list, h);
+  }
+
+  s->desktop_members_valid = true;
+  return false;
+}
+
+handle_vec_t* wm_desktop_members(server_t* s, screen_t* scr, uint32_t desktop) {
+  if (!s || !scr)
+    return NULL;
+  wm_desktop_members_ensure(s);
+  if (!s->desktop_members_valid || desktop >= scr->desktop_members_count)
+    return NULL;
+  return &scr->desktop_members[desktop];
+}
+
+void wm_desktop_members_sync(server_t* s, handle_t h) {
+  if (!s || !s->desktop_members_valid)
+    return;
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return;
+
+  // A desktop past the end of the table needs it regrown; let the rebuild do it
+  screen_t* scr = client_screen(s, hot);
+  if (!hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop >= scr->desktop_members_count) {
+    s->desktop_members_valid = false;
+    return;
+  }
+
+  uint32_t slot = wm_desktop_member_slot(scr, hot);
+  if (slot == cold->desktop_member)
+    return;
+
+  if (cold->desktop_member == DESKTOP_MEMBER_NONE)
+    s->desktop_members_clients++;
+  handle_vec_t* old_list = wm_desktop_member_list(scr, cold->desktop_member);
+  handle_vec_t* new_list = wm_desktop_member_list(scr, slot);
+  if (old_list)
+    handle_vec_remove(old_list, h);
+  if (new_list)
+    handle_vec_push(new_list, h);
+  cold->desktop_member = slot;
+  wm_desktop_members_touch(s, h);
+}
+
+void wm_desktop_members_touch(server_t* s, handle_t h) {
+  if (!s || !s->desktop_members_valid)
+    return;
+  client_hot_t* hot = server_chot(s, h);
+  if (!hot)
+    return;
+  screen_t* scr = client_screen(s, hot);
+  if (handle_vec_find(&scr->visibility_moved, h) == SIZE_MAX)
+    handle_vec_push(&scr->visibility_moved, h);
+}
+
+void wm_desktop_members_remove(server_t* s, handle_t h) {
+  if (!s)
+    return;
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return;
+  if (s->desktop_members_valid && cold->desktop_member != DESKTOP_MEMBER_NONE) {
+    screen_t* scr = client_screen(s, hot);
+    handle_vec_t* list = wm_desktop_member_list(scr, cold->desktop_member);
+    if (list)
+      handle_vec_remove(list, h);
+    handle_vec_remove_swap(&scr->visibility_moved, h);
+    s->desktop_members_clients--;
+  }
+  cold->desktop_member = DESKTOP_MEMBER_NONE;
+}
+
+/*
+ * Focus target for a desktop being switched to. The per-desktop head is
+ * checked first, so the common case is O(1); only a stale head (client
+ * gone, iconified or moved away) falls back to the MRU walk.
+ */
+static handle_t wm_desktop_focus_target(server_t* s, screen_t* scr, uint32_t desktop) {
+  if (desktop < scr->desktop_focus_cap) {
+    handle_t h = scr->desktop_focus[desktop];
+    client_hot_t* c = (h != HANDLE_INVALID) ? server_chot(s, h) : NULL;
+    if (c && c->state == STATE_MAPPED && client_screen(s, c) == scr && (c->desktop == (int32_t)desktop || c->sticky))
+      return h;
+  }
+
+  return wm_focus_history_pick(s, scr, (int32_t)desktop, FOCUS_MRU_MAPPED);
+}
+
+void wm_switch_workspace(server_t* s, screen_t* scr, uint32_t new_desktop) {
+  if (scr->desktop_count == 0)
+    scr->desktop_count = 1;
+  if (new_desktop >= scr->desktop_count)
+    return;
+  if (new_desktop == scr->current_desktop)
+    return;
+
+  LOG_INFO("Switching workspace %u -> %u", scr->current_desktop, new_desktop);
+
+  scr->current_desktop = new_desktop;
+
+  scr->root_dirty |= ROOT_DIRTY_VISIBILITY | ROOT_DIRTY_CURRENT_DESKTOP | ROOT_DIRTY_WORKAREA;
+  scr->workarea_dirty = true;
 
   bool focused_visible = false;
   if (s->focused_client != HANDLE_INVALID) {
     client_hot_t* c = server_chot(s, s->focused_client);
-    if (c && (c->desktop == (int32_t)new_desktop || c->sticky))
+    if (c && client_screen(s, c) == scr && (c->desktop == (int32_t)new_desktop || c->sticky))
       focused_visible = true;
   }
 
-  if (!focused_visible) {
-    handle_t new_focus = HANDLE_INVALID;
-    for (list_node_t* node = s->focus_history.next; node != &s->focus_history; node = node->next) {
-      client_hot_t* c = (client_hot_t*)((char*)node - offsetof(client_hot_t, focus_node));
-      if (c->state == STATE_MAPPED && (c->desktop == (int32_t)new_desktop || c->sticky)) {
-        new_focus = c->self;
-        break;
-      }
-    }
-    wm_set_focus(s, new_focus);
-  }
+  if (!focused_visible)
+    wm_set_focus(s, wm_desktop_focus_target(s, scr, new_desktop));
 
-  s->root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
+  scr->root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
 }
 
-void wm_switch_workspace_relative(server_t* s, int delta) {
-  if (s->desktop_count == 0)
-    s->desktop_count = 1;
-  int32_t next = (int32_t)s->current_desktop + delta;
+void wm_switch_workspace_relative(server_t* s, screen_t* scr, int delta) {
+  if (scr->desktop_count == 0)
+    scr->desktop_count = 1;
+  // Wraps, also for a held key's steps folded into one delta
+  int32_t count = (int32_t)scr->desktop_count;
+  int32_t next = ((int32_t)scr->current_desktop + delta % count) % count;
   if (next < 0)
-    next = (int32_t)s->desktop_count - 1;
-  if (next >= (int32_t)s->desktop_count)
-    next = 0;
-  wm_switch_workspace(s, (uint32_t)next);
+    next += count;
+  wm_switch_workspace(s, scr, (uint32_t)next);
 }
 
 void wm_client_move_to_workspace(server_t* s, handle_t h, uint32_t desktop, bool follow) {
@@ -551,13 +952,14 @@ void wm_client_move_to_workspace(server_t* s, handle_t h, uint32_t desktop, bool
   client_cold_t* cold = server_ccold(s, h);
   if (!c)
     return;
+  screen_t* scr = client_screen(s, c);
 
   if (c->sticky && (c->type == WINDOW_TYPE_DOCK || c->type == WINDOW_TYPE_DESKTOP) && desktop != 0xFFFFFFFF) {
     desktop = 0xFFFFFFFF;
   }
 
-  if (desktop != 0xFFFFFFFF && desktop >= s->desktop_count) {
-    if (s->desktop_count == 1) {
+  if (desktop != 0xFFFFFFFF && desktop >= scr->desktop_count) {
+    if (scr->desktop_count == 1) {
       desktop = 0;
     }
     else {
@@ -569,36 +971,35 @@ void wm_client_move_to_workspace(server_t* s, handle_t h, uint32_t desktop, bool
 
   LOG_INFO("Moving client %u to desktop %d (follow=%d)", c->xid, new_desk, follow);
 
-  c->desktop = new_desk;
-  c->sticky = (new_desk == -1);
+  // A focused window sent elsewhere is what that desktop should focus next
+  if (s->focused_client == h && new_desk >= 0)
+    wm_desktop_focus_note(s, (uint32_t)new_desk, h);
+
+  client_set_desktop(s, c, new_desk);
+  client_set_sticky(s, c, new_desk == -1);
+  wm_desktop_members_sync(s, h);
+  wm_focus_history_update(s, h);
   if (cold && (cold->strut_partial_active || cold->strut_full_active)) {
-    s->root_dirty |= ROOT_DIRTY_WORKAREA;
-    s->workarea_dirty = true;
+    wm_workarea_invalidate(scr);
+    scr->root_dirty |= ROOT_DIRTY_WORKAREA;
+    scr->workarea_dirty = true;
   }
 
   if (follow && !c->sticky) {
-    wm_switch_workspace(s, desktop);
+    wm_switch_workspace(s, scr, desktop);
     wm_set_focus(s, h);
   }
   else if (c->state == STATE_MAPPED) {
-    s->root_dirty |= ROOT_DIRTY_VISIBILITY;
+    scr->root_dirty |= ROOT_DIRTY_VISIBILITY;
 
-    bool visible = c->sticky || (c->desktop == (int32_t)s->current_desktop);
+    bool visible = c->sticky || (c->desktop == (int32_t)scr->current_desktop);
     if (!visible && s->focused_client == h) {
-      handle_t new_focus = HANDLE_INVALID;
-      for (list_node_t* node = s->focus_history.next; node != &s->focus_history; node = node->next) {
-        client_hot_t* hc = (client_hot_t*)((char*)node - offsetof(client_hot_t, focus_node));
-        if (hc->state == STATE_MAPPED && (hc->desktop == (int32_t)s->current_desktop || hc->sticky)) {
-          new_focus = hc->self;
-          break;
-        }
-      }
-      wm_set_focus(s, new_focus);
+      wm_set_focus(s, wm_focus_history_pick(s, scr, (int32_t)scr->current_desktop, FOCUS_MRU_MAPPED));
     }
   }
 
-  c->dirty |= DIRTY_STATE | DIRTY_DESKTOP;
-  s->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING | ROOT_DIRTY_ACTIVE_WINDOW;
+  server_mark_dirty(s, c, DIRTY_STATE | DIRTY_DESKTOP);
+  scr->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING | ROOT_DIRTY_ACTIVE_WINDOW;
 }
 
 void wm_client_toggle_sticky(server_t* s, handle_t h) {
@@ -606,34 +1007,30 @@ void wm_client_toggle_sticky(server_t* s, handle_t h) {
   client_cold_t* cold = server_ccold(s, h);
   if (!c)
     return;
+  screen_t* scr = client_screen(s, c);
 
-  c->sticky = !c->sticky;
+  client_set_sticky(s, c, !c->sticky);
   if (c->sticky && (c->type == WINDOW_TYPE_DOCK || c->type == WINDOW_TYPE_DESKTOP)) {
-    c->desktop = -1;
+    client_set_desktop(s, c, -1);
   }
+  wm_desktop_members_sync(s, h);
+  wm_focus_history_update(s, h);
   if (cold && (cold->strut_partial_active || cold->strut_full_active)) {
-    s->root_dirty |= ROOT_DIRTY_WORKAREA;
-    s->workarea_dirty = true;
+    wm_workarea_invalidate(scr);
+    scr->root_dirty |= ROOT_DIRTY_WORKAREA;
+    scr->workarea_dirty = true;
   }
 
   LOG_INFO("Client %u sticky toggled to %d", c->xid, c->sticky);
 
   if (c->state == STATE_MAPPED) {
-    s->root_dirty |= ROOT_DIRTY_VISIBILITY;
+    scr->root_dirty |= ROOT_DIRTY_VISIBILITY;
 
-    bool visible = c->sticky || (c->desktop == (int32_t)s->current_desktop);
+    bool visible = c->sticky || (c->desktop == (int32_t)scr->current_desktop);
     if (!visible && s->focused_client == h) {
-      handle_t new_focus = HANDLE_INVALID;
-      for (list_node_t* node = s->focus_history.next; node != &s->focus_history; node = node->next) {
-        client_hot_t* hc = (client_hot_t*)((char*)node - offsetof(client_hot_t, focus_node));
-        if (hc->state == STATE_MAPPED && (hc->desktop == (int32_t)s->current_desktop || hc->sticky)) {
-          new_focus = hc->self;
-          break;
-        }
-      }
-      wm_set_focus(s, new_focus);
+      wm_set_focus(s, wm_focus_history_pick(s, scr, (int32_t)scr->current_desktop, FOCUS_MRU_MAPPED));
     }
   }
 
-  c->dirty |= DIRTY_STATE | DIRTY_DESKTOP;
+  server_mark_dirty(s, c, DIRTY_STATE | DIRTY_DESKTOP);
 }
@@ -11,7 +11,8 @@
  *  1. Iterates over all active clients.
  *  2. Resolves conflicting dirty states.
  *  3. Batches XCB requests (ConfigureWindow, ChangeProperty).
- *  4. Updates global properties (ClientList, Workarea).
+ *  4. Paints every dirty frame in one pass after geometry and stacking.
+ *  5. Updates global properties (ClientList, Workarea).
  *
  * This ensures:
  *  - Visual consistency (no half-applied states).
@@ -23,6 +24,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <xcb/damage.h>
+#include <xcb/sync.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_icccm.h>
 
@@ -31,9 +33,14 @@
 #include "frame.h"
 #include "hxm.h"
 #include "snap_preview.h"
+#include "thumbnail.h"
+#include "tracepoint.h"
 #include "wm.h"
 #include "wm_internal.h"
 
+#define INTERACTION_DEFAULT_MHZ 60000u
+#define SYNC_ALARM_TIMEOUT_NS 100000000u /* a client that stops answering resizes at 10 Hz */
+
 static bool wm_client_is_hidden(const server_t* s, const client_hot_t* hot) {
   (void)s;
   if (!hot)
@@ -86,20 +93,67 @@ void wm_send_sync_request(server_t* s, const client_hot_t* hot, uint64_t value,
   xcb_send_event(s->conn, 0, hot->xid, XCB_EVENT_MASK_NO_EVENT, (const char*)&ev);
 }
 
-static rect_t wm_monitor_bounds_for_rect(server_t* s, const rect_t* r) {
+/*
+ * Point the client's alarm at value, creating it on first use. The alarm
+ * fires once the client's counter reaches value, i.e. it has handled the
+ * configure and redrawn; delta 0 leaves it inactive until the next change.
+ */
+static bool wm_sync_alarm_arm(server_t* s, client_cold_t* cold, uint64_t value) {
+  if (!s->sync_supported || cold->sync_counter == XCB_NONE)
+    return false;
+
+  uint32_t hi = (uint32_t)(value >> 32);
+  uint32_t lo = (uint32_t)(value & 0xFFFFFFFFu);
+  if (cold->sync_alarm == XCB_NONE) {
+    cold->sync_alarm = xcb_generate_id(s->conn);
+    uint32_t mask = XCB_SYNC_CA_COUNTER | XCB_SYNC_CA_VALUE_TYPE | XCB_SYNC_CA_VALUE | XCB_SYNC_CA_TEST_TYPE | XCB_SYNC_CA_DELTA | XCB_SYNC_CA_EVENTS;
+    uint32_t values[] = {cold->sync_counter, XCB_SYNC_VALUETYPE_ABSOLUTE, hi, lo, XCB_SYNC_TESTTYPE_POSITIVE_COMPARISON, 0, 0, 1};
+    xcb_sync_create_alarm(s->conn, cold->sync_alarm, mask, values);
+  }
+  else {
+    uint32_t values[] = {hi, lo};
+    xcb_sync_change_alarm(s->conn, cold->sync_alarm, XCB_SYNC_CA_VALUE, values);
+  }
+  return true;
+}
+
+void wm_handle_sync_alarm(server_t* s, const xcb_sync_alarm_notify_event_t* ev) {
+  // Only the client being resized is ever gated
+  client_cold_t* cold = server_ccold(s, s->interaction_handle);
+  if (!cold || cold->sync_alarm == XCB_NONE || cold->sync_alarm != ev->alarm || cold->sync_wait_value == 0)
+    return;
+
+  uint64_t value = ((uint64_t)(uint32_t)ev->counter_value.hi << 32) | (uint64_t)ev->counter_value.lo;
+  if (value >= cold->sync_wait_value)
+    cold->sync_wait_value = 0;
+}
+
+/* Frame the interactive client would get if its desired geometry were committed */
+static rect_t wm_outline_rect(server_t* s, const client_hot_t* hot, const client_cold_t* cold) {
+  rect_t r = hot->desired;
+  if (!cold || cold->gtk_frame_extents_set)
+    return r;
+  uint16_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
+  uint16_t th = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.title_height;
+  r.w = (uint16_t)(r.w + 2u * bw);
+  r.h = (uint16_t)(r.h + th + bw);
+  return r;
+}
+
+static rect_t wm_monitor_bounds_for_rect(server_t* s, const screen_t* scr, const rect_t* r) {
   rect_t bounds;
 
-  if (s->monitor_count > 0 && s->monitors) {
+  if (scr->monitor_count > 0 && scr->monitors) {
     int center_x = r->x + (int32_t)r->w / 2;
     int center_y = r->y + (int32_t)r->h / 2;
-    int mid = wm_monitor_at_point(s, center_x, center_y);
-    if (mid < 0 || (uint32_t)mid >= s->monitor_count)
+    int mid = wm_monitor_at_point(scr, center_x, center_y);
+    if (mid < 0 || (uint32_t)mid >= scr->monitor_count)
       mid = 0;
-    bounds = s->monitors[mid].geom;
+    bounds = scr->monitors[mid].geom;
     return bounds;
   }
 
-  xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+  xcb_screen_t* screen = xcb_screen_of(s->conn, scr->num);
   bounds.x = 0;
   bounds.y = 0;
   bounds.w = (uint16_t)screen->width_in_pixels;
@@ -137,60 +191,18 @@ static void wm_clamp_rect_to_bounds(rect_t* r, const rect_t* bounds) {
   r->y = (int16_t)y;
 }
 
+// Requests for windows we don't manage go out as the client asked. Ingest
+// already routed them here, so there is no client lookup per entry.
 static bool wm_flush_unmanaged_configure_requests(server_t* s) {
-  bool sent = false;
-  size_t key_count = s->buckets.configure_request_keys.length;
-
-  if (key_count > 0) {
-    for (size_t i = 0; i < key_count; i++) {
-      uint64_t* key_ptr = (uint64_t*)s->buckets.configure_request_keys.items[i];
-      if (!key_ptr)
-        continue;
-
-      pending_config_t* ev = (pending_config_t*)hash_map_get(&s->buckets.configure_requests, *key_ptr);
-      if (!ev || ev->mask == 0)
-        continue;
-      if (server_get_client_by_window(s, ev->window) != HANDLE_INVALID)
-        continue;
-
-      uint16_t mask = ev->mask;
-      uint32_t values[7];
-      int j = 0;
-
-      if (mask & XCB_CONFIG_WINDOW_X)
-        values[j++] = (uint32_t)(int32_t)ev->x;
-      if (mask & XCB_CONFIG_WINDOW_Y)
-        values[j++] = (uint32_t)(int32_t)ev->y;
-      if (mask & XCB_CONFIG_WINDOW_WIDTH)
-        values[j++] = (uint32_t)ev->width;
-      if (mask & XCB_CONFIG_WINDOW_HEIGHT)
-        values[j++] = (uint32_t)ev->height;
-      if (mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
-        values[j++] = (uint32_t)ev->border_width;
-      if (mask & XCB_CONFIG_WINDOW_SIBLING)
-        values[j++] = (uint32_t)ev->sibling;
-      if (mask & XCB_CONFIG_WINDOW_STACK_MODE)
-        values[j++] = (uint32_t)ev->stack_mode;
-
-      xcb_configure_window(s->conn, ev->window, mask, values);
-      ev->mask = 0;
-      sent = true;
-    }
-    return sent;
-  }
-
-  for (size_t i = 0; i < s->buckets.configure_requests.capacity; i++) {
-    hash_map_entry_t* entry = &s->buckets.configure_requests.entries[i];
-    if (!entry->key || !entry->value)
-      continue;
+  event_buckets_t* b = &s->buckets;
+  uint64_t before = b->unmanaged_forwarded;
 
-    pending_config_t* ev = (pending_config_t*)entry->value;
-    if (!ev || ev->mask == 0)
-      continue;
-    if (server_get_client_by_window(s, ev->window) != HANDLE_INVALID)
+  for (uint32_t i = 0; i < b->unmanaged_configs_len; i++) {
+    pending_config_t* ev = &b->unmanaged_configs[i];
+    uint16_t mask = ev->mask;
+    if (mask == 0)
       continue;
 
-    uint16_t mask = ev->mask;
     uint32_t values[7];
     int j = 0;
 
@@ -211,10 +223,11 @@ static bool wm_flush_unmanaged_configure_requests(server_t* s) {
 
     xcb_configure_window(s->conn, ev->window, mask, values);
     ev->mask = 0;
-    sent = true;
+    b->unmanaged_forwarded++;
   }
+  b->unmanaged_configs_len = 0;
 
-  return sent;
+  return b->unmanaged_forwarded != before;
 }
 
 bool wm_send_synthetic_configure(server_t* s, handle_t h) {
@@ -222,6 +235,9 @@ bool wm_send_synthetic_configure(server_t* s, handle_t h) {
   client_cold_t* cold = server_ccold(s, h);
   if (!hot || !cold)
     return false;
+  // Held until it answers a ping again (wm_ping_reply queues one)
+  if (cold->ping_hung)
+    return false;
 
   uint16_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
   uint16_t th = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.title_height;
@@ -249,6 +265,7 @@ bool wm_send_synthetic_configure(server_t* s, handle_t h) {
   ev->override_redirect = hot->override_redirect;
 
   if (hot->last_synthetic_geom.x == ev->x && hot->last_synthetic_geom.y == ev->y && hot->last_synthetic_geom.w == ev->width && hot->last_synthetic_geom.h == ev->height) {
+    s->synthetic_suppressed++;
     return false;
   }
   hot->last_synthetic_geom.x = ev->x;
@@ -258,62 +275,70 @@ bool wm_send_synthetic_configure(server_t* s, handle_t h) {
 
   TRACE_LOG("synthetic_configure xid=%u x=%d y=%d w=%u h=%u", hot->xid, ev->x, ev->y, ev->width, ev->height);
   xcb_send_event(s->conn, 0, hot->xid, XCB_EVENT_MASK_NO_EVENT, buffer);
+  s->synthetic_sent++;
   return true;
 }
 
-void wm_publish_workarea(server_t* s, const rect_t* wa) {
+void wm_publish_workarea(server_t* s, screen_t* scr, const rect_t* wa) {
   if (!s || !wa)
     return;
 
-  s->workarea = *wa;
+  scr->workarea = *wa;
 
-  uint32_t n = s->desktop_count ? s->desktop_count : 1;
+  uint32_t n = scr->desktop_count ? scr->desktop_count : 1;
   rect_t* desktop_workareas = (rect_t*)arena_alloc(&s->tick_arena, n * sizeof(*desktop_workareas));
   if (desktop_workareas) {
-    wm_compute_workareas(s, desktop_workareas, n);
+    wm_compute_workareas(s, scr, desktop_workareas, n);
   }
 
   uint32_t* wa_vals = (uint32_t*)arena_alloc(&s->tick_arena, n * 4 * sizeof(uint32_t));
   if (wa_vals) {
     for (uint32_t i = 0; i < n; i++) {
-      rect_t wa_i = desktop_workareas ? desktop_workareas[i] : s->workarea;
+      rect_t wa_i = desktop_workareas ? desktop_workareas[i] : scr->workarea;
       wa_vals[i * 4 + 0] = (uint32_t)wa_i.x;
       wa_vals[i * 4 + 1] = (uint32_t)wa_i.y;
       wa_vals[i * 4 + 2] = (uint32_t)wa_i.w;
       wa_vals[i * 4 + 3] = (uint32_t)wa_i.h;
     }
-    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_WORKAREA, XCB_ATOM_CARDINAL, 32, n * 4, wa_vals);
+    wm_publish_root_prop(s, scr, ROOT_PROP_WORKAREA, atoms._NET_WORKAREA, XCB_ATOM_CARDINAL, 32, n * 4, wa_vals);
   }
 
-  // Re-apply workarea-dependent geometry for maximized/fullscreen windows
+  // Re-apply workarea-dependent geometry for maximized/fullscreen windows.
+  // Only those whose workarea changed are queued for a configure.
   for (size_t i = 0; i < s->active_clients.length; i++) {
-    handle_t h = ptr_to_handle(s->active_clients.items[i]);
+    handle_t h = s->active_clients.items[i];
     client_hot_t* hot = server_chot(s, h);
     if (!hot)
       continue;
 
     if (hot->state == STATE_UNMANAGING || hot->state == STATE_DESTROYED)
       continue;
+    if (client_screen(s, hot) != scr)
+      continue;
 
     if (hot->layer == LAYER_FULLSCREEN && s->config.fullscreen_use_workarea) {
-      wm_get_client_workarea(s, hot, &hot->desired);
-      hot->dirty |= DIRTY_GEOM;
+      rect_t fs;
+      wm_get_client_workarea(s, hot, &fs);
+      if (fs.x != hot->desired.x || fs.y != hot->desired.y || fs.w != hot->desired.w || fs.h != hot->desired.h) {
+        hot->desired = fs;
+        server_mark_dirty(s, hot, DIRTY_GEOM);
+      }
     }
     else if (hot->maximized_horz || hot->maximized_vert) {
-      wm_client_set_maximize(s, hot, hot->maximized_horz, hot->maximized_vert);
+      wm_client_refit_maximize(s, hot);
     }
   }
 }
 
-static uint32_t wm_build_client_list_stacking(server_t* s, xcb_window_t* out, uint32_t cap) {
+static uint32_t wm_build_client_list_stacking(server_t* s, const screen_t* scr, xcb_window_t* out, uint32_t cap) {
   if (!s || !out || !cap)
     return 0;
 
   uint32_t idx = 0;
   for (int l = 0; l < LAYER_COUNT; l++) {
-    small_vec_t* v = &s->layers[l];
+    const handle_vec_t* v = &scr->layers[l];
     for (size_t i = 0; i < v->length; i++) {
-      handle_t h = ptr_to_handle(v->items[i]);
+      handle_t h = v->items[i];
       client_hot_t* hot = server_chot(s, h);
       if (!hot)
         continue;
@@ -321,11 +346,6 @@ static uint32_t wm_build_client_list_stacking(server_t* s, xcb_window_t* out, ui
         continue;
       if (idx >= cap)
         return idx;
-#ifndef NDEBUG
-      for (uint32_t j = 0; j < idx; j++) {
-        assert(out[j] != hot->xid);
-      }
-#endif
       out[idx++] = hot->xid;
     }
   }
@@ -333,622 +353,908 @@ static uint32_t wm_build_client_list_stacking(server_t* s, xcb_window_t* out, ui
   return idx;
 }
 
-static uint32_t wm_build_client_list(server_t* s, xcb_window_t* out, uint32_t cap) {
+#ifndef NDEBUG
+/* The client columns mirror client_hot_t for slot idx */
+static bool wm_cols_agree(server_t* s, const client_cols_t* cols, uint32_t idx) {
+  const client_hot_t* hot = (const client_hot_t*)slotmap_hot_at(&s->clients, idx);
+  return hot && cols->xid[idx] == hot->xid && cols->state[idx] == hot->state && cols->desktop[idx] == hot->desktop &&
+         cols->sticky[idx] == (uint8_t)hot->sticky && cols->frame_vis[idx] == hot->frame_vis && cols->screen[idx] == hot->screen;
+}
+#endif
+
+/* _NET_CLIENT_LIST of one screen: its clients in manage order */
+static uint32_t wm_build_client_list(server_t* s, const screen_t* scr, xcb_window_t* out, uint32_t cap) {
   if (!s || !out || !cap)
     return 0;
 
+  uint8_t screen = (uint8_t)server_screen_index(s, scr);
+
+  client_cols_t cols;
+  bool soa = server_client_cols(s, &cols);
+
   uint32_t idx = 0;
   for (size_t i = 0; i < s->active_clients.length; i++) {
-    handle_t h = ptr_to_handle(s->active_clients.items[i]);
-    client_hot_t* hot = server_chot(s, h);
-    if (!hot)
-      continue;
-    if (hot->state == STATE_UNMANAGING || hot->state == STATE_DESTROYED)
+    handle_t h = s->active_clients.items[i];
+    uint8_t state;
+    uint8_t on;
+    xcb_window_t xid;
+    if (soa) {
+      if (!slotmap_live(&s->clients, h))
+        continue;
+      uint32_t slot = handle_index(h);
+      assert(wm_cols_agree(s, &cols, slot));
+      state = cols.state[slot];
+      on = cols.screen[slot];
+      xid = cols.xid[slot];
+    }
+    else {
+      client_hot_t* hot = server_chot(s, h);
+      if (!hot)
+        continue;
+      state = hot->state;
+      on = hot->screen;
+      xid = hot->xid;
+    }
+    if (state == STATE_UNMANAGING || state == STATE_DESTROYED || on != screen)
       continue;
     if (idx >= cap)
       return idx;
+    out[idx++] = xid;
+  }
+  return idx;
+}
+
 #ifndef NDEBUG
-    for (uint32_t j = 0; j < idx; j++) {
-      assert(out[j] != hot->xid);
+static int wm_window_cmp(const void* a, const void* b) {
+  xcb_window_t wa = *(const xcb_window_t*)a;
+  xcb_window_t wb = *(const xcb_window_t*)b;
+  return (wa > wb) - (wa < wb);
+}
+
+// A window appearing twice means a stack/manage list invariant broke
+static void wm_assert_unique_windows(server_t* s, const xcb_window_t* wins, uint32_t n) {
+  if (n < 2)
+    return;
+  xcb_window_t* sorted = (xcb_window_t*)arena_alloc(&s->tick_arena, (size_t)n * sizeof(*sorted));
+  memcpy(sorted, wins, (size_t)n * sizeof(*sorted));
+  qsort(sorted, n, sizeof(*sorted), wm_window_cmp);
+  for (uint32_t i = 1; i < n; i++)
+    assert(sorted[i - 1] != sorted[i]);
+}
+#endif
+
+bool wm_publish_root_prop(server_t* s, screen_t* scr, root_prop_t id, xcb_atom_t prop, xcb_atom_t type, uint8_t format, uint32_t n, const void* data) {
+  published_prop_t* pub = &scr->published[id];
+  uint32_t len = n * (format / 8u);
+  if (pub->valid && pub->type == type && pub->format == format && pub->len == len && (len == 0 || memcmp(pub->data, data, len) == 0)) {
+    s->root_props_skipped++;
+    return false;
+  }
+
+  xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, scr->root, prop, type, format, n, data);
+  s->root_props_written++;
+
+  if (len > pub->cap) {
+    uint8_t* grown = realloc(pub->data, len);
+    if (!grown) {
+      // Without a shadow the next call writes again
+      pub->valid = false;
+      return true;
+    }
+    pub->data = grown;
+    pub->cap = len;
+  }
+  if (len)
+    memcpy(pub->data, data, len);
+  pub->len = len;
+  pub->type = type;
+  pub->format = format;
+  pub->valid = true;
+  return true;
+}
+
+void wm_published_props_destroy(server_t* s) {
+  for (uint32_t n = 0; n < HXM_MAX_SCREENS; n++) {
+    screen_t* scr = &s->screens[n];
+    for (int i = 0; i < ROOT_PROP_COUNT; i++) {
+      free(scr->published[i].data);
+      scr->published[i] = (published_prop_t){0};
     }
+  }
+}
+
+static bool wm_publish_window_list(server_t* s, screen_t* scr, root_prop_t id, xcb_atom_t prop, const xcb_window_t* wins, uint32_t n) {
+#ifndef NDEBUG
+  wm_assert_unique_windows(s, wins, n);
 #endif
-    out[idx++] = hot->xid;
+  return wm_publish_root_prop(s, scr, id, prop, XCB_ATOM_WINDOW, 32, n, wins);
+}
+
+/*
+ * Interactive move/resize commits at most once per refresh of the monitor
+ * under the pointer (else under the window), capped by interactive_max_hz.
+ * Monitors whose mode rate is unknown pace at 60 Hz.
+ */
+uint64_t wm_interaction_interval_ns(server_t* s, const client_hot_t* hot) {
+  int px, py;
+  if (s->pointer_root_valid) {
+    px = s->pointer_root_x;
+    py = s->pointer_root_y;
   }
-  return idx;
+  else {
+    px = hot->desired.x + (int)hot->desired.w / 2;
+    py = hot->desired.y + (int)hot->desired.h / 2;
+  }
+
+  const screen_t* scr = client_screen(s, hot);
+  int idx = wm_monitor_at_point(scr, px, py);
+  uint32_t monitor_mhz = (idx >= 0) ? scr->monitors[idx].refresh_mhz : 0;
+  uint32_t mhz = monitor_mhz ? monitor_mhz : INTERACTION_DEFAULT_MHZ;
+  uint32_t cap_mhz = s->config.interactive_max_hz * 1000u;
+  if (cap_mhz && mhz > cap_mhz)
+    mhz = cap_mhz;
+
+  tick_stats_record_pacing(mhz, monitor_mhz);
+  return 1000000000000ull / mhz;
 }
 
 /*
- * wm_flush_dirty:
- * Commit all pending state changes to the X server.
- *
- * Phases:
- * 1. Visibility: Map/Unmap windows based on desktop state.
- * 2. Workarea Pre-Publish: Update _NET_WORKAREA before geometry pass.
- * 3. Per-Client Updates: Flush geometry, title, hints, and stacking.
- * 4. Focus Commit: Apply deferred focus changes (SetInputFocus).
- * 5. Root Properties: Update _NET_CLIENT_LIST, ACTIVE_WINDOW, etc.
- *
- * Returns true if any X requests were issued (triggering a flush).
+ * Commit one queued client's dirty state to the server.
+ * Returns true if any X requests were issued.
  */
-bool wm_flush_dirty(server_t* s, uint64_t now) {
+static bool wm_flush_client(server_t* s, handle_t h, client_hot_t* hot, client_cold_t* cold, uint64_t now) {
   bool flushed = false;
-  s->in_commit_phase = true;
+  bool geom_mismatch = wm_client_geom_mismatch(hot, cold);
 
-  // 0. Handle new clients ready to be managed
-  for (size_t i = 0; i < s->active_clients.length;) {
-    void* ptr = s->active_clients.items[i];
-    handle_t h = ptr_to_handle(ptr);
-    client_hot_t* hot = server_chot(s, h);
-    if (hot && hot->state == STATE_READY) {
-      client_finish_manage(s, h);
-      flushed = true;
-    }
+  if (hot->dirty == DIRTY_NONE && dirty_rects_empty(&cold->frame_damage) && !geom_mismatch) {
+    return flushed;
+  }
 
-    // Safe advance: only increment if the element at 'i' hasn't changed (wasn't
-    // swapped out)
-    if (i < s->active_clients.length && s->active_clients.items[i] == ptr) {
-      i++;
-    }
+#if HXM_DIAG
+  bool dirty_changed = (hot->dirty != hot->last_log_dirty);
+  bool dirty_interesting = (hot->dirty & (DIRTY_GEOM | DIRTY_STACK | DIRTY_STATE)) || geom_mismatch;
+  if (dirty_changed || dirty_interesting) {
+    TRACE_LOG("flush_dirty h=%lx xid=%u dirty=0x%x state=%d", h, hot->xid, hot->dirty, hot->state);
+    hot->last_log_dirty = hot->dirty;
   }
+#endif
 
-  // Preview window for snap-to-edge
-  {
-    client_hot_t* preview_hot = NULL;
-    if (s->interaction_mode == INTERACTION_MOVE) {
-      preview_hot = server_chot(s, s->interaction_handle);
-    }
+  // READY clients are only here while manage_defer_ms holds them unframed
+  if (hot->state == STATE_UNMANAGING || hot->state == STATE_DESTROYED || hot->state == STATE_NEW || hot->state == STATE_READY) {
+    return flushed;
+  }
 
-    bool should_show = (preview_hot && preview_hot->snap_preview_active);
-    bool was_mapped = s->snap_preview_mapped;
-    rect_t preview_rect = {0};
-    if (should_show)
-      preview_rect = preview_hot->snap_preview_frame_rect;
-    snap_preview_apply(s, should_show ? &preview_rect : NULL, should_show);
+  if ((hot->dirty & DIRTY_GEOM) || geom_mismatch) {
+    bool interactive = ((s->interaction_mode == INTERACTION_RESIZE || s->interaction_mode == INTERACTION_MOVE) && s->interaction_window == hot->frame);
 
-    if (should_show || was_mapped != s->snap_preview_mapped)
-      flushed = true;
-  }
+    bool interactive_resize = (s->interaction_mode == INTERACTION_RESIZE && s->interaction_window == hot->frame);
 
-  // 1. Visibility (Map/Unmap) - Must happen before focus
-  if (s->root_dirty & ROOT_DIRTY_VISIBILITY) {
-    flushed = true;
-    for (size_t i = 0; i < s->active_clients.length;) {
-      void* ptr = s->active_clients.items[i];
-      handle_t h = ptr_to_handle(ptr);
-      client_hot_t* c = server_chot(s, h);
-      if (!c) {
-        if (i < s->active_clients.length && s->active_clients.items[i] == ptr)
-          i++;
-        continue;
-      }
+    // Outline drags leave the client alone until release
+    if (interactive && s->interaction_outline)
+      return flushed;
 
-      if (c->state != STATE_MAPPED) {
-        if (i < s->active_clients.length && s->active_clients.items[i] == ptr)
-          i++;
-        continue;
+    if (interactive) {
+      uint64_t interval = wm_interaction_interval_ns(s, hot);
+      if (s->last_interaction_flush > 0 && (now - s->last_interaction_flush) < interval) {
+        server_schedule_timer_ns(s, interval - (now - s->last_interaction_flush));
+        return flushed;
       }
 
-      bool visible = c->sticky || (c->desktop == (int32_t)s->current_desktop);
-      if (visible) {
-        // Ensure mapped
-        // We don't track "actually mapped" bit perfectly besides state=MAPPED.
-        // But since we use deferred visibility for workspace switch, we assume
-        // if it's MAPPED state, it SHOULD be mapped if visible.
-        // Ideally we'd check if it's already mapped to avoid redundant
-        // requests, but XCB map on mapped window is no-op. However, we want to
-        // update WM_STATE property too.
-
-        // Optimization: track visibility in client or just blindly apply?
-        // Blindly applying is safer for "commit" style.
-        xcb_map_window(s->conn, c->frame);
-        uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_NORMAL, XCB_NONE};
-        xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, c->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
-      }
-      else {
-        if (c->ignore_unmap < UINT8_MAX)
-          c->ignore_unmap++;
-        xcb_unmap_window(s->conn, c->frame);
-        uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_ICONIC, XCB_NONE};
-        xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, c->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
-      }
+      // The client has not drawn the previous size yet; the newest desired
+      // size stays queued and is sent once it has (or the wait times out)
+      if (interactive_resize && cold->sync_wait_value != 0) {
+        uint64_t waited = now - cold->sync_wait_start;
+        if (waited < SYNC_ALARM_TIMEOUT_NS) {
+          server_schedule_timer_ns(s, SYNC_ALARM_TIMEOUT_NS - waited);
+          return flushed;
+        }
+        TRACE_LOG("sync alarm timeout xid=%u waiting for %llu", hot->xid, (unsigned long long)cold->sync_wait_value);
+        cold->sync_wait_value = 0;
 
-      if (i < s->active_clients.length && s->active_clients.items[i] == ptr) {
-        i++;
+        // A client this far behind re-lays out for nothing; finish as an outline
+        if (s->config.interactive_outline == OUTLINE_AUTO && !(hot->flags & CLIENT_FLAG_LIVE_DRAG)) {
+          s->interaction_outline = true;
+          return flushed;
+        }
       }
+      s->last_interaction_flush = now;
     }
-    s->root_dirty &= ~ROOT_DIRTY_VISIBILITY;
-  }
 
-  // 2. Pass through ConfigureRequest for unmanaged windows.
-  if (wm_flush_unmanaged_configure_requests(s))
-    flushed = true;
+    // A hung client would never bump the counter
+    if (interactive_resize && cold->sync_enabled && cold->sync_counter != XCB_NONE && !cold->ping_hung) {
+      uint64_t sync_value = ++cold->sync_value;
+      wm_send_sync_request(s, hot, sync_value, s->interaction_time);
 
-  // 3. Ack coalesced Damage events once per tick.
-  if (s->buckets.damage_region_keys.length > 0) {
-    for (size_t i = 0; i < s->buckets.damage_region_keys.length; i++) {
-      uint64_t* key_ptr = (uint64_t*)s->buckets.damage_region_keys.items[i];
-      if (!key_ptr)
-        continue;
-      xcb_window_t win = (xcb_window_t)(*key_ptr);
-      handle_t h = server_get_client_by_window(s, win);
-      if (h == HANDLE_INVALID)
-        continue;
-      client_hot_t* hot = server_chot(s, h);
-      client_cold_t* cold = server_ccold(s, h);
-      if (!hot || !cold || cold->damage == XCB_NONE)
-        continue;
-      xcb_damage_subtract(s->conn, cold->damage, XCB_NONE, XCB_NONE);
-      flushed = true;
+      // A pure move does not make the client redraw, so there is nothing to wait for
+      bool resizing = hot->desired.w != hot->server.w || hot->desired.h != hot->server.h;
+      if (resizing && wm_sync_alarm_arm(s, cold, sync_value)) {
+        cold->sync_wait_value = sync_value;
+        cold->sync_wait_start = now;
+      }
     }
-  }
-  else {
-    for (size_t i = 0; i < s->buckets.damage_regions.capacity; i++) {
-      hash_map_entry_t* entry = &s->buckets.damage_regions.entries[i];
-      if (!entry->key || !entry->value)
-        continue;
-      xcb_window_t win = (xcb_window_t)entry->key;
-      handle_t h = server_get_client_by_window(s, win);
-      if (h == HANDLE_INVALID)
-        continue;
-      client_hot_t* hot = server_chot(s, h);
-      client_cold_t* cold = server_ccold(s, h);
-      if (!hot || !cold || cold->damage == XCB_NONE)
-        continue;
-      xcb_damage_subtract(s->conn, cold->damage, XCB_NONE, XCB_NONE);
-      flushed = true;
+
+    uint16_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
+    uint16_t th = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.title_height;
+    uint16_t max_client_w = MAX_FRAME_SIZE;
+    uint16_t max_client_h = MAX_FRAME_SIZE;
+    wm_compute_max_client_size(bw, th, cold->gtk_frame_extents_set, &max_client_w, &max_client_h);
+
+    // Defer configuration until management is complete
+    if (hot->state == STATE_NEW) {
+      goto end_dirty_geom;
     }
-  }
 
-  // 4. Commit RandR-driven desktop geometry updates.
-  if (s->buckets.randr_dirty) {
-    flushed = true;
-    TRACE_LOG("flush_dirty randr width=%u height=%u", s->buckets.randr_width, s->buckets.randr_height);
-    wm_update_monitors(s);
-    uint32_t geometry[] = {s->buckets.randr_width, s->buckets.randr_height};
-    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_DESKTOP_GEOMETRY, XCB_ATOM_CARDINAL, 32, 2, geometry);
-    s->buckets.randr_dirty = false;
-  }
+    bool is_panel = (hot->type == WINDOW_TYPE_DOCK || hot->type == WINDOW_TYPE_DESKTOP);
 
-  // Workarea first so maximized/fullscreen clients marked DIRTY_GEOM during
-  // publish can be flushed in this same tick.
-  if (s->root_dirty & ROOT_DIRTY_WORKAREA) {
-    flushed = true;
-    rect_t wa;
-    wm_compute_workarea(s, &wa);
-#if HXM_TRACE_LOGS
-    static rl_t rl_wa = {0};
-    if (rl_allow(&rl_wa, now, 1000000000)) {
-      TRACE_LOG("publish_workarea x=%d y=%d w=%u h=%u", wa.x, wa.y, wa.w, wa.h);
+    // Safety: Do not configure if we have no geometry yet (except panels).
+    if (hot->desired.w == 0 || hot->desired.h == 0) {
+      if (is_panel) {
+        if (hot->desired.w == 0)
+          hot->desired.w = 1;
+        if (hot->desired.h == 0)
+          hot->desired.h = 1;
+      }
+      else {
+        hot->dirty &= ~DIRTY_GEOM;  // Clear dirty flag to prevent spin
+        goto end_dirty_geom;
+      }
     }
-#endif
-    wm_publish_workarea(s, &wa);
-    s->root_dirty &= ~ROOT_DIRTY_WORKAREA;
-  }
 
-  for (size_t i = 0; i < s->active_clients.length;) {
-    void* ptr = s->active_clients.items[i];
-    handle_t h = ptr_to_handle(ptr);
-    client_hot_t* hot = server_chot(s, h);
-    if (!hot) {
-      if (i < s->active_clients.length && s->active_clients.items[i] == ptr)
-        i++;
-      continue;
+    if (is_panel) {
+      rect_t bounds = wm_monitor_bounds_for_rect(s, client_screen(s, hot), &hot->desired);
+      wm_clamp_rect_to_bounds(&hot->desired, &bounds);
+      if (hot->desired.w > max_client_w)
+        hot->desired.w = max_client_w;
+      if (hot->desired.h > max_client_h)
+        hot->desired.h = max_client_h;
     }
-    client_cold_t* cold = server_ccold(s, h);
-    if (!cold) {
-      if (i < s->active_clients.length && s->active_clients.items[i] == ptr)
-        i++;
-      continue;
+    else {
+      uint16_t min_client_w = (max_client_w < MIN_FRAME_SIZE) ? max_client_w : (uint16_t)MIN_FRAME_SIZE;
+      uint16_t min_client_h = (max_client_h < MIN_FRAME_SIZE) ? max_client_h : (uint16_t)MIN_FRAME_SIZE;
+
+      // Robust clamping: Ensure frame is at least large enough for
+      // decorations/buttons and client is never <= 0.
+      if (hot->desired.w < min_client_w)
+        hot->desired.w = min_client_w;
+      if (hot->desired.w > max_client_w)
+        hot->desired.w = max_client_w;
+      if (hot->desired.h < min_client_h)
+        hot->desired.h = min_client_h;
+      if (hot->desired.h > max_client_h)
+        hot->desired.h = max_client_h;
+
+      // Apply size hints (increments, aspect ratio, min/max) to ensure we
+      // send a valid geometry that the client won't immediately reject.
+      client_constrain_size(&cold->hints, cold->hints_flags, &hot->desired.w, &hot->desired.h);
+      if (hot->desired.w > max_client_w)
+        hot->desired.w = max_client_w;
+      if (hot->desired.h > max_client_h)
+        hot->desired.h = max_client_h;
+      if (hot->desired.w < min_client_w)
+        hot->desired.w = min_client_w;
+      if (hot->desired.h < min_client_h)
+        hot->desired.h = min_client_h;
     }
-    bool geom_mismatch = wm_client_geom_mismatch(hot, cold);
 
-    if (hot->dirty == DIRTY_NONE && !cold->frame_damage.valid && !geom_mismatch) {
-      if (i < s->active_clients.length && s->active_clients.items[i] == ptr)
-        i++;
-      continue;
-    }
+    int32_t frame_x = hot->desired.x;
+    int32_t frame_y = hot->desired.y;
+    uint32_t frame_w = hot->desired.w;
+    uint32_t frame_h = hot->desired.h;
 
-#if HXM_DIAG
-    bool dirty_changed = (hot->dirty != hot->last_log_dirty);
-    bool dirty_interesting = (hot->dirty & (DIRTY_GEOM | DIRTY_STACK | DIRTY_STATE)) || geom_mismatch;
-    if (dirty_changed || dirty_interesting) {
-      TRACE_LOG("flush_dirty h=%lx xid=%u dirty=0x%x state=%d", h, hot->xid, hot->dirty, hot->state);
-      hot->last_log_dirty = hot->dirty;
-    }
-#endif
+    int32_t client_w_calc = (int32_t)hot->desired.w;
+    int32_t client_h_calc = (int32_t)hot->desired.h;
 
-    if (hot->state == STATE_UNMANAGING || hot->state == STATE_DESTROYED || hot->state == STATE_NEW) {
-      if (i < s->active_clients.length && s->active_clients.items[i] == ptr)
-        i++;
-      continue;
+    if (cold->gtk_frame_extents_set) {
+      frame_x -= (int32_t)cold->gtk_extents.left;
+      frame_y -= (int32_t)cold->gtk_extents.top;
+
+      client_w_calc = frame_w;
+      client_h_calc = frame_h;
+    }
+    else {
+      uint16_t bottom_h = bw;
+      frame_w += (uint32_t)(2u * bw);
+      frame_h += (uint32_t)th + (uint32_t)bottom_h;
+      // client_w/h remain equal to desired (content size)
     }
 
-    if ((hot->dirty & DIRTY_GEOM) || geom_mismatch) {
-      bool interactive = ((s->interaction_mode == INTERACTION_RESIZE || s->interaction_mode == INTERACTION_MOVE) && s->interaction_window == hot->frame);
-
-      if (interactive) {
-        uint64_t interval = 16666666;  // ~16ms for 60Hz
-        if (s->last_interaction_flush > 0 && (now - s->last_interaction_flush) < interval) {
-          uint64_t remaining = interval - (now - s->last_interaction_flush);
-          int ms = (int)(remaining / 1000000) + 1;
-          server_schedule_timer(s, ms);
-          if (i < s->active_clients.length && s->active_clients.items[i] == ptr)
-            i++;
-          continue;
+    // Final clamp for client dimensions
+    if (client_w_calc < 1)
+      client_w_calc = 1;
+    if (client_h_calc < 1)
+      client_h_calc = 1;
+    if (client_w_calc > MAX_FRAME_SIZE)
+      client_w_calc = MAX_FRAME_SIZE;
+    if (client_h_calc > MAX_FRAME_SIZE)
+      client_h_calc = MAX_FRAME_SIZE;
+    if (frame_w > MAX_FRAME_SIZE)
+      frame_w = MAX_FRAME_SIZE;
+    if (frame_h > MAX_FRAME_SIZE)
+      frame_h = MAX_FRAME_SIZE;
+
+    uint32_t client_w = (uint32_t)client_w_calc;
+    uint32_t client_h = (uint32_t)client_h_calc;
+
+    TRACE_LOG("apply_geom: frame(%dx%d+%d+%d) extents_set=%d -> client(%dx%d)", frame_w, frame_h, frame_x, frame_y, cold->gtk_frame_extents_set, client_w, client_h);
+
+    uint32_t old_frame_w = hot->server.w;
+    uint32_t old_frame_h = hot->server.h;
+    if (!cold->gtk_frame_extents_set) {
+      uint16_t old_bottom_h = bw;
+      old_frame_w += (uint32_t)(2u * bw);
+      old_frame_h += (uint32_t)th + (uint32_t)old_bottom_h;
+    }
+    bool frame_size_changed = (old_frame_w != frame_w || old_frame_h != frame_h);
+    bool geom_changed = true;
+
+    if (geom_changed) {
+      if (!interactive_resize && cold->sync_enabled && cold->sync_counter != XCB_NONE) {
+        if (hot->server.w != (uint16_t)client_w || hot->server.h != (uint16_t)client_h) {
+          uint64_t sync_value = ++cold->sync_value;
+          wm_send_sync_request(s, hot, sync_value, XCB_CURRENT_TIME);
         }
-        s->last_interaction_flush = now;
       }
 
-      bool interactive_resize = (s->interaction_mode == INTERACTION_RESIZE && s->interaction_window == hot->frame);
-      if (interactive_resize && cold->sync_enabled && cold->sync_counter != XCB_NONE) {
-        uint64_t sync_value = ++cold->sync_value;
-        wm_send_sync_request(s, hot, sync_value, s->interaction_time);
-      }
-
-      uint16_t bw = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.border_width;
-      uint16_t th = (hot->flags & CLIENT_FLAG_UNDECORATED) ? 0 : s->config.theme.title_height;
-      uint16_t max_client_w = MAX_FRAME_SIZE;
-      uint16_t max_client_h = MAX_FRAME_SIZE;
-      wm_compute_max_client_size(bw, th, cold->gtk_frame_extents_set, &max_client_w, &max_client_h);
+      uint32_t client_values[4];
+      int32_t local_x = bw;
+      int32_t local_y = th;
 
-      // Defer configuration until management is complete
-      if (hot->state == STATE_NEW) {
-        goto end_dirty_geom;
+      if (cold->gtk_frame_extents_set) {
+        local_x = 0;
+        local_y = 0;
       }
 
-      bool is_panel = (hot->type == WINDOW_TYPE_DOCK || hot->type == WINDOW_TYPE_DESKTOP);
-
-      // Safety: Do not configure if we have no geometry yet (except panels).
-      if (hot->desired.w == 0 || hot->desired.h == 0) {
-        if (is_panel) {
-          if (hot->desired.w == 0)
-            hot->desired.w = 1;
-          if (hot->desired.h == 0)
-            hot->desired.h = 1;
-        }
-        else {
-          hot->dirty &= ~DIRTY_GEOM;  // Clear dirty flag to prevent spin
-          goto end_dirty_geom;
-        }
+      client_values[0] = (uint32_t)local_x;
+      client_values[1] = (uint32_t)local_y;
+      client_values[2] = client_w;
+      client_values[3] = client_h;
+
+      uint32_t frame_values[4];
+      frame_values[0] = (uint32_t)frame_x;
+      frame_values[1] = (uint32_t)frame_y;
+      frame_values[2] = frame_w;
+      frame_values[3] = frame_h;
+
+      /*
+       * Keep client/frame geometry coherent during live resize: update the
+       * child first, then resize/move the reparent frame.
+       */
+      /*
+       * Always configure the client when committing geometry. The
+       * geometry-from-notify fast path can transiently leave frame and client
+       * out of sync with some toolkits/compositors during live resize.
+       */
+      bool should_configure_client = true;
+      if (should_configure_client) {
+        xcb_configure_window(s->conn, hot->xid, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, client_values);
       }
 
-      if (is_panel) {
-        rect_t bounds = wm_monitor_bounds_for_rect(s, &hot->desired);
-        wm_clamp_rect_to_bounds(&hot->desired, &bounds);
-        if (hot->desired.w > max_client_w)
-          hot->desired.w = max_client_w;
-        if (hot->desired.h > max_client_h)
-          hot->desired.h = max_client_h;
+      // Update cached committed geometry; the synthetic ConfigureNotify is
+      // built from it at the end of the flush.
+      hot->server.x = (int16_t)frame_x;
+      hot->server.y = (int16_t)frame_y;
+      hot->server.w = (uint16_t)client_w;
+      hot->server.h = (uint16_t)client_h;
+      wm_client_update_monitor(s, hot);
+
+      xcb_configure_window(s->conn, hot->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, frame_values);
+      spatial_index_update(&client_screen(s, hot)->frame_index, h, (rect_t){(int16_t)frame_x, (int16_t)frame_y, (uint16_t)frame_w, (uint16_t)frame_h});
+
+      // Set _NET_FRAME_EXTENTS
+      uint16_t bottom_h = bw;
+      uint32_t extents[4] = {bw, bw, th, bottom_h};
+      if ((hot->flags & CLIENT_FLAG_UNDECORATED) || cold->gtk_frame_extents_set) {
+        extents[0] = 0;
+        extents[1] = 0;
+        extents[2] = 0;
+        extents[3] = 0;
       }
-      else {
-        uint16_t min_client_w = (max_client_w < MIN_FRAME_SIZE) ? max_client_w : (uint16_t)MIN_FRAME_SIZE;
-        uint16_t min_client_h = (max_client_h < MIN_FRAME_SIZE) ? max_client_h : (uint16_t)MIN_FRAME_SIZE;
-
-        // Robust clamping: Ensure frame is at least large enough for
-        // decorations/buttons and client is never <= 0.
-        if (hot->desired.w < min_client_w)
-          hot->desired.w = min_client_w;
-        if (hot->desired.w > max_client_w)
-          hot->desired.w = max_client_w;
-        if (hot->desired.h < min_client_h)
-          hot->desired.h = min_client_h;
-        if (hot->desired.h > max_client_h)
-          hot->desired.h = max_client_h;
-
-        // Apply size hints (increments, aspect ratio, min/max) to ensure we
-        // send a valid geometry that the client won't immediately reject.
-        client_constrain_size(&cold->hints, cold->hints_flags, &hot->desired.w, &hot->desired.h);
-        if (hot->desired.w > max_client_w)
-          hot->desired.w = max_client_w;
-        if (hot->desired.h > max_client_h)
-          hot->desired.h = max_client_h;
-        if (hot->desired.w < min_client_w)
-          hot->desired.w = min_client_w;
-        if (hot->desired.h < min_client_h)
-          hot->desired.h = min_client_h;
+      xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 32, 4, extents);
+
+      // Position-only moves do not require repainting decorations.
+      if (frame_size_changed) {
+        frame_redraw(s, h, FRAME_REDRAW_ALL);
       }
 
-      int32_t frame_x = hot->desired.x;
-      int32_t frame_y = hot->desired.y;
-      uint32_t frame_w = hot->desired.w;
-      uint32_t frame_h = hot->desired.h;
+      LOG_DEBUG(
+          "Flushed DIRTY_GEOM for %lx: Frame Global(%d,%d) Client "
+          "Local(%d,%d) %dx%d",
+          h, frame_x, frame_y, local_x, local_y, client_w, client_h);
+      flushed = true;
+    }
+    else {
+      TRACE_LOG("Skipping DIRTY_GEOM for %lx (unchanged)", h);
+    }
 
-      int32_t client_w_calc = (int32_t)hot->desired.w;
-      int32_t client_h_calc = (int32_t)hot->desired.h;
+    // Sent by wm_flush_synthetic_configures once every client is committed
+    if (hot->dirty & DIRTY_SYNTHETIC_CONFIGURE)
+      s->synthetic_suppressed++;
+    hot->dirty |= DIRTY_SYNTHETIC_CONFIGURE;
 
-      if (cold->gtk_frame_extents_set) {
-        frame_x -= (int32_t)cold->gtk_extents.left;
-        frame_y -= (int32_t)cold->gtk_extents.top;
+    hot->pending = hot->desired;
+    hot->pending_epoch++;
 
-        client_w_calc = frame_w;
-        client_h_calc = frame_h;
-      }
-      else {
-        uint16_t bottom_h = bw;
-        frame_w += (uint32_t)(2u * bw);
-        frame_h += (uint32_t)th + (uint32_t)bottom_h;
-        // client_w/h remain equal to desired (content size)
-      }
+    hot->dirty &= ~DIRTY_GEOM;
+  }
+end_dirty_geom:
 
-      // Final clamp for client dimensions
-      if (client_w_calc < 1)
-        client_w_calc = 1;
-      if (client_h_calc < 1)
-        client_h_calc = 1;
-      if (client_w_calc > MAX_FRAME_SIZE)
-        client_w_calc = MAX_FRAME_SIZE;
-      if (client_h_calc > MAX_FRAME_SIZE)
-        client_h_calc = MAX_FRAME_SIZE;
-      if (frame_w > MAX_FRAME_SIZE)
-        frame_w = MAX_FRAME_SIZE;
-      if (frame_h > MAX_FRAME_SIZE)
-        frame_h = MAX_FRAME_SIZE;
-
-      uint32_t client_w = (uint32_t)client_w_calc;
-      uint32_t client_h = (uint32_t)client_h_calc;
-
-      TRACE_LOG("apply_geom: frame(%dx%d+%d+%d) extents_set=%d -> client(%dx%d)", frame_w, frame_h, frame_x, frame_y, cold->gtk_frame_extents_set, client_w, client_h);
-
-      uint32_t old_frame_w = hot->server.w;
-      uint32_t old_frame_h = hot->server.h;
-      if (!cold->gtk_frame_extents_set) {
-        uint16_t old_bottom_h = bw;
-        old_frame_w += (uint32_t)(2u * bw);
-        old_frame_h += (uint32_t)th + (uint32_t)old_bottom_h;
-      }
-      bool frame_size_changed = (old_frame_w != frame_w || old_frame_h != frame_h);
-      bool geom_changed = true;
-
-      bool synthetic_attempted = false;
-      if (geom_changed) {
-        if (!interactive_resize && cold->sync_enabled && cold->sync_counter != XCB_NONE) {
-          if (hot->server.w != (uint16_t)client_w || hot->server.h != (uint16_t)client_h) {
-            uint64_t sync_value = ++cold->sync_value;
-            wm_send_sync_request(s, hot, sync_value, XCB_CURRENT_TIME);
-          }
-        }
+  if (hot->dirty & DIRTY_TITLE) {
+    flushed = true;
+    uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_NAME, atoms.UTF8_STRING, 0, 1024).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_NAME);
 
-        uint32_t client_values[4];
-        int32_t local_x = bw;
-        int32_t local_y = th;
+    c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_NAME, XCB_ATOM_STRING, 0, 1024).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms.WM_NAME);
 
-        if (cold->gtk_frame_extents_set) {
-          local_x = 0;
-          local_y = 0;
-        }
+    hot->dirty &= ~DIRTY_TITLE;
+  }
 
-        client_values[0] = (uint32_t)local_x;
-        client_values[1] = (uint32_t)local_y;
-        client_values[2] = client_w;
-        client_values[3] = client_h;
-
-        uint32_t frame_values[4];
-        frame_values[0] = (uint32_t)frame_x;
-        frame_values[1] = (uint32_t)frame_y;
-        frame_values[2] = frame_w;
-        frame_values[3] = frame_h;
-
-        /*
-         * Keep client/frame geometry coherent during live resize: update the
-         * child first, then resize/move the reparent frame.
-         */
-        /*
-         * Always configure the client when committing geometry. The
-         * geometry-from-notify fast path can transiently leave frame and client
-         * out of sync with some toolkits/compositors during live resize.
-         */
-        bool should_configure_client = true;
-        if (should_configure_client) {
-          xcb_configure_window(s->conn, hot->xid, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, client_values);
-        }
+  if (hot->dirty & DIRTY_HINTS) {
+    flushed = true;
+    uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 0, 32).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms.WM_NORMAL_HINTS);
 
-        // Update cached committed geometry before synthetic ConfigureNotify.
-        hot->server.x = (int16_t)frame_x;
-        hot->server.y = (int16_t)frame_y;
-        hot->server.w = (uint16_t)client_w;
-        hot->server.h = (uint16_t)client_h;
-
-        synthetic_attempted = true;
-        if (wm_send_synthetic_configure(s, h))
-          flushed = true;
-
-        xcb_configure_window(s->conn, hot->frame, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, frame_values);
-
-        // Set _NET_FRAME_EXTENTS
-        uint16_t bottom_h = bw;
-        uint32_t extents[4] = {bw, bw, th, bottom_h};
-        if ((hot->flags & CLIENT_FLAG_UNDECORATED) || cold->gtk_frame_extents_set) {
-          extents[0] = 0;
-          extents[1] = 0;
-          extents[2] = 0;
-          extents[3] = 0;
-        }
-        xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 32, 4, extents);
+    c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_HINTS, atoms.WM_HINTS, 0, 32).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms.WM_HINTS);
 
-        // Position-only moves do not require repainting decorations.
-        if (frame_size_changed) {
-          frame_redraw(s, h, FRAME_REDRAW_ALL);
-        }
+    c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_COLORMAP_WINDOWS, XCB_ATOM_WINDOW, 0, 64).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms.WM_COLORMAP_WINDOWS);
 
-        LOG_DEBUG(
-            "Flushed DIRTY_GEOM for %lx: Frame Global(%d,%d) Client "
-            "Local(%d,%d) %dx%d",
-            h, frame_x, frame_y, local_x, local_y, client_w, client_h);
-        flushed = true;
-      }
-      else {
-        TRACE_LOG("Skipping DIRTY_GEOM for %lx (unchanged)", h);
-      }
+    c = xcb_get_property(s->conn, 0, hot->xid, atoms._MOTIF_WM_HINTS, XCB_ATOM_ANY, 0, 5).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._MOTIF_WM_HINTS);
 
-      if (!synthetic_attempted && wm_send_synthetic_configure(s, h))
-        flushed = true;
+    c = xcb_get_property(s->conn, 0, hot->xid, atoms._GTK_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 0, 4).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._GTK_FRAME_EXTENTS);
 
-      hot->pending = hot->desired;
-      hot->pending_epoch++;
+    c = xcb_get_property(s->conn, 0, hot->xid, atoms._KDE_NET_WM_FRAME_STRUT, XCB_ATOM_CARDINAL, 0, 4).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._KDE_NET_WM_FRAME_STRUT);
 
-      hot->dirty &= ~DIRTY_GEOM;
-    }
-  end_dirty_geom:
+    hot->dirty &= ~DIRTY_HINTS;
+  }
 
-    if (hot->dirty & DIRTY_TITLE) {
-      flushed = true;
-      uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_NAME, atoms.UTF8_STRING, 0, 1024).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_NAME);
+  if (hot->dirty & DIRTY_STRUT) {
+    flushed = true;
+    uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 0, 12).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_STRUT_PARTIAL);
 
-      c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_NAME, XCB_ATOM_STRING, 0, 1024).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms.WM_NAME);
+    c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_STRUT, XCB_ATOM_CARDINAL, 0, 4).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_STRUT);
 
-      hot->dirty &= ~DIRTY_TITLE;
-    }
+    hot->dirty &= ~DIRTY_STRUT;
+  }
 
-    if (hot->dirty & DIRTY_HINTS) {
-      flushed = true;
-      uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 0, 32).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms.WM_NORMAL_HINTS);
+  if (hot->dirty & DIRTY_OPACITY) {
+    flushed = true;
+    uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_WINDOW_OPACITY, XCB_ATOM_CARDINAL, 0, 1).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_WINDOW_OPACITY);
 
-      c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_HINTS, atoms.WM_HINTS, 0, 32).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms.WM_HINTS);
+    hot->dirty &= ~DIRTY_OPACITY;
+  }
 
-      c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_COLORMAP_WINDOWS, XCB_ATOM_WINDOW, 0, 64).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms.WM_COLORMAP_WINDOWS);
+  if (hot->dirty & DIRTY_BYPASS_COMPOSITOR) {
+    flushed = true;
+    uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 0, 1).sequence;
+    wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_BYPASS_COMPOSITOR);
 
-      c = xcb_get_property(s->conn, 0, hot->xid, atoms._MOTIF_WM_HINTS, XCB_ATOM_ANY, 0, 5).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._MOTIF_WM_HINTS);
+    hot->dirty &= ~DIRTY_BYPASS_COMPOSITOR;
+  }
 
-      c = xcb_get_property(s->conn, 0, hot->xid, atoms._GTK_FRAME_EXTENTS, XCB_ATOM_CARDINAL, 0, 4).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._GTK_FRAME_EXTENTS);
+  if (hot->dirty & DIRTY_DESKTOP) {
+    flushed = true;
+    uint32_t desktop = hot->sticky ? 0xFFFFFFFFu : (uint32_t)hot->desktop;
+    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &desktop);
+    hot->dirty &= ~DIRTY_DESKTOP;
+  }
 
-      c = xcb_get_property(s->conn, 0, hot->xid, atoms._KDE_NET_WM_FRAME_STRUT, XCB_ATOM_CARDINAL, 0, 4).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._KDE_NET_WM_FRAME_STRUT);
+  if (!dirty_rects_empty(&cold->frame_damage) || (hot->dirty & (DIRTY_FRAME_ALL | DIRTY_FRAME_TITLE | DIRTY_FRAME_BUTTONS | DIRTY_FRAME_BORDER | DIRTY_FRAME_STYLE | DIRTY_TITLE))) {
+    flushed = true;
+    // Painted by wm_flush_frames once every client has been committed
+    handle_vec_push(&s->frame_pass, h);
+  }
 
-      hot->dirty &= ~DIRTY_HINTS;
+  if (hot->dirty & DIRTY_STACK) {
+    flushed = true;
+    TRACE_LOG("flush_dirty stack h=%lx layer=%d stack_layer=%d", h, hot->layer, hot->stacking_layer);
+
+    // If the client is not in the correct layer in the list, move it.
+    // This happens if layer changed but stack_move_to_layer wasn't called
+    // (which we shouldn't rely on anymore for X sync). Actually, we modified
+    // stack_move_to_layer to NOT sync. But we need to call it if the list is
+    // wrong. The list is wrong if hot->layer != hot->stacking_layer
+    if (hot->layer != hot->stacking_layer) {
+      stack_move_to_layer(s, h);
     }
+    // DIRTY_STACK stays set: stack_commit_to_xcb clears it once the whole
+    // tick's restacks are diffed against the committed order
+  }
 
-    if (hot->dirty & DIRTY_STRUT) {
-      flushed = true;
-      uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 0, 12).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_STRUT_PARTIAL);
+  if (hot->dirty & DIRTY_STATE) {
+    flushed = true;
+    TRACE_LOG(
+        "flush_dirty state h=%lx layer=%d above=%d below=%d sticky=%d "
+        "max=%d/%d focused=%d",
+        h, hot->layer, hot->state_above, hot->state_below, hot->sticky, hot->maximized_horz, hot->maximized_vert, (hot->flags & CLIENT_FLAG_FOCUSED) != 0);
 
-      c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_STRUT, XCB_ATOM_CARDINAL, 0, 4).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_STRUT);
+    xcb_atom_t state_atoms[12];
+    uint32_t count = 0;
 
-      hot->dirty &= ~DIRTY_STRUT;
+    if (hot->layer == LAYER_FULLSCREEN) {
+      state_atoms[count++] = atoms._NET_WM_STATE_FULLSCREEN;
+    }
+    if (hot->state_above) {
+      state_atoms[count++] = atoms._NET_WM_STATE_ABOVE;
+    }
+    if (hot->state_below) {
+      state_atoms[count++] = atoms._NET_WM_STATE_BELOW;
     }
 
-    if (hot->dirty & DIRTY_OPACITY) {
-      flushed = true;
-      uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_WINDOW_OPACITY, XCB_ATOM_CARDINAL, 0, 1).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_WINDOW_OPACITY);
-
-      hot->dirty &= ~DIRTY_OPACITY;
+    if (hot->flags & CLIENT_FLAG_URGENT)
+      state_atoms[count++] = atoms._NET_WM_STATE_DEMANDS_ATTENTION;
+    if (hot->sticky)
+      state_atoms[count++] = atoms._NET_WM_STATE_STICKY;
+    if (hot->skip_taskbar)
+      state_atoms[count++] = atoms._NET_WM_STATE_SKIP_TASKBAR;
+    if (hot->skip_pager)
+      state_atoms[count++] = atoms._NET_WM_STATE_SKIP_PAGER;
+    if (hot->maximized_horz)
+      state_atoms[count++] = atoms._NET_WM_STATE_MAXIMIZED_HORZ;
+    if (hot->maximized_vert)
+      state_atoms[count++] = atoms._NET_WM_STATE_MAXIMIZED_VERT;
+    if (wm_client_is_hidden(s, hot))
+      state_atoms[count++] = atoms._NET_WM_STATE_HIDDEN;
+    if (hot->flags & CLIENT_FLAG_FOCUSED)
+      state_atoms[count++] = atoms._NET_WM_STATE_FOCUSED;
+
+    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_STATE, XCB_ATOM_ATOM, 32, count, state_atoms);
+
+    // Set _NET_WM_ALLOWED_ACTIONS
+    xcb_atom_t actions[16];
+    uint32_t num_actions = 0;
+    actions[num_actions++] = atoms._NET_WM_ACTION_MOVE;
+    actions[num_actions++] = atoms._NET_WM_ACTION_MINIMIZE;
+    actions[num_actions++] = atoms._NET_WM_ACTION_STICK;
+    actions[num_actions++] = atoms._NET_WM_ACTION_CHANGE_DESKTOP;
+    actions[num_actions++] = atoms._NET_WM_ACTION_CLOSE;
+    actions[num_actions++] = atoms._NET_WM_ACTION_ABOVE;
+    actions[num_actions++] = atoms._NET_WM_ACTION_BELOW;
+
+    if (!client_has_fixed_size(cold)) {
+      actions[num_actions++] = atoms._NET_WM_ACTION_RESIZE;
+      actions[num_actions++] = atoms._NET_WM_ACTION_MAXIMIZE_HORZ;
+      actions[num_actions++] = atoms._NET_WM_ACTION_MAXIMIZE_VERT;
+      actions[num_actions++] = atoms._NET_WM_ACTION_FULLSCREEN;
     }
 
-    if (hot->dirty & DIRTY_BYPASS_COMPOSITOR) {
-      flushed = true;
-      uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 0, 1).sequence;
-      wm_enqueue_property_cookie(s, h, c, ((uint64_t)hot->xid << 32) | atoms._NET_WM_BYPASS_COMPOSITOR);
+    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_ALLOWED_ACTIONS, XCB_ATOM_ATOM, 32, num_actions, actions);
 
-      hot->dirty &= ~DIRTY_BYPASS_COMPOSITOR;
-    }
+    hot->dirty &= ~DIRTY_STATE;
+  }
 
-    if (hot->dirty & DIRTY_DESKTOP) {
-      flushed = true;
-      uint32_t desktop = hot->sticky ? 0xFFFFFFFFu : (uint32_t)hot->desktop;
-      xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &desktop);
-      hot->dirty &= ~DIRTY_DESKTOP;
-    }
+  return flushed;
+}
 
-    if (cold->frame_damage.valid || (hot->dirty & (DIRTY_FRAME_ALL | DIRTY_FRAME_TITLE | DIRTY_FRAME_BUTTONS | DIRTY_FRAME_BORDER | DIRTY_FRAME_STYLE | DIRTY_TITLE))) {
-      flushed = true;
+/* Group paints by render target so consecutive frames reuse surface state */
+static uint64_t wm_frame_pass_key(server_t* s, handle_t h) {
+  const client_cold_t* cold = server_ccold(s, h);
+  if (!cold)
+    return 0;
+  return ((uint64_t)(uint8_t)cold->render_ctx.depth << 33) | ((uint64_t)cold->render_ctx.visual_id << 1) | (cold->frame_pixmap != XCB_NONE ? 1u : 0u);
+}
+
+/*
+ * Paint every frame queued by wm_flush_client in one pass. Running after
+ * geometry and restacking means a frame that was resized this tick is painted
+ * once at its final size, and all decoration requests go out back to back
+ * ahead of the tick's single xcb_flush.
+ */
+static void wm_flush_frames(server_t* s) {
+  handle_vec_t* pass = &s->frame_pass;
+
+  // Insertion sort: the pass is a handful of frames and mostly presorted
+  for (size_t i = 1; i < pass->length; i++) {
+    handle_t h = pass->items[i];
+    uint64_t key = wm_frame_pass_key(s, h);
+    size_t j = i;
+    while (j > 0 && wm_frame_pass_key(s, pass->items[j - 1]) > key) {
+      pass->items[j] = pass->items[j - 1];
+      j--;
     }
+    pass->items[j] = h;
+  }
 
-    frame_flush(s, h);
+  for (size_t i = 0; i < pass->length; i++) {
+    // Frames under a fast fullscreen client are painted when it leaves
+    if (wm_fullscreen_fast_covers(s, pass->items[i]))
+      wm_fullscreen_fast_hold_paint(s, pass->items[i]);
+    else
+      frame_flush(s, pass->items[i]);
+  }
+  TRACE_LOG("flush_frames painted=%zu", pass->length);
+  pass->length = 0;
+}
 
-    if (hot->dirty & DIRTY_STACK) {
-      flushed = true;
-      TRACE_LOG("flush_dirty stack h=%lx layer=%d stack_layer=%d", h, hot->layer, hot->stacking_layer);
-
-      // If the client is not in the correct layer in the list, move it.
-      // This happens if layer changed but stack_move_to_layer wasn't called
-      // (which we shouldn't rely on anymore for X sync). Actually, we modified
-      // stack_move_to_layer to NOT sync. But we need to call it if the list is
-      // wrong. The list is wrong if hot->layer != hot->stacking_layer
-      if (hot->layer != hot->stacking_layer) {
-        stack_move_to_layer(s, h);
-      }
+/*
+ * The one place synthetic ConfigureNotify goes out. Geometry commits only
+ * mark the client, so a client committed several times in a tick, or whose
+ * commit did not move it relative to the root, costs no event: toolkits such
+ * as Java and Wine relayout on every one they receive.
+ */
+static bool wm_flush_synthetic_configures(server_t* s, size_t processed) {
+  bool sent = false;
+  for (size_t i = 0; i < processed && i < s->dirty_clients.length; i++) {
+    handle_t h = s->dirty_clients.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    if (!hot || !(hot->dirty & DIRTY_SYNTHETIC_CONFIGURE))
+      continue;
+    hot->dirty &= ~DIRTY_SYNTHETIC_CONFIGURE;
+    if (wm_send_synthetic_configure(s, h))
+      sent = true;
+  }
+  return sent;
+}
 
-      stack_sync_to_xcb(s, h);
-      hot->dirty &= ~DIRTY_STACK;
-    }
+typedef struct vis_change {
+  handle_t h;
+  int8_t layer;
+  uint32_t label;
+  uint32_t order; /* collection order (manage order within a desktop), breaks ties */
+} vis_change_t;
+
+/* Top of the stack first */
+static int wm_vis_change_cmp(const void* a, const void* b) {
+  const vis_change_t* x = (const vis_change_t*)a;
+  const vis_change_t* y = (const vis_change_t*)b;
+  if (x->layer != y->layer)
+    return (x->layer > y->layer) ? -1 : 1;
+  if (x->label != y->label)
+    return (x->label > y->label) ? -1 : 1;
+  return (x->order < y->order) ? -1 : (x->order > y->order);
+}
 
-    if (hot->dirty & DIRTY_STATE) {
-      flushed = true;
-      TRACE_LOG(
-          "flush_dirty state h=%lx layer=%d above=%d below=%d sticky=%d "
-          "max=%d/%d focused=%d",
-          h, hot->layer, hot->state_above, hot->state_below, hot->sticky, hot->maximized_horz, hot->maximized_vert, (hot->flags & CLIENT_FLAG_FOCUSED) != 0);
+typedef struct vis_pass {
+  vis_change_t* show;
+  vis_change_t* hide;
+  size_t show_n;
+  size_t hide_n;
+  uint32_t order;
+  uint8_t screen;   /* s->screens index the pass is for */
+  uint32_t current; /* its current desktop */
+  bool soa;         /* cols valid */
+  client_cols_t cols;
+} vis_pass_t;
 
-      xcb_atom_t state_atoms[12];
-      uint32_t count = 0;
+/*
+ * With client columns a candidate costs a few bytes of state, desktop,
+ * sticky and frame_vis; client_hot_t is only read for frames that change.
+ */
+static void wm_vis_consider(server_t* s, vis_pass_t* pass, handle_t h) {
+  uint32_t order = pass->order++;
+  client_hot_t* c = NULL;
+  uint8_t state;
+  uint8_t sticky;
+  uint8_t frame_vis;
+  uint8_t screen;
+  int32_t desktop;
+  if (pass->soa) {
+    if (!slotmap_live(&s->clients, h))
+      return;
+    uint32_t slot = handle_index(h);
+    assert(wm_cols_agree(s, &pass->cols, slot));
+    state = pass->cols.state[slot];
+    sticky = pass->cols.sticky[slot];
+    desktop = pass->cols.desktop[slot];
+    frame_vis = pass->cols.frame_vis[slot];
+    screen = pass->cols.screen[slot];
+  }
+  else {
+    c = server_chot(s, h);
+    if (!c)
+      return;
+    state = c->state;
+    sticky = c->sticky;
+    desktop = c->desktop;
+    frame_vis = c->frame_vis;
+    screen = c->screen;
+  }
+  if (state != STATE_MAPPED || screen != pass->screen)
+    return;
 
-      if (hot->layer == LAYER_FULLSCREEN) {
-        state_atoms[count++] = atoms._NET_WM_STATE_FULLSCREEN;
-      }
-      if (hot->state_above) {
-        state_atoms[count++] = atoms._NET_WM_STATE_ABOVE;
-      }
-      if (hot->state_below) {
-        state_atoms[count++] = atoms._NET_WM_STATE_BELOW;
-      }
+  bool visible = sticky || (desktop == (int32_t)pass->current);
+  bool show = visible && frame_vis != FRAME_VIS_MAPPED;
+  bool hide = !visible && frame_vis != FRAME_VIS_HIDDEN;
+  if (!show && !hide)
+    return;
 
-      if (hot->flags & CLIENT_FLAG_URGENT)
-        state_atoms[count++] = atoms._NET_WM_STATE_DEMANDS_ATTENTION;
-      if (hot->sticky)
-        state_atoms[count++] = atoms._NET_WM_STATE_STICKY;
-      if (hot->skip_taskbar)
-        state_atoms[count++] = atoms._NET_WM_STATE_SKIP_TASKBAR;
-      if (hot->skip_pager)
-        state_atoms[count++] = atoms._NET_WM_STATE_SKIP_PAGER;
-      if (hot->maximized_horz)
-        state_atoms[count++] = atoms._NET_WM_STATE_MAXIMIZED_HORZ;
-      if (hot->maximized_vert)
-        state_atoms[count++] = atoms._NET_WM_STATE_MAXIMIZED_VERT;
-      if (wm_client_is_hidden(s, hot))
-        state_atoms[count++] = atoms._NET_WM_STATE_HIDDEN;
-      if (hot->flags & CLIENT_FLAG_FOCUSED)
-        state_atoms[count++] = atoms._NET_WM_STATE_FOCUSED;
-
-      xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_STATE, XCB_ATOM_ATOM, 32, count, state_atoms);
-
-      // Set _NET_WM_ALLOWED_ACTIONS
-      xcb_atom_t actions[16];
-      uint32_t num_actions = 0;
-      actions[num_actions++] = atoms._NET_WM_ACTION_MOVE;
-      actions[num_actions++] = atoms._NET_WM_ACTION_MINIMIZE;
-      actions[num_actions++] = atoms._NET_WM_ACTION_STICK;
-      actions[num_actions++] = atoms._NET_WM_ACTION_CHANGE_DESKTOP;
-      actions[num_actions++] = atoms._NET_WM_ACTION_CLOSE;
-      actions[num_actions++] = atoms._NET_WM_ACTION_ABOVE;
-      actions[num_actions++] = atoms._NET_WM_ACTION_BELOW;
-
-      if (!client_has_fixed_size(cold)) {
-        actions[num_actions++] = atoms._NET_WM_ACTION_RESIZE;
-        actions[num_actions++] = atoms._NET_WM_ACTION_MAXIMIZE_HORZ;
-        actions[num_actions++] = atoms._NET_WM_ACTION_MAXIMIZE_VERT;
-        actions[num_actions++] = atoms._NET_WM_ACTION_FULLSCREEN;
-      }
+  if (!c)
+    c = (client_hot_t*)slotmap_hot(&s->clients, h);
+  vis_change_t change = {h, c->stacking_layer, c->stacking_label, order};
+  if (show)
+    pass->show[pass->show_n++] = change;
+  else
+    pass->hide[pass->hide_n++] = change;
+}
 
-      xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->xid, atoms._NET_WM_ALLOWED_ACTIONS, XCB_ATOM_ATOM, 32, num_actions, actions);
+static void wm_vis_consider_list(server_t* s, vis_pass_t* pass, const handle_vec_t* list) {
+  if (!list)
+    return;
+  for (size_t i = 0; i < list->length; i++)
+    wm_vis_consider(s, pass, list->items[i]);
+}
 
-      hot->dirty &= ~DIRTY_STATE;
-    }
+/*
+ * Workspace visibility as one batch. Only frames whose wanted state differs
+ * from what was last requested are touched, so a switch costs O(changed)
+ * requests instead of a map or unmap for every client. Newly shown frames
+ * are mapped top-down before anything is unmapped: the top window covers
+ * its area first and the root is never exposed between the two desktops.
+ * When both sets are non-empty the batch runs under a server grab so other
+ * clients cannot paint in between.
+ *
+ * Candidates come from the desktop membership index: the desktop now shown,
+ * the one shown last pass, sticky clients, and anything whose membership
+ * changed in between. Clients parked on other desktops are never visited.
+ * Without a usable index every client is checked. Either way candidates are
+ * decided from the client columns (client_col_t) when s->clients has them.
+ * Each screen switches desktops on its own, so a pass covers one screen.
+ */
+static void wm_flush_visibility(server_t* s, screen_t* scr) {
+  size_t n = s->active_clients.length;
+  if (n == 0)
+    return;
 
-    if (i < s->active_clients.length && s->active_clients.items[i] == ptr) {
-      i++;
+  vis_pass_t pass = {0};
+  pass.show = (vis_change_t*)arena_alloc(&s->tick_arena, n * sizeof(*pass.show));
+  pass.hide = (vis_change_t*)arena_alloc(&s->tick_arena, n * sizeof(*pass.hide));
+  if (!pass.show || !pass.hide)
+    return;
+  pass.soa = server_client_cols(s, &pass.cols);
+
+  uint32_t current = scr->current_desktop;
+  uint32_t previous = scr->visible_desktop;
+  pass.screen = (uint8_t)server_screen_index(s, scr);
+  pass.current = current;
+  if (wm_desktop_members_ensure(s)) {
+    wm_vis_consider_list(s, &pass, wm_desktop_members(s, scr, current));
+    wm_vis_consider_list(s, &pass, &scr->sticky_members);
+    if (previous != current)
+      wm_vis_consider_list(s, &pass, wm_desktop_members(s, scr, previous));
+
+    // Moved clients already in one of the lists above were just handled
+    for (size_t i = 0; i < scr->visibility_moved.length; i++) {
+      handle_t h = scr->visibility_moved.items[i];
+      client_cold_t* cold = server_ccold(s, h);
+      if (!cold)
+        continue;
+      uint32_t slot = cold->desktop_member;
+      if (slot == DESKTOP_MEMBER_STICKY || slot == current + DESKTOP_MEMBER_FIRST || slot == previous + DESKTOP_MEMBER_FIRST)
+        continue;
+      wm_vis_consider(s, &pass, h);
     }
   }
+  else {
+    for (size_t i = 0; i < n; i++)
+      wm_vis_consider(s, &pass, s->active_clients.items[i]);
+  }
+  scr->visibility_moved.length = 0;
+  scr->visible_desktop = current;
+
+  size_t show_n = pass.show_n;
+  size_t hide_n = pass.hide_n;
+  vis_change_t* show = pass.show;
+  vis_change_t* hide = pass.hide;
+  if (show_n == 0 && hide_n == 0)
+    return;
+
+  qsort(show, show_n, sizeof(*show), wm_vis_change_cmp);
+
+  bool grab = show_n > 0 && hide_n > 0;
+  if (grab)
+    xcb_grab_server(s->conn);
+
+  for (size_t i = 0; i < show_n; i++) {
+    client_hot_t* c = server_chot(s, show[i].h);
+    // A frozen app must be running before it is asked to repaint
+    wm_client_thaw(s, c);
+    client_complete_probe(s, c);
+    xcb_map_window(s->conn, c->frame);
+    uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_NORMAL, XCB_NONE};
+    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, c->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
+    client_set_frame_vis(s, c, FRAME_VIS_MAPPED);
+  }
+
+  for (size_t i = 0; i < hide_n; i++) {
+    client_hot_t* c = server_chot(s, hide[i].h);
+    if (c->ignore_unmap < UINT8_MAX)
+      c->ignore_unmap++;
+    xcb_unmap_window(s->conn, c->frame);
+    uint32_t state_vals[] = {XCB_ICCCM_WM_STATE_ICONIC, XCB_NONE};
+    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, c->xid, atoms.WM_STATE, atoms.WM_STATE, 32, 2, state_vals);
+    client_set_frame_vis(s, c, FRAME_VIS_HIDDEN);
+    wm_client_freeze_hidden(s, c);
+  }
+
+  if (grab)
+    xcb_ungrab_server(s->conn);
+  TRACE_LOG("visibility screen=%u desktop=%u show=%zu hide=%zu", pass.screen, scr->current_desktop, show_n, hide_n);
+}
+
+/* A queued client stays queued while it still has commit work pending */
+static bool wm_client_needs_commit(const client_hot_t* hot, const client_cold_t* cold) {
+  if (hot->state == STATE_UNMANAGING || hot->state == STATE_DESTROYED)
+    return false;
+  if (hot->state == STATE_READY)
+    return true;
+  return hot->dirty != DIRTY_NONE || !dirty_rects_empty(&cold->frame_damage) || wm_client_geom_mismatch(hot, cold);
+}
+
+/*
+ * Restyle only the clients whose focus differs from the last commit.
+ * wm_set_focus just flips CLIENT_FLAG_FOCUSED, so a focus-follows-mouse
+ * sweep across many windows in one tick repaints the previously and the
+ * finally focused client, not every window crossed. A theme whose active
+ * and inactive frames look alike needs _NET_WM_STATE updated but no paint.
+ */
+static void wm_flush_focus_style(server_t* s) {
+  if (s->committed_focus_client == s->focused_client)
+    return;
+
+  uint32_t dirty = DIRTY_STATE;
+  if (!theme_focus_looks_same(&s->config.theme))
+    dirty |= DIRTY_FRAME_STYLE;
+
+  client_hot_t* old = server_chot(s, s->committed_focus_client);
+  if (old)
+    server_mark_dirty(s, old, dirty);
+  client_hot_t* c = server_chot(s, s->focused_client);
+  if (c)
+    server_mark_dirty(s, c, dirty);
+  s->committed_focus_client = s->focused_client;
+}
+
+/*
+ * Move the focused button grabs (see client_set_button_grabs) with focus.
+ * Keyed on focused_client rather than the committed window, so focus taken
+ * by a client itself and confirmed through FocusIn switches them too.
+ */
+static bool wm_flush_button_grabs(server_t* s) {
+  handle_t want = HANDLE_INVALID;
+  client_hot_t* hot = server_chot(s, s->focused_client);
+  if (hot && hot->state == STATE_MAPPED && !hot->override_redirect)
+    want = s->focused_client;
+  if (want == s->button_grab_client)
+    return false;
+
+  if (server_chot(s, s->button_grab_client))
+    client_set_button_grabs(s, s->button_grab_client, false);
+  if (want != HANDLE_INVALID)
+    client_set_button_grabs(s, want, true);
+  s->button_grab_client = want;
+  return true;
+}
+
+int wm_manage_defer_timeout_ms(server_t* s, uint64_t now) {
+  uint64_t defer_ns = (uint64_t)s->config.manage_defer_ms * 1000000ull;
+  if (defer_ns == 0)
+    return -1;
+
+  int best = -1;
+  for (size_t i = 0; i < s->dirty_clients.length; i++) {
+    handle_t h = s->dirty_clients.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    if (!hot || hot->state != STATE_READY)
+      continue;
+    uint64_t due = server_ccold(s, h)->manage_timing.t[MANAGE_MARK_START] + defer_ns;
+    int left = due <= now ? 0 : (int)((due - now + 999999u) / 1000000u);
+    if (best < 0 || left < best)
+      best = left;
+  }
+  return best;
+}
+
+// Push a focus change from the model to the server; true if one went out
+static bool wm_flush_focus_commit(server_t* s) {
+  bool grabs = wm_flush_button_grabs(s);
 
-  // Commit Focus
   if (s->committed_focus != s->initial_focus) {
     // Handle initial condition where they might be different?
     // Just use s->focused_client
@@ -968,79 +1274,207 @@ bool wm_flush_dirty(server_t* s, uint64_t now) {
     }
     else {
       // Fallback to root if focused client invalid/unmapped
-      desired_focus = s->root;
+      desired_focus = client_screen(s, focus_hot)->root;
     }
   }
   else {
-    desired_focus = s->root;
+    desired_focus = server_screen(s)->root;
   }
 
-  if (desired_focus != s->committed_focus) {
-    flushed = true;
-    TRACE_LOG("flush_dirty commit focus %u -> %u", s->committed_focus, desired_focus);
+  if (desired_focus == s->committed_focus)
+    return grabs;
 
-    if (desired_focus == s->root) {
-      if (s->default_colormap != XCB_NONE) {
-        xcb_install_colormap(s->conn, s->default_colormap);
-      }
-      xcb_void_cookie_t ck = xcb_set_input_focus(s->conn, XCB_INPUT_FOCUS_POINTER_ROOT, s->root, XCB_CURRENT_TIME);
+  TRACE_LOG("flush_dirty commit focus %u -> %u", s->committed_focus, desired_focus);
+
+  wm_colormap_request(s);
+  if (server_screen_of_root(s, desired_focus)) {
+    xcb_void_cookie_t ck = xcb_set_input_focus(s->conn, XCB_INPUT_FOCUS_POINTER_ROOT, desired_focus, XCB_CURRENT_TIME);
+    wm_note_focus_request_sequence(s, ck);
+  }
+  else if (focus_hot) {
+    if (focus_cold && focus_cold->can_focus) {
+      xcb_void_cookie_t ck = xcb_set_input_focus(s->conn, XCB_INPUT_FOCUS_POINTER_ROOT, focus_hot->xid, XCB_CURRENT_TIME);
       wm_note_focus_request_sequence(s, ck);
     }
-    else if (focus_hot) {
-      wm_install_client_colormap(s, focus_hot);
-
-      if (focus_cold && focus_cold->can_focus) {
-        xcb_void_cookie_t ck = xcb_set_input_focus(s->conn, XCB_INPUT_FOCUS_POINTER_ROOT, focus_hot->xid, XCB_CURRENT_TIME);
-        wm_note_focus_request_sequence(s, ck);
-      }
 
-      if (focus_cold && (focus_cold->protocols & PROTOCOL_TAKE_FOCUS)) {
-        xcb_client_message_event_t ev;
-        memset(&ev, 0, sizeof(ev));
-        ev.response_type = XCB_CLIENT_MESSAGE;
-        ev.format = 32;
-        ev.window = focus_hot->xid;
-        ev.type = atoms.WM_PROTOCOLS;
-        ev.data.data32[0] = atoms.WM_TAKE_FOCUS;
-        ev.data.data32[1] = focus_cold->user_time ? focus_cold->user_time : XCB_CURRENT_TIME;
-        xcb_void_cookie_t ck = xcb_send_event(s->conn, 0, focus_hot->xid, XCB_EVENT_MASK_NO_EVENT, (const char*)&ev);
-        wm_note_focus_request_sequence(s, ck);
-      }
+    if (focus_cold && (focus_cold->protocols & PROTOCOL_TAKE_FOCUS)) {
+      xcb_client_message_event_t ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.response_type = XCB_CLIENT_MESSAGE;
+      ev.format = 32;
+      ev.window = focus_hot->xid;
+      ev.type = atoms.WM_PROTOCOLS;
+      ev.data.data32[0] = atoms.WM_TAKE_FOCUS;
+      ev.data.data32[1] = focus_cold->user_time ? focus_cold->user_time : XCB_CURRENT_TIME;
+      xcb_void_cookie_t ck = xcb_send_event(s->conn, 0, focus_hot->xid, XCB_EVENT_MASK_NO_EVENT, (const char*)&ev);
+      wm_note_focus_request_sequence(s, ck);
     }
+  }
 
-    s->committed_focus = desired_focus;
+  s->committed_focus = desired_focus;
+  TP_FOCUS_COMMIT(desired_focus);
+  return true;
+}
+
+static bool wm_flush_snap_preview(server_t* s) {
+  client_hot_t* preview_hot = NULL;
+  bool interactive = (s->interaction_mode == INTERACTION_MOVE || s->interaction_mode == INTERACTION_RESIZE);
+  if (s->interaction_mode == INTERACTION_MOVE || (interactive && s->interaction_outline)) {
+    preview_hot = server_chot(s, s->interaction_handle);
   }
 
-  // Root properties
+  bool snapping = (preview_hot && preview_hot->snap_preview_active);
+  bool outline = (preview_hot && !snapping && s->interaction_outline);
+  bool should_show = snapping || outline;
+  bool was_mapped = s->snap_preview_mapped;
+  rect_t preview_rect = {0};
+  if (snapping)
+    preview_rect = preview_hot->snap_preview_frame_rect;
+  else if (outline)
+    preview_rect = wm_outline_rect(s, preview_hot, server_ccold(s, s->interaction_handle));
+  snap_preview_apply(s, preview_hot ? client_screen(s, preview_hot) : NULL, should_show ? &preview_rect : NULL, should_show, outline);
+
+  return should_show || was_mapped != s->snap_preview_mapped;
+}
 
-  if (s->root_dirty & ROOT_DIRTY_ACTIVE_WINDOW) {
+// DamageNotify stops at REPORT_LEVEL_NON_EMPTY until the damage is
+// subtracted, and the bucket is gone next tick, so this never waits
+static bool wm_flush_damage_acks(server_t* s) {
+  bool acked = false;
+  size_t damage_cursor = 0;
+  uint64_t damage_key = 0;
+  void* damage_value = NULL;
+  while (epoch_map_next(&s->buckets.damage_regions, &damage_cursor, &damage_key, &damage_value)) {
+    xcb_window_t win = (xcb_window_t)damage_key;
+    handle_t h = server_get_client_by_window(s, win);
+    if (h == HANDLE_INVALID)
+      continue;
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold || cold->damage == XCB_NONE)
+      continue;
+    xcb_damage_subtract(s->conn, cold->damage, XCB_NONE, XCB_NONE);
+    acked = true;
+  }
+  return acked;
+}
+
+// The dragged client only; its queue entry stays for the next full pass
+static bool wm_flush_dragged(server_t* s, uint64_t now) {
+  if (s->interaction_mode != INTERACTION_MOVE && s->interaction_mode != INTERACTION_RESIZE)
+    return false;
+  handle_t h = s->interaction_handle;
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return false;
+
+  bool flushed = wm_flush_client(s, h, hot, cold, now);
+  wm_flush_frames(s);
+  if (hot->dirty & DIRTY_SYNTHETIC_CONFIGURE) {
+    hot->dirty &= ~DIRTY_SYNTHETIC_CONFIGURE;
+    if (wm_send_synthetic_configure(s, h))
+      flushed = true;
+  }
+  return flushed;
+}
+
+bool wm_flush_input(server_t* s, uint64_t now) {
+  bool flushed = false;
+  s->in_commit_phase = true;
+
+  wm_interaction_apply_keys(s);
+  if (wm_interaction_poll_pointer(s, now))
     flushed = true;
-    if (s->focused_client != HANDLE_INVALID) {
-      client_hot_t* c = server_chot(s, s->focused_client);
-      if (c && c->state == STATE_MAPPED) {
-        xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 32, 1, &c->xid);
-      }
-      else {
-        xcb_delete_property(s->conn, s->root, atoms._NET_ACTIVE_WINDOW);
-      }
-    }
-    else {
-      xcb_delete_property(s->conn, s->root, atoms._NET_ACTIVE_WINDOW);
-    }
-    s->root_dirty &= ~ROOT_DIRTY_ACTIVE_WINDOW;
+
+  if (wm_flush_dragged(s, now))
+    flushed = true;
+
+  // A client mapped this tick is not viewable until the visibility pass
+  if (!(server_root_dirty(s) & ROOT_DIRTY_VISIBILITY) && wm_flush_focus_commit(s))
+    flushed = true;
+
+  s->in_commit_phase = false;
+  return flushed;
+}
+
+bool wm_interaction_qos(const server_t* s, uint64_t now) {
+  if (s->config.interactive_defer_ms == 0)
+    return false;
+  if (s->interaction_mode != INTERACTION_MOVE && s->interaction_mode != INTERACTION_RESIZE)
+    return false;
+  return now - s->full_flush_ns < (uint64_t)s->config.interactive_defer_ms * 1000000ull;
+}
+
+/*
+ * Drag mode commit: input, the dragged client and the snap preview. Other
+ * clients stay on the dirty worklist and root properties stay flagged for
+ * the next full pass. Per-tick bucket state that would be lost by waiting
+ * (unmanaged ConfigureRequests, Damage acks) still goes out.
+ */
+static bool wm_flush_interaction(server_t* s, uint64_t now) {
+  // Held work still lands within interactive_defer_ms if the pointer rests;
+  // a pacing timer armed by the dragged client's commit below takes over
+  const handle_vec_t* q = &s->dirty_clients;
+  bool held = q->length > 1 || (q->length == 1 && q->items[0] != s->interaction_handle);
+  if (held || server_root_dirty(s) || server_workarea_dirty(s) || s->buckets.deferred_props_len > 0) {
+    uint64_t bound = (uint64_t)s->config.interactive_defer_ms * 1000000ull;
+    server_schedule_timer_ns(s, bound - (now - s->full_flush_ns));
   }
 
-  if (s->root_dirty & (ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING)) {
+  s->in_commit_phase = true;
+  bool flushed = wm_flush_snap_preview(s);
+  if (wm_flush_unmanaged_configure_requests(s))
+    flushed = true;
+  if (wm_flush_damage_acks(s))
+    flushed = true;
+  s->in_commit_phase = false;
+
+  if (wm_flush_input(s, now))
     flushed = true;
+  s->interaction_qos_ticks++;
+  return flushed;
+}
+
+/*
+ * One screen's root properties. _NET_ACTIVE_WINDOW names the focused client
+ * on its own screen and is None on the others; the client lists carry only
+ * the clients of the screen.
+ */
+static bool wm_flush_root_props(server_t* s, screen_t* scr, uint32_t root_held) {
+  bool flushed = false;
+
+  if (scr->root_dirty & ROOT_DIRTY_ACTIVE_WINDOW) {
+    xcb_window_t active = XCB_NONE;
+    client_hot_t* c = server_chot(s, s->focused_client);
+    if (c && c->state == STATE_MAPPED && client_screen(s, c) == scr)
+      active = c->xid;
+
+    // Focus that went away and came back within the tick leaves nothing to say
+    if (!scr->active_window_committed || active != scr->committed_active_window) {
+      flushed = true;
+      if (active != XCB_NONE)
+        xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, scr->root, atoms._NET_ACTIVE_WINDOW, XCB_ATOM_WINDOW, 32, 1, &active);
+      else
+        xcb_delete_property(s->conn, scr->root, atoms._NET_ACTIVE_WINDOW);
+      scr->committed_active_window = active;
+      scr->active_window_committed = true;
+      server_focus_boost_note(s);
+    }
+    scr->root_dirty &= ~ROOT_DIRTY_ACTIVE_WINDOW;
+  }
+
+  uint32_t lists_due = scr->root_dirty & (ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING) & ~root_held;
+  if (lists_due) {
     size_t cap = 0;
     for (int l = 0; l < LAYER_COUNT; l++)
-      cap += s->layers[l].length;
+      cap += scr->layers[l].length;
 
     xcb_window_t* wins_stacking = cap ? (xcb_window_t*)arena_alloc(&s->tick_arena, cap * sizeof(xcb_window_t)) : NULL;
 
     uint32_t idx_stacking = 0;
     if (wins_stacking) {
-      idx_stacking = wm_build_client_list_stacking(s, wins_stacking, (uint32_t)cap);
+      idx_stacking = wm_build_client_list_stacking(s, scr, wins_stacking, (uint32_t)cap);
     }
 
     // _NET_CLIENT_LIST: stable manage order from active_clients.
@@ -1049,31 +1483,212 @@ bool wm_flush_dirty(server_t* s, uint64_t now) {
 
     uint32_t idx_list = 0;
     if (wins_list) {
-      idx_list = wm_build_client_list(s, wins_list, cap_list);
+      idx_list = wm_build_client_list(s, scr, wins_list, cap_list);
     }
 
-    if (s->root_dirty & ROOT_DIRTY_CLIENT_LIST) {
-      xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_CLIENT_LIST, XCB_ATOM_WINDOW, 32, idx_list, wins_list);
+    if (lists_due & ROOT_DIRTY_CLIENT_LIST) {
+      if (wm_publish_window_list(s, scr, ROOT_PROP_CLIENT_LIST, atoms._NET_CLIENT_LIST, wins_list, idx_list))
+        flushed = true;
     }
 
-    if (s->root_dirty & ROOT_DIRTY_CLIENT_LIST_STACKING) {
-      xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, 32, idx_stacking, wins_stacking);
+    if (lists_due & ROOT_DIRTY_CLIENT_LIST_STACKING) {
+      if (wm_publish_window_list(s, scr, ROOT_PROP_CLIENT_LIST_STACKING, atoms._NET_CLIENT_LIST_STACKING, wins_stacking, idx_stacking))
+        flushed = true;
     }
 
-    s->root_dirty &= ~(ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING);
+    scr->root_dirty &= ~lists_due;
+  }
+
+  if (scr->root_dirty & ROOT_DIRTY_CURRENT_DESKTOP) {
+    if (wm_publish_root_prop(s, scr, ROOT_PROP_CURRENT_DESKTOP, atoms._NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &scr->current_desktop))
+      flushed = true;
+    scr->root_dirty &= ~ROOT_DIRTY_CURRENT_DESKTOP;
+  }
+
+  if (scr->root_dirty & ROOT_DIRTY_SHOWING_DESKTOP) {
+    uint32_t val = scr->showing_desktop ? 1u : 0u;
+    if (wm_publish_root_prop(s, scr, ROOT_PROP_SHOWING_DESKTOP, atoms._NET_SHOWING_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &val))
+      flushed = true;
+    scr->root_dirty &= ~ROOT_DIRTY_SHOWING_DESKTOP;
   }
 
-  if (s->root_dirty & ROOT_DIRTY_CURRENT_DESKTOP) {
+  return flushed;
+}
+
+/*
+ * wm_flush_dirty:
+ * Commit all pending state changes to the X server.
+ *
+ * Phases:
+ * 1. Visibility: Map/Unmap windows based on desktop state.
+ * 2. Workarea Pre-Publish: Update _NET_WORKAREA before geometry pass.
+ * 3. Per-Client Updates: Flush geometry, title, hints, and stacking for
+ *    clients on the dirty worklist (see server_mark_dirty).
+ * 4. Focus Commit: Apply deferred focus changes (SetInputFocus).
+ * 5. Root Properties: Update _NET_CLIENT_LIST, ACTIVE_WINDOW, etc.
+ *
+ * Returns true if any X requests were issued (triggering a flush).
+ */
+bool wm_flush_dirty(server_t* s, uint64_t now) {
+  // A raise at drag start, or RandR, needs the whole tick
+  if (wm_interaction_qos(s, now) && !s->buckets.randr_dirty) {
+    client_hot_t* dragged = server_chot(s, s->interaction_handle);
+    if (!dragged || !(dragged->dirty & DIRTY_STACK))
+      return wm_flush_interaction(s, now);
+  }
+
+  bool flushed = false;
+  s->in_commit_phase = true;
+  s->full_flush_ns = now;
+
+  // 0. Handle new clients ready to be managed (queued on STATE_READY).
+  // manage_defer_ms holds them first: one destroyed or withdrawn meanwhile
+  // is dropped by client_unmanage without ever being framed
+  uint64_t defer_ns = (uint64_t)s->config.manage_defer_ms * 1000000ull;
+  for (size_t i = 0; i < s->dirty_clients.length; i++) {
+    handle_t h = s->dirty_clients.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    if (hot && hot->state == STATE_READY) {
+      if (defer_ns && now < server_ccold(s, h)->manage_timing.t[MANAGE_MARK_START] + defer_ns)
+        continue;
+      client_finish_manage(s, h);
+      flushed = true;
+    }
+  }
+
+  // Keyboard drags: this tick's arrow presses become one geometry change
+  wm_interaction_apply_keys(s);
+
+  // Motion-hint drags: read the pointer once per paced commit
+  if (wm_interaction_poll_pointer(s, now))
+    flushed = true;
+
+  // Preview window for snap-to-edge, hollowed out for outline drags
+  if (wm_flush_snap_preview(s))
     flushed = true;
-    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_CURRENT_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &s->current_desktop);
-    s->root_dirty &= ~ROOT_DIRTY_CURRENT_DESKTOP;
+
+  // 1. Visibility (Map/Unmap) - Must happen before focus
+  for (uint32_t i = 0; i < server_screen_count(s); i++) {
+    screen_t* scr = &s->screens[i];
+    if (scr->root_dirty & ROOT_DIRTY_VISIBILITY) {
+      flushed = true;
+      wm_flush_visibility(s, scr);
+      scr->root_dirty &= ~ROOT_DIRTY_VISIBILITY;
+    }
   }
 
-  if (s->root_dirty & ROOT_DIRTY_SHOWING_DESKTOP) {
+  // Fullscreen fast mode follows focus, layer and visibility as committed
+  wm_fullscreen_fast_update(s);
+  uint32_t root_held = wm_fullscreen_fast_held_root(s);
+
+  // 2. Pass through ConfigureRequest for unmanaged windows.
+  if (wm_flush_unmanaged_configure_requests(s))
+    flushed = true;
+
+  // 3. Ack coalesced Damage events once per tick.
+  if (wm_flush_damage_acks(s))
     flushed = true;
-    uint32_t val = s->showing_desktop ? 1u : 0u;
-    xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, s->root, atoms._NET_SHOWING_DESKTOP, XCB_ATOM_CARDINAL, 32, 1, &val);
-    s->root_dirty &= ~ROOT_DIRTY_SHOWING_DESKTOP;
+
+  // Rescale switcher thumbnails that went stale, rate-limited per client
+  if (thumbnail_flush(s, now))
+    flushed = true;
+
+  // 4. Commit RandR-driven desktop geometry updates.
+  if (s->buckets.randr_dirty) {
+    flushed = true;
+    for (uint32_t i = 0; i < server_screen_count(s); i++) {
+      if (!(s->buckets.randr_screens & (1u << i)))
+        continue;
+      screen_t* scr = &s->screens[i];
+      uint16_t width = s->buckets.randr_width[i];
+      uint16_t height = s->buckets.randr_height[i];
+      TRACE_LOG("flush_dirty randr screen=%u width=%u height=%u", i, width, height);
+      wm_update_monitors(s, scr);
+      uint32_t geometry[] = {width, height};
+      wm_publish_root_prop(s, scr, ROOT_PROP_DESKTOP_GEOMETRY, atoms._NET_DESKTOP_GEOMETRY, XCB_ATOM_CARDINAL, 32, 2, geometry);
+      // The compositor only runs on the first screen, see compositor.h
+      if (i == 0)
+        compositor_resize(s, width, height);
+    }
+    s->buckets.randr_dirty = false;
+    s->buckets.randr_screens = 0;
+  }
+
+  // Workarea first so maximized/fullscreen clients marked DIRTY_GEOM during
+  // publish can be flushed in this same tick.
+  for (uint32_t i = 0; i < server_screen_count(s); i++) {
+    screen_t* scr = &s->screens[i];
+    if (!(scr->root_dirty & ROOT_DIRTY_WORKAREA & ~root_held))
+      continue;
+    flushed = true;
+    rect_t wa;
+    wm_compute_workarea(s, scr, &wa);
+#if HXM_TRACE_LOGS
+    static rl_t rl_wa = {0};
+    if (rl_allow(&rl_wa, now, 1000000000)) {
+      TRACE_LOG("publish_workarea screen=%u x=%d y=%d w=%u h=%u", i, wa.x, wa.y, wa.w, wa.h);
+    }
+#endif
+    wm_publish_workarea(s, scr, &wa);
+    scr->root_dirty &= ~ROOT_DIRTY_WORKAREA;
+  }
+
+  wm_flush_focus_style(s);
+
+  // Tiles that changed become desired geometry for the commits below
+  wm_tiling_flush(s);
+
+  // Per-client commit over the dirty worklist: O(queued), not O(clients).
+  // Clients queued during the pass are committed this tick too, up to a bound
+  // so two clients re-marking each other cannot spin the loop.
+  size_t limit = s->dirty_clients.length + s->active_clients.length;
+  size_t processed = 0;
+  bool restack = false;
+  for (; processed < s->dirty_clients.length && processed < limit; processed++) {
+    handle_t h = s->dirty_clients.items[processed];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold)
+      continue;
+
+    if (wm_flush_client(s, h, hot, cold, now))
+      flushed = true;
+    if (hot->dirty & DIRTY_STACK)
+      restack = true;
+  }
+
+  // All of this tick's stacking changes go out as one minimal diff
+  if (restack)
+    stack_commit_to_xcb(s);
+
+  wm_flush_frames(s);
+
+  if (wm_flush_synthetic_configures(s, processed))
+    flushed = true;
+
+  size_t kept = 0;
+  for (size_t qi = 0; qi < s->dirty_clients.length; qi++) {
+    handle_t h = s->dirty_clients.items[qi];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold)
+      continue;
+    if (qi >= processed || wm_client_needs_commit(hot, cold))
+      s->dirty_clients.items[kept++] = h;
+    else
+      hot->dirty_queued = false;
+  }
+  s->dirty_clients.length = kept;
+
+  if (wm_flush_focus_commit(s))
+    flushed = true;
+  if (wm_flush_colormap(s))
+    flushed = true;
+
+  // Root properties
+  for (uint32_t i = 0; i < server_screen_count(s); i++) {
+    if (wm_flush_root_props(s, &s->screens[i], root_held))
+      flushed = true;
   }
 
   s->in_commit_phase = false;
@@ -0,0 +1,221 @@
+/* src/wm_fullscreen.c
+ * Fullscreen fast mode.
+ *
+ * While the focused client is fullscreen and covers its monitor, nothing
+ * the window manager draws on that monitor can be seen, so the work done
+ * for it only competes with the game or video for the CPU and the X server:
+ * - frames under it are not repainted; they are repainted in full on exit
+ * - those frames stop selecting pointer events, and the client's own frame
+ *   stops selecting motion and crossings, which would otherwise propagate
+ *   from a client that does not take them itself
+ * - its switcher thumbnail stops redirecting it and its Damage object is
+ *   destroyed; with automatic redirection the server copies every frame it
+ *   draws, and Damage reports each one
+ * - its frame's render context and backing pixmap are released: it is
+ *   undecorated for as long as it stays fullscreen
+ * - _NET_CLIENT_LIST_STACKING and _NET_WORKAREA, which pagers and panels
+ *   under it redraw on, are held until it leaves (see
+ *   wm_fullscreen_fast_held_root)
+ *
+ * fullscreen_fast turns this on; a client's _NET_WM_BYPASS_COMPOSITOR
+ * overrides it: 1 asks for it, 2 asks to stay composited.
+ *
+ * Evaluated once per full flush, before geometry is committed, so a client
+ * that just went fullscreen qualifies on the tick its new geometry is seen.
+ *
+ * The built-in compositor asks the same question of the whole screen (see
+ * wm_fullscreen_unredirect_client); that does not depend on fullscreen_fast.
+ */
+
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "client.h"
+#include "event.h"
+#include "frame.h"
+#include "hxm.h"
+#include "render.h"
+#include "thumbnail.h"
+#include "wm.h"
+#include "wm_internal.h"
+
+/* The fast client's frame: clicks still reach frame bindings */
+#define FS_FAST_FRAME_MASK (FRAME_EVENT_MASK & ~(uint32_t)(XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW))
+/* Frames under it cannot be reached by the pointer at all */
+#define FS_FAST_COVERED_MASK (FS_FAST_FRAME_MASK & ~(uint32_t)XCB_EVENT_MASK_BUTTON_PRESS)
+
+static bool wm_fs_fast_wanted(const server_t* s, const client_cold_t* cold) {
+  if (cold->bypass_compositor_valid && cold->bypass_compositor == 2)
+    return false;
+  if (cold->bypass_compositor_valid && cold->bypass_compositor == 1)
+    return true;
+  return s->config.fullscreen_fast;
+}
+
+static bool wm_rect_contains(const rect_t* outer, const rect_t* inner) {
+  return inner->x >= outer->x && inner->y >= outer->y && (int32_t)inner->x + inner->w <= (int32_t)outer->x + outer->w &&
+         (int32_t)inner->y + inner->h <= (int32_t)outer->y + outer->h;
+}
+
+/* Committed frame rect: client size plus decorations, at the frame origin */
+static rect_t wm_fs_frame_rect(const server_t* s, const client_hot_t* hot, const client_cold_t* cold) {
+  rect_t r = hot->server;
+  if ((hot->flags & CLIENT_FLAG_UNDECORATED) || cold->gtk_frame_extents_set)
+    return r;
+  uint16_t bw = s->config.theme.border_width;
+  r.w = (uint16_t)(r.w + 2u * bw);
+  r.h = (uint16_t)(r.h + s->config.theme.title_height + bw);
+  return r;
+}
+
+static handle_t wm_fs_fast_candidate(server_t* s, rect_t* out_monitor) {
+  handle_t h = s->focused_client;
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold || hot->state != STATE_MAPPED || hot->layer != LAYER_FULLSCREEN || hot->frame_vis != FRAME_VIS_MAPPED)
+    return HANDLE_INVALID;
+  if (!wm_fs_fast_wanted(s, cold))
+    return HANDLE_INVALID;
+
+  rect_t mon;
+  wm_get_monitor_geometry(s, hot, &mon);
+  rect_t frame = wm_fs_frame_rect(s, hot, cold);
+  if (!wm_rect_contains(&frame, &mon))
+    return HANDLE_INVALID;
+  *out_monitor = mon;
+  return h;
+}
+
+bool wm_fullscreen_fast_covers(server_t* s, handle_t h) {
+  if (s->fs_fast == HANDLE_INVALID || h == s->fs_fast)
+    return false;
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  // Another fullscreen client may be stacked above the fast one
+  if (!hot || !cold || hot->frame == XCB_NONE || hot->layer == LAYER_FULLSCREEN || hot->override_redirect)
+    return false;
+  rect_t frame = wm_fs_frame_rect(s, hot, cold);
+  return wm_rect_contains(&s->fs_fast_monitor, &frame);
+}
+
+static void wm_fs_set_frame_mask(server_t* s, const client_hot_t* hot, uint32_t mask) {
+  xcb_change_window_attributes(s->conn, hot->frame, XCB_CW_EVENT_MASK, &mask);
+}
+
+static void wm_fs_fast_enter(server_t* s, handle_t h, const rect_t* monitor) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  s->fs_fast = h;
+  s->fs_fast_monitor = *monitor;
+  s->fs_fast_entered++;
+
+  s->fs_fast_thumb = cold->thumb_redirected;
+  thumbnail_suspend(s, h);
+
+  render_free(&cold->render_ctx);
+  render_init(&cold->render_ctx);
+  if (cold->frame_pixmap != XCB_NONE) {
+    client_frame_backing_destroy(s->conn, cold);
+    uint32_t pixel = FRAME_BACKGROUND_PIXEL;
+    xcb_change_window_attributes(s->conn, hot->frame, XCB_CW_BACK_PIXEL, &pixel);
+  }
+  wm_fs_set_frame_mask(s, hot, FS_FAST_FRAME_MASK);
+
+  s->fs_fast_covered.length = 0;
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t other = s->active_clients.items[i];
+    client_hot_t* o = server_chot(s, other);
+    if (!o || o->state != STATE_MAPPED || o->frame_vis != FRAME_VIS_MAPPED || !wm_fullscreen_fast_covers(s, other))
+      continue;
+    wm_fs_set_frame_mask(s, o, FS_FAST_COVERED_MASK);
+    handle_vec_push(&s->fs_fast_covered, other);
+  }
+  LOG_DEBUG("fullscreen fast: enter xid=%u covered=%zu", hot->xid, s->fs_fast_covered.length);
+}
+
+/* Give a frame back its events and a full paint */
+static void wm_fs_restore(server_t* s, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  if (!hot || hot->frame == XCB_NONE || hot->state == STATE_UNMANAGING || hot->state == STATE_DESTROYED)
+    return;
+  wm_fs_set_frame_mask(s, hot, FRAME_EVENT_MASK);
+  frame_redraw(s, h, FRAME_REDRAW_ALL);
+}
+
+static void wm_fs_fast_exit(server_t* s) {
+  handle_t h = s->fs_fast;
+  s->fs_fast = HANDLE_INVALID;
+
+  for (size_t i = 0; i < s->fs_fast_covered.length; i++)
+    wm_fs_restore(s, s->fs_fast_covered.items[i]);
+  s->fs_fast_covered.length = 0;
+
+  wm_fs_restore(s, h);
+  if (s->fs_fast_thumb) {
+    thumbnail_track(s, h);
+    s->fs_fast_thumb = false;
+  }
+  // Held root updates are still flagged and go out with this flush
+  LOG_DEBUG("fullscreen fast: exit");
+}
+
+void wm_fullscreen_fast_update(server_t* s) {
+  rect_t monitor = {0};
+  handle_t want = wm_fs_fast_candidate(s, &monitor);
+  if (want == s->fs_fast) {
+    if (want == HANDLE_INVALID)
+      return;
+    // Frames that moved out from under it take pointer events again
+    size_t kept = 0;
+    for (size_t i = 0; i < s->fs_fast_covered.length; i++) {
+      handle_t h = s->fs_fast_covered.items[i];
+      if (wm_fullscreen_fast_covers(s, h))
+        s->fs_fast_covered.items[kept++] = h;
+      else
+        wm_fs_restore(s, h);
+    }
+    s->fs_fast_covered.length = kept;
+    return;
+  }
+
+  if (s->fs_fast != HANDLE_INVALID)
+    wm_fs_fast_exit(s);
+  if (want != HANDLE_INVALID)
+    wm_fs_fast_enter(s, want, &monitor);
+}
+
+void wm_fullscreen_fast_hold_paint(server_t* s, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return;
+  hot->dirty &= ~(uint32_t)(DIRTY_FRAME_ALL | DIRTY_FRAME_TITLE | DIRTY_FRAME_BUTTONS | DIRTY_FRAME_BORDER | DIRTY_TITLE | DIRTY_FRAME_STYLE);
+  dirty_rects_reset(&cold->frame_damage);
+  s->fs_fast_paints_held++;
+
+  // Frames that came under it later are repainted on exit too
+  for (size_t i = 0; i < s->fs_fast_covered.length; i++) {
+    if (s->fs_fast_covered.items[i] == h)
+      return;
+  }
+  handle_vec_push(&s->fs_fast_covered, h);
+}
+
+handle_t wm_fullscreen_unredirect_client(server_t* s, const rect_t* screen) {
+  handle_t h = s->focused_client;
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold || hot->state != STATE_MAPPED || hot->layer != LAYER_FULLSCREEN || hot->frame_vis != FRAME_VIS_MAPPED)
+    return HANDLE_INVALID;
+  if (cold->bypass_compositor_valid && cold->bypass_compositor == 2)
+    return HANDLE_INVALID;
+  rect_t frame = wm_fs_frame_rect(s, hot, cold);
+  return wm_rect_contains(&frame, screen) ? h : HANDLE_INVALID;
+}
+
+uint32_t wm_fullscreen_fast_held_root(const server_t* s) {
+  if (s->fs_fast == HANDLE_INVALID)
+    return 0;
+  // A workarea-sized fullscreen client follows the workarea
+  return ROOT_DIRTY_CLIENT_LIST_STACKING | (s->config.fullscreen_use_workarea ? 0u : ROOT_DIRTY_WORKAREA);
+}
@@ -4,14 +4,14 @@
  * This module manages:
  * - Global key bindings (Alt-Tab, Workspace switching, etc.).
  * - Focus cycling logic (MRU traversal).
- * - Executing external commands (spawn).
+ * - Executing external commands (through launcher.h).
  */
 
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <unistd.h>
 
 #ifndef TEST_WM_INPUT_KEYS
@@ -28,77 +28,99 @@
 #include "wm_internal.h"
 #endif
 
-// Common modifiers that should be ignored when matching bindings
-// (CapsLock, NumLock/Mod2, ScrollLock/Mod5)
-#ifndef TEST_WM_INPUT_KEYS
-static const uint16_t IGNORED_MODS[] = {0,
-                                        XCB_MOD_MASK_LOCK,
-                                        XCB_MOD_MASK_2,
-                                        XCB_MOD_MASK_5,
-                                        XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2,
-                                        XCB_MOD_MASK_LOCK | XCB_MOD_MASK_5,
-                                        XCB_MOD_MASK_2 | XCB_MOD_MASK_5,
-                                        XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2 | XCB_MOD_MASK_5};
-#endif
+const uint16_t wm_lock_mod_combos[WM_LOCK_MOD_COMBOS] = {0,
+                                                          XCB_MOD_MASK_LOCK,
+                                                          XCB_MOD_MASK_2,
+                                                          XCB_MOD_MASK_5,
+                                                          XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2,
+                                                          XCB_MOD_MASK_LOCK | XCB_MOD_MASK_5,
+                                                          XCB_MOD_MASK_2 | XCB_MOD_MASK_5,
+                                                          XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2 | XCB_MOD_MASK_5};
 
 uint32_t wm_clean_mods(uint16_t state) {
   // Mask out NumLock, ScrollLock, and CapsLock for comparison
-  return state & ~(XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2 | XCB_MOD_MASK_5);
+  return state & ~WM_LOCK_MODS;
 }
 
-#ifndef TEST_WM_INPUT_KEYS
-static void spawn(const char* cmd) {
-  if (!cmd)
-    return;
+/*
+ * Key dispatch index
+ *
+ * A press resolves (keycode, clean modifiers) to a binding once: keysym
+ * lookup plus a scan of key_bindings, first match wins. The answer (or "no
+ * binding") is stored in s->key_dispatch, so repeats and later presses of the
+ * same chord are a single table read. wm_setup_keys clears the table on
+ * reload and MappingNotify and primes it for every grabbed chord.
+ */
 
-  // Double fork to avoid zombies if SIGCHLD isn't trapped globally
-  pid_t pid = fork();
-  if (pid == 0) {
-    if (fork() == 0) {
-      setsid();
-      char* args[] = {"/bin/sh", "-c", (char*)cmd, NULL};
-      execvp(args[0], args);
-      // Use _exit to avoid flushing parent stdio buffers
-      perror("spawn execvp failed");
-      _exit(127);
+// Pack clean modifiers into a key_dispatch column, -1 if outside the index
+static int key_dispatch_slot(uint32_t clean) {
+  if (clean & ~(uint32_t)(XCB_MOD_MASK_SHIFT | XCB_MOD_MASK_CONTROL | XCB_MOD_MASK_1 | XCB_MOD_MASK_3 | XCB_MOD_MASK_4))
+    return -1;
+  int slot = 0;
+  if (clean & XCB_MOD_MASK_SHIFT)
+    slot |= 1 << 0;
+  if (clean & XCB_MOD_MASK_CONTROL)
+    slot |= 1 << 1;
+  if (clean & XCB_MOD_MASK_1)
+    slot |= 1 << 2;
+  if (clean & XCB_MOD_MASK_3)
+    slot |= 1 << 3;
+  if (clean & XCB_MOD_MASK_4)
+    slot |= 1 << 4;
+  return slot;
+}
+
+static key_binding_t* key_dispatch_lookup(server_t* s, xcb_keycode_t keycode, uint32_t clean) {
+  int slot = key_dispatch_slot(clean);
+  // Bindings only carry modifier bits, so a held button never matches
+  if (slot < 0)
+    return NULL;
+
+  uint16_t entry = s->key_dispatch[keycode][slot];
+  if (entry == KEY_DISPATCH_NONE)
+    return NULL;
+  if (entry != 0 && entry <= s->config.key_bindings.length)
+    return s->config.key_bindings.items[entry - 1];
+
+  xcb_keysym_t sym = xcb_key_symbols_get_keysym(s->keysyms, keycode, 0);
+  key_binding_t* found = NULL;
+  size_t i = 0;
+  for (; i < s->config.key_bindings.length; i++) {
+    key_binding_t* b = s->config.key_bindings.items[i];
+    if (b && b->keysym == sym && (uint32_t)b->modifiers == clean) {
+      found = b;
+      break;
     }
-    _exit(0);
-  }
-  // Wait for the intermediate child
-  if (pid > 0) {
-    waitpid(pid, NULL, 0);
   }
+
+  if (!found)
+    s->key_dispatch[keycode][slot] = KEY_DISPATCH_NONE;
+  else if (i + 1 < KEY_DISPATCH_NONE)
+    s->key_dispatch[keycode][slot] = (uint16_t)(i + 1);
+  LOG_DEBUG("Key dispatch resolved: keycode=%u clean=%u sym=%x binding=%zd", keycode, clean, sym, found ? (ssize_t)i : (ssize_t)-1);
+  return found;
 }
-#endif
 
 // Helper predicate for focus cycling
 static bool is_focusable(client_hot_t* c, server_t* s) {
   if (c->state != STATE_MAPPED)
     return false;
 
+  // Cycling stays on the screen the user is on
+  const screen_t* scr = server_screen(s);
+  if (client_screen(s, c) != scr)
+    return false;
+
   // Respect "show desktop" temporary hides
-  if (s->showing_desktop && c->show_desktop_hidden)
+  if (scr->showing_desktop && c->show_desktop_hidden)
     return false;
 
   // Must be on current desktop or sticky
-  if (c->desktop != (int32_t)s->current_desktop && !c->sticky)
+  if (c->desktop != (int32_t)scr->current_desktop && !c->sticky)
     return false;
 
   // Reject un-focusable types
-  switch (c->type) {
-    case WINDOW_TYPE_DOCK:
-    case WINDOW_TYPE_NOTIFICATION:
-    case WINDOW_TYPE_DESKTOP:
-    case WINDOW_TYPE_MENU:
-    case WINDOW_TYPE_DROPDOWN_MENU:
-    case WINDOW_TYPE_POPUP_MENU:
-    case WINDOW_TYPE_TOOLTIP:
-    case WINDOW_TYPE_COMBO:
-    case WINDOW_TYPE_DND:
-      return false;
-    default:
-      return true;
-  }
+  return (focus_mru_client_flags(c) & FOCUS_MRU_SWITCHABLE) != 0;
 }
 
 void wm_switcher_step(server_t* s, int dir);
@@ -143,8 +165,9 @@ static void switcher_activate_client(server_t* s, handle_t h) {
   if (!hot)
     return;
 
-  if (!hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != s->current_desktop) {
-    wm_switch_workspace(s, (uint32_t)hot->desktop);
+  screen_t* scr = client_screen(s, hot);
+  if (!hot->sticky && hot->desktop >= 0 && (uint32_t)hot->desktop != scr->current_desktop) {
+    wm_switch_workspace(s, scr, (uint32_t)hot->desktop);
   }
 
   if (hot->state == STATE_UNMAPPED) {
@@ -183,45 +206,77 @@ void wm_switcher_cancel(server_t* s) {
 }
 
 void wm_cycle_focus(server_t* s, bool forward) {
-  if (list_empty(&s->focus_history))
+  focus_mru_t* mru = &s->focus_mru;
+  if (mru->count == 0)
     return;
 
-  list_node_t* start_node = &s->focus_history;
-
-  // If we have a focused client, start searching from there
+  // Start from the focused client, else from the sentinel (slot 0)
+  uint32_t start = 0;
   if (s->focused_client != HANDLE_INVALID) {
     client_hot_t* focused = server_chot(s, s->focused_client);
     if (focused)
-      start_node = &focused->focus_node;
+      start = focused->focus_slot;
   }
 
-  list_node_t* node = forward ? start_node->next : start_node->prev;
-
-  // Guard against infinite loop if no windows are focusable
-  int iterations = 0;
-  int max_iterations = (int)s->active_clients.length + 4;  // Sanity limit
-
-  while (node != start_node && iterations++ < max_iterations) {
-    // Skip the list head (sentinel)
-    if (node == &s->focus_history) {
-      node = forward ? node->next : node->prev;
-      if (node == start_node)
-        break;
-    }
-
-    client_hot_t* c = (client_hot_t*)((char*)node - offsetof(client_hot_t, focus_node));
+  // The history is circular, so the walk ends back at start
+  int32_t desktop = (int32_t)server_screen(s)->current_desktop;
+  uint32_t need = FOCUS_MRU_MAPPED | FOCUS_MRU_SWITCHABLE;
+  uint32_t i = start;
+  while ((i = forward ? focus_mru_next(mru, i) : focus_mru_prev(mru, i)) != start) {
+    if (i == 0 || !focus_mru_match(mru, i, desktop, need))
+      continue;
 
-    if (is_focusable(c, s)) {
+    client_hot_t* c = server_chot(s, focus_mru_handle(mru, i));
+    if (c && is_focusable(c, s)) {
       wm_set_focus(s, c->self);
       stack_raise(s, c->self);
       return;
     }
-
-    node = forward ? node->next : node->prev;
   }
 }
 
 #ifndef TEST_WM_INPUT_KEYS
+#define KEY_GRAB(keycode, mods) (((uint32_t)(keycode) << 16) | (uint32_t)(uint16_t)(mods))
+#define KEY_GRAB_KEYCODE(g) ((xcb_keycode_t)((g) >> 16))
+#define KEY_GRAB_MODS(g) ((uint16_t)((g) & 0xFFFFu))
+
+static int key_grab_cmp(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
+}
+
+static void key_grabs_push(uint32_t** v, size_t* len, size_t* cap, uint32_t g) {
+  if (*len == *cap) {
+    size_t next = *cap ? *cap * 2 : 64;
+    uint32_t* grown = realloc(*v, next * sizeof(**v));
+    if (!grown) {
+      LOG_ERROR("key grab set allocation failed");
+      abort();
+    }
+    *v = grown;
+    *cap = next;
+  }
+  (*v)[(*len)++] = g;
+}
+
+// A grab the server refused (usually another client holds the chord) is
+// forgotten, so the next wm_setup_keys tries it again
+static void wm_key_grab_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
+  (void)reply;
+  if (!err)
+    return;
+
+  uint32_t g = (uint32_t)slot->data;
+  LOG_WARN("Key grab keycode=%u mods=0x%x failed with error %u (held by another client?)", KEY_GRAB_KEYCODE(g), KEY_GRAB_MODS(g), err->error_code);
+  uint32_t* hit = bsearch(&g, s->key_grabs, s->key_grab_count, sizeof(*s->key_grabs), key_grab_cmp);
+  if (!hit)
+    return;
+  size_t i = (size_t)(hit - s->key_grabs);
+  memmove(hit, hit + 1, (s->key_grab_count - i - 1) * sizeof(*hit));
+  s->key_grab_count--;
+}
+
 /*
  * wm_setup_keys:
  * Grab all configured global keys on the root window.
@@ -230,15 +285,23 @@ void wm_cycle_focus(server_t* s, bool forward) {
  * X11 grabs are exact. If NumLock or CapsLock is on, the modifier mask changes.
  * To ensure bindings work regardless of Lock state, we grab every binding with
  * all 8 combinations of (CapsLock | NumLock | ScrollLock).
+ *
+ * On reload and MappingNotify only the difference against the grabs already
+ * held is sent, so unchanged bindings never go dead and a typical reload costs
+ * a handful of requests. New grabs are checked through the cookie jar.
+ * The keysym table is kept: event_coalesce refreshes it on MappingNotify.
  */
 void wm_setup_keys(server_t* s) {
-  if (s->keysyms)
-    xcb_key_symbols_free(s->keysyms);
-  s->keysyms = xcb_key_symbols_alloc(s->conn);
+  if (!s->keysyms)
+    s->keysyms = xcb_key_symbols_alloc(s->conn);
   if (!s->keysyms)
     return;
 
-  xcb_ungrab_key(s->conn, XCB_GRAB_ANY, s->root, XCB_MOD_MASK_ANY);
+  memset(s->key_dispatch, 0, sizeof(s->key_dispatch));
+
+  uint32_t* next = NULL;
+  size_t next_len = 0;
+  size_t next_cap = 0;
 
   for (size_t i = 0; i < s->config.key_bindings.length; i++) {
     key_binding_t* b = s->config.key_bindings.items[i];
@@ -252,14 +315,63 @@ void wm_setup_keys(server_t* s) {
     for (xcb_keycode_t* k = keycodes; *k; k++) {
       // Grab for all ignored modifier combinations
       // This ensures the bind works even if CapsLock or NumLock is on
-      for (size_t m = 0; m < sizeof(IGNORED_MODS) / sizeof(IGNORED_MODS[0]); m++) {
-        xcb_grab_key(s->conn, 1, s->root, b->modifiers | IGNORED_MODS[m], *k, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-      }
+      for (size_t m = 0; m < WM_LOCK_MOD_COMBOS; m++)
+        key_grabs_push(&next, &next_len, &next_cap, KEY_GRAB(*k, b->modifiers | wm_lock_mod_combos[m]));
+      key_dispatch_lookup(s, *k, wm_clean_mods(b->modifiers));
     }
     free(keycodes);
   }
 
-  // xcb_flush(s->conn);
+  if (next_len > 1) {
+    qsort(next, next_len, sizeof(*next), key_grab_cmp);
+    size_t w = 1;
+    for (size_t r = 1; r < next_len; r++) {
+      if (next[r] != next[w - 1])
+        next[w++] = next[r];
+    }
+    next_len = w;
+  }
+
+  // Nothing is known about grabs left behind before the first setup
+  if (!s->key_grabs_valid) {
+    for (uint32_t n = 0; n < server_screen_count(s); n++)
+      xcb_ungrab_key(s->conn, XCB_GRAB_ANY, s->screens[n].root, XCB_MOD_MASK_ANY);
+    s->key_grab_count = 0;
+  }
+
+  // Both sets are sorted: walk them together and send only the changes.
+  // Bindings work on every screen, so each change goes to every root
+  size_t oi = 0, ni = 0, grabbed = 0, released = 0;
+  while (oi < s->key_grab_count || ni < next_len) {
+    uint32_t old_g = oi < s->key_grab_count ? s->key_grabs[oi] : UINT32_MAX;
+    uint32_t new_g = ni < next_len ? next[ni] : UINT32_MAX;
+    if (old_g < new_g) {
+      for (uint32_t n = 0; n < server_screen_count(s); n++)
+        xcb_ungrab_key(s->conn, KEY_GRAB_KEYCODE(old_g), s->screens[n].root, KEY_GRAB_MODS(old_g));
+      released++;
+      oi++;
+    }
+    else if (new_g < old_g) {
+      for (uint32_t n = 0; n < server_screen_count(s); n++) {
+        xcb_void_cookie_t ck =
+            xcb_grab_key_checked(s->conn, 1, s->screens[n].root, KEY_GRAB_MODS(new_g), KEY_GRAB_KEYCODE(new_g), XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+        if (ck.sequence != 0)
+          cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GRAB_KEY, HANDLE_INVALID, (uintptr_t)new_g, s->txn_id, wm_key_grab_reply);
+      }
+      grabbed++;
+      ni++;
+    }
+    else {
+      oi++;
+      ni++;
+    }
+  }
+
+  free(s->key_grabs);
+  s->key_grabs = next;
+  s->key_grab_count = next_len;
+  s->key_grabs_valid = true;
+  LOG_DEBUG("Key grabs: %zu held, %zu grabbed, %zu released", next_len, grabbed, released);
 }
 #endif
 
@@ -276,137 +388,188 @@ static int safe_atoi(const char* str) {
   return (int)val;
 }
 
-void wm_handle_key_press(server_t* s, xcb_key_press_event_t* ev) {
-  if (!s->keysyms)
-    return;
-
-  xcb_keysym_t sym = xcb_key_symbols_get_keysym(s->keysyms, ev->detail, 0);
+static void wm_key_binding_run(server_t* s, const key_binding_t* b) {
+  LOG_INFO("Matched key binding action %d", b->action);
 
-  // Menu logic takes precedence
-  if (s->menu.visible) {
-    menu_handle_key_press(s, ev);
-    return;
-  }
+  switch (b->action) {
+    case ACTION_CLOSE:
+      if (s->focused_client != HANDLE_INVALID)
+        client_close(s, s->focused_client);
+      break;
 
-  uint32_t clean_state = wm_clean_mods(ev->state);
-
-  LOG_DEBUG("Key press: detail=%u state=%u clean=%u sym=%x", ev->detail, ev->state, clean_state, sym);
-
-  // Linear scan of bindings
-  // Note: For large configs, a hash map lookup would be O(1)
-  for (size_t i = 0; i < s->config.key_bindings.length; i++) {
-    key_binding_t* b = s->config.key_bindings.items[i];
-    if (!b)
-      continue;
+    case ACTION_FOCUS_NEXT:
+      wm_switcher_start(s, 1);
+      break;
 
-    if (b->keysym != sym || (uint32_t)b->modifiers != clean_state)
-      continue;
+    case ACTION_FOCUS_PREV:
+      wm_switcher_start(s, -1);
+      break;
 
-    LOG_INFO("Matched key binding action %d", b->action);
+    case ACTION_TERMINAL:
+      launcher_first(&s->launcher, "st xterm x-terminal-emulator", s->tick_start_ns);
+      break;
 
-    switch (b->action) {
-      case ACTION_CLOSE:
-        if (s->focused_client != HANDLE_INVALID)
-          client_close(s, s->focused_client);
-        break;
+    case ACTION_EXEC:
+      launcher_shell(&s->launcher, b->exec_cmd, s->tick_start_ns);
+      break;
 
-      case ACTION_FOCUS_NEXT:
-        wm_switcher_start(s, 1);
-        break;
+    case ACTION_RESTART:
+      LOG_INFO("Triggering restart...");
+      g_restart_pending = 1;
+      break;
 
-      case ACTION_FOCUS_PREV:
-        wm_switcher_start(s, -1);
-        break;
+    case ACTION_EXIT:
+      exit(0);
+      break;
 
-      case ACTION_TERMINAL:
-        spawn("st || xterm || x-terminal-emulator");
-        break;
+    case ACTION_WORKSPACE:
+      if (b->exec_cmd)
+        wm_switch_workspace(s, server_screen(s), (uint32_t)safe_atoi(b->exec_cmd));
+      break;
 
-      case ACTION_EXEC:
-        spawn(b->exec_cmd);
-        break;
+    case ACTION_WORKSPACE_PREV:
+      wm_switch_workspace_relative(s, server_screen(s), -1);
+      break;
 
-      case ACTION_RESTART:
-        LOG_INFO("Triggering restart...");
-        g_restart_pending = 1;
-        break;
+    case ACTION_WORKSPACE_NEXT:
+      wm_switch_workspace_relative(s, server_screen(s), 1);
+      break;
 
-      case ACTION_EXIT:
-        exit(0);
-        break;
+    case ACTION_MOVE_TO_WORKSPACE:
+      if (b->exec_cmd && s->focused_client != HANDLE_INVALID) {
+        wm_client_move_to_workspace(s, s->focused_client, (uint32_t)safe_atoi(b->exec_cmd), false);
+      }
+      break;
 
-      case ACTION_WORKSPACE:
-        if (b->exec_cmd)
-          wm_switch_workspace(s, (uint32_t)safe_atoi(b->exec_cmd));
-        break;
+    case ACTION_MOVE_TO_WORKSPACE_FOLLOW:
+      if (b->exec_cmd && s->focused_client != HANDLE_INVALID) {
+        wm_client_move_to_workspace(s, s->focused_client, (uint32_t)safe_atoi(b->exec_cmd), true);
+      }
+      break;
+
+    case ACTION_TOGGLE_STICKY:
+      if (s->focused_client != HANDLE_INVALID)
+        wm_client_toggle_sticky(s, s->focused_client);
+      break;
+
+    case ACTION_TILE_LAYOUT:
+      wm_tiling_cycle_layout(s);
+      break;
+
+    case ACTION_TILE_TOGGLE: {
+      client_hot_t* hot = server_chot(s, s->focused_client);
+      if (hot)
+        wm_tiling_float(s, s->focused_client, !hot->tile_float);
+      break;
+    }
 
-      case ACTION_WORKSPACE_PREV:
-        wm_switch_workspace_relative(s, -1);
-        break;
+    case ACTION_TILE_GROW:
+    case ACTION_TILE_SHRINK:
+      wm_tiling_resize(s, s->focused_client, b->action == ACTION_TILE_GROW);
+      break;
+
+    case ACTION_MOVE:
+    case ACTION_RESIZE:
+      if (s->focused_client != HANDLE_INVALID) {
+        client_hot_t* hot = server_chot(s, s->focused_client);
+        client_cold_t* cold = server_ccold(s, s->focused_client);
+        if (!hot || !cold)
+          break;
+
+        if (b->action == ACTION_MOVE && !client_can_move(hot))
+          break;
+        if (b->action == ACTION_RESIZE && !client_can_resize(hot, cold))
+          break;
+
+        int16_t root_x, root_y;
+
+        if (b->action == ACTION_MOVE) {
+          xcb_query_pointer_cookie_t ck = xcb_query_pointer(s->conn, client_screen(s, hot)->root);
+          if (ck.sequence == 0) {
+            LOG_ERROR("ACTION_MOVE query_pointer returned zero sequence; aborting interaction start");
+            break;
+          }
+          cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_QUERY_POINTER, s->focused_client, 0x300, s->txn_id, wm_handle_reply);
+        }
+        else {
+          // RESIZE: Warp to bottom right
+          root_x = hot->server.x + hot->server.w;
+          root_y = hot->server.y + hot->server.h;
 
-      case ACTION_WORKSPACE_NEXT:
-        wm_switch_workspace_relative(s, 1);
-        break;
+          xcb_warp_pointer(s->conn, XCB_NONE, client_screen(s, hot)->root, 0, 0, 0, 0, root_x, root_y);
 
-      case ACTION_MOVE_TO_WORKSPACE:
-        if (b->exec_cmd && s->focused_client != HANDLE_INVALID) {
-          wm_client_move_to_workspace(s, s->focused_client, (uint32_t)safe_atoi(b->exec_cmd), false);
+          wm_start_interaction(s, s->focused_client, hot, false, RESIZE_BOTTOM | RESIZE_RIGHT, root_x, root_y, XCB_CURRENT_TIME, true);
         }
-        break;
+      }
+      break;
 
-      case ACTION_MOVE_TO_WORKSPACE_FOLLOW:
-        if (b->exec_cmd && s->focused_client != HANDLE_INVALID) {
-          wm_client_move_to_workspace(s, s->focused_client, (uint32_t)safe_atoi(b->exec_cmd), true);
-        }
-        break;
-
-      case ACTION_TOGGLE_STICKY:
-        if (s->focused_client != HANDLE_INVALID)
-          wm_client_toggle_sticky(s, s->focused_client);
-        break;
-
-      case ACTION_MOVE:
-      case ACTION_RESIZE:
-        if (s->focused_client != HANDLE_INVALID) {
-          client_hot_t* hot = server_chot(s, s->focused_client);
-          client_cold_t* cold = server_ccold(s, s->focused_client);
-          if (!hot || !cold)
-            break;
+    default:
+      break;
+  }
+}
 
-          if (b->action == ACTION_MOVE && !client_can_move(hot))
-            break;
-          if (b->action == ACTION_RESIZE && !client_can_resize(hot, cold))
-            break;
+/*
+ * count presses of ev's chord from one tick, all auto-repeats when repeat.
+ * Relative steps take the whole count at once, so a held workspace_next
+ * switches desktops once per tick however many repeats it folded; other
+ * actions run count times as they did per press. A binding's repeat_ms
+ * drops repeat runs closer than that to the last time it ran and lets one
+ * step through otherwise.
+ */
+void wm_handle_key_run(server_t* s, xcb_key_press_event_t* ev, uint32_t count, bool repeat) {
+  if (!s->keysyms || count == 0)
+    return;
+  server_screen_enter(s, ev->root);
 
-          int16_t root_x, root_y;
+  // Menu logic takes precedence
+  if (s->menu.visible) {
+    for (uint32_t i = 0; i < count; i++)
+      menu_handle_key_press(s, ev);
+    return;
+  }
 
-          if (b->action == ACTION_MOVE) {
-            xcb_query_pointer_cookie_t ck = xcb_query_pointer(s->conn, s->root);
-            if (ck.sequence == 0) {
-              LOG_ERROR("ACTION_MOVE query_pointer returned zero sequence; aborting interaction start");
-              break;
-            }
-            cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_QUERY_POINTER, s->focused_client, 0x100, s->txn_id, wm_handle_reply);
-          }
-          else {
-            // RESIZE: Warp to bottom right
-            root_x = hot->server.x + hot->server.w;
-            root_y = hot->server.y + hot->server.h;
+  // A keyboard move/resize owns the keyboard until Return or Escape
+  if (wm_interaction_handle_key(s, ev)) {
+    for (uint32_t i = 1; i < count && s->interaction_mode != INTERACTION_NONE; i++)
+      wm_interaction_handle_key(s, ev);
+    return;
+  }
 
-            xcb_warp_pointer(s->conn, XCB_NONE, s->root, 0, 0, 0, 0, root_x, root_y);
+  uint32_t clean_state = wm_clean_mods(ev->state);
 
-            wm_start_interaction(s, s->focused_client, hot, false, RESIZE_BOTTOM | RESIZE_RIGHT, root_x, root_y, XCB_CURRENT_TIME, true);
-          }
-        }
-        break;
+  LOG_DEBUG("Key press: detail=%u state=%u clean=%u count=%u repeat=%d", ev->detail, ev->state, clean_state, count, repeat);
 
-      default:
-        break;
-    }
-    // Break after finding the first matching binding (prevent duplicate
-    // triggers)
+  // First matching binding only (prevents duplicate triggers)
+  key_binding_t* b = key_dispatch_lookup(s, ev->detail, clean_state);
+  if (!b)
     return;
+
+  key_repeat_t* kr = &s->key_repeat;
+  if (repeat && b->repeat_ms) {
+    if (s->tick_start_ns - kr->fired_ns < (uint64_t)b->repeat_ms * 1000000ull) {
+      kr->capped++;
+      return;
+    }
+    count = 1;
   }
+  kr->fired_ns = s->tick_start_ns;
+
+  switch (b->action) {
+    case ACTION_WORKSPACE_PREV:
+    case ACTION_WORKSPACE_NEXT: {
+      int steps = count < INT16_MAX ? (int)count : INT16_MAX;
+      wm_switch_workspace_relative(s, server_screen(s), b->action == ACTION_WORKSPACE_NEXT ? steps : -steps);
+      break;
+    }
+    default:
+      for (uint32_t i = 0; i < count; i++)
+        wm_key_binding_run(s, b);
+      break;
+  }
+}
+
+void wm_handle_key_press(server_t* s, xcb_key_press_event_t* ev) {
+  wm_handle_key_run(s, ev, 1, false);
 }
 
 void wm_handle_key_release(server_t* s, xcb_key_release_event_t* ev) {
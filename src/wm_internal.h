@@ -9,6 +9,8 @@
 #ifndef WM_INTERNAL_H
 #define WM_INTERNAL_H
 
+#include <xcb/randr.h>
+
 #include "event.h"
 #include "hxm.h"
 
@@ -35,6 +37,14 @@ static inline void wm_compute_max_client_size(uint16_t border_width, uint16_t ti
     *out_max_h = wm_max_client_size_for_frame_extra(frame_extra_h);
 }
 
+// Lock modifiers wm_clean_mods ignores (CapsLock, NumLock/Mod2, ScrollLock/Mod5)
+#define WM_LOCK_MODS (XCB_MOD_MASK_LOCK | XCB_MOD_MASK_2 | XCB_MOD_MASK_5)
+
+// Every combination of WM_LOCK_MODS; key and button grabs are repeated under
+// each so a binding still fires with any of them on
+#define WM_LOCK_MOD_COMBOS 8
+extern const uint16_t wm_lock_mod_combos[WM_LOCK_MOD_COMBOS];
+
 uint32_t wm_clean_mods(uint16_t state);
 
 // Exposed interaction logic
@@ -42,17 +52,97 @@ void wm_start_interaction(server_t* s, handle_t h, client_hot_t* hot, bool start
 
 void wm_client_set_maximize(server_t* s, client_hot_t* hot, bool max_horz, bool max_vert);
 
-void wm_publish_workarea(server_t* s, const rect_t* wa);
-void wm_compute_workareas(server_t* s, rect_t* out_workareas, uint32_t count);
+/*
+ * Write a root property hxm owns unless it already holds exactly these n
+ * items; pagers and panels re-read on every PropertyNotify, so a no-op
+ * rewrite costs each of them a round trip. Returns true if it was written.
+ */
+bool wm_publish_root_prop(server_t* s, screen_t* scr, root_prop_t id, xcb_atom_t prop, xcb_atom_t type, uint8_t format, uint32_t n, const void* data);
+void wm_publish_workarea(server_t* s, screen_t* scr, const rect_t* wa);
+void wm_compute_workareas(server_t* s, screen_t* scr, rect_t* out_workareas, uint32_t count);
 void wm_get_client_workarea(server_t* s, const client_hot_t* hot, rect_t* out_workarea);
 void wm_send_sync_request(server_t* s, const client_hot_t* hot, uint64_t value, uint32_t time);
 
 bool wm_flush_dirty(server_t* s, uint64_t now);
-void wm_set_showing_desktop(server_t* s, bool show);
-void wm_install_client_colormap(server_t* s, client_hot_t* hot);
-void wm_update_monitors(server_t* s);
+void wm_set_showing_desktop(server_t* s, screen_t* scr, bool show);
+// Install the focused client's colormaps at the next flush, see focus.c
+void wm_colormap_request(server_t* s);
+bool wm_flush_colormap(server_t* s);
+bool screen_colormaps_static(const xcb_screen_t* screen);
+void wm_update_monitors(server_t* s, screen_t* scr);
+// Takes ownership of next_monitors; an identical set is dropped without work
+void wm_apply_monitor_snapshot(server_t* s, screen_t* scr, monitor_t* next_monitors, uint32_t active_count);
+// Maximized axes follow the current workarea; false when nothing moved
+bool wm_client_refit_maximize(server_t* s, client_hot_t* hot);
 void wm_get_monitor_geometry(server_t* s, client_hot_t* hot, rect_t* out_geom);
-int wm_monitor_at_point(const server_t* s, int root_x, int root_y);
+int wm_monitor_at_point(const screen_t* scr, int root_x, int root_y);
+uint32_t wm_client_monitor(server_t* s, client_hot_t* hot);
+void wm_client_update_monitor(server_t* s, client_hot_t* hot);
+bool wm_monitor_workarea(server_t* s, screen_t* scr, uint32_t desktop, uint32_t monitor, rect_t* out);
+uint32_t wm_randr_mode_refresh_mhz(const xcb_randr_mode_info_t* mode);
+uint64_t wm_interaction_interval_ns(server_t* s, const client_hot_t* hot);
+bool wm_interaction_poll_pointer(server_t* s, uint64_t now);
+bool wm_interaction_handle_key(server_t* s, const xcb_key_press_event_t* ev);
+void wm_interaction_apply_keys(server_t* s);
 void wm_set_frame_extents_for_window(server_t* s, xcb_window_t win, bool undecorated);
 
+// Fullscreen fast mode, see wm_fullscreen.c
+void wm_fullscreen_fast_update(server_t* s);
+bool wm_fullscreen_fast_covers(server_t* s, handle_t h);
+void wm_fullscreen_fast_hold_paint(server_t* s, handle_t h);
+uint32_t wm_fullscreen_fast_held_root(const server_t* s);
+handle_t wm_fullscreen_unredirect_client(server_t* s, const rect_t* screen);
+
+/*
+ * Property dispatch: one descriptor per interned atom, looked up through
+ * atom_id in O(1). PropertyNotify marks dirty, refetches, then runs notify;
+ * a COOKIE_GET_PROPERTY reply goes to reply, which returns true when the
+ * frame needs restyling.
+ */
+/* Properties clients commonly rewrite with unchanged bytes; each owns one
+ * cold->prop_hash entry */
+typedef enum wm_prop_cache {
+  WM_PROP_CACHE_NONE = 0,
+  WM_PROP_CACHE_WM_HINTS,
+  WM_PROP_CACHE_WM_NORMAL_HINTS,
+  WM_PROP_CACHE_NET_WM_NAME,
+  WM_PROP_CACHE_NET_WM_ICON_NAME,
+} wm_prop_cache_t;
+
+HXM_STATIC_ASSERT(WM_PROP_CACHE_NET_WM_ICON_NAME == CLIENT_PROP_HASH_SLOTS, "one prop_hash entry per cached property");
+
+/* Forget a cached reply hash after the WM changed state its handler derives
+ * from, so the next reply is parsed even if its bytes are unchanged */
+static inline void wm_prop_cache_forget(client_cold_t* cold, wm_prop_cache_t cache) {
+  if (cold && cache != WM_PROP_CACHE_NONE)
+    cold->prop_hash[cache - 1] = 0;
+}
+
+typedef void (*wm_prop_notify_fn)(server_t* s, handle_t h, client_hot_t* hot);
+typedef bool (*wm_prop_reply_fn)(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r);
+
+typedef struct wm_prop_desc {
+  uint32_t dirty;        /* marked on PropertyNotify */
+  xcb_atom_t fetch_type; /* refetched on PropertyNotify when fetch_len > 0 */
+  uint16_t fetch_len;    /* in 32-bit units */
+  uint8_t fetch_as;      /* atom_id + 1 to fetch in its place, 0 = this atom */
+  uint8_t probe;         /* manage_probe_t bit the reply satisfies */
+  uint8_t cache;         /* wm_prop_cache_t slot; an identical reply skips the handler */
+  wm_prop_notify_fn notify;
+  wm_prop_reply_fn reply;
+} wm_prop_desc_t;
+
+/* NULL for atoms the WM does not intern */
+const wm_prop_desc_t* wm_prop_desc(xcb_atom_t atom);
+
+/*
+ * PropertyNotify refetches in flight, keyed like their slot data
+ * ((xid << 32) | atom). A notify while one is outstanding only marks it
+ * stale; settle runs as its reply is handled and issues at most one
+ * follow-up fetch. forget drops a window's entries when its cookies are
+ * purged without callbacks.
+ */
+void wm_prop_fetch_settle(server_t* s, const cookie_slot_t* slot, bool answered);
+void wm_prop_fetch_forget(server_t* s, xcb_window_t xid);
+
 #endif
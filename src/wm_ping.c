@@ -0,0 +1,183 @@
+/* src/wm_ping.c
+ * _NET_WM_PING hang detection.
+ *
+ * Every ping_interval_ms the mapped clients that list _NET_WM_PING in
+ * WM_PROTOCOLS are pinged, and so is a client the moment the user starts to
+ * drag or close it. A ping is a SendEvent; the reply arrives as a
+ * ClientMessage on the root window. Nothing waits for it: one timer, at the
+ * earliest of the next round and the oldest unanswered ping's deadline,
+ * checks the outstanding ones, and a client that has not answered within
+ * ping_timeout_ms is marked hung until it does.
+ *
+ * A hung client gets the cheap path:
+ * - an interactive resize becomes an outline, and XSync requests and the
+ *   wait for the counter are skipped (see wm_flush_client)
+ * - synthetic ConfigureNotify is held; one is sent when it answers again
+ * - its title shows that it is not responding
+ * - client_close kills it at once, through _NET_WM_PID when it is local
+ *
+ * Frozen apps (freeze rule) cannot answer and are neither pinged nor judged.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <xcb/xcb.h>
+
+#include "client.h"
+#include "event.h"
+#include "hxm.h"
+#include "wm.h"
+#include "wm_internal.h"
+
+/* Pings are coarse; let the check share a wakeup */
+#define PING_TIMER_SLACK_NS 50000000u
+
+static bool wm_ping_on(const server_t* s) {
+  return s->config.ping_interval_ms > 0 && s->config.ping_timeout_ms > 0;
+}
+
+static uint32_t wm_ping_ms(uint64_t now_ns) {
+  uint32_t ms = (uint32_t)(now_ns / 1000000u);
+  return ms ? ms : 1u;
+}
+
+static bool wm_ping_frozen(const server_t* s, const client_cold_t* cold) {
+  return s->freezer.count > 0 && cold->pid > 0 && cold->pid <= INT32_MAX && freezer_is_frozen(&s->freezer, (pid_t)cold->pid);
+}
+
+static void wm_ping_fired(wheel_timer_t* t, void* ctx);
+
+/* Move the timer earlier to deadline_ns; a later deadline leaves it alone */
+static void wm_ping_arm(server_t* s, uint64_t deadline_ns) {
+  if (wheel_timer_pending(&s->ping_timer) && s->ping_timer.deadline_ns <= deadline_ns)
+    return;
+  s->ping_timer.fn = wm_ping_fired;
+  timer_wheel_add(&s->timers, &s->ping_timer, deadline_ns, PING_TIMER_SLACK_NS);
+}
+
+static void wm_ping_send(server_t* s, client_hot_t* hot, client_cold_t* cold, uint64_t now_ns) {
+  if (!(cold->protocols & PROTOCOL_PING) || cold->ping_sent_ms != 0 || wm_ping_frozen(s, cold))
+    return;
+
+  xcb_client_message_event_t ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.response_type = XCB_CLIENT_MESSAGE;
+  ev.format = 32;
+  ev.window = hot->xid;
+  ev.type = atoms.WM_PROTOCOLS;
+  ev.data.data32[0] = atoms._NET_WM_PING;
+  ev.data.data32[1] = XCB_CURRENT_TIME;
+  ev.data.data32[2] = hot->xid;
+  xcb_send_event(s->conn, 0, hot->xid, XCB_EVENT_MASK_NO_EVENT, (const char*)&ev);
+
+  cold->ping_sent_ms = wm_ping_ms(now_ns);
+  s->pings_sent++;
+}
+
+static void wm_ping_set_hung(server_t* s, client_hot_t* hot, client_cold_t* cold, bool hung) {
+  if (cold->ping_hung == hung)
+    return;
+  cold->ping_hung = hung;
+  if (hung) {
+    s->pings_hung++;
+    cold->sync_wait_value = 0;
+    LOG_INFO("Client %u is not responding", hot->xid);
+    if (s->interaction_mode == INTERACTION_RESIZE && s->interaction_handle == hot->self)
+      s->interaction_outline = true;
+  }
+  else {
+    LOG_INFO("Client %u is responding again", hot->xid);
+    // Held while it was hung
+    hot->dirty |= DIRTY_SYNTHETIC_CONFIGURE;
+  }
+  hot->dirty |= DIRTY_FRAME_TITLE;
+  server_queue_client(s, hot);
+}
+
+static void wm_ping_fired(wheel_timer_t* t, void* ctx) {
+  (void)t;
+  server_t* s = (server_t*)ctx;
+  if (!wm_ping_on(s))
+    return;
+
+  uint64_t now = monotonic_time_ns();
+  uint32_t now_ms = wm_ping_ms(now);
+  uint32_t timeout_ms = s->config.ping_timeout_ms;
+  bool round = now >= s->ping_round_ns;
+  if (round)
+    s->ping_round_ns = now + (uint64_t)s->config.ping_interval_ms * 1000000u;
+
+  uint64_t next = s->ping_round_ns;
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t h = s->active_clients.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold)
+      continue;
+
+    if (cold->ping_sent_ms != 0) {
+      uint32_t waited = now_ms - cold->ping_sent_ms;
+      if (wm_ping_frozen(s, cold)) {
+        cold->ping_sent_ms = 0;
+      }
+      else if (waited >= timeout_ms) {
+        wm_ping_set_hung(s, hot, cold, true);
+        // Pinged again by the round; a hung client stays hung until it answers
+        cold->ping_sent_ms = 0;
+      }
+      else {
+        uint64_t due = now + (uint64_t)(timeout_ms - waited) * 1000000u;
+        if (due < next)
+          next = due;
+        continue;
+      }
+    }
+    if (round && hot->state == STATE_MAPPED) {
+      wm_ping_send(s, hot, cold, now);
+      if (cold->ping_sent_ms != 0 && now + (uint64_t)timeout_ms * 1000000u < next)
+        next = now + (uint64_t)timeout_ms * 1000000u;
+    }
+  }
+  wm_ping_arm(s, next);
+}
+
+void wm_ping_client(server_t* s, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold || !wm_ping_on(s))
+    return;
+  uint64_t now = monotonic_time_ns();
+  wm_ping_send(s, hot, cold, now);
+  if (cold->ping_sent_ms != 0)
+    wm_ping_arm(s, now + (uint64_t)s->config.ping_timeout_ms * 1000000u);
+}
+
+void wm_ping_reply(server_t* s, xcb_window_t win) {
+  handle_t h = server_get_client_by_window(s, win);
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return;
+  cold->ping_sent_ms = 0;
+  wm_ping_set_hung(s, hot, cold, false);
+}
+
+void wm_ping_reload(server_t* s) {
+  timer_wheel_cancel(&s->timers, &s->ping_timer);
+  s->ping_round_ns = 0;
+  if (wm_ping_on(s)) {
+    s->ping_round_ns = monotonic_time_ns() + (uint64_t)s->config.ping_interval_ms * 1000000u;
+    wm_ping_arm(s, s->ping_round_ns);
+    return;
+  }
+  // Off: nobody is judged any more
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    handle_t h = s->active_clients.items[i];
+    client_hot_t* hot = server_chot(s, h);
+    client_cold_t* cold = server_ccold(s, h);
+    if (!hot || !cold)
+      continue;
+    cold->ping_sent_ms = 0;
+    wm_ping_set_hung(s, hot, cold, false);
+  }
+}
@@ -37,6 +37,8 @@
 #include "event.h"
 #include "frame.h"
 #include "hxm.h"
+#include "menu.h"
+#include "str_intern.h"
 #include "wm.h"
 #include "wm_internal.h"
 
@@ -267,6 +269,163 @@ static uint32_t* prop_get_u32_array(const xcb_get_property_reply_t* r, int min_c
   return (uint32_t*)xcb_get_property_value(r);
 }
 
+/*
+ * _NET_WM_ICON size selection.
+ *
+ * Bounds keep hostile or bloated properties from costing more than a few MB:
+ * at most ICON_COUNT_MAX images, at most ICON_TOTAL_PIXELS_MAX pixels walked,
+ * single images above ICON_PIXELS_MAX are skipped.
+ */
+#define ICON_DIM_MAX 4096u
+#define ICON_PIXELS_MAX (1024ull * 1024ull)
+#define ICON_TOTAL_PIXELS_MAX (4ull * 1024ull * 1024ull)
+#define ICON_COUNT_MAX 32u
+
+static const uint32_t icon_target_sizes[] = {16, 24, 32, 48, 64};
+
+typedef enum icon_scan {
+  ICON_SCAN_STOP = 0, /* header invalid or limit hit, nothing consumed */
+  ICON_SCAN_NEXT,     /* image consumed, another header may follow */
+  ICON_SCAN_LAST      /* image consumed, scan limit reached */
+} icon_scan_t;
+
+/*
+ * Feed one (w, h) header found at word offset. remaining is the number of
+ * property words after the header. Updates the best pick in f.
+ */
+static icon_scan_t icon_scan_header(icon_fetch_t* f, uint32_t offset, uint32_t w, uint32_t h, uint32_t remaining) {
+  if (f->icons_seen >= ICON_COUNT_MAX)
+    return ICON_SCAN_STOP;
+  if (w == 0 || h == 0)
+    return ICON_SCAN_STOP;
+
+  uint64_t pixels = (uint64_t)w * (uint64_t)h;
+  if (pixels > remaining)
+    return ICON_SCAN_STOP;  // truncated
+  if (pixels > ICON_PIXELS_MAX)
+    return (pixels == remaining) ? ICON_SCAN_LAST : ICON_SCAN_NEXT;  // oversize, skip
+  if (f->total_pixels + pixels > ICON_TOTAL_PIXELS_MAX)
+    return ICON_SCAN_STOP;
+
+  if (w <= ICON_DIM_MAX && h <= ICON_DIM_MAX) {
+    uint32_t diff = UINT32_MAX;
+    for (size_t t = 0; t < sizeof(icon_target_sizes) / sizeof(icon_target_sizes[0]); t++) {
+      int dw = abs((int)w - (int)icon_target_sizes[t]);
+      int dh = abs((int)h - (int)icon_target_sizes[t]);
+      uint32_t td = (uint32_t)(dw + dh);
+      if (td < diff)
+        diff = td;
+    }
+
+    uint64_t best_area = (uint64_t)f->best_w * (uint64_t)f->best_h;
+    if (diff < f->best_diff || (diff == f->best_diff && pixels > best_area)) {
+      f->best_diff = diff;
+      f->best_w = w;
+      f->best_h = h;
+      f->best_offset = offset;
+    }
+  }
+
+  f->icons_seen++;
+  f->total_pixels += (uint32_t)pixels;
+  if (pixels == remaining || f->icons_seen >= ICON_COUNT_MAX)
+    return ICON_SCAN_LAST;
+  return ICON_SCAN_NEXT;
+}
+
+/* Replace the client icon with non-premultiplied ARGB pixels */
+static void icon_surface_replace(server_t* s, client_cold_t* cold, const uint32_t* argb, uint32_t w, uint32_t h) {
+  cairo_surface_t* next = icon_cache_intern(&s->icon_cache, argb, w, h);
+  if (cold->icon_surface)
+    cairo_surface_destroy(cold->icon_surface);
+  cold->icon_surface = next;
+}
+
+static void icon_mark_changed(server_t* s, client_hot_t* hot) {
+  server_mark_dirty(s, hot, DIRTY_FRAME_STYLE);
+  if (menu_is_visible(&s->menu) && s->menu.is_client_list)
+    menu_redraw(s);
+}
+
+/* Header walk done: fetch the chosen pixel run, or drop the icon */
+static void icon_scan_finish(server_t* s, handle_t h, client_hot_t* hot, client_cold_t* cold) {
+  icon_fetch_t* f = &cold->icon_fetch;
+  if (f->best_w) {
+    f->phase = ICON_FETCH_PIXELS;
+    if (!client_icon_read_pixels(s, h, f->best_offset + 2, f->best_w * f->best_h))
+      f->phase = ICON_FETCH_IDLE;
+    return;
+  }
+
+  f->phase = ICON_FETCH_IDLE;
+  if (cold->icon_surface) {
+    cairo_surface_destroy(cold->icon_surface);
+    cold->icon_surface = NULL;
+    icon_mark_changed(s, hot);
+  }
+}
+
+/*
+ * Lazy _NET_WM_ICON fetch replies.
+ *
+ * Header reads return (w, h) plus bytes_after, which tells us whether the
+ * pixel run is complete and whether another header follows. Errors and
+ * timeouts end the walk with whatever was found so far.
+ */
+static void wm_handle_icon_reply(server_t* s, const cookie_slot_t* slot, const xcb_get_property_reply_t* r) {
+  client_hot_t* hot = server_chot(s, slot->client);
+  client_cold_t* cold = server_ccold(s, slot->client);
+  if (!hot || !cold)
+    return;
+
+  icon_fetch_t* f = &cold->icon_fetch;
+  uint32_t gen = (uint32_t)(slot->data >> 32);
+  uint32_t offset = (uint32_t)slot->data;
+  if (gen != f->gen)
+    return;  // property changed since this read was issued
+
+  bool cardinal = r && r->type == XCB_ATOM_CARDINAL;
+
+  if (slot->type == COOKIE_GET_PROPERTY_ICON_HEADER) {
+    if (f->phase != ICON_FETCH_SCANNING || offset != f->offset)
+      return;
+
+    int words = 0;
+    const uint32_t* val = cardinal ? prop_get_u32_array(r, 2, &words) : NULL;
+    if (!val) {
+      icon_scan_finish(s, slot->client, hot, cold);
+      return;
+    }
+
+    uint32_t w = val[0];
+    uint32_t h = val[1];
+    uint32_t remaining = (uint32_t)(words - 2) + r->bytes_after / 4;
+    icon_scan_t step = icon_scan_header(f, offset, w, h, remaining);
+    uint64_t next = (uint64_t)offset + 2 + (uint64_t)w * h;
+    if (step != ICON_SCAN_NEXT || next > UINT32_MAX) {
+      icon_scan_finish(s, slot->client, hot, cold);
+      return;
+    }
+
+    f->offset = (uint32_t)next;
+    if (!client_icon_read_header(s, slot->client, f->offset))
+      icon_scan_finish(s, slot->client, hot, cold);
+    return;
+  }
+
+  if (f->phase != ICON_FETCH_PIXELS || offset != f->best_offset + 2)
+    return;
+  f->phase = ICON_FETCH_IDLE;
+
+  int words = 0;
+  const uint32_t* val = cardinal ? prop_get_u32_array(r, 1, &words) : NULL;
+  if (!val || (uint64_t)words != (uint64_t)f->best_w * f->best_h)
+    return;  // shrank under us; the PropertyNotify restarts the fetch
+
+  icon_surface_replace(s, cold, val, f->best_w, f->best_h);
+  icon_mark_changed(s, hot);
+}
+
 static void client_update_effective_strut(client_cold_t* cold) {
   if (cold->strut_partial_active) {
     cold->strut = cold->strut_partial;
@@ -319,7 +478,7 @@ static bool client_should_be_undecorated(const client_hot_t* hot, const client_c
   return false;
 }
 
-static bool client_apply_decoration_hints(client_hot_t* hot, const client_cold_t* cold) {
+static bool client_apply_decoration_hints(server_t* s, client_hot_t* hot, const client_cold_t* cold) {
   if (!hot || !cold)
     return false;
   bool was_undecorated = (hot->flags & CLIENT_FLAG_UNDECORATED) != 0;
@@ -333,7 +492,7 @@ static bool client_apply_decoration_hints(client_hot_t* hot, const client_cold_t
   }
 
   if (was_undecorated != now_undecorated) {
-    hot->dirty |= DIRTY_GEOM | DIRTY_FRAME_STYLE;
+    server_mark_dirty(s, hot, DIRTY_GEOM | DIRTY_FRAME_STYLE);
     return true;
   }
 
@@ -363,7 +522,7 @@ static void parse_net_wm_name_like(server_t* s, handle_t h, client_hot_t* hot, c
       if (had_net) {
         cold->base_title = arena_strndup(&cold->string_arena, "", 0);
         wm_client_refresh_title(s, h);
-        hot->dirty |= DIRTY_FRAME_STYLE;
+        server_mark_dirty(s, hot, DIRTY_FRAME_STYLE);
       }
 
       uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_NAME, XCB_ATOM_STRING, 0, 1024).sequence;
@@ -377,7 +536,7 @@ static void parse_net_wm_name_like(server_t* s, handle_t h, client_hot_t* hot, c
       cold->base_title = arena_strndup(&cold->string_arena, str, trimmed_len);
       cold->has_net_wm_name = true;
       wm_client_refresh_title(s, h);
-      hot->dirty |= DIRTY_FRAME_STYLE;
+      server_mark_dirty(s, hot, DIRTY_FRAME_STYLE);
     }
     return;
   }
@@ -389,7 +548,7 @@ static void parse_net_wm_name_like(server_t* s, handle_t h, client_hot_t* hot, c
       if (had_net) {
         cold->base_icon_name = arena_strndup(&cold->string_arena, "", 0);
         wm_client_refresh_title(s, h);
-        hot->dirty |= DIRTY_FRAME_STYLE;
+        server_mark_dirty(s, hot, DIRTY_FRAME_STYLE);
       }
 
       uint32_t c = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_ICON_NAME, XCB_ATOM_STRING, 0, 1024).sequence;
@@ -403,97 +562,1054 @@ static void parse_net_wm_name_like(server_t* s, handle_t h, client_hot_t* hot, c
       cold->base_icon_name = arena_strndup(&cold->string_arena, str, trimmed_len);
       cold->has_net_wm_icon_name = true;
       wm_client_refresh_title(s, h);
-      hot->dirty |= DIRTY_FRAME_STYLE;
+      server_mark_dirty(s, hot, DIRTY_FRAME_STYLE);
     }
     return;
   }
 }
 
-static void parse_wm_class(client_cold_t* cold, const xcb_get_property_reply_t* r) {
-  int len = 0;
-  char* str = prop_get_string(r, &len);
-  if (!str || len <= 0)
-    return;
-
-  size_t n = (size_t)len;
-  char* nul1 = memchr(str, '\0', n);
-  if (!nul1)
-    return;
-
-  size_t inst_len = (size_t)(nul1 - str);
-  size_t rem = n - inst_len - 1;
-
-  char* cls = nul1 + 1;
-  char* nul2 = memchr(cls, '\0', rem);
-  size_t cls_len = nul2 ? (size_t)(nul2 - cls) : rem;
-
-  if (!cold->wm_instance || strcmp(cold->wm_instance, str) != 0) {
-    cold->wm_instance = arena_strndup(&cold->string_arena, str, inst_len);
+// Returns the RULE_DEP_* fields that changed
+static uint8_t parse_wm_class(client_cold_t* cold, const xcb_get_property_reply_t* r) {
+  int len = 0;
+  char* str = prop_get_string(r, &len);
+  if (!str || len <= 0)
+    return 0;
+
+  size_t n = (size_t)len;
+  char* nul1 = memchr(str, '\0', n);
+  if (!nul1)
+    return 0;
+
+  size_t inst_len = (size_t)(nul1 - str);
+  size_t rem = n - inst_len - 1;
+
+  char* cls = nul1 + 1;
+  char* nul2 = memchr(cls, '\0', rem);
+  size_t cls_len = nul2 ? (size_t)(nul2 - cls) : rem;
+
+  // Interned, so an unchanged value comes back as the same pointer
+  uint8_t changed = 0;
+  const char* instance = str_intern_n(str, inst_len);
+  if (instance != cold->wm_instance)
+    changed |= RULE_DEP_INSTANCE;
+  str_intern_release(cold->wm_instance);
+  cold->wm_instance = instance;
+
+  const char* class_name = str_intern_n(cls, cls_len);
+  if (class_name != cold->wm_class)
+    changed |= RULE_DEP_CLASS;
+  str_intern_release(cold->wm_class);
+  cold->wm_class = class_name;
+  return changed;
+}
+
+static bool client_apply_default_type(server_t* s, client_hot_t* hot, client_cold_t* cold) {
+  (void)s;
+  if (!hot || !cold)
+    return false;
+  if (hot->type_from_net)
+    return false;
+
+  uint8_t prev_type = hot->type;
+  uint8_t prev_layer = hot->layer;
+  uint8_t prev_base = hot->base_layer;
+  uint8_t prev_place = hot->placement;
+
+  if (hot->override_redirect) {
+    hot->type = WINDOW_TYPE_NORMAL;
+    hot->base_layer = LAYER_NORMAL;
+    hot->placement = PLACEMENT_DEFAULT;
+  }
+  else if (cold->transient_for_xid != XCB_NONE) {
+    hot->type = WINDOW_TYPE_DIALOG;
+    hot->base_layer = LAYER_NORMAL;
+    hot->placement = PLACEMENT_CENTER;
+  }
+  else {
+    hot->type = WINDOW_TYPE_NORMAL;
+    hot->base_layer = LAYER_NORMAL;
+    hot->placement = PLACEMENT_DEFAULT;
+  }
+
+  if (hot->layer != LAYER_FULLSCREEN) {
+    hot->layer = client_layer_from_state(hot);
+    if (hot->layer != prev_layer) {
+      server_mark_dirty(s, hot, DIRTY_STATE | DIRTY_STACK);
+    }
+  }
+
+  if (hot->type != prev_type)
+    wm_focus_history_update(s, hot->self);
+
+  bool changed = hot->type != prev_type || hot->base_layer != prev_base || hot->placement != prev_place;
+  if (client_apply_decoration_hints(s, hot, cold))
+    changed = true;
+
+  return changed;
+}
+
+static bool check_transient_cycle(server_t* s, handle_t child, handle_t parent) {
+  if (child == parent)
+    return true;
+  handle_t curr = parent;
+  int depth = 0;
+  while (curr != HANDLE_INVALID && depth < 32) {
+    if (curr == child)
+      return true;
+    client_hot_t* hot = server_chot(s, curr);
+    if (!hot)
+      break;
+    curr = hot->transient_for;
+    depth++;
+  }
+  return false;
+}
+
+/* GetProperty reply handlers, one per property; true when frame decoration
+ * needs a redraw */
+
+static bool prop_reply_wm_class(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  // before holds its own references so it stays readable past the update
+  rule_subject_t before = client_rule_subject(hot, cold);
+  str_intern_ref(before.wm_class);
+  str_intern_ref(before.wm_instance);
+  uint8_t rules_changed = parse_wm_class(cold, r);
+  if (rules_changed)
+    client_rules_changed(s, slot->client, rules_changed, &before);
+  str_intern_release(before.wm_class);
+  str_intern_release(before.wm_instance);
+  return false;
+}
+
+static bool prop_reply_wm_client_machine(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)s;
+  (void)slot;
+  (void)hot;
+  int len = 0;
+  char* str = prop_get_string(r, &len);
+  if (str) {
+    const char* machine = str_intern_n(str, (size_t)len);
+    str_intern_release(cold->wm_client_machine);
+    cold->wm_client_machine = machine;
+  }
+  return false;
+}
+
+static bool prop_reply_wm_command(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)s;
+  (void)slot;
+  (void)hot;
+  int len = 0;
+  char* str = prop_get_string(r, &len);
+  if (str && len > 0) {
+    size_t n = (size_t)len;
+    char* nul = memchr(str, '\0', n);
+    size_t cmd_len = nul ? (size_t)(nul - str) : n;
+    if (cmd_len > 0) {
+      const char* command = str_intern_n(str, cmd_len);
+      str_intern_release(cold->wm_command);
+      cold->wm_command = command;
+    }
+  }
+  return false;
+}
+
+static bool prop_reply_wm_colormap_windows(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)hot;
+  if (!prop_is_empty(r) && r->format == 32 && r->type == XCB_ATOM_WINDOW) {
+    int bytes = xcb_get_property_value_length(r);
+    if (bytes >= 4) {
+      uint32_t count = (uint32_t)(bytes / (int)sizeof(xcb_window_t));
+      client_set_colormap_windows(cold, (xcb_window_t*)xcb_get_property_value(r), count);
+    }
+    else {
+      client_set_colormap_windows(cold, NULL, 0);
+    }
+  }
+  else {
+    client_set_colormap_windows(cold, NULL, 0);
+  }
+  if (s->focused_client == slot->client) {
+    wm_colormap_request(s);
+  }
+  return false;
+}
+
+static bool prop_reply_net_wm_name(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  xcb_atom_t atom = (xcb_atom_t)(slot->data & 0xFFFFFFFFu);
+  parse_net_wm_name_like(s, slot->client, hot, cold, atom, r);
+  return false;
+}
+
+static bool prop_reply_wm_name(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)hot;
+  bool changed = false;
+  if (prop_is_empty(r) && !cold->has_net_wm_name) {
+    cold->base_title = arena_strndup(&cold->string_arena, "", 0);
+    wm_client_refresh_title(s, slot->client);
+    changed = true;
+  }
+  else {
+    int len = 0;
+    char* str = prop_get_string(r, &len);
+    if (str && !cold->has_net_wm_name) {
+      size_t max = clamp_prop_len(len, MAX_TITLE_BYTES);
+      size_t trimmed_len = string_len_until_nul(str, max);
+      if (!cold->base_title || strlen(cold->base_title) != trimmed_len || strncmp(cold->base_title, str, trimmed_len) != 0) {
+        cold->base_title = arena_strndup(&cold->string_arena, str, trimmed_len);
+        wm_client_refresh_title(s, slot->client);
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
+static bool prop_reply_wm_icon_name(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)hot;
+  bool changed = false;
+  if (prop_is_empty(r) && !cold->has_net_wm_icon_name) {
+    cold->base_icon_name = arena_strndup(&cold->string_arena, "", 0);
+    wm_client_refresh_title(s, slot->client);
+    changed = true;
+  }
+  else {
+    int len = 0;
+    char* str = prop_get_string(r, &len);
+    if (str && !cold->has_net_wm_icon_name) {
+      size_t max = clamp_prop_len(len, MAX_TITLE_BYTES);
+      size_t trimmed_len = string_len_until_nul(str, max);
+      if (!cold->base_icon_name || strlen(cold->base_icon_name) != trimmed_len || strncmp(cold->base_icon_name, str, trimmed_len) != 0) {
+        cold->base_icon_name = arena_strndup(&cold->string_arena, str, trimmed_len);
+        wm_client_refresh_title(s, slot->client);
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
+static bool prop_reply_motif_wm_hints(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  bool changed = false;
+  if (client_apply_motif_hints(s, slot->client, r)) {
+    if (client_apply_decoration_hints(s, hot, cold))
+      changed = true;
+  }
+  return changed;
+}
+
+static bool prop_reply_gtk_frame_extents(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  bool changed = false;
+  if (client_apply_gtk_frame_extents(s, slot->client, r)) {
+    server_mark_dirty(s, hot, DIRTY_GEOM);
+    if (client_apply_decoration_hints(s, hot, cold))
+      changed = true;
+  }
+  return changed;
+}
+
+static bool prop_reply_net_wm_state(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)hot;
+  if (prop_is_empty(r)) {
+    client_state_set_t set = {0};
+    wm_client_apply_state_set(s, slot->client, &set);
+  }
+  else {
+    int num_states = 0;
+    xcb_atom_t* states = (xcb_atom_t*)prop_get_u32_array(r, 1, &num_states);
+    if (states) {
+      client_state_set_t set = {0};
+      for (int i = 0; i < num_states; i++) {
+        xcb_atom_t state = states[i];
+        if (state == atoms._NET_WM_STATE_FULLSCREEN) {
+          set.fullscreen = true;
+        }
+        else if (state == atoms._NET_WM_STATE_ABOVE) {
+          set.above = true;
+        }
+        else if (state == atoms._NET_WM_STATE_BELOW) {
+          set.below = true;
+        }
+        else if (state == atoms._NET_WM_STATE_STICKY) {
+          set.sticky = true;
+        }
+        else if (state == atoms._NET_WM_STATE_DEMANDS_ATTENTION) {
+          set.urgent = true;
+        }
+        else if (state == atoms._NET_WM_STATE_MAXIMIZED_HORZ) {
+          set.max_horz = true;
+        }
+        else if (state == atoms._NET_WM_STATE_MAXIMIZED_VERT) {
+          set.max_vert = true;
+        }
+        else if (state == atoms._NET_WM_STATE_MODAL) {
+          set.modal = true;
+        }
+        else if (state == atoms._NET_WM_STATE_SHADED) {
+          set.shaded = true;
+        }
+        else if (state == atoms._NET_WM_STATE_SKIP_TASKBAR) {
+          set.skip_taskbar = true;
+        }
+        else if (state == atoms._NET_WM_STATE_SKIP_PAGER) {
+          set.skip_pager = true;
+        }
+      }
+      /*
+       * Do not import startup maximize hints during initial manage.
+       * Some clients persist maximized state in the property and this
+       * causes every new window to start maximized.
+       */
+      if (cold->manage_phase != MANAGE_DONE) {
+        set.max_horz = false;
+        set.max_vert = false;
+      }
+      wm_client_apply_state_set(s, slot->client, &set);
+    }
+  }
+  return false;
+}
+
+static bool prop_reply_wm_normal_hints(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)slot;
+  xcb_size_hints_t hints;
+
+  size_hints_t next_hints = {0};
+
+  uint32_t next_flags = 0;
+
+  bool valid = false;
+
+  if (prop_is_empty(r)) {
+    valid = true;
+  }
+  else if (xcb_get_property_value_length(r) >= (int)sizeof(xcb_size_hints_t) &&
+
+           xcb_icccm_get_wm_size_hints_from_reply(&hints, r)) {
+    valid = true;
+
+    next_flags = hints.flags;
+
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE) {
+      next_hints.min_w = hints.min_width;
+
+      next_hints.min_h = hints.min_height;
+    }
+
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MAX_SIZE) {
+      next_hints.max_w = hints.max_width;
+
+      next_hints.max_h = hints.max_height;
+    }
+
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_RESIZE_INC) {
+      next_hints.inc_w = hints.width_inc;
+
+      next_hints.inc_h = hints.height_inc;
+    }
+
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_BASE_SIZE) {
+      next_hints.base_w = hints.base_width;
+
+      next_hints.base_h = hints.base_height;
+    }
+
+    if (hints.flags & XCB_ICCCM_SIZE_HINT_P_ASPECT) {
+      next_hints.min_aspect_num = hints.min_aspect_num;
+
+      next_hints.min_aspect_den = hints.min_aspect_den;
+
+      next_hints.max_aspect_num = hints.max_aspect_num;
+
+      next_hints.max_aspect_den = hints.max_aspect_den;
+    }
+  }
+
+  if (valid) {
+    bool hints_changed = (cold->hints_flags != next_flags || memcmp(&cold->hints, &next_hints, sizeof(size_hints_t)) != 0);
+
+    if (hints_changed) {
+      cold->hints = next_hints;
+
+      cold->hints_flags = next_flags;
+
+      server_mark_dirty(s, hot, DIRTY_STATE);  // Allowed actions might change
+      bool is_panel = (hot->type == WINDOW_TYPE_DOCK || hot->type == WINDOW_TYPE_DESKTOP);
+
+      if (hot->state == STATE_NEW && cold->manage_phase != MANAGE_DONE) {
+        bool model_from_request = (hot->dirty & DIRTY_GEOM) != 0;
+        bool user_size = (next_flags & XCB_ICCCM_SIZE_HINT_US_SIZE);
+        bool prog_size = (next_flags & XCB_ICCCM_SIZE_HINT_P_SIZE);
+        if (user_size || prog_size) {
+          if (!model_from_request) {
+            if (hints.width > 0 && (user_size || hints.width > 1))
+              hot->desired.w = (uint16_t)hints.width;
+
+            if (hints.height > 0 && (user_size || hints.height > 1))
+              hot->desired.h = (uint16_t)hints.height;
+          }
+          else {
+            if (hot->desired.w == 0 && hints.width > 0 && (user_size || hints.width > 1))
+              hot->desired.w = (uint16_t)hints.width;
+
+            if (hot->desired.h == 0 && hints.height > 0 && (user_size || hints.height > 1))
+              hot->desired.h = (uint16_t)hints.height;
+          }
+        }
+
+        if (next_flags & XCB_ICCCM_SIZE_HINT_US_POSITION) {
+          if (!model_from_request) {
+            hot->desired.x = (int16_t)hints.x;
+
+            hot->desired.y = (int16_t)hints.y;
+          }
+        }
+
+        if (!is_panel) {
+          client_constrain_size(&cold->hints, cold->hints_flags, &hot->desired.w, &hot->desired.h);
+        }
+      }
+      else if (s->interaction_mode == INTERACTION_RESIZE && s->interaction_window == hot->frame) {
+        if (!is_panel) {
+          client_constrain_size(&cold->hints, cold->hints_flags, &hot->desired.w, &hot->desired.h);
+        }
+
+        server_mark_dirty(s, hot, DIRTY_GEOM);
+      }
+      else {
+        // Even if not resizing, if hints changed, we might need to
+        // re-constrain
+
+        uint16_t w = hot->desired.w;
+
+        uint16_t h_val = hot->desired.h;
+
+        if (!is_panel) {
+          client_constrain_size(&cold->hints, cold->hints_flags, &w, &h_val);
+        }
+
+        if (w != hot->desired.w || h_val != hot->desired.h) {
+          hot->desired.w = w;
+
+          hot->desired.h = h_val;
+
+          server_mark_dirty(s, hot, DIRTY_GEOM);
+        }
+      }
+    }
+  }
+  return false;
+}
+
+static bool prop_reply_wm_transient_for(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  bool changed = false;
+  if (xcb_get_property_value_length(r) >= 4) {
+    xcb_window_t transient_for_xid = *(xcb_window_t*)xcb_get_property_value(r);
+    cold->transient_for_xid = transient_for_xid;
+    handle_t parent = server_get_client_by_window(s, transient_for_xid);
+
+    if (parent != HANDLE_INVALID && check_transient_cycle(s, slot->client, parent)) {
+      LOG_WARN("Ignoring transient_for cycle for client %u", hot->xid);
+      parent = HANDLE_INVALID;
+    }
+    client_set_transient_for(s, hot, parent);
+  }
+  else {
+    cold->transient_for_xid = XCB_NONE;
+    client_set_transient_for(s, hot, HANDLE_INVALID);
+  }
+
+  if (client_apply_default_type(s, hot, cold)) {
+    changed = true;
+  }
+  return changed;
+}
+
+static bool prop_reply_net_wm_window_type(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  bool changed = false;
+  if (xcb_get_property_value_length(r) > 0) {
+    uint8_t prev_type = hot->type;
+    xcb_atom_t* types = (xcb_atom_t*)xcb_get_property_value(r);
+    int num_types = xcb_get_property_value_length(r) / (int)sizeof(xcb_atom_t);
+
+    for (int i = 0; i < num_types; i++) {
+      if (types[i] == atoms._NET_WM_WINDOW_TYPE_DOCK) {
+        hot->type = WINDOW_TYPE_DOCK;
+        hot->base_layer = LAYER_DOCK;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_NOTIFICATION) {
+        hot->type = WINDOW_TYPE_NOTIFICATION;
+        hot->base_layer = LAYER_OVERLAY;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_DIALOG) {
+        hot->type = WINDOW_TYPE_DIALOG;
+        hot->base_layer = LAYER_NORMAL;
+        hot->placement = PLACEMENT_CENTER;
+        hot->type_from_net = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_DESKTOP) {
+        hot->type = WINDOW_TYPE_DESKTOP;
+        hot->base_layer = LAYER_DESKTOP;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        hot->skip_taskbar = true;
+        hot->skip_pager = true;
+        if (!hot->net_wm_desktop_seen) {
+          client_set_sticky(s, hot, true);
+          client_set_desktop(s, hot, -1);
+          wm_desktop_members_sync(s, slot->client);
+          screen_t* scr = client_screen(s, hot);
+          if (handle_vec_find(&scr->strut_clients, slot->client) != SIZE_MAX)
+            wm_workarea_invalidate(scr);
+        }
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_SPLASH) {
+        hot->type = WINDOW_TYPE_SPLASH;
+        hot->base_layer = LAYER_ABOVE;
+        hot->type_from_net = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_TOOLBAR) {
+        hot->type = WINDOW_TYPE_TOOLBAR;
+        hot->base_layer = LAYER_NORMAL;
+        hot->placement = PLACEMENT_DEFAULT;
+        hot->type_from_net = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_UTILITY) {
+        hot->type = WINDOW_TYPE_UTILITY;
+        hot->base_layer = LAYER_NORMAL;
+        hot->placement = PLACEMENT_DEFAULT;
+        hot->type_from_net = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_MENU) {
+        hot->type = WINDOW_TYPE_MENU;
+        hot->base_layer = LAYER_OVERLAY;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_DROPDOWN_MENU) {
+        hot->type = WINDOW_TYPE_DROPDOWN_MENU;
+        hot->base_layer = LAYER_OVERLAY;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
+          hot->manage_aborted = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_POPUP_MENU) {
+        hot->type = WINDOW_TYPE_POPUP_MENU;
+        hot->base_layer = LAYER_OVERLAY;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
+          hot->manage_aborted = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_TOOLTIP) {
+        hot->type = WINDOW_TYPE_TOOLTIP;
+        hot->base_layer = LAYER_OVERLAY;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
+          hot->manage_aborted = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_COMBO) {
+        hot->type = WINDOW_TYPE_COMBO;
+        hot->base_layer = LAYER_OVERLAY;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
+          hot->manage_aborted = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_DND) {
+        hot->type = WINDOW_TYPE_DND;
+        hot->base_layer = LAYER_OVERLAY;
+        hot->flags |= CLIENT_FLAG_UNDECORATED;
+        hot->type_from_net = true;
+        if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
+          hot->manage_aborted = true;
+        break;
+      }
+      else if (types[i] == atoms._NET_WM_WINDOW_TYPE_NORMAL) {
+        hot->type = WINDOW_TYPE_NORMAL;
+        hot->base_layer = LAYER_NORMAL;
+        hot->placement = PLACEMENT_DEFAULT;
+        hot->type_from_net = true;
+        break;
+      }
+    }
+
+    if (client_apply_decoration_hints(s, hot, cold)) {
+      changed = true;
+    }
+
+    if (hot->layer != LAYER_FULLSCREEN) {
+      uint8_t prev_layer = hot->layer;
+      hot->layer = client_layer_from_state(hot);
+      if (hot->layer != prev_layer) {
+        server_mark_dirty(s, hot, DIRTY_STATE | DIRTY_STACK);
+      }
+    }
+
+    wm_focus_history_update(s, slot->client);
+    if (hot->type != prev_type) {
+      client_screen(s, hot)->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
+    }
+  }
+  return changed;
+}
+
+static bool prop_reply_wm_protocols(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)hot;
+  protocol_flags_t prev_protocols = (protocol_flags_t)cold->protocols;
+  cold->protocols = 0;
+  cold->sync_enabled = false;
+  int num_protocols = 0;
+  xcb_atom_t* protocols = (xcb_atom_t*)prop_get_u32_array(r, 1, &num_protocols);
+  if (!protocols && r && r->format == 32 && r->value_len > 0) {
+    protocols = (xcb_atom_t*)xcb_get_property_value(r);
+    num_protocols = (int)r->value_len;
+  }
+  if (protocols) {
+    for (int i = 0; i < num_protocols; i++) {
+      if (protocols[i] == atoms.WM_DELETE_WINDOW) {
+        cold->protocols |= PROTOCOL_DELETE_WINDOW;
+      }
+      else if (protocols[i] == atoms.WM_TAKE_FOCUS) {
+        cold->protocols |= PROTOCOL_TAKE_FOCUS;
+      }
+      else if (protocols[i] == atoms._NET_WM_SYNC_REQUEST) {
+        cold->protocols |= PROTOCOL_SYNC_REQUEST;
+        cold->sync_enabled = true;
+      }
+      else if (protocols[i] == atoms._NET_WM_PING) {
+        cold->protocols |= PROTOCOL_PING;
+      }
+    }
+  }
+
+  bool had_take_focus = (prev_protocols & PROTOCOL_TAKE_FOCUS) != 0;
+  bool has_take_focus = (cold->protocols & PROTOCOL_TAKE_FOCUS) != 0;
+  if (!had_take_focus && has_take_focus) {
+    wm_focus_recommit_if_current(s, slot->client);
+  }
+  return false;
+}
+
+static bool prop_reply_net_wm_desktop(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  uint32_t* val = prop_get_u32_array(r, 1, NULL);
+  if (val) {
+    hot->net_wm_desktop_seen = true;
+    bool sticky = (*val == 0xFFFFFFFFu);
+    uint32_t desk = *val;
+    const screen_t* scr = client_screen(s, hot);
+    if (!sticky && desk >= scr->desktop_count)
+      desk = scr->current_desktop;
+    int32_t new_desk = sticky ? -1 : (int32_t)desk;
+
+    if (hot->sticky == sticky && hot->desktop == new_desk) {
+      // No change
+    }
+    else if (cold->manage_phase == MANAGE_DONE) {
+      wm_client_move_to_workspace(s, slot->client, sticky ? 0xFFFFFFFFu : desk, false);
+    }
+    else {
+      client_set_sticky(s, hot, sticky);
+      client_set_desktop(s, hot, new_desk);
+      wm_desktop_members_sync(s, slot->client);
+    }
+  }
+  return false;
+}
+
+static bool prop_reply_net_wm_strut(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  xcb_atom_t atom = (xcb_atom_t)(slot->data & 0xFFFFFFFFu);
+  int len = r ? xcb_get_property_value_length(r) : 0;
+  bool is_partial = (atom == atoms._NET_WM_STRUT_PARTIAL);
+  strut_t* target = is_partial ? &cold->strut_partial : &cold->strut_full;
+  bool* active = is_partial ? &cold->strut_partial_active : &cold->strut_full_active;
+
+  strut_t prev_effective = cold->strut;
+
+  if (r && r->type == XCB_ATOM_CARDINAL && r->format == 32 && len >= 16) {
+    uint32_t* val = (uint32_t*)xcb_get_property_value(r);
+    memset(target, 0, sizeof(*target));
+    target->left = val[0];
+    target->right = val[1];
+    target->top = val[2];
+    target->bottom = val[3];
+
+    if (is_partial && len >= 48) {
+      target->left_start_y = val[4];
+      target->left_end_y = val[5];
+      target->right_start_y = val[6];
+      target->right_end_y = val[7];
+      target->top_start_x = val[8];
+      target->top_end_x = val[9];
+      target->bottom_start_x = val[10];
+      target->bottom_end_x = val[11];
+      sanitize_strut_range(&target->left_start_y, &target->left_end_y);
+      sanitize_strut_range(&target->right_start_y, &target->right_end_y);
+      sanitize_strut_range(&target->top_start_x, &target->top_end_x);
+      sanitize_strut_range(&target->bottom_start_x, &target->bottom_end_x);
+    }
+    *active = true;
+  }
+  else {
+    memset(target, 0, sizeof(*target));
+    *active = false;
+  }
+
+  // Waterfall: If PARTIAL failed (or empty), try legacy STRUT
+  if (is_partial && !*active) {
+    xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_STRUT, XCB_ATOM_CARDINAL, 0, 4);
+    if (ck.sequence != 0)
+      cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, slot->client, ((uint64_t)hot->xid << 32) | atoms._NET_WM_STRUT, s->txn_id, wm_handle_reply);
+  }
+
+  client_update_effective_strut(cold);
+
+  if (memcmp(&prev_effective, &cold->strut, sizeof(strut_t)) != 0) {
+#if HXM_TRACE_LOGS
+    static rl_t rl_strut = {0};
+    if (rl_allow(&rl_strut, monotonic_time_ns(), 1000000000)) {
+      TRACE_LOG("strut_reply xid=%u atom=%s changed active=%d top=%u", hot->xid, is_partial ? "_NET_WM_STRUT_PARTIAL" : "_NET_WM_STRUT", *active, cold->strut.top);
+    }
+#endif
+    wm_client_strut_changed(s, slot->client);
+    screen_t* scr = client_screen(s, hot);
+    scr->workarea_dirty = true;
+    scr->root_dirty |= ROOT_DIRTY_WORKAREA;
+  }
+  return false;
+}
+
+static bool prop_reply_wm_hints(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  bool changed = false;
+  bool prev_can_focus = cold->can_focus;
+  if (prop_is_empty(r)) {
+    bool changed_any = (cold->can_focus != true || hot->initial_state != XCB_ICCCM_WM_STATE_NORMAL);
+    cold->can_focus = true;
+    hot->initial_state = XCB_ICCCM_WM_STATE_NORMAL;
+    if (hot->flags & CLIENT_FLAG_URGENT) {
+      hot->flags &= ~CLIENT_FLAG_URGENT;
+      server_mark_dirty(s, hot, DIRTY_STATE);
+      changed = true;
+    }
+    else if (changed_any) {
+      server_mark_dirty(s, hot, DIRTY_STATE);
+      changed = true;
+    }
+  }
+  else {
+    xcb_icccm_wm_hints_t hints;
+    if (xcb_icccm_get_wm_hints_from_reply(&hints, r)) {
+      bool next_can_focus = true;
+      if (hints.flags & XCB_ICCCM_WM_HINT_INPUT) {
+        next_can_focus = (bool)(hints.input);
+      }
+
+      uint8_t next_initial_state = hot->initial_state;
+      if (hints.flags & XCB_ICCCM_WM_HINT_STATE) {
+        next_initial_state = (uint8_t)hints.initial_state;
+      }
+
+      bool next_urgent = (hints.flags & XCB_ICCCM_WM_HINT_X_URGENCY) != 0;
+      bool was_urgent = (hot->flags & CLIENT_FLAG_URGENT) != 0;
+
+      if (cold->can_focus != next_can_focus || hot->initial_state != next_initial_state || was_urgent != next_urgent) {
+        cold->can_focus = next_can_focus;
+        hot->initial_state = next_initial_state;
+        if (next_urgent) {
+          hot->flags |= CLIENT_FLAG_URGENT;
+        }
+        else {
+          hot->flags &= ~CLIENT_FLAG_URGENT;
+        }
+        server_mark_dirty(s, hot, DIRTY_STATE);
+        changed = true;
+      }
+    }
+  }
+
+  if (!prev_can_focus && cold->can_focus) {
+    wm_focus_recommit_if_current(s, slot->client);
+  }
+  return changed;
+}
+
+static bool prop_reply_net_wm_icon(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)slot;
+  (void)hot;
+  bool changed = false;
+  // Whole-property read; the lazy path in wm_handle_icon_reply() reads
+  // headers and a single pixel run instead
+  const uint32_t* best_data = NULL;
+  uint32_t best_w = 0;
+  uint32_t best_h = 0;
+
+  int total_words = 0;
+  uint32_t* val = prop_is_empty(r) ? NULL : prop_get_u32_array(r, 2, &total_words);
+  if (!prop_is_empty(r) && !val)
+    return false;
+
+  if (val) {
+    icon_fetch_t pick = {.best_diff = UINT32_MAX};
+    int i = 0;
+    while (i + 2 <= total_words) {
+      uint32_t remaining = (uint32_t)(total_words - i - 2);
+      icon_scan_t step = icon_scan_header(&pick, (uint32_t)i, val[i], val[i + 1], remaining);
+      if (step == ICON_SCAN_STOP)
+        break;
+      i += (int)(2 + val[i] * val[i + 1]);
+      if (step == ICON_SCAN_LAST)
+        break;
+    }
+    if (pick.best_w) {
+      best_data = &val[pick.best_offset + 2];
+      best_w = pick.best_w;
+      best_h = pick.best_h;
+    }
+  }
+
+  if (best_data) {
+    icon_surface_replace(s, cold, best_data, best_w, best_h);
+    changed = true;
+  }
+  else if (cold->icon_surface) {
+    cairo_surface_destroy(cold->icon_surface);
+    cold->icon_surface = NULL;
+    changed = true;
+  }
+  return changed;
+}
+
+static bool prop_reply_net_wm_pid(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)s;
+  (void)slot;
+  (void)hot;
+  if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
+    uint32_t val = *(uint32_t*)xcb_get_property_value(r);
+    cold->pid = val;
+  }
+  return false;
+}
+
+static bool prop_reply_net_wm_user_time(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)s;
+  (void)slot;
+  (void)hot;
+  if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
+    uint32_t val = *(uint32_t*)xcb_get_property_value(r);
+    cold->user_time = val;
+  }
+  return false;
+}
+
+static bool prop_reply_net_wm_user_time_window(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)slot;
+  if (r && r->type == XCB_ATOM_WINDOW && xcb_get_property_value_length(r) >= 4) {
+    xcb_window_t w = *(xcb_window_t*)xcb_get_property_value(r);
+    cold->user_time_window = w;
+
+    if (w != hot->xid) {
+      uint32_t values[] = {XCB_EVENT_MASK_PROPERTY_CHANGE};
+      xcb_change_window_attributes(s->conn, w, XCB_CW_EVENT_MASK, values);
+    }
+  }
+  return false;
+}
+
+static bool prop_reply_net_wm_sync_request_counter(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)hot;
+  // The alarm watches the old counter
+  if (cold->sync_alarm != XCB_NONE) {
+    xcb_sync_destroy_alarm(s->conn, cold->sync_alarm);
+    cold->sync_alarm = XCB_NONE;
+  }
+  cold->sync_wait_value = 0;
+  if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
+    xcb_sync_counter_t counter = *(xcb_sync_counter_t*)xcb_get_property_value(r);
+    cold->sync_counter = counter;
+    cold->sync_value = 0;
+    if (counter != XCB_NONE) {
+      xcb_sync_query_counter_cookie_t ck = xcb_sync_query_counter(s->conn, counter);
+      if (ck.sequence != 0)
+        cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_SYNC_QUERY_COUNTER, slot->client, (uintptr_t)counter, s->txn_id, wm_handle_reply);
+    }
+  }
+  else {
+    cold->sync_counter = 0;
+    cold->sync_value = 0;
+  }
+  return false;
+}
+
+static bool prop_reply_net_wm_window_opacity(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)slot;
+  if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
+    uint32_t val = *(uint32_t*)xcb_get_property_value(r);
+    if (!cold->window_opacity_valid || cold->window_opacity != val) {
+      cold->window_opacity = val;
+      cold->window_opacity_valid = true;
+      if (hot->frame != XCB_NONE) {
+        xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->frame, atoms._NET_WM_WINDOW_OPACITY, XCB_ATOM_CARDINAL, 32, 1, &val);
+      }
+    }
+  }
+  else {
+    if (cold->window_opacity_valid) {
+      cold->window_opacity_valid = false;
+      if (hot->frame != XCB_NONE) {
+        xcb_delete_property(s->conn, hot->frame, atoms._NET_WM_WINDOW_OPACITY);
+      }
+    }
+  }
+  return false;
+}
+
+static bool prop_reply_net_wm_bypass_compositor(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
+  (void)slot;
+  if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
+    uint32_t val = *(uint32_t*)xcb_get_property_value(r);
+    if (val == 0) {
+      if (cold->bypass_compositor_valid) {
+        cold->bypass_compositor_valid = false;
+        cold->bypass_compositor = 0;
+        if (hot->frame != XCB_NONE) {
+          xcb_delete_property(s->conn, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR);
+        }
+      }
+    }
+    else {
+      if (!cold->bypass_compositor_valid || cold->bypass_compositor != val) {
+        cold->bypass_compositor = val;
+        cold->bypass_compositor_valid = true;
+        if (hot->frame != XCB_NONE) {
+          xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 32, 1, &val);
+        }
+      }
+    }
   }
-  if (!cold->wm_class || strcmp(cold->wm_class, cls) != 0) {
-    cold->wm_class = arena_strndup(&cold->string_arena, cls, cls_len);
+  else if (cold->bypass_compositor_valid) {
+    cold->bypass_compositor_valid = false;
+    cold->bypass_compositor = 0;
+    if (hot->frame != XCB_NONE) {
+      xcb_delete_property(s->conn, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR);
+    }
   }
+  return false;
 }
 
-static bool client_apply_default_type(server_t* s, client_hot_t* hot, client_cold_t* cold) {
+static bool prop_reply_net_wm_icon_geometry(server_t* s, const cookie_slot_t* slot, client_hot_t* hot, client_cold_t* cold, xcb_get_property_reply_t* r) {
   (void)s;
-  if (!hot || !cold)
-    return false;
-  if (hot->type_from_net)
-    return false;
-
-  uint8_t prev_type = hot->type;
-  uint8_t prev_layer = hot->layer;
-  uint8_t prev_base = hot->base_layer;
-  uint8_t prev_place = hot->placement;
-
-  if (hot->override_redirect) {
-    hot->type = WINDOW_TYPE_NORMAL;
-    hot->base_layer = LAYER_NORMAL;
-    hot->placement = PLACEMENT_DEFAULT;
-  }
-  else if (cold->transient_for_xid != XCB_NONE) {
-    hot->type = WINDOW_TYPE_DIALOG;
-    hot->base_layer = LAYER_NORMAL;
-    hot->placement = PLACEMENT_CENTER;
+  (void)slot;
+  (void)hot;
+  if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 16) {
+    uint32_t* val = (uint32_t*)xcb_get_property_value(r);
+    rect_t next_geom = {(int16_t)val[0], (int16_t)val[1], (uint16_t)val[2], (uint16_t)val[3]};
+    if (!cold->icon_geometry_valid || memcmp(&cold->icon_geometry, &next_geom, sizeof(rect_t)) != 0) {
+      cold->icon_geometry = next_geom;
+      cold->icon_geometry_valid = true;
+    }
   }
   else {
-    hot->type = WINDOW_TYPE_NORMAL;
-    hot->base_layer = LAYER_NORMAL;
-    hot->placement = PLACEMENT_DEFAULT;
+    cold->icon_geometry_valid = false;
   }
+  return false;
+}
 
-  if (hot->layer != LAYER_FULLSCREEN) {
-    hot->layer = client_layer_from_state(hot);
-    if (hot->layer != prev_layer) {
-      hot->dirty |= DIRTY_STATE | DIRTY_STACK;
-    }
-  }
+/* PropertyNotify work beyond marking dirty bits or a plain refetch */
 
-  bool changed = hot->type != prev_type || hot->base_layer != prev_base || hot->placement != prev_place;
-  if (client_apply_decoration_hints(hot, cold))
-    changed = true;
+static void prop_notify_wm_class(server_t* s, handle_t h, client_hot_t* hot) {
+  // Only live rules care once the window is managed
+  if (!(s->config.rule_set.live_deps & (RULE_DEP_CLASS | RULE_DEP_INSTANCE)))
+    return;
+  xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms.WM_CLASS, XCB_ATOM_STRING, 0, 1024);
+  if (ck.sequence != 0)
+    cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, h, ((uint64_t)hot->xid << 32) | atoms.WM_CLASS, s->txn_id, wm_handle_reply);
+}
 
-  return changed;
+static void prop_notify_net_wm_icon(server_t* s, handle_t h, client_hot_t* hot) {
+  (void)hot;
+  client_icon_invalidate(s, h);
 }
 
-static bool check_transient_cycle(server_t* s, handle_t child, handle_t parent) {
-  if (child == parent)
+/*
+ * Per-atom property behavior, indexed by atom_id. Atoms without an entry
+ * (or outside struct atoms) are ignored on PropertyNotify and their
+ * GetProperty replies are dropped.
+ */
+static const wm_prop_desc_t wm_prop_table[ATOM_ID_COUNT] = {
+    [ATOM_ID_WM_CLASS] = {.notify = prop_notify_wm_class, .reply = prop_reply_wm_class},
+    [ATOM_ID_WM_CLIENT_MACHINE] = {.reply = prop_reply_wm_client_machine},
+    [ATOM_ID_WM_COMMAND] = {.reply = prop_reply_wm_command},
+    [ATOM_ID_WM_COLORMAP_WINDOWS] = {.dirty = DIRTY_HINTS, .reply = prop_reply_wm_colormap_windows},
+    [ATOM_ID__NET_WM_NAME] = {.dirty = DIRTY_TITLE, .cache = WM_PROP_CACHE_NET_WM_NAME, .reply = prop_reply_net_wm_name},
+    [ATOM_ID__NET_WM_ICON_NAME] = {.cache = WM_PROP_CACHE_NET_WM_ICON_NAME, .reply = prop_reply_net_wm_name},
+    [ATOM_ID_WM_NAME] = {.dirty = DIRTY_TITLE, .reply = prop_reply_wm_name},
+    [ATOM_ID_WM_ICON_NAME] = {.reply = prop_reply_wm_icon_name},
+    [ATOM_ID__MOTIF_WM_HINTS] = {.dirty = DIRTY_HINTS, .reply = prop_reply_motif_wm_hints},
+    [ATOM_ID__GTK_FRAME_EXTENTS] = {.dirty = DIRTY_HINTS, .reply = prop_reply_gtk_frame_extents},
+    [ATOM_ID__KDE_NET_WM_FRAME_STRUT] = {.dirty = DIRTY_HINTS, .reply = prop_reply_gtk_frame_extents},
+    [ATOM_ID__NET_WM_STATE] = {.fetch_type = XCB_ATOM_ATOM, .fetch_len = 32, .reply = prop_reply_net_wm_state},
+    [ATOM_ID_WM_NORMAL_HINTS] = {.dirty = DIRTY_HINTS, .cache = WM_PROP_CACHE_WM_NORMAL_HINTS, .reply = prop_reply_wm_normal_hints},
+    [ATOM_ID_WM_TRANSIENT_FOR] = {.probe = MANAGE_PROBE_TRANSIENT_FOR, .reply = prop_reply_wm_transient_for},
+    [ATOM_ID__NET_WM_WINDOW_TYPE] = {.fetch_type = XCB_ATOM_ATOM, .fetch_len = 32, .probe = MANAGE_PROBE_WINDOW_TYPE, .reply = prop_reply_net_wm_window_type},
+    [ATOM_ID_WM_PROTOCOLS] = {.fetch_type = XCB_ATOM_ATOM, .fetch_len = 32, .reply = prop_reply_wm_protocols},
+    [ATOM_ID__NET_WM_DESKTOP] = {.fetch_type = XCB_ATOM_CARDINAL, .fetch_len = 1, .reply = prop_reply_net_wm_desktop},
+    [ATOM_ID__NET_WM_STRUT] = {.dirty = DIRTY_STRUT, .fetch_type = XCB_ATOM_CARDINAL, .fetch_len = 12, .fetch_as = ATOM_ID__NET_WM_STRUT_PARTIAL + 1, .reply = prop_reply_net_wm_strut},
+    [ATOM_ID__NET_WM_STRUT_PARTIAL] = {.dirty = DIRTY_STRUT, .fetch_type = XCB_ATOM_CARDINAL, .fetch_len = 12, .fetch_as = ATOM_ID__NET_WM_STRUT_PARTIAL + 1, .reply = prop_reply_net_wm_strut},
+    [ATOM_ID_WM_HINTS] = {.dirty = DIRTY_HINTS, .probe = MANAGE_PROBE_WM_HINTS, .cache = WM_PROP_CACHE_WM_HINTS, .reply = prop_reply_wm_hints},
+    [ATOM_ID__NET_WM_ICON] = {.notify = prop_notify_net_wm_icon, .reply = prop_reply_net_wm_icon},
+    [ATOM_ID__NET_WM_PID] = {.reply = prop_reply_net_wm_pid},
+    [ATOM_ID__NET_WM_USER_TIME] = {.reply = prop_reply_net_wm_user_time},
+    [ATOM_ID__NET_WM_USER_TIME_WINDOW] = {.reply = prop_reply_net_wm_user_time_window},
+    [ATOM_ID__NET_WM_SYNC_REQUEST_COUNTER] = {.fetch_type = XCB_ATOM_CARDINAL, .fetch_len = 1, .reply = prop_reply_net_wm_sync_request_counter},
+    [ATOM_ID__NET_WM_WINDOW_OPACITY] = {.dirty = DIRTY_OPACITY, .reply = prop_reply_net_wm_window_opacity},
+    [ATOM_ID__NET_WM_BYPASS_COMPOSITOR] = {.dirty = DIRTY_BYPASS_COMPOSITOR, .reply = prop_reply_net_wm_bypass_compositor},
+    [ATOM_ID__NET_WM_ICON_GEOMETRY] = {.reply = prop_reply_net_wm_icon_geometry},
+};
+
+/*
+ * True when r carries the same type, format and bytes as the last reply
+ * handled for this cache slot; otherwise records r's hash. The handlers
+ * only diff against state they derived from that reply, so skipping them
+ * for an identical one changes nothing.
+ */
+static bool prop_reply_unchanged(client_cold_t* cold, uint8_t cache, const xcb_get_property_reply_t* r) {
+  if (cache == WM_PROP_CACHE_NONE)
+    return false;
+  uint32_t* last = &cold->prop_hash[cache - 1];
+
+  uint32_t head[3] = {r->type, r->format, r->bytes_after};
+  uint32_t h = crc32c(0, head, sizeof(head));
+  h = crc32c(h, xcb_get_property_value(r), (size_t)xcb_get_property_value_length(r));
+  h |= (h == 0);
+  if (*last == h)
     return true;
-  handle_t curr = parent;
-  int depth = 0;
-  while (curr != HANDLE_INVALID && depth < 32) {
-    if (curr == child)
-      return true;
-    client_hot_t* hot = server_chot(s, curr);
-    if (!hot)
-      break;
-    curr = hot->transient_for;
-    depth++;
-  }
+  *last = h;
   return false;
 }
 
+const wm_prop_desc_t* wm_prop_desc(xcb_atom_t atom) {
+  int id = atom_id(atom);
+  return (id >= 0) ? &wm_prop_table[id] : NULL;
+}
+
 static uint32_t manage_probe_mask_for_slot(const cookie_slot_t* slot) {
   if (!slot)
     return MANAGE_PROBE_NONE;
@@ -504,14 +1620,8 @@ static uint32_t manage_probe_mask_for_slot(const cookie_slot_t* slot) {
     case COOKIE_GET_GEOMETRY:
       return MANAGE_PROBE_GEOMETRY;
     case COOKIE_GET_PROPERTY: {
-      xcb_atom_t atom = (xcb_atom_t)(slot->data & 0xFFFFFFFFu);
-      if (atom == atoms._NET_WM_WINDOW_TYPE)
-        return MANAGE_PROBE_WINDOW_TYPE;
-      if (atom == atoms.WM_TRANSIENT_FOR)
-        return MANAGE_PROBE_TRANSIENT_FOR;
-      if (atom == atoms.WM_HINTS)
-        return MANAGE_PROBE_WM_HINTS;
-      return MANAGE_PROBE_NONE;
+      const wm_prop_desc_t* desc = wm_prop_desc((xcb_atom_t)(slot->data & 0xFFFFFFFFu));
+      return desc ? desc->probe : MANAGE_PROBE_NONE;
     }
     default:
       return MANAGE_PROBE_NONE;
@@ -545,6 +1655,14 @@ void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_ge
     reply = NULL;
   }
 
+  if (slot->type == COOKIE_GET_PROPERTY)
+    wm_prop_fetch_settle(s, slot, reply != NULL);
+
+  if (slot->type == COOKIE_GET_PROPERTY_ICON_HEADER || slot->type == COOKIE_GET_PROPERTY_ICON_PIXELS) {
+    wm_handle_icon_reply(s, slot, (const xcb_get_property_reply_t*)reply);
+    return;
+  }
+
   if (slot->client == HANDLE_INVALID) {
     if ((slot->type == COOKIE_GET_WINDOW_ATTRIBUTES || slot->type == COOKIE_CHECK_MANAGE_MAP_REQUEST) && reply) {
       xcb_get_window_attributes_reply_t* r = (xcb_get_window_attributes_reply_t*)reply;
@@ -589,6 +1707,10 @@ void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_ge
           if (server_get_client_by_window(s, win) == HANDLE_INVALID) {
             LOG_INFO("Adopting window %u (map_state %d)", win, r->map_state);
             client_manage_start(s, win);
+            // The classify cookie was pushed by wm_handle_map_request
+            client_cold_t* cold = is_map_request ? server_ccold(s, server_get_client_by_window(s, win)) : NULL;
+            if (cold)
+              cold->manage_timing.t[MANAGE_MARK_MAP_REQUEST] = slot->timestamp_ns;
           }
         }
       }
@@ -676,15 +1798,18 @@ void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_ge
       hot->server.h = r->height;
       cold->depth = r->depth;
       hot->original_border_width = r->border_width;
+      if (hot->state == STATE_NEW)
+        client_note_root(s, hot, r->root);
 
       // Treat 0x0 or tiny as uninitialized/invalid
       if (r->width < 50 || r->height < 20) {
         hot->server.w = 800;
         hot->server.h = 600;
-        xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(s->conn)).data;
+        xcb_screen_t* screen = xcb_screen_of(s->conn, client_screen(s, hot)->num);
         hot->server.x = (screen->width_in_pixels - 800) / 2;
         hot->server.y = (screen->height_in_pixels - 600) / 2;
       }
+      wm_client_update_monitor(s, hot);
 
       if (hot->state == STATE_NEW) {
         // Only adopt server geometry if we haven't received a ConfigureRequest
@@ -700,831 +1825,11 @@ void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_ge
       xcb_atom_t atom = (xcb_atom_t)(slot->data & 0xFFFFFFFFu);
       xcb_get_property_reply_t* r = (xcb_get_property_reply_t*)reply;
 
-      if (atom == atoms.WM_CLASS) {
-        parse_wm_class(cold, r);
-      }
-      else if (atom == atoms.WM_CLIENT_MACHINE) {
-        int len = 0;
-        char* str = prop_get_string(r, &len);
-        if (str) {
-          cold->wm_client_machine = arena_strndup(&cold->string_arena, str, (size_t)len);
-        }
-      }
-      else if (atom == atoms.WM_COMMAND) {
-        int len = 0;
-        char* str = prop_get_string(r, &len);
-        if (str && len > 0) {
-          size_t n = (size_t)len;
-          char* nul = memchr(str, '\0', n);
-          size_t cmd_len = nul ? (size_t)(nul - str) : n;
-          if (cmd_len > 0) {
-            cold->wm_command = arena_strndup(&cold->string_arena, str, cmd_len);
-          }
-        }
-      }
-      else if (atom == atoms.WM_COLORMAP_WINDOWS) {
-        if (!prop_is_empty(r) && r->format == 32 && r->type == XCB_ATOM_WINDOW) {
-          int bytes = xcb_get_property_value_length(r);
-          if (bytes >= 4) {
-            uint32_t count = (uint32_t)(bytes / (int)sizeof(xcb_window_t));
-            client_set_colormap_windows(cold, (xcb_window_t*)xcb_get_property_value(r), count);
-          }
-          else {
-            client_set_colormap_windows(cold, NULL, 0);
-          }
-        }
-        else {
-          client_set_colormap_windows(cold, NULL, 0);
-        }
-        if (s->focused_client == slot->client) {
-          wm_install_client_colormap(s, hot);
-        }
-      }
-      else if (atom == atoms._NET_WM_NAME || atom == atoms._NET_WM_ICON_NAME) {
-        parse_net_wm_name_like(s, slot->client, hot, cold, atom, r);
+      const wm_prop_desc_t* desc = wm_prop_desc(atom);
+      if (!desc || !desc->reply || prop_reply_unchanged(cold, desc->cache, r))
         break;
-      }
-      else if (atom == atoms.WM_NAME) {
-        if (prop_is_empty(r) && !cold->has_net_wm_name) {
-          cold->base_title = arena_strndup(&cold->string_arena, "", 0);
-          wm_client_refresh_title(s, slot->client);
-          changed = true;
-        }
-        else {
-          int len = 0;
-          char* str = prop_get_string(r, &len);
-          if (str && !cold->has_net_wm_name) {
-            size_t max = clamp_prop_len(len, MAX_TITLE_BYTES);
-            size_t trimmed_len = string_len_until_nul(str, max);
-            if (!cold->base_title || strlen(cold->base_title) != trimmed_len || strncmp(cold->base_title, str, trimmed_len) != 0) {
-              cold->base_title = arena_strndup(&cold->string_arena, str, trimmed_len);
-              wm_client_refresh_title(s, slot->client);
-              changed = true;
-            }
-          }
-        }
-      }
-      else if (atom == atoms.WM_ICON_NAME) {
-        if (prop_is_empty(r) && !cold->has_net_wm_icon_name) {
-          cold->base_icon_name = arena_strndup(&cold->string_arena, "", 0);
-          wm_client_refresh_title(s, slot->client);
-          changed = true;
-        }
-        else {
-          int len = 0;
-          char* str = prop_get_string(r, &len);
-          if (str && !cold->has_net_wm_icon_name) {
-            size_t max = clamp_prop_len(len, MAX_TITLE_BYTES);
-            size_t trimmed_len = string_len_until_nul(str, max);
-            if (!cold->base_icon_name || strlen(cold->base_icon_name) != trimmed_len || strncmp(cold->base_icon_name, str, trimmed_len) != 0) {
-              cold->base_icon_name = arena_strndup(&cold->string_arena, str, trimmed_len);
-              wm_client_refresh_title(s, slot->client);
-              changed = true;
-            }
-          }
-        }
-      }
-      else if (atom == atoms._MOTIF_WM_HINTS) {
-        if (client_apply_motif_hints(s, slot->client, r)) {
-          if (client_apply_decoration_hints(hot, cold))
-            changed = true;
-        }
-      }
-      else if (atom == atoms._GTK_FRAME_EXTENTS || atom == atoms._KDE_NET_WM_FRAME_STRUT) {
-        if (client_apply_gtk_frame_extents(s, slot->client, r)) {
-          hot->dirty |= DIRTY_GEOM;
-          if (client_apply_decoration_hints(hot, cold))
-            changed = true;
-        }
-      }
-      else if (atom == atoms._NET_WM_STATE) {
-        if (prop_is_empty(r)) {
-          client_state_set_t set = {0};
-          wm_client_apply_state_set(s, slot->client, &set);
-        }
-        else {
-          int num_states = 0;
-          xcb_atom_t* states = (xcb_atom_t*)prop_get_u32_array(r, 1, &num_states);
-          if (states) {
-            client_state_set_t set = {0};
-            for (int i = 0; i < num_states; i++) {
-              xcb_atom_t state = states[i];
-              if (state == atoms._NET_WM_STATE_FULLSCREEN) {
-                set.fullscreen = true;
-              }
-              else if (state == atoms._NET_WM_STATE_ABOVE) {
-                set.above = true;
-              }
-              else if (state == atoms._NET_WM_STATE_BELOW) {
-                set.below = true;
-              }
-              else if (state == atoms._NET_WM_STATE_STICKY) {
-                set.sticky = true;
-              }
-              else if (state == atoms._NET_WM_STATE_DEMANDS_ATTENTION) {
-                set.urgent = true;
-              }
-              else if (state == atoms._NET_WM_STATE_MAXIMIZED_HORZ) {
-                set.max_horz = true;
-              }
-              else if (state == atoms._NET_WM_STATE_MAXIMIZED_VERT) {
-                set.max_vert = true;
-              }
-              else if (state == atoms._NET_WM_STATE_MODAL) {
-                set.modal = true;
-              }
-              else if (state == atoms._NET_WM_STATE_SHADED) {
-                set.shaded = true;
-              }
-              else if (state == atoms._NET_WM_STATE_SKIP_TASKBAR) {
-                set.skip_taskbar = true;
-              }
-              else if (state == atoms._NET_WM_STATE_SKIP_PAGER) {
-                set.skip_pager = true;
-              }
-            }
-            /*
-             * Do not import startup maximize hints during initial manage.
-             * Some clients persist maximized state in the property and this
-             * causes every new window to start maximized.
-             */
-            if (cold->manage_phase != MANAGE_DONE) {
-              set.max_horz = false;
-              set.max_vert = false;
-            }
-            wm_client_apply_state_set(s, slot->client, &set);
-          }
-        }
-      }
-      else if (atom == atoms.WM_NORMAL_HINTS) {
-        xcb_size_hints_t hints;
-
-        size_hints_t next_hints = {0};
-
-        uint32_t next_flags = 0;
-
-        bool valid = false;
-
-        if (prop_is_empty(r)) {
-          valid = true;
-        }
-        else if (xcb_get_property_value_length(r) >= (int)sizeof(xcb_size_hints_t) &&
-
-                 xcb_icccm_get_wm_size_hints_from_reply(&hints, r)) {
-          valid = true;
-
-          next_flags = hints.flags;
-
-          if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE) {
-            next_hints.min_w = hints.min_width;
-
-            next_hints.min_h = hints.min_height;
-          }
-
-          if (hints.flags & XCB_ICCCM_SIZE_HINT_P_MAX_SIZE) {
-            next_hints.max_w = hints.max_width;
-
-            next_hints.max_h = hints.max_height;
-          }
-
-          if (hints.flags & XCB_ICCCM_SIZE_HINT_P_RESIZE_INC) {
-            next_hints.inc_w = hints.width_inc;
-
-            next_hints.inc_h = hints.height_inc;
-          }
-
-          if (hints.flags & XCB_ICCCM_SIZE_HINT_BASE_SIZE) {
-            next_hints.base_w = hints.base_width;
-
-            next_hints.base_h = hints.base_height;
-          }
-
-          if (hints.flags & XCB_ICCCM_SIZE_HINT_P_ASPECT) {
-            next_hints.min_aspect_num = hints.min_aspect_num;
-
-            next_hints.min_aspect_den = hints.min_aspect_den;
-
-            next_hints.max_aspect_num = hints.max_aspect_num;
-
-            next_hints.max_aspect_den = hints.max_aspect_den;
-          }
-        }
-
-        if (valid) {
-          bool hints_changed = (cold->hints_flags != next_flags || memcmp(&cold->hints, &next_hints, sizeof(size_hints_t)) != 0);
-
-          if (hints_changed) {
-            cold->hints = next_hints;
-
-            cold->hints_flags = next_flags;
-
-            hot->dirty |= DIRTY_STATE;  // Allowed actions might change
-            bool is_panel = (hot->type == WINDOW_TYPE_DOCK || hot->type == WINDOW_TYPE_DESKTOP);
-
-            if (hot->state == STATE_NEW && cold->manage_phase != MANAGE_DONE) {
-              bool model_from_request = (hot->dirty & DIRTY_GEOM) != 0;
-              bool user_size = (next_flags & XCB_ICCCM_SIZE_HINT_US_SIZE);
-              bool prog_size = (next_flags & XCB_ICCCM_SIZE_HINT_P_SIZE);
-              if (user_size || prog_size) {
-                if (!model_from_request) {
-                  if (hints.width > 0 && (user_size || hints.width > 1))
-                    hot->desired.w = (uint16_t)hints.width;
-
-                  if (hints.height > 0 && (user_size || hints.height > 1))
-                    hot->desired.h = (uint16_t)hints.height;
-                }
-                else {
-                  if (hot->desired.w == 0 && hints.width > 0 && (user_size || hints.width > 1))
-                    hot->desired.w = (uint16_t)hints.width;
-
-                  if (hot->desired.h == 0 && hints.height > 0 && (user_size || hints.height > 1))
-                    hot->desired.h = (uint16_t)hints.height;
-                }
-              }
-
-              if (next_flags & XCB_ICCCM_SIZE_HINT_US_POSITION) {
-                if (!model_from_request) {
-                  hot->desired.x = (int16_t)hints.x;
-
-                  hot->desired.y = (int16_t)hints.y;
-                }
-              }
-
-              if (!is_panel) {
-                client_constrain_size(&cold->hints, cold->hints_flags, &hot->desired.w, &hot->desired.h);
-              }
-            }
-            else if (s->interaction_mode == INTERACTION_RESIZE && s->interaction_window == hot->frame) {
-              if (!is_panel) {
-                client_constrain_size(&cold->hints, cold->hints_flags, &hot->desired.w, &hot->desired.h);
-              }
-
-              hot->dirty |= DIRTY_GEOM;
-            }
-            else {
-              // Even if not resizing, if hints changed, we might need to
-              // re-constrain
-
-              uint16_t w = hot->desired.w;
-
-              uint16_t h_val = hot->desired.h;
-
-              if (!is_panel) {
-                client_constrain_size(&cold->hints, cold->hints_flags, &w, &h_val);
-              }
-
-              if (w != hot->desired.w || h_val != hot->desired.h) {
-                hot->desired.w = w;
-
-                hot->desired.h = h_val;
-
-                hot->dirty |= DIRTY_GEOM;
-              }
-            }
-          }
-        }
-      }
-      else if (atom == atoms.WM_TRANSIENT_FOR) {
-        if (xcb_get_property_value_length(r) >= 4) {
-          xcb_window_t transient_for_xid = *(xcb_window_t*)xcb_get_property_value(r);
-          cold->transient_for_xid = transient_for_xid;
-          hot->transient_for = server_get_client_by_window(s, transient_for_xid);
-
-          if (hot->transient_for != HANDLE_INVALID) {
-            if (check_transient_cycle(s, slot->client, hot->transient_for)) {
-              LOG_WARN("Ignoring transient_for cycle for client %u", hot->xid);
-              hot->transient_for = HANDLE_INVALID;
-            }
-          }
-        }
-        else {
-          cold->transient_for_xid = XCB_NONE;
-          if (hot->transient_for != HANDLE_INVALID) {
-            hot->transient_for = HANDLE_INVALID;
-          }
-        }
-
-        if (client_apply_default_type(s, hot, cold)) {
-          changed = true;
-        }
-      }
-      else if (atom == atoms._NET_WM_WINDOW_TYPE) {
-        if (xcb_get_property_value_length(r) > 0) {
-          uint8_t prev_type = hot->type;
-          xcb_atom_t* types = (xcb_atom_t*)xcb_get_property_value(r);
-          int num_types = xcb_get_property_value_length(r) / (int)sizeof(xcb_atom_t);
-
-          for (int i = 0; i < num_types; i++) {
-            if (types[i] == atoms._NET_WM_WINDOW_TYPE_DOCK) {
-              hot->type = WINDOW_TYPE_DOCK;
-              hot->base_layer = LAYER_DOCK;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_NOTIFICATION) {
-              hot->type = WINDOW_TYPE_NOTIFICATION;
-              hot->base_layer = LAYER_OVERLAY;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_DIALOG) {
-              hot->type = WINDOW_TYPE_DIALOG;
-              hot->base_layer = LAYER_NORMAL;
-              hot->placement = PLACEMENT_CENTER;
-              hot->type_from_net = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_DESKTOP) {
-              hot->type = WINDOW_TYPE_DESKTOP;
-              hot->base_layer = LAYER_DESKTOP;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              hot->skip_taskbar = true;
-              hot->skip_pager = true;
-              if (!hot->net_wm_desktop_seen) {
-                hot->sticky = true;
-                hot->desktop = -1;
-              }
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_SPLASH) {
-              hot->type = WINDOW_TYPE_SPLASH;
-              hot->base_layer = LAYER_ABOVE;
-              hot->type_from_net = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_TOOLBAR) {
-              hot->type = WINDOW_TYPE_TOOLBAR;
-              hot->base_layer = LAYER_NORMAL;
-              hot->placement = PLACEMENT_DEFAULT;
-              hot->type_from_net = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_UTILITY) {
-              hot->type = WINDOW_TYPE_UTILITY;
-              hot->base_layer = LAYER_NORMAL;
-              hot->placement = PLACEMENT_DEFAULT;
-              hot->type_from_net = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_MENU) {
-              hot->type = WINDOW_TYPE_MENU;
-              hot->base_layer = LAYER_OVERLAY;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_DROPDOWN_MENU) {
-              hot->type = WINDOW_TYPE_DROPDOWN_MENU;
-              hot->base_layer = LAYER_OVERLAY;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
-                hot->manage_aborted = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_POPUP_MENU) {
-              hot->type = WINDOW_TYPE_POPUP_MENU;
-              hot->base_layer = LAYER_OVERLAY;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
-                hot->manage_aborted = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_TOOLTIP) {
-              hot->type = WINDOW_TYPE_TOOLTIP;
-              hot->base_layer = LAYER_OVERLAY;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
-                hot->manage_aborted = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_COMBO) {
-              hot->type = WINDOW_TYPE_COMBO;
-              hot->base_layer = LAYER_OVERLAY;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
-                hot->manage_aborted = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_DND) {
-              hot->type = WINDOW_TYPE_DND;
-              hot->base_layer = LAYER_OVERLAY;
-              hot->flags |= CLIENT_FLAG_UNDECORATED;
-              hot->type_from_net = true;
-              if (hot->state == STATE_NEW && cold->manage_phase == MANAGE_PHASE1)
-                hot->manage_aborted = true;
-              break;
-            }
-            else if (types[i] == atoms._NET_WM_WINDOW_TYPE_NORMAL) {
-              hot->type = WINDOW_TYPE_NORMAL;
-              hot->base_layer = LAYER_NORMAL;
-              hot->placement = PLACEMENT_DEFAULT;
-              hot->type_from_net = true;
-              break;
-            }
-          }
-
-          if (client_apply_decoration_hints(hot, cold)) {
-            changed = true;
-          }
-
-          if (hot->layer != LAYER_FULLSCREEN) {
-            uint8_t prev_layer = hot->layer;
-            hot->layer = client_layer_from_state(hot);
-            if (hot->layer != prev_layer) {
-              hot->dirty |= DIRTY_STATE | DIRTY_STACK;
-            }
-          }
-
-          if (hot->type != prev_type) {
-            s->root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
-          }
-        }
-      }
-      else if (atom == atoms.WM_PROTOCOLS) {
-        protocol_flags_t prev_protocols = (protocol_flags_t)cold->protocols;
-        cold->protocols = 0;
-        cold->sync_enabled = false;
-        int num_protocols = 0;
-        xcb_atom_t* protocols = (xcb_atom_t*)prop_get_u32_array(r, 1, &num_protocols);
-        if (!protocols && r && r->format == 32 && r->value_len > 0) {
-          protocols = (xcb_atom_t*)xcb_get_property_value(r);
-          num_protocols = (int)r->value_len;
-        }
-        if (protocols) {
-          for (int i = 0; i < num_protocols; i++) {
-            if (protocols[i] == atoms.WM_DELETE_WINDOW) {
-              cold->protocols |= PROTOCOL_DELETE_WINDOW;
-            }
-            else if (protocols[i] == atoms.WM_TAKE_FOCUS) {
-              cold->protocols |= PROTOCOL_TAKE_FOCUS;
-            }
-            else if (protocols[i] == atoms._NET_WM_SYNC_REQUEST) {
-              cold->protocols |= PROTOCOL_SYNC_REQUEST;
-              cold->sync_enabled = true;
-            }
-            else if (protocols[i] == atoms._NET_WM_PING) {
-              cold->protocols |= PROTOCOL_PING;
-            }
-          }
-        }
-
-        bool had_take_focus = (prev_protocols & PROTOCOL_TAKE_FOCUS) != 0;
-        bool has_take_focus = (cold->protocols & PROTOCOL_TAKE_FOCUS) != 0;
-        if (!had_take_focus && has_take_focus) {
-          wm_focus_recommit_if_current(s, slot->client);
-        }
-      }
-      else if (atom == atoms._NET_WM_DESKTOP) {
-        uint32_t* val = prop_get_u32_array(r, 1, NULL);
-        if (val) {
-          hot->net_wm_desktop_seen = true;
-          bool sticky = (*val == 0xFFFFFFFFu);
-          uint32_t desk = *val;
-          if (!sticky && desk >= s->desktop_count)
-            desk = s->current_desktop;
-          int32_t new_desk = sticky ? -1 : (int32_t)desk;
-
-          if (hot->sticky == sticky && hot->desktop == new_desk) {
-            // No change
-          }
-          else if (cold->manage_phase == MANAGE_DONE) {
-            wm_client_move_to_workspace(s, slot->client, sticky ? 0xFFFFFFFFu : desk, false);
-          }
-          else {
-            hot->sticky = sticky;
-            hot->desktop = new_desk;
-          }
-        }
-      }
-      else if (atom == atoms._NET_WM_STRUT || atom == atoms._NET_WM_STRUT_PARTIAL) {
-        int len = r ? xcb_get_property_value_length(r) : 0;
-        bool is_partial = (atom == atoms._NET_WM_STRUT_PARTIAL);
-        strut_t* target = is_partial ? &cold->strut_partial : &cold->strut_full;
-        bool* active = is_partial ? &cold->strut_partial_active : &cold->strut_full_active;
-
-        strut_t prev_effective = cold->strut;
-
-        if (r && r->type == XCB_ATOM_CARDINAL && r->format == 32 && len >= 16) {
-          uint32_t* val = (uint32_t*)xcb_get_property_value(r);
-          memset(target, 0, sizeof(*target));
-          target->left = val[0];
-          target->right = val[1];
-          target->top = val[2];
-          target->bottom = val[3];
-
-          if (is_partial && len >= 48) {
-            target->left_start_y = val[4];
-            target->left_end_y = val[5];
-            target->right_start_y = val[6];
-            target->right_end_y = val[7];
-            target->top_start_x = val[8];
-            target->top_end_x = val[9];
-            target->bottom_start_x = val[10];
-            target->bottom_end_x = val[11];
-            sanitize_strut_range(&target->left_start_y, &target->left_end_y);
-            sanitize_strut_range(&target->right_start_y, &target->right_end_y);
-            sanitize_strut_range(&target->top_start_x, &target->top_end_x);
-            sanitize_strut_range(&target->bottom_start_x, &target->bottom_end_x);
-          }
-          *active = true;
-        }
-        else {
-          memset(target, 0, sizeof(*target));
-          *active = false;
-        }
-
-        // Waterfall: If PARTIAL failed (or empty), try legacy STRUT
-        if (is_partial && !*active) {
-          xcb_get_property_cookie_t ck = xcb_get_property(s->conn, 0, hot->xid, atoms._NET_WM_STRUT, XCB_ATOM_CARDINAL, 0, 4);
-          if (ck.sequence != 0)
-            cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_GET_PROPERTY, slot->client, ((uint64_t)hot->xid << 32) | atoms._NET_WM_STRUT, s->txn_id, wm_handle_reply);
-        }
-
-        client_update_effective_strut(cold);
-
-        if (memcmp(&prev_effective, &cold->strut, sizeof(strut_t)) != 0) {
-#if HXM_TRACE_LOGS
-          static rl_t rl_strut = {0};
-          if (rl_allow(&rl_strut, monotonic_time_ns(), 1000000000)) {
-            TRACE_LOG("strut_reply xid=%u atom=%s changed active=%d top=%u", hot->xid, is_partial ? "_NET_WM_STRUT_PARTIAL" : "_NET_WM_STRUT", *active, cold->strut.top);
-          }
-#endif
-          s->workarea_dirty = true;
-          s->root_dirty |= ROOT_DIRTY_WORKAREA;
-        }
-      }
-      else if (atom == atoms.WM_HINTS) {
-        bool prev_can_focus = cold->can_focus;
-        if (prop_is_empty(r)) {
-          bool changed_any = (cold->can_focus != true || hot->initial_state != XCB_ICCCM_WM_STATE_NORMAL);
-          cold->can_focus = true;
-          hot->initial_state = XCB_ICCCM_WM_STATE_NORMAL;
-          if (hot->flags & CLIENT_FLAG_URGENT) {
-            hot->flags &= ~CLIENT_FLAG_URGENT;
-            hot->dirty |= DIRTY_STATE;
-            changed = true;
-          }
-          else if (changed_any) {
-            hot->dirty |= DIRTY_STATE;
-            changed = true;
-          }
-        }
-        else {
-          xcb_icccm_wm_hints_t hints;
-          if (xcb_icccm_get_wm_hints_from_reply(&hints, r)) {
-            bool next_can_focus = true;
-            if (hints.flags & XCB_ICCCM_WM_HINT_INPUT) {
-              next_can_focus = (bool)(hints.input);
-            }
-
-            uint8_t next_initial_state = hot->initial_state;
-            if (hints.flags & XCB_ICCCM_WM_HINT_STATE) {
-              next_initial_state = (uint8_t)hints.initial_state;
-            }
-
-            bool next_urgent = (hints.flags & XCB_ICCCM_WM_HINT_X_URGENCY) != 0;
-            bool was_urgent = (hot->flags & CLIENT_FLAG_URGENT) != 0;
-
-            if (cold->can_focus != next_can_focus || hot->initial_state != next_initial_state || was_urgent != next_urgent) {
-              cold->can_focus = next_can_focus;
-              hot->initial_state = next_initial_state;
-              if (next_urgent) {
-                hot->flags |= CLIENT_FLAG_URGENT;
-              }
-              else {
-                hot->flags &= ~CLIENT_FLAG_URGENT;
-              }
-              hot->dirty |= DIRTY_STATE;
-              changed = true;
-            }
-          }
-        }
-
-        if (!prev_can_focus && cold->can_focus) {
-          wm_focus_recommit_if_current(s, slot->client);
-        }
-      }
-      else if (atom == atoms._NET_WM_ICON) {
-        if (!prop_is_empty(r)) {
-          const uint32_t icon_target_sizes[] = {16, 24, 32, 48, 64};
-          const uint32_t icon_dim_max = 4096;
-          const uint64_t icon_pixels_max = 1024ull * 1024ull;
-          const uint64_t icon_total_pixels_max = 4ull * 1024ull * 1024ull;
-          const uint32_t icon_count_max = 32;
-
-          int total_words = 0;
-          uint32_t* val = prop_get_u32_array(r, 2, &total_words);
-          if (!val)
-            break;
-
-          uint32_t best_w = 0;
-          uint32_t best_h = 0;
-          uint64_t best_area = 0;
-          uint32_t* best_data = NULL;
-          uint32_t best_diff = UINT32_MAX;
-
-          int i = 0;
-          uint32_t icons_seen = 0;
-          uint64_t total_pixels = 0;
-          while (i + 2 <= total_words) {
-            if (icons_seen >= icon_count_max)
-              break;
-
-            uint32_t w = val[i];
-            uint32_t h = val[i + 1];
-            if (w == 0 || h == 0)
-              break;
-
-            uint64_t pixels = (uint64_t)w * (uint64_t)h;
-            if (pixels > (uint64_t)(total_words - i - 2))
-              break;  // truncated, stop
-            if (pixels > icon_pixels_max) {
-              i += (int)(2 + pixels);
-              continue;
-            }  // oversize, skip
-            if (total_pixels + pixels > icon_total_pixels_max)
-              break;
-
-            if (w <= icon_dim_max && h <= icon_dim_max) {
-              uint32_t diff = UINT32_MAX;
-              for (size_t t = 0; t < sizeof(icon_target_sizes) / sizeof(icon_target_sizes[0]); t++) {
-                int dw = abs((int)w - (int)icon_target_sizes[t]);
-                int dh = abs((int)h - (int)icon_target_sizes[t]);
-                uint32_t td = (uint32_t)(dw + dh);
-                if (td < diff)
-                  diff = td;
-              }
-
-              if (diff < best_diff || (diff == best_diff && pixels > best_area)) {
-                best_diff = diff;
-                best_w = w;
-                best_h = h;
-                best_area = pixels;
-                best_data = &val[i + 2];
-              }
-            }
-
-            i += (int)(2 + pixels);
-            icons_seen++;
-            total_pixels += pixels;
-          }
-
-          if (best_data) {
-            if (cold->icon_surface)
-              cairo_surface_destroy(cold->icon_surface);
-            cold->icon_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)best_w, (int)best_h);
-
-            unsigned char* dest = cairo_image_surface_get_data(cold->icon_surface);
-            int stride = cairo_image_surface_get_stride(cold->icon_surface);
-            cairo_surface_flush(cold->icon_surface);
-
-            for (int y = 0; y < (int)best_h; y++) {
-              uint32_t* row = (uint32_t*)(dest + y * stride);
-              for (int x = 0; x < (int)best_w; x++) {
-                uint32_t pixel = best_data[y * (int)best_w + x];
-                uint8_t a = (uint8_t)(pixel >> 24);
-                uint8_t r = (uint8_t)(pixel >> 16);
-                uint8_t g = (uint8_t)(pixel >> 8);
-                uint8_t b = (uint8_t)pixel;
-                if (a == 0) {
-                  r = 0;
-                  g = 0;
-                  b = 0;
-                }
-                else if (a < 255) {
-                  // Cairo expects premultiplied ARGB32
-                  r = (uint8_t)((r * a + 127) / 255);
-                  g = (uint8_t)((g * a + 127) / 255);
-                  b = (uint8_t)((b * a + 127) / 255);
-                }
-                row[x] = ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
-              }
-            }
-
-            cairo_surface_mark_dirty(cold->icon_surface);
-            changed = true;
-          }
-          else if (cold->icon_surface) {
-            cairo_surface_destroy(cold->icon_surface);
-            cold->icon_surface = NULL;
-            changed = true;
-          }
-        }
-        else if (cold->icon_surface) {
-          cairo_surface_destroy(cold->icon_surface);
-          cold->icon_surface = NULL;
-          changed = true;
-        }
-      }
-      else if (atom == atoms._NET_WM_PID) {
-        if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
-          uint32_t val = *(uint32_t*)xcb_get_property_value(r);
-          cold->pid = val;
-        }
-      }
-      else if (atom == atoms._NET_WM_USER_TIME) {
-        if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
-          uint32_t val = *(uint32_t*)xcb_get_property_value(r);
-          cold->user_time = val;
-        }
-      }
-      else if (atom == atoms._NET_WM_USER_TIME_WINDOW) {
-        if (r && r->type == XCB_ATOM_WINDOW && xcb_get_property_value_length(r) >= 4) {
-          xcb_window_t w = *(xcb_window_t*)xcb_get_property_value(r);
-          cold->user_time_window = w;
-
-          if (w != hot->xid) {
-            uint32_t values[] = {XCB_EVENT_MASK_PROPERTY_CHANGE};
-            xcb_change_window_attributes(s->conn, w, XCB_CW_EVENT_MASK, values);
-          }
-        }
-      }
-      else if (atom == atoms._NET_WM_SYNC_REQUEST_COUNTER) {
-        if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
-          xcb_sync_counter_t counter = *(xcb_sync_counter_t*)xcb_get_property_value(r);
-          cold->sync_counter = counter;
-          cold->sync_value = 0;
-          if (counter != XCB_NONE) {
-            xcb_sync_query_counter_cookie_t ck = xcb_sync_query_counter(s->conn, counter);
-            if (ck.sequence != 0)
-              cookie_jar_push(&s->cookie_jar, ck.sequence, COOKIE_SYNC_QUERY_COUNTER, slot->client, (uintptr_t)counter, s->txn_id, wm_handle_reply);
-          }
-        }
-        else {
-          cold->sync_counter = 0;
-          cold->sync_value = 0;
-        }
-      }
-      else if (atom == atoms._NET_WM_WINDOW_OPACITY) {
-        if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
-          uint32_t val = *(uint32_t*)xcb_get_property_value(r);
-          if (!cold->window_opacity_valid || cold->window_opacity != val) {
-            cold->window_opacity = val;
-            cold->window_opacity_valid = true;
-            if (hot->frame != XCB_NONE) {
-              xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->frame, atoms._NET_WM_WINDOW_OPACITY, XCB_ATOM_CARDINAL, 32, 1, &val);
-            }
-          }
-        }
-        else {
-          if (cold->window_opacity_valid) {
-            cold->window_opacity_valid = false;
-            if (hot->frame != XCB_NONE) {
-              xcb_delete_property(s->conn, hot->frame, atoms._NET_WM_WINDOW_OPACITY);
-            }
-          }
-        }
-      }
-      else if (atom == atoms._NET_WM_BYPASS_COMPOSITOR) {
-        if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 4) {
-          uint32_t val = *(uint32_t*)xcb_get_property_value(r);
-          if (val == 0) {
-            if (cold->bypass_compositor_valid) {
-              cold->bypass_compositor_valid = false;
-              cold->bypass_compositor = 0;
-              if (hot->frame != XCB_NONE) {
-                xcb_delete_property(s->conn, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR);
-              }
-            }
-          }
-          else {
-            if (!cold->bypass_compositor_valid || cold->bypass_compositor != val) {
-              cold->bypass_compositor = val;
-              cold->bypass_compositor_valid = true;
-              if (hot->frame != XCB_NONE) {
-                xcb_change_property(s->conn, XCB_PROP_MODE_REPLACE, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR, XCB_ATOM_CARDINAL, 32, 1, &val);
-              }
-            }
-          }
-        }
-        else if (cold->bypass_compositor_valid) {
-          cold->bypass_compositor_valid = false;
-          cold->bypass_compositor = 0;
-          if (hot->frame != XCB_NONE) {
-            xcb_delete_property(s->conn, hot->frame, atoms._NET_WM_BYPASS_COMPOSITOR);
-          }
-        }
-      }
-      else if (atom == atoms._NET_WM_ICON_GEOMETRY) {
-        if (prop_is_cardinal(r) && xcb_get_property_value_length(r) >= 16) {
-          uint32_t* val = (uint32_t*)xcb_get_property_value(r);
-          rect_t next_geom = {(int16_t)val[0], (int16_t)val[1], (uint16_t)val[2], (uint16_t)val[3]};
-          if (!cold->icon_geometry_valid || memcmp(&cold->icon_geometry, &next_geom, sizeof(rect_t)) != 0) {
-            cold->icon_geometry = next_geom;
-            cold->icon_geometry_valid = true;
-          }
-        }
-        else {
-          cold->icon_geometry_valid = false;
-        }
-      }
+      if (desc->reply(s, slot, hot, cold, r))
+        changed = true;
 
       break;
     }
@@ -1548,7 +1853,7 @@ void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_ge
         hot->snap_edge = SNAP_NONE;
         hot->snap_preview_active = false;
         hot->snap_preview_edge = SNAP_NONE;
-        hot->dirty |= DIRTY_GEOM;
+        server_mark_dirty(s, hot, DIRTY_GEOM);
       }
 
       wm_start_interaction(s, slot->client, hot, is_move, resize_dir, root_x, root_y, 0, is_keyboard);
@@ -1572,17 +1877,21 @@ void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_ge
   }
 
   if (changed)
-    hot->dirty |= DIRTY_FRAME_STYLE;
+    server_mark_dirty(s, hot, DIRTY_FRAME_STYLE);
 
 done_one:
   if (hot->state != STATE_NEW)
     return;
   if (cold->manage_phase != MANAGE_PHASE1)
     return;
+  manage_timing_probe(&cold->manage_timing, (uint8_t)slot->type, (uint32_t)(slot->data & 0xFFFFFFFFu), monotonic_time_ns() - slot->timestamp_ns);
   if (hot->manage_aborted) {
     client_abort_manage(s, slot->client);
     return;
   }
+  // Grouped probes are promoted together by wm_handle_manage_complete()
+  if (slot->group != 0)
+    return;
   if (hot->probe_required_mask == MANAGE_PROBE_NONE)
     return;
 
@@ -1590,5 +1899,28 @@ done_one:
   if ((hot->probe_received_mask & hot->probe_required_mask) != hot->probe_required_mask)
     return;
 
-  hot->state = STATE_READY;
+  client_set_state(s, hot, STATE_READY);
+  manage_timing_mark(&cold->manage_timing, MANAGE_MARK_READY, monotonic_time_ns());
+  server_queue_client(s, hot);
+}
+
+void wm_handle_manage_complete(server_t* s, uint64_t txn_id, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return;
+  if (hot->state != STATE_NEW || cold->manage_phase != MANAGE_PHASE1)
+    return;
+
+  if (hot->manage_aborted) {
+    client_abort_manage(s, h);
+    return;
+  }
+
+  TRACE_LOG("manage probes complete h=%lx txn=%lu", h, txn_id);
+  (void)txn_id;
+  hot->probe_received_mask = hot->probe_required_mask;
+  client_set_state(s, hot, STATE_READY);
+  manage_timing_mark(&cold->manage_timing, MANAGE_MARK_READY, monotonic_time_ns());
+  server_queue_client(s, hot);
 }
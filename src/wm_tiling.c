@@ -0,0 +1,274 @@
+/* src/wm_tiling.c
+ * Tiling layouts on top of the tiling engine (see tiling.h).
+ *
+ * One tile tree per desktop and monitor of each screen, desktop-major like
+ * the workarea cache, laid out over that monitor's workarea on that desktop. A client is
+ * tiled while it is a mapped, resizable, normal top-level window in the
+ * normal layer on one desktop, not maximized or snapped, and has not been
+ * floated by hand; the tiling key actions and any move or resize drag float
+ * it.
+ *
+ * Membership is re-filed in the commit phase, for the queued clients only:
+ * everything that can change it (map, iconify, desktop, layer, state) queues
+ * the client. Each tree then reports just the tiles that changed, which
+ * become desired geometry and go out with the same tick's per-client
+ * commits, as one batch.
+ *
+ * Off (tiling = float, and no desktop switched on by key) this costs one
+ * branch per flush.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "client.h"
+#include "event.h"
+#include "hxm.h"
+#include "tiling.h"
+#include "wm.h"
+#include "wm_internal.h"
+
+#define TILING_RESIZE_STEP 50
+
+static tile_mode_t wm_tiling_config_mode(const server_t* s) {
+  return (s->config.tiling_layout < TILE_MODE_COUNT) ? (tile_mode_t)s->config.tiling_layout : TILE_FLOAT;
+}
+
+static void wm_tiling_update_on(server_t* s, screen_t* scr) {
+  bool on = wm_tiling_config_mode(s) != TILE_FLOAT;
+  size_t count = (size_t)scr->tiling_desktops * scr->tiling_monitors;
+  for (size_t i = 0; !on && scr->tiling && i < count; i++)
+    on = scr->tiling[i].mode != TILE_FLOAT;
+  // Clients were not filed while off
+  if (on && !scr->tiling_on)
+    scr->tiling_rebuild = true;
+  scr->tiling_on = on;
+}
+
+static void wm_tiling_destroy_screen(server_t* s, screen_t* scr) {
+  size_t count = (size_t)scr->tiling_desktops * scr->tiling_monitors;
+  for (size_t i = 0; scr->tiling && i < count; i++)
+    tile_tree_destroy(&scr->tiling[i]);
+  free(scr->tiling);
+  scr->tiling = NULL;
+  scr->tiling_desktops = 0;
+  scr->tiling_monitors = 0;
+
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    client_hot_t* hot = server_chot(s, s->active_clients.items[i]);
+    if (hot && client_screen(s, hot) == scr)
+      hot->tile_tree = 0;
+  }
+}
+
+void wm_tiling_destroy(server_t* s) {
+  for (uint32_t i = 0; i < HXM_MAX_SCREENS; i++)
+    wm_tiling_destroy_screen(s, &s->screens[i]);
+}
+
+/* Trees for the current desktop and monitor counts; a change re-files everyone */
+static bool wm_tiling_ensure(server_t* s, screen_t* scr) {
+  uint32_t desktops = scr->desktop_count ? scr->desktop_count : 1u;
+  uint32_t monitors = scr->monitor_count ? scr->monitor_count : 1u;
+  if (scr->tiling && scr->tiling_desktops == desktops && scr->tiling_monitors == monitors)
+    return true;
+
+  // Keep the layouts picked by key on the desktops that still exist
+  tile_mode_t keep[64];
+  uint32_t kept = (scr->tiling && scr->tiling_desktops < 64u) ? scr->tiling_desktops : 0u;
+  for (uint32_t d = 0; d < kept; d++)
+    keep[d] = scr->tiling[(size_t)d * scr->tiling_monitors].mode;
+
+  wm_tiling_destroy_screen(s, scr);
+  tile_tree_t* trees = calloc((size_t)desktops * monitors, sizeof(*trees));
+  if (!trees) {
+    LOG_WARN("tiling: out of memory for %u desktops x %u monitors", desktops, monitors);
+    return false;
+  }
+  for (uint32_t d = 0; d < desktops; d++) {
+    for (uint32_t m = 0; m < monitors; m++) {
+      tile_tree_t* t = &trees[(size_t)d * monitors + m];
+      tile_tree_init(t, (d < kept) ? keep[d] : wm_tiling_config_mode(s));
+      tile_tree_set_master(t, (uint16_t)(s->config.tiling_master_percent * 10u));
+    }
+  }
+  scr->tiling = trees;
+  scr->tiling_desktops = desktops;
+  scr->tiling_monitors = monitors;
+  scr->tiling_rebuild = true;
+  return true;
+}
+
+/* 1 + the tree h belongs in, 0 if it floats */
+static uint16_t wm_tiling_want(server_t* s, const screen_t* scr, client_hot_t* hot, const client_cold_t* cold) {
+  if (hot->tile_float || hot->state != STATE_MAPPED || hot->override_redirect || hot->layer != LAYER_NORMAL ||
+      hot->type != WINDOW_TYPE_NORMAL || hot->transient_for != HANDLE_INVALID || hot->sticky || hot->desktop < 0 ||
+      hot->maximized_horz || hot->maximized_vert || hot->snap_active || !client_can_resize(hot, cold))
+    return 0;
+  if ((uint32_t)hot->desktop >= scr->tiling_desktops)
+    return 0;
+  uint32_t m = wm_client_monitor(s, hot);
+  if (m >= scr->tiling_monitors)
+    m = 0;
+  size_t idx = (size_t)(uint32_t)hot->desktop * scr->tiling_monitors + m;
+  return (idx < UINT16_MAX) ? (uint16_t)(idx + 1u) : 0;
+}
+
+static void wm_tiling_file(server_t* s, screen_t* scr, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold || client_screen(s, hot) != scr)
+    return;
+  uint16_t want = wm_tiling_want(s, scr, hot, cold);
+  if (want == hot->tile_tree)
+    return;
+
+  if (hot->tile_tree)
+    tile_tree_remove(&scr->tiling[hot->tile_tree - 1], h);
+  hot->tile_tree = 0;
+  if (!want)
+    return;
+
+  // Tile next to the focused window when it is in the same tree
+  client_hot_t* focused = server_chot(s, s->focused_client);
+  handle_t near = (focused && focused->tile_tree == want) ? s->focused_client : HANDLE_INVALID;
+  if (tile_tree_insert(&scr->tiling[want - 1], h, near))
+    hot->tile_tree = want;
+}
+
+/* A tile is a frame rect; desired holds the client size at the frame origin */
+static void wm_tiling_apply(server_t* s, handle_t h, rect_t frame) {
+  client_hot_t* hot = server_chot(s, h);
+  client_cold_t* cold = server_ccold(s, h);
+  if (!hot || !cold)
+    return;
+
+  rect_t r = frame;
+  if (cold->gtk_frame_extents_set) {
+    r.x = (int16_t)(r.x + (int32_t)cold->gtk_extents.left);
+    r.y = (int16_t)(r.y + (int32_t)cold->gtk_extents.top);
+  }
+  else if (!(hot->flags & CLIENT_FLAG_UNDECORATED)) {
+    int32_t bw = s->config.theme.border_width;
+    int32_t w = (int32_t)frame.w - 2 * bw;
+    int32_t h_val = (int32_t)frame.h - (int32_t)s->config.theme.title_height - bw;
+    r.w = (uint16_t)((w > 1) ? w : 1);
+    r.h = (uint16_t)((h_val > 1) ? h_val : 1);
+  }
+
+  if (memcmp(&hot->desired, &r, sizeof(r)) == 0)
+    return;
+  hot->desired = r;
+  server_mark_dirty(s, hot, DIRTY_GEOM);
+}
+
+static void wm_tiling_flush_screen(server_t* s, screen_t* scr) {
+  if (!scr->tiling_on || !wm_tiling_ensure(s, scr))
+    return;
+
+  if (scr->tiling_rebuild) {
+    for (size_t i = 0; i < s->active_clients.length; i++)
+      wm_tiling_file(s, scr, s->active_clients.items[i]);
+    scr->tiling_rebuild = false;
+  }
+  else {
+    // Only queued clients can have changed membership; tiles queue more behind them
+    size_t queued = s->dirty_clients.length;
+    for (size_t i = 0; i < queued; i++)
+      wm_tiling_file(s, scr, s->dirty_clients.items[i]);
+  }
+
+  uint16_t gap = (uint16_t)s->config.tiling_gap_px;
+  for (uint32_t d = 0; d < scr->tiling_desktops; d++) {
+    for (uint32_t m = 0; m < scr->tiling_monitors; m++) {
+      tile_tree_t* t = &scr->tiling[(size_t)d * scr->tiling_monitors + m];
+      if (t->mode == TILE_FLOAT || tile_tree_count(t) == 0)
+        continue;
+      rect_t wa;
+      if (!wm_monitor_workarea(s, scr, d, m, &wa))
+        wa = scr->workarea;
+      tile_tree_set_area(t, wa, gap);
+
+      size_t n = 0;
+      const tile_result_t* out = tile_tree_layout(t, &n);
+      for (size_t i = 0; i < n; i++)
+        wm_tiling_apply(s, out[i].client, out[i].rect);
+    }
+  }
+}
+
+void wm_tiling_flush(server_t* s) {
+  for (uint32_t i = 0; i < server_screen_count(s); i++)
+    wm_tiling_flush_screen(s, &s->screens[i]);
+}
+
+void wm_tiling_remove(server_t* s, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  if (!hot || !hot->tile_tree)
+    return;
+  screen_t* scr = client_screen(s, hot);
+  if (scr->tiling && hot->tile_tree <= (size_t)scr->tiling_desktops * scr->tiling_monitors)
+    tile_tree_remove(&scr->tiling[hot->tile_tree - 1], h);
+  hot->tile_tree = 0;
+}
+
+void wm_tiling_reload(server_t* s) {
+  tile_mode_t mode = wm_tiling_config_mode(s);
+  for (uint32_t n = 0; n < server_screen_count(s); n++) {
+    screen_t* scr = &s->screens[n];
+    size_t count = (size_t)scr->tiling_desktops * scr->tiling_monitors;
+    for (size_t i = 0; scr->tiling && i < count; i++) {
+      tile_tree_set_mode(&scr->tiling[i], mode);
+      tile_tree_set_master(&scr->tiling[i], (uint16_t)(s->config.tiling_master_percent * 10u));
+    }
+    wm_tiling_update_on(s, scr);
+  }
+}
+
+void wm_tiling_refresh(server_t* s, handle_t h) {
+  client_hot_t* hot = server_chot(s, h);
+  if (!hot || !hot->tile_tree)
+    return;
+  screen_t* scr = client_screen(s, hot);
+  if (scr->tiling)
+    tile_tree_invalidate(&scr->tiling[hot->tile_tree - 1], h);
+}
+
+/* The focused window's screen, else the one the user is on */
+void wm_tiling_cycle_layout(server_t* s) {
+  client_hot_t* focused = server_chot(s, s->focused_client);
+  screen_t* scr = client_screen(s, focused);
+  if (!wm_tiling_ensure(s, scr))
+    return;
+  uint32_t d = (scr->current_desktop < scr->tiling_desktops) ? scr->current_desktop : 0u;
+  uint32_t m = focused ? wm_client_monitor(s, focused) : 0u;
+  if (m >= scr->tiling_monitors)
+    m = 0;
+
+  tile_tree_t* t = &scr->tiling[(size_t)d * scr->tiling_monitors + m];
+  tile_tree_set_mode(t, (tile_mode_t)((t->mode + 1) % TILE_MODE_COUNT));
+  LOG_INFO("tiling: screen %u desktop %u monitor %u layout %d", server_screen_index(s, scr), d, m, (int)t->mode);
+  wm_tiling_update_on(s, scr);
+}
+
+void wm_tiling_float(server_t* s, handle_t h, bool floating) {
+  client_hot_t* hot = server_chot(s, h);
+  if (!hot || hot->tile_float == floating)
+    return;
+  // Only a window a layout placed can be taken out of it
+  const screen_t* scr = client_screen(s, hot);
+  if (floating && (!hot->tile_tree || !scr->tiling || scr->tiling[hot->tile_tree - 1].mode == TILE_FLOAT))
+    return;
+  hot->tile_float = floating;
+  // Re-filed at the next flush
+  server_queue_client(s, hot);
+}
+
+void wm_tiling_resize(server_t* s, handle_t h, bool grow) {
+  client_hot_t* hot = server_chot(s, h);
+  if (!hot || !hot->tile_tree)
+    return;
+  screen_t* scr = client_screen(s, hot);
+  if (scr->tiling && tile_tree_resize(&scr->tiling[hot->tile_tree - 1], h, grow ? TILING_RESIZE_STEP : -TILING_RESIZE_STEP))
+    server_queue_client(s, hot);
+}
@@ -0,0 +1,293 @@
+/* x_reader.c - Optional X input thread
+ *
+ * The reader sleeps in poll on the X socket and kick_fd, drains libxcb into
+ * a private batch while folding adjacent runs, then publishes the batch
+ * into the ring. Only entries not yet published are ever folded, so the
+ * main thread never sees a slot change under it.
+ */
+
+#include "x_reader.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "hxm.h"
+
+static const char* const x_reader_class_names[X_READER_CLASS_COUNT] = {"motion", "configure", "property", "other"};
+
+static x_reader_class_t x_reader_classify(const xcb_generic_event_t* ev) {
+  switch (ev->response_type & ~0x80) {
+    case XCB_MOTION_NOTIFY:
+      return X_READER_CLASS_MOTION;
+    case XCB_CONFIGURE_NOTIFY:
+      return X_READER_CLASS_CONFIGURE;
+    case XCB_PROPERTY_NOTIFY:
+      return X_READER_CLASS_PROPERTY;
+    default:
+      return X_READER_CLASS_OTHER;
+  }
+}
+
+/*
+ * Fold ev into the newest unpublished batch entry when the tick buckets
+ * would keep only one of the two anyway. Returns true if ev was consumed.
+ */
+static bool x_reader_fold(x_reader_t* r, xcb_generic_event_t* ev, x_reader_class_t cls) {
+  if (cls == X_READER_CLASS_OTHER || r->batch_len == r->batch_pos)
+    return false;
+  xcb_generic_event_t** last = &r->batch[r->batch_len - 1u];
+  if (x_reader_classify(*last) != cls)
+    return false;
+
+  bool same = false;
+  switch (cls) {
+    case X_READER_CLASS_MOTION:
+      same = ((const xcb_motion_notify_event_t*)*last)->event == ((const xcb_motion_notify_event_t*)ev)->event;
+      break;
+    case X_READER_CLASS_CONFIGURE:
+      same = ((const xcb_configure_notify_event_t*)*last)->window == ((const xcb_configure_notify_event_t*)ev)->window;
+      break;
+    case X_READER_CLASS_PROPERTY: {
+      const xcb_property_notify_event_t* a = (const xcb_property_notify_event_t*)*last;
+      const xcb_property_notify_event_t* b = (const xcb_property_notify_event_t*)ev;
+      same = a->window == b->window && a->atom == b->atom;
+      break;
+    }
+    default:
+      break;
+  }
+  if (!same)
+    return false;
+
+  atomic_fetch_add_explicit(&r->folded[cls], 1, memory_order_relaxed);
+  if (cls == X_READER_CLASS_PROPERTY) {
+    // The property is re-read on handling; the first notify stands for both
+    free(ev);
+  }
+  else {
+    // The later motion or geometry supersedes the earlier one
+    free(*last);
+    *last = ev;
+  }
+  return true;
+}
+
+/* Move unpublished batch entries into the ring; returns how many moved */
+static uint32_t x_reader_publish(x_reader_t* r) {
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+  uint32_t n = 0;
+  while (r->batch_pos < r->batch_len && head - tail < X_READER_RING_CAP) {
+    r->ring[head & (X_READER_RING_CAP - 1u)] = r->batch[r->batch_pos++];
+    head++;
+    n++;
+  }
+  atomic_store_explicit(&r->head, head, memory_order_release);
+
+  if (r->batch_pos == r->batch_len)
+    r->batch_pos = r->batch_len = 0;
+  else
+    atomic_fetch_add_explicit(&r->ring_full, 1, memory_order_relaxed);
+  return n;
+}
+
+static void x_reader_notify(x_reader_t* r) {
+  uint64_t one = 1;
+  if (write(r->notify_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    LOG_WARN("x reader notify failed: %s", strerror(errno));
+}
+
+static void* x_reader_main(void* arg) {
+  x_reader_t* r = (x_reader_t*)arg;
+  bool more = false;
+
+  while (!atomic_load_explicit(&r->stop, memory_order_acquire)) {
+    x_reader_publish(r);
+    bool blocked = r->batch_len > 0;
+
+    bool socket = false;
+    if (blocked || !more) {
+      // While the ring is full only a kick (the main thread popped) helps
+      struct pollfd pfd[2] = {{.fd = r->kick_fd, .events = POLLIN}, {.fd = r->xcb_fd, .events = POLLIN}};
+      if (poll(pfd, blocked ? 1 : 2, -1) < 0) {
+        if (errno == EINTR)
+          continue;
+        LOG_ERROR("x reader poll failed: %s", strerror(errno));
+        break;
+      }
+      atomic_fetch_add_explicit(&r->wakeups, 1, memory_order_relaxed);
+      if (pfd[0].revents & POLLIN) {
+        uint64_t v;
+        if (read(r->kick_fd, &v, sizeof(v)) < 0 && errno != EAGAIN)
+          LOG_WARN("x reader kick read failed: %s", strerror(errno));
+      }
+      if (blocked)
+        continue;
+      socket = pfd[1].revents != 0;
+    }
+
+    more = false;
+    xcb_generic_event_t* ev = NULL;
+    while (r->batch_len < X_READER_BATCH && (ev = xcb_poll_for_event(r->conn))) {
+      x_reader_class_t cls = x_reader_classify(ev);
+      atomic_fetch_add_explicit(&r->seen[cls], 1, memory_order_relaxed);
+      if (!x_reader_fold(r, ev, cls))
+        r->batch[r->batch_len++] = ev;
+    }
+    more = r->batch_len == X_READER_BATCH;
+
+    if (xcb_connection_has_error(r->conn)) {
+      x_reader_publish(r);
+      x_reader_notify(r);
+      break;
+    }
+    // Socket traffic may have been replies only; the cookie jar wants them too
+    if (x_reader_publish(r) > 0 || socket)
+      x_reader_notify(r);
+  }
+  return NULL;
+}
+
+bool x_reader_start(x_reader_t* r, xcb_connection_t* conn) {
+  if (r->running)
+    return true;
+  if (!r->ring) {
+    r->ring = calloc(X_READER_RING_CAP, sizeof(*r->ring));
+    if (!r->ring) {
+      LOG_WARN("x reader ring allocation failed");
+      return false;
+    }
+  }
+
+  r->conn = conn;
+  r->xcb_fd = xcb_get_file_descriptor(conn);
+  r->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  r->kick_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (r->xcb_fd < 0 || r->notify_fd < 0 || r->kick_fd < 0) {
+    LOG_WARN("x reader setup failed: %s", strerror(errno));
+    if (r->notify_fd >= 0)
+      close(r->notify_fd);
+    if (r->kick_fd >= 0)
+      close(r->kick_fd);
+    r->notify_fd = r->kick_fd = -1;
+    return false;
+  }
+  atomic_store(&r->stop, false);
+
+  int err = pthread_create(&r->thread, NULL, x_reader_main, r);
+  if (err != 0) {
+    LOG_WARN("x reader thread failed: %s", strerror(err));
+    close(r->notify_fd);
+    close(r->kick_fd);
+    r->notify_fd = r->kick_fd = -1;
+    return false;
+  }
+  r->running = true;
+  return true;
+}
+
+void x_reader_kick(x_reader_t* r) {
+  if (!r->running)
+    return;
+  uint64_t one = 1;
+  if (write(r->kick_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    LOG_WARN("x reader kick failed: %s", strerror(errno));
+}
+
+void x_reader_stop(x_reader_t* r) {
+  if (!r->running)
+    return;
+  atomic_store_explicit(&r->stop, true, memory_order_release);
+  x_reader_kick(r);
+  pthread_join(r->thread, NULL);
+  close(r->notify_fd);
+  close(r->kick_fd);
+  r->notify_fd = r->kick_fd = -1;
+  r->running = false;
+}
+
+void x_reader_destroy(x_reader_t* r) {
+  x_reader_stop(r);
+  xcb_generic_event_t* ev;
+  while ((ev = x_reader_pop(r)))
+    free(ev);
+  free(r->ring);
+  memset(r, 0, sizeof(*r));
+  r->notify_fd = r->kick_fd = r->xcb_fd = -1;
+}
+
+xcb_generic_event_t* x_reader_pop(x_reader_t* r) {
+  if (!r->ring)
+    return NULL;
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+  if (tail != head) {
+    xcb_generic_event_t* ev = r->ring[tail & (X_READER_RING_CAP - 1u)];
+    atomic_store_explicit(&r->tail, tail + 1u, memory_order_release);
+    return ev;
+  }
+
+  // Stopped with a batch the ring had no room for: it follows the ring
+  if (!r->running && r->batch_pos < r->batch_len) {
+    xcb_generic_event_t* ev = r->batch[r->batch_pos++];
+    if (r->batch_pos == r->batch_len)
+      r->batch_pos = r->batch_len = 0;
+    return ev;
+  }
+  return NULL;
+}
+
+bool x_reader_pending(const x_reader_t* r) {
+  if (!r->ring)
+    return false;
+  if (atomic_load_explicit(&r->tail, memory_order_relaxed) != atomic_load_explicit(&r->head, memory_order_acquire))
+    return true;
+  return !r->running && r->batch_pos < r->batch_len;
+}
+
+void x_reader_take_notify(x_reader_t* r) {
+  uint64_t v;
+  if (r->notify_fd >= 0 && read(r->notify_fd, &v, sizeof(v)) < 0 && errno != EAGAIN)
+    LOG_WARN("x reader notify read failed: %s", strerror(errno));
+}
+
+size_t x_reader_format(const x_reader_t* r, char* buf, size_t cap) {
+  if (!buf || cap == 0)
+    return 0;
+  buf[0] = '\0';
+  if (!r || !r->ring)
+    return 0;
+
+  int n = snprintf(buf, cap, "x_reader: running=%d wakeups=%" PRIu64 " ring_full=%" PRIu64, r->running ? 1 : 0,
+                   (uint64_t)atomic_load_explicit(&r->wakeups, memory_order_relaxed), (uint64_t)atomic_load_explicit(&r->ring_full, memory_order_relaxed));
+  if (n <= 0)
+    return 0;
+  size_t len = (size_t)n < cap ? (size_t)n : cap - 1u;
+
+  // seen/folded per class
+  for (int c = 0; c <= X_READER_CLASS_COUNT; c++) {
+    if (c == X_READER_CLASS_COUNT)
+      n = snprintf(buf + len, cap - len, "\n");
+    else
+      n = snprintf(buf + len, cap - len, " %s=%" PRIu64 "/%" PRIu64, x_reader_class_names[c], (uint64_t)atomic_load_explicit(&r->seen[c], memory_order_relaxed),
+                   (uint64_t)atomic_load_explicit(&r->folded[c], memory_order_relaxed));
+    if (n <= 0)
+      break;
+    len += (size_t)n < cap - len ? (size_t)n : cap - len - 1u;
+  }
+  return len;
+}
+
+void x_reader_dump(const x_reader_t* r) {
+  char buf[512];
+  if (x_reader_format(r, buf, sizeof(buf)) > 0) {
+    fputs(buf, stdout);
+    fflush(stdout);
+  }
+}
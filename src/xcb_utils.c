@@ -15,128 +15,135 @@
 struct atoms atoms;
 static xcb_connection_t* g_conn_ref = NULL;
 
-static const char* atom_names[] = {
-    "WM_PROTOCOLS",
-    "WM_DELETE_WINDOW",
-    "WM_TAKE_FOCUS",
-    "_NET_WM_PING",
-    "WM_STATE",
-    "WM_CLASS",
-    "WM_CLIENT_MACHINE",
-    "WM_COLORMAP_WINDOWS",
-    "WM_COMMAND",
-    "WM_NAME",
-    "WM_ICON_NAME",
-    "WM_HINTS",
-    "WM_NORMAL_HINTS",
-    "WM_TRANSIENT_FOR",
-    "WM_CHANGE_STATE",
-    "_MOTIF_WM_HINTS",
-    "_GTK_FRAME_EXTENTS",
-    "_KDE_NET_WM_FRAME_STRUT",
-    "_NET_WM_SYNC_REQUEST",
-
-    "_NET_SUPPORTED",
-    "_NET_CLIENT_LIST",
-    "_NET_CLIENT_LIST_STACKING",
-    "_NET_ACTIVE_WINDOW",
-    "_NET_WM_NAME",
-    "_NET_WM_VISIBLE_NAME",
-    "_NET_WM_ICON_NAME",
-    "_NET_WM_VISIBLE_ICON_NAME",
-    "_NET_WM_STATE",
-    "_NET_WM_WINDOW_TYPE",
-    "_NET_WM_STRUT",
-    "_NET_WM_STRUT_PARTIAL",
-    "_NET_WORKAREA",
-    "_NET_WM_PID",
-    "_NET_WM_USER_TIME",
-    "_NET_WM_USER_TIME_WINDOW",
-    "_NET_WM_SYNC_REQUEST_COUNTER",
-    "_NET_WM_ICON_GEOMETRY",
-    "_NET_WM_STATE_FULLSCREEN",
-    "_NET_WM_STATE_ABOVE",
-    "_NET_WM_STATE_BELOW",
-    "_NET_WM_STATE_STICKY",
-    "_NET_WM_STATE_DEMANDS_ATTENTION",
-    "_NET_WM_STATE_HIDDEN",
-    "_NET_WM_STATE_MAXIMIZED_HORZ",
-    "_NET_WM_STATE_MAXIMIZED_VERT",
-    "_NET_WM_STATE_FOCUSED",
-    "_NET_WM_STATE_MODAL",
-    "_NET_WM_STATE_SHADED",
-    "_NET_WM_STATE_SKIP_TASKBAR",
-    "_NET_WM_STATE_SKIP_PAGER",
-    "_NET_WM_WINDOW_TYPE_DOCK",
-    "_NET_WM_WINDOW_TYPE_DIALOG",
-    "_NET_WM_WINDOW_TYPE_NOTIFICATION",
-    "_NET_WM_WINDOW_TYPE_NORMAL",
-    "_NET_WM_WINDOW_TYPE_DESKTOP",
-    "_NET_WM_WINDOW_TYPE_SPLASH",
-    "_NET_WM_WINDOW_TYPE_TOOLBAR",
-    "_NET_WM_WINDOW_TYPE_UTILITY",
-    "_NET_WM_WINDOW_TYPE_MENU",
-    "_NET_WM_WINDOW_TYPE_DROPDOWN_MENU",
-    "_NET_WM_WINDOW_TYPE_POPUP_MENU",
-    "_NET_WM_WINDOW_TYPE_TOOLTIP",
-    "_NET_WM_WINDOW_TYPE_COMBO",
-    "_NET_WM_WINDOW_TYPE_DND",
-    "_NET_SUPPORTING_WM_CHECK",
-    "_NET_DESKTOP_VIEWPORT",
-    "_NET_NUMBER_OF_DESKTOPS",
-    "_NET_CURRENT_DESKTOP",
-    "_NET_VIRTUAL_ROOTS",
-    "_NET_DESKTOP_NAMES",
-    "_NET_WM_DESKTOP",
-    "_NET_WM_ICON",
-    "_NET_CLOSE_WINDOW",
-    "_NET_DESKTOP_GEOMETRY",
-    "_NET_FRAME_EXTENTS",
-    "_NET_REQUEST_FRAME_EXTENTS",
-    "_NET_SHOWING_DESKTOP",
-    "_NET_WM_WINDOW_OPACITY",
-    "_NET_WM_ALLOWED_ACTIONS",
-    "_NET_WM_ACTION_MOVE",
-    "_NET_WM_ACTION_RESIZE",
-    "_NET_WM_ACTION_MINIMIZE",
-    "_NET_WM_ACTION_SHADE",
-    "_NET_WM_ACTION_STICK",
-    "_NET_WM_ACTION_MAXIMIZE_HORZ",
-    "_NET_WM_ACTION_MAXIMIZE_VERT",
-    "_NET_WM_ACTION_FULLSCREEN",
-    "_NET_WM_ACTION_CHANGE_DESKTOP",
-    "_NET_WM_ACTION_CLOSE",
-    "_NET_WM_ACTION_ABOVE",
-    "_NET_WM_ACTION_BELOW",
-    "_NET_WM_MOVERESIZE",
-    "_NET_MOVERESIZE_WINDOW",
-    "_NET_RESTACK_WINDOW",
-    "_NET_WM_FULLSCREEN_MONITORS",
-    "_NET_WM_FULL_PLACEMENT",
-    "UTF8_STRING",
-    "COMPOUND_TEXT",
-    "WM_S0",
-    "_NET_WM_BYPASS_COMPOSITOR",
+static const char* const atom_names[] = {
+#define HXM_ATOM_NAME(name) #name,
+    HXM_ATOMS(HXM_ATOM_NAME)
+#undef HXM_ATOM_NAME
 };
 
+_Static_assert(sizeof(atom_names) / sizeof(atom_names[0]) == HXM_ATOM_COUNT, "atom table out of sync with struct atoms");
+_Static_assert(HXM_ATOM_COUNT < UINT8_MAX, "atom_index slots are uint8_t");
+
+/*
+ * Atom value -> table index, for atom_name and atom_id. Atom values are only
+ * known after interning, so the perfect hash is found then: multiplicative
+ * hashing with the first multiplier that leaves no two atoms in one slot. If
+ * none does, lookups fall back to linear probing.
+ */
+#define ATOM_INDEX_BITS 9u
+#define ATOM_INDEX_SIZE (1u << ATOM_INDEX_BITS)
+#define ATOM_INDEX_EMPTY UINT8_MAX
+
+static uint8_t atom_index[ATOM_INDEX_SIZE];
+static uint32_t atom_index_mult;
+static bool atom_index_perfect;
+static bool atom_index_built;
+static struct atoms atom_index_values; /* atoms as of the last build */
+
+static inline uint32_t atom_index_slot(xcb_atom_t atom, uint32_t mult) {
+  return (uint32_t)(atom * mult) >> (32u - ATOM_INDEX_BITS);
+}
+
+static bool atom_index_try(uint32_t mult, bool probe) {
+  const xcb_atom_t* values = (const xcb_atom_t*)&atoms;
+  memset(atom_index, ATOM_INDEX_EMPTY, sizeof(atom_index));
+  for (size_t i = 0; i < HXM_ATOM_COUNT; i++) {
+    if (values[i] == XCB_ATOM_NONE)
+      continue;
+    uint32_t slot = atom_index_slot(values[i], mult);
+    while (atom_index[slot] != ATOM_INDEX_EMPTY) {
+      // Same value under two names (a failed intern): first one wins
+      if (values[atom_index[slot]] == values[i] || !probe)
+        break;
+      slot = (slot + 1u) & (ATOM_INDEX_SIZE - 1u);
+    }
+    if (atom_index[slot] == ATOM_INDEX_EMPTY)
+      atom_index[slot] = (uint8_t)i;
+    else if (values[atom_index[slot]] != values[i])
+      return false;
+  }
+  return true;
+}
+
+static void atom_index_build(void) {
+  atom_index_values = atoms;
+  for (uint32_t attempt = 0; attempt < 256; attempt++) {
+    uint32_t mult = (0x9e3779b1u + attempt * 0x6a09e66eu) | 1u;
+    if (atom_index_try(mult, false)) {
+      atom_index_mult = mult;
+      atom_index_perfect = true;
+      atom_index_built = true;
+      return;
+    }
+  }
+  atom_index_mult = 0x9e3779b1u;
+  atom_index_perfect = false;
+  atom_index_built = atom_index_try(atom_index_mult, true);
+}
+
+static int atom_index_lookup(xcb_atom_t atom) {
+  const xcb_atom_t* values = (const xcb_atom_t*)&atoms;
+  uint32_t slot = atom_index_slot(atom, atom_index_mult);
+  for (uint32_t n = 0; n < ATOM_INDEX_SIZE; n++) {
+    uint8_t i = atom_index[slot];
+    if (i == ATOM_INDEX_EMPTY)
+      return -1;
+    if (values[i] == atom)
+      return i;
+    if (atom_index_perfect)
+      return -1;
+    slot = (slot + 1u) & (ATOM_INDEX_SIZE - 1u);
+  }
+  return -1;
+}
+
+int atom_id(xcb_atom_t atom) {
+  if (atom == XCB_ATOM_NONE)
+    return -1;
+  if (atom_index_built) {
+    int i = atom_index_lookup(atom);
+    if (i >= 0 || memcmp(&atom_index_values, &atoms, sizeof(atoms)) == 0)
+      return i;
+  }
+
+  // atoms filled in without or after atoms_init (tests)
+  atom_index_build();
+  if (atom_index_built)
+    return atom_index_lookup(atom);
+  const xcb_atom_t* values = (const xcb_atom_t*)&atoms;
+  for (size_t i = 0; i < HXM_ATOM_COUNT; i++) {
+    if (values[i] == atom)
+      return (int)i;
+  }
+  return -1;
+}
+
 /*
  * atom_name:
  * Resolve an Atom ID to its string name (for debug logging).
  *
  * Optimization:
- * XCB atom name lookup is a round-trip. To avoid stalling the log output,
- * we use a small thread-local MRU cache (8 entries). This is sufficient for
- * debugging where we typically see the same few atoms repeated.
+ * Atoms from the table resolve through atom_index with no scan. Others need
+ * an XCB atom name lookup, which is a round-trip. To avoid stalling the log
+ * output, we use a small thread-local MRU cache (8 entries). This is
+ * sufficient for debugging where we typically see the same few atoms repeated.
  */
 const char* atom_name(xcb_atom_t atom) {
   if (atom == XCB_ATOM_NONE)
     return "NONE";
 
-  const xcb_atom_t* values = (const xcb_atom_t*)&atoms;
-  size_t count = sizeof(atoms) / sizeof(xcb_atom_t);
-  for (size_t i = 0; i < count; i++) {
-    if (values[i] == atom)
-      return atom_names[i];
+  if (atom_index_built) {
+    int known = atom_index_lookup(atom);
+    if (known >= 0)
+      return atom_names[known];
+  }
+  else {
+    // atoms filled in without atoms_init (tests)
+    const xcb_atom_t* values = (const xcb_atom_t*)&atoms;
+    for (size_t i = 0; i < HXM_ATOM_COUNT; i++) {
+      if (values[i] == atom)
+        return atom_names[i];
+    }
   }
 
   // Dynamic resolution cache (Thread Local for safety)
@@ -182,18 +189,22 @@ const char* atom_name(xcb_atom_t atom) {
   return "unknown";
 }
 
+/*
+ * atoms_init:
+ * Every xcb_intern_atom is sent before the first reply is awaited, so the
+ * whole table costs one round trip.
+ */
 void atoms_init(xcb_connection_t* conn) {
-  xcb_intern_atom_cookie_t cookies[sizeof(atom_names) / sizeof(atom_names[0])];
-  const size_t count = sizeof(atom_names) / sizeof(atom_names[0]);
+  xcb_intern_atom_cookie_t cookies[HXM_ATOM_COUNT];
+  xcb_atom_t* atom_ptr = (xcb_atom_t*)&atoms;
   g_conn_ref = conn;
 
-  for (size_t i = 0; i < count; i++) {
+  for (size_t i = 0; i < HXM_ATOM_COUNT; i++) {
     cookies[i] = xcb_intern_atom(conn, 0, strlen(atom_names[i]), atom_names[i]);
   }
 
   xcb_intern_atom_reply_t* reply;
-  xcb_atom_t* atom_ptr = (xcb_atom_t*)&atoms;
-  for (size_t i = 0; i < count; i++) {
+  for (size_t i = 0; i < HXM_ATOM_COUNT; i++) {
     reply = xcb_intern_atom_reply(conn, cookies[i], NULL);
     if (reply) {
       atom_ptr[i] = reply->atom;
@@ -204,6 +215,7 @@ void atoms_init(xcb_connection_t* conn) {
       atom_ptr[i] = XCB_ATOM_NONE;
     }
   }
+  atom_index_build();
 }
 
 void atoms_print(void) {
@@ -211,7 +223,7 @@ void atoms_print(void) {
   LOG_INFO("Cached atoms:");
   const char* const* name = atom_names;
   xcb_atom_t* atom_ptr = (xcb_atom_t*)&atoms;
-  for (size_t i = 0; i < sizeof(atom_names) / sizeof(atom_names[0]); i++) {
+  for (size_t i = 0; i < HXM_ATOM_COUNT; i++) {
     LOG_INFO("  %s: %u", *name, *atom_ptr);
     name++;
     atom_ptr++;
@@ -219,8 +231,8 @@ void atoms_print(void) {
 #endif
 }
 
-xcb_connection_t* xcb_connect_cached(void) {
-  xcb_connection_t* conn = xcb_connect(NULL, NULL);
+xcb_connection_t* xcb_connect_cached(int* screen_out) {
+  xcb_connection_t* conn = xcb_connect(NULL, screen_out);
   if (xcb_connection_has_error(conn)) {
     LOG_ERROR("Failed to connect to X server");
     return NULL;
@@ -229,6 +241,14 @@ xcb_connection_t* xcb_connect_cached(void) {
   return conn;
 }
 
+xcb_screen_t* xcb_screen_of(xcb_connection_t* conn, int screen_num) {
+  xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(conn));
+  xcb_screen_t* first = it.data;
+  for (int i = 0; i < screen_num && it.rem > 0; i++)
+    xcb_screen_next(&it);
+  return it.rem > 0 && it.data ? it.data : first;
+}
+
 __attribute__((weak)) xcb_visualtype_t* xcb_get_visualtype(xcb_connection_t* conn, xcb_visualid_t visual_id) {
   xcb_screen_iterator_t screen_iter = xcb_setup_roots_iterator(xcb_get_setup(conn));
   for (; screen_iter.rem; xcb_screen_next(&screen_iter)) {
@@ -0,0 +1,74 @@
+/* src/xi2.c
+ * XInput 2 drag grabs.
+ *
+ * Core MotionNotify carries whole-pixel positions the server has already
+ * truncated. An XI2 grab delivers the master pointer's 16.16 position, which
+ * we round, so high-resolution and high-rate mice track the pointer without
+ * the half-pixel bias. Everything past ingest sees core events: the rewrite
+ * happens while the libxcb allocation still holds the whole GenericEvent,
+ * before the 32-byte staging copy would cut it short.
+ */
+
+#include "xi2.h"
+
+#include <string.h>
+#include <xcb/xinput.h>
+
+bool xi2_enabled(const server_t* s) {
+  return s && s->xi2_supported && s->config.xinput2_motion;
+}
+
+unsigned int xi2_grab_pointer(server_t* s, xcb_window_t root, xcb_cursor_t cursor, uint32_t time) {
+  uint32_t mask = XCB_INPUT_XI_EVENT_MASK_MOTION | XCB_INPUT_XI_EVENT_MASK_BUTTON_RELEASE;
+  xcb_input_xi_grab_device_cookie_t ck = xcb_input_xi_grab_device(s->conn, root, time ? time : XCB_CURRENT_TIME, cursor, s->xi2_pointer, XCB_INPUT_GRAB_MODE_22_ASYNC,
+                                                                  XCB_INPUT_GRAB_MODE_22_ASYNC, XCB_INPUT_GRAB_OWNER_NO_OWNER, 1, &mask);
+  return ck.sequence;
+}
+
+uint8_t xi2_grab_status(const void* reply) {
+  return ((const xcb_input_xi_grab_device_reply_t*)reply)->status;
+}
+
+static int16_t fp1616_round(xcb_input_fp1616_t v) {
+  return (int16_t)((v + 0x8000) >> 16);
+}
+
+bool xi2_event_to_core(const server_t* s, xcb_generic_event_t* ev) {
+  if (!s->xi2_supported || (ev->response_type & ~0x80) != XCB_GE_GENERIC)
+    return false;
+  const xcb_ge_generic_event_t* ge = (const xcb_ge_generic_event_t*)ev;
+  if (ge->extension != s->xi2_opcode)
+    return false;
+  if (ge->event_type != XCB_INPUT_MOTION && ge->event_type != XCB_INPUT_BUTTON_RELEASE)
+    return false;
+
+  // Button state as of before the event, like the core state field
+  const xcb_input_button_press_event_t* xi = (const xcb_input_button_press_event_t*)ev;
+  uint16_t state = (uint16_t)(xi->mods.effective & 0xffu);
+  if (xi->buttons_len > 0) {
+    uint32_t buttons = xcb_input_button_press_button_mask(xi)[0];
+    for (int b = 1; b <= 5; b++) {
+      if (buttons & (1u << b))
+        state |= (uint16_t)(XCB_KEY_BUT_MASK_BUTTON_1 << (b - 1));
+    }
+  }
+
+  // Motion and button events share one core layout
+  xcb_motion_notify_event_t core = {
+      .response_type = (ge->event_type == XCB_INPUT_MOTION) ? XCB_MOTION_NOTIFY : XCB_BUTTON_RELEASE,
+      .detail = (ge->event_type == XCB_INPUT_MOTION) ? XCB_MOTION_NORMAL : (uint8_t)xi->detail,
+      .sequence = xi->sequence,
+      .time = xi->time,
+      .root = xi->root,
+      .event = xi->event,
+      .child = xi->child,
+      .root_x = fp1616_round(xi->root_x),
+      .root_y = fp1616_round(xi->root_y),
+      .event_x = fp1616_round(xi->event_x),
+      .event_y = fp1616_round(xi->event_y),
+      .state = state,
+      .same_screen = 1,
+  };
+  memcpy(ev, &core, sizeof(core));
+  return true;
+}
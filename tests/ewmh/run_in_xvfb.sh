@@ -20,7 +20,7 @@ if ! command -v pkg-config >/dev/null 2>&1; then
 fi
 
 cc=${CC:-cc}
-if ! $cc -std=c11 -O2 -Wall -Wextra -o "$client_bin" "$client_src" $(pkg-config --cflags --libs xcb); then
+if ! $cc -std=c11 -O2 -Wall -Wextra -o "$client_bin" "$client_src" $(pkg-config --cflags --libs xcb xcb-xtest); then
   echo "failed to build x_test_client" >&2
   exit 1
 fi
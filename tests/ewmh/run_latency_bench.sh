@@ -0,0 +1,155 @@
+#!/usr/bin/env bash
+# End-to-end latency of hxm as seen by a client, under N background windows.
+#
+# Usage: run_latency_bench.sh [windows] [iters]
+#   LATENCY_WINDOWS, LATENCY_ITERS   defaults when no arguments are given
+#   LATENCY_TIMEOUT_MS               per-sample timeout (default 5000)
+#   LATENCY_DISPLAY                  measure on this running X server instead
+#                                    of a private Xvfb; hxm is started there
+#                                    unless another WM already owns it
+set -euo pipefail
+
+script_dir=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+repo_root=$(cd "$script_dir/../.." && pwd)
+
+windows=${1:-${LATENCY_WINDOWS:-50}}
+iters=${2:-${LATENCY_ITERS:-200}}
+timeout_ms=${LATENCY_TIMEOUT_MS:-5000}
+
+if [ -z "${LATENCY_DISPLAY:-}" ] && ! command -v Xvfb >/dev/null 2>&1; then
+  echo "SKIP: Xvfb not found" >&2
+  exit 77
+fi
+
+if ! command -v pkg-config >/dev/null 2>&1; then
+  echo "SKIP: pkg-config not found" >&2
+  exit 77
+fi
+
+hxm_bin=${HXM_BIN:-}
+if [ -z "$hxm_bin" ]; then
+  if [ -x "$repo_root/build/hxm" ]; then
+    hxm_bin="$repo_root/build/hxm"
+  elif [ -x "$repo_root/hxm" ]; then
+    hxm_bin="$repo_root/hxm"
+  else
+    echo "hxm binary not found; set HXM_BIN" >&2
+    exit 1
+  fi
+fi
+
+tmp_home=$(mktemp -d)
+client_bin="$tmp_home/x_test_client"
+out_file="$tmp_home/latency.out"
+cleanup() {
+  if [ -n "${hxm_pid:-}" ]; then
+    kill "$hxm_pid" >/dev/null 2>&1 || true
+    wait "$hxm_pid" >/dev/null 2>&1 || true
+  fi
+  if [ -n "${xvfb_pid:-}" ]; then
+    kill "$xvfb_pid" >/dev/null 2>&1 || true
+    wait "$xvfb_pid" >/dev/null 2>&1 || true
+  fi
+  rm -rf "$tmp_home"
+}
+trap cleanup EXIT
+
+cc=${CC:-cc}
+if ! $cc -std=c11 -O2 -Wall -Wextra -o "$client_bin" "$script_dir/x_test_client.c" $(pkg-config --cflags --libs xcb xcb-xtest); then
+  echo "failed to build x_test_client" >&2
+  exit 1
+fi
+
+start_xvfb() {
+  local start=99
+  local end=150
+  if [ -n "${XVFB_DISPLAY:-}" ]; then
+    start=${XVFB_DISPLAY#:}
+    end=$start
+  fi
+
+  for i in $(seq "$start" "$end"); do
+    local disp=":$i"
+    Xvfb "$disp" -screen 0 1920x1080x24 +extension RANDR +extension XTEST >/dev/null 2>&1 &
+    xvfb_pid=$!
+
+    local alive=1
+    for _ in $(seq 1 40); do
+      if ! kill -0 "$xvfb_pid" 2>/dev/null; then
+        alive=0
+        break
+      fi
+      sleep 0.05
+    done
+
+    if [ "$alive" -eq 1 ]; then
+      export DISPLAY="$disp"
+      return 0
+    fi
+
+    wait "$xvfb_pid" 2>/dev/null || true
+    unset xvfb_pid
+
+    if [ -n "${XVFB_DISPLAY:-}" ]; then
+      break
+    fi
+  done
+
+  return 1
+}
+
+export HOME="$tmp_home"
+export XDG_CONFIG_HOME="$tmp_home/.config"
+mkdir -p "$XDG_CONFIG_HOME/hxm"
+cat >"$XDG_CONFIG_HOME/hxm/hxm.conf" <<'CONF'
+desktop_count = 2
+interactive_outline = off
+keybind = Super+1 : workspace 0
+keybind = Super+2 : workspace 1
+CONF
+
+if [ -n "${LATENCY_DISPLAY:-}" ]; then
+  export DISPLAY="$LATENCY_DISPLAY"
+elif ! start_xvfb; then
+  echo "SKIP: unable to start Xvfb (check xkeyboard-config setup)" >&2
+  exit 77
+fi
+
+if [ "$("$client_bin" has-extension XTEST 2>/dev/null || true)" != "yes" ]; then
+  echo "SKIP: XTEST extension not available on $DISPLAY" >&2
+  exit 77
+fi
+
+# Reuse a WM that already manages the display, otherwise start hxm
+if ! "$client_bin" assert-substructure-redirect >/dev/null 2>&1; then
+  hxm_log_file="${HXM_LOG_FILE:-/dev/null}"
+  "$hxm_bin" >"$hxm_log_file" 2>&1 &
+  hxm_pid=$!
+
+  owned=0
+  for _ in $(seq 1 100); do
+    if "$client_bin" assert-substructure-redirect >/dev/null 2>&1; then
+      owned=1
+      break
+    fi
+    sleep 0.05
+  done
+  if [ "$owned" -ne 1 ]; then
+    echo "WM did not take SubstructureRedirect on root" >&2
+    exit 1
+  fi
+fi
+
+if ! "$client_bin" latency-bench "$windows" "$iters" "$timeout_ms" >"$out_file"; then
+  echo "latency-bench failed" >&2
+  cat "$out_file" >&2 || true
+  exit 1
+fi
+cat "$out_file"
+
+for metric in map_to_frame_mapped active_window_to_focus_in keypress_to_workspace_switch resize_step; do
+  if ! grep -Eq "^LATENCY $metric SAMPLES $iters P50_US [0-9.]+ P90_US [0-9.]+ P99_US [0-9.]+ MAX_US [0-9.]+$" "$out_file"; then
+    echo "missing or malformed result for $metric" >&2
+    exit 1
+  fi
+done
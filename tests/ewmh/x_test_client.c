@@ -1,12 +1,17 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <errno.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <xcb/xcb.h>
+#include <xcb/xtest.h>
 
 static void die(const char* msg) {
   fprintf(stderr, "x_test_client: %s\n", msg);
@@ -53,6 +58,453 @@ static void print_cardinal_json(uint32_t* vals, int count) {
   printf("]}\n");
 }
 
+/*
+ * latency-bench: end-to-end WM latency as seen by a client
+ *
+ * Every sample is timed from the request leaving this client to the event
+ * that shows the WM acted on it, so it covers the server round trips and the
+ * WM's own event loop. Background windows stay mapped throughout so the WM
+ * works against a realistic client count.
+ */
+
+#define LATENCY_BG_W 200
+#define LATENCY_BG_H 150
+#define LATENCY_RESIZE_STEP 16
+
+typedef struct latency_series {
+  uint64_t* ns;
+  uint32_t len;
+} latency_series_t;
+
+typedef bool (*latency_match_fn)(const xcb_generic_event_t* ev, void* ctx);
+
+static uint64_t latency_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void latency_series_init(latency_series_t* s, uint32_t cap) {
+  s->ns = calloc(cap ? cap : 1, sizeof(*s->ns));
+  if (!s->ns)
+    die("out of memory");
+  s->len = 0;
+}
+
+static int latency_cmp_u64(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*)a;
+  uint64_t y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile over a sorted series
+static double latency_pct_us(const latency_series_t* s, uint32_t pct) {
+  uint32_t rank = (uint32_t)(((uint64_t)s->len * pct + 99) / 100);
+  if (rank == 0)
+    rank = 1;
+  return (double)s->ns[rank - 1] / 1000.0;
+}
+
+static void latency_report(const char* name, latency_series_t* s) {
+  if (s->len == 0)
+    die("latency series is empty");
+  qsort(s->ns, s->len, sizeof(*s->ns), latency_cmp_u64);
+  printf("LATENCY %s SAMPLES %" PRIu32 " P50_US %.1f P90_US %.1f P99_US %.1f MAX_US %.1f\n", name, s->len, latency_pct_us(s, 50), latency_pct_us(s, 90), latency_pct_us(s, 99),
+         (double)s->ns[s->len - 1] / 1000.0);
+  fflush(stdout);
+  free(s->ns);
+  s->ns = NULL;
+}
+
+/*
+ * Dispatch events until match accepts one or timeout_ms passes. Events the
+ * matcher rejects are dropped. *at_ns is the time the accepted event was
+ * dequeued.
+ */
+static bool latency_wait(xcb_connection_t* conn, latency_match_fn match, void* ctx, uint32_t timeout_ms, uint64_t* at_ns) {
+  uint64_t deadline = latency_now_ns() + (uint64_t)timeout_ms * 1000000ull;
+  for (;;) {
+    xcb_generic_event_t* ev = xcb_poll_for_event(conn);
+    if (ev) {
+      uint64_t t = latency_now_ns();
+      bool hit = match(ev, ctx);
+      free(ev);
+      if (hit) {
+        if (at_ns)
+          *at_ns = t;
+        return true;
+      }
+      continue;
+    }
+    if (xcb_connection_has_error(conn))
+      die("X connection lost");
+
+    uint64_t now = latency_now_ns();
+    if (now >= deadline)
+      return false;
+    struct pollfd pfd = {.fd = xcb_get_file_descriptor(conn), .events = POLLIN};
+    int wait_ms = (int)((deadline - now + 999999ull) / 1000000ull);
+    if (poll(&pfd, 1, wait_ms) < 0 && errno != EINTR)
+      die("poll failed");
+  }
+}
+
+static xcb_window_t latency_create_window(xcb_connection_t* conn, xcb_screen_t* screen, int16_t x, int16_t y) {
+  xcb_window_t win = xcb_generate_id(conn);
+  uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+  uint32_t values[] = {screen->white_pixel, XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_FOCUS_CHANGE | XCB_EVENT_MASK_PROPERTY_CHANGE};
+  xcb_create_window(conn, XCB_COPY_FROM_PARENT, win, screen->root, x, y, LATENCY_BG_W, LATENCY_BG_H, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, mask, values);
+  return win;
+}
+
+// A window counts as visible once it and its frame are both mapped
+typedef struct latency_map_ctx {
+  xcb_window_t win;
+  xcb_window_t frame;
+  bool win_mapped;
+  bool frame_mapped;
+  xcb_window_t early[8]; /* root children mapped before the reparent was seen */
+  uint32_t early_len;
+} latency_map_ctx_t;
+
+static bool latency_match_map(const xcb_generic_event_t* ev, void* ctx) {
+  latency_map_ctx_t* m = ctx;
+  uint8_t type = ev->response_type & 0x7f;
+  if (type == XCB_REPARENT_NOTIFY) {
+    const xcb_reparent_notify_event_t* e = (const xcb_reparent_notify_event_t*)ev;
+    if (e->window != m->win)
+      return false;
+    m->frame = e->parent;
+    for (uint32_t i = 0; i < m->early_len; i++) {
+      if (m->early[i] == m->frame)
+        m->frame_mapped = true;
+    }
+  }
+  else if (type == XCB_MAP_NOTIFY) {
+    const xcb_map_notify_event_t* e = (const xcb_map_notify_event_t*)ev;
+    if (e->window == m->win) {
+      m->win_mapped = true;
+    }
+    else if (m->frame != XCB_NONE && e->window == m->frame) {
+      m->frame_mapped = true;
+    }
+    else if (m->frame == XCB_NONE) {
+      m->early[m->early_len % 8] = e->window;
+      m->early_len = m->early_len < 8 ? m->early_len + 1 : 8;
+    }
+  }
+  return m->win_mapped && m->frame_mapped;
+}
+
+typedef struct latency_unmap_ctx {
+  xcb_window_t frame;
+} latency_unmap_ctx_t;
+
+static bool latency_match_unmap(const xcb_generic_event_t* ev, void* ctx) {
+  latency_unmap_ctx_t* u = ctx;
+  uint8_t type = ev->response_type & 0x7f;
+  if (type == XCB_UNMAP_NOTIFY)
+    return ((const xcb_unmap_notify_event_t*)ev)->window == u->frame;
+  if (type == XCB_DESTROY_NOTIFY)
+    return ((const xcb_destroy_notify_event_t*)ev)->window == u->frame;
+  return false;
+}
+
+// Background windows: done once every one of them is reparented and mapped
+typedef struct latency_bg_ctx {
+  const xcb_window_t* wins;
+  uint8_t* state; /* bit 0 reparented, bit 1 mapped */
+  uint32_t count;
+  uint32_t done;
+} latency_bg_ctx_t;
+
+static bool latency_match_bg(const xcb_generic_event_t* ev, void* ctx) {
+  latency_bg_ctx_t* b = ctx;
+  uint8_t type = ev->response_type & 0x7f;
+  xcb_window_t win;
+  uint8_t bit;
+  if (type == XCB_REPARENT_NOTIFY) {
+    const xcb_reparent_notify_event_t* e = (const xcb_reparent_notify_event_t*)ev;
+    win = e->window;
+    bit = 1;
+  }
+  else if (type == XCB_MAP_NOTIFY) {
+    win = ((const xcb_map_notify_event_t*)ev)->window;
+    bit = 2;
+  }
+  else {
+    return false;
+  }
+  for (uint32_t i = 0; i < b->count; i++) {
+    if (b->wins[i] != win)
+      continue;
+    if (b->state[i] != 3) {
+      b->state[i] |= bit;
+      if (b->state[i] == 3)
+        b->done++;
+    }
+    break;
+  }
+  return b->done == b->count;
+}
+
+typedef struct latency_focus_ctx {
+  xcb_window_t win;
+} latency_focus_ctx_t;
+
+static bool latency_match_focus(const xcb_generic_event_t* ev, void* ctx) {
+  latency_focus_ctx_t* f = ctx;
+  if ((ev->response_type & 0x7f) != XCB_FOCUS_IN)
+    return false;
+  const xcb_focus_in_event_t* e = (const xcb_focus_in_event_t*)ev;
+  return e->event == f->win && e->mode != XCB_NOTIFY_MODE_GRAB && e->mode != XCB_NOTIFY_MODE_UNGRAB && e->detail != XCB_NOTIFY_DETAIL_INFERIOR &&
+         e->detail != XCB_NOTIFY_DETAIL_POINTER;
+}
+
+typedef struct latency_prop_ctx {
+  xcb_window_t win;
+  xcb_atom_t atom;
+} latency_prop_ctx_t;
+
+static bool latency_match_prop(const xcb_generic_event_t* ev, void* ctx) {
+  latency_prop_ctx_t* p = ctx;
+  if ((ev->response_type & 0x7f) != XCB_PROPERTY_NOTIFY)
+    return false;
+  const xcb_property_notify_event_t* e = (const xcb_property_notify_event_t*)ev;
+  return e->window == p->win && e->atom == p->atom;
+}
+
+typedef struct latency_size_ctx {
+  xcb_window_t win;
+  uint16_t w;
+  uint16_t h;
+} latency_size_ctx_t;
+
+static bool latency_match_size(const xcb_generic_event_t* ev, void* ctx) {
+  latency_size_ctx_t* c = ctx;
+  if ((ev->response_type & 0x7f) != XCB_CONFIGURE_NOTIFY)
+    return false;
+  const xcb_configure_notify_event_t* e = (const xcb_configure_notify_event_t*)ev;
+  return e->window == c->win && e->width == c->w && e->height == c->h;
+}
+
+static void latency_send_root_message(xcb_connection_t* conn, xcb_window_t root, xcb_window_t win, xcb_atom_t type, const uint32_t data[5]) {
+  xcb_client_message_event_t ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.response_type = XCB_CLIENT_MESSAGE;
+  ev.format = 32;
+  ev.window = win;
+  ev.type = type;
+  for (int i = 0; i < 5; i++)
+    ev.data.data32[i] = data[i];
+  xcb_send_event(conn, 0, root, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT, (const char*)&ev);
+}
+
+static uint32_t latency_root_cardinal(xcb_connection_t* conn, xcb_window_t root, xcb_atom_t atom) {
+  xcb_get_property_reply_t* reply = xcb_get_property_reply(conn, xcb_get_property(conn, 0, root, atom, XCB_ATOM_CARDINAL, 0, 1), NULL);
+  uint32_t val = UINT32_MAX;
+  if (reply && xcb_get_property_value_length(reply) >= 4)
+    val = *(uint32_t*)xcb_get_property_value(reply);
+  free(reply);
+  return val;
+}
+
+static xcb_window_t latency_input_focus(xcb_connection_t* conn) {
+  xcb_get_input_focus_reply_t* reply = xcb_get_input_focus_reply(conn, xcb_get_input_focus(conn), NULL);
+  xcb_window_t focus = reply ? reply->focus : XCB_NONE;
+  free(reply);
+  return focus;
+}
+
+// First keycode whose unshifted keysym is sym
+static xcb_keycode_t latency_keycode(xcb_connection_t* conn, uint32_t sym) {
+  const xcb_setup_t* setup = xcb_get_setup(conn);
+  uint8_t count = (uint8_t)(setup->max_keycode - setup->min_keycode + 1);
+  xcb_get_keyboard_mapping_reply_t* reply = xcb_get_keyboard_mapping_reply(conn, xcb_get_keyboard_mapping(conn, setup->min_keycode, count), NULL);
+  if (!reply)
+    die("get_keyboard_mapping failed");
+  const xcb_keysym_t* syms = xcb_get_keyboard_mapping_keysyms(reply);
+  xcb_keycode_t code = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    if (syms[i * reply->keysyms_per_keycode] == sym) {
+      code = (xcb_keycode_t)(setup->min_keycode + i);
+      break;
+    }
+  }
+  free(reply);
+  if (!code)
+    die("keysym not in keyboard mapping");
+  return code;
+}
+
+static void latency_fake(xcb_connection_t* conn, uint8_t type, uint8_t detail, xcb_window_t root, int16_t x, int16_t y) {
+  xcb_test_fake_input(conn, type, detail, XCB_CURRENT_TIME, root, x, y, 0);
+}
+
+static int latency_bench(xcb_connection_t* conn, xcb_screen_t* screen, uint32_t windows, uint32_t iters, uint32_t timeout_ms) {
+  xcb_window_t root = screen->root;
+  const xcb_query_extension_reply_t* xtest = xcb_get_extension_data(conn, &xcb_test_id);
+  if (!xtest || !xtest->present)
+    die("XTEST extension missing");
+
+  xcb_atom_t net_active = get_atom(conn, "_NET_ACTIVE_WINDOW");
+  xcb_atom_t net_desktop = get_atom(conn, "_NET_CURRENT_DESKTOP");
+  xcb_atom_t net_moveresize = get_atom(conn, "_NET_WM_MOVERESIZE");
+
+  uint32_t root_mask = XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE;
+  xcb_change_window_attributes(conn, root, XCB_CW_EVENT_MASK, &root_mask);
+
+  // Focus changes need two windows to alternate between
+  uint32_t bg_count = windows < 2 ? 2 : windows;
+  xcb_window_t* bg = calloc(bg_count, sizeof(*bg));
+  uint8_t* bg_state = calloc(bg_count, 1);
+  if (!bg || !bg_state)
+    die("out of memory");
+  uint32_t cols = screen->width_in_pixels > LATENCY_BG_W ? (uint32_t)(screen->width_in_pixels - LATENCY_BG_W) / 24u + 1u : 1u;
+  for (uint32_t i = 0; i < bg_count; i++) {
+    bg[i] = latency_create_window(conn, screen, (int16_t)((i % cols) * 24u), (int16_t)((i / cols % 16u) * 24u));
+    xcb_map_window(conn, bg[i]);
+  }
+  xcb_flush(conn);
+  latency_bg_ctx_t bg_ctx = {.wins = bg, .state = bg_state, .count = bg_count};
+  if (!latency_wait(conn, latency_match_bg, &bg_ctx, timeout_ms + bg_count * 20u, NULL))
+    die("timed out managing background windows");
+  printf("LATENCY_SETUP WINDOWS %" PRIu32 " ITERS %" PRIu32 "\n", bg_count, iters);
+
+  // MapRequest to frame mapped
+  latency_series_t map_lat;
+  latency_series_init(&map_lat, iters);
+  for (uint32_t i = 0; i < iters; i++) {
+    latency_map_ctx_t m = {.win = latency_create_window(conn, screen, 40, 40)};
+    xcb_flush(conn);
+    uint64_t t0 = latency_now_ns();
+    xcb_map_window(conn, m.win);
+    xcb_flush(conn);
+    uint64_t t1;
+    if (!latency_wait(conn, latency_match_map, &m, timeout_ms, &t1))
+      die("timed out waiting for frame map");
+    map_lat.ns[map_lat.len++] = t1 - t0;
+
+    // Let the WM finish unmanaging before the next sample
+    latency_unmap_ctx_t u = {.frame = m.frame};
+    xcb_destroy_window(conn, m.win);
+    xcb_flush(conn);
+    if (!latency_wait(conn, latency_match_unmap, &u, timeout_ms, NULL))
+      die("timed out waiting for frame unmap");
+  }
+  latency_report("map_to_frame_mapped", &map_lat);
+
+  // _NET_ACTIVE_WINDOW to FocusIn; the first activation only sets a known start
+  latency_series_t focus_lat;
+  latency_series_init(&focus_lat, iters);
+  for (uint32_t i = 0; i <= iters; i++) {
+    latency_focus_ctx_t f = {.win = bg[i % bg_count]};
+    uint32_t data[5] = {2, XCB_CURRENT_TIME, 0, 0, 0};
+    uint64_t t0 = latency_now_ns();
+    latency_send_root_message(conn, root, f.win, net_active, data);
+    xcb_flush(conn);
+    uint64_t t1;
+    if (!latency_wait(conn, latency_match_focus, &f, timeout_ms, &t1)) {
+      // The warm-up target may already hold the focus, which sends no FocusIn
+      if (i > 0 || latency_input_focus(conn) != f.win)
+        die("timed out waiting for FocusIn");
+    }
+    if (i > 0)
+      focus_lat.ns[focus_lat.len++] = t1 - t0;
+  }
+  latency_report("active_window_to_focus_in", &focus_lat);
+
+  // XTest Super+1/Super+2 to _NET_CURRENT_DESKTOP; the background windows
+  // all live on desktop 0, so every switch hides or shows them
+  xcb_keycode_t super = latency_keycode(conn, 0xffeb); /* XK_Super_L */
+  xcb_keycode_t digit[2] = {latency_keycode(conn, 0x31), latency_keycode(conn, 0x32)};
+  latency_series_t ws_lat;
+  latency_series_init(&ws_lat, iters);
+  uint32_t desktop = latency_root_cardinal(conn, root, net_desktop);
+  for (uint32_t i = 0; i < iters + 1u; i++) {
+    uint32_t target = desktop == 0 ? 1 : 0;
+    bool timed = i < iters;
+    // A trailing untimed switch puts desktop 0 back for the resize run
+    if (!timed && desktop == 0)
+      break;
+    latency_prop_ctx_t p = {.win = root, .atom = net_desktop};
+    uint64_t t0 = latency_now_ns();
+    latency_fake(conn, XCB_KEY_PRESS, super, XCB_NONE, 0, 0);
+    latency_fake(conn, XCB_KEY_PRESS, digit[target], XCB_NONE, 0, 0);
+    latency_fake(conn, XCB_KEY_RELEASE, digit[target], XCB_NONE, 0, 0);
+    latency_fake(conn, XCB_KEY_RELEASE, super, XCB_NONE, 0, 0);
+    xcb_flush(conn);
+    uint64_t t1;
+    for (;;) {
+      if (!latency_wait(conn, latency_match_prop, &p, timeout_ms, &t1))
+        die("timed out waiting for _NET_CURRENT_DESKTOP");
+      if (latency_root_cardinal(conn, root, net_desktop) == target)
+        break;
+    }
+    desktop = target;
+    if (timed)
+      ws_lat.ns[ws_lat.len++] = t1 - t0;
+  }
+  latency_report("keypress_to_workspace_switch", &ws_lat);
+
+  // Interactive resize: each pointer step to the client's ConfigureNotify
+  xcb_window_t rwin = bg[0];
+  xcb_get_geometry_reply_t* geom = xcb_get_geometry_reply(conn, xcb_get_geometry(conn, rwin), NULL);
+  xcb_translate_coordinates_reply_t* tr = xcb_translate_coordinates_reply(conn, xcb_translate_coordinates(conn, rwin, root, 0, 0), NULL);
+  if (!geom || !tr)
+    die("cannot query resize target geometry");
+  latency_size_ctx_t sz = {.win = rwin, .w = geom->width, .h = geom->height};
+  int16_t px = (int16_t)(tr->dst_x + geom->width - 1);
+  int16_t py = (int16_t)(tr->dst_y + geom->height - 1);
+  free(geom);
+  free(tr);
+
+  latency_fake(conn, XCB_MOTION_NOTIFY, 0, root, px, py);
+  uint32_t start[5] = {(uint32_t)px, (uint32_t)py, 4, 1, 1}; /* SIZE_BOTTOMRIGHT, button 1, normal source */
+  latency_send_root_message(conn, root, rwin, net_moveresize, start);
+  xcb_flush(conn);
+
+  // The interaction starts asynchronously; nudge until the first step lands
+  uint16_t base_w = sz.w;
+  uint16_t base_h = sz.h;
+  bool started = false;
+  for (uint32_t waited = 0; waited < timeout_ms && !started; waited += 50) {
+    latency_fake(conn, XCB_MOTION_NOTIFY, 0, root, (int16_t)(px + LATENCY_RESIZE_STEP), (int16_t)(py + LATENCY_RESIZE_STEP));
+    xcb_flush(conn);
+    sz.w = (uint16_t)(base_w + LATENCY_RESIZE_STEP);
+    sz.h = (uint16_t)(base_h + LATENCY_RESIZE_STEP);
+    started = latency_wait(conn, latency_match_size, &sz, 50, NULL);
+  }
+  if (!started)
+    die("interactive resize did not start");
+
+  latency_series_t resize_lat;
+  latency_series_init(&resize_lat, iters);
+  for (uint32_t i = 0; i < iters; i++) {
+    int16_t d = (i & 1u) ? LATENCY_RESIZE_STEP : 0;
+    sz.w = (uint16_t)(base_w + d);
+    sz.h = (uint16_t)(base_h + d);
+    uint64_t t0 = latency_now_ns();
+    latency_fake(conn, XCB_MOTION_NOTIFY, 0, root, (int16_t)(px + d), (int16_t)(py + d));
+    xcb_flush(conn);
+    uint64_t t1;
+    if (!latency_wait(conn, latency_match_size, &sz, timeout_ms, &t1))
+      die("timed out waiting for resize step");
+    resize_lat.ns[resize_lat.len++] = t1 - t0;
+  }
+  uint32_t cancel[5] = {0, 0, 11, 0, 1}; /* _NET_WM_MOVERESIZE_CANCEL */
+  latency_send_root_message(conn, root, rwin, net_moveresize, cancel);
+  xcb_flush(conn);
+  latency_report("resize_step", &resize_lat);
+
+  for (uint32_t i = 0; i < bg_count; i++)
+    xcb_destroy_window(conn, bg[i]);
+  xcb_flush(conn);
+  free(bg);
+  free(bg_state);
+  return 0;
+}
+
 static void usage(void) {
   fprintf(stderr,
           "Usage:\n"
@@ -72,6 +524,7 @@ static void usage(void) {
           "<d3> <d4>\n"
           "  x_test_client has-extension <name>\n"
           "  x_test_client assert-substructure-redirect\n"
+          "  x_test_client latency-bench <windows> <iters> [timeout-ms]\n"
           "  x_test_client sleep <seconds>\n");
   exit(2);
 }
@@ -365,6 +818,19 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  if (strcmp(cmd, "latency-bench") == 0) {
+    if (argc != 4 && argc != 5)
+      usage();
+    uint32_t windows = parse_u32(argv[2]);
+    uint32_t iters = parse_u32(argv[3]);
+    uint32_t timeout_ms = argc == 5 ? parse_u32(argv[4]) : 5000;
+    if (iters == 0)
+      usage();
+    int rc = latency_bench(conn, screen, windows, iters, timeout_ms);
+    xcb_disconnect(conn);
+    return rc;
+  }
+
   if (strcmp(cmd, "sleep") == 0) {
     if (argc != 3)
       usage();
@@ -0,0 +1,414 @@
+/*
+ * load_client - one X client producing a configurable mix of WM work
+ *
+ * Keeps a set of toplevels (each optionally heading a chain of transients)
+ * alive for a fixed duration and, at the requested rates, replaces them,
+ * retitles them, replaces their icons, toggles _NET_WM_STATE, sends
+ * ConfigureRequests and flashes override-redirect popups. Rates are totals
+ * per second for this process; run several to model several applications.
+ * scripts/stress-test.py drives it with workload presets.
+ *
+ * Prints one JSON object counting what was done.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#define LOAD_MAX_WINDOWS 512
+#define LOAD_MAX_DEPTH 16
+#define LOAD_MAX_POPUPS 16
+#define LOAD_MAX_ICON 512
+
+typedef enum load_op {
+  LOAD_OP_CHURN = 0,
+  LOAD_OP_TITLE,
+  LOAD_OP_ICON,
+  LOAD_OP_STATE,
+  LOAD_OP_CONFIGURE,
+  LOAD_OP_POPUP,
+  LOAD_OP_COUNT
+} load_op_t;
+
+static const char* const load_op_names[LOAD_OP_COUNT] = {
+    [LOAD_OP_CHURN] = "churn", [LOAD_OP_TITLE] = "titles", [LOAD_OP_ICON] = "icons", [LOAD_OP_STATE] = "states", [LOAD_OP_CONFIGURE] = "configures", [LOAD_OP_POPUP] = "popups",
+};
+
+static const char* const load_op_flags[LOAD_OP_COUNT] = {
+    [LOAD_OP_CHURN] = "--churn-hz",         [LOAD_OP_TITLE] = "--title-hz", [LOAD_OP_ICON] = "--icon-hz", [LOAD_OP_STATE] = "--state-hz",
+    [LOAD_OP_CONFIGURE] = "--configure-hz", [LOAD_OP_POPUP] = "--popup-hz",
+};
+
+typedef struct load_params {
+  uint32_t duration_ms;
+  uint32_t windows;
+  uint32_t transient_depth;
+  uint32_t icon_size;
+  uint32_t popup_ms;
+  uint64_t seed;
+  double hz[LOAD_OP_COUNT];
+} load_params_t;
+
+typedef struct load_window {
+  xcb_window_t win;
+  xcb_window_t transients[LOAD_MAX_DEPTH];
+  uint32_t state_step;
+} load_window_t;
+
+typedef struct load_popup {
+  xcb_window_t win;
+  uint64_t expires_ns;
+} load_popup_t;
+
+static xcb_connection_t* c;
+static xcb_screen_t* screen;
+static load_params_t params;
+static load_window_t windows[LOAD_MAX_WINDOWS];
+static load_popup_t popups[LOAD_MAX_POPUPS];
+static uint32_t* icon_buf;
+static uint64_t rng_state;
+static uint64_t done[LOAD_OP_COUNT];
+static uint64_t created;
+static uint64_t transients_created;
+static uint64_t x_errors;
+
+static struct {
+  xcb_atom_t utf8_string;
+  xcb_atom_t net_wm_name;
+  xcb_atom_t net_wm_icon;
+  xcb_atom_t net_wm_state;
+  xcb_atom_t net_wm_window_type;
+  xcb_atom_t net_wm_window_type_dialog;
+  xcb_atom_t maximized_horz;
+  xcb_atom_t states[5];
+} atoms;
+
+static const char* const state_atom_names[5] = {
+    "_NET_WM_STATE_MAXIMIZED_VERT", "_NET_WM_STATE_ABOVE", "_NET_WM_STATE_DEMANDS_ATTENTION", "_NET_WM_STATE_FULLSCREEN", "_NET_WM_STATE_SHADED",
+};
+
+static void fail(const char* msg) {
+  fprintf(stderr, "load_client: %s\n", msg);
+  exit(1);
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// splitmix64: reproducible per seed, independent of libc
+static uint64_t rng_next(void) {
+  uint64_t z = (rng_state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+static uint32_t rng_below(uint32_t n) {
+  return n ? (uint32_t)(rng_next() % n) : 0;
+}
+
+static xcb_atom_t intern(const char* name) {
+  xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(c, xcb_intern_atom(c, 0, (uint16_t)strlen(name), name), NULL);
+  if (!reply)
+    fail("failed to intern atom");
+  xcb_atom_t atom = reply->atom;
+  free(reply);
+  return atom;
+}
+
+static void set_title(xcb_window_t win, uint64_t serial) {
+  char title[96];
+  int len = snprintf(title, sizeof(title), "load %u \xe2\x80\x94 update %" PRIu64, win, serial);
+  xcb_change_property(c, XCB_PROP_MODE_REPLACE, win, atoms.net_wm_name, atoms.utf8_string, 8, (uint32_t)len, title);
+  xcb_change_property(c, XCB_PROP_MODE_REPLACE, win, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, (uint32_t)len, title);
+}
+
+// A fresh colour each time so the WM cannot short-circuit on equal pixels
+static void set_icon(xcb_window_t win, uint64_t serial) {
+  uint32_t n = params.icon_size;
+  if (!n)
+    return;
+  uint32_t argb = 0xff000000u | (uint32_t)(serial * 0x9e3779b9u >> 8);
+  icon_buf[0] = n;
+  icon_buf[1] = n;
+  for (uint32_t i = 0; i < n * n; i++)
+    icon_buf[2 + i] = argb ^ (i & 0xffu);
+  xcb_change_property(c, XCB_PROP_MODE_REPLACE, win, atoms.net_wm_icon, XCB_ATOM_CARDINAL, 32, 2u + n * n, icon_buf);
+}
+
+static xcb_window_t create_window(xcb_window_t transient_for, uint16_t w, uint16_t h) {
+  xcb_window_t win = xcb_generate_id(c);
+  uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+  uint32_t values[] = {screen->white_pixel, XCB_EVENT_MASK_STRUCTURE_NOTIFY};
+  int16_t x = (int16_t)rng_below(screen->width_in_pixels > w ? (uint32_t)(screen->width_in_pixels - w) : 1u);
+  int16_t y = (int16_t)rng_below(screen->height_in_pixels > h ? (uint32_t)(screen->height_in_pixels - h) : 1u);
+  xcb_create_window(c, XCB_COPY_FROM_PARENT, win, screen->root, x, y, w, h, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, mask, values);
+
+  static const char wm_class[] = "hxm-load\0HxmLoad";
+  xcb_change_property(c, XCB_PROP_MODE_REPLACE, win, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, sizeof(wm_class), wm_class);
+  if (transient_for != XCB_NONE) {
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, win, XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 32, 1, &transient_for);
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, win, atoms.net_wm_window_type, XCB_ATOM_ATOM, 32, 1, &atoms.net_wm_window_type_dialog);
+  }
+  set_title(win, 0);
+  set_icon(win, created);
+  xcb_map_window(c, win);
+  return win;
+}
+
+static void window_open(load_window_t* lw) {
+  memset(lw, 0, sizeof(*lw));
+  lw->win = create_window(XCB_NONE, 320, 240);
+  created++;
+  xcb_window_t parent = lw->win;
+  for (uint32_t d = 0; d < params.transient_depth; d++) {
+    lw->transients[d] = create_window(parent, (uint16_t)(240 - d * 8), (uint16_t)(160 - d * 6));
+    parent = lw->transients[d];
+    transients_created++;
+  }
+}
+
+// Innermost transient first, like an application tearing down its dialogs
+static void window_close(load_window_t* lw) {
+  for (uint32_t d = params.transient_depth; d-- > 0;)
+    xcb_destroy_window(c, lw->transients[d]);
+  xcb_destroy_window(c, lw->win);
+  lw->win = XCB_NONE;
+}
+
+static void send_state(xcb_window_t win, xcb_atom_t first, xcb_atom_t second) {
+  xcb_client_message_event_t ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.response_type = XCB_CLIENT_MESSAGE;
+  ev.format = 32;
+  ev.window = win;
+  ev.type = atoms.net_wm_state;
+  ev.data.data32[0] = 2; /* _NET_WM_STATE_TOGGLE */
+  ev.data.data32[1] = first;
+  ev.data.data32[2] = second;
+  ev.data.data32[3] = 1; /* normal application */
+  xcb_send_event(c, 0, screen->root, XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT, (const char*)&ev);
+}
+
+static void popup_reap(uint64_t now, bool all) {
+  for (uint32_t i = 0; i < LOAD_MAX_POPUPS; i++) {
+    if (popups[i].win != XCB_NONE && (all || now >= popups[i].expires_ns)) {
+      xcb_destroy_window(c, popups[i].win);
+      popups[i].win = XCB_NONE;
+    }
+  }
+}
+
+static void popup_open(uint64_t now) {
+  uint32_t slot = 0;
+  for (uint32_t i = 0; i < LOAD_MAX_POPUPS; i++) {
+    if (popups[i].win == XCB_NONE || popups[i].expires_ns < popups[slot].expires_ns) {
+      slot = i;
+      if (popups[i].win == XCB_NONE)
+        break;
+    }
+  }
+  if (popups[slot].win != XCB_NONE)
+    xcb_destroy_window(c, popups[slot].win);
+
+  xcb_window_t win = xcb_generate_id(c);
+  uint32_t mask = XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT;
+  uint32_t values[] = {screen->black_pixel, 1};
+  int16_t x = (int16_t)rng_below(screen->width_in_pixels);
+  int16_t y = (int16_t)rng_below(screen->height_in_pixels);
+  xcb_create_window(c, XCB_COPY_FROM_PARENT, win, screen->root, x, y, 160, 90, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, mask, values);
+  xcb_map_window(c, win);
+  popups[slot].win = win;
+  popups[slot].expires_ns = now + (uint64_t)params.popup_ms * 1000000ull;
+}
+
+static void run_op(load_op_t op, uint64_t now) {
+  load_window_t* lw = &windows[rng_below(params.windows)];
+  switch (op) {
+    case LOAD_OP_CHURN:
+      window_close(lw);
+      window_open(lw);
+      break;
+    case LOAD_OP_TITLE:
+      set_title(lw->win, done[op] + 1);
+      break;
+    case LOAD_OP_ICON:
+      set_icon(lw->win, done[op] + 1);
+      break;
+    case LOAD_OP_STATE: {
+      // Every state goes on and then off again, maximize as the EWMH pair
+      uint32_t idx = (lw->state_step++ / 2u) % 5u;
+      send_state(lw->win, atoms.states[idx], idx == 0 ? atoms.maximized_horz : XCB_NONE);
+      break;
+    }
+    case LOAD_OP_CONFIGURE: {
+      uint32_t values[] = {rng_below(screen->width_in_pixels / 2u), rng_below(screen->height_in_pixels / 2u), 200u + rng_below(400), 150u + rng_below(300)};
+      xcb_configure_window(c, lw->win, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+      break;
+    }
+    case LOAD_OP_POPUP:
+      popup_open(now);
+      break;
+    default:
+      return;
+  }
+  done[op]++;
+}
+
+static bool parse_arg(const char* key, const char* val) {
+  char* end = NULL;
+  errno = 0;
+  for (int i = 0; i < LOAD_OP_COUNT; i++) {
+    if (strcmp(key, load_op_flags[i]) == 0) {
+      params.hz[i] = strtod(val, &end);
+      return errno == 0 && end && *end == '\0' && params.hz[i] >= 0.0;
+    }
+  }
+  unsigned long long v = strtoull(val, &end, 0);
+  if (errno != 0 || !end || *end != '\0')
+    return false;
+  if (strcmp(key, "--duration-ms") == 0)
+    params.duration_ms = (uint32_t)v;
+  else if (strcmp(key, "--windows") == 0 && v >= 1 && v <= LOAD_MAX_WINDOWS)
+    params.windows = (uint32_t)v;
+  else if (strcmp(key, "--transient-depth") == 0 && v <= LOAD_MAX_DEPTH)
+    params.transient_depth = (uint32_t)v;
+  else if (strcmp(key, "--icon-size") == 0 && v <= LOAD_MAX_ICON)
+    params.icon_size = (uint32_t)v;
+  else if (strcmp(key, "--popup-ms") == 0)
+    params.popup_ms = (uint32_t)v;
+  else if (strcmp(key, "--seed") == 0)
+    params.seed = v;
+  else
+    return false;
+  return true;
+}
+
+static void usage(void) {
+  fprintf(stderr,
+          "Usage: load_client [--option value]...\n"
+          "  --duration-ms N      how long to run (default 5000)\n"
+          "  --windows N          toplevels kept alive (default 4, max %d)\n"
+          "  --transient-depth N  transient chain under each toplevel (max %d)\n"
+          "  --icon-size N        _NET_WM_ICON edge in pixels, 0 for none (max %d)\n"
+          "  --popup-ms N         lifetime of override-redirect popups (default 100)\n"
+          "  --seed N             window and geometry choices\n"
+          "Rates, per second across all windows (default 0):\n"
+          "  --churn-hz --title-hz --icon-hz --state-hz --configure-hz --popup-hz\n",
+          LOAD_MAX_WINDOWS, LOAD_MAX_DEPTH, LOAD_MAX_ICON);
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  params.duration_ms = 5000;
+  params.windows = 4;
+  params.popup_ms = 100;
+  params.seed = 1;
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc || !parse_arg(argv[i], argv[i + 1]))
+      usage();
+  }
+  rng_state = params.seed;
+
+  c = xcb_connect(NULL, NULL);
+  if (xcb_connection_has_error(c))
+    fail("cannot connect to X server");
+  screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+  atoms.utf8_string = intern("UTF8_STRING");
+  atoms.net_wm_name = intern("_NET_WM_NAME");
+  atoms.net_wm_icon = intern("_NET_WM_ICON");
+  atoms.net_wm_state = intern("_NET_WM_STATE");
+  atoms.net_wm_window_type = intern("_NET_WM_WINDOW_TYPE");
+  atoms.net_wm_window_type_dialog = intern("_NET_WM_WINDOW_TYPE_DIALOG");
+  atoms.maximized_horz = intern("_NET_WM_STATE_MAXIMIZED_HORZ");
+  for (int i = 0; i < 5; i++)
+    atoms.states[i] = intern(state_atom_names[i]);
+
+  if (params.icon_size) {
+    icon_buf = malloc((2u + params.icon_size * params.icon_size) * sizeof(uint32_t));
+    if (!icon_buf)
+      fail("out of memory");
+  }
+
+  for (uint32_t i = 0; i < params.windows; i++)
+    window_open(&windows[i]);
+  xcb_flush(c);
+
+  uint64_t start = now_ns();
+  uint64_t end = start + (uint64_t)params.duration_ms * 1000000ull;
+  uint64_t period[LOAD_OP_COUNT];
+  uint64_t due[LOAD_OP_COUNT];
+  for (int i = 0; i < LOAD_OP_COUNT; i++) {
+    period[i] = params.hz[i] > 0.0 ? (uint64_t)(1e9 / params.hz[i]) : 0;
+    if (period[i] == 0 && params.hz[i] > 0.0)
+      period[i] = 1;
+    due[i] = start + period[i];
+  }
+
+  uint64_t now = start;
+  while (now < end) {
+    for (int i = 0; i < LOAD_OP_COUNT; i++) {
+      if (!period[i])
+        continue;
+      // Stay on the schedule, but do not burst to catch up after a stall
+      if (now > due[i] + 1000000000ull)
+        due[i] = now;
+      while (due[i] <= now) {
+        run_op((load_op_t)i, now);
+        due[i] += period[i];
+      }
+    }
+    popup_reap(now, false);
+    xcb_flush(c);
+
+    xcb_generic_event_t* ev;
+    while ((ev = xcb_poll_for_event(c))) {
+      if (ev->response_type == 0)
+        x_errors++;
+      free(ev);
+    }
+    if (xcb_connection_has_error(c))
+      fail("X connection lost");
+
+    uint64_t next = end;
+    for (int i = 0; i < LOAD_OP_COUNT; i++) {
+      if (period[i] && due[i] < next)
+        next = due[i];
+    }
+    for (uint32_t i = 0; i < LOAD_MAX_POPUPS; i++) {
+      if (popups[i].win != XCB_NONE && popups[i].expires_ns < next)
+        next = popups[i].expires_ns;
+    }
+    now = now_ns();
+    if (next > now) {
+      struct pollfd pfd = {.fd = xcb_get_file_descriptor(c), .events = POLLIN};
+      poll(&pfd, 1, (int)((next - now + 999999ull) / 1000000ull));
+      now = now_ns();
+    }
+  }
+
+  popup_reap(now, true);
+  for (uint32_t i = 0; i < params.windows; i++)
+    window_close(&windows[i]);
+  free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+  printf("{\"elapsed_ms\":%" PRIu64 ",\"created\":%" PRIu64 ",\"transients\":%" PRIu64, (uint64_t)((now - start) / 1000000ull), created, transients_created);
+  for (int i = 0; i < LOAD_OP_COUNT; i++)
+    printf(",\"%s\":%" PRIu64, load_op_names[i], done[i]);
+  printf(",\"x_errors\":%" PRIu64 "}\n", x_errors);
+
+  free(icon_buf);
+  xcb_disconnect(c);
+  return 0;
+}
@@ -19,8 +19,8 @@ void test_tiny_window_expansion(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
   // Setup basic config
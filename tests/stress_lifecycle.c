@@ -21,23 +21,39 @@ static void stress_cleanup_visitor(void* hot_ptr, void* cold_ptr, handle_t h, vo
     client_render_payload_destroy(cold);
 }
 
+static void stress_setup(server_t* s) {
+  memset(s, 0, sizeof(*s));
+  s->is_test = true;
+  s->conn = xcb_connect(NULL, NULL);
+  atoms_init(s->conn);
+
+  slotmap_init(&s->clients, 1024, sizeof(client_hot_t), sizeof(client_cold_t));
+  hash_map_init(&s->xid_index);
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_init(&s->screens[0].layers[i]);
+  handle_vec_init(&s->active_clients);
+  arena_init(&s->tick_arena, 64 * 1024);
+  cookie_jar_init(&s->cookie_jar);
+  config_init_defaults(&s->config);
+}
+
+static void stress_teardown(server_t* s) {
+  slotmap_for_each_used(&s->clients, stress_cleanup_visitor, s);
+  focus_mru_destroy(&s->focus_mru);
+  slotmap_destroy(&s->clients);
+  hash_map_destroy(&s->xid_index);
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_destroy(&s->screens[0].layers[i]);
+  handle_vec_destroy(&s->active_clients);
+  arena_destroy(&s->tick_arena);
+  cookie_jar_destroy(&s->cookie_jar);
+  config_destroy(&s->config);
+  free(s->conn);
+}
+
 void test_rapid_lifecycle(void) {
   server_t s;
-  memset(&s, 0, sizeof(s));
-  s.is_test = true;
-  s.conn = xcb_connect(NULL, NULL);
-  atoms_init(s.conn);
-
-  slotmap_init(&s.clients, 1024, sizeof(client_hot_t), sizeof(client_cold_t));
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
-  list_init(&s.focus_history);
-  for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
-  small_vec_init(&s.active_clients);
-  arena_init(&s.tick_arena, 64 * 1024);
-  cookie_jar_init(&s.cookie_jar);
-  config_init_defaults(&s.config);
+  stress_setup(&s);
 
   const int ITERATIONS = 50;
   const int WINDOWS_PER_ITER = 10;
@@ -56,6 +72,7 @@ void test_rapid_lifecycle(void) {
     for (int j = 0; j < WINDOWS_PER_ITER; j++) {
       client_hot_t* hot = server_chot(&s, handles[j]);
       hot->state = STATE_READY;
+      server_queue_client(&s, hot);
     }
 
     // Flush (frames windows)
@@ -70,22 +87,142 @@ void test_rapid_lifecycle(void) {
   }
 
   printf("test_rapid_lifecycle passed\n");
+  stress_teardown(&s);
+}
 
-  // Cleanup
-  slotmap_for_each_used(&s.clients, stress_cleanup_visitor, &s);
-  slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
-  for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s.layers[i]);
-  small_vec_destroy(&s.active_clients);
-  arena_destroy(&s.tick_arena);
-  cookie_jar_destroy(&s.cookie_jar);
-  config_destroy(&s.config);
-  free(s.conn);
+/*
+ * The in-process counterpart of scripts/stress-test.py: a seeded mix of
+ * lifecycle churn, title and icon updates, _NET_WM_STATE toggles,
+ * ConfigureRequest storms and transient chains, applied tick by tick.
+ * Rates are operations per tick.
+ */
+typedef struct stress_mix {
+  const char* name;
+  int ticks;
+  int windows;
+  int churn;
+  int titles;
+  int icons;
+  int states;
+  int configures;
+  int transient_depth;
+} stress_mix_t;
+
+static const stress_mix_t stress_mixes[] = {
+    {"ci-browser", 200, 24, 2, 8, 1, 0, 6, 1},
+    {"chat", 200, 6, 0, 4, 1, 2, 0, 0},
+    {"storm", 100, 32, 4, 32, 4, 8, 64, 3},
+};
+
+static uint64_t stress_rng;
+
+static uint32_t stress_below(uint32_t n) {
+  stress_rng = stress_rng * 6364136223846793005ull + 1442695040888963407ull;
+  return (uint32_t)(stress_rng >> 33) % n;
+}
+
+static handle_t stress_open(server_t* s, xcb_window_t win, handle_t parent) {
+  client_manage_start(s, win);
+  handle_t h = server_get_client_by_window(s, win);
+  assert(h != HANDLE_INVALID);
+  client_hot_t* hot = server_chot(s, h);
+  hot->state = STATE_READY;
+  if (parent != HANDLE_INVALID)
+    client_set_transient_for(s, hot, parent);
+  server_queue_client(s, hot);
+  return h;
+}
+
+static void stress_run_mix(const stress_mix_t* mix) {
+  server_t s;
+  stress_setup(&s);
+  stress_rng = 0x6c6f6164u;
+
+  // Each slot heads a chain: chain[w][0] is the toplevel
+  enum { MAX_W = 32, MAX_D = 4 };
+  assert(mix->windows <= MAX_W && mix->transient_depth < MAX_D);
+  handle_t chain[MAX_W][MAX_D];
+  xcb_window_t next_xid = 0x200000;
+  int depth = 1 + mix->transient_depth;
+
+  for (int w = 0; w < mix->windows; w++) {
+    for (int d = 0; d < depth; d++)
+      chain[w][d] = stress_open(&s, next_xid++, d ? chain[w][d - 1] : HANDLE_INVALID);
+  }
+  wm_flush_dirty(&s, monotonic_time_ns());
+
+  for (int t = 0; t < mix->ticks; t++) {
+    for (int i = 0; i < mix->churn; i++) {
+      int w = (int)stress_below((uint32_t)mix->windows);
+      // Parent first: the WM has to cope with orphaned transients
+      for (int d = 0; d < depth; d++)
+        client_unmanage(&s, chain[w][d]);
+      for (int d = 0; d < depth; d++)
+        chain[w][d] = stress_open(&s, next_xid++, d ? chain[w][d - 1] : HANDLE_INVALID);
+    }
+
+    for (int i = 0; i < mix->titles + mix->icons; i++) {
+      handle_t h = chain[stress_below((uint32_t)mix->windows)][stress_below((uint32_t)depth)];
+      xcb_property_notify_event_t ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.window = server_chot(&s, h)->xid;
+      ev.atom = i < mix->titles ? atoms._NET_WM_NAME : atoms._NET_WM_ICON;
+      wm_handle_property_notify(&s, h, &ev);
+    }
+
+    static const xcb_atom_t* const toggles[] = {&atoms._NET_WM_STATE_FULLSCREEN, &atoms._NET_WM_STATE_ABOVE, &atoms._NET_WM_STATE_MAXIMIZED_VERT,
+                                                &atoms._NET_WM_STATE_DEMANDS_ATTENTION};
+    for (int i = 0; i < mix->states; i++) {
+      handle_t h = chain[stress_below((uint32_t)mix->windows)][0];
+      xcb_client_message_event_t ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.response_type = XCB_CLIENT_MESSAGE;
+      ev.format = 32;
+      ev.window = server_chot(&s, h)->xid;
+      ev.type = atoms._NET_WM_STATE;
+      ev.data.data32[0] = 2; /* toggle */
+      ev.data.data32[1] = *toggles[stress_below(4)];
+      wm_handle_client_message(&s, &ev);
+    }
+
+    for (int i = 0; i < mix->configures; i++) {
+      handle_t h = chain[stress_below((uint32_t)mix->windows)][stress_below((uint32_t)depth)];
+      pending_config_t pc = {0};
+      pc.window = server_chot(&s, h)->xid;
+      pc.mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
+      pc.x = (int16_t)stress_below(800);
+      pc.y = (int16_t)stress_below(600);
+      pc.width = (uint16_t)(50 + stress_below(700));
+      pc.height = (uint16_t)(50 + stress_below(500));
+      wm_handle_configure_request(&s, h, &pc);
+    }
+
+    wm_flush_dirty(&s, monotonic_time_ns());
+  }
+
+  // Everything still open is exactly what the mix left open
+  size_t live = (size_t)mix->windows * (size_t)depth;
+  assert(s.active_clients.length == live);
+  for (int w = 0; w < mix->windows; w++) {
+    for (int d = 0; d < depth; d++) {
+      client_hot_t* hot = server_chot(&s, chain[w][d]);
+      assert(hot && server_get_client_by_window(&s, hot->xid) == chain[w][d]);
+      if (d > 0)
+        assert(hot->transient_for == chain[w][d - 1]);
+    }
+  }
+
+  printf("test_mixed_storm %s passed (%zu clients, %d ticks)\n", mix->name, live, mix->ticks);
+  stress_teardown(&s);
+}
+
+void test_mixed_storm(void) {
+  for (size_t i = 0; i < sizeof(stress_mixes) / sizeof(stress_mixes[0]); i++)
+    stress_run_mix(&stress_mixes[i]);
 }
 
 int main(void) {
   test_rapid_lifecycle();
+  test_mixed_storm();
   return 0;
 }
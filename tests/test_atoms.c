@@ -0,0 +1,54 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "xcb_utils.h"
+
+static const char* const expected_names[] = {
+#define NAME(name) #name,
+    HXM_ATOMS(NAME)
+#undef NAME
+};
+
+void test_atom_name_resolves_table(void) {
+  xcb_connection_t* conn = xcb_connect(NULL, NULL);
+  atoms_init(conn);
+
+  const xcb_atom_t* values = (const xcb_atom_t*)&atoms;
+  for (size_t i = 0; i < HXM_ATOM_COUNT; i++) {
+    assert(values[i] != XCB_ATOM_NONE);
+    assert(strcmp(atom_name(values[i]), expected_names[i]) == 0);
+  }
+  assert(strcmp(atom_name(atoms.WM_S0), "WM_S0") == 0);
+  assert(strcmp(atom_name(atoms._HXM_TICK_STATS), "_HXM_TICK_STATS") == 0);
+  assert(strcmp(atom_name(XCB_ATOM_NONE), "NONE") == 0);
+
+  xcb_disconnect(conn);
+  printf("test_atom_name_resolves_table passed\n");
+}
+
+void test_atom_id_tracks_reassignment(void) {
+  xcb_connection_t* conn = xcb_connect(NULL, NULL);
+  atoms_init(conn);
+
+  assert(atom_id(atoms.WM_NAME) == ATOM_ID_WM_NAME);
+  assert(atom_id(atoms._NET_WM_STRUT_PARTIAL) == ATOM_ID__NET_WM_STRUT_PARTIAL);
+  assert(atom_id(XCB_ATOM_NONE) == -1);
+
+  // Values reassigned after atoms_init are found once the index misses
+  xcb_atom_t saved = atoms.WM_NAME;
+  atoms.WM_NAME = 0x7fff0001u;
+  assert(atom_id(0x7fff0001u) == ATOM_ID_WM_NAME);
+  assert(atom_id(0x7fff0002u) == -1);
+  atoms.WM_NAME = saved;
+  assert(atom_id(saved) == ATOM_ID_WM_NAME);
+
+  xcb_disconnect(conn);
+  printf("test_atom_id_tracks_reassignment passed\n");
+}
+
+int main(void) {
+  test_atom_name_resolves_table();
+  test_atom_id_tracks_reassignment();
+  return 0;
+}
@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+script_dir=$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)
+repo_root=$(cd "$script_dir/.." && pwd)
+checker="$repo_root/scripts/ci/check_bench_ds.py"
+
+bench_bin=${BENCH_DS_BIN:-$repo_root/build/bench_ds}
+if [[ ! -x "$bench_bin" ]]; then
+  echo "bench_ds binary missing: $bench_bin" >&2
+  exit 1
+fi
+
+tmpdir=$(mktemp -d)
+cleanup() {
+  rm -rf "$tmpdir"
+}
+trap cleanup EXIT
+
+"$bench_bin" --quick >"$tmpdir/run.json"
+
+# Every primitive is covered at every size
+for name in arena.alloc_reset small_vec.push small_vec.remove small_vec.remove_swap \
+  hash_map.linear.get_hit hash_map.swiss.remove slotmap.paged.iterate \
+  cookie_jar.push cookie_jar.drain cookie_jar.expire; do
+  for n in 10 100 1000 10000; do
+    if ! grep -Fq "\"name\": \"$name\", \"n\": $n," "$tmpdir/run.json"; then
+      echo "missing result: $name n=$n" >&2
+      exit 1
+    fi
+  done
+done
+
+checker_args=()
+if [[ "${BENCH_DS_RELATIVE_ONLY:-0}" == "1" ]]; then
+  checker_args+=(--relative-only)
+fi
+python3 "$checker" "${checker_args[@]}" "$tmpdir/run.json"
+
+# The checker must reject a run that breaks a limit
+python3 - "$tmpdir/run.json" "$tmpdir/slow.json" <<'PY'
+import json, sys
+run = json.load(open(sys.argv[1]))
+for r in run["results"]:
+    if r["name"] == "cookie_jar.drain" and r["n"] == 10000:
+        r["ns_per_op"] *= 1000
+json.dump(run, open(sys.argv[2], "w"))
+PY
+if python3 "$checker" --relative-only "$tmpdir/slow.json" >/dev/null 2>&1; then
+  echo "expected checker to fail on a quadratic drain" >&2
+  exit 1
+fi
+
+echo "test_bench_ds passed"
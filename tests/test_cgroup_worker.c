@@ -0,0 +1,151 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cgroup_worker.h"
+
+static char g_root[64];
+
+static void put(const char* rel, const char* text) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", g_root, rel);
+  // mkdir -p of the parent
+  for (char* p = path + strlen(g_root) + 1; (p = strchr(p, '/')); p++) {
+    *p = '\0';
+    mkdir(path, 0700);
+    *p = '/';
+  }
+  FILE* f = fopen(path, "w");
+  assert(f);
+  fputs(text, f);
+  fclose(f);
+}
+
+static void get(const char* rel, char* out, size_t cap) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", g_root, rel);
+  FILE* f = fopen(path, "r");
+  assert(f);
+  size_t n = fread(out, 1, cap - 1, f);
+  out[n] = '\0';
+  fclose(f);
+}
+
+static void test_parse_and_contains(void) {
+  char out[64];
+  assert(cgroup_parse_proc("12:cpu:/x\n0::/user.slice/app-a.scope\n", out, sizeof(out)));
+  assert(strcmp(out, "/user.slice/app-a.scope") == 0);
+  assert(!cgroup_parse_proc("4:memory:/x\n", out, sizeof(out)));
+  assert(!cgroup_parse_proc("0::\n", out, sizeof(out)));
+
+  assert(cgroup_path_contains("/", "/a"));
+  assert(cgroup_path_contains("/a", "/a"));
+  assert(cgroup_path_contains("/a", "/a/b"));
+  assert(!cgroup_path_contains("/a", "/ab"));
+  assert(!cgroup_path_contains("/a/b", "/a"));
+  printf("test_parse_and_contains passed\n");
+}
+
+static void setup(cgroup_worker_t* w) {
+  memset(w, 0, sizeof(*w));
+  char proc[96], cg[96];
+  snprintf(proc, sizeof(proc), "%s/proc", g_root);
+  snprintf(cg, sizeof(cg), "%s/cg", g_root);
+  w->proc_root = strdup(proc);
+  w->cgroup_root = strdup(cg);
+  w->weight = 400;
+  strcpy(w->self_cgroup, "/user.slice/session.scope");
+}
+
+static void teardown(cgroup_worker_t* w) {
+  free((char*)w->proc_root);
+  free((char*)w->cgroup_root);
+}
+
+static void test_boost_and_demote(void) {
+  put("proc/100/cgroup", "0::/user.slice/app-a.scope\n");
+  put("proc/101/cgroup", "0::/user.slice/app-a.scope\n");
+  put("proc/200/cgroup", "0::/user.slice/app-b.scope\n");
+  put("cg/user.slice/app-a.scope/cpu.weight", "100\n");
+  put("cg/user.slice/app-a.scope/io.weight", "default 100\n");
+  // b has no io controller
+  put("cg/user.slice/app-b.scope/cpu.weight", "50\n");
+
+  cgroup_worker_t w;
+  setup(&w);
+  char buf[64];
+
+  cgroup_worker_apply(&w, 100);
+  get("cg/user.slice/app-a.scope/cpu.weight", buf, sizeof(buf));
+  assert(strcmp(buf, "400") == 0);
+  get("cg/user.slice/app-a.scope/io.weight", buf, sizeof(buf));
+  assert(strcmp(buf, "default 400") == 0);
+  assert(w.boosts == 1);
+
+  // Another window of the same app: nothing to write
+  cgroup_worker_apply(&w, 101);
+  assert(w.boosts == 1 && w.demotes == 0);
+
+  // Focus moves on: a gets its own weights back, b is raised
+  cgroup_worker_apply(&w, 200);
+  get("cg/user.slice/app-a.scope/cpu.weight", buf, sizeof(buf));
+  assert(strcmp(buf, "100") == 0);
+  get("cg/user.slice/app-a.scope/io.weight", buf, sizeof(buf));
+  assert(strcmp(buf, "default 100") == 0);
+  get("cg/user.slice/app-b.scope/cpu.weight", buf, sizeof(buf));
+  assert(strcmp(buf, "400") == 0);
+  assert(w.boosts == 2 && w.demotes == 1);
+
+  // No pid: demote only
+  cgroup_worker_apply(&w, 0);
+  get("cg/user.slice/app-b.scope/cpu.weight", buf, sizeof(buf));
+  assert(strcmp(buf, "50") == 0);
+  assert(w.demotes == 2 && w.boosted[0] == '\0');
+
+  teardown(&w);
+  printf("test_boost_and_demote passed\n");
+}
+
+static void test_shared_and_missing_cgroups_are_skipped(void) {
+  // Same scope as the WM, or a slice above it
+  put("proc/300/cgroup", "0::/user.slice/session.scope\n");
+  put("proc/301/cgroup", "0::/user.slice\n");
+  put("cg/user.slice/session.scope/cpu.weight", "100\n");
+
+  cgroup_worker_t w;
+  setup(&w);
+  cgroup_worker_apply(&w, 300);
+  cgroup_worker_apply(&w, 301);
+  // Exited
+  cgroup_worker_apply(&w, 999);
+  assert(w.skipped == 3 && w.boosts == 0);
+
+  char buf[64];
+  get("cg/user.slice/session.scope/cpu.weight", buf, sizeof(buf));
+  assert(strcmp(buf, "100\n") == 0);
+
+  // Not delegated: counted, left alone
+  put("proc/400/cgroup", "0::/system.slice/locked.service\n");
+  cgroup_worker_apply(&w, 400);
+  assert(w.failed == 1 && w.boosted[0] == '\0');
+
+  teardown(&w);
+  printf("test_shared_and_missing_cgroups_are_skipped passed\n");
+}
+
+int main(void) {
+  strcpy(g_root, "/tmp/hxm_cgroup_XXXXXX");
+  assert(mkdtemp(g_root));
+
+  test_parse_and_contains();
+  test_boost_and_demote();
+  test_shared_and_missing_cgroups_are_skipped();
+
+  char cmd[128];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", g_root);
+  assert(system(cmd) == 0);
+  return 0;
+}
@@ -19,14 +19,12 @@ static void setup_server(server_t* s) {
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
 
-  s->root = 1;
-  s->default_colormap = 555;
+  s->screens[0].root = 1;
+  s->screens[0].default_colormap = 555;
 
-  list_init(&s->focus_history);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+  hash_map_init(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
 
   slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
 }
@@ -47,11 +45,11 @@ static void cleanup_server(server_t* s) {
       }
     }
   }
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  hash_map_destroy(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
   xcb_disconnect(s->conn);
 }
 
@@ -71,14 +69,13 @@ static handle_t add_client(server_t* s, xcb_window_t xid, xcb_window_t frame) {
   hot->state = STATE_MAPPED;
   hot->stacking_index = -1;
   hot->stacking_layer = -1;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
   cold->can_focus = false;
 
-  hash_map_insert(&s->window_to_client, xid, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, frame, handle_to_ptr(h));
+  server_xid_bind(s, xid, XID_CLIENT, h);
+  server_xid_bind(s, frame, XID_FRAME, h);
   return h;
 }
 
@@ -157,6 +154,9 @@ static void test_colormap_windows_update_on_focus(void) {
   slot.data = ((uint64_t)hot->xid << 32) | atoms.WM_COLORMAP_WINDOWS;
 
   wm_handle_reply(&s, &slot, &reply.r, NULL);
+  assert(stub_install_colormap_count == 0);
+  // The focus commit and the new list share one install
+  wm_flush_dirty(&s, monotonic_time_ns());
   assert(stub_install_colormap_count == 1);
   assert(stub_last_installed_colormap == cold->colormap);
 
@@ -177,12 +177,15 @@ static void test_colormap_notify_triggers_install(void) {
   cold->colormap_windows[0] = hot->xid;
 
   wm_set_focus(&s, h);
+  wm_flush_dirty(&s, monotonic_time_ns());
   stub_install_colormap_count = 0;
 
   xcb_colormap_notify_event_t ev;
   memset(&ev, 0, sizeof(ev));
   ev.window = hot->xid;
   wm_handle_colormap_notify(&s, &ev);
+  wm_handle_colormap_notify(&s, &ev);
+  wm_flush_dirty(&s, monotonic_time_ns());
 
   assert(stub_install_colormap_count == 1);
   assert(stub_last_installed_colormap == cold->colormap);
@@ -191,10 +194,58 @@ static void test_colormap_notify_triggers_install(void) {
   cleanup_server(&s);
 }
 
+static void test_colormap_install_coalesces(void) {
+  server_t s;
+  setup_server(&s);
+
+  handle_t a = add_client(&s, 500, 510);
+  handle_t b = add_client(&s, 600, 610);
+  server_ccold(&s, a)->colormap = 50;
+  server_ccold(&s, b)->colormap = 60;
+
+  // Only the client focused at the end of the tick gets its colormap
+  stub_install_colormap_count = 0;
+  xcb_colormap_notify_event_t ev;
+  memset(&ev, 0, sizeof(ev));
+  wm_set_focus(&s, a);
+  ev.window = 500;
+  wm_handle_colormap_notify(&s, &ev);
+  wm_set_focus(&s, b);
+  ev.window = 600;
+  wm_handle_colormap_notify(&s, &ev);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_install_colormap_count == 1);
+  assert(stub_last_installed_colormap == 60);
+
+  // A client on a TrueColor visual has nothing worth installing
+  xcb_visualtype_t truecolor;
+  memset(&truecolor, 0, sizeof(truecolor));
+  truecolor._class = XCB_VISUAL_CLASS_TRUE_COLOR;
+  server_ccold(&s, a)->visual_type = &truecolor;
+  stub_install_colormap_count = 0;
+  wm_set_focus(&s, a);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_install_colormap_count == 0);
+  server_ccold(&s, a)->visual_type = NULL;
+
+  // Nor does any client when the screen has only static visuals
+  s.screens[0].colormaps_static = true;
+  wm_set_focus(&s, b);
+  wm_handle_colormap_notify(&s, &ev);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  wm_set_focus(&s, HANDLE_INVALID);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_install_colormap_count == 0);
+
+  printf("test_colormap_install_coalesces passed\n");
+  cleanup_server(&s);
+}
+
 int main(void) {
   test_colormap_fallback_install();
   test_colormap_windows_list_install();
   test_colormap_windows_update_on_focus();
   test_colormap_notify_triggers_install();
+  test_colormap_install_coalesces();
   return 0;
 }
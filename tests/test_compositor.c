@@ -0,0 +1,264 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "client.h"
+#include "compositor.h"
+#include "config.h"
+#include "event.h"
+#include "hxm.h"
+#include "slotmap.h"
+#include "wm.h"
+#include "xcb_utils.h"
+
+extern int stub_composite_redirect_subwindows_count;
+extern int stub_composite_unredirect_subwindows_count;
+extern int stub_damage_create_count;
+extern int stub_damage_destroy_count;
+void xcb_stubs_reset(void);
+void xcb_stubs_set_selection_owner(xcb_window_t owner);
+xcb_window_t xcb_stubs_get_selection_owner(void);
+
+#define SCREEN_W 1920
+#define SCREEN_H 1080
+
+static void setup_server(server_t* s) {
+  xcb_stubs_reset();
+  memset(s, 0, sizeof(*s));
+  s->is_test = true;
+  s->screens[0].root = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
+  s->conn = (xcb_connection_t*)malloc(1);
+  s->screens[0].supporting_wm_check = 5;
+  s->composite_supported = true;
+  s->damage_supported = true;
+  config_init_defaults(&s->config);
+  s->config.compositor = true;
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_init(&s->screens[0].layers[i]);
+  hash_map_init(&s->xid_index);
+  slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
+  cookie_jar_init(&s->cookie_jar);
+  s->focused_client = HANDLE_INVALID;
+}
+
+static void cleanup_server(server_t* s) {
+  compositor_stop(s);
+  cookie_jar_destroy(&s->cookie_jar);
+  slotmap_destroy(&s->clients);
+  hash_map_destroy(&s->xid_index);
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_destroy(&s->screens[0].layers[i]);
+  config_destroy(&s->config);
+  free(s->conn);
+}
+
+static void send_create(server_t* s, xcb_window_t win, int16_t x, int16_t y, uint16_t w, uint16_t h) {
+  xcb_create_notify_event_t e = {0};
+  e.response_type = XCB_CREATE_NOTIFY;
+  e.parent = s->screens[0].root;
+  e.window = win;
+  e.x = x;
+  e.y = y;
+  e.width = w;
+  e.height = h;
+  compositor_observe(s, (xcb_generic_event_t*)&e);
+}
+
+static void send_map(server_t* s, xcb_window_t win) {
+  xcb_map_notify_event_t e = {0};
+  e.response_type = XCB_MAP_NOTIFY;
+  e.event = s->screens[0].root;
+  e.window = win;
+  compositor_observe(s, (xcb_generic_event_t*)&e);
+}
+
+static void send_configure(server_t* s, xcb_window_t win, int16_t x, int16_t y, uint16_t w, uint16_t h, xcb_window_t above) {
+  xcb_configure_notify_event_t e = {0};
+  e.response_type = XCB_CONFIGURE_NOTIFY;
+  e.event = s->screens[0].root;
+  e.window = win;
+  e.above_sibling = above;
+  e.x = x;
+  e.y = y;
+  e.width = w;
+  e.height = h;
+  compositor_observe(s, (xcb_generic_event_t*)&e);
+}
+
+static handle_t add_framed_client(server_t* s, layer_t layer) {
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s->clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = (client_hot_t*)hot_ptr;
+  client_cold_t* cold = (client_cold_t*)cold_ptr;
+  memset(hot, 0, sizeof(*hot));
+  memset(cold, 0, sizeof(*cold));
+  hot->self = h;
+  hot->xid = 1000 + handle_index(h);
+  hot->frame = 2000 + handle_index(h);
+  hot->state = STATE_MAPPED;
+  hot->frame_vis = FRAME_VIS_MAPPED;
+  hot->layer = layer;
+  hot->flags = CLIENT_FLAG_UNDECORATED;
+  hot->server = (rect_t){0, 0, SCREEN_W, SCREEN_H};
+  server_xid_bind(s, hot->xid, XID_CLIENT, h);
+  server_xid_bind(s, hot->frame, XID_FRAME, h);
+  handle_vec_push(&s->screens[0].layers[layer], h);
+
+  send_create(s, hot->frame, 0, 0, SCREEN_W, SCREEN_H);
+  send_map(s, hot->frame);
+  return h;
+}
+
+static void test_start_stop(void) {
+  server_t s;
+  setup_server(&s);
+
+  assert(compositor_enabled(&s));
+  assert(compositor_start(&s));
+  assert(s.compositor.active);
+  assert(stub_composite_redirect_subwindows_count == 1);
+  assert(xcb_stubs_get_selection_owner() == s.screens[0].supporting_wm_check);
+  assert(s.compositor.w == SCREEN_W && s.compositor.h == SCREEN_H);
+  // The first paint covers the whole screen
+  assert(s.compositor.damage.count == 1);
+  assert(s.compositor.damage.rects[0].w == SCREEN_W);
+
+  compositor_stop(&s);
+  assert(!s.compositor.active);
+  assert(stub_composite_unredirect_subwindows_count == 1);
+  assert(xcb_stubs_get_selection_owner() == XCB_NONE);
+
+  // Someone else composites already
+  xcb_stubs_set_selection_owner(777);
+  assert(!compositor_start(&s));
+  assert(!s.compositor.active);
+  assert(stub_composite_redirect_subwindows_count == 1);
+
+  cleanup_server(&s);
+  printf("test_start_stop passed\n");
+}
+
+static void test_window_tracking(void) {
+  server_t s;
+  setup_server(&s);
+  assert(compositor_start(&s));
+  assert(compositor_paint(&s, 1000));
+  assert(dirty_rects_empty(&s.compositor.damage));
+
+  // Created unmapped: nothing to repaint, no Damage object yet
+  send_create(&s, 500, 10, 20, 100, 50);
+  assert(dirty_rects_empty(&s.compositor.damage));
+  assert(stub_damage_create_count == 0);
+
+  send_map(&s, 500);
+  assert(stub_damage_create_count == 1);
+  assert(s.compositor.damage.count == 1);
+  assert(s.compositor.damage.rects[0].x == 10 && s.compositor.damage.rects[0].y == 20);
+  assert(s.compositor.damage.rects[0].w == 100 && s.compositor.damage.rects[0].h == 50);
+  dirty_rects_reset(&s.compositor.damage);
+
+  // Window damage is moved to screen coordinates
+  dirty_rects_t region = dirty_rects_make(5, 5, 10, 10);
+  compositor_note_damage(&s, 500, &region);
+  assert(s.compositor.damage.count == 1);
+  assert(s.compositor.damage.rects[0].x == 15 && s.compositor.damage.rects[0].y == 25);
+  assert(s.compositor.damage_events == 1);
+  dirty_rects_reset(&s.compositor.damage);
+
+  // A move repaints where it was and where it is
+  send_configure(&s, 500, 600, 400, 100, 50, XCB_NONE);
+  assert(s.compositor.damage.count == 2);
+  dirty_rects_reset(&s.compositor.damage);
+
+  xcb_unmap_notify_event_t un = {0};
+  un.response_type = XCB_UNMAP_NOTIFY;
+  un.event = s.screens[0].root;
+  un.window = 500;
+  compositor_observe(&s, (xcb_generic_event_t*)&un);
+  assert(stub_damage_destroy_count == 1);
+  assert(s.compositor.damage.count == 1);
+  assert(s.compositor.damage.rects[0].x == 600);
+
+  xcb_destroy_notify_event_t de = {0};
+  de.response_type = XCB_DESTROY_NOTIFY;
+  de.event = s.screens[0].root;
+  de.window = 500;
+  compositor_observe(&s, (xcb_generic_event_t*)&de);
+  assert(hash_map_size(&s.compositor.windows) == 0);
+  assert(s.compositor.order_len == 0);
+
+  cleanup_server(&s);
+  printf("test_window_tracking passed\n");
+}
+
+static void test_occlusion_and_pacing(void) {
+  server_t s;
+  setup_server(&s);
+  assert(compositor_start(&s));
+  assert(compositor_paint(&s, 1000));
+
+  add_framed_client(&s, LAYER_NORMAL);
+  add_framed_client(&s, LAYER_ABOVE);
+  send_create(&s, 600, 0, 0, 50, 50);
+  send_map(&s, 600);
+
+  // The upper frame hides the lower one and the background
+  uint64_t now = 1000 + 1000000000ull;
+  assert(compositor_paint(&s, now));
+  assert(s.compositor.windows_occluded == 1);
+  assert(s.compositor.windows_painted == 2);
+
+  // Damage sooner than one refresh later waits for a timer
+  dirty_rects_t region = dirty_rects_make(0, 0, 10, 10);
+  compositor_note_damage(&s, 600, &region);
+  assert(!compositor_paint(&s, now + 1000000));
+  assert(wheel_timer_pending(&s.wake_timer));
+  assert(!dirty_rects_empty(&s.compositor.damage));
+  assert(compositor_paint(&s, now + 1000000000ull / 60 + 1));
+  assert(s.compositor.paints == 3);
+
+  timer_wheel_cancel(&s.timers, &s.wake_timer);
+  cleanup_server(&s);
+  printf("test_occlusion_and_pacing passed\n");
+}
+
+static void test_fullscreen_unredirect(void) {
+  server_t s;
+  setup_server(&s);
+  assert(compositor_start(&s));
+
+  handle_t h = add_framed_client(&s, LAYER_FULLSCREEN);
+  s.focused_client = h;
+  int destroyed = stub_damage_destroy_count;
+  assert(compositor_paint(&s, 1000));
+  assert(s.compositor.suspended);
+  assert(stub_composite_unredirect_subwindows_count == 1);
+  assert(stub_damage_destroy_count == destroyed + 1);
+  assert(s.compositor.paints == 0);
+
+  // Asking to stay composited brings the compositor back
+  client_cold_t* cold = server_ccold(&s, h);
+  cold->bypass_compositor_valid = true;
+  cold->bypass_compositor = 2;
+  assert(compositor_paint(&s, 2000));
+  assert(!s.compositor.suspended);
+  assert(stub_composite_redirect_subwindows_count == 2);
+  assert(s.compositor.damage.rects[0].w == SCREEN_W);
+  assert(compositor_paint(&s, 3000));
+  assert(s.compositor.paints == 1);
+  assert(s.compositor.suspends == 1);
+
+  cleanup_server(&s);
+  printf("test_fullscreen_unredirect passed\n");
+}
+
+int main(void) {
+  test_start_stop();
+  test_window_tracking();
+  test_occlusion_and_pacing();
+  test_fullscreen_unredirect();
+  return 0;
+}
@@ -1,13 +1,18 @@
 #include <X11/keysym.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <xkbcommon/xkbcommon.h>
 
 #include "client.h"
 #include "config.h"
+#include "config_cache.h"
+#include "config_watch.h"
 #include "hxm.h"
 
 // Helper to write content to a temp file
@@ -28,10 +33,13 @@ static void test_defaults(void) {
 
   assert(c.desktop_count == 4);
   assert(c.theme.border_width == 2);
-  assert(strcmp(c.font_name, "fixed") == 0);
+  assert(strcmp(c.font_name, "Sans Bold 10") == 0);
   assert(c.focus_raise == true);
   assert(c.focus_follows_mouse == false);
+  assert(c.focus_hover_delay_ms == 0);
   assert(c.fullscreen_use_workarea == false);
+  assert(c.frame_backing == false);
+  assert(c.render_thread == false);
   assert(c.key_bindings.length > 0);
 
   // Verify specific default keybinds
@@ -55,6 +63,10 @@ static void test_load_simple(void) {
       "font_name=Monospace 12\n"
       "focus_raise=false\n"
       "focus_follows_mouse=true\n"
+      "focus_hover_delay_ms=120\n"
+      "focus_hover_speed=300\n"
+      "frame_backing=true\n"
+      "render_thread=1\n"
       "active_bg=#FF0000\n"
       "desktop_names=Web,Code,Music\n";
 
@@ -70,6 +82,10 @@ static void test_load_simple(void) {
   assert(strcmp(c.font_name, "Monospace 12") == 0);
   assert(!c.focus_raise);
   assert(c.focus_follows_mouse);
+  assert(c.focus_hover_delay_ms == 120);
+  assert(c.focus_hover_speed == 300);
+  assert(c.frame_backing);
+  assert(c.render_thread);
   assert(c.theme.window_active_title.color == 0xFF0000);
 
   assert(c.desktop_names_count == 3);
@@ -88,7 +104,9 @@ static void test_keybinds(void) {
       "clear_keybinds=\n"  // Should clear defaults
       "keybind=Mod4+Shift+q : close\n"
       "keybind=Control+Alt+t : exec terminal\n"
-      "keybind=Mod1+Tab:focus_next\n";  // Minimal spaces
+      "keybind=Mod1+Tab:focus_next\n"  // Minimal spaces
+      "keybind=Super+Right repeat=150 : workspace_next\n"
+      "keybind=Super+Left repeat=x : workspace_prev\n";  // Bad cap: dropped
 
   char* path = write_temp_file(content);
 
@@ -97,7 +115,7 @@ static void test_keybinds(void) {
   bool res = config_load(&c, path);
   assert(res);
 
-  assert(c.key_bindings.length == 3);
+  assert(c.key_bindings.length == 4);
 
   // Check 1: Mod4+Shift+q -> close
   key_binding_t* b1 = c.key_bindings.items[0];
@@ -113,6 +131,14 @@ static void test_keybinds(void) {
   assert(b2->keysym == XK_t);
   assert(b2->action == ACTION_EXEC);
   assert(strcmp(b2->exec_cmd, "terminal") == 0);
+  assert(b2->repeat_ms == 0);
+
+  // Check 3: repeat cap after the key
+  key_binding_t* b4 = c.key_bindings.items[3];
+  assert(b4->modifiers == XCB_MOD_MASK_4);
+  assert(b4->keysym == XK_Right);
+  assert(b4->action == ACTION_WORKSPACE_NEXT);
+  assert(b4->repeat_ms == 150);
 
   config_destroy(&c);
   unlink(path);
@@ -214,6 +240,195 @@ static void test_missing_file(void) {
   printf("test_missing_file passed\n");
 }
 
+static uint32_t diff_after_load(const char* content) {
+  char* path = write_temp_file(content);
+  config_t base, next;
+  config_init_defaults(&base);
+  config_init_defaults(&next);
+  assert(config_load(&next, path));
+  uint32_t changed = config_diff(&base, &next);
+  config_destroy(&base);
+  config_destroy(&next);
+  unlink(path);
+  free(path);
+  return changed;
+}
+
+static void test_config_diff(void) {
+  config_t a, b;
+  config_init_defaults(&a);
+  config_init_defaults(&b);
+  assert(config_diff(&a, &b) == 0);
+  config_destroy(&a);
+  config_destroy(&b);
+
+  // Each edit lands in exactly its own section
+  assert(diff_after_load("keybind=Mod4+q : close\n") == CONFIG_SECTION_KEYS);
+  assert(diff_after_load("active_bg=#123456\n") == CONFIG_SECTION_THEME);
+  assert(diff_after_load("border_width=7\n") == CONFIG_SECTION_THEME);
+  assert(diff_after_load("desktop_names=one,two\n") == CONFIG_SECTION_DESKTOPS);
+  assert(diff_after_load("rule=class:Foo -> desktop:1\n") == CONFIG_SECTION_RULES);
+  assert(diff_after_load("focus_follows_mouse=true\n") == CONFIG_SECTION_POLICY);
+  assert(diff_after_load("focus_hover_delay_ms=80\n") == CONFIG_SECTION_POLICY);
+  assert(diff_after_load("snap_threshold_px=40\n") == CONFIG_SECTION_SNAP);
+  assert(diff_after_load("snap_split_percent=33\n") == CONFIG_SECTION_SNAP);
+  assert(diff_after_load("snap_edge_resistance_px=0\n") == CONFIG_SECTION_SNAP);
+  assert(diff_after_load("interactive_max_hz=60\n") == CONFIG_SECTION_POLICY);
+  assert(diff_after_load("interactive_outline=auto\n") == CONFIG_SECTION_POLICY);
+  assert(diff_after_load("rule=class:Foo -> outline:true\n") == CONFIG_SECTION_RULES);
+  assert(diff_after_load("# nothing\n") == 0);
+
+  printf("test_config_diff passed\n");
+}
+
+static void test_config_watch(void) {
+  config_watch_t w;
+  if (!config_watch_init(&w)) {
+    printf("test_config_watch skipped (no inotify)\n");
+    return;
+  }
+
+  char dir[] = "/tmp/hxm_test_watch_XXXXXX";
+  assert(mkdtemp(dir));
+  config_watch_add_dir(&w, dir);
+
+  char path[256];
+  snprintf(path, sizeof(path), "%s/unrelated", dir);
+  FILE* f = fopen(path, "w");
+  assert(f);
+  fclose(f);
+  config_watch_handle_inotify(&w);
+  assert(w.pending == 0);
+  unlink(path);
+
+  // Two writes in a burst settle into one reload of both files
+  snprintf(path, sizeof(path), "%s/themerc", dir);
+  f = fopen(path, "w");
+  assert(f);
+  fputs("border.width: 3\n", f);
+  fclose(f);
+  char menu_path[256];
+  snprintf(menu_path, sizeof(menu_path), "%s/menu.conf", dir);
+  f = fopen(menu_path, "w");
+  assert(f);
+  fclose(f);
+
+  config_watch_handle_inotify(&w);
+  assert(w.pending == (CONFIG_WATCH_THEME | CONFIG_WATCH_MENU));
+  assert(config_watch_take(&w) == 0);  // still debouncing
+
+  struct pollfd pfd = {.fd = w.timer_fd, .events = POLLIN};
+  assert(poll(&pfd, 1, 5000) == 1);
+  config_watch_handle_timer(&w);
+  assert(config_watch_take(&w) == (CONFIG_WATCH_THEME | CONFIG_WATCH_MENU));
+  assert(config_watch_take(&w) == 0);
+
+  unlink(path);
+  unlink(menu_path);
+  rmdir(dir);
+  config_watch_destroy(&w);
+  printf("test_config_watch passed\n");
+}
+
+static void write_file(const char* path, const char* content) {
+  FILE* f = fopen(path, "w");
+  assert(f);
+  fputs(content, f);
+  fclose(f);
+}
+
+static void test_config_cache(void) {
+  char dir[] = "/tmp/hxm_test_cache_XXXXXX";
+  assert(mkdtemp(dir));
+  char cache_dir[256];
+  snprintf(cache_dir, sizeof(cache_dir), "%s/cache", dir);
+  setenv("XDG_CACHE_HOME", cache_dir, 1);
+
+  // Candidate order as the loaders use it: an override first, then the file
+  char override[256];
+  char path[256];
+  snprintf(override, sizeof(override), "%s/override.conf", dir);
+  snprintf(path, sizeof(path), "%s/hxm.conf", dir);
+  write_file(path,
+             "font_name=Monospace 9\n"
+             "desktop_names=Web,Code\n"
+             "keybind=Mod4+Shift+q : close\n"
+             "keybind=Control+Alt+t : exec terminal\n"
+             "rule=class:Foo -> desktop:1\n"
+             "rule=title:Bar -> layer:above, focus:no\n"
+             "snap_threshold_px=40\n");
+
+  config_cache_sources_t* src = malloc(sizeof(*src));
+  assert(src);
+  config_cache_sources_init(src);
+  assert(config_cache_sources_add(src, "%s", override));
+  assert(config_cache_sources_add(src, "%s", path));
+
+  config_t parsed;
+  config_init_defaults(&parsed);
+  assert(!config_cache_load_config(&parsed, src));  // nothing stored yet
+  config_cache_stamp(src);
+  assert(config_load(&parsed, path));
+  config_cache_store_config(&parsed, src);
+
+  // A hit decodes to the same values, with its own strings and rule index
+  config_t cached;
+  config_init_defaults(&cached);
+  assert(config_cache_load_config(&cached, src));
+  assert(config_diff(&parsed, &cached) == 0);
+  assert(cached.font_name != parsed.font_name && strcmp(cached.font_name, "Monospace 9") == 0);
+  assert(cached.rule_set.built && cached.rule_set.count == 2);
+  config_destroy(&cached);
+
+  // A new mtime with the same bytes is still a hit
+  struct timespec times[2] = {{.tv_sec = 1000000000, .tv_nsec = 0}, {.tv_sec = 1000000000, .tv_nsec = 0}};
+  assert(utimensat(AT_FDCWD, path, times, 0) == 0);
+  config_init_defaults(&cached);
+  assert(config_cache_load_config(&cached, src));
+  assert(config_diff(&parsed, &cached) == 0);
+
+  // An edit, or a candidate appearing ahead of the file, is a miss that
+  // leaves the config untouched
+  write_file(path, "font_name=Monospace 8\n");
+  assert(!config_cache_load_config(&cached, src));
+  assert(strcmp(cached.font_name, "Monospace 9") == 0);
+  config_cache_stamp(src);
+  config_cache_store_config(&parsed, src);
+  assert(config_cache_load_config(&cached, src));
+  write_file(override, "# empty\n");
+  assert(!config_cache_load_config(&cached, src));
+
+  // An entry written by another build is a miss too
+  char cache_path[300];
+  snprintf(cache_path, sizeof(cache_path), "%s/hxm/config.cache", cache_dir);
+  config_cache_stamp(src);
+  config_cache_store_config(&parsed, src);
+  assert(config_cache_load_config(&cached, src));
+  int fd = open(cache_path, O_RDWR);
+  assert(fd >= 0);
+  uint64_t build_id;
+  const off_t build_id_off = 24;  // after magic, kind, source_count and payload_len
+  assert(pread(fd, &build_id, sizeof(build_id), build_id_off) == (ssize_t)sizeof(build_id));
+  assert(build_id != 0);
+  build_id ^= 1;
+  assert(pwrite(fd, &build_id, sizeof(build_id), build_id_off) == (ssize_t)sizeof(build_id));
+  close(fd);
+  assert(!config_cache_load_config(&cached, src));
+  config_destroy(&cached);
+  config_destroy(&parsed);
+
+  unlink(cache_path);
+  snprintf(cache_path, sizeof(cache_path), "%s/hxm", cache_dir);
+  rmdir(cache_path);
+  rmdir(cache_dir);
+  unlink(override);
+  unlink(path);
+  rmdir(dir);
+  unsetenv("XDG_CACHE_HOME");
+  free(src);
+  printf("test_config_cache passed\n");
+}
+
 int main(void) {
   test_defaults();
   test_load_simple();
@@ -222,5 +437,8 @@ int main(void) {
   test_theme();
   test_invalid();
   test_missing_file();
+  test_config_diff();
+  test_config_watch();
+  test_config_cache();
   return 0;
 }
@@ -42,23 +42,21 @@ static void setup_server(server_t* s) {
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
 
-  s->root = 1;
-  s->root_visual = 1;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
 
   config_init_defaults(&s->config);
   s->config.theme.border_width = 2;
   s->config.theme.title_height = 10;
 
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
-  list_init(&s->focus_history);
+  hash_map_init(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
 
   slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
-  small_vec_init(&s->active_clients);
+  handle_vec_init(&s->active_clients);
   arena_init(&s->tick_arena, 4096);
 }
 
@@ -75,17 +73,16 @@ static void cleanup_server(server_t* s) {
       client_render_payload_destroy(cold);
     }
   }
-  if (s->monitors) {
-    free(s->monitors);
-    s->monitors = NULL;
-    s->monitor_count = 0;
+  if (s->screens[0].monitors) {
+    free(s->screens[0].monitors);
+    s->screens[0].monitors = NULL;
+    s->screens[0].monitor_count = 0;
   }
   slotmap_destroy(&s->clients);
-  small_vec_destroy(&s->active_clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  handle_vec_destroy(&s->active_clients);
+  hash_map_destroy(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
   arena_destroy(&s->tick_arena);
   config_destroy(&s->config);
   xcb_disconnect(s->conn);
@@ -113,13 +110,12 @@ static handle_t add_client(server_t* s, xcb_window_t win, xcb_window_t frame) {
   hot->server = hot->desired;
   hot->stacking_index = -1;
   hot->stacking_layer = -1;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s->window_to_client, win, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, frame, handle_to_ptr(h));
-  small_vec_push(&s->active_clients, handle_to_ptr(h));
+  server_xid_bind(s, win, XID_CLIENT, h);
+  server_xid_bind(s, frame, XID_FRAME, h);
+  handle_vec_push(&s->active_clients, h);
 
   return h;
 }
@@ -303,7 +299,7 @@ static void test_synthetic_configure_notify_sent(void) {
   client_hot_t* hot = server_chot(&s, h);
 
   stub_send_event_count = 0;
-  hot->dirty |= DIRTY_GEOM;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
   wm_flush_dirty(&s, monotonic_time_ns());
 
   assert(stub_send_event_count == 1);
@@ -315,6 +311,42 @@ static void test_synthetic_configure_notify_sent(void) {
   cleanup_server(&s);
 }
 
+static void test_synthetic_configure_notify_suppressed_when_unchanged(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  handle_t h = add_client(&s, 3002, 3102);
+  client_hot_t* hot = server_chot(&s, h);
+
+  stub_send_event_count = 0;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_send_event_count == 1);
+  assert(s.synthetic_sent == 1);
+
+  // Recommitting the same geometry (a restack, frame extents rewrite) says nothing
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_send_event_count == 1);
+  assert(s.synthetic_suppressed == 1);
+  assert(!(hot->dirty & DIRTY_SYNTHETIC_CONFIGURE));
+
+  // Several moves before a flush produce one event, at the final position
+  hot->desired.x = 40;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
+  hot->desired.x = 70;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_send_event_count == 2);
+  assert(s.synthetic_sent == 2);
+  xcb_configure_notify_event_t* ev = (xcb_configure_notify_event_t*)stub_last_event;
+  assert(ev->x == hot->server.x + (int16_t)s.config.theme.border_width);
+
+  printf("test_synthetic_configure_notify_suppressed_when_unchanged passed\n");
+  cleanup_server(&s);
+}
+
 static void test_configure_request_ignores_border_and_stack_fields(void) {
   server_t s;
   setup_server(&s);
@@ -390,18 +422,18 @@ static void test_panel_clamps_to_monitor_bounds(void) {
   setup_server(&s);
   xcb_stubs_reset();
 
-  s.workarea = (rect_t){10, 10, 100, 100};
-  s.monitors = calloc(1, sizeof(monitor_t));
-  s.monitor_count = 1;
-  s.monitors[0].geom = (rect_t){0, 0, 200, 200};
-  s.monitors[0].workarea = (rect_t){10, 10, 100, 100};
+  s.screens[0].workarea = (rect_t){10, 10, 100, 100};
+  s.screens[0].monitors = calloc(1, sizeof(monitor_t));
+  s.screens[0].monitor_count = 1;
+  s.screens[0].monitors[0].geom = (rect_t){0, 0, 200, 200};
+  s.screens[0].monitors[0].workarea = (rect_t){10, 10, 100, 100};
 
   handle_t h = add_client(&s, 6001, 6101);
   client_hot_t* hot = server_chot(&s, h);
   hot->type = WINDOW_TYPE_DESKTOP;
   hot->flags |= CLIENT_FLAG_UNDECORATED;
   hot->desired = (rect_t){150, 170, 80, 50};
-  hot->dirty |= DIRTY_GEOM;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
 
   stub_config_calls_len = 0;
   wm_flush_dirty(&s, monotonic_time_ns());
@@ -655,6 +687,7 @@ static void test_interactive_resize_configures_client_even_when_notify_matches(v
   client_hot_t* hot = server_chot(&s, h);
   hot->desired = (rect_t){10, 20, 180, 130};
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&s, hot);
 
   s.interaction_mode = INTERACTION_RESIZE;
   s.interaction_window = hot->frame;
@@ -686,6 +719,7 @@ static void test_configure_notify_does_not_resync_desired_during_interactive_res
   server_ccold(&s, h)->manage_phase = MANAGE_DONE;
   hot->desired = (rect_t){10, 20, 220, 140};
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&s, hot);
 
   s.interaction_mode = INTERACTION_RESIZE;
   s.interaction_window = hot->frame;
@@ -805,6 +839,7 @@ static void test_configure_request_ignores_committed_echo(void) {
   hot->server = (rect_t){10, 20, 100, 80};
   hot->desired = (rect_t){30, 40, 220, 140};
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&s, hot);
 
   pending_config_t pc = {0};
   pc.window = hot->xid;
@@ -838,12 +873,68 @@ static void test_configure_request_ignores_committed_echo(void) {
   cleanup_server(&s);
 }
 
+static void test_drag_holds_other_clients_until_bound(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  handle_t dragged = add_client(&s, 7201, 7301);
+  handle_t other = add_client(&s, 7202, 7302);
+  client_hot_t* dhot = server_chot(&s, dragged);
+  client_hot_t* ohot = server_chot(&s, other);
+
+  s.interaction_mode = INTERACTION_RESIZE;
+  s.interaction_window = dhot->frame;
+  s.interaction_handle = dragged;
+
+  // The first tick of the drag is a full pass
+  uint64_t now = monotonic_time_ns();
+  wm_flush_dirty(&s, now);
+  assert(s.full_flush_ns == now);
+
+  // Then only the dragged client moves; the other waits on the worklist
+  now += 10000000ull;
+  dhot->desired.w = 150;
+  server_mark_dirty(&s, dhot, DIRTY_GEOM);
+  ohot->desired.w = 120;
+  server_mark_dirty(&s, ohot, DIRTY_GEOM);
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
+  wm_flush_dirty(&s, now);
+  assert(dhot->server.w == 150u);
+  assert(ohot->server.w == 100u);
+  assert(ohot->dirty & DIRTY_GEOM);
+  assert(s.screens[0].root_dirty & ROOT_DIRTY_CLIENT_LIST_STACKING);
+  assert(s.interaction_qos_ticks == 1);
+
+  // interactive_defer_ms bounds the hold
+  now += (uint64_t)s.config.interactive_defer_ms * 1000000ull;
+  wm_flush_dirty(&s, now);
+  assert(ohot->server.w == 120u);
+  assert(!(s.screens[0].root_dirty & ROOT_DIRTY_CLIENT_LIST_STACKING));
+  assert(s.full_flush_ns == now);
+
+  // Release commits at once
+  now += 1000000ull;
+  ohot->desired.w = 140;
+  server_mark_dirty(&s, ohot, DIRTY_GEOM);
+  wm_flush_dirty(&s, now);
+  assert(ohot->server.w == 120u);
+  s.interaction_mode = INTERACTION_NONE;
+  now += 1000000ull;
+  wm_flush_dirty(&s, now);
+  assert(ohot->server.w == 140u);
+
+  printf("test_drag_holds_other_clients_until_bound passed\n");
+  cleanup_server(&s);
+}
+
 int main(void) {
   test_configure_request_applies_and_extents();
   test_configure_request_mask_respects_existing();
   test_configure_request_min_size_clamps();
   test_geometry_reply_tiny_fallback();
   test_synthetic_configure_notify_sent();
+  test_synthetic_configure_notify_suppressed_when_unchanged();
   test_configure_request_ignores_border_and_stack_fields();
   test_panel_configure_request_skips_min_constraints();
   test_panel_clamps_to_monitor_bounds();
@@ -858,5 +949,6 @@ int main(void) {
   test_configure_request_not_ignored_before_pointer_grab_ack();
   test_configure_request_ignored_during_interactive_move();
   test_configure_request_ignores_committed_echo();
+  test_drag_holds_other_clients_until_bound();
   return 0;
 }
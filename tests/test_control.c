@@ -0,0 +1,223 @@
+/*
+ * Tests for the control socket snapshots and its request/response loop
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "client.h"
+#include "control.h"
+#include "cookie_jar.h"
+#include "event.h"
+#include "str_intern.h"
+
+extern void xcb_stubs_reset(void);
+
+static void setup_server(server_t* s) {
+  memset(s, 0, sizeof(server_t));
+  s->is_test = true;
+
+  xcb_stubs_reset();
+  s->conn = xcb_connect(NULL, NULL);
+  slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
+  cookie_jar_init(&s->cookie_jar);
+  handle_vec_init(&s->active_clients);
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_init(&s->screens[0].layers[i]);
+  control_init(&s->control);
+}
+
+static void teardown_server(server_t* s) {
+  for (size_t i = 0; i < s->active_clients.length; i++) {
+    client_cold_t* cold = server_ccold(s, s->active_clients.items[i]);
+    free(cold->title);
+    str_intern_release(cold->wm_class);
+  }
+  handle_vec_destroy(&s->active_clients);
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_destroy(&s->screens[0].layers[i]);
+  focus_mru_destroy(&s->focus_mru);
+  cookie_jar_destroy(&s->cookie_jar);
+  slotmap_destroy(&s->clients);
+  xcb_disconnect(s->conn);
+}
+
+static handle_t add_client(server_t* s, xcb_window_t xid, const char* title) {
+  void* hot_ptr = NULL;
+  void* cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s->clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = hot_ptr;
+  client_cold_t* cold = cold_ptr;
+  hot->self = h;
+  hot->xid = xid;
+  hot->frame = xid + 1u;
+  hot->state = STATE_MAPPED;
+  hot->layer = LAYER_NORMAL;
+  hot->stacking_layer = -1;
+  hot->dirty = DIRTY_TITLE;
+  cold->title = strdup(title);
+  cold->wm_class = str_intern("xterm");
+  handle_vec_push(&s->active_clients, h);
+  handle_vec_push(&s->screens[0].layers[LAYER_NORMAL], h);
+  return h;
+}
+
+static void test_snapshot_sections(void) {
+  server_t s;
+  setup_server(&s);
+  handle_t a = add_client(&s, 0x400001, "plain");
+  add_client(&s, 0x500001, "say \"hi\"\n");
+  s.focused_client = a;
+  focus_mru_insert_after(&s.focus_mru, 0, a);
+
+  size_t len = 0;
+  char* json = control_snapshot(&s, "clients", &len);
+  assert(json && len == strlen(json));
+  assert(strncmp(json, "{\"clients\":[", 12) == 0);
+  assert(strstr(json, "\"xid\":4194305,\"frame\":4194306,\"state\":\"mapped\""));
+  assert(strstr(json, "\"layer\":\"normal\""));
+  assert(strstr(json, "\"title\":\"say \\\"hi\\\"\\u000a\""));
+  assert(json[len - 1] == '\n');
+  free(json);
+
+  json = control_snapshot(&s, "layers", NULL);
+  assert(strstr(json, "{\"screen\":0,\"name\":\"normal\",\"count\":2,\"clients\":[4194305,5242881]}"));
+  free(json);
+
+  json = control_snapshot(&s, "focus", NULL);
+  assert(strstr(json, "\"focused\":4194305"));
+  assert(strstr(json, "\"mru\":[{\"xid\":4194305,\"desktop\":0}],\"mru_broken\":false"));
+  free(json);
+
+  json = control_snapshot(&s, "memory", NULL);
+  assert(strstr(json, "\"clients\":{\"live\":2,\"cap\":16"));
+  free(json);
+
+  // Everything, in table order
+  json = control_snapshot(&s, "", NULL);
+  char* layers = strstr(json, "\"layers\":");
+  char* clients = strstr(json, "\"clients\":[");
+  assert(layers && clients && layers < clients);
+  assert(strstr(json, "\"cookies\":{\"live\":0"));
+  assert(strstr(json, "\"ticks\":{"));
+  free(json);
+
+  xreq_counts[XREQ_CONFIGURE] = 7;
+  s.buckets.unmanaged_coalesced = 3;
+  json = control_snapshot(&s, "requests", NULL);
+  assert(strncmp(json, "{\"requests\":{\"x\":{\"configure\":7,", 30) == 0);
+  assert(strstr(json, "\"per_tick\":{\"count\":0,"));
+  assert(strstr(json, "\"unmanaged_configure\":{\"forwarded\":0,\"coalesced\":3}"));
+  free(json);
+  xreq_counts[XREQ_CONFIGURE] = 0;
+
+  assert(control_snapshot(&s, "nope", NULL) == NULL);
+  teardown_server(&s);
+}
+
+static void test_socket_round_trip(void) {
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/hxm-test-control-%d.sock", (int)getpid());
+  setenv(CONTROL_SOCKET_ENV, path, 1);
+
+  server_t s;
+  setup_server(&s);
+  add_client(&s, 0x400001, "plain");
+  int epfd = epoll_create1(EPOLL_CLOEXEC);
+  assert(epfd >= 0);
+  assert(control_open(&s.control, epfd));
+  assert(control_owns_fd(&s.control, s.control.listen_fd));
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+  assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+  assert(write(fd, "clients\n", 8) == 8);
+
+  // Serve until the connection is answered and closed
+  bool served = false;
+  for (int iter = 0; iter < 16; iter++) {
+    struct epoll_event evs[4];
+    int n = epoll_wait(epfd, evs, 4, 1000);
+    for (int i = 0; i < n; i++) {
+      assert(control_owns_fd(&s.control, evs[i].data.fd));
+      control_handle(&s.control, &s, evs[i].data.fd, evs[i].events);
+    }
+    served = true;
+    for (int i = 0; i < CONTROL_MAX_CONNS; i++) {
+      if (s.control.conns[i].fd >= 0)
+        served = false;
+    }
+    if (served && iter > 0)
+      break;
+  }
+  assert(served);
+
+  char buf[1024];
+  size_t got = 0;
+  ssize_t n;
+  while ((n = read(fd, buf + got, sizeof(buf) - 1 - got)) > 0)
+    got += (size_t)n;
+  buf[got] = '\0';
+  close(fd);
+  assert(strncmp(buf, "{\"clients\":[{\"xid\":4194305", 26) == 0);
+  assert(buf[got - 1] == '\n');
+
+  control_close(&s.control);
+  assert(s.control.listen_fd == -1);
+  assert(access(path, F_OK) != 0);
+  close(epfd);
+  teardown_server(&s);
+  unsetenv(CONTROL_SOCKET_ENV);
+}
+
+static void test_open_keeps_non_socket(void) {
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/hxm-test-control-%d.file", (int)getpid());
+  FILE* f = fopen(path, "w");
+  assert(f);
+  fputs("keep\n", f);
+  fclose(f);
+  setenv(CONTROL_SOCKET_ENV, path, 1);
+
+  server_t s;
+  setup_server(&s);
+  assert(!control_open(&s.control, -1));
+  assert(s.control.listen_fd == -1);
+
+  char buf[16] = {0};
+  f = fopen(path, "r");
+  assert(f);
+  assert(fgets(buf, sizeof(buf), f) != NULL);
+  fclose(f);
+  assert(strcmp(buf, "keep\n") == 0);
+
+  control_close(&s.control);
+  assert(access(path, F_OK) == 0);
+  unlink(path);
+  teardown_server(&s);
+  unsetenv(CONTROL_SOCKET_ENV);
+}
+
+static void test_empty_env_disables(void) {
+  char path[64];
+  setenv(CONTROL_SOCKET_ENV, "", 1);
+  assert(!control_socket_path(path, sizeof(path)));
+  unsetenv(CONTROL_SOCKET_ENV);
+}
+
+int main(void) {
+  test_snapshot_sections();
+  test_socket_round_trip();
+  test_open_keeps_non_socket();
+  test_empty_env_disables();
+  return 0;
+}
@@ -326,6 +326,8 @@ static void test_growth_and_reachability(void) {
 static void test_collisions_linear_probe(void) {
   cookie_jar_t cj;
   cookie_jar_init(&cj);
+  // Readiness below is out of sequence order; exercise the table scan path
+  cj.ordered = false;
 
   // Ensure we are at minimum cap so (seq & mask) trick works
   // If init starts larger, this still collides for many masks, but this is the
@@ -358,6 +360,8 @@ static void test_collisions_linear_probe(void) {
 static void test_remove_breaks_chain_regression(void) {
   cookie_jar_t cj;
   cookie_jar_init(&cj);
+  // Readiness below is out of sequence order; exercise the table scan path
+  cj.ordered = false;
 
   // This test tries to catch the classic bug:
   // deleting an element in a probe chain without backshift/rehash breaks lookup
@@ -643,6 +647,8 @@ static void test_timeout_without_reply_hint(void) {
 static void test_cursor_fairness_progress(void) {
   cookie_jar_t cj;
   cookie_jar_init(&cj);
+  // Readiness below is out of sequence order; exercise the table scan path
+  cj.ordered = false;
 
   stub_poll_for_reply_hook = mock_poll;
 
@@ -763,6 +769,403 @@ static void test_alloc_fail_grow(void) {
   }
 }
 
+static uint32_t g_expired_order[8];
+static size_t g_expired_count = 0;
+
+static void order_handler(struct server* s, const struct cookie_slot* slot, void* reply, xcb_generic_error_t* err) {
+  (void)s;
+  (void)reply;
+  (void)err;
+  if (g_expired_count < sizeof(g_expired_order) / sizeof(g_expired_order[0]))
+    g_expired_order[g_expired_count] = slot->sequence;
+  g_expired_count++;
+}
+
+static void test_timeout_heap_oldest_first(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+  g_use_mock_time = true;
+  g_expired_count = 0;
+
+  // Push out of timestamp order; the heap must still expire oldest first
+  g_mock_time = 3000000000ULL;
+  cookie_jar_push(&cj, 30, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, order_handler);
+  g_mock_time = 1000000000ULL;
+  cookie_jar_push(&cj, 10, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, order_handler);
+  g_mock_time = 2000000000ULL;
+  cookie_jar_push(&cj, 20, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, order_handler);
+
+  // Re-pushing 10 refreshes its deadline; the stale entry must be skipped
+  g_mock_time = 4000000000ULL;
+  cookie_jar_push(&cj, 10, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, order_handler);
+  assert(cj.live_count == 3);
+  assert(cookie_jar_next_timeout_ms(&cj, 4000000000ULL) == 3000);
+
+  // Only 20 and 30 are past 5s at t=8.5s
+  g_mock_time = 8500000000ULL;
+  expire_only(&cj, 10);
+  assert(g_expired_count == 2);
+  assert(g_expired_order[0] == 20);
+  assert(g_expired_order[1] == 30);
+  assert(cj.live_count == 1);
+
+  // Budget is honoured
+  g_mock_time = 9000000000ULL;
+  cookie_jar_push(&cj, 40, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, order_handler);
+  g_mock_time = 20000000000ULL;
+  expire_only(&cj, 1);
+  assert(g_expired_count == 3);
+  assert(g_expired_order[2] == 10);
+  assert(cj.live_count == 1);
+
+  g_use_mock_time = false;
+  cookie_jar_destroy(&cj);
+  printf("test_timeout_heap_oldest_first passed\n");
+}
+
+static void test_timeout_heap_stale_entries_bounded(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+  // Seq 1 stays unanswered while later ones complete; use the table scan path
+  cj.ordered = false;
+  g_use_mock_time = true;
+  g_mock_time = 1000000000ULL;
+
+  // One long-lived cookie keeps every later (answered) entry behind it
+  stub_poll_for_reply_hook = mock_poll;
+  cookie_jar_push(&cj, 1, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, mock_handler);
+  size_t cap_before = cj.deadline_cap;
+  for (uint32_t seq = 2; seq < 20000; seq++) {
+    g_mock_time += 1000;
+    cookie_jar_push(&cj, seq, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, mock_handler);
+    set_ready_reply(seq);
+    drain_ready(&cj, 1);
+    assert(cj.live_count == 1);
+  }
+
+  // Stale entries are compacted instead of growing the heap
+  assert(cj.deadline_len <= cj.deadline_cap);
+  assert(cj.deadline_cap == cap_before);
+
+  g_mock_time += 6000000000ULL;
+  reset_handler_state();
+  expire_only(&cj, 10);
+  assert(g_handler_called && g_handler_seq == 1);
+  assert(cj.live_count == 0);
+  assert(cj.deadline_len == 0);
+
+  g_use_mock_time = false;
+  cookie_jar_destroy(&cj);
+  printf("test_timeout_heap_stale_entries_bounded passed\n");
+}
+
+static void test_ordered_drain_stops_at_first_pending(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+  assert(cj.ordered);
+
+  stub_poll_for_reply_hook = mock_poll_all_ready;
+
+  // Pushed out of issue order; drain must still dispatch in sequence order
+  const uint32_t seqs[] = {5, 3, 4, 1, 2};
+  for (size_t i = 0; i < 5; i++)
+    cookie_jar_push(&cj, seqs[i], COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, order_handler);
+
+  g_expired_count = 0;
+  g_poll_calls = 0;
+  drain_ready(&cj, 3);
+  assert(g_expired_count == 3);
+  assert(g_expired_order[0] == 1 && g_expired_order[1] == 2 && g_expired_order[2] == 3);
+  assert(g_poll_calls == 3);
+  // Budget hit with replies still flowing: keep polling next tick
+  assert(cj.replies_may_exist);
+
+  drain_ready(&cj, 10);
+  assert(g_expired_count == 5);
+  assert(g_expired_order[3] == 4 && g_expired_order[4] == 5);
+  assert(cj.live_count == 0);
+
+  // Head not ready: exactly one poll, nothing later is touched
+  stub_poll_for_reply_hook = mock_poll;
+  for (uint32_t i = 100; i < 400; i++)
+    cookie_jar_push(&cj, i, COOKIE_GET_GEOMETRY, i < 110 ? (handle_t)7 : HANDLE_INVALID, 0, 0, mock_handler);
+  set_ready_none();
+  drain_ready(&cj, 64);
+  assert(g_poll_calls == 1);
+  assert(cj.live_count == 300);
+  assert(!cj.replies_may_exist);
+
+  // Removed heads are skipped without polling
+  size_t removed = cookie_jar_remove_client(&cj, (handle_t)7);
+  assert(removed == 10);
+  reset_handler_state();
+  set_ready_reply(110);
+  drain_ready(&cj, 1);
+  assert(g_handler_called && g_handler_seq == 110);
+  assert(g_poll_calls == 1);
+
+  cookie_jar_destroy(&cj);
+  printf("test_ordered_drain_stops_at_first_pending passed\n");
+}
+
+static void test_ordered_ring_wraps_and_grows(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+  stub_poll_for_reply_hook = mock_poll_all_ready;
+
+  // Sequence numbers crossing the 32-bit wrap keep their issue order
+  const uint32_t seqs[] = {UINT32_MAX - 2, UINT32_MAX - 1, UINT32_MAX, 1, 2, 3};
+  for (size_t i = 0; i < 6; i++)
+    cookie_jar_push(&cj, seqs[i], COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, order_handler);
+  g_expired_count = 0;
+  drain_ready(&cj, 6);
+  assert(g_expired_count == 6);
+  assert(g_expired_order[0] == UINT32_MAX - 2);
+  assert(g_expired_order[2] == UINT32_MAX);
+  assert(g_expired_order[3] == 1);
+
+  // Growing past the initial ring capacity keeps order
+  const uint32_t N = 5000;
+  for (uint32_t i = 1; i <= N; i++)
+    cookie_jar_push(&cj, i, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, mock_handler);
+  assert(cj.order_len == N);
+  for (uint32_t i = 1; i <= N; i++) {
+    reset_handler_state();
+    drain_ready(&cj, 1);
+    assert(g_handler_seq == i);
+  }
+  assert(cj.live_count == 0);
+
+  cookie_jar_destroy(&cj);
+  printf("test_ordered_ring_wraps_and_grows passed\n");
+}
+
+static int g_group_done_calls = 0;
+static size_t g_group_done_at = 0;
+static handle_t g_group_done_client = HANDLE_INVALID;
+
+static void group_done(struct server* s, uint64_t txn_id, handle_t client) {
+  (void)s;
+  assert(txn_id == 42);
+  g_group_done_calls++;
+  g_group_done_at = g_expired_count;
+  g_group_done_client = client;
+}
+
+static void test_group_dispatches_together(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+  stub_poll_for_reply_hook = mock_poll_all_ready;
+
+  g_expired_count = 0;
+  g_group_done_calls = 0;
+
+  uint32_t gid = cookie_jar_group_begin(&cj, 42, (handle_t)9, group_done);
+  assert(gid != 0);
+  for (uint32_t seq = 10; seq < 14; seq++)
+    cookie_jar_push(&cj, seq, COOKIE_GET_PROPERTY, (handle_t)9, 0, 42, order_handler);
+  cookie_jar_group_end(&cj, NULL);
+
+  // Partial progress is parked, nothing reaches the handlers
+  drain_ready(&cj, 3);
+  assert(g_expired_count == 0);
+  assert(g_group_done_calls == 0);
+  assert(cj.live_count == 1);
+
+  // Last reply releases every member in issue order, then the completion
+  drain_ready(&cj, 3);
+  assert(g_expired_count == 4);
+  for (uint32_t i = 0; i < 4; i++)
+    assert(g_expired_order[i] == 10 + i);
+  assert(g_group_done_calls == 1);
+  assert(g_group_done_at == 4);
+  assert(g_group_done_client == (handle_t)9);
+
+  // Ungrouped pushes after the group dispatch immediately
+  cookie_jar_push(&cj, 20, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, order_handler);
+  drain_ready(&cj, 1);
+  assert(g_expired_count == 5);
+
+  // An empty group completes as soon as it is sealed
+  cookie_jar_group_begin(&cj, 42, (handle_t)3, group_done);
+  cookie_jar_group_end(&cj, NULL);
+  assert(g_group_done_calls == 2);
+  assert(g_group_done_client == (handle_t)3);
+
+  cookie_jar_destroy(&cj);
+  printf("test_group_dispatches_together passed\n");
+}
+
+static void test_group_remove_client_drops_group(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+  stub_poll_for_reply_hook = mock_poll_all_ready;
+
+  g_expired_count = 0;
+  g_group_done_calls = 0;
+
+  cookie_jar_group_begin(&cj, 42, (handle_t)9, group_done);
+  for (uint32_t seq = 1; seq <= 3; seq++)
+    cookie_jar_push(&cj, seq, COOKIE_GET_PROPERTY, (handle_t)9, 0, 42, order_handler);
+  cookie_jar_group_end(&cj, NULL);
+
+  // One collected reply, two still pending
+  drain_ready(&cj, 1);
+  assert(g_expired_count == 0);
+
+  size_t removed = cookie_jar_remove_client(&cj, (handle_t)9);
+  assert(removed == 2);
+  assert(cj.live_count == 0);
+
+  drain_ready(&cj, 8);
+  assert(g_expired_count == 0);
+  assert(g_group_done_calls == 0);
+
+  // Group entry is reusable
+  uint32_t gid = cookie_jar_group_begin(&cj, 42, (handle_t)4, group_done);
+  assert(gid == 1);
+  cookie_jar_group_end(&cj, NULL);
+  assert(g_group_done_calls == 1);
+
+  cookie_jar_destroy(&cj);
+  printf("test_group_remove_client_drops_group passed\n");
+}
+
+static void test_remove_client_walks_own_list(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+  reset_handler_state();
+
+  // Three clients interleaved, enough to grow the table twice
+  size_t start_cap = cj.cap;
+  for (uint32_t seq = 1; seq <= 3000; seq++)
+    cookie_jar_push(&cj, seq, COOKIE_GET_PROPERTY, (handle_t)(1 + seq % 3), 0, 0, mock_handler);
+  assert(cj.cap > start_cap);
+  assert(hash_map_size(&cj.client_cookies) == 3);
+
+  // Drained cookies and one moved to another client leave the lists consistent
+  stub_poll_for_reply_hook = mock_poll_all_ready;
+  drain_ready(&cj, 30);
+  assert(cj.live_count == 2970);
+  cookie_jar_push(&cj, 2002, COOKIE_GET_PROPERTY, (handle_t)9, 0, 0, mock_handler);
+
+  size_t removed = cookie_jar_remove_client(&cj, (handle_t)2);
+  assert(removed == 990 - 1);
+  assert(cj.live_count == 2970 - removed);
+  for (size_t i = 0; i < cj.cap; i++)
+    assert(!cj.slots[i].live || cj.slots[i].client != (handle_t)2);
+
+  assert(cookie_jar_remove_client(&cj, (handle_t)2) == 0);
+  assert(cookie_jar_remove_client(&cj, (handle_t)9) == 1);
+  assert(cookie_jar_remove_client(&cj, (handle_t)1) == 990);
+  assert(cookie_jar_remove_client(&cj, (handle_t)3) == 990);
+  assert(cj.live_count == 0);
+  assert(hash_map_size(&cj.client_cookies) == 0);
+
+  cookie_jar_destroy(&cj);
+  printf("test_remove_client_walks_own_list passed\n");
+}
+
+static void test_backshift_bounded_walk(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+
+  // A run at home, with displaced chains folded into its first 40 buckets
+  enum { RUN = 300, CHAINS = 3, FOLD = 40, TOTAL = RUN + CHAINS * FOLD };
+  uint32_t seqs[TOTAL];
+  bool live[TOTAL];
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < RUN; i++)
+    seqs[n++] = 1 + i;
+  for (uint32_t c = 1; c <= CHAINS; c++)
+    for (uint32_t i = 0; i < FOLD; i++)
+      seqs[n++] = 1 + i + c * (uint32_t)cj.cap;
+  for (uint32_t i = 0; i < TOTAL; i++) {
+    cookie_jar_push(&cj, seqs[i], COOKIE_GET_PROPERTY, (handle_t)(i + 1), 0, 0, mock_handler);
+    live[i] = true;
+  }
+  assert(cj.probe_max > 0);
+
+  // Remove in a scattered order; every survivor stays reachable
+  for (uint32_t k = 0; k < TOTAL; k++) {
+    uint32_t victim = (k * 97u) % TOTAL;
+    assert(cookie_jar_remove_client(&cj, (handle_t)(victim + 1)) == 1);
+    live[victim] = false;
+    if (k % 16 != 0 && k + 1 != TOTAL)
+      continue;
+    for (uint32_t i = 0; i < TOTAL; i++)
+      assert((cookie_jar_lookup(&cj, seqs[i]) != NULL) == live[i]);
+  }
+  assert(cj.live_count == 0);
+  assert(cj.probe_max == 0);
+
+  cookie_jar_destroy(&cj);
+  printf("test_backshift_bounded_walk passed\n");
+}
+
+static void test_stats_by_type(void) {
+  cookie_jar_t cj;
+  cookie_jar_init(&cj);
+  stub_poll_for_reply_hook = mock_poll;
+  g_use_mock_time = true;
+  g_mock_time = 1000000000ULL;
+  reset_handler_state();
+
+  cookie_jar_push(&cj, 10, COOKIE_GET_GEOMETRY, HANDLE_INVALID, 0, 0, mock_handler);
+  cookie_jar_push(&cj, 11, COOKIE_GET_PROPERTY, HANDLE_INVALID, 0, 0, mock_handler);
+  cookie_jar_push(&cj, 12, COOKIE_GET_PROPERTY, HANDLE_INVALID, 0, 0, mock_handler);
+  cookie_jar_push(&cj, 13, COOKIE_GRAB_KEY, (handle_t)9, 0, 0, mock_handler);
+  // Same home bucket as 13, one step along the chain
+  cookie_jar_push(&cj, 13 + (uint32_t)cj.cap, COOKIE_GRAB_KEY, (handle_t)9, 0, 0, mock_handler);
+
+  const cookie_jar_stats_t* st = cj.stats;
+  assert(st->type[COOKIE_GET_PROPERTY].pushed == 2);
+  assert(st->probe_len[0] == 4 && st->probe_len[1] == 1 && st->probe_len_max == 1);
+  assert(st->live_max == 5);
+
+  g_mock_time += 2000000ULL;
+  set_ready_reply(10);
+  drain_ready(&cj, 10);
+  set_ready_error(11);
+  drain_ready(&cj, 10);
+  assert(st->type[COOKIE_GET_GEOMETRY].completed == 1);
+  assert(st->type[COOKIE_GET_GEOMETRY].latency.max_ns == 2000000ULL);
+  assert(st->type[COOKIE_GET_PROPERTY].errors == 1);
+  assert(st->type[COOKIE_GET_PROPERTY].latency.count == 1);
+
+  assert(cookie_jar_remove_client(&cj, (handle_t)9) == 2);
+  assert(st->type[COOKIE_GRAB_KEY].dropped == 2);
+
+  g_mock_time += COOKIE_JAR_TIMEOUT_NS;
+  set_ready_none();
+  expire_only(&cj, 10);
+  assert(st->type[COOKIE_GET_PROPERTY].timed_out == 1);
+  assert(st->type[COOKIE_GET_PROPERTY].latency.count == 1);
+
+  // Answered replies left behind by the budget
+  stub_poll_for_reply_hook = mock_poll_all_ready;
+  for (uint32_t seq = 20; seq < 23; seq++)
+    cookie_jar_push(&cj, seq, COOKIE_QUERY_POINTER, HANDLE_INVALID, 0, 0, mock_handler);
+  uint64_t limited = st->budget_limited;
+  drain_ready(&cj, 1);
+  assert(st->budget_limited == limited + 1);
+  drain_ready(&cj, 8);
+  assert(st->budget_limited == limited + 1);
+  assert(st->type[COOKIE_QUERY_POINTER].completed == 3);
+
+  char buf[4096];
+  size_t len = cookie_jar_stats_format(&cj, buf, sizeof(buf));
+  assert(len == strlen(buf));
+  assert(strstr(buf, "cookie jar: live=0 live_max=5") != NULL);
+  assert(strstr(buf, "cookie probe length: 0=7 1=1 ") != NULL);
+  assert(strstr(buf, "get_geometry") != NULL && strstr(buf, "grab_key") != NULL);
+  assert(strstr(buf, "get_window_attributes") == NULL);
+
+  g_use_mock_time = false;
+  cookie_jar_destroy(&cj);
+  printf("test_stats_by_type passed\n");
+}
+
 int main(void) {
   test_init_destroy();
   test_push_and_drain();
@@ -776,6 +1179,15 @@ int main(void) {
   test_reply_and_error_both();
   test_timeout();
   test_timeout_then_late_reply_ignored();
+  test_timeout_heap_oldest_first();
+  test_timeout_heap_stale_entries_bounded();
+  test_ordered_drain_stops_at_first_pending();
+  test_ordered_ring_wraps_and_grows();
+  test_group_dispatches_together();
+  test_group_remove_client_drops_group();
+  test_remove_client_walks_own_list();
+  test_backshift_bounded_walk();
+  test_stats_by_type();
   test_next_timeout_ms_no_pending();
   test_next_timeout_ms_earliest_deadline();
   test_next_timeout_ms_expired_is_zero();
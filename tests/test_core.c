@@ -1,8 +1,11 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "client.h"
 #include "hxm.h"
+#include "manage_stats.h"
 
 void counters_tick_record(uint64_t dt_ns);
 
@@ -63,10 +66,191 @@ static void test_monotonic_time(void) {
   printf("test_monotonic_time passed: %" PRIu64 " -> %" PRIu64 "\n", t1, t2);
 }
 
+static void test_latency_hist_buckets(void) {
+  latency_hist_t h;
+  latency_hist_reset(&h);
+  assert(h.count == 0);
+  assert(h.min_ns == UINT64_MAX);
+  assert(latency_hist_quantile(&h, 5000) == 0);
+
+  // Small values are exact
+  for (uint64_t v = 1; v <= 7; v++)
+    latency_hist_record(&h, v);
+  assert(h.count == 7);
+  assert(h.min_ns == 1);
+  assert(h.max_ns == 7);
+  assert(latency_hist_quantile(&h, 5000) == 4);
+  assert(latency_hist_quantile(&h, 10000) == 7);
+
+  // Large values are bounded to 1/8 relative error and clamped to max
+  latency_hist_reset(&h);
+  for (int i = 0; i < 99; i++)
+    latency_hist_record(&h, 1000);
+  latency_hist_record(&h, 5000000);
+  uint64_t p50 = latency_hist_quantile(&h, 5000);
+  assert(p50 >= 1000 && p50 <= 1000 + 1000 / 8);
+  uint64_t p99 = latency_hist_quantile(&h, 9900);
+  assert(p99 >= 1000 && p99 <= 1000 + 1000 / 8);
+  assert(latency_hist_quantile(&h, 9990) == 5000000);
+
+  // Extreme values must not index out of range
+  latency_hist_record(&h, UINT64_MAX);
+  assert(h.max_ns == UINT64_MAX);
+  assert(latency_hist_quantile(&h, 10000) == UINT64_MAX);
+  printf("test_latency_hist_buckets passed\n");
+}
+
+static void test_tick_stats_record_and_format(void) {
+  tick_stats_init();
+
+  tick_sample_t a;
+  tick_sample_init(&a);
+  tick_sample_add(&a, TICK_PHASE_WAIT, 50000);
+  tick_sample_add(&a, TICK_PHASE_INGEST, 1000);
+  tick_sample_add(&a, TICK_PHASE_PROCESS, 2000);
+  tick_sample_add(&a, TICK_PHASE_TOTAL, 3000);
+  a.arena_used = 4096;
+  a.arena_reserved = 65536;
+  a.arena_blocks = 1;
+  tick_stats_record(&a);
+
+  tick_sample_t b;
+  tick_sample_init(&b);
+  tick_sample_add(&b, TICK_PHASE_INGEST, 4000);
+  tick_sample_add(&b, TICK_PHASE_XCB_FLUSH, 6000);
+  tick_sample_add(&b, TICK_PHASE_TOTAL, 10000);
+  b.arena_used = 100000;
+  b.arena_reserved = 131072;
+  b.arena_blocks = 3;
+  b.arena_shrinks = 1;
+  b.title_hits = 3;
+  b.title_misses = 1;
+  uint64_t xreq_mark[XREQ_KIND_COUNT] = {0};
+  uint64_t bytes_mark = 1000;
+  xreq_counts[XREQ_CONFIGURE] = 4;
+  xreq_counts[XREQ_PROPERTY] = 2;
+  tick_sample_take_xreq(&b, xreq_mark, &bytes_mark, 1640);
+  assert(b.xreq[XREQ_CONFIGURE] == 4 && b.xreq[XREQ_PROPERTY] == 2 && b.xreq[XREQ_MAP] == 0);
+  assert(b.x_bytes == 640 && bytes_mark == 1640 && xreq_mark[XREQ_CONFIGURE] == 4);
+  tick_stats_record(&b);
+
+  // Phases only count ticks in which they ran
+  assert(tick_stats.phase[TICK_PHASE_WAIT].count == 1);
+  assert(tick_stats.phase[TICK_PHASE_INGEST].count == 2);
+  assert(tick_stats.phase[TICK_PHASE_XCB_FLUSH].count == 1);
+  assert(tick_stats.phase[TICK_PHASE_DRAIN].count == 0);
+  assert(tick_stats.phase[TICK_PHASE_TOTAL].count == 2);
+  assert(tick_stats.slowest.ns[TICK_PHASE_TOTAL] == 10000);
+  assert(tick_stats.slowest.ns[TICK_PHASE_XCB_FLUSH] == 6000);
+  assert(tick_stats.arena_used.count == 2);
+  assert(tick_stats.arena_used.max_ns == 100000);
+  assert(tick_stats.arena_blocks_max == 3);
+  assert(tick_stats.arena_reserved == 131072);
+  assert(tick_stats.arena_reserved_max == 131072);
+  assert(tick_stats.arena_shrinks == 1);
+
+  char buf[4096];
+  size_t len = tick_stats_format(buf, sizeof(buf));
+  assert(len == strlen(buf));
+  assert(strstr(buf, "ingest") != NULL);
+  assert(strstr(buf, "slowest tick:") != NULL);
+  assert(strstr(buf, "tick arena (bytes):") != NULL);
+  assert(strstr(buf, "title cache: hits=3 misses=1 hit_rate=75.0%") != NULL);
+  assert(strstr(buf, "x output per tick: requests p50=") != NULL);
+  assert(strstr(buf, " configure=4/4 property=2/2 get_property=0/0") != NULL);
+  assert(strstr(buf, " bytes=640\n") != NULL);
+  assert(strstr(buf, "startup (us):") == NULL);
+
+  // Startup phases accumulate; the line appears once any was recorded
+  tick_stats_record_startup(STARTUP_PHASE_X_QUERIES, 1500);
+  tick_stats_record_startup(STARTUP_PHASE_CONFIG, 2000);
+  tick_stats_record_startup(STARTUP_PHASE_X_QUERIES, 500);
+  tick_stats_record_startup(STARTUP_PHASE_COUNT, 999);
+  assert(tick_stats.startup_ns[STARTUP_PHASE_X_QUERIES] == 2000);
+  len = tick_stats_format(buf, sizeof(buf));
+  assert(len == strlen(buf));
+  assert(strstr(buf, "startup (us): connect=0.0 x_queries=2.0 config=2.0") != NULL);
+  assert(strstr(buf, "total=4.0\n") != NULL);
+
+  // Truncation keeps the buffer terminated
+  char small[16];
+  len = tick_stats_format(small, sizeof(small));
+  assert(len == strlen(small));
+  assert(len < sizeof(small));
+
+  tick_stats_dump();
+  printf("test_tick_stats_record_and_format passed\n");
+}
+
+static void test_manage_stats_record_and_format(void) {
+  manage_stats_init();
+
+  // Not painted yet: nothing to fold
+  manage_timing_t m = {0};
+  manage_timing_mark(&m, MANAGE_MARK_MAP_REQUEST, 1000);
+  manage_timing_mark(&m, MANAGE_MARK_START, 3000);
+  manage_timing_probe(&m, 3, 40, 5000);
+  manage_timing_probe(&m, 3, 41, 2000);
+  assert(m.slowest_probe_ns == 5000 && m.slowest_probe_atom == 40);
+  manage_stats_record(&m, WINDOW_TYPE_NORMAL, "Firefox", "WM_CLASS");
+  assert(manage_stats.stage[MANAGE_STAGE_TOTAL].count == 0);
+
+  manage_timing_mark(&m, MANAGE_MARK_READY, 9000);
+  manage_timing_mark(&m, MANAGE_MARK_START, 7777); // first mark sticks
+  manage_timing_mark(&m, MANAGE_MARK_FINISH, 10000);
+  manage_timing_mark(&m, MANAGE_MARK_FRAME_MAP, 12000);
+  manage_timing_mark(&m, MANAGE_MARK_PAINT, 21000);
+  manage_stats_record(&m, WINDOW_TYPE_NORMAL, "Firefox", "WM_CLASS");
+
+  assert(manage_stats.stage[0].max_ns == 2000); // classify
+  assert(manage_stats.stage[1].max_ns == 6000); // probes
+  assert(manage_stats.stage[MANAGE_STAGE_TOTAL].max_ns == 20000);
+  assert(manage_stats.by_type[WINDOW_TYPE_NORMAL].count == 1);
+  assert(manage_stats.class_count == 1);
+  assert(strcmp(manage_stats.classes[0].worst_probe, "WM_CLASS") == 0);
+
+  // Adopted window: no MapRequest, total starts at manage start
+  manage_timing_t adopted = {0};
+  manage_timing_mark(&adopted, MANAGE_MARK_START, 100);
+  manage_timing_mark(&adopted, MANAGE_MARK_READY, 200);
+  manage_timing_mark(&adopted, MANAGE_MARK_FINISH, 300);
+  manage_timing_mark(&adopted, MANAGE_MARK_PAINT, 600);
+  manage_stats_record(&adopted, WINDOW_TYPE_DIALOG, NULL, NULL);
+  assert(manage_stats.stage[0].count == 1);
+  assert(manage_stats.stage[MANAGE_STAGE_TOTAL].count == 2);
+  assert(manage_stats.stage[MANAGE_STAGE_TOTAL].min_ns == 500);
+  assert(strcmp(manage_stats.classes[1].name, "(none)") == 0);
+
+  // Classes past the table share the last row
+  for (int i = 0; i < MANAGE_STATS_CLASSES + 2; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "app%d", i);
+    manage_stats_record(&adopted, WINDOW_TYPE_NORMAL, name, NULL);
+  }
+  assert(manage_stats.class_count == MANAGE_STATS_CLASSES);
+  assert(manage_stats.classes[MANAGE_STATS_CLASSES].total.count == 4);
+
+  char buf[4096];
+  size_t len = manage_stats_format(buf, sizeof(buf));
+  assert(len == strlen(buf));
+  assert(strstr(buf, "manage latency (us)") != NULL);
+  assert(strstr(buf, "normal=") != NULL && strstr(buf, "dialog=1/") != NULL);
+  assert(strstr(buf, "Firefox") != NULL && strstr(buf, "worst_probe=WM_CLASS/5.0") != NULL);
+  assert(strstr(buf, "slowest manage: class=Firefox type=normal classify=2.0 probes=6.0") != NULL);
+  assert(strstr(buf, "probe=WM_CLASS/5.0") != NULL);
+
+  manage_stats_init();
+  assert(manage_stats_format(buf, sizeof(buf)) == 0);
+  printf("test_manage_stats_record_and_format passed\n");
+}
+
 int main(void) {
   test_counters_init_and_empty_dump();
   test_counters_tick_and_events();
   test_counters_edge_cases();
   test_monotonic_time();
+  test_latency_hist_buckets();
+  test_tick_stats_record_and_format();
+  test_manage_stats_record_and_format();
   return 0;
 }
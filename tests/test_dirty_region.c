@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "hxm.h"
 
@@ -78,9 +79,102 @@ void test_dirty_region_union_resets_on_invalid_geometry(void) {
   printf("test_dirty_region_union_resets_on_invalid_geometry passed\n");
 }
 
+static uint64_t rects_area(const dirty_rects_t* r) {
+  uint64_t sum = 0;
+  for (uint8_t i = 0; i < r->count; i++)
+    sum += (uint64_t)r->rects[i].w * r->rects[i].h;
+  return sum;
+}
+
+static bool rects_cover(const dirty_rects_t* r, int x, int y) {
+  for (uint8_t i = 0; i < r->count; i++) {
+    const dirty_rect_t* d = &r->rects[i];
+    if (x >= d->x && y >= d->y && x < d->x + (int)d->w && y < d->y + (int)d->h)
+      return true;
+  }
+  return false;
+}
+
+void test_dirty_rects_merge_and_split(void) {
+  dirty_rects_t r;
+  dirty_rects_reset(&r);
+  assert(dirty_rects_empty(&r));
+
+  dirty_rects_add(&r, 0, 0, 0, 5);
+  assert(dirty_rects_empty(&r));
+
+  // Far apart stays apart, corner contact too
+  dirty_rects_add(&r, 0, 0, 10, 10);
+  dirty_rects_add(&r, 500, 0, 10, 10);
+  dirty_rects_add(&r, 10, 10, 5, 5);
+  assert(r.count == 3);
+  assert(rects_area(&r) == 225u);
+
+  // Sharing an edge merges
+  dirty_rects_add(&r, 10, 0, 5, 10);
+  assert(r.count == 2);
+
+  // A bridge swallows both ends and whatever the grown rect reaches
+  dirty_rects_add(&r, 5, 2, 500, 4);
+  assert(r.count == 1);
+  assert(r.rects[0].x == 0 && r.rects[0].y == 0 && r.rects[0].w == 510 && r.rects[0].h == 15);
+
+  dirty_rects_t other = dirty_rects_make(-20, 100, 5, 5);
+  dirty_rects_union(&r, &other);
+  assert(r.count == 2);
+  dirty_region_t b = dirty_rects_bounds(&r);
+  assert(b.valid && b.x == -20 && b.y == 0 && b.w == 530 && b.h == 105);
+
+  dirty_rects_clamp(&r, 0, 0, 100, 50);
+  assert(r.count == 1);
+  assert(r.rects[0].w == 100 && r.rects[0].h == 15);
+  dirty_rects_clamp(&r, 200, 200, 10, 10);
+  assert(dirty_rects_empty(&r));
+
+  printf("test_dirty_rects_merge_and_split passed\n");
+}
+
+void test_dirty_rects_full_list_merges_cheapest(void) {
+  dirty_rects_t r;
+  dirty_rects_reset(&r);
+  for (int i = 0; i < DIRTY_RECTS_MAX; i++)
+    dirty_rects_add(&r, (int16_t)(i * 100), 0, 10, 10);
+  assert(r.count == DIRTY_RECTS_MAX);
+
+  // Closest to the last rect: folded into it rather than into a far one
+  dirty_rects_add(&r, (int16_t)((DIRTY_RECTS_MAX - 1) * 100 + 20), 0, 10, 10);
+  assert(r.count == DIRTY_RECTS_MAX);
+  assert(rects_area(&r) == (uint64_t)(DIRTY_RECTS_MAX - 1) * 100u + 300u);
+  for (int i = 0; i < DIRTY_RECTS_MAX; i++)
+    assert(rects_cover(&r, i * 100 + 5, 5));
+
+  // Random churn never loses coverage or exceeds the cap
+  srand(7);
+  for (int round = 0; round < 200; round++) {
+    dirty_rects_reset(&r);
+    int xs[32], ys[32];
+    for (int i = 0; i < 32; i++) {
+      xs[i] = rand() % 2000 - 100;
+      ys[i] = rand() % 1000 - 100;
+      dirty_rects_add(&r, (int16_t)xs[i], (int16_t)ys[i], (uint16_t)(1 + rand() % 80), (uint16_t)(1 + rand() % 80));
+      assert(r.count <= DIRTY_RECTS_MAX);
+    }
+    for (int i = 0; i < 32; i++)
+      assert(rects_cover(&r, xs[i], ys[i]));
+    for (uint8_t i = 0; i < r.count; i++) {
+      for (uint8_t j = (uint8_t)(i + 1); j < r.count; j++)
+        assert(!dirty_rect_touches(&r.rects[i], &r.rects[j]));
+    }
+  }
+
+  printf("test_dirty_rects_full_list_merges_cheapest passed\n");
+}
+
 int main(void) {
   test_dirty_region_union_and_clamp();
   test_dirty_region_invalid_inputs();
   test_dirty_region_union_resets_on_invalid_geometry();
+  test_dirty_rects_merge_and_split();
+  test_dirty_rects_full_list_merges_cheapest();
   return 0;
 }
@@ -444,6 +444,63 @@ static void test_arena_strings(void) {
   printf("test_arena_strings passed\n");
 }
 
+static void test_arena_stats_and_decay(void) {
+  struct arena a;
+  arena_init(&a, 4096);
+
+  arena_alloc(&a, 100);
+  arena_alloc(&a, 3);
+  TEST_ASSERT(a.used == 104 + 8);
+  TEST_ASSERT(a.blocks_used == 1);
+  TEST_ASSERT(a.blocks == 1);
+  TEST_ASSERT(a.reserved == 4096);
+
+  // Storm tick: ~1 MiB across many blocks
+  arena_reset(&a);
+  for (int i = 0; i < 1024; i++)
+    TEST_ASSERT(arena_alloc(&a, 1024) != NULL);
+  TEST_ASSERT(a.blocks_used == a.blocks);
+  TEST_ASSERT(a.blocks >= 256);
+  size_t storm_reserved = a.reserved;
+
+  // The next reset remembers the storm and keeps everything
+  arena_reset(&a);
+  TEST_ASSERT(a.used == 0 && a.blocks_used == 0);
+  TEST_ASSERT(a.high_water == 1024 * 1024);
+  TEST_ASSERT(a.reserved == storm_reserved);
+  TEST_ASSERT(a.shrinks == 0);
+
+  // Quiet ticks decay the high-water mark; memory is released in steps each
+  // time the working set drops below half of what is held
+  for (int i = 0; i < 300; i++) {
+    void* p = arena_alloc(&a, 2000);
+    TEST_ASSERT(p != NULL);
+    fill_pattern(p, 2000, 0x3C);
+    arena_reset(&a);
+  }
+  TEST_ASSERT(a.shrinks >= 1);
+  TEST_ASSERT(a.blocks == 1);
+  TEST_ASSERT(a.first && a.first->next == NULL);
+  TEST_ASSERT(a.reserved == a.first->size);
+  TEST_ASSERT(a.reserved <= 2 * 4096);
+
+  // Settled at the working set: no further churn
+  uint64_t shrinks = a.shrinks;
+  size_t reserved = a.reserved;
+  for (int i = 0; i < 200; i++) {
+    void* p = arena_alloc(&a, 2000);
+    fill_pattern(p, 2000, 0x5A);
+    expect_pattern(p, 2000, 0x5A);
+    arena_reset(&a);
+  }
+  TEST_ASSERT(a.high_water == 2000);
+  TEST_ASSERT(a.reserved == reserved);
+  TEST_ASSERT(a.shrinks == shrinks);
+
+  arena_destroy(&a);
+  printf("test_arena_stats_and_decay passed\n");
+}
+
 static void test_small_vec_basic(void) {
   small_vec_t v;
   small_vec_init(&v);
@@ -499,6 +556,321 @@ static void test_small_vec_growth(void) {
   printf("test_small_vec_growth passed\n");
 }
 
+// A caller-chosen inline capacity, as a module-local vector would declare it
+DS_VEC_DEFINE(tiny_vec, uint16_t, 2)
+
+static void test_handle_vec_ops(void) {
+  handle_vec_t v;
+  handle_vec_init(&v);
+  TEST_ASSERT(v.items == v.inline_storage);
+  TEST_ASSERT(v.capacity == HANDLE_VEC_INLINE_CAP);
+
+  for (uint32_t i = 1; i <= 40; i++)
+    handle_vec_push(&v, handle_make(i, 1));
+  TEST_ASSERT(v.length == 40);
+  TEST_ASSERT(v.items != v.inline_storage);
+  for (uint32_t i = 0; i < 40; i++)
+    TEST_ASSERT(handle_index(v.items[i]) == i + 1);
+
+  // Ordered insert/remove keep the rest in place (stacking semantics)
+  handle_t mid = handle_make(99, 2);
+  handle_vec_insert(&v, 10, mid);
+  TEST_ASSERT(v.length == 41);
+  TEST_ASSERT(v.items[10] == mid);
+  TEST_ASSERT(handle_index(v.items[9]) == 10 && handle_index(v.items[11]) == 11);
+  TEST_ASSERT(handle_vec_find(&v, mid) == 10);
+
+  handle_vec_insert(&v, 1000, handle_make(100, 1));  // clamped to the end
+  TEST_ASSERT(handle_index(v.items[v.length - 1]) == 100);
+
+  TEST_ASSERT(handle_vec_remove(&v, mid) == true);
+  TEST_ASSERT(handle_vec_remove(&v, mid) == false);
+  TEST_ASSERT(handle_vec_find(&v, mid) == SIZE_MAX);
+  TEST_ASSERT(handle_index(v.items[10]) == 11);
+
+  handle_vec_remove_at(&v, 0);
+  TEST_ASSERT(handle_index(v.items[0]) == 2);
+  handle_vec_remove_at(&v, 500);  // out of range is a no-op
+  TEST_ASSERT(v.length == 40);
+
+  handle_t last;
+  TEST_ASSERT(handle_vec_pop(&v, &last) && handle_index(last) == 100);
+  TEST_ASSERT(handle_vec_remove_swap(&v, v.items[0]) == true);
+  TEST_ASSERT(handle_index(v.items[0]) == 40);
+  TEST_ASSERT(v.length == 38);
+
+  handle_vec_clear(&v);
+  TEST_ASSERT(v.length == 0);
+  TEST_ASSERT(!handle_vec_pop(&v, &last));
+  handle_vec_destroy(&v);
+  TEST_ASSERT(v.items == v.inline_storage);
+  printf("test_handle_vec_ops passed\n");
+}
+
+static void test_typed_vec_inline_and_growth(void) {
+  tiny_vec_t t;
+  tiny_vec_init(&t);
+  tiny_vec_push(&t, 7);
+  tiny_vec_push(&t, 8);
+  TEST_ASSERT(t.items == t.inline_storage && t.capacity == 2);
+  tiny_vec_push(&t, 9);
+  TEST_ASSERT(t.items != t.inline_storage && t.capacity >= 3);
+  TEST_ASSERT(t.items[0] == 7 && t.items[1] == 8 && t.items[2] == 9);
+  tiny_vec_destroy(&t);
+
+  u32_vec_t u;
+  u32_vec_init(&u);
+  u32_vec_reserve(&u, 1000);
+  TEST_ASSERT(u.capacity >= 1000);
+  uint32_t* before = u.items;
+  for (uint32_t i = 0; i < 1000; i++)
+    u32_vec_push(&u, i * 3u);
+  TEST_ASSERT(u.items == before);  // reserve avoided regrowth
+  TEST_ASSERT(u32_vec_find(&u, 2997u) == 999);
+  u32_vec_destroy(&u);
+  printf("test_typed_vec_inline_and_growth passed\n");
+}
+
+static void test_hash_map_swiss_basic(void) {
+  hash_map_t map;
+  hash_map_init_swiss(&map);
+
+  TEST_ASSERT(hash_map_get(&map, 1) == NULL);
+  TEST_ASSERT(hash_map_remove(&map, 1) == false);
+
+  TEST_ASSERT(hash_map_insert(&map, 1, (void*)0x11) == false);
+  TEST_ASSERT(hash_map_insert(&map, 2, (void*)0x22) == false);
+  TEST_ASSERT(hash_map_insert(&map, 100, (void*)0x100) == false);
+  TEST_ASSERT(hash_map_size(&map) == 3);
+  TEST_ASSERT(hash_map_get(&map, 100) == (void*)0x100);
+
+  TEST_ASSERT(hash_map_insert(&map, 2, (void*)0x99) == true);
+  TEST_ASSERT(hash_map_size(&map) == 3);
+  TEST_ASSERT(hash_map_get(&map, 2) == (void*)0x99);
+
+  TEST_ASSERT(hash_map_remove(&map, 2) == true);
+  TEST_ASSERT(hash_map_remove(&map, 2) == false);
+  TEST_ASSERT(hash_map_get(&map, 2) == NULL);
+  TEST_ASSERT(hash_map_size(&map) == 2);
+
+  size_t cap_before = hash_map_capacity(&map);
+  hash_map_clear(&map);
+  TEST_ASSERT(hash_map_size(&map) == 0);
+  TEST_ASSERT(hash_map_capacity(&map) == cap_before);
+  TEST_ASSERT(hash_map_get(&map, 1) == NULL);
+
+  hash_map_destroy(&map);
+  printf("test_hash_map_swiss_basic passed\n");
+}
+
+static void test_hash_map_swiss_churn_bounded(void) {
+  hash_map_t map;
+  hash_map_init_swiss(&map);
+
+  // Window ids churn through a small live set: tombstones must be recycled
+  // rather than growing the table forever
+  for (uint64_t i = 0; i < 64; i++)
+    hash_map_insert(&map, 0x400000 + i, (void*)(uintptr_t)(i + 1));
+  size_t cap_live = hash_map_capacity(&map);
+
+  for (uint64_t round = 0; round < 2000; round++) {
+    uint64_t old_key = 0x400000 + round;
+    uint64_t new_key = 0x400000 + round + 64;
+    TEST_ASSERT(hash_map_remove(&map, old_key) == true);
+    hash_map_insert(&map, new_key, (void*)(uintptr_t)(round + 65));
+    TEST_ASSERT(hash_map_size(&map) == 64);
+  }
+  TEST_ASSERT(hash_map_capacity(&map) <= cap_live * 2);
+
+  for (uint64_t i = 2000; i < 2064; i++)
+    TEST_ASSERT(hash_map_get(&map, 0x400000 + i) == (void*)(uintptr_t)(i + 1));
+
+  hash_map_destroy(&map);
+  printf("test_hash_map_swiss_churn_bounded passed\n");
+}
+
+static void test_hash_map_swiss_matches_linear(void) {
+  hash_map_t lin;
+  hash_map_t sw;
+  hash_map_init(&lin);
+  hash_map_init_swiss(&sw);
+
+  uint64_t rng = 0xfeedfacecafebeefull;
+  for (int step = 0; step < 50000; step++) {
+    uint64_t r = prng_u64(&rng);
+    uint64_t k = (r % 3000 + 1) * 0x200001ull;  // stride like X resource ids
+    int op = (int)((r >> 32) % 4);
+
+    if (op <= 1) {
+      void* v = (void*)(uintptr_t)(r | 1ull);
+      TEST_ASSERT(hash_map_insert(&lin, k, v) == hash_map_insert(&sw, k, v));
+    }
+    else if (op == 2) {
+      TEST_ASSERT(hash_map_remove(&lin, k) == hash_map_remove(&sw, k));
+    }
+    else {
+      TEST_ASSERT(hash_map_get(&lin, k) == hash_map_get(&sw, k));
+    }
+    TEST_ASSERT(hash_map_size(&lin) == hash_map_size(&sw));
+  }
+
+  // Iteration visits every live entry of either layout exactly once
+  hash_map_t* maps[] = {&lin, &sw};
+  for (size_t m = 0; m < 2; m++) {
+    size_t cursor = 0;
+    size_t seen = 0;
+    uint64_t key;
+    void* value;
+    while (hash_map_next(maps[m], &cursor, &key, &value)) {
+      TEST_ASSERT(hash_map_get(&lin, key) == value);
+      seen++;
+    }
+    TEST_ASSERT(seen == hash_map_size(&lin));
+  }
+
+  hash_map_destroy(&lin);
+  hash_map_destroy(&sw);
+  printf("test_hash_map_swiss_matches_linear passed\n");
+}
+
+static void test_epoch_map_basic_and_order(void) {
+  epoch_map_t map;
+  epoch_map_init(&map);
+
+  TEST_ASSERT(epoch_map_get(&map, 1) == NULL);
+  TEST_ASSERT(epoch_map_remove(&map, 1) == false);
+
+  // Key 0 is allowed; insertion order is iteration order
+  const uint64_t keys[] = {30, 0, 10, 20};
+  for (size_t i = 0; i < 4; i++)
+    TEST_ASSERT(epoch_map_insert(&map, keys[i], (void*)(uintptr_t)(i + 1)) == false);
+  TEST_ASSERT(epoch_map_insert(&map, 10, (void*)0x99) == true);
+  TEST_ASSERT(epoch_map_size(&map) == 4);
+  TEST_ASSERT(epoch_map_get(&map, 0) == (void*)2);
+
+  TEST_ASSERT(epoch_map_remove(&map, 30) == true);
+  TEST_ASSERT(epoch_map_remove(&map, 30) == false);
+  TEST_ASSERT(epoch_map_get(&map, 30) == NULL);
+  TEST_ASSERT(epoch_map_size(&map) == 3);
+
+  size_t cursor = 0;
+  uint64_t key;
+  void* value;
+  const uint64_t want[] = {0, 10, 20};
+  size_t n = 0;
+  while (epoch_map_next(&map, &cursor, &key, &value)) {
+    TEST_ASSERT(n < 3 && key == want[n]);
+    n++;
+  }
+  TEST_ASSERT(n == 3);
+
+  // Reinsert in the same epoch takes the original position back
+  TEST_ASSERT(epoch_map_insert(&map, 30, (void*)0x30) == false);
+  cursor = 0;
+  TEST_ASSERT(epoch_map_next(&map, &cursor, &key, &value));
+  TEST_ASSERT(key == 30 && value == (void*)0x30);
+
+  epoch_map_destroy(&map);
+  printf("test_epoch_map_basic_and_order passed\n");
+}
+
+static void test_epoch_map_clear_is_epoch_bump(void) {
+  epoch_map_t map;
+  epoch_map_init(&map);
+
+  // A storm grows the map...
+  for (uint64_t k = 1; k <= 5000; k++)
+    epoch_map_insert(&map, k, (void*)(uintptr_t)k);
+  size_t cap = map.capacity;
+  TEST_ASSERT(cap >= 5000);
+
+  // ...later ticks keep the storage and see none of the old entries
+  for (int tick = 0; tick < 100; tick++) {
+    epoch_map_clear(&map);
+    TEST_ASSERT(epoch_map_size(&map) == 0);
+    TEST_ASSERT(epoch_map_get(&map, 1) == NULL);
+    TEST_ASSERT(epoch_map_get(&map, 4999) == NULL);
+
+    uint64_t k = 100 + (uint64_t)tick;
+    TEST_ASSERT(epoch_map_insert(&map, k, (void*)0x1) == false);
+    TEST_ASSERT(epoch_map_get(&map, k) == (void*)0x1);
+    TEST_ASSERT(epoch_map_size(&map) == 1);
+  }
+  TEST_ASSERT(map.capacity == cap);
+
+  // Epoch wraparound wipes stale stamps instead of aliasing them
+  epoch_map_insert(&map, 77, (void*)0x77);
+  map.epoch = UINT32_MAX;
+  epoch_map_clear(&map);
+  TEST_ASSERT(map.epoch == 1);
+  TEST_ASSERT(epoch_map_get(&map, 77) == NULL);
+  TEST_ASSERT(epoch_map_insert(&map, 77, (void*)0x78) == false);
+  TEST_ASSERT(epoch_map_get(&map, 77) == (void*)0x78);
+
+  epoch_map_destroy(&map);
+  printf("test_epoch_map_clear_is_epoch_bump passed\n");
+}
+
+static void test_epoch_map_matches_hash_map(void) {
+  hash_map_t ref;
+  epoch_map_t map;
+  hash_map_init(&ref);
+  epoch_map_init(&map);
+
+  uint64_t rng = 0x0ddba11cafef00dull;
+  for (int step = 0; step < 50000; step++) {
+    uint64_t r = prng_u64(&rng);
+    uint64_t k = (r % 2000) + 1;
+    int op = (int)((r >> 32) % 16);
+
+    if (op < 7) {
+      void* v = (void*)(uintptr_t)(r | 1ull);
+      TEST_ASSERT(hash_map_insert(&ref, k, v) == epoch_map_insert(&map, k, v));
+    }
+    else if (op < 11) {
+      TEST_ASSERT(hash_map_remove(&ref, k) == epoch_map_remove(&map, k));
+    }
+    else if (op < 15) {
+      TEST_ASSERT(hash_map_get(&ref, k) == epoch_map_get(&map, k));
+    }
+    else if ((r & 0xFF) == 0) {
+      hash_map_clear(&ref);
+      epoch_map_clear(&map);
+    }
+    TEST_ASSERT(hash_map_size(&ref) == epoch_map_size(&map));
+  }
+
+  size_t cursor = 0;
+  size_t seen = 0;
+  uint64_t key;
+  void* value;
+  while (epoch_map_next(&map, &cursor, &key, &value)) {
+    TEST_ASSERT(hash_map_get(&ref, key) == value);
+    seen++;
+  }
+  TEST_ASSERT(seen == hash_map_size(&ref));
+
+  hash_map_destroy(&ref);
+  epoch_map_destroy(&map);
+  printf("test_epoch_map_matches_hash_map passed\n");
+}
+
+static void test_crc32c_check_value_and_chaining(void) {
+  static const char check[] = "123456789";
+  TEST_ASSERT(crc32c(0, check, 9) == 0xe3069283u);
+  TEST_ASSERT(crc32c(0, NULL, 0) == 0);
+
+  // Odd split points exercise the 8-, 4- and 1-byte tails
+  uint8_t buf[67];
+  for (size_t i = 0; i < sizeof(buf); i++)
+    buf[i] = (uint8_t)(i * 37u + 11u);
+  uint32_t whole = crc32c(0, buf, sizeof(buf));
+  for (size_t split = 0; split <= sizeof(buf); split++)
+    TEST_ASSERT(crc32c(crc32c(0, buf, split), buf + split, sizeof(buf) - split) == whole);
+
+  printf("test_crc32c_check_value_and_chaining passed (%s)\n", crc32c_kernel());
+}
+
 static void test_alloc_fail_arena(void) {
   printf("Running test_alloc_fail_arena...\n");
   pid_t pid = fork();
@@ -584,15 +956,27 @@ int main(void) {
   test_arena_zero_and_large_alloc();
   test_arena_reset_semantics();
   test_arena_strings();
+  test_arena_stats_and_decay();
 
   test_small_vec_basic();
   test_small_vec_growth();
+  test_handle_vec_ops();
+  test_typed_vec_inline_and_growth();
 
   test_hash_map_basic();
   test_hash_map_update_and_reinsert();
   test_hash_map_clear_reuses_capacity();
   test_hash_map_stress_linear_probe_tombstones();
   test_hash_map_prng_sequence();
+  test_hash_map_swiss_basic();
+  test_hash_map_swiss_churn_bounded();
+  test_hash_map_swiss_matches_linear();
+
+  test_epoch_map_basic_and_order();
+  test_epoch_map_clear_is_epoch_bump();
+  test_epoch_map_matches_hash_map();
+
+  test_crc32c_check_value_and_chaining();
 
   test_alloc_fail_arena();
   test_alloc_fail_small_vec();
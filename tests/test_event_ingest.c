@@ -1,3 +1,4 @@
+#include <X11/keysym.h>
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,6 +7,8 @@
 #include <xcb/randr.h>
 
 #include "event.h"
+#include "wm.h"
+#include "xcb_utils.h"
 
 extern void xcb_stubs_reset(void);
 extern void atoms_init(xcb_connection_t* conn);
@@ -13,6 +16,11 @@ extern bool xcb_stubs_enqueue_queued_event(xcb_generic_event_t* ev);
 extern bool xcb_stubs_enqueue_event(xcb_generic_event_t* ev);
 extern size_t xcb_stubs_queued_event_len(void);
 extern size_t xcb_stubs_event_len(void);
+extern int stub_grab_key_count;
+extern int stub_ungrab_key_count;
+extern xcb_keycode_t stub_last_grab_keycode;
+extern uint8_t stub_keycode_offset;
+extern int stub_refresh_keyboard_mapping_count;
 
 static xcb_generic_event_t* make_event(uint8_t type) {
   xcb_generic_event_t* ev = calloc(1, sizeof(*ev));
@@ -26,6 +34,7 @@ static void setup_server(server_t* s) {
   atoms_init(s->conn);
   cookie_jar_init(&s->cookie_jar);
   arena_init(&s->tick_arena, 1024);
+  event_ring_init(&s->event_ring, EVENT_RING_CAP);
 
   small_vec_init(&s->buckets.map_requests);
   small_vec_init(&s->buckets.unmap_notifies);
@@ -35,19 +44,13 @@ static void setup_server(server_t* s) {
   small_vec_init(&s->buckets.button_events);
   small_vec_init(&s->buckets.client_messages);
 
-  hash_map_init(&s->buckets.expose_regions);
-  small_vec_init(&s->buckets.expose_region_keys);
-  hash_map_init(&s->buckets.configure_requests);
-  small_vec_init(&s->buckets.configure_request_keys);
-  hash_map_init(&s->buckets.configure_notifies);
-  small_vec_init(&s->buckets.configure_notify_keys);
-  hash_map_init(&s->buckets.destroyed_windows);
-  hash_map_init(&s->buckets.property_notifies);
-  small_vec_init(&s->buckets.property_notify_keys);
-  hash_map_init(&s->buckets.motion_notifies);
-  small_vec_init(&s->buckets.motion_notify_keys);
-  hash_map_init(&s->buckets.damage_regions);
-  small_vec_init(&s->buckets.damage_region_keys);
+  epoch_map_init(&s->buckets.expose_regions);
+  epoch_map_init(&s->buckets.configure_requests);
+  epoch_map_init(&s->buckets.configure_notifies);
+  epoch_map_init(&s->buckets.destroyed_windows);
+  epoch_map_init(&s->buckets.property_notifies);
+  epoch_map_init(&s->buckets.motion_notifies);
+  epoch_map_init(&s->buckets.damage_regions);
 }
 
 static void cleanup_server(server_t* s) {
@@ -59,21 +62,20 @@ static void cleanup_server(server_t* s) {
   small_vec_destroy(&s->buckets.button_events);
   small_vec_destroy(&s->buckets.client_messages);
 
-  hash_map_destroy(&s->buckets.expose_regions);
-  small_vec_destroy(&s->buckets.expose_region_keys);
-  hash_map_destroy(&s->buckets.configure_requests);
-  small_vec_destroy(&s->buckets.configure_request_keys);
-  hash_map_destroy(&s->buckets.configure_notifies);
-  small_vec_destroy(&s->buckets.configure_notify_keys);
-  hash_map_destroy(&s->buckets.destroyed_windows);
-  hash_map_destroy(&s->buckets.property_notifies);
-  small_vec_destroy(&s->buckets.property_notify_keys);
-  hash_map_destroy(&s->buckets.motion_notifies);
-  small_vec_destroy(&s->buckets.motion_notify_keys);
-  hash_map_destroy(&s->buckets.damage_regions);
-  small_vec_destroy(&s->buckets.damage_region_keys);
+  epoch_map_destroy(&s->buckets.expose_regions);
+  epoch_map_destroy(&s->buckets.configure_requests);
+  free(s->buckets.unmanaged_configs);
+  epoch_map_destroy(&s->buckets.configure_notifies);
+  epoch_map_destroy(&s->buckets.destroyed_windows);
+  epoch_map_destroy(&s->buckets.property_notifies);
+  epoch_map_destroy(&s->buckets.motion_notifies);
+  epoch_map_destroy(&s->buckets.damage_regions);
+  epoch_map_destroy(&s->buckets.client_message_keys);
+  epoch_map_destroy(&s->buckets.client_message_last);
+  epoch_map_destroy(&s->buckets.key_repeats);
 
   arena_destroy(&s->tick_arena);
+  event_ring_destroy(&s->event_ring);
   cookie_jar_destroy(&s->cookie_jar);
   xcb_disconnect(s->conn);
 }
@@ -147,22 +149,59 @@ static void test_event_ingest_coalesces_configure_request(void) {
 
   event_ingest(&s, false);
 
-  assert(hash_map_size(&s.buckets.configure_requests) == 1);
+  // Nobody manages win, so both land in one unmanaged pass-through entry
+  assert(epoch_map_size(&s.buckets.configure_requests) == 0);
+  assert(s.buckets.unmanaged_configs_len == 1);
 
-  pending_config_t* pc = hash_map_get(&s.buckets.configure_requests, win);
-  assert(pc != NULL);
+  pending_config_t* pc = &s.buckets.unmanaged_configs[0];
+  assert(pc->window == win);
   assert(pc->mask == (XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT));
   assert(pc->x == 100);
   assert(pc->y == 200);
   assert(pc->width == 300);
   assert(pc->height == 400);
   assert(s.buckets.coalesced == 1);
+  assert(s.buckets.unmanaged_coalesced == 1);
 
   printf("test_event_ingest_coalesces_configure_request passed\n");
   xcb_stubs_reset();
   cleanup_server(&s);
 }
 
+static void test_event_ingest_destroy_drops_unmanaged_configure(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  xcb_window_t wins[3] = {0x100, 0x200, 0x100};
+  for (int i = 0; i < 3; i++) {
+    xcb_configure_request_event_t* ev = calloc(1, sizeof(*ev));
+    ev->response_type = XCB_CONFIGURE_REQUEST;
+    ev->window = wins[i];
+    ev->value_mask = XCB_CONFIG_WINDOW_X;
+    ev->x = (int16_t)(10 * (i + 1));
+    assert(xcb_stubs_enqueue_queued_event((xcb_generic_event_t*)ev));
+  }
+
+  xcb_destroy_notify_event_t* d = calloc(1, sizeof(*d));
+  d->response_type = XCB_DESTROY_NOTIFY;
+  d->window = 0x200;
+  assert(xcb_stubs_enqueue_queued_event((xcb_generic_event_t*)d));
+
+  event_ingest(&s, false);
+
+  // Arrival order is kept; the third request merged into the first
+  assert(s.buckets.unmanaged_configs_len == 2);
+  assert(s.buckets.unmanaged_configs[0].window == 0x100);
+  assert(s.buckets.unmanaged_configs[0].x == 30);
+  assert(s.buckets.unmanaged_configs[1].window == 0x200);
+  assert(s.buckets.unmanaged_configs[1].mask == 0);
+
+  printf("test_event_ingest_destroy_drops_unmanaged_configure passed\n");
+  xcb_stubs_reset();
+  cleanup_server(&s);
+}
+
 static void test_event_ingest_coalesces_randr(void) {
   server_t s;
   setup_server(&s);
@@ -174,12 +213,14 @@ static void test_event_ingest_coalesces_randr(void) {
   // Event 1: Width=800, Height=600
   xcb_randr_screen_change_notify_event_t* ev1 = calloc(1, sizeof(*ev1));
   ev1->response_type = (uint8_t)(s.randr_event_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY);
+  ev1->root = s.screens[0].root;
   ev1->width = 800;
   ev1->height = 600;
 
   // Event 2: Width=1024, Height=768
   xcb_randr_screen_change_notify_event_t* ev2 = calloc(1, sizeof(*ev2));
   ev2->response_type = (uint8_t)(s.randr_event_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY);
+  ev2->root = s.screens[0].root;
   ev2->width = 1024;
   ev2->height = 768;
 
@@ -189,8 +230,9 @@ static void test_event_ingest_coalesces_randr(void) {
   event_ingest(&s, false);
 
   assert(s.buckets.randr_dirty == true);
-  assert(s.buckets.randr_width == 1024);
-  assert(s.buckets.randr_height == 768);
+  assert(s.buckets.randr_screens == 1u);
+  assert(s.buckets.randr_width[0] == 1024);
+  assert(s.buckets.randr_height[0] == 768);
   assert(s.buckets.coalesced == 1);
 
   printf("test_event_ingest_coalesces_randr passed\n");
@@ -342,13 +384,14 @@ static void test_event_ingest_coalesces_damage(void) {
 
   event_ingest(&s, false);
 
-  assert(hash_map_size(&s.buckets.damage_regions) == 1);
-  dirty_region_t* region = hash_map_get(&s.buckets.damage_regions, win);
+  assert(epoch_map_size(&s.buckets.damage_regions) == 1);
+  dirty_rects_t* region = epoch_map_get(&s.buckets.damage_regions, win);
   assert(region != NULL);
-  assert(region->x == 0);
-  assert(region->y == 0);
-  assert(region->w == 15);
-  assert(region->h == 15);
+  assert(region->count == 1);
+  assert(region->rects[0].x == 0);
+  assert(region->rects[0].y == 0);
+  assert(region->rects[0].w == 15);
+  assert(region->rects[0].h == 15);
   assert(s.buckets.coalesced == 1);
 
   printf("test_event_ingest_coalesces_damage passed\n");
@@ -377,13 +420,13 @@ static void test_event_ingest_coalesces_motion_notify(void) {
   event_ingest(&s, false);
 
   // Should have 1 entry in hash map
-  assert(hash_map_size(&s.buckets.motion_notifies) == 1);
+  assert(epoch_map_size(&s.buckets.motion_notifies) == 1);
 
   // Should have 9 coalesced events
   assert(s.buckets.coalesced == 9);
 
   // The one kept should be the last one (x=90, y=90)
-  xcb_motion_notify_event_t* final_ev = hash_map_get(&s.buckets.motion_notifies, win);
+  xcb_motion_notify_event_t* final_ev = epoch_map_get(&s.buckets.motion_notifies, win);
   assert(final_ev != NULL);
   assert(final_ev->event_x == 90);
   assert(final_ev->event_y == 90);
@@ -393,15 +436,350 @@ static void test_event_ingest_coalesces_motion_notify(void) {
   cleanup_server(&s);
 }
 
+static void enqueue_client_message(xcb_window_t win, xcb_atom_t type, uint32_t d0, uint32_t d1) {
+  xcb_client_message_event_t* ev = calloc(1, sizeof(*ev));
+  ev->response_type = XCB_CLIENT_MESSAGE;
+  ev->format = 32;
+  ev->window = win;
+  ev->type = type;
+  ev->data.data32[0] = d0;
+  ev->data.data32[1] = d1;
+  assert(xcb_stubs_enqueue_queued_event((xcb_generic_event_t*)ev));
+}
+
+static void test_event_ingest_coalesces_client_messages(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  xcb_window_t a = 0x500;
+  xcb_window_t b = 0x600;
+
+  // A desktop burst keeps the last value
+  for (uint32_t d = 1; d <= 3; d++)
+    enqueue_client_message(a, atoms._NET_WM_DESKTOP, d, 0);
+  // A toggle in between keeps every state action
+  enqueue_client_message(b, atoms._NET_WM_STATE, 1, atoms._NET_WM_STATE_FULLSCREEN);
+  enqueue_client_message(b, atoms._NET_WM_STATE, 2, atoms._NET_WM_STATE_FULLSCREEN);
+  enqueue_client_message(b, atoms._NET_WM_STATE, 1, atoms._NET_WM_STATE_FULLSCREEN);
+  // Activating a, b, a leaves b then a
+  enqueue_client_message(a, atoms._NET_ACTIVE_WINDOW, 2, 0);
+  enqueue_client_message(b, atoms._NET_ACTIVE_WINDOW, 2, 0);
+  enqueue_client_message(a, atoms._NET_ACTIVE_WINDOW, 2, 0);
+
+  event_ingest(&s, false);
+
+  xcb_client_message_event_t* kept[16];
+  size_t n = 0;
+  for (size_t i = 0; i < s.buckets.client_messages.length; i++) {
+    if (s.buckets.client_messages.items[i])
+      kept[n++] = s.buckets.client_messages.items[i];
+  }
+  assert(s.buckets.client_messages_dropped == 3);
+  assert(n == 6);
+  assert(kept[0]->type == atoms._NET_WM_DESKTOP && kept[0]->data.data32[0] == 3);
+  assert(kept[1]->type == atoms._NET_WM_STATE && kept[2]->data.data32[0] == 2 && kept[3]->type == atoms._NET_WM_STATE);
+  assert(kept[4]->type == atoms._NET_ACTIVE_WINDOW && kept[4]->window == b);
+  assert(kept[5]->type == atoms._NET_ACTIVE_WINDOW && kept[5]->window == a);
+
+  printf("test_event_ingest_coalesces_client_messages passed\n");
+  xcb_stubs_reset();
+  cleanup_server(&s);
+}
+
+static void test_event_ingest_respects_runtime_budget(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  s.tick_budget.max_events = 8;
+  for (size_t i = 0; i < 12; i++) {
+    assert(xcb_stubs_enqueue_queued_event(make_event(XCB_KEY_PRESS)));
+  }
+
+  event_ingest(&s, false);
+
+  assert(s.buckets.ingested == 8);
+  assert(s.tick_budget.events_used == 8);
+  assert(s.x_poll_immediate == true);
+  assert(xcb_stubs_queued_event_len() == 4);
+
+  printf("test_event_ingest_respects_runtime_budget passed\n");
+  xcb_stubs_reset();
+  cleanup_server(&s);
+}
+
+static void test_tick_budget_adapts(void) {
+  tick_budget_t b;
+  tick_budget_init(&b);
+  assert(b.max_events == MAX_EVENTS_PER_TICK);
+  assert(b.max_replies == COOKIE_JAR_MAX_REPLIES_PER_TICK);
+
+  tick_sample_t t;
+
+  // Cheap tick that exhausted the reply budget grows it
+  tick_sample_init(&t);
+  tick_sample_add(&t, TICK_PHASE_DRAIN, 100000);
+  tick_sample_add(&t, TICK_PHASE_TOTAL, 200000);
+  b.replies_used = b.max_replies;
+  b.events_used = 1;
+  tick_budget_update(&b, &t, false);
+  assert(b.max_replies > COOKIE_JAR_MAX_REPLIES_PER_TICK);
+  assert(b.max_events == MAX_EVENTS_PER_TICK);
+  assert(b.replies_used == 0);
+
+  // Overrun dominated by event processing shrinks the event budget
+  uint32_t replies = b.max_replies;
+  tick_sample_init(&t);
+  tick_sample_add(&t, TICK_PHASE_PROCESS, TICK_BUDGET_TARGET_NS);
+  tick_sample_add(&t, TICK_PHASE_DRAIN, 1000);
+  tick_sample_add(&t, TICK_PHASE_TOTAL, TICK_BUDGET_TARGET_NS * 2);
+  tick_budget_update(&b, &t, false);
+  assert(b.max_events < MAX_EVENTS_PER_TICK);
+  assert(b.max_replies == replies);
+
+  // Repeated overruns never go below the floor
+  for (int i = 0; i < 64; i++)
+    tick_budget_update(&b, &t, false);
+  assert(b.max_events == TICK_BUDGET_EVENTS_MIN);
+
+  // Interactive drags cap replies and cut them first
+  uint32_t events = b.max_events;
+  tick_budget_update(&b, &t, true);
+  assert(b.max_events == events);
+  assert(b.max_replies <= TICK_BUDGET_REPLIES_INTERACTIVE);
+
+  // Growth is bounded
+  tick_sample_init(&t);
+  tick_sample_add(&t, TICK_PHASE_TOTAL, 1000);
+  for (int i = 0; i < 256; i++) {
+    b.events_used = b.max_events;
+    b.replies_used = b.max_replies;
+    tick_budget_update(&b, &t, false);
+  }
+  assert(b.max_events == TICK_BUDGET_EVENTS_MAX);
+  assert(b.max_replies == TICK_BUDGET_REPLIES_MAX);
+
+  printf("test_tick_budget_adapts passed\n");
+}
+
+static bool in_ring(const event_ring_t* r, const void* p) {
+  const event_slot_t* slot = p;
+  return slot >= r->slots && slot < r->slots + r->used;
+}
+
+static xcb_generic_event_t* make_motion(xcb_window_t win, int16_t x) {
+  xcb_motion_notify_event_t* ev = calloc(1, sizeof(*ev));
+  ev->response_type = XCB_MOTION_NOTIFY;
+  ev->event = win;
+  ev->event_x = x;
+  return (xcb_generic_event_t*)ev;
+}
+
+static void test_event_ingest_stages_into_ring(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  // Interleaved motion: runs collapse in-batch, the rest through the bucket
+  assert(xcb_stubs_enqueue_queued_event(make_motion(0x10, 1)));
+  assert(xcb_stubs_enqueue_queued_event(make_motion(0x10, 2)));
+  assert(xcb_stubs_enqueue_queued_event(make_motion(0x20, 3)));
+  assert(xcb_stubs_enqueue_queued_event(make_motion(0x10, 4)));
+  assert(xcb_stubs_enqueue_queued_event(make_event(XCB_KEY_PRESS)));
+
+  event_ingest(&s, false);
+
+  assert(s.event_ring.used == 5);
+  assert(s.buckets.coalesced == 2);
+  assert(s.buckets.ingested == 3);
+  assert(epoch_map_size(&s.buckets.motion_notifies) == 2);
+
+  xcb_motion_notify_event_t* m = epoch_map_get(&s.buckets.motion_notifies, 0x10);
+  assert(m && m->event_x == 4);
+  assert(in_ring(&s.event_ring, m));
+  m = epoch_map_get(&s.buckets.motion_notifies, 0x20);
+  assert(m && m->event_x == 3);
+
+  // Kept events point into the ring instead of a tick_arena copy
+  assert(s.buckets.key_presses.length == 1);
+  assert(in_ring(&s.event_ring, s.buckets.key_presses.items[0]));
+
+  // Next tick recycles the slots
+  event_ingest(&s, false);
+  assert(s.event_ring.used == 0);
+
+  printf("test_event_ingest_stages_into_ring passed\n");
+  xcb_stubs_reset();
+  cleanup_server(&s);
+}
+
+static void test_event_ingest_ring_overflow_falls_back(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  event_ring_destroy(&s.event_ring);
+  event_ring_init(&s.event_ring, 4);
+
+  for (int i = 0; i < 10; i++) {
+    assert(xcb_stubs_enqueue_queued_event(make_event(XCB_KEY_PRESS)));
+  }
+
+  event_ingest(&s, false);
+
+  assert(s.event_ring.used == 4);
+  assert(s.buckets.ingested == 10);
+  assert(s.buckets.key_presses.length == 10);
+  assert(in_ring(&s.event_ring, s.buckets.key_presses.items[3]));
+  assert(!in_ring(&s.event_ring, s.buckets.key_presses.items[4]));
+  for (size_t i = 0; i < s.buckets.key_presses.length; i++) {
+    xcb_generic_event_t* ev = s.buckets.key_presses.items[i];
+    assert(ev->response_type == XCB_KEY_PRESS);
+  }
+
+  printf("test_event_ingest_ring_overflow_falls_back passed\n");
+  xcb_stubs_reset();
+  cleanup_server(&s);
+}
+
+static xcb_generic_event_t* make_key(uint8_t type, xcb_keycode_t key, uint16_t state, xcb_timestamp_t time) {
+  xcb_key_press_event_t* ev = calloc(1, sizeof(xcb_generic_event_t));
+  ev->response_type = type;
+  ev->detail = key;
+  ev->state = state;
+  ev->time = time;
+  return (xcb_generic_event_t*)ev;
+}
+
+static uint32_t key_repeats(server_t* s, size_t i) {
+  return (uint32_t)(uintptr_t)epoch_map_get(&s->buckets.key_repeats, (uintptr_t)s->buckets.key_presses.items[i]);
+}
+
+static void test_event_ingest_folds_key_repeats(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  // Detectable auto-repeat: a held key sends presses only
+  s.key_repeat.detectable = true;
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_PRESS, 40, XCB_MOD_MASK_4, 100)));
+  for (xcb_timestamp_t t = 0; t < 5; t++)
+    assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_PRESS, 40, XCB_MOD_MASK_4, 600 + t * 30)));
+  event_ingest(&s, false);
+
+  // The first press stands alone, the repeats behind it become one entry
+  assert(s.buckets.key_presses.length == 2);
+  assert(key_repeats(&s, 0) == 0);
+  assert(key_repeats(&s, 1) == 5);
+  assert(s.key_repeat.repeats == 5 && s.key_repeat.folded == 4);
+
+  // Still held next tick, then released and pressed again: a fresh press
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_PRESS, 40, XCB_MOD_MASK_4, 800)));
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_RELEASE, 40, XCB_MOD_MASK_4, 810)));
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_PRESS, 40, XCB_MOD_MASK_4, 900)));
+  event_ingest(&s, false);
+  assert(s.buckets.key_presses.length == 2);
+  assert(key_repeats(&s, 0) == 1);
+  assert(key_repeats(&s, 1) == 0);
+
+  // Without it, a repeat is a release and press sharing a timestamp
+  s.key_repeat.detectable = false;
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_RELEASE, 40, XCB_MOD_MASK_4, 950)));
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_PRESS, 40, XCB_MOD_MASK_4, 950)));
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_RELEASE, 40, XCB_MOD_MASK_4, 980)));
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_PRESS, 40, XCB_MOD_MASK_4, 980)));
+  assert(xcb_stubs_enqueue_queued_event(make_key(XCB_KEY_PRESS, 41, XCB_MOD_MASK_4, 990)));
+  event_ingest(&s, false);
+  assert(s.buckets.key_presses.length == 2);
+  assert(key_repeats(&s, 0) == 2);
+  assert(key_repeats(&s, 1) == 0);
+
+  printf("test_event_ingest_folds_key_repeats passed\n");
+  xcb_stubs_reset();
+  cleanup_server(&s);
+}
+
+static xcb_generic_event_t* make_mapping_notify(uint8_t request) {
+  xcb_mapping_notify_event_t* ev = calloc(1, sizeof(*ev));
+  ev->response_type = XCB_MAPPING_NOTIFY;
+  ev->request = request;
+  ev->first_keycode = 8;
+  ev->count = 248;
+  return (xcb_generic_event_t*)ev;
+}
+
+static void test_event_ingest_mapping_notify_regrabs_keys(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  small_vec_init(&s.config.key_bindings);
+  key_binding_t* b = calloc(1, sizeof(*b));
+  b->keysym = XK_Escape;
+  b->modifiers = XCB_MOD_MASK_1;
+  b->action = ACTION_RESTART;
+  small_vec_push(&s.config.key_bindings, b);
+
+  s.keysyms = xcb_key_symbols_alloc(s.conn);
+  wm_setup_keys(&s);
+  xcb_keycode_t old_code = (xcb_keycode_t)(XK_Escape & 0xFF);
+  assert(stub_last_grab_keycode == old_code);
+  // A chord resolved against the old map
+  s.key_dispatch[9][1 << 2] = 1;
+
+  // The keymap moves Escape; a burst of notifies costs one regrab pass
+  stub_keycode_offset = 1;
+  xcb_keycode_t new_code = (xcb_keycode_t)(old_code + 1);
+  int grabs = stub_grab_key_count;
+  int ungrabs = stub_ungrab_key_count;
+  assert(xcb_stubs_enqueue_queued_event(make_mapping_notify(XCB_MAPPING_KEYBOARD)));
+  assert(xcb_stubs_enqueue_queued_event(make_mapping_notify(XCB_MAPPING_KEYBOARD)));
+  event_ingest(&s, false);
+  assert(stub_refresh_keyboard_mapping_count == 2);
+  assert(s.buckets.keymap_dirty);
+  assert(s.buckets.coalesced == 1);
+  assert(stub_grab_key_count == grabs);
+
+  event_process_input(&s);
+  assert(stub_grab_key_count > grabs);
+  assert(stub_ungrab_key_count > ungrabs);
+  assert(stub_last_grab_keycode == new_code);
+  assert(s.key_dispatch[9][1 << 2] == 0);
+
+  // Modifier and pointer button remaps leave the key grabs alone
+  assert(xcb_stubs_enqueue_queued_event(make_mapping_notify(XCB_MAPPING_MODIFIER)));
+  assert(xcb_stubs_enqueue_queued_event(make_mapping_notify(XCB_MAPPING_POINTER)));
+  event_ingest(&s, false);
+  assert(stub_refresh_keyboard_mapping_count == 4);
+  assert(!s.buckets.keymap_dirty);
+
+  printf("test_event_ingest_mapping_notify_regrabs_keys passed\n");
+  xcb_key_symbols_free(s.keysyms);
+  free(b);
+  small_vec_destroy(&s.config.key_bindings);
+  free(s.key_grabs);
+  xcb_stubs_reset();
+  cleanup_server(&s);
+}
+
 int main(void) {
   test_event_ingest_bounded();
   test_event_ingest_drains_all_when_ready();
   test_event_ingest_coalesces_configure_request();
+  test_event_ingest_destroy_drops_unmanaged_configure();
   test_event_ingest_coalesces_randr();
   test_event_ingest_coalesces_pointer_notify();
   test_event_ingest_coalesces_focus_notify();
   test_event_ingest_dispatches_colormap_notify();
   test_event_ingest_coalesces_damage();
   test_event_ingest_coalesces_motion_notify();
+  test_event_ingest_coalesces_client_messages();
+  test_event_ingest_respects_runtime_budget();
+  test_tick_budget_adapts();
+  test_event_ingest_stages_into_ring();
+  test_event_ingest_ring_overflow_falls_back();
+  test_event_ingest_folds_key_repeats();
+  test_event_ingest_mapping_notify_regrabs_keys();
   return 0;
 }
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <xcb/xcb.h>
 
 #include "../src/wm_internal.h"
@@ -22,6 +23,20 @@ extern uint32_t stub_last_config_h;
 extern int stub_prop_calls_len;
 extern int stub_set_input_focus_count;
 
+// Mockable clock for title throttling
+static uint64_t g_mock_time = 0;
+static bool g_use_mock_time = false;
+
+uint64_t monotonic_time_ns(void) {
+  if (g_use_mock_time)
+    return g_mock_time;
+
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+    return 0;
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
 // Counters for wrapped functions
 static int call_wm_handle_key_press = 0;
 static int call_wm_handle_key_release = 0;
@@ -37,10 +52,11 @@ static int call_wm_set_focus = 0;
 static handle_t call_wm_set_focus_last = HANDLE_INVALID;
 
 // Wrappers
-void __wrap_wm_handle_key_press(server_t* s, xcb_key_press_event_t* ev) {
+void __wrap_wm_handle_key_run(server_t* s, xcb_key_press_event_t* ev, uint32_t count, bool repeat) {
   (void)s;
   (void)ev;
-  call_wm_handle_key_press++;
+  (void)repeat;
+  call_wm_handle_key_press += (int)count;
 }
 
 void __wrap_wm_handle_key_release(server_t* s, xcb_key_release_event_t* ev) {
@@ -67,7 +83,7 @@ void __wrap_menu_handle_expose_region(server_t* s, dirty_region_t* region) {
   call_menu_handle_expose_region++;
 }
 
-void __wrap_frame_redraw_region(server_t* s, handle_t h, dirty_region_t* region) {
+void __wrap_frame_redraw_region(server_t* s, handle_t h, dirty_rects_t* region) {
   (void)s;
   (void)h;
   (void)region;
@@ -80,19 +96,22 @@ void __wrap_wm_handle_motion_notify(server_t* s, xcb_motion_notify_event_t* ev)
   call_wm_handle_motion_notify++;
 }
 
-void __wrap_wm_update_monitors(server_t* s) {
+void __wrap_wm_update_monitors(server_t* s, screen_t* scr) {
   (void)s;
+  (void)scr;
   call_wm_update_monitors++;
 }
 
-void __wrap_wm_compute_workarea(server_t* s, rect_t* wa) {
+void __wrap_wm_compute_workarea(server_t* s, screen_t* scr, rect_t* wa) {
   (void)s;
+  (void)scr;
   (void)wa;
   call_wm_compute_workarea++;
 }
 
-void __wrap_wm_publish_workarea(server_t* s, const rect_t* wa) {
+void __wrap_wm_publish_workarea(server_t* s, screen_t* scr, const rect_t* wa) {
   (void)s;
+  (void)scr;
   (void)wa;
   call_wm_publish_workarea++;
 }
@@ -132,24 +151,16 @@ static void setup_server(server_t* s) {
   small_vec_init(&s->buckets.button_events);
   small_vec_init(&s->buckets.client_messages);
 
-  hash_map_init(&s->buckets.expose_regions);
-  small_vec_init(&s->buckets.expose_region_keys);
-  hash_map_init(&s->buckets.configure_requests);
-  small_vec_init(&s->buckets.configure_request_keys);
-  hash_map_init(&s->buckets.configure_notifies);
-  small_vec_init(&s->buckets.configure_notify_keys);
-  hash_map_init(&s->buckets.destroyed_windows);
-  hash_map_init(&s->buckets.property_notifies);
-  small_vec_init(&s->buckets.property_notify_keys);
-  hash_map_init(&s->buckets.motion_notifies);
-  small_vec_init(&s->buckets.motion_notify_keys);
-  hash_map_init(&s->buckets.damage_regions);
-  small_vec_init(&s->buckets.damage_region_keys);
-
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
-  small_vec_init(&s->active_clients);
-  list_init(&s->focus_history);
+  epoch_map_init(&s->buckets.expose_regions);
+  epoch_map_init(&s->buckets.configure_requests);
+  epoch_map_init(&s->buckets.configure_notifies);
+  epoch_map_init(&s->buckets.destroyed_windows);
+  epoch_map_init(&s->buckets.property_notifies);
+  epoch_map_init(&s->buckets.motion_notifies);
+  epoch_map_init(&s->buckets.damage_regions);
+
+  hash_map_init(&s->xid_index);
+  handle_vec_init(&s->active_clients);
   bool ok = slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
   assert(ok);
 }
@@ -163,24 +174,23 @@ static void cleanup_server(server_t* s) {
   small_vec_destroy(&s->buckets.button_events);
   small_vec_destroy(&s->buckets.client_messages);
 
-  hash_map_destroy(&s->buckets.expose_regions);
-  small_vec_destroy(&s->buckets.expose_region_keys);
-  hash_map_destroy(&s->buckets.configure_requests);
-  small_vec_destroy(&s->buckets.configure_request_keys);
-  hash_map_destroy(&s->buckets.configure_notifies);
-  small_vec_destroy(&s->buckets.configure_notify_keys);
-  hash_map_destroy(&s->buckets.destroyed_windows);
-  hash_map_destroy(&s->buckets.property_notifies);
-  small_vec_destroy(&s->buckets.property_notify_keys);
-  hash_map_destroy(&s->buckets.motion_notifies);
-  small_vec_destroy(&s->buckets.motion_notify_keys);
-  hash_map_destroy(&s->buckets.damage_regions);
-  small_vec_destroy(&s->buckets.damage_region_keys);
-
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  epoch_map_destroy(&s->buckets.expose_regions);
+  epoch_map_destroy(&s->buckets.configure_requests);
+  free(s->buckets.unmanaged_configs);
+  free(s->buckets.deferred_props);
+  epoch_map_destroy(&s->buckets.configure_notifies);
+  epoch_map_destroy(&s->buckets.destroyed_windows);
+  epoch_map_destroy(&s->buckets.property_notifies);
+  epoch_map_destroy(&s->buckets.motion_notifies);
+  epoch_map_destroy(&s->buckets.damage_regions);
+
+  hash_map_destroy(&s->xid_index);
+  hash_map_destroy(&s->prop_fetches);
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  small_vec_destroy(&s->active_clients);
+  handle_vec_destroy(&s->active_clients);
+  handle_vec_destroy(&s->dirty_clients);
+  handle_vec_destroy(&s->title_deferred);
 
   arena_destroy(&s->tick_arena);
   xcb_disconnect(s->conn);
@@ -199,11 +209,10 @@ static handle_t add_mapped_client(server_t* s, xcb_window_t xid, xcb_window_t fr
   hot->xid = xid;
   hot->frame = frame;
   hot->state = STATE_MAPPED;
-  list_init(&hot->focus_node);
 
-  small_vec_push(&s->active_clients, handle_to_ptr(h));
-  hash_map_insert(&s->window_to_client, xid, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, frame, handle_to_ptr(h));
+  handle_vec_push(&s->active_clients, h);
+  server_xid_bind(s, xid, XID_CLIENT, h);
+  server_xid_bind(s, frame, XID_FRAME, h);
   return h;
 }
 
@@ -256,9 +265,9 @@ static void test_6_3_menu_expose_dispatch(void) {
 
   s.menu.window = 0xabc;
 
-  dirty_region_t* region = arena_alloc(&s.tick_arena, sizeof(*region));
-  *region = dirty_region_make(0, 0, 100, 100);
-  hash_map_insert(&s.buckets.expose_regions, s.menu.window, region);
+  dirty_rects_t* region = arena_alloc(&s.tick_arena, sizeof(*region));
+  *region = dirty_rects_make(0, 0, 100, 100);
+  epoch_map_insert(&s.buckets.expose_regions, s.menu.window, region);
 
   event_process(&s);
 
@@ -277,7 +286,7 @@ static void test_6_4_motion_notify_dispatch(void) {
 
   xcb_motion_notify_event_t* mn = arena_alloc(&s.tick_arena, sizeof(*mn));
   mn->event = 0x123;
-  hash_map_insert(&s.buckets.motion_notifies, mn->event, mn);
+  epoch_map_insert(&s.buckets.motion_notifies, mn->event, mn);
 
   event_process(&s);
 
@@ -302,7 +311,7 @@ static void test_6_5_configure_request_unknown_window(void) {
   pc->height = 150;
   pc->mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
 
-  hash_map_insert(&s.buckets.configure_requests, win, pc);
+  epoch_map_insert(&s.buckets.configure_requests, win, pc);
 
   // No client registered for 0x999, so it is unknown.
 
@@ -327,8 +336,9 @@ static void test_6_6_randr_dirty_processing(void) {
   reset_counters();
 
   s.buckets.randr_dirty = true;
-  s.buckets.randr_width = 1920;
-  s.buckets.randr_height = 1080;
+  s.buckets.randr_screens = 1u;
+  s.buckets.randr_width[0] = 1920;
+  s.buckets.randr_height[0] = 1080;
 
   event_process(&s);
   wm_flush_dirty(&s, monotonic_time_ns());
@@ -351,7 +361,7 @@ static void test_6_7_focus_in_dispatches_set_focus(void) {
   xcb_stubs_reset();
   reset_counters();
 
-  s.root = 0x1;
+  s.screens[0].root = 0x1;
   handle_t h = add_mapped_client(&s, 0x701, 0x801);
 
   s.buckets.focus_notify.in_valid = true;
@@ -430,7 +440,7 @@ static void test_6_10_focus_target_destroyed_is_filtered(void) {
   s.buckets.focus_notify.in.mode = XCB_NOTIFY_MODE_NORMAL;
   s.buckets.focus_notify.in.detail = XCB_NOTIFY_DETAIL_NONLINEAR;
   s.buckets.focus_notify.in.sequence = 220;
-  hash_map_insert(&s.buckets.destroyed_windows, 0x704, (void*)1);
+  epoch_map_insert(&s.buckets.destroyed_windows, 0x704, (void*)1);
 
   event_process(&s);
 
@@ -500,7 +510,7 @@ static void test_6_13_stale_root_focus_out_after_focus_commit_is_filtered(void)
   xcb_stubs_reset();
   reset_counters();
 
-  s.root = 0x1;
+  s.screens[0].root = 0x1;
   handle_t old_focus = add_mapped_client(&s, 0x706, 0x806);
   handle_t new_focus = add_mapped_client(&s, 0x707, 0x807);
 
@@ -521,7 +531,7 @@ static void test_6_13_stale_root_focus_out_after_focus_commit_is_filtered(void)
   uint16_t committed_focus_seq = s.last_focus_sequence;
 
   s.buckets.focus_notify.out_valid = true;
-  s.buckets.focus_notify.out.event = s.root;
+  s.buckets.focus_notify.out.event = s.screens[0].root;
   s.buckets.focus_notify.out.mode = XCB_NOTIFY_MODE_NORMAL;
   s.buckets.focus_notify.out.detail = XCB_NOTIFY_DETAIL_POINTER_ROOT;
   s.buckets.focus_notify.out.sequence = (uint16_t)(committed_focus_seq - 1u);
@@ -589,6 +599,299 @@ static void test_6_15_pointer_enter_older_than_leave_is_ignored(void) {
   cleanup_server(&s);
 }
 
+static void push_title_notify(server_t* s, xcb_window_t win) {
+  xcb_property_notify_event_t* ev = arena_alloc(&s->tick_arena, sizeof(*ev));
+  memset(ev, 0, sizeof(*ev));
+  ev->response_type = XCB_PROPERTY_NOTIFY;
+  ev->window = win;
+  ev->atom = atoms._NET_WM_NAME;
+  epoch_map_insert(&s->buckets.property_notifies, ((uint64_t)win << 32) | ev->atom, ev);
+}
+
+static bool take_title_dirty(server_t* s, client_hot_t* hot) {
+  epoch_map_clear(&s->buckets.property_notifies);
+  bool dirty = (hot->dirty & DIRTY_TITLE) != 0;
+  hot->dirty = 0;
+  handle_vec_clear(&s->dirty_clients);
+  return dirty;
+}
+
+static void test_6_16_chatty_titles_are_throttled(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_counters();
+
+  handle_t h = add_mapped_client(&s, 0x100, 0x200);
+  client_hot_t* hot = server_chot(&s, h);
+  client_cold_t* cold = server_ccold(&s, h);
+  cold->title_deferred = false;
+  cold->title_refresh_ms = 0;
+
+  g_use_mock_time = true;
+  g_mock_time = 10ull * 1000000000ull;
+
+  // First change after a quiet period goes straight through
+  push_title_notify(&s, 0x100);
+  event_process(&s);
+  assert(take_title_dirty(&s, hot));
+
+  // A burst inside the interval collapses into one trailing refresh
+  for (int i = 1; i <= 5; i++) {
+    g_mock_time += 40ull * 1000000ull;
+    push_title_notify(&s, 0x100);
+    event_process(&s);
+    assert(!take_title_dirty(&s, hot));
+  }
+  assert(s.title_deferred.length == 1);
+  assert(cold->title_deferred);
+
+  // Once the interval passes the trailing refresh lands without a new notify
+  g_mock_time += 60ull * 1000000ull;
+  event_process(&s);
+  assert(take_title_dirty(&s, hot));
+  assert(s.title_deferred.length == 0);
+  assert(!cold->title_deferred);
+
+  // The focused client gets a shorter interval
+  hot->flags |= CLIENT_FLAG_FOCUSED;
+  g_mock_time += 40ull * 1000000ull;
+  push_title_notify(&s, 0x100);
+  event_process(&s);
+  assert(take_title_dirty(&s, hot));
+
+  g_use_mock_time = false;
+  printf("test_6_16_chatty_titles_are_throttled passed\n");
+  cleanup_server(&s);
+}
+
+static void test_6_17_confirmed_focus_in_skips_recommit(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_counters();
+
+  s.screens[0].root = 0x1;
+  handle_t h = add_mapped_client(&s, 0x708, 0x808);
+  s.focused_client = h;
+
+  s.buckets.focus_notify.in_valid = true;
+  s.buckets.focus_notify.in.event = 0x708;
+  s.buckets.focus_notify.in.mode = XCB_NOTIFY_MODE_NORMAL;
+  s.buckets.focus_notify.in.detail = XCB_NOTIFY_DETAIL_NONLINEAR;
+  s.buckets.focus_notify.in.sequence = 240;
+
+  event_process(&s);
+
+  // The server already focused the client, so the flush has nothing to send
+  assert(call_wm_set_focus == 1);
+  assert(s.committed_focus == 0x708);
+
+  // FocusIn on the frame resolves to the client but does not confirm its window
+  s.committed_focus = XCB_NONE;
+  s.buckets.focus_notify.in_valid = true;
+  s.buckets.focus_notify.in.event = 0x808;
+  s.buckets.focus_notify.in.sequence = 250;
+
+  event_process(&s);
+
+  assert(call_wm_set_focus == 2);
+  assert(s.committed_focus == XCB_NONE);
+
+  printf("test_6_17_confirmed_focus_in_skips_recommit passed\n");
+  cleanup_server(&s);
+}
+
+static void push_pointer_enter(server_t* s, xcb_window_t win, uint32_t time, int16_t x, int16_t y) {
+  s->buckets.pointer_notify.enter_valid = true;
+  s->buckets.pointer_notify.enter.event = win;
+  s->buckets.pointer_notify.enter.mode = XCB_NOTIFY_MODE_NORMAL;
+  s->buckets.pointer_notify.enter.detail = XCB_NOTIFY_DETAIL_NONLINEAR;
+  s->buckets.pointer_notify.enter.time = time;
+  s->buckets.pointer_notify.enter.root_x = x;
+  s->buckets.pointer_notify.enter.root_y = y;
+}
+
+static void test_6_18_hover_delay_defers_pointer_focus(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_counters();
+
+  g_use_mock_time = true;
+  g_mock_time = 1000000000ull;
+  s.config.focus_follows_mouse = true;
+  s.config.focus_hover_delay_ms = 100;
+  handle_t a = add_mapped_client(&s, 0x70a, 0x80a);
+  handle_t b = add_mapped_client(&s, 0x70b, 0x80b);
+
+  // Sweeping over A into B arms only B's deadline
+  push_pointer_enter(&s, 0x80a, 200, 10, 10);
+  event_process(&s);
+  assert(call_wm_set_focus == 0);
+  assert(s.hover_target == a);
+
+  g_mock_time += 20000000ull;
+  push_pointer_enter(&s, 0x80b, 220, 600, 10);
+  event_process(&s);
+  assert(call_wm_set_focus == 0);
+  assert(s.hover_target == b);
+
+  s.buckets.pointer_notify.enter_valid = false;
+  g_mock_time += 50000000ull;
+  event_process(&s);
+  assert(call_wm_set_focus == 0);
+
+  g_mock_time += 50000000ull;
+  event_process(&s);
+  assert(call_wm_set_focus == 1);
+  assert(call_wm_set_focus_last == b);
+  assert(s.hover_target == HANDLE_INVALID);
+
+  g_use_mock_time = false;
+  printf("test_6_18_hover_delay_defers_pointer_focus passed\n");
+  cleanup_server(&s);
+}
+
+static void test_6_19_slow_crossing_focuses_without_delay(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_counters();
+
+  s.config.focus_follows_mouse = true;
+  s.config.focus_hover_delay_ms = 100;
+  s.config.focus_hover_speed = 200;
+  add_mapped_client(&s, 0x70c, 0x80c);
+  handle_t b = add_mapped_client(&s, 0x70d, 0x80d);
+
+  push_pointer_enter(&s, 0x80c, 1000, 100, 100);
+  event_process(&s);
+  assert(call_wm_set_focus == 0);
+
+  // 10px in 80ms is 125 px/s
+  push_pointer_enter(&s, 0x80d, 1080, 110, 100);
+  event_process(&s);
+  assert(call_wm_set_focus == 1);
+  assert(call_wm_set_focus_last == b);
+  assert(s.hover_target == HANDLE_INVALID);
+
+  printf("test_6_19_slow_crossing_focuses_without_delay passed\n");
+  cleanup_server(&s);
+}
+
+static void test_6_20_unmanaged_configures_forward_verbatim(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_counters();
+
+  // A managed client must not be touched by the pass-through
+  add_mapped_client(&s, 0x900, 0x901);
+
+  pending_config_t reqs[3] = {
+      {.window = 0x700, .x = 5, .y = 6, .width = 70, .height = 80,
+       .mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT},
+      {.window = 0x701, .x = 1, .mask = 0}, /* dropped by a DestroyNotify */
+      {.window = 0x702, .x = 9, .y = 10, .width = 11, .height = 12,
+       .mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT},
+  };
+  s.buckets.unmanaged_configs = malloc(sizeof(reqs));
+  memcpy(s.buckets.unmanaged_configs, reqs, sizeof(reqs));
+  s.buckets.unmanaged_configs_len = s.buckets.unmanaged_configs_cap = 3;
+
+  event_process(&s);
+  wm_flush_dirty(&s, monotonic_time_ns());
+
+  assert(stub_configure_window_count == 2);
+  assert(stub_last_config_window == 0x702);
+  assert(stub_last_config_x == 9);
+  assert(stub_last_config_h == 12);
+  assert(s.buckets.unmanaged_forwarded == 2);
+  assert(s.buckets.unmanaged_configs_len == 0);
+
+  printf("test_6_20_unmanaged_configures_forward_verbatim passed\n");
+  cleanup_server(&s);
+}
+
+static void push_property_notify(server_t* s, xcb_window_t win, xcb_atom_t atom) {
+  xcb_property_notify_event_t* ev = arena_alloc(&s->tick_arena, sizeof(*ev));
+  memset(ev, 0, sizeof(*ev));
+  ev->response_type = XCB_PROPERTY_NOTIFY;
+  ev->window = win;
+  ev->atom = atom;
+  epoch_map_insert(&s->buckets.property_notifies, ((uint64_t)win << 32) | atom, ev);
+}
+
+static void test_6_21_input_lane_reports_input(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_counters();
+
+  add_mapped_client(&s, 0x100, 0x200);
+  push_property_notify(&s, 0x100, 5000);
+  assert(!event_process_input(&s));
+  assert(event_bulk_pending(&s));
+
+  xcb_key_press_event_t* ev = arena_alloc(&s.tick_arena, sizeof(*ev));
+  memset(ev, 0, sizeof(*ev));
+  ev->response_type = XCB_KEY_PRESS;
+  small_vec_push(&s.buckets.key_presses, ev);
+  assert(event_process_input(&s));
+  assert(call_wm_handle_key_press == 1);
+
+  event_process_bulk(&s, 0);
+  epoch_map_clear(&s.buckets.property_notifies);
+  assert(!event_bulk_pending(&s));
+
+  printf("test_6_21_input_lane_reports_input passed\n");
+  cleanup_server(&s);
+}
+
+static void test_6_22_late_property_work_is_deferred(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_counters();
+
+  add_mapped_client(&s, 0x100, 0x200);
+  g_use_mock_time = true;
+  g_mock_time = 10ull * 1000000000ull;
+
+  // The deadline is long gone: only the guaranteed share runs
+  const uint32_t total = EVENT_BULK_PROPS_MIN + 16u;
+  for (uint32_t i = 0; i < total; i++)
+    push_property_notify(&s, 0x100, 5000 + i);
+  event_process_bulk(&s, 1);
+  assert(s.buckets.deferred_props_len == 16);
+  assert(s.buckets.props_deferred == 16);
+  assert(s.buckets.deferred_props[0].atom == 5000 + EVENT_BULK_PROPS_MIN);
+  assert(event_bulk_pending(&s));
+
+  // Next tick replays them first; one superseded by a fresh notify is dropped
+  epoch_map_clear(&s.buckets.property_notifies);
+  push_property_notify(&s, 0x100, 5000 + EVENT_BULK_PROPS_MIN);
+  event_process_bulk(&s, 0);
+  assert(s.buckets.deferred_props_len == 0);
+  assert(s.buckets.props_deferred == 16);
+
+  // Notifies for windows gone in between are dropped, not deferred again
+  epoch_map_clear(&s.buckets.property_notifies);
+  for (uint32_t i = 0; i < total; i++)
+    push_property_notify(&s, 0x100, 6000 + i);
+  event_process_bulk(&s, 1);
+  assert(s.buckets.deferred_props_len == 16);
+  server_xid_unbind(&s, 0x100, XID_CLIENT);
+  epoch_map_clear(&s.buckets.property_notifies);
+  event_process_bulk(&s, 1);
+  assert(s.buckets.deferred_props_len == 0);
+
+  g_use_mock_time = false;
+  printf("test_6_22_late_property_work_is_deferred passed\n");
+  cleanup_server(&s);
+}
+
 int main(void) {
   test_6_1_key_press_dispatch();
   test_6_2_button_events_dispatch();
@@ -605,5 +908,12 @@ int main(void) {
   test_6_13_stale_root_focus_out_after_focus_commit_is_filtered();
   test_6_14_pointer_enter_focuses_when_enabled();
   test_6_15_pointer_enter_older_than_leave_is_ignored();
+  test_6_16_chatty_titles_are_throttled();
+  test_6_17_confirmed_focus_in_skips_recommit();
+  test_6_18_hover_delay_defers_pointer_focus();
+  test_6_19_slow_crossing_focuses_without_delay();
+  test_6_20_unmanaged_configures_forward_verbatim();
+  test_6_21_input_lane_reports_input();
+  test_6_22_late_property_work_is_deferred();
   return 0;
 }
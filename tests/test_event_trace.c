@@ -0,0 +1,106 @@
+/*
+ * Round-trip tests for the event trace recorder and reader
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "event_trace.h"
+
+static uint64_t fake_now;
+
+uint64_t monotonic_time_ns(void) { return fake_now; }
+
+static void trace_path(char* buf, size_t len) {
+  snprintf(buf, len, "/tmp/hxm-test-trace-%d", (int)getpid());
+}
+
+static void test_round_trip(void) {
+  char path[64];
+  trace_path(path, sizeof(path));
+  setenv(EVENT_TRACE_ENV, path, 1);
+  assert(event_trace_open_from_env());
+  assert(event_trace_recording());
+
+  event_trace_tick(100);
+
+  xcb_generic_event_t ev = {.response_type = XCB_MAP_REQUEST, .sequence = 7};
+  fake_now = 110;
+  event_trace_event(&ev);
+
+  // Reply carrying two extra words past the fixed 32 bytes
+  uint8_t reply_buf[40] = {0};
+  xcb_generic_reply_t* reply = (xcb_generic_reply_t*)reply_buf;
+  reply->response_type = 1;
+  reply->length = 2;
+  reply_buf[39] = 0xab;
+  cookie_slot_t slot = {.sequence = 9, .type = COOKIE_GET_GEOMETRY, .data = 0x400001};
+  fake_now = 120;
+  event_trace_reply(&slot, reply, NULL);
+
+  xcb_generic_error_t err = {.response_type = 0, .error_code = XCB_WINDOW};
+  event_trace_reply(&slot, NULL, &err);
+
+  event_trace_close();
+  assert(!event_trace_recording());
+  unsetenv(EVENT_TRACE_ENV);
+
+  event_trace_reader_t r;
+  assert(event_trace_reader_open(&r, path));
+  event_trace_hdr_t hdr;
+  const uint8_t* payload = NULL;
+
+  assert(event_trace_reader_next(&r, &hdr, &payload));
+  assert(hdr.kind == EVENT_TRACE_TICK && hdr.t_ns == 100 && hdr.len == 0);
+
+  assert(event_trace_reader_next(&r, &hdr, &payload));
+  assert(hdr.kind == EVENT_TRACE_EVENT && hdr.t_ns == 110 && hdr.len == 32);
+  assert(payload[0] == XCB_MAP_REQUEST);
+
+  assert(event_trace_reader_next(&r, &hdr, &payload));
+  assert(hdr.kind == EVENT_TRACE_REPLY && hdr.len == 40);
+  assert(hdr.cookie_type == COOKIE_GET_GEOMETRY && hdr.data == 0x400001);
+  assert(payload[39] == 0xab);
+
+  assert(event_trace_reader_next(&r, &hdr, &payload));
+  assert(hdr.kind == EVENT_TRACE_ERROR && hdr.len == 32);
+  assert(((const xcb_generic_error_t*)payload)->error_code == XCB_WINDOW);
+
+  assert(!event_trace_reader_next(&r, &hdr, &payload));
+  event_trace_reader_close(&r);
+  unlink(path);
+}
+
+static void test_off_without_env(void) {
+  unsetenv(EVENT_TRACE_ENV);
+  assert(!event_trace_open_from_env());
+  assert(!event_trace_recording());
+
+  // Recording calls are no-ops while off
+  xcb_generic_event_t ev = {.response_type = XCB_MAP_REQUEST};
+  event_trace_tick(1);
+  event_trace_event(&ev);
+}
+
+static void test_rejects_foreign_file(void) {
+  char path[64];
+  trace_path(path, sizeof(path));
+  FILE* f = fopen(path, "wb");
+  assert(f);
+  fputs("not a trace at all", f);
+  fclose(f);
+
+  event_trace_reader_t r;
+  assert(!event_trace_reader_open(&r, path));
+  unlink(path);
+}
+
+int main(void) {
+  test_round_trip();
+  test_off_without_env();
+  test_rejects_foreign_file();
+  return 0;
+}
@@ -44,14 +44,14 @@ static void test_supporting_wm_check_mapped(void) {
   }
 
   // Keep root distinct from stub xid range
-  s.root = 99;
+  s.screens[0].root = 99;
 
   // Ensure atoms table exists
   atoms_init(s.conn);
 
   // Keep server state sane for future logic
   slotmap_init(&s.clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  s.desktop_count = 4;
+  s.screens[0].desktop_count = 4;
   arena_init(&s.tick_arena, 4096);
 
   xcb_stubs_reset();
@@ -59,7 +59,7 @@ static void test_supporting_wm_check_mapped(void) {
   wm_become(&s);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  if (s.supporting_wm_check == XCB_WINDOW_NONE) {
+  if (s.screens[0].supporting_wm_check == XCB_WINDOW_NONE) {
     fprintf(stderr, "FAIL: supporting_wm_check not set\n");
     exit(1);
   }
@@ -69,13 +69,13 @@ static void test_supporting_wm_check_mapped(void) {
     exit(1);
   }
 
-  if (!was_mapped(s.supporting_wm_check)) {
-    fprintf(stderr, "FAIL: supporting_wm_check %u was not mapped\n", s.supporting_wm_check);
+  if (!was_mapped(s.screens[0].supporting_wm_check)) {
+    fprintf(stderr, "FAIL: supporting_wm_check %u was not mapped\n", s.screens[0].supporting_wm_check);
     dump_mapped();
     exit(1);
   }
 
-  printf("PASS: supporting_wm_check %u was mapped\n", s.supporting_wm_check);
+  printf("PASS: supporting_wm_check %u was mapped\n", s.screens[0].supporting_wm_check);
 
   arena_destroy(&s.tick_arena);
   slotmap_destroy(&s.clients);
@@ -124,25 +124,25 @@ static void test_net_client_list_published(void) {
   memset(&s, 0, sizeof(s));
 
   s.conn = xcb_connect(NULL, NULL);
-  s.root = 1;
+  s.screens[0].root = 1;
   atoms_init(s.conn);
   slotmap_init(&s.clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  small_vec_init(&s.active_clients);
-  s.desktop_count = 1;
+  handle_vec_init(&s.active_clients);
+  s.screens[0].desktop_count = 1;
   arena_init(&s.tick_arena, 4096);
   xcb_stubs_reset();
 
   // Add a client
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
   (void)h;
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   hot->xid = 12345;
   hot->state = STATE_MAPPED;
 
   // Trigger update
-  s.root_dirty = ROOT_DIRTY_CLIENT_LIST;
+  s.screens[0].root_dirty = ROOT_DIRTY_CLIENT_LIST;
   wm_flush_dirty(&s, monotonic_time_ns());
 
   assert(stub_last_prop_atom == atoms._NET_CLIENT_LIST);
@@ -171,10 +171,10 @@ static void test_refuse_when_substructure_redirect_fails(void) {
   memset(&s, 0, sizeof(s));
 
   s.conn = xcb_connect(NULL, NULL);
-  s.root = 42;
+  s.screens[0].root = 42;
   atoms_init(s.conn);
   slotmap_init(&s.clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  s.desktop_count = 1;
+  s.screens[0].desktop_count = 1;
   arena_init(&s.tick_arena, 4096);
 
   xcb_stubs_reset();
@@ -184,7 +184,7 @@ static void test_refuse_when_substructure_redirect_fails(void) {
   wm_become(&s);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  assert(s.supporting_wm_check == XCB_WINDOW_NONE);
+  assert(s.screens[0].supporting_wm_check == XCB_WINDOW_NONE);
   assert(stub_map_window_count == 0);
   assert(xcb_stubs_get_selection_owner() == XCB_NONE);
 
@@ -201,10 +201,10 @@ static void test_existing_wm_keeps_selection_owner(void) {
   memset(&s1, 0, sizeof(s1));
 
   s1.conn = xcb_connect(NULL, NULL);
-  s1.root = 7;
+  s1.screens[0].root = 7;
   atoms_init(s1.conn);
   slotmap_init(&s1.clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  s1.desktop_count = 1;
+  s1.screens[0].desktop_count = 1;
   arena_init(&s1.tick_arena, 4096);
 
   xcb_stubs_reset();
@@ -212,10 +212,10 @@ static void test_existing_wm_keeps_selection_owner(void) {
   wm_flush_dirty(&s1, monotonic_time_ns());
 
   xcb_window_t owner = xcb_stubs_get_selection_owner();
-  assert(owner == s1.supporting_wm_check);
+  assert(owner == s1.screens[0].supporting_wm_check);
   int map_count = stub_map_window_count;
 
-  const struct stub_prop_call* root_call = find_prop_call(s1.root, atoms._NET_SUPPORTING_WM_CHECK);
+  const struct stub_prop_call* root_call = find_prop_call(s1.screens[0].root, atoms._NET_SUPPORTING_WM_CHECK);
   assert(root_call != NULL);
   const uint32_t* root_val = (const uint32_t*)root_call->data;
   assert(root_val[0] == owner);
@@ -223,15 +223,15 @@ static void test_existing_wm_keeps_selection_owner(void) {
   server_t s2;
   memset(&s2, 0, sizeof(s2));
   s2.conn = xcb_connect(NULL, NULL);
-  s2.root = s1.root;
+  s2.screens[0].root = s1.screens[0].root;
   slotmap_init(&s2.clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  s2.desktop_count = 1;
+  s2.screens[0].desktop_count = 1;
   arena_init(&s2.tick_arena, 4096);
 
   wm_become(&s2);
   wm_flush_dirty(&s2, monotonic_time_ns());
 
-  assert(s2.supporting_wm_check == XCB_WINDOW_NONE);
+  assert(s2.screens[0].supporting_wm_check == XCB_WINDOW_NONE);
   assert(xcb_stubs_get_selection_owner() == owner);
   assert(stub_map_window_count == map_count);
 
@@ -250,31 +250,31 @@ static void test_wm_s0_selection_and_supporting_check(void) {
   memset(&s, 0, sizeof(s));
 
   s.conn = xcb_connect(NULL, NULL);
-  s.root = 77;
+  s.screens[0].root = 77;
   atoms_init(s.conn);
   slotmap_init(&s.clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  s.desktop_count = 1;
+  s.screens[0].desktop_count = 1;
   arena_init(&s.tick_arena, 4096);
   xcb_stubs_reset();
 
   wm_become(&s);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  assert(xcb_stubs_get_selection_owner() == s.supporting_wm_check);
+  assert(xcb_stubs_get_selection_owner() == s.screens[0].supporting_wm_check);
 
-  const struct stub_prop_call* root_call = find_prop_call(s.root, atoms._NET_SUPPORTING_WM_CHECK);
+  const struct stub_prop_call* root_call = find_prop_call(s.screens[0].root, atoms._NET_SUPPORTING_WM_CHECK);
   assert(root_call != NULL);
   assert(root_call->format == 32);
   assert(root_call->len == 1);
   const uint32_t* root_val = (const uint32_t*)root_call->data;
-  assert(root_val[0] == s.supporting_wm_check);
+  assert(root_val[0] == s.screens[0].supporting_wm_check);
 
-  const struct stub_prop_call* support_call = find_prop_call(s.supporting_wm_check, atoms._NET_SUPPORTING_WM_CHECK);
+  const struct stub_prop_call* support_call = find_prop_call(s.screens[0].supporting_wm_check, atoms._NET_SUPPORTING_WM_CHECK);
   assert(support_call != NULL);
   assert(support_call->format == 32);
   assert(support_call->len == 1);
   const uint32_t* support_val = (const uint32_t*)support_call->data;
-  assert(support_val[0] == s.supporting_wm_check);
+  assert(support_val[0] == s.screens[0].supporting_wm_check);
 
   printf("PASS: WM_S0 and _NET_SUPPORTING_WM_CHECK round-trip\n");
 
@@ -288,10 +288,10 @@ static void test_refuse_when_selection_owned(void) {
   memset(&s, 0, sizeof(s));
 
   s.conn = xcb_connect(NULL, NULL);
-  s.root = 55;
+  s.screens[0].root = 55;
   atoms_init(s.conn);
   slotmap_init(&s.clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  s.desktop_count = 1;
+  s.screens[0].desktop_count = 1;
   arena_init(&s.tick_arena, 4096);
 
   xcb_stubs_reset();
@@ -300,7 +300,7 @@ static void test_refuse_when_selection_owned(void) {
   wm_become(&s);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  assert(s.supporting_wm_check == XCB_WINDOW_NONE);
+  assert(s.screens[0].supporting_wm_check == XCB_WINDOW_NONE);
   assert(stub_map_window_count == 0);
   assert(xcb_stubs_get_selection_owner() == 999);
 
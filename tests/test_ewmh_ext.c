@@ -20,8 +20,8 @@ void test_frame_extents(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   arena_init(&s.tick_arena, 4096);
 
@@ -35,7 +35,7 @@ void test_frame_extents(void) {
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
-  small_vec_init(&s.active_clients);
+  handle_vec_init(&s.active_clients);
 
   // Manually setup a client to simulate what client_finish_manage does,
   // but calling wm_flush_dirty is hard because it relies on the loop and hash
@@ -44,15 +44,13 @@ void test_frame_extents(void) {
   // xcb_change_property. So I can just call client_finish_manage if I setup
   // enough context (hash maps).
 
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
-  list_init(&s.focus_history);
+  hash_map_init(&s.xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   client_cold_t* cold = (client_cold_t*)cold_ptr;
   hot->self = h;
@@ -66,7 +64,6 @@ void test_frame_extents(void) {
   hot->stacking_layer = -1;
   list_init(&hot->transient_sibling);
   list_init(&hot->transients_head);
-  list_init(&hot->focus_node);
   cold->visual_id = 0;
 
   // We want to capture the property change for _NET_FRAME_EXTENTS
@@ -89,6 +86,7 @@ void test_frame_extents(void) {
   hot->state = STATE_MAPPED;
   hot->frame = 456;
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&s, hot);
 
   // Clear last prop
   stub_last_prop_atom = 0;
@@ -126,10 +124,10 @@ void test_frame_extents(void) {
 
   // Cleanup
   client_render_payload_destroy(cold);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  handle_vec_destroy(&s.active_clients);
+  hash_map_destroy(&s.xid_index);
   config_destroy(&s.config);
   arena_destroy(&s.tick_arena);
   free(s.conn);
@@ -139,8 +137,8 @@ void test_allowed_actions(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   arena_init(&s.tick_arena, 4096);
 
@@ -151,14 +149,13 @@ void test_allowed_actions(void) {
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
-  small_vec_init(&s.active_clients);
+  handle_vec_init(&s.active_clients);
 
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
+  hash_map_init(&s.xid_index);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   client_cold_t* cold = (client_cold_t*)cold_ptr;
   hot->self = h;
@@ -171,6 +168,7 @@ void test_allowed_actions(void) {
   cold->hints.min_w = 0;
   cold->hints.max_w = 0;  // unlimited
   hot->dirty = DIRTY_STATE;
+  server_queue_client(&s, hot);
 
   // wm_flush_dirty will set WM_STATE and ALLOWED_ACTIONS.
   // ALLOWED_ACTIONS is set LAST in the block.
@@ -203,6 +201,7 @@ void test_allowed_actions(void) {
   cold->hints.min_h = 100;
   cold->hints.max_h = 100;
   hot->dirty = DIRTY_STATE;
+  server_queue_client(&s, hot);
 
   stub_last_prop_atom = 0;
   wm_flush_dirty(&s, monotonic_time_ns());
@@ -224,10 +223,10 @@ void test_allowed_actions(void) {
   printf("test_allowed_actions passed\n");
 
   client_render_payload_destroy(cold);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  handle_vec_destroy(&s.active_clients);
+  hash_map_destroy(&s.xid_index);
   arena_destroy(&s.tick_arena);
   free(s.conn);
 }
@@ -236,11 +235,11 @@ void test_desktop_clamp_single(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
-  s.desktop_count = 1;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 1;
+  s.screens[0].current_desktop = 0;
   arena_init(&s.tick_arena, 4096);
 
   atoms._NET_WM_DESKTOP = 500;
@@ -248,12 +247,11 @@ void test_desktop_clamp_single(void) {
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
-  small_vec_init(&s.active_clients);
-  list_init(&s.focus_history);
+  handle_vec_init(&s.active_clients);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   client_cold_t* cold = (client_cold_t*)cold_ptr;
   hot->self = h;
@@ -262,12 +260,10 @@ void test_desktop_clamp_single(void) {
   hot->state = STATE_MAPPED;
   hot->desktop = 0;
   hot->sticky = false;
-  list_init(&hot->focus_node);
 
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
+  hash_map_init(&s.xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
 
   stub_last_prop_atom = 0;
   wm_client_move_to_workspace(&s, h, 2, false);
@@ -301,13 +297,13 @@ void test_desktop_clamp_single(void) {
 
   printf("test_desktop_clamp_single passed\n");
 
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s.layers[i]);
+    handle_vec_destroy(&s.screens[0].layers[i]);
   client_render_payload_destroy(cold);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   arena_destroy(&s.tick_arena);
   free(s.conn);
 }
@@ -316,22 +312,22 @@ void test_dirty_stack_relayer(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
-  s.root = 1;
+  s.screens[0].root = 1;
   arena_init(&s.tick_arena, 4096);
 
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
-  small_vec_init(&s.active_clients);
+  handle_vec_init(&s.active_clients);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   client_cold_t* cold = (client_cold_t*)cold_ptr;
   hot->self = h;
@@ -348,16 +344,18 @@ void test_dirty_stack_relayer(void) {
 
   hot->layer = LAYER_ABOVE;
   hot->dirty = DIRTY_STACK;
+  server_queue_client(&s, hot);
 
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  assert(s.layers[LAYER_NORMAL].length == 0);
-  assert(s.layers[LAYER_ABOVE].length == 1);
-  assert((handle_t)(uintptr_t)s.layers[LAYER_ABOVE].items[0] == h);
+  assert(s.screens[0].layers[LAYER_NORMAL].length == 0);
+  assert(s.screens[0].layers[LAYER_ABOVE].length == 1);
+  assert(s.screens[0].layers[LAYER_ABOVE].items[0] == h);
 
   printf("test_dirty_stack_relayer passed\n");
 
   client_render_payload_destroy(cold);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
   arena_destroy(&s.tick_arena);
   free(s.conn);
@@ -57,25 +57,23 @@ static void setup_server(server_t* s) {
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
 
-  s->root = 1;
-  s->root_visual = 1;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
 
   config_init_defaults(&s->config);
-  s->desktop_count = 1;
-  s->current_desktop = 0;
-  s->workarea = (rect_t){0, 0, 0, 0};
+  s->screens[0].desktop_count = 1;
+  s->screens[0].current_desktop = 0;
+  s->screens[0].workarea = (rect_t){0, 0, 0, 0};
 
   arena_init(&s->tick_arena, 4096);
   cookie_jar_init(&s->cookie_jar);
   slotmap_init(&s->clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+  hash_map_init(&s->xid_index);
   hash_map_init(&s->pending_unmanaged_states);
-  list_init(&s->focus_history);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
 }
 
 static void cleanup_server(server_t* s) {
@@ -92,9 +90,15 @@ static void cleanup_server(server_t* s) {
     }
   }
   cookie_jar_destroy(&s->cookie_jar);
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  handle_vec_destroy(&s->screens[0].strut_clients);
+  free(s->screens[0].workarea_cache);
+  wm_desktop_members_destroy(s);
+  handle_vec_destroy(&s->screens[0].sticky_members);
+  handle_vec_destroy(&s->screens[0].visibility_moved);
+  s->screens[0].workarea_cache = NULL;
+  hash_map_destroy(&s->xid_index);
   for (size_t i = 0; i < s->pending_unmanaged_states.capacity; i++) {
     hash_map_entry_t* entry = &s->pending_unmanaged_states.entries[i];
     if (!entry->key || !entry->value)
@@ -108,7 +112,7 @@ static void cleanup_server(server_t* s) {
   }
   hash_map_destroy(&s->pending_unmanaged_states);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
   arena_destroy(&s->tick_arena);
   config_destroy(&s->config);
   xcb_disconnect(s->conn);
@@ -138,12 +142,11 @@ static handle_t add_mapped_client(server_t* s, xcb_window_t win, xcb_window_t fr
   hot->server = (rect_t){10, 10, 200, 150};
   hot->desired = hot->server;
 
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s->window_to_client, win, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, frame, handle_to_ptr(h));
+  server_xid_bind(s, win, XID_CLIENT, h);
+  server_xid_bind(s, frame, XID_FRAME, h);
   return h;
 }
 
@@ -174,10 +177,10 @@ static void send_net_restack_window(server_t* s, xcb_window_t win, xcb_window_t
 }
 
 static void assert_layer_order(const server_t* s, int layer, const handle_t* expected, size_t expected_len) {
-  const small_vec_t* v = &s->layers[layer];
+  const handle_vec_t* v = &s->screens[0].layers[layer];
   assert(v->length == expected_len);
   for (size_t i = 0; i < expected_len; i++) {
-    assert((handle_t)(uintptr_t)v->items[i] == expected[i]);
+    assert(v->items[i] == expected[i]);
   }
 }
 
@@ -278,7 +281,7 @@ static void test_unmanaged_wm_state_is_stashed(void) {
   memset(&de, 0, sizeof(de));
   de.response_type = XCB_DESTROY_NOTIFY;
   de.window = win;
-  de.event = s.root;
+  de.event = s.screens[0].root;
   wm_handle_destroy_notify(&s, &de);
 
   assert(hash_map_get(&s.pending_unmanaged_states, win) == NULL);
@@ -294,7 +297,7 @@ static void test_strut_partial_invalid_ranges_ignored(void) {
 
   atoms._NET_WORKAREA = 300;
   atoms._NET_WM_STRUT_PARTIAL = 301;
-  s.desktop_count = 1;
+  s.screens[0].desktop_count = 1;
 
   handle_t h = add_mapped_client(&s, 3001, 3101);
 
@@ -318,7 +321,7 @@ static void test_strut_partial_invalid_ranges_ignored(void) {
   wm_handle_reply(&s, &slot, &reply.r, NULL);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* wa = find_prop_call(s.root, atoms._NET_WORKAREA, false);
+  const struct stub_prop_call* wa = find_prop_call(s.screens[0].root, atoms._NET_WORKAREA, false);
   assert(wa != NULL);
   const uint32_t* vals = (const uint32_t*)wa->data;
   assert(vals[0] == 0);
@@ -365,8 +368,8 @@ static void test_active_window_rejects_stale_application_timestamp(void) {
   setup_server(&s);
   xcb_stubs_reset();
 
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
 
   handle_t h1 = add_mapped_client(&s, 5001, 5101);
   handle_t h2 = add_mapped_client(&s, 5002, 5102);
@@ -384,7 +387,7 @@ static void test_active_window_rejects_stale_application_timestamp(void) {
 
   send_net_active_window(&s, b->xid, 1, 400);
 
-  assert(s.current_desktop == 0);
+  assert(s.screens[0].current_desktop == 0);
   assert(s.focused_client == h1);
 
   printf("test_active_window_rejects_stale_application_timestamp passed\n");
@@ -396,8 +399,8 @@ static void test_active_window_rejects_non_user_cross_desktop_activation(void) {
   setup_server(&s);
   xcb_stubs_reset();
 
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
 
   handle_t h1 = add_mapped_client(&s, 6001, 6101);
   handle_t h2 = add_mapped_client(&s, 6002, 6102);
@@ -415,7 +418,7 @@ static void test_active_window_rejects_non_user_cross_desktop_activation(void) {
 
   send_net_active_window(&s, b->xid, 1, 800);
 
-  assert(s.current_desktop == 0);
+  assert(s.screens[0].current_desktop == 0);
   assert(s.focused_client == h1);
 
   printf("test_active_window_rejects_non_user_cross_desktop_activation passed\n");
@@ -427,8 +430,8 @@ static void test_active_window_user_request_can_switch_desktop(void) {
   setup_server(&s);
   xcb_stubs_reset();
 
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
 
   handle_t h1 = add_mapped_client(&s, 7001, 7101);
   handle_t h2 = add_mapped_client(&s, 7002, 7102);
@@ -446,7 +449,7 @@ static void test_active_window_user_request_can_switch_desktop(void) {
 
   send_net_active_window(&s, b->xid, 2, 1);
 
-  assert(s.current_desktop == 1);
+  assert(s.screens[0].current_desktop == 1);
   assert(s.focused_client == h2);
 
   printf("test_active_window_user_request_can_switch_desktop passed\n");
@@ -458,8 +461,8 @@ static void test_active_window_rejects_missing_timestamp_when_focus_time_known(v
   setup_server(&s);
   xcb_stubs_reset();
 
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
 
   handle_t h1 = add_mapped_client(&s, 8001, 8101);
   handle_t h2 = add_mapped_client(&s, 8002, 8102);
@@ -477,7 +480,7 @@ static void test_active_window_rejects_missing_timestamp_when_focus_time_known(v
 
   send_net_active_window(&s, b->xid, 1, XCB_CURRENT_TIME);
 
-  assert(s.current_desktop == 0);
+  assert(s.screens[0].current_desktop == 0);
   assert(s.focused_client == h1);
 
   printf("test_active_window_rejects_missing_timestamp_when_focus_time_known passed\n");
@@ -533,8 +536,8 @@ static void test_restack_desktop_mismatch_sibling_is_ignored(void) {
   setup_server(&s);
   xcb_stubs_reset();
 
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
 
   handle_t h_helper = add_mapped_client(&s, 9101, 9201);
   handle_t h_sibling = add_mapped_client(&s, 9102, 9202);
@@ -25,7 +25,10 @@ extern int stub_map_window_count;
 extern int stub_unmap_window_count;
 extern xcb_window_t stub_last_mapped_window;
 extern xcb_window_t stub_last_unmapped_window;
+extern xcb_window_t stub_mapped_windows[];
+extern int stub_mapped_windows_len;
 extern int stub_prop_calls_len;
+extern int stub_set_input_focus_count;
 extern struct stub_prop_call {
   xcb_window_t window;
   xcb_atom_t atom;
@@ -68,26 +71,25 @@ static void setup_server(server_t* s) {
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
 
-  s->root = 1;
-  s->root_visual = 1;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
 
   config_init_defaults(&s->config);
-  s->desktop_count = 3;
-  s->current_desktop = 0;
-  s->workarea = (rect_t){0, 0, 1920, 1080};
+  s->screens[0].desktop_count = 3;
+  s->screens[0].current_desktop = 0;
+  s->screens[0].workarea = (rect_t){0, 0, 1920, 1080};
 
   arena_init(&s->tick_arena, 4096);
   cookie_jar_init(&s->cookie_jar);
   slotmap_init(&s->clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  small_vec_init(&s->active_clients);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
-  list_init(&s->focus_history);
+  handle_vec_init(&s->active_clients);
+  handle_vec_init(&s->screens[0].strut_clients);
+  hash_map_init(&s->xid_index);
 
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
 }
 
 static void cleanup_server(server_t* s) {
@@ -104,18 +106,26 @@ static void cleanup_server(server_t* s) {
     }
   }
   cookie_jar_destroy(&s->cookie_jar);
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  small_vec_destroy(&s->active_clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
-  free(s->monitors);
-  s->monitors = NULL;
-  s->monitor_count = 0;
+  handle_vec_destroy(&s->active_clients);
+  handle_vec_destroy(&s->screens[0].strut_clients);
+  free(s->screens[0].workarea_cache);
+  wm_desktop_members_destroy(s);
+  handle_vec_destroy(&s->screens[0].sticky_members);
+  handle_vec_destroy(&s->screens[0].visibility_moved);
+  s->screens[0].workarea_cache = NULL;
+  hash_map_destroy(&s->xid_index);
+  free(s->screens[0].monitors);
+  s->screens[0].monitors = NULL;
+  s->screens[0].monitor_count = 0;
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
+  wm_published_props_destroy(s);
   arena_destroy(&s->tick_arena);
   config_destroy(&s->config);
   xcb_disconnect(s->conn);
+  render_text_shutdown();
   pango_cairo_font_map_set_default(NULL);
   FcFini();
 }
@@ -143,13 +153,12 @@ static handle_t add_mapped_client(server_t* s, xcb_window_t win, xcb_window_t fr
   hot->server = (rect_t){10, 10, 200, 150};
   hot->desired = hot->server;
 
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s->window_to_client, win, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, frame, handle_to_ptr(h));
-  small_vec_push(&s->active_clients, handle_to_ptr(h));
+  server_xid_bind(s, win, XID_CLIENT, h);
+  server_xid_bind(s, frame, XID_FRAME, h);
+  handle_vec_push(&s->active_clients, h);
 
   return h;
 }
@@ -180,7 +189,7 @@ static void test_active_window_updates(void) {
   wm_set_focus(&s, h);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* call = find_prop_call(s.root, atoms._NET_ACTIVE_WINDOW, false);
+  const struct stub_prop_call* call = find_prop_call(s.screens[0].root, atoms._NET_ACTIVE_WINDOW, false);
   assert(call != NULL);
   assert(call->len == 1);
   const uint32_t* val = (const uint32_t*)call->data;
@@ -189,28 +198,77 @@ static void test_active_window_updates(void) {
   wm_set_focus(&s, HANDLE_INVALID);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* del = find_prop_call(s.root, atoms._NET_ACTIVE_WINDOW, true);
+  const struct stub_prop_call* del = find_prop_call(s.screens[0].root, atoms._NET_ACTIVE_WINDOW, true);
   assert(del != NULL);
 
   hot->state = STATE_UNMAPPED;
   s.focused_client = h;
-  s.root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
+  s.screens[0].root_dirty |= ROOT_DIRTY_ACTIVE_WINDOW;
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* del_unmapped = find_prop_call(s.root, atoms._NET_ACTIVE_WINDOW, true);
+  const struct stub_prop_call* del_unmapped = find_prop_call(s.screens[0].root, atoms._NET_ACTIVE_WINDOW, true);
   assert(del_unmapped != NULL);
 
   printf("test_active_window_updates passed\n");
   cleanup_server(&s);
 }
 
+static void test_focus_sweep_commits_final_state(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  atoms._NET_ACTIVE_WINDOW = 200;
+  atoms._NET_WM_STATE = 201;
+
+  handle_t h[4];
+  for (int i = 0; i < 4; i++) {
+    h[i] = add_mapped_client(&s, 1401 + (xcb_window_t)i, 1501 + (xcb_window_t)i);
+    server_ccold(&s, h[i])->can_focus = true;
+  }
+
+  wm_set_focus(&s, h[0]);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  xcb_stubs_reset();
+
+  // Pointer sweeps over B and C on its way to D, all within one tick
+  wm_set_focus(&s, h[1]);
+  wm_set_focus(&s, h[2]);
+  wm_set_focus(&s, h[3]);
+  wm_flush_dirty(&s, monotonic_time_ns());
+
+  assert(find_prop_call(1401, atoms._NET_WM_STATE, false) != NULL);
+  assert(find_prop_call(1402, atoms._NET_WM_STATE, false) == NULL);
+  assert(find_prop_call(1403, atoms._NET_WM_STATE, false) == NULL);
+  assert(find_prop_call(1404, atoms._NET_WM_STATE, false) != NULL);
+  assert(stub_set_input_focus_count == 1);
+
+  const struct stub_prop_call* active = find_prop_call(s.screens[0].root, atoms._NET_ACTIVE_WINDOW, false);
+  assert(active != NULL);
+  assert(((const uint32_t*)active->data)[0] == 1404u);
+
+  // Leaving and coming back within a tick restyles and republishes nothing
+  xcb_stubs_reset();
+  wm_set_focus(&s, h[0]);
+  wm_set_focus(&s, h[3]);
+  wm_flush_dirty(&s, monotonic_time_ns());
+
+  assert(find_prop_call(s.screens[0].root, atoms._NET_ACTIVE_WINDOW, false) == NULL);
+  assert(find_prop_call(1401, atoms._NET_WM_STATE, false) == NULL);
+  assert(find_prop_call(1404, atoms._NET_WM_STATE, false) == NULL);
+  assert(stub_set_input_focus_count == 0);
+
+  printf("test_focus_sweep_commits_final_state passed\n");
+  cleanup_server(&s);
+}
+
 static void test_active_window_exits_show_desktop_mode(void) {
   server_t s;
   setup_server(&s);
   xcb_stubs_reset();
 
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
 
   handle_t h1 = add_mapped_client(&s, 1201, 1301);
   handle_t h2 = add_mapped_client(&s, 1202, 1302);
@@ -227,14 +285,14 @@ static void test_active_window_exits_show_desktop_mode(void) {
   a_cold->user_time = 100;
   b_cold->user_time = 100;
 
-  wm_set_showing_desktop(&s, true);
+  wm_set_showing_desktop(&s, &s.screens[0], true);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* shown = find_prop_call(s.root, atoms._NET_SHOWING_DESKTOP, false);
+  const struct stub_prop_call* shown = find_prop_call(s.screens[0].root, atoms._NET_SHOWING_DESKTOP, false);
   assert(shown != NULL);
   assert(shown->len == 1);
   assert(((const uint32_t*)shown->data)[0] == 1u);
-  assert(s.showing_desktop == true);
+  assert(s.screens[0].showing_desktop == true);
   assert(a->show_desktop_hidden == true);
   assert(b->show_desktop_hidden == true);
   assert(a->state == STATE_UNMAPPED);
@@ -243,11 +301,11 @@ static void test_active_window_exits_show_desktop_mode(void) {
   send_net_active_window(&s, b->xid, 2, 200);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* hidden = find_prop_call(s.root, atoms._NET_SHOWING_DESKTOP, false);
+  const struct stub_prop_call* hidden = find_prop_call(s.screens[0].root, atoms._NET_SHOWING_DESKTOP, false);
   assert(hidden != NULL);
   assert(hidden->len == 1);
   assert(((const uint32_t*)hidden->data)[0] == 0u);
-  assert(s.showing_desktop == false);
+  assert(s.screens[0].showing_desktop == false);
   assert(a->show_desktop_hidden == false);
   assert(b->show_desktop_hidden == false);
   assert(a->state == STATE_MAPPED);
@@ -269,21 +327,21 @@ static void test_restore_exits_show_desktop_mode(void) {
   server_ccold(&s, h)->manage_phase = MANAGE_DONE;
   hot->desktop = 0;
 
-  wm_set_showing_desktop(&s, true);
+  wm_set_showing_desktop(&s, &s.screens[0], true);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  assert(s.showing_desktop == true);
+  assert(s.screens[0].showing_desktop == true);
   assert(hot->show_desktop_hidden == true);
   assert(hot->state == STATE_UNMAPPED);
 
   wm_client_restore(&s, h);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* hidden = find_prop_call(s.root, atoms._NET_SHOWING_DESKTOP, false);
+  const struct stub_prop_call* hidden = find_prop_call(s.screens[0].root, atoms._NET_SHOWING_DESKTOP, false);
   assert(hidden != NULL);
   assert(hidden->len == 1);
   assert(((const uint32_t*)hidden->data)[0] == 0u);
-  assert(s.showing_desktop == false);
+  assert(s.screens[0].showing_desktop == false);
   assert(hot->show_desktop_hidden == false);
   assert(hot->state == STATE_MAPPED);
 
@@ -291,6 +349,51 @@ static void test_restore_exits_show_desktop_mode(void) {
   cleanup_server(&s);
 }
 
+static void test_show_desktop_batches_in_stacking_order(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  // Managed bottom to top as c, a, b; d is on another desktop
+  handle_t a = add_mapped_client(&s, 1601, 1701);
+  handle_t b = add_mapped_client(&s, 1602, 1702);
+  handle_t c = add_mapped_client(&s, 1603, 1703);
+  handle_t d = add_mapped_client(&s, 1604, 1704);
+  server_chot(&s, d)->desktop = 1;
+  client_set_frame_vis(&s, server_chot(&s, d), FRAME_VIS_HIDDEN);
+  stack_raise(&s, c);
+  stack_raise(&s, a);
+  stack_raise(&s, b);
+  stack_raise(&s, d);
+  wm_set_focus(&s, b);
+  wm_flush_dirty(&s, monotonic_time_ns());
+
+  // One unmap per shown frame, bottom-up, and no focus hop through a and c
+  xcb_stubs_reset();
+  wm_set_showing_desktop(&s, &s.screens[0], true);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_unmap_window_count == 3);
+  assert(stub_last_unmapped_window == 1702);
+  assert(stub_set_input_focus_count == 1);
+  assert(s.focused_client == HANDLE_INVALID);
+  assert(server_chot(&s, d)->state == STATE_MAPPED && !server_chot(&s, d)->show_desktop_hidden);
+  assert(server_chot(&s, c)->state == STATE_UNMAPPED);
+
+  // Back top-down, above d and in their old order
+  xcb_stubs_reset();
+  wm_set_showing_desktop(&s, &s.screens[0], false);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_mapped_windows_len == 3);
+  assert(stub_mapped_windows[0] == 1702 && stub_mapped_windows[1] == 1701 && stub_mapped_windows[2] == 1703);
+  const handle_vec_t* normal = &s.screens[0].layers[LAYER_NORMAL];
+  assert(normal->length == 4);
+  assert(normal->items[0] == d && normal->items[1] == c && normal->items[2] == a && normal->items[3] == b);
+  assert(server_chot(&s, c)->state == STATE_MAPPED && server_chot(&s, c)->frame_vis == FRAME_VIS_MAPPED);
+
+  printf("test_show_desktop_batches_in_stacking_order passed\n");
+  cleanup_server(&s);
+}
+
 static void test_client_list_add_remove(void) {
   server_t s;
   setup_server(&s);
@@ -304,10 +407,10 @@ static void test_client_list_add_remove(void) {
   stack_raise(&s, h1);
   stack_raise(&s, h2);
 
-  s.root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* list = find_prop_call(s.root, atoms._NET_CLIENT_LIST, false);
+  const struct stub_prop_call* list = find_prop_call(s.screens[0].root, atoms._NET_CLIENT_LIST, false);
   assert(list != NULL);
   assert(list->len == 2);
   const uint32_t* list_vals = (const uint32_t*)list->data;
@@ -317,7 +420,7 @@ static void test_client_list_add_remove(void) {
   client_unmanage(&s, h1);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* list2 = find_prop_call(s.root, atoms._NET_CLIENT_LIST, false);
+  const struct stub_prop_call* list2 = find_prop_call(s.screens[0].root, atoms._NET_CLIENT_LIST, false);
   assert(list2 != NULL);
   assert(list2->len == 1);
   list_vals = (const uint32_t*)list2->data;
@@ -342,10 +445,10 @@ static void test_client_list_remove_keeps_order(void) {
   (void)h3;
 
   stack_raise(&s, h1);
-  s.root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* list = find_prop_call(s.root, atoms._NET_CLIENT_LIST, false);
+  const struct stub_prop_call* list = find_prop_call(s.screens[0].root, atoms._NET_CLIENT_LIST, false);
   assert(list != NULL);
   assert(list->len == 3);
   const uint32_t* vals = (const uint32_t*)list->data;
@@ -356,7 +459,7 @@ static void test_client_list_remove_keeps_order(void) {
   client_unmanage(&s, h1);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* list_after = find_prop_call(s.root, atoms._NET_CLIENT_LIST, false);
+  const struct stub_prop_call* list_after = find_prop_call(s.screens[0].root, atoms._NET_CLIENT_LIST, false);
   assert(list_after != NULL);
   assert(list_after->len == 2);
   vals = (const uint32_t*)list_after->data;
@@ -395,10 +498,10 @@ static void test_client_list_includes_all_managed(void) {
   wm_client_update_state(&s, h3, 1, atoms._NET_WM_STATE_SKIP_PAGER);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  s.root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST | ROOT_DIRTY_CLIENT_LIST_STACKING;
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* list = find_prop_call(s.root, atoms._NET_CLIENT_LIST, false);
+  const struct stub_prop_call* list = find_prop_call(s.screens[0].root, atoms._NET_CLIENT_LIST, false);
   assert(list != NULL);
   assert(list->len == 4);
   const uint32_t* list_vals = (const uint32_t*)list->data;
@@ -407,7 +510,7 @@ static void test_client_list_includes_all_managed(void) {
   assert(list_vals[2] == 7003);
   assert(list_vals[3] == 7004);
 
-  const struct stub_prop_call* list_stack = find_prop_call(s.root, atoms._NET_CLIENT_LIST_STACKING, false);
+  const struct stub_prop_call* list_stack = find_prop_call(s.screens[0].root, atoms._NET_CLIENT_LIST_STACKING, false);
   assert(list_stack != NULL);
   assert(list_stack->len == 4);
   const uint32_t* stack_vals = (const uint32_t*)list_stack->data;
@@ -428,28 +531,48 @@ static void test_desktop_props_publish_and_switch(void) {
   atoms._NET_NUMBER_OF_DESKTOPS = 400;
   atoms._NET_CURRENT_DESKTOP = 401;
 
-  s.desktop_count = 3;
-  s.current_desktop = 1;
+  s.screens[0].desktop_count = 3;
+  s.screens[0].current_desktop = 1;
 
-  wm_publish_desktop_props(&s);
+  wm_publish_desktop_props(&s, &s.screens[0]);
 
-  const struct stub_prop_call* num = find_prop_call(s.root, atoms._NET_NUMBER_OF_DESKTOPS, false);
+  const struct stub_prop_call* num = find_prop_call(s.screens[0].root, atoms._NET_NUMBER_OF_DESKTOPS, false);
   assert(num != NULL);
   const uint32_t* num_vals = (const uint32_t*)num->data;
   assert(num_vals[0] == 3);
 
-  const struct stub_prop_call* cur = find_prop_call(s.root, atoms._NET_CURRENT_DESKTOP, false);
+  const struct stub_prop_call* cur = find_prop_call(s.screens[0].root, atoms._NET_CURRENT_DESKTOP, false);
   assert(cur != NULL);
   const uint32_t* cur_vals = (const uint32_t*)cur->data;
   assert(cur_vals[0] == 1);
 
-  wm_switch_workspace(&s, 2);
+  // Publishing the same values again writes nothing
+  int calls = stub_prop_calls_len;
+  uint64_t written = s.root_props_written;
+  wm_publish_desktop_props(&s, &s.screens[0]);
+  assert(stub_prop_calls_len == calls);
+  assert(s.root_props_written == written);
+  assert(s.root_props_skipped >= 5);
+
+  wm_switch_workspace(&s, &s.screens[0], 2);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* cur2 = find_prop_call(s.root, atoms._NET_CURRENT_DESKTOP, false);
+  const struct stub_prop_call* cur2 = find_prop_call(s.screens[0].root, atoms._NET_CURRENT_DESKTOP, false);
   assert(cur2 != NULL);
   cur_vals = (const uint32_t*)cur2->data;
   assert(cur_vals[0] == 2);
+  assert(find_prop_call(s.screens[0].root, atoms._NET_NUMBER_OF_DESKTOPS, false) == num);
+
+  // A rename is a change; only the names are written
+  calls = stub_prop_calls_len;
+  char* names[] = {"a", "b", "c"};
+  s.config.desktop_names = names;
+  s.config.desktop_names_count = 3;
+  wm_publish_desktop_props(&s, &s.screens[0]);
+  assert(stub_prop_calls_len == calls + 1);
+  assert(stub_prop_calls[calls].atom == atoms._NET_DESKTOP_NAMES);
+  s.config.desktop_names = NULL;
+  s.config.desktop_names_count = 0;
 
   printf("test_desktop_props_publish_and_switch passed\n");
   cleanup_server(&s);
@@ -503,8 +626,8 @@ static void test_net_wm_desktop_reply_clamps_out_of_range(void) {
   xcb_stubs_reset();
 
   atoms._NET_WM_DESKTOP = 411;
-  s.desktop_count = 2;
-  s.current_desktop = 1;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 1;
 
   handle_t h = add_mapped_client(&s, 8002, 8102);
   client_hot_t* hot = server_chot(&s, h);
@@ -528,7 +651,7 @@ static void test_net_wm_desktop_reply_clamps_out_of_range(void) {
   wm_handle_reply(&s, &slot, &reply.r, NULL);
   assert(hot->net_wm_desktop_seen);
   assert(hot->sticky == false);
-  assert(hot->desktop == (int32_t)s.current_desktop);
+  assert(hot->desktop == (int32_t)s.screens[0].current_desktop);
 
   printf("test_net_wm_desktop_reply_clamps_out_of_range passed\n");
   cleanup_server(&s);
@@ -540,8 +663,8 @@ static void test_net_wm_desktop_reply_moves_after_manage(void) {
   xcb_stubs_reset();
 
   atoms._NET_WM_DESKTOP = 412;
-  s.desktop_count = 3;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 3;
+  s.screens[0].current_desktop = 0;
 
   handle_t h = add_mapped_client(&s, 8003, 8103);
   client_hot_t* hot = server_chot(&s, h);
@@ -754,7 +877,7 @@ static void test_strut_updates_workarea(void) {
 
   atoms._NET_WORKAREA = 500;
   atoms._NET_WM_STRUT_PARTIAL = 501;
-  s.desktop_count = 1;
+  s.screens[0].desktop_count = 1;
 
   handle_t h = add_mapped_client(&s, 3001, 3101);
   client_cold_t* cold = server_ccold(&s, h);
@@ -780,7 +903,7 @@ static void test_strut_updates_workarea(void) {
   wm_handle_reply(&s, &slot, &reply.r, NULL);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* wa = find_prop_call(s.root, atoms._NET_WORKAREA, false);
+  const struct stub_prop_call* wa = find_prop_call(s.screens[0].root, atoms._NET_WORKAREA, false);
   assert(wa != NULL);
   const uint32_t* vals = (const uint32_t*)wa->data;
   assert(vals[0] == 100);
@@ -793,7 +916,7 @@ static void test_strut_updates_workarea(void) {
   wm_handle_reply(&s, &slot, &reply.r, NULL);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* wa2 = find_prop_call(s.root, atoms._NET_WORKAREA, false);
+  const struct stub_prop_call* wa2 = find_prop_call(s.screens[0].root, atoms._NET_WORKAREA, false);
   assert(wa2 != NULL);
   vals = (const uint32_t*)wa2->data;
   assert(vals[0] == 0);
@@ -811,8 +934,8 @@ static void test_workarea_publishes_per_desktop_array(void) {
   xcb_stubs_reset();
 
   atoms._NET_WORKAREA = 550;
-  s.desktop_count = 3;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 3;
+  s.screens[0].current_desktop = 0;
 
   handle_t h_top = add_mapped_client(&s, 3201, 3301);
   handle_t h_left = add_mapped_client(&s, 3202, 3302);
@@ -827,17 +950,19 @@ static void test_workarea_publishes_per_desktop_array(void) {
   top_hot->sticky = false;
   top_cold->strut.top = 30;
   top_cold->strut_full_active = true;
+  wm_client_strut_changed(&s, h_top);
 
   left_hot->type = WINDOW_TYPE_DOCK;
   left_hot->desktop = 1;
   left_hot->sticky = false;
   left_cold->strut.left = 40;
   left_cold->strut_full_active = true;
+  wm_client_strut_changed(&s, h_left);
 
-  s.root_dirty |= ROOT_DIRTY_WORKAREA;
+  s.screens[0].root_dirty |= ROOT_DIRTY_WORKAREA;
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* wa = find_prop_call(s.root, atoms._NET_WORKAREA, false);
+  const struct stub_prop_call* wa = find_prop_call(s.screens[0].root, atoms._NET_WORKAREA, false);
   assert(wa != NULL);
   assert(wa->len == 12);
   const uint32_t* vals = (const uint32_t*)wa->data;
@@ -864,19 +989,19 @@ static void test_maximize_and_fullscreen_use_client_desktop_monitor_workarea(voi
   xcb_stubs_reset();
 
   atoms._NET_WM_STATE_FULLSCREEN = 560;
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
   s.config.theme.border_width = 0;
   s.config.theme.title_height = 0;
   s.config.fullscreen_use_workarea = true;
 
-  s.monitors = calloc(2, sizeof(monitor_t));
-  assert(s.monitors != NULL);
-  s.monitor_count = 2;
-  s.monitors[0].geom = (rect_t){0, 0, 960, 1080};
-  s.monitors[1].geom = (rect_t){960, 0, 960, 1080};
-  s.monitors[0].workarea = s.monitors[0].geom;
-  s.monitors[1].workarea = s.monitors[1].geom;
+  s.screens[0].monitors = calloc(2, sizeof(monitor_t));
+  assert(s.screens[0].monitors != NULL);
+  s.screens[0].monitor_count = 2;
+  s.screens[0].monitors[0].geom = (rect_t){0, 0, 960, 1080};
+  s.screens[0].monitors[1].geom = (rect_t){960, 0, 960, 1080};
+  s.screens[0].monitors[0].workarea = s.screens[0].monitors[0].geom;
+  s.screens[0].monitors[1].workarea = s.screens[0].monitors[1].geom;
 
   handle_t h_dock = add_mapped_client(&s, 3401, 3501);
   client_hot_t* dock_hot = server_chot(&s, h_dock);
@@ -889,6 +1014,7 @@ static void test_maximize_and_fullscreen_use_client_desktop_monitor_workarea(voi
   dock_cold->strut_partial_active = true;
   dock_cold->strut.top_start_x = 960;
   dock_cold->strut.top_end_x = 1920;
+  wm_client_strut_changed(&s, h_dock);
 
   handle_t h = add_mapped_client(&s, 3402, 3502);
   client_hot_t* hot = server_chot(&s, h);
@@ -965,8 +1091,8 @@ static void test_state_below_sticky_skip_applies(void) {
   atoms._NET_WM_STATE_SKIP_TASKBAR = 913;
   atoms._NET_WM_STATE_SKIP_PAGER = 914;
 
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
 
   handle_t h = add_mapped_client(&s, 6001, 6101);
   client_hot_t* hot = server_chot(&s, h);
@@ -1000,8 +1126,8 @@ static void test_state_below_sticky_skip_applies(void) {
 
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  assert(s.layers[LAYER_BELOW].length == 1);
-  assert(ptr_to_handle(s.layers[LAYER_BELOW].items[0]) == h);
+  assert(s.screens[0].layers[LAYER_BELOW].length == 1);
+  assert(s.screens[0].layers[LAYER_BELOW].items[0] == h);
 
   const struct stub_prop_call* state = find_prop_call(hot->xid, atoms._NET_WM_STATE, false);
   assert(state != NULL);
@@ -1011,7 +1137,7 @@ static void test_state_below_sticky_skip_applies(void) {
   assert(atom_in_state_list((xcb_atom_t*)state->data, state->len, atoms._NET_WM_STATE_SKIP_PAGER));
 
   stub_unmap_window_count = 0;
-  wm_switch_workspace(&s, 1);
+  wm_switch_workspace(&s, &s.screens[0], 1);
   wm_flush_dirty(&s, monotonic_time_ns());
   assert(stub_unmap_window_count == 0);
 
@@ -1083,15 +1209,15 @@ static void test_hidden_state_not_toggled_by_off_desktop_visibility(void) {
   atoms._NET_WM_DESKTOP = 922;
   atoms.WM_STATE = 923;
 
-  s.desktop_count = 2;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 2;
+  s.screens[0].current_desktop = 0;
 
   handle_t h = add_mapped_client(&s, 6201, 6301);
   client_hot_t* hot = server_chot(&s, h);
   assert(hot != NULL);
   hot->desktop = 0;
   hot->sticky = false;
-  hot->dirty |= DIRTY_STATE;
+  server_mark_dirty(&s, hot, DIRTY_STATE);
 
   wm_flush_dirty(&s, monotonic_time_ns());
   assert_hidden_state_flag(hot, false, atoms._NET_WM_STATE, atoms._NET_WM_STATE_HIDDEN);
@@ -1104,9 +1230,9 @@ static void test_hidden_state_not_toggled_by_off_desktop_visibility(void) {
   assert_wm_state_value(hot, atoms.WM_STATE, XCB_ICCCM_WM_STATE_ICONIC);
   assert_hidden_state_flag(hot, false, atoms._NET_WM_STATE, atoms._NET_WM_STATE_HIDDEN);
 
-  wm_switch_workspace(&s, 1);
+  wm_switch_workspace(&s, &s.screens[0], 1);
   wm_flush_dirty(&s, monotonic_time_ns());
-  hot->dirty |= DIRTY_STATE;
+  server_mark_dirty(&s, hot, DIRTY_STATE);
   wm_flush_dirty(&s, monotonic_time_ns());
 
   assert(stub_map_window_count >= 1);
@@ -1163,26 +1289,26 @@ static void test_show_desktop_round_trip_clears_hidden_state(void) {
   assert(hot != NULL);
   server_ccold(&s, h)->manage_phase = MANAGE_DONE;
 
-  wm_set_showing_desktop(&s, true);
+  wm_set_showing_desktop(&s, &s.screens[0], true);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  const struct stub_prop_call* showing = find_prop_call(s.root, atoms._NET_SHOWING_DESKTOP, false);
+  const struct stub_prop_call* showing = find_prop_call(s.screens[0].root, atoms._NET_SHOWING_DESKTOP, false);
   assert(showing != NULL);
   assert(showing->len == 1);
   assert(((const uint32_t*)showing->data)[0] == 1u);
-  assert(s.showing_desktop == true);
+  assert(s.screens[0].showing_desktop == true);
   assert(hot->show_desktop_hidden == true);
   assert(hot->state == STATE_UNMAPPED);
   assert_wm_state_value(hot, atoms.WM_STATE, XCB_ICCCM_WM_STATE_ICONIC);
 
-  wm_set_showing_desktop(&s, false);
+  wm_set_showing_desktop(&s, &s.screens[0], false);
   wm_flush_dirty(&s, monotonic_time_ns());
 
-  showing = find_prop_call(s.root, atoms._NET_SHOWING_DESKTOP, false);
+  showing = find_prop_call(s.screens[0].root, atoms._NET_SHOWING_DESKTOP, false);
   assert(showing != NULL);
   assert(showing->len == 1);
   assert(((const uint32_t*)showing->data)[0] == 0u);
-  assert(s.showing_desktop == false);
+  assert(s.screens[0].showing_desktop == false);
   assert(hot->show_desktop_hidden == false);
   assert(hot->state == STATE_MAPPED);
   assert_wm_state_value(hot, atoms.WM_STATE, XCB_ICCCM_WM_STATE_NORMAL);
@@ -1389,8 +1515,10 @@ static void test_optional_state_properties_stored_in_cold(void) {
 
 int main(void) {
   test_active_window_updates();
+  test_focus_sweep_commits_final_state();
   test_active_window_exits_show_desktop_mode();
   test_restore_exits_show_desktop_mode();
+  test_show_desktop_batches_in_stacking_order();
   test_client_list_add_remove();
   test_client_list_remove_keeps_order();
   test_client_list_includes_all_managed();
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <xcb/damage.h>
+#include <xcb/xinput.h>
 #include <xcb/xproto.h>
 
 #include "event.h"
@@ -28,36 +29,24 @@ static void setup_server(server_t* s) {
   small_vec_init(&s->buckets.button_events);
   small_vec_init(&s->buckets.client_messages);
 
-  hash_map_init(&s->buckets.expose_regions);
-  small_vec_init(&s->buckets.expose_region_keys);
-  hash_map_init(&s->buckets.configure_requests);
-  small_vec_init(&s->buckets.configure_request_keys);
-  hash_map_init(&s->buckets.configure_notifies);
-  small_vec_init(&s->buckets.configure_notify_keys);
-  hash_map_init(&s->buckets.destroyed_windows);
-  hash_map_init(&s->buckets.property_notifies);
-  small_vec_init(&s->buckets.property_notify_keys);
-  hash_map_init(&s->buckets.motion_notifies);
-  small_vec_init(&s->buckets.motion_notify_keys);
-  hash_map_init(&s->buckets.damage_regions);
-  small_vec_init(&s->buckets.damage_region_keys);
+  epoch_map_init(&s->buckets.expose_regions);
+  epoch_map_init(&s->buckets.configure_requests);
+  epoch_map_init(&s->buckets.configure_notifies);
+  epoch_map_init(&s->buckets.destroyed_windows);
+  epoch_map_init(&s->buckets.property_notifies);
+  epoch_map_init(&s->buckets.motion_notifies);
+  epoch_map_init(&s->buckets.damage_regions);
 }
 
 static void cleanup_server(server_t* s) {
   arena_destroy(&s->tick_arena);
-  hash_map_destroy(&s->buckets.expose_regions);
-  small_vec_destroy(&s->buckets.expose_region_keys);
-  hash_map_destroy(&s->buckets.configure_requests);
-  small_vec_destroy(&s->buckets.configure_request_keys);
-  hash_map_destroy(&s->buckets.configure_notifies);
-  small_vec_destroy(&s->buckets.configure_notify_keys);
-  hash_map_destroy(&s->buckets.destroyed_windows);
-  hash_map_destroy(&s->buckets.property_notifies);
-  small_vec_destroy(&s->buckets.property_notify_keys);
-  hash_map_destroy(&s->buckets.motion_notifies);
-  small_vec_destroy(&s->buckets.motion_notify_keys);
-  hash_map_destroy(&s->buckets.damage_regions);
-  small_vec_destroy(&s->buckets.damage_region_keys);
+  epoch_map_destroy(&s->buckets.expose_regions);
+  epoch_map_destroy(&s->buckets.configure_requests);
+  epoch_map_destroy(&s->buckets.configure_notifies);
+  epoch_map_destroy(&s->buckets.destroyed_windows);
+  epoch_map_destroy(&s->buckets.property_notifies);
+  epoch_map_destroy(&s->buckets.motion_notifies);
+  epoch_map_destroy(&s->buckets.damage_regions);
   cookie_jar_destroy(&s->cookie_jar);
   xcb_disconnect(s->conn);
 }
@@ -88,18 +77,56 @@ static void test_expose_coalesces_regions(void) {
 
   event_ingest(&s, true);
 
-  dirty_region_t* region = hash_map_get(&s.buckets.expose_regions, 10);
+  dirty_rects_t* region = epoch_map_get(&s.buckets.expose_regions, 10);
   assert(region != NULL);
-  assert(region->valid);
-  assert(region->x == 10);
-  assert(region->y == 5);
-  assert(region->w == 25);
-  assert(region->h == 25);
+  assert(region->count == 1);
+  assert(region->rects[0].x == 10);
+  assert(region->rects[0].y == 5);
+  assert(region->rects[0].w == 25);
+  assert(region->rects[0].h == 25);
 
   printf("test_expose_coalesces_regions passed\n");
   cleanup_server(&s);
 }
 
+static void test_expose_keeps_distant_rects_apart(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  // Opposite ends of a wide titlebar
+  xcb_expose_event_t* e1 = calloc(1, sizeof(*e1));
+  e1->response_type = XCB_EXPOSE;
+  e1->window = 10;
+  e1->x = 0;
+  e1->y = 0;
+  e1->width = 8;
+  e1->height = 8;
+
+  xcb_expose_event_t* e2 = calloc(1, sizeof(*e2));
+  e2->response_type = XCB_EXPOSE;
+  e2->window = 10;
+  e2->x = 1000;
+  e2->y = 12;
+  e2->width = 8;
+  e2->height = 8;
+
+  assert(xcb_stubs_enqueue_event((xcb_generic_event_t*)e1));
+  assert(xcb_stubs_enqueue_event((xcb_generic_event_t*)e2));
+
+  event_ingest(&s, true);
+
+  dirty_rects_t* region = epoch_map_get(&s.buckets.expose_regions, 10);
+  assert(region != NULL);
+  assert(region->count == 2);
+  assert(s.buckets.coalesced == 1);
+  dirty_region_t bounds = dirty_rects_bounds(region);
+  assert(bounds.x == 0 && bounds.y == 0 && bounds.w == 1008 && bounds.h == 20);
+
+  printf("test_expose_keeps_distant_rects_apart passed\n");
+  cleanup_server(&s);
+}
+
 static void test_damage_coalesces_regions(void) {
   server_t s;
   setup_server(&s);
@@ -129,14 +156,14 @@ static void test_damage_coalesces_regions(void) {
 
   event_ingest(&s, true);
 
-  dirty_region_t* region = hash_map_get(&s.buckets.damage_regions, 99);
+  dirty_rects_t* region = epoch_map_get(&s.buckets.damage_regions, 99);
   (void)region;
   assert(region != NULL);
-  assert(region->valid);
-  assert(region->x == 0);
-  assert(region->y == 0);
-  assert(region->w == 60);
-  assert(region->h == 40);
+  assert(region->count == 1);
+  assert(region->rects[0].x == 0);
+  assert(region->rects[0].y == 0);
+  assert(region->rects[0].w == 60);
+  assert(region->rects[0].h == 40);
 
   printf("test_damage_coalesces_regions passed\n");
   cleanup_server(&s);
@@ -164,7 +191,7 @@ static void test_motion_coalesces_last_event(void) {
 
   event_ingest(&s, true);
 
-  xcb_motion_notify_event_t* last = hash_map_get(&s.buckets.motion_notifies, 42);
+  xcb_motion_notify_event_t* last = epoch_map_get(&s.buckets.motion_notifies, 42);
   (void)last;
   assert(last != NULL);
   assert(last->root_x == 50);
@@ -174,9 +201,59 @@ static void test_motion_coalesces_last_event(void) {
   cleanup_server(&s);
 }
 
+static xcb_generic_event_t* make_xi2_event(uint16_t event_type, uint32_t detail, xcb_input_fp1616_t root_x, xcb_input_fp1616_t root_y, uint32_t buttons) {
+  xcb_input_button_press_event_t* xi = calloc(1, sizeof(*xi) + sizeof(uint32_t));
+  xi->response_type = XCB_GE_GENERIC;
+  xi->extension = 131;
+  xi->event_type = event_type;
+  xi->detail = detail;
+  xi->time = 500;
+  xi->root = 1;
+  xi->event = 42;
+  xi->root_x = root_x;
+  xi->root_y = root_y;
+  xi->buttons_len = 1;
+  xi->mods.effective = XCB_MOD_MASK_SHIFT;
+  memcpy(xi + 1, &buttons, sizeof(buttons));
+  return (xcb_generic_event_t*)xi;
+}
+
+static void test_xi2_events_ingest_as_core(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  s.xi2_supported = true;
+  s.xi2_opcode = 131;
+
+  // 100.75, 20.25 with button 1 held
+  assert(xcb_stubs_enqueue_event(make_xi2_event(XCB_INPUT_MOTION, 0, (100 << 16) + 0xc000, (20 << 16) + 0x4000, 1u << 1)));
+  assert(xcb_stubs_enqueue_event(make_xi2_event(XCB_INPUT_BUTTON_RELEASE, 1, 101 << 16, 21 << 16, 1u << 1)));
+
+  event_ingest(&s, true);
+
+  xcb_motion_notify_event_t* motion = epoch_map_get(&s.buckets.motion_notifies, 42);
+  assert(motion != NULL);
+  assert((motion->response_type & ~0x80) == XCB_MOTION_NOTIFY);
+  assert(motion->root_x == 101);
+  assert(motion->root_y == 20);
+  assert(motion->time == 500);
+  assert(motion->state == (XCB_MOD_MASK_SHIFT | XCB_KEY_BUT_MASK_BUTTON_1));
+
+  assert(s.buckets.button_events.length == 1);
+  xcb_button_release_event_t* release = s.buckets.button_events.items[0];
+  assert((release->response_type & ~0x80) == XCB_BUTTON_RELEASE);
+  assert(release->detail == 1);
+  assert(release->root_x == 101 && release->root_y == 21);
+
+  printf("test_xi2_events_ingest_as_core passed\n");
+  cleanup_server(&s);
+}
+
 int main(void) {
   test_expose_coalesces_regions();
+  test_expose_keeps_distant_rects_apart();
   test_damage_coalesces_regions();
   test_motion_coalesces_last_event();
+  test_xi2_events_ingest_as_core();
   return 0;
 }
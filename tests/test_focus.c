@@ -22,9 +22,8 @@ static void setup_server(server_t* s) {
 
   // Minimal init for focus tests
   slotmap_init(&s->clients, 128, sizeof(client_hot_t), sizeof(client_cold_t));
-  list_init(&s->focus_history);
-  s->desktop_count = 4;
-  s->current_desktop = 0;
+  s->screens[0].desktop_count = 4;
+  s->screens[0].current_desktop = 0;
 }
 
 static void teardown_server(server_t* s) {
@@ -38,6 +37,7 @@ static void teardown_server(server_t* s) {
       }
     }
   }
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
   xcb_disconnect(s->conn);
 }
@@ -101,12 +101,9 @@ void test_debug_dump_focus_history_guard(void) {
     c->frame = 1000 + i;
     c->xid = 2000 + i;
     c->self = handles[i];
-    // Initialize focus_node
-    c->focus_node.prev = &c->focus_node;
-    c->focus_node.next = &c->focus_node;
   }
 
-  // Focus them one by one. This will insert them into s.focus_history.
+  // Focus them one by one. This will insert them into s.focus_mru.
   // wm_set_focus calls debug_dump_focus_history internally if debug logging is
   // enabled.
   for (int i = 0; i < CLIENT_COUNT; i++) {
@@ -115,17 +112,15 @@ void test_debug_dump_focus_history_guard(void) {
 
   // Verify list size roughly (sanity check)
   int count = 0;
-  list_node_t* node = s.focus_history.next;
-  while (node != &s.focus_history) {
+  for (uint32_t i = focus_mru_first(&s.focus_mru); i != 0; i = focus_mru_next(&s.focus_mru, i))
     count++;
-    node = node->next;
-  }
   assert(count == CLIENT_COUNT);
+  assert(s.focus_mru.count == (uint32_t)CLIENT_COUNT);
 
-  // Refocus the first client (which is now at the tail) to cover list_remove
+  // Refocus the first client (which is now at the tail) to cover the relink
   // This moves it to the head
   wm_set_focus(&s, handles[0]);
-  assert(s.focus_history.next == &server_chot(&s, handles[0])->focus_node);
+  assert(focus_mru_first(&s.focus_mru) == server_chot(&s, handles[0])->focus_slot);
 
   printf(
       "test_debug_dump_focus_history_guard passed (check logs for WARN if "
@@ -133,8 +128,81 @@ void test_debug_dump_focus_history_guard(void) {
   teardown_server(&s);
 }
 
+static handle_t add_focus_client(server_t* s, int32_t desktop, window_type_t type) {
+  handle_t h = slotmap_alloc(&s->clients, NULL, NULL);
+  client_hot_t* c = server_chot(s, h);
+  client_render_payload_init(server_ccold(s, h));
+  c->self = h;
+  c->state = STATE_MAPPED;
+  c->desktop = desktop;
+  c->sticky = desktop < 0;
+  c->type = (uint8_t)type;
+  return h;
+}
+
+void test_focus_history_mru(void) {
+  server_t s;
+  setup_server(&s);
+
+  handle_t a = add_focus_client(&s, 0, WINDOW_TYPE_NORMAL);
+  handle_t b = add_focus_client(&s, 1, WINDOW_TYPE_NORMAL);
+  handle_t dock = add_focus_client(&s, 0, WINDOW_TYPE_DOCK);
+  handle_t pinned = add_focus_client(&s, -1, WINDOW_TYPE_NORMAL);
+
+  // Most recent first: pinned, dock, b, a
+  wm_set_focus(&s, a);
+  wm_set_focus(&s, b);
+  wm_set_focus(&s, dock);
+  wm_set_focus(&s, pinned);
+  assert(s.focus_mru.count == 4);
+  assert(focus_mru_handle(&s.focus_mru, focus_mru_first(&s.focus_mru)) == pinned);
+  assert(focus_mru_handle(&s.focus_mru, focus_mru_last(&s.focus_mru)) == a);
+
+  // Desktop filters keep sticky clients; type filters drop the dock
+  assert(wm_focus_history_pick(&s, NULL, 1, FOCUS_MRU_MAPPED) == pinned);
+  assert(wm_focus_history_pick(&s, NULL, 0, FOCUS_MRU_MAPPED | FOCUS_MRU_SWITCHABLE) == pinned);
+  server_chot(&s, pinned)->sticky = false;
+  server_chot(&s, pinned)->desktop = 2;
+  wm_focus_history_update(&s, pinned);
+  assert(wm_focus_history_pick(&s, NULL, 1, FOCUS_MRU_MAPPED) == b);
+  assert(wm_focus_history_pick(&s, NULL, 0, FOCUS_MRU_MAPPED) == dock);
+  assert(wm_focus_history_pick(&s, NULL, 0, FOCUS_MRU_MAPPED | FOCUS_MRU_SWITCHABLE) == a);
+
+  // Refocusing moves a to the head without touching the others' order
+  wm_set_focus(&s, a);
+  uint32_t slot = focus_mru_first(&s.focus_mru);
+  assert(focus_mru_handle(&s.focus_mru, slot) == a);
+  slot = focus_mru_next(&s.focus_mru, slot);
+  assert(focus_mru_handle(&s.focus_mru, slot) == pinned);
+  slot = focus_mru_next(&s.focus_mru, slot);
+  assert(focus_mru_handle(&s.focus_mru, slot) == dock);
+  slot = focus_mru_next(&s.focus_mru, slot);
+  assert(focus_mru_handle(&s.focus_mru, slot) == b);
+  assert(focus_mru_next(&s.focus_mru, slot) == 0);
+
+  // A state change is picked up once the entry is updated
+  server_chot(&s, a)->state = STATE_UNMAPPED;
+  wm_focus_history_update(&s, a);
+  assert(wm_focus_history_pick(&s, NULL, 0, FOCUS_MRU_MAPPED | FOCUS_MRU_SWITCHABLE) == HANDLE_INVALID);
+  assert(wm_focus_history_pick(&s, NULL, FOCUS_MRU_ANY_DESKTOP, FOCUS_MRU_SWITCHABLE) == a);
+
+  // Removed slots are reused by the next insert
+  uint32_t freed = server_chot(&s, dock)->focus_slot;
+  wm_focus_history_remove(&s, dock);
+  assert(server_chot(&s, dock)->focus_slot == 0);
+  assert(s.focus_mru.count == 3);
+  handle_t c = add_focus_client(&s, 0, WINDOW_TYPE_NORMAL);
+  wm_set_focus(&s, c);
+  assert(server_chot(&s, c)->focus_slot == freed);
+  assert(wm_focus_history_pick(&s, NULL, 0, FOCUS_MRU_MAPPED) == c);
+
+  printf("test_focus_history_mru passed\n");
+  teardown_server(&s);
+}
+
 int main(void) {
   test_should_focus_on_map();
   test_debug_dump_focus_history_guard();
+  test_focus_history_mru();
   return 0;
 }
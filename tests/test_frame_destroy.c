@@ -48,19 +48,18 @@ static xcb_generic_event_t make_unmap_event(xcb_window_t win, xcb_window_t event
 static void server_init_for_test(server_t* s) {
   memset(s, 0, sizeof(*s));
   s->is_test = true;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(NULL, 0);
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s->conn = (xcb_connection_t*)malloc(1);  // Mock connection
-  s->root = 497;                           // Arbitrary root
+  s->screens[0].root = 497;                           // Arbitrary root
 
   // Init config
   s->config.theme.border_width = 5;
   s->config.theme.title_height = 20;
 
   // Init list heads
-  list_init(&s->focus_history);
   for (int i = 0; i < LAYER_COUNT; i++) {
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
   }
 
   // Init slotmap
@@ -71,8 +70,7 @@ static void server_init_for_test(server_t* s) {
   cookie_jar_init(&s->cookie_jar);
 
   // Init lookups
-  hash_map_init(&s->frame_to_client);
-  hash_map_init(&s->window_to_client);
+  hash_map_init(&s->xid_index);
 }
 
 static void server_destroy_for_test(server_t* s) {
@@ -86,8 +84,7 @@ static void server_destroy_for_test(server_t* s) {
       }
     }
   }
-  hash_map_destroy(&s->frame_to_client);
-  hash_map_destroy(&s->window_to_client);
+  hash_map_destroy(&s->xid_index);
   cookie_jar_destroy(&s->cookie_jar);
   slotmap_destroy(&s->clients);
   free(s->conn);
@@ -116,14 +113,10 @@ static handle_t test_create_managed_client(server_t* s, xcb_window_t client_xid,
   hot->stacking_layer = -1;
   list_init(&hot->transient_sibling);
   list_init(&hot->transients_head);
-  list_init(&hot->focus_node);
 
   // Register maps
-  hash_map_insert(&s->window_to_client, client_xid, handle_to_ptr(h));
-  // If your window_to_client also tracks frames (some WMs do, some don't,
-  // usually frame_to_client is separate) Based on test_resize.c, there is
-  // s->frame_to_client.
-  hash_map_insert(&s->frame_to_client, frame_xid, handle_to_ptr(h));
+  server_xid_bind(s, client_xid, XID_CLIENT, h);
+  server_xid_bind(s, frame_xid, XID_FRAME, h);
 
   // Also usually we want the client in a layer
   hot->layer = LAYER_NORMAL;
@@ -151,7 +144,7 @@ static void test_frame_destroy_during_interaction_cancels_only(void) {
   assert(s.interaction_handle == h);
 
   // Inject DestroyNotify for the frame window
-  xcb_generic_event_t ge = make_destroy_event(XCB_DESTROY_NOTIFY, frame_xid, s.root);
+  xcb_generic_event_t ge = make_destroy_event(XCB_DESTROY_NOTIFY, frame_xid, s.screens[0].root);
 
   // We need to call the specific handler because event_process_one might need
   // more setup or is static wm_handle_destroy_notify is in wm.h
@@ -183,7 +176,7 @@ static void test_frame_unmap_does_not_unmanage_client(void) {
   assert(server_chot(&s, h) != NULL);
 
   // Inject UnmapNotify for the frame window
-  xcb_generic_event_t ge = make_unmap_event(frame_xid, s.root);
+  xcb_generic_event_t ge = make_unmap_event(frame_xid, s.screens[0].root);
 
   // Call handler directly
   wm_handle_unmap_notify(&s, (xcb_unmap_notify_event_t*)&ge);
@@ -240,9 +233,47 @@ static void test_unmanage_cancels_interaction_before_frame_destroy(void) {
   server_destroy_for_test(&s);
 }
 
+static void test_xid_index_roles(void) {
+  printf("Running test_xid_index_roles...\n");
+  server_t s;
+  server_init_for_test(&s);
+
+  const xcb_window_t client_xid = 0x00600031;
+  const xcb_window_t frame_xid = 0x00400032;
+  handle_t h = test_create_managed_client(&s, client_xid, frame_xid);
+
+  // One entry per window, each answering for its own role only
+  assert(hash_map_size(&s.xid_index) == 2);
+  xid_role_t role;
+  assert(server_xid_lookup(&s, frame_xid, &role) == h && role == XID_FRAME);
+  assert(server_xid_lookup(&s, client_xid, &role) == h && role == XID_CLIENT);
+  assert(server_get_client_by_window(&s, frame_xid) == HANDLE_INVALID);
+  assert(server_get_client_by_frame(&s, client_xid) == HANDLE_INVALID);
+  assert(server_get_client_by_any(&s, frame_xid) == h);
+  assert(server_xid_lookup(&s, 0x00700001, &role) == HANDLE_INVALID && role == XID_NONE);
+
+  // Unbinding in the wrong role leaves the entry alone
+  server_xid_unbind(&s, frame_xid, XID_CLIENT);
+  assert(server_get_client_by_frame(&s, frame_xid) == h);
+
+  // An entry outliving its slot resolves to nothing, even once the slot is reused
+  client_render_payload_destroy(server_ccold(&s, h));
+  slotmap_free(&s.clients, h);
+  assert(server_get_client_by_any(&s, client_xid) == HANDLE_INVALID);
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t again = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
+  assert(handle_index(again) == handle_index(h));
+  client_render_payload_init((client_cold_t*)cold_ptr);
+  assert(server_get_client_by_frame(&s, frame_xid) == HANDLE_INVALID);
+
+  printf("Passed.\n");
+  server_destroy_for_test(&s);
+}
+
 int main(void) {
   test_frame_destroy_during_interaction_cancels_only();
   test_frame_unmap_does_not_unmanage_client();
   test_unmanage_cancels_interaction_before_frame_destroy();
+  test_xid_index_roles();
   return 0;
 }
@@ -0,0 +1,153 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "client.h"
+#include "event.h"
+#include "frame_pool.h"
+#include "mem_budget.h"
+#include "render.h"
+#include "xcb_utils.h"
+
+extern void xcb_stubs_reset(void);
+extern int stub_unmap_window_count;
+extern int stub_destroy_window_count;
+extern xcb_window_t stub_last_destroyed_window;
+extern xcb_window_t stub_last_prop_window;
+extern xcb_atom_t stub_last_prop_atom;
+extern uint32_t stub_last_prop_len;
+
+static xcb_connection_t* g_conn;
+
+static void setup(void) {
+  xcb_stubs_reset();
+  g_conn = xcb_connect(NULL, NULL);
+  atoms_init(g_conn);
+}
+
+static void teardown(void) {
+  xcb_disconnect(g_conn);
+}
+
+static void render_with_surface(render_context_t* r, int w, int h) {
+  render_init(r);
+  r->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+  r->last_title = strdup("old title");
+}
+
+static size_t image_size(int w, int h) {
+  return (size_t)cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, w) * (size_t)h;
+}
+
+void test_frame_pool_fence_and_reuse(void) {
+  setup();
+  frame_pool_t pool;
+  frame_pool_init(&pool);
+
+  render_context_t r;
+  render_with_surface(&r, 100, 20);
+  assert(frame_pool_put(&pool, g_conn, 2, 0x100, 0x1, 24, 1, &r));
+  assert(!r.surface && !r.last_title);
+  assert(stub_unmap_window_count == 1);
+  assert(stub_last_prop_window == 0x100);
+  assert(stub_last_prop_atom == atoms._HXM_FRAME_POOL);
+  assert(stub_last_prop_len == 0);
+
+  // Not handed out before its fence has been seen
+  xcb_window_t frame = XCB_NONE;
+  render_context_t out;
+  assert(!frame_pool_take(&pool, 0x1, 24, 1, &frame, &out));
+  assert(pool.misses == 1);
+
+  assert(!frame_pool_settle(&pool, 0x100, atoms.WM_NAME));
+  assert(frame_pool_settle(&pool, 0x100, atoms._HXM_FRAME_POOL));
+
+  // Keyed by root, depth and visual
+  assert(!frame_pool_take(&pool, 0x2, 24, 1, &frame, &out));
+  assert(!frame_pool_take(&pool, 0x1, 32, 1, &frame, &out));
+  assert(!frame_pool_take(&pool, 0x1, 24, 2, &frame, &out));
+
+  assert(frame_pool_take(&pool, 0x1, 24, 1, &frame, &out));
+  assert(frame == 0x100);
+  assert(out.surface && !out.last_title && !out.title_surface);
+  assert(frame_pool_size(&pool) == 0 && pool.hits == 1);
+
+  render_free(&out);
+  frame_pool_destroy(&pool, g_conn);
+  teardown();
+  printf("test_frame_pool_fence_and_reuse passed\n");
+}
+
+void test_frame_pool_limit_and_trim(void) {
+  setup();
+  frame_pool_t pool;
+  frame_pool_init(&pool);
+
+  render_context_t r;
+  for (xcb_window_t f = 0x100; f < 0x103; f++) {
+    render_with_surface(&r, 100, 20);
+    bool pooled = frame_pool_put(&pool, g_conn, 2, f, 0x1, 24, 1, &r);
+    assert(pooled == (f < 0x102));
+    if (!pooled)
+      render_free(&r);
+  }
+  assert(frame_pool_size(&pool) == 2);
+  assert(frame_pool_bytes(&pool) == 2 * image_size(100, 20));
+
+  // Oldest first
+  assert(frame_pool_trim(&pool, g_conn, 1) == image_size(100, 20));
+  assert(stub_destroy_window_count == 1 && stub_last_destroyed_window == 0x100);
+  assert(frame_pool_size(&pool) == 1 && pool.trimmed == 1);
+
+  // The fence of a trimmed frame is still swallowed
+  assert(frame_pool_settle(&pool, 0x100, atoms._HXM_FRAME_POOL));
+
+  frame_pool_destroy(&pool, g_conn);
+  assert(stub_destroy_window_count == 2 && stub_last_destroyed_window == 0x101);
+  render_with_surface(&r, 10, 10);
+  assert(!frame_pool_put(&pool, g_conn, 2, 0x200, 0x1, 24, 1, &r));
+  render_free(&r);
+
+  teardown();
+  printf("test_frame_pool_limit_and_trim passed\n");
+}
+
+void test_mem_budget_evicts_frame_pool(void) {
+  server_t s;
+  memset(&s, 0, sizeof(s));
+  s.is_test = true;
+  setup();
+  s.conn = g_conn;
+  slotmap_init(&s.clients, 8, sizeof(client_hot_t), sizeof(client_cold_t));
+  title_cache_init(&s.title_cache);
+  frame_pool_init(&s.frame_pool);
+
+  render_context_t r;
+  render_with_surface(&r, 200, 100);
+  assert(frame_pool_put(&s.frame_pool, s.conn, 8, 0x100, 0x1, 24, 1, &r));
+
+  mem_usage_t u;
+  mem_usage_measure(&s, &u);
+  assert(u.bytes[MEM_RENDER] == image_size(200, 100));
+
+  bool queued = false;
+  assert(mem_budget_enforce(&s, 0, &queued) >= image_size(200, 100));
+  assert(queued);
+  assert(frame_pool_size(&s.frame_pool) == 0);
+  assert(s.mem_budget.evicted[MEM_EVICT_FRAME_POOL] == 1);
+  assert(s.mem_budget.evicted_bytes[MEM_EVICT_FRAME_POOL] == image_size(200, 100));
+
+  frame_pool_destroy(&s.frame_pool, s.conn);
+  title_cache_destroy(&s.title_cache);
+  slotmap_destroy(&s.clients);
+  teardown();
+  printf("test_mem_budget_evicts_frame_pool passed\n");
+}
+
+int main(void) {
+  test_frame_pool_fence_and_reuse();
+  test_frame_pool_limit_and_trim();
+  test_mem_budget_evicts_frame_pool();
+  return 0;
+}
@@ -17,6 +17,10 @@
 extern uint32_t stub_last_image_w;
 extern uint32_t stub_last_image_h;
 extern uint8_t stub_last_image_data[200 * 1024];
+extern xcb_drawable_t stub_last_image_drawable;
+extern int stub_free_pixmap_count;
+extern int stub_clear_area_count;
+extern xcb_window_t stub_last_clear_area_window;
 
 static server_t s;
 static client_hot_t* hot;
@@ -26,7 +30,7 @@ static handle_t h;
 static void setup(void) {
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 32;
+  s.screens[0].root_depth = 32;
 
   // Initialize theme with distinct colors
   s.config.theme.border_width = 2;
@@ -56,6 +60,7 @@ static void setup(void) {
   hot->server.h = 100;
   hot->flags = 0;  // Not focused initially
   hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
 
   // Setup render context
   client_render_payload_init(cold);
@@ -64,12 +69,19 @@ static void setup(void) {
   stub_last_image_w = 0;
   stub_last_image_h = 0;
   memset(stub_last_image_data, 0, sizeof(stub_last_image_data));
+  stub_last_image_drawable = XCB_NONE;
+  stub_free_pixmap_count = 0;
+  stub_clear_area_count = 0;
+  stub_last_clear_area_window = XCB_NONE;
 
   // Mock visual
-  s.root_visual_type = xcb_get_visualtype(s.conn, 0);  // Stubs return a valid visual
+  s.screens[0].root_visual_type = xcb_get_visualtype(s.conn, 0);  // Stubs return a valid visual
 }
 
 static void teardown(void) {
+  client_frame_backing_destroy(s.conn, cold);
+  render_tiles_destroy(&s.frame_tiles);
+  title_cache_destroy(&s.title_cache);
   client_render_payload_destroy(cold);
   slotmap_destroy(&s.clients);
 }
@@ -107,6 +119,7 @@ static void test_frame_render_active_color(void) {
   // Set focused
   hot->flags |= CLIENT_FLAG_FOCUSED;
   hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
 
   s.in_commit_phase = true;
   frame_flush(&s, h);
@@ -128,6 +141,7 @@ static void test_frame_controls_position(void) {
   // Active window (Red border, Blue title)
   hot->flags |= CLIENT_FLAG_FOCUSED;
   hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
   hot->server.w = 100;  // Small width
 
   s.in_commit_phase = true;
@@ -168,6 +182,7 @@ static void test_frame_title_background_color(void) {
   // Initially inactive (no focus)
   hot->flags &= ~CLIENT_FLAG_FOCUSED;
   hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
   s.in_commit_phase = true;
   frame_flush(&s, h);
 
@@ -186,6 +201,7 @@ static void test_frame_title_background_color(void) {
   // Now focus the window
   hot->flags |= CLIENT_FLAG_FOCUSED;
   hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
   // Reset stubs? Actually frame_flush will overwrite image data.
   frame_flush(&s, h);
 
@@ -204,6 +220,7 @@ static void test_frame_buttons_present(void) {
 
   hot->flags &= ~CLIENT_FLAG_FOCUSED;
   hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
   s.in_commit_phase = true;
   frame_flush(&s, h);
 
@@ -236,11 +253,207 @@ static void test_frame_buttons_present(void) {
   printf("PASS: Buttons present\n");
 }
 
+static void test_frame_tiles_reused(void) {
+  printf("Testing theme tiles are reused across paints...\n");
+  setup();
+  s.in_commit_phase = true;
+
+  // First paint renders the title slices and the button strip
+  frame_flush(&s, h);
+  assert(s.frame_tiles.title[0].slices != NULL);
+  assert(s.frame_tiles.buttons[0].strip != NULL);
+  assert(s.frame_tiles.builds == 2);
+
+  // Repaints and resizes blit the same tiles
+  hot->server.w = 420;
+  hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(s.frame_tiles.builds == 2);
+
+  // The other state gets its own pair
+  hot->flags |= CLIENT_FLAG_FOCUSED;
+  hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(s.frame_tiles.builds == 4);
+  assert(s.frame_tiles.title[1].height == (int)s.config.theme.title_height);
+
+  // A theme change is picked up without an explicit reset
+  s.config.theme.window_active_title.color = 0xFF112233;
+  hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(s.frame_tiles.builds == 5);
+  assert(s.frame_tiles.title[1].app.color == 0xFF112233);
+
+  // Gradients along x are drawn directly
+  s.config.theme.window_active_title.flags = BG_GRADIENT | BG_HORIZONTAL;
+  hot->dirty = DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(s.frame_tiles.builds == 5);
+
+  teardown();
+  printf("PASS: Theme tiles reused\n");
+}
+
+static void test_frame_backing_pixmap(void) {
+  printf("Testing frame backing pixmap...\n");
+  setup();
+  s.conn = xcb_connect(NULL, NULL);
+  s.config.frame_backing = true;
+  s.in_commit_phase = true;
+
+  // Decorations go to a pixmap, then the frame is cleared to show it
+  frame_flush(&s, h);
+  xcb_pixmap_t pixmap = cold->frame_pixmap;
+  assert(pixmap != XCB_NONE);
+  assert(stub_last_image_drawable == pixmap);
+  assert(cold->frame_pixmap_w == stub_last_image_w && cold->frame_pixmap_h == stub_last_image_h);
+  assert(stub_clear_area_count == 1);
+  assert(stub_last_clear_area_window == hot->frame);
+
+  // Exposes are left to the server
+  dirty_rects_t expose = dirty_rects_make(0, 0, 10, 10);
+  frame_redraw_region(&s, h, &expose);
+  assert(dirty_rects_empty(&cold->frame_damage));
+
+  // A title change repaints the same pixmap
+  hot->dirty |= DIRTY_FRAME_TITLE;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(cold->frame_pixmap == pixmap);
+  assert(stub_clear_area_count == 2);
+  assert(stub_free_pixmap_count == 0);
+
+  // A resize swaps in a new pixmap of the new size
+  hot->server.w = 300;
+  hot->dirty |= DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(cold->frame_pixmap != XCB_NONE && cold->frame_pixmap != pixmap);
+  assert(stub_free_pixmap_count == 1);
+  assert(stub_last_image_w == 300u + 2u * s.config.theme.border_width);
+
+  // Turning the option off falls back to painting the window
+  s.config.frame_backing = false;
+  hot->dirty |= DIRTY_FRAME_ALL;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(cold->frame_pixmap == XCB_NONE);
+  assert(stub_free_pixmap_count == 2);
+  assert(stub_last_image_drawable == hot->frame);
+
+  teardown();
+  xcb_disconnect(s.conn);
+  printf("PASS: Frame backing pixmap\n");
+}
+
+static void test_frame_title_runs_shared(void) {
+  printf("Testing title runs are shared...\n");
+  setup();
+  s.in_commit_phase = true;
+
+  // A prompt-style title flip only shapes each string once
+  const char* titles[] = {"~/src", "make", "~/src", "make", "~/src"};
+  for (size_t i = 0; i < sizeof(titles) / sizeof(titles[0]); i++) {
+    cold->title = (char*)titles[i];
+    hot->dirty |= DIRTY_TITLE;
+    server_queue_client(&s, hot);
+    frame_flush(&s, h);
+  }
+  assert(s.title_cache.misses == 2);
+  assert(s.title_cache.hits == 3);
+  assert(title_cache_size(&s.title_cache) == 2);
+
+  // The render context holds its own reference on the run it shows
+  assert(cold->render_ctx.title_surface != NULL);
+  assert(cairo_surface_get_reference_count(cold->render_ctx.title_surface) == 2);
+
+  cold->title = NULL;
+  teardown();
+  printf("PASS: Title runs shared\n");
+}
+
+static void test_frame_title_font_from_config(void) {
+  printf("Testing title font follows the configured font...\n");
+  setup();
+  s.in_commit_phase = true;
+
+  render_text_configure("Monospace 9");
+  uint64_t configures = render_text_configures();
+  assert(strcmp(render_text_font(), "Monospace 9") == 0);
+  assert(render_text_height() > 0);
+  render_text_configure("Monospace 9");
+  assert(render_text_configures() == configures);
+
+  cold->title = (char*)"terminal";
+  hot->dirty |= DIRTY_TITLE;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(s.title_cache.misses == 1);
+
+  // The font is part of the run key, so a new font reshapes the same title
+  render_text_configure("Monospace 14");
+  assert(render_text_configures() == configures + 1);
+  assert(render_text_height() > 0);
+  hot->dirty |= DIRTY_TITLE;
+  server_queue_client(&s, hot);
+  frame_flush(&s, h);
+  assert(s.title_cache.misses == 2);
+  assert(title_cache_size(&s.title_cache) == 2);
+
+  // Frames shape through the shared layout and keep none of their own
+  assert(cold->render_ctx.layout == NULL);
+
+  render_text_configure(NULL);
+  assert(strcmp(render_text_font(), RENDER_TEXT_DEFAULT_FONT) == 0);
+  cold->title = NULL;
+  teardown();
+  printf("PASS: Title font follows the configured font\n");
+}
+
+static void test_render_image_create(void) {
+  printf("Testing upload image creation...\n");
+
+  // No reference surface: a plain image
+  render_upload_shutdown();
+  assert(!render_upload_shm());
+  cairo_surface_t* plain = render_image_create(CAIRO_FORMAT_ARGB32, 64, 20);
+  assert(cairo_surface_status(plain) == CAIRO_STATUS_SUCCESS);
+  assert(cairo_surface_get_type(plain) == CAIRO_SURFACE_TYPE_IMAGE);
+  assert(cairo_image_surface_get_width(plain) == 64);
+  assert(cairo_image_surface_get_height(plain) == 20);
+  cairo_surface_destroy(plain);
+
+  // A non-image reference still hands out image surfaces
+  render_upload_set_reference(cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL));
+  assert(render_upload_shm());
+  cairo_surface_t* similar = render_image_create(CAIRO_FORMAT_ARGB32, 64, 20);
+  assert(cairo_surface_status(similar) == CAIRO_STATUS_SUCCESS);
+  assert(cairo_surface_get_type(similar) == CAIRO_SURFACE_TYPE_IMAGE);
+  assert(cairo_image_surface_get_format(similar) == CAIRO_FORMAT_ARGB32);
+  assert(cairo_image_surface_get_width(similar) == 64);
+  assert(cairo_image_surface_get_height(similar) == 20);
+  cairo_surface_destroy(similar);
+
+  // A failed reference leaves the fallback in place
+  render_upload_set_reference(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, -1, -1));
+  assert(!render_upload_shm());
+  render_upload_shutdown();
+}
+
 int main(void) {
   test_frame_render_no_icon();
   test_frame_render_active_color();
   test_frame_controls_position();
   test_frame_title_background_color();
   test_frame_buttons_present();
+  test_frame_tiles_reused();
+  test_frame_backing_pixmap();
+  test_frame_title_runs_shared();
+  test_frame_title_font_from_config();
+  test_render_image_create();
   return 0;
 }
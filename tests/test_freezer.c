@@ -0,0 +1,140 @@
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "freezer.h"
+
+static char g_root[64];
+
+static void put(const char* rel, const char* text) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", g_root, rel);
+  for (char* p = path + strlen(g_root) + 1; (p = strchr(p, '/')); p++) {
+    *p = '\0';
+    mkdir(path, 0700);
+    *p = '/';
+  }
+  FILE* f = fopen(path, "w");
+  assert(f);
+  fputs(text, f);
+  fclose(f);
+}
+
+static char get_first(const char* rel) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", g_root, rel);
+  FILE* f = fopen(path, "r");
+  assert(f);
+  int c = fgetc(f);
+  fclose(f);
+  return (char)c;
+}
+
+/* Process state letter from /proc/<pid>/stat, after the ")" */
+static char proc_state(pid_t pid) {
+  char path[64];
+  char buf[512];
+  snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+  FILE* f = fopen(path, "r");
+  assert(f);
+  size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+  fclose(f);
+  buf[n] = '\0';
+  char* paren = strrchr(buf, ')');
+  assert(paren);
+  return paren[2];
+}
+
+static pid_t spawn_sleeper(void) {
+  pid_t pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    setpgid(0, 0);
+    for (;;)
+      pause();
+  }
+  setpgid(pid, pid);
+  return pid;
+}
+
+static void wait_state(pid_t pid, char want) {
+  for (int i = 0; i < 200 && proc_state(pid) != want; i++)
+    usleep(1000);
+  assert(proc_state(pid) == want);
+}
+
+static void test_freeze_by_signal(void) {
+  pid_t child = spawn_sleeper();
+  freezer_t f;
+  memset(&f, 0, sizeof(f));
+  // Real /proc: a test runner's cgroup is no app scope, so signals are used
+  assert(freezer_freeze(&f, child));
+  assert(freezer_is_frozen(&f, child));
+  assert(f.entries[0].method == FREEZE_SIGNAL);
+  wait_state(child, 'T');
+
+  // Freezing twice is one entry
+  assert(freezer_freeze(&f, child));
+  assert(f.count == 1 && f.frozen == 1);
+
+  assert(freezer_thaw(&f, child));
+  assert(!freezer_is_frozen(&f, child));
+  assert(!freezer_thaw(&f, child));
+  wait_state(child, 'S');
+
+  // Never ourselves
+  assert(!freezer_freeze(&f, getpid()));
+
+  // destroy thaws what is left
+  assert(freezer_freeze(&f, child));
+  wait_state(child, 'T');
+  freezer_destroy(&f);
+  wait_state(child, 'S');
+  assert(f.thawed == 2);
+
+  kill(child, SIGKILL);
+  waitpid(child, NULL, 0);
+  printf("test_freeze_by_signal passed\n");
+}
+
+static void test_freeze_by_cgroup(void) {
+  put("proc/self/cgroup", "0::/user.slice/session.scope\n");
+  put("proc/500/cgroup", "0::/user.slice/app.slice/app-player.scope\n");
+  put("cg/user.slice/app.slice/app-player.scope/cgroup.freeze", "0\n");
+
+  char proc[96], cg[96];
+  snprintf(proc, sizeof(proc), "%s/proc", g_root);
+  snprintf(cg, sizeof(cg), "%s/cg", g_root);
+  freezer_t f;
+  memset(&f, 0, sizeof(f));
+  f.proc_root = proc;
+  f.cgroup_root = cg;
+
+  assert(freezer_freeze(&f, 500));
+  assert(f.entries[0].method == FREEZE_CGROUP);
+  assert(get_first("cg/user.slice/app.slice/app-player.scope/cgroup.freeze") == '1');
+
+  assert(freezer_thaw(&f, 500));
+  assert(get_first("cg/user.slice/app.slice/app-player.scope/cgroup.freeze") == '0');
+  assert(f.failed == 0);
+  freezer_destroy(&f);
+  printf("test_freeze_by_cgroup passed\n");
+}
+
+int main(void) {
+  strcpy(g_root, "/tmp/hxm_freezer_XXXXXX");
+  assert(mkdtemp(g_root));
+
+  test_freeze_by_signal();
+  test_freeze_by_cgroup();
+
+  char cmd[128];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", g_root);
+  assert(system(cmd) == 0);
+  return 0;
+}
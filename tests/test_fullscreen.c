@@ -10,6 +10,7 @@
 #include "hxm.h"
 #include "slotmap.h"
 #include "wm.h"
+#include "wm_internal.h"
 #include "xcb_utils.h"
 
 extern int stub_map_window_count;
@@ -17,24 +18,23 @@ extern int stub_unmap_window_count;
 extern xcb_atom_t stub_last_prop_atom;
 extern uint32_t stub_last_prop_len;
 extern uint8_t stub_last_prop_data[1024];
+extern int stub_change_window_attributes_count;
 
 static void setup_server(server_t* s) {
   memset(s, 0, sizeof(*s));
   s->is_test = true;
-  s->root = 1;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(NULL, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s->conn = (xcb_connection_t*)malloc(1);
   config_init_defaults(&s->config);
   s->config.theme.border_width = 5;
   s->config.theme.title_height = 20;
   s->config.fullscreen_use_workarea = false;
-  s->workarea = (rect_t){0, 0, 800, 600};
-  list_init(&s->focus_history);
+  s->screens[0].workarea = (rect_t){0, 0, 800, 600};
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+    handle_vec_init(&s->screens[0].layers[i]);
+  hash_map_init(&s->xid_index);
   slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
 }
 
@@ -52,10 +52,9 @@ static void cleanup_server(server_t* s) {
     }
   }
   slotmap_destroy(&s->clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  hash_map_destroy(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
   config_destroy(&s->config);
   free(s->conn);
 }
@@ -78,11 +77,10 @@ static handle_t add_client(server_t* s) {
   hot->flags = CLIENT_FLAG_NONE;
   hot->server = (rect_t){100, 100, 400, 300};
   hot->desired = hot->server;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
-  hash_map_insert(&s->window_to_client, hot->xid, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, hot->frame, handle_to_ptr(h));
+  server_xid_bind(s, hot->xid, XID_CLIENT, h);
+  server_xid_bind(s, hot->frame, XID_FRAME, h);
   return h;
 }
 
@@ -213,10 +211,101 @@ void test_hidden_state_iconify_restore(void) {
   cleanup_server(&s);
 }
 
+void test_fullscreen_fast_mode(void) {
+  server_t s;
+  setup_server(&s);
+  s.config.fullscreen_fast = true;
+  handle_vec_init(&s.active_clients);
+  handle_vec_init(&s.dirty_clients);
+  handle_vec_init(&s.fs_fast_covered);
+  s.screens[0].monitors = calloc(1, sizeof(monitor_t));
+  s.screens[0].monitors[0].geom = (rect_t){0, 0, 800, 600};
+  s.screens[0].monitor_count = 1;
+
+  handle_t game = add_client(&s);
+  handle_t below = add_client(&s);
+  handle_t other_mon = add_client(&s);
+  handle_vec_push(&s.active_clients, game);
+  handle_vec_push(&s.active_clients, below);
+  handle_vec_push(&s.active_clients, other_mon);
+  client_hot_t* g = server_chot(&s, game);
+  client_hot_t* b = server_chot(&s, below);
+  client_hot_t* o = server_chot(&s, other_mon);
+  g->frame_vis = b->frame_vis = o->frame_vis = FRAME_VIS_MAPPED;
+  o->server = (rect_t){900, 0, 200, 200};
+
+  // Fullscreen but not yet covering the monitor: nothing changes
+  g->layer = LAYER_FULLSCREEN;
+  g->flags |= CLIENT_FLAG_UNDECORATED;
+  s.focused_client = game;
+  wm_fullscreen_fast_update(&s);
+  assert(s.fs_fast == HANDLE_INVALID);
+  assert(wm_fullscreen_fast_held_root(&s) == 0);
+
+  g->server = (rect_t){0, 0, 800, 600};
+  stub_change_window_attributes_count = 0;
+  wm_fullscreen_fast_update(&s);
+  assert(s.fs_fast == game);
+  assert(s.fs_fast_entered == 1);
+  // Its own frame and the one under it
+  assert(stub_change_window_attributes_count == 2);
+  assert(s.fs_fast_covered.length == 1 && s.fs_fast_covered.items[0] == below);
+  assert(wm_fullscreen_fast_covers(&s, below));
+  assert(!wm_fullscreen_fast_covers(&s, other_mon));
+  assert(wm_fullscreen_fast_held_root(&s) & ROOT_DIRTY_CLIENT_LIST_STACKING);
+  assert(wm_fullscreen_fast_held_root(&s) & ROOT_DIRTY_WORKAREA);
+
+  // A covered frame's repaint is held, not queued
+  b->dirty = DIRTY_FRAME_TITLE | DIRTY_GEOM;
+  wm_fullscreen_fast_hold_paint(&s, below);
+  assert(b->dirty == DIRTY_GEOM);
+  assert(s.fs_fast_covered.length == 1);
+
+  // Steady state costs no requests
+  stub_change_window_attributes_count = 0;
+  wm_fullscreen_fast_update(&s);
+  assert(s.fs_fast == game && stub_change_window_attributes_count == 0);
+
+  // Focus leaves: events come back and the held frame is painted in full
+  s.focused_client = below;
+  wm_fullscreen_fast_update(&s);
+  assert(s.fs_fast == HANDLE_INVALID);
+  assert(s.fs_fast_covered.length == 0);
+  assert(stub_change_window_attributes_count == 2);
+  assert(b->dirty & DIRTY_FRAME_ALL);
+  assert(wm_fullscreen_fast_held_root(&s) == 0);
+
+  // _NET_WM_BYPASS_COMPOSITOR=2 keeps it out, =1 brings it in with the option off
+  s.focused_client = game;
+  client_cold_t* gc = server_ccold(&s, game);
+  gc->bypass_compositor_valid = true;
+  gc->bypass_compositor = 2;
+  wm_fullscreen_fast_update(&s);
+  assert(s.fs_fast == HANDLE_INVALID);
+  s.config.fullscreen_fast = false;
+  gc->bypass_compositor = 1;
+  wm_fullscreen_fast_update(&s);
+  assert(s.fs_fast == game);
+
+  // Hidden by a desktop switch
+  g->frame_vis = FRAME_VIS_HIDDEN;
+  wm_fullscreen_fast_update(&s);
+  assert(s.fs_fast == HANDLE_INVALID);
+
+  printf("test_fullscreen_fast_mode passed\n");
+
+  handle_vec_destroy(&s.fs_fast_covered);
+  handle_vec_destroy(&s.dirty_clients);
+  handle_vec_destroy(&s.active_clients);
+  free(s.screens[0].monitors);
+  cleanup_server(&s);
+}
+
 int main(void) {
   test_fullscreen_decorations();
   test_fullscreen_restores_flags_and_layer();
   test_above_below_state_layers();
   test_hidden_state_iconify_restore();
+  test_fullscreen_fast_mode();
   return 0;
 }
@@ -24,7 +24,7 @@ static void cleanup_server(server_t* s) {
       continue;
     client_render_payload_destroy(cold);
   }
-  small_vec_destroy(&s->active_clients);
+  handle_vec_destroy(&s->active_clients);
   slotmap_destroy(&s->clients);
   config_destroy(&s->config);
   free(s->conn);
@@ -38,8 +38,8 @@ void test_gtk_extents_toggle_decorations(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
   config_init_defaults(&s.config);
@@ -51,11 +51,11 @@ void test_gtk_extents_toggle_decorations(void) {
     free(s.conn);
     return;
   }
-  small_vec_init(&s.active_clients);
+  handle_vec_init(&s.active_clients);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   client_cold_t* cold = (client_cold_t*)cold_ptr;
   hot->self = h;
@@ -63,7 +63,7 @@ void test_gtk_extents_toggle_decorations(void) {
   hot->frame = 456;
   hot->state = STATE_MAPPED;
   cold->manage_phase = MANAGE_DONE;
-  cold->depth = s.root_depth;
+  cold->depth = s.screens[0].root_depth;
   hot->desired.x = 50;
   hot->desired.y = 60;
   hot->desired.w = 400;
@@ -148,11 +148,11 @@ void test_gtk_configure_request_extents(void) {
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
-  small_vec_init(&s.active_clients);
+  handle_vec_init(&s.active_clients);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   client_cold_t* cold = (client_cold_t*)cold_ptr;
   hot->self = h;
@@ -191,7 +191,7 @@ void test_gtk_configure_request_extents(void) {
 
   printf("test_gtk_configure_request_extents passed\n");
 
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   slotmap_destroy(&s.clients);
 }
 
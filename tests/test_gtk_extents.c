@@ -55,7 +55,7 @@ static void test_server_init(test_server_t* ts) {
 
   config_init_defaults(&ts->s.config);
 
-  small_vec_init(&ts->s.active_clients);
+  handle_vec_init(&ts->s.active_clients);
   bool ok = slotmap_init(&ts->s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
   assert(ok);
 }
@@ -85,7 +85,7 @@ static client_hot_t* test_client_add(test_server_t* ts, xcb_window_t xid, xcb_wi
   hot->desired.w = 400;
   hot->desired.h = 300;
 
-  small_vec_push(&ts->s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&ts->s.active_clients, h);
 
   assert(ts->created_len < (sizeof(ts->created) / sizeof(ts->created[0])));
   ts->created[ts->created_len++] = hot;
@@ -106,7 +106,7 @@ static void test_server_destroy(test_server_t* ts) {
     client_render_payload_destroy(cold);
   }
 
-  small_vec_destroy(&ts->s.active_clients);
+  handle_vec_destroy(&ts->s.active_clients);
   slotmap_destroy(&ts->s.clients);
   config_destroy(&ts->s.config);
   free(ts->s.conn);
@@ -143,6 +143,7 @@ static void test_gtk_extents_inflation_order_and_state(void) {
   cold->gtk_extents.bottom = 20;
 
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&ts.s, hot);
 
   reset_config_captures();
   wm_flush_dirty(&ts.s, monotonic_time_ns());
@@ -201,6 +202,7 @@ static void test_no_gtk_extents_no_inflation(void) {
   memset(&cold->gtk_extents, 0, sizeof(cold->gtk_extents));
 
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&ts.s, hot);
 
   reset_config_captures();
   wm_flush_dirty(&ts.s, monotonic_time_ns());
@@ -248,6 +250,7 @@ static void test_theme_decoration_change_reconfigures_frame(void) {
   hot->desired.w = 320;
   hot->desired.h = 240;
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&ts.s, hot);
 
   reset_config_captures();
   wm_flush_dirty(&ts.s, monotonic_time_ns());
@@ -258,6 +261,7 @@ static void test_theme_decoration_change_reconfigures_frame(void) {
   ts.s.config.theme.border_width = 9;
   ts.s.config.theme.title_height = 26;
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&ts.s, hot);
 
   wm_flush_dirty(&ts.s, monotonic_time_ns());
 
@@ -321,6 +325,7 @@ static void test_idempotent_second_flush_does_nothing(void) {
   cold->gtk_extents.bottom = 4;
 
   hot->dirty = DIRTY_GEOM;
+  server_queue_client(&ts.s, hot);
 
   reset_config_captures();
   wm_flush_dirty(&ts.s, monotonic_time_ns());
@@ -363,6 +368,7 @@ static void test_two_clients_both_configured(void) {
   acold->gtk_extents.top = 7;
   acold->gtk_extents.bottom = 8;
   a->dirty = DIRTY_GEOM;
+  server_queue_client(&ts.s, a);
 
   b->desired.x = 30;
   b->desired.y = 40;
@@ -371,6 +377,7 @@ static void test_two_clients_both_configured(void) {
   bcold->gtk_frame_extents_set = false;
   memset(&bcold->gtk_extents, 0, sizeof(bcold->gtk_extents));
   b->dirty = DIRTY_GEOM;
+  server_queue_client(&ts.s, b);
 
   reset_config_captures();
   wm_flush_dirty(&ts.s, monotonic_time_ns());
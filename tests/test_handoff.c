@@ -0,0 +1,149 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event.h"
+#include "handoff.h"
+
+static void fill_clients(handoff_client_t* c) {
+  memset(c, 0, 3 * sizeof(*c));
+  c[0] = (handoff_client_t){.xid = 0x200001, .desktop = 1, .geom = {10, 20, 300, 200}, .base_layer = LAYER_NORMAL, .stack_rank = 2, .focus_rank = 0};
+  c[0].str[HANDOFF_STR_CLASS] = "XTerm";
+  c[0].str[HANDOFF_STR_INSTANCE] = "xterm";
+  c[0].str[HANDOFF_STR_TITLE] = "";
+  c[0].flags = HANDOFF_NET_WM_NAME;
+  c[1] = (handoff_client_t){.xid = 0x200002, .desktop = -1, .geom = {-5, 0, 640, 480}, .base_layer = LAYER_ABOVE, .stack_rank = 0, .focus_rank = 2};
+  c[1].flags = HANDOFF_STICKY | HANDOFF_ICONIC;
+  c[2] = (handoff_client_t){.xid = 0x200003, .desktop = 0, .geom = {0, 0, 1, 1}, .base_layer = LAYER_NORMAL, .stack_rank = 1, .focus_rank = 1};
+  c[2].str[HANDOFF_STR_COMMAND] = "firefox";
+}
+
+void test_handoff_roundtrip(void) {
+  handoff_client_t in[3];
+  fill_clients(in);
+
+  uint8_t* blob = NULL;
+  size_t len = 0;
+  assert(handoff_encode(0x1a5, in, 3, &blob, &len));
+
+  handoff_t h = {0};
+  assert(handoff_decode(&h, blob, len));
+  assert(h.active);
+  assert(h.root == 0x1a5);
+  assert(h.count == 3);
+
+  // Records come back in stacking order
+  assert(h.clients[0].xid == 0x200002);
+  assert(h.clients[1].xid == 0x200003);
+  assert(h.clients[2].xid == 0x200001);
+
+  const handoff_client_t* c = handoff_find(&h, 0x200001);
+  assert(c);
+  assert(c->desktop == 1);
+  assert(c->geom.x == 10 && c->geom.y == 20 && c->geom.w == 300 && c->geom.h == 200);
+  assert(c->flags == HANDOFF_NET_WM_NAME);
+  assert(strcmp(c->str[HANDOFF_STR_CLASS], "XTerm") == 0);
+  assert(strcmp(c->str[HANDOFF_STR_INSTANCE], "xterm") == 0);
+  assert(c->str[HANDOFF_STR_TITLE] && c->str[HANDOFF_STR_TITLE][0] == '\0');
+  assert(c->str[HANDOFF_STR_ICON_NAME] == NULL);
+
+  c = handoff_find(&h, 0x200002);
+  assert(c && c->desktop == -1 && c->geom.x == -5);
+  assert(c->base_layer == LAYER_ABOVE);
+  assert(c->flags == (HANDOFF_STICKY | HANDOFF_ICONIC));
+  assert(handoff_find(&h, 0x200004) == NULL);
+
+  // Consumed records are not found again; the last one releases the handoff
+  handoff_consume(&h, 0x200001);
+  assert(handoff_find(&h, 0x200001) == NULL);
+  assert(handoff_find(&h, 0x200003) != NULL);
+  handoff_consume(&h, 0x200002);
+  handoff_consume(&h, 0x200003);
+  assert(!h.active);
+  assert(h.clients == NULL);
+  assert(handoff_find(&h, 0x200003) == NULL);
+
+  free(blob);
+  handoff_destroy(&h);
+  printf("test_handoff_roundtrip passed\n");
+}
+
+void test_handoff_rejects_invalid(void) {
+  handoff_client_t in[3];
+  fill_clients(in);
+
+  uint8_t* blob = NULL;
+  size_t len = 0;
+  assert(handoff_encode(0x1a5, in, 3, &blob, &len));
+
+  handoff_t h = {0};
+
+  // Truncated anywhere
+  for (size_t n = 0; n < len; n++) {
+    assert(!handoff_decode(&h, blob, n));
+    assert(!h.active);
+  }
+
+  // Trailing garbage
+  uint8_t* longer = malloc(len + 1);
+  assert(longer);
+  memcpy(longer, blob, len);
+  longer[len] = 0;
+  assert(!handoff_decode(&h, longer, len + 1));
+  free(longer);
+
+  // Wrong magic
+  blob[0] ^= 0xff;
+  assert(!handoff_decode(&h, blob, len));
+  blob[0] ^= 0xff;
+  assert(handoff_decode(&h, blob, len));
+  handoff_destroy(&h);
+  free(blob);
+
+  // Duplicate focus ranks
+  in[1].focus_rank = 0;
+  assert(handoff_encode(0x1a5, in, 3, &blob, &len));
+  assert(!handoff_decode(&h, blob, len));
+  free(blob);
+
+  // Duplicate XIDs
+  fill_clients(in);
+  in[2].xid = in[0].xid;
+  assert(handoff_encode(0x1a5, in, 3, &blob, &len));
+  assert(!handoff_decode(&h, blob, len));
+  free(blob);
+
+  // Empty geometry
+  fill_clients(in);
+  in[0].geom.w = 0;
+  assert(handoff_encode(0x1a5, in, 3, &blob, &len));
+  assert(!handoff_decode(&h, blob, len));
+  free(blob);
+
+  assert(!h.active);
+  handoff_destroy(&h);
+  printf("test_handoff_rejects_invalid passed\n");
+}
+
+void test_handoff_load_env(void) {
+  handoff_t h = {0};
+
+  unsetenv(HANDOFF_ENV);
+  assert(!handoff_load(&h, 0x1a5));
+
+  // A bad descriptor is ignored and the variable is consumed
+  setenv(HANDOFF_ENV, "not-a-fd", 1);
+  assert(!handoff_load(&h, 0x1a5));
+  assert(getenv(HANDOFF_ENV) == NULL);
+  assert(!h.active);
+
+  printf("test_handoff_load_env passed\n");
+}
+
+int main(void) {
+  test_handoff_roundtrip();
+  test_handoff_rejects_invalid();
+  test_handoff_load_env();
+  return 0;
+}
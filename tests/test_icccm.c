@@ -46,8 +46,8 @@ void test_icccm_protocols(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
   atoms.WM_PROTOCOLS = 10;
@@ -103,6 +103,7 @@ void test_icccm_protocols(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
   free(s.conn);
 }
@@ -111,8 +112,8 @@ void test_client_close(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_PROTOCOLS = 10;
   atoms.WM_DELETE_WINDOW = 11;
@@ -165,6 +166,7 @@ void test_client_close(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
   free(s.conn);
 }
@@ -173,15 +175,14 @@ void test_wm_take_focus_on_focus(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root = 1;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root = 1;
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
   atoms.WM_PROTOCOLS = 20;
   atoms.WM_TAKE_FOCUS = 21;
 
-  list_init(&s.focus_history);
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
 
@@ -196,7 +197,6 @@ void test_wm_take_focus_on_focus(void) {
   hot->self = h;
   hot->xid = 123;
   hot->state = STATE_MAPPED;
-  list_init(&hot->focus_node);
   cold->protocols |= PROTOCOL_TAKE_FOCUS;
   cold->can_focus = true;
 
@@ -234,6 +234,7 @@ void test_wm_take_focus_on_focus(void) {
     }
   }
   arena_destroy(&s.tick_arena);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
   free(s.conn);
 }
@@ -242,17 +243,15 @@ void test_wm_state_manage_unmanage(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root = 1;
-  s.root_visual = 1;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root = 1;
+  s.screens[0].root_visual = 1;
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   config_init_defaults(&s.config);
-  list_init(&s.focus_history);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
+    handle_vec_init(&s.screens[0].layers[i]);
+  hash_map_init(&s.xid_index);
 
   atoms.WM_STATE = 30;
 
@@ -277,14 +276,13 @@ void test_wm_state_manage_unmanage(void) {
   hot->desktop = 0;
   hot->initial_state = XCB_ICCCM_WM_STATE_NORMAL;
   hot->desired = (rect_t){0, 0, 100, 80};
-  cold->visual_id = s.root_visual;
-  cold->depth = s.root_depth;
+  cold->visual_id = s.screens[0].root_visual;
+  cold->depth = s.screens[0].root_depth;
   hot->layer = LAYER_NORMAL;
   hot->base_layer = LAYER_NORMAL;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   client_finish_manage(&s, h);
 
@@ -301,9 +299,9 @@ void test_wm_state_manage_unmanage(void) {
   printf("test_wm_state_manage_unmanage passed\n");
   config_destroy(&s.config);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s.layers[i]);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+    handle_vec_destroy(&s.screens[0].layers[i]);
+  hash_map_destroy(&s.xid_index);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
   free(s.conn);
 }
@@ -312,8 +310,8 @@ void test_name_fallback(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_NAME = 1;
   atoms._NET_WM_NAME = 2;
@@ -380,6 +378,7 @@ void test_name_fallback(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
   free(s.conn);
 }
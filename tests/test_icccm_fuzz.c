@@ -31,19 +31,17 @@ static xcb_generic_event_t* make_reparent_event(xcb_window_t win, xcb_window_t p
 static void setup_server(server_t* s) {
   memset(s, 0, sizeof(*s));
   s->is_test = true;
-  s->root = 1;
-  s->root_depth = 24;
-  s->root_visual = 1;
-  s->root_visual_type = xcb_get_visualtype(NULL, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s->conn = (xcb_connection_t*)malloc(1);
   config_init_defaults(&s->config);
 
-  list_init(&s->focus_history);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
 
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+  hash_map_init(&s->xid_index);
   cookie_jar_init(&s->cookie_jar);
   slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
 
@@ -56,19 +54,13 @@ static void setup_server(server_t* s) {
   small_vec_init(&s->buckets.button_events);
   small_vec_init(&s->buckets.client_messages);
 
-  hash_map_init(&s->buckets.expose_regions);
-  small_vec_init(&s->buckets.expose_region_keys);
-  hash_map_init(&s->buckets.configure_requests);
-  small_vec_init(&s->buckets.configure_request_keys);
-  hash_map_init(&s->buckets.configure_notifies);
-  small_vec_init(&s->buckets.configure_notify_keys);
-  hash_map_init(&s->buckets.destroyed_windows);
-  hash_map_init(&s->buckets.property_notifies);
-  small_vec_init(&s->buckets.property_notify_keys);
-  hash_map_init(&s->buckets.motion_notifies);
-  small_vec_init(&s->buckets.motion_notify_keys);
-  hash_map_init(&s->buckets.damage_regions);
-  small_vec_init(&s->buckets.damage_region_keys);
+  epoch_map_init(&s->buckets.expose_regions);
+  epoch_map_init(&s->buckets.configure_requests);
+  epoch_map_init(&s->buckets.configure_notifies);
+  epoch_map_init(&s->buckets.destroyed_windows);
+  epoch_map_init(&s->buckets.property_notifies);
+  epoch_map_init(&s->buckets.motion_notifies);
+  epoch_map_init(&s->buckets.damage_regions);
 }
 
 static void cleanup_server(server_t* s) {
@@ -91,8 +83,8 @@ static void cleanup_server(server_t* s) {
 
   cookie_jar_destroy(&s->cookie_jar);
   slotmap_destroy(&s->clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  hash_map_destroy(&s->xid_index);
+  hash_map_destroy(&s->prop_fetches);
 
   small_vec_destroy(&s->buckets.map_requests);
   small_vec_destroy(&s->buckets.unmap_notifies);
@@ -102,19 +94,13 @@ static void cleanup_server(server_t* s) {
   small_vec_destroy(&s->buckets.button_events);
   small_vec_destroy(&s->buckets.client_messages);
 
-  hash_map_destroy(&s->buckets.expose_regions);
-  small_vec_destroy(&s->buckets.expose_region_keys);
-  hash_map_destroy(&s->buckets.configure_requests);
-  small_vec_destroy(&s->buckets.configure_request_keys);
-  hash_map_destroy(&s->buckets.configure_notifies);
-  small_vec_destroy(&s->buckets.configure_notify_keys);
-  hash_map_destroy(&s->buckets.destroyed_windows);
-  hash_map_destroy(&s->buckets.property_notifies);
-  small_vec_destroy(&s->buckets.property_notify_keys);
-  hash_map_destroy(&s->buckets.motion_notifies);
-  small_vec_destroy(&s->buckets.motion_notify_keys);
-  hash_map_destroy(&s->buckets.damage_regions);
-  small_vec_destroy(&s->buckets.damage_region_keys);
+  epoch_map_destroy(&s->buckets.expose_regions);
+  epoch_map_destroy(&s->buckets.configure_requests);
+  epoch_map_destroy(&s->buckets.configure_notifies);
+  epoch_map_destroy(&s->buckets.destroyed_windows);
+  epoch_map_destroy(&s->buckets.property_notifies);
+  epoch_map_destroy(&s->buckets.motion_notifies);
+  epoch_map_destroy(&s->buckets.damage_regions);
 
   arena_destroy(&s->tick_arena);
   config_destroy(&s->config);
@@ -274,7 +260,7 @@ static void test_override_redirect_midstream_aborts_manage(void) {
   xcb_get_window_attributes_reply_t r;
   memset(&r, 0, sizeof(r));
   r.override_redirect = 1;
-  r.visual = s.root_visual;
+  r.visual = s.screens[0].root_visual;
 
   cookie_slot_t slot = {0};
   slot.client = h;
@@ -311,17 +297,16 @@ static void test_map_unmap_property_race(void) {
   hot->server.y = 10;
   hot->server.w = 100;
   hot->server.h = 100;
-  list_init(&hot->focus_node);
   list_init(&hot->transient_sibling);
   list_init(&hot->transients_head);
   arena_init(&cold->string_arena, 128);
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   xcb_unmap_notify_event_t* unmap = arena_alloc(&s.tick_arena, sizeof(*unmap));
   memset(unmap, 0, sizeof(*unmap));
   unmap->response_type = XCB_UNMAP_NOTIFY;
-  unmap->event = s.root;
+  unmap->event = s.screens[0].root;
   unmap->window = hot->xid;
   small_vec_push(&s.buckets.unmap_notifies, unmap);
 
@@ -331,7 +316,7 @@ static void test_map_unmap_property_race(void) {
   prop->window = hot->xid;
   prop->atom = atoms.WM_NAME;
   uint64_t key = ((uint64_t)prop->window << 32) | prop->atom;
-  hash_map_insert(&s.buckets.property_notifies, key, prop);
+  epoch_map_insert(&s.buckets.property_notifies, key, prop);
 
   event_process(&s);
 
@@ -355,12 +340,11 @@ static void test_reparent_notify_self_ignored(void) {
   hot->self = h;
   hot->xid = 4006;
   hot->state = STATE_MAPPED;
-  list_init(&hot->focus_node);
   list_init(&hot->transient_sibling);
   list_init(&hot->transients_head);
   arena_init(&cold->string_arena, 128);
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   assert(xcb_stubs_enqueue_queued_event(make_reparent_event(hot->xid, hot->xid, 1)));
   event_ingest(&s, false);
@@ -63,6 +63,7 @@ static void cleanup_server(server_t* s) {
       }
     }
   }
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
   cookie_jar_destroy(&s->cookie_jar);
   free(s->conn);
@@ -73,8 +74,8 @@ static void test_wm_icon_name_fallback(void) {
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
   atoms._NET_WM_ICON_NAME = 10;
@@ -133,8 +134,8 @@ static void test_wm_class_invalid_no_nul(void) {
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_CLASS = 3;
 
@@ -178,8 +179,8 @@ static void test_wm_client_machine_large(void) {
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_CLIENT_MACHINE = 4;
 
@@ -223,8 +224,8 @@ static void test_wm_command_first_token(void) {
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_COMMAND = 5;
 
@@ -262,15 +263,14 @@ static void test_wm_hints_input_affects_focus(void) {
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_HINTS = 6;
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
   cookie_jar_init(&s.cookie_jar);
-  list_init(&s.focus_history);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
@@ -283,7 +283,6 @@ static void test_wm_hints_input_affects_focus(void) {
   hot->self = h;
   hot->xid = 654;
   hot->state = STATE_MAPPED;
-  list_init(&hot->focus_node);
 
   cookie_slot_t slot;
   slot.type = COOKIE_GET_PROPERTY;
@@ -336,8 +335,8 @@ static void test_wm_hints_icon_safe(void) {
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_HINTS = 7;
 
@@ -386,8 +385,8 @@ static void test_property_deletions_reset_defaults(void) {
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_HINTS = 8;
   atoms.WM_NORMAL_HINTS = 9;
@@ -400,7 +399,7 @@ static void test_property_deletions_reset_defaults(void) {
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
   cookie_jar_init(&s.cookie_jar);
-  hash_map_init(&s.window_to_client);
+  hash_map_init(&s.xid_index);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
@@ -415,7 +414,7 @@ static void test_property_deletions_reset_defaults(void) {
   hot->state = STATE_MAPPED;
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   cookie_slot_t slot = {0};
   slot.type = COOKIE_GET_PROPERTY;
@@ -500,7 +499,89 @@ static void test_property_deletions_reset_defaults(void) {
   assert(strcmp(cold->base_title, "") == 0);
 
   printf("test_property_deletions_reset_defaults passed\n");
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
+  cleanup_server(&s);
+}
+
+static void test_identical_property_reply_skips_handler(void) {
+  server_t s;
+  reset_atoms();
+  memset(&s, 0, sizeof(s));
+  s.is_test = true;
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.conn = (xcb_connection_t*)malloc(1);
+  atoms.WM_HINTS = 8;
+  atoms.WM_NORMAL_HINTS = 9;
+  atoms._NET_WM_STATE_DEMANDS_ATTENTION = 20;
+
+  if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
+    return;
+  cookie_jar_init(&s.cookie_jar);
+
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = (client_hot_t*)hot_ptr;
+  client_cold_t* cold = (client_cold_t*)cold_ptr;
+  client_render_payload_init(cold);
+  arena_init(&cold->string_arena, 512);
+  hot->xid = 910;
+  hot->self = h;
+  hot->state = STATE_MAPPED;
+  list_init(&hot->transients_head);
+  list_init(&hot->transient_sibling);
+
+  cookie_slot_t slot = {0};
+  slot.type = COOKIE_GET_PROPERTY;
+  slot.client = h;
+  slot.data = ((uint64_t)hot->xid << 32) | atoms.WM_NORMAL_HINTS;
+
+  struct {
+    xcb_get_property_reply_t r;
+    xcb_size_hints_t hints;
+  } normal;
+  memset(&normal, 0, sizeof(normal));
+  normal.r.format = 32;
+  normal.r.type = XCB_ATOM_WM_SIZE_HINTS;
+  normal.r.value_len = sizeof(xcb_size_hints_t) / 4;
+  normal.hints.flags = XCB_ICCCM_SIZE_HINT_P_MIN_SIZE;
+  normal.hints.min_width = 100;
+  normal.hints.min_height = 50;
+
+  wm_handle_reply(&s, &slot, &normal.r, NULL);
+  assert(cold->hints.min_w == 100);
+
+  // Same bytes again: not reparsed, so a local edit survives
+  cold->hints.min_w = 7;
+  wm_handle_reply(&s, &slot, &normal.r, NULL);
+  assert(cold->hints.min_w == 7);
+
+  normal.hints.min_width = 120;
+  wm_handle_reply(&s, &slot, &normal.r, NULL);
+  assert(cold->hints.min_w == 120);
+
+  // WM-side urgency changes force the next identical WM_HINTS through
+  struct {
+    xcb_get_property_reply_t r;
+    uint32_t data[9];
+  } wm_hints;
+  memset(&wm_hints, 0, sizeof(wm_hints));
+  wm_hints.r.format = 32;
+  wm_hints.r.type = XCB_ATOM_WM_HINTS;
+  wm_hints.r.value_len = 9;
+  wm_hints.data[0] = XCB_ICCCM_WM_HINT_X_URGENCY;
+  slot.data = ((uint64_t)hot->xid << 32) | atoms.WM_HINTS;
+
+  wm_handle_reply(&s, &slot, &wm_hints.r, NULL);
+  assert(hot->flags & CLIENT_FLAG_URGENT);
+  hot->flags &= ~CLIENT_FLAG_URGENT;
+  wm_handle_reply(&s, &slot, &wm_hints.r, NULL);
+  assert(!(hot->flags & CLIENT_FLAG_URGENT));
+  wm_client_update_state(&s, h, 0, atoms._NET_WM_STATE_DEMANDS_ATTENTION);
+  wm_handle_reply(&s, &slot, &wm_hints.r, NULL);
+  assert(hot->flags & CLIENT_FLAG_URGENT);
+
+  printf("test_identical_property_reply_skips_handler passed\n");
   cleanup_server(&s);
 }
 
@@ -509,9 +590,9 @@ static void test_focused_client_recommits_on_wm_protocols_take_focus_enable(void
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root = 1;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root = 1;
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_PROTOCOLS = 10;
   atoms.WM_TAKE_FOCUS = 11;
@@ -519,7 +600,6 @@ static void test_focused_client_recommits_on_wm_protocols_take_focus_enable(void
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
   cookie_jar_init(&s.cookie_jar);
-  list_init(&s.focus_history);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
@@ -533,7 +613,6 @@ static void test_focused_client_recommits_on_wm_protocols_take_focus_enable(void
   hot->xid = 901;
   hot->state = STATE_MAPPED;
   cold->user_time = 1234;
-  list_init(&hot->focus_node);
   cold->can_focus = false;
   cold->protocols = 0;
 
@@ -569,16 +648,15 @@ static void test_focused_client_recommits_on_wm_hints_input_enable(void) {
   reset_atoms();
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root = 1;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root = 1;
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_HINTS = 13;
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
   cookie_jar_init(&s.cookie_jar);
-  list_init(&s.focus_history);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
@@ -591,7 +669,6 @@ static void test_focused_client_recommits_on_wm_hints_input_enable(void) {
   hot->self = h;
   hot->xid = 902;
   hot->state = STATE_MAPPED;
-  list_init(&hot->focus_node);
   cold->can_focus = false;
   cold->protocols = 0;
 
@@ -634,6 +711,7 @@ int main(void) {
   test_wm_hints_input_affects_focus();
   test_wm_hints_icon_safe();
   test_property_deletions_reset_defaults();
+  test_identical_property_reply_skips_handler();
   test_focused_client_recommits_on_wm_protocols_take_focus_enable();
   test_focused_client_recommits_on_wm_hints_input_enable();
   return 0;
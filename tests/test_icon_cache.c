@@ -0,0 +1,193 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "icon_cache.h"
+
+static void fill(uint32_t* px, size_t n, uint32_t v) {
+  for (size_t i = 0; i < n; i++)
+    px[i] = v;
+}
+
+void test_icon_cache_dedup_and_release(void) {
+  icon_cache_t cache;
+  memset(&cache, 0, sizeof(cache));
+
+  uint32_t a[8 * 8];
+  uint32_t b[8 * 8];
+  fill(a, 64, 0xFF102030);
+  fill(b, 64, 0xFF102030);
+  b[63] = 0xFF000000;
+
+  cairo_surface_t* s1 = icon_cache_intern(&cache, a, 8, 8);
+  cairo_surface_t* s2 = icon_cache_intern(&cache, a, 8, 8);
+  cairo_surface_t* s3 = icon_cache_intern(&cache, b, 8, 8);
+  assert(s1 == s2);
+  assert(s1 != s3);
+  assert(cache.hits == 1);
+  assert(cache.misses == 2);
+  assert(icon_cache_size(&cache) == 2);
+
+  // Same pixels, different shape: never shared
+  cairo_surface_t* s4 = icon_cache_intern(&cache, a, 16, 4);
+  assert(s4 != s1);
+  assert(icon_cache_size(&cache) == 3);
+
+  // Entries live exactly as long as some client holds the surface
+  cairo_surface_destroy(s1);
+  assert(icon_cache_size(&cache) == 3);
+  cairo_surface_destroy(s2);
+  assert(icon_cache_size(&cache) == 2);
+  cairo_surface_destroy(s3);
+  cairo_surface_destroy(s4);
+  assert(icon_cache_size(&cache) == 0);
+
+  cairo_surface_t* s5 = icon_cache_intern(&cache, a, 8, 8);
+  assert(cache.misses == 4);
+  cairo_surface_destroy(s5);
+
+  icon_cache_destroy(&cache);
+  printf("test_icon_cache_dedup_and_release passed\n");
+}
+
+void test_icon_cache_premultiply(void) {
+  const uint32_t src[] = {0x00FFFFFF, 0xFFABCDEF, 0x80FF8000, 0x01FFFFFF};
+  uint32_t dst[4];
+  icon_premultiply(dst, src, 4);
+  assert(dst[0] == 0x00000000);
+  assert(dst[1] == 0xFFABCDEF);
+  assert(dst[2] == 0x80804000);
+  assert(dst[3] == 0x01010101);
+  printf("test_icon_cache_premultiply passed\n");
+}
+
+void test_icon_premultiply_kernel_matches_scalar(void) {
+  // Every (alpha, channel) pair, with distinct per-channel values
+  static uint32_t src[256 * 256];
+  static uint32_t want[256 * 256];
+  static uint32_t got[256 * 256];
+  for (uint32_t a = 0; a < 256; a++) {
+    for (uint32_t c = 0; c < 256; c++)
+      src[a * 256 + c] = (a << 24) | (c << 16) | ((255 - c) << 8) | ((c * 7) & 0xFF);
+  }
+
+  icon_premultiply_scalar(want, src, 256 * 256);
+  icon_premultiply(got, src, 256 * 256);
+  assert(memcmp(want, got, sizeof(want)) == 0);
+
+  // Odd lengths and misaligned starts exercise every tail path
+  for (size_t off = 0; off < 9; off++) {
+    for (size_t n = 0; n < 41; n++) {
+      memset(got, 0xAB, (n + 1) * sizeof(uint32_t));
+      icon_premultiply(got, src + 1000 + off, n);
+      assert(memcmp(got, want + 1000 + off, n * sizeof(uint32_t)) == 0);
+      assert(got[n] == 0xABABABAB);
+    }
+  }
+
+  printf("test_icon_premultiply_kernel_matches_scalar passed (%s)\n", icon_premultiply_kernel());
+}
+
+void test_icon_cache_scaled_variants(void) {
+  icon_cache_t cache;
+  memset(&cache, 0, sizeof(cache));
+
+  uint32_t px[32 * 16];
+  fill(px, 32 * 16, 0xFFFFFFFF);
+  cairo_surface_t* icon = icon_cache_intern(&cache, px, 32, 16);
+
+  // Exact fit is the icon itself
+  assert(icon_cache_scaled(icon, 32) == icon);
+
+  cairo_surface_t* v16 = icon_cache_scaled(icon, 16);
+  assert(v16 && v16 != icon);
+  assert(cairo_image_surface_get_width(v16) == 16);
+  assert(cairo_image_surface_get_height(v16) == 8);
+  assert(icon_cache_scaled(icon, 16) == v16);
+
+  // Every client sharing the icon shares its variants
+  cairo_surface_t* again = icon_cache_intern(&cache, px, 32, 16);
+  assert(again == icon);
+  assert(icon_cache_scaled(again, 16) == v16);
+  cairo_surface_destroy(again);
+
+  // More sizes than slots: older variants are recycled, lookups stay correct
+  for (int size = 8; size < 8 + 2 * ICON_CACHE_VARIANTS; size++) {
+    cairo_surface_t* v = icon_cache_scaled(icon, size);
+    assert(v);
+    assert(cairo_image_surface_get_width(v) == size);
+  }
+
+  assert(icon_cache_scaled(NULL, 16) == NULL);
+  assert(icon_cache_scaled(icon, 0) == NULL);
+
+  cairo_surface_destroy(icon);
+  assert(icon_cache_size(&cache) == 0);
+  icon_cache_destroy(&cache);
+  printf("test_icon_cache_scaled_variants passed\n");
+}
+
+void test_icon_cache_disk_roundtrip(void) {
+  char dir[] = "/tmp/hxm-icon-cache-XXXXXX";
+  assert(mkdtemp(dir));
+  setenv("XDG_CACHE_HOME", dir, 1);
+
+  char src[sizeof(dir) + 16];
+  snprintf(src, sizeof(src), "%s/icon.svg", dir);
+  FILE* f = fopen(src, "w");
+  assert(f);
+  fputs("<svg/>", f);
+  fclose(f);
+
+  // Nothing stored yet
+  assert(icon_cache_disk_load(src, 18) == NULL);
+
+  cairo_surface_t* icon = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 18, 12);
+  cairo_surface_flush(icon);
+  uint32_t* px = (uint32_t*)cairo_image_surface_get_data(icon);
+  int stride = cairo_image_surface_get_stride(icon) / 4;
+  for (int y = 0; y < 12; y++)
+    for (int x = 0; x < 18; x++)
+      px[y * stride + x] = 0xFF000000u | (uint32_t)(y << 8) | (uint32_t)x;
+  cairo_surface_mark_dirty(icon);
+  icon_cache_disk_store(src, 18, icon);
+
+  cairo_surface_t* loaded = icon_cache_disk_load(src, 18);
+  assert(loaded);
+  assert(cairo_image_surface_get_width(loaded) == 18);
+  assert(cairo_image_surface_get_height(loaded) == 12);
+  uint32_t* lpx = (uint32_t*)cairo_image_surface_get_data(loaded);
+  int lstride = cairo_image_surface_get_stride(loaded) / 4;
+  for (int y = 0; y < 12; y++)
+    for (int x = 0; x < 18; x++)
+      assert(lpx[y * lstride + x] == px[y * stride + x]);
+  cairo_surface_destroy(loaded);
+
+  // Other sizes are separate entries
+  assert(icon_cache_disk_load(src, 24) == NULL);
+
+  // A changed source invalidates the entry
+  f = fopen(src, "a");
+  assert(f);
+  fputs("<!-- edited -->", f);
+  fclose(f);
+  assert(icon_cache_disk_load(src, 18) == NULL);
+
+  cairo_surface_destroy(icon);
+  unsetenv("XDG_CACHE_HOME");
+  char cmd[sizeof(dir) + 16];
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+  assert(system(cmd) == 0);
+  printf("test_icon_cache_disk_roundtrip passed\n");
+}
+
+int main(void) {
+  test_icon_cache_dedup_and_release();
+  test_icon_cache_premultiply();
+  test_icon_premultiply_kernel_matches_scalar();
+  test_icon_cache_scaled_variants();
+  test_icon_cache_disk_roundtrip();
+  return 0;
+}
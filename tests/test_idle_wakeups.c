@@ -0,0 +1,161 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "event.h"
+
+extern void xcb_stubs_reset(void);
+
+#define IDLE_WINDOW_MS 300
+
+static int g_pipe[2];
+
+static void epoll_add(int epfd, int fd) {
+  struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+  assert(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0);
+}
+
+/* Just what server_wait_for_events touches: epoll, timer_fd and a pipe as the X fd */
+static void setup_server(server_t* s) {
+  memset(s, 0, sizeof(*s));
+  xcb_stubs_reset();
+  s->conn = xcb_connect(NULL, NULL);
+  control_init(&s->control);
+  s->signal_fd = -1;
+  s->config_watch.inotify_fd = s->config_watch.timer_fd = -1;
+
+  s->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  assert(s->epoll_fd > 0);
+  s->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  assert(s->timer_fd > 0);
+  assert(pipe(g_pipe) == 0);
+  s->xcb_fd = g_pipe[0];
+  epoll_add(s->epoll_fd, s->timer_fd);
+  epoll_add(s->epoll_fd, s->xcb_fd);
+}
+
+static void cleanup_server(server_t* s) {
+  close(s->epoll_fd);
+  close(s->timer_fd);
+  close(g_pipe[0]);
+  close(g_pipe[1]);
+  xcb_disconnect(s->conn);
+}
+
+static uint64_t total_wakeups(const server_t* s) {
+  uint64_t n = 0;
+  for (int i = 0; i < WAKE_CAUSE_COUNT; i++)
+    n += s->wakeups[i];
+  return n;
+}
+
+static void test_flush_wait_is_infinite_when_nothing_is_held(void) {
+  server_t s;
+  memset(&s, 0, sizeof(s));
+
+  // However long ago the last flush was, an idle loop sets no timeout
+  assert(server_flush_wait_ms(&s, 0) == -1);
+  assert(server_flush_wait_ms(&s, 3000000ull) == -1);
+  assert(server_flush_wait_ms(&s, 50000000ull) == -1);
+
+  // A flush held back while ingest is busy is paced
+  s.pending_flush = true;
+  assert(server_flush_wait_ms(&s, 3000000ull) == 6);
+  assert(server_flush_wait_ms(&s, EVENT_BUSY_FLUSH_NS) == 0);
+  printf("test_flush_wait_is_infinite_when_nothing_is_held passed\n");
+}
+
+static void test_idle_server_does_not_wake(void) {
+  server_t s;
+  setup_server(&s);
+
+  // The window's own timeout is the only way out of an idle wait
+  assert(!server_wait_for_events(&s, IDLE_WINDOW_MS));
+  assert(s.wakeups[WAKE_TIMEOUT] == 1);
+  assert(total_wakeups(&s) == 1);
+
+  // And timer_fd was never armed
+  assert(s.timer_armed_ns == 0);
+  assert(s.timer_rearms == 0);
+  struct itimerspec its;
+  assert(timerfd_gettime(s.timer_fd, &its) == 0);
+  assert(its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0);
+
+  cleanup_server(&s);
+  printf("test_idle_server_does_not_wake passed\n");
+}
+
+static void test_wakeups_are_counted_by_cause(void) {
+  server_t s;
+  setup_server(&s);
+
+  // A pending wheel timer wakes through timer_fd, once
+  server_schedule_timer_ns(&s, 5000000ull);
+  assert(!server_wait_for_events(&s, 5000));
+  assert(s.wakeups[WAKE_TIMER] == 1);
+  assert(s.timer_rearms == 1);
+  assert(timer_wheel_run(&s.timers, monotonic_time_ns(), &s) == 1);
+
+  // With the wheel empty again the loop goes back to sleep
+  assert(!server_wait_for_events(&s, IDLE_WINDOW_MS));
+  assert(s.wakeups[WAKE_TIMEOUT] == 1);
+  assert(s.timer_rearms == 1);
+
+  // X input
+  assert(write(g_pipe[1], "x", 1) == 1);
+  assert(server_wait_for_events(&s, 5000));
+  assert(s.wakeups[WAKE_X] == 1);
+  char c;
+  assert(read(g_pipe[0], &c, 1) == 1);
+
+  // timer_fd firing with nothing due on the wheel was wasted
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_nsec = 1000000;
+  assert(timerfd_settime(s.timer_fd, 0, &its, NULL) == 0);
+  assert(!server_wait_for_events(&s, 5000));
+  assert(s.wakeups[WAKE_SPURIOUS] == 1);
+
+  assert(total_wakeups(&s) == 4);
+  cleanup_server(&s);
+  printf("test_wakeups_are_counted_by_cause passed\n");
+}
+
+static void test_busy_poll_only_during_grabs(void) {
+  server_t s;
+  setup_server(&s);
+  s.config.interactive_busy_poll_us = 1000;
+
+  // No grab: a plain sleep
+  assert(!server_wait_for_events(&s, 20));
+  assert(s.busy_poll_hits + s.busy_poll_misses == 0);
+
+  // During a drag, input already there is found by the spin
+  s.interaction_mode = INTERACTION_MOVE;
+  assert(write(g_pipe[1], "x", 1) == 1);
+  assert(server_wait_for_events(&s, 5000));
+  assert(s.busy_poll_hits == 1);
+  assert(s.wakeups[WAKE_X] == 1);
+  char c;
+  assert(read(g_pipe[0], &c, 1) == 1);
+
+  // Nothing arrives: spin out, then sleep the rest of the timeout
+  assert(!server_wait_for_events(&s, 20));
+  assert(s.busy_poll_misses == 1);
+  assert(s.wakeups[WAKE_TIMEOUT] == 2);
+
+  cleanup_server(&s);
+  printf("test_busy_poll_only_during_grabs passed\n");
+}
+
+int main(void) {
+  test_flush_wait_is_infinite_when_nothing_is_held();
+  test_idle_server_does_not_wake();
+  test_wakeups_are_counted_by_cause();
+  test_busy_poll_only_during_grabs();
+  return 0;
+}
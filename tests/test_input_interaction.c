@@ -3,12 +3,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <xcb/xcb_icccm.h>
 #include <xcb/xproto.h>
 
 #include "client.h"
 #include "config.h"
 #include "cookie_jar.h"
 #include "event.h"
+#include "frame.h"
 #include "hxm.h"
 #include "src/wm_internal.h"
 #include "wm.h"
@@ -17,26 +19,52 @@
 extern void xcb_stubs_reset(void);
 extern int stub_grab_pointer_count;
 extern int stub_ungrab_pointer_count;
+extern int stub_xi_grab_device_count;
 extern int stub_grab_key_count;
 extern int stub_ungrab_key_count;
+extern int stub_grab_keyboard_count;
+extern int stub_ungrab_keyboard_count;
 extern uint16_t stub_last_grab_key_mods;
 extern xcb_keycode_t stub_last_grab_keycode;
 extern int stub_sync_await_count;
+extern int stub_sync_create_alarm_count;
+extern int stub_sync_change_alarm_count;
 extern int stub_config_calls_len;
+extern int stub_change_window_attributes_count;
+typedef struct stub_config_call {
+  xcb_window_t win;
+  uint16_t mask;
+
+  int32_t x;
+  int32_t y;
+  uint32_t w;
+  uint32_t h;
+
+  uint32_t border_width;
+  xcb_window_t sibling;
+  uint32_t stack_mode;
+} stub_config_call_t;
+
+extern const stub_config_call_t* stub_config_call_at(int idx);
+extern int (*stub_poll_for_reply_hook)(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error);
 extern void xcb_stubs_set_query_pointer_sequence(uint32_t sequence);
 
 void __real_cookie_jar_push(cookie_jar_t* cj, uint32_t sequence, cookie_type_t type, handle_t client, uintptr_t data, uint64_t txn_id, cookie_handler_fn handler);
 
 static int g_cookie_push_query_pointer_calls = 0;
+static uint32_t g_grab_keyboard_seq = 0;
 
 void __wrap_cookie_jar_push(cookie_jar_t* cj, uint32_t sequence, cookie_type_t type, handle_t client, uintptr_t data, uint64_t txn_id, cookie_handler_fn handler) {
   if (type == COOKIE_QUERY_POINTER)
     g_cookie_push_query_pointer_calls++;
+  if (type == COOKIE_GRAB_KEYBOARD)
+    g_grab_keyboard_seq = sequence;
   __real_cookie_jar_push(cj, sequence, type, client, data, txn_id, handler);
 }
 
 static void reset_cookie_push_spy(void) {
   g_cookie_push_query_pointer_calls = 0;
+  g_grab_keyboard_seq = 0;
 }
 
 static void setup_server(server_t* s) {
@@ -44,23 +72,21 @@ static void setup_server(server_t* s) {
   s->is_test = true;
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
-  s->root = 1;
-  s->root_visual = 1;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
 
   config_init_defaults(&s->config);
 
   slotmap_init(&s->clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
   cookie_jar_init(&s->cookie_jar);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
-  list_init(&s->focus_history);
+  hash_map_init(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
 
-  s->desktop_count = 2;
-  s->current_desktop = 0;
+  s->screens[0].desktop_count = 2;
+  s->screens[0].current_desktop = 0;
 }
 
 static void cleanup_server(server_t* s) {
@@ -79,11 +105,12 @@ static void cleanup_server(server_t* s) {
   }
   config_destroy(&s->config);
   cookie_jar_destroy(&s->cookie_jar);
+  free(s->key_grabs);
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  hash_map_destroy(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
   xcb_disconnect(s->conn);
 }
 
@@ -120,12 +147,11 @@ static handle_t add_mapped_client(server_t* s, xcb_window_t win, xcb_window_t fr
   hot->server = (rect_t){10, 10, 200, 150};
   hot->desired = hot->server;
 
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s->window_to_client, win, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, frame, handle_to_ptr(h));
+  server_xid_bind(s, win, XID_CLIENT, h);
+  server_xid_bind(s, frame, XID_FRAME, h);
 
   return h;
 }
@@ -232,6 +258,148 @@ static void test_move_interaction(void) {
   cleanup_server(&s);
 }
 
+static void test_move_interaction_xi2_predicts_and_settles(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_cookie_push_spy();
+
+  s.xi2_supported = true;
+  s.config.xinput2_motion = true;
+  s.config.interactive_predict = true;
+
+  handle_t h = add_mapped_client(&s, 2201, 2301);
+  client_hot_t* hot = server_chot(&s, h);
+
+  xcb_button_press_event_t press = {0};
+  press.event = hot->xid;
+  press.detail = 1;
+  press.state = XCB_MOD_MASK_1;
+  press.root_x = 50;
+  press.root_y = 60;
+
+  wm_handle_button_press(&s, &press);
+  assert(s.interaction_mode == INTERACTION_MOVE);
+  assert(s.interaction_xi2);
+  assert(stub_xi_grab_device_count == 1);
+  assert(stub_grab_pointer_count == 0);
+
+  xcb_motion_notify_event_t motion = {0};
+  motion.event = s.screens[0].root;
+  motion.state = XCB_KEY_BUT_MASK_BUTTON_1;
+  motion.root_x = 60;
+  motion.root_y = 60;
+  motion.time = 1000;
+  wm_handle_motion_notify(&s, &motion);
+  assert(hot->desired.x == hot->server.x + 10);
+
+  // 1 px/ms while a paced commit is pending: the window leads by the time left
+  s.last_interaction_flush = monotonic_time_ns();
+  motion.root_x = 70;
+  motion.time = 1010;
+  wm_handle_motion_notify(&s, &motion);
+  assert(hot->desired.x > hot->server.x + 20);
+  assert(hot->desired.x <= hot->server.x + 37);
+  assert(hot->desired.y == hot->server.y);
+
+  // Release lands exactly under the pointer
+  xcb_button_release_event_t release = {0};
+  release.detail = 1;
+  release.state = XCB_KEY_BUT_MASK_BUTTON_1;
+  release.root_x = 70;
+  release.root_y = 60;
+  release.time = 1012;
+  wm_handle_button_release(&s, &release);
+  assert(s.interaction_mode == INTERACTION_NONE);
+  assert(hot->desired.x == hot->server.x + 20);
+
+  printf("test_move_interaction_xi2_predicts_and_settles passed\n");
+  cleanup_server(&s);
+}
+
+#define DRAG_QUERY_SEQ 4242u
+
+static int poll_drag_query_pointer(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) {
+  (void)c;
+  *error = NULL;
+  if (request != DRAG_QUERY_SEQ) {
+    // The grab: status zero is GrabSuccess
+    *reply = calloc(1, sizeof(xcb_grab_pointer_reply_t));
+    return 1;
+  }
+  xcb_query_pointer_reply_t* r = calloc(1, sizeof(*r));
+  r->same_screen = 1;
+  r->root = 1;
+  r->root_x = 110;
+  r->root_y = 75;
+  r->mask = XCB_KEY_BUT_MASK_BUTTON_1;
+  *reply = r;
+  return 1;
+}
+
+static void test_move_interaction_motion_hint_polls_once(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_cookie_push_spy();
+
+  s.config.interactive_motion_hint = true;
+
+  handle_t h = add_mapped_client(&s, 2401, 2501);
+  client_hot_t* hot = server_chot(&s, h);
+
+  xcb_button_press_event_t press = {0};
+  press.event = hot->xid;
+  press.detail = 1;
+  press.state = XCB_MOD_MASK_1;
+  press.root_x = 50;
+  press.root_y = 60;
+
+  wm_handle_button_press(&s, &press);
+  assert(s.interaction_mode == INTERACTION_MOVE);
+  assert(s.interaction_motion_hint);
+
+  // Nothing to read until the server hints
+  uint64_t now = monotonic_time_ns();
+  assert(!wm_interaction_poll_pointer(&s, now));
+
+  xcb_motion_notify_event_t motion = {0};
+  motion.detail = XCB_MOTION_HINT;
+  motion.event = s.screens[0].root;
+  motion.state = XCB_KEY_BUT_MASK_BUTTON_1;
+  motion.root_x = 60;
+  motion.root_y = 60;
+  wm_handle_motion_notify(&s, &motion);
+  assert(hot->desired.x == hot->server.x + 10);
+  assert(s.interaction_hint_pending);
+
+  xcb_stubs_set_query_pointer_sequence(DRAG_QUERY_SEQ);
+  assert(wm_interaction_poll_pointer(&s, now));
+  assert(g_cookie_push_query_pointer_calls == 1);
+
+  // A second hint while the query is out does not send another
+  motion.root_x = 65;
+  wm_handle_motion_notify(&s, &motion);
+  assert(!wm_interaction_poll_pointer(&s, now + 1000000000ull));
+  assert(g_cookie_push_query_pointer_calls == 1);
+
+  // The reply moves the window to where the pointer is now
+  stub_poll_for_reply_hook = poll_drag_query_pointer;
+  cookie_jar_mark_replies_may_exist(&s.cookie_jar);
+  cookie_jar_drain(&s.cookie_jar, s.conn, &s, 0);
+  stub_poll_for_reply_hook = NULL;
+  assert(!s.interaction_query_inflight);
+  assert(hot->desired.x == hot->server.x + 60);
+  assert(hot->desired.y == hot->server.y + 15);
+
+  xcb_button_release_event_t release = {0};
+  wm_handle_button_release(&s, &release);
+  assert(s.interaction_mode == INTERACTION_NONE);
+
+  printf("test_move_interaction_motion_hint_polls_once passed\n");
+  cleanup_server(&s);
+}
+
 static void test_resize_interaction(void) {
   server_t s;
   setup_server(&s);
@@ -371,6 +539,67 @@ static void test_cancel_interaction_resets_cursor(void) {
   cleanup_server(&s);
 }
 
+static void test_frame_hover_cursor_and_buttons(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  s.config.theme.border_width = 4;
+  s.config.theme.title_height = 20;
+
+  handle_t h = add_mapped_client(&s, 5201, 5301);
+  client_hot_t* hot = server_chot(&s, h);
+  hot->last_cursor_dir = -1;
+
+  xcb_motion_notify_event_t motion = {0};
+  motion.event = hot->frame;
+  motion.event_x = 100;
+  motion.event_y = 100;
+
+  // First hover sets the cursor; staying in the same region does not resend it
+  wm_handle_motion_notify(&s, &motion);
+  assert(hot->last_cursor_dir == RESIZE_NONE);
+  assert(stub_change_window_attributes_count == 1);
+  motion.event_x = 101;
+  wm_handle_motion_notify(&s, &motion);
+  assert(stub_change_window_attributes_count == 1);
+
+  // Frame is 208 wide: x >= 204 is the right border
+  motion.event_x = 205;
+  wm_handle_motion_notify(&s, &motion);
+  assert(hot->last_cursor_dir == RESIZE_RIGHT);
+  assert(stub_change_window_attributes_count == 2);
+  motion.event_y = 173;
+  wm_handle_motion_notify(&s, &motion);
+  assert(hot->last_cursor_dir == (RESIZE_RIGHT | RESIZE_BOTTOM));
+  assert(stub_change_window_attributes_count == 3);
+
+  // Close sits inside the right border, maximize and minimize step left
+  assert(frame_get_button_at(&s, h, 190, 5) == FRAME_BUTTON_CLOSE);
+  assert(frame_get_button_at(&s, h, 170, 5) == FRAME_BUTTON_MAXIMIZE);
+  assert(frame_get_button_at(&s, h, 150, 5) == FRAME_BUTTON_MINIMIZE);
+  assert(frame_get_button_at(&s, h, 162, 5) == FRAME_BUTTON_NONE);
+  assert(frame_get_button_at(&s, h, 190, 19) == FRAME_BUTTON_NONE);
+
+  // A resize moves every region with it
+  hot->server.w = 300;
+  assert(frame_get_button_at(&s, h, 190, 5) == FRAME_BUTTON_NONE);
+  assert(frame_get_button_at(&s, h, 290, 5) == FRAME_BUTTON_CLOSE);
+  motion.event_y = 100;
+  wm_handle_motion_notify(&s, &motion);
+  assert(hot->last_cursor_dir == RESIZE_NONE);
+  assert(hot->frame_hit.right_edge == 304);
+
+  // Undecorated frames have no buttons and no border to grab
+  hot->flags |= CLIENT_FLAG_UNDECORATED;
+  assert(frame_get_button_at(&s, h, 290, 5) == FRAME_BUTTON_NONE);
+  motion.event_x = 2;
+  wm_handle_motion_notify(&s, &motion);
+  assert(hot->last_cursor_dir == RESIZE_NONE);
+
+  printf("test_frame_hover_cursor_and_buttons passed\n");
+  cleanup_server(&s);
+}
+
 static void test_resize_no_sync_await(void) {
   server_t s;
   setup_server(&s);
@@ -383,7 +612,7 @@ static void test_resize_no_sync_await(void) {
 
   cold->sync_enabled = true;
   cold->sync_counter = 1;
-  hot->dirty |= DIRTY_GEOM;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
 
   s.interaction_mode = INTERACTION_RESIZE;
   s.interaction_window = hot->frame;
@@ -397,6 +626,80 @@ static void test_resize_no_sync_await(void) {
   cleanup_server(&s);
 }
 
+static void test_resize_waits_for_sync_alarm(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_cookie_push_spy();
+
+  s.sync_supported = true;
+
+  handle_t h = add_mapped_client(&s, 6051, 6151);
+  client_hot_t* hot = server_chot(&s, h);
+  client_cold_t* cold = server_ccold(&s, h);
+  handle_vec_init(&s.active_clients);
+  handle_vec_push(&s.active_clients, h);
+
+  cold->sync_enabled = true;
+  cold->sync_counter = 1;
+
+  s.interaction_mode = INTERACTION_RESIZE;
+  s.interaction_window = hot->frame;
+  s.interaction_handle = h;
+  s.interaction_resize_dir = RESIZE_BOTTOM | RESIZE_RIGHT;
+
+  hot->desired.w = (uint16_t)(hot->server.w + 32);
+  hot->desired.h = (uint16_t)(hot->server.h + 24);
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
+
+  uint64_t now = monotonic_time_ns();
+  wm_flush_dirty(&s, now);
+  assert(stub_sync_create_alarm_count == 1);
+  assert(cold->sync_alarm != XCB_NONE);
+  assert(cold->sync_wait_value == cold->sync_value);
+  assert(hot->server.w == hot->desired.w);
+
+  // The client has not redrawn yet, so the next size is held back
+  now += 50000000ull;
+  hot->desired.w = (uint16_t)(hot->desired.w + 16);
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
+  stub_config_calls_len = 0;
+  wm_flush_dirty(&s, now);
+  assert(stub_config_calls_len == 0);
+  assert(hot->server.w != hot->desired.w);
+  assert((hot->dirty & DIRTY_GEOM) != 0);
+
+  // An alarm for an older value does not release it
+  xcb_sync_alarm_notify_event_t ev = {0};
+  ev.alarm = cold->sync_alarm;
+  ev.counter_value.lo = (uint32_t)(cold->sync_wait_value - 1);
+  wm_handle_sync_alarm(&s, &ev);
+  assert(cold->sync_wait_value != 0);
+
+  ev.counter_value.lo = (uint32_t)cold->sync_wait_value;
+  wm_handle_sync_alarm(&s, &ev);
+  assert(cold->sync_wait_value == 0);
+
+  // The latest desired size goes out and re-arms the existing alarm
+  wm_flush_dirty(&s, now);
+  assert(stub_config_calls_len > 0);
+  assert(hot->server.w == hot->desired.w);
+  assert(stub_sync_create_alarm_count == 1);
+  assert(stub_sync_change_alarm_count == 1);
+  assert(cold->sync_wait_value == cold->sync_value);
+
+  // A client that never answers only stalls the resize until the timeout
+  now += 200000000ull;
+  hot->desired.h = (uint16_t)(hot->desired.h + 16);
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
+  wm_flush_dirty(&s, now);
+  assert(hot->server.h == hot->desired.h);
+
+  printf("test_resize_waits_for_sync_alarm passed\n");
+  handle_vec_destroy(&s.active_clients);
+  cleanup_server(&s);
+}
+
 static void test_button_release_flushes_pending_resize(void) {
   server_t s;
   setup_server(&s);
@@ -407,8 +710,8 @@ static void test_button_release_flushes_pending_resize(void) {
 
   handle_t h = add_mapped_client(&s, 6101, 6201);
   client_hot_t* hot = server_chot(&s, h);
-  small_vec_init(&s.active_clients);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_init(&s.active_clients);
+  handle_vec_push(&s.active_clients, h);
 
   s.interaction_mode = INTERACTION_RESIZE;
   s.interaction_window = hot->frame;
@@ -417,7 +720,7 @@ static void test_button_release_flushes_pending_resize(void) {
 
   hot->desired.w = (uint16_t)(hot->server.w + 32);
   hot->desired.h = (uint16_t)(hot->server.h + 24);
-  hot->dirty |= DIRTY_GEOM;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
 
   stub_config_calls_len = 0;
 
@@ -439,7 +742,221 @@ static void test_button_release_flushes_pending_resize(void) {
   assert(stub_config_calls_len >= 2);
 
   printf("test_button_release_flushes_pending_resize passed\n");
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
+  cleanup_server(&s);
+}
+
+/* ConfigureWindow calls that moved or resized the client or its frame */
+static int count_geometry_configures(const client_hot_t* hot) {
+  int n = 0;
+  for (int i = 0; i < stub_config_calls_len; i++) {
+    const stub_config_call_t* call = stub_config_call_at(i);
+    if ((call->win == hot->xid || call->win == hot->frame) && (call->mask & (XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_WIDTH)))
+      n++;
+  }
+  return n;
+}
+
+static void test_outline_move_configures_once_on_release(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_cookie_push_spy();
+
+  s.is_test = false;
+  s.config.interactive_outline = OUTLINE_ALWAYS;
+
+  handle_t h = add_mapped_client(&s, 6301, 6401);
+  client_hot_t* hot = server_chot(&s, h);
+  handle_vec_init(&s.active_clients);
+  handle_vec_push(&s.active_clients, h);
+
+  xcb_button_press_event_t press = {0};
+  press.event = hot->xid;
+  press.detail = 1;
+  press.state = XCB_MOD_MASK_1;
+  press.root_x = 50;
+  press.root_y = 60;
+  wm_handle_button_press(&s, &press);
+  assert(s.interaction_mode == INTERACTION_MOVE);
+  assert(s.interaction_outline);
+  stub_config_calls_len = 0;
+
+  xcb_motion_notify_event_t motion = {0};
+  motion.event = s.screens[0].root;
+  motion.state = XCB_KEY_BUT_MASK_BUTTON_1;
+  for (int i = 1; i <= 3; i++) {
+    motion.root_x = (int16_t)(50 + 10 * i);
+    motion.root_y = (int16_t)(60 + 5 * i);
+    wm_handle_motion_notify(&s, &motion);
+    wm_flush_dirty(&s, monotonic_time_ns());
+  }
+
+  // Only the outline moved
+  assert(count_geometry_configures(hot) == 0);
+  assert(hot->server.x == 10 && hot->server.y == 10);
+  assert(hot->dirty & DIRTY_GEOM);
+
+  xcb_button_release_event_t release = {0};
+  release.root_x = 80;
+  release.root_y = 75;
+  wm_handle_button_release(&s, &release);
+  assert(!s.interaction_outline);
+
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(hot->server.x == 40 && hot->server.y == 25);
+  assert((hot->dirty & DIRTY_GEOM) == 0);
+  assert(count_geometry_configures(hot) == 2);
+
+  printf("test_outline_move_configures_once_on_release passed\n");
+  handle_vec_destroy(&s.active_clients);
+  cleanup_server(&s);
+}
+
+static xcb_key_press_event_t arrow_key(xcb_keycode_t keycode, uint32_t time) {
+  xcb_key_press_event_t ev = {0};
+  ev.response_type = XCB_KEY_PRESS;
+  ev.detail = keycode;
+  ev.time = time;
+  ev.root = 1;
+  return ev;
+}
+
+static uint8_t g_grab_keyboard_status = XCB_GRAB_STATUS_SUCCESS;
+
+// Every grab succeeds except the keyboard one, which gets g_grab_keyboard_status
+static int poll_grab_keyboard(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) {
+  (void)c;
+  *error = NULL;
+  xcb_grab_keyboard_reply_t* r = calloc(1, sizeof(*r));
+  r->status = request == g_grab_keyboard_seq ? g_grab_keyboard_status : XCB_GRAB_STATUS_SUCCESS;
+  *reply = r;
+  return 1;
+}
+
+static void answer_grabs(server_t* s, uint8_t keyboard_status) {
+  g_grab_keyboard_status = keyboard_status;
+  stub_poll_for_reply_hook = poll_grab_keyboard;
+  cookie_jar_mark_replies_may_exist(&s->cookie_jar);
+  cookie_jar_drain(&s->cookie_jar, s->conn, s, 0);
+  stub_poll_for_reply_hook = NULL;
+}
+
+static void test_keyboard_move_accelerates_and_coalesces(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_cookie_push_spy();
+
+  s.is_test = false;
+
+  handle_t h = add_mapped_client(&s, 6501, 6601);
+  client_hot_t* hot = server_chot(&s, h);
+  handle_vec_init(&s.active_clients);
+  handle_vec_push(&s.active_clients, h);
+
+  wm_start_interaction(&s, h, hot, true, RESIZE_NONE, 100, 100, 0, true);
+  assert(stub_grab_keyboard_count == 1);
+  assert(!s.interaction_keyboard_grabbed);
+  answer_grabs(&s, XCB_GRAB_STATUS_SUCCESS);
+  assert(s.interaction_keyboard_grabbed);
+  stub_config_calls_len = 0;
+
+  // Held Right: 4 repeats at the base step, then doubled
+  for (uint32_t i = 0; i < 6; i++) {
+    xcb_key_press_event_t ev = arrow_key(114, 1000 + 30 * i);
+    assert(wm_interaction_handle_key(&s, &ev));
+  }
+  xcb_key_press_event_t down = arrow_key(116, 1200);
+  assert(wm_interaction_handle_key(&s, &down));
+
+  // Seven presses, one configure
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(hot->server.x == 10 + 80);
+  assert(hot->server.y == 10 + 10);
+  assert(count_geometry_configures(hot) == 2);
+
+  // Escape puts the window back and ends the interaction
+  xcb_key_press_event_t esc = arrow_key(9, 1300);
+  assert(wm_interaction_handle_key(&s, &esc));
+  assert(s.interaction_mode == INTERACTION_NONE);
+  assert(!s.interaction_keyboard_grabbed);
+  assert(stub_ungrab_keyboard_count == 1);
+  assert(hot->desired.x == 10 && hot->desired.y == 10);
+
+  printf("test_keyboard_move_accelerates_and_coalesces passed\n");
+  handle_vec_destroy(&s.active_clients);
+  cleanup_server(&s);
+}
+
+static void test_keyboard_grab_checked_through_cookie(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_cookie_push_spy();
+
+  handle_t h = add_mapped_client(&s, 6511, 6611);
+  client_hot_t* hot = server_chot(&s, h);
+  handle_vec_init(&s.active_clients);
+  handle_vec_push(&s.active_clients, h);
+
+  // Someone else holds the keyboard: arrows stay theirs, the pointer goes on
+  wm_start_interaction(&s, h, hot, true, RESIZE_NONE, 100, 100, 0, true);
+  assert(g_grab_keyboard_seq != 0);
+  answer_grabs(&s, XCB_GRAB_STATUS_ALREADY_GRABBED);
+  assert(!s.interaction_keyboard_grabbed);
+  assert(s.interaction_mode == INTERACTION_MOVE);
+  xcb_key_press_event_t right = arrow_key(114, 1000);
+  assert(!wm_interaction_handle_key(&s, &right));
+  wm_cancel_interaction(&s);
+  assert(stub_ungrab_keyboard_count == 0);
+
+  // Ended before the reply: the keyboard is released all the same, and the
+  // late success does not mark a grab nobody holds
+  wm_start_interaction(&s, h, hot, true, RESIZE_NONE, 100, 100, 0, true);
+  wm_cancel_interaction(&s);
+  assert(stub_ungrab_keyboard_count == 1);
+  answer_grabs(&s, XCB_GRAB_STATUS_SUCCESS);
+  assert(!s.interaction_keyboard_grabbed);
+
+  printf("test_keyboard_grab_checked_through_cookie passed\n");
+  handle_vec_destroy(&s.active_clients);
+  cleanup_server(&s);
+}
+
+static void test_keyboard_resize_steps_by_increments(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  reset_cookie_push_spy();
+
+  handle_t h = add_mapped_client(&s, 6701, 6801);
+  client_hot_t* hot = server_chot(&s, h);
+  client_cold_t* cold = server_ccold(&s, h);
+  hot->server.h = 160;
+  hot->desired = hot->server;
+  cold->hints_flags = XCB_ICCCM_SIZE_HINT_P_RESIZE_INC | XCB_ICCCM_SIZE_HINT_BASE_SIZE;
+  cold->hints.inc_w = 8;
+  cold->hints.inc_h = 16;
+
+  wm_start_interaction(&s, h, hot, false, RESIZE_BOTTOM | RESIZE_RIGHT, 210, 170, 0, true);
+  answer_grabs(&s, XCB_GRAB_STATUS_SUCCESS);
+
+  xcb_key_press_event_t right = arrow_key(114, 1000);
+  xcb_key_press_event_t down = arrow_key(116, 2000);
+  wm_interaction_handle_key(&s, &right);
+  wm_interaction_handle_key(&s, &down);
+  wm_interaction_apply_keys(&s);
+  assert(hot->desired.w == 208);
+  assert(hot->desired.h == 176);
+
+  // Return keeps the result
+  xcb_key_press_event_t enter = arrow_key(36, 3000);
+  assert(wm_interaction_handle_key(&s, &enter));
+  assert(s.interaction_mode == INTERACTION_NONE);
+  assert(hot->desired.w == 208);
+
+  printf("test_keyboard_resize_steps_by_increments passed\n");
   cleanup_server(&s);
 }
 
@@ -493,7 +1010,7 @@ static void test_keybinding_conflict_deterministic(void) {
   small_vec_push(&s.config.key_bindings, second);
 
   g_restart_pending = 0;
-  s.current_desktop = 0;
+  s.screens[0].current_desktop = 0;
 
   xcb_key_press_event_t ev = {0};
   ev.detail = 9;
@@ -503,13 +1020,50 @@ static void test_keybinding_conflict_deterministic(void) {
   wm_handle_key_press(&s, &ev);
 
   assert(g_restart_pending == 1);
-  assert(s.current_desktop == 0);
+  assert(s.screens[0].current_desktop == 0);
 
   printf("test_keybinding_conflict_deterministic passed\n");
   xcb_key_symbols_free(s.keysyms);
   cleanup_server(&s);
 }
 
+static void test_setup_keys_resets_dispatch(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  key_binding_t* b = calloc(1, sizeof(*b));
+  b->keysym = XK_Escape;
+  b->modifiers = XCB_MOD_MASK_1;
+  b->action = ACTION_RESTART;
+  reset_keybindings(&s.config);
+  small_vec_push(&s.config.key_bindings, b);
+
+  s.keysyms = xcb_key_symbols_alloc(s.conn);
+  g_restart_pending = 0;
+
+  xcb_key_press_event_t ev = {0};
+  ev.detail = 9;
+  ev.state = XCB_MOD_MASK_1;
+  wm_handle_key_press(&s, &ev);
+  assert(g_restart_pending == 1);
+  assert(s.key_dispatch[9][1 << 2] == 1);
+
+  // A keymap change drops resolved chords so they are looked up again
+  s.key_dispatch[9][0] = KEY_DISPATCH_NONE;
+  wm_setup_keys(&s);
+  assert(s.key_dispatch[9][1 << 2] == 0);
+  assert(s.key_dispatch[9][0] == 0);
+
+  g_restart_pending = 0;
+  wm_handle_key_press(&s, &ev);
+  assert(g_restart_pending == 1);
+
+  printf("test_setup_keys_resets_dispatch passed\n");
+  xcb_key_symbols_free(s.keysyms);
+  cleanup_server(&s);
+}
+
 static void test_key_grabs_from_config(void) {
   server_t s;
   setup_server(&s);
@@ -538,6 +1092,79 @@ static void test_key_grabs_from_config(void) {
   cleanup_server(&s);
 }
 
+static key_binding_t* push_binding(server_t* s, xcb_keysym_t sym, uint16_t mods) {
+  key_binding_t* b = calloc(1, sizeof(*b));
+  b->keysym = sym;
+  b->modifiers = mods;
+  b->action = ACTION_RESTART;
+  small_vec_push(&s->config.key_bindings, b);
+  return b;
+}
+
+static int poll_grab_access_error(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) {
+  (void)c;
+  (void)request;
+  *reply = NULL;
+  *error = calloc(1, sizeof(**error));
+  (*error)->error_code = XCB_ACCESS;
+  return 1;
+}
+
+static void test_key_grabs_diffed_on_reload(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  reset_keybindings(&s.config);
+  key_binding_t* esc = push_binding(&s, XK_Escape, XCB_MOD_MASK_1);
+
+  // First setup clears whatever was there, then grabs each lock combination
+  wm_setup_keys(&s);
+  assert(stub_ungrab_key_count == 1);
+  assert(stub_grab_key_count == 8);
+  assert(s.key_grab_count == 8);
+
+  // Unchanged bindings: nothing is sent
+  stub_grab_key_count = 0;
+  stub_ungrab_key_count = 0;
+  wm_setup_keys(&s);
+  assert(stub_grab_key_count == 0);
+  assert(stub_ungrab_key_count == 0);
+
+  // An added binding only grabs its own chords
+  push_binding(&s, XK_Return, XCB_MOD_MASK_4);
+  wm_setup_keys(&s);
+  assert(stub_grab_key_count == 8);
+  assert(stub_ungrab_key_count == 0);
+  assert(s.key_grab_count == 16);
+
+  // A changed modifier swaps just that binding's chords
+  stub_grab_key_count = 0;
+  esc->modifiers = XCB_MOD_MASK_CONTROL;
+  wm_setup_keys(&s);
+  assert(stub_grab_key_count == 8);
+  assert(stub_ungrab_key_count == 8);
+  assert(wm_clean_mods(stub_last_grab_key_mods) == XCB_MOD_MASK_CONTROL);
+  assert(s.key_grab_count == 16);
+
+  // Refused grabs are forgotten and retried on the next setup
+  stub_poll_for_reply_hook = poll_grab_access_error;
+  cookie_jar_mark_replies_may_exist(&s.cookie_jar);
+  cookie_jar_drain(&s.cookie_jar, s.conn, &s, 0);
+  stub_poll_for_reply_hook = NULL;
+  assert(s.key_grab_count == 0);
+  stub_grab_key_count = 0;
+  stub_ungrab_key_count = 0;
+  wm_setup_keys(&s);
+  assert(stub_grab_key_count == 16);
+  assert(stub_ungrab_key_count == 0);
+  assert(s.key_grab_count == 16);
+
+  printf("test_key_grabs_diffed_on_reload passed\n");
+  xcb_key_symbols_free(s.keysyms);
+  cleanup_server(&s);
+}
+
 static void test_moveresize_keyboard_zero_query_sequence_skips_enqueue(void) {
   server_t s;
   setup_server(&s);
@@ -573,15 +1200,25 @@ int main(void) {
   test_click_to_focus();
   test_click_ignores_dock_and_desktop();
   test_move_interaction();
+  test_move_interaction_xi2_predicts_and_settles();
+  test_move_interaction_motion_hint_polls_once();
   test_resize_interaction();
   test_resize_interaction_clamps_frame_overflow();
   test_resize_corner_top_left();
   test_cancel_interaction_resets_cursor();
+  test_frame_hover_cursor_and_buttons();
   test_resize_no_sync_await();
+  test_resize_waits_for_sync_alarm();
   test_button_release_flushes_pending_resize();
+  test_outline_move_configures_once_on_release();
+  test_keyboard_move_accelerates_and_coalesces();
+  test_keyboard_grab_checked_through_cookie();
+  test_keyboard_resize_steps_by_increments();
   test_keybinding_clean_mods();
   test_keybinding_conflict_deterministic();
+  test_setup_keys_resets_dispatch();
   test_key_grabs_from_config();
+  test_key_grabs_diffed_on_reload();
   test_moveresize_keyboard_zero_query_sequence_skips_enqueue();
   return 0;
 }
@@ -0,0 +1,160 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "handoff.h"
+#include "launcher.h"
+
+void test_launcher_split_command(void) {
+  char* argv[LAUNCHER_ARGV_MAX];
+
+  char plain[] = "  alacritty\t--working-directory=/tmp  -e htop ";
+  assert(launcher_split_command(plain, argv, LAUNCHER_ARGV_MAX) == 4);
+  assert(strcmp(argv[0], "alacritty") == 0);
+  assert(strcmp(argv[1], "--working-directory=/tmp") == 0);
+  assert(strcmp(argv[3], "htop") == 0);
+  assert(argv[4] == NULL);
+
+  const char* shell[] = {
+      "rofi -show run | tee log", "st -e 'vim x'", "echo $HOME", "a && b", "ls *.c", "x > y",
+      "FOO=1 xterm",              "~/bin/tool",    "cmd # note", "(sub)",  "a\nb",   "",
+  };
+  for (size_t i = 0; i < sizeof(shell) / sizeof(shell[0]); i++) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s", shell[i]);
+    assert(launcher_split_command(buf, argv, LAUNCHER_ARGV_MAX) == 0);
+  }
+
+  // Too many words for argv
+  char many[] = "a b c d";
+  assert(launcher_split_command(many, argv, 4) == 0);
+  char fits[] = "a b c";
+  assert(launcher_split_command(fits, argv, 4) == 3);
+
+  printf("test_launcher_split_command passed\n");
+}
+
+static bool wait_for_file(const char* path) {
+  struct timespec step = {0, 10 * 1000 * 1000};
+  for (int i = 0; i < 300; i++) {
+    struct stat st;
+    if (stat(path, &st) == 0)
+      return true;
+    nanosleep(&step, NULL);
+  }
+  return false;
+}
+
+static void collect_until(launcher_t* l, uint32_t pending) {
+  struct timespec step = {0, 10 * 1000 * 1000};
+  for (int i = 0; i < 300 && l->helper_pending > pending; i++) {
+    launcher_helper_collect(l);
+    nanosleep(&step, NULL);
+  }
+}
+
+void test_launcher_helper_runs_commands(void) {
+  char dir[] = "/tmp/hxm_launcher_XXXXXX";
+  assert(mkdtemp(dir));
+  char direct[128], shell[128], cmd[320];
+  snprintf(direct, sizeof(direct), "%s/direct", dir);
+  snprintf(shell, sizeof(shell), "%s/shell", dir);
+
+  // The helper snapshots PATH; put dir first so a program can appear in it
+  const char* env_path = getenv("PATH");
+  char old_path[4096], path[4096 + 128];
+  snprintf(old_path, sizeof(old_path), "%s", env_path ? env_path : "/usr/bin:/bin");
+  snprintf(path, sizeof(path), "%s:%s", dir, old_path);
+  setenv("PATH", path, 1);
+  unsetenv(LAUNCHER_HELPER_ENV);
+
+  // A restart handoff is still pending when main forks the helper
+  int handoff_fd = open("/dev/null", O_RDONLY);
+  assert(handoff_fd > 2);
+  char fd_str[16];
+  snprintf(fd_str, sizeof(fd_str), "%d", handoff_fd);
+  setenv(HANDOFF_ENV, fd_str, 1);
+
+  launcher_t l = {0};
+  assert(launcher_helper_start(&l));
+  assert(l.helper_pid > 0);
+
+  // No shell syntax: exec'd straight from the PATH cache
+  snprintf(cmd, sizeof(cmd), "touch %s", direct);
+  assert(launcher_shell(&l, cmd, 0) == 0);
+  assert(wait_for_file(direct));
+  collect_until(&l, 0);
+  assert(l.spawned == 1 && l.helper_direct == 1);
+
+  // ...and does not keep the handoff descriptor open (the number itself may
+  // have been reused since)
+  char fd_link[64], fd_target[64] = {0};
+  snprintf(fd_link, sizeof(fd_link), "/proc/%d/fd/%d", (int)l.helper_pid, handoff_fd);
+  ssize_t n = readlink(fd_link, fd_target, sizeof(fd_target) - 1u);
+  assert(n < 0 || strcmp(fd_target, "/dev/null") != 0);
+  unsetenv(HANDOFF_ENV);
+  close(handoff_fd);
+
+  snprintf(cmd, sizeof(cmd), "echo hi > '%s'", shell);
+  assert(launcher_shell(&l, cmd, 0) == 0);
+  assert(wait_for_file(shell));
+  collect_until(&l, 0);
+  assert(l.spawned == 2 && l.helper_direct == 1);
+  assert(l.helper_sent == 2 && l.failed == 0);
+  assert(l.latency.count == 2);
+
+  // Not on PATH yet: sh gets it (and fails); once created, inotify drops
+  // the cached miss and the next launch execs it directly
+  char tool[128], made[128];
+  snprintf(tool, sizeof(tool), "%s/hxm-test-tool", dir);
+  snprintf(made, sizeof(made), "%s/made", dir);
+  assert(launcher_shell(&l, "hxm-test-tool", 0) == 0);
+  collect_until(&l, 0);
+  assert(l.helper_direct == 1);
+
+  FILE* f = fopen(tool, "w");
+  assert(f);
+  fprintf(f, "#!/bin/sh\ntouch %s\n", made);
+  fclose(f);
+  assert(chmod(tool, 0755) == 0);
+
+  assert(launcher_shell(&l, "hxm-test-tool", 0) == 0);
+  assert(wait_for_file(made));
+  collect_until(&l, 0);
+  assert(l.helper_direct == 2);
+
+  // The first program found among alternatives is exec'd without sh
+  unlink(made);
+  assert(launcher_first(&l, "hxm-no-such-tool hxm-test-tool", 0) == 0);
+  assert(wait_for_file(made));
+  collect_until(&l, 0);
+  assert(l.helper_direct == 3 && l.failed == 0);
+  assert(launcher_first(&l, "hxm-no-such-tool", 0) == 0);
+  collect_until(&l, 0);
+  assert(l.failed == 1 && l.spawned == 5);
+
+  char report[512];
+  assert(launcher_format(&l, report, sizeof(report)) > 0);
+  assert(strstr(report, "helper=up sent=6 direct=3"));
+
+  launcher_destroy(&l);
+  assert(l.helper_pid == 0);
+  setenv("PATH", old_path, 1);
+  unlink(direct);
+  unlink(shell);
+  unlink(tool);
+  unlink(made);
+  rmdir(dir);
+  printf("test_launcher_helper_runs_commands passed\n");
+}
+
+int main(void) {
+  test_launcher_split_command();
+  test_launcher_helper_runs_commands();
+  return 0;
+}
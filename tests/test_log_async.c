@@ -0,0 +1,72 @@
+/*
+ * Async log ring: ordering, drop accounting, non-producer threads
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hxm.h"
+
+static void* log_from_other_thread(void* arg) {
+  (void)arg;
+  hxm_log(LOG_INFO, "from other thread");
+  return NULL;
+}
+
+static int count_lines(const char* path, const char* needle, int* last_seq) {
+  FILE* f = fopen(path, "r");
+  assert(f);
+  char line[256];
+  int count = 0;
+  while (fgets(line, sizeof(line), f)) {
+    const char* hit = strstr(line, needle);
+    if (!hit)
+      continue;
+    int seq = atoi(hit + strlen(needle));
+    if (last_seq) {
+      // Queued lines come out in the order they were logged
+      assert(seq > *last_seq);
+      *last_seq = seq;
+    }
+    count++;
+  }
+  fclose(f);
+  return count;
+}
+
+int main(void) {
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/hxm-test-log-async-%d", (int)getpid());
+  assert(freopen(path, "w", stdout));
+
+  setenv("HXM_LOG_ASYNC", "1", 1);
+  hxm_log_async_start();
+
+  // Far more than the ring holds: everything is either written or counted
+  enum { TOTAL = 20000 };
+  for (int i = 0; i < TOTAL; i++)
+    hxm_log(LOG_INFO, "async line %d padding padding padding padding padding padding", i);
+
+  pthread_t t;
+  assert(pthread_create(&t, NULL, log_from_other_thread, NULL) == 0);
+  pthread_join(t, NULL);
+
+  hxm_log_async_stop();
+  hxm_log(LOG_INFO, "after stop");
+  fflush(stdout);
+
+  int last = -1;
+  int written = count_lines(path, "async line ", &last);
+  assert((uint64_t)written + hxm_log_dropped() == TOTAL);
+  assert(written > 0);
+  assert(count_lines(path, "from other thread", NULL) == 1);
+  assert(count_lines(path, "after stop", NULL) == 1);
+
+  unlink(path);
+  fprintf(stderr, "test_log_async passed (%d written, %llu dropped)\n", written, (unsigned long long)hxm_log_dropped());
+  return 0;
+}
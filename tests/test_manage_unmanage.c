@@ -10,6 +10,8 @@
 #include "cookie_jar.h"
 #include "event.h"
 #include "hxm.h"
+#include "manage_stats.h"
+#include "str_intern.h"
 #include "wm.h"
 #include "xcb_utils.h"
 
@@ -25,6 +27,8 @@ extern xcb_window_t stub_mapped_windows[256];
 extern bool xcb_stubs_enqueue_event(xcb_generic_event_t* ev);
 extern int stub_destroy_window_count;
 extern xcb_window_t stub_last_destroyed_window;
+extern int stub_reparent_window_count;
+extern int stub_save_set_delete_count;
 
 void __real_cookie_jar_push(cookie_jar_t* cj, uint32_t sequence, cookie_type_t type, handle_t client, uintptr_t data, uint64_t txn_id, cookie_handler_fn handler);
 xcb_get_window_attributes_cookie_t __real_xcb_get_window_attributes(xcb_connection_t* c, xcb_window_t window);
@@ -34,8 +38,30 @@ static bool g_force_attr_query_zero_sequence = false;
 static bool g_force_geometry_query_zero_sequence = false;
 static int g_cookie_push_calls = 0;
 
+/* _NET_WM_DESKTOP requests of the adoption scan: sequence -> window */
+static struct {
+  uint32_t seq;
+  xcb_window_t window;
+} g_adopt_desktop_reqs[16];
+static int g_adopt_desktop_reqs_len = 0;
+
+/* Property probes of managed clients: sequence -> atom */
+static struct {
+  uint32_t seq;
+  xcb_atom_t atom;
+} g_probe_reqs[64];
+static int g_probe_reqs_len = 0;
+
 void __wrap_cookie_jar_push(cookie_jar_t* cj, uint32_t sequence, cookie_type_t type, handle_t client, uintptr_t data, uint64_t txn_id, cookie_handler_fn handler) {
   g_cookie_push_calls++;
+  if (type == COOKIE_GET_PROPERTY && client == HANDLE_INVALID && g_adopt_desktop_reqs_len < 16) {
+    g_adopt_desktop_reqs[g_adopt_desktop_reqs_len].seq = sequence;
+    g_adopt_desktop_reqs[g_adopt_desktop_reqs_len++].window = (xcb_window_t)(data >> 32);
+  }
+  if (type == COOKIE_GET_PROPERTY && client != HANDLE_INVALID && g_probe_reqs_len < 64) {
+    g_probe_reqs[g_probe_reqs_len].seq = sequence;
+    g_probe_reqs[g_probe_reqs_len++].atom = (xcb_atom_t)(data & 0xFFFFFFFFu);
+  }
   __real_cookie_jar_push(cj, sequence, type, client, data, txn_id, handler);
 }
 
@@ -48,13 +74,17 @@ xcb_get_window_attributes_cookie_t __wrap_xcb_get_window_attributes(xcb_connecti
   return __real_xcb_get_window_attributes(c, window);
 }
 
+static uint32_t g_geometry_seq = 0;
+
 xcb_get_geometry_cookie_t __wrap_xcb_get_geometry(xcb_connection_t* c, xcb_drawable_t drawable) {
   if (g_force_geometry_query_zero_sequence) {
     (void)c;
     (void)drawable;
     return (xcb_get_geometry_cookie_t){0};
   }
-  return __real_xcb_get_geometry(c, drawable);
+  xcb_get_geometry_cookie_t cookie = __real_xcb_get_geometry(c, drawable);
+  g_geometry_seq = cookie.sequence;
+  return cookie;
 }
 
 static void setup_server(server_t* s) {
@@ -63,28 +93,31 @@ static void setup_server(server_t* s) {
   g_force_attr_query_zero_sequence = false;
   g_force_geometry_query_zero_sequence = false;
   g_cookie_push_calls = 0;
+  g_adopt_desktop_reqs_len = 0;
+  g_probe_reqs_len = 0;
 
   xcb_stubs_reset();
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
 
-  s->root = 1;
-  s->root_visual = 1;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
 
   s->config.theme.border_width = 1;
   s->config.theme.title_height = 10;
 
   cookie_jar_init(&s->cookie_jar);
   slotmap_init(&s->clients, 64, sizeof(client_hot_t), sizeof(client_cold_t));
-  small_vec_init(&s->active_clients);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
-  list_init(&s->focus_history);
+  handle_vec_init(&s->active_clients);
+  hash_map_init(&s->xid_index);
+  hash_map_init(&s->adopt_desktops);
+  u32_vec_init(&s->adopt_later);
+  handle_vec_init(&s->adopt_deferred);
 
   for (int i = 0; i < LAYER_COUNT; i++) {
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
   }
 }
 
@@ -103,10 +136,13 @@ static void cleanup_server(server_t* s) {
     }
   }
   cookie_jar_destroy(&s->cookie_jar);
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  small_vec_destroy(&s->active_clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  handle_vec_destroy(&s->active_clients);
+  hash_map_destroy(&s->xid_index);
+  hash_map_destroy(&s->adopt_desktops);
+  u32_vec_destroy(&s->adopt_later);
+  handle_vec_destroy(&s->adopt_deferred);
   xcb_disconnect(s->conn);
 }
 
@@ -114,6 +150,8 @@ typedef struct adopt_attr {
   xcb_window_t window;
   bool override_redirect;
   uint8_t map_state;
+  bool has_desktop;
+  uint32_t desktop;
 } adopt_attr_t;
 
 static adopt_attr_t g_adopt_attrs[8];
@@ -125,6 +163,26 @@ static int adopt_poll_for_reply(xcb_connection_t* c, unsigned int request, void*
   if (error)
     *error = NULL;
 
+  for (int i = 0; i < g_adopt_desktop_reqs_len; i++) {
+    if (g_adopt_desktop_reqs[i].seq != request)
+      continue;
+    for (int j = 0; j < g_adopt_attrs_len; j++) {
+      if (g_adopt_attrs[j].window == g_adopt_desktop_reqs[i].window && g_adopt_attrs[j].has_desktop) {
+        xcb_get_property_reply_t* r = calloc(1, sizeof(*r) + sizeof(uint32_t));
+        r->format = 32;
+        r->type = XCB_ATOM_CARDINAL;
+        r->value_len = 1;
+        r->length = 1;
+        memcpy(r + 1, &g_adopt_attrs[j].desktop, sizeof(uint32_t));
+        if (reply)
+          *reply = r;
+        return 1;
+      }
+    }
+    // No property: answered, without a reply
+    return 1;
+  }
+
   xcb_window_t win = XCB_NONE;
   if (!xcb_stubs_attr_request_window(request, &win))
     return 0;
@@ -168,7 +226,7 @@ static void test_adopt_children_skips_override_and_unmapped(void) {
   setup_server(&s);
 
   xcb_window_t supporting = 9000;
-  s.supporting_wm_check = supporting;
+  s.screens[0].supporting_wm_check = supporting;
 
   xcb_window_t w1 = 1001;
   xcb_window_t w2 = 1002;
@@ -177,9 +235,9 @@ static void test_adopt_children_skips_override_and_unmapped(void) {
   xcb_stubs_set_query_tree_children(children, 4);
 
   g_adopt_attrs_len = 0;
-  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w1, false, XCB_MAP_STATE_VIEWABLE};
-  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w2, true, XCB_MAP_STATE_VIEWABLE};
-  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w3, false, XCB_MAP_STATE_UNMAPPED};
+  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w1, false, XCB_MAP_STATE_VIEWABLE, false, 0};
+  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w2, true, XCB_MAP_STATE_VIEWABLE, false, 0};
+  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w3, false, XCB_MAP_STATE_UNMAPPED, false, 0};
 
   stub_poll_for_reply_hook = adopt_poll_for_reply;
 
@@ -195,6 +253,190 @@ static void test_adopt_children_skips_override_and_unmapped(void) {
   cleanup_server(&s);
 }
 
+static void test_adopt_children_defers_other_desktops(void) {
+  server_t s;
+  setup_server(&s);
+  s.screens[0].current_desktop = 0;
+
+  xcb_window_t w1 = 1101;  // current desktop
+  xcb_window_t w2 = 1102;  // desktop 1
+  xcb_window_t w3 = 1103;  // sticky
+  xcb_window_t children[] = {w2, w1, w3};
+  xcb_stubs_set_query_tree_children(children, 3);
+
+  g_adopt_attrs_len = 0;
+  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w1, false, XCB_MAP_STATE_VIEWABLE, true, 0};
+  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w2, false, XCB_MAP_STATE_VIEWABLE, true, 1};
+  g_adopt_attrs[g_adopt_attrs_len++] = (adopt_attr_t){w3, false, XCB_MAP_STATE_VIEWABLE, true, 0xFFFFFFFFu};
+
+  stub_poll_for_reply_hook = adopt_poll_for_reply;
+
+  wm_adopt_children(&s);
+  cookie_jar_mark_replies_may_exist(&s.cookie_jar);
+  cookie_jar_drain(&s.cookie_jar, s.conn, &s, 32);
+
+  handle_t h1 = server_get_client_by_window(&s, w1);
+  handle_t h2 = server_get_client_by_window(&s, w2);
+  handle_t h3 = server_get_client_by_window(&s, w3);
+  assert(h1 != HANDLE_INVALID && h2 != HANDLE_INVALID && h3 != HANDLE_INVALID);
+
+  // Visible ones are adopted first, with the full probe, whatever the tree order
+  assert(s.active_clients.length == 3);
+  assert(s.active_clients.items[0] == h1 && s.active_clients.items[1] == h3 && s.active_clients.items[2] == h2);
+  assert(!server_chot(&s, h1)->probe_deferred);
+  assert(!server_chot(&s, h3)->probe_deferred);
+  assert(server_chot(&s, h2)->probe_deferred);
+  assert(s.adopt_deferred.length == 1 && s.adopt_deferred.items[0] == h2);
+
+  // Nothing is completed before its manage probes landed
+  client_complete_probe(&s, server_chot(&s, h2));
+  wm_adopt_trickle(&s);
+  assert(server_chot(&s, h2)->probe_deferred);
+  assert(s.adopt_deferred.length == 1);
+
+  printf("test_adopt_children_defers_other_desktops passed\n");
+  cleanup_server(&s);
+}
+
+static void test_adopt_children_consumes_stale_handoff(void) {
+  server_t s;
+  setup_server(&s);
+  s.screens[0].current_desktop = 0;
+
+  xcb_window_t kept = 1201;
+  xcb_window_t gone = 1202;  // destroyed while the WM restarted
+  handoff_client_t carried[2] = {
+      {.xid = kept, .desktop = 0, .geom = {0, 0, 200, 100}, .base_layer = LAYER_NORMAL, .stack_rank = 0, .focus_rank = 0},
+      {.xid = gone, .desktop = 0, .geom = {10, 10, 200, 100}, .base_layer = LAYER_NORMAL, .stack_rank = 1, .focus_rank = 1},
+  };
+  uint8_t* blob = NULL;
+  size_t len = 0;
+  assert(handoff_encode(s.screens[0].root, carried, 2, &blob, &len));
+  assert(handoff_decode(&s.handoff, blob, len));
+  free(blob);
+
+  xcb_window_t children[] = {kept};
+  xcb_stubs_set_query_tree_children(children, 1);
+  wm_adopt_children(&s);
+
+  // The missing window's record is dropped, the adopted one waits for manage
+  assert(s.handoff.active);
+  assert(handoff_find(&s.handoff, gone) == NULL);
+  assert(handoff_find(&s.handoff, kept) != NULL);
+
+  // A manage that never finishes consumes its record too
+  handle_t h = server_get_client_by_window(&s, kept);
+  assert(h != HANDLE_INVALID);
+  client_abort_manage(&s, h);
+  assert(!s.handoff.active);
+
+  printf("test_adopt_children_consumes_stale_handoff passed\n");
+  handoff_destroy(&s.handoff);
+  cleanup_server(&s);
+}
+
+static bool probed(xcb_atom_t atom) {
+  for (int i = 0; i < g_probe_reqs_len; i++) {
+    if (g_probe_reqs[i].atom == atom)
+      return true;
+  }
+  return false;
+}
+
+static const char* g_retitle = NULL;
+
+/* Answers the manage probes: _NET_WM_NAME with g_retitle, the others absent */
+static int retitle_poll_for_reply(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) {
+  (void)c;
+  if (error)
+    *error = NULL;
+
+  xcb_window_t win = XCB_NONE;
+  if (xcb_stubs_attr_request_window(request, &win)) {
+    xcb_get_window_attributes_reply_t* r = calloc(1, sizeof(*r));
+    r->map_state = XCB_MAP_STATE_VIEWABLE;
+    r->_class = XCB_WINDOW_CLASS_INPUT_OUTPUT;
+    if (reply)
+      *reply = r;
+    return 1;
+  }
+  if (request == g_geometry_seq) {
+    xcb_get_geometry_reply_t* r = calloc(1, sizeof(*r));
+    r->width = 200;
+    r->height = 100;
+    r->depth = 24;
+    if (reply)
+      *reply = r;
+    return 1;
+  }
+
+  for (int i = 0; i < g_probe_reqs_len; i++) {
+    if (g_probe_reqs[i].seq != request)
+      continue;
+    if (g_probe_reqs[i].atom != atoms._NET_WM_NAME)
+      return 1;
+    size_t len = strlen(g_retitle);
+    xcb_get_property_reply_t* r = calloc(1, sizeof(*r) + len);
+    r->format = 8;
+    r->type = atoms.UTF8_STRING;
+    r->value_len = (uint32_t)len;
+    r->length = (uint32_t)((len + 3) / 4);
+    memcpy(r + 1, g_retitle, len);
+    if (reply)
+      *reply = r;
+    return 1;
+  }
+  return 0;
+}
+
+static void test_handoff_refetches_names(void) {
+  server_t s;
+  setup_server(&s);
+  s.screens[0].current_desktop = 0;
+
+  xcb_window_t win = 1301;
+  handoff_client_t carried = {.xid = win, .desktop = 0, .geom = {0, 0, 200, 100}, .base_layer = LAYER_NORMAL, .flags = HANDOFF_NET_WM_NAME};
+  carried.str[HANDOFF_STR_CLASS] = "XTerm";
+  carried.str[HANDOFF_STR_INSTANCE] = "xterm";
+  carried.str[HANDOFF_STR_TITLE] = "~/src";
+  uint8_t* blob = NULL;
+  size_t len = 0;
+  assert(handoff_encode(s.screens[0].root, &carried, 1, &blob, &len));
+  assert(handoff_decode(&s.handoff, blob, len));
+  free(blob);
+
+  // The terminal retitles after the snapshot, before the new process selects
+  // PropertyChange on it
+  g_retitle = "~/src/hxm";
+
+  xcb_window_t children[] = {win};
+  xcb_stubs_set_query_tree_children(children, 1);
+  wm_adopt_children(&s);
+
+  handle_t h = server_get_client_by_window(&s, win);
+  assert(h != HANDLE_INVALID);
+  client_cold_t* cold = server_ccold(&s, h);
+
+  // The carried strings are the first paint...
+  assert(strcmp(cold->base_title, "~/src") == 0);
+  assert(cold->wm_class == str_intern("XTerm"));
+
+  // ...the names are probed again, the class and command are not
+  assert(probed(atoms._NET_WM_NAME) && probed(atoms.WM_NAME));
+  assert(probed(atoms._NET_WM_ICON_NAME) && probed(atoms.WM_ICON_NAME));
+  assert(!probed(atoms.WM_CLASS) && !probed(atoms.WM_CLIENT_MACHINE) && !probed(atoms.WM_COMMAND));
+
+  stub_poll_for_reply_hook = retitle_poll_for_reply;
+  cookie_jar_mark_replies_may_exist(&s.cookie_jar);
+  cookie_jar_drain(&s.cookie_jar, s.conn, &s, 64);
+  stub_poll_for_reply_hook = NULL;
+  assert(strcmp(cold->base_title, "~/src/hxm") == 0);
+
+  printf("test_handoff_refetches_names passed\n");
+  handoff_destroy(&s.handoff);
+  cleanup_server(&s);
+}
+
 static size_t count_live_clients(server_t* s) {
   size_t count = 0;
   for (uint32_t i = 1; i < s->clients.cap; i++) {
@@ -227,7 +469,7 @@ static void test_map_request_starts_manage_once(void) {
   xcb_map_request_event_t ev;
   memset(&ev, 0, sizeof(ev));
   ev.window = 1234;
-  ev.parent = s.root;
+  ev.parent = s.screens[0].root;
 
   wm_handle_map_request(&s, &ev);
   g_map_request_window = ev.window;
@@ -270,15 +512,14 @@ static void test_finish_manage_maps_client_then_frame(void) {
   hot->transient_for = HANDLE_INVALID;
   hot->desktop = 0;
   hot->desired = (rect_t){0, 0, 100, 80};
-  cold->visual_id = s.root_visual;
-  cold->depth = s.root_depth;
+  cold->visual_id = s.screens[0].root_visual;
+  cold->depth = s.screens[0].root_depth;
   hot->layer = LAYER_NORMAL;
   hot->base_layer = LAYER_NORMAL;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   stub_mapped_windows_len = 0;
   client_finish_manage(&s, h);
@@ -313,13 +554,12 @@ static void test_desktop_background_below_conky(void) {
   conky_hot->transient_for = HANDLE_INVALID;
   conky_hot->desktop = 0;
   conky_hot->desired = (rect_t){0, 0, 100, 80};
-  conky_cold->visual_id = s.root_visual;
-  conky_cold->depth = s.root_depth;
-  list_init(&conky_hot->focus_node);
+  conky_cold->visual_id = s.screens[0].root_visual;
+  conky_cold->depth = s.screens[0].root_depth;
   list_init(&conky_hot->transients_head);
   list_init(&conky_hot->transient_sibling);
-  conky_cold->wm_class = arena_strdup(&conky_cold->string_arena, "Conky");
-  hash_map_insert(&s.window_to_client, conky_hot->xid, handle_to_ptr(h_conky));
+  conky_cold->wm_class = str_intern("Conky");
+  server_xid_bind(&s, conky_hot->xid, XID_CLIENT, h_conky);
 
   void *hot_ptr2 = NULL, *cold_ptr2 = NULL;
   handle_t h_bg = slotmap_alloc(&s.clients, &hot_ptr2, &cold_ptr2);
@@ -339,20 +579,19 @@ static void test_desktop_background_below_conky(void) {
   bg_hot->transient_for = HANDLE_INVALID;
   bg_hot->desktop = 0;
   bg_hot->desired = (rect_t){0, 0, 100, 80};
-  bg_cold->visual_id = s.root_visual;
-  bg_cold->depth = s.root_depth;
-  list_init(&bg_hot->focus_node);
+  bg_cold->visual_id = s.screens[0].root_visual;
+  bg_cold->depth = s.screens[0].root_depth;
   list_init(&bg_hot->transients_head);
   list_init(&bg_hot->transient_sibling);
-  bg_cold->wm_class = arena_strdup(&bg_cold->string_arena, "Wallpaper");
-  hash_map_insert(&s.window_to_client, bg_hot->xid, handle_to_ptr(h_bg));
+  bg_cold->wm_class = str_intern("Wallpaper");
+  server_xid_bind(&s, bg_hot->xid, XID_CLIENT, h_bg);
 
   client_finish_manage(&s, h_conky);
   client_finish_manage(&s, h_bg);
 
-  assert(s.layers[LAYER_DESKTOP].length == 2);
-  assert(ptr_to_handle(s.layers[LAYER_DESKTOP].items[0]) == h_bg);
-  assert(ptr_to_handle(s.layers[LAYER_DESKTOP].items[1]) == h_conky);
+  assert(s.screens[0].layers[LAYER_DESKTOP].length == 2);
+  assert(s.screens[0].layers[LAYER_DESKTOP].items[0] == h_bg);
+  assert(s.screens[0].layers[LAYER_DESKTOP].items[1] == h_conky);
 
   printf("test_desktop_background_below_conky passed\n");
   cleanup_server(&s);
@@ -380,15 +619,14 @@ static void test_finish_manage_ignores_reparent_unmap(void) {
   hot->transient_for = HANDLE_INVALID;
   hot->desktop = 0;
   hot->desired = (rect_t){0, 0, 100, 80};
-  cold->visual_id = s.root_visual;
-  cold->depth = s.root_depth;
+  cold->visual_id = s.screens[0].root_visual;
+  cold->depth = s.screens[0].root_depth;
   hot->layer = LAYER_NORMAL;
   hot->base_layer = LAYER_NORMAL;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   client_finish_manage(&s, h);
   assert(hot->ignore_unmap > 0);
@@ -396,7 +634,7 @@ static void test_finish_manage_ignores_reparent_unmap(void) {
   xcb_unmap_notify_event_t unmap;
   memset(&unmap, 0, sizeof(unmap));
   unmap.window = hot->xid;
-  unmap.event = s.root;
+  unmap.event = s.screens[0].root;
   wm_handle_unmap_notify(&s, &unmap);
 
   assert(server_get_client_by_window(&s, hot->xid) == h);
@@ -440,14 +678,13 @@ static void test_rules_preserve_sticky_for_panel(void) {
   hot->sticky = true;
   hot->desktop = 0;
   hot->desired = (rect_t){0, 0, 100, 80};
-  cold->visual_id = s.root_visual;
-  cold->depth = s.root_depth;
-  list_init(&hot->focus_node);
+  cold->visual_id = s.screens[0].root_visual;
+  cold->depth = s.screens[0].root_depth;
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
-  cold->wm_class = arena_strdup(&cold->string_arena, "Conky");
+  cold->wm_class = str_intern("Conky");
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   client_finish_manage(&s, h);
 
@@ -466,6 +703,7 @@ static void test_rules_preserve_sticky_for_panel(void) {
     }
   }
   small_vec_destroy(&s.config.rules);
+  rule_set_destroy(&s.config.rule_set);
   cleanup_server(&s);
 }
 
@@ -474,13 +712,13 @@ static void test_map_request_maps_and_stays_mapped(void) {
   setup_server(&s);
   arena_init(&s.tick_arena, 4096);
 
-  s.desktop_count = 1;
-  s.current_desktop = 0;
+  s.screens[0].desktop_count = 1;
+  s.screens[0].current_desktop = 0;
 
   xcb_map_request_event_t ev;
   memset(&ev, 0, sizeof(ev));
   ev.window = 5678;
-  ev.parent = s.root;
+  ev.parent = s.screens[0].root;
 
   g_map_request_window = ev.window;
   stub_poll_for_reply_hook = map_request_poll_for_reply;
@@ -498,9 +736,10 @@ static void test_map_request_maps_and_stays_mapped(void) {
   assert(cold != NULL);
 
   hot->desired = (rect_t){0, 0, 120, 90};
-  cold->visual_id = s.root_visual;
-  cold->depth = s.root_depth;
+  cold->visual_id = s.screens[0].root_visual;
+  cold->depth = s.screens[0].root_depth;
   hot->state = STATE_READY;
+  server_queue_client(&s, hot);
 
   stub_map_window_count = 0;
   stub_unmap_window_count = 0;
@@ -548,12 +787,11 @@ static void test_unmap_destroy_unmanages(void) {
   hot->layer = LAYER_NORMAL;
   hot->base_layer = LAYER_NORMAL;
   hot->ignore_unmap = 0;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
-  hash_map_insert(&s.frame_to_client, hot->frame, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
+  server_xid_bind(&s, hot->frame, XID_FRAME, h);
 
   wm_set_focus(&s, h);
   assert(s.focused_client == h);
@@ -561,11 +799,11 @@ static void test_unmap_destroy_unmanages(void) {
   xcb_unmap_notify_event_t unmap;
   memset(&unmap, 0, sizeof(unmap));
   unmap.window = hot->xid;
-  unmap.event = s.root;
+  unmap.event = s.screens[0].root;
   wm_handle_unmap_notify(&s, &unmap);
 
   assert(server_get_client_by_window(&s, hot->xid) == HANDLE_INVALID);
-  assert((s.root_dirty & ROOT_DIRTY_CLIENT_LIST) != 0);
+  assert((s.screens[0].root_dirty & ROOT_DIRTY_CLIENT_LIST) != 0);
 
   void *hot_ptr2 = NULL, *cold_ptr2 = NULL;
   handle_t h2 = slotmap_alloc(&s.clients, &hot_ptr2, &cold_ptr2);
@@ -581,20 +819,19 @@ static void test_unmap_destroy_unmanages(void) {
   hot2->state = STATE_MAPPED;
   hot2->layer = LAYER_NORMAL;
   hot2->base_layer = LAYER_NORMAL;
-  list_init(&hot2->focus_node);
   list_init(&hot2->transients_head);
   list_init(&hot2->transient_sibling);
-  hash_map_insert(&s.window_to_client, hot2->xid, handle_to_ptr(h2));
-  hash_map_insert(&s.frame_to_client, hot2->frame, handle_to_ptr(h2));
+  server_xid_bind(&s, hot2->xid, XID_CLIENT, h2);
+  server_xid_bind(&s, hot2->frame, XID_FRAME, h2);
 
   xcb_destroy_notify_event_t destroy;
   memset(&destroy, 0, sizeof(destroy));
   destroy.window = hot2->xid;
-  destroy.event = s.root;
+  destroy.event = s.screens[0].root;
   wm_handle_destroy_notify(&s, &destroy);
 
   assert(server_get_client_by_window(&s, hot2->xid) == HANDLE_INVALID);
-  assert((s.root_dirty & ROOT_DIRTY_CLIENT_LIST) != 0);
+  assert((s.screens[0].root_dirty & ROOT_DIRTY_CLIENT_LIST) != 0);
 
   printf("test_unmap_destroy_unmanages passed\n");
   cleanup_server(&s);
@@ -620,12 +857,11 @@ static void test_destroy_notify_unmanages_and_destroys_frame(void) {
   hot->state = STATE_MAPPED;
   hot->layer = LAYER_NORMAL;
   hot->base_layer = LAYER_NORMAL;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
-  hash_map_insert(&s.frame_to_client, hot->frame, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
+  server_xid_bind(&s, hot->frame, XID_FRAME, h);
 
   wm_set_focus(&s, h);
   assert(s.focused_client == h);
@@ -635,7 +871,7 @@ static void test_destroy_notify_unmanages_and_destroys_frame(void) {
   xcb_destroy_notify_event_t destroy;
   memset(&destroy, 0, sizeof(destroy));
   destroy.window = hot->xid;
-  destroy.event = s.root;
+  destroy.event = s.screens[0].root;
   wm_handle_destroy_notify(&s, &destroy);
 
   assert(server_get_client_by_window(&s, hot->xid) == HANDLE_INVALID);
@@ -669,12 +905,11 @@ static void test_iconify_ignores_unmap_notify_send_event(void) {
   hot->base_layer = LAYER_NORMAL;
   hot->stacking_layer = -1;
   hot->stacking_index = -1;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
-  hash_map_insert(&s.frame_to_client, hot->frame, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
+  server_xid_bind(&s, hot->frame, XID_FRAME, h);
 
   wm_client_iconify(&s, h);
   assert(hot->state == STATE_UNMAPPED);
@@ -685,7 +920,7 @@ static void test_iconify_ignores_unmap_notify_send_event(void) {
   memset(&unmap_frame, 0, sizeof(unmap_frame));
   unmap_frame.response_type = XCB_UNMAP_NOTIFY | 0x80;
   unmap_frame.window = hot->frame;
-  unmap_frame.event = s.root;
+  unmap_frame.event = s.screens[0].root;
   wm_handle_unmap_notify(&s, &unmap_frame);
 
   // Simulate UnmapNotify for the client (consumed by ignore_unmap)
@@ -693,7 +928,7 @@ static void test_iconify_ignores_unmap_notify_send_event(void) {
   memset(&unmap, 0, sizeof(unmap));
   unmap.response_type = XCB_UNMAP_NOTIFY | 0x80;
   unmap.window = hot->xid;
-  unmap.event = s.root;
+  unmap.event = s.screens[0].root;
   wm_handle_unmap_notify(&s, &unmap);
 
   assert(server_get_client_by_window(&s, hot->xid) == h);
@@ -713,7 +948,7 @@ static void test_reparent_notify_ignored(void) {
   memset(&ev, 0, sizeof(ev));
   ev.response_type = XCB_REPARENT_NOTIFY;
   ev.window = 4001;
-  ev.parent = s.root;
+  ev.parent = s.screens[0].root;
 
   xcb_stubs_reset();
   xcb_stubs_enqueue_event((xcb_generic_event_t*)memcpy(calloc(1, sizeof(ev)), &ev, sizeof(ev)));
@@ -738,7 +973,7 @@ static void test_manage_start_already_managed(void) {
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   hot->xid = win;
   hot->state = STATE_MAPPED;  // Assuming managed
-  hash_map_insert(&s.window_to_client, win, handle_to_ptr(h));
+  server_xid_bind(&s, win, XID_CLIENT, h);
 
   // Call manage_start again
   // Should return early and not allocate new slot
@@ -768,8 +1003,8 @@ static void test_manage_start_defaults_desktop_current(void) {
   server_t s;
   setup_server(&s);
 
-  s.desktop_count = 4;
-  s.current_desktop = 2;
+  s.screens[0].desktop_count = 4;
+  s.screens[0].current_desktop = 2;
 
   xcb_window_t win = 4242;
   client_manage_start(&s, win);
@@ -779,7 +1014,7 @@ static void test_manage_start_defaults_desktop_current(void) {
 
   client_hot_t* hot = server_chot(&s, h);
   assert(hot != NULL);
-  assert(hot->desktop == (int32_t)s.current_desktop);
+  assert(hot->desktop == (int32_t)s.screens[0].current_desktop);
   assert(hot->sticky == false);
   assert(hot->net_wm_desktop_seen == false);
 
@@ -794,7 +1029,7 @@ static void test_map_request_zero_sequence_maps_unmanaged(void) {
   xcb_map_request_event_t ev;
   memset(&ev, 0, sizeof(ev));
   ev.window = 4646;
-  ev.parent = s.root;
+  ev.parent = s.screens[0].root;
 
   g_force_attr_query_zero_sequence = true;
   wm_handle_map_request(&s, &ev);
@@ -829,8 +1064,80 @@ static void test_should_focus_on_map_override(void) {
   printf("test_should_focus_on_map_override passed\n");
 }
 
+static void test_destroy_before_framing_is_discarded(void) {
+  server_t s;
+  setup_server(&s);
+  manage_stats_init();
+
+  client_manage_start(&s, 6001);
+  handle_t h = server_get_client_by_window(&s, 6001);
+  assert(h != HANDLE_INVALID);
+  assert(server_chot(&s, h)->frame == XCB_NONE);
+
+  stub_reparent_window_count = 0;
+  stub_save_set_delete_count = 0;
+  stub_destroy_window_count = 0;
+
+  xcb_destroy_notify_event_t destroy;
+  memset(&destroy, 0, sizeof(destroy));
+  destroy.window = 6001;
+  destroy.event = s.screens[0].root;
+  wm_handle_destroy_notify(&s, &destroy);
+
+  // Never framed: dropped without a single request to the server
+  assert(server_get_client_by_window(&s, 6001) == HANDLE_INVALID);
+  assert(count_live_clients(&s) == 0);
+  assert(stub_reparent_window_count == 0);
+  assert(stub_save_set_delete_count == 0);
+  assert(stub_destroy_window_count == 0);
+  assert(manage_stats.discarded_probing == 1);
+  assert(manage_stats.discarded_ready == 0);
+
+  printf("test_destroy_before_framing_is_discarded passed\n");
+  cleanup_server(&s);
+}
+
+static void test_manage_defer_holds_ready_client(void) {
+  server_t s;
+  setup_server(&s);
+  manage_stats_init();
+  handle_vec_init(&s.dirty_clients);
+  s.config.manage_defer_ms = 50;
+
+  client_manage_start(&s, 6101);
+  handle_t h = server_get_client_by_window(&s, 6101);
+  assert(h != HANDLE_INVALID);
+  client_hot_t* hot = server_chot(&s, h);
+  client_cold_t* cold = server_ccold(&s, h);
+  hot->state = STATE_READY;
+  manage_timing_mark(&cold->manage_timing, MANAGE_MARK_READY, cold->manage_timing.t[MANAGE_MARK_START] + 1);
+  handle_vec_push(&s.dirty_clients, h);
+
+  uint64_t start = cold->manage_timing.t[MANAGE_MARK_START];
+  assert(wm_manage_defer_timeout_ms(&s, start + 10000000ull) == 40);
+  assert(wm_manage_defer_timeout_ms(&s, start + 60000000ull) == 0);
+
+  // Destroyed while held: counted as a ready discard
+  xcb_destroy_notify_event_t destroy;
+  memset(&destroy, 0, sizeof(destroy));
+  destroy.window = 6101;
+  destroy.event = s.screens[0].root;
+  wm_handle_destroy_notify(&s, &destroy);
+
+  assert(count_live_clients(&s) == 0);
+  assert(manage_stats.discarded_ready == 1);
+  assert(wm_manage_defer_timeout_ms(&s, start) == -1);
+
+  printf("test_manage_defer_holds_ready_client passed\n");
+  handle_vec_destroy(&s.dirty_clients);
+  cleanup_server(&s);
+}
+
 int main(void) {
   test_adopt_children_skips_override_and_unmapped();
+  test_adopt_children_defers_other_desktops();
+  test_adopt_children_consumes_stale_handoff();
+  test_handoff_refetches_names();
   test_map_request_starts_manage_once();
   test_finish_manage_maps_client_then_frame();
   test_finish_manage_ignores_reparent_unmap();
@@ -841,6 +1148,8 @@ int main(void) {
   test_destroy_notify_unmanages_and_destroys_frame();
   test_iconify_ignores_unmap_notify_send_event();
   test_reparent_notify_ignored();
+  test_destroy_before_framing_is_discarded();
+  test_manage_defer_holds_ready_client();
 
   test_manage_start_already_managed();
   test_manage_start_requests_window_type();
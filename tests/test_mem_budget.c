@@ -0,0 +1,204 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "client.h"
+#include "event.h"
+#include "mem_budget.h"
+#include "render.h"
+
+extern void xcb_stubs_reset(void);
+
+static void setup_server(server_t* s) {
+  memset(s, 0, sizeof(server_t));
+  s->is_test = true;
+
+  xcb_stubs_reset();
+  s->conn = xcb_connect(NULL, NULL);
+  slotmap_init(&s->clients, 8, sizeof(client_hot_t), sizeof(client_cold_t));
+  title_cache_init(&s->title_cache);
+  s->screens[0].desktop_count = 2;
+  s->screens[0].current_desktop = 0;
+}
+
+static void teardown_server(server_t* s) {
+  uint32_t idx;
+  slotmap_for_each_live(&s->clients, idx) {
+    client_cold_t* cold = slotmap_cold_at(&s->clients, idx);
+    client_render_payload_destroy(cold);
+  }
+  title_cache_destroy(&s->title_cache);
+  slotmap_destroy(&s->clients);
+  xcb_disconnect(s->conn);
+}
+
+static client_cold_t* add_client(server_t* s, xcb_window_t xid, uint8_t state, int32_t desktop) {
+  void* hot_ptr = NULL;
+  void* cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s->clients, &hot_ptr, &cold_ptr);
+  assert(h != HANDLE_INVALID);
+  client_hot_t* hot = hot_ptr;
+  client_cold_t* cold = cold_ptr;
+  hot->self = h;
+  hot->xid = xid;
+  hot->frame = xid + 1u;
+  hot->state = state;
+  hot->desktop = desktop;
+  client_render_payload_init(cold);
+  return cold;
+}
+
+static size_t image_size(int w, int h) {
+  return (size_t)cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, w) * (size_t)h;
+}
+
+void test_mem_usage_measure(void) {
+  server_t s;
+  setup_server(&s);
+
+  client_cold_t* a = add_client(&s, 0x400001, STATE_MAPPED, 0);
+  a->render_ctx.title_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 100, 20);
+  a->icon_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 32, 32);
+  a->thumb = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+  a->thumb_w = 96;
+  a->thumb_h = 60;
+
+  // A deduplicated icon is split between its holders
+  client_cold_t* b = add_client(&s, 0x500001, STATE_MAPPED, 0);
+  b->icon_surface = cairo_surface_reference(a->icon_surface);
+
+  mem_usage_t u;
+  mem_usage_measure(&s, &u);
+  assert(u.bytes[MEM_CLIENT_SLOTS] >= 8u * (sizeof(client_hot_t) + sizeof(client_cold_t)));
+  assert(u.bytes[MEM_TITLES] == image_size(100, 20));
+  assert(u.bytes[MEM_ICONS] == image_size(32, 32));
+  assert(u.bytes[MEM_THUMBNAILS] == 96u * 60u * 4u);
+
+  size_t sum = 0;
+  for (int i = 0; i < MEM_CLASS_COUNT; i++)
+    sum += u.bytes[i];
+  assert(u.total == sum);
+
+  teardown_server(&s);
+  printf("test_mem_usage_measure passed\n");
+}
+
+void test_mem_budget_evicts_hidden_only(void) {
+  server_t s;
+  setup_server(&s);
+
+  // Visible: nothing may be evicted
+  client_cold_t* vis = add_client(&s, 0x400001, STATE_MAPPED, 0);
+  vis->render_ctx.title_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 100, 20);
+  vis->icon_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 128, 128);
+
+  // Iconified: title and oversized icon go, a small icon stays
+  client_cold_t* icon = add_client(&s, 0x500001, STATE_UNMAPPED, 0);
+  icon->render_ctx.title_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 100, 20);
+  icon->icon_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 256, 256);
+  client_cold_t* small = add_client(&s, 0x600001, STATE_UNMAPPED, 0);
+  small->icon_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 48, 48);
+
+  // Other desktop: render context and backing pixmap go
+  client_cold_t* other = add_client(&s, 0x700001, STATE_UNMAPPED, 1);
+  other->render_ctx.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 200, 100);
+  other->frame_pixmap = 0x700100;
+  other->frame_pixmap_w = 200;
+  other->frame_pixmap_h = 100;
+
+  // Under target: nothing happens
+  assert(mem_budget_enforce(&s, SIZE_MAX, NULL) == 0);
+
+  bool queued = false;
+  size_t freed = mem_budget_enforce(&s, 0, &queued);
+  assert(queued);
+  assert(freed >= image_size(100, 20) + image_size(256, 256) + image_size(200, 100) + 200u * 100u * 4u);
+
+  assert(vis->render_ctx.title_surface && vis->icon_surface);
+  assert(!icon->render_ctx.title_surface);
+  assert(!icon->icon_surface && icon->icon_fetch.phase == ICON_FETCH_WANTED);
+  assert(small->icon_surface);
+  assert(!other->render_ctx.surface && other->frame_pixmap == XCB_NONE);
+
+  assert(s.mem_budget.evicted[MEM_EVICT_TITLES] == 1);
+  assert(s.mem_budget.evicted[MEM_EVICT_RENDER] == 1);
+  assert(s.mem_budget.evicted[MEM_EVICT_ICONS] == 1);
+
+  teardown_server(&s);
+  printf("test_mem_budget_evicts_hidden_only passed\n");
+}
+
+void test_mem_budget_tick_interval(void) {
+  server_t s;
+  setup_server(&s);
+  client_cold_t* c = add_client(&s, 0x400001, STATE_UNMAPPED, 0);
+  c->render_ctx.title_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1024, 512);
+
+  // No budget: measured, never evicted
+  assert(!mem_budget_tick(&s, 1));
+  assert(s.mem_budget.checks == 1 && s.mem_budget.last.total > 0);
+  assert(c->render_ctx.title_surface);
+
+  // Rate limited to one measurement per interval
+  mem_budget_tick(&s, 2);
+  assert(s.mem_budget.checks == 1);
+
+  // A budget below usage evicts on the next check
+  s.config.memory_budget_mb = 1;
+  mem_budget_tick(&s, s.mem_budget.next_check_ns);
+  assert(s.mem_budget.checks == 2);
+  assert(s.mem_budget.over_budget == 1);
+  assert(!c->render_ctx.title_surface);
+  assert(s.mem_budget.evicted_bytes[MEM_EVICT_TITLES] == image_size(1024, 512));
+
+  char buf[1024];
+  assert(mem_budget_format(&s.mem_budget, 1u << 20, buf, sizeof(buf)) > 0);
+  assert(strstr(buf, "memory (KiB): total="));
+  assert(strstr(buf, "titles="));
+
+  teardown_server(&s);
+  printf("test_mem_budget_tick_interval passed\n");
+}
+
+void test_idle_render_release(void) {
+  server_t s;
+  setup_server(&s);
+  s.config.render_idle_release_s = 5;
+
+  client_cold_t* hidden = add_client(&s, 0x400001, STATE_UNMAPPED, 0);
+  hidden->render_ctx.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 200, 100);
+  client_cold_t* away = add_client(&s, 0x500001, STATE_MAPPED, 1);
+  away->render_ctx.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 200, 100);
+  client_cold_t* shown = add_client(&s, 0x600001, STATE_MAPPED, 0);
+  shown->render_ctx.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 200, 100);
+
+  const uint64_t sec = 1000000000ull;
+  mem_budget_tick(&s, sec);
+  mem_budget_tick(&s, 4 * sec);
+  assert(hidden->render_idle_s == 3 && away->render_idle_s == 3);
+  assert(hidden->render_ctx.surface && away->render_ctx.surface);
+
+  // A long idle sleep still counts in full
+  mem_budget_tick(&s, 7 * sec);
+  assert(!hidden->render_ctx.surface && hidden->render_idle_s == 0);
+  assert(!away->render_ctx.surface);
+  assert(shown->render_ctx.surface && shown->render_idle_s == 0);
+  assert(s.mem_budget.evicted[MEM_EVICT_IDLE_RENDER] == 2);
+  assert(s.mem_budget.evicted_bytes[MEM_EVICT_IDLE_RENDER] == 2 * image_size(200, 100));
+
+  // Released contexts are not counted again
+  mem_budget_tick(&s, 20 * sec);
+  assert(s.mem_budget.evicted[MEM_EVICT_IDLE_RENDER] == 2);
+
+  teardown_server(&s);
+  printf("test_idle_render_release passed\n");
+}
+
+int main(void) {
+  test_mem_usage_measure();
+  test_mem_budget_evicts_hidden_only();
+  test_mem_budget_tick_interval();
+  test_idle_render_release();
+  return 0;
+}
@@ -10,18 +10,27 @@
 #include "event.h"
 #include "hxm.h"
 #include "menu.h"
+#include "thumbnail.h"
 #include "wm.h"
 
+extern void xcb_stubs_reset(void);
+extern int stub_put_image_count;
+extern uint32_t stub_last_image_h;
+extern int stub_composite_redirect_count;
+extern int stub_composite_unredirect_count;
+extern int stub_damage_create_count;
+extern int stub_damage_destroy_count;
+
 void setup_server(server_t* s) {
   memset(s, 0, sizeof(server_t));
   s->is_test = true;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(NULL, 0);
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s->conn = xcb_connect(NULL, NULL);
   s->keysyms = xcb_key_symbols_alloc(s->conn);
   slotmap_init(&s->clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  s->desktop_count = 4;
-  s->current_desktop = 0;
+  s->screens[0].desktop_count = 4;
+  s->screens[0].current_desktop = 0;
 
   config_init_defaults(&s->config);
 
@@ -53,6 +62,7 @@ static void teardown_server(server_t* s) {
       }
     }
   }
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
   xcb_key_symbols_free(s->keysyms);
   xcb_disconnect(s->conn);
@@ -64,11 +74,11 @@ void test_menu_basics(void) {
 
   // 1. Initial state
   assert(s.menu.visible == false);
-  assert(s.menu.items.length == 0);
+  assert(s.menu.item_count == 0);
 
   // 2. Show menu
   menu_show(&s, 100, 100);
-  assert(s.menu.items.length == 25);  // Matches data/menu.conf (15 apps, 3
+  assert(s.menu.item_count == 25);  // Matches data/menu.conf (15 apps, 3
                                       // separators, 2 prefs, 4 monitors, 1 exit)
   assert(s.menu.visible == true);
   assert(s.menu.x == 100);
@@ -164,15 +174,336 @@ void test_menu_right_click_keeps_menu_visible(void) {
   teardown_server(&s);
 }
 
+void test_menu_hover_repaints_changed_rows(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+
+  // Showing renders every row once and presents the whole menu
+  menu_show(&s, 100, 100);
+  assert(s.menu.back != NULL);
+  assert(stub_put_image_count == 1);
+  assert(stub_last_image_h == s.menu.h);
+
+  assert(s.menu.back_selected == -1);
+
+  // Entering item 0 repaints only that row
+  menu_handle_pointer_motion(&s, 110, 110);
+  assert(s.menu.selected_index == 0);
+  assert(stub_put_image_count == 2);
+  assert(stub_last_image_h == 24);
+  assert(s.menu.back_selected == 0);
+
+  // Moving within the row does nothing; moving to item 1 repaints two rows
+  menu_handle_pointer_motion(&s, 120, 112);
+  assert(stub_put_image_count == 2);
+  menu_handle_pointer_motion(&s, 110, 134);
+  assert(s.menu.selected_index == 1);
+  assert(stub_put_image_count == 4);
+  assert(stub_last_image_h == 24);
+  assert(s.menu.back_selected == 1);
+
+  // Exposes are served from the buffer, clipped to the damage
+  dirty_region_t dirty = dirty_region_make(0, 30, 50, 10);
+  menu_handle_expose_region(&s, &dirty);
+  assert(stub_put_image_count == 5);
+  assert(stub_last_image_h == 10);
+
+  menu_hide(&s);
+  assert(s.menu.back == NULL);
+
+  printf("test_menu_hover_repaints_changed_rows passed\n");
+  teardown_server(&s);
+}
+
+void test_menu_icons_load_on_first_show(void) {
+  server_t s;
+  setup_server(&s);
+
+  // Parsing the config does not decode icons
+  assert(s.menu.config_count > 0);
+  for (size_t i = 0; i < s.menu.config_count; i++) {
+    menu_item_spec_t* spec = &s.menu.config_items[i];
+    assert(!spec->icon_loaded);
+    assert(spec->icon_surface == NULL);
+  }
+
+  menu_show(&s, 100, 100);
+  for (size_t i = 0; i < s.menu.config_count; i++) {
+    menu_item_spec_t* spec = &s.menu.config_items[i];
+    assert(spec->icon_loaded);
+    menu_item_t* item = &s.menu.items[i];
+    assert(item->icon_surface == spec->icon_surface);
+  }
+  menu_hide(&s);
+
+  // Showing again reuses the decoded surfaces
+  menu_item_spec_t* first = &s.menu.config_items[0];
+  cairo_surface_t* icon = first->icon_surface;
+  menu_show(&s, 100, 100);
+  assert(first->icon_surface == icon);
+  menu_hide(&s);
+
+  printf("test_menu_icons_load_on_first_show passed\n");
+  teardown_server(&s);
+}
+
+void test_menu_config_interns_strings(void) {
+  server_t s;
+  setup_server(&s);
+
+  char path[] = "/tmp/hxm-menu-XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  const char* conf =
+      "- label: Term\n  cmd: xterm\n  icon: /nonexistent/term.png\n"
+      "- separator: true\n"
+      "- label: Broken\n  cmd: [nested, list]\n"
+      "- just a scalar\n"
+      "- cmd: unlabeled\n"
+      "- label: Term\n  cmd: xterm -e top\n  icon: /nonexistent/term.png\n";
+  assert(write(fd, conf, strlen(conf)) == (ssize_t)strlen(conf));
+  close(fd);
+
+  assert(menu_load_config(&s, path));
+  assert(s.menu.config_count == 4);
+  assert(s.menu.config_items[1].action == MENU_ACTION_SEPARATOR);
+  assert(s.menu.config_items[2].action == MENU_ACTION_NONE);
+  assert(s.menu.config_items[2].cmd == NULL);
+
+  // Repeated strings share one copy in the config arena
+  menu_item_spec_t* a = &s.menu.config_items[0];
+  menu_item_spec_t* b = &s.menu.config_items[3];
+  assert(a->action == MENU_ACTION_EXEC && b->action == MENU_ACTION_EXEC);
+  assert(a->label == b->label);
+  assert(a->icon_path == b->icon_path);
+  assert(strcmp(a->cmd, "xterm") == 0 && strcmp(b->cmd, "xterm -e top") == 0);
+
+  // A broken file keeps the previous config
+  FILE* f = fopen(path, "w");
+  assert(f);
+  fputs("- label: [unterminated\n", f);
+  fclose(f);
+  assert(!menu_load_config(&s, path));
+  assert(s.menu.config_count == 4);
+  assert(strcmp(s.menu.config_items[0].label, "Term") == 0);
+
+  unlink(path);
+  printf("test_menu_config_interns_strings passed\n");
+  teardown_server(&s);
+}
+
+static handle_t add_switcher_client(server_t* s, xcb_window_t xid, uint16_t w, uint16_t h) {
+  handle_t handle = slotmap_alloc(&s->clients, NULL, NULL);
+  client_hot_t* hot = server_chot(s, handle);
+  client_cold_t* cold = server_ccold(s, handle);
+  client_render_payload_init(cold);
+  hot->self = handle;
+  hot->xid = xid;
+  hot->state = STATE_MAPPED;
+  hot->frame_vis = FRAME_VIS_MAPPED;
+  hot->server = (rect_t){0, 0, w, h};
+  wm_focus_history_insert(s, hot->self, focus_mru_last(&s->focus_mru));
+  return handle;
+}
+
+void test_switcher_thumbnails(void) {
+  server_t s;
+  setup_server(&s);
+  xcb_stubs_reset();
+  handle_vec_init(&s.thumb_queue);
+  s.composite_supported = true;
+  s.damage_supported = true;
+  s.config.switcher_thumbnails = true;
+  s.config.switcher_thumbnail_hz = 2;
+
+  handle_t a = add_switcher_client(&s, 0x400001, 800, 500);
+  handle_t b = add_switcher_client(&s, 0x400002, 300, 600);
+  thumbnail_track(&s, a);
+  thumbnail_track(&s, b);
+  assert(stub_composite_redirect_count == 2);
+  assert(s.thumb_queue.length == 2);
+
+  // Tracking is what subscribes a client to Damage; a second consumer shares it
+  assert(stub_damage_create_count == 2);
+  assert(server_ccold(&s, a)->damage != XCB_NONE);
+  client_damage_subscribe(&s, a);
+  assert(stub_damage_create_count == 2 && server_ccold(&s, a)->damage_refs == 2);
+  client_damage_unsubscribe(&s, a);
+  assert(stub_damage_destroy_count == 0 && server_ccold(&s, a)->damage != XCB_NONE);
+
+  // Both are captured on the first flush, scaled to fit the box
+  uint64_t t0 = 1000000000ull;
+  assert(thumbnail_flush(&s, t0));
+  assert(s.thumb_queue.length == 0);
+  int w = 0;
+  int h = 0;
+  assert(thumbnail_get(&s, a, &w, &h) != NULL);
+  assert(w == THUMBNAIL_MAX_W && h == THUMBNAIL_MAX_H);
+  assert(thumbnail_get(&s, b, &w, &h) != NULL);
+  assert(w == THUMBNAIL_MAX_H / 2 && h == THUMBNAIL_MAX_H);
+
+  // Damage inside the refresh interval waits; the thumbnail is kept
+  thumbnail_mark_stale(&s, a);
+  thumbnail_mark_stale(&s, a);
+  assert(s.thumb_queue.length == 1);
+  assert(!thumbnail_flush(&s, t0 + 100000000ull));
+  assert(s.thumb_queue.length == 1);
+  assert(server_ccold(&s, a)->thumb_time == t0);
+  assert(thumbnail_flush(&s, t0 + 500000000ull));
+  assert(s.thumb_queue.length == 0);
+  assert(server_ccold(&s, a)->thumb_time == t0 + 500000000ull);
+
+  // Switcher rows are sized for thumbnails; stepping repaints one row pair
+  menu_show_switcher(&s, a);
+  assert(s.menu.is_switcher);
+  assert(s.menu.item_count == 2);
+  assert(s.menu.h == 2 * s.menu.item_height + 8);
+  assert(s.menu.item_height > 24);
+  int puts = stub_put_image_count;
+  assert(menu_switcher_step(&s, 1));
+  assert(stub_put_image_count == puts + 2);
+  assert(stub_last_image_h == (uint32_t)s.menu.item_height);
+  menu_hide(&s);
+
+  // Turning the option off releases every thumbnail
+  s.config.switcher_thumbnails = false;
+  thumbnail_release(&s, a);
+  thumbnail_release(&s, b);
+  assert(stub_composite_unredirect_count == 2);
+  assert(thumbnail_get(&s, a, NULL, NULL) == NULL);
+
+  // With no consumer left no damage object remains
+  assert(stub_damage_destroy_count == 2);
+  assert(server_ccold(&s, a)->damage == XCB_NONE && server_ccold(&s, b)->damage == XCB_NONE);
+  client_damage_unsubscribe(&s, a);
+  assert(stub_damage_destroy_count == 2);
+
+  // Plain list rows come back with the option off
+  menu_show_switcher(&s, a);
+  assert(s.menu.item_height == 24);
+  menu_hide(&s);
+
+  printf("test_switcher_thumbnails passed\n");
+  handle_vec_destroy(&s.thumb_queue);
+  teardown_server(&s);
+}
+
+static void press_key(server_t* s, xcb_keycode_t code) {
+  xcb_key_press_event_t ev = {0};
+  ev.detail = code;
+  menu_handle_key_press(s, &ev);
+}
+
+// Stub keycodes 200..225 are a..z
+#define KEY_LETTER(c) ((xcb_keycode_t)(200 + ((c) - 'a')))
+
+void test_menu_type_ahead_filters_rows(void) {
+  server_t s;
+  setup_server(&s);
+
+  // Masks are built while menu.conf is parsed
+  assert(s.menu.config_items[0].match_mask != 0);
+
+  menu_show(&s, 100, 100);
+  assert(s.menu.row_count == 25);
+  uint16_t h = s.menu.h;
+  xcb_stubs_reset();
+
+  // 'x' keeps 8 items (labels or commands); row 0 is unchanged but gains the
+  // highlight, and every changed row goes out in one band
+  press_key(&s, KEY_LETTER('x'));
+  assert(s.menu.row_count == 8);
+  assert(s.menu.selected_index == 0);
+  assert(stub_put_image_count == 1);
+  assert(stub_last_image_h == 25 * 24);
+  assert(s.menu.h == h);
+
+  // Narrowing to "xr" leaves the xrandr entries; rows 4..7 are cleared
+  press_key(&s, KEY_LETTER('r'));
+  assert(s.menu.row_count == 4);
+  for (uint32_t r = 0; r < s.menu.row_count; r++) {
+    menu_item_t* item = &s.menu.items[s.menu.rows[r]];
+    assert(strncmp(item->label, "Monitor > ", 10) == 0);
+    assert(item->row == r);
+  }
+  assert(s.menu.items[0].row == MENU_ROW_HIDDEN);
+  assert(s.menu.selected_index == (int32_t)s.menu.rows[0]);
+  assert(stub_put_image_count == 2);
+  assert(stub_last_image_h == 8 * 24);
+
+  // Arrow keys walk the shown rows only
+  press_key(&s, 116);
+  assert(s.menu.selected_index == (int32_t)s.menu.rows[1]);
+
+  // A query with no match empties the list; Return does nothing
+  press_key(&s, KEY_LETTER('q'));
+  assert(s.menu.row_count == 0 && s.menu.selected_index == -1);
+  press_key(&s, 36);
+  assert(s.menu.visible);
+
+  press_key(&s, 22);
+  press_key(&s, 22);
+  assert(s.menu.row_count == 8);
+
+  // Escape drops the query first, then closes the menu
+  press_key(&s, 9);
+  assert(s.menu.visible && s.menu.filter_len == 0 && s.menu.row_count == 25);
+  press_key(&s, 9);
+  assert(!s.menu.visible);
+
+  printf("test_menu_type_ahead_filters_rows passed\n");
+  teardown_server(&s);
+}
+
+void test_menu_type_ahead_follows_titles(void) {
+  server_t s;
+  setup_server(&s);
+
+  handle_t a = add_switcher_client(&s, 0x400001, 100, 100);
+  handle_t b = add_switcher_client(&s, 0x400002, 100, 100);
+  server_ccold(&s, a)->title = "Terminal";
+  server_ccold(&s, b)->title = "Browser";
+
+  menu_show_client_list(&s, 0, 0);
+  assert(s.menu.row_count == 2);
+  press_key(&s, KEY_LETTER('t'));
+  press_key(&s, KEY_LETTER('r'));
+  press_key(&s, KEY_LETTER('m'));
+  assert(s.menu.row_count == 1);
+  assert(s.menu.items[s.menu.rows[0]].client == a);
+
+  // A retitled client enters and leaves the filtered list
+  server_ccold(&s, b)->title = "Remote terminal";
+  menu_client_title_changed(&s, b);
+  assert(s.menu.row_count == 2);
+  server_ccold(&s, a)->title = "Editor";
+  menu_client_title_changed(&s, a);
+  assert(s.menu.row_count == 1);
+  assert(s.menu.items[s.menu.rows[0]].client == b);
+  assert(s.menu.selected_index == (int32_t)s.menu.rows[0]);
+  menu_hide(&s);
+
+  printf("test_menu_type_ahead_follows_titles passed\n");
+  teardown_server(&s);
+}
+
 int main(void) {
   test_menu_basics();
   test_menu_esc();
   test_menu_right_click_keeps_menu_visible();
+  test_menu_hover_repaints_changed_rows();
+  test_menu_icons_load_on_first_show();
+  test_menu_config_interns_strings();
+  test_switcher_thumbnails();
+  test_menu_type_ahead_filters_rows();
+  test_menu_type_ahead_follows_titles();
 
   /*
    * Release shared font-map/fontconfig globals once after all menu tests.
    * This keeps sanitizer leak checks stable across libc/fontconfig variants.
    */
+  render_text_shutdown();
   pango_cairo_font_map_set_default(NULL);
   FcFini();
 
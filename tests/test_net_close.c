@@ -19,8 +19,8 @@ void test_net_close_window(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
   // Setup atoms
@@ -40,8 +40,8 @@ void test_net_close_window(void) {
   hot->state = STATE_MAPPED;
 
   // Associate window with client in the map
-  hash_map_init(&s.window_to_client);
-  hash_map_insert(&s.window_to_client, hot->xid, (void*)(uintptr_t)h);
+  hash_map_init(&s.xid_index);
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   arena_init(&cold->string_arena, 512);
 
@@ -87,7 +87,7 @@ void test_net_close_window(void) {
 
   // Cleanup
   arena_destroy(&cold->string_arena);
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
   slotmap_destroy(&s.clients);
   free(s.conn);
 }
@@ -0,0 +1,76 @@
+/*
+ * Tests for the optional hardware counters used by perf_harness
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "perf_counters.h"
+
+static char* print_per_op(const perf_counter_sample_t* s, uint64_t ops) {
+  static char buf[512];
+  FILE* f = fmemopen(buf, sizeof(buf), "w");
+  assert(f);
+  perf_counters_print_per_op(f, s, ops);
+  fclose(f);
+  return buf;
+}
+
+static void test_per_op_format(void) {
+  perf_counter_sample_t s;
+  memset(&s, 0, sizeof(s));
+  s.value[PERF_COUNTER_CYCLES] = 3000;
+  s.valid[PERF_COUNTER_CYCLES] = true;
+  s.value[PERF_COUNTER_INSTRUCTIONS] = 6000;
+  s.valid[PERF_COUNTER_INSTRUCTIONS] = true;
+  s.value[PERF_COUNTER_L1D_MISSES] = 5;
+  s.valid[PERF_COUNTER_L1D_MISSES] = true;
+
+  assert(strcmp(print_per_op(&s, 1000),
+                " CYCLES_PER_OP 3.0000 INSTRUCTIONS_PER_OP 6.0000 L1D_MISSES_PER_OP 0.0050 LLC_MISSES_PER_OP NA BRANCH_MISSES_PER_OP NA IPC 2.000") == 0);
+
+  // Same fields when nothing could be measured
+  memset(&s, 0, sizeof(s));
+  assert(strcmp(print_per_op(&s, 1000),
+                " CYCLES_PER_OP NA INSTRUCTIONS_PER_OP NA L1D_MISSES_PER_OP NA LLC_MISSES_PER_OP NA BRANCH_MISSES_PER_OP NA IPC NA") == 0);
+
+  assert(strcmp(perf_counter_name(PERF_COUNTER_LLC_MISSES), "llc_misses") == 0);
+  assert(strcmp(perf_counter_name(PERF_COUNTER_KIND_COUNT), "?") == 0);
+  printf("test_per_op_format passed\n");
+}
+
+// Runs with or without a PMU; only events that opened may report values
+static void test_open_degrades_per_event(void) {
+  perf_counters_t pc;
+  bool any = perf_counters_open(&pc);
+
+  perf_counters_start(&pc);
+  volatile uint64_t sink = 0;
+  for (uint64_t i = 0; i < 1000000; i++)
+    sink += i * i;
+  perf_counter_sample_t s;
+  perf_counters_stop(&pc, &s);
+
+  bool any_valid = false;
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++) {
+    if (pc.fd[i] < 0)
+      assert(!s.valid[i]);
+    any_valid |= s.valid[i];
+  }
+  assert(any || !any_valid);
+  if (s.valid[PERF_COUNTER_INSTRUCTIONS])
+    assert(s.value[PERF_COUNTER_INSTRUCTIONS] >= 1000000);
+
+  perf_counters_close(&pc);
+  for (int i = 0; i < PERF_COUNTER_KIND_COUNT; i++)
+    assert(pc.fd[i] == -1);
+  printf("test_open_degrades_per_event passed (%s)\n", any ? "counters available" : "counters unavailable");
+}
+
+int main(void) {
+  test_per_op_format();
+  test_open_degrades_per_event();
+  return 0;
+}
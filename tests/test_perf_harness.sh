@@ -24,5 +24,50 @@ require_output_line '^SCENARIO focus_cycle OPS [0-9]+$'
 require_output_line '^SCENARIO stacking_ops OPS [0-9]+$'
 require_output_line '^SCENARIO move_resize OPS [0-9]+$'
 require_output_line '^SCENARIO flush_loops OPS [0-9]+$'
+require_output_line '^SCENARIO map_linear OPS [0-9]+$'
+require_output_line '^SCENARIO map_swiss OPS [0-9]+$'
+require_output_line '^SCENARIO flush_scan OPS [0-9]+$'
+require_output_line '^SCENARIO flush_worklist OPS [0-9]+$'
+require_output_line '^SCENARIO place_smart OPS [0-9]+$'
+require_output_line '^SCENARIO rules_linear OPS [0-9]+$'
+require_output_line '^SCENARIO rules_compiled OPS [0-9]+$'
+require_output_line '^SCENARIO rules_interned OPS [0-9]+$'
+require_output_line '^SCENARIO damage_idle_scan OPS [0-9]+$'
+require_output_line '^SCENARIO damage_idle_epoch OPS [0-9]+$'
+require_output_line '^SCENARIO slotmap_contiguous OPS [0-9]+$'
+require_output_line '^SCENARIO slotmap_paged OPS [0-9]+$'
+require_output_line '^SCENARIO visibility_aos OPS [0-9]+$'
+require_output_line '^SCENARIO visibility_soa OPS [0-9]+$'
+
+# Counters are NA without a PMU or perf_event access, but the fields are fixed
+output=$($runner --counters --iters 1000 --scenario focus_cycle 2>/dev/null)
+per_op='([0-9]+\.[0-9]+|NA)'
+require_output_line '^SCENARIO focus_cycle OPS [0-9]+$'
+require_output_line "^COUNTERS focus_cycle NS_PER_OP [0-9.]+ CYCLES_PER_OP $per_op INSTRUCTIONS_PER_OP $per_op L1D_MISSES_PER_OP $per_op LLC_MISSES_PER_OP $per_op BRANCH_MISSES_PER_OP $per_op IPC $per_op\$"
+
+pipeline_bin=${PERF_PIPELINE_BIN:-$repo_root/build/perf_pipeline}
+if [[ ! -x "$pipeline_bin" ]]; then
+  echo "perf pipeline binary missing: $pipeline_bin" >&2
+  exit 1
+fi
+
+output=$("$pipeline_bin" --iters 200 --clients 64)
+
+for name in manage property_storm workspace_switch interactive_resize alt_tab drag_input_sleep drag_input_busy_poll click_through; do
+  require_output_line "^SCENARIO $name OPS [1-9][0-9]* NS_PER_OP [0-9.]+ REQS_PER_OP [0-9.]+$"
+done
+
+# The PGO comparison against itself: every scenario of both harnesses shows up
+build_dir=$(dirname "$pipeline_bin")
+harness_dir=$(dirname "${PERF_HARNESS_BIN:-$build_dir/perf_harness}")
+if [[ "$harness_dir" == "$build_dir" ]]; then
+  output=$(python3 "$repo_root/scripts/pgo-compare.py" --baseline "$build_dir" --pgo "$build_dir" --runs 1 \
+    --harness-iters 1000 --pipeline-iters 50 --clients 64)
+  require_output_line '^SPEEDUP harness/focus_cycle BASELINE_NS [0-9.]+ PGO_NS [0-9.]+ RATIO [0-9.]+$'
+  require_output_line '^SPEEDUP harness/visibility_soa BASELINE_NS [0-9.]+ PGO_NS [0-9.]+ RATIO [0-9.]+$'
+  require_output_line '^SPEEDUP pipeline/manage BASELINE_NS [0-9.]+ PGO_NS [0-9.]+ RATIO [0-9.]+$'
+  require_output_line '^SPEEDUP pipeline/click_through BASELINE_NS [0-9.]+ PGO_NS [0-9.]+ RATIO [0-9.]+$'
+  require_output_line '^SPEEDUP geomean RATIO [0-9.]+$'
+fi
 
 echo "test_perf_harness passed"
@@ -0,0 +1,94 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "placement.h"
+
+static uint64_t overlap_at(int32_t x, int32_t y, uint32_t w, uint32_t h, const rect_t* obs, size_t n) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    int32_t x0 = x > obs[i].x ? x : obs[i].x;
+    int32_t y0 = y > obs[i].y ? y : obs[i].y;
+    int32_t x1 = x + (int32_t)w < obs[i].x + (int32_t)obs[i].w ? x + (int32_t)w : obs[i].x + (int32_t)obs[i].w;
+    int32_t y1 = y + (int32_t)h < obs[i].y + (int32_t)obs[i].h ? y + (int32_t)h : obs[i].y + (int32_t)obs[i].h;
+    if (x1 > x0 && y1 > y0)
+      sum += (uint64_t)(x1 - x0) * (uint64_t)(y1 - y0);
+  }
+  return sum;
+}
+
+void test_placement_free_and_pinned(void) {
+  arena_t a;
+  arena_init(&a, 4096);
+  rect_t area = {10, 20, 800, 600};
+  int32_t x, y;
+
+  assert(placement_min_overlap(&a, area, 200, 100, NULL, 0, &x, &y) == 0);
+  assert(x == 10 && y == 20);
+
+  // Larger than the area: pinned top-left, overlap still reported
+  rect_t obs[] = {{0, 0, 100, 100}};
+  assert(placement_min_overlap(&a, area, 1000, 700, obs, 1, &x, &y) == 90u * 80u);
+  assert(x == 10 && y == 20);
+
+  // Obstacles outside the area are ignored
+  rect_t far[] = {{-500, -500, 100, 100}, {2000, 2000, 50, 50}};
+  assert(placement_min_overlap(&a, area, 200, 100, far, 2, &x, &y) == 0);
+  assert(x == 10 && y == 20);
+
+  // A free slot right of a frame is found exactly
+  rect_t left[] = {{10, 20, 300, 600}};
+  assert(placement_min_overlap(&a, area, 200, 100, left, 1, &x, &y) == 0);
+  assert(x == 310 && y == 20);
+
+  arena_destroy(&a);
+  printf("test_placement_free_and_pinned passed\n");
+}
+
+void test_placement_matches_brute_force(void) {
+  arena_t a;
+  arena_init(&a, 4096);
+  srand(42);
+
+  for (int round = 0; round < 60; round++) {
+    rect_t area = {(int16_t)(rand() % 20 - 10), (int16_t)(rand() % 20 - 10), (uint16_t)(60 + rand() % 60), (uint16_t)(50 + rand() % 50)};
+    uint32_t w = 10u + (uint32_t)(rand() % 50);
+    uint32_t h = 10u + (uint32_t)(rand() % 40);
+    size_t n = 1u + (size_t)(rand() % 12);
+    rect_t obs[12];
+    for (size_t i = 0; i < n; i++)
+      obs[i] = (rect_t){(int16_t)(rand() % 140 - 20), (int16_t)(rand() % 120 - 20), (uint16_t)(1 + rand() % 60), (uint16_t)(1 + rand() % 50)};
+
+    int32_t x, y;
+    uint64_t got = placement_min_overlap(&a, area, w, h, obs, n, &x, &y);
+    assert(got == overlap_at(x, y, w, h, obs, n));
+
+    int32_t x_hi = w < area.w ? area.x + (int32_t)area.w - (int32_t)w : area.x;
+    int32_t y_hi = h < area.h ? area.y + (int32_t)area.h - (int32_t)h : area.y;
+    uint64_t best = UINT64_MAX;
+    int32_t bx = 0, by = 0;
+    for (int32_t py = area.y; py <= y_hi; py++) {
+      for (int32_t px = area.x; px <= x_hi; px++) {
+        uint64_t o = overlap_at(px, py, w, h, obs, n);
+        if (o < best) {
+          best = o;
+          bx = px;
+          by = py;
+        }
+      }
+    }
+    assert(got == best);
+    assert(x == bx && y == by);
+    arena_reset(&a);
+  }
+
+  arena_destroy(&a);
+  printf("test_placement_matches_brute_force passed\n");
+}
+
+int main(void) {
+  test_placement_free_and_pinned();
+  test_placement_matches_brute_force();
+  return 0;
+}
@@ -12,10 +12,10 @@ static void setup_server(server_t* s) {
   memset(s, 0, sizeof(*s));
   s->is_test = true;
   s->conn = xcb_connect(NULL, NULL);
-  s->workarea.x = 0;
-  s->workarea.y = 0;
-  s->workarea.w = 800;
-  s->workarea.h = 600;
+  s->screens[0].workarea.x = 0;
+  s->screens[0].workarea.y = 0;
+  s->screens[0].workarea.w = 800;
+  s->screens[0].workarea.h = 600;
   slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
 }
 
@@ -33,6 +33,8 @@ static void cleanup_server(server_t* s) {
     }
   }
   slotmap_destroy(&s->clients);
+  spatial_index_destroy(&s->screens[0].frame_index);
+  arena_destroy(&s->tick_arena);
   xcb_disconnect(s->conn);
 }
 
@@ -50,7 +52,6 @@ static handle_t add_client(server_t* s, int16_t x, int16_t y, uint16_t w, uint16
   hot->placement = PLACEMENT_DEFAULT;
   hot->desired = (rect_t){x, y, w, height};
   hot->server = hot->desired;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
   return handle;
@@ -65,10 +66,10 @@ static bool rects_intersect(const rect_t* a, const rect_t* b) {
 }
 
 static bool rect_intersects_any_monitor(const server_t* s, const rect_t* r) {
-  if (!s || !s->monitors || s->monitor_count == 0)
+  if (!s || !s->screens[0].monitors || s->screens[0].monitor_count == 0)
     return false;
-  for (uint32_t i = 0; i < s->monitor_count; i++) {
-    if (rects_intersect(r, &s->monitors[i].geom))
+  for (uint32_t i = 0; i < s->screens[0].monitor_count; i++) {
+    if (rects_intersect(r, &s->screens[0].monitors[i].geom))
       return true;
   }
   return false;
@@ -132,7 +133,7 @@ static void test_position_intersects_workarea_after_place(void) {
 
   wm_place_window(&s, h);
 
-  rect_t wa = s.workarea;
+  rect_t wa = s.screens[0].workarea;
   assert(rects_intersect(&hot->desired, &wa));
 
   printf("test_position_intersects_workarea_after_place passed\n");
@@ -148,7 +149,7 @@ static void test_position_intersects_workarea_after_place_far_positive(void) {
 
   wm_place_window(&s, h);
 
-  rect_t wa = s.workarea;
+  rect_t wa = s.screens[0].workarea;
   assert(rects_intersect(&hot->desired, &wa));
 
   printf("test_position_intersects_workarea_after_place_far_positive passed\n");
@@ -159,15 +160,15 @@ static void test_position_intersects_monitor_multihead(void) {
   server_t s;
   setup_server(&s);
 
-  s.monitor_count = 2;
-  s.monitors = calloc(2, sizeof(monitor_t));
-  assert(s.monitors != NULL);
+  s.screens[0].monitor_count = 2;
+  s.screens[0].monitors = calloc(2, sizeof(monitor_t));
+  assert(s.screens[0].monitors != NULL);
 
-  s.monitors[0].geom = (rect_t){0, 0, 800, 600};
-  s.monitors[1].geom = (rect_t){800, 0, 800, 600};
+  s.screens[0].monitors[0].geom = (rect_t){0, 0, 800, 600};
+  s.screens[0].monitors[1].geom = (rect_t){800, 0, 800, 600};
 
   // Use a workarea that spans both monitors to simulate union placement.
-  s.workarea = (rect_t){0, 0, 1600, 600};
+  s.screens[0].workarea = (rect_t){0, 0, 1600, 600};
 
   handle_t h = add_client(&s, 20000, 20000, 200, 200);
   client_hot_t* hot = server_chot(&s, h);
@@ -177,9 +178,79 @@ static void test_position_intersects_monitor_multihead(void) {
   assert(rect_intersects_any_monitor(&s, &hot->desired));
 
   printf("test_position_intersects_monitor_multihead passed\n");
-  free(s.monitors);
-  s.monitors = NULL;
-  s.monitor_count = 0;
+  free(s.screens[0].monitors);
+  s.screens[0].monitors = NULL;
+  s.screens[0].monitor_count = 0;
+  cleanup_server(&s);
+}
+
+static handle_t add_mapped_frame(server_t* s, rect_t frame) {
+  handle_t h = add_client(s, frame.x, frame.y, frame.w, frame.h);
+  client_hot_t* hot = server_chot(s, h);
+  hot->state = STATE_MAPPED;
+  spatial_index_update(&s->screens[0].frame_index, h, frame);
+  return h;
+}
+
+static void setup_single_monitor(server_t* s) {
+  s->screens[0].monitor_count = 1;
+  s->screens[0].monitors = calloc(1, sizeof(monitor_t));
+  assert(s->screens[0].monitors != NULL);
+  s->screens[0].monitors[0].geom = s->screens[0].workarea;
+  s->screens[0].monitors[0].workarea = s->screens[0].workarea;
+}
+
+static void test_smart_placement_avoids_frames(void) {
+  server_t s;
+  setup_server(&s);
+  setup_single_monitor(&s);
+
+  add_mapped_frame(&s, (rect_t){0, 0, 400, 600});
+  add_mapped_frame(&s, (rect_t){400, 0, 400, 250});
+
+  handle_t h = add_client(&s, 0, 0, 300, 200);
+  client_hot_t* hot = server_chot(&s, h);
+  hot->placement = PLACEMENT_SMART;
+  wm_place_window(&s, h);
+  assert(hot->desired.x == 400);
+  assert(hot->desired.y == 250);
+
+  // No free slot: least overlap wins, and the frame stays in the workarea
+  handle_t big = add_client(&s, 0, 0, 500, 500);
+  client_hot_t* bhot = server_chot(&s, big);
+  bhot->placement = PLACEMENT_SMART;
+  wm_place_window(&s, big);
+  assert(bhot->desired.x == 300);
+  assert(bhot->desired.y >= 0 && bhot->desired.y + bhot->desired.h <= 600);
+
+  printf("test_smart_placement_avoids_frames passed\n");
+  free(s.screens[0].monitors);
+  cleanup_server(&s);
+}
+
+static void test_smart_placement_global_default(void) {
+  server_t s;
+  setup_server(&s);
+  setup_single_monitor(&s);
+  s.config.placement = PLACEMENT_SMART;
+
+  add_mapped_frame(&s, (rect_t){0, 0, 400, 300});
+
+  handle_t h = add_client(&s, 0, 0, 300, 200);
+  client_hot_t* hot = server_chot(&s, h);
+  wm_place_window(&s, h);
+  assert(hot->desired.x == 400);
+  assert(hot->desired.y == 0);
+
+  // Program-specified positions still win over the global policy
+  handle_t us = add_client(&s, 10, 20, 300, 200);
+  server_ccold(&s, us)->hints_flags = XCB_ICCCM_SIZE_HINT_US_POSITION;
+  wm_place_window(&s, us);
+  assert(server_chot(&s, us)->desired.x == 10);
+  assert(server_chot(&s, us)->desired.y == 20);
+
+  printf("test_smart_placement_global_default passed\n");
+  free(s.screens[0].monitors);
   cleanup_server(&s);
 }
 
@@ -190,5 +261,7 @@ int main(void) {
   test_position_intersects_workarea_after_place();
   test_position_intersects_workarea_after_place_far_positive();
   test_position_intersects_monitor_multihead();
+  test_smart_placement_avoids_frames();
+  test_smart_placement_global_default();
   return 0;
 }
@@ -0,0 +1,204 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "client.h"
+#include "event.h"
+#include "prewarm.h"
+#include "render.h"
+#include "wm.h"
+#include "xcb_utils.h"
+
+extern void xcb_stubs_reset(void);
+extern bool xcb_stubs_enqueue_event(xcb_generic_event_t* ev);
+
+#define IDLE_MS 100u
+#define MS 1000000ull
+
+static void setup_server(server_t* s) {
+  memset(s, 0, sizeof(server_t));
+  s->is_test = true;
+
+  xcb_stubs_reset();
+  s->conn = xcb_connect(NULL, NULL);
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
+  slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
+  handle_vec_init(&s->active_clients);
+  title_cache_init(&s->title_cache);
+  s->screens[0].desktop_count = 4;
+  s->screens[0].current_desktop = 0;
+  s->config.theme.border_width = 2;
+  s->config.theme.title_height = 20;
+  s->config.frame_backing = true;
+  s->config.prewarm_idle_ms = IDLE_MS;
+}
+
+static void teardown_server(server_t* s) {
+  uint32_t idx;
+  slotmap_for_each_live(&s->clients, idx) {
+    client_cold_t* cold = slotmap_cold_at(&s->clients, idx);
+    client_frame_backing_destroy(s->conn, cold);
+    client_render_payload_destroy(cold);
+  }
+  wm_desktop_members_destroy(s);
+  handle_vec_destroy(&s->active_clients);
+  title_cache_destroy(&s->title_cache);
+  slotmap_destroy(&s->clients);
+  free(s->prefetched_event);
+  xcb_disconnect(s->conn);
+}
+
+static client_cold_t* add_client(server_t* s, xcb_window_t xid, uint8_t state, int32_t desktop) {
+  void* hot_ptr = NULL;
+  void* cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s->clients, &hot_ptr, &cold_ptr);
+  assert(h != HANDLE_INVALID);
+  client_hot_t* hot = hot_ptr;
+  client_cold_t* cold = cold_ptr;
+  hot->self = h;
+  hot->xid = xid;
+  hot->frame = xid + 1u;
+  hot->state = state;
+  hot->desktop = desktop;
+  hot->server.w = 200;
+  hot->server.h = 100;
+  client_render_payload_init(cold);
+  handle_vec_push(&s->active_clients, h);
+  return cold;
+}
+
+// Ticks without input from t until the pass is over; returns the slices run
+static int run_idle(server_t* s, uint64_t t) {
+  int slices = 0;
+  s->buckets.ingested = 0;
+  while (s->prewarm.pending) {
+    uint64_t before = s->prewarm.painted;
+    if (prewarm_tick(s, t))
+      slices++;
+    assert(s->prewarm.painted - before <= PREWARM_SLICE_CLIENTS);
+    t += MS;
+  }
+  return slices;
+}
+
+static void test_prewarm_paints_neighbours_when_idle(void) {
+  server_t s;
+  setup_server(&s);
+
+  client_cold_t* shown = add_client(&s, 0x100, STATE_MAPPED, 0);
+  client_cold_t* next[5];
+  for (int i = 0; i < 5; i++)
+    next[i] = add_client(&s, 0x200u + (xcb_window_t)i * 0x10u, STATE_MAPPED, 1);
+  client_cold_t* iconic = add_client(&s, 0x300, STATE_UNMAPPED, 1);
+  client_cold_t* far = add_client(&s, 0x400, STATE_MAPPED, 2);
+  client_cold_t* prev = add_client(&s, 0x500, STATE_MAPPED, 3);
+
+  // Input restarts the wait; nothing is painted before it is over
+  uint64_t t = 1000 * MS;
+  s.buckets.ingested = 1;
+  assert(!prewarm_tick(&s, t));
+  assert(s.prewarm.pending);
+  s.buckets.ingested = 0;
+  assert(!prewarm_tick(&s, t + (IDLE_MS - 1) * MS));
+  assert(s.prewarm.painted == 0);
+
+  int slices = run_idle(&s, t + IDLE_MS * MS);
+  assert(slices >= 2);
+  assert(s.prewarm.painted == 6);
+  for (int i = 0; i < 5; i++)
+    assert(next[i]->frame_pixmap != XCB_NONE);
+  assert(prev->frame_pixmap != XCB_NONE);
+  assert(shown->frame_pixmap == XCB_NONE);
+  assert(iconic->frame_pixmap == XCB_NONE);
+  assert(far->frame_pixmap == XCB_NONE);
+
+  // One pass per idle period: the next idle tick does nothing
+  assert(!prewarm_tick(&s, t + 2000 * MS));
+  assert(s.prewarm.painted == 6);
+
+  // From desktop 3 both 0, also the one just left, and 2 are neighbours
+  s.screens[0].current_desktop = 3;
+  assert(!prewarm_tick(&s, t + 3000 * MS));
+  run_idle(&s, t + 3000 * MS + IDLE_MS * MS);
+  assert(shown->frame_pixmap != XCB_NONE);
+  assert(far->frame_pixmap != XCB_NONE);
+  assert(s.prewarm.painted == 8);
+  assert(s.prewarm.recent_len == 1 && s.prewarm.recent[0] == 0);
+
+  client_hot_t* shown_hot = server_chot(&s, s.active_clients.items[0]);
+  client_hot_t* iconic_hot = server_chot(&s, s.active_clients.items[6]);
+  assert(prewarm_keeps(&s, shown_hot));
+  assert(!prewarm_keeps(&s, iconic_hot));
+
+  teardown_server(&s);
+  printf("test_prewarm_paints_neighbours_when_idle passed\n");
+}
+
+static void test_prewarm_yields_to_input(void) {
+  server_t s;
+  setup_server(&s);
+  client_cold_t* a = add_client(&s, 0x100, STATE_MAPPED, 1);
+
+  uint64_t t = 1000 * MS;
+  s.buckets.ingested = 1;
+  prewarm_tick(&s, t);
+
+  // An event waiting on the socket ends the slice before anything is painted
+  xcb_generic_event_t* ev = calloc(1, sizeof(xcb_generic_event_t));
+  ev->response_type = XCB_KEY_PRESS;
+  assert(xcb_stubs_enqueue_event(ev));
+  s.buckets.ingested = 0;
+  assert(!prewarm_tick(&s, t + IDLE_MS * MS));
+  assert(s.prewarm.yields == 1);
+  assert(s.prefetched_event == ev);
+  assert(a->frame_pixmap == XCB_NONE);
+  assert(s.prewarm.pending);
+
+  // The tick that takes it waits again
+  free(s.prefetched_event);
+  s.prefetched_event = NULL;
+  s.buckets.ingested = 1;
+  assert(!prewarm_tick(&s, t + 200 * MS));
+  run_idle(&s, t + 200 * MS + IDLE_MS * MS);
+  assert(a->frame_pixmap != XCB_NONE);
+
+  teardown_server(&s);
+  printf("test_prewarm_yields_to_input passed\n");
+}
+
+static void test_prewarm_respects_budget(void) {
+  server_t s;
+  setup_server(&s);
+  client_cold_t* a = add_client(&s, 0x100, STATE_MAPPED, 1);
+
+  // Already at the eviction target: painting would only be evicted again
+  s.config.memory_budget_mb = 1;
+  s.mem_budget.last.total = (1u << 20) / 100u * MEM_BUDGET_LOW_WATER;
+
+  uint64_t t = 1000 * MS;
+  s.buckets.ingested = 1;
+  prewarm_tick(&s, t);
+  run_idle(&s, t + IDLE_MS * MS);
+  assert(a->frame_pixmap == XCB_NONE);
+  assert(s.prewarm.budget_stops == 1);
+  assert(!s.prewarm.pending);
+
+  // Off: nothing waits and nothing is kept from render_idle_release_s
+  s.config.prewarm_idle_ms = 0;
+  s.buckets.ingested = 1;
+  assert(!prewarm_tick(&s, t + 2000 * MS));
+  assert(!s.prewarm.pending);
+  assert(!prewarm_keeps(&s, server_chot(&s, s.active_clients.items[0])));
+
+  teardown_server(&s);
+  printf("test_prewarm_respects_budget passed\n");
+}
+
+int main(void) {
+  test_prewarm_paints_neighbours_when_idle();
+  test_prewarm_yields_to_input();
+  test_prewarm_respects_budget();
+  return 0;
+}
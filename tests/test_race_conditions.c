@@ -20,16 +20,14 @@ static void setup_server(server_t* s) {
   s->is_test = true;
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
-  s->root = 1;
-  s->root_visual = 1;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
-  list_init(&s->focus_history);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+  s->screens[0].root = 1;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
+  hash_map_init(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
-  small_vec_init(&s->active_clients);
+    handle_vec_init(&s->screens[0].layers[i]);
+  handle_vec_init(&s->active_clients);
   cookie_jar_init(&s->cookie_jar);
   slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
 }
@@ -47,11 +45,11 @@ static void cleanup_server(server_t* s) {
       }
     }
   }
-  small_vec_destroy(&s->active_clients);
+  handle_vec_destroy(&s->active_clients);
   cookie_jar_destroy(&s->cookie_jar);
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  hash_map_destroy(&s->xid_index);
   xcb_disconnect(s->conn);
 }
 
@@ -142,7 +140,6 @@ static void test_state_toggle_stability(void) {
   hot->state = STATE_MAPPED;
   hot->layer = LAYER_NORMAL;
   hot->base_layer = LAYER_NORMAL;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
@@ -179,7 +176,6 @@ static void test_out_of_order_reply_ignored(void) {
   hot->base_layer = LAYER_NORMAL;
   hot->stacking_index = -1;
   hot->stacking_layer = -1;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
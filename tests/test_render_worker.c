@@ -0,0 +1,114 @@
+#include <assert.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "render.h"
+#include "render_worker.h"
+
+static void wait_done(render_worker_t* w) {
+  struct pollfd p = {.fd = w->notify_fd, .events = POLLIN};
+  assert(poll(&p, 1, 5000) == 1);
+}
+
+static void paint(xcb_connection_t* conn, render_context_t* ctx, config_t* cfg, title_cache_t* titles, const char* title) {
+  render_frame(conn, 1, NULL, ctx, 24, true, title, true, 300, 40, &cfg->theme, NULL, titles, NULL, NULL);
+}
+
+void test_render_worker_shapes_off_thread(void) {
+  xcb_connection_t* conn = xcb_connect(NULL, NULL);
+  config_t cfg;
+  config_init_defaults(&cfg);
+  title_cache_t titles;
+  title_cache_init(&titles);
+  render_worker_t w;
+  assert(render_worker_start(&w));
+  titles.worker = &w;
+
+  render_context_t a, b;
+  render_init(&a);
+  render_init(&b);
+
+  // A miss is queued, not shaped inline; nothing to show yet
+  paint(conn, &a, &cfg, &titles, "日本語 terminal");
+  assert(a.title_pending);
+  assert(a.title_surface == NULL);
+  assert(render_worker_inflight(&w) == 1);
+
+  // Repaints while waiting do not queue it again
+  paint(conn, &a, &cfg, &titles, "日本語 terminal");
+  paint(conn, &b, &cfg, &titles, "日本語 terminal");
+  assert(render_worker_inflight(&w) == 1);
+  assert(title_cache_size(&titles) == 0);
+
+  wait_done(&w);
+  assert(render_worker_collect(&w, &titles) == 1);
+  assert(render_worker_inflight(&w) == 0);
+  assert(title_cache_size(&titles) == 1);
+
+  // Both contexts now pick up the shared run
+  paint(conn, &a, &cfg, &titles, "日本語 terminal");
+  paint(conn, &b, &cfg, &titles, "日本語 terminal");
+  assert(!a.title_pending && !b.title_pending);
+  assert(a.title_surface && a.title_surface == b.title_surface);
+
+  // A retitle keeps the old run on screen until the new one lands
+  cairo_surface_t* old = a.title_surface;
+  paint(conn, &a, &cfg, &titles, "vim");
+  assert(a.title_pending);
+  assert(a.title_surface == old);
+  wait_done(&w);
+  assert(render_worker_collect(&w, &titles) == 1);
+  paint(conn, &a, &cfg, &titles, "vim");
+  assert(!a.title_pending);
+  assert(a.title_surface != old);
+  assert(title_cache_size(&titles) == 2);
+
+  render_free(&a);
+  render_free(&b);
+  titles.worker = NULL;
+  render_worker_stop(&w);
+  title_cache_destroy(&titles);
+  config_destroy(&cfg);
+  xcb_disconnect(conn);
+  printf("test_render_worker_shapes_off_thread passed\n");
+}
+
+void test_render_worker_stop_drops_queued(void) {
+  title_cache_t titles;
+  title_cache_init(&titles);
+  render_worker_t w;
+  memset(&w, 0, sizeof(w));
+
+  // Not running: requests and collects are no-ops
+  title_key_t k = {"Sans Bold 10", "idle", 64, 20, 0xFFFFFFFF};
+  render_worker_request(&w, &titles, &k);
+  assert(render_worker_inflight(&w) == 0);
+  assert(render_worker_collect(&w, &titles) == 0);
+  render_worker_stop(&w);
+
+  assert(render_worker_start(&w));
+  char text[32];
+  for (int i = 0; i < 16; i++) {
+    snprintf(text, sizeof(text), "title %d", i);
+    k.text = text;
+    render_worker_request(&w, &titles, &k);
+  }
+  assert(render_worker_inflight(&w) == 16);
+
+  // Whatever was not collected is released with the worker
+  render_worker_stop(&w);
+  assert(!w.running);
+  assert(w.notify_fd == -1);
+  assert(title_cache_size(&titles) == 0);
+
+  title_cache_destroy(&titles);
+  printf("test_render_worker_stop_drops_queued passed\n");
+}
+
+int main(void) {
+  test_render_worker_shapes_off_thread();
+  test_render_worker_stop_drops_queued();
+  return 0;
+}
@@ -17,19 +17,18 @@ void test_resize_logic(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);  // Mock connection for grabbing
-  s.root = 1;
+  s.screens[0].root = 1;
 
   // Init config
   s.config.theme.border_width = 5;
   s.config.theme.title_height = 20;
 
   // Init list heads
-  list_init(&s.focus_history);
   for (int i = 0; i < LAYER_COUNT; i++) {
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
   }
 
   // Init slotmap
@@ -69,7 +68,6 @@ void test_resize_logic(void) {
   hot->stacking_layer = -1;
   list_init(&hot->transient_sibling);
   list_init(&hot->transients_head);
-  list_init(&hot->focus_node);
 
   // Add to layer (stack_raise expects it to be in a list or will insert it)
   // Actually stack_raise checks if it's connected.
@@ -78,8 +76,8 @@ void test_resize_logic(void) {
   stack_raise(&s, h);
 
   // Init frame map
-  hash_map_init(&s.frame_to_client);
-  hash_map_insert(&s.frame_to_client, 999, handle_to_ptr(h));
+  hash_map_init(&s.xid_index);
+  server_xid_bind(&s, 999, XID_FRAME, h);
 
   // ==========================================
   // Test 0: Hit testing via wm_handle_button_press
@@ -219,7 +217,7 @@ void test_resize_logic(void) {
       }
     }
   }
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   cookie_jar_destroy(&s.cookie_jar);
   slotmap_destroy(&s.clients);
   free(s.conn);
@@ -16,10 +16,10 @@ void test_resize_handle_logic(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);  // Mock connection
-  s.root = 1;
+  s.screens[0].root = 1;
 
   // Init config
   config_init_defaults(&s.config);
@@ -28,9 +28,8 @@ void test_resize_handle_logic(void) {
   s.config.theme.handle_height = 6;
 
   // Init list heads
-  list_init(&s.focus_history);
   for (int i = 0; i < LAYER_COUNT; i++) {
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
   }
 
   // Init slotmap
@@ -60,13 +59,12 @@ void test_resize_handle_logic(void) {
 
   list_init(&hot->transient_sibling);
   list_init(&hot->transients_head);
-  list_init(&hot->focus_node);
 
   hot->layer = LAYER_NORMAL;
   stack_raise(&s, h);
 
-  hash_map_init(&s.frame_to_client);
-  hash_map_insert(&s.frame_to_client, 999, handle_to_ptr(h));
+  hash_map_init(&s.xid_index);
+  server_xid_bind(&s, 999, XID_FRAME, h);
 
   xcb_button_press_event_t bev;
   memset(&bev, 0, sizeof(bev));
@@ -124,7 +122,7 @@ void test_resize_handle_logic(void) {
 
   // Cleanup
   config_destroy(&s.config);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   cookie_jar_destroy(&s.cookie_jar);
 
   // Proper cleanup of client
@@ -132,7 +130,7 @@ void test_resize_handle_logic(void) {
   slotmap_destroy(&s.clients);
 
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s.layers[i]);
+    handle_vec_destroy(&s.screens[0].layers[i]);
 
   free(s.conn);
 }
@@ -6,30 +6,30 @@
 #include "client.h"
 #include "config.h"
 #include "event.h"
+#include "rules.h"
+#include "str_intern.h"
 #include "wm.h"
 #include "xcb_utils.h"
 
 void setup_server(server_t* s) {
   memset(s, 0, sizeof(server_t));
   s->is_test = true;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(NULL, 0);
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s->conn = xcb_connect(NULL, NULL);
   s->keysyms = xcb_key_symbols_alloc(s->conn);
   slotmap_init(&s->clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  s->desktop_count = 4;
-  s->current_desktop = 0;
-  list_init(&s->focus_history);
+  s->screens[0].desktop_count = 4;
+  s->screens[0].current_desktop = 0;
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+    handle_vec_init(&s->screens[0].layers[i]);
+  hash_map_init(&s->xid_index);
   config_init_defaults(&s->config);
 
-  s->workarea.x = 0;
-  s->workarea.y = 0;
-  s->workarea.w = 1920;
-  s->workarea.h = 1080;
+  s->screens[0].workarea.x = 0;
+  s->screens[0].workarea.y = 0;
+  s->screens[0].workarea.w = 1920;
+  s->screens[0].workarea.h = 1080;
 }
 
 void test_rules_matching(void) {
@@ -64,14 +64,13 @@ void test_rules_matching(void) {
   hot->placement = PLACEMENT_DEFAULT;
   hot->desired.w = 400;
   hot->desired.h = 300;
-  list_init(&hot->focus_node);
   hot->stacking_index = -1;
   hot->stacking_layer = -1;
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  cold->wm_class = strdup("XTerm");
-  cold->wm_instance = strdup("xterm");
+  cold->wm_class = str_intern("XTerm");
+  cold->wm_instance = str_intern("xterm");
 
   // We need to call client_finish_manage, but it does a lot of X calls.
   // Actually, client_finish_manage calls client_apply_rules.
@@ -93,19 +92,232 @@ void test_rules_matching(void) {
 
   printf("test_rules_matching passed\n");
 
-  // Cleanup
-  free(cold->wm_class);
-  free(cold->wm_instance);
+  // Cleanup; unmanage drops the interned names
   client_unmanage(&s, h);
   config_destroy(&s.config);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
+  xcb_key_symbols_free(s.keysyms);
+  xcb_disconnect(s.conn);
+}
+
+static app_rule_t* make_rule(const char* cls, const char* inst, const char* title, int32_t type, int8_t transient) {
+  app_rule_t* r = calloc(1, sizeof(*r));
+  r->class_match = cls ? strdup(cls) : NULL;
+  r->instance_match = inst ? strdup(inst) : NULL;
+  r->title_match = title ? strdup(title) : NULL;
+  r->type_match = type;
+  r->transient_match = transient;
+  r->desktop = -2;
+  r->layer = -1;
+  r->focus = -1;
+  r->bypass_compositor = -1;
+  return r;
+}
+
+static void free_rules(small_vec_t* rules) {
+  for (size_t i = 0; i < rules->length; i++) {
+    app_rule_t* r = rules->items[i];
+    free(r->class_match);
+    free(r->instance_match);
+    free(r->title_match);
+    free(r);
+  }
+  small_vec_destroy(rules);
+}
+
+// The compiled set must agree with testing every rule in order
+static void expect_same_as_linear(rule_set_t* set, const small_vec_t* rules, const rule_subject_t* subj) {
+  const uint32_t* hits = NULL;
+  size_t n = rule_set_match(set, subj, &hits);
+  size_t j = 0;
+  for (size_t i = 0; i < rules->length; i++) {
+    if (!rule_matches(rules->items[i], subj))
+      continue;
+    assert(j < n);
+    assert(hits[j] == i);
+    j++;
+  }
+  assert(j == n);
+}
+
+void test_rule_set_matches_in_config_order(void) {
+  small_vec_t rules;
+  small_vec_init(&rules);
+  small_vec_push(&rules, make_rule(NULL, NULL, "Mozilla", -1, -1));                  // 0
+  small_vec_push(&rules, make_rule("Firefox", NULL, NULL, -1, -1));                  // 1
+  small_vec_push(&rules, make_rule(NULL, "navigator", NULL, -1, -1));                // 2
+  small_vec_push(&rules, make_rule(NULL, NULL, NULL, WINDOW_TYPE_DIALOG, -1));       // 3
+  small_vec_push(&rules, make_rule("Firefox", NULL, "Private", -1, -1));             // 4
+  small_vec_push(&rules, make_rule(NULL, NULL, "zilla", -1, 1));                     // 5
+  small_vec_push(&rules, make_rule(NULL, NULL, "illa Fire", -1, -1));                // 6
+  small_vec_push(&rules, make_rule(NULL, NULL, "", -1, -1));                         // 7
+  small_vec_push(&rules, make_rule("XTerm", "xterm", NULL, WINDOW_TYPE_NORMAL, 0));  // 8
+
+  rule_set_t set;
+  rule_set_init(&set);
+  rule_set_build(&set, &rules);
+  assert(set.class_count == 3);
+  assert(set.instance_count == 1);
+  assert(set.always_count == 2);
+
+  const uint32_t* hits = NULL;
+  rule_subject_t ff = {"Firefox", "navigator", "Private - Mozilla Firefox", WINDOW_TYPE_NORMAL, false, false};
+  assert(rule_set_match(&set, &ff, &hits) == 6);
+  uint32_t want[] = {0, 1, 2, 4, 6, 7};
+  assert(memcmp(hits, want, sizeof(want)) == 0);
+  expect_same_as_linear(&set, &rules, &ff);
+
+  // Overlapping title patterns, a transient dialog, and missing strings
+  rule_subject_t dlg = {"Firefox", NULL, "Mozilla", WINDOW_TYPE_DIALOG, true, false};
+  expect_same_as_linear(&set, &rules, &dlg);
+  assert(rule_set_match(&set, &dlg, &hits) == 5);
+  rule_subject_t bare = {NULL, NULL, NULL, WINDOW_TYPE_NORMAL, false, false};
+  assert(rule_set_match(&set, &bare, &hits) == 0);
+  rule_subject_t xterm = {"XTerm", "xterm", "bash", WINDOW_TYPE_NORMAL, false, false};
+  assert(rule_set_match(&set, &xterm, &hits) == 2);
+  assert(hits[0] == 7 && hits[1] == 8);
+  xterm.transient = true;
+  assert(rule_set_match(&set, &xterm, &hits) == 1);
+
+  // A changed rule list is picked up by sync, an unchanged one is kept
+  rule_key_t* before = set.by_class;
+  rule_set_sync(&set, &rules);
+  assert(set.by_class == before);
+  small_vec_push(&rules, make_rule("bash", NULL, NULL, -1, -1));
+  rule_set_sync(&set, &rules);
+  assert(set.count == rules.length);
+  xterm.wm_class = "bash";
+  expect_same_as_linear(&set, &rules, &xterm);
+
+  rule_set_destroy(&set);
+  free_rules(&rules);
+  printf("test_rule_set_matches_in_config_order passed\n");
+}
+
+void test_rule_set_agrees_with_linear_scan(void) {
+  static const char* words[] = {"term", "fox", "ox", "Steam", "team", "a", "mpv", "Gimp", "gimp-2.10", "The"};
+  const size_t nwords = sizeof(words) / sizeof(words[0]);
+  small_vec_t rules;
+  small_vec_init(&rules);
+  uint32_t seed = 12345u;
+  for (int i = 0; i < 400; i++) {
+    uint32_t v[5];
+    for (int k = 0; k < 5; k++) {
+      seed = seed * 1664525u + 1013904223u;
+      v[k] = seed >> 8;
+    }
+    const char* cls = (v[0] % 3 == 0) ? words[v[0] % nwords] : NULL;
+    const char* inst = (v[1] % 4 == 0) ? words[v[1] % nwords] : NULL;
+    const char* title = (v[2] % 2 == 0) ? words[v[2] % nwords] : NULL;
+    int32_t type = (v[3] % 5 == 0) ? (int32_t)(v[3] % WINDOW_TYPE_COUNT) : -1;
+    int8_t transient = (v[4] % 3 == 0) ? (int8_t)(v[4] & 1u) : -1;
+    small_vec_push(&rules, make_rule(cls, inst, title, type, transient));
+  }
+
+  rule_set_t set;
+  rule_set_init(&set);
+  rule_set_build(&set, &rules);
+
+  static const char* titles[] = {"Steam - The Gimp", "xterm", "firefox", "proxy team", "", "aaaa"};
+  for (size_t c = 0; c < nwords; c++) {
+    for (size_t t = 0; t < sizeof(titles) / sizeof(titles[0]); t++) {
+      for (uint8_t type = 0; type < WINDOW_TYPE_COUNT; type += 3) {
+        rule_subject_t subj = {words[c], words[(c + t) % nwords], titles[t], type, (c + t) & 1u, false};
+        expect_same_as_linear(&set, &rules, &subj);
+      }
+    }
+  }
+
+  rule_set_destroy(&set);
+  free_rules(&rules);
+  printf("test_rule_set_agrees_with_linear_scan passed\n");
+}
+
+void test_live_rules_follow_late_title(void) {
+  server_t s;
+  setup_server(&s);
+  arena_init(&s.tick_arena, 4096);
+
+  app_rule_t* live = make_rule(NULL, NULL, "Steam", -1, -1);
+  live->live = true;
+  live->desktop = 3;
+  live->layer = LAYER_ABOVE;
+  app_rule_t* once = make_rule(NULL, NULL, "Steam", -1, -1);
+  once->focus = 0;
+  small_vec_push(&s.config.rules, live);
+  small_vec_push(&s.config.rules, once);
+
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = (client_hot_t*)hot_ptr;
+  client_cold_t* cold = (client_cold_t*)cold_ptr;
+  client_render_payload_init(cold);
+  arena_init(&cold->string_arena, 128);
+  hot->self = h;
+  hot->xid = 102;
+  hot->type = WINDOW_TYPE_NORMAL;
+  hot->layer = LAYER_NORMAL;
+  hot->base_layer = LAYER_NORMAL;
+  hot->focus_override = -1;
+  hot->desired = (rect_t){0, 0, 400, 300};
+  hot->stacking_index = -1;
+  hot->stacking_layer = -1;
+  list_init(&hot->transients_head);
+  list_init(&hot->transient_sibling);
+  cold->base_title = arena_strdup(&cold->string_arena, "loading");
+  cold->title = cold->base_title;
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
+
+  client_finish_manage(&s, h);
+  assert(hot->desktop == 0);
+  assert(s.config.rule_set.live_count == 1);
+  assert(s.config.rule_set.live_deps == RULE_DEP_TITLE);
+
+  // The title arrives late: only the live rule applies
+  cold->base_title = arena_strdup(&cold->string_arena, "Steam");
+  wm_client_refresh_title(&s, h);
+  assert(hot->desktop == 3);
+  assert(hot->base_layer == LAYER_ABOVE);
+  assert(hot->focus_override == -1);
+
+  // Still matching after another retitle: a rule fires on the edge, so the
+  // user's later move is kept
+  wm_client_move_to_workspace(&s, h, 1, false);
+  cold->base_title = arena_strdup(&cold->string_arena, "Steam - Store");
+  wm_client_refresh_title(&s, h);
+  assert(hot->desktop == 1);
+
+  // Matching again after a non-matching title re-applies it
+  cold->base_title = arena_strdup(&cold->string_arena, "Library");
+  wm_client_refresh_title(&s, h);
+  cold->base_title = arena_strdup(&cold->string_arena, "Steam");
+  wm_client_refresh_title(&s, h);
+  assert(hot->desktop == 3);
+
+  // Class changes are not title changes
+  rule_subject_t before = client_rule_subject(hot, cold);
+  wm_client_move_to_workspace(&s, h, 0, false);
+  client_rules_changed(&s, h, RULE_DEP_CLASS, &before);
+  assert(hot->desktop == 0);
+
+  printf("test_live_rules_follow_late_title passed\n");
+
+  client_unmanage(&s, h);
+  config_destroy(&s.config);
+  arena_destroy(&s.tick_arena);
+  focus_mru_destroy(&s.focus_mru);
+  slotmap_destroy(&s.clients);
+  hash_map_destroy(&s.xid_index);
   xcb_key_symbols_free(s.keysyms);
   xcb_disconnect(s.conn);
 }
 
 int main(void) {
   test_rules_matching();
+  test_rule_set_matches_in_config_order();
+  test_rule_set_agrees_with_linear_scan();
+  test_live_rules_follow_late_title();
   return 0;
 }
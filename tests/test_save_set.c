@@ -23,16 +23,14 @@ static void setup_server(server_t* s) {
   xcb_stubs_reset();
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
-  s->root = 1;
-  s->root_depth = 24;
-  s->root_visual = 1;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
-
-  list_init(&s->focus_history);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+  s->screens[0].root = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
+
+  hash_map_init(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
   slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
 }
 
@@ -49,11 +47,11 @@ static void cleanup_server(server_t* s) {
       }
     }
   }
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  hash_map_destroy(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
   xcb_disconnect(s->conn);
 }
 
@@ -75,16 +73,15 @@ static handle_t add_client(server_t* s, xcb_window_t xid, xcb_window_t frame) {
   hot->layer = LAYER_NORMAL;
   hot->base_layer = LAYER_NORMAL;
   hot->desired = (rect_t){0, 0, 100, 80};
-  cold->visual_id = s->root_visual;
-  cold->depth = s->root_depth;
+  cold->visual_id = s->screens[0].root_visual;
+  cold->depth = s->screens[0].root_depth;
   hot->stacking_index = -1;
   hot->stacking_layer = -1;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s->window_to_client, xid, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, frame, handle_to_ptr(h));
+  server_xid_bind(s, xid, XID_CLIENT, h);
+  server_xid_bind(s, frame, XID_FRAME, h);
   return h;
 }
 
@@ -147,14 +144,14 @@ static void test_unmanage_reparent_uses_desired_when_geom_dirty(void) {
   hot->server.y = 15;
   hot->desired.x = 110;
   hot->desired.y = 215;
-  hot->dirty |= DIRTY_GEOM;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
 
   xcb_stubs_reset();
   client_unmanage(&s, h);
 
   assert(stub_reparent_window_count == 1);
   assert(stub_last_reparent_window == 2003);
-  assert(stub_last_reparent_parent == s.root);
+  assert(stub_last_reparent_parent == s.screens[0].root);
   assert(stub_last_reparent_x == 112);
   assert(stub_last_reparent_y == 235);
 
@@ -179,14 +176,14 @@ static void test_unmanage_reparent_gtk_desired_conversion(void) {
   cold->gtk_frame_extents_set = true;
   cold->gtk_extents.left = 7;
   cold->gtk_extents.top = 9;
-  hot->dirty |= DIRTY_GEOM;
+  server_mark_dirty(&s, hot, DIRTY_GEOM);
 
   xcb_stubs_reset();
   client_unmanage(&s, h);
 
   assert(stub_reparent_window_count == 1);
   assert(stub_last_reparent_window == 2004);
-  assert(stub_last_reparent_parent == s.root);
+  assert(stub_last_reparent_parent == s.screens[0].root);
   assert(stub_last_reparent_x == 300);
   assert(stub_last_reparent_y == 400);
 
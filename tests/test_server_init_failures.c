@@ -39,10 +39,10 @@ void __wrap_exit(int status) {
 // We link against xcb_stubs.c which provides xcb_connect (but not cached)
 extern xcb_connection_t* xcb_connect(const char* displayname, int* screenp);
 
-xcb_connection_t* __wrap_xcb_connect_cached(void) {
+xcb_connection_t* __wrap_xcb_connect_cached(int* screen_out) {
   if (fail_connect)
     return NULL;
-  return xcb_connect(NULL, NULL);
+  return xcb_connect(NULL, screen_out);
 }
 
 // fcntl wrapper
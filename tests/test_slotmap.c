@@ -0,0 +1,188 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slotmap.h"
+
+static uint32_t collect_live(const slotmap_t* sm, uint32_t* out, uint32_t cap) {
+  uint32_t n = 0;
+  uint32_t idx;
+  slotmap_for_each_live(sm, idx) {
+    assert(n < cap);
+    out[n++] = idx;
+  }
+  return n;
+}
+
+static void count_visit(void* hot, void* cold, handle_t h, void* user) {
+  (void)cold;
+  assert(*(uint32_t*)hot == handle_index(h));
+  (*(uint32_t*)user)++;
+}
+
+void test_slotmap_live_iteration_sparse(void) {
+  slotmap_t sm;
+  assert(slotmap_init(&sm, 300, sizeof(uint32_t), 0));
+
+  handle_t hs[299];
+  for (uint32_t i = 0; i < 299; i++) {
+    void* hot = NULL;
+    hs[i] = slotmap_alloc(&sm, &hot, NULL);
+    assert(hs[i] != HANDLE_INVALID);
+    *(uint32_t*)hot = handle_index(hs[i]);
+  }
+  assert(slotmap_count(&sm) == 299);
+
+  // Keep a sparse pattern spanning word boundaries, including the last slot
+  for (uint32_t i = 0; i < 299; i++) {
+    uint32_t idx = handle_index(hs[i]);
+    if (!(idx == 1 || idx == 63 || idx == 64 || idx == 127 || idx == 200 || idx == 299))
+      slotmap_free(&sm, hs[i]);
+  }
+  assert(slotmap_validate_basic(&sm));
+  assert(slotmap_count(&sm) == 6);
+
+  uint32_t got[300];
+  uint32_t n = collect_live(&sm, got, 300);
+  const uint32_t want[] = {1, 63, 64, 127, 200, 299};
+  assert(n == 6);
+  assert(memcmp(got, want, sizeof(want)) == 0);
+
+  uint32_t visited = 0;
+  slotmap_for_each_used(&sm, count_visit, &visited);
+  assert(visited == 6);
+
+  assert(slotmap_next_live(&sm, 0) == 1);
+  assert(slotmap_next_live(&sm, 65) == 127);
+  assert(slotmap_next_live(&sm, 300) == 0);
+
+  // Freeing the current slot mid-iteration is allowed
+  uint32_t idx;
+  slotmap_for_each_live(&sm, idx) {
+    slotmap_free(&sm, slotmap_handle_at(&sm, idx));
+  }
+  assert(slotmap_count(&sm) == 0);
+  assert(collect_live(&sm, got, 300) == 0);
+
+  slotmap_destroy(&sm);
+  printf("test_slotmap_live_iteration_sparse passed\n");
+}
+
+void test_slotmap_live_bits_survive_reserve_and_clear(void) {
+  slotmap_t sm;
+  assert(slotmap_init(&sm, 2, sizeof(uint32_t), sizeof(uint64_t)));
+
+  // alloc_grow doubles through several reserves
+  for (uint32_t i = 0; i < 100; i++) {
+    void* hot = NULL;
+    handle_t h = slotmap_alloc_grow(&sm, &hot, NULL);
+    assert(h != HANDLE_INVALID);
+    *(uint32_t*)hot = handle_index(h);
+  }
+  assert(sm.cap >= 101);
+  assert(slotmap_validate_basic(&sm));
+  assert(slotmap_count(&sm) == 100);
+
+  uint32_t visited = 0;
+  slotmap_for_each_used(&sm, count_visit, &visited);
+  assert(visited == 100);
+
+  slotmap_clear(&sm);
+  assert(slotmap_validate_basic(&sm));
+  assert(slotmap_count(&sm) == 0);
+  assert(slotmap_next_live(&sm, 1) == 0);
+
+  handle_t h = slotmap_alloc(&sm, NULL, NULL);
+  assert(slotmap_next_live(&sm, 1) == handle_index(h));
+
+  slotmap_destroy(&sm);
+  printf("test_slotmap_live_bits_survive_reserve_and_clear passed\n");
+}
+
+void test_slotmap_paged_growth_keeps_addresses(void) {
+  slotmap_t sm;
+  assert(slotmap_init_paged(&sm, 2, sizeof(uint32_t), sizeof(uint64_t)));
+  assert(sm.paged && sm.cap == SLOTMAP_PAGE_SLOTS);
+
+  handle_t hs[300];
+  uint32_t* hots[300];
+  uint64_t* colds[300];
+  for (uint32_t i = 0; i < 300; i++) {
+    void* hot = NULL;
+    void* cold = NULL;
+    hs[i] = slotmap_alloc_grow(&sm, &hot, &cold);
+    assert(hs[i] != HANDLE_INVALID);
+    hots[i] = hot;
+    colds[i] = cold;
+    *hots[i] = handle_index(hs[i]);
+    *colds[i] = (uint64_t)i << 32;
+  }
+  assert(sm.cap >= 301 && sm.cap % SLOTMAP_PAGE_SLOTS == 0);
+  assert(slotmap_validate_basic(&sm));
+
+  // Pointers taken before every reserve still address the same slots
+  for (uint32_t i = 0; i < 300; i++) {
+    assert(slotmap_hot_checked(&sm, hs[i]) == hots[i]);
+    assert(slotmap_cold_checked(&sm, hs[i]) == colds[i]);
+    assert(*hots[i] == handle_index(hs[i]));
+    assert(*colds[i] == (uint64_t)i << 32);
+  }
+
+  uint32_t visited = 0;
+  slotmap_for_each_used(&sm, count_visit, &visited);
+  assert(visited == 300);
+
+  // Reused slots come back zeroed
+  slotmap_free(&sm, hs[10]);
+  void* hot = NULL;
+  handle_t h = slotmap_alloc(&sm, &hot, NULL);
+  assert(handle_index(h) == handle_index(hs[10]) && hot == hots[10]);
+  assert(*(uint32_t*)hot == 0);
+
+  slotmap_destroy(&sm);
+  printf("test_slotmap_paged_growth_keeps_addresses passed\n");
+}
+
+void test_slotmap_columns_follow_reserve(void) {
+  slotmap_t sm;
+  assert(slotmap_init(&sm, 2, sizeof(uint32_t), 0));
+  assert(slotmap_add_column(&sm, sizeof(uint8_t)) == 0);
+  assert(slotmap_add_column(&sm, sizeof(uint32_t)) == 1);
+  assert(slotmap_column_count(&sm) == 2 && !slotmap_column(&sm, 2));
+
+  handle_t hs[100];
+  for (uint32_t i = 0; i < 100; i++) {
+    hs[i] = slotmap_alloc_grow(&sm, NULL, NULL);
+    assert(hs[i] != HANDLE_INVALID);
+    uint32_t idx = handle_index(hs[i]);
+    ((uint8_t*)slotmap_column(&sm, 0))[idx] = (uint8_t)i;
+    ((uint32_t*)slotmap_column(&sm, 1))[idx] = i * 3u;
+  }
+
+  // Growth moved the columns but kept every slot's values
+  const uint8_t* small = slotmap_column(&sm, 0);
+  const uint32_t* wide = slotmap_column(&sm, 1);
+  for (uint32_t i = 0; i < 100; i++) {
+    assert(small[handle_index(hs[i])] == (uint8_t)i);
+    assert(wide[handle_index(hs[i])] == i * 3u);
+  }
+
+  // Reused slots come back zeroed in every column
+  slotmap_free(&sm, hs[5]);
+  handle_t h = slotmap_alloc(&sm, NULL, NULL);
+  assert(handle_index(h) == handle_index(hs[5]));
+  assert(small[handle_index(h)] == 0 && wide[handle_index(h)] == 0);
+
+  slotmap_destroy(&sm);
+  assert(slotmap_column_count(&sm) == 0);
+  printf("test_slotmap_columns_follow_reserve passed\n");
+}
+
+int main(void) {
+  test_slotmap_live_iteration_sparse();
+  test_slotmap_live_bits_survive_reserve_and_clear();
+  test_slotmap_paged_growth_keeps_addresses();
+  test_slotmap_columns_follow_reserve();
+  return 0;
+}
@@ -32,12 +32,60 @@ static void assert_slotmap_init_fails_at(int fail_at) {
   assert(sm.hdr == NULL);
   assert(sm.hot == NULL);
   assert(sm.cold == NULL);
+  assert(sm.live_bits == NULL);
   assert(sm.cap == 0);
 }
 
+// hdr, live bits, two page directories, one hot and one cold page
+static void assert_slotmap_init_paged_fails_at(int fail_at) {
+  slotmap_t sm;
+  g_call_count = 0;
+  g_fail_at = fail_at;
+
+  bool ok = slotmap_init_paged(&sm, 4, sizeof(int), sizeof(int));
+  assert(!ok);
+  assert(sm.hdr == NULL);
+  assert(sm.hot_pages == NULL);
+  assert(sm.cold_pages == NULL);
+  assert(sm.live_bits == NULL);
+  assert(sm.cap == 0);
+}
+
+// A failed paged reserve leaves the map, its pages and its column untouched:
+// hdr, live bits, column, two page directories, one hot and one cold page
+static void assert_slotmap_reserve_paged_fails_at(int fail_at) {
+  slotmap_t sm;
+  g_fail_at = 0;
+  assert(slotmap_init_paged(&sm, 4, sizeof(int), sizeof(int)));
+  assert(slotmap_add_column(&sm, sizeof(uint16_t)) == 0);
+  void* hot = NULL;
+  handle_t h = slotmap_alloc(&sm, &hot, NULL);
+  *(int*)hot = 42;
+  uint16_t* col = slotmap_column(&sm, 0);
+  col[handle_index(h)] = 7;
+  void** hot_pages = sm.hot_pages;
+
+  g_call_count = 0;
+  g_fail_at = fail_at;
+  assert(!slotmap_reserve(&sm, 2 * SLOTMAP_PAGE_SLOTS));
+  assert(sm.cap == SLOTMAP_PAGE_SLOTS);
+  assert(sm.hot_pages == hot_pages);
+  assert(slotmap_hot_checked(&sm, h) == hot && *(int*)hot == 42);
+  assert(slotmap_column(&sm, 0) == col && col[handle_index(h)] == 7);
+  assert(slotmap_validate_basic(&sm));
+
+  g_fail_at = 0;
+  slotmap_destroy(&sm);
+}
+
 int main(void) {
   assert_slotmap_init_fails_at(1);
   assert_slotmap_init_fails_at(2);
   assert_slotmap_init_fails_at(3);
+  assert_slotmap_init_fails_at(4);
+  for (int i = 1; i <= 6; i++)
+    assert_slotmap_init_paged_fails_at(i);
+  for (int i = 1; i <= 7; i++)
+    assert_slotmap_reserve_paged_fails_at(i);
   return 0;
 }
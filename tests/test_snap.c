@@ -1,14 +1,19 @@
 /*
- * Basic unit tests for snap_compute_candidate
+ * Basic unit tests for snap_compute_candidate and the snap edge index
  */
 
 #include <assert.h>
 
 #include "snap.h"
 
+static snap_layout_t halves(int threshold_px) {
+  return (snap_layout_t){.threshold_px = threshold_px, .split_pct = 50};
+}
+
 static void test_left_snap(void) {
   rect_t wa = {0, 0, 100, 80};
-  snap_candidate_t c = snap_compute_candidate(4, 10, wa, 10);
+  snap_layout_t l = halves(10);
+  snap_candidate_t c = snap_compute_candidate(4, 10, wa, &l);
   assert(c.active);
   assert(c.edge == SNAP_LEFT);
   assert(c.rect.x == 0 && c.rect.y == 0);
@@ -17,7 +22,8 @@ static void test_left_snap(void) {
 
 static void test_right_snap(void) {
   rect_t wa = {0, 0, 101, 80};
-  snap_candidate_t c = snap_compute_candidate(100, 20, wa, 5);
+  snap_layout_t l = halves(5);
+  snap_candidate_t c = snap_compute_candidate(100, 20, wa, &l);
   assert(c.active);
   assert(c.edge == SNAP_RIGHT);
   assert(c.rect.x == 50);
@@ -26,14 +32,88 @@ static void test_right_snap(void) {
 
 static void test_none(void) {
   rect_t wa = {0, 0, 100, 80};
-  snap_candidate_t c = snap_compute_candidate(40, 20, wa, 10);
+  snap_layout_t l = halves(10);
+  snap_candidate_t c = snap_compute_candidate(40, 20, wa, &l);
   assert(!c.active);
   assert(c.edge == SNAP_NONE);
 }
 
+static void test_corners_and_top(void) {
+  rect_t wa = {0, 20, 300, 200};
+  snap_layout_t l = {.threshold_px = 8, .corner_px = 30, .split_pct = 50, .top_maximize = true};
+
+  snap_candidate_t c = snap_compute_candidate(2, 30, wa, &l);
+  assert(c.edge == SNAP_TOP_LEFT);
+  assert(c.rect.x == 0 && c.rect.y == 20 && c.rect.w == 150 && c.rect.h == 100);
+
+  c = snap_compute_candidate(299, 210, wa, &l);
+  assert(c.edge == SNAP_BOTTOM_RIGHT);
+  assert(c.rect.x == 150 && c.rect.y == 120 && c.rect.w == 150 && c.rect.h == 100);
+
+  // Corners also reach along the top edge
+  c = snap_compute_candidate(280, 22, wa, &l);
+  assert(c.edge == SNAP_TOP_RIGHT);
+
+  c = snap_compute_candidate(150, 22, wa, &l);
+  assert(c.edge == SNAP_TOP);
+  assert(c.rect.x == 0 && c.rect.y == 20 && c.rect.w == 300 && c.rect.h == 200);
+
+  // Mid-height on a side is still the full-height tile
+  c = snap_compute_candidate(2, 120, wa, &l);
+  assert(c.edge == SNAP_LEFT);
+  assert(c.rect.h == 200);
+
+  l.top_maximize = false;
+  c = snap_compute_candidate(150, 22, wa, &l);
+  assert(!c.active);
+}
+
+static void test_split_layout(void) {
+  rect_t wa = {0, 0, 300, 100};
+  snap_layout_t l = halves(10);
+  l.split_pct = 33;
+
+  snap_candidate_t c = snap_compute_candidate(0, 50, wa, &l);
+  assert(c.edge == SNAP_LEFT && c.rect.w == 99);
+  c = snap_compute_candidate(299, 50, wa, &l);
+  assert(c.edge == SNAP_RIGHT && c.rect.x == 99 && c.rect.w == 201);
+}
+
+static void test_edge_attract(void) {
+  snap_edge_index_t idx = {0};
+  assert(snap_edges_add_rect(&idx, (rect_t){0, 0, 1000, 800}));
+  assert(snap_edges_add_rect(&idx, (rect_t){400, 100, 200, 200}));
+  snap_edges_sort(&idx);
+
+  // Right edge pulled onto the neighbour's left edge
+  rect_t r = snap_edges_attract(&idx, (rect_t){195, 150, 200, 100}, 8);
+  assert(r.x == 200 && r.y == 150);
+
+  // Out of reach: untouched
+  r = snap_edges_attract(&idx, (rect_t){180, 150, 200, 100}, 8);
+  assert(r.x == 180);
+
+  // The neighbour's edge only counts where the spans overlap
+  r = snap_edges_attract(&idx, (rect_t){195, 500, 200, 100}, 8);
+  assert(r.x == 195);
+
+  // Monitor corner holds on both axes
+  r = snap_edges_attract(&idx, (rect_t){-5, 793, 100, 10}, 8);
+  assert(r.x == 0 && r.y == 790);
+
+  snap_edges_clear(&idx);
+  r = snap_edges_attract(&idx, (rect_t){195, 150, 200, 100}, 8);
+  assert(r.x == 195);
+
+  snap_edges_destroy(&idx);
+}
+
 int main(void) {
   test_left_snap();
   test_right_snap();
   test_none();
+  test_corners_and_top();
+  test_split_layout();
+  test_edge_attract();
   return 0;
 }
@@ -0,0 +1,203 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "client.h"
+#include "config.h"
+#include "event.h"
+#include "spatial.h"
+#include "wm.h"
+
+static bool rect_contains(rect_t r, int x, int y) {
+  return x >= r.x && y >= r.y && x < r.x + (int)r.w && y < r.y + (int)r.h;
+}
+
+static bool rect_intersects(rect_t a, rect_t b) {
+  return a.x < b.x + (int)b.w && b.x < a.x + (int)a.w && a.y < b.y + (int)b.h && b.y < a.y + (int)a.h;
+}
+
+static bool vec_has(const handle_vec_t* v, handle_t h) {
+  for (size_t i = 0; i < v->length; i++) {
+    if (v->items[i] == h)
+      return true;
+  }
+  return false;
+}
+
+void test_spatial_update_move_remove(void) {
+  spatial_index_t idx;
+  spatial_index_init(&idx);
+
+  handle_t a = handle_make(1, 1);
+  handle_t b = handle_make(2, 1);
+  assert(spatial_index_update(&idx, a, (rect_t){0, 0, 100, 100}));
+  assert(!spatial_index_update(&idx, a, (rect_t){0, 0, 100, 100}));
+  assert(spatial_index_update(&idx, b, (rect_t){-300, -300, 1000, 1000}));
+  assert(spatial_index_size(&idx) == 2);
+
+  handle_vec_t hits;
+  handle_vec_init(&hits);
+  assert(spatial_index_query_point(&idx, 50, 50, &hits) == 2);
+  handle_vec_clear(&hits);
+  assert(spatial_index_query_point(&idx, -1, -1, &hits) == 1);
+  assert(hits.items[0] == b);
+  handle_vec_clear(&hits);
+
+  // Moving drops the old cells
+  assert(spatial_index_update(&idx, a, (rect_t){2000, 2000, 50, 50}));
+  assert(spatial_index_query_point(&idx, 50, 50, &hits) == 1);
+  assert(hits.items[0] == b);
+  handle_vec_clear(&hits);
+  assert(spatial_index_query_point(&idx, 2049, 2049, &hits) == 1);
+  assert(hits.items[0] == a);
+  handle_vec_clear(&hits);
+  assert(spatial_index_query_point(&idx, 2050, 2050, &hits) == 0);
+
+  rect_t got;
+  assert(spatial_index_get(&idx, a, &got));
+  assert(got.x == 2000 && got.w == 50);
+
+  // A window covering many cells is reported once per rect query
+  assert(spatial_index_query_rect(&idx, (rect_t){-1000, -1000, 4000, 4000}, &hits) == 2);
+  handle_vec_clear(&hits);
+
+  // Empty rect removes
+  assert(spatial_index_update(&idx, b, (rect_t){0, 0, 0, 10}));
+  assert(!spatial_index_get(&idx, b, NULL));
+  spatial_index_remove(&idx, a);
+  spatial_index_remove(&idx, a);
+  assert(spatial_index_size(&idx) == 0);
+  assert(hash_map_size(&idx.cells) == 0);
+
+  handle_vec_destroy(&hits);
+  spatial_index_destroy(&idx);
+  printf("test_spatial_update_move_remove passed\n");
+}
+
+void test_spatial_matches_linear_scan(void) {
+  enum { N = 200, ROUNDS = 400 };
+  spatial_index_t idx;
+  memset(&idx, 0, sizeof(idx));
+
+  rect_t rects[N];
+  srand(1234);
+  for (int i = 0; i < N; i++) {
+    rects[i] = (rect_t){(int16_t)(rand() % 4000 - 500), (int16_t)(rand() % 3000 - 500), (uint16_t)(1 + rand() % 900), (uint16_t)(1 + rand() % 700)};
+    spatial_index_update(&idx, handle_make((uint32_t)i + 1u, 1), rects[i]);
+  }
+
+  handle_vec_t hits;
+  handle_vec_init(&hits);
+  for (int round = 0; round < ROUNDS; round++) {
+    // Churn a few windows between queries
+    int moved = rand() % N;
+    rects[moved].x = (int16_t)(rects[moved].x + rand() % 301 - 150);
+    rects[moved].y = (int16_t)(rects[moved].y + rand() % 301 - 150);
+    spatial_index_update(&idx, handle_make((uint32_t)moved + 1u, 1), rects[moved]);
+
+    int px = rand() % 4500 - 600;
+    int py = rand() % 3500 - 600;
+    handle_vec_clear(&hits);
+    size_t n = spatial_index_query_point(&idx, px, py, &hits);
+    size_t want = 0;
+    for (int i = 0; i < N; i++) {
+      if (rect_contains(rects[i], px, py)) {
+        want++;
+        assert(vec_has(&hits, handle_make((uint32_t)i + 1u, 1)));
+      }
+    }
+    assert(n == want);
+
+    rect_t q = {(int16_t)px, (int16_t)py, (uint16_t)(1 + rand() % 600), (uint16_t)(1 + rand() % 600)};
+    handle_vec_clear(&hits);
+    n = spatial_index_query_rect(&idx, q, &hits);
+    want = 0;
+    for (int i = 0; i < N; i++) {
+      if (rect_intersects(rects[i], q)) {
+        want++;
+        assert(vec_has(&hits, handle_make((uint32_t)i + 1u, 1)));
+      }
+    }
+    assert(n == want);
+  }
+
+  handle_vec_destroy(&hits);
+  spatial_index_destroy(&idx);
+  printf("test_spatial_matches_linear_scan passed\n");
+}
+
+static handle_t add_client(server_t* s, xcb_window_t xid, int32_t desktop, rect_t frame) {
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s->clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = (client_hot_t*)hot_ptr;
+  hot->self = h;
+  hot->xid = xid;
+  hot->frame = xid + 1000;
+  hot->layer = LAYER_NORMAL;
+  hot->base_layer = LAYER_NORMAL;
+  hot->state = STATE_MAPPED;
+  hot->desktop = desktop;
+  hot->stacking_index = -1;
+  hot->stacking_layer = -1;
+  list_init(&hot->transients_head);
+  list_init(&hot->transient_sibling);
+  handle_vec_push(&s->active_clients, h);
+  stack_raise(s, h);
+  spatial_index_update(&s->screens[0].frame_index, h, frame);
+  return h;
+}
+
+void test_client_at_point_topmost_visible(void) {
+  server_t s;
+  memset(&s, 0, sizeof(s));
+  s.is_test = true;
+  config_init_defaults(&s.config);
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_init(&s.screens[0].layers[i]);
+  handle_vec_init(&s.active_clients);
+  spatial_index_init(&s.screens[0].frame_index);
+  if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
+    return;
+
+  handle_t below = add_client(&s, 10, 0, (rect_t){0, 0, 800, 600});
+  handle_t above = add_client(&s, 20, 0, (rect_t){100, 100, 400, 300});
+  handle_t other = add_client(&s, 30, 1, (rect_t){0, 0, 800, 600});
+
+  assert(wm_client_at_point(&s, &s.screens[0], 200, 200) == above);
+  assert(wm_client_at_point(&s, &s.screens[0], 50, 50) == below);
+  assert(wm_client_at_point(&s, &s.screens[0], 900, 900) == HANDLE_INVALID);
+
+  stack_raise(&s, below);
+  assert(wm_client_at_point(&s, &s.screens[0], 200, 200) == below);
+
+  // Other desktops are invisible until switched to or made sticky
+  server_chot(&s, other)->sticky = true;
+  stack_raise(&s, other);
+  assert(wm_client_at_point(&s, &s.screens[0], 200, 200) == other);
+  server_chot(&s, other)->state = STATE_UNMAPPED;
+  assert(wm_client_at_point(&s, &s.screens[0], 200, 200) == below);
+
+  handle_vec_t hits;
+  handle_vec_init(&hits);
+  assert(wm_clients_in_rect(&s, &s.screens[0], (rect_t){450, 350, 100, 100}, &hits) == 2);
+  assert(vec_has(&hits, below) && vec_has(&hits, above));
+  handle_vec_destroy(&hits);
+
+  printf("test_client_at_point_topmost_visible passed\n");
+
+  spatial_index_destroy(&s.screens[0].frame_index);
+  slotmap_destroy(&s.clients);
+  handle_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.dirty_clients);
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_destroy(&s.screens[0].layers[i]);
+  config_destroy(&s.config);
+}
+
+int main(void) {
+  test_spatial_update_move_remove();
+  test_spatial_matches_linear_scan();
+  test_client_at_point_topmost_visible();
+  return 0;
+}
@@ -26,10 +26,9 @@ static bool init_server(server_t* s) {
   s->conn = (xcb_connection_t*)malloc(1);
   config_init_defaults(&s->config);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
   arena_init(&s->tick_arena, 4096);
-  list_init(&s->focus_history);
-  small_vec_init(&s->active_clients);
+  handle_vec_init(&s->active_clients);
   if (slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return true;
   free(s->conn);
@@ -48,11 +47,15 @@ static void cleanup_server(server_t* s) {
     if (cold)
       client_render_payload_destroy(cold);
   }
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
-  small_vec_destroy(&s->active_clients);
+  handle_vec_destroy(&s->active_clients);
+  wm_published_props_destroy(s);
+  u32_vec_destroy(&s->screens[0].committed_stacking);
   for (int i = 0; i < LAYER_COUNT; i++) {
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
   }
+  transient_groups_destroy(&s->transients);
   arena_destroy(&s->tick_arena);
   config_destroy(&s->config);
   free(s->conn);
@@ -72,16 +75,15 @@ static handle_t add_client(server_t* s, xcb_window_t xid, xcb_window_t frame, in
   hot->stacking_layer = -1;
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
-  list_init(&hot->focus_node);
-  small_vec_push(&s->active_clients, handle_to_ptr(h));
+  handle_vec_push(&s->active_clients, h);
   return h;
 }
 
 static void assert_layer_order(const server_t* s, int layer, const handle_t* handles, size_t count) {
-  const small_vec_t* v = &s->layers[layer];
+  const handle_vec_t* v = &s->screens[0].layers[layer];
   assert(v->length == count);
   for (size_t i = 0; i < count; i++) {
-    assert((handle_t)(uintptr_t)v->items[i] == handles[i]);
+    assert(v->items[i] == handles[i]);
   }
 }
 
@@ -174,9 +176,9 @@ void test_stack_raise_transients_restack_count(void) {
   client_hot_t* t1 = server_chot(&s, ht1);
   client_hot_t* t2 = server_chot(&s, ht2);
 
-  t1->transient_for = hp;
+  client_set_transient_for(&s, t1, hp);
   list_insert(&t1->transient_sibling, p->transients_head.prev, &p->transients_head);
-  t2->transient_for = hp;
+  client_set_transient_for(&s, t2, hp);
   list_insert(&t2->transient_sibling, p->transients_head.prev, &p->transients_head);
 
   stub_configure_window_count = 0;
@@ -194,12 +196,134 @@ void test_stack_raise_transients_restack_count(void) {
   cleanup_server(&s);
 }
 
+void test_stack_transient_group_splice(void) {
+  server_t s;
+  if (!init_server(&s))
+    return;
+
+  handle_t ha = add_client(&s, 10, 110, LAYER_NORMAL);
+  handle_t hp = add_client(&s, 20, 120, LAYER_NORMAL);
+  handle_t hb = add_client(&s, 30, 130, LAYER_NORMAL);
+  handle_t ht1 = add_client(&s, 40, 140, LAYER_NORMAL);
+  handle_t ht2 = add_client(&s, 50, 150, LAYER_NORMAL);
+  handle_t ht11 = add_client(&s, 60, 160, LAYER_NORMAL);
+  handle_t hon = add_client(&s, 70, 170, LAYER_ABOVE);
+  handle_t hc = add_client(&s, 80, 180, LAYER_ABOVE);
+  for (size_t i = 0; i < s.active_clients.length; i++)
+    stack_raise(&s, s.active_clients.items[i]);
+  uint64_t rebuilds = s.transients.rebuilds;
+
+  // p <- t1 <- t11, p <- t2, and an always-on-top dialog on t2
+  client_set_transient_for(&s, server_chot(&s, ht1), hp);
+  client_set_transient_for(&s, server_chot(&s, ht2), hp);
+  client_set_transient_for(&s, server_chot(&s, ht11), ht1);
+  client_set_transient_for(&s, server_chot(&s, hon), ht2);
+  assert(!s.transients.valid);
+
+  stack_raise(&s, hp);
+  {
+    handle_t order[] = {ha, hb, hp, ht1, ht11, ht2};
+    assert_layer_order(&s, LAYER_NORMAL, order, 6);
+    handle_t above[] = {hc, hon};
+    assert_layer_order(&s, LAYER_ABOVE, above, 2);
+  }
+
+  // The group keeps its order at the bottom too, and a subtree moves alone
+  stack_lower(&s, hp);
+  {
+    handle_t order[] = {hp, ht1, ht11, ht2, ha, hb};
+    assert_layer_order(&s, LAYER_NORMAL, order, 6);
+    handle_t above[] = {hon, hc};
+    assert_layer_order(&s, LAYER_ABOVE, above, 2);
+  }
+  stack_raise(&s, ht1);
+  {
+    handle_t order[] = {hp, ht2, ha, hb, ht1, ht11};
+    assert_layer_order(&s, LAYER_NORMAL, order, 6);
+  }
+  assert(s.transients.rebuilds == rebuilds + 1);
+
+  // Relinking rebuilds once
+  client_set_transient_for(&s, server_chot(&s, ht11), HANDLE_INVALID);
+  stack_raise(&s, ht1);
+  stack_raise(&s, hp);
+  assert(s.transients.rebuilds == rebuilds + 2);
+  {
+    handle_t order[] = {ha, hb, ht11, hp, ht1, ht2};
+    assert_layer_order(&s, LAYER_NORMAL, order, 6);
+  }
+
+  // Labels still order each layer
+  for (int l = 0; l < LAYER_COUNT; l++) {
+    handle_vec_t* v = &s.screens[0].layers[l];
+    for (size_t i = 1; i < v->length; i++)
+      assert(server_chot(&s, v->items[i - 1])->stacking_label < server_chot(&s, v->items[i])->stacking_label);
+  }
+
+  printf("test_stack_transient_group_splice passed\n");
+
+  cleanup_server(&s);
+}
+
+void test_stack_batched_raises_emit_minimal_restacks(void) {
+  server_t s;
+  if (!init_server(&s))
+    return;
+
+  handle_t hs[8];
+  for (int i = 0; i < 8; i++) {
+    hs[i] = add_client(&s, (xcb_window_t)(10 + i), (xcb_window_t)(110 + i), LAYER_NORMAL);
+    stack_raise(&s, hs[i]);
+  }
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(s.screens[0].committed_stacking.length == 8);
+
+  // Three raises in one tick: only the raised windows move
+  stub_configure_window_count = 0;
+  stack_raise(&s, hs[1]);
+  stack_raise(&s, hs[4]);
+  stack_raise(&s, hs[2]);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_configure_window_count == 3);
+  assert(stub_last_config_window == server_chot(&s, hs[2])->frame);
+  assert(stub_last_config_sibling == server_chot(&s, hs[4])->frame);
+  assert(stub_last_config_stack_mode == XCB_STACK_MODE_ABOVE);
+
+  // Raising the same window repeatedly costs one request
+  stub_configure_window_count = 0;
+  for (int i = 0; i < 5; i++) {
+    stack_raise(&s, hs[0]);
+    stack_raise(&s, hs[7]);
+  }
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_configure_window_count == 2);
+
+  // Only the net move is sent, not the intermediate lower
+  stub_configure_window_count = 0;
+  stack_lower(&s, hs[5]);
+  stack_raise(&s, hs[5]);
+  stack_raise(&s, hs[7]);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_configure_window_count == 1);
+
+  {
+    handle_t order[] = {hs[3], hs[6], hs[1], hs[4], hs[2], hs[0], hs[5], hs[7]};
+    assert_layer_order(&s, LAYER_NORMAL, order, 8);
+    for (size_t i = 0; i < 8; i++)
+      assert(s.screens[0].committed_stacking.items[i] == server_chot(&s, order[i])->frame);
+  }
+
+  printf("test_stack_batched_raises_emit_minimal_restacks passed\n");
+
+  cleanup_server(&s);
+}
+
 void test_root_stacking_property_order(void) {
   server_t s;
   if (!init_server(&s))
     return;
 
-  s.root = 1;
+  s.screens[0].root = 1;
   atoms._NET_CLIENT_LIST_STACKING = 400;
 
   handle_t hb = add_client(&s, 10, 110, LAYER_BELOW);
@@ -212,7 +336,7 @@ void test_root_stacking_property_order(void) {
   stack_raise(&s, hn2);
   stack_raise(&s, ha);
 
-  s.root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
   stub_last_prop_atom = 0;
   wm_flush_dirty(&s, monotonic_time_ns());
 
@@ -234,7 +358,7 @@ void test_root_stacking_desktop_below_normal(void) {
   if (!init_server(&s))
     return;
 
-  s.root = 1;
+  s.screens[0].root = 1;
   atoms._NET_CLIENT_LIST_STACKING = 500;
 
   handle_t hdesk = add_client(&s, 11, 111, LAYER_DESKTOP);
@@ -245,7 +369,7 @@ void test_root_stacking_desktop_below_normal(void) {
   stack_raise(&s, hbelow);
   stack_raise(&s, hnormal);
 
-  s.root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
   stub_last_prop_atom = 0;
   wm_flush_dirty(&s, monotonic_time_ns());
 
@@ -261,6 +385,139 @@ void test_root_stacking_desktop_below_normal(void) {
   cleanup_server(&s);
 }
 
+void test_root_stacking_unchanged_skips_write(void) {
+  server_t s;
+  if (!init_server(&s))
+    return;
+
+  s.screens[0].root = 1;
+  atoms._NET_CLIENT_LIST_STACKING = 600;
+
+  handle_t h1 = add_client(&s, 51, 151, LAYER_NORMAL);
+  handle_t h2 = add_client(&s, 52, 152, LAYER_NORMAL);
+  stack_raise(&s, h1);
+  stack_raise(&s, h2);
+
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
+  stub_last_prop_atom = 0;
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_last_prop_atom == atoms._NET_CLIENT_LIST_STACKING);
+
+  // Raising the top window again leaves the order alone: no rewrite
+  stack_raise(&s, h2);
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
+  stub_last_prop_atom = 0;
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_last_prop_atom != atoms._NET_CLIENT_LIST_STACKING);
+  assert((s.screens[0].root_dirty & ROOT_DIRTY_CLIENT_LIST_STACKING) == 0);
+
+  // A real change is published
+  stack_raise(&s, h1);
+  s.screens[0].root_dirty |= ROOT_DIRTY_CLIENT_LIST_STACKING;
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_last_prop_atom == atoms._NET_CLIENT_LIST_STACKING);
+  uint32_t* wins = (uint32_t*)stub_last_prop_data;
+  assert(stub_last_prop_len == 2);
+  assert(wins[0] == 52);
+  assert(wins[1] == 51);
+
+  printf("test_root_stacking_unchanged_skips_write passed\n");
+
+  cleanup_server(&s);
+}
+
+static void assert_labels_ascending(server_t* s, int layer) {
+  const handle_vec_t* v = &s->screens[0].layers[layer];
+  for (size_t i = 1; i < v->length; i++) {
+    client_hot_t* lo = server_chot(s, v->items[i - 1]);
+    client_hot_t* hi = server_chot(s, v->items[i]);
+    assert(lo->stacking_label < hi->stacking_label);
+  }
+}
+
+void test_stack_labels_leave_neighbours_untouched(void) {
+  server_t s;
+  if (!init_server(&s))
+    return;
+
+  handle_t h[4];
+  for (int i = 0; i < 4; i++) {
+    h[i] = add_client(&s, (xcb_window_t)(60 + i), (xcb_window_t)(160 + i), LAYER_NORMAL);
+    stack_raise(&s, h[i]);
+  }
+  client_hot_t* c0 = server_chot(&s, h[0]);
+  client_hot_t* c2 = server_chot(&s, h[2]);
+  uint32_t label0 = c0->stacking_label;
+  uint32_t label2 = c2->stacking_label;
+
+  // Raising a bottom window shifts everyone's position but writes only itself
+  stack_raise(&s, h[1]);
+  assert(c0->stacking_label == label0);
+  assert(c2->stacking_label == label2);
+  {
+    handle_t order[] = {h[0], h[2], h[3], h[1]};
+    assert_layer_order(&s, LAYER_NORMAL, order, 4);
+  }
+
+  // Stale position hints are repaired by label search
+  stack_place_above(&s, h[0], h[3]);
+  {
+    handle_t order[] = {h[2], h[3], h[0], h[1]};
+    assert_layer_order(&s, LAYER_NORMAL, order, 4);
+  }
+  assert_labels_ascending(&s, LAYER_NORMAL);
+
+  printf("test_stack_labels_leave_neighbours_untouched passed\n");
+  cleanup_server(&s);
+}
+
+void test_stack_labels_relabel_on_exhaustion(void) {
+  server_t s;
+  if (!init_server(&s))
+    return;
+
+  enum { N = 6 };
+  handle_t h[N];
+  handle_t model[N];
+  for (int i = 0; i < N; i++) {
+    h[i] = add_client(&s, (xcb_window_t)(70 + i), (xcb_window_t)(170 + i), LAYER_NORMAL);
+    stack_raise(&s, h[i]);
+    model[i] = h[i];
+  }
+
+  // Ping-pong into one gap: halves it every time until a relabel is forced
+  for (int round = 0; round < 64; round++) {
+    handle_t mover = (round & 1) ? h[5] : h[4];
+    stack_place_above(&s, mover, h[0]);
+    assert_labels_ascending(&s, LAYER_NORMAL);
+  }
+  {
+    handle_t order[] = {h[0], h[5], h[4], h[1], h[2], h[3]};
+    assert_layer_order(&s, LAYER_NORMAL, order, N);
+  }
+
+  // Long raise/lower runs walk off both ends of the label space
+  for (int i = 0; i < 200000; i++) {
+    size_t pick = (size_t)(i * 7) % N;
+    handle_t hh = model[pick];
+    if (i & 1) {
+      stack_raise(&s, hh);
+      memmove(&model[pick], &model[pick + 1], (N - pick - 1) * sizeof(handle_t));
+      model[N - 1] = hh;
+    }
+    else {
+      stack_lower(&s, hh);
+      memmove(&model[1], &model[0], pick * sizeof(handle_t));
+      model[0] = hh;
+    }
+  }
+  assert_layer_order(&s, LAYER_NORMAL, model, N);
+  assert_labels_ascending(&s, LAYER_NORMAL);
+
+  printf("test_stack_labels_relabel_on_exhaustion passed\n");
+  cleanup_server(&s);
+}
+
 void test_raise_lower_preserve_relative_order(void) {
   server_t s;
   if (!init_server(&s))
@@ -361,9 +618,14 @@ int main(void) {
   test_stack_restack_single_and_sibling();
   test_stack_cross_layer_sibling();
   test_stack_raise_transients_restack_count();
+  test_stack_transient_group_splice();
+  test_stack_batched_raises_emit_minimal_restacks();
   test_root_stacking_property_order();
   test_root_stacking_desktop_below_normal();
+  test_root_stacking_unchanged_skips_write();
   test_raise_lower_preserve_relative_order();
+  test_stack_labels_leave_neighbours_untouched();
+  test_stack_labels_relabel_on_exhaustion();
   test_stack_remove_recovers_from_stale_index();
   test_focus_raise_on_focus();
   return 0;
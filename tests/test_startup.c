@@ -13,7 +13,7 @@ void test_adoption_logic(void) {
   s.conn = (xcb_connection_t*)0xDEADBEEF;  // Just not NULL
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
-  hash_map_init(&s.window_to_client);
+  hash_map_init(&s.xid_index);
 
   // Mock reply for adoption check
   xcb_get_window_attributes_reply_t mock_attr;
@@ -29,8 +29,8 @@ void test_adoption_logic(void) {
   // This should trigger client_manage_start for window 999
   wm_handle_reply(&s, &slot, &mock_attr, NULL);
 
-  // Check if window 999 is now being managed (should be in window_to_client
-  // map)
+  // Check if window 999 is now being managed (should be in xid_index as a
+  // client window)
   handle_t h = server_get_client_by_window(&s, 999);
   assert(h != HANDLE_INVALID);
 
@@ -41,8 +41,9 @@ void test_adoption_logic(void) {
 
   printf("test_adoption_logic passed\n");
 
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
 }
 
 int main(void) {
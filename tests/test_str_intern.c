@@ -0,0 +1,109 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "rules.h"
+#include "str_intern.h"
+
+void test_str_intern_shares_and_frees(void) {
+  size_t base = str_intern_count();
+
+  char buf[] = "XTerm";
+  const char* a = str_intern("XTerm");
+  const char* b = str_intern(buf);
+  assert(a && a == b && a != buf);
+  assert(strcmp(a, "XTerm") == 0);
+  assert(str_intern_refs(a) == 2);
+  assert(str_intern_count() == base + 1);
+  assert(str_intern_hash(a) == str_hash("XTerm", 5));
+
+  // Cut at len or the first NUL, whichever comes first
+  const char* c = str_intern_n("xterm\0XTerm", 11);
+  const char* d = str_intern_n("xtermx", 5);
+  assert(c == d && strcmp(c, "xterm") == 0);
+  assert(c != a);
+
+  assert(str_intern_ref(a) == a && str_intern_refs(a) == 3);
+  str_intern_release(a);
+  str_intern_release(a);
+  assert(str_intern_refs(b) == 1);
+  str_intern_release(b);
+  str_intern_release(c);
+  str_intern_release(d);
+  assert(str_intern_count() == base);
+
+  assert(!str_intern(NULL) && str_intern_refs(NULL) == 0);
+  str_intern_release(NULL);
+  printf("test_str_intern_shares_and_frees passed\n");
+}
+
+static app_rule_t* class_rule(const char* cls, const char* instance) {
+  app_rule_t* r = calloc(1, sizeof(*r));
+  assert(r);
+  r->class_match = cls ? strdup(cls) : NULL;
+  r->instance_match = instance ? strdup(instance) : NULL;
+  r->type_match = -1;
+  r->transient_match = -1;
+  r->desktop = -2;
+  r->layer = -1;
+  r->focus = -1;
+  r->bypass_compositor = -1;
+  return r;
+}
+
+void test_rules_match_interned_subjects(void) {
+  size_t base = str_intern_count();
+
+  small_vec_t rules;
+  small_vec_init(&rules);
+  small_vec_push(&rules, class_rule("XTerm", NULL));
+  small_vec_push(&rules, class_rule(NULL, "xterm"));
+  small_vec_push(&rules, class_rule("Firefox", "Navigator"));
+
+  rule_set_t set;
+  rule_set_init(&set);
+  rule_set_build(&set, &rules);
+  assert(set.class_ids[0] == str_intern_ref(set.class_ids[0]));
+  str_intern_release(set.class_ids[0]);
+
+  const char* cls = str_intern("XTerm");
+  const char* inst = str_intern("xterm");
+  rule_subject_t interned = {.wm_class = cls, .wm_instance = inst, .interned = true};
+  rule_subject_t plain = {.wm_class = "XTerm", .wm_instance = "xterm"};
+
+  // Same hits by pointer as by strcmp
+  const uint32_t* hits = NULL;
+  assert(rule_set_match(&set, &interned, &hits) == 2);
+  assert(hits[0] == 0 && hits[1] == 1);
+  assert(rule_set_match(&set, &plain, &hits) == 2);
+  assert(hits[0] == 0 && hits[1] == 1);
+
+  const char* ff = str_intern("Firefox");
+  const char* other = str_intern("Toolkit");
+  rule_subject_t partial = {.wm_class = ff, .wm_instance = other, .interned = true};
+  assert(rule_set_match(&set, &partial, &hits) == 0);
+
+  rule_set_destroy(&set);
+  str_intern_release(cls);
+  str_intern_release(inst);
+  str_intern_release(ff);
+  str_intern_release(other);
+  assert(str_intern_count() == base);
+
+  for (size_t i = 0; i < rules.length; i++) {
+    app_rule_t* r = rules.items[i];
+    free(r->class_match);
+    free(r->instance_match);
+    free(r);
+  }
+  small_vec_destroy(&rules);
+  printf("test_rules_match_interned_subjects passed\n");
+}
+
+int main(void) {
+  test_str_intern_shares_and_frees();
+  test_rules_match_interned_subjects();
+  return 0;
+}
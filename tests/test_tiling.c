@@ -0,0 +1,196 @@
+/*
+ * Unit tests for the tiling layout engine
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tiling.h"
+
+static const tile_result_t* find(const tile_result_t* out, size_t n, handle_t h) {
+  for (size_t i = 0; i < n; i++) {
+    if (out[i].client == h)
+      return &out[i];
+  }
+  return NULL;
+}
+
+static bool rect_is(rect_t r, int x, int y, int w, int h) {
+  return r.x == x && r.y == y && r.w == w && r.h == h;
+}
+
+static void test_bsp_split_and_merge(void) {
+  tile_tree_t t;
+  tile_tree_init(&t, TILE_BSP);
+  tile_tree_set_area(&t, (rect_t){0, 0, 1000, 600}, 0);
+
+  size_t n;
+  assert(tile_tree_insert(&t, 1, HANDLE_INVALID));
+  const tile_result_t* out = tile_tree_layout(&t, &n);
+  assert(n == 1 && rect_is(out[0].rect, 0, 0, 1000, 600));
+
+  // The wide leaf splits side by side
+  assert(tile_tree_insert(&t, 2, HANDLE_INVALID));
+  assert(!tile_tree_insert(&t, 2, HANDLE_INVALID));
+  out = tile_tree_layout(&t, &n);
+  assert(n == 2);
+  assert(rect_is(find(out, n, 1)->rect, 0, 0, 500, 600));
+  assert(rect_is(find(out, n, 2)->rect, 500, 0, 500, 600));
+
+  // The tall right half splits top/bottom; the left half is not touched
+  uint64_t visited = t.nodes_visited;
+  assert(tile_tree_insert(&t, 3, 2));
+  out = tile_tree_layout(&t, &n);
+  assert(n == 2);
+  assert(!find(out, n, 1));
+  assert(rect_is(find(out, n, 2)->rect, 500, 0, 500, 300));
+  assert(rect_is(find(out, n, 3)->rect, 500, 300, 500, 300));
+  assert(t.nodes_visited - visited == 4);
+
+  // Nothing dirty, nothing reported
+  out = tile_tree_layout(&t, &n);
+  assert(n == 0);
+
+  // Removing 3 gives 2 the whole right half back and leaves 1 alone
+  assert(tile_tree_remove(&t, 3));
+  assert(!tile_tree_remove(&t, 3));
+  out = tile_tree_layout(&t, &n);
+  assert(n == 1 && out[0].client == 2);
+  assert(rect_is(out[0].rect, 500, 0, 500, 600));
+
+  assert(tile_tree_remove(&t, 1));
+  out = tile_tree_layout(&t, &n);
+  assert(n == 1 && rect_is(out[0].rect, 0, 0, 1000, 600));
+  assert(tile_tree_remove(&t, 2));
+  assert(tile_tree_count(&t) == 0 && t.root == TILE_NIL);
+
+  tile_tree_destroy(&t);
+  printf("test_bsp_split_and_merge passed\n");
+}
+
+static void test_bsp_resize_and_gaps(void) {
+  tile_tree_t t;
+  tile_tree_init(&t, TILE_BSP);
+  tile_tree_set_area(&t, (rect_t){0, 0, 1000, 600}, 10);
+  assert(tile_tree_insert(&t, 1, HANDLE_INVALID));
+  assert(tile_tree_insert(&t, 2, HANDLE_INVALID));
+
+  size_t n;
+  const tile_result_t* out = tile_tree_layout(&t, &n);
+  assert(n == 2);
+  assert(rect_is(find(out, n, 1)->rect, 10, 10, 485, 580));
+  assert(rect_is(find(out, n, 2)->rect, 505, 10, 485, 580));
+
+  // Growing the second child moves the split left
+  assert(tile_tree_resize(&t, 2, 100));
+  out = tile_tree_layout(&t, &n);
+  assert(n == 2);
+  assert(find(out, n, 1)->rect.w == 388);
+  assert(find(out, n, 2)->rect.x == 408);
+
+  assert(tile_tree_resize(&t, 1, -1000));
+  assert(!tile_tree_resize(&t, 1, -1000));
+
+  // A hand-moved client is put back on the next layout
+  tile_tree_layout(&t, &n);
+  tile_tree_invalidate(&t, 1);
+  out = tile_tree_layout(&t, &n);
+  assert(n == 1 && out[0].client == 1);
+
+  tile_tree_destroy(&t);
+  printf("test_bsp_resize_and_gaps passed\n");
+}
+
+static void test_master_stack(void) {
+  tile_tree_t t;
+  tile_tree_init(&t, TILE_MASTER);
+  tile_tree_set_area(&t, (rect_t){0, 0, 1000, 600}, 0);
+  tile_tree_set_master(&t, 600);
+  for (handle_t h = 1; h <= 4; h++)
+    assert(tile_tree_insert(&t, h, HANDLE_INVALID));
+
+  size_t n;
+  const tile_result_t* out = tile_tree_layout(&t, &n);
+  assert(n == 4);
+  assert(rect_is(find(out, n, 1)->rect, 0, 0, 600, 600));
+  assert(rect_is(find(out, n, 2)->rect, 600, 0, 400, 200));
+  assert(rect_is(find(out, n, 3)->rect, 600, 200, 400, 200));
+  assert(rect_is(find(out, n, 4)->rect, 600, 400, 400, 200));
+
+  // Dropping the last stack client changes only the stack
+  assert(tile_tree_remove(&t, 4));
+  out = tile_tree_layout(&t, &n);
+  assert(n == 2 && !find(out, n, 1));
+  assert(rect_is(find(out, n, 3)->rect, 600, 300, 400, 300));
+
+  // Growing a stack client shrinks the master
+  assert(tile_tree_resize(&t, 2, 100));
+  out = tile_tree_layout(&t, &n);
+  assert(n == 3 && find(out, n, 1)->rect.w == 500);
+
+  // Switching layout reports only what moved: here BSP tiles the same way
+  tile_tree_set_mode(&t, TILE_BSP);
+  out = tile_tree_layout(&t, &n);
+  assert(n == 0);
+  assert(tile_tree_insert(&t, 4, 1));
+  out = tile_tree_layout(&t, &n);
+  assert(n == 2);
+  assert(rect_is(find(out, n, 1)->rect, 0, 0, 500, 300));
+  assert(rect_is(find(out, n, 4)->rect, 0, 300, 500, 300));
+
+  tile_tree_set_mode(&t, TILE_FLOAT);
+  tile_tree_set_area(&t, (rect_t){0, 0, 800, 600}, 0);
+  out = tile_tree_layout(&t, &n);
+  assert(n == 0);
+
+  tile_tree_destroy(&t);
+  printf("test_master_stack passed\n");
+}
+
+static void test_many_clients(void) {
+  tile_tree_t t;
+  tile_tree_init(&t, TILE_BSP);
+  tile_tree_set_area(&t, (rect_t){0, 0, 3840, 2160}, 4);
+  size_t n;
+  for (handle_t h = 1; h <= 64; h++) {
+    assert(tile_tree_insert(&t, h, h / 2));
+    tile_tree_layout(&t, &n);
+  }
+
+  // One more splits one leaf: two reports, whatever the client count
+  uint64_t visited = t.nodes_visited;
+  assert(tile_tree_insert(&t, 65, 40));
+  const tile_result_t* out = tile_tree_layout(&t, &n);
+  assert(n == 2 && find(out, n, 40) && find(out, n, 65));
+  assert(t.nodes_visited - visited < 16);
+
+  for (handle_t h = 1; h <= 65; h += 2)
+    assert(tile_tree_remove(&t, h));
+  out = tile_tree_layout(&t, &n);
+  assert(tile_tree_count(&t) == 32);
+
+  // Every survivor stays inside the area and no two overlap
+  tile_tree_invalidate(&t, HANDLE_INVALID);
+  out = tile_tree_layout(&t, &n);
+  assert(n == 32);
+  for (size_t i = 0; i < n; i++) {
+    rect_t a = out[i].rect;
+    assert(a.x >= 4 && a.y >= 4 && a.x + a.w <= 3836 && a.y + a.h <= 2156);
+    for (size_t j = i + 1; j < n; j++) {
+      rect_t b = out[j].rect;
+      assert(a.x + a.w <= b.x || b.x + b.w <= a.x || a.y + a.h <= b.y || b.y + b.h <= a.y);
+    }
+  }
+
+  tile_tree_destroy(&t);
+  printf("test_many_clients passed\n");
+}
+
+int main(void) {
+  test_bsp_split_and_merge();
+  test_bsp_resize_and_gaps();
+  test_master_stack();
+  test_many_clients();
+  return 0;
+}
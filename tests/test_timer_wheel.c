@@ -0,0 +1,198 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "timer_wheel.h"
+
+#define MS 1000000ull
+
+typedef struct fire_log {
+  wheel_timer_t* order[16];
+  uint64_t at[16];
+  int n;
+  uint64_t now;
+} fire_log_t;
+
+static void record(wheel_timer_t* t, void* ctx) {
+  fire_log_t* log = ctx;
+  assert(log->n < 16);
+  // Never early
+  assert(log->now >= t->deadline_ns);
+  log->at[log->n] = log->now;
+  log->order[log->n++] = t;
+}
+
+static uint32_t run_at(timer_wheel_t* w, fire_log_t* log, uint64_t now) {
+  log->now = now;
+  return timer_wheel_run(w, now, log);
+}
+
+static void test_timer_wheel_fires_in_order_across_levels(void) {
+  timer_wheel_t w;
+  memset(&w, 0, sizeof(w));
+  fire_log_t log = {0};
+  uint64_t start = 5000 * MS;
+  run_at(&w, &log, start);
+
+  // 2 ms, 40 ms (level 1), 3 s (level 2), 30 min (level 3)
+  wheel_timer_t a, b, c, d;
+  wheel_timer_init(&a, record);
+  wheel_timer_init(&b, record);
+  wheel_timer_init(&c, record);
+  wheel_timer_init(&d, record);
+  timer_wheel_add(&w, &d, start + 1800000 * MS, 0);
+  timer_wheel_add(&w, &c, start + 3000 * MS, 0);
+  timer_wheel_add(&w, &b, start + 40 * MS, 0);
+  timer_wheel_add(&w, &a, start + 2 * MS, 0);
+  assert(w.count == 4);
+  assert(timer_wheel_next_ns(&w) == start + 2 * MS);
+
+  assert(run_at(&w, &log, start + 1 * MS) == 0);
+  assert(run_at(&w, &log, start + 2 * MS) == 1);
+  assert(log.order[0] == &a);
+  assert(timer_wheel_next_ns(&w) == start + 40 * MS);
+
+  // Stepping through wakeups, each timer fires at the instant reported
+  while (w.count > 0) {
+    uint64_t next = timer_wheel_next_ns(&w);
+    assert(run_at(&w, &log, next - 1) == 0);
+    assert(run_at(&w, &log, next) == 1);
+  }
+  assert(log.n == 4);
+  assert(log.order[1] == &b && log.at[1] == start + 40 * MS);
+  assert(log.order[2] == &c && log.at[2] == start + 3000 * MS);
+  assert(log.order[3] == &d && log.at[3] == start + 1800000 * MS);
+  assert(timer_wheel_next_ns(&w) == UINT64_MAX);
+  assert(w.fired == 4);
+  printf("test_timer_wheel_fires_in_order_across_levels passed\n");
+}
+
+static void test_timer_wheel_cancel_and_move(void) {
+  timer_wheel_t w;
+  memset(&w, 0, sizeof(w));
+  fire_log_t log = {0};
+  uint64_t start = 100 * MS;
+  run_at(&w, &log, start);
+
+  wheel_timer_t a, b;
+  wheel_timer_init(&a, record);
+  wheel_timer_init(&b, record);
+  timer_wheel_add(&w, &a, start + 10 * MS, 0);
+  timer_wheel_add(&w, &b, start + 20 * MS, 0);
+  assert(wheel_timer_pending(&a));
+
+  timer_wheel_cancel(&w, &a);
+  assert(!wheel_timer_pending(&a));
+  timer_wheel_cancel(&w, &a);
+  assert(w.count == 1 && w.cancelled == 1);
+  assert(timer_wheel_next_ns(&w) == start + 20 * MS);
+
+  // Re-adding a pending timer moves it
+  timer_wheel_add(&w, &b, start + 5 * MS, 0);
+  assert(w.count == 1);
+  assert(timer_wheel_next_ns(&w) == start + 5 * MS);
+  assert(run_at(&w, &log, start + 30 * MS) == 1);
+  assert(log.n == 1 && log.order[0] == &b);
+  printf("test_timer_wheel_cancel_and_move passed\n");
+}
+
+static void test_timer_wheel_slack_coalesces(void) {
+  timer_wheel_t w;
+  memset(&w, 0, sizeof(w));
+  fire_log_t log = {0};
+  uint64_t start = 100 * MS;
+  run_at(&w, &log, start);
+
+  // Due at 10 and 14 ms; the first may wait 5 ms, so one wakeup serves both
+  wheel_timer_t a, b;
+  wheel_timer_init(&a, record);
+  wheel_timer_init(&b, record);
+  timer_wheel_add(&w, &a, start + 10 * MS, 5 * MS);
+  timer_wheel_add(&w, &b, start + 14 * MS, 2 * MS);
+  uint64_t wake = timer_wheel_next_ns(&w);
+  assert(wake == start + 15 * MS);
+  assert(run_at(&w, &log, wake) == 2);
+  assert(w.runs_fired == 1);
+  printf("test_timer_wheel_slack_coalesces passed\n");
+}
+
+static timer_wheel_t* g_wheel;
+static wheel_timer_t g_victim;
+static int g_rearms;
+
+static void rearm_self(wheel_timer_t* t, void* ctx) {
+  fire_log_t* log = ctx;
+  g_rearms++;
+  // Re-arming for "now" waits for the next run
+  timer_wheel_add(g_wheel, t, log->now, 0);
+  timer_wheel_cancel(g_wheel, &g_victim);
+}
+
+static void test_timer_wheel_callbacks_rearm_and_cancel(void) {
+  timer_wheel_t w;
+  memset(&w, 0, sizeof(w));
+  g_wheel = &w;
+  fire_log_t log = {0};
+  uint64_t start = 100 * MS;
+  run_at(&w, &log, start);
+
+  wheel_timer_t self;
+  wheel_timer_init(&self, rearm_self);
+  wheel_timer_init(&g_victim, record);
+  timer_wheel_add(&w, &g_victim, start + 1 * MS, 0);
+  timer_wheel_add(&w, &self, start + 1 * MS, 0);
+
+  // self was added last and sits first in the slot, so it cancels g_victim
+  assert(run_at(&w, &log, start + 50 * MS) == 1);
+  assert(g_rearms == 1);
+  assert(log.n == 0);
+  assert(wheel_timer_pending(&self) && !wheel_timer_pending(&g_victim));
+  assert(run_at(&w, &log, start + 51 * MS) == 1);
+  assert(g_rearms == 2);
+  timer_wheel_cancel(&w, &self);
+  assert(w.count == 0);
+  printf("test_timer_wheel_callbacks_rearm_and_cancel passed\n");
+}
+
+static void test_timer_wheel_beyond_horizon(void) {
+  timer_wheel_t w;
+  memset(&w, 0, sizeof(w));
+  fire_log_t log = {0};
+  uint64_t start = 7 * MS;
+  run_at(&w, &log, start);
+
+  // Twice the horizon: parked in the top level, placed again on cascade
+  uint64_t far = start + 2ull * (1ull << 24) * TIMER_WHEEL_TICK_NS + 3 * MS;
+  wheel_timer_t a;
+  wheel_timer_init(&a, record);
+  timer_wheel_add(&w, &a, far, 0);
+  assert(timer_wheel_next_ns(&w) == far);
+
+  assert(run_at(&w, &log, far - 1 * MS) == 0);
+  assert(wheel_timer_pending(&a));
+  assert(run_at(&w, &log, far) == 1);
+  assert(log.n == 1);
+  printf("test_timer_wheel_beyond_horizon passed\n");
+}
+
+static void test_timer_wheel_zeroed_is_empty(void) {
+  timer_wheel_t w;
+  memset(&w, 0, sizeof(w));
+  assert(timer_wheel_next_ns(&w) == UINT64_MAX);
+  assert(timer_wheel_run(&w, 123 * MS, NULL) == 0);
+
+  char report[256];
+  assert(timer_wheel_format(&w, report, sizeof(report)) > 0);
+  assert(strncmp(report, "timers: pending=0", 17) == 0);
+  printf("test_timer_wheel_zeroed_is_empty passed\n");
+}
+
+int main(void) {
+  test_timer_wheel_fires_in_order_across_levels();
+  test_timer_wheel_cancel_and_move();
+  test_timer_wheel_slack_coalesces();
+  test_timer_wheel_callbacks_rearm_and_cancel();
+  test_timer_wheel_beyond_horizon();
+  test_timer_wheel_zeroed_is_empty();
+  return 0;
+}
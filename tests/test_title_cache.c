@@ -0,0 +1,119 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "title_cache.h"
+
+static title_key_t key_of(const char* text, int width, uint32_t color) {
+  return (title_key_t){"Sans Bold 10", text, width, 20, color};
+}
+
+static cairo_surface_t* add(title_cache_t* cache, const title_key_t* key) {
+  cairo_surface_t* s = title_cache_acquire(cache, key->width, key->height);
+  assert(s);
+  return title_cache_insert(cache, key, s);
+}
+
+void test_title_cache_hit_and_key_fields(void) {
+  title_cache_t cache;
+  memset(&cache, 0, sizeof(cache));
+
+  title_key_t k = key_of("~/src/hxm", 100, 0xFFFFFFFF);
+  assert(title_cache_lookup(&cache, &k) == NULL);
+  cairo_surface_t* s = add(&cache, &k);
+  assert(title_cache_lookup(&cache, &k) == s);
+  assert(cache.hits == 1 && cache.misses == 1);
+
+  // Widths are rounded up to a size class, height is exact
+  assert(cairo_image_surface_get_width(s) == 128);
+  assert(cairo_image_surface_get_height(s) == 20);
+
+  // Every key field matters
+  title_key_t other = key_of("~/src/hxm", 101, 0xFFFFFFFF);
+  assert(title_cache_lookup(&cache, &other) == NULL);
+  other = key_of("~/src/hxm", 100, 0xFF000000);
+  assert(title_cache_lookup(&cache, &other) == NULL);
+  other = key_of("~/src", 100, 0xFFFFFFFF);
+  assert(title_cache_lookup(&cache, &other) == NULL);
+  other = k;
+  other.font = "Sans 9";
+  assert(title_cache_lookup(&cache, &other) == NULL);
+  assert(cache.misses == 5);
+
+  // The key's strings are copied
+  char text[] = "vim";
+  title_key_t mutable_key = key_of(text, 64, 0xFFFFFFFF);
+  cairo_surface_t* v = add(&cache, &mutable_key);
+  text[0] = 'x';
+  mutable_key.text = "vim";
+  assert(title_cache_lookup(&cache, &mutable_key) == v);
+  assert(title_cache_size(&cache) == 2);
+
+  title_cache_destroy(&cache);
+  printf("test_title_cache_hit_and_key_fields passed\n");
+}
+
+void test_title_cache_lru_and_pool(void) {
+  title_cache_t cache;
+  title_cache_init(&cache);
+
+  char buf[TITLE_CACHE_CAPACITY][16];
+  for (int i = 0; i < TITLE_CACHE_CAPACITY; i++) {
+    snprintf(buf[i], sizeof(buf[i]), "title %d", i);
+    title_key_t k = key_of(buf[i], 90, 0xFFFFFFFF);
+    add(&cache, &k);
+  }
+  assert(title_cache_size(&cache) == TITLE_CACHE_CAPACITY);
+
+  // Touch the oldest so the second oldest is evicted instead
+  title_key_t oldest = key_of(buf[0], 90, 0xFFFFFFFF);
+  title_key_t second = key_of(buf[1], 90, 0xFFFFFFFF);
+  assert(title_cache_lookup(&cache, &oldest) != NULL);
+  cairo_surface_t* held = title_cache_lookup(&cache, &second);
+  cairo_surface_t* third = title_cache_lookup(&cache, &(title_key_t){"Sans Bold 10", buf[2], 90, 20, 0xFFFFFFFF});
+  assert(held && third);
+  title_cache_lookup(&cache, &oldest);
+  // A render context still showing a run keeps it alive through eviction
+  cairo_surface_reference(held);
+
+  // Re-touch everything but the second and third oldest
+  for (int i = 3; i < TITLE_CACHE_CAPACITY; i++)
+    assert(title_cache_lookup(&cache, &(title_key_t){"Sans Bold 10", buf[i], 90, 20, 0xFFFFFFFF}) != NULL);
+  title_cache_lookup(&cache, &oldest);
+
+  title_key_t fresh = key_of("fresh", 90, 0xFFFFFFFF);
+  add(&cache, &fresh);
+  assert(cache.evictions == 1);
+  assert(title_cache_lookup(&cache, &second) == NULL);
+  assert(title_cache_lookup(&cache, &oldest) != NULL);
+  // Still referenced elsewhere, so it was released rather than pooled
+  assert(cache.pool_len == 0);
+  assert(cairo_surface_get_reference_count(held) == 1);
+  cairo_surface_destroy(held);
+
+  // The next eviction is unreferenced and its surface gets recycled
+  title_key_t fresh2 = key_of("fresh 2", 90, 0xFFFFFFFF);
+  add(&cache, &fresh2);
+  assert(cache.evictions == 2);
+  assert(cache.pool_len == 1);
+  assert(title_cache_lookup(&cache, &(title_key_t){"Sans Bold 10", buf[2], 90, 20, 0xFFFFFFFF}) == NULL);
+
+  // Same size class reuses it; another class allocates
+  cairo_surface_t* other_class = title_cache_acquire(&cache, 200, 20);
+  assert(cache.pool_reuses == 0);
+  cairo_surface_destroy(other_class);
+  cairo_surface_t* reused = title_cache_acquire(&cache, 70, 20);
+  assert(reused == third);
+  assert(cache.pool_reuses == 1 && cache.pool_len == 0);
+  cairo_surface_destroy(reused);
+
+  title_cache_destroy(&cache);
+  assert(title_cache_size(&cache) == 0);
+  printf("test_title_cache_lru_and_pool passed\n");
+}
+
+int main(void) {
+  test_title_cache_hit_and_key_fields();
+  test_title_cache_lru_and_pool();
+  return 0;
+}
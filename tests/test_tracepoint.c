@@ -0,0 +1,117 @@
+/*
+ * Tests for the tracepoint flight recorder and its Chrome JSON dump
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hxm.h"
+#include "tracepoint.h"
+
+static uint64_t fake_now;
+
+uint64_t monotonic_time_ns(void) { return fake_now; }
+
+// core.c is not linked; the dumper only needs a name per phase
+const char* tick_phase_name(tick_phase_t phase) { return phase == TICK_PHASE_PROCESS ? "process" : "other"; }
+
+static void tp_path(char* buf, size_t len) {
+  snprintf(buf, len, "/tmp/hxm-test-tp-%d.json", (int)getpid());
+}
+
+static char* slurp(const char* path) {
+  FILE* f = fopen(path, "r");
+  assert(f);
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char* buf = malloc((size_t)n + 1);
+  assert(buf);
+  assert(fread(buf, 1, (size_t)n, f) == (size_t)n);
+  buf[n] = '\0';
+  fclose(f);
+  return buf;
+}
+
+static void test_off_without_env(void) {
+  unsetenv(TRACEPOINTS_ENV);
+  assert(!tp_open_from_env());
+  assert(!tp_recording());
+
+  // Macros are no-ops while off
+  TP_MANAGE_START(0x400001);
+  TP_COOKIE_PUSH(5, 1);
+  tp_dump();
+}
+
+static void test_dump_json(void) {
+  char path[64];
+  tp_path(path, sizeof(path));
+  setenv(TRACEPOINTS_ENV, path, 1);
+  assert(tp_open_from_env());
+  assert(tp_recording());
+
+  TP_TICK_PHASE(TICK_PHASE_PROCESS, 2000, 1500);
+  fake_now = 3000;
+  TP_COOKIE_PUSH(42, 7);
+  fake_now = 5000;
+  TP_COOKIE_DISPATCH(42, 7, 3000);
+  TP_MANAGE_START(0x400001);
+  fake_now = 9000;
+  TP_MANAGE_FINISH(0x400001);
+  TP_FOCUS_COMMIT(0x400001);
+  assert(tp_ring.next == 6);
+
+  tp_dump();
+  char* json = slurp(path);
+  assert(strncmp(json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 39) == 0);
+  assert(strstr(json, "\"name\":\"process\",\"cat\":\"tick\",\"ph\":\"X\",\"ts\":2.000,\"dur\":1.500"));
+  assert(strstr(json, "\"args\":{\"seq\":42,\"type\":7}"));
+  assert(strstr(json, "\"ph\":\"b\",\"id\":42,\"ts\":3.000"));
+  assert(strstr(json, "\"ph\":\"e\",\"id\":42,\"ts\":5.000"));
+  assert(strstr(json, "\"name\":\"manage\",\"cat\":\"client\",\"ph\":\"b\",\"id\":4194305,\"ts\":5.000"));
+  assert(strstr(json, "\"name\":\"manage\",\"cat\":\"client\",\"ph\":\"e\",\"id\":4194305,\"ts\":9.000"));
+  assert(strstr(json, "\"name\":\"focus\""));
+  assert(strcmp(json + strlen(json) - 4, "\n]}\n") == 0);
+  free(json);
+
+  tp_close();
+  assert(!tp_recording());
+  unsetenv(TRACEPOINTS_ENV);
+  unlink(path);
+}
+
+static void test_ring_keeps_newest(void) {
+  char path[64];
+  tp_path(path, sizeof(path));
+  setenv(TRACEPOINTS_ENV, path, 1);
+  assert(tp_open_from_env());
+
+  for (uint32_t i = 1; i <= TP_RING_CAP + 3; i++) {
+    fake_now = i;
+    TP_FOCUS_COMMIT(i);
+  }
+
+  // Oldest survivor is record 4, and the dump starts from it
+  tp_dump();
+  char* json = slurp(path);
+  char* first = strstr(json, "\"name\":\"focus\"");
+  assert(first && strstr(first, "\"xid\":4}"));
+  assert(strstr(first, "\"xid\":4}") < strstr(first, "\"xid\":5}"));
+  assert(!strstr(json, "\"xid\":3}"));
+  free(json);
+
+  tp_close();
+  unsetenv(TRACEPOINTS_ENV);
+  unlink(path);
+}
+
+int main(void) {
+  test_off_without_env();
+  test_dump_json();
+  test_ring_keeps_newest();
+  return 0;
+}
@@ -30,8 +30,8 @@ void test_transient_cycle_prevention(void) {
   hot_a->state = STATE_MAPPED;
   list_init(&hot_a->transients_head);
   list_init(&hot_a->transient_sibling);
-  hash_map_init(&s.window_to_client);
-  hash_map_insert(&s.window_to_client, 10, handle_to_ptr(ha));
+  hash_map_init(&s.xid_index);
+  server_xid_bind(&s, 10, XID_CLIENT, ha);
 
   // Create Client B
   void *hot_ptr_b = NULL, *cold_ptr_b = NULL;
@@ -43,7 +43,7 @@ void test_transient_cycle_prevention(void) {
   hot_b->state = STATE_MAPPED;
   list_init(&hot_b->transients_head);
   list_init(&hot_b->transient_sibling);
-  hash_map_insert(&s.window_to_client, 20, handle_to_ptr(hb));
+  server_xid_bind(&s, 20, XID_CLIENT, hb);
 
   // 1. Make A transient for B
   // Mock reply for A
@@ -104,7 +104,7 @@ void test_transient_cycle_prevention(void) {
   hot_c->self = hc;
   list_init(&hot_c->transients_head);
   list_init(&hot_c->transient_sibling);
-  hash_map_insert(&s.window_to_client, 30, handle_to_ptr(hc));
+  server_xid_bind(&s, 30, XID_CLIENT, hc);
 
   struct {
     xcb_get_property_reply_t reply;
@@ -133,7 +133,7 @@ void test_transient_cycle_prevention(void) {
   arena_destroy(&cold_a->string_arena);  // Actually empty but for correctness
   arena_destroy(&cold_b->string_arena);
   // ...
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
   slotmap_destroy(&s.clients);
   free(s.conn);
 }
@@ -148,7 +148,7 @@ void test_transient_orphan_handled(void) {
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
 
-  hash_map_init(&s.window_to_client);
+  hash_map_init(&s.xid_index);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
@@ -159,7 +159,7 @@ void test_transient_orphan_handled(void) {
   hot->state = STATE_MAPPED;
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
-  hash_map_insert(&s.window_to_client, 40, handle_to_ptr(h));
+  server_xid_bind(&s, 40, XID_CLIENT, h);
 
   struct {
     xcb_get_property_reply_t reply;
@@ -183,7 +183,7 @@ void test_transient_orphan_handled(void) {
 
   printf("test_transient_orphan_handled passed\n");
 
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
   slotmap_destroy(&s.clients);
   free(s.conn);
 }
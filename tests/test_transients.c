@@ -19,14 +19,13 @@ void test_transient_stacking(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
-  small_vec_init(&s.active_clients);
+  hash_map_init(&s.xid_index);
+  handle_vec_init(&s.active_clients);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
@@ -43,7 +42,7 @@ void test_transient_stacking(void) {
   list_init(&hp_hot->transients_head);
   hp_hot->stacking_index = -1;
   hp_hot->stacking_layer = -1;
-  small_vec_push(&s.active_clients, handle_to_ptr(hp));
+  handle_vec_push(&s.active_clients, hp);
   stack_raise(&s, hp);
 
   // Allocate Transient
@@ -55,28 +54,28 @@ void test_transient_stacking(void) {
   ht_hot->frame = 20;
   ht_hot->state = STATE_MAPPED;
   ht_hot->layer = LAYER_NORMAL;
-  ht_hot->transient_for = hp;
+  client_set_transient_for(&s, ht_hot, hp);
   list_init(&ht_hot->transients_head);
   list_init(&ht_hot->transient_sibling);
   ht_hot->stacking_index = -1;
   ht_hot->stacking_layer = -1;
-  small_vec_push(&s.active_clients, handle_to_ptr(ht));
+  handle_vec_push(&s.active_clients, ht);
   list_insert(&ht_hot->transient_sibling, hp_hot->transients_head.prev, &hp_hot->transients_head);
 
   stack_place_above(&s, ht, hp);
 
   // Verify order: P then T
-  assert(s.layers[LAYER_NORMAL].length == 2);
-  assert((handle_t)(uintptr_t)s.layers[LAYER_NORMAL].items[0] == hp);
-  assert((handle_t)(uintptr_t)s.layers[LAYER_NORMAL].items[1] == ht);
+  assert(s.screens[0].layers[LAYER_NORMAL].length == 2);
+  assert(s.screens[0].layers[LAYER_NORMAL].items[0] == hp);
+  assert(s.screens[0].layers[LAYER_NORMAL].items[1] == ht);
 
   // Raise parent, should raise transient too
   stack_raise(&s, hp);
   // After raise, T should still be above P, and both at the end of the layer
   // list
-  assert(s.layers[LAYER_NORMAL].length == 2);
-  assert((handle_t)(uintptr_t)s.layers[LAYER_NORMAL].items[0] == hp);
-  assert((handle_t)(uintptr_t)s.layers[LAYER_NORMAL].items[1] == ht);
+  assert(s.screens[0].layers[LAYER_NORMAL].length == 2);
+  assert(s.screens[0].layers[LAYER_NORMAL].items[0] == hp);
+  assert(s.screens[0].layers[LAYER_NORMAL].items[1] == ht);
 
   printf("test_transient_stacking passed\n");
   printf("test_transient_stacking passed\n");
@@ -90,8 +89,9 @@ void test_transient_stacking(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   free(s.conn);
 }
 
@@ -99,13 +99,11 @@ void test_transient_focus_return(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
-  list_init(&s.focus_history);
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
-  small_vec_init(&s.active_clients);
+  hash_map_init(&s.xid_index);
+  handle_vec_init(&s.active_clients);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
@@ -118,9 +116,8 @@ void test_transient_focus_return(void) {
   hp_hot->xid = 1;
   hp_hot->frame = 10;
   hp_hot->state = STATE_MAPPED;
-  list_init(&hp_hot->focus_node);
   list_init(&hp_hot->transients_head);
-  small_vec_push(&s.active_clients, handle_to_ptr(hp));
+  handle_vec_push(&s.active_clients, hp);
 
   // Transient
   void *t_hot_ptr = NULL, *t_cold_ptr = NULL;
@@ -130,11 +127,10 @@ void test_transient_focus_return(void) {
   ht_hot->xid = 2;
   ht_hot->frame = 20;
   ht_hot->state = STATE_MAPPED;
-  ht_hot->transient_for = hp;
-  list_init(&ht_hot->focus_node);
+  client_set_transient_for(&s, ht_hot, hp);
   list_init(&ht_hot->transients_head);
   list_init(&ht_hot->transient_sibling);
-  small_vec_push(&s.active_clients, handle_to_ptr(ht));
+  handle_vec_push(&s.active_clients, ht);
 
   wm_set_focus(&s, hp);
   wm_set_focus(&s, ht);
@@ -159,8 +155,9 @@ void test_transient_focus_return(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   free(s.conn);
 }
 
@@ -168,12 +165,11 @@ void test_transient_parent_unmanage_unlinks_child(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
-  small_vec_init(&s.active_clients);
+  hash_map_init(&s.xid_index);
+  handle_vec_init(&s.active_clients);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
@@ -187,7 +183,7 @@ void test_transient_parent_unmanage_unlinks_child(void) {
   hp_hot->state = STATE_MAPPED;
   list_init(&hp_hot->transients_head);
   list_init(&hp_hot->transient_sibling);
-  small_vec_push(&s.active_clients, handle_to_ptr(hp));
+  handle_vec_push(&s.active_clients, hp);
 
   void *t_hot_ptr = NULL, *t_cold_ptr = NULL;
   handle_t ht = slotmap_alloc(&s.clients, &t_hot_ptr, &t_cold_ptr);
@@ -196,16 +192,16 @@ void test_transient_parent_unmanage_unlinks_child(void) {
   ht_hot->xid = 2;
   ht_hot->frame = 20;
   ht_hot->state = STATE_MAPPED;
-  ht_hot->transient_for = hp;
+  client_set_transient_for(&s, ht_hot, hp);
   list_init(&ht_hot->transients_head);
   list_init(&ht_hot->transient_sibling);
-  small_vec_push(&s.active_clients, handle_to_ptr(ht));
+  handle_vec_push(&s.active_clients, ht);
   list_insert(&ht_hot->transient_sibling, hp_hot->transients_head.prev, &hp_hot->transients_head);
 
-  hash_map_insert(&s.window_to_client, hp_hot->xid, handle_to_ptr(hp));
-  hash_map_insert(&s.frame_to_client, hp_hot->frame, handle_to_ptr(hp));
-  hash_map_insert(&s.window_to_client, ht_hot->xid, handle_to_ptr(ht));
-  hash_map_insert(&s.frame_to_client, ht_hot->frame, handle_to_ptr(ht));
+  server_xid_bind(&s, hp_hot->xid, XID_CLIENT, hp);
+  server_xid_bind(&s, hp_hot->frame, XID_FRAME, hp);
+  server_xid_bind(&s, ht_hot->xid, XID_CLIENT, ht);
+  server_xid_bind(&s, ht_hot->frame, XID_FRAME, ht);
 
   client_unmanage(&s, hp);
 
@@ -223,10 +219,10 @@ void test_transient_parent_unmanage_unlinks_child(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  handle_vec_destroy(&s.active_clients);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -234,13 +230,11 @@ void test_transient_unmanage_unlinks_from_parent(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
-  list_init(&s.focus_history);
-  small_vec_init(&s.active_clients);
+  hash_map_init(&s.xid_index);
+  handle_vec_init(&s.active_clients);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
@@ -252,10 +246,9 @@ void test_transient_unmanage_unlinks_from_parent(void) {
   hp_hot->xid = 11;
   hp_hot->frame = 111;
   hp_hot->state = STATE_MAPPED;
-  list_init(&hp_hot->focus_node);
   list_init(&hp_hot->transients_head);
   list_init(&hp_hot->transient_sibling);
-  small_vec_push(&s.active_clients, handle_to_ptr(hp));
+  handle_vec_push(&s.active_clients, hp);
 
   void *t_hot_ptr = NULL, *t_cold_ptr = NULL;
   handle_t ht = slotmap_alloc(&s.clients, &t_hot_ptr, &t_cold_ptr);
@@ -264,17 +257,16 @@ void test_transient_unmanage_unlinks_from_parent(void) {
   ht_hot->xid = 22;
   ht_hot->frame = 222;
   ht_hot->state = STATE_MAPPED;
-  ht_hot->transient_for = hp;
-  list_init(&ht_hot->focus_node);
+  client_set_transient_for(&s, ht_hot, hp);
   list_init(&ht_hot->transients_head);
   list_init(&ht_hot->transient_sibling);
-  small_vec_push(&s.active_clients, handle_to_ptr(ht));
+  handle_vec_push(&s.active_clients, ht);
   list_insert(&ht_hot->transient_sibling, hp_hot->transients_head.prev, &hp_hot->transients_head);
 
-  hash_map_insert(&s.window_to_client, hp_hot->xid, handle_to_ptr(hp));
-  hash_map_insert(&s.frame_to_client, hp_hot->frame, handle_to_ptr(hp));
-  hash_map_insert(&s.window_to_client, ht_hot->xid, handle_to_ptr(ht));
-  hash_map_insert(&s.frame_to_client, ht_hot->frame, handle_to_ptr(ht));
+  server_xid_bind(&s, hp_hot->xid, XID_CLIENT, hp);
+  server_xid_bind(&s, hp_hot->frame, XID_FRAME, hp);
+  server_xid_bind(&s, ht_hot->xid, XID_CLIENT, ht);
+  server_xid_bind(&s, ht_hot->frame, XID_FRAME, ht);
 
   wm_set_focus(&s, hp);
   wm_set_focus(&s, ht);
@@ -296,10 +288,10 @@ void test_transient_unmanage_unlinks_from_parent(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  handle_vec_destroy(&s.active_clients);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -13,13 +13,12 @@ void test_idempotent_unmanage(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
-  list_init(&s.focus_history);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
@@ -37,7 +36,6 @@ void test_idempotent_unmanage(void) {
   hot->stacking_layer = -1;
   list_init(&hot->transient_sibling);
   list_init(&hot->transients_head);
-  list_init(&hot->focus_node);
   arena_init(&cold->string_arena, 512);
 
   // 1. First call to unmanage
@@ -53,13 +51,12 @@ void test_destroy_unmanage_race(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
-  list_init(&s.focus_history);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
@@ -77,7 +74,6 @@ void test_destroy_unmanage_race(void) {
   hot->stacking_layer = -1;
   list_init(&hot->transient_sibling);
   list_init(&hot->transients_head);
-  list_init(&hot->focus_node);
   arena_init(&cold->string_arena, 512);
 
   // Simulate DestroyNotify followed by UnmapNotify
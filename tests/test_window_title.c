@@ -21,7 +21,7 @@ static handle_t h;
 // Setup
 static void setup(void) {
   memset(&s, 0, sizeof(s));
-  small_vec_init(&s.active_clients);
+  handle_vec_init(&s.active_clients);
   cookie_jar_init(&s.cookie_jar);
 
   // Initialize slotmap
@@ -52,7 +52,7 @@ static void teardown(void) {
     arena_destroy(&cold->string_arena);
   }
 
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   cookie_jar_destroy(&s.cookie_jar);
   slotmap_destroy(&s.clients);
 }
@@ -72,7 +72,7 @@ static void test_net_wm_name_update(void) {
   setup();
 
   // 1. Mark title dirty
-  hot->dirty |= DIRTY_TITLE;
+  server_mark_dirty(&s, hot, DIRTY_TITLE);
 
   // 2. Simulate reply for _NET_WM_NAME
   cookie_slot_t slot = {0};
@@ -97,7 +97,7 @@ static void test_wm_name_fallback(void) {
   setup();
 
   // 1. Mark title dirty
-  hot->dirty |= DIRTY_TITLE;
+  server_mark_dirty(&s, hot, DIRTY_TITLE);
 
   // 2. Simulate empty _NET_WM_NAME (or missing)
   cookie_slot_t slot_net = {0};
@@ -155,9 +155,39 @@ static void test_title_truncation(void) {
   printf("PASS: Title truncation\n");
 }
 
+static void test_title_churn_compacts(void) {
+  printf("Testing title churn compaction...\n");
+  setup();
+
+  cookie_slot_t slot = {0};
+  slot.type = COOKIE_GET_PROPERTY;
+  slot.client = h;
+  slot.data = ((uint64_t)hot->xid << 32) | atoms._NET_WM_NAME;
+
+  char title[32];
+  for (int i = 0; i < 2000; i++) {
+    int len = snprintf(title, sizeof(title), "vim file%d.c", i);
+    xcb_get_property_reply_t* rep = make_string_reply(atoms.UTF8_STRING, title, len);
+    wm_handle_reply(&s, &slot, rep, NULL);
+    free(rep);
+
+    assert(strcmp(cold->title, title) == 0);
+    assert(cold->title == cold->base_title);
+    // Dead copies never outgrow the threshold by more than a block
+    assert(cold->string_arena.reserved <= 2u * 4096u);
+  }
+
+  assert(s.mem_budget.evicted[MEM_EVICT_STRINGS] > 0);
+  assert(s.mem_budget.evicted_bytes[MEM_EVICT_STRINGS] >= 4096u * s.mem_budget.evicted[MEM_EVICT_STRINGS]);
+
+  teardown();
+  printf("PASS: Title churn compaction\n");
+}
+
 int main(void) {
   test_net_wm_name_update();
   test_wm_name_fallback();
   test_title_truncation();
+  test_title_churn_compacts();
   return 0;
 }
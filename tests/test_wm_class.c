@@ -13,8 +13,8 @@ void test_wm_class_split(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
   atoms.WM_CLASS = 1;
 
@@ -57,8 +57,8 @@ void test_wm_class_split(void) {
 
   // Test update with same values (no new allocation in arena ideally, but at
   // least no change)
-  char* old_instance = cold->wm_instance;
-  char* old_class = cold->wm_class;
+  const char* old_instance = cold->wm_instance;
+  const char* old_class = cold->wm_class;
   wm_handle_reply(&s, &slot, &mock_r, NULL);
   assert(cold->wm_instance == old_instance);
   assert(cold->wm_class == old_class);
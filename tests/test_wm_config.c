@@ -15,7 +15,7 @@ void test_configure_request_managed(void) {
     fprintf(stderr, "Failed to init slotmap\n");
     return;
   }
-  hash_map_init(&s.window_to_client);
+  hash_map_init(&s.xid_index);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
@@ -29,7 +29,7 @@ void test_configure_request_managed(void) {
   cold->hints.max_w = 200;
   cold->hints.max_h = 200;
 
-  hash_map_insert(&s.window_to_client, 123, handle_to_ptr(h));
+  server_xid_bind(&s, 123, XID_CLIENT, h);
 
   pending_config_t ev;
   memset(&ev, 0, sizeof(ev));
@@ -51,7 +51,7 @@ void test_configure_request_managed(void) {
   printf("test_configure_request_managed passed\n");
 
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
 }
 
 int main(void) {
@@ -13,6 +13,9 @@
 
 extern void xcb_stubs_reset(void);
 extern uint32_t stub_last_image_w;
+extern int stub_put_image_count;
+extern int stub_configure_count_at_first_image;
+extern int stub_configure_window_count;
 
 static void setup_server(server_t* s) {
   memset(s, 0, sizeof(*s));
@@ -20,24 +23,23 @@ static void setup_server(server_t* s) {
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
 
-  s->root = 1;
-  s->root_visual = 1;
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
 
   config_init_defaults(&s->config);
   s->config.theme.border_width = 2;
   s->config.theme.title_height = 18;
 
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
-  list_init(&s->focus_history);
+  hash_map_init(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
 
   slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
   cookie_jar_init(&s->cookie_jar);
-  small_vec_init(&s->active_clients);
+  handle_vec_init(&s->active_clients);
+  handle_vec_init(&s->dirty_clients);
   arena_init(&s->tick_arena, 4096);
 
   s->in_commit_phase = true;
@@ -57,11 +59,11 @@ static void cleanup_server(server_t* s) {
   }
   slotmap_destroy(&s->clients);
   cookie_jar_destroy(&s->cookie_jar);
-  small_vec_destroy(&s->active_clients);
-  hash_map_destroy(&s->window_to_client);
-  hash_map_destroy(&s->frame_to_client);
+  handle_vec_destroy(&s->active_clients);
+  handle_vec_destroy(&s->dirty_clients);
+  hash_map_destroy(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_destroy(&s->layers[i]);
+    handle_vec_destroy(&s->screens[0].layers[i]);
   arena_destroy(&s->tick_arena);
   config_destroy(&s->config);
   xcb_disconnect(s->conn);
@@ -89,13 +91,12 @@ static handle_t add_client(server_t* s, xcb_window_t win, xcb_window_t frame) {
   hot->server = hot->desired;
   hot->stacking_index = -1;
   hot->stacking_layer = -1;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s->window_to_client, win, handle_to_ptr(h));
-  hash_map_insert(&s->frame_to_client, frame, handle_to_ptr(h));
-  small_vec_push(&s->active_clients, handle_to_ptr(h));
+  server_xid_bind(s, win, XID_CLIENT, h);
+  server_xid_bind(s, frame, XID_FRAME, h);
+  handle_vec_push(&s->active_clients, h);
   return h;
 }
 
@@ -110,7 +111,8 @@ static void test_frame_damage_triggers_flush(void) {
   assert(hot && cold);
 
   hot->dirty = DIRTY_NONE;
-  cold->frame_damage = dirty_region_make(0, 0, 12, 10);
+  cold->frame_damage = dirty_rects_make(0, 0, 12, 10);
+  server_queue_client(&s, hot);
 
   xcb_stubs_reset();
   stub_last_image_w = 0;
@@ -118,7 +120,7 @@ static void test_frame_damage_triggers_flush(void) {
   bool flushed = wm_flush_dirty(&s, monotonic_time_ns());
   assert(flushed);
   assert(stub_last_image_w > 0);
-  assert(!cold->frame_damage.valid);
+  assert(dirty_rects_empty(&cold->frame_damage));
 
   cleanup_server(&s);
   printf("PASS: frame damage triggers flush\n");
@@ -136,7 +138,8 @@ static void test_undecorated_frame_dirty_quiesces(void) {
 
   hot->flags |= CLIENT_FLAG_UNDECORATED;
   hot->dirty = DIRTY_FRAME_ALL | DIRTY_FRAME_STYLE | DIRTY_FRAME_TITLE | DIRTY_TITLE;
-  cold->frame_damage = dirty_region_make(0, 0, 16, 12);
+  server_queue_client(&s, hot);
+  cold->frame_damage = dirty_rects_make(0, 0, 16, 12);
 
   xcb_stubs_reset();
   stub_last_image_w = 0;
@@ -146,7 +149,7 @@ static void test_undecorated_frame_dirty_quiesces(void) {
 
   uint32_t frame_dirty_mask = DIRTY_FRAME_ALL | DIRTY_FRAME_TITLE | DIRTY_FRAME_BUTTONS | DIRTY_FRAME_BORDER | DIRTY_FRAME_STYLE | DIRTY_TITLE;
   assert((hot->dirty & frame_dirty_mask) == 0);
-  assert(!cold->frame_damage.valid);
+  assert(dirty_rects_empty(&cold->frame_damage));
   assert(stub_last_image_w == 0);
 
   flushed = wm_flush_dirty(&s, monotonic_time_ns());
@@ -156,9 +159,91 @@ static void test_undecorated_frame_dirty_quiesces(void) {
   printf("PASS: undecorated frame dirty state quiesces\n");
 }
 
+static void test_flush_visits_only_queued_clients(void) {
+  printf("Testing wm_flush_dirty walks the dirty worklist...\n");
+  server_t s;
+  setup_server(&s);
+
+  handle_t ha = add_client(&s, 300, 301);
+  handle_t hb = add_client(&s, 310, 311);
+  client_hot_t* a = server_chot(&s, ha);
+  client_hot_t* b = server_chot(&s, hb);
+  assert(a && b);
+  a->server = a->desired;
+  b->server = b->desired;
+  a->dirty = DIRTY_NONE;
+  b->dirty = DIRTY_NONE;
+
+  // Marking twice queues once
+  server_mark_dirty(&s, a, DIRTY_OPACITY);
+  server_mark_dirty(&s, a, DIRTY_OPACITY);
+  assert(s.dirty_clients.length == 1);
+  assert(a->dirty_queued);
+
+  // Bits set behind the worklist's back are not seen by the commit phase
+  b->dirty = DIRTY_OPACITY;
+
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(a->dirty == DIRTY_NONE);
+  assert(!a->dirty_queued);
+  assert(b->dirty == DIRTY_OPACITY);
+  assert(s.dirty_clients.length == 0);
+
+  // Queued clients destroyed before the commit are dropped
+  server_mark_dirty(&s, b, DIRTY_NONE);
+  client_cold_t* bcold = server_ccold(&s, hb);
+  arena_destroy(&bcold->string_arena);
+  client_render_payload_destroy(bcold);
+  slotmap_free(&s.clients, hb);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(s.dirty_clients.length == 0);
+
+  cleanup_server(&s);
+  printf("PASS: flush visits only queued clients\n");
+}
+
+static void test_frames_painted_in_one_pass(void) {
+  printf("Testing frame paints are batched after geometry...\n");
+  server_t s;
+  setup_server(&s);
+
+  handle_t ha = add_client(&s, 400, 401);
+  handle_t hb = add_client(&s, 410, 411);
+  client_hot_t* a = server_chot(&s, ha);
+  client_hot_t* b = server_chot(&s, hb);
+  assert(a && b);
+  a->dirty = DIRTY_NONE;
+  b->dirty = DIRTY_NONE;
+
+  // b is queued first, but a's move must not be interleaved with paints
+  server_mark_dirty(&s, b, DIRTY_FRAME_TITLE);
+  a->desired = (rect_t){40, 50, 200, 100};
+  server_mark_dirty(&s, a, DIRTY_GEOM | DIRTY_FRAME_ALL);
+
+  xcb_stubs_reset();
+  assert(wm_flush_dirty(&s, monotonic_time_ns()));
+  assert(stub_put_image_count == 2);
+  assert(stub_configure_window_count > 0);
+  assert(stub_configure_count_at_first_image == stub_configure_window_count);
+  assert(s.frame_pass.length == 0);
+  assert((a->dirty & DIRTY_FRAME_ALL) == 0);
+  assert((b->dirty & DIRTY_FRAME_TITLE) == 0);
+
+  // Nothing left to paint next tick
+  xcb_stubs_reset();
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_put_image_count == 0);
+
+  handle_vec_destroy(&s.frame_pass);
+  cleanup_server(&s);
+  printf("PASS: frames painted in one pass\n");
+}
+
 int main(void) {
   test_frame_damage_triggers_flush();
   test_undecorated_frame_dirty_quiesces();
+  test_flush_visits_only_queued_clients();
+  test_frames_painted_in_one_pass();
   printf("All wm_dirty frame damage tests passed\n");
   return 0;
 }
@@ -12,6 +12,8 @@
 #include "xcb_utils.h"
 
 extern int stub_grab_button_count;
+extern int stub_ungrab_button_count;
+extern bool xcb_stubs_button_grab_freezes(xcb_window_t window, uint8_t button, uint16_t state);
 extern void xcb_stubs_reset(void);
 extern int stub_map_window_count;
 extern int stub_unmap_window_count;
@@ -29,20 +31,18 @@ static void setup_server_for_manage(server_t* s) {
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
 
-  s->root = 1;
-  s->root_depth = 24;
-  s->root_visual = 1;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
+  s->screens[0].root = 1;
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual = 1;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
 
-  s->current_desktop = 0;
-  s->desktop_count = 4;
+  s->screens[0].current_desktop = 0;
+  s->screens[0].desktop_count = 4;
   s->focused_client = HANDLE_INVALID;
 
-  list_init(&s->focus_history);
-  hash_map_init(&s->window_to_client);
-  hash_map_init(&s->frame_to_client);
+  hash_map_init(&s->xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s->layers[i]);
+    handle_vec_init(&s->screens[0].layers[i]);
 
   s->config.theme.border_width = 1;
   s->config.theme.title_height = 10;
@@ -69,11 +69,10 @@ static handle_t alloc_test_client(server_t* s, xcb_window_t xid, int32_t desktop
   hot->desktop = desktop;
   hot->initial_state = XCB_ICCCM_WM_STATE_NORMAL;
   hot->desired = (rect_t){0, 0, 200, 150};
-  cold->visual_id = s->root_visual;
-  cold->depth = s->root_depth;
+  cold->visual_id = s->screens[0].root_visual;
+  cold->depth = s->screens[0].root_depth;
   hot->stacking_index = -1;
   hot->stacking_layer = -1;
-  list_init(&hot->focus_node);
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
   return h;
@@ -95,15 +94,13 @@ void test_focus_on_finish_manage(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);  // Fake connection  // Fake connection
-  list_init(&s.focus_history);
   s.focused_client = HANDLE_INVALID;
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
+  hash_map_init(&s.xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
@@ -117,19 +114,18 @@ void test_focus_on_finish_manage(void) {
   memset(h1_cold_ptr, 0, sizeof(client_cold_t));
   client_render_payload_init(h1_cold);
   h1_hot->self = h1;
-  h1_hot->xid = 101;
+  h1_hot->xid = 0x1001;
   h1_hot->type = WINDOW_TYPE_NORMAL;
   h1_hot->state = STATE_NEW;
   h1_hot->focus_override = -1;
   h1_hot->transient_for = HANDLE_INVALID;
   h1_hot->desktop = 0;
-  list_init(&h1_hot->focus_node);
   h1_hot->stacking_index = -1;
   h1_hot->stacking_layer = -1;
   list_init(&h1_hot->transients_head);
   list_init(&h1_hot->transient_sibling);
 
-  s.current_desktop = 0;
+  s.screens[0].current_desktop = 0;
   stub_grab_button_count = 0;
   client_finish_manage(&s, h1);
 
@@ -145,13 +141,12 @@ void test_focus_on_finish_manage(void) {
   memset(h2_hot, 0, sizeof(client_hot_t));
   client_render_payload_init(h2_cold);
   h2_hot->self = h2;
-  h2_hot->xid = 102;
+  h2_hot->xid = 0x1002;
   h2_hot->type = WINDOW_TYPE_NORMAL;
   h2_hot->state = STATE_NEW;
   h2_hot->focus_override = -1;
   h2_hot->transient_for = HANDLE_INVALID;
   h2_hot->desktop = 0;
-  list_init(&h2_hot->focus_node);
   h2_hot->stacking_index = -1;
   h2_hot->stacking_layer = -1;
   list_init(&h2_hot->transients_head);
@@ -168,13 +163,12 @@ void test_focus_on_finish_manage(void) {
   memset(h3_hot, 0, sizeof(client_hot_t));
   client_render_payload_init(h3_cold);
   h3_hot->self = h3;
-  h3_hot->xid = 103;
+  h3_hot->xid = 0x1003;
   h3_hot->type = WINDOW_TYPE_DIALOG;
   h3_hot->state = STATE_NEW;
   h3_hot->focus_override = -1;
   h3_hot->transient_for = HANDLE_INVALID;
   h3_hot->desktop = 0;
-  list_init(&h3_hot->focus_node);
   h3_hot->stacking_index = -1;
   h3_hot->stacking_layer = -1;
   list_init(&h3_hot->transients_head);
@@ -194,9 +188,9 @@ void test_focus_on_finish_manage(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -204,15 +198,13 @@ void test_mru_cycling(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);  // Fake connection
-  list_init(&s.focus_history);
   s.focused_client = HANDLE_INVALID;
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
+  hash_map_init(&s.xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
 
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
@@ -232,7 +224,6 @@ void test_mru_cycling(void) {
     hot->state = STATE_MAPPED;
     hot->focus_override = -1;
     hot->desktop = 0;
-    list_init(&hot->focus_node);
     hot->stacking_index = -1;
     hot->stacking_layer = -1;
     list_init(&hot->transients_head);
@@ -269,7 +260,7 @@ void test_mru_cycling(void) {
   // Test workspace filtering
   client_hot_t* hot2 = server_chot(&s, h[2]);
   hot2->desktop = 1;
-  s.current_desktop = 0;
+  s.screens[0].current_desktop = 0;
 
   // Start: [0, 2, 1], focused=0
   // Cycle Next from 0 -> skips 2 (wrong desktop) -> skips 1 (DOCK) -> loops
@@ -288,9 +279,9 @@ void test_mru_cycling(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -298,15 +289,13 @@ void test_move_interaction(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);  // Fake connection
-  list_init(&s.focus_history);
   s.focused_client = HANDLE_INVALID;
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
+  hash_map_init(&s.xid_index);
   for (int i = 0; i < LAYER_COUNT; i++)
-    small_vec_init(&s.layers[i]);
+    handle_vec_init(&s.screens[0].layers[i]);
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
   cookie_jar_init(&s.cookie_jar);
@@ -324,14 +313,13 @@ void test_move_interaction(void) {
   hot->server.w = 100;
   hot->server.h = 100;
   hot->desired = hot->server;
-  list_init(&hot->focus_node);
   hot->stacking_index = -1;
   hot->stacking_layer = -1;
   list_init(&hot->transients_head);
   list_init(&hot->transient_sibling);
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
-  hash_map_insert(&s.frame_to_client, hot->frame, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
+  server_xid_bind(&s, hot->frame, XID_FRAME, h);
 
   // Simulate Alt + Button 1 Press on window
   xcb_button_press_event_t ev = {0};
@@ -348,7 +336,7 @@ void test_move_interaction(void) {
 
   // Simulate Motion
   xcb_motion_notify_event_t mev = {0};
-  mev.event = s.root;
+  mev.event = s.screens[0].root;
   mev.root_x = 60;  // Moved by 10
   mev.root_y = 70;  // Moved by 20
   mev.state = XCB_KEY_BUT_MASK_BUTTON_1;
@@ -370,10 +358,10 @@ void test_move_interaction(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
   cookie_jar_destroy(&s.cookie_jar);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -381,11 +369,10 @@ void test_title_update(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);  // Fake connection
-  hash_map_init(&s.window_to_client);
-  hash_map_init(&s.frame_to_client);
+  hash_map_init(&s.xid_index);
   if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
     return;
 
@@ -439,9 +426,9 @@ void test_title_update(void) {
     }
   }
   arena_destroy(&cold->string_arena);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -491,16 +478,16 @@ void test_finish_manage_visibility(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
 void test_finish_manage_show_desktop_hides(void) {
   server_t s;
   setup_server_for_manage(&s);
-  s.showing_desktop = true;
+  s.screens[0].showing_desktop = true;
 
   handle_t h = alloc_test_client(&s, 301, 0);
   stub_map_window_count = 0;
@@ -524,9 +511,9 @@ void test_finish_manage_show_desktop_hides(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -564,9 +551,9 @@ void test_finish_manage_focus_override(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -616,9 +603,9 @@ void test_finish_manage_no_focus_for_dock_desktop(void) {
     }
   }
   arena_destroy(&s.tick_arena);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -666,9 +653,9 @@ void test_iconify_updates_focus(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -706,9 +693,9 @@ void test_restore_maps_window(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -740,9 +727,9 @@ void test_set_focus_ignores_unmapped(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -765,7 +752,7 @@ void test_set_focus_revert_policy_and_root_fallback(void) {
   client_unmanage(&s, h1);
   wm_flush_dirty(&s, monotonic_time_ns());
   assert(s.focused_client == HANDLE_INVALID);
-  assert(stub_last_input_focus_window == s.root);
+  assert(stub_last_input_focus_window == s.screens[0].root);
   assert(stub_last_input_focus_revert == XCB_INPUT_FOCUS_POINTER_ROOT);
 
   printf("test_set_focus_revert_policy_and_root_fallback passed\n");
@@ -780,9 +767,9 @@ void test_set_focus_revert_policy_and_root_fallback(void) {
     }
   }
   arena_destroy(&s.tick_arena);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -816,9 +803,9 @@ void test_unmanage_focus_prefers_parent(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
@@ -857,12 +844,67 @@ void test_unmanage_focus_falls_back_to_mru(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
-  hash_map_destroy(&s.frame_to_client);
+  hash_map_destroy(&s.xid_index);
   free(s.conn);
 }
 
+void test_button_grabs_follow_focus(void) {
+  server_t s;
+  setup_server_for_manage(&s);
+
+  handle_t h1 = alloc_test_client(&s, 801, 0);
+  handle_t h2 = alloc_test_client(&s, 802, 0);
+  set_client_mapped(&s, h1, 1801);
+  set_client_mapped(&s, h2, 1802);
+  server_ccold(&s, h1)->can_focus = true;
+  server_ccold(&s, h2)->can_focus = true;
+  client_setup_grabs(&s, h1);
+  client_setup_grabs(&s, h2);
+  assert(xcb_stubs_button_grab_freezes(801, 1, 0));
+  assert(xcb_stubs_button_grab_freezes(802, 2, XCB_MOD_MASK_CONTROL));
+
+  // The focused client's plain clicks go straight to it; Alt drags still reach the WM
+  wm_set_focus(&s, h1);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(s.button_grab_client == h1);
+  assert(!xcb_stubs_button_grab_freezes(801, 1, 0));
+  assert(!xcb_stubs_button_grab_freezes(801, 2, XCB_MOD_MASK_1));
+  assert(xcb_stubs_button_grab_freezes(801, 1, XCB_MOD_MASK_1));
+  assert(xcb_stubs_button_grab_freezes(801, 3, XCB_MOD_MASK_1 | XCB_MOD_MASK_2 | XCB_MOD_MASK_LOCK));
+  assert(xcb_stubs_button_grab_freezes(802, 1, 0));
+
+  // Nothing changes while focus stays put
+  int grabs = stub_grab_button_count;
+  int ungrabs = stub_ungrab_button_count;
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_grab_button_count == grabs && stub_ungrab_button_count == ungrabs);
+
+  // Moving focus hands the grabs over in the same commit
+  wm_set_focus(&s, h2);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(s.button_grab_client == h2);
+  assert(xcb_stubs_button_grab_freezes(801, 1, 0));
+  assert(!xcb_stubs_button_grab_freezes(802, 1, 0));
+
+  printf("test_button_grabs_follow_focus passed\n");
+  for (uint32_t i = 1; i < s.clients.cap; i++) {
+    if (s.clients.hdr[i].live) {
+      client_cold_t* cold = server_ccold(&s, handle_make(i, s.clients.hdr[i].gen));
+      if (cold)
+        client_render_payload_destroy(cold);
+    }
+  }
+  arena_destroy(&s.tick_arena);
+  focus_mru_destroy(&s.focus_mru);
+  slotmap_destroy(&s.clients);
+  hash_map_destroy(&s.xid_index);
+  for (int i = 0; i < LAYER_COUNT; i++)
+    handle_vec_destroy(&s.screens[0].layers[i]);
+  xcb_disconnect(s.conn);
+}
+
 int main(void) {
   test_focus_on_finish_manage();
   test_mru_cycling();
@@ -878,5 +920,6 @@ int main(void) {
   test_set_focus_revert_policy_and_root_fallback();
   test_unmanage_focus_prefers_parent();
   test_unmanage_focus_falls_back_to_mru();
+  test_button_grabs_follow_focus();
   return 0;
 }
@@ -14,8 +14,8 @@ void test_wm_icon(void) {
   server_t s;
   memset(&s, 0, sizeof(s));
   s.is_test = true;
-  s.root_depth = 24;
-  s.root_visual_type = xcb_get_visualtype(NULL, 0);
+  s.screens[0].root_depth = 24;
+  s.screens[0].root_visual_type = xcb_get_visualtype(NULL, 0);
   s.conn = (xcb_connection_t*)malloc(1);
 
   atoms._NET_WM_ICON = 99;
@@ -94,7 +94,127 @@ void test_wm_icon(void) {
   free(s.conn);
 }
 
+extern int (*stub_poll_for_reply_hook)(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error);
+
+static xcb_get_property_reply_t* g_next_reply = NULL;
+
+static int poll_next_reply(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) {
+  (void)c;
+  (void)request;
+  if (!g_next_reply)
+    return 0;
+  *reply = g_next_reply;
+  *error = NULL;
+  g_next_reply = NULL;
+  return 1;
+}
+
+static const cookie_slot_t* find_icon_cookie(const cookie_jar_t* cj, cookie_type_t type) {
+  for (size_t i = 0; i < cj->cap; i++) {
+    if (cj->slots[i].live && cj->slots[i].type == type)
+      return &cj->slots[i];
+  }
+  return NULL;
+}
+
+// Answer the oldest pending read with a CARDINAL/32 reply
+static void reply_to_icon_read(server_t* s, const uint32_t* words, uint32_t count, uint32_t bytes_after) {
+  xcb_get_property_reply_t* r = calloc(1, sizeof(*r) + count * sizeof(uint32_t));
+  assert(r);
+  r->format = 32;
+  r->type = XCB_ATOM_CARDINAL;
+  r->value_len = count;
+  r->bytes_after = bytes_after;
+  if (count)
+    memcpy(r + 1, words, count * sizeof(uint32_t));
+
+  g_next_reply = r;
+  cookie_jar_mark_replies_may_exist(&s->cookie_jar);
+  cookie_jar_drain(&s->cookie_jar, s->conn, s, 1);
+  assert(g_next_reply == NULL);
+}
+
+void test_wm_icon_lazy_fetch(void) {
+  server_t s;
+  memset(&s, 0, sizeof(s));
+  s.is_test = true;
+  s.conn = (xcb_connection_t*)malloc(1);
+  cookie_jar_init(&s.cookie_jar);
+  stub_poll_for_reply_hook = poll_next_reply;
+
+  atoms._NET_WM_ICON = 99;
+
+  if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t)))
+    return;
+
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = (client_hot_t*)hot_ptr;
+  client_cold_t* cold = (client_cold_t*)cold_ptr;
+  hot->xid = 123;
+  hot->state = STATE_MAPPED;
+  cold->icon_fetch.phase = ICON_FETCH_WANTED;
+
+  // Property: 2x2 image at word 0, 16x16 image at word 6
+  const uint32_t total_words = (2 + 4) + (2 + 256);
+
+  // Nothing is read until a draw asks for the icon
+  assert(s.cookie_jar.live_count == 0);
+  client_icon_request(&s, h);
+  assert(cold->icon_fetch.phase == ICON_FETCH_SCANNING);
+  assert(s.cookie_jar.live_count == 1);
+
+  // A property change mid-walk makes the in-flight header stale
+  const cookie_slot_t* first = find_icon_cookie(&s.cookie_jar, COOKIE_GET_PROPERTY_ICON_HEADER);
+  assert(first && (uint32_t)first->data == 0);
+  client_icon_invalidate(&s, h);
+  assert(s.cookie_jar.live_count == 2);
+  uint32_t dims_small[2] = {2, 2};
+  reply_to_icon_read(&s, dims_small, 2, (total_words - 2) * 4);
+  assert(cold->icon_fetch.offset == 0);
+  assert(s.cookie_jar.live_count == 1);
+
+  // Header walk: each read returns only (w, h)
+  reply_to_icon_read(&s, dims_small, 2, (total_words - 2) * 4);
+  const cookie_slot_t* next = find_icon_cookie(&s.cookie_jar, COOKIE_GET_PROPERTY_ICON_HEADER);
+  assert(next && (uint32_t)next->data == 6);
+
+  uint32_t dims_big[2] = {16, 16};
+  reply_to_icon_read(&s, dims_big, 2, 256 * 4);
+  assert(cold->icon_fetch.phase == ICON_FETCH_PIXELS);
+  assert(cold->icon_fetch.best_w == 16 && cold->icon_fetch.best_h == 16);
+  const cookie_slot_t* px = find_icon_cookie(&s.cookie_jar, COOKIE_GET_PROPERTY_ICON_PIXELS);
+  assert(px && (uint32_t)px->data == 8);
+
+  // Only the chosen run is transferred
+  uint32_t pixels[256];
+  for (size_t i = 0; i < 256; i++)
+    pixels[i] = 0xFF00FF00;
+  reply_to_icon_read(&s, pixels, 256, 0);
+  assert(cold->icon_fetch.phase == ICON_FETCH_IDLE);
+  assert(cold->icon_surface != NULL);
+  assert(cairo_image_surface_get_width(cold->icon_surface) == 16);
+  assert(((uint32_t*)cairo_image_surface_get_data(cold->icon_surface))[0] == 0xFF00FF00);
+  assert(hot->dirty & DIRTY_FRAME_STYLE);
+  assert(s.cookie_jar.live_count == 0);
+
+  // Drawn icons refetch on change; an empty property drops the surface
+  client_icon_invalidate(&s, h);
+  assert(cold->icon_fetch.phase == ICON_FETCH_SCANNING);
+  reply_to_icon_read(&s, NULL, 0, 0);
+  assert(cold->icon_fetch.phase == ICON_FETCH_IDLE);
+  assert(cold->icon_surface == NULL);
+
+  printf("test_wm_icon_lazy_fetch passed\n");
+
+  client_render_payload_destroy(cold);
+  cookie_jar_destroy(&s.cookie_jar);
+  slotmap_destroy(&s.clients);
+  free(s.conn);
+}
+
 int main(void) {
   test_wm_icon();
+  test_wm_icon_lazy_fetch();
   return 0;
 }
@@ -21,6 +21,7 @@
 volatile sig_atomic_t g_reload_pending = 0;
 volatile sig_atomic_t g_shutdown_pending = 0;
 volatile sig_atomic_t g_restart_pending = 0;
+uint64_t xreq_counts[XREQ_KIND_COUNT];
 
 void hxm_log(enum log_level level, const char* fmt, ...) {
   (void)level;
@@ -34,6 +35,7 @@ void hxm_log(enum log_level level, const char* fmt, ...) {
 static jmp_buf g_exit_jmp_buf;
 
 static xcb_keysym_t g_fake_keysym = 0;
+static int spy_get_keysym_calls = 0;
 static uint32_t g_query_pointer_sequence = 1;
 static bool g_client_can_move = true;
 static bool g_client_can_resize = true;
@@ -54,6 +56,11 @@ static handle_t spy_wm_set_focus_last = HANDLE_INVALID;
 
 static int spy_stack_raise_calls = 0;
 static handle_t spy_stack_raise_last = HANDLE_INVALID;
+static int spy_launcher_shell_calls = 0;
+static const char* spy_launcher_shell_cmd = NULL;
+static uint64_t spy_launcher_shell_trigger = 0;
+static int spy_launcher_first_calls = 0;
+static const char* spy_launcher_first_names = NULL;
 
 static int spy_switch_workspace_calls = 0;
 static uint32_t spy_switch_workspace_last = 0;
@@ -88,6 +95,7 @@ static int spy_exit_last_code = 0;
 
 static void reset_spies(void) {
   g_fake_keysym = 0;
+  spy_get_keysym_calls = 0;
   g_query_pointer_sequence = 1;
   g_client_can_move = true;
   g_client_can_resize = true;
@@ -109,6 +117,12 @@ static void reset_spies(void) {
   spy_stack_raise_calls = 0;
   spy_stack_raise_last = HANDLE_INVALID;
 
+  spy_launcher_shell_calls = 0;
+  spy_launcher_shell_cmd = NULL;
+  spy_launcher_shell_trigger = 0;
+  spy_launcher_first_calls = 0;
+  spy_launcher_first_names = NULL;
+
   spy_switch_workspace_calls = 0;
   spy_switch_workspace_last = 0;
 
@@ -147,12 +161,10 @@ static void setup_server(server_t* s) {
   memset(s, 0, sizeof(*s));
 
   s->keysyms = (xcb_key_symbols_t*)0x1;
-  s->root = 1;
-  s->current_desktop = 0;
+  s->screens[0].root = 1;
+  s->screens[0].current_desktop = 0;
   s->menu.selected_index = -1;
 
-  list_init(&s->focus_history);
-
   bool ok = slotmap_init(&s->clients, 16u, sizeof(client_hot_t), sizeof(client_cold_t));
   assert(ok);
 
@@ -161,6 +173,7 @@ static void setup_server(server_t* s) {
 }
 
 static void teardown_server(server_t* s) {
+  focus_mru_destroy(&s->focus_mru);
   slotmap_destroy(&s->clients);
 }
 
@@ -183,8 +196,6 @@ static client_hot_t* add_client(server_t* s, int32_t desktop, bool sticky, clien
   hot->server.w = 100;
   hot->server.h = 50;
 
-  list_init(&hot->focus_node);
-
   s->active_clients.length++;
 
   if (out_handle)
@@ -193,6 +204,13 @@ static client_hot_t* add_client(server_t* s, int32_t desktop, bool sticky, clien
   return hot;
 }
 
+// Append to the focus history, least recent last
+static void push_history(server_t* s, client_hot_t* c) {
+  c->focus_slot = focus_mru_insert_after(&s->focus_mru, focus_mru_last(&s->focus_mru), c->self);
+  assert(c->focus_slot != 0);
+  focus_mru_refresh(&s->focus_mru, c->focus_slot, c);
+}
+
 static void set_bindings(server_t* s, key_binding_t** bindings, size_t nbindings) {
   s->config.key_bindings.items = (void**)bindings;
   s->config.key_bindings.length = nbindings;
@@ -256,14 +274,32 @@ void __wrap_stack_raise(server_t* s, handle_t h) {
   spy_stack_raise_last = h;
 }
 
-void __wrap_wm_switch_workspace(server_t* s, uint32_t ws) {
+pid_t __wrap_launcher_shell(launcher_t* l, const char* cmd, uint64_t trigger_ns) {
+  (void)l;
+  spy_launcher_shell_calls++;
+  spy_launcher_shell_cmd = cmd;
+  spy_launcher_shell_trigger = trigger_ns;
+  return 1;
+}
+
+pid_t __wrap_launcher_first(launcher_t* l, const char* names, uint64_t trigger_ns) {
+  (void)l;
+  (void)trigger_ns;
+  spy_launcher_first_calls++;
+  spy_launcher_first_names = names;
+  return 1;
+}
+
+void __wrap_wm_switch_workspace(server_t* s, screen_t* scr, uint32_t ws) {
   (void)s;
+  (void)scr;
   spy_switch_workspace_calls++;
   spy_switch_workspace_last = ws;
 }
 
-void __wrap_wm_switch_workspace_relative(server_t* s, int delta) {
+void __wrap_wm_switch_workspace_relative(server_t* s, screen_t* scr, int delta) {
   (void)s;
+  (void)scr;
   spy_switch_workspace_relative_calls++;
   spy_switch_workspace_relative_last_delta = delta;
 }
@@ -372,6 +408,7 @@ xcb_keysym_t __wrap_xcb_key_symbols_get_keysym(xcb_key_symbols_t* syms, xcb_keyc
   (void)syms;
   (void)keycode;
   (void)col;
+  spy_get_keysym_calls++;
   return g_fake_keysym;
 }
 
@@ -381,6 +418,12 @@ __attribute__((noreturn)) void __wrap_exit(int code) {
   longjmp(g_exit_jmp_buf, 1);
 }
 
+bool wm_interaction_handle_key(server_t* s, const xcb_key_press_event_t* ev) {
+  (void)s;
+  (void)ev;
+  return false;
+}
+
 void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_generic_error_t* err) {
   (void)s;
   (void)slot;
@@ -388,6 +431,22 @@ void wm_handle_reply(server_t* s, const cookie_slot_t* slot, void* reply, xcb_ge
   (void)err;
 }
 
+void wm_tiling_cycle_layout(server_t* s) {
+  (void)s;
+}
+
+void wm_tiling_float(server_t* s, handle_t h, bool floating) {
+  (void)s;
+  (void)h;
+  (void)floating;
+}
+
+void wm_tiling_resize(server_t* s, handle_t h, bool grow) {
+  (void)s;
+  (void)h;
+  (void)grow;
+}
+
 static void test_wm_clean_mods_masks_lock_num_scroll(void) {
   uint16_t in = 0;
   in |= XCB_MOD_MASK_LOCK;
@@ -416,9 +475,9 @@ static void test_wm_cycle_focus_selects_next_focusable(void) {
   client_hot_t* b = add_client(&s, 0, false, STATE_MAPPED, WINDOW_TYPE_DOCK, &b_handle);
   client_hot_t* c = add_client(&s, 0, false, STATE_MAPPED, WINDOW_TYPE_NORMAL, &c_handle);
 
-  list_push_back(&s.focus_history, &a->focus_node);
-  list_push_back(&s.focus_history, &b->focus_node);
-  list_push_back(&s.focus_history, &c->focus_node);
+  push_history(&s, a);
+  push_history(&s, b);
+  push_history(&s, c);
 
   s.focused_client = a_handle;
 
@@ -441,8 +500,8 @@ static void test_wm_cycle_focus_no_focusable_no_calls(void) {
   client_hot_t* a = add_client(&s, 0, false, STATE_MAPPED, WINDOW_TYPE_DOCK, NULL);
   client_hot_t* b = add_client(&s, 0, false, STATE_MAPPED, WINDOW_TYPE_TOOLTIP, NULL);
 
-  list_push_back(&s.focus_history, &a->focus_node);
-  list_push_back(&s.focus_history, &b->focus_node);
+  push_history(&s, a);
+  push_history(&s, b);
 
   s.focused_client = a->self;
 
@@ -530,6 +589,61 @@ static void test_key_press_action_close_calls_client_close(void) {
   teardown_server(&s);
 }
 
+static void test_key_press_action_exec_launches_with_tick_start(void) {
+  reset_spies();
+
+  server_t s;
+  setup_server(&s);
+
+  char cmd[] = "rofi -show run";
+  key_binding_t bind = {
+    .keysym = 0x2323u,
+    .modifiers = 0,
+    .action = ACTION_EXEC,
+    .exec_cmd = cmd,
+  };
+  key_binding_t* bindings[] = {&bind};
+  set_bindings(&s, bindings, 1);
+  s.tick_start_ns = 123456789u;
+
+  xcb_key_press_event_t ev = {.detail = 12, .state = 0};
+  g_fake_keysym = 0x2323u;
+
+  wm_handle_key_press(&s, &ev);
+
+  assert(spy_launcher_shell_calls == 1);
+  assert(spy_launcher_shell_cmd == cmd);
+  assert(spy_launcher_shell_trigger == 123456789u);
+
+  teardown_server(&s);
+}
+
+static void test_key_press_action_terminal_skips_shell(void) {
+  reset_spies();
+
+  server_t s;
+  setup_server(&s);
+
+  key_binding_t bind = {
+    .keysym = 0x2324u,
+    .modifiers = 0,
+    .action = ACTION_TERMINAL,
+  };
+  key_binding_t* bindings[] = {&bind};
+  set_bindings(&s, bindings, 1);
+
+  xcb_key_press_event_t ev = {.detail = 12, .state = 0};
+  g_fake_keysym = 0x2324u;
+
+  wm_handle_key_press(&s, &ev);
+
+  assert(spy_launcher_first_calls == 1);
+  assert(strcmp(spy_launcher_first_names, "st xterm x-terminal-emulator") == 0);
+  assert(spy_launcher_shell_calls == 0);
+
+  teardown_server(&s);
+}
+
 static void test_key_press_action_focus_next_dispatch(void) {
   reset_spies();
 
@@ -540,8 +654,8 @@ static void test_key_press_action_focus_next_dispatch(void) {
   client_hot_t* a = add_client(&s, 0, false, STATE_MAPPED, WINDOW_TYPE_NORMAL, &a_handle);
   client_hot_t* b = add_client(&s, 0, false, STATE_MAPPED, WINDOW_TYPE_NORMAL, NULL);
 
-  list_push_back(&s.focus_history, &a->focus_node);
-  list_push_back(&s.focus_history, &b->focus_node);
+  push_history(&s, a);
+  push_history(&s, b);
   s.focused_client = a_handle;
 
   key_binding_t bind = {
@@ -576,7 +690,7 @@ static void test_switcher_commit_restores_and_focuses(void) {
   handle_t h = HANDLE_INVALID;
   add_client(&s, 1, false, STATE_UNMAPPED, WINDOW_TYPE_NORMAL, &h);
 
-  s.current_desktop = 0;
+  s.screens[0].current_desktop = 0;
   s.switcher_active = true;
   s.menu.visible = true;
   s.menu.is_switcher = true;
@@ -779,6 +893,107 @@ static void test_key_press_action_exit_intercepted(void) {
   teardown_server(&s);
 }
 
+static void test_key_press_repeat_uses_dispatch_index(void) {
+  reset_spies();
+
+  server_t s;
+  setup_server(&s);
+
+  key_binding_t other = {
+    .keysym = 0x5555u,
+    .modifiers = XCB_MOD_MASK_4,
+    .action = ACTION_WORKSPACE,
+    .exec_cmd = "3",
+  };
+  key_binding_t next = {
+    .keysym = 0x4444u,
+    .modifiers = XCB_MOD_MASK_4,
+    .action = ACTION_WORKSPACE_NEXT,
+    .exec_cmd = NULL,
+  };
+  key_binding_t* bindings[] = {&other, &next};
+  set_bindings(&s, bindings, 2);
+
+  xcb_key_press_event_t ev = {.detail = 30, .state = XCB_MOD_MASK_4};
+  g_fake_keysym = 0x4444u;
+
+  // Held key: only the first press translates the keycode
+  for (int i = 0; i < 5; i++)
+    wm_handle_key_press(&s, &ev);
+  assert(spy_switch_workspace_relative_calls == 5);
+  assert(spy_switch_workspace_calls == 0);
+  assert(spy_get_keysym_calls == 1);
+
+  // Lock bits share the entry; a chord with no binding is remembered too
+  ev.state = XCB_MOD_MASK_4 | XCB_MOD_MASK_2;
+  wm_handle_key_press(&s, &ev);
+  assert(spy_switch_workspace_relative_calls == 6);
+  ev.state = XCB_MOD_MASK_CONTROL;
+  wm_handle_key_press(&s, &ev);
+  wm_handle_key_press(&s, &ev);
+  assert(spy_switch_workspace_relative_calls == 6);
+  assert(spy_get_keysym_calls == 2);
+
+  // Held buttons never match a binding and are not looked up
+  ev.state = XCB_MOD_MASK_4 | XCB_KEY_BUT_MASK_BUTTON_1;
+  wm_handle_key_press(&s, &ev);
+  assert(spy_switch_workspace_relative_calls == 6);
+  assert(spy_get_keysym_calls == 2);
+
+  teardown_server(&s);
+}
+
+static void test_key_run_folds_repeats_and_caps(void) {
+  reset_spies();
+
+  server_t s;
+  setup_server(&s);
+
+  key_binding_t next = {
+    .keysym = 0x4444u,
+    .modifiers = XCB_MOD_MASK_4,
+    .action = ACTION_WORKSPACE_NEXT,
+  };
+  key_binding_t sticky = {
+    .keysym = 0x5555u,
+    .modifiers = XCB_MOD_MASK_4,
+    .action = ACTION_TOGGLE_STICKY,
+  };
+  key_binding_t* bindings[] = {&next, &sticky};
+  set_bindings(&s, bindings, 2);
+  s.focused_client = 0x123u;
+
+  // Relative steps go out as one switch of N
+  xcb_key_press_event_t ev = {.detail = 30, .state = XCB_MOD_MASK_4};
+  g_fake_keysym = 0x4444u;
+  wm_handle_key_run(&s, &ev, 4, true);
+  assert(spy_switch_workspace_relative_calls == 1);
+  assert(spy_switch_workspace_relative_last_delta == 4);
+
+  // Other actions still run once per press
+  xcb_key_press_event_t st = {.detail = 31, .state = XCB_MOD_MASK_4};
+  g_fake_keysym = 0x5555u;
+  wm_handle_key_run(&s, &st, 3, true);
+  assert(spy_toggle_sticky_calls == 3);
+
+  // A cap lets one repeat step through per period; fresh presses always run
+  next.repeat_ms = 100;
+  g_fake_keysym = 0x4444u;
+  s.tick_start_ns = 1000000000ull;
+  wm_handle_key_run(&s, &ev, 1, false);
+  assert(spy_switch_workspace_relative_calls == 2);
+  s.tick_start_ns += 40000000ull;
+  wm_handle_key_run(&s, &ev, 3, true);
+  assert(spy_switch_workspace_relative_calls == 2);
+  assert(s.key_repeat.capped == 1);
+  s.tick_start_ns += 70000000ull;
+  wm_handle_key_run(&s, &ev, 3, true);
+  assert(spy_switch_workspace_relative_calls == 3);
+  assert(spy_switch_workspace_relative_last_delta == 1);
+
+  teardown_server(&s);
+}
+
 static void test_key_release_alt_commits_switcher(void) {
   reset_spies();
 
@@ -809,6 +1024,8 @@ int main(void) {
   test_key_press_menu_delegates_to_menu();
   test_key_press_matches_binding_with_ignored_mods();
   test_key_press_action_close_calls_client_close();
+  test_key_press_action_exec_launches_with_tick_start();
+  test_key_press_action_terminal_skips_shell();
   test_key_press_action_focus_next_dispatch();
   test_switcher_commit_restores_and_focuses();
   test_key_press_action_workspace_uses_safe_atoi();
@@ -817,6 +1034,8 @@ int main(void) {
   test_key_press_action_move_zero_query_sequence_skips_cookie_enqueue();
   test_key_press_action_resize_starts_interaction();
   test_key_press_action_exit_intercepted();
+  test_key_press_repeat_uses_dispatch_index();
+  test_key_run_folds_repeats_and_caps();
   test_key_release_alt_commits_switcher();
 
   puts("test_wm_input_keys: OK");
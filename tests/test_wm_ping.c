@@ -0,0 +1,171 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "client.h"
+#include "event.h"
+#include "hxm.h"
+#include "wm.h"
+#include "xcb_utils.h"
+
+extern int stub_send_event_count;
+extern xcb_window_t stub_last_send_event_destination;
+extern char stub_last_event[32];
+extern int stub_kill_client_count;
+extern uint32_t stub_last_kill_client_resource;
+
+static void setup_server(server_t* s) {
+  memset(s, 0, sizeof(*s));
+  s->is_test = true;
+  s->conn = (xcb_connection_t*)malloc(1);
+  s->screens[0].root = 1;
+  s->config.ping_interval_ms = 5000;
+  s->config.ping_timeout_ms = 3000;
+
+  atoms.WM_PROTOCOLS = 10;
+  atoms.WM_DELETE_WINDOW = 11;
+  atoms._NET_WM_PING = 12;
+
+  slotmap_init(&s->clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
+  handle_vec_init(&s->active_clients);
+  handle_vec_init(&s->dirty_clients);
+  hash_map_init(&s->xid_index);
+}
+
+static void teardown_server(server_t* s) {
+  timer_wheel_cancel(&s->timers, &s->ping_timer);
+  hash_map_destroy(&s->xid_index);
+  handle_vec_destroy(&s->dirty_clients);
+  handle_vec_destroy(&s->active_clients);
+  slotmap_destroy(&s->clients);
+  free(s->conn);
+}
+
+static handle_t add_client(server_t* s, xcb_window_t xid) {
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s->clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = hot_ptr;
+  client_cold_t* cold = cold_ptr;
+  hot->self = h;
+  hot->xid = xid;
+  hot->state = STATE_MAPPED;
+  cold->protocols = PROTOCOL_PING | PROTOCOL_DELETE_WINDOW;
+  server_xid_bind(s, xid, XID_CLIENT, h);
+  handle_vec_push(&s->active_clients, h);
+  return h;
+}
+
+static void answer(server_t* s, xcb_window_t xid) {
+  xcb_client_message_event_t ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.response_type = XCB_CLIENT_MESSAGE;
+  ev.format = 32;
+  ev.window = s->screens[0].root;
+  ev.type = atoms.WM_PROTOCOLS;
+  ev.data.data32[0] = atoms._NET_WM_PING;
+  ev.data.data32[2] = xid;
+  wm_handle_client_message(s, &ev);
+}
+
+/* Runs the ping check as its timer would, with the ping sent ago_ms earlier */
+static void age_and_check(server_t* s, client_cold_t* cold, uint32_t ago_ms) {
+  cold->ping_sent_ms = (uint32_t)(monotonic_time_ns() / 1000000u) - ago_ms;
+  assert(wheel_timer_pending(&s->ping_timer));
+  s->ping_timer.fn(&s->ping_timer, s);
+}
+
+static void test_ping_marks_and_clears_hung(void) {
+  server_t s;
+  setup_server(&s);
+  handle_t h = add_client(&s, 123);
+  client_hot_t* hot = server_chot(&s, h);
+  client_cold_t* cold = server_ccold(&s, h);
+
+  // One ping out at a time, and its deadline is armed
+  stub_send_event_count = 0;
+  wm_ping_client(&s, h);
+  wm_ping_client(&s, h);
+  assert(stub_send_event_count == 1);
+  assert(stub_last_send_event_destination == 123);
+  xcb_client_message_event_t* sent = (xcb_client_message_event_t*)stub_last_event;
+  assert(sent->type == atoms.WM_PROTOCOLS && sent->data.data32[0] == atoms._NET_WM_PING && sent->data.data32[2] == 123);
+  assert(cold->ping_sent_ms != 0);
+  assert(wheel_timer_pending(&s.ping_timer));
+
+  answer(&s, 123);
+  assert(cold->ping_sent_ms == 0 && !cold->ping_hung);
+
+  // Still within the timeout: nothing happens
+  wm_ping_client(&s, h);
+  age_and_check(&s, cold, 1000);
+  assert(!cold->ping_hung && cold->ping_sent_ms != 0);
+
+  // Past it, during a live resize of that client
+  s.interaction_mode = INTERACTION_RESIZE;
+  s.interaction_handle = h;
+  cold->sync_wait_value = 7;
+  hot->dirty = 0;
+  age_and_check(&s, cold, 3500);
+  assert(cold->ping_hung);
+  assert(s.pings_hung == 1);
+  assert(s.interaction_outline);
+  assert(cold->sync_wait_value == 0);
+  assert(hot->dirty & DIRTY_FRAME_TITLE);
+  assert(!wm_send_synthetic_configure(&s, h));
+  s.interaction_mode = INTERACTION_NONE;
+
+  // The answer lifts it and sends the held configure
+  hot->dirty = 0;
+  answer(&s, 123);
+  assert(!cold->ping_hung);
+  assert(hot->dirty & DIRTY_SYNTHETIC_CONFIGURE);
+
+  // Turning pings off forgets a hung client
+  wm_ping_client(&s, h);
+  age_and_check(&s, cold, 3500);
+  assert(cold->ping_hung);
+  s.config.ping_interval_ms = 0;
+  wm_ping_reload(&s);
+  assert(!cold->ping_hung && !wheel_timer_pending(&s.ping_timer));
+  stub_send_event_count = 0;
+  wm_ping_client(&s, h);
+  assert(stub_send_event_count == 0);
+
+  teardown_server(&s);
+  printf("test_ping_marks_and_clears_hung passed\n");
+}
+
+static void test_close_kills_hung_client(void) {
+  server_t s;
+  setup_server(&s);
+  handle_t h = add_client(&s, 200);
+  client_cold_t* cold = server_ccold(&s, h);
+  arena_init(&cold->string_arena, 64);
+
+  // A responsive client is asked to close, and pinged while it decides
+  stub_send_event_count = 0;
+  stub_kill_client_count = 0;
+  client_close(&s, h);
+  assert(stub_send_event_count == 2);
+  assert(stub_kill_client_count == 0);
+  assert(cold->ping_sent_ms != 0);
+
+  // Closing it again once it is found hung kills it at once
+  age_and_check(&s, cold, 3500);
+  assert(cold->ping_hung);
+  stub_send_event_count = 0;
+  client_close(&s, h);
+  assert(stub_send_event_count == 0);
+  assert(stub_kill_client_count == 1 && stub_last_kill_client_resource == 200);
+
+  arena_destroy(&cold->string_arena);
+  teardown_server(&s);
+  printf("test_close_kills_hung_client passed\n");
+}
+
+int main(void) {
+  test_ping_marks_and_clears_hung();
+  test_close_kills_hung_client();
+  return 0;
+}
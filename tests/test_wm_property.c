@@ -6,6 +6,7 @@
 #include "cookie_jar.h"
 #include "event.h"
 #include "wm.h"
+#include "wm_internal.h"
 
 extern void xcb_stubs_reset(void);
 
@@ -23,7 +24,7 @@ void test_property_dirty_bits(void) {
     fprintf(stderr, "Failed to init slotmap\n");
     return;
   }
-  hash_map_init(&s.window_to_client);
+  hash_map_init(&s.xid_index);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
@@ -31,7 +32,7 @@ void test_property_dirty_bits(void) {
   hot->xid = 123;
   hot->dirty = DIRTY_NONE;
 
-  hash_map_insert(&s.window_to_client, 123, handle_to_ptr(h));
+  server_xid_bind(&s, 123, XID_CLIENT, h);
 
   xcb_property_notify_event_t ev;
   memset(&ev, 0, sizeof(ev));
@@ -52,7 +53,7 @@ void test_property_dirty_bits(void) {
   printf("test_property_dirty_bits passed\n");
 
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
 }
 
 void test_property_net_wm_desktop_enqueues_cookie(void) {
@@ -75,7 +76,7 @@ void test_property_net_wm_desktop_enqueues_cookie(void) {
     fprintf(stderr, "Failed to init slotmap\n");
     return;
   }
-  hash_map_init(&s.window_to_client);
+  hash_map_init(&s.xid_index);
   cookie_jar_init(&s.cookie_jar);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
@@ -83,7 +84,7 @@ void test_property_net_wm_desktop_enqueues_cookie(void) {
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   hot->xid = 1234;
 
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   xcb_property_notify_event_t ev;
   memset(&ev, 0, sizeof(ev));
@@ -99,7 +100,8 @@ void test_property_net_wm_desktop_enqueues_cookie(void) {
 
   cookie_jar_destroy(&s.cookie_jar);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
+  hash_map_destroy(&s.prop_fetches);
   xcb_disconnect(s.conn);
 }
 
@@ -122,14 +124,14 @@ void test_property_net_wm_state_enqueues_cookie(void) {
     fprintf(stderr, "Failed to init slotmap\n");
     return;
   }
-  hash_map_init(&s.window_to_client);
+  hash_map_init(&s.xid_index);
   cookie_jar_init(&s.cookie_jar);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   hot->xid = 2234;
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   xcb_property_notify_event_t ev;
   memset(&ev, 0, sizeof(ev));
@@ -145,7 +147,8 @@ void test_property_net_wm_state_enqueues_cookie(void) {
 
   cookie_jar_destroy(&s.cookie_jar);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
+  hash_map_destroy(&s.prop_fetches);
   xcb_disconnect(s.conn);
 }
 
@@ -168,14 +171,14 @@ void test_property_net_wm_window_type_enqueues_cookie(void) {
     fprintf(stderr, "Failed to init slotmap\n");
     return;
   }
-  hash_map_init(&s.window_to_client);
+  hash_map_init(&s.xid_index);
   cookie_jar_init(&s.cookie_jar);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
   handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
   client_hot_t* hot = (client_hot_t*)hot_ptr;
   hot->xid = 2235;
-  hash_map_insert(&s.window_to_client, hot->xid, handle_to_ptr(h));
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
 
   xcb_property_notify_event_t ev;
   memset(&ev, 0, sizeof(ev));
@@ -191,7 +194,86 @@ void test_property_net_wm_window_type_enqueues_cookie(void) {
 
   cookie_jar_destroy(&s.cookie_jar);
   slotmap_destroy(&s.clients);
-  hash_map_destroy(&s.window_to_client);
+  hash_map_destroy(&s.xid_index);
+  hash_map_destroy(&s.prop_fetches);
+  xcb_disconnect(s.conn);
+}
+
+static const cookie_slot_t* find_live_slot(const cookie_jar_t* cj, uint32_t after) {
+  const cookie_slot_t* best = NULL;
+  for (size_t i = 0; i < cj->cap; i++) {
+    const cookie_slot_t* slot = &cj->slots[i];
+    if (slot->live && slot->sequence > after && (!best || slot->sequence < best->sequence))
+      best = slot;
+  }
+  return best;
+}
+
+void test_property_refetch_coalesces_while_in_flight(void) {
+  server_t s;
+  memset(&s, 0, sizeof(s));
+  s.is_test = true;
+
+  xcb_stubs_reset();
+  s.conn = xcb_connect(NULL, NULL);
+
+  atoms._NET_WM_ALLOWED_ACTIONS = 0;
+  atoms._NET_FRAME_EXTENTS = 0;
+  atoms.WM_STATE = 0;
+  atoms._NET_WM_VISIBLE_NAME = 0;
+  atoms._NET_WM_VISIBLE_ICON_NAME = 0;
+  atoms._NET_WM_STATE = 43;
+
+  if (!slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t))) {
+    fprintf(stderr, "Failed to init slotmap\n");
+    return;
+  }
+  hash_map_init(&s.xid_index);
+  hash_map_init(&s.prop_fetches);
+  cookie_jar_init(&s.cookie_jar);
+
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = (client_hot_t*)hot_ptr;
+  hot->xid = 2236;
+  server_xid_bind(&s, hot->xid, XID_CLIENT, h);
+
+  xcb_property_notify_event_t ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.window = hot->xid;
+  ev.atom = atoms._NET_WM_STATE;
+
+  // A burst of changes shares the fetch already in flight
+  for (int i = 0; i < 5; i++)
+    wm_handle_property_notify(&s, h, &ev);
+  assert(s.cookie_jar.live_count == 1);
+
+  // Its reply issues exactly one follow-up for the changes it missed
+  const cookie_slot_t* first = find_live_slot(&s.cookie_jar, 0);
+  assert(first);
+  cookie_slot_t landed = *first;
+  wm_prop_fetch_settle(&s, &landed, true);
+  assert(s.cookie_jar.live_count == 2);
+
+  // Settling the same reply again, or the follow-up, issues nothing more
+  wm_prop_fetch_settle(&s, &landed, true);
+  const cookie_slot_t* second = find_live_slot(&s.cookie_jar, landed.sequence);
+  assert(second);
+  landed = *second;
+  wm_prop_fetch_settle(&s, &landed, true);
+  assert(s.cookie_jar.live_count == 2);
+  assert(hash_map_empty(&s.prop_fetches));
+
+  // With nothing in flight the next change fetches again
+  wm_handle_property_notify(&s, h, &ev);
+  assert(s.cookie_jar.live_count == 3);
+
+  printf("test_property_refetch_coalesces_while_in_flight passed\n");
+
+  cookie_jar_destroy(&s.cookie_jar);
+  slotmap_destroy(&s.clients);
+  hash_map_destroy(&s.xid_index);
+  hash_map_destroy(&s.prop_fetches);
   xcb_disconnect(s.conn);
 }
 
@@ -200,5 +282,6 @@ int main(void) {
   test_property_net_wm_desktop_enqueues_cookie();
   test_property_net_wm_state_enqueues_cookie();
   test_property_net_wm_window_type_enqueues_cookie();
+  test_property_refetch_coalesces_while_in_flight();
   return 0;
 }
@@ -8,6 +8,7 @@
 
 #include "cookie_jar.h"
 #include "event.h"
+#include "wm.h"
 #include "xcb_utils.h"
 #include "../src/wm_internal.h"
 
@@ -71,19 +72,19 @@ static void setup_server(server_t* s) {
 
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
-  s->root = 1;
+  s->screens[0].root = 1;
   s->randr_supported = true;
 
   cookie_jar_init(&s->cookie_jar);
-  small_vec_init(&s->active_clients);
+  handle_vec_init(&s->active_clients);
 }
 
 static void cleanup_server(server_t* s) {
-  if (s->monitors)
-    free(s->monitors);
-  if (s->randr_pending_monitors)
-    free(s->randr_pending_monitors);
-  small_vec_destroy(&s->active_clients);
+  if (s->screens[0].monitors)
+    free(s->screens[0].monitors);
+  if (s->screens[0].randr_pending_monitors)
+    free(s->screens[0].randr_pending_monitors);
+  handle_vec_destroy(&s->active_clients);
   cookie_jar_destroy(&s->cookie_jar);
   xcb_disconnect(s->conn);
   stub_poll_for_reply_hook = NULL;
@@ -98,7 +99,7 @@ static void test_randr_crtc_zero_sequence_clears_pending_accounting(void) {
   g_resources_reply_delivered = false;
   stub_poll_for_reply_hook = randr_poll_for_reply;
 
-  wm_update_monitors(&s);
+  wm_update_monitors(&s, &s.screens[0]);
   assert(g_resources_sequence != 0);
   assert(cookie_jar_has_pending(&s.cookie_jar));
 
@@ -108,15 +109,181 @@ static void test_randr_crtc_zero_sequence_clears_pending_accounting(void) {
 
   assert(g_resources_reply_delivered);
   assert(!cookie_jar_has_pending(&s.cookie_jar));
-  assert(s.randr_pending_replies == 0);
-  assert(s.randr_pending_capacity == 0);
-  assert(s.randr_pending_monitors == NULL);
+  assert(s.screens[0].randr_pending_replies == 0);
+  assert(s.screens[0].randr_pending_capacity == 0);
+  assert(s.screens[0].randr_pending_monitors == NULL);
 
   printf("test_randr_crtc_zero_sequence_clears_pending_accounting passed\n");
   cleanup_server(&s);
 }
 
+static void test_randr_mode_refresh(void) {
+  // 2560x1440@143.86 (CVT reduced blanking)
+  xcb_randr_mode_info_t mode = {.dot_clock = 586586000, .htotal = 2720, .vtotal = 1499};
+  uint32_t mhz = wm_randr_mode_refresh_mhz(&mode);
+  assert(mhz >= 143850 && mhz <= 143870);
+
+  mode.mode_flags = XCB_RANDR_MODE_FLAG_DOUBLE_SCAN;
+  assert(wm_randr_mode_refresh_mhz(&mode) == mhz / 2 || wm_randr_mode_refresh_mhz(&mode) == mhz / 2 + 1);
+
+  mode.mode_flags = 0;
+  mode.htotal = 0;
+  assert(wm_randr_mode_refresh_mhz(&mode) == 0);
+
+  printf("test_randr_mode_refresh passed\n");
+}
+
+static void test_interaction_interval_follows_monitor(void) {
+  server_t s;
+  setup_server(&s);
+
+  monitor_t mons[2] = {
+      {.geom = {0, 0, 1920, 1080}, .refresh_mhz = 144000},
+      {.geom = {1920, 0, 1920, 1080}, .refresh_mhz = 0},
+  };
+  s.screens[0].monitors = mons;
+  s.screens[0].monitor_count = 2;
+  client_hot_t hot = {.desired = {2000, 100, 400, 300}};
+
+  // Pointer on the 144 Hz monitor wins over the window's position
+  s.pointer_root_valid = true;
+  s.pointer_root_x = 100;
+  s.pointer_root_y = 100;
+  assert(wm_interaction_interval_ns(&s, &hot) == 1000000000000ull / 144000);
+  assert(tick_stats.pacing_mhz == 144000 && tick_stats.pacing_monitor_mhz == 144000);
+
+  // Unknown rate falls back to 60 Hz
+  s.pointer_root_valid = false;
+  assert(wm_interaction_interval_ns(&s, &hot) == 1000000000000ull / 60000);
+  assert(tick_stats.pacing_monitor_mhz == 0);
+
+  // The configured cap applies
+  s.pointer_root_valid = true;
+  s.config.interactive_max_hz = 30;
+  assert(wm_interaction_interval_ns(&s, &hot) == 1000000000000ull / 30000);
+  assert(tick_stats.pacing_mhz == 30000 && tick_stats.pacing_monitor_mhz == 144000);
+
+  s.screens[0].monitors = NULL;
+  s.screens[0].monitor_count = 0;
+  printf("test_interaction_interval_follows_monitor passed\n");
+  cleanup_server(&s);
+}
+
+static void test_client_monitor_cached_per_generation(void) {
+  server_t s;
+  setup_server(&s);
+
+  monitor_t mons[2] = {
+      {.geom = {0, 0, 1920, 1080}},
+      {.geom = {1920, 0, 1920, 1080}},
+  };
+  s.screens[0].monitors = mons;
+  s.screens[0].monitor_count = 2;
+  s.screens[0].monitor_generation = 3;
+
+  client_hot_t hot = {.server = {2000, 100, 400, 300}};
+  wm_client_update_monitor(&s, &hot);
+  assert(hot.monitor == 1 && hot.monitor_gen == 3);
+
+  rect_t geom;
+  wm_get_monitor_geometry(&s, &hot, &geom);
+  assert(geom.x == 1920 && geom.w == 1920);
+
+  // The tag is trusted until the monitor set changes
+  hot.server.x = 100;
+  assert(wm_client_monitor(&s, &hot) == 1);
+  s.screens[0].monitor_generation = 4;
+  assert(wm_client_monitor(&s, &hot) == 0);
+  assert(hot.monitor_gen == 4);
+
+  // A stale index past the monitor count is never returned
+  hot.monitor = 7;
+  assert(wm_client_monitor(&s, &hot) == 0);
+
+  s.screens[0].monitors = NULL;
+  s.screens[0].monitor_count = 0;
+  printf("test_client_monitor_cached_per_generation passed\n");
+  cleanup_server(&s);
+}
+
+static client_hot_t* add_client(server_t* s, xcb_window_t xid, rect_t geom) {
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s->clients, &hot_ptr, &cold_ptr);
+  client_hot_t* hot = hot_ptr;
+  hot->self = h;
+  hot->xid = xid;
+  hot->state = STATE_MAPPED;
+  hot->server = geom;
+  hot->desired = geom;
+  handle_vec_push(&s->active_clients, h);
+  return hot;
+}
+
+static monitor_t* snapshot(const monitor_t* mons, uint32_t n) {
+  monitor_t* next = calloc(n, sizeof(*next));
+  assert(next != NULL);
+  memcpy(next, mons, n * sizeof(*next));
+  return next;
+}
+
+static void test_hotplug_relocates_only_affected_clients(void) {
+  server_t s;
+  setup_server(&s);
+  slotmap_init(&s.clients, 16, sizeof(client_hot_t), sizeof(client_cold_t));
+  handle_vec_init(&s.dirty_clients);
+
+  monitor_t mons[2] = {
+      {.geom = {0, 0, 1920, 1080}, .crtc = 11},
+      {.geom = {1920, 0, 1920, 1080}, .crtc = 22},
+  };
+  wm_apply_monitor_snapshot(&s, &s.screens[0], snapshot(mons, 2), 2);
+  uint8_t gen = s.screens[0].monitor_generation;
+  client_hot_t* a = add_client(&s, 0x100, (rect_t){100, 100, 400, 300});
+  client_hot_t* b = add_client(&s, 0x200, (rect_t){2000, 100, 400, 300});
+  s.screens[0].workarea_dirty = false;
+  s.screens[0].root_dirty = 0;
+
+  // The same set again is dropped: no new generation, nothing dirty
+  monitor_t* current = s.screens[0].monitors;
+  wm_apply_monitor_snapshot(&s, &s.screens[0], snapshot(mons, 2), 2);
+  assert(s.screens[0].monitors == current && s.screens[0].monitor_generation == gen);
+  assert(s.monitor_snapshots_same == 1);
+  assert(!s.screens[0].workarea_dirty && s.screens[0].root_dirty == 0 && s.dirty_clients.length == 0);
+
+  // The second monitor grows: only its client moves, keeping its relative place
+  mons[1].geom = (rect_t){1920, 0, 2560, 1440};
+  wm_apply_monitor_snapshot(&s, &s.screens[0], snapshot(mons, 2), 2);
+  assert(s.screens[0].monitor_generation != gen);
+  assert(a->dirty == 0 && a->desired.x == 100 && a->desired.y == 100);
+  assert(b->dirty & DIRTY_GEOM);
+  assert(b->desired.x == 1920 + 80 * 2560 / 1920 && b->desired.y == 100 * 1440 / 1080);
+  assert(b->desired.w == 400 && b->desired.h == 300);
+  assert(s.monitor_clients_moved == 1);
+  assert(s.screens[0].root_dirty & ROOT_DIRTY_WORKAREA);
+
+  // Unplugged: its client lands inside the remaining monitor
+  b->server = b->desired;
+  b->dirty = 0;
+  wm_apply_monitor_snapshot(&s, &s.screens[0], snapshot(mons, 1), 1);
+  assert(a->dirty == 0);
+  assert(b->dirty & DIRTY_GEOM);
+  assert(b->desired.x >= 0 && b->desired.x + b->desired.w <= 1920);
+  assert(b->desired.y >= 0 && b->desired.y + b->desired.h <= 1080);
+  assert(wm_client_monitor(&s, b) == 0);
+  assert(s.monitor_clients_moved == 2);
+
+  wm_workarea_invalidate(&s.screens[0]);
+  handle_vec_destroy(&s.dirty_clients);
+  slotmap_destroy(&s.clients);
+  printf("test_hotplug_relocates_only_affected_clients passed\n");
+  cleanup_server(&s);
+}
+
 int main(void) {
   test_randr_crtc_zero_sequence_clears_pending_accounting();
+  test_randr_mode_refresh();
+  test_interaction_interval_follows_monitor();
+  test_client_monitor_cached_per_generation();
+  test_hotplug_relocates_only_affected_clients();
   return 0;
 }
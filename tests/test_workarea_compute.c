@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "client.h"
@@ -15,7 +16,7 @@ void test_workarea_compute(void) {
     fprintf(stderr, "Failed to init slotmap\n");
     return;
   }
-  small_vec_init(&s.active_clients);
+  handle_vec_init(&s.active_clients);
   s.conn = xcb_connect(NULL, NULL);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
@@ -29,7 +30,7 @@ void test_workarea_compute(void) {
   c1->state = STATE_MAPPED;
   c1->type = WINDOW_TYPE_DOCK;
   cold1->strut.top = 30;
-  small_vec_push(&s.active_clients, handle_to_ptr(h1));
+  handle_vec_push(&s.active_clients, h1);
 
   handle_t h2 = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
   assert(h2 != HANDLE_INVALID);
@@ -41,10 +42,12 @@ void test_workarea_compute(void) {
   c2->state = STATE_MAPPED;
   c2->type = WINDOW_TYPE_DOCK;
   cold2->strut.left = 50;
-  small_vec_push(&s.active_clients, handle_to_ptr(h2));
+  handle_vec_push(&s.active_clients, h2);
+  wm_client_strut_changed(&s, h1);
+  wm_client_strut_changed(&s, h2);
 
   rect_t wa;
-  wm_compute_workarea(&s, &wa);
+  wm_compute_workarea(&s, &s.screens[0], &wa);
 
   printf("wa: x=%d y=%d w=%u h=%u\n", wa.x, wa.y, wa.w, wa.h);
   assert(wa.x == 50);
@@ -54,7 +57,9 @@ void test_workarea_compute(void) {
 
   printf("test_workarea_compute passed\n");
 
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.screens[0].strut_clients);
+  free(s.screens[0].workarea_cache);
   slotmap_destroy(&s.clients);
   xcb_disconnect(s.conn);
 }
@@ -67,7 +72,7 @@ void test_workarea_no_strut_for_dock(void) {
     fprintf(stderr, "Failed to init slotmap\n");
     return;
   }
-  small_vec_init(&s.active_clients);
+  handle_vec_init(&s.active_clients);
   s.conn = xcb_connect(NULL, NULL);
 
   void *hot_ptr = NULL, *cold_ptr = NULL;
@@ -79,10 +84,12 @@ void test_workarea_no_strut_for_dock(void) {
   memset(cold, 0, sizeof(*cold));
   c->state = STATE_MAPPED;
   c->type = WINDOW_TYPE_DOCK;
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
+  wm_client_strut_changed(&s, h);
+  assert(s.screens[0].strut_clients.length == 0);
 
   rect_t wa;
-  wm_compute_workarea(&s, &wa);
+  wm_compute_workarea(&s, &s.screens[0], &wa);
 
   assert(wa.x == 0);
   assert(wa.y == 0);
@@ -91,7 +98,78 @@ void test_workarea_no_strut_for_dock(void) {
 
   printf("test_workarea_no_strut_for_dock passed\n");
 
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.screens[0].strut_clients);
+  free(s.screens[0].workarea_cache);
+  slotmap_destroy(&s.clients);
+  xcb_disconnect(s.conn);
+}
+
+void test_workarea_cache_invalidation(void) {
+  server_t s;
+  memset(&s, 0, sizeof(s));
+
+  if (!slotmap_init(&s.clients, 8, sizeof(client_hot_t), sizeof(client_cold_t))) {
+    fprintf(stderr, "Failed to init slotmap\n");
+    return;
+  }
+  handle_vec_init(&s.active_clients);
+  handle_vec_init(&s.screens[0].strut_clients);
+  s.conn = xcb_connect(NULL, NULL);
+  s.screens[0].desktop_count = 2;
+
+  void *hot_ptr = NULL, *cold_ptr = NULL;
+  handle_t h = slotmap_alloc(&s.clients, &hot_ptr, &cold_ptr);
+  assert(h != HANDLE_INVALID);
+  client_hot_t* c = (client_hot_t*)hot_ptr;
+  client_cold_t* cold = (client_cold_t*)cold_ptr;
+  c->state = STATE_MAPPED;
+  c->type = WINDOW_TYPE_DOCK;
+  c->desktop = 1;
+  cold->strut.top = 40;
+  handle_vec_push(&s.active_clients, h);
+  wm_client_strut_changed(&s, h);
+  assert(s.screens[0].strut_clients.length == 1);
+
+  // The strut only applies on desktop 1
+  rect_t wa;
+  wm_compute_workarea(&s, &s.screens[0], &wa);
+  assert(wa.y == 0 && wa.h == 1080);
+  assert(s.screens[0].workarea_cache_valid);
+
+  rect_t* cache = s.screens[0].workarea_cache;
+  s.screens[0].current_desktop = 1;
+  wm_compute_workarea(&s, &s.screens[0], &wa);
+  assert(wa.y == 40 && wa.h == 1040);
+  assert(s.screens[0].workarea_cache == cache);
+
+  // Switching desktops reads the cache; only a strut change rebuilds it
+  cold->strut.top = 60;
+  wm_compute_workarea(&s, &s.screens[0], &wa);
+  assert(wa.y == 40);
+  wm_client_strut_changed(&s, h);
+  assert(!s.screens[0].workarea_cache_valid);
+  wm_compute_workarea(&s, &s.screens[0], &wa);
+  assert(wa.y == 60 && wa.h == 1020);
+
+  // A desktop count change resizes the table
+  s.screens[0].desktop_count = 4;
+  rect_t all[4];
+  wm_compute_workareas(&s, &s.screens[0], all, 4);
+  assert(s.screens[0].workarea_cache_desktops == 4);
+  assert(all[0].y == 0 && all[1].y == 60 && all[2].y == 0 && all[3].y == 0);
+
+  cold->strut.top = 0;
+  wm_client_strut_changed(&s, h);
+  assert(s.screens[0].strut_clients.length == 0);
+  wm_compute_workarea(&s, &s.screens[0], &wa);
+  assert(wa.y == 0 && wa.h == 1080);
+
+  printf("test_workarea_cache_invalidation passed\n");
+
+  handle_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.screens[0].strut_clients);
+  free(s.screens[0].workarea_cache);
   slotmap_destroy(&s.clients);
   xcb_disconnect(s.conn);
 }
@@ -99,5 +177,6 @@ void test_workarea_no_strut_for_dock(void) {
 int main(void) {
   test_workarea_compute();
   test_workarea_no_strut_for_dock();
+  test_workarea_cache_invalidation();
   return 0;
 }
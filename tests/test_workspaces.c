@@ -16,6 +16,10 @@ extern int stub_map_window_count;
 extern int stub_unmap_window_count;
 extern xcb_window_t stub_last_mapped_window;
 extern xcb_window_t stub_last_unmapped_window;
+extern xcb_window_t stub_mapped_windows[];
+extern int stub_mapped_windows_len;
+extern int stub_grab_server_count;
+extern int stub_ungrab_server_count;
 
 void setup_server(server_t* s) {
   memset(s, 0, sizeof(server_t));
@@ -25,17 +29,16 @@ void setup_server(server_t* s) {
   s->conn = xcb_connect(NULL, NULL);
   atoms_init(s->conn);
 
-  s->root_depth = 24;
-  s->root_visual_type = xcb_get_visualtype(s->conn, 0);
+  s->screens[0].root_depth = 24;
+  s->screens[0].root_visual_type = xcb_get_visualtype(s->conn, 0);
   slotmap_init(&s->clients, 32, sizeof(client_hot_t), sizeof(client_cold_t));
-  small_vec_init(&s->active_clients);
+  handle_vec_init(&s->active_clients);
   arena_init(&s->tick_arena, 4096);
 
   // Initialize workspace defaults
-  s->desktop_count = 4;
-  s->current_desktop = 0;
+  s->screens[0].desktop_count = 4;
+  s->screens[0].current_desktop = 0;
 
-  list_init(&s->focus_history);
 }
 
 void test_workspace_switch_basics(void) {
@@ -49,28 +52,28 @@ void test_workspace_switch_basics(void) {
   // shouldn't map it. Client 4: Sticky (Desktop -1)
 
   handle_t h1 = slotmap_alloc(&s.clients, NULL, NULL);
-  small_vec_push(&s.active_clients, handle_to_ptr(h1));
+  handle_vec_push(&s.active_clients, h1);
   client_hot_t* c1 = server_chot(&s, h1);
   c1->state = STATE_MAPPED;
   c1->desktop = 0;
   c1->frame = 1001;
 
   handle_t h2 = slotmap_alloc(&s.clients, NULL, NULL);
-  small_vec_push(&s.active_clients, handle_to_ptr(h2));
+  handle_vec_push(&s.active_clients, h2);
   client_hot_t* c2 = server_chot(&s, h2);
   c2->state = STATE_MAPPED;
   c2->desktop = 1;
   c2->frame = 1002;
 
   handle_t h3 = slotmap_alloc(&s.clients, NULL, NULL);
-  small_vec_push(&s.active_clients, handle_to_ptr(h3));
+  handle_vec_push(&s.active_clients, h3);
   client_hot_t* c3 = server_chot(&s, h3);
   c3->state = STATE_UNMAPPED;  // Minimized
   c3->desktop = 0;
   c3->frame = 1003;
 
   handle_t h4 = slotmap_alloc(&s.clients, NULL, NULL);
-  small_vec_push(&s.active_clients, handle_to_ptr(h4));
+  handle_vec_push(&s.active_clients, h4);
   client_hot_t* c4 = server_chot(&s, h4);
   c4->state = STATE_MAPPED;
   c4->desktop = 0;  // Will be sticky
@@ -83,7 +86,7 @@ void test_workspace_switch_basics(void) {
 
   // Switch to desktop 1
   printf("Switching to desktop 1...\n");
-  wm_switch_workspace(&s, 1);
+  wm_switch_workspace(&s, &s.screens[0], 1);
   wm_flush_dirty(&s, monotonic_time_ns());
 
   // Expectations:
@@ -94,7 +97,7 @@ void test_workspace_switch_basics(void) {
   // action.
 
   // Check server state
-  assert(s.current_desktop == 1);
+  assert(s.screens[0].current_desktop == 1);
 
   // We can't easily check exact sequence without a log, but we can check last
   // calls or counts. Ideally we check if unmap was called for c1 and map for
@@ -156,8 +159,9 @@ void test_workspace_switch_basics(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   arena_destroy(&s.tick_arena);
   xcb_disconnect(s.conn);
 }
@@ -167,7 +171,7 @@ void test_client_move_to_workspace(void) {
   setup_server(&s);
 
   handle_t h1 = slotmap_alloc(&s.clients, NULL, NULL);
-  small_vec_push(&s.active_clients, handle_to_ptr(h1));
+  handle_vec_push(&s.active_clients, h1);
   client_hot_t* c1 = server_chot(&s, h1);
   c1->state = STATE_MAPPED;
   c1->desktop = 0;
@@ -212,14 +216,14 @@ void test_client_move_to_workspace(void) {
   wm_client_move_to_workspace(&s, h1, 0, true);
   wm_flush_dirty(&s, monotonic_time_ns());
   assert(c1->desktop == 0);
-  assert(s.current_desktop == 0);
+  assert(s.screens[0].current_desktop == 0);
   assert(s.focused_client == h1);
 
   printf("Moving c1 to desktop 1 (follow)...\n");
   wm_client_move_to_workspace(&s, h1, 1, true);
   wm_flush_dirty(&s, monotonic_time_ns());
   assert(c1->desktop == 1);
-  assert(s.current_desktop == 1);
+  assert(s.screens[0].current_desktop == 1);
   assert(s.focused_client == h1);
 
   printf("test_client_move_to_workspace passed.\n");
@@ -234,8 +238,9 @@ void test_client_move_to_workspace(void) {
     }
   }
   arena_destroy(&s.tick_arena);
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   xcb_disconnect(s.conn);
 }
 
@@ -244,7 +249,7 @@ void test_client_toggle_sticky(void) {
   setup_server(&s);
 
   handle_t h1 = slotmap_alloc(&s.clients, NULL, NULL);
-  small_vec_push(&s.active_clients, handle_to_ptr(h1));
+  handle_vec_push(&s.active_clients, h1);
   client_hot_t* c1 = server_chot(&s, h1);
   c1->state = STATE_MAPPED;
   c1->desktop = 1;  // On hidden desktop
@@ -281,8 +286,9 @@ void test_client_toggle_sticky(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   arena_destroy(&s.tick_arena);
   xcb_disconnect(s.conn);
 }
@@ -291,24 +297,24 @@ void test_workspace_relative(void) {
   server_t s;
   setup_server(&s);
 
-  s.current_desktop = 1;
-  s.desktop_count = 4;
+  s.screens[0].current_desktop = 1;
+  s.screens[0].desktop_count = 4;
 
   printf("Switching relative +1 from 1...\n");
-  wm_switch_workspace_relative(&s, 1);
-  assert(s.current_desktop == 2);
+  wm_switch_workspace_relative(&s, &s.screens[0], 1);
+  assert(s.screens[0].current_desktop == 2);
 
   printf("Switching relative +1 from 2...\n");
-  wm_switch_workspace_relative(&s, 1);
-  assert(s.current_desktop == 3);
+  wm_switch_workspace_relative(&s, &s.screens[0], 1);
+  assert(s.screens[0].current_desktop == 3);
 
   printf("Switching relative +1 from 3 (wrap)...\n");
-  wm_switch_workspace_relative(&s, 1);
-  assert(s.current_desktop == 0);
+  wm_switch_workspace_relative(&s, &s.screens[0], 1);
+  assert(s.screens[0].current_desktop == 0);
 
   printf("Switching relative -1 from 0 (wrap)...\n");
-  wm_switch_workspace_relative(&s, -1);
-  assert(s.current_desktop == 3);
+  wm_switch_workspace_relative(&s, &s.screens[0], -1);
+  assert(s.screens[0].current_desktop == 3);
 
   printf("test_workspace_relative passed.\n");
   for (uint32_t i = 1; i < s.clients.cap; i++) {
@@ -321,8 +327,9 @@ void test_workspace_relative(void) {
       }
     }
   }
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
   arena_destroy(&s.tick_arena);
   xcb_disconnect(s.conn);
 }
@@ -332,7 +339,7 @@ void test_sticky_panel_ignores_workspace_move(void) {
   setup_server(&s);
 
   handle_t h = slotmap_alloc(&s.clients, NULL, NULL);
-  small_vec_push(&s.active_clients, handle_to_ptr(h));
+  handle_vec_push(&s.active_clients, h);
   client_hot_t* c = server_chot(&s, h);
   c->state = STATE_MAPPED;
   c->desktop = 0;
@@ -347,8 +354,235 @@ void test_sticky_panel_ignores_workspace_move(void) {
 
   printf("test_sticky_panel_ignores_workspace_move passed\n");
 
+  focus_mru_destroy(&s.focus_mru);
   slotmap_destroy(&s.clients);
-  small_vec_destroy(&s.active_clients);
+  handle_vec_destroy(&s.active_clients);
+  arena_destroy(&s.tick_arena);
+  xcb_disconnect(s.conn);
+}
+
+static void release_desktop_members(server_t* s) {
+  wm_desktop_members_destroy(s);
+  handle_vec_destroy(&s->screens[0].sticky_members);
+  handle_vec_destroy(&s->screens[0].visibility_moved);
+}
+
+static handle_t add_desktop_client(server_t* s, int32_t desktop, xcb_window_t frame, uint32_t label, uint8_t frame_vis) {
+  handle_t h = slotmap_alloc(&s->clients, NULL, NULL);
+  handle_vec_push(&s->active_clients, h);
+  client_hot_t* c = server_chot(s, h);
+  c->self = h;
+  client_set_state(s, c, STATE_MAPPED);
+  client_set_desktop(s, c, desktop);
+  c->frame = frame;
+  client_set_xid(s, c, frame + 1000);
+  c->stacking_layer = LAYER_NORMAL;
+  c->stacking_label = label;
+  client_set_frame_vis(s, c, frame_vis);
+  return h;
+}
+
+void test_workspace_switch_batches_changes(void) {
+  server_t s;
+  setup_server(&s);
+
+  handle_t h1 = add_desktop_client(&s, 0, 1001, 10, FRAME_VIS_MAPPED);
+  handle_t h2 = add_desktop_client(&s, 0, 1002, 50, FRAME_VIS_MAPPED);
+  handle_t h3 = add_desktop_client(&s, 1, 1003, 30, FRAME_VIS_HIDDEN);
+  handle_t h4 = add_desktop_client(&s, 1, 1004, 40, FRAME_VIS_HIDDEN);
+  (void)h2;
+  (void)h3;
+
+  // Only the frames that change are touched: two shown, two hidden
+  xcb_stubs_reset();
+  wm_switch_workspace(&s, &s.screens[0], 1);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_map_window_count == 2);
+  assert(stub_unmap_window_count == 2);
+  assert(stub_grab_server_count == 1 && stub_ungrab_server_count == 1);
+
+  // Mapped top-down, before the old desktop is unmapped
+  assert(stub_mapped_windows_len == 2);
+  assert(stub_mapped_windows[0] == 1004);
+  assert(stub_mapped_windows[1] == 1003);
+
+  // A repeated pass with nothing changed issues no requests
+  xcb_stubs_reset();
+  s.screens[0].root_dirty |= ROOT_DIRTY_VISIBILITY;
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_map_window_count == 0);
+  assert(stub_unmap_window_count == 0);
+  assert(stub_grab_server_count == 0);
+
+  // The desktop's own MRU head decides focus on the way back
+  s.focused_client = h4;
+  wm_desktop_focus_note(&s, 0, h1);
+  xcb_stubs_reset();
+  wm_switch_workspace(&s, &s.screens[0], 0);
+  assert(s.focused_client == h1);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_mapped_windows_len == 2);
+  assert(stub_mapped_windows[0] == 1002);
+  assert(stub_mapped_windows[1] == 1001);
+
+  printf("test_workspace_switch_batches_changes passed.\n");
+  release_desktop_members(&s);
+  free(s.screens[0].desktop_focus);
+  focus_mru_destroy(&s.focus_mru);
+  slotmap_destroy(&s.clients);
+  handle_vec_destroy(&s.active_clients);
+  arena_destroy(&s.tick_arena);
+  xcb_disconnect(s.conn);
+}
+
+void test_desktop_membership_index(void) {
+  server_t s;
+  setup_server(&s);
+
+  handle_t h1 = add_desktop_client(&s, 0, 1001, 10, FRAME_VIS_UNKNOWN);
+  handle_t h2 = add_desktop_client(&s, 1, 1002, 20, FRAME_VIS_UNKNOWN);
+  handle_t h3 = add_desktop_client(&s, 2, 1003, 30, FRAME_VIS_UNKNOWN);
+  handle_t h4 = add_desktop_client(&s, 0, 1004, 40, FRAME_VIS_UNKNOWN);
+  server_chot(&s, h4)->sticky = true;
+
+  // First pass builds the index and reconciles every frame
+  s.screens[0].root_dirty |= ROOT_DIRTY_VISIBILITY;
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(s.desktop_members_valid);
+  assert(stub_map_window_count == 2);
+  assert(stub_unmap_window_count == 2);
+  assert(wm_desktop_members(&s, &s.screens[0], 0)->length == 1 && wm_desktop_members(&s, &s.screens[0], 0)->items[0] == h1);
+  assert(wm_desktop_members(&s, &s.screens[0], 1)->length == 1 && wm_desktop_members(&s, &s.screens[0], 1)->items[0] == h2);
+  assert(wm_desktop_members(&s, &s.screens[0], 3)->length == 0);
+  assert(s.screens[0].sticky_members.length == 1 && s.screens[0].sticky_members.items[0] == h4);
+
+  // Moves and sticky toggles only touch the lists involved
+  wm_client_move_to_workspace(&s, h1, 2, false);
+  wm_client_toggle_sticky(&s, h2);
+  assert(wm_desktop_members(&s, &s.screens[0], 0)->length == 0);
+  assert(wm_desktop_members(&s, &s.screens[0], 1)->length == 0);
+  assert(wm_desktop_members(&s, &s.screens[0], 2)->length == 2 && wm_desktop_members(&s, &s.screens[0], 2)->items[1] == h1);
+  assert(s.screens[0].sticky_members.length == 2);
+  assert(s.screens[0].visibility_moved.length == 2);
+
+  // Only the moved clients are revisited: h3 is parked on desktop 2 and a
+  // pass that scanned everything would re-request its unmap
+  server_chot(&s, h3)->frame_vis = FRAME_VIS_UNKNOWN;
+  xcb_stubs_reset();
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_unmap_window_count == 1);
+  assert(stub_last_unmapped_window == 1001);
+  assert(stub_map_window_count == 1);
+  assert(stub_last_mapped_window == 1002);
+  assert(s.screens[0].visibility_moved.length == 0);
+
+  // Switching covers both the old and the new desktop
+  xcb_stubs_reset();
+  wm_switch_workspace(&s, &s.screens[0], 2);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_map_window_count == 2);
+  assert(stub_unmap_window_count == 0);
+
+  // Unmanaged clients leave the index; clients added behind its back force a rebuild
+  wm_desktop_members_remove(&s, h3);
+  handle_vec_remove(&s.active_clients, h3);
+  assert(wm_desktop_members(&s, &s.screens[0], 2)->length == 1);
+  assert(s.desktop_members_valid);
+  add_desktop_client(&s, 3, 1005, 50, FRAME_VIS_UNKNOWN);
+  assert(wm_desktop_members(&s, &s.screens[0], 3)->length == 1);
+
+  printf("test_desktop_membership_index passed.\n");
+  release_desktop_members(&s);
+  free(s.screens[0].desktop_focus);
+  focus_mru_destroy(&s.focus_mru);
+  slotmap_destroy(&s.clients);
+  handle_vec_destroy(&s.active_clients);
+  arena_destroy(&s.tick_arena);
+  xcb_disconnect(s.conn);
+}
+
+void test_workspace_switch_reads_client_columns(void) {
+  server_t s;
+  setup_server(&s);
+  assert(server_client_cols_init(&s));
+
+  handle_t h1 = add_desktop_client(&s, 0, 1001, 10, FRAME_VIS_MAPPED);
+  handle_t h2 = add_desktop_client(&s, 1, 1002, 20, FRAME_VIS_HIDDEN);
+  handle_t h3 = add_desktop_client(&s, 0, 1003, 30, FRAME_VIS_MAPPED);
+  client_set_sticky(&s, server_chot(&s, h3), true);
+
+  client_cols_t cols;
+  assert(server_client_cols(&s, &cols));
+  assert(cols.xid[handle_index(h2)] == 2002);
+  assert(cols.desktop[handle_index(h2)] == 1);
+  assert(cols.sticky[handle_index(h3)] == 1);
+
+  // Same decisions as the client_hot_t path; the sticky frame is left alone
+  xcb_stubs_reset();
+  wm_switch_workspace(&s, &s.screens[0], 1);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_map_window_count == 1 && stub_last_mapped_window == 1002);
+  assert(stub_unmap_window_count == 1 && stub_last_unmapped_window == 1001);
+  assert(cols.frame_vis[handle_index(h1)] == FRAME_VIS_HIDDEN);
+  assert(cols.frame_vis[handle_index(h2)] == FRAME_VIS_MAPPED);
+
+  // Moves go through the setters and keep the columns in step
+  wm_client_move_to_workspace(&s, h1, 1, false);
+  assert(cols.desktop[handle_index(h1)] == 1);
+  xcb_stubs_reset();
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(stub_map_window_count == 1 && stub_last_mapped_window == 1001);
+
+  printf("test_workspace_switch_reads_client_columns passed.\n");
+  release_desktop_members(&s);
+  free(s.screens[0].desktop_focus);
+  focus_mru_destroy(&s.focus_mru);
+  slotmap_destroy(&s.clients);
+  handle_vec_destroy(&s.active_clients);
+  arena_destroy(&s.tick_arena);
+  xcb_disconnect(s.conn);
+}
+
+void test_desktops_are_per_screen(void) {
+  server_t s;
+  setup_server(&s);
+  s.screen_count = 2;
+  s.screens[0].root = 100;
+  s.screens[1].num = 1;
+  s.screens[1].root = 200;
+  s.screens[1].desktop_count = 4;
+  s.screens[1].current_desktop = 2;
+  s.screens[1].visible_desktop = 2;
+
+  handle_t h1 = add_desktop_client(&s, 0, 1001, 10, FRAME_VIS_MAPPED);
+  handle_t h2 = add_desktop_client(&s, 0, 1002, 20, FRAME_VIS_MAPPED);
+
+  // The geometry reply names screen 1's root: the client joins its current desktop
+  client_note_root(&s, server_chot(&s, h2), 200);
+  assert(server_chot(&s, h2)->screen == 1);
+  assert(server_chot(&s, h2)->desktop == 2);
+  assert(wm_desktop_members(&s, &s.screens[0], 0)->length == 1);
+  assert(wm_desktop_members(&s, &s.screens[1], 2)->length == 1 && wm_desktop_members(&s, &s.screens[1], 2)->items[0] == h2);
+
+  // Switching screen 1's desktop leaves screen 0 alone
+  xcb_stubs_reset();
+  wm_switch_workspace(&s, &s.screens[1], 0);
+  wm_flush_dirty(&s, monotonic_time_ns());
+  assert(s.screens[1].current_desktop == 0);
+  assert(s.screens[0].current_desktop == 0);
+  assert(stub_map_window_count == 0);
+  assert(stub_unmap_window_count == 1 && stub_last_unmapped_window == 1002);
+  assert(server_chot(&s, h1)->frame_vis == FRAME_VIS_MAPPED);
+
+  printf("test_desktops_are_per_screen passed.\n");
+  release_desktop_members(&s);
+  handle_vec_destroy(&s.screens[1].sticky_members);
+  handle_vec_destroy(&s.screens[1].visibility_moved);
+  free(s.screens[0].desktop_focus);
+  free(s.screens[1].desktop_focus);
+  focus_mru_destroy(&s.focus_mru);
+  slotmap_destroy(&s.clients);
+  handle_vec_destroy(&s.active_clients);
   arena_destroy(&s.tick_arena);
   xcb_disconnect(s.conn);
 }
@@ -357,8 +591,12 @@ int main(void) {
   test_workspace_switch_basics();
   test_client_move_to_workspace();
   test_client_toggle_sticky();
+  test_workspace_switch_batches_changes();
+  test_desktop_membership_index();
+  test_workspace_switch_reads_client_columns();
   test_sticky_panel_ignores_workspace_move();
   test_workspace_relative();
+  test_desktops_are_per_screen();
   printf("All tests passed!\n");
   return 0;
 }
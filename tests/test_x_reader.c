@@ -0,0 +1,119 @@
+#include <assert.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "x_reader.h"
+
+extern void xcb_stubs_reset(void);
+extern bool xcb_stubs_enqueue_event(xcb_generic_event_t* ev);
+
+static void enqueue_motion(xcb_window_t win, int16_t x) {
+  xcb_motion_notify_event_t* ev = calloc(1, sizeof(xcb_generic_event_t));
+  ev->response_type = XCB_MOTION_NOTIFY;
+  ev->event = win;
+  ev->event_x = x;
+  assert(xcb_stubs_enqueue_event((xcb_generic_event_t*)ev));
+}
+
+static void enqueue_configure(xcb_window_t win, int16_t x) {
+  xcb_configure_notify_event_t* ev = calloc(1, sizeof(xcb_generic_event_t));
+  ev->response_type = XCB_CONFIGURE_NOTIFY;
+  ev->window = win;
+  ev->x = x;
+  assert(xcb_stubs_enqueue_event((xcb_generic_event_t*)ev));
+}
+
+static void enqueue_property(xcb_window_t win, xcb_atom_t atom, xcb_timestamp_t time) {
+  xcb_property_notify_event_t* ev = calloc(1, sizeof(xcb_generic_event_t));
+  ev->response_type = XCB_PROPERTY_NOTIFY;
+  ev->window = win;
+  ev->atom = atom;
+  ev->time = time;
+  assert(xcb_stubs_enqueue_event((xcb_generic_event_t*)ev));
+}
+
+static void test_x_reader_folds_adjacent_runs(void) {
+  xcb_stubs_reset();
+  xcb_connection_t* conn = xcb_connect(NULL, NULL);
+
+  enqueue_motion(1, 1);
+  enqueue_motion(1, 2);
+  enqueue_motion(2, 3);
+  enqueue_configure(3, 1);
+  enqueue_configure(3, 5);
+  enqueue_property(4, 10, 100);
+  enqueue_property(4, 10, 200);
+  enqueue_property(4, 11, 300);
+  xcb_generic_event_t* key = calloc(1, sizeof(*key));
+  key->response_type = XCB_KEY_PRESS;
+  assert(xcb_stubs_enqueue_event(key));
+
+  x_reader_t r;
+  memset(&r, 0, sizeof(r));
+  assert(x_reader_start(&r, conn));
+  assert(x_reader_active(&r));
+
+  xcb_generic_event_t* got[6] = {0};
+  size_t n = 0;
+  for (int spins = 0; n < 6 && spins < 200; spins++) {
+    struct pollfd pfd = {.fd = r.notify_fd, .events = POLLIN};
+    if (poll(&pfd, 1, 10) > 0)
+      x_reader_take_notify(&r);
+    xcb_generic_event_t* ev;
+    while (n < 6 && (ev = x_reader_pop(&r)))
+      got[n++] = ev;
+  }
+  assert(n == 6);
+
+  const xcb_motion_notify_event_t* m0 = (const xcb_motion_notify_event_t*)got[0];
+  assert(m0->response_type == XCB_MOTION_NOTIFY && m0->event == 1 && m0->event_x == 2);
+  const xcb_motion_notify_event_t* m1 = (const xcb_motion_notify_event_t*)got[1];
+  assert(m1->response_type == XCB_MOTION_NOTIFY && m1->event == 2);
+  const xcb_configure_notify_event_t* c0 = (const xcb_configure_notify_event_t*)got[2];
+  assert(c0->response_type == XCB_CONFIGURE_NOTIFY && c0->window == 3 && c0->x == 5);
+  const xcb_property_notify_event_t* p0 = (const xcb_property_notify_event_t*)got[3];
+  assert(p0->response_type == XCB_PROPERTY_NOTIFY && p0->atom == 10 && p0->time == 100);
+  const xcb_property_notify_event_t* p1 = (const xcb_property_notify_event_t*)got[4];
+  assert(p1->response_type == XCB_PROPERTY_NOTIFY && p1->atom == 11);
+  assert(got[5]->response_type == XCB_KEY_PRESS);
+
+  x_reader_stop(&r);
+  assert(!r.running);
+  assert(!x_reader_pending(&r));
+  assert(!x_reader_active(&r));
+
+  char report[512];
+  assert(x_reader_format(&r, report, sizeof(report)) > 0);
+  assert(strstr(report, "motion=3/1"));
+  assert(strstr(report, "configure=2/1"));
+  assert(strstr(report, "property=3/1"));
+  assert(strstr(report, "other=1/0"));
+
+  for (size_t i = 0; i < n; i++)
+    free(got[i]);
+  x_reader_destroy(&r);
+  xcb_disconnect(conn);
+  printf("test_x_reader_folds_adjacent_runs passed\n");
+}
+
+static void test_x_reader_zeroed_is_idle(void) {
+  x_reader_t r;
+  memset(&r, 0, sizeof(r));
+  assert(!x_reader_active(&r));
+  assert(x_reader_pop(&r) == NULL);
+  x_reader_kick(&r);
+  x_reader_stop(&r);
+
+  char report[64];
+  assert(x_reader_format(&r, report, sizeof(report)) == 0);
+  x_reader_destroy(&r);
+  printf("test_x_reader_zeroed_is_idle passed\n");
+}
+
+int main(void) {
+  test_x_reader_folds_adjacent_runs();
+  test_x_reader_zeroed_is_idle();
+  return 0;
+}
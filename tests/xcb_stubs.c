@@ -5,10 +5,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <xcb/composite.h>
 #include <xcb/damage.h>
 #include <xcb/randr.h>
+#include <xcb/shape.h>
 #include <xcb/sync.h>
 #include <xcb/xcb.h>
+#include <xcb/xinput.h>
+#include <xcb/xkb.h>
 #include <xcb/xproto.h>
 
 /*
@@ -34,6 +38,10 @@ static uint32_t stub_xid_counter = 100;
 static uint32_t stub_cookie_seq = 1;
 static uint32_t stub_query_pointer_sequence = UINT32_MAX;
 
+// Every request the code under test issued (checked variants count once),
+// for perf_pipeline's requests-per-operation figures
+uint64_t stub_request_count = 0;
+
 static int stub_xcb_fd = -1;
 
 // Extension data reply
@@ -64,6 +72,15 @@ static xcb_atom_t stub_atom_counter = 1;
 uint32_t stub_last_image_w = 0;
 uint32_t stub_last_image_h = 0;
 uint8_t stub_last_image_data[200 * 1024];
+xcb_drawable_t stub_last_image_drawable = XCB_NONE;
+int stub_put_image_count = 0;
+int stub_configure_count_at_first_image = -1;
+
+// Pixmap / background capture
+int stub_free_pixmap_count = 0;
+int stub_clear_area_count = 0;
+int stub_change_window_attributes_count = 0;
+xcb_window_t stub_last_clear_area_window = XCB_NONE;
 
 // Property capture for assertions
 xcb_window_t stub_last_prop_window = 0;
@@ -132,6 +149,18 @@ typedef struct stub_config_call {
 } stub_config_call_t;
 
 stub_config_call_t stub_config_calls[STUB_MAX_CONFIG_CALLS];
+
+// Passive button grabs currently in place, as the server would hold them
+#define STUB_MAX_BUTTON_GRABS 8192
+typedef struct stub_button_grab {
+  xcb_window_t window;
+  uint8_t button;
+  uint8_t pointer_mode;
+  uint16_t modifiers;
+} stub_button_grab_t;
+
+static stub_button_grab_t stub_button_grabs[STUB_MAX_BUTTON_GRABS];
+static size_t stub_button_grabs_len = 0;
 int stub_config_calls_len = 0;
 
 // Send event capture
@@ -147,12 +176,18 @@ xcb_window_t stub_last_destroyed_window = 0;
 
 // Grab button capture
 int stub_grab_button_count = 0;
+int stub_ungrab_button_count = 0;
 int stub_grab_key_count = 0;
 int stub_ungrab_key_count = 0;
+int stub_grab_keyboard_count = 0;
+int stub_ungrab_keyboard_count = 0;
 int stub_grab_pointer_count = 0;
 int stub_ungrab_pointer_count = 0;
 uint16_t stub_last_grab_key_mods = 0;
 xcb_keycode_t stub_last_grab_keycode = 0;
+// Added to every keycode xcb_key_symbols_get_keycode returns, to model a remap
+uint8_t stub_keycode_offset = 0;
+int stub_refresh_keyboard_mapping_count = 0;
 xcb_cursor_t stub_last_grab_pointer_cursor = XCB_NONE;
 int stub_install_colormap_count = 0;
 xcb_colormap_t stub_last_installed_colormap = XCB_NONE;
@@ -165,6 +200,20 @@ xcb_window_t stub_last_reparent_parent = XCB_NONE;
 int16_t stub_last_reparent_x = 0;
 int16_t stub_last_reparent_y = 0;
 int stub_sync_await_count = 0;
+int stub_sync_create_alarm_count = 0;
+int stub_sync_change_alarm_count = 0;
+int stub_sync_destroy_alarm_count = 0;
+int stub_grab_server_count = 0;
+int stub_ungrab_server_count = 0;
+int stub_composite_redirect_count = 0;
+int stub_composite_unredirect_count = 0;
+int stub_composite_name_pixmap_count = 0;
+int stub_composite_redirect_subwindows_count = 0;
+int stub_composite_unredirect_subwindows_count = 0;
+int stub_damage_create_count = 0;
+int stub_damage_destroy_count = 0;
+int stub_xi_grab_device_count = 0;
+xcb_cursor_t stub_last_xi_grab_cursor = XCB_NONE;
 
 // Optional reply hook for cookie draining
 int (*stub_poll_for_reply_hook)(xcb_connection_t* c, unsigned int request, void** reply, xcb_generic_error_t** error) = NULL;
@@ -187,6 +236,7 @@ void xcb_stubs_reset(void) {
   stub_xid_counter = 100;
   stub_cookie_seq = 1;
   stub_query_pointer_sequence = UINT32_MAX;
+  stub_request_count = 0;
 
   memset(&stub_ext_reply, 0, sizeof(stub_ext_reply));
   stub_ext_reply.present = 1;
@@ -240,12 +290,18 @@ void xcb_stubs_reset(void) {
   stub_last_destroyed_window = 0;
 
   stub_grab_button_count = 0;
+  stub_ungrab_button_count = 0;
+  stub_button_grabs_len = 0;
   stub_grab_key_count = 0;
   stub_ungrab_key_count = 0;
+  stub_grab_keyboard_count = 0;
+  stub_ungrab_keyboard_count = 0;
   stub_grab_pointer_count = 0;
   stub_ungrab_pointer_count = 0;
   stub_last_grab_key_mods = 0;
   stub_last_grab_keycode = 0;
+  stub_keycode_offset = 0;
+  stub_refresh_keyboard_mapping_count = 0;
   stub_last_grab_pointer_cursor = XCB_NONE;
   stub_install_colormap_count = 0;
   stub_last_installed_colormap = XCB_NONE;
@@ -258,10 +314,32 @@ void xcb_stubs_reset(void) {
   stub_last_reparent_x = 0;
   stub_last_reparent_y = 0;
   stub_sync_await_count = 0;
+  stub_sync_create_alarm_count = 0;
+  stub_sync_change_alarm_count = 0;
+  stub_sync_destroy_alarm_count = 0;
+  stub_grab_server_count = 0;
+  stub_ungrab_server_count = 0;
+  stub_composite_redirect_count = 0;
+  stub_composite_unredirect_count = 0;
+  stub_composite_name_pixmap_count = 0;
+  stub_composite_redirect_subwindows_count = 0;
+  stub_composite_unredirect_subwindows_count = 0;
+  stub_damage_create_count = 0;
+  stub_damage_destroy_count = 0;
+  stub_xi_grab_device_count = 0;
+  stub_last_xi_grab_cursor = XCB_NONE;
 
   stub_last_image_w = 0;
   stub_last_image_h = 0;
   memset(stub_last_image_data, 0, sizeof(stub_last_image_data));
+  stub_last_image_drawable = XCB_NONE;
+  stub_put_image_count = 0;
+  stub_configure_count_at_first_image = -1;
+
+  stub_free_pixmap_count = 0;
+  stub_clear_area_count = 0;
+  stub_change_window_attributes_count = 0;
+  stub_last_clear_area_window = XCB_NONE;
 
   stub_poll_for_reply_hook = NULL;
 
@@ -316,6 +394,11 @@ int xcb_flush(xcb_connection_t* c) {
   return 1;
 }
 
+uint64_t xcb_total_written(xcb_connection_t* c) {
+  (void)c;
+  return 0;
+}
+
 // Setup/screen helpers
 const xcb_setup_t* xcb_get_setup(xcb_connection_t* c) {
   (void)c;
@@ -348,6 +431,11 @@ const xcb_query_extension_reply_t* xcb_get_extension_data(xcb_connection_t* c, x
   return &stub_ext_reply;
 }
 
+void xcb_prefetch_extension_data(xcb_connection_t* c, xcb_extension_t* ext) {
+  (void)c;
+  (void)ext;
+}
+
 // XID generation
 xcb_font_t xcb_generate_id(xcb_connection_t* c) {
   (void)c;
@@ -356,6 +444,7 @@ xcb_font_t xcb_generate_id(xcb_connection_t* c) {
 
 // Atoms
 xcb_intern_atom_cookie_t xcb_intern_atom(xcb_connection_t* c, uint8_t only_if_exists, uint16_t name_len, const char* name) {
+  stub_request_count++;
   (void)c;
   (void)only_if_exists;
   (void)name_len;
@@ -387,6 +476,7 @@ xcb_void_cookie_t xcb_create_window(xcb_connection_t* c,
                                     xcb_visualid_t visual,
                                     uint32_t value_mask,
                                     const void* value_list) {
+  stub_request_count++;
   (void)c;
   (void)depth;
   (void)wid;
@@ -420,10 +510,12 @@ xcb_void_cookie_t xcb_create_window_checked(xcb_connection_t* c,
 }
 
 xcb_void_cookie_t xcb_change_window_attributes(xcb_connection_t* c, xcb_window_t window, uint32_t value_mask, const void* value_list) {
+  stub_request_count++;
   (void)c;
   (void)window;
   (void)value_mask;
   (void)value_list;
+  stub_change_window_attributes_count++;
   return (xcb_void_cookie_t){0};
 }
 
@@ -447,6 +539,7 @@ xcb_generic_error_t* xcb_request_check(xcb_connection_t* c, xcb_void_cookie_t co
 }
 
 xcb_void_cookie_t xcb_destroy_window(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   stub_destroy_window_count++;
   stub_last_destroyed_window = window;
@@ -458,6 +551,7 @@ xcb_void_cookie_t xcb_destroy_window_checked(xcb_connection_t* c, xcb_window_t w
 }
 
 xcb_void_cookie_t xcb_map_window(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   stub_map_window_count++;
   stub_last_mapped_window = window;
@@ -474,6 +568,7 @@ xcb_void_cookie_t xcb_map_window_checked(xcb_connection_t* c, xcb_window_t windo
 }
 
 xcb_void_cookie_t xcb_unmap_window(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   stub_unmap_window_count++;
   stub_last_unmapped_window = window;
@@ -485,6 +580,7 @@ xcb_void_cookie_t xcb_unmap_window_checked(xcb_connection_t* c, xcb_window_t win
 }
 
 xcb_void_cookie_t xcb_configure_window(xcb_connection_t* c, xcb_window_t window, uint16_t value_mask, const void* value_list) {
+  stub_request_count++;
   (void)c;
 
   stub_configure_window_count++;
@@ -557,6 +653,7 @@ const stub_config_call_t* stub_config_call_at(int idx) {
 
 // Properties
 xcb_void_cookie_t xcb_change_property(xcb_connection_t* c, uint8_t mode, xcb_window_t window, xcb_atom_t property, xcb_atom_t type, uint8_t format, uint32_t data_len, const void* data) {
+  stub_request_count++;
   (void)c;
   (void)mode;
 
@@ -602,6 +699,7 @@ xcb_void_cookie_t xcb_change_property_checked(xcb_connection_t* c, uint8_t mode,
 }
 
 xcb_void_cookie_t xcb_delete_property(xcb_connection_t* c, xcb_window_t window, xcb_atom_t property) {
+  stub_request_count++;
   (void)c;
   stub_last_prop_window = window;
   stub_last_prop_atom = property;
@@ -626,6 +724,7 @@ xcb_void_cookie_t xcb_delete_property_checked(xcb_connection_t* c, xcb_window_t
 
 // Queries and replies
 xcb_get_window_attributes_cookie_t xcb_get_window_attributes(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   xcb_get_window_attributes_cookie_t cookie;
   cookie.sequence = stub_cookie_seq++;
@@ -636,6 +735,7 @@ xcb_get_window_attributes_cookie_t xcb_get_window_attributes(xcb_connection_t* c
 }
 
 xcb_get_geometry_cookie_t xcb_get_geometry(xcb_connection_t* c, xcb_drawable_t drawable) {
+  stub_request_count++;
   (void)c;
   (void)drawable;
   xcb_get_geometry_cookie_t cookie;
@@ -644,6 +744,7 @@ xcb_get_geometry_cookie_t xcb_get_geometry(xcb_connection_t* c, xcb_drawable_t d
 }
 
 xcb_get_property_cookie_t xcb_get_property(xcb_connection_t* c, uint8_t _delete, xcb_window_t window, xcb_atom_t property, xcb_atom_t type, uint32_t long_offset, uint32_t long_len) {
+  stub_request_count++;
   (void)c;
   (void)_delete;
   (void)window;
@@ -670,6 +771,7 @@ xcb_get_property_reply_t* xcb_get_property_reply(xcb_connection_t* c, xcb_get_pr
 }
 
 xcb_query_tree_cookie_t xcb_query_tree(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   (void)window;
   return (xcb_query_tree_cookie_t){0};
@@ -712,6 +814,7 @@ void xcb_stubs_set_query_pointer_sequence(uint32_t sequence) {
 }
 
 xcb_query_pointer_cookie_t xcb_query_pointer(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   (void)window;
   xcb_query_pointer_cookie_t cookie;
@@ -751,6 +854,7 @@ bool xcb_stubs_attr_request_window(uint32_t seq, xcb_window_t* out_window) {
 
 // Input focus and grabs
 xcb_void_cookie_t xcb_set_input_focus(xcb_connection_t* c, uint8_t revert_to, xcb_window_t focus, xcb_timestamp_t time) {
+  stub_request_count++;
   (void)c;
   stub_set_input_focus_count++;
   stub_last_input_focus_window = focus;
@@ -765,6 +869,7 @@ xcb_void_cookie_t xcb_set_input_focus_checked(xcb_connection_t* c, uint8_t rever
 
 // Optional, if your WM uses this
 xcb_void_cookie_t xcb_map_subwindows(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   (void)window;
   return (xcb_void_cookie_t){0};
@@ -775,6 +880,7 @@ xcb_void_cookie_t xcb_map_subwindows_checked(xcb_connection_t* c, xcb_window_t w
 }
 
 xcb_void_cookie_t xcb_grab_key(xcb_connection_t* c, uint8_t owner_events, xcb_window_t grab_window, uint16_t modifiers, xcb_keycode_t key, uint8_t pointer_mode, uint8_t keyboard_mode) {
+  stub_request_count++;
   (void)c;
   (void)owner_events;
   (void)grab_window;
@@ -786,7 +892,13 @@ xcb_void_cookie_t xcb_grab_key(xcb_connection_t* c, uint8_t owner_events, xcb_wi
   return (xcb_void_cookie_t){0};
 }
 
+xcb_void_cookie_t xcb_grab_key_checked(xcb_connection_t* c, uint8_t owner_events, xcb_window_t grab_window, uint16_t modifiers, xcb_keycode_t key, uint8_t pointer_mode, uint8_t keyboard_mode) {
+  xcb_grab_key(c, owner_events, grab_window, modifiers, key, pointer_mode, keyboard_mode);
+  return (xcb_void_cookie_t){stub_cookie_seq++};
+}
+
 xcb_void_cookie_t xcb_ungrab_key(xcb_connection_t* c, xcb_keycode_t key, xcb_window_t grab_window, uint16_t modifiers) {
+  stub_request_count++;
   (void)c;
   (void)key;
   (void)grab_window;
@@ -804,6 +916,7 @@ xcb_grab_pointer_cookie_t xcb_grab_pointer(xcb_connection_t* c,
                                            xcb_window_t confine_to,
                                            xcb_cursor_t cursor,
                                            xcb_timestamp_t time) {
+  stub_request_count++;
   (void)c;
   (void)owner_events;
   (void)grab_window;
@@ -827,6 +940,7 @@ xcb_grab_pointer_reply_t* xcb_grab_pointer_reply(xcb_connection_t* c, xcb_grab_p
 }
 
 xcb_void_cookie_t xcb_ungrab_pointer(xcb_connection_t* c, xcb_timestamp_t time) {
+  stub_request_count++;
   (void)c;
   (void)time;
   stub_ungrab_pointer_count++;
@@ -843,22 +957,58 @@ xcb_void_cookie_t xcb_grab_button(xcb_connection_t* c,
                                   xcb_cursor_t cursor,
                                   uint8_t button,
                                   uint16_t modifiers) {
+  stub_request_count++;
   (void)c;
   (void)owner_events;
-  (void)grab_window;
   (void)event_mask;
-  (void)pointer_mode;
   (void)keyboard_mode;
   (void)confine_to;
   (void)cursor;
-  (void)button;
-  (void)modifiers;
 
   stub_grab_button_count++;
+  // A grab of the same combination replaces the previous one
+  size_t i = 0;
+  while (i < stub_button_grabs_len && !(stub_button_grabs[i].window == grab_window && stub_button_grabs[i].button == button && stub_button_grabs[i].modifiers == modifiers))
+    i++;
+  if (i == stub_button_grabs_len) {
+    if (i == STUB_MAX_BUTTON_GRABS)
+      return (xcb_void_cookie_t){0};
+    stub_button_grabs_len++;
+  }
+  stub_button_grabs[i] = (stub_button_grab_t){.window = grab_window, .button = button, .pointer_mode = pointer_mode, .modifiers = modifiers};
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_ungrab_button(xcb_connection_t* c, uint8_t button, xcb_window_t grab_window, uint16_t modifiers) {
+  stub_request_count++;
+  (void)c;
+  stub_ungrab_button_count++;
+  size_t kept = 0;
+  for (size_t i = 0; i < stub_button_grabs_len; i++) {
+    const stub_button_grab_t* g = &stub_button_grabs[i];
+    bool match = g->window == grab_window && (button == XCB_BUTTON_INDEX_ANY || g->button == button) && (modifiers == XCB_MOD_MASK_ANY || g->modifiers == modifiers);
+    if (!match)
+      stub_button_grabs[kept++] = *g;
+  }
+  stub_button_grabs_len = kept;
   return (xcb_void_cookie_t){0};
 }
 
+// True when a press of button with state on window activates a synchronous grab
+bool xcb_stubs_button_grab_freezes(xcb_window_t window, uint8_t button, uint16_t state) {
+  uint16_t mods = state & 0xffu;
+  for (size_t i = 0; i < stub_button_grabs_len; i++) {
+    const stub_button_grab_t* g = &stub_button_grabs[i];
+    if (g->window != window || (g->button != XCB_BUTTON_INDEX_ANY && g->button != button))
+      continue;
+    if (g->modifiers == XCB_MOD_MASK_ANY || g->modifiers == mods)
+      return g->pointer_mode == XCB_GRAB_MODE_SYNC;
+  }
+  return false;
+}
+
 xcb_void_cookie_t xcb_allow_events(xcb_connection_t* c, uint8_t mode, xcb_timestamp_t time) {
+  stub_request_count++;
   (void)c;
   (void)mode;
   (void)time;
@@ -866,16 +1016,20 @@ xcb_void_cookie_t xcb_allow_events(xcb_connection_t* c, uint8_t mode, xcb_timest
 }
 
 xcb_grab_keyboard_cookie_t xcb_grab_keyboard(xcb_connection_t* c, uint8_t owner_events, xcb_window_t grab_window, xcb_timestamp_t time, uint8_t pointer_mode, uint8_t keyboard_mode) {
+  stub_request_count++;
   (void)c;
   (void)owner_events;
   (void)grab_window;
   (void)time;
   (void)pointer_mode;
   (void)keyboard_mode;
-  return (xcb_grab_keyboard_cookie_t){0};
+  stub_grab_keyboard_count++;
+  return (xcb_grab_keyboard_cookie_t){stub_cookie_seq++};
 }
 
 xcb_void_cookie_t xcb_ungrab_keyboard(xcb_connection_t* c, xcb_timestamp_t time) {
+  stub_request_count++;
+  stub_ungrab_keyboard_count++;
   (void)c;
   (void)time;
   return (xcb_void_cookie_t){0};
@@ -883,6 +1037,7 @@ xcb_void_cookie_t xcb_ungrab_keyboard(xcb_connection_t* c, xcb_timestamp_t time)
 
 // Save-set and reparenting
 xcb_void_cookie_t xcb_change_save_set(xcb_connection_t* c, uint8_t mode, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   if (mode == XCB_SET_MODE_INSERT) {
     stub_save_set_insert_count++;
@@ -895,6 +1050,7 @@ xcb_void_cookie_t xcb_change_save_set(xcb_connection_t* c, uint8_t mode, xcb_win
 }
 
 xcb_void_cookie_t xcb_reparent_window(xcb_connection_t* c, xcb_window_t window, xcb_window_t parent, int16_t x, int16_t y) {
+  stub_request_count++;
   (void)c;
   stub_reparent_window_count++;
   stub_last_reparent_window = window;
@@ -906,6 +1062,7 @@ xcb_void_cookie_t xcb_reparent_window(xcb_connection_t* c, xcb_window_t window,
 
 // Event send and kill
 xcb_void_cookie_t xcb_send_event(xcb_connection_t* c, uint8_t propagate, xcb_window_t destination, uint32_t event_mask, const char* event) {
+  stub_request_count++;
   (void)c;
   (void)propagate;
   (void)event_mask;
@@ -919,6 +1076,7 @@ xcb_void_cookie_t xcb_send_event(xcb_connection_t* c, uint8_t propagate, xcb_win
 }
 
 xcb_void_cookie_t xcb_sync_await(xcb_connection_t* c, uint32_t wait_list_len, const xcb_sync_waitcondition_t* wait_list) {
+  stub_request_count++;
   (void)c;
   (void)wait_list_len;
   (void)wait_list;
@@ -926,7 +1084,71 @@ xcb_void_cookie_t xcb_sync_await(xcb_connection_t* c, uint32_t wait_list_len, co
   return (xcb_void_cookie_t){0};
 }
 
+xcb_sync_initialize_cookie_t xcb_sync_initialize(xcb_connection_t* c, uint8_t desired_major_version, uint8_t desired_minor_version) {
+  stub_request_count++;
+  (void)c;
+  (void)desired_major_version;
+  (void)desired_minor_version;
+  return (xcb_sync_initialize_cookie_t){0};
+}
+
+xcb_sync_initialize_reply_t* xcb_sync_initialize_reply(xcb_connection_t* c, xcb_sync_initialize_cookie_t cookie, xcb_generic_error_t** e) {
+  (void)c;
+  (void)cookie;
+  if (e)
+    *e = NULL;
+  xcb_sync_initialize_reply_t* r = calloc(1, sizeof(*r));
+  if (r) {
+    r->major_version = XCB_SYNC_MAJOR_VERSION;
+    r->minor_version = XCB_SYNC_MINOR_VERSION;
+  }
+  return r;
+}
+
+xcb_void_cookie_t xcb_sync_create_alarm(xcb_connection_t* c, xcb_sync_alarm_t id, uint32_t value_mask, const void* value_list) {
+  stub_request_count++;
+  (void)c;
+  (void)id;
+  (void)value_mask;
+  (void)value_list;
+  stub_sync_create_alarm_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_sync_change_alarm(xcb_connection_t* c, xcb_sync_alarm_t id, uint32_t value_mask, const void* value_list) {
+  stub_request_count++;
+  (void)c;
+  (void)id;
+  (void)value_mask;
+  (void)value_list;
+  stub_sync_change_alarm_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_sync_destroy_alarm(xcb_connection_t* c, xcb_sync_alarm_t alarm) {
+  stub_request_count++;
+  (void)c;
+  (void)alarm;
+  stub_sync_destroy_alarm_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_grab_server(xcb_connection_t* c) {
+  stub_request_count++;
+  (void)c;
+  stub_grab_server_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_ungrab_server(xcb_connection_t* c) {
+  stub_request_count++;
+  (void)c;
+  stub_ungrab_server_count++;
+  return (xcb_void_cookie_t){0};
+}
+
 xcb_void_cookie_t xcb_kill_client(xcb_connection_t* c, uint32_t resource) {
+  stub_request_count++;
   (void)c;
   stub_kill_client_count++;
   stub_last_kill_client_resource = resource;
@@ -948,6 +1170,7 @@ int xcb_poll_for_reply(xcb_connection_t* c, unsigned int request, void** reply,
 
 // Cursor/font stubs
 xcb_void_cookie_t xcb_open_font(xcb_connection_t* c, xcb_font_t fid, uint16_t name_len, const char* name) {
+  stub_request_count++;
   (void)c;
   (void)fid;
   (void)name_len;
@@ -967,6 +1190,7 @@ xcb_void_cookie_t xcb_create_glyph_cursor(xcb_connection_t* c,
                                           uint16_t back_red,
                                           uint16_t back_green,
                                           uint16_t back_blue) {
+  stub_request_count++;
   (void)c;
   (void)cid;
   (void)source_font;
@@ -983,12 +1207,14 @@ xcb_void_cookie_t xcb_create_glyph_cursor(xcb_connection_t* c,
 }
 
 xcb_void_cookie_t xcb_close_font(xcb_connection_t* c, xcb_font_t font) {
+  stub_request_count++;
   (void)c;
   (void)font;
   return (xcb_void_cookie_t){0};
 }
 
 xcb_void_cookie_t xcb_free_cursor(xcb_connection_t* c, xcb_cursor_t cursor) {
+  stub_request_count++;
   (void)c;
   (void)cursor;
   return (xcb_void_cookie_t){0};
@@ -996,6 +1222,7 @@ xcb_void_cookie_t xcb_free_cursor(xcb_connection_t* c, xcb_cursor_t cursor) {
 
 // Selection owner
 xcb_void_cookie_t xcb_set_selection_owner(xcb_connection_t* c, xcb_window_t owner, xcb_atom_t selection, xcb_timestamp_t time) {
+  stub_request_count++;
   (void)c;
   (void)selection;
   (void)time;
@@ -1008,6 +1235,7 @@ xcb_void_cookie_t xcb_set_selection_owner_checked(xcb_connection_t* c, xcb_windo
 }
 
 xcb_get_selection_owner_cookie_t xcb_get_selection_owner(xcb_connection_t* c, xcb_atom_t selection) {
+  stub_request_count++;
   (void)c;
   (void)selection;
   return (xcb_get_selection_owner_cookie_t){0};
@@ -1080,6 +1308,7 @@ xcb_generic_event_t* xcb_poll_for_event(xcb_connection_t* c) {
 
 // GC and drawing
 xcb_void_cookie_t xcb_create_gc(xcb_connection_t* c, xcb_gcontext_t cid, xcb_drawable_t drawable, uint32_t value_mask, const void* value_list) {
+  stub_request_count++;
   (void)c;
   (void)cid;
   (void)drawable;
@@ -1089,12 +1318,14 @@ xcb_void_cookie_t xcb_create_gc(xcb_connection_t* c, xcb_gcontext_t cid, xcb_dra
 }
 
 xcb_void_cookie_t xcb_free_gc(xcb_connection_t* c, xcb_gcontext_t gc) {
+  stub_request_count++;
   (void)c;
   (void)gc;
   return (xcb_void_cookie_t){0};
 }
 
 xcb_void_cookie_t xcb_poly_fill_rectangle(xcb_connection_t* c, xcb_drawable_t drawable, xcb_gcontext_t gc, uint32_t rectangles_len, const xcb_rectangle_t* rectangles) {
+  stub_request_count++;
   (void)c;
   (void)drawable;
   (void)gc;
@@ -1104,6 +1335,7 @@ xcb_void_cookie_t xcb_poly_fill_rectangle(xcb_connection_t* c, xcb_drawable_t dr
 }
 
 xcb_void_cookie_t xcb_image_text_8(xcb_connection_t* c, uint8_t string_len, xcb_drawable_t drawable, xcb_gcontext_t gc, int16_t x, int16_t y, const char* string) {
+  stub_request_count++;
   (void)c;
   (void)string_len;
   (void)drawable;
@@ -1115,6 +1347,7 @@ xcb_void_cookie_t xcb_image_text_8(xcb_connection_t* c, uint8_t string_len, xcb_
 }
 
 xcb_void_cookie_t xcb_poly_line(xcb_connection_t* c, uint8_t coordinate_mode, xcb_drawable_t drawable, xcb_gcontext_t gc, uint32_t points_len, const xcb_point_t* points) {
+  stub_request_count++;
   (void)c;
   (void)coordinate_mode;
   (void)drawable;
@@ -1126,6 +1359,7 @@ xcb_void_cookie_t xcb_poly_line(xcb_connection_t* c, uint8_t coordinate_mode, xc
 
 // Pixmaps and blits
 xcb_void_cookie_t xcb_create_pixmap(xcb_connection_t* c, uint8_t depth, xcb_pixmap_t pid, xcb_drawable_t drawable, uint16_t width, uint16_t height) {
+  stub_request_count++;
   (void)c;
   (void)depth;
   (void)pid;
@@ -1136,8 +1370,23 @@ xcb_void_cookie_t xcb_create_pixmap(xcb_connection_t* c, uint8_t depth, xcb_pixm
 }
 
 xcb_void_cookie_t xcb_free_pixmap(xcb_connection_t* c, xcb_pixmap_t pixmap) {
+  stub_request_count++;
   (void)c;
   (void)pixmap;
+  stub_free_pixmap_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_clear_area(xcb_connection_t* c, uint8_t exposures, xcb_window_t window, int16_t x, int16_t y, uint16_t width, uint16_t height) {
+  stub_request_count++;
+  (void)c;
+  (void)exposures;
+  (void)x;
+  (void)y;
+  (void)width;
+  (void)height;
+  stub_clear_area_count++;
+  stub_last_clear_area_window = window;
   return (xcb_void_cookie_t){0};
 }
 
@@ -1151,6 +1400,7 @@ xcb_void_cookie_t xcb_copy_area(xcb_connection_t* c,
                                 int16_t dst_y,
                                 uint16_t width,
                                 uint16_t height) {
+  stub_request_count++;
   (void)c;
   (void)src_drawable;
   (void)dst_drawable;
@@ -1176,9 +1426,9 @@ xcb_void_cookie_t xcb_put_image(xcb_connection_t* c,
                                 uint8_t depth,
                                 uint32_t data_len,
                                 const uint8_t* data) {
+  stub_request_count++;
   (void)c;
   (void)format;
-  (void)drawable;
   (void)gc;
   (void)dst_x;
   (void)dst_y;
@@ -1187,6 +1437,9 @@ xcb_void_cookie_t xcb_put_image(xcb_connection_t* c,
 
   stub_last_image_w = width;
   stub_last_image_h = height;
+  stub_last_image_drawable = drawable;
+  if (stub_put_image_count++ == 0)
+    stub_configure_count_at_first_image = stub_configure_window_count;
 
   if (data && data_len > 0) {
     uint32_t copy_len = data_len;
@@ -1215,12 +1468,18 @@ void xcb_key_symbols_free(xcb_key_symbols_t* syms) {
   free(syms);
 }
 
+int xcb_refresh_keyboard_mapping(xcb_key_symbols_t* syms, xcb_mapping_notify_event_t* event) {
+  (void)syms;
+  stub_refresh_keyboard_mapping_count++;
+  return event->request == XCB_MAPPING_KEYBOARD;
+}
+
 xcb_keycode_t* xcb_key_symbols_get_keycode(xcb_key_symbols_t* syms, xcb_keysym_t keysym) {
   (void)syms;
   xcb_keycode_t* codes = calloc(2, sizeof(*codes));
   if (!codes)
     return NULL;
-  codes[0] = (xcb_keycode_t)(keysym ? (keysym & 0xFF) : 42);
+  codes[0] = (xcb_keycode_t)((keysym ? (keysym & 0xFF) : 42) + stub_keycode_offset);
   codes[1] = 0;
   return codes;
 }
@@ -1228,13 +1487,32 @@ xcb_keycode_t* xcb_key_symbols_get_keycode(xcb_key_symbols_t* syms, xcb_keysym_t
 xcb_keysym_t xcb_key_symbols_get_keysym(xcb_key_symbols_t* syms, xcb_keycode_t keycode, int col) {
   (void)syms;
   (void)col;
-  if (keycode == 9)
-    return XK_Escape;
-  return 0;
+  switch (keycode) {
+    case 9:
+      return XK_Escape;
+    case 36:
+      return XK_Return;
+    case 111:
+      return XK_Up;
+    case 113:
+      return XK_Left;
+    case 114:
+      return XK_Right;
+    case 116:
+      return XK_Down;
+    case 22:
+      return XK_BackSpace;
+    default:
+      // Letters for type-ahead tests: keycodes 200..225 are a..z
+      if (keycode >= 200 && keycode < 226)
+        return (xcb_keysym_t)(XK_a + (keycode - 200));
+      return 0;
+  }
 }
 
 // Colormap stubs
 xcb_void_cookie_t xcb_install_colormap(xcb_connection_t* c, xcb_colormap_t cmap) {
+  stub_request_count++;
   (void)c;
   stub_install_colormap_count++;
   stub_last_installed_colormap = cmap;
@@ -1247,6 +1525,7 @@ xcb_void_cookie_t xcb_install_colormap_checked(xcb_connection_t* c, xcb_colormap
 }
 
 xcb_void_cookie_t xcb_create_colormap(xcb_connection_t* c, uint8_t alloc, xcb_colormap_t mid, xcb_window_t window, xcb_visualid_t visual) {
+  stub_request_count++;
   (void)c;
   (void)alloc;
   (void)mid;
@@ -1260,6 +1539,7 @@ xcb_void_cookie_t xcb_create_colormap_checked(xcb_connection_t* c, uint8_t alloc
 }
 
 xcb_void_cookie_t xcb_free_colormap(xcb_connection_t* c, xcb_colormap_t cmap) {
+  stub_request_count++;
   (void)c;
   (void)cmap;
   return (xcb_void_cookie_t){0};
@@ -1271,6 +1551,7 @@ xcb_void_cookie_t xcb_free_colormap_checked(xcb_connection_t* c, xcb_colormap_t
 
 // RandR stubs
 xcb_randr_get_screen_resources_current_cookie_t xcb_randr_get_screen_resources_current(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
   (void)c;
   (void)window;
   return (xcb_randr_get_screen_resources_current_cookie_t){stub_cookie_seq++};
@@ -1295,6 +1576,7 @@ int xcb_randr_get_screen_resources_current_crtcs_length(const xcb_randr_get_scre
 }
 
 xcb_randr_get_crtc_info_cookie_t xcb_randr_get_crtc_info(xcb_connection_t* c, xcb_randr_crtc_t crtc, xcb_timestamp_t config_timestamp) {
+  stub_request_count++;
   (void)c;
   (void)crtc;
   (void)config_timestamp;
@@ -1309,6 +1591,7 @@ xcb_randr_get_crtc_info_reply_t* xcb_randr_get_crtc_info_reply(xcb_connection_t*
 }
 
 xcb_void_cookie_t xcb_randr_select_input(xcb_connection_t* c, xcb_window_t window, uint16_t enable) {
+  stub_request_count++;
   (void)c;
   (void)window;
   (void)enable;
@@ -1316,6 +1599,7 @@ xcb_void_cookie_t xcb_randr_select_input(xcb_connection_t* c, xcb_window_t windo
 }
 
 xcb_randr_query_version_cookie_t xcb_randr_query_version(xcb_connection_t* c, uint32_t major_version, uint32_t minor_version) {
+  stub_request_count++;
   (void)c;
   (void)major_version;
   (void)minor_version;
@@ -1333,6 +1617,7 @@ xcb_randr_query_version_reply_t* xcb_randr_query_version_reply(xcb_connection_t*
 }
 
 xcb_damage_query_version_cookie_t xcb_damage_query_version(xcb_connection_t* c, uint32_t client_major_version, uint32_t client_minor_version) {
+  stub_request_count++;
   (void)c;
   (void)client_major_version;
   (void)client_minor_version;
@@ -1350,6 +1635,8 @@ xcb_damage_query_version_reply_t* xcb_damage_query_version_reply(xcb_connection_
 }
 
 xcb_void_cookie_t xcb_damage_create(xcb_connection_t* c, xcb_damage_damage_t damage, xcb_drawable_t drawable, uint8_t level) {
+  stub_request_count++;
+  stub_damage_create_count++;
   (void)c;
   (void)damage;
   (void)drawable;
@@ -1358,15 +1645,236 @@ xcb_void_cookie_t xcb_damage_create(xcb_connection_t* c, xcb_damage_damage_t dam
 }
 
 xcb_void_cookie_t xcb_damage_destroy(xcb_connection_t* c, xcb_damage_damage_t damage) {
+  stub_request_count++;
+  stub_damage_destroy_count++;
   (void)c;
   (void)damage;
   return (xcb_void_cookie_t){0};
 }
 
 xcb_void_cookie_t xcb_damage_subtract(xcb_connection_t* c, xcb_damage_damage_t damage, xcb_xfixes_region_t repair, xcb_xfixes_region_t parts) {
+  stub_request_count++;
   (void)c;
   (void)damage;
   (void)repair;
   (void)parts;
   return (xcb_void_cookie_t){0};
 }
+
+xcb_composite_query_version_cookie_t xcb_composite_query_version(xcb_connection_t* c, uint32_t client_major_version, uint32_t client_minor_version) {
+  stub_request_count++;
+  (void)c;
+  (void)client_major_version;
+  (void)client_minor_version;
+  return (xcb_composite_query_version_cookie_t){0};
+}
+
+xcb_composite_query_version_reply_t* xcb_composite_query_version_reply(xcb_connection_t* c, xcb_composite_query_version_cookie_t cookie, xcb_generic_error_t** e) {
+  (void)c;
+  (void)cookie;
+  if (e)
+    *e = NULL;
+  xcb_composite_query_version_reply_t* r = calloc(1, sizeof(*r));
+  r->major_version = 0;
+  r->minor_version = 4;
+  return r;
+}
+
+xcb_void_cookie_t xcb_composite_redirect_window(xcb_connection_t* c, xcb_window_t window, uint8_t update) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  (void)update;
+  stub_composite_redirect_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_composite_unredirect_window(xcb_connection_t* c, xcb_window_t window, uint8_t update) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  (void)update;
+  stub_composite_unredirect_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_composite_name_window_pixmap(xcb_connection_t* c, xcb_window_t window, xcb_pixmap_t pixmap) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  (void)pixmap;
+  stub_composite_name_pixmap_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_composite_redirect_subwindows(xcb_connection_t* c, xcb_window_t window, uint8_t update) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  (void)update;
+  stub_composite_redirect_subwindows_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_composite_redirect_subwindows_checked(xcb_connection_t* c, xcb_window_t window, uint8_t update) {
+  return xcb_composite_redirect_subwindows(c, window, update);
+}
+
+xcb_void_cookie_t xcb_composite_unredirect_subwindows(xcb_connection_t* c, xcb_window_t window, uint8_t update) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  (void)update;
+  stub_composite_unredirect_subwindows_count++;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_composite_get_overlay_window_cookie_t xcb_composite_get_overlay_window(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  return (xcb_composite_get_overlay_window_cookie_t){stub_cookie_seq++};
+}
+
+xcb_composite_get_overlay_window_reply_t* xcb_composite_get_overlay_window_reply(xcb_connection_t* c, xcb_composite_get_overlay_window_cookie_t cookie,
+                                                                                 xcb_generic_error_t** e) {
+  (void)c;
+  (void)cookie;
+  (void)e;
+  xcb_composite_get_overlay_window_reply_t* r = calloc(1, sizeof(*r));
+  r->overlay_win = stub_xid_counter++;
+  return r;
+}
+
+xcb_void_cookie_t xcb_composite_release_overlay_window(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_void_cookie_t xcb_shape_rectangles(xcb_connection_t* c, xcb_shape_op_t operation, xcb_shape_kind_t destination_kind, uint8_t ordering,
+                                       xcb_window_t destination_window, int16_t x_offset, int16_t y_offset, uint32_t rectangles_len,
+                                       const xcb_rectangle_t* rectangles) {
+  stub_request_count++;
+  (void)c;
+  (void)operation;
+  (void)destination_kind;
+  (void)ordering;
+  (void)destination_window;
+  (void)x_offset;
+  (void)y_offset;
+  (void)rectangles_len;
+  (void)rectangles;
+  return (xcb_void_cookie_t){0};
+}
+
+xcb_input_xi_query_version_cookie_t xcb_input_xi_query_version(xcb_connection_t* c, uint16_t major_version, uint16_t minor_version) {
+  stub_request_count++;
+  (void)c;
+  (void)major_version;
+  (void)minor_version;
+  return (xcb_input_xi_query_version_cookie_t){0};
+}
+
+xcb_input_xi_query_version_reply_t* xcb_input_xi_query_version_reply(xcb_connection_t* c, xcb_input_xi_query_version_cookie_t cookie, xcb_generic_error_t** e) {
+  (void)c;
+  (void)cookie;
+  if (e)
+    *e = NULL;
+  xcb_input_xi_query_version_reply_t* r = calloc(1, sizeof(*r));
+  r->major_version = 2;
+  r->minor_version = 2;
+  return r;
+}
+
+xcb_input_xi_get_client_pointer_cookie_t xcb_input_xi_get_client_pointer(xcb_connection_t* c, xcb_window_t window) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  return (xcb_input_xi_get_client_pointer_cookie_t){0};
+}
+
+xcb_input_xi_get_client_pointer_reply_t* xcb_input_xi_get_client_pointer_reply(xcb_connection_t* c, xcb_input_xi_get_client_pointer_cookie_t cookie, xcb_generic_error_t** e) {
+  (void)c;
+  (void)cookie;
+  if (e)
+    *e = NULL;
+  xcb_input_xi_get_client_pointer_reply_t* r = calloc(1, sizeof(*r));
+  r->set = 1;
+  r->deviceid = 2;
+  return r;
+}
+
+xcb_xkb_use_extension_cookie_t xcb_xkb_use_extension(xcb_connection_t* c, uint16_t wantedMajor, uint16_t wantedMinor) {
+  stub_request_count++;
+  (void)c;
+  (void)wantedMajor;
+  (void)wantedMinor;
+  return (xcb_xkb_use_extension_cookie_t){stub_cookie_seq++};
+}
+
+xcb_xkb_use_extension_reply_t* xcb_xkb_use_extension_reply(xcb_connection_t* c, xcb_xkb_use_extension_cookie_t cookie, xcb_generic_error_t** e) {
+  (void)c;
+  (void)cookie;
+  if (e)
+    *e = NULL;
+  xcb_xkb_use_extension_reply_t* r = calloc(1, sizeof(*r));
+  r->supported = 1;
+  r->serverMajor = 1;
+  return r;
+}
+
+xcb_xkb_per_client_flags_cookie_t xcb_xkb_per_client_flags(xcb_connection_t* c,
+                                                           xcb_xkb_device_spec_t deviceSpec,
+                                                           uint32_t change,
+                                                           uint32_t value,
+                                                           uint32_t ctrlsToChange,
+                                                           uint32_t autoCtrls,
+                                                           uint32_t autoCtrlsValues) {
+  stub_request_count++;
+  (void)c;
+  (void)deviceSpec;
+  (void)change;
+  (void)value;
+  (void)ctrlsToChange;
+  (void)autoCtrls;
+  (void)autoCtrlsValues;
+  return (xcb_xkb_per_client_flags_cookie_t){stub_cookie_seq++};
+}
+
+xcb_xkb_per_client_flags_reply_t* xcb_xkb_per_client_flags_reply(xcb_connection_t* c, xcb_xkb_per_client_flags_cookie_t cookie, xcb_generic_error_t** e) {
+  (void)c;
+  (void)cookie;
+  if (e)
+    *e = NULL;
+  xcb_xkb_per_client_flags_reply_t* r = calloc(1, sizeof(*r));
+  r->supported = XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT;
+  r->value = XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT;
+  return r;
+}
+
+xcb_input_xi_grab_device_cookie_t xcb_input_xi_grab_device(xcb_connection_t* c,
+                                                           xcb_window_t window,
+                                                           xcb_timestamp_t time,
+                                                           xcb_cursor_t cursor,
+                                                           xcb_input_device_id_t deviceid,
+                                                           uint8_t mode,
+                                                           uint8_t paired_device_mode,
+                                                           uint8_t owner_events,
+                                                           uint16_t mask_len,
+                                                           const uint32_t* mask) {
+  stub_request_count++;
+  (void)c;
+  (void)window;
+  (void)time;
+  (void)deviceid;
+  (void)mode;
+  (void)paired_device_mode;
+  (void)owner_events;
+  (void)mask_len;
+  (void)mask;
+  stub_xi_grab_device_count++;
+  stub_last_xi_grab_cursor = cursor;
+  return (xcb_input_xi_grab_device_cookie_t){stub_cookie_seq++};
+}